@@ -39,21 +39,36 @@ public:
     /** Prepare for connecting to an lv2:OutputPort, atom:AtomPort */
     void prepare();
 
-    /** Insert event data at the given frame. */
-    void insert (int64_t frames, uint32_t size, uint32_t type, const void* data);
+    /** Insert event data at the given frame, after events already there.
+        Returns false and counts a dropped event if it doesn't fit. */
+    bool insert (int64_t frames, uint32_t size, uint32_t type, const void* data);
 
     /** Insert a juce MidiMessage into the buffer. */
     void insert (juce::MidiMessage& msg, int frame);
 
+    /** Replace the contents with another buffer's. */
+    void copyFrom (const AtomBuffer& other);
+
     /** Add the contents of another atom buffer into this one. */
     void add (const AtomBuffer& other);
 
+    /** Merge several sequences into this one in a single pass.
+
+        Events stay in time order, ties keep this buffer's events first and
+        then follow the order of `sources`. Events that don't fit are
+        dropped and counted. Realtime safe.
+     */
+    void merge (const AtomBuffer* const* sources, int numSources);
+
     /** Add the contents of a juce MidiBuffer into this one. */
     void add (juce::MidiBuffer& midi);
 
     /** Returns the total allocated memory. */
     inline constexpr uint32_t capacity() const noexcept { return _capacity; }
 
+    /** Returns how many events were dropped for lack of space. */
+    inline constexpr uint32_t numDropped() const noexcept { return _dropped; }
+
     /** Returns the underlying data. */
     inline constexpr void* data() noexcept { return _ptrs.raw; }
     /** Returns the underlying data. */
@@ -72,8 +87,10 @@ public:
     inline AtomBuffer& operator= (AtomBuffer&& o) noexcept
     {
         _data = std::move (o._data);
+        _scratch = std::move (o._scratch);
         _ptrs = std::move (o._ptrs);
         _capacity = std::move (o._capacity);
+        _dropped = std::move (o._dropped);
         MidiEvent = std::move (o.MidiEvent);
         return *this;
     }
@@ -82,13 +99,16 @@ public:
     inline void swap (AtomBuffer& b) noexcept
     {
         _data.swap (b._data);
+        _scratch.swap (b._scratch);
         std::swap (_ptrs.raw, b._ptrs.raw);
         std::swap (_capacity, b._capacity);
+        std::swap (_dropped, b._dropped);
         std::swap (MidiEvent, b.MidiEvent);
     }
 
 private:
     AlignedData<8> _data;
+    AlignedData<8> _scratch; ///< merge output, same size as _data
     union {
         void* raw { nullptr };
         LV2_Atom* atom;
@@ -96,6 +116,7 @@ private:
     } _ptrs;
 
     uint32_t _capacity { 0 };
+    uint32_t _dropped { 0 };
     uint32_t MidiEvent { 0 };
 };
 
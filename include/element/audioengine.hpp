@@ -50,10 +50,38 @@ public:
     bool addGraph (RootGraph* graph);
     bool removeGraph (RootGraph* graph);
 
+    /** Add a graph of the session that plays next. It's prepared whatever
+        the standby limit but isn't heard, sent MIDI or picked by program
+        changes until switchToCuedGraphs(). removeGraph() drops it again.
+        Not realtime safe.
+     */
+    bool addCuedGraph (RootGraph* graph);
+
+    /** Render the cued graphs in place of the current ones, starting from
+        the cued graph at index. The graphs that were heard fade out over
+        the next block as the new ones fade in. The replaced graphs stay
+        with the engine, silent, until they're removed with removeGraph(),
+        which waits out the fade. Message thread.
+     */
+    void switchToCuedGraphs (int index);
+
+    /** Register or remove device ports for graphs that changed
+        RootGraph::setDevicePortsEnabled(). Only devices that can host
+        extra ports, i.e. JACK, give graphs their own.
+     */
+    void updateDevicePorts();
+
     void setCurrentGraph (const int index) { setActiveGraph (index); }
     void setActiveGraph (const int index);
     int getActiveGraph() const;
 
+    /** Keep the graph a program change would select ready while standby
+        releases others, wherever it sits in the session. Set lists pass
+        their next entry, so it's prepared during the current song and the
+        switch never waits on loading. -1 clears it. Message thread.
+     */
+    void setUpcomingProgram (int program);
+
     RootGraph* getGraph (const int index);
 
     void setPlaying (const bool shouldBePlaying);
@@ -61,6 +89,9 @@ public:
     void seekToAudioFrame (const int64 frame);
     void setMeter (int beatsPerBar, int beatDivisor);
 
+    /** Glide the transport tempo to bpm over lengthFrames. */
+    void rampTempo (double bpm, int64 lengthFrames);
+
     void togglePlayPause();
 
     MidiKeyboardState& getKeyboardState();
@@ -97,11 +128,60 @@ public:
     LevelMeterPtr getLevelMeter (int channel, bool input);
     int getNumChannels (bool input) const noexcept;
 
+    /** Timing of the audio callback, see getTelemetry(). */
+    struct Telemetry {
+        static constexpr int numBins = 11;
+
+        int64 numCallbacks = 0;
+        int64 deadlineMisses = 0; ///< callbacks that took longer than their block
+        int64 lateCallbacks = 0;  ///< callbacks that started well past their period
+        int xruns = -1;           ///< as reported by the device, -1 if it doesn't count them
+        double load = 0.0;        ///< smoothed DSP load, 1.0 is the whole block
+        double peakLoad = 0.0;    ///< highest load since the last reset
+        double periodMs = 0.0;    ///< average time between callbacks
+        double jitterMs = 0.0;    ///< RMS deviation of the period from the block duration
+        int64 signalFaults = 0;   ///< node output blocks with NaN or infinite samples, see Settings::isGuardingNodeOutputs()
+
+        /** Callback durations in 10% steps of the block, the last bin is 100% and over. */
+        int64 histogram[numBins] {};
+    };
+
+    /** Returns callback timing since the last reset. Safe to call from any thread. */
+    Telemetry getTelemetry() const;
+
+    /** Clear the counters returned by getTelemetry(). */
+    void resetTelemetry();
+
+    /** How well an external MIDI clock is being followed, see getMidiClockStats(). */
+    struct MidiClockStats {
+        int64 numTicks = 0;      ///< clock messages received
+        int64 dropouts = 0;      ///< times the clock stopped arriving after locking
+        bool locked = false;     ///< true once enough ticks arrived to trust the tempo
+        double bpm = 0.0;        ///< smoothed tempo, zero until locked
+        double jitterMs = 0.0;   ///< RMS error of tick arrival against the loop's prediction
+        double maxJitterMs = 0.0;
+    };
+
+    /** Returns the external clock follower's statistics. Safe to call from any thread. */
+    MidiClockStats getMidiClockStats() const;
+
+    /** Returns the number of MIDI input messages waiting for the audio thread. Any thread. */
+    int getNumMidiInputsPending() const noexcept;
+
+    /** Start capturing a trace of the render path. */
+    void startRenderTrace();
+
+    /** Stop the capture and save it as a Chrome trace (JSON).
+        Returns false if the file couldn't be written.
+     */
+    bool stopRenderTrace (const File& file);
+
 private:
     class Private;
     std::unique_ptr<Private> priv;
     Context& world;
     RunMode runMode;
+    File traceFile;
 };
 
 using AudioEnginePtr = ReferenceCountedObjectPtr<AudioEngine>;
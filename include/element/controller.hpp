@@ -30,6 +30,15 @@ public:
         toggleEquals
     };
 
+    /** Resolution of a controller event. 14-bit pairs an MSB controller
+        (0-31) with its LSB at +32, NRPN uses a 14-bit parameter number.
+     */
+    enum Resolution : int {
+        resolution7Bit = 0,
+        resolution14Bit,
+        resolutionNRPN
+    };
+
     Control (const juce::String& name)
         : Model (types::Control, EL_CONTROL_VERSION)
     {
@@ -68,6 +77,19 @@ public:
     bool isControllerEvent() const { return getProperty ("eventType").toString() == "controller"; }
     int getEventId() const { return (int) getProperty ("eventId", 0); }
 
+    Resolution getResolution() const noexcept
+    {
+        const auto str = getProperty ("resolution", "7bit").toString();
+        if (str == "14bit")
+            return resolution14Bit;
+        else if (str == "nrpn")
+            return resolutionNRPN;
+        return resolution7Bit;
+    }
+
+    /** Returns true if this is a 14-bit or NRPN controller. */
+    bool isHighResolution() const noexcept { return isControllerEvent() && getResolution() != resolution7Bit; }
+
     bool isMomentary() const { return (bool) getProperty ("momentary", false); }
     juce::Value getMomentaryValue() { return getPropertyAsValue ("momentary"); }
     int getToggleValue() const { return (int) getProperty ("toggleValue", 0); }
@@ -129,6 +151,7 @@ private:
         stabilizePropertyPOD ("toggleValue", 64);
         stabilizePropertyPOD ("inverseToggle", false);
         stabilizePropertyString ("toggleMode", "eqorhi");
+        stabilizePropertyString ("resolution", "7bit");
     }
 };
 
@@ -33,6 +33,12 @@ public:
     /** Returns the default Node MIDI Presets directory */
     static const juce::File defaultGlobalMidiProgramsDir();
 
+    /** Returns the directory compiled Lua chunks are cached in */
+    static const juce::File defaultScriptCacheDir();
+
+    /** Returns the directory frozen graphs are rendered to */
+    static const juce::File defaultFreezeCacheDir();
+
     /** Returns the default User data path */
     static const juce::File defaultUserDataPath();
 
@@ -48,6 +54,9 @@ public:
     /** Returns the default Controllers directory */
     static const juce::File defaultControllersDir();
 
+    /** Returns the default directory for Disk Recorder takes */
+    static const juce::File defaultRecordingsDir();
+
     /** Returns the installation directory. May return an invalid file,
         especially when in debug mode. Use this sparingly.
       */
@@ -9,41 +9,60 @@
 
 namespace element {
 
-/** A glorified array of Buffers used in rendering graph nodes */
+/** A glorified array of Buffers used in rendering graph nodes.
+
+    Up to inlineCapacity buffers are held in the pipe itself. Past that the
+    pipe refers to the array it was given, so a node with many ports renders
+    from a span its render op owns and allocated up front, never per block.
+ */
 template <class Buf>
 class DataPipe {
 public:
     using buffer_type = Buf;
 
+    /** How many buffers fit in the pipe without referring to a span. */
+    static constexpr int inlineCapacity = 32;
+
     DataPipe()
         : _size (0)
     {
-        memset (referencedBuffers, 0, sizeof (Buf*) * maxReferencedBuffers);
+        memset (inlineBuffers, 0, sizeof (Buf*) * inlineCapacity);
     }
 
     DataPipe (Buf& buffer)
     {
-        memset (referencedBuffers, 0, sizeof (Buf*) * maxReferencedBuffers);
-        referencedBuffers[0] = &buffer;
+        memset (inlineBuffers, 0, sizeof (Buf*) * inlineCapacity);
+        inlineBuffers[0] = &buffer;
         _size = 1;
     }
 
-    DataPipe (Buf** buffers, int numBuffers)
+    /** Copies small counts. Larger ones refer to buffers, which must
+        outlive the pipe.
+     */
+    DataPipe (Buf* const* buffers, int numBuffers)
     {
-        assert (numBuffers < maxReferencedBuffers);
-        memset (referencedBuffers, 0, sizeof (Buf*) * maxReferencedBuffers);
-        for (int i = 0; i < numBuffers; ++i)
-            referencedBuffers[i] = buffers[i];
         _size = numBuffers;
+        if (numBuffers > inlineCapacity)
+        {
+            referencedBuffers = buffers;
+            return;
+        }
+
+        memset (inlineBuffers, 0, sizeof (Buf*) * inlineCapacity);
+        for (int i = 0; i < numBuffers; ++i)
+            inlineBuffers[i] = buffers[i];
     }
 
+    /** Picks buffers by index. Only the inline count can be picked this
+        way, hand larger ones over with a span.
+     */
     DataPipe (const juce::OwnedArray<Buf>& buffers, const juce::Array<int>& channels)
     {
-        jassert (channels.size() < maxReferencedBuffers);
-        memset (referencedBuffers, 0, sizeof (Buf*) * maxReferencedBuffers);
-        for (int i = 0; i < channels.size(); ++i)
-            referencedBuffers[i] = buffers.getUnchecked (channels.getUnchecked (i));
-        _size = channels.size();
+        jassert (channels.size() <= inlineCapacity);
+        memset (inlineBuffers, 0, sizeof (Buf*) * inlineCapacity);
+        _size = juce::jmin (channels.size(), (int) inlineCapacity);
+        for (int i = 0; i < _size; ++i)
+            inlineBuffers[i] = buffers.getUnchecked (channels.getUnchecked (i));
     }
 
     ~DataPipe()
@@ -83,9 +102,9 @@ public:
     }
 
 private:
-    enum { maxReferencedBuffers = 32 };
     int _size = 0;
-    buffer_type* referencedBuffers[maxReferencedBuffers];
+    buffer_type* inlineBuffers[inlineCapacity];
+    buffer_type* const* referencedBuffers = inlineBuffers;
     EL_DISABLE_COPY (DataPipe)
 };
 
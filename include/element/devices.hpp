@@ -20,6 +20,11 @@ public:
     void selectAudioDriver (const juce::String& name);
     void attach (AudioEnginePtr engine);
 
+    /** Set the devices the Aggregate device combines, the clock first.
+        Reopens it if it's in use.
+     */
+    void setAggregateMembers (const juce::StringArray& names);
+
 #if KV_JACK_AUDIO
     kv::JackClient& getJackClient();
 #endif
@@ -122,11 +122,41 @@ public:
     /** called when the session loads or re-loads */
     void sessionReloaded();
 
+    /** Load the graphs of a session's data beside the current session's.
+        They're prepared in the engine right away and their nodes, plugins
+        and states are created a graph at a time while the current session
+        keeps playing. Replaces a session already cued. Returns false if
+        the data isn't a session.
+     */
+    bool cueSession (const ValueTree& sessionData);
+
+    /** Returns true if a session is cued. */
+    bool hasCuedSession() const;
+
+    /** Returns true once every graph of the cued session is loaded. */
+    bool isCuedSessionReady() const;
+
+    /** Drop the cued session's graphs. */
+    void clearCuedSession();
+
+    /** Render the cued session's graphs instead of the current ones,
+        crossfading to its active graph, and drop the graphs it replaces.
+        The Session must already hold the cued data.
+     */
+    void switchToCuedSession();
+
     /** replace a node with a given plugin */
     void replace (const Node&, const PluginDescription&);
 
     void changeBusesLayout (const Node& node, const AudioProcessor::BusesLayout& layout);
 
+    /** Hold engine updates of every graph until the matching endBatch().
+        Edits made in between reach the engine together, with one rebuild
+        per graph. Calls nest.
+     */
+    void beginBatch();
+    void endBatch();
+
     Signal<void (const Node&)> sigNodeRemoved;
 
 private:
@@ -134,6 +164,7 @@ private:
     class RootGraphs;
     friend class RootGraphs;
     std::unique_ptr<RootGraphs> graphs;
+    std::unique_ptr<RootGraphs> cued;
 
     friend class ChangeBroadcaster;
     Node addPlugin (GraphManager& controller, const PluginDescription& desc);
@@ -9,12 +9,16 @@ namespace element {
 
 class SymbolMap;
 class Processor;
+class World;
 
 //==============================================================================
 class LV2NodeProvider : public NodeProvider {
 public:
     LV2NodeProvider();
     LV2NodeProvider (SymbolMap&);
+
+    /** Loads plugins from a world another provider already loaded. */
+    explicit LV2NodeProvider (std::shared_ptr<World> world);
     ~LV2NodeProvider();
     juce::String format() const override { return "LV2"; }
     Processor* create (const juce::String&) override;
@@ -22,6 +26,9 @@ public:
 
     String nameForURI (const String& uri) const noexcept;
 
+    /** Returns the LV2 world, to share with other providers. */
+    std::shared_ptr<World> getWorld() const noexcept;
+
 private:
     class LV2;
     std::unique_ptr<LV2> lv2;
@@ -3,18 +3,32 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+
 #include <element/juce/core.hpp>
+#include <element/juce/events.hpp>
 #include <element/signals.hpp>
 
 namespace element {
 
-/** Monitors MIDI input/output from device IO in the audio engine */
-class MidiIOMonitor : public juce::ReferenceCountedObject {
+/** Monitors MIDI input/output from device IO in the audio engine.
+
+    The MIDI and audio threads only bump a counter. Activity is passed on
+    from a message thread timer, which runs only while something is
+    connected with onReceived() or onSent().
+ */
+class MidiIOMonitor : public juce::ReferenceCountedObject,
+                      private juce::Timer
+{
 public:
+    static constexpr int refreshHz = 90;
+
     MidiIOMonitor() {}
 
     ~MidiIOMonitor()
     {
+        stopTimer();
         sigReceived.disconnect_all_slots();
         sigSent.disconnect_all_slots();
     }
@@ -22,31 +36,67 @@ public:
     Signal<void()> sigReceived;
     Signal<void()> sigSent;
 
+    /** Calls a function on the message thread when MIDI was received. */
+    inline SignalConnection onReceived (std::function<void()> fn)
+    {
+        auto connection = sigReceived.connect (std::move (fn));
+        startNotifying();
+        return connection;
+    }
+
+    /** Calls a function on the message thread when MIDI was sent. */
+    inline SignalConnection onSent (std::function<void()> fn)
+    {
+        auto connection = sigSent.connect (std::move (fn));
+        startNotifying();
+        return connection;
+    }
+
     inline void clear()
     {
-        midiInputCount.set (0);
-        midiOutputCount.set (0);
+        midiInputCount.store (0, std::memory_order_relaxed);
+        midiOutputCount.store (0, std::memory_order_relaxed);
     }
 
-    /** Call this from the UI thread regularly. */
+    /** Call this from the UI thread regularly, or connect with onReceived()
+        and onSent() to have it called for you.
+     */
     inline void notify()
     {
-        if (midiInputCount.get() > 0)
+        if (midiInputCount.exchange (0, std::memory_order_relaxed) > 0)
             sigReceived();
-        if (midiOutputCount.get() > 0)
+        if (midiOutputCount.exchange (0, std::memory_order_relaxed) > 0)
             sigSent();
-        clear();
     }
 
     /** Call in the midi thread when received. */
-    inline void received() { midiInputCount.set (midiInputCount.get() + 1); }
+    inline void received() noexcept { midiInputCount.fetch_add (1, std::memory_order_relaxed); }
 
     /** Call in the midi thread when sent. */
-    inline void sent() { midiOutputCount.set (midiOutputCount.get() + 1); }
+    inline void sent() noexcept { midiOutputCount.fetch_add (1, std::memory_order_relaxed); }
 
 private:
-    juce::Atomic<int> midiInputCount { 0 };
-    juce::Atomic<int> midiOutputCount { 0 };
+    std::atomic<int> midiInputCount { 0 };
+    std::atomic<int> midiOutputCount { 0 };
+
+    inline void startNotifying()
+    {
+        if (! isTimerRunning())
+            startTimerHz (refreshHz);
+    }
+
+    void timerCallback() override
+    {
+        // nothing is listening, counts pile up until someone connects.
+        if (sigReceived.empty() && sigSent.empty())
+        {
+            stopTimer();
+            clear();
+            return;
+        }
+
+        notify();
+    }
 };
 
 typedef juce::ReferenceCountedObjectPtr<MidiIOMonitor> MidiIOMonitorPtr;
@@ -14,12 +14,25 @@ struct MidiBufferImpl;
 
 namespace element {
 
-/** A glorified array of MidiBuffers used in rendering graph nodes */
+/** A glorified array of MidiBuffers used in rendering graph nodes.
+
+    Small counts are held in the pipe. Larger ones refer to the array the
+    pipe was made with, see DataPipe.
+ */
 class MidiPipe {
 public:
+    /** How many buffers fit in the pipe without referring to a span. */
+    static constexpr int inlineCapacity = 64;
+
     MidiPipe();
     MidiPipe (juce::MidiBuffer& buffer);
-    MidiPipe (juce::MidiBuffer** buffers, int numBuffers);
+
+    /** Copies small counts. Larger ones refer to buffers, which must
+        outlive the pipe.
+     */
+    MidiPipe (juce::MidiBuffer* const* buffers, int numBuffers);
+
+    /** Picks buffers by index, up to the inline count. */
     MidiPipe (const juce::OwnedArray<juce::MidiBuffer>& buffers, const juce::Array<int>& channels);
     ~MidiPipe();
 
@@ -32,11 +45,9 @@ public:
     void clear (int index, int startSample, int numSamples);
 
 private:
-    enum {
-        maxReferencedBuffers = 64
-    };
     int size = 0;
-    juce::MidiBuffer* referencedBuffers[maxReferencedBuffers];
+    juce::MidiBuffer* inlineBuffers[inlineCapacity];
+    juce::MidiBuffer* const* referencedBuffers = inlineBuffers;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiPipe);
 };
 
@@ -15,21 +15,30 @@ extern "C" {
 #define EL_NODE_ID_ALLPASS_FILTER     "element.allPass"
 #define EL_NODE_ID_AUDIO_FILE_PLAYER  "element.audioFilePlayer"
 #define EL_NODE_ID_AUDIO_MIXER        "element.audioMixer"
+#define EL_NODE_ID_AUX_RETURN         "element.auxReturn"
+#define EL_NODE_ID_AUX_SEND           "element.auxSend"
 #define EL_NODE_ID_CHANNELIZE         "element.channelize"
 #define EL_NODE_ID_COMB_FILTER        "element.comb"
 #define EL_NODE_ID_COMPRESSOR         "element.compressor"
+#define EL_NODE_ID_CONVOLVER          "element.convolver"
+#define EL_NODE_ID_DISK_RECORDER      "element.diskRecorder"
 #define EL_NODE_ID_EQ_FILTER          "element.eqfilt"
 #define EL_NODE_ID_FREQ_SPLITTER      "element.freqsplit"
+#define EL_NODE_ID_LIMITER            "element.limiter"
+#define EL_NODE_ID_LOOPER             "element.looper"
 #define EL_NODE_ID_MEDIA_PLAYER       "element.mediaPlayer"
 #define EL_NODE_ID_MIDI_CHANNEL_MAP   "element.midiChannelMap"
 #define EL_NODE_ID_MIDI_INPUT_DEVICE  "element.midiInputDevice"
 #define EL_NODE_ID_MIDI_OUTPUT_DEVICE "element.midiOutputDevice"
+#define EL_NODE_ID_NET_RECEIVE        "element.netReceive"
+#define EL_NODE_ID_NET_SEND           "element.netSend"
 #define EL_NODE_ID_PLACEHOLDER        "element.placeholder"
 #define EL_NODE_ID_REVERB             "element.reverb"
 #define EL_NODE_ID_WET_DRY            "element.wetDry"
 #define EL_NODE_ID_VOLUME             "element.volume"
 
 // Processor subclass
+#define EL_NODE_ID_ANALYZER              "element.analyzer"
 #define EL_NODE_ID_AUDIO_ROUTER          "element.audioRouter"
 #define EL_NODE_ID_GRAPH                 "element.graph"
 #define EL_NODE_ID_MIDI_CHANNEL_SPLITTER "element.midiChannelSplitter"
@@ -42,6 +51,8 @@ extern "C" {
 #define EL_NODE_ID_SCRIPT                "element.script"
 #define EL_NODE_ID_MCU                   "el.MCU"
 #define EL_NODE_ID_MIDI_SET_LIST         "element.midiSetList"
+#define EL_NODE_ID_MPE_ROUTER            "element.mpeRouter"
+#define EL_NODE_ID_VIDEO_MONITOR         "element.videoMonitor"
 
 //==============================================================================
 #define EL_NODE_UID_AUDIO_FILE_PLAYER     1000
@@ -72,6 +83,17 @@ extern "C" {
 #define EL_NODE_UID_VOLUME                1026
 #define EL_NODE_UID_MCU                   1027
 #define EL_NODE_UID_MIDI_SET_LIST         1028
+#define EL_NODE_UID_MPE_ROUTER            1029
+#define EL_NODE_UID_CONVOLVER             1030
+#define EL_NODE_UID_NET_SEND              1031
+#define EL_NODE_UID_NET_RECEIVE           1032
+#define EL_NODE_UID_AUX_SEND              1033
+#define EL_NODE_UID_AUX_RETURN            1034
+#define EL_NODE_UID_VIDEO_MONITOR         1035
+#define EL_NODE_UID_DISK_RECORDER         1036
+#define EL_NODE_UID_LOOPER                1037
+#define EL_NODE_UID_LIMITER               1038
+#define EL_NODE_UID_ANALYZER              1039
 
 #ifdef __cplusplus
 }
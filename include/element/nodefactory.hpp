@@ -48,6 +48,11 @@ public:
     /** Returns a list of known Node IDs public and private. */
     const StringArray& knownIDs() const noexcept;
 
+    /** Returns the known Node IDs that aren't hidden. Rebuilt only after
+        types are added, hidden or shown.
+     */
+    const StringArray& visibleIDs() const;
+
     //==========================================================================
     /** Add a new provider to the factory. */
     NodeFactory& add (NodeProvider* f);
@@ -13,6 +13,19 @@ class Oversampler final {
 public:
     using ProcessorType = juce::dsp::Oversampling<SampleType>;
 
+    /** Phase response of the half band stages. Minimum phase uses polyphase
+        IIR filters and has the least latency. Linear phase uses polyphase
+        equiripple FIR filters, which keep transients intact at the cost of
+        more latency.
+     */
+    enum class Phase {
+        minimum,
+        linear
+    };
+
+    /** Highest supported factor. */
+    static constexpr int maxFactor = 16;
+
     Oversampler() = default;
     ~Oversampler();
 
@@ -21,15 +34,34 @@ public:
 
     float getLatencySamples (int index) const;
     int getFactor (int index) const;
+
+    Phase getPhase() const noexcept { return phase; }
+
+    /** Change the phase response. Processors are rebuilt by the next prepare. */
+    void setPhase (Phase newPhase);
+
+    /** Prepare a processor for every factor. */
     void prepare (int numChannels, int blockSize);
+
+    /** Prepare only the processor for factor and free the others. Nodes
+        that don't oversample then hold no filters or buffers at all.
+     */
+    void prepare (int numChannels, int blockSize, int factor);
+
     void reset();
 
+    /** Returns an estimate of the bytes held by the prepared processors'
+        buffers. Filter state is small and left out.
+     */
+    size_t getNumBytes() const;
+
 private:
     enum {
-        maxProc = 3
+        maxProc = 4
     };
     int channels = 0,
         buffer = 0;
+    Phase phase = Phase::minimum;
     juce::OwnedArray<ProcessorType> processors;
 };
 
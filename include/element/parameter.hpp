@@ -1,6 +1,9 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <atomic>
+#include <memory>
+
 #include <boost/signals2.hpp>
 
 #include <element/juce/core.hpp>
@@ -213,7 +216,8 @@ public:
         Parameter.
 
         Use Parameter::addListener() to register your listener with
-        an Parameter.
+        an Parameter, or Parameter::addRealtimeListener() for listeners
+        that have to hear about changes on the thread making them.
 
         This Listener replaces most of the functionality in the
         AudioProcessorListener class, which will be deprecated and removed.
@@ -225,12 +229,14 @@ public:
 
         /** Receives a callback when a parameter has been changed.
 
-            IMPORTANT NOTE: This will be called synchronously when a parameter changes, and
-            many audio processors will change their parameter during their audio callback.
-            This means that not only has your handler code got to be completely thread-safe,
-            but it's also got to be VERY fast, and avoid blocking. If you need to handle
-            this event on your message thread, use this callback to trigger an AsyncUpdater
-            or ChangeBroadcaster which you can respond to on the message thread.
+            Listeners added with addListener() are called on the message thread.
+            Changes made on other threads are coalesced, a listener sees the
+            latest value up to 30 times a second.
+
+            IMPORTANT NOTE: Realtime listeners are called synchronously when a parameter
+            changes, and many audio processors will change their parameter during their
+            audio callback. This means that not only has your handler code got to be
+            completely thread-safe, but it's also got to be VERY fast, and avoid blocking.
         */
         virtual void controlValueChanged (int index, float value) = 0;
 
@@ -240,26 +246,32 @@ public:
             being true when they first press the mouse button, and it will be called again with
             gestureIsStarting being false when they release it.
 
-            IMPORTANT NOTE: This will be called synchronously, and many audio processors will
-            call it during their audio callback. This means that not only has your handler code
-            got to be completely thread-safe, but it's also got to be VERY fast, and avoid
-            blocking. If you need to handle this event on your message thread, use this callback
-            to trigger an AsyncUpdater or ChangeBroadcaster which you can respond to later on the
-            message thread.
+            Threading is the same as controlValueChanged(). Listeners on the message
+            thread only see the latest state of gestures made on other threads.
         */
         virtual void controlTouched (int index, bool grabbed) = 0;
     };
 
-    /** Registers a listener to receive events when the parameter's state changes.
-        If the listener is already registered, this will not register it again.
+    /** Registers a listener to receive events on the message thread when the
+        parameter's state changes. If the listener is already registered, this
+        will not register it again. Message thread.
 
-        @see removeListener
+        @see removeListener, addRealtimeListener
     */
     void addListener (Listener* newListener);
 
-    /** Removes a previously registered parameter listener
+    /** Registers a listener called synchronously on whichever thread changes
+        the parameter, for bindings that run with the audio. Notifying these
+        takes no locks. Adding and removing wait for a notification in progress
+        to finish, so don't do either from inside a callback. Message thread.
+
+        @see removeListener
+    */
+    void addRealtimeListener (Listener* newListener);
 
-        @see addListener
+    /** Removes a previously registered parameter listener of either kind.
+
+        @see addListener, addRealtimeListener
     */
     void removeListener (Listener* listener);
 
@@ -278,6 +290,21 @@ private:
     juce::Array<Listener*> listeners;
     mutable juce::StringArray valueStrings;
 
+    // realtime listeners are swapped in whole, readers are counted so an
+    // old list is only freed once nobody is walking it.
+    using ListenerList = juce::Array<Listener*>;
+    std::atomic<ListenerList*> realtimeListeners { nullptr };
+    std::atomic<int> numNotifying { 0 };
+    void updateRealtimeListeners (Listener* listener, bool add);
+
+    // changes for message thread listeners, picked up by the Notifier.
+    class Notifier;
+    std::shared_ptr<Notifier> notifier;
+    std::atomic<float> pendingValue { 0.f };
+    std::atomic<int> pendingGesture { -1 };
+    std::atomic<bool> valuePending { false };
+    void deliverPending();
+
 #if JUCE_DEBUG
     bool isPerformingGesture = false;
 #endif
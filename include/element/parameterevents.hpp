@@ -0,0 +1,71 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+namespace element {
+
+/** Parameter changes for one block of a node, in frame order.
+
+    The graph fills this for nodes that want parameter events, see
+    Processor::wantsParameterEvents(). Every change to one of the node's
+    input parameters lands here, whether it came from the UI, a mapping,
+    a parameter binding or OSC, so the node can apply it at the frame it
+    belongs to instead of once per block.
+
+    Storage is fixed so nothing is allocated while rendering. Values are
+    normalized, as passed to Parameter::setValue().
+ */
+class ParameterEvents final {
+public:
+    struct Event {
+        int frame;
+        int parameter;
+        float value;
+    };
+
+    static constexpr int capacity = 128;
+
+    ParameterEvents() = default;
+
+    /** Remove all events. */
+    void clear() noexcept { num = 0; }
+
+    /** Add an event, keeping frame order. Events with the same frame stay
+        in the order they were added. Returns false if the lane is full.
+     */
+    bool add (int frame, int parameter, float value) noexcept
+    {
+        if (num >= capacity)
+            return false;
+
+        // events usually come in order, so this rarely moves any.
+        int i = num;
+        while (i > 0 && events[i - 1].frame > frame)
+        {
+            events[i] = events[i - 1];
+            --i;
+        }
+
+        events[i] = { frame, parameter, value };
+        ++num;
+        return true;
+    }
+
+    int size() const noexcept { return num; }
+    bool isEmpty() const noexcept { return num == 0; }
+    bool isFull() const noexcept { return num >= capacity; }
+
+    const Event& operator[] (int index) const noexcept { return events[index]; }
+    const Event* begin() const noexcept { return events; }
+    const Event* end() const noexcept { return events + num; }
+
+private:
+    Event events[capacity];
+    int num = 0;
+
+    ParameterEvents (const ParameterEvents&) = delete;
+    ParameterEvents& operator= (const ParameterEvents&) = delete;
+};
+
+} // namespace element
@@ -6,6 +6,7 @@
 #include <element/juce/audio_processors.hpp>
 
 #define EL_PLUGIN_SCANNER_PROCESS_ID "pspelbg"
+#define EL_PLUGIN_BRIDGE_PROCESS_ID "pbrelbg"
 
 namespace element {
 
@@ -97,6 +98,45 @@ public:
     juce::AudioPluginInstance* createAudioPlugin (const juce::PluginDescription& desc, juce::String& errorMsg);
     Processor* createGraphNode (const juce::PluginDescription& desc, juce::String& errorMsg);
 
+    /** Returns true if the description is of a plugin format that can be
+        created with createAudioPluginAsync().
+     */
+    bool canCreateAudioPluginAsync (const juce::PluginDescription& desc);
+
+    /** Create a plugin without blocking the caller. The callback is run on
+        the message thread once it's ready, or with an error.
+     */
+    void createAudioPluginAsync (const juce::PluginDescription& desc, juce::AudioPluginFormat::PluginCreationCallback callback);
+
+    /** Returns true if a plugin can be hosted in its own process. */
+    bool canBridgePlugin (const juce::PluginDescription& desc) const;
+
+    /** Returns true if new instances of a plugin run in their own process. */
+    bool isPluginBridged (const juce::PluginDescription& desc) const;
+
+    /** Run new instances of a plugin in their own process, so a crash there
+        doesn't take the engine down. Adds a block of latency.
+     */
+    void setPluginBridged (const juce::PluginDescription& desc, bool bridged);
+
+    /** Returns true if a plugin can be shared between graphs. */
+    bool canSharePlugin (const juce::PluginDescription& desc) const;
+
+    /** Returns true if new instances of a plugin share one instance. */
+    bool isPluginShared (const juce::PluginDescription& desc) const;
+
+    /** Give every node of a plugin the same instance, rendered once per
+        block for whichever graphs are playing. Saves loading heavy
+        instruments once per graph.
+     */
+    void setPluginShared (const juce::PluginDescription& desc, bool shared);
+
+    /** Takes an instance of a plugin from the warm pool, already prepared
+        at the current play config. Returns nullptr if none is ready. Counts
+        as a use either way, the most used plugins are kept warm.
+     */
+    std::unique_ptr<juce::AudioPluginInstance> takeWarmPlugin (const juce::PluginDescription& desc);
+
     /** Set the play config used when instantiating plugins */
     void setPlayConfig (double sampleRate, int blockSize);
 
@@ -148,6 +188,11 @@ public:
         virtual void audioPluginScanFinished() {}
         virtual void audioPluginScanProgress (const float progress) { juce::ignoreUnused (progress); }
         virtual void audioPluginScanStarted (const juce::String& name) {}
+
+        /** Called on the message thread for each plugin as soon as a worker
+            finds it. The plugin is already in the known list.
+         */
+        virtual void audioPluginFound (const juce::PluginDescription& type) { juce::ignoreUnused (type); }
     };
 
     static const juce::File& getWorkerPluginListFile();
@@ -176,10 +221,15 @@ public:
 private:
     friend class PluginScannerCoordinator;
     friend class juce::Timer;
-    std::unique_ptr<PluginScannerCoordinator> master;
+    juce::OwnedArray<PluginScannerCoordinator> workers;
+    juce::CriticalSection progressLock;
+    juce::Array<float> progress;
     juce::ListenerList<Listener> listeners;
     juce::StringArray failedIdentifiers;
     juce::KnownPluginList& list;
+    void setWorkerProgress (int worker, float progress);
+    void pluginsFound (const juce::Array<juce::PluginDescription>& types);
+    void workerFinished();
     void timerCallback() override;
 };
 
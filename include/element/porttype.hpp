@@ -4,6 +4,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include <element/juce/core.hpp>
 #include <element/juce/data_structures.hpp>
@@ -374,27 +375,40 @@ struct PortIndexComparator {
     }
 };
 
+/** A list of port descriptions, sorted by index.
+
+    Lookups by index, by type and channel, and the nth port of a type take
+    constant time. The tables behind them are rebuilt whenever ports are
+    added or removed, which only happens when a node's ports change.
+    Descriptions shouldn't be changed through the iterators.
+ */
 class PortList {
 public:
     PortList() = default;
     PortList (const PortList& o) { operator= (o); }
-    PortList (PortList&& o) : ports (std::move (o.ports)) {}
+    PortList (PortList&& o) : ports (std::move (o.ports)), lookup (std::move (o.lookup)) {}
 
     ~PortList()
     {
         ports.clear();
     }
 
-    inline void clear() { ports.clear(); }
-    inline void clearQuick() { ports.clearQuick (true); }
+    inline void clear()
+    {
+        ports.clear();
+        updateLookup();
+    }
+
+    inline void clearQuick()
+    {
+        ports.clearQuick (true);
+        updateLookup();
+    }
+
     inline int size() const { return ports.size(); }
     inline int size (int type, bool input) const
     {
-        int n = 0;
-        for (const auto* port : ports)
-            if (port->type == type && port->input == input)
-                ++n;
-        return n;
+        return isValidType (type) ? (int) lookup.ordered[type][input ? 1 : 0].size() : 0;
     }
 
     inline void add (PortDescription* port)
@@ -405,6 +419,7 @@ public:
         jassert (nullptr == findByChannelInternal (port->type, port->channel, port->input));
         PortIndexComparator sorter;
         ports.addSorted (sorter, port);
+        updateLookup();
     }
 
     inline void addControl (int index, int channel, const juce::String& symbol, const juce::String& name, float minValue, float maxValue, float defaultValue, bool input)
@@ -457,6 +472,17 @@ public:
         return ! isInput (port, defaultRet);
     }
 
+    /** Returns the index of the nth port of a type, EL_INVALID_PORT if
+        there aren't that many. Ports count in index order from zero. */
+    inline int getNthPort (int type, int nth, bool input) const
+    {
+        if (! isValidType (type))
+            return static_cast<int> (EL_INVALID_PORT);
+        const auto& ordered = lookup.ordered[type][input ? 1 : 0];
+        return juce::isPositiveAndBelow (nth, (int) ordered.size()) ? ordered[(size_t) nth]->index
+                                                                    : static_cast<int> (EL_INVALID_PORT);
+    }
+
     inline PortDescription getPort (int index) const
     {
         jassert (juce::isPositiveAndBelow (index, ports.size()));
@@ -486,11 +512,16 @@ public:
     }
 
     inline const juce::OwnedArray<PortDescription>& getPorts() const { return ports; }
-    inline void swapWith (PortList& o) { ports.swapWith (o.ports); }
+    inline void swapWith (PortList& o)
+    {
+        ports.swapWith (o.ports);
+        std::swap (lookup, o.lookup);
+    }
 
     PortList& operator= (PortList&& o)
     {
         ports = std::move (o.ports);
+        lookup = std::move (o.lookup);
         return *this;
     }
 
@@ -498,6 +529,7 @@ public:
     {
         ports.clearQuick (true);
         ports.addCopiesOf (o.ports);
+        updateLookup();
         return *this;
     }
 
@@ -506,13 +538,69 @@ public:
         uint32_t index = 0;
         for (auto* port : ports)
             port->index = index++;
+        updateLookup();
     }
 
 private:
     juce::OwnedArray<PortDescription> ports;
 
+    /** Tables for constant time lookups. Indexes and channels are nearly
+        always dense, values too far past the port count to tabulate are
+        found by scanning. */
+    struct Lookup {
+        std::vector<PortDescription*> byIndex;
+        std::vector<PortDescription*> byChannel[PortType::Unknown][2];
+        std::vector<PortDescription*> ordered[PortType::Unknown][2];
+    } lookup;
+
+    static bool isValidType (int type) noexcept { return type >= 0 && type < PortType::Unknown; }
+
+    inline int getTableLimit() const noexcept { return ports.size() * 4 + 64; }
+
+    void updateLookup()
+    {
+        const int limit = getTableLimit();
+        lookup.byIndex.clear();
+        for (auto& types : lookup.byChannel)
+            for (auto& table : types)
+                table.clear();
+        for (auto& types : lookup.ordered)
+            for (auto& table : types)
+                table.clear();
+
+        for (auto* port : ports)
+        {
+            if (juce::isPositiveAndBelow (port->index, limit))
+            {
+                if (port->index >= (int) lookup.byIndex.size())
+                    lookup.byIndex.resize ((size_t) port->index + 1, nullptr);
+                if (lookup.byIndex[(size_t) port->index] == nullptr)
+                    lookup.byIndex[(size_t) port->index] = port;
+            }
+
+            if (! isValidType (port->type))
+                continue;
+
+            const int dir = port->input ? 1 : 0;
+            lookup.ordered[port->type][dir].push_back (port);
+            if (juce::isPositiveAndBelow (port->channel, limit))
+            {
+                auto& table = lookup.byChannel[port->type][dir];
+                if (port->channel >= (int) table.size())
+                    table.resize ((size_t) port->channel + 1, nullptr);
+                // the first port wins, like the scan this replaced.
+                if (table[(size_t) port->channel] == nullptr)
+                    table[(size_t) port->channel] = port;
+            }
+        }
+    }
+
     inline PortDescription* findByIndexInternal (int index) const
     {
+        if (juce::isPositiveAndBelow (index, (int) lookup.byIndex.size()))
+            return lookup.byIndex[(size_t) index];
+        if (index < getTableLimit())
+            return nullptr;
         for (auto* port : ports)
             if (port->index == index)
                 return port;
@@ -529,6 +617,13 @@ private:
 
     inline PortDescription* findByChannelInternal (int type, int channel, bool isInput) const
     {
+        if (! isValidType (type))
+            return nullptr;
+        const auto& table = lookup.byChannel[type][isInput ? 1 : 0];
+        if (juce::isPositiveAndBelow (channel, (int) table.size()))
+            return table[(size_t) channel];
+        if (channel < getTableLimit())
+            return nullptr;
         for (auto* port : ports)
             if (port->type == type && port->channel == channel && port->input == isInput)
                 return port;
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <element/juce/core.hpp>
 #include <element/juce/audio_basics.hpp>
 #include <element/juce/audio_processors.hpp>
@@ -12,6 +14,7 @@
 #include <element/midipipe.hpp>
 #include <element/oversampler.hpp>
 #include <element/parameter.hpp>
+#include <element/parameterevents.hpp>
 #include <element/portcount.hpp>
 #include <element/midichannels.hpp>
 #include <element/signals.hpp>
@@ -36,6 +39,10 @@ struct RenderContext {
     MidiPipe midi;
     AtomPipe atom;
 
+    /** Parameter changes for this block, null unless the node wants them.
+        @see Processor::wantsParameterEvents */
+    const ParameterEvents* params = nullptr;
+
     // clang-format off
     RenderContext (float* const *audioData, 
                    int numAudio,
@@ -52,6 +59,21 @@ struct RenderContext {
           atom (sharedAtom, atomIndexes)
     {}
 
+    RenderContext (float* const *audioData, 
+                   int numAudio,
+                   float* const *cvData, 
+                   int numCV,
+                   juce::MidiBuffer* const *midiData,
+                   int numMidi,
+                   AtomBuffer* const *atomData,
+                   int numAtom,
+                   int numSamples)
+        : audio (audioData, numAudio, numSamples),
+          cv (cvData, numCV, numSamples),
+          midi (midiData, numMidi),
+          atom (atomData, numAtom)
+    {}
+
     RenderContext (float* const *audioData, 
                    int numAudio,
                    float* const *cvData, 
@@ -151,6 +173,12 @@ public:
     /** FIXME: AudioProcessor types access the juce class directly... */
     virtual bool wantsContext() const noexcept { return true; }
 
+    /** Return true to get changes to input parameters in
+        RenderContext::params, placed at the frames they belong to. Parameter
+        values are set as usual either way. Asked when the graph is built.
+     */
+    virtual bool wantsParameterEvents() const noexcept { return false; }
+
     /** Returns the total number of audio inputs */
     int getNumAudioInputs() const;
 
@@ -248,6 +276,19 @@ public:
     /** Suspend processing */
     void suspendProcessing (const bool);
 
+    /** Set bypass or mute from any thread without waiting on the message
+        thread. The renderer reads these once per block, so the change is
+        heard on the next one. Nothing is notified; call syncBypassAndMute()
+        on the message thread afterwards.
+     */
+    void setBypassFlag (bool shouldBypass) noexcept { bypassed.set (shouldBypass ? 1 : 0); }
+    void setMuteFlag (bool shouldMute) noexcept { mute.set (shouldMute ? 1 : 0); }
+
+    /** Brings the wrapped processor and listeners up to date after
+        setBypassFlag() or setMuteFlag(). Message thread only.
+     */
+    void syncBypassAndMute();
+
     /** Get latency audio samples */
     int getLatencySamples() const;
 
@@ -283,6 +324,20 @@ public:
      */
     GraphNode* getParentGraph() const;
 
+    /** Start computing levels for a meter. Call stopMetering() when the
+        meter goes away. Levels are only measured while at least one meter
+        is open.
+     */
+    void startMetering() noexcept { meters.fetch_add (1, std::memory_order_relaxed); }
+    void stopMetering() noexcept
+    {
+        [[maybe_unused]] const auto was = meters.fetch_sub (1, std::memory_order_relaxed);
+        jassert (was > 0);
+    }
+
+    /** Returns true if a meter wants this node's levels. */
+    bool isMetering() const noexcept { return meters.load (std::memory_order_relaxed) > 0; }
+
     void setInputRMS (int chan, float val);
     float getInputRMS (int chan) const { return (chan < inRMS.size()) ? inRMS.getUnchecked (chan)->get() : 0.0f; }
     void setOutputRMS (int chan, float val);
@@ -299,6 +354,11 @@ public:
     /** Returns true if this node is enabled */
     inline bool isEnabled() const { return enabled.get() == 1; }
 
+    /** Returns true while the node is being prepared in the background. It
+        renders as if disabled until that finishes.
+     */
+    bool isPreparing() const noexcept { return preparing.load (std::memory_order_acquire); }
+
     //=========================================================================
     inline void setKeyRange (const int low, const int high)
     {
@@ -307,6 +367,7 @@ public:
         jassert (isPositiveAndBelow (high, 128));
         keyRangeLow.set (low);
         keyRangeHigh.set (high);
+        updateMidiFilter();
     }
 
     inline void setKeyRange (const Range<int>& range) { setKeyRange (range.getStart(), range.getEnd()); }
@@ -318,12 +379,31 @@ public:
     {
         jassert (value >= -24 && value <= 24);
         transposeOffset.set (value);
+        updateMidiFilter();
     }
 
     inline int getTransposeOffset() const { return transposeOffset.get(); }
 
     const CriticalSection& getPropertyLock() const { return propertyLock; }
 
+    //=========================================================================
+    /** MIDI filter settings as seen by the render thread. */
+    struct MidiFilter
+    {
+        Range<int> keyRange { 0, 127 };
+        int transpose = 0;
+        uint32 channels = 1u; ///< bit 0 is omni, bits 1-16 are channels
+        bool programsEnabled = false;
+
+        bool isOmni() const noexcept { return (channels & 1u) != 0; }
+        bool isOff (int channel) const noexcept { return ! isOmni() && (channels & (1u << channel)) == 0; }
+    };
+
+    /** Returns the key range, transpose, MIDI channels and program flag in
+        one consistent snapshot. Realtime safe, this is a single atomic load.
+     */
+    MidiFilter getMidiFilter() const noexcept;
+
     //=========================================================================
     /** Returns the file used for the current global MIDI Program */
     File getMidiProgramFile (int program = -1) const;
@@ -339,7 +419,11 @@ public:
     inline bool areMidiProgramsEnabled() const { return midiProgramsEnabled.get() == 1; }
 
     /** Enable or disable changing midi programs */
-    inline void setMidiProgramsEnabled (bool enabled) { midiProgramsEnabled.set (enabled ? 1 : 0); }
+    inline void setMidiProgramsEnabled (bool enabled)
+    {
+        midiProgramsEnabled.set (enabled ? 1 : 0);
+        updateMidiFilter();
+    }
 
     /** Returns the active midi program */
     inline int getMidiProgram() const { return midiProgram.get(); }
@@ -356,6 +440,18 @@ public:
     /** Reloads the active MIDI program */
     void reloadMidiProgram();
 
+    /** Decode this node's saved global MIDI programs into memory, a few at
+        a time on the message thread, so a program change later only has to
+        apply the state. Programs saved or removed afterwards are picked up
+        when they're next loaded.
+     */
+    void prefetchMidiPrograms();
+
+    /** Returns the program whose state was last applied, or -1 if none was.
+        Updated before midiProgramChanged is triggered.
+     */
+    inline int getLoadedMidiProgram() const { return lastMidiProgram.get(); }
+
     /** Save the current MIDI program */
     void saveMidiProgram();
 
@@ -375,8 +471,11 @@ public:
     //=========================================================================
     inline void setMidiChannels (const BigInteger& ch)
     {
-        ScopedLock sl (propertyLock);
-        midiChannels.setChannels (ch);
+        {
+            ScopedLock sl (propertyLock);
+            midiChannels.setChannels (ch);
+        }
+        updateMidiFilter();
     }
 
     inline const MidiChannels& getMidiChannels() const { return midiChannels; }
@@ -419,15 +518,99 @@ public:
     virtual void getState (MemoryBlock&) = 0;
     virtual void setState (const void*, int sizeInBytes) = 0;
 
+    /** Note that what getState() returns may have changed. Any thread. */
+    void markStateChanged() noexcept { stateVersion.fetch_add (1, std::memory_order_relaxed); }
+
+    /** Counts calls to markStateChanged(), so a caller can tell whether the
+        state needs saving again. Nodes which never mark changes stay at 0.
+     */
+    uint32 getStateVersion() const noexcept { return stateVersion.load (std::memory_order_relaxed); }
+
     //==========================================================================
     void setOversamplingFactor (int osFactor);
     int getOversamplingFactor();
 
+    /** Oversample with linear phase filters instead of the default minimum
+        phase ones. Adds latency.
+     */
+    void setLinearPhaseOversampling (bool linearPhase);
+    bool isLinearPhaseOversampling() const;
+
     //==========================================================================
     void setDelayCompensation (double delayMs);
     double getDelayCompensation() const;
     int getDelayCompensationSamples() const;
 
+    //==========================================================================
+    /** Set how long this node can keep making sound after its input stops, in
+        milliseconds. When the inputs and outputs have been silent for longer
+        than this the graph puts the node to sleep, skipping its processing
+        until input arrives again. A negative value never sleeps (default).
+     */
+    void setTailLength (double tailMs);
+    double getTailLength() const;
+
+    /** Returns the tail in samples, or -1 if this node never sleeps. Realtime safe. */
+    int getTailLengthSamples() const noexcept { return tailSamples.load (std::memory_order_relaxed); }
+
+    //==========================================================================
+    /** Timing of this node's processing, gathered while profiling is on.
+        Times are in microseconds per block, load is the share of a block's
+        duration spent processing this node.
+     */
+    struct ProcessStats
+    {
+        int64 numBlocks = 0;
+        double minimum = 0.0, maximum = 0.0, average = 0.0;
+        double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+        double load = 0.0;
+    };
+
+    /** Turn per block timing on or off. Stats are reset when turned on. */
+    void setProfilingEnabled (bool shouldProfile);
+
+    /** Returns true if this node's processing is being timed. */
+    bool isProfilingEnabled() const noexcept { return profiling.load (std::memory_order_relaxed); }
+
+    /** Returns a snapshot of the timing stats. Safe to call from any thread,
+        though the fields are read separately and may straddle a block.
+     */
+    ProcessStats getProcessStats() const noexcept;
+
+    /** Clear the stats. They are cleared on the render thread's next block. */
+    void resetProcessStats() noexcept;
+
+    /** Record the time a block took. Called by the graph while rendering. */
+    void recordProcessTime (int64 ticks, int numSamples) noexcept;
+
+    //==========================================================================
+    /** Returns the number of blocks in which this node output NaN or
+        infinite samples. Only counted while the signal guard is on.
+     */
+    int64 getNumSignalFaults() const noexcept { return signalFaults.load (std::memory_order_relaxed); }
+
+    /** Returns true if the signal guard bypassed this node. Cleared when
+        the node is un-bypassed.
+     */
+    bool isFaultBypassed() const noexcept { return faultBypassed.load (std::memory_order_relaxed); }
+
+    /** Clear the fault count. Doesn't change the bypass. */
+    void resetSignalFaults() noexcept { signalFaults.store (0, std::memory_order_relaxed); }
+
+    /** Count a faulty block, and bypass the node if it should be. Called by
+        the graph while rendering. signalFaulted is sent afterwards when the
+        node is bypassed.
+     */
+    void recordSignalFault (bool shouldBypass) noexcept;
+
+    //==========================================================================
+    /** Returns the bytes this node holds for processing, best effort. The
+        default counts the oversampling buffers, nodes add what they
+        allocate themselves and graphs add their nodes. Memory inside
+        hosted plugins can't be seen and isn't counted. Message thread.
+     */
+    virtual int64 getMemoryUsage() const;
+
     //=========================================================================
     virtual bool hasEditor() { return false; }
     virtual Editor* createEditor() { return nullptr; }
@@ -445,6 +628,9 @@ public:
     /** Triggered when the mute state changes */
     Signal<void (Processor*)> muteChanged;
 
+    /** Triggered on the message thread when the signal guard bypasses this node */
+    Signal<void (Processor*)> signalFaulted;
+
     /** Triggered immediately before this node is removed from a graph */
     Signal<void()> willBeRemoved;
 
@@ -515,6 +701,8 @@ private:
 
     Atomic<float> gain, lastGain, inputGain, lastInputGain;
     OwnedArray<AtomicValue<float>> inRMS, outRMS;
+    std::atomic<int> meters { 0 };
+    std::atomic<uint32> stateVersion { 0 };
 
     Atomic<int> keyRangeLow { 0 };
     Atomic<int> keyRangeHigh { 127 };
@@ -527,6 +715,9 @@ private:
     Atomic<int> globalMidiPrograms { 0 };
 
     CriticalSection propertyLock;
+    std::atomic<uint64> midiFilter { 0 };
+    void updateMidiFilter();
+
     struct EnablementUpdater : public AsyncUpdater {
         EnablementUpdater (Processor& g) : graph (g) {}
         ~EnablementUpdater() {}
@@ -549,6 +740,15 @@ private:
         Processor& node;
     } portResetter;
 
+    std::atomic<int64> signalFaults { 0 };
+    std::atomic<bool> faultBypassed { false };
+    struct FaultNotifier : public AsyncUpdater {
+        FaultNotifier (Processor& n) : node (n) {}
+        ~FaultNotifier() { cancelPendingUpdate(); }
+        void handleAsyncUpdate() override;
+        Processor& node;
+    } faultNotifier;
+
     struct MidiProgram {
         int program;
         String name;
@@ -572,6 +772,21 @@ private:
     double delayCompMillis = 0.0;
     int delayCompSamples = 0;
 
+    double tailMillis = -1.0;
+    std::atomic<int> tailSamples { -1 };
+    void updateTailSamples();
+
+    struct Profile;
+    std::unique_ptr<Profile> profile;
+
+    struct MidiProgramCache;
+    std::unique_ptr<MidiProgramCache> programCache;
+    MidiProgramCache& getMidiProgramCache();
+    std::atomic<bool> profiling { false };
+
+    std::atomic<bool> preparing { false };
+    juce::CriticalSection prepareLock;
+
     juce::AudioPlayHead* _playhead { nullptr };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Processor)
@@ -10,7 +10,9 @@ enum struct RunMode : int {
     /** Running as standalone application */
     Standalone = 0,
     /** Running as an audio plugin */
-    Plugin = 1
+    Plugin = 1,
+    /** Running as a standalone application without any UI */
+    Headless = 2
 };
 
 } // namespace element
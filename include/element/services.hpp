@@ -37,6 +37,14 @@ public:
     /** Save service settings. */
     virtual void saveSettings() {}
 
+    /** Returns true if this can wait to be activated until the main window
+        is up. It's activated sooner if something finds it first.
+     */
+    virtual bool isDeferred() const { return false; }
+
+    /** Returns true once this has been activated. */
+    bool isActive() const noexcept { return active; }
+
     /** Locate a sibling service by type. */
     template <class T>
     inline T* sibling() const;
@@ -52,6 +60,7 @@ protected:
 private:
     friend class Services;
     Services* owner = nullptr;
+    bool active = false;
 };
 
 //=============================================================================
@@ -69,13 +78,18 @@ public:
     /** Add a service */
     void add (Service* service);
 
-    /** Find a service by type */
+    /** Find a service by type. A deferred one is activated first if the
+        others are active.
+     */
     template <class T>
     inline T* find() const
     {
         for (auto* c : *this)
             if (T* t = const_cast<T*> (dynamic_cast<const T*> (c)))
+            {
+                require (*t);
                 return t;
+            }
         return nullptr;
     }
 
@@ -114,6 +128,8 @@ private:
     class Impl;
     std::unique_ptr<Impl> impl;
 
+    void require (Service&) const;
+
     /** Run/Launch the core application. */
     void run();
 };
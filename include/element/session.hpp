@@ -100,8 +100,12 @@ public:
     void setActiveGraph (int index);
     bool containsGraph (const Node& graph) const;
 
-    /** Writes an encoded file */
-    bool writeToFile (const File&) const;
+    /** Writes an encoded file. The level is deflate's, from 0 to store
+        uncompressed up to 9. Low levels save large sessions much faster.
+     */
+    bool writeToFile (const File&, int compressionLevel = 1) const;
+
+    /** Reads session data from a file, including older XML sessions. */
     static ValueTree readFromFile (const File&);
 
     Value getActiveGraphIndexObject (bool syncUpdate = false) const
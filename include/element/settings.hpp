@@ -31,6 +31,7 @@ public:
     static const char* generateMidiClockKey;
     static const char* sendMidiClockToInputKey;
     static const char* hidePluginWindowsWhenFocusLostKey;
+    static const char* releaseMinimisedEditorsKey;
     static const char* lastGraphKey;
     static const char* lastSessionKey;
     static const char* legacyInterfaceKey;
@@ -50,11 +51,38 @@ public:
     static const char* updateKeyKey;
     static const char* updateKeyUserKey;
     static const char* transportStartStopContinue;
+    static const char* renderThreadsKey;
+    static const char* renderQuantumKey;
+    static const char* flattenSubgraphsKey;
+    static const char* guardNodeOutputsKey;
+    static const char* standbyGraphsKey;
+    static const char* looperSecondsKey;
+    static const char* realtimeCoresKey;
+    static const char* backgroundCoresKey;
+    static const char* realtimePriorityKey;
+    static const char* metricsPortKey;
+    static const char* autosaveIntervalKey;
+    static const char* sessionCompressionKey;
+    static const char* undoHistorySizeKey;
+    static const char* bridgedPluginsKey;
+    static const char* sharedPluginsKey;
+    static const char* warmPluginsKey;
+    static const char* pluginUsageKey;
+    static const char* aggregateDevicesKey;
 
     bool getBool (std::string_view key, bool fallback = false) const noexcept;
 
     void set (std::string_view key, const juce::var& value);
 
+    /** Writes changed settings on a background thread and returns at once.
+        Changes are also written on their own shortly after they're made,
+        so a burst of changes is written once.
+     */
+    void saveIfNeeded();
+
+    /** Writes changed settings now and waits until they're on disk. */
+    void flush();
+
     std::unique_ptr<juce::XmlElement> getLastGraph() const;
     void setLastGraph (const juce::ValueTree& data);
 
@@ -104,6 +132,11 @@ public:
     void setHidePluginWindowsWhenFocusLost (const bool);
     bool hidePluginWindowsWhenFocusLost() const;
 
+    /** True if plugin editors are deleted while their window is minimised,
+        and created again when it's restored. */
+    void setReleaseMinimisedEditors (const bool);
+    bool releaseMinimisedEditors() const;
+
     void setUseLegacyInterface (const bool);
     bool useLegacyInterface() const;
 
@@ -118,6 +151,93 @@ public:
     double getMidiOutLatency() const;
     void setMidiOutLatency (double latencyMs);
 
+    /** Returns the number of extra threads used to render graphs.
+        Zero means graphs are rendered on the audio thread only.
+     */
+    int getNumRenderThreads() const;
+    void setNumRenderThreads (int numThreads);
+
+    /** Returns the largest sub-block graphs are rendered in, in samples.
+        Zero means whole device blocks are rendered.
+     */
+    int getRenderQuantum() const;
+    void setRenderQuantum (int numSamples);
+
+    /** Returns true if subgraphs are inlined into their parent graph's
+        rendering when possible.
+     */
+    bool isFlatteningSubgraphs() const;
+    void setFlattenSubgraphs (bool shouldFlatten);
+
+    /** Returns true if NaN, infinite and denormal samples are zeroed after
+        each node renders, and nodes that keep making them are bypassed.
+     */
+    bool isGuardingNodeOutputs() const;
+    void setGuardNodeOutputs (bool shouldGuard);
+
+    /** Returns how many graphs after the current one are kept ready for a
+        program change. Graphs further away are released until needed.
+        A negative value keeps every graph ready.
+     */
+    int getStandbyGraphs() const;
+    void setStandbyGraphs (int numGraphs);
+
+    /** Returns the longest loop a Looper node records, in seconds. Its
+        memory is allocated up front for that long.
+     */
+    int getLooperSeconds() const;
+    void setLooperSeconds (int seconds);
+
+    /** Returns the cores the audio thread and render workers are pinned
+        to, e.g. "2-3". Empty leaves them unpinned.
+     */
+    juce::String getRealtimeCores() const;
+    void setRealtimeCores (const juce::String& cores);
+
+    /** Returns the cores background threads are pinned to. */
+    juce::String getBackgroundCores() const;
+    void setBackgroundCores (const juce::String& cores);
+
+    /** Returns the SCHED_FIFO priority for realtime threads, 1 to 99.
+        Zero leaves scheduling to the audio backend.
+     */
+    int getRealtimePriority() const;
+    void setRealtimePriority (int priority);
+
+    /** Returns the local port engine metrics are served on over HTTP, zero
+        when they aren't.
+     */
+    int getMetricsPort() const;
+    void setMetricsPort (int port);
+
+    /** Returns the minutes between autosaves, zero turns autosave off. */
+    int getAutosaveInterval() const;
+    void setAutosaveInterval (int minutes);
+
+    /** Returns the deflate level sessions are saved with, 0 stores them
+        uncompressed and 9 is smallest but slowest.
+     */
+    int getSessionCompression() const;
+    void setSessionCompression (int level);
+
+    /** Returns the megabytes undo history may hold before the oldest steps
+        are dropped.
+     */
+    int getUndoHistorySize() const;
+    void setUndoHistorySize (int megabytes);
+
+    /** Returns how many of the most used plugins are kept instantiated,
+        ready to be added to a graph.
+     */
+    int getWarmPluginCount() const;
+    void setWarmPluginCount (int count);
+
+    /** Returns the audio devices combined by the Aggregate device, the
+        one that clocks the others first.
+     */
+    juce::StringArray getAggregateDevices() const;
+    void setAggregateDevices (const juce::StringArray& names);
+
     double getDesktopScale() const;
     void setDesktopScale (double);
 
@@ -163,6 +283,8 @@ public:
     bool transportRespondToStartStopContinue() const;
 
 private:
+    class Writer;
+    std::unique_ptr<Writer> writer;
     juce::PropertiesFile* getProps() const;
 };
 
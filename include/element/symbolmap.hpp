@@ -4,28 +4,48 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 
-#include <lvtk/symbols.hpp>
+#include <lv2/core/lv2.h>
+#include <lv2/urid/urid.h>
 
 namespace element {
 
+/** Maps URIs to LV2 URIDs and back, safe to use from any thread.
+
+    Lookups of URIs that are already mapped never lock, so plugins
+    instantiating in parallel or unmapping while they run don't serialize.
+    Mapping a new URI only locks the shard it hashes to. Well-known LV2
+    URIs are mapped when the map is created.
+ */
 class SymbolMap final {
 public:
-    SymbolMap() noexcept {}
-    ~SymbolMap() {}
+    SymbolMap();
+    ~SymbolMap();
+
+    const uint32_t map (const char* str) noexcept;
+    const char* unmap (uint32_t urid) const noexcept;
 
-    const uint32_t map (const char* str) noexcept { return _sym.map (str); }
-    const char* unmap (uint32_t urid) noexcept { return _sym.unmap (urid); }
+    /** Returns how many URIs are mapped. */
+    uint32_t size() const noexcept;
 
-    inline auto mapPtr() const noexcept { return (LV2_URID_Map*) _sym.map_feature()->data; }
-    inline auto mapFeature() const noexcept { return _sym.map_feature(); }
-    inline auto unmapPtr() const noexcept { return (LV2_URID_Unmap*) _sym.unmap_feature()->data; }
-    inline auto unmapFeature() const noexcept { return _sym.unmap_feature(); }
+    inline auto mapPtr() const noexcept { return const_cast<LV2_URID_Map*> (&mapData); }
+    inline auto mapFeature() const noexcept { return &mapFeat; }
+    inline auto unmapPtr() const noexcept { return const_cast<LV2_URID_Unmap*> (&unmapData); }
+    inline auto unmapFeature() const noexcept { return &unmapFeat; }
 
     inline operator LV2_URID_Map*() const noexcept { return mapPtr(); }
 
 private:
-    lvtk::Symbols _sym;
+    struct Tables;
+    std::unique_ptr<Tables> tables;
+
+    LV2_URID_Map mapData;
+    LV2_URID_Unmap unmapData;
+    LV2_Feature mapFeat, unmapFeat;
+
+    SymbolMap (const SymbolMap&) = delete;
+    SymbolMap& operator= (const SymbolMap&) = delete;
 };
 
 } // namespace element
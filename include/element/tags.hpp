@@ -99,6 +99,7 @@ static const juce::Identifier controller = "controller";
 static const juce::Identifier controllers = "controllers";
 static const juce::Identifier collapsed = "collapsed";
 static const juce::Identifier delayCompensation = "delayCompensation";
+static const juce::Identifier tailLength = "tailLength";
 static const juce::Identifier displayMode = "displayMode";
 static const juce::Identifier enabled = "enabled";
 static const juce::Identifier gain = "gain";
@@ -113,6 +114,7 @@ static const juce::Identifier node = "node";
 static const juce::Identifier nodes = "nodes";
 static const juce::Identifier notes = "notes";
 static const juce::Identifier oversamplingFactor = "oversamplingFactor";
+static const juce::Identifier oversamplingLinearPhase = "oversamplingLinearPhase";
 static const juce::Identifier persistent = "persistent";
 static const juce::Identifier placeholder = "placeholder";
 static const juce::Identifier port = "port";
@@ -146,6 +148,9 @@ static const juce::Identifier midiProgramsEnabled = "midiProgramsEnabled";
 static const juce::Identifier globalMidiPrograms = "globalMidiPrograms";
 static const juce::Identifier midiProgramsState = "midiProgramsState";
 static const juce::Identifier renderMode = "renderMode";
+static const juce::Identifier devicePorts = "devicePorts";
+static const juce::Identifier doublePrecision = "doublePrecision";
+static const juce::Identifier internalRate = "internalRate";
 
 static const juce::Identifier staticPos = "staticPos";
 
@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include <element/linkedlist.hpp>
 
@@ -186,8 +187,12 @@ public:
     // Node list accessor.
     const LinkedList<Node>& nodes() const { return mNodes; }
 
-    // To optimize and keep track of current frame
-    // position, mostly like an sequence cursor/iterator.
+    /** Keeps track of the current position in the tempo map.
+
+        Seeks within the current node or to the one after it, as happens
+        during playback, take constant time. Anything else is a binary
+        search of the map, so long tempo-mapped timelines seek in log time.
+     */
     class Cursor {
     public:
         Cursor (TimeScale* scale) : ts (scale), node (0) {}
@@ -429,8 +434,7 @@ public:
         std::string color;
     };
 
-    // To optimize and keep track of current frame
-    // position, mostly like an sequence cursor/iterator.
+    /** Keeps track of the current marker, seeking like Cursor. */
     class MarkerCursor {
     public:
         // Constructor.
@@ -491,6 +495,11 @@ private:
     // Tempo-map node list.
     LinkedList<Node> mNodes;
 
+    // The node list in order, for binary searching. Rebuilt whenever nodes
+    // are added or removed, their keys only ever move together.
+    std::vector<Node*> mNodeIndex;
+    void updateNodeIndex();
+
     // Internal node cursor.
     Cursor mCursor;
 
@@ -500,6 +509,8 @@ private:
 
     // Location marker list.
     LinkedList<Marker> mMarkers;
+    std::vector<Marker*> mMarkerIndex;
+    void updateMarkerIndex();
 
     // Internal node cursor.
     MarkerCursor mMarkerCursor;
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 
 #include <element/atomic.hpp>
@@ -39,37 +41,70 @@ public:
     int getBeatsPerBar() const { return getTimeScale().beatsPerBar(); }
     int getBeatType() const { return getTimeScale().beatType(); }
 
-    inline void requestPlayState (bool p)
-    {
-        while (! playState.set (p)) {
-        }
-    }
-    inline void requestPlayPause() { requestPlayState (! playState.get()); }
-    inline void requestRecordState (bool r)
-    {
-        while (! recordState.set (r)) {
-        }
-    }
-    inline void requestTempo (const double bpm)
-    {
-        while (! nextTempo.set (bpm)) {
-        }
-    }
-    void requestMeter (int beatsPerBar, int beatType);
-
-    void requestAudioFrame (const int64_t frame);
+    /** Requests are queued and applied by the audio thread in the order
+        they were made, none are lost. Any thread can make them.
 
+        `offset` is the frame in the next processed block the request takes
+        effect at. Offsets past the block carry over to later blocks. Locate
+        and play state changes inside a block move the position exactly,
+        the playhead reports one position, tempo and meter per block though.
+
+        Each returns false if the queue is full.
+     */
+    bool requestPlayState (bool shouldPlay, int64_t offset = 0);
+    bool requestPlayPause();
+    bool requestRecordState (bool shouldRecord, int64_t offset = 0);
+    bool requestTempo (double bpm, int64_t offset = 0);
+
+    /** Change tempo gradually, reaching `bpm` after `lengthFrames`. The
+        tempo steps once a block on the way. Another tempo request cancels it.
+     */
+    bool requestTempoRamp (double bpm, int64_t lengthFrames, int64_t offset = 0);
+
+    bool requestMeter (int beatsPerBar, int beatType, int64_t offset = 0);
+    bool requestAudioFrame (int64_t frame, int64_t offset = 0);
+
+    /** Apply requests due at the start of the block. Audio thread. */
     void preProcess (int nframes);
+
+    /** Advance through the block applying requests due in it. Audio thread. */
     void postProcess (int nframes);
 
     inline MonitorPtr getMonitor() const { return monitor; }
 
 private:
-    AtomicValue<bool> playState, recordState;
-    AtomicValue<double> nextTempo;
-    juce::Atomic<int> nextBeatsPerBar, nextBeatDivisor;
-    juce::Atomic<bool> seekWanted;
-    AtomicValue<int64_t> seekFrame;
+    struct Command {
+        enum Type { play,
+                    record,
+                    tempo,
+                    ramp,
+                    meter,
+                    locate };
+        Type type = play;
+        int64_t offset = 0;
+        int64_t frame = 0; // locate target or ramp length
+        double tempo = 0.0;
+        int beatsPerBar = 0, beatDivisor = 0;
+        bool state = false;
+    };
+
+    static constexpr int capacity = 256;
+    std::array<Command, capacity> queue;
+    juce::AbstractFifo fifo { capacity };
+    juce::SpinLock writeLock;
+    std::atomic<bool> requestedPlaying { false };
+
+    // audio thread only
+    std::array<Command, capacity> pending;
+    int numPending = 0;
+    double rampStart = 0.0, rampTarget = 0.0;
+    int64_t rampLength = 0, rampDone = 0;
+
+    bool push (const Command& command);
+    void drain();
+    void apply (const Command& command);
+    void advanceRamp (int64_t frames);
+
     MonitorPtr monitor;
 };
 
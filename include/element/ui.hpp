@@ -18,6 +18,7 @@ class ContentFactory;
 class Context;
 class LookAndFeel_E1;
 class MainWindow;
+class MessageScheduler;
 class PluginWindow;
 class Services;
 class WindowManager;
@@ -80,6 +81,16 @@ public:
     /** Stabilize Views Only */
     void stabilizeViews();
 
+    /** Like stabilizeContent(), but on the message scheduler. Calls made
+        before it runs only stabilize once. */
+    void stabilizeContentLater();
+
+    /** Like stabilizeViews(), but on the message scheduler. */
+    void stabilizeViewsLater();
+
+    /** Returns the scheduler that spreads UI work across frames. */
+    MessageScheduler& scheduler();
+
     /** Refershes the system tray based on Settings */
     void refreshSystemTray();
 
@@ -59,6 +59,8 @@ public:
 
         panic,
         importSession,
+        sessionCue,
+        sessionSwitchToCued,
 
         checkNewerVersion = 0x0500,
 
@@ -141,6 +143,8 @@ public:
 
             panic,
             importSession,
+            sessionCue,
+            sessionSwitchToCued,
 
             checkNewerVersion,
 
@@ -27,6 +27,8 @@ public:
 
     void changeListenerCallback (juce::ChangeBroadcaster* source) override;
     void activeWindowStatusChanged() override;
+    void minimisationStateChanged (bool isNowMinimised) override;
+    void visibilityChanged() override;
     void refreshName();
 
 private:
@@ -39,6 +41,7 @@ private:
 
     void nameChanged();
     void nameChangedSession();
+    void updateActivity();
 };
 
 } // namespace element
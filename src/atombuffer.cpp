@@ -1,6 +1,7 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <algorithm>
 #include <cassert>
 
 #include <element/atombuffer.hpp>
@@ -12,7 +13,8 @@
 namespace element {
 
 AtomBuffer::AtomBuffer()
-    : _data (8192)
+    : _data (8192),
+      _scratch (8192)
 {
     _capacity = _data.size();
     _ptrs.raw = _data.data();
@@ -24,6 +26,7 @@ AtomBuffer::~AtomBuffer()
     _capacity = 0;
     _ptrs.raw = nullptr;
     _data.reset();
+    _scratch.reset();
 }
 
 void AtomBuffer::setTypes (LV2_URID_Map* map)
@@ -48,12 +51,15 @@ void AtomBuffer::prepare()
     _ptrs.atom->size = _capacity - sizeof (LV2_Atom_Sequence_Body);
 }
 
-void AtomBuffer::insert (int64_t frames, uint32_t size, uint32_t type, const void* data)
+bool AtomBuffer::insert (int64_t frames, uint32_t size, uint32_t type, const void* data)
 {
-    if (sizeof (LV2_Atom) + _ptrs.atom->size + lv2_atom_pad_size (size) > _capacity)
-        return;
-
     const auto size_needed = lv2_atom_pad_size (sizeof (LV2_Atom_Event) + size);
+    if (sizeof (LV2_Atom) + _ptrs.atom->size + size_needed > _capacity)
+    {
+        ++_dropped;
+        return false;
+    }
+
     LV2_Atom_Event* ev = (LV2_Atom_Event*) ((uint8_t*) _ptrs.seq + lv2_atom_total_size (&_ptrs.seq->atom));
 
     LV2_ATOM_SEQUENCE_FOREACH (_ptrs.seq, i)
@@ -76,6 +82,7 @@ void AtomBuffer::insert (int64_t frames, uint32_t size, uint32_t type, const voi
     std::memcpy (ev + 1, data, size);
 
     _ptrs.atom->size += size_needed;
+    return true;
 }
 
 void AtomBuffer::insert (juce::MidiMessage& msg, int frame)
@@ -86,15 +93,107 @@ void AtomBuffer::insert (juce::MidiMessage& msg, int frame)
             msg.getRawData());
 }
 
+void AtomBuffer::copyFrom (const AtomBuffer& other)
+{
+    if (&other == this)
+        return;
+
+    const auto total = lv2_atom_total_size (other._ptrs.atom);
+    if (total <= _capacity)
+    {
+        std::memcpy (_ptrs.raw, other._ptrs.raw, total);
+        return;
+    }
+
+    // a bigger source, keep what fits.
+    clear();
+    const AtomBuffer* source = &other;
+    merge (&source, 1);
+}
+
 void AtomBuffer::add (const AtomBuffer& other)
 {
-    LV2_ATOM_SEQUENCE_FOREACH (other._ptrs.seq, i)
+    const AtomBuffer* source = &other;
+    merge (&source, 1);
+}
+
+void AtomBuffer::merge (const AtomBuffer* const* sources, int numSources)
+{
+    // cursors stay on the stack, larger fan-ins are merged in groups.
+    static constexpr int maxCursors = 16;
+    while (numSources > maxCursors - 1)
+    {
+        merge (sources, maxCursors - 1);
+        sources += maxCursors - 1;
+        numSources -= maxCursors - 1;
+    }
+
+    const LV2_Atom_Event* cursors[maxCursors];
+    const LV2_Atom_Event* ends[maxCursors];
+    int numCursors = 0;
+
+    auto addCursor = [&] (const LV2_Atom_Sequence* seq) {
+        auto* const begin = lv2_atom_sequence_begin (&seq->body);
+        auto* const end = lv2_atom_sequence_end (&seq->body, seq->atom.size);
+        if (begin >= end)
+            return;
+        cursors[numCursors] = begin;
+        ends[numCursors] = end;
+        ++numCursors;
+    };
+
+    addCursor (_ptrs.seq);
+    const bool hadEvents = numCursors > 0;
+    for (int i = 0; i < numSources; ++i)
+        if (sources[i] != nullptr && sources[i] != this)
+            addCursor (sources[i]->_ptrs.seq);
+
+    if (numCursors == 0 || (hadEvents && numCursors == 1))
+        return;
+
+    // into an empty buffer events go straight to their place, otherwise
+    // through scratch and back with one copy.
+    const auto space = (uint32_t) std::min ((size_t) _capacity, _scratch.size()) - (uint32_t) sizeof (LV2_Atom_Sequence);
+    auto* const out = hadEvents ? static_cast<uint8_t*> (_scratch.data())
+                                : reinterpret_cast<uint8_t*> (_ptrs.seq + 1);
+    uint32_t used = 0;
+
+    while (numCursors > 0)
     {
-        insert (i->time.frames,
-                i->body.size,
-                i->body.type,
-                LV2_ATOM_BODY (&i->body));
+        int next = 0;
+        for (int i = 1; i < numCursors; ++i)
+            if (cursors[i]->time.frames < cursors[next]->time.frames)
+                next = i;
+
+        const auto* const ev = cursors[next];
+        const auto size = (uint32_t) sizeof (LV2_Atom_Event) + ev->body.size;
+        const auto padded = lv2_atom_pad_size (size);
+        if (used + padded <= space)
+        {
+            std::memcpy (out + used, ev, size);
+            used += padded;
+        }
+        else
+        {
+            ++_dropped;
+        }
+
+        cursors[next] = lv2_atom_sequence_next (ev);
+        if (cursors[next] >= ends[next])
+        {
+            // keep the remaining cursors in source order for stable ties.
+            --numCursors;
+            for (int i = next; i < numCursors; ++i)
+            {
+                cursors[i] = cursors[i + 1];
+                ends[i] = ends[i + 1];
+            }
+        }
     }
+
+    if (hadEvents)
+        std::memcpy (_ptrs.seq + 1, out, used);
+    _ptrs.atom->size = (uint32_t) sizeof (LV2_Atom_Sequence_Body) + used;
 }
 
 void AtomBuffer::add (juce::MidiBuffer& midi)
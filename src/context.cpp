@@ -40,6 +40,22 @@ inline static void setupChildProcessHandlers (RunMode mode)
 }
 } // namespace detail
 
+/** Registries every Context in a plugin process shares. The first instance
+    builds them and the last one frees them, so later instances don't map
+    URIs or load the LV2 world again.
+ */
+class SharedRegistries final
+{
+public:
+    SharedRegistries() = default;
+
+    SymbolMap symbols;
+    LV2NodeProvider lv2 { symbols };
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (SharedRegistries)
+};
+
 class Context::Impl
 {
 public:
@@ -57,6 +73,8 @@ public:
     AudioEnginePtr engine;
     SessionPtr session;
 
+    // plugins use the process' registries, the app has its own.
+    std::unique_ptr<SharedResourcePointer<SharedRegistries>> shared;
     std::unique_ptr<SymbolMap> symbols;
     std::unique_ptr<DeviceManager> devices;
     std::unique_ptr<PluginManager> plugins;
@@ -71,9 +89,17 @@ public:
 private:
     friend class Context;
 
+    SymbolMap& getSymbols() const noexcept
+    {
+        return shared != nullptr ? (*shared)->symbols : *symbols;
+    }
+
     void init()
     {
-        symbols.reset (new SymbolMap());
+        if (mode == RunMode::Plugin)
+            shared = std::make_unique<SharedResourcePointer<SharedRegistries>>();
+        else
+            symbols.reset (new SymbolMap());
         log.reset (new Log());
         devices.reset (new DeviceManager());
         settings.reset (new Settings());
@@ -92,7 +118,8 @@ private:
         auto& nf = plugins->getNodeFactory();
         nf.add (new InternalNodes (owner));
         nf.add (new AudioProcessorFactory (owner));
-        nf.add (new LV2NodeProvider (*symbols));
+        nf.add (shared != nullptr ? new LV2NodeProvider ((*shared)->lv2.getWorld())
+                                  : new LV2NodeProvider (*symbols));
         plugins->addDefaultFormats();
     }
 
@@ -108,6 +135,7 @@ private:
         presets = nullptr;
         lua = nullptr;
         log = nullptr;
+        shared = nullptr;
     }
 };
 
@@ -265,6 +293,6 @@ void Context::addModulePath (const std::string& path)
 }
 
 void Context::discoverModules() { impl->modules->discover(); }
-SymbolMap& Context::symbols() { return *impl->symbols; }
+SymbolMap& Context::symbols() { return impl->getSymbols(); }
 
 } // namespace element
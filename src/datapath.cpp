@@ -5,6 +5,7 @@
 
 #include "appinfo.hpp"
 #include "datapath.hpp"
+#include "session/presetindex.hpp"
 
 #ifndef EL_INSTALL_DIR_AWARE
 #define EL_INSTALL_DIR_AWARE 1
@@ -82,10 +83,21 @@ const File DataPath::defaultGlobalMidiProgramsDir()
     return applicationDataDir().getChildFile ("cache/midi/programs");
 }
 
+const File DataPath::defaultScriptCacheDir()
+{
+    return applicationDataDir().getChildFile ("cache/lua");
+}
+
+const File DataPath::defaultFreezeCacheDir()
+{
+    return applicationDataDir().getChildFile ("cache/freeze");
+}
+
 const File DataPath::defaultScriptsDir() { return defaultUserDataPath().getChildFile ("Scripts"); }
 const File DataPath::defaultSessionDir() { return defaultUserDataPath().getChildFile ("Sessions"); }
 const File DataPath::defaultGraphDir() { return defaultUserDataPath().getChildFile ("Graphs"); }
 const File DataPath::defaultControllersDir() { return defaultUserDataPath().getChildFile ("Controllers"); }
+const File DataPath::defaultRecordingsDir() { return defaultUserDataPath().getChildFile ("Recordings"); }
 
 juce::File DataPath::getPresetFile (const juce::String& name) const
 {
@@ -109,9 +121,17 @@ void DataPath::findPresetsFor (const String& format, const String& identifier, N
     if (! presetsDir.exists() || ! presetsDir.isDirectory())
         return;
 
-    for (DirectoryEntry entry : RangedDirectoryIterator (presetsDir, true, EL_PRESET_FILE_EXTENSIONS))
+    // only the presets indexed for the plugin are parsed.
+    PresetIndex index (applicationDataDir().getChildFile ("PresetIndex.dat"));
+    index.load();
+    if (index.update (presetsDir))
+        index.save();
+
+    Array<PresetIndex::Entry> entries;
+    index.getPresetsFor (format, identifier, entries);
+    for (const auto& entry : entries)
     {
-        Node node (Node::parse (entry.getFile()));
+        Node node (Node::parse (entry.file));
         if (node.isValid() && node.getFileOrIdentifier() == identifier && node.getFormat() == format)
         {
             nodes.add (node);
@@ -70,6 +70,12 @@ public:
         return (t1 - t0);
     }
 
+    /** Return the filtered time of the last update */
+    inline double currentTime() const { return t0; }
+
+    /** Return the predicted time of the next update */
+    inline double nextTime() const { return t1; }
+
 private:
     double samplerate, periodSize;
     double e2, t0, t1;
@@ -196,6 +196,185 @@ static int audio_fade (lua_State* L)
     return 0;
 }
 
+//==============================================================================
+// Block kernels. Channels and frames are 1-indexed like the rest of the
+// class, counts are clipped to the buffers so a bad range can't write past
+// the end.
+
+static int audio_clip (const Buffer& buf, int start, int count) noexcept
+{
+    return juce::jlimit (0, juce::jmax (0, buf.getNumSamples() - start), count);
+}
+
+static const Buffer* audio_source (lua_State* L, int n)
+{
+    return *(Buffer**) luaL_checkudata (L, n, EL_MT_AUDIO_BUFFER_IMPL);
+}
+
+// dst:copy (dstchan, dststart, src, srcchan, srcstart, count [, gain])
+static int audio_copy (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const auto* src = audio_source (L, 4);
+    const int dstStart = (int) lua_tointeger (L, 3) - 1;
+    const int srcStart = (int) lua_tointeger (L, 6) - 1;
+    const int count = audio_clip (*src, srcStart, audio_clip (*buf, dstStart, (int) lua_tointeger (L, 7)));
+    if (count <= 0)
+        return 0;
+
+    auto* d = buf->getWritePointer ((int) lua_tointeger (L, 2) - 1, dstStart);
+    const auto* s = src->getReadPointer ((int) lua_tointeger (L, 5) - 1, srcStart);
+    if (lua_gettop (L) >= 8)
+        juce::FloatVectorOperations::copyWithMultiply (d, s, static_cast<SampleType> (lua_tonumber (L, 8)), count);
+    else
+        juce::FloatVectorOperations::copy (d, s, count);
+    return 0;
+}
+
+// dst:add (dstchan, dststart, src, srcchan, srcstart, count [, gain])
+static int audio_add (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const auto* src = audio_source (L, 4);
+    const int dstStart = (int) lua_tointeger (L, 3) - 1;
+    const int srcStart = (int) lua_tointeger (L, 6) - 1;
+    const int count = audio_clip (*src, srcStart, audio_clip (*buf, dstStart, (int) lua_tointeger (L, 7)));
+    if (count <= 0)
+        return 0;
+
+    auto* d = buf->getWritePointer ((int) lua_tointeger (L, 2) - 1, dstStart);
+    const auto* s = src->getReadPointer ((int) lua_tointeger (L, 5) - 1, srcStart);
+    if (lua_gettop (L) >= 8)
+        juce::FloatVectorOperations::addWithMultiply (d, s, static_cast<SampleType> (lua_tonumber (L, 8)), count);
+    else
+        juce::FloatVectorOperations::add (d, s, count);
+    return 0;
+}
+
+// dst:multiply (dstchan, dststart, src, srcchan, srcstart, count)
+static int audio_multiply (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const auto* src = audio_source (L, 4);
+    const int dstStart = (int) lua_tointeger (L, 3) - 1;
+    const int srcStart = (int) lua_tointeger (L, 6) - 1;
+    const int count = audio_clip (*src, srcStart, audio_clip (*buf, dstStart, (int) lua_tointeger (L, 7)));
+    if (count <= 0)
+        return 0;
+
+    juce::FloatVectorOperations::multiply (buf->getWritePointer ((int) lua_tointeger (L, 2) - 1, dstStart),
+                                           src->getReadPointer ((int) lua_tointeger (L, 5) - 1, srcStart),
+                                           count);
+    return 0;
+}
+
+// buf:fill (channel, start, count, value)
+static int audio_fill (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int start = (int) lua_tointeger (L, 3) - 1;
+    const int count = audio_clip (*buf, start, (int) lua_tointeger (L, 4));
+    if (count > 0)
+        juce::FloatVectorOperations::fill (buf->getWritePointer ((int) lua_tointeger (L, 2) - 1, start),
+                                           static_cast<SampleType> (lua_tonumber (L, 5)),
+                                           count);
+    return 0;
+}
+
+// buf:ramp (channel, start, count, startvalue, endvalue)
+static int audio_ramp (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int start = (int) lua_tointeger (L, 3) - 1;
+    const int count = audio_clip (*buf, start, (int) lua_tointeger (L, 4));
+    if (count <= 0)
+        return 0;
+
+    auto* d = buf->getWritePointer ((int) lua_tointeger (L, 2) - 1, start);
+    const auto v1 = static_cast<SampleType> (lua_tonumber (L, 5));
+    const auto v2 = static_cast<SampleType> (lua_tonumber (L, 6));
+    const auto step = count > 1 ? (v2 - v1) / static_cast<SampleType> (count - 1) : SampleType();
+    // each sample only depends on its index so this vectorizes.
+    for (int i = 0; i < count; ++i)
+        d[i] = v1 + step * static_cast<SampleType> (i);
+    return 0;
+}
+
+// buf:magnitude (channel, start, count)
+static int audio_magnitude (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int start = (int) lua_tointeger (L, 3) - 1;
+    const int count = audio_clip (*buf, start, (int) lua_tointeger (L, 4));
+    lua_pushnumber (L, count > 0 ? buf->getMagnitude ((int) lua_tointeger (L, 2) - 1, start, count) : 0);
+    return 1;
+}
+
+// buf:rms (channel, start, count)
+static int audio_rms (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int start = (int) lua_tointeger (L, 3) - 1;
+    const int count = audio_clip (*buf, start, (int) lua_tointeger (L, 4));
+    lua_pushnumber (L, count > 0 ? buf->getRMSLevel ((int) lua_tointeger (L, 2) - 1, start, count) : 0);
+    return 1;
+}
+
+// lo, hi = buf:range (channel, start, count)
+static int audio_range (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int start = (int) lua_tointeger (L, 3) - 1;
+    const int count = audio_clip (*buf, start, (int) lua_tointeger (L, 4));
+    const auto range = count > 0 ? buf->findMinMax ((int) lua_tointeger (L, 2) - 1, start, count)
+                                 : juce::Range<SampleType>();
+    lua_pushnumber (L, range.getStart());
+    lua_pushnumber (L, range.getEnd());
+    return 2;
+}
+
+// buf:biquad (channel, start, count, coeffs, state)
+// coeffs is { b0, b1, b2, a1, a2 } normalized to a0, state is { z1, z2 } and
+// is updated in place so it carries over between blocks.
+static int audio_biquad (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int start = (int) lua_tointeger (L, 3) - 1;
+    const int count = audio_clip (*buf, start, (int) lua_tointeger (L, 4));
+    if (count <= 0 || ! lua_istable (L, 5) || ! lua_istable (L, 6))
+        return 0;
+
+    double c[5];
+    for (int i = 0; i < 5; ++i)
+    {
+        lua_rawgeti (L, 5, i + 1);
+        c[i] = lua_tonumber (L, -1);
+        lua_pop (L, 1);
+    }
+
+    lua_rawgeti (L, 6, 1);
+    lua_rawgeti (L, 6, 2);
+    double z1 = lua_tonumber (L, -2), z2 = lua_tonumber (L, -1);
+    lua_pop (L, 2);
+
+    // transposed direct form II, state kept in double.
+    auto* d = buf->getWritePointer ((int) lua_tointeger (L, 2) - 1, start);
+    for (int i = 0; i < count; ++i)
+    {
+        const double in = d[i];
+        const double out = c[0] * in + z1;
+        z1 = c[1] * in - c[3] * out + z2;
+        z2 = c[2] * in - c[4] * out;
+        d[i] = static_cast<SampleType> (out);
+    }
+
+    lua_pushnumber (L, z1);
+    lua_rawseti (L, 6, 1);
+    lua_pushnumber (L, z2);
+    lua_rawseti (L, 6, 2);
+    return 0;
+}
+
 static int audio_free (lua_State* L)
 {
     auto** buf = (Buffer**) lua_touserdata (L, 1);
@@ -358,6 +537,88 @@ static const luaL_Reg buffer_methods[] = {
     // @number gain2 End gain
     // @function AudioBuffer:fade
     { "fade", audio_fade },
+
+    /// Copy samples from another buffer of the same type.
+    // @int channel Destination channel
+    // @int start Destination sample index
+    // @param source Buffer to copy from, may be this one
+    // @int sourcechannel Source channel
+    // @int sourcestart Source sample index
+    // @int count Number of samples to copy
+    // @number[opt] gain Gain to apply while copying
+    // @function AudioBuffer:copy
+    { "copy", audio_copy },
+
+    /// Add samples from another buffer of the same type.
+    // @int channel Destination channel
+    // @int start Destination sample index
+    // @param source Buffer to add from
+    // @int sourcechannel Source channel
+    // @int sourcestart Source sample index
+    // @int count Number of samples to add
+    // @number[opt] gain Gain to apply to the source
+    // @function AudioBuffer:add
+    { "add", audio_add },
+
+    /// Multiply samples by those in another buffer, e.g. ring modulation.
+    // @int channel Destination channel
+    // @int start Destination sample index
+    // @param source Buffer to multiply by
+    // @int sourcechannel Source channel
+    // @int sourcestart Source sample index
+    // @int count Number of samples
+    // @function AudioBuffer:multiply
+    { "multiply", audio_multiply },
+
+    /// Set a range of samples to a value.
+    // @int channel Channel to fill
+    // @int start Sample index to start at
+    // @int count Number of samples
+    // @number value Value to set
+    // @function AudioBuffer:fill
+    { "fill", audio_fill },
+
+    /// Write a linear ramp over a range of samples.
+    // @int channel Channel to write
+    // @int start Sample index to start at
+    // @int count Number of samples
+    // @number value1 First value
+    // @number value2 Last value
+    // @function AudioBuffer:ramp
+    { "ramp", audio_ramp },
+
+    /// Peak absolute value in a range.
+    // @int channel Channel to measure
+    // @int start Sample index to start at
+    // @int count Number of samples
+    // @function AudioBuffer:magnitude
+    // @return the peak
+    { "magnitude", audio_magnitude },
+
+    /// RMS level of a range.
+    // @int channel Channel to measure
+    // @int start Sample index to start at
+    // @int count Number of samples
+    // @function AudioBuffer:rms
+    // @return the level
+    { "rms", audio_rms },
+
+    /// Lowest and highest values in a range.
+    // @int channel Channel to measure
+    // @int start Sample index to start at
+    // @int count Number of samples
+    // @function AudioBuffer:range
+    // @return min and max
+    { "range", audio_range },
+
+    /// Run a biquad filter over a range in place.
+    // @int channel Channel to filter
+    // @int start Sample index to start at
+    // @int count Number of samples
+    // @tab coeffs `{ b0, b1, b2, a1, a2 }` normalized to a0
+    // @tab state `{ z1, z2 }`, updated so it carries over between calls
+    // @function AudioBuffer:biquad
+    { "biquad", audio_biquad },
     { NULL, NULL }
 };
 
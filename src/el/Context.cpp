@@ -7,6 +7,7 @@
 // @pragma nostrip
 
 #include <element/ui/commands.hpp>
+#include <element/audioengine.hpp>
 #include <element/context.hpp>
 #include <element/devices.hpp>
 #include <element/plugins.hpp>
@@ -55,7 +56,39 @@ EL_PLUGIN_EXPORT int luaopen_el_Context (lua_State* L)
         "midi",     &Context::midi,
         "plugins",  &Context::plugins,
         "presets",  &Context::presets,
-        "settings", &Context::settings);
+        "settings", &Context::settings,
+
+        /// Returns audio callback timing.
+        // Fields are `callbacks`, `deadlinemisses`, `latecallbacks`, `xruns`,
+        // `load`, `peakload`, `period` and `jitter` (milliseconds),
+        // `histogram`, callback counts in 10% steps of the block, and
+        // `signalfaults`, node output blocks with NaN or infinite samples.
+        // @function Context:telemetry
+        // @treturn table
+        // @within Instance Methods
+        "telemetry", [](Context& self, sol::this_state L) -> sol::table {
+            sol::state_view lua (L);
+            auto tbl = lua.create_table();
+            auto engine = self.audio();
+            if (engine == nullptr)
+                return tbl;
+
+            const auto t = engine->getTelemetry();
+            tbl["callbacks"]      = t.numCallbacks;
+            tbl["deadlinemisses"] = t.deadlineMisses;
+            tbl["latecallbacks"]  = t.lateCallbacks;
+            tbl["xruns"]          = t.xruns;
+            tbl["load"]           = t.load;
+            tbl["peakload"]       = t.peakLoad;
+            tbl["period"]         = t.periodMs;
+            tbl["jitter"]         = t.jitterMs;
+            tbl["signalfaults"]   = t.signalFaults;
+            auto bins = lua.create_table();
+            for (int i = 0; i < element::AudioEngine::Telemetry::numBins; ++i)
+                bins[i + 1] = t.histogram[i];
+            tbl["histogram"] = bins;
+            return tbl;
+        });
 
     lua.script (R"(
         require ('el.Node')
@@ -130,6 +130,66 @@ static int midibuffer_messages (lua_State* L)
     return 1;
 }
 
+//==============================================================================
+static int midibuffer_raw_next (lua_State* L)
+{
+    auto* impl = *(Impl**) lua_touserdata (L, 1);
+    if (impl->iter == impl->buffer.end())
+    {
+        impl->current = nullptr;
+        impl->currentSize = 0;
+        lua_pushnil (L);
+        return 1;
+    }
+
+    const auto& ref = (*(*impl).iter);
+    // events are stored in the buffer's own heap block, so they can be
+    // patched in place as long as nothing is inserted while iterating.
+    impl->current = const_cast<juce::uint8*> (ref.data);
+    impl->currentSize = ref.numBytes;
+
+    lua_pushinteger (L, ref.samplePosition + 1);
+    lua_pushinteger (L, ref.numBytes);
+    for (int i = 0; i < 3; ++i)
+        lua_pushinteger (L, i < ref.numBytes ? ref.data[i] : 0);
+    ++impl->iter;
+
+    return 5;
+}
+
+static int midibuffer_raw (lua_State* L)
+{
+    auto* impl = *(Impl**) lua_touserdata (L, 1);
+    impl->resetIterator();
+    lua_pushcfunction (L, midibuffer_raw_next);
+    lua_pushvalue (L, 1);
+    return 2;
+}
+
+static int midibuffer_rewrite (lua_State* L)
+{
+    auto* impl = *(Impl**) lua_touserdata (L, 1);
+    if (impl->current == nullptr)
+        return 0;
+
+    const int n = juce::jmin (impl->currentSize, lua_gettop (L) - 1);
+    for (int i = 0; i < n; ++i)
+        impl->current[i] = static_cast<juce::uint8> (lua_tointeger (L, i + 2));
+    return 0;
+}
+
+static int midibuffer_write (lua_State* L)
+{
+    auto* impl = *(Impl**) lua_touserdata (L, 1);
+    juce::uint8 data[3] = { 0, 0, 0 };
+    const int n = juce::jlimit (0, 3, lua_gettop (L) - 2);
+    for (int i = 0; i < n; ++i)
+        data[i] = static_cast<juce::uint8> (lua_tointeger (L, i + 3));
+    if (n > 0)
+        impl->buffer.addEvent (data, n, static_cast<int> (lua_tointeger (L, 2)) - 1);
+    return 0;
+}
+
 //==============================================================================
 static int midibuffer_insertMessage (lua_State* L)
 {
@@ -317,6 +377,15 @@ static const luaL_Reg buffer_methods[] = {
     // @int frame Sample position to insert at
     { "insertPacked", midibuffer_insertPacked },
 
+    /// Add a short message from its bytes.
+    // Doesn't allocate as long as the buffer has room, see MidiBuffer:reserve.
+    // @function MidiBuffer:write
+    // @int frame Sample position to insert at
+    // @int status Status byte
+    // @int[opt] data1 First data byte
+    // @int[opt] data2 Second data byte
+    { "write", midibuffer_write },
+
     // Insert some bytes into the buffer.
     // The el.Bytes passed in should contain a complete MIDI message
     // of any type.
@@ -339,6 +408,35 @@ static const luaL_Reg buffer_methods[] = {
     // end
     { "events", midibuffer_events },
 
+    /// Iterate over raw MIDI bytes.
+    // Doesn't allocate, so it's the one to use on the audio thread. Bytes
+    // past the size of an event are zero, and only the first three bytes of
+    // longer events are returned.
+    // @function MidiBuffer:raw
+    // @return Event byte iterator
+    // @usage
+    // -- @frame   Sample position in buffer
+    // -- @size    Size in bytes
+    // -- @b1..b3  The first three bytes
+    // for frame, size, b1, b2, b3 in buffer:raw() do
+    //     -- do something with midi data
+    // end
+    { "raw", midibuffer_raw },
+
+    /// Overwrite the event last returned by MidiBuffer:raw.
+    // Bytes past the size of the event are ignored. Don't insert into the
+    // buffer while iterating.
+    // @function MidiBuffer:rewrite
+    // @int status Status byte
+    // @int[opt] data1 First data byte
+    // @int[opt] data2 Second data byte
+    // @usage
+    // -- transpose notes up an octave
+    // for frame, size, status, note in buffer:raw() do
+    //     if status & 0xe0 == 0x80 then buffer:rewrite (status, math.min (note + 12, 127)) end
+    // end
+    { "rewrite", midibuffer_rewrite },
+
     // Add a raw MIDI Event.
     // @function MidiBuffer:insertEvent
     // @param data Raw event data to add
@@ -0,0 +1,156 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+/// Engine performance counters.
+// Read only snapshots of how the engine is doing, for monitoring scripts.
+// Every function returns a new table, so poll as often as needed.
+// @module el.Stats
+// @pragma nostrip
+
+#include <element/element.h>
+#include <element/audioengine.hpp>
+#include <element/context.hpp>
+#include <element/node.hpp>
+
+#include "sol_helpers.hpp"
+#include "engine/graphnode.hpp"
+#include "engine/midiengine.hpp"
+
+// clang-format off
+
+namespace {
+element::GraphNode* graphObject (const element::Node& node)
+{
+    return dynamic_cast<element::GraphNode*> (node.getObject());
+}
+} // namespace
+
+EL_PLUGIN_EXPORT int luaopen_el_Stats (lua_State* L)
+{
+    using namespace element;
+    sol::state_view lua (L);
+    auto M = lua.create_table();
+
+    /// Returns audio callback and MIDI queue counters.
+    // Fields are `callbacks`, `deadlinemisses`, `latecallbacks`, `xruns`,
+    // `load`, `peakload` and `signalfaults` as in @{el.Context:telemetry},
+    // plus `midiin`, messages waiting for the audio thread, and `midiout`,
+    // messages waiting to be sent. Returns nil without a running context.
+    // @function engine
+    // @treturn table
+    M.set_function ("engine", [](sol::this_state L) -> sol::object {
+        sol::state_view lua (L);
+        auto ctx = lua.globals().get<sol::optional<Context&>> ("el.context");
+        if (! ctx)
+            return sol::lua_nil;
+        auto engine = ctx->audio();
+        if (engine == nullptr)
+            return sol::lua_nil;
+
+        const auto t = engine->getTelemetry();
+        auto tbl = lua.create_table();
+        tbl["callbacks"]      = t.numCallbacks;
+        tbl["deadlinemisses"] = t.deadlineMisses;
+        tbl["latecallbacks"]  = t.lateCallbacks;
+        tbl["xruns"]          = t.xruns;
+        tbl["load"]           = t.load;
+        tbl["peakload"]       = t.peakLoad;
+        tbl["signalfaults"]   = t.signalFaults;
+        tbl["midiin"]         = engine->getNumMidiInputsPending();
+        tbl["midiout"]        = ctx->midi().getNumOutputsPending();
+        return tbl;
+    });
+
+    /// Returns the size of a graph's rendering sequence.
+    // Fields are `nodes`, `ops`, rendering ops in the active sequence,
+    // `blocksize`, the largest block rendered at once, and `memory`,
+    // `audiomemory`, `midimemory` and `atommemory` in bytes of scratch
+    // buffers, and `opmemory`, bytes of delay lines. `total` adds the
+    // memory of every node. Returns nil if the graph isn't running.
+    // @function graph
+    // @tparam el.Node graph
+    // @treturn table
+    M.set_function ("graph", [](const Node& node, sol::this_state L) -> sol::object {
+        auto* graph = graphObject (node);
+        if (graph == nullptr)
+            return sol::lua_nil;
+
+        sol::state_view lua (L);
+        const auto info = graph->getScratchInfo();
+        auto tbl = lua.create_table();
+        tbl["nodes"]       = graph->getNumNodes();
+        tbl["ops"]         = graph->getNumRenderOps();
+        tbl["blocksize"]   = info.maxBlockSize;
+        tbl["memory"]      = info.getTotalBytes();
+        tbl["audiomemory"] = info.audioBytes;
+        tbl["midimemory"]  = info.midiBytes;
+        tbl["atommemory"]  = info.atomBytes;
+        tbl["opmemory"]    = info.opBytes;
+        tbl["total"]       = graph->getMemoryUsage();
+        return tbl;
+    });
+
+    /// Returns processing time of each node in a graph.
+    // One table per node with `id`, `name`, `memory`, bytes the node holds
+    // not counting memory inside plugins, `profiling`, `faults`, blocks the
+    // node output NaN or infinite samples in while node outputs are
+    // guarded, and `faultbypassed`, true if the guard bypassed it. Nodes being
+    // profiled also have `blocks`, `average`, `p50`, `p95`, `p99` and
+    // `max` in microseconds per block, and `load`, the share of a block.
+    // Returns nil if the graph isn't running.
+    // @function nodes
+    // @tparam el.Node graph
+    // @treturn table
+    // @see profile
+    M.set_function ("nodes", [](const Node& node, sol::this_state L) -> sol::object {
+        auto* graph = graphObject (node);
+        if (graph == nullptr)
+            return sol::lua_nil;
+
+        sol::state_view lua (L);
+        auto nodes = lua.create_table();
+        for (int i = 0; i < graph->getNumNodes(); ++i)
+        {
+            auto* proc = graph->getNode (i);
+            auto tbl = lua.create_table();
+            tbl["id"]        = proc->nodeId;
+            tbl["name"]      = proc->getName().toStdString();
+            tbl["memory"]    = proc->getMemoryUsage();
+            tbl["profiling"] = proc->isProfilingEnabled();
+            tbl["faults"]    = proc->getNumSignalFaults();
+            tbl["faultbypassed"] = proc->isFaultBypassed();
+            if (proc->isProfilingEnabled())
+            {
+                const auto s = proc->getProcessStats();
+                tbl["blocks"]  = s.numBlocks;
+                tbl["average"] = s.average;
+                tbl["p50"]     = s.p50;
+                tbl["p95"]     = s.p95;
+                tbl["p99"]     = s.p99;
+                tbl["max"]     = s.maximum;
+                tbl["load"]    = s.load;
+            }
+            nodes[i + 1] = tbl;
+        }
+        return nodes;
+    });
+
+    /// Turns timing of a graph's nodes on or off.
+    // Timing costs a little per block, so leave it off when not watching.
+    // @function profile
+    // @tparam el.Node graph
+    // @bool enabled
+    // @treturn bool True if the graph is running.
+    M.set_function ("profile", [](const Node& node, bool enabled) -> bool {
+        auto* graph = graphObject (node);
+        if (graph == nullptr)
+            return false;
+        for (int i = 0; i < graph->getNumNodes(); ++i)
+            graph->getNode (i)->setProfilingEnabled (enabled);
+        return true;
+    });
+
+    sol::stack::push (L, M);
+    return 1;
+}
+// clang-format on
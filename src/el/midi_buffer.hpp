@@ -19,6 +19,9 @@ struct MidiBufferImpl final
     /** Cached message used by iterator */
     juce::MidiMessage** message { nullptr };
     int msgref { LUA_REFNIL };
+    /** Data of the event last returned by the raw iterator */
+    juce::uint8* current { nullptr };
+    int currentSize { 0 };
 
     MidiBufferImpl (lua_State* L)
     {
@@ -49,6 +52,8 @@ struct MidiBufferImpl final
     {
         iter = buffer.begin();
         **message = juce::MidiMessage();
+        current = nullptr;
+        currentSize = 0;
     }
 };
 
@@ -126,6 +126,46 @@ inline static sol::table new_nodetype (lua_State* L, const char* name, Args&&...
 
         "resetPorts",   &Node::resetPorts,
 
+        /// Turn CPU profiling on or off.
+        // @function Node:setProfiling
+        // @tparam bool enabled True to time this node's processing.
+        "setProfiling", [] (Node& self, bool enabled) {
+            if (auto obj = self.getObject())
+                obj->setProfilingEnabled (enabled);
+        },
+
+        /// Returns true if this node is being profiled.
+        // @function Node:isProfiling
+        // @treturn bool
+        "isProfiling", [] (Node& self) -> bool {
+            auto obj = self.getObject();
+            return obj != nullptr && obj->isProfilingEnabled();
+        },
+
+        /// Returns processing time stats.
+        // Times are microseconds per block. `load` is the share of the
+        // block's duration spent in this node.
+        // @function Node:processStats
+        // @treturn table Fields blocks, min, max, average, p50, p95, p99
+        // and load, or nil if the node has no processor.
+        "processStats", [] (Node& self, sol::this_state L) -> sol::object {
+            auto obj = self.getObject();
+            if (obj == nullptr)
+                return sol::lua_nil;
+            const auto stats = obj->getProcessStats();
+            sol::state_view lua (L);
+            auto t = lua.create_table();
+            t["blocks"]  = static_cast<lua_Integer> (stats.numBlocks);
+            t["min"]     = stats.minimum;
+            t["max"]     = stats.maximum;
+            t["average"] = stats.average;
+            t["p50"]     = stats.p50;
+            t["p95"]     = stats.p95;
+            t["p99"]     = stats.p99;
+            t["load"]    = stats.load;
+            return t;
+        },
+
         std::forward<Args> (args)...
     );
     return removeAndClear (M, name);
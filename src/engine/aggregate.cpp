@@ -0,0 +1,407 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "engine/aggregate.hpp"
+#include "engine/driftfifo.hpp"
+
+namespace element {
+using namespace juce;
+
+namespace {
+BigInteger channelRange (const BigInteger& channels, int first, int num)
+{
+    BigInteger range;
+    for (int i = 0; i < num; ++i)
+        if (channels[first + i])
+            range.setBit (i);
+    return range;
+}
+} // namespace
+
+//==============================================================================
+class AggregateDevice final : public AudioIODevice
+{
+public:
+    AggregateDevice (OwnedArray<AudioIODevice>&& devices)
+        : AudioIODevice (AggregateDeviceType::typeName, AggregateDeviceType::typeName)
+    {
+        jassert (! devices.isEmpty());
+        while (! devices.isEmpty())
+            members.add (new Member (*this, devices.removeAndReturn (0), members.isEmpty()));
+    }
+
+    ~AggregateDevice() override
+    {
+        close();
+    }
+
+    StringArray getOutputChannelNames() override { return channelNames (false); }
+    StringArray getInputChannelNames() override { return channelNames (true); }
+
+    Array<double> getAvailableSampleRates() override
+    {
+        // the rates every member can run at.
+        auto rates = primary().getAvailableSampleRates();
+        for (auto* m : members)
+        {
+            const auto theirs = m->device->getAvailableSampleRates();
+            rates.removeIf ([&theirs] (double rate) { return ! theirs.contains (rate); });
+        }
+        return rates;
+    }
+
+    Array<int> getAvailableBufferSizes() override { return primary().getAvailableBufferSizes(); }
+    int getDefaultBufferSize() override { return primary().getDefaultBufferSize(); }
+
+    String open (const BigInteger& inputChannels, const BigInteger& outputChannels, double sampleRate, int bufferSizeSamples) override
+    {
+        close();
+
+        int numInputs = 0, numOutputs = 0;
+        for (auto* m : members)
+        {
+            m->firstInput = numInputs;
+            m->firstOutput = numOutputs;
+            m->numInputs = m->device->getInputChannelNames().size();
+            m->numOutputs = m->device->getOutputChannelNames().size();
+            numInputs += m->numInputs;
+            numOutputs += m->numOutputs;
+
+            lastError = m->device->open (channelRange (inputChannels, m->firstInput, m->numInputs),
+                                         channelRange (outputChannels, m->firstOutput, m->numOutputs),
+                                         sampleRate,
+                                         bufferSizeSamples);
+            if (lastError.isEmpty() && ! m->isPrimary
+                && std::abs (m->device->getCurrentSampleRate() - primary().getCurrentSampleRate()) > 1.0)
+            {
+                lastError << "runs at " << m->device->getCurrentSampleRate() << " Hz, not "
+                          << primary().getCurrentSampleRate() << " Hz";
+            }
+
+            if (lastError.isNotEmpty())
+            {
+                lastError = m->device->getName() + ": " + lastError;
+                closeMembers();
+                return lastError;
+            }
+        }
+
+        const double rate = primary().getCurrentSampleRate();
+        blockSize = primary().getCurrentBufferSizeSamples();
+        int numActiveInputs = primary().getActiveInputChannels().countNumberOfSetBits();
+        int numActiveOutputs = primary().getActiveOutputChannels().countNumberOfSetBits();
+        for (auto* m : members)
+        {
+            if (m->isPrimary)
+                continue;
+
+            const int ins = m->device->getActiveInputChannels().countNumberOfSetBits();
+            const int outs = m->device->getActiveOutputChannels().countNumberOfSetBits();
+            const int maxBlock = jmax (blockSize, m->device->getCurrentBufferSizeSamples());
+            const double memberRate = m->device->getCurrentSampleRate();
+            m->inputs.prepare (ins, maxBlock, memberRate, rate);
+            m->outputs.prepare (outs, maxBlock, rate, memberRate);
+            m->inputBlock.setSize (jmax (1, ins), blockSize, false, true, false);
+            m->outputBlock.setSize (jmax (1, outs), blockSize, false, true, false);
+            numActiveInputs += ins;
+            numActiveOutputs += outs;
+        }
+
+        inputs.calloc ((size_t) numActiveInputs + 1);
+        outputs.calloc ((size_t) numActiveOutputs + 1);
+        deviceIsOpen = true;
+        return {};
+    }
+
+    void close() override
+    {
+        stop();
+        closeMembers();
+    }
+
+    bool isOpen() override { return deviceIsOpen; }
+
+    void start (AudioIODeviceCallback* newCallback) override
+    {
+        if (! deviceIsOpen || newCallback == callback)
+            return;
+
+        if (newCallback != nullptr)
+        {
+            newCallback->audioDeviceAboutToStart (this);
+            if (! running)
+                startMembers();
+        }
+
+        AudioIODeviceCallback* const oldCallback = callback;
+        {
+            const ScopedLock sl (callbackLock);
+            callback = newCallback;
+        }
+
+        if (newCallback == nullptr && running)
+            stopMembers();
+
+        if (oldCallback != nullptr)
+            oldCallback->audioDeviceStopped();
+    }
+
+    void stop() override { start (nullptr); }
+
+    bool isPlaying() override { return callback != nullptr; }
+    String getLastError() override { return lastError; }
+
+    int getCurrentBufferSizeSamples() override { return primary().getCurrentBufferSizeSamples(); }
+    double getCurrentSampleRate() override { return primary().getCurrentSampleRate(); }
+    int getCurrentBitDepth() override { return primary().getCurrentBitDepth(); }
+
+    BigInteger getActiveOutputChannels() const override
+    {
+        BigInteger active;
+        for (auto* m : members)
+        {
+            const auto theirs = m->device->getActiveOutputChannels();
+            for (int i = 0; i < m->numOutputs; ++i)
+                if (theirs[i])
+                    active.setBit (m->firstOutput + i);
+        }
+        return active;
+    }
+
+    BigInteger getActiveInputChannels() const override
+    {
+        BigInteger active;
+        for (auto* m : members)
+        {
+            const auto theirs = m->device->getActiveInputChannels();
+            for (int i = 0; i < m->numInputs; ++i)
+                if (theirs[i])
+                    active.setBit (m->firstInput + i);
+        }
+        return active;
+    }
+
+    // the FIFOs hold about their target, which delays the other members.
+    int getOutputLatencyInSamples() override
+    {
+        int latency = 0;
+        for (auto* m : members)
+            latency = jmax (latency, m->device->getOutputLatencyInSamples() + (m->isPrimary ? 0 : m->outputs.getTarget()));
+        return latency;
+    }
+
+    int getInputLatencyInSamples() override
+    {
+        int latency = 0;
+        for (auto* m : members)
+            latency = jmax (latency, m->device->getInputLatencyInSamples() + (m->isPrimary ? 0 : m->inputs.getTarget()));
+        return latency;
+    }
+
+    int getXRunCount() const noexcept override
+    {
+        int count = 0;
+        for (auto* m : members)
+        {
+            count += jmax (0, m->device->getXRunCount());
+            if (! m->isPrimary)
+                count += m->inputs.getNumUnderruns() + m->inputs.getNumOverruns()
+                         + m->outputs.getNumUnderruns() + m->outputs.getNumOverruns();
+        }
+        return count;
+    }
+
+private:
+    struct Member final : public AudioIODeviceCallback
+    {
+        Member (AggregateDevice& o, AudioIODevice* d, bool isFirst)
+            : owner (o), device (d), isPrimary (isFirst) {}
+
+        void audioDeviceIOCallbackWithContext (const float* const* in, int numIn, float* const* out, int numOut, int numSamples, const AudioIODeviceCallbackContext& context) override
+        {
+            if (isPrimary)
+                owner.process (in, numIn, out, numOut, numSamples, context);
+            else
+                owner.exchange (*this, in, numIn, out, numOut, numSamples);
+        }
+
+        void audioDeviceAboutToStart (AudioIODevice*) override {}
+        void audioDeviceStopped() override {}
+        void audioDeviceError (const String& message) override { owner.memberError (*this, message); }
+
+        AggregateDevice& owner;
+        std::unique_ptr<AudioIODevice> device;
+        const bool isPrimary;
+        int firstInput = 0, numInputs = 0;
+        int firstOutput = 0, numOutputs = 0;
+
+        // secondaries only: what they recorded on their way to the clock,
+        // and what the engine played on its way back.
+        DriftFifo inputs, outputs;
+        AudioBuffer<float> inputBlock, outputBlock;
+    };
+
+    OwnedArray<Member> members;
+    CriticalSection callbackLock;
+    AudioIODeviceCallback* callback = nullptr;
+    HeapBlock<const float*> inputs;
+    HeapBlock<float*> outputs;
+    int blockSize = 0;
+    bool deviceIsOpen = false, running = false;
+    String lastError;
+
+    AudioIODevice& primary() const noexcept { return *members.getFirst()->device; }
+
+    StringArray channelNames (bool forInput) const
+    {
+        StringArray names;
+        for (auto* m : members)
+            for (const auto& name : forInput ? m->device->getInputChannelNames() : m->device->getOutputChannelNames())
+                names.add (m->device->getName() + ": " + name);
+        return names;
+    }
+
+    void startMembers()
+    {
+        // secondaries first, so their inputs are filling when the clock starts.
+        for (auto* m : members)
+        {
+            m->inputs.reset();
+            m->outputs.reset();
+        }
+        for (int i = members.size(); --i >= 0;)
+            members.getUnchecked (i)->device->start (members.getUnchecked (i));
+        running = true;
+    }
+
+    void stopMembers()
+    {
+        for (auto* m : members)
+            m->device->stop();
+        running = false;
+    }
+
+    void closeMembers()
+    {
+        for (auto* m : members)
+            m->device->close();
+        deviceIsOpen = false;
+    }
+
+    void memberError (Member& member, const String& message)
+    {
+        const ScopedLock sl (callbackLock);
+        if (callback != nullptr)
+            callback->audioDeviceError (member.device->getName() + ": " + message);
+    }
+
+    /** A secondary's callback: hand its inputs over and take its outputs. */
+    void exchange (Member& m, const float* const* in, int numIn, float* const* out, int numOut, int numSamples) noexcept
+    {
+        m.inputs.write (in, numIn, numSamples);
+        m.outputs.read (out, numOut, numSamples);
+    }
+
+    /** The clock's callback: runs the engine on every member's channels. */
+    void process (const float* const* in, int numIn, float* const* out, int numOut, int numSamples, const AudioIODeviceCallbackContext& context) noexcept
+    {
+        const ScopedLock sl (callbackLock);
+        if (callback == nullptr)
+        {
+            for (int ch = 0; ch < numOut; ++ch)
+                FloatVectorOperations::clear (out[ch], numSamples);
+            return;
+        }
+
+        // a block larger than the device said leaves the others silent.
+        const bool fits = numSamples <= blockSize;
+        int numInputs = 0, numOutputs = 0;
+        for (int ch = 0; ch < numIn; ++ch)
+            inputs[numInputs++] = in[ch];
+        for (int ch = 0; ch < numOut; ++ch)
+            outputs[numOutputs++] = out[ch];
+
+        for (auto* m : members)
+        {
+            if (m->isPrimary)
+                continue;
+
+            const int ins = m->inputs.getNumChannels(), outs = m->outputs.getNumChannels();
+            if (fits)
+                m->inputs.read (m->inputBlock.getArrayOfWritePointers(), ins, numSamples);
+            for (int ch = 0; ch < ins && fits; ++ch)
+                inputs[numInputs++] = m->inputBlock.getReadPointer (ch);
+            for (int ch = 0; ch < outs && fits; ++ch)
+                outputs[numOutputs++] = m->outputBlock.getWritePointer (ch);
+        }
+
+        callback->audioDeviceIOCallbackWithContext (inputs, numInputs, outputs, numOutputs, numSamples, context);
+
+        for (auto* m : members)
+            if (! m->isPrimary && fits)
+                m->outputs.write (m->outputBlock.getArrayOfReadPointers(), m->outputs.getNumChannels(), numSamples);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AggregateDevice)
+};
+
+//==============================================================================
+AggregateDeviceType::AggregateDeviceType (AudioIODeviceType* type)
+    : AudioIODeviceType (typeName),
+      memberType (type)
+{
+    jassert (memberType != nullptr);
+}
+
+AggregateDeviceType::~AggregateDeviceType() = default;
+
+void AggregateDeviceType::setMembers (const StringArray& names)
+{
+    if (names == members)
+        return;
+    members = names;
+    callDeviceChangeListeners();
+}
+
+void AggregateDeviceType::scanForDevices()
+{
+    memberType->scanForDevices();
+}
+
+StringArray AggregateDeviceType::getDeviceNames (bool) const
+{
+    return members.isEmpty() ? StringArray() : StringArray (typeName);
+}
+
+int AggregateDeviceType::getDefaultDeviceIndex (bool) const
+{
+    return 0;
+}
+
+int AggregateDeviceType::getIndexOfDevice (AudioIODevice* device, bool) const
+{
+    return dynamic_cast<AggregateDevice*> (device) != nullptr ? 0 : -1;
+}
+
+AudioIODevice* AggregateDeviceType::createDevice (const String& outputDeviceName, const String& inputDeviceName)
+{
+    if (members.isEmpty() || (outputDeviceName != typeName && inputDeviceName != typeName))
+        return nullptr;
+
+    // members that are unplugged are left out, the first one there is the clock.
+    const auto inputNames = memberType->getDeviceNames (true);
+    const auto outputNames = memberType->getDeviceNames (false);
+    OwnedArray<AudioIODevice> devices;
+    for (const auto& name : members)
+    {
+        const bool hasInputs = inputNames.contains (name), hasOutputs = outputNames.contains (name);
+        if (! hasInputs && ! hasOutputs)
+            continue;
+        if (auto* device = memberType->createDevice (hasOutputs ? name : String(), hasInputs ? name : String()))
+            devices.add (device);
+    }
+
+    return devices.isEmpty() ? nullptr : new AggregateDevice (std::move (devices));
+}
+
+} // namespace element
@@ -0,0 +1,54 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/audio_devices.hpp>
+
+namespace element {
+
+/** Combines several devices of one type into a single device.
+
+    The first member is the clock: its callback runs the engine. Every
+    other member runs on its own callback and trades blocks with it
+    through a DriftFifo each way, so interfaces on separate clocks can be
+    used together without the operating system aggregating them. Channels
+    are listed member by member, each prefixed with its device's name.
+
+    Members must run at the same nominal rate. MIDI isn't routed, it still
+    comes from the MIDI devices.
+ */
+class AggregateDeviceType final : public juce::AudioIODeviceType
+{
+public:
+    static constexpr const char* typeName = "Aggregate";
+
+    /** Aggregates devices of memberType, which it takes ownership of. */
+    explicit AggregateDeviceType (juce::AudioIODeviceType* memberType);
+    ~AggregateDeviceType() override;
+
+    /** Set the devices combined, by name, the clock first. The aggregate
+        is only listed when there are some.
+     */
+    void setMembers (const juce::StringArray& names);
+    const juce::StringArray& getMembers() const noexcept { return members; }
+
+    /** Returns the type members are opened with. */
+    juce::AudioIODeviceType& getMemberType() noexcept { return *memberType; }
+
+    void scanForDevices() override;
+    juce::StringArray getDeviceNames (bool wantInputNames = false) const override;
+    int getDefaultDeviceIndex (bool forInput) const override;
+    int getIndexOfDevice (juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override { return false; }
+    juce::AudioIODevice* createDevice (const juce::String& outputDeviceName,
+                                       const juce::String& inputDeviceName) override;
+
+private:
+    std::unique_ptr<juce::AudioIODeviceType> memberType;
+    juce::StringArray members;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AggregateDeviceType)
+};
+
+} // namespace element
@@ -6,19 +6,42 @@
 #include <element/context.hpp>
 #include <element/settings.hpp>
 
+#include "engine/devicemidi.hpp"
+#include "engine/deviceports.hpp"
+#include "engine/fixedmidi.hpp"
 #include "engine/internalformat.hpp"
+#include "engine/looper.hpp"
 #include "engine/midiclock.hpp"
 #include "engine/midichannelmap.hpp"
 #include "engine/midiengine.hpp"
+#include "engine/midiinputqueue.hpp"
 #include "engine/miditranspose.hpp"
 #include "engine/rootgraph.hpp"
 #include "engine/midipanic.hpp"
+#include "engine/realtimeguard.hpp"
+#include "engine/renderthreadpool.hpp"
+#include "engine/rendertrace.hpp"
+#include "engine/signalguard.hpp"
+#include "engine/telemetry.hpp"
+#include "engine/threadpolicy.hpp"
 #include "engine/trace.hpp"
+#include "session/sharedplugin.hpp"
 
 #include "tempo.hpp"
 
 namespace element {
 
+/** Coalesces rendering sequence changes from every graph, whichever
+    thread rebuilt them, into one latency update on the message thread.
+ */
+struct LatencyUpdate : public AsyncUpdater
+{
+    explicit LatencyUpdate (AudioEngine& e) : engine (e) {}
+    ~LatencyUpdate() override { cancelPendingUpdate(); }
+    void handleAsyncUpdate() override { engine.updateExternalLatencySamples(); }
+    AudioEngine& engine;
+};
+
 struct RootGraphRender : public AsyncUpdater
 {
     std::function<void()> onActiveGraphChanged;
@@ -26,6 +49,9 @@ struct RootGraphRender : public AsyncUpdater
     RootGraphRender()
     {
         graphs.ensureStorageAllocated (32);
+        cued.ensureStorageAllocated (32);
+        fading.ensureStorageAllocated (32);
+        slots.ensureStorageAllocated (32);
     }
 
     void handleAsyncUpdate() override
@@ -59,6 +85,7 @@ struct RootGraphRender : public AsyncUpdater
         numOutputChans = numOuts;
         audioTemp.setSize (jmax (numIns, numOuts), numSamples);
         audioOut.setSize (audioTemp.getNumChannels(), audioTemp.getNumSamples());
+        allocateSlots();
     }
 
     void releaseBuffers()
@@ -68,6 +95,11 @@ struct RootGraphRender : public AsyncUpdater
         midiTemp.clear();
         audioTemp.setSize (1, 1);
         audioOut.setSize (1, 1);
+        for (auto* slot : slots)
+        {
+            slot->audio.setSize (1, 1);
+            slot->midi.clear();
+        }
     }
 
     void dumpGraphs()
@@ -91,106 +123,119 @@ struct RootGraphRender : public AsyncUpdater
         {
             buffer.clear();
             midi.clear();
+            fading.clearQuick();
+            switched.store (false, std::memory_order_release);
             return;
         }
 
+        // after a switch to the cued session every graph heard is new, so
+        // they all fade in like a change of mode while the old ones fade out.
+        const bool switching = switched.load (std::memory_order_relaxed);
         const int numSamples = buffer.getNumSamples();
         const int numChans = buffer.getNumChannels();
-        const bool graphChanged = lastGraph != currentGraph;
+        const bool graphChanged = switching || lastGraph != currentGraph;
         const bool shouldProcess = true;
         const RootGraph::RenderMode mode = current->getRenderMode();
-        const bool modeChanged = graphChanged && mode != last->getRenderMode();
+        const bool modeChanged = switching || (graphChanged && mode != last->getRenderMode());
 
         if (shouldProcess)
         {
-            audioOut.setSize (numChans, numSamples, false, false, true);
-            audioTemp.setSize (numChans, numSamples, false, false, true);
-
-            // clear the mixing area
-            for (int i = numChans; --i >= 0;)
-                audioOut.clear (i, 0, numSamples);
+            const BlockState state { current, switching ? nullptr : last, graphChanged, modeChanged, numSamples, numChans };
             midiOut.clear();
 
-            for (auto* const graph : graphs)
+            // one graph heard and nothing fading: render in place in the
+            // device buffer, skipping the mixing area and both copies.
+            RootGraph* solo = nullptr;
+            if (! graphChanged)
             {
-                // copy inputs, clear outs if more than input count
-                for (int i = 0; i < numInputChans; ++i)
-                    audioTemp.copyFrom (i, 0, buffer, i, 0, numSamples);
-                for (int i = numInputChans; i < numChans; ++i)
-                    audioTemp.clear (i, 0, numSamples);
-
-                // avoids feedback loop when IO node ins are
-                // connected to IO node outs
-                midiTemp.clear (0, numSamples);
-
-                if ((last == graph && graphChanged && last->isSingle())
-                    || (graphChanged && current != nullptr && current->isSingle() && graph != current))
+                int numAudible = 0;
+                for (auto* const graph : graphs)
                 {
-                    // send kill messages to the last graph(s) when the graph changes
-                    // see http://nickfever.com/music/midi-cc-list
-                    for (int i = 0; i < 16; ++i)
+                    if (isAudible (state, graph) && getPortGroup (graph) == nullptr)
                     {
-                        // sustain pedal off
-                        midiTemp.addEvent (MidiMessage::controllerEvent (i + 1, 64, 0), 0);
-                        // Sostenuto off
-                        midiTemp.addEvent (MidiMessage::controllerEvent (i + 1, 66, 0), 0);
-                        // Hold off
-                        midiTemp.addEvent (MidiMessage::controllerEvent (i + 1, 69, 0), 0);
-
-                        midiTemp.addEvent (MidiMessage::allNotesOff (i + 1), 0);
+                        solo = graph;
+                        ++numAudible;
                     }
                 }
-                else if ((current == graph && graph->isSingle())
-                         || (current != nullptr && ! current->isSingle() && ! graph->isSingle()))
+
+                if (numAudible != 1)
+                    solo = nullptr;
+            }
+
+            const bool concurrent = solo == nullptr && pool != nullptr && pool->getNumWorkers() > 0
+                                    && graphs.size() > 1 && graphs.size() <= slots.size()
+                                    && ! current->isSingle();
+
+            if (solo == nullptr || numPortGroups > 0)
+                audioTemp.setSize (numChans, numSamples, false, false, true);
+
+            if (solo == nullptr)
+            {
+                audioOut.setSize (numChans, numSamples, false, false, true);
+
+                // clear the mixing area
+                for (int i = numChans; --i >= 0;)
+                    audioOut.clear (i, 0, numSamples);
+            }
+
+            if (solo != nullptr)
+            {
+                prepareGraphInput (state, solo, buffer, midi, buffer, midiTemp);
+                renderGraph (solo, buffer, midiTemp, numSamples);
+                midiOut.addEvents (midiTemp, 0, numSamples, 0);
+
+                for (auto* const graph : graphs)
                 {
-                    // current single graph or parallel graphs get MIDI always
-                    midiTemp.addEvents (midi, 0, numSamples, 0);
+                    if (getPortGroup (graph) == nullptr)
+                        continue;
+                    prepareGraphInput (state, graph, buffer, midi, audioTemp, midiTemp);
+                    renderGraph (graph, audioTemp, midiTemp, numSamples);
+                    mixGraphOutput (state, graph, audioTemp, midiTemp);
                 }
-
+            }
+            else if (concurrent)
+            {
+                // each graph gets its own scratch buffers so they can render
+                // at the same time. Mixing stays serial and in graph order.
+                for (int i = 0; i < graphs.size(); ++i)
                 {
-                    RenderContext rc (audioTemp, cvTemp, midiTemp, atomTemp, numSamples);
-                    const ScopedLock sl (graph->getPropertyLock());
-                    if (graph->isSuspended())
-                    {
-                        graph->renderBypassed (rc);
-                    }
-                    else
-                    {
-                        graph->render (rc);
-                    }
+                    auto* slot = slots.getUnchecked (i);
+                    auto* graph = graphs.getUnchecked (i);
+                    slot->audible = isAudible (state, graph) || getPortGroup (graph) != nullptr;
+                    if (! slot->audible)
+                        continue;
+                    slot->audio.setSize (numChans, numSamples, false, false, true);
+                    prepareGraphInput (state, graph, buffer, midi, slot->audio, slot->midi);
                 }
 
-                // clang-format off
-                if (graphChanged && ((current->isSingle() && graph == last) || 
-                                     (modeChanged && ! current->isSingle() && graph->isSingle() && graph == last)))
+                concurrentRender.reset (graphs.size(), numSamples);
+                pool->perform (concurrentRender);
 
+                for (int i = 0; i < graphs.size(); ++i)
                 {
-                    // DBG("  FADE OUT LAST GRAPH: " << graph->engineIndex);
-                    for (int i = 0; i < numOutputChans; ++i)
-                        audioOut.addFromWithRamp (i, 0, audioTemp.getReadPointer (i), numSamples, 1.f, 0.f);
+                    auto* slot = slots.getUnchecked (i);
+                    if (slot->audible)
+                        mixGraphOutput (state, graphs.getUnchecked (i), slot->audio, slot->midi);
                 }
-                else if ((graph == current && graph->isSingle()) || (! graph->isSingle() && (current != nullptr) && ! current->isSingle()))
+            }
+            else
+            {
+                for (auto* const graph : graphs)
                 {
-                    // if it's the current single graph or both are parallel...
-                    if (graphChanged && (graph->isSingle() || (modeChanged && ! graph->isSingle() && ! current->isSingle())))
-                    {
-                        // DBG("  FADE IN NEW GRAPH: " << graph->engineIndex);
-                        for (int i = 0; i < numOutputChans; ++i)
-                            audioOut.addFromWithRamp (i, 0, audioTemp.getReadPointer (i), numSamples, 0.f, 1.f);
-                    }
-                    else
-                    {
-                        for (int i = 0; i < numOutputChans; ++i)
-                            audioOut.addFrom (i, 0, audioTemp, i, 0, numSamples);
-                    }
-
-                    midiOut.addEvents (midiTemp, 0, numSamples, 0);
+                    if (! isAudible (state, graph) && getPortGroup (graph) == nullptr)
+                        continue;
+                    prepareGraphInput (state, graph, buffer, midi, audioTemp, midiTemp);
+                    renderGraph (graph, audioTemp, midiTemp, numSamples);
+                    mixGraphOutput (state, graph, audioTemp, midiTemp);
                 }
-                // clang-format on
             }
 
-            for (int i = 0; i < numChans; ++i)
-                buffer.copyFrom (i, 0, audioOut, i, 0, numSamples);
+            if (switching)
+                fadeOutSwitched (buffer, numSamples, numChans);
+
+            if (solo == nullptr)
+                for (int i = 0; i < numChans; ++i)
+                    buffer.copyFrom (i, 0, audioOut, i, 0, numSamples);
 
             // setup a program change if present
             for (auto m : midi)
@@ -222,6 +267,7 @@ struct RootGraphRender : public AsyncUpdater
     {
         graphs.add (graph);
         graph->engineIndex = graphs.size() - 1;
+        allocateSlots();
 
         if (graph->engineIndex == 0)
         {
@@ -232,9 +278,55 @@ struct RootGraphRender : public AsyncUpdater
         return true;
     }
 
+    /** not realtime safe! AudioEngine's callback should be locked when you call this */
+    void addCuedGraph (RootGraph* graph)
+    {
+        cued.add (graph);
+        graph->engineIndex = -1;
+        allocateSlots();
+    }
+
+    /** Render the cued graphs from the next block on, starting at index.
+        The graphs being heard are kept to fade out over that block, all
+        the replaced ones wait as outgoing until they're removed.
+        AudioEngine's callback should be locked when you call this.
+     */
+    void switchToCuedGraphs (const int index)
+    {
+        auto* const current = getCurrentGraph();
+        for (auto* const graph : graphs)
+        {
+            outgoing.add (graph);
+            if (current != nullptr && getPortGroup (graph) == nullptr
+                && (graph == current || (! graph->isSingle() && ! current->isSingle())))
+                fading.add (graph);
+            graph->engineIndex = -1;
+        }
+
+        graphs.swapWith (cued);
+        cued.clearQuick();
+        updateIndexes();
+        allocateSlots();
+
+        currentGraph = lastGraph = graphs.isEmpty() ? -1 : jlimit (0, graphs.size() - 1, index);
+        program.reset();
+        switched.store (true, std::memory_order_release);
+        triggerAsyncUpdate();
+    }
+
+    /** Returns true until the block that fades out the graphs switched from. */
+    bool isSwitching() const noexcept { return switched.load (std::memory_order_acquire); }
+
     /** not realtime safe! AudioEngine's callback should be locked when you call this */
     void removeGraph (RootGraph* graph)
     {
+        fading.removeFirstMatchingValue (graph);
+        if (cued.removeFirstMatchingValue (graph) >= 0 || outgoing.removeFirstMatchingValue (graph) >= 0)
+        {
+            graph->engineIndex = -1;
+            return;
+        }
+
         jassert (graphs.contains (graph));
         graphs.removeFirstMatchingValue (graph);
         graph->engineIndex = -1;
@@ -245,13 +337,26 @@ struct RootGraphRender : public AsyncUpdater
             lastGraph = graphs.size() - 1;
     }
 
+    /** Set the device port groups for this block, see DevicePortCallback. */
+    void setDevicePorts (const DevicePortGroup* groups, int numGroups) noexcept
+    {
+        portGroups = groups;
+        numPortGroups = groups != nullptr ? numGroups : 0;
+    }
+
+    /** Set the pool used to render parallel graphs concurrently. */
+    void setRenderThreadPool (RenderThreadPool* newPool) noexcept { pool = newPool; }
+
     int size() const { return graphs.size(); }
 
     RootGraph* getGraph (const int i) const { return graphs.getUnchecked (i); }
     const Array<RootGraph*>& getGraphs() const { return graphs; }
+    const Array<RootGraph*>& getCuedGraphs() const { return cued; }
 
 private:
     Array<RootGraph*> graphs;
+    Array<RootGraph*> cued, outgoing, fading;
+    std::atomic<bool> switched { false };
     int currentGraph = -1;
     int lastGraph = -1;
 
@@ -274,6 +379,258 @@ private:
     MidiBuffer midiOut, midiTemp;
     AtomBuffer atomTemp;
 
+    struct BlockState
+    {
+        RootGraph* current;
+        RootGraph* last;
+        bool graphChanged;
+        bool modeChanged;
+        int numSamples;
+        int numChans;
+    };
+
+    /** Scratch buffers for one graph when rendering concurrently. */
+    struct GraphBuffers
+    {
+        AudioSampleBuffer audio;
+        MidiBuffer midi;
+        bool audible = false;
+    };
+
+    struct ConcurrentRender : public RenderThreadPool::Job
+    {
+        ConcurrentRender (RootGraphRender& r) : owner (r) {}
+
+        void reset (int count, int frames) noexcept
+        {
+            numGraphs = count;
+            numSamples = frames;
+            next.store (0);
+            done.store (0);
+        }
+
+        bool runNextTask() noexcept override
+        {
+            const int index = next.fetch_add (1);
+            if (index >= numGraphs)
+                return false;
+            auto* slot = owner.slots.getUnchecked (index);
+            if (slot->audible)
+                owner.renderGraph (owner.graphs.getUnchecked (index), slot->audio, slot->midi, numSamples);
+            done.fetch_add (1, std::memory_order_release);
+            return true;
+        }
+
+        bool isFinished() const noexcept override
+        {
+            return done.load (std::memory_order_acquire) >= numGraphs;
+        }
+
+        RootGraphRender& owner;
+        int numGraphs = 0, numSamples = 0;
+        std::atomic<int> next { 0 }, done { 0 };
+    };
+
+    const DevicePortGroup* portGroups = nullptr;
+    int numPortGroups = 0;
+
+    RenderThreadPool* pool = nullptr;
+    OwnedArray<GraphBuffers> slots;
+    ConcurrentRender concurrentRender { *this };
+
+    void allocateSlots()
+    {
+        while (slots.size() < jmax (graphs.size(), cued.size()))
+            slots.add (new GraphBuffers());
+        for (auto* slot : slots)
+        {
+            slot->audio.setSize (audioTemp.getNumChannels(), audioTemp.getNumSamples());
+            slot->midi.ensureSize (2048);
+        }
+    }
+
+    /** Returns true if a graph's output is mixed this block. Only the
+        current graph, the outgoing one while it fades and parallel graphs
+        alongside a parallel current graph are heard. The rest aren't
+        rendered at all, so idle programs don't cost anything.
+     */
+    static bool isAudible (const BlockState& state, const RootGraph* graph) noexcept
+    {
+        if (graph == state.current)
+            return true;
+        if (graph == state.last && state.graphChanged)
+            return true;
+        return ! graph->isSingle() && ! state.current->isSingle();
+    }
+
+    /** Returns the device ports of a graph that has its own, or nullptr.
+        Those graphs are rendered every block no matter which graph is
+        current, they only hear and feed their own ports.
+     */
+    const DevicePortGroup* getPortGroup (const RootGraph* graph) const noexcept
+    {
+        const int groupId = graph->devicePortGroup;
+        if (! isPositiveAndBelow (groupId, numPortGroups) || ! portGroups[groupId].isValid())
+            return nullptr;
+        return portGroups + groupId;
+    }
+
+    void prepareGraphInput (const BlockState& state, RootGraph* graph, const AudioSampleBuffer& buffer, const MidiBuffer& midi, AudioSampleBuffer& audio, MidiBuffer& midiIn)
+    {
+        const int numSamples = state.numSamples;
+        auto* const current = state.current;
+        auto* const last = state.last;
+
+        if (auto* ports = getPortGroup (graph))
+        {
+            // own ports: no main inputs, and MIDI always like a parallel graph.
+            for (int i = 0; i < state.numChans; ++i)
+            {
+                if (i < ports->numInputs)
+                    audio.copyFrom (i, 0, ports->inputs[i], numSamples);
+                else
+                    audio.clear (i, 0, numSamples);
+            }
+
+            midiIn.clear (0, numSamples);
+            midiIn.addEvents (midi, 0, numSamples, 0);
+            return;
+        }
+
+        // copy inputs, clear outs if more than input count
+        if (&audio != &buffer)
+            for (int i = 0; i < numInputChans; ++i)
+                audio.copyFrom (i, 0, buffer, i, 0, numSamples);
+        for (int i = numInputChans; i < state.numChans; ++i)
+            audio.clear (i, 0, numSamples);
+
+        // avoids feedback loop when IO node ins are
+        // connected to IO node outs
+        midiIn.clear (0, numSamples);
+
+        if ((last == graph && state.graphChanged && last->isSingle())
+            || (state.graphChanged && current != nullptr && current->isSingle() && graph != current))
+        {
+            // send kill messages to the last graph(s) when the graph changes
+            addNotesOff (midiIn);
+        }
+        else if ((current == graph && graph->isSingle())
+                 || (current != nullptr && ! current->isSingle() && ! graph->isSingle()))
+        {
+            // current single graph or parallel graphs get MIDI always
+            midiIn.addEvents (midi, 0, numSamples, 0);
+        }
+    }
+
+    /** Release everything held on every channel.
+        see http://nickfever.com/music/midi-cc-list
+     */
+    static void addNotesOff (MidiBuffer& midiIn)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            // sustain pedal off
+            midiIn.addEvent (MidiMessage::controllerEvent (i + 1, 64, 0), 0);
+            // Sostenuto off
+            midiIn.addEvent (MidiMessage::controllerEvent (i + 1, 66, 0), 0);
+            // Hold off
+            midiIn.addEvent (MidiMessage::controllerEvent (i + 1, 69, 0), 0);
+
+            midiIn.addEvent (MidiMessage::allNotesOff (i + 1), 0);
+        }
+    }
+
+    /** Mix one last block of the graphs a session switch replaced, fading
+        out, with their notes released.
+     */
+    void fadeOutSwitched (const AudioSampleBuffer& buffer, int numSamples, int numChans)
+    {
+        for (auto* const graph : fading)
+        {
+            for (int i = 0; i < numInputChans; ++i)
+                audioTemp.copyFrom (i, 0, buffer, i, 0, numSamples);
+            for (int i = numInputChans; i < numChans; ++i)
+                audioTemp.clear (i, 0, numSamples);
+
+            midiTemp.clear();
+            addNotesOff (midiTemp);
+            renderGraph (graph, audioTemp, midiTemp, numSamples);
+
+            for (int i = 0; i < numOutputChans; ++i)
+                audioOut.addFromWithRamp (i, 0, audioTemp.getReadPointer (i), numSamples, 1.f, 0.f);
+        }
+
+        fading.clearQuick();
+        switched.store (false, std::memory_order_release);
+    }
+
+    void renderGraph (RootGraph* graph, AudioSampleBuffer& audio, MidiBuffer& midiBuf, int numSamples)
+    {
+        // cv and atom aren't used by root graphs, so sharing them is fine.
+        RenderContext rc (audio, cvTemp, midiBuf, atomTemp, numSamples);
+        const ScopedLock sl (graph->getPropertyLock());
+        if (graph->isParked())
+        {
+            // released for standby, it'll be prepared again off this thread.
+            audio.clear (0, numSamples);
+            midiBuf.clear();
+        }
+        else if (graph->isSuspended())
+        {
+            graph->renderBypassed (rc);
+        }
+        else
+        {
+            graph->render (rc);
+        }
+    }
+
+    void mixGraphOutput (const BlockState& state, RootGraph* graph, const AudioSampleBuffer& audio, const MidiBuffer& midiBuf)
+    {
+        const int numSamples = state.numSamples;
+        auto* const current = state.current;
+        auto* const last = state.last;
+        const bool graphChanged = state.graphChanged;
+        const bool modeChanged = state.modeChanged;
+
+        if (auto* ports = getPortGroup (graph))
+        {
+            // the device cleared the outputs before the callback.
+            for (int i = 0; i < jmin (ports->numOutputs, audio.getNumChannels()); ++i)
+                FloatVectorOperations::copy (ports->outputs[i], audio.getReadPointer (i), numSamples);
+            midiOut.addEvents (midiBuf, 0, numSamples, 0);
+            return;
+        }
+
+        // clang-format off
+        if (graphChanged && ((current->isSingle() && graph == last) || 
+                             (modeChanged && ! current->isSingle() && graph->isSingle() && graph == last)))
+
+        {
+            // DBG("  FADE OUT LAST GRAPH: " << graph->engineIndex);
+            for (int i = 0; i < numOutputChans; ++i)
+                audioOut.addFromWithRamp (i, 0, audio.getReadPointer (i), numSamples, 1.f, 0.f);
+        }
+        else if ((graph == current && graph->isSingle()) || (! graph->isSingle() && (current != nullptr) && ! current->isSingle()))
+        {
+            // if it's the current single graph or both are parallel...
+            if (graphChanged && (graph->isSingle() || (modeChanged && ! graph->isSingle() && ! current->isSingle())))
+            {
+                // DBG("  FADE IN NEW GRAPH: " << graph->engineIndex);
+                for (int i = 0; i < numOutputChans; ++i)
+                    audioOut.addFromWithRamp (i, 0, audio.getReadPointer (i), numSamples, 0.f, 1.f);
+            }
+            else
+            {
+                for (int i = 0; i < numOutputChans; ++i)
+                    audioOut.addFrom (i, 0, audio, i, 0, numSamples);
+            }
+
+            midiOut.addEvents (midiBuf, 0, numSamples, 0);
+        }
+        // clang-format on
+    }
+
     void updateIndexes()
     {
         for (int i = 0; i < graphs.size(); ++i)
@@ -297,10 +654,11 @@ private:
 };
 
 class AudioEngine::Private : public AudioIODeviceCallback,
+                             public DeviceMidiCallback,
+                             public DevicePortCallback,
                              public MidiInputCallback,
                              public Value::Listener,
-                             public MidiClock::Listener,
-                             public Timer
+                             public MidiClock::Listener
 {
 public:
     Private (AudioEngine& e)
@@ -319,8 +677,8 @@ public:
         sessionWantsExternalClock.set (0);
         midiClock.addListener (this);
         graphs.onActiveGraphChanged = std::bind (&AudioEngine::Private::onCurrentGraphChanged, this);
+        graphs.setRenderThreadPool (&renderPool);
         midiIOMonitor = new MidiIOMonitor();
-        startTimerHz (90);
     }
 
     ~Private()
@@ -333,14 +691,11 @@ public:
         if (isPrepared)
         {
             jassertfalse;
-            releaseResources();
             isPrepared = false;
         }
-    }
 
-    void timerCallback() override
-    {
-        midiIOMonitor->notify();
+        if (graphsBlockSize > 0)
+            releaseResources();
     }
 
     RootGraph* getCurrentGraph() const { return graphs.getCurrentGraph(); }
@@ -368,6 +723,8 @@ public:
             auto graphs = session->data().getChildWithName (tags::graphs);
             graphs.setProperty (tags::active, currentGraph.get(), nullptr);
         }
+
+        updateStandby();
     }
 
     void audioDeviceIOCallbackWithContext (const float* const* inputChannelData,
@@ -379,7 +736,26 @@ public:
     {
         jassert (sampleRate > 0 && blockSize > 0);
         int totalNumChans = 0;
+        RealtimeGuard::Scope realtime;
         ScopedNoDenormals denormals;
+        ThreadPolicy::applyRealtimeIfChanged (threadPolicy);
+
+        const bool tracing = RenderTrace::isEnabled();
+        const auto callbackTime = MidiInputQueue::now();
+        const auto callbackTicks = Time::getHighResolutionTicks();
+        const auto blockSeconds = numSamples / sampleRate;
+        const auto period = lastCallbackTicks > 0 ? Time::highResolutionTicksToSeconds (callbackTicks - lastCallbackTicks)
+                                                  : 0.0;
+        lastCallbackTicks = callbackTicks;
+
+        if (tracing)
+        {
+            RenderTrace::record (RenderTrace::blockBegin, 0, numSamples);
+
+            // a gap well past one block means the device had to wait on us.
+            if (period > blockSeconds * 1.5)
+                RenderTrace::record (RenderTrace::xrun, 0, (int32) ((period - blockSeconds) * 1.0e6));
+        }
 
         for (int c = 0; c < numInputChannels; ++c)
             inMeters.getObjectPointerUnchecked (c)->updateLevel (inputChannelData, c, numSamples);
@@ -424,39 +800,119 @@ public:
 
         AudioSampleBuffer buffer (channels, totalNumChans, numSamples);
         tempMidi.clear();
+        midiInput.render (tempMidi, numSamples, callbackTime);
         processCurrentGraph (buffer, tempMidi);
+        if (tracing && ! tempMidi.isEmpty())
+            RenderTrace::record (RenderTrace::midiOut, 0, tempMidi.getNumEvents());
+        if (deviceMidiOut != nullptr && ! tempMidi.isEmpty())
+            FixedMidi::add (*deviceMidiOut, tempMidi, 0, numSamples, 0);
 
+        if (! tempMidi.isEmpty())
         {
-            ScopedLock lockMidiOut (engine.world.midi().getMidiOutputLock());
-            if (auto* const midiOut = engine.world.midi().getDefaultMidiOutput())
-            {
-                const double delayMs = midiOutLatency.get();
-                if (! tempMidi.isEmpty())
-                {
-                    midiIOMonitor->sent();
-#if JUCE_WINDOWS
-                    midiOut->sendBlockOfMessagesNow (tempMidi);
-#else
-                    midiOut->sendBlockOfMessages (tempMidi, delayMs + Time::getMillisecondCounterHiRes(), sampleRate);
-#endif
-                }
-            }
+            // queued for the MIDI output thread, this never waits on a lock.
+            const double delayMs = midiOutLatency.get();
+            if (engine.world.midi().sendBlockOfMessages (tempMidi, delayMs + Time::getMillisecondCounterHiRes(), sampleRate))
+                midiIOMonitor->sent();
         }
 
         for (int c = 0; c < numOutputChannels; ++c)
             outMeters.getObjectPointerUnchecked (c)->updateLevel (outputChannelData, c, numSamples);
+
+        const auto elapsed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - callbackTicks);
+        telemetry.record (blockSeconds, elapsed, period);
+
+        if (tracing)
+        {
+            if (elapsed > blockSeconds)
+                RenderTrace::record (RenderTrace::xrun, 1, (int32) ((elapsed - blockSeconds) * 1.0e6));
+            RenderTrace::record (RenderTrace::blockEnd);
+        }
+    }
+
+    void setDeviceMidi (const MidiBuffer* in, MidiBuffer* out) noexcept override
+    {
+        deviceMidiIn = in;
+        deviceMidiOut = out;
+    }
+
+    void setDevicePortHost (DevicePortHost* host) override
+    {
+        {
+            // the host drops its groups when it goes away.
+            ScopedLock sl (lock);
+            for (auto* graph : graphs.getGraphs())
+                graph->devicePortGroup = -1;
+        }
+
+        portHost = host;
+        updateDevicePorts();
+    }
+
+    void setDevicePorts (const DevicePortGroup* groups, int numGroups) noexcept override
+    {
+        graphs.setDevicePorts (groups, numGroups);
+    }
+
+    /** Registers or removes device ports for graphs that changed whether
+        they want their own. Message thread only.
+     */
+    void updateDevicePorts()
+    {
+        if (portHost == nullptr)
+            return;
+
+        for (auto* graph : graphs.getGraphs())
+        {
+            const bool wanted = graph->isDevicePortsEnabled();
+            const int groupId = graph->devicePortGroup;
+            if (wanted && groupId < 0)
+            {
+                const int newId = portHost->addPortGroup (graph->getName(),
+                                                          graph->getNumPorts (PortType::Audio, true),
+                                                          graph->getNumPorts (PortType::Audio, false));
+                ScopedLock sl (lock);
+                graph->devicePortGroup = newId;
+            }
+            else if (! wanted && groupId >= 0)
+            {
+                removeDevicePorts (graph);
+            }
+        }
+
+        if (standbyGraphs.get() >= 0)
+            updateStandby();
+    }
+
+    void removeDevicePorts (RootGraph* graph)
+    {
+        const int groupId = graph->devicePortGroup;
+        if (groupId < 0)
+            return;
+
+        {
+            ScopedLock sl (lock);
+            graph->devicePortGroup = -1;
+        }
+
+        if (portHost != nullptr)
+            portHost->removePortGroup (groupId);
     }
 
     void processCurrentGraph (AudioBuffer<float>& buffer, MidiBuffer& midi)
     {
         const int numSamples = buffer.getNumSamples();
         messageCollector.removeNextBlockOfMessages (midi, numSamples);
+        if (deviceMidiIn != nullptr && ! deviceMidiIn->isEmpty())
+            FixedMidi::add (midi, *deviceMidiIn, 0, numSamples, 0);
+        if (! midi.isEmpty())
+            RenderTrace::record (RenderTrace::midiIn, 0, midi.getNumEvents());
 
-        extraMidi.clear();
-
-        if (MidiPanic::processCC (midi, extraMidi, panicCC.get(), panicChannel.get()))
+        // only copy through the panic filter when there's something to replace.
+        if (MidiPanic::containsCC (midi, panicCC.get(), panicChannel.get()))
         {
-            midi.swapWith (extraMidi);
+            extraMidi.clear();
+            if (MidiPanic::processCC (midi, extraMidi, panicCC.get(), panicChannel.get()))
+                midi.swapWith (extraMidi);
             extraMidi.clear();
         }
 
@@ -469,31 +925,14 @@ public:
 
         // MIDI Clock to input
         if (generateClock && clockToInput)
-        {
-            if (wasPlaying != transport.isPlaying())
-            {
-                if (transport.isPlaying())
-                {
-                    midi.addEvent (transport.getPositionFrames() <= 0
-                                       ? MidiMessage::midiStart()
-                                       : MidiMessage::midiContinue(),
-                                   0);
-                }
-                else
-                {
-                    midi.addEvent (MidiMessage::midiStop(), 0);
-                }
-            }
-
-            midiClockMaster.setTempo (static_cast<double> (transport.getTempo()));
-            midiClockMaster.render (midi, numSamples);
-        }
+            renderMidiClock (midi, wasPlaying, numSamples);
 
         const auto nextGraph = currentGraph.get();
         if (nextGraph != graphs.getCurrentGraphIndex())
         {
             graphs.setCurrentGraph (nextGraph);
         }
+        SharedPlugin::nextBlock();
         graphs.renderGraphs (buffer, midi); // user requested index can be cancelled by program changed
         if (nextGraph != graphs.getCurrentGraphIndex())
         {
@@ -502,30 +941,68 @@ public:
 
         // MIDI Clock out.
         if (generateClock && ! clockToInput)
+            renderMidiClock (midi, wasPlaying, numSamples);
+
+        // advances the position too.
+        transport.postProcess (numSamples);
+    }
+
+    /** Add start, stop or continue when the transport changed state and the
+        block's clock ticks. Ticks are re-aligned with the transport position
+        on start and continue, so a follower's beat lines up with ours.
+     */
+    void renderMidiClock (MidiBuffer& midi, bool wasPlaying, int numSamples) noexcept
+    {
+        midiClockMaster.setTempo (static_cast<double> (transport.getTempo()));
+
+        if (wasPlaying != transport.isPlaying())
         {
-            if (wasPlaying != transport.isPlaying())
+            static constexpr uint8 start[] = { 0xfa }, cont[] = { 0xfb }, stop[] = { 0xfc };
+            if (transport.isPlaying())
             {
-                if (transport.isPlaying())
-                {
-                    midi.addEvent (transport.getPositionFrames() <= 0
-                                       ? MidiMessage::midiStart()
-                                       : MidiMessage::midiContinue(),
-                                   0);
-                }
-                else
-                {
-                    midi.addEvent (MidiMessage::midiStop(), 0);
-                }
+                const auto frame = transport.getPositionFrames();
+                FixedMidi::add (midi, frame <= 0 ? start : cont, 1, 0);
+                midiClockMaster.sync (frame);
+            }
+            else
+            {
+                FixedMidi::add (midi, stop, 1, 0);
             }
+        }
+
+        midiClockMaster.render (midi, numSamples);
+    }
+
+    /** Render a block handed to us by a plugin host.
 
-            midiClockMaster.setTempo (transport.getTempo());
-            midiClockMaster.render (midi, numSamples);
+        Hosts may pass any block size, including ones larger than what was
+        prepared. Those are rendered in prepared sized pieces so buffers are
+        never resized on the audio thread. tempMidi isn't used by the device
+        callback in plugin mode and holds each piece's MIDI.
+     */
+    void processPluginBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
+    {
+        const int numSamples = buffer.getNumSamples();
+        midiInput.render (midi, numSamples, MidiInputQueue::now());
+        if (numSamples <= blockSize || blockSize <= 0)
+        {
+            processCurrentGraph (buffer, midi);
+            return;
         }
 
-        if (transport.isPlaying())
-            transport.advance (numSamples);
+        pluginMidiOut.clear();
+        for (int offset = 0; offset < numSamples; offset += blockSize)
+        {
+            const int numFrames = jmin (blockSize, numSamples - offset);
+            AudioBuffer<float> piece (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), offset, numFrames);
+            tempMidi.clear();
+            FixedMidi::add (tempMidi, midi, offset, numFrames, -offset);
+            processCurrentGraph (piece, tempMidi);
+            FixedMidi::add (pluginMidiOut, tempMidi, 0, numFrames, offset);
+        }
 
-        transport.postProcess (numSamples);
+        midi.swapWith (pluginMidiOut);
+        pluginMidiOut.clear();
     }
 
     bool isTimeMaster() const
@@ -535,19 +1012,35 @@ public:
         return processMidiClock.get() == 0 && sessionWantsExternalClock.get() == 0;
     }
 
-    void audioDeviceAboutToStart (AudioIODevice* const device) override
+    void audioDeviceAboutToStart (AudioIODevice* const newDevice) override
     {
-        const double newSampleRate = device->getCurrentSampleRate();
-        const int newBlockSize = device->getCurrentBufferSizeSamples();
-        const int numChansIn = device->getActiveInputChannels().countNumberOfSetBits();
-        const int numChansOut = device->getActiveOutputChannels().countNumberOfSetBits();
+        device = newDevice;
+        telemetry.reset();
+        threadPolicy = -1; // the callback might come from a new thread.
+        lastCallbackTicks = 0;
+        const double newSampleRate = newDevice->getCurrentSampleRate();
+        const int newBlockSize = newDevice->getCurrentBufferSizeSamples();
+        const int numChansIn = newDevice->getActiveInputChannels().countNumberOfSetBits();
+        const int numChansOut = newDevice->getActiveOutputChannels().countNumberOfSetBits();
         audioAboutToStart (newSampleRate, newBlockSize, numChansIn, numChansOut);
     }
 
     void audioAboutToStart (const double newSampleRate, const int newBlockSize, const int numChansIn, const int numChansOut)
     {
-        const ScopedLock sl (lock);
+        Array<GraphNode*> toPrepare;
+        {
+            const ScopedLock sl (lock);
+            toPrepare = aboutToStart (newSampleRate, newBlockSize, numChansIn, numChansOut);
+        }
+
+        // nothing renders until this returns, so the graphs prepare without
+        // the lock, which their latency updates take from other threads.
+        GraphNode::prepareGraphs (toPrepare, graphsSampleRate, graphsBlockSize);
+        isPrepared = true;
+    }
 
+    Array<GraphNode*> aboutToStart (const double newSampleRate, const int newBlockSize, const int numChansIn, const int numChansOut)
+    {
         sampleRate = newSampleRate;
         blockSize = newBlockSize;
         numInputChans = numChansIn;
@@ -555,6 +1048,9 @@ public:
 
         midiClock.reset (sampleRate, blockSize);
         messageCollector.reset (sampleRate);
+        midiInput.reset (sampleRate);
+        FixedMidi::reserve (tempMidi);
+        FixedMidi::reserve (pluginMidiOut);
         keyboardState.addListener (&messageCollector);
         channels.calloc ((size_t) jmax (numChansIn, numChansOut) + 2);
 
@@ -565,26 +1061,33 @@ public:
         while (outMeters.size() < numOutputChans)
             outMeters.add (new AudioEngine::LevelMeter());
 
-        if (isPrepared)
-        {
-            isPrepared = false;
+        // graphs kept through a restart are used again if they were
+        // prepared at this rate for blocks at least this long.
+        isPrepared = false;
+        if (graphsBlockSize > 0 && (graphsSampleRate != sampleRate || graphsBlockSize < blockSize))
             releaseResources();
+        if (graphsBlockSize <= 0)
+        {
+            graphsSampleRate = sampleRate;
+            graphsBlockSize = blockSize;
         }
 
-        prepareToPlay (sampleRate, blockSize);
-        isPrepared = true;
+        return prepareToPlay (sampleRate);
     }
 
     void audioDeviceStopped() override
     {
-        audioStopped();
+        device = nullptr;
+        // a device stops to change its settings, so keep the graphs until
+        // the next start shows whether they still fit.
+        audioStopped (true);
     }
 
-    void audioStopped()
+    void audioStopped (bool keepGraphs)
     {
         const ScopedLock sl (lock);
         keyboardState.removeListener (&messageCollector);
-        if (isPrepared)
+        if (! keepGraphs)
             releaseResources();
         isPrepared = false;
         sampleRate = 0.0;
@@ -597,7 +1100,9 @@ public:
     {
         if (! message.isActiveSense() && ! message.isMidiClock())
             midiIOMonitor->received();
-        messageCollector.addMessageToQueue (message);
+        // short messages keep their arrival time, sysex goes through the collector.
+        if (! midiInput.push (message))
+            messageCollector.addMessageToQueue (message);
         const bool clockWanted = processMidiClock.get() > 0 && sessionWantsExternalClock.get() > 0;
         const bool doStartStop = startStopCont.get() != 0;
 
@@ -627,26 +1132,165 @@ public:
     void addGraph (RootGraph* graph)
     {
         jassert (graph);
+        // with a standby limit, the graph is parked until updateStandby()
+        // decides whether it's near enough to prepare.
+        const bool standby = standbyGraphs.get() >= 0;
+        if (isPrepared && ! standby)
+            prepareGraph (graph, graphsSampleRate, graphsBlockSize);
+        graph->parked.store (standby);
+
+        {
+            ScopedLock sl (lock);
+            graph->setRenderThreadPool (&renderPool);
+            graph->setRenderQuantum (renderQuantum.get());
+            graph->setFlattenSubgraphs (flattenSubgraphs.get() == 1);
+            if (graphs.addGraph (graph))
+            {
+                graph->renderingSequenceChanged.connect (
+                    [this]() { latencyUpdate.triggerAsyncUpdate(); });
+            }
+        }
+
+        if (graph->isDevicePortsEnabled())
+            updateDevicePorts();
+        else if (standby)
+            updateStandby();
+    }
+
+    void addCuedGraph (RootGraph* graph)
+    {
+        jassert (graph);
+        // the next show is ready whatever the standby limit, so switching
+        // to it never waits on preparing.
         if (isPrepared)
-            prepareGraph (graph, sampleRate, blockSize);
-        ScopedLock sl (lock);
-        if (graphs.addGraph (graph))
+            prepareGraph (graph, graphsSampleRate, graphsBlockSize);
+        graph->parked.store (false);
+
+        {
+            ScopedLock sl (lock);
+            graph->setRenderThreadPool (&renderPool);
+            graph->setRenderQuantum (renderQuantum.get());
+            graph->setFlattenSubgraphs (flattenSubgraphs.get() == 1);
+            graphs.addCuedGraph (graph);
+        }
+
+        graph->renderingSequenceChanged.connect (
+            [this]() { latencyUpdate.triggerAsyncUpdate(); });
+    }
+
+    void switchToCuedGraphs (const int index)
+    {
         {
-            graph->renderingSequenceChanged.connect (
-                std::bind (&AudioEngine::updateExternalLatencySamples, &engine));
+            ScopedLock sl (lock);
+            graphs.switchToCuedGraphs (index);
+            currentGraph.set (graphs.getCurrentGraphIndex());
+            standbyCurrent = standbyPrevious = -1;
         }
+
+        // device ports and standby follow the new graphs, updating ports
+        // updates standby too.
+        if (portHost != nullptr)
+            updateDevicePorts();
+        else if (standbyGraphs.get() >= 0)
+            updateStandby();
+        latencyUpdate.triggerAsyncUpdate();
     }
 
     void removeGraph (RootGraph* graph)
     {
+        // graphs switched away from are heard for one more block, wait it
+        // out while the device is calling back.
+        for (int i = 0; i < 200 && isPrepared && graphs.isSwitching(); ++i)
+            Thread::sleep (1);
+
         {
             ScopedLock sl (lock);
             graphs.removeGraph (graph);
+            graph->setRenderThreadPool (nullptr);
         }
 
         graph->renderingSequenceChanged.disconnect_all_slots();
-        if (isPrepared)
+        removeDevicePorts (graph);
+        if (graphsBlockSize > 0)
+            graph->releaseResources();
+        graph->parked.store (false);
+
+        if (standbyGraphs.get() >= 0)
+            updateStandby();
+    }
+
+    /** Returns true if a graph should be kept ready for a program change.
+        That's the current and previous graphs, the one a set list says is
+        next, plus the next few in session order. Parallel graphs
+        can be heard alongside each other, so they're always kept, as are
+        graphs with their own device ports.
+     */
+    bool isWantedForStandby (int index, int current, int previous) const
+    {
+        const int limit = standbyGraphs.get();
+        const int numGraphs = graphs.size();
+        if (limit < 0 || current < 0 || index == current || index == previous)
+            return true;
+        const int upcoming = upcomingProgram.get();
+        if (upcoming >= 0 && graphs.getGraph (index)->midiProgram == upcoming)
+            return true;
+        if (! graphs.getGraph (index)->isSingle() || graphs.getGraph (index)->devicePortGroup >= 0)
+            return true;
+        return (index - current + numGraphs) % numGraphs <= limit;
+    }
+
+    /** Prepares graphs near the current one and releases the rest.
+        Called on the message thread after a graph change, so the neighbours
+        of a new program are loaded before they're asked for.
+     */
+    void updateStandby()
+    {
+        if (! isPrepared)
+            return;
+
+        Array<RootGraph*> wake, sleep;
+        {
+            ScopedLock sl (lock);
+            const int current = graphs.getCurrentGraphIndex();
+            if (current != standbyCurrent)
+            {
+                standbyPrevious = standbyCurrent;
+                standbyCurrent = current;
+            }
+
+            // walk forward from the current graph, so the nearest are prepared first.
+            const int numGraphs = graphs.size();
+            for (int i = 0; i < numGraphs; ++i)
+            {
+                const int index = (jmax (0, current) + i) % numGraphs;
+                auto* graph = graphs.getGraph (index);
+                if (isWantedForStandby (index, current, standbyPrevious))
+                {
+                    if (graph->isParked())
+                        wake.add (graph);
+                }
+                else if (! graph->isParked())
+                {
+                    sleep.add (graph);
+                }
+            }
+        }
+
+        for (auto* graph : sleep)
+        {
+            graph->parked.store (true);
+            // wait out a render that started before it was parked.
+            {
+                const ScopedLock sl (graph->getPropertyLock());
+            }
             graph->releaseResources();
+        }
+
+        for (auto* graph : wake)
+        {
+            prepareGraph (graph, graphsSampleRate, graphsBlockSize);
+            graph->parked.store (false);
+        }
     }
 
     void connectSessionValues()
@@ -732,11 +1376,23 @@ private:
     bool isPrepared = false;
     Atomic<int> currentGraph;
 
+    // what the graphs are prepared for, which outlasts a device restart.
+    double graphsSampleRate = 0.0;
+    int graphsBlockSize = 0;
+
     int numInputChans, numOutputChans;
     HeapBlock<float*> channels;
     AudioSampleBuffer tempBuffer;
-    MidiBuffer tempMidi, extraMidi;
+    MidiBuffer tempMidi, extraMidi, pluginMidiOut;
+    int64 lastCallbackTicks = 0;
+    TelemetryCollector telemetry;
+    const MidiBuffer* deviceMidiIn = nullptr;
+    MidiBuffer* deviceMidiOut = nullptr;
+    DevicePortHost* portHost = nullptr;
+    int threadPolicy = -1;
+    std::atomic<AudioIODevice*> device { nullptr };
     MidiMessageCollector messageCollector;
+    MidiInputQueue midiInput;
     MidiKeyboardState keyboardState;
 
     AudioSampleBuffer graphBuffer;
@@ -757,34 +1413,79 @@ private:
     MidiClockMaster midiClockMaster;
 
     int latencySamples = 0;
+    LatencyUpdate latencyUpdate { engine };
 
     MidiIOMonitorPtr midiIOMonitor;
 
     Atomic<double> midiOutLatency { 0.0 };
+    Atomic<int> renderQuantum { 0 };
+    Atomic<int> flattenSubgraphs { 0 };
+    Atomic<int> standbyGraphs { -1 };
+    Atomic<int> upcomingProgram { -1 };
+    int standbyCurrent = -1, standbyPrevious = -1;
+
+    RenderThreadPool renderPool;
 
     ReferenceCountedArray<AudioEngine::LevelMeter> inMeters, outMeters;
 
     void prepareGraph (RootGraph* graph, double sampleRate, int estimatedBlockSize)
     {
-        graph->setRenderDetails (sampleRate, blockSize);
+        graph->setRenderDetails (sampleRate, estimatedBlockSize);
         graph->setPlayHead (&transport);
         graph->prepareToRender (sampleRate, estimatedBlockSize);
     }
 
-    void prepareToPlay (double sampleRate, int estimatedBlockSize)
+    /** Readies the transport and returns the graphs that need preparing.
+        Graphs still prepared from before a restart are left as they are.
+     */
+    Array<GraphNode*> prepareToPlay (double sampleRate)
     {
+        Array<GraphNode*> toPrepare;
         transport.setSampleRate (sampleRate);
         transport.getMonitor()->sampleRate.set (transport.getSampleRate());
         midiClockMaster.setSampleRate (sampleRate);
         midiClockMaster.setTempo (transport.getTempo());
+        const int current = graphs.getCurrentGraphIndex();
+        standbyCurrent = current;
         for (int i = 0; i < graphs.size(); ++i)
-            prepareGraph (graphs.getGraph (i), sampleRate, estimatedBlockSize);
+        {
+            auto* graph = graphs.getGraph (i);
+            const bool wanted = isWantedForStandby (i, current, standbyPrevious);
+            if (wanted && ! graph->prepared())
+            {
+                graph->setRenderDetails (graphsSampleRate, graphsBlockSize);
+                graph->setPlayHead (&transport);
+                toPrepare.add (graph);
+            }
+            else if (! wanted && graph->prepared())
+            {
+                graph->releaseResources();
+            }
+            graph->parked.store (! wanted);
+        }
+
+        for (auto* graph : graphs.getCuedGraphs())
+        {
+            if (! graph->prepared())
+            {
+                graph->setRenderDetails (graphsSampleRate, graphsBlockSize);
+                graph->setPlayHead (&transport);
+                toPrepare.add (graph);
+            }
+            graph->parked.store (false);
+        }
+
+        return toPrepare;
     }
 
     void releaseResources()
     {
         for (int i = 0; i < graphs.size(); ++i)
             graphs.getGraph (i)->releaseResources();
+        for (auto* graph : graphs.getCuedGraphs())
+            graph->releaseResources();
+        graphsSampleRate = 0.0;
+        graphsBlockSize = 0;
     }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Private)
@@ -794,17 +1495,38 @@ AudioEngine::AudioEngine (Context& g, RunMode m)
     : world (g), runMode (m)
 {
     priv = std::make_unique<Private> (*this);
+
+    // ELEMENT_RENDER_TRACE=/path/to/trace.json captures the whole run.
+    const auto tracePath = SystemStats::getEnvironmentVariable ("ELEMENT_RENDER_TRACE", {});
+    if (tracePath.isNotEmpty() && File::isAbsolutePath (tracePath))
+    {
+        traceFile = File (tracePath);
+        startRenderTrace();
+    }
 }
 
 AudioEngine::~AudioEngine() noexcept
 {
     deactivate();
     priv.reset();
+
+    if (traceFile != File())
+        stopRenderTrace (traceFile);
+}
+
+void AudioEngine::startRenderTrace()
+{
+    RenderTrace::start();
+}
+
+bool AudioEngine::stopRenderTrace (const File& file)
+{
+    return RenderTrace::stopAndSave (file);
 }
 
 void AudioEngine::activate()
 {
-    if (getRunMode() == RunMode::Standalone)
+    if (getRunMode() != RunMode::Plugin)
     {
         auto& midi (world.midi());
         midi.addMidiInputCallback (&getMidiInputCallback());
@@ -813,7 +1535,7 @@ void AudioEngine::activate()
 
 void AudioEngine::deactivate()
 {
-    if (getRunMode() == RunMode::Standalone)
+    if (getRunMode() != RunMode::Plugin)
     {
         auto& midi (world.midi());
         midi.removeMidiInputCallback (&getMidiInputCallback());
@@ -858,6 +1580,52 @@ void AudioEngine::applySettings (Settings& settings)
     }
 
     priv->startStopCont.set (settings.transportRespondToStartStopContinue() ? 1 : 0);
+
+    {
+        // workers can't change while a graph is rendering with them.
+        ScopedLock sl (priv->lock);
+        priv->renderPool.setNumWorkers (runMode == RunMode::Plugin ? 0
+                                                                   : settings.getNumRenderThreads());
+    }
+
+    priv->renderQuantum.set (settings.getRenderQuantum());
+    priv->flattenSubgraphs.set (settings.isFlatteningSubgraphs() ? 1 : 0);
+    SignalGuard::setEnabled (settings.isGuardingNodeOutputs());
+    Looper::setMaxSeconds (settings.getLooperSeconds());
+    for (auto* graph : priv->graphs.getGraphs())
+    {
+        graph->setRenderQuantum (priv->renderQuantum.get());
+        graph->setFlattenSubgraphs (priv->flattenSubgraphs.get() == 1);
+    }
+    for (auto* graph : priv->graphs.getCuedGraphs())
+    {
+        graph->setRenderQuantum (priv->renderQuantum.get());
+        graph->setFlattenSubgraphs (priv->flattenSubgraphs.get() == 1);
+    }
+
+    // a plugin's threads belong to the host.
+    if (runMode != RunMode::Plugin)
+    {
+        ThreadPolicy::set (ThreadPolicy::parseCores (settings.getRealtimeCores()),
+                           ThreadPolicy::parseCores (settings.getBackgroundCores()),
+                           settings.getRealtimePriority());
+    }
+
+    priv->standbyGraphs.set (settings.getStandbyGraphs());
+    priv->updateStandby();
+}
+
+bool AudioEngine::addCuedGraph (RootGraph* graph)
+{
+    jassert (priv && graph);
+    priv->addCuedGraph (graph);
+    return true;
+}
+
+void AudioEngine::switchToCuedGraphs (const int index)
+{
+    if (priv != nullptr)
+        priv->switchToCuedGraphs (index);
 }
 
 bool AudioEngine::removeGraph (RootGraph* graph)
@@ -867,6 +1635,11 @@ bool AudioEngine::removeGraph (RootGraph* graph)
     return true;
 }
 
+void AudioEngine::updateDevicePorts()
+{
+    priv->updateDevicePorts();
+}
+
 RootGraph* AudioEngine::getGraph (const int index)
 {
     ScopedLock sl (priv->lock);
@@ -891,6 +1664,16 @@ void AudioEngine::setActiveGraph (const int index)
         priv->currentGraph.set (index);
 }
 
+void AudioEngine::setUpcomingProgram (int program)
+{
+    program = isPositiveAndBelow (program, 128) ? program : -1;
+    if (priv == nullptr || priv->upcomingProgram.get() == program)
+        return;
+    priv->upcomingProgram.set (program);
+    if (priv->standbyGraphs.get() >= 0)
+        priv->updateStandby();
+}
+
 int AudioEngine::getActiveGraph() const { return (priv != nullptr) ? priv->currentGraph.get() : -1; }
 
 void AudioEngine::setSession (SessionPtr session)
@@ -922,6 +1705,12 @@ void AudioEngine::setMeter (int beatsPerBar, int beatDivisor)
     transport.requestMeter (beatsPerBar, beatDivisor);
 }
 
+void AudioEngine::rampTempo (double bpm, int64 lengthFrames)
+{
+    auto& transport (priv->transport);
+    transport.requestTempoRamp (bpm, lengthFrames);
+}
+
 void AudioEngine::togglePlayPause()
 {
     auto& transport (priv->transport);
@@ -949,19 +1738,67 @@ void AudioEngine::seekToAudioFrame (const int64 frame)
 void AudioEngine::prepareExternalPlayback (const double sampleRate, const int blockSize, const int numIns, const int numOuts)
 {
     if (priv)
+    {
+        priv->telemetry.reset();
+        priv->lastCallbackTicks = 0;
         priv->audioAboutToStart (sampleRate, blockSize, numIns, numOuts);
+    }
 }
 
 void AudioEngine::processExternalBuffers (AudioBuffer<float>& buffer, MidiBuffer& midi)
 {
     if (priv)
     {
+        RealtimeGuard::Scope realtime;
+        const auto startTicks = Time::getHighResolutionTicks();
+        const auto period = priv->lastCallbackTicks > 0
+                                ? Time::highResolutionTicksToSeconds (startTicks - priv->lastCallbackTicks)
+                                : 0.0;
+        priv->lastCallbackTicks = startTicks;
+
         if (getRunMode() == RunMode::Plugin)
+        {
             world.midi().processMidiBuffer (midi, buffer.getNumSamples(), priv->sampleRate);
-        priv->processCurrentGraph (buffer, midi);
+            priv->processPluginBlock (buffer, midi);
+        }
+        else
+        {
+            priv->processCurrentGraph (buffer, midi);
+        }
+
+        if (priv->sampleRate > 0.0)
+        {
+            const auto elapsed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            priv->telemetry.record (buffer.getNumSamples() / priv->sampleRate, elapsed, period);
+        }
     }
 }
 
+AudioEngine::Telemetry AudioEngine::getTelemetry() const
+{
+    auto t = priv->telemetry.snapshot();
+    t.signalFaults = SignalGuard::getNumFaults();
+    if (auto* device = priv->device.load())
+        t.xruns = device->getXRunCount();
+    return t;
+}
+
+void AudioEngine::resetTelemetry()
+{
+    priv->telemetry.reset();
+    SignalGuard::resetFaults();
+}
+
+AudioEngine::MidiClockStats AudioEngine::getMidiClockStats() const
+{
+    return priv->midiClock.getStats();
+}
+
+int AudioEngine::getNumMidiInputsPending() const noexcept
+{
+    return priv != nullptr ? priv->midiInput.getNumReady() : 0;
+}
+
 bool AudioEngine::isUsingExternalClock() const
 {
     return priv && priv->isUsingExternalClock();
@@ -991,7 +1828,7 @@ void AudioEngine::processExternalPlayhead (AudioPlayHead* playhead, const int nf
 void AudioEngine::releaseExternalResources()
 {
     if (priv)
-        priv->audioStopped();
+        priv->audioStopped (false);
 }
 
 Context& AudioEngine::context() const { return world; }
@@ -1019,6 +1856,8 @@ void AudioEngine::updateExternalLatencySamples()
         }
     }
 
+    if (priv->latencySamples == latencySamples)
+        return;
     priv->latencySamples = latencySamples;
     sampleLatencyChanged();
 }
@@ -0,0 +1,147 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+
+#include <element/juce/audio_basics.hpp>
+
+namespace element {
+
+/** A high resolution controller change decoded from MIDI 1.0 messages. */
+struct ControllerEvent
+{
+    enum Type : int
+    {
+        Controller14 = 0, ///< 14-bit CC: an MSB controller 0-31 and its LSB at +32
+        NRPN, ///< non registered parameter number
+        RPN ///< registered parameter number
+    };
+
+    Type type = Controller14;
+    int channel = 1; ///< 1-16
+    int number = 0; ///< the MSB controller number or the 14-bit parameter number
+    int value = 0; ///< 0-16383
+
+    /** Returns the value from zero to one. */
+    float getNormalized() const noexcept { return (float) value / 16383.f; }
+
+    /** Returns a key unique to the type and number, ignoring channel. */
+    int getKey() const noexcept { return key (type, number); }
+    static constexpr int key (Type type, int number) noexcept { return ((int) type << 14) | (number & 0x3fff); }
+};
+
+/** Pairs MSB/LSB controller messages into 14-bit values.
+
+    MSB halves are latched and a value is produced when its LSB arrives,
+    so a pair gives one ControllerEvent instead of two 7-bit updates. NRPN
+    and RPN data entry works the same way: CC 6 latches, CC 38 completes.
+    Controllers that aren't part of a pair are ignored. Keeps state per
+    channel, call from one thread.
+ */
+class ControllerDecoder final
+{
+public:
+    ControllerDecoder() { reset(); }
+
+    /** Forget all latched state. */
+    void reset() noexcept
+    {
+        for (auto& ch : channels)
+        {
+            std::fill (std::begin (ch.msb), std::end (ch.msb), -1);
+            ch.parameter = -1;
+            ch.parameterMsb = ch.parameterLsb = -1;
+            ch.dataMsb = -1;
+            ch.registered = false;
+        }
+    }
+
+    /** Feed a message. Returns true and fills event when it completes a
+        high resolution value.
+     */
+    bool decode (const juce::MidiMessage& msg, ControllerEvent& event) noexcept
+    {
+        if (! msg.isController())
+            return false;
+
+        auto& ch = channels[msg.getChannel() - 1];
+        const int number = msg.getControllerNumber();
+        const int value = msg.getControllerValue();
+
+        switch (number)
+        {
+            case 6: // data entry MSB
+                ch.dataMsb = value;
+                return false;
+
+            case 38: // data entry LSB
+                if (ch.parameter < 0 || ch.dataMsb < 0)
+                    return false;
+                event.type = ch.registered ? ControllerEvent::RPN : ControllerEvent::NRPN;
+                event.channel = msg.getChannel();
+                event.number = ch.parameter;
+                event.value = (ch.dataMsb << 7) | value;
+                return true;
+
+            case 98: // NRPN LSB
+            case 100: // RPN LSB
+                setParameter (ch, number == 100, false, value);
+                return false;
+
+            case 99: // NRPN MSB
+            case 101: // RPN MSB
+                setParameter (ch, number == 101, true, value);
+                return false;
+
+            default:
+                break;
+        }
+
+        if (number < 32)
+        {
+            ch.msb[number] = value;
+            return false;
+        }
+
+        if (number < 64 && ch.msb[number - 32] >= 0)
+        {
+            event.type = ControllerEvent::Controller14;
+            event.channel = msg.getChannel();
+            event.number = number - 32;
+            event.value = (ch.msb[number - 32] << 7) | value;
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    struct Channel
+    {
+        int msb[32];
+        int parameter, parameterMsb, parameterLsb, dataMsb;
+        bool registered;
+    };
+
+    Channel channels[16];
+
+    static void setParameter (Channel& ch, bool registered, bool isMsb, int value) noexcept
+    {
+        // switched between NRPN and RPN, the other half is stale.
+        if (ch.registered != registered)
+            ch.parameterMsb = ch.parameterLsb = -1;
+
+        ch.registered = registered;
+        (isMsb ? ch.parameterMsb : ch.parameterLsb) = value;
+        ch.dataMsb = -1;
+
+        // 127/127 is the null parameter, it deselects.
+        const int msb = ch.parameterMsb, lsb = ch.parameterLsb;
+        ch.parameter = (msb >= 0 && lsb >= 0 && ! (msb == 127 && lsb == 127)) ? (msb << 7) | lsb : -1;
+    }
+};
+
+} // namespace element
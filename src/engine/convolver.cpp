@@ -0,0 +1,289 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "engine/convolver.hpp"
+
+namespace element {
+using namespace juce;
+
+namespace {
+
+/** dst += a * b over interleaved complex spectra. */
+void multiplyAccumulate (float* dst, const float* a, const float* b, int numBins) noexcept
+{
+    for (int i = 0; i < numBins; ++i)
+    {
+        const float ar = a[i * 2], ai = a[i * 2 + 1];
+        const float br = b[i * 2], bi = b[i * 2 + 1];
+        dst[i * 2] += ar * br - ai * bi;
+        dst[i * 2 + 1] += ar * bi + ai * br;
+    }
+}
+
+int getOrder (int size) noexcept
+{
+    int order = 0;
+    while ((1 << order) < size)
+        ++order;
+    return order;
+}
+
+} // namespace
+
+//==============================================================================
+void PartitionedConvolver::init (int newBlockSize, const float* impulse, int impulseLength)
+{
+    jassert (isPowerOfTwo (newBlockSize));
+    blockSize = newBlockSize;
+    spectrumSize = (blockSize + 1) * 2;
+    numPartitions = impulse != nullptr ? (jmax (0, impulseLength) + blockSize - 1) / blockSize : 0;
+    fft = std::make_unique<dsp::FFT> (getOrder (blockSize * 2));
+
+    impulseSpectra.assign ((size_t) (numPartitions * spectrumSize), 0.f);
+    segments.assign ((size_t) (numPartitions * spectrumSize), 0.f);
+    preMultiplied.assign ((size_t) spectrumSize, 0.f);
+    input.assign ((size_t) blockSize, 0.f);
+    overlap.assign ((size_t) blockSize, 0.f);
+    fftBuffer.assign ((size_t) blockSize * 4, 0.f);
+
+    for (int i = 0; i < numPartitions; ++i)
+    {
+        const int offset = i * blockSize;
+        std::fill (fftBuffer.begin(), fftBuffer.end(), 0.f);
+        std::copy (impulse + offset, impulse + offset + jmin (blockSize, impulseLength - offset), fftBuffer.begin());
+        fft->performRealOnlyForwardTransform (fftBuffer.data(), true);
+        std::copy (fftBuffer.begin(), fftBuffer.begin() + spectrumSize, getImpulse (i));
+    }
+
+    reset();
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    std::fill (segments.begin(), segments.end(), 0.f);
+    std::fill (preMultiplied.begin(), preMultiplied.end(), 0.f);
+    std::fill (input.begin(), input.end(), 0.f);
+    std::fill (overlap.begin(), overlap.end(), 0.f);
+    current = 0;
+    inputFill = 0;
+}
+
+void PartitionedConvolver::process (const float* in, float* out, int numSamples) noexcept
+{
+    if (numPartitions <= 0)
+    {
+        FloatVectorOperations::clear (out, numSamples);
+        return;
+    }
+
+    const int numBins = blockSize + 1;
+    float* const data = fftBuffer.data();
+
+    for (int done = 0; done < numSamples;)
+    {
+        const bool blockStarted = inputFill == 0;
+        const int position = inputFill;
+        const int n = jmin (numSamples - done, blockSize - inputFill);
+
+        FloatVectorOperations::copy (input.data() + position, in + done, n);
+
+        // transform the partly filled block, zero padded to twice its size.
+        FloatVectorOperations::copy (data, input.data(), blockSize);
+        FloatVectorOperations::clear (data + blockSize, blockSize * 3);
+        fft->performRealOnlyForwardTransform (data, true);
+        float* const segment = getSegment (current);
+        FloatVectorOperations::copy (segment, data, spectrumSize);
+
+        // older blocks only change when a new one starts.
+        if (blockStarted)
+        {
+            FloatVectorOperations::clear (preMultiplied.data(), spectrumSize);
+            for (int i = 1; i < numPartitions; ++i)
+                multiplyAccumulate (preMultiplied.data(), getImpulse (i), getSegment ((current + i) % numPartitions), numBins);
+        }
+
+        FloatVectorOperations::copy (data, preMultiplied.data(), spectrumSize);
+        multiplyAccumulate (data, getImpulse (0), segment, numBins);
+        fft->performRealOnlyInverseTransform (data);
+
+        FloatVectorOperations::add (out + done, data + position, overlap.data() + position, n);
+
+        inputFill += n;
+        if (inputFill == blockSize)
+        {
+            FloatVectorOperations::clear (input.data(), blockSize);
+            FloatVectorOperations::copy (overlap.data(), data + blockSize, blockSize);
+            current = current > 0 ? current - 1 : numPartitions - 1;
+            inputFill = 0;
+        }
+
+        done += n;
+    }
+}
+
+//==============================================================================
+class Convolver::Worker final : public Thread
+{
+public:
+    Worker (Convolver& c)
+        : Thread ("element: convolver"), owner (c) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (! start.wait (100))
+                continue;
+            if (threadShouldExit())
+                break;
+            owner.processLate();
+            finished.signal();
+        }
+    }
+
+    WaitableEvent start, finished;
+
+private:
+    Convolver& owner;
+};
+
+Convolver::Convolver (const AudioBuffer<float>& impulse, int numChannels, int newHeadSize, int newTailSize, bool backgroundTail)
+{
+    length = impulse.getNumChannels() > 0 ? impulse.getNumSamples() : 0;
+    headSize = nextPowerOfTwo (jmax (16, newHeadSize));
+    tailSize = jmax (headSize * 2, nextPowerOfTwo (newTailSize));
+    hasEarly = length > tailSize;
+    hasLate = length > tailSize * 2;
+
+    channels.resize ((size_t) jmax (1, numChannels));
+    for (int ch = 0; ch < (int) channels.size(); ++ch)
+    {
+        auto& c = channels[(size_t) ch];
+        const float* ir = length > 0 ? impulse.getReadPointer (jmin (ch, impulse.getNumChannels() - 1)) : nullptr;
+
+        c.head.init (headSize, ir, jmin (length, tailSize));
+
+        if (hasEarly)
+        {
+            c.early.init (headSize, ir + tailSize, jmin (length - tailSize, tailSize));
+            c.earlyOutput.assign ((size_t) tailSize, 0.f);
+            c.earlyReady.assign ((size_t) tailSize, 0.f);
+        }
+
+        if (hasLate)
+        {
+            c.late.init (tailSize, ir + tailSize * 2, length - tailSize * 2);
+            c.lateInput.assign ((size_t) tailSize, 0.f);
+            c.lateOutput.assign ((size_t) tailSize, 0.f);
+            c.lateReady.assign ((size_t) tailSize, 0.f);
+        }
+
+        if (hasEarly)
+            c.tailInput.assign ((size_t) tailSize, 0.f);
+    }
+
+    if (hasLate && backgroundTail)
+    {
+        worker = std::make_unique<Worker> (*this);
+        worker->startThread (Thread::Priority::high);
+    }
+}
+
+Convolver::~Convolver()
+{
+    if (worker != nullptr)
+    {
+        worker->signalThreadShouldExit();
+        worker->start.signal();
+        worker->stopThread (1000);
+    }
+}
+
+void Convolver::process (const float* const* input, float* const* output, int numSamples) noexcept
+{
+    const int numChannels = getNumChannels();
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int n = jmin (numSamples - done, headSize - tailFill % headSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& c = channels[(size_t) ch];
+            // keep the input before the head overwrites it in place.
+            if (hasEarly)
+                FloatVectorOperations::copy (c.tailInput.data() + tailFill, input[ch] + done, n);
+
+            c.head.process (input[ch] + done, output[ch] + done, n);
+
+            if (hasEarly)
+                FloatVectorOperations::add (output[ch] + done, c.earlyReady.data() + tailFill, n);
+            if (hasLate)
+                FloatVectorOperations::add (output[ch] + done, c.lateReady.data() + tailFill, n);
+        }
+
+        tailFill += n;
+        done += n;
+
+        if (! hasEarly)
+        {
+            tailFill %= tailSize;
+            continue;
+        }
+
+        if (tailFill % headSize == 0)
+        {
+            const int offset = tailFill - headSize;
+            for (auto& c : channels)
+            {
+                c.early.process (c.tailInput.data() + offset, c.earlyOutput.data() + offset, headSize);
+                if (tailFill == tailSize)
+                    std::swap (c.earlyReady, c.earlyOutput);
+            }
+        }
+
+        if (tailFill == tailSize)
+        {
+            if (hasLate)
+            {
+                waitForLate();
+                for (auto& c : channels)
+                {
+                    std::swap (c.lateReady, c.lateOutput);
+                    std::swap (c.lateInput, c.tailInput);
+                }
+                startLate();
+            }
+
+            tailFill = 0;
+        }
+    }
+}
+
+void Convolver::startLate() noexcept
+{
+    if (worker == nullptr)
+    {
+        processLate();
+        return;
+    }
+
+    latePending = true;
+    worker->start.signal();
+}
+
+void Convolver::waitForLate() noexcept
+{
+    if (! latePending)
+        return;
+    worker->finished.wait (-1);
+    latePending = false;
+}
+
+void Convolver::processLate() noexcept
+{
+    for (auto& c : channels)
+        c.late.process (c.lateInput.data(), c.lateOutput.data(), tailSize);
+}
+
+} // namespace element
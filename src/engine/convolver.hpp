@@ -0,0 +1,131 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/dsp.hpp>
+
+namespace element {
+
+/** Uniformly partitioned FFT convolution of one channel.
+
+    The impulse is split into blocks of getBlockSize() samples, each kept as
+    a spectrum. Input is transformed as it arrives, so there is no latency
+    whatever the host block size. The products of older input blocks with
+    the later partitions are summed once per block and reused until the
+    next one starts.
+ */
+class PartitionedConvolver final
+{
+public:
+    PartitionedConvolver() = default;
+
+    /** Prepare for an impulse. blockSize must be a power of two. Allocates. */
+    void init (int blockSize, const float* impulse, int impulseLength);
+
+    /** Clears the input history without touching the impulse. */
+    void reset() noexcept;
+
+    /** Convolve numSamples of input. input and output may be the same.
+        Realtime safe.
+     */
+    void process (const float* input, float* output, int numSamples) noexcept;
+
+    /** Returns the partition size. */
+    int getBlockSize() const noexcept { return blockSize; }
+
+    /** Returns the number of partitions. */
+    int getNumPartitions() const noexcept { return numPartitions; }
+
+private:
+    std::unique_ptr<juce::dsp::FFT> fft;
+    int blockSize = 0;
+    int spectrumSize = 0; // interleaved complex, blockSize + 1 bins
+    int numPartitions = 0;
+    int current = 0;
+    int inputFill = 0;
+
+    std::vector<float> impulseSpectra;
+    std::vector<float> segments;
+    std::vector<float> preMultiplied;
+    std::vector<float> input;
+    std::vector<float> overlap;
+    std::vector<float> fftBuffer;
+
+    float* getImpulse (int index) noexcept { return impulseSpectra.data() + (size_t) (index * spectrumSize); }
+    float* getSegment (int index) noexcept { return segments.data() + (size_t) (index * spectrumSize); }
+};
+
+//==============================================================================
+/** Multichannel, zero latency convolution for long impulses.
+
+    The impulse is partitioned non uniformly. The head runs with small
+    partitions on the calling thread, so the first samples come out
+    straight away. Early reflections, the second tail sized stretch, also
+    use small partitions but are delayed one tail block. Everything after
+    that uses large partitions on a background thread, which has a whole
+    tail block of time to finish before its output is needed.
+
+    Channels beyond those in the impulse reuse its last channel.
+ */
+class Convolver final
+{
+public:
+    static constexpr int defaultHeadSize = 128;
+    static constexpr int defaultTailSize = 4096;
+
+    /** Create a convolver. Sizes are rounded up to powers of two. When
+        backgroundTail is false the late partitions run inline, which gives
+        the same output and suits offline rendering and tests. Allocates.
+     */
+    Convolver (const juce::AudioBuffer<float>& impulse,
+               int numChannels,
+               int headSize = defaultHeadSize,
+               int tailSize = defaultTailSize,
+               bool backgroundTail = true);
+    ~Convolver();
+
+    /** Returns the number of channels processed. */
+    int getNumChannels() const noexcept { return (int) channels.size(); }
+
+    /** Returns the impulse length in samples. */
+    int getLength() const noexcept { return length; }
+
+    /** Convolve numSamples of each channel. Inputs and outputs may be the
+        same buffers. Realtime safe, but may briefly wait on the tail thread
+        if it has fallen a whole tail block behind.
+     */
+    void process (const float* const* input, float* const* output, int numSamples) noexcept;
+
+private:
+    class Worker;
+    struct Channel
+    {
+        PartitionedConvolver head, early, late;
+        std::vector<float> tailInput, lateInput;
+        std::vector<float> earlyOutput, earlyReady;
+        std::vector<float> lateOutput, lateReady;
+    };
+
+    std::vector<Channel> channels;
+    std::unique_ptr<Worker> worker;
+    int length = 0;
+    int headSize = 0;
+    int tailSize = 0;
+    int tailFill = 0;
+    bool hasEarly = false;
+    bool hasLate = false;
+    bool latePending = false;
+
+    void startLate() noexcept;
+    void waitForLate() noexcept;
+    void processLate() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (Convolver)
+};
+
+} // namespace element
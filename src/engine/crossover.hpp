@@ -0,0 +1,181 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <cmath>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Linkwitz-Riley crossover splitting a signal into 2 to 8 bands.
+
+    Each split is a fourth order Linkwitz-Riley low and high pass, two
+    Butterworth biquads each. Bands below a split get its allpass too, so
+    every band has the same phase and the bands sum back to the input run
+    through an allpass, flat in magnitude.
+
+    Channels are filtered two at a time in one loop, the two recursions
+    are independent so they overlap in the pipeline and vector registers.
+ */
+class Crossover final
+{
+public:
+    static constexpr int minBands = 2;
+    static constexpr int maxBands = 8;
+    static constexpr int maxSplits = maxBands - 1;
+    static constexpr int maxChannels = 8;
+
+    Crossover() noexcept { prepare (sampleRate); }
+
+    /** Change the number of bands. Clears the filter state. */
+    void setNumBands (int newNumBands) noexcept
+    {
+        numBands = juce::jlimit (minBands, maxBands, newNumBands);
+        reset();
+    }
+
+    int getNumBands() const noexcept { return numBands; }
+
+    /** Set the sample rate, recalculate every split and clear the state. */
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        for (int i = 0; i < maxSplits; ++i)
+            design (i);
+        reset();
+    }
+
+    /** Clear the filter state. */
+    void reset() noexcept
+    {
+        juce::zeromem (lowState, sizeof (lowState));
+        juce::zeromem (highState, sizeof (highState));
+        juce::zeromem (allpassState, sizeof (allpassState));
+    }
+
+    /** Set the frequency of a split, 0 is the lowest. Realtime safe. */
+    void setFrequency (int split, float hz) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (split, maxSplits));
+        if (frequencies[split] == hz)
+            return;
+        frequencies[split] = hz;
+        design (split);
+    }
+
+    float getFrequency (int split) const noexcept { return frequencies[split]; }
+
+    /** Split input into getNumBands() outputs. output holds numChannels
+        pointers per band, band by band. The input may be the same as the
+        first band. Realtime safe.
+     */
+    void process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept
+    {
+        numChannels = juce::jmin (numChannels, maxChannels);
+        float* const* rest = output + (numBands - 1) * numChannels;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            if (rest[ch] != input[ch])
+                juce::FloatVectorOperations::copy (rest[ch], input[ch], numSamples);
+
+        for (int split = 0; split < numBands - 1; ++split)
+        {
+            float* const* band = output + split * numChannels;
+            run (lowpass[split], lowState[split][0], rest, band, numChannels, numSamples);
+            run (lowpass[split], lowState[split][1], band, band, numChannels, numSamples);
+            run (highpass[split], highState[split][0], rest, rest, numChannels, numSamples);
+            run (highpass[split], highState[split][1], rest, rest, numChannels, numSamples);
+
+            for (int above = split + 1; above < numBands - 1; ++above)
+                run (allpass[above], allpassState[split][above], band, band, numChannels, numSamples);
+        }
+    }
+
+private:
+    /** Normalized biquad coefficients. */
+    struct Coefs
+    {
+        float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+    };
+
+    using State = float[maxChannels][2];
+
+    int numBands = 3;
+    double sampleRate = 44100.0;
+    float frequencies[maxSplits] = { 500.f, 2000.f, 4000.f, 6000.f, 8000.f, 10000.f, 12000.f };
+
+    Coefs lowpass[maxSplits], highpass[maxSplits], allpass[maxSplits];
+    State lowState[maxSplits][2];
+    State highState[maxSplits][2];
+    State allpassState[maxSplits][maxSplits];
+
+    void design (int split) noexcept
+    {
+        const double fc = juce::jlimit (10.0, sampleRate * 0.45, (double) frequencies[split]);
+        const double w0 = juce::MathConstants<double>::twoPi * fc / sampleRate;
+        const double c = std::cos (w0);
+        const double alpha = std::sin (w0) / juce::MathConstants<double>::sqrt2; // Q of 1 / sqrt 2
+        const double a0 = 1.0 + alpha;
+
+        auto set = [a0, c, alpha] (Coefs& k, double b0, double b1, double b2) {
+            k.b0 = (float) (b0 / a0);
+            k.b1 = (float) (b1 / a0);
+            k.b2 = (float) (b2 / a0);
+            k.a1 = (float) (-2.0 * c / a0);
+            k.a2 = (float) ((1.0 - alpha) / a0);
+        };
+
+        set (lowpass[split], (1.0 - c) * 0.5, 1.0 - c, (1.0 - c) * 0.5);
+        set (highpass[split], (1.0 + c) * 0.5, -(1.0 + c), (1.0 + c) * 0.5);
+        set (allpass[split], 1.0 - alpha, -2.0 * c, 1.0 + alpha);
+    }
+
+    static void run (const Coefs& k, State& state, const float* const* in, float* const* out, int numChannels, int numSamples) noexcept
+    {
+        int ch = 0;
+        for (; ch + 2 <= numChannels; ch += 2)
+            runPair (k, state[ch], state[ch + 1], in[ch], in[ch + 1], out[ch], out[ch + 1], numSamples);
+        for (; ch < numChannels; ++ch)
+            runSingle (k, state[ch], in[ch], out[ch], numSamples);
+    }
+
+    static void runSingle (const Coefs& k, float* z, const float* in, float* out, int numSamples) noexcept
+    {
+        float z1 = z[0], z2 = z[1];
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const float x = in[n];
+            const float y = k.b0 * x + z1;
+            z1 = k.b1 * x - k.a1 * y + z2;
+            z2 = k.b2 * x - k.a2 * y;
+            out[n] = y;
+        }
+        z[0] = z1;
+        z[1] = z2;
+    }
+
+    static void runPair (const Coefs& k, float* zl, float* zr, const float* inL, const float* inR, float* outL, float* outR, int numSamples) noexcept
+    {
+        float l1 = zl[0], l2 = zl[1], r1 = zr[0], r2 = zr[1];
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const float xl = inL[n], xr = inR[n];
+            const float yl = k.b0 * xl + l1;
+            const float yr = k.b0 * xr + r1;
+            l1 = k.b1 * xl - k.a1 * yl + l2;
+            r1 = k.b1 * xr - k.a1 * yr + r2;
+            l2 = k.b2 * xl - k.a2 * yl;
+            r2 = k.b2 * xr - k.a2 * yr;
+            outL[n] = yl;
+            outR[n] = yr;
+        }
+        zl[0] = l1;
+        zl[1] = l2;
+        zr[0] = r1;
+        zr[1] = r2;
+    }
+};
+
+} // namespace element
@@ -0,0 +1,53 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/audio_basics.hpp>
+
+namespace element {
+
+/** Fills CV buffers from a control value, ramping to new values over one
+    block so steps don't click.
+ */
+class CVRamp final
+{
+public:
+    CVRamp() = default;
+    explicit CVRamp (float initialValue) noexcept : current (initialValue) {}
+
+    /** Returns the value the last block ended on. */
+    float getCurrentValue() const noexcept { return current; }
+
+    /** Fill a block ending on target. Realtime safe.
+
+        A static value is a vector fill. A change is a linear segment where
+        each sample only depends on its index, so the loop vectorizes where
+        stepping a LinearSmoothedValue per sample can't.
+     */
+    void fill (float* dst, int numSamples, float target) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        if (target == current)
+        {
+            juce::FloatVectorOperations::fill (dst, target, numSamples);
+            return;
+        }
+
+        const float start = current;
+        const float step = (target - start) / (float) numSamples;
+        for (int i = 0; i < numSamples - 1; ++i)
+            dst[i] = start + step * (float) (i + 1);
+
+        // land exactly on the target, the next block may be a plain fill.
+        dst[numSamples - 1] = target;
+        current = target;
+    }
+
+private:
+    float current = 0.f;
+};
+
+} // namespace element
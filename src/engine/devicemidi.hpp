@@ -0,0 +1,28 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/audio_basics.hpp>
+
+namespace element {
+
+/** Implemented by audio callbacks that can exchange MIDI with the audio
+    device itself, e.g. JACK MIDI ports, without going through the
+    MidiEngine device layer.
+
+    Devices find this with a dynamic_cast of their AudioIODeviceCallback.
+ */
+class DeviceMidiCallback
+{
+public:
+    virtual ~DeviceMidiCallback() = default;
+
+    /** Called on the audio thread around each audio callback. Events in
+        `in` are for the coming block, events added to `out` are sent to
+        the device after it. Both are nullptr outside of a callback.
+     */
+    virtual void setDeviceMidi (const juce::MidiBuffer* in, juce::MidiBuffer* out) noexcept = 0;
+};
+
+} // namespace element
@@ -0,0 +1,60 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Buffers of one group of extra device ports for the current block. */
+struct DevicePortGroup
+{
+    const float* const* inputs = nullptr;
+    float* const* outputs = nullptr;
+    int numInputs = 0;
+    int numOutputs = 0;
+
+    bool isValid() const noexcept { return inputs != nullptr || outputs != nullptr; }
+};
+
+/** Implemented by audio devices that can register extra audio ports
+    outside their main channels, e.g. a group of JACK ports per graph.
+ */
+class DevicePortHost
+{
+public:
+    virtual ~DevicePortHost() = default;
+
+    /** Register a group of ports named after `name`. Message thread only.
+        Returns an id for the group, or -1 if it couldn't be registered.
+     */
+    virtual int addPortGroup (const juce::String& name, int numInputs, int numOutputs) = 0;
+
+    /** Unregister a group added with addPortGroup(). Message thread only. */
+    virtual void removePortGroup (int groupId) = 0;
+};
+
+/** Implemented by audio callbacks that can render into extra device ports.
+
+    Devices find this with a dynamic_cast of the engine's callback, see
+    JackClient::setEngineCallback().
+ */
+class DevicePortCallback
+{
+public:
+    virtual ~DevicePortCallback() = default;
+
+    /** Called on the message thread when a device that can host port groups
+        opens, and with nullptr when it closes. Groups are gone by then.
+     */
+    virtual void setDevicePortHost (DevicePortHost* host) = 0;
+
+    /** Called on the audio thread around each audio callback. `groups` is
+        indexed by group id and entries that aren't in use are invalid.
+        nullptr outside of a callback.
+     */
+    virtual void setDevicePorts (const DevicePortGroup* groups, int numGroups) noexcept = 0;
+};
+
+} // namespace element
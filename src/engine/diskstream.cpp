@@ -0,0 +1,607 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+#include <mutex>
+
+#include "engine/diskstream.hpp"
+#include "engine/threadpolicy.hpp"
+
+namespace element {
+using namespace juce;
+
+//==============================================================================
+/** I/O threads shared by all streams, alive while any stream is. */
+class DiskStream::Pool final
+{
+public:
+    Pool()
+    {
+        const int numThreads = jlimit (1, 4, SystemStats::getNumCpus() / 4);
+        for (int i = 0; i < numThreads; ++i)
+        {
+            auto* thread = threads.add (new TimeSliceThread ("Disk Stream " + String (i + 1)));
+            ThreadPolicy::prepareBackground (*thread);
+            thread->startThread();
+            loads.add (0);
+        }
+    }
+
+    ~Pool()
+    {
+        for (auto* thread : threads)
+            thread->stopThread (1000);
+    }
+
+    static std::shared_ptr<Pool> getInstance()
+    {
+        static std::mutex mutex;
+        static std::weak_ptr<Pool> instance;
+
+        const std::lock_guard<std::mutex> sl (mutex);
+        auto pool = instance.lock();
+        if (pool == nullptr)
+        {
+            pool = std::make_shared<Pool>();
+            instance = pool;
+        }
+        return pool;
+    }
+
+    /** Returns the thread serving the fewest streams. */
+    TimeSliceThread* acquire()
+    {
+        const ScopedLock sl (lock);
+        int best = 0;
+        for (int i = 1; i < loads.size(); ++i)
+            if (loads[i] < loads[best])
+                best = i;
+        loads.set (best, loads[best] + 1);
+        return threads.getUnchecked (best);
+    }
+
+    void release (TimeSliceThread* thread)
+    {
+        const ScopedLock sl (lock);
+        const int index = threads.indexOf (thread);
+        if (index >= 0)
+            loads.set (index, jmax (0, loads[index] - 1));
+    }
+
+private:
+    CriticalSection lock;
+    OwnedArray<TimeSliceThread> threads;
+    Array<int> loads;
+};
+
+//==============================================================================
+namespace detail {
+// two seconds of read-ahead at most, more than enough for a disk that
+// keeps up at all.
+static int streamCapacity (double sampleRate)
+{
+    return jlimit (16384, 1 << 20, roundToInt (sampleRate * 2.0));
+}
+
+// reads per time slice, so one stream doesn't hold up the others.
+static constexpr int maxChunk = 16384;
+} // namespace detail
+
+DiskStream::DiskStream (std::unique_ptr<AudioFormatReader> r, const File& f, bool isMapped)
+    : pool (Pool::getInstance()),
+      reader (std::move (r)),
+      file (f),
+      sampleRate (reader->sampleRate > 0.0 ? reader->sampleRate : 44100.0),
+      length (reader->lengthInSamples),
+      mapped (isMapped),
+      fifo (detail::streamCapacity (sampleRate) + 1)
+{
+    ring.setSize (2, fifo.getTotalSize());
+    ring.clear();
+
+    if (! mapped)
+    {
+        cache = SampleCache::getShared();
+        cacheKey = SampleCache::getKey (file);
+    }
+
+    // mapped files are cheap to read, start with less ahead.
+    const auto seconds = mapped ? 0.25 : 0.5;
+    readAhead.store (jmin (getCapacity(), roundToInt (sampleRate * seconds)));
+
+    thread = pool->acquire();
+    thread->addTimeSliceClient (this);
+}
+
+DiskStream::~DiskStream()
+{
+    thread->removeTimeSliceClient (this);
+    pool->release (thread);
+}
+
+std::unique_ptr<DiskStream> DiskStream::open (AudioFormatManager& formats, const File& file)
+{
+    std::unique_ptr<AudioFormatReader> reader;
+    bool mapped = false;
+
+    if (auto* format = formats.findFormatForFileExtension (file.getFileExtension()))
+    {
+        if (std::unique_ptr<MemoryMappedAudioFormatReader> mapReader { format->createMemoryMappedReader (file) })
+        {
+            if (mapReader->mapEntireFile())
+            {
+                reader = std::move (mapReader);
+                mapped = true;
+            }
+        }
+    }
+
+    if (reader == nullptr)
+        reader.reset (formats.createReaderFor (file));
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+        return nullptr;
+
+    std::unique_ptr<DiskStream> stream (new DiskStream (std::move (reader), file, mapped));
+    stream->preload (0); // where playback and loops start
+    return stream;
+}
+
+void DiskStream::preload (int64 preloadPosition)
+{
+    if (cache == nullptr || preloadPosition < 0 || preloadPosition >= length)
+        return;
+    const ScopedLock sl (producerLock);
+    cache->getBlock (cacheKey, *reader, preloadPosition / SampleCache::blockSize);
+}
+
+void DiskStream::seek (int64 newPosition) noexcept
+{
+    seekTarget.store (newPosition);
+    seekSerial.fetch_add (1, std::memory_order_release);
+}
+
+//==============================================================================
+int DiskStream::useTimeSlice()
+{
+    const ScopedLock sl (producerLock);
+    return fill();
+}
+
+size_t DiskStream::getNumBytes() const noexcept
+{
+    return sizeof (float) * (size_t) ring.getNumChannels() * (size_t) ring.getNumSamples();
+}
+
+void DiskStream::prefetch()
+{
+    const ScopedLock sl (producerLock);
+    for (int i = 0; i < 256; ++i)
+        if (fill() >= 20)
+            break;
+}
+
+int DiskStream::fill()
+{
+    const auto serial = seekSerial.load (std::memory_order_acquire);
+    if (serial != producerSerial)
+    {
+        readPosition = jlimit ((int64) 0, length, seekTarget.load());
+        producerDone.store (false);
+        producerSerial = serial;
+        seekedPosition.store (readPosition);
+        ackSerial.store (serial, std::memory_order_release);
+    }
+
+    // the audio thread throws away what's left from before the seek first.
+    if (flushSerial.load (std::memory_order_acquire) != producerSerial)
+        return 1;
+
+    if (wantsMore.exchange (false))
+        readAhead.store (jmin (getCapacity(), readAhead.load() * 2));
+
+    const int target = readAhead.load (std::memory_order_relaxed);
+    int wanted = jmin (fifo.getFreeSpace(), target - fifo.getNumReady(), detail::maxChunk);
+    if (wanted <= 0)
+        return 20;
+
+    if (readPosition >= length)
+    {
+        if (! looping.load())
+        {
+            producerDone.store (true, std::memory_order_release);
+            return 20;
+        }
+
+        readPosition = 0;
+        producerDone.store (false);
+    }
+
+    wanted = (int) jmin ((int64) wanted, length - readPosition);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (wanted, start1, size1, start2, size2);
+    if (cache != nullptr)
+    {
+        if (size1 > 0)
+            readFromCache (start1, size1, readPosition);
+        if (size2 > 0)
+            readFromCache (start2, size2, readPosition + size1);
+    }
+    else
+    {
+        if (size1 > 0)
+            reader->read (&ring, start1, size1, readPosition, true, true);
+        if (size2 > 0)
+            reader->read (&ring, start2, size2, readPosition + size1, true, true);
+    }
+    fifo.finishedWrite (size1 + size2);
+    readPosition += size1 + size2;
+
+    return fifo.getNumReady() < target / 2 ? 0 : 5;
+}
+
+void DiskStream::readFromCache (int destStart, int numSamples, int64 startPosition)
+{
+    while (numSamples > 0)
+    {
+        const auto index = startPosition / SampleCache::blockSize;
+        if (index != blockIndex)
+        {
+            block = cache->getBlock (cacheKey, *reader, index);
+            blockIndex = index;
+        }
+
+        const auto offset = (int) (startPosition - index * SampleCache::blockSize);
+        const auto available = block != nullptr ? block->getNumSamples() - offset : 0;
+        if (available <= 0)
+        {
+            ring.clear (destStart, numSamples);
+            return;
+        }
+
+        const auto num = jmin (numSamples, available);
+        for (int c = 0; c < ring.getNumChannels(); ++c)
+            ring.copyFrom (c, destStart, *block, jmin (c, block->getNumChannels() - 1), offset, num);
+
+        destStart += num;
+        startPosition += num;
+        numSamples -= num;
+    }
+}
+
+//==============================================================================
+bool DiskStream::update() noexcept
+{
+    const auto ack = ackSerial.load (std::memory_order_acquire);
+    if (ack == consumerSerial)
+        return false;
+
+    fifo.finishedRead (fifo.getNumReady());
+    position.store (seekedPosition.load());
+    finished.store (false);
+    consumerSerial = ack;
+    flushSerial.store (ack, std::memory_order_release);
+    return true;
+}
+
+bool DiskStream::locate (int64 target) noexcept
+{
+    if (isSeeking())
+        return false;
+
+    const auto current = position.load (std::memory_order_relaxed);
+    auto distance = target - current;
+    if (distance < 0 && looping.load())
+        distance += length; // ahead through the loop point
+    if (distance == 0)
+        return true;
+
+    if (distance > 0 && distance <= getCapacity())
+    {
+        // drop what's read ahead up to the target, if it isn't there yet the
+        // I/O thread keeps reading towards it.
+        const auto numDropped = (int) jmin (distance, (int64) fifo.getNumReady());
+        fifo.finishedRead (numDropped);
+
+        auto pos = current + numDropped;
+        if (pos >= length)
+            pos = looping.load() ? pos % length : length;
+        position.store (pos, std::memory_order_relaxed);
+
+        if (numDropped == distance)
+            return true;
+        if (! producerDone.load (std::memory_order_acquire))
+            return false;
+    }
+
+    seek (target);
+    return false;
+}
+
+int DiskStream::read (float* const* dest, int numChannels, int startSample, int numSamples) noexcept
+{
+    int numRead = 0;
+
+    // a seek is on its way, don't play what's left from before it.
+    if (seekSerial.load (std::memory_order_acquire) == consumerSerial)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (jmin (numSamples, fifo.getNumReady()), start1, size1, start2, size2);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            const auto* src = ring.getReadPointer (jmin (c, ring.getNumChannels() - 1));
+            if (size1 > 0)
+                FloatVectorOperations::copy (dest[c] + startSample, src + start1, size1);
+            if (size2 > 0)
+                FloatVectorOperations::copy (dest[c] + startSample + size1, src + start2, size2);
+        }
+
+        numRead = size1 + size2;
+        fifo.finishedRead (numRead);
+
+        auto pos = position.load (std::memory_order_relaxed) + numRead;
+        if (pos >= length)
+            pos = looping.load() ? pos % length : length;
+        position.store (pos, std::memory_order_relaxed);
+
+        if (numRead < numSamples)
+        {
+            if (producerDone.load (std::memory_order_acquire) && fifo.getNumReady() == 0)
+            {
+                finished.store (true, std::memory_order_relaxed);
+            }
+            else
+            {
+                underruns.fetch_add (1, std::memory_order_relaxed);
+                wantsMore.store (true);
+            }
+        }
+    }
+
+    for (int c = 0; c < numChannels; ++c)
+        FloatVectorOperations::clear (dest[c] + startSample + numRead, numSamples - numRead);
+
+    return numRead;
+}
+
+//==============================================================================
+class DiskStreamPlayer::Source final : public AudioSource
+{
+public:
+    DiskStream* stream = nullptr;
+
+    void prepareToPlay (int, double) override {}
+    void releaseResources() override {}
+
+    void getNextAudioBlock (const AudioSourceChannelInfo& info) override
+    {
+        if (stream == nullptr)
+        {
+            info.clearActiveBufferRegion();
+            return;
+        }
+
+        stream->read (info.buffer->getArrayOfWritePointers(), info.buffer->getNumChannels(),
+                      info.startSample, info.numSamples);
+    }
+};
+
+DiskStreamPlayer::DiskStreamPlayer()
+{
+    source = std::make_unique<Source>();
+    resampler = std::make_unique<ResamplingAudioSource> (source.get(), false, 2);
+}
+
+DiskStreamPlayer::~DiskStreamPlayer()
+{
+    const ScopedLock sl (lock);
+    current = pending = latest = nullptr;
+    streams.clear();
+}
+
+void DiskStreamPlayer::setStream (std::unique_ptr<DiskStream> newStream)
+{
+    auto* const stream = newStream.get();
+    if (stream != nullptr)
+    {
+        stream->setLooping (looping.load());
+        stream->prefetch();
+    }
+
+    const ScopedLock sl (lock);
+    if (stream != nullptr)
+        streams.add (newStream.release());
+
+    latest = stream;
+    if (prepared)
+    {
+        pending = stream;
+        hasPending = true;
+    }
+    else
+    {
+        current = stream;
+    }
+
+    reclaim();
+}
+
+void DiskStreamPlayer::reclaim()
+{
+    for (int i = streams.size(); --i >= 0;)
+    {
+        auto* const stream = streams.getUnchecked (i);
+        if (stream != latest.load() && stream != current.load() && stream != pending.load())
+            streams.remove (i);
+    }
+}
+
+void DiskStreamPlayer::start()
+{
+    auto* const stream = latest.load();
+    if (stream == nullptr || playing.load())
+        return;
+
+    if (stream->isFinished())
+        stream->seek (0);
+    playing = true;
+    sendChangeMessage();
+}
+
+void DiskStreamPlayer::stop()
+{
+    if (! playing.exchange (false))
+        return;
+    sendChangeMessage();
+}
+
+void DiskStreamPlayer::setPosition (double seconds)
+{
+    if (auto* const stream = latest.load())
+        stream->seek (jlimit ((int64) 0, stream->getLengthInSamples(), (int64) (seconds * stream->getSampleRate())));
+}
+
+double DiskStreamPlayer::getCurrentPosition() const
+{
+    if (auto* const stream = latest.load())
+        return (double) stream->getPosition() / stream->getSampleRate();
+    return 0.0;
+}
+
+double DiskStreamPlayer::getLengthInSeconds() const
+{
+    if (auto* const stream = latest.load())
+        return (double) stream->getLengthInSamples() / stream->getSampleRate();
+    return 0.0;
+}
+
+int64 DiskStreamPlayer::getMemoryUsage() const
+{
+    const ScopedLock sl (lock);
+    int64 total = 0;
+    for (auto* stream : streams)
+        total += (int64) stream->getNumBytes();
+    return total;
+}
+
+void DiskStreamPlayer::follow (bool shouldPlay, int64 timeInSamples) noexcept
+{
+    following = true;
+    followTime = timeInSamples;
+
+    if (auto* const stream = current.load())
+    {
+        const auto target = (double) timeInSamples * stream->getSampleRate() / outputRate;
+        if (! looping.load() && target >= (double) stream->getLengthInSamples())
+            shouldPlay = false;
+    }
+
+    if (playing.exchange (shouldPlay) != shouldPlay)
+        sendChangeMessage();
+}
+
+bool DiskStreamPlayer::followTimeline (DiskStream& stream) noexcept
+{
+    following = false;
+
+    const auto length = stream.getLengthInSamples();
+    auto target = (int64) std::floor ((double) followTime * stream.getSampleRate() / outputRate);
+    target = looping.load() ? target % length : jmin (target, length);
+    if (target < 0)
+        target += length;
+
+    // the resampler reads a little ahead of what it outputs.
+    auto drift = stream.getPosition() - target;
+    if (looping.load() && std::abs (drift) > length / 2)
+        drift -= drift > 0 ? length : -length;
+    const auto tolerance = resampling ? (int64) (stream.getSampleRate() / outputRate * 8.0) + 8 : 0;
+    if (std::abs (drift) <= tolerance && ! stream.isSeeking())
+        return true;
+
+    const bool located = stream.locate (target);
+    resampler->flushBuffers();
+    return located;
+}
+
+void DiskStreamPlayer::setLooping (bool shouldLoop)
+{
+    looping = shouldLoop;
+    if (auto* const stream = latest.load())
+        stream->setLooping (shouldLoop);
+}
+
+//==============================================================================
+void DiskStreamPlayer::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    const ScopedLock sl (lock);
+    outputRate = sampleRate;
+    resampler->prepareToPlay (samplesPerBlockExpected, sampleRate);
+    updateRatio (current.load());
+    lastGain = gain.load();
+    prepared = true;
+}
+
+void DiskStreamPlayer::releaseResources()
+{
+    const ScopedLock sl (lock);
+    prepared = false;
+    if (hasPending.exchange (false))
+        current = pending.exchange (nullptr);
+    reclaim();
+    resampler->releaseResources();
+}
+
+void DiskStreamPlayer::updateRatio (DiskStream* stream) noexcept
+{
+    resampling = stream != nullptr && stream->getSampleRate() != outputRate;
+    if (stream != nullptr)
+        resampler->setResamplingRatio (stream->getSampleRate() / outputRate);
+}
+
+void DiskStreamPlayer::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    {
+        // swap at the block boundary, a new stream waits a block if the
+        // message thread holds the lock.
+        const ScopedTryLock sl (lock);
+        if (sl.isLocked() && hasPending.exchange (false))
+        {
+            current = pending.exchange (nullptr);
+            updateRatio (current.load());
+            resampler->flushBuffers();
+        }
+    }
+
+    auto* const stream = current.load();
+    source->stream = stream;
+
+    if (stream != nullptr && stream->update())
+        resampler->flushBuffers();
+
+    const bool inStep = ! following || stream == nullptr || followTimeline (*stream);
+    if (stream == nullptr || ! playing.load() || ! inStep)
+    {
+        info.clearActiveBufferRegion();
+        lastGain = gain.load();
+        return;
+    }
+
+    if (resampling)
+        resampler->getNextAudioBlock (info);
+    else
+        source->getNextAudioBlock (info);
+
+    const auto newGain = gain.load();
+    for (int c = info.buffer->getNumChannels(); --c >= 0;)
+        info.buffer->applyGainRamp (c, info.startSample, info.numSamples, lastGain, newGain);
+    lastGain = newGain;
+
+    if (stream->isFinished())
+    {
+        playing = false;
+        sendChangeMessage();
+    }
+}
+
+} // namespace element
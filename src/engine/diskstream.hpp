@@ -0,0 +1,247 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/audio_formats.hpp>
+#include <element/juce/events.hpp>
+
+#include "engine/samplecache.hpp"
+
+namespace element {
+
+/** Streams one audio file from disk for the audio thread.
+
+    Reading happens on a small pool of I/O threads shared by every stream
+    in the process, so many players don't each need their own thread. WAV
+    and AIFF files are memory mapped where the platform allows. Samples are
+    handed to the audio thread through a single producer, single consumer
+    FIFO, and neither side ever waits for the other.
+
+    How far ahead a stream reads starts small and doubles each time the
+    audio thread finds it empty, up to getCapacity().
+
+    Files that can't be mapped, which includes every compressed format,
+    are decoded through the shared SampleCache. Streams of the same file
+    and each pass of a loop then reuse one decode.
+ */
+class DiskStream final : private juce::TimeSliceClient
+{
+public:
+    ~DiskStream() override;
+
+    /** Open a file for streaming. Returns nullptr if no format in `formats`
+        can read it. Message thread.
+     */
+    static std::unique_ptr<DiskStream> open (juce::AudioFormatManager& formats, const juce::File& file);
+
+    /** Returns the file being streamed. */
+    const juce::File& getFile() const noexcept { return file; }
+
+    /** Returns the file's sample rate. */
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    /** Returns the file's length in samples. */
+    juce::int64 getLengthInSamples() const noexcept { return length; }
+
+    /** Returns true if the file is read through a memory map. */
+    bool isMemoryMapped() const noexcept { return mapped; }
+
+    /** Returns true if the file is decoded through the SampleCache. */
+    bool isCached() const noexcept { return cache != nullptr; }
+
+    /** Decode the samples around a position into the cache ahead of time,
+        so looping or seeking there doesn't wait for the decoder. Does
+        nothing for mapped files. Message thread.
+     */
+    void preload (juce::int64 position);
+
+    /** Returns the most samples that can be read ahead. */
+    int getCapacity() const noexcept { return fifo.getTotalSize() - 1; }
+
+    /** Returns how far ahead the stream reads now. */
+    int getReadAhead() const noexcept { return readAhead.load (std::memory_order_relaxed); }
+
+    /** Returns the bytes of the read-ahead FIFO. Decoded blocks belong to
+        the SampleCache and aren't counted.
+     */
+    size_t getNumBytes() const noexcept;
+
+    /** Returns the number of times read() ran dry before the end. */
+    juce::int64 getNumUnderruns() const noexcept { return underruns.load (std::memory_order_relaxed); }
+
+    /** Set whether the stream wraps to the start at the end. Any thread. */
+    void setLooping (bool shouldLoop) noexcept { looping.store (shouldLoop); }
+    bool isLooping() const noexcept { return looping.load(); }
+
+    /** Move to a sample position. Any thread. read() returns silence until
+        the I/O thread has caught up.
+     */
+    void seek (juce::int64 position) noexcept;
+
+    /** Make the next read() start at a position without waiting for the
+        message thread. Audio thread, call after update().
+
+        Samples already read ahead are dropped to get there. A position
+        behind, or further ahead than the FIFO holds, is seeked to.
+        Returns true if the next read() starts at the position, false if
+        the I/O thread hasn't caught up yet.
+     */
+    bool locate (juce::int64 position) noexcept;
+
+    /** Returns true if a seek hasn't reached the audio thread yet. Audio thread. */
+    bool isSeeking() const noexcept { return seekSerial.load (std::memory_order_acquire) != consumerSerial; }
+
+    /** Returns the position of the next sample read() will return. Any thread. */
+    juce::int64 getPosition() const noexcept { return position.load (std::memory_order_relaxed); }
+
+    /** Returns true once read() has returned every sample of a stream that
+        isn't looping. Any thread.
+     */
+    bool isFinished() const noexcept { return finished.load (std::memory_order_relaxed); }
+
+    /** Call on the audio thread before read() on each block. Returns true
+        if a seek finished since the last call, i.e. the samples don't
+        follow on from the previous ones.
+     */
+    bool update() noexcept;
+
+    /** Read the next samples into dest, clearing any that aren't ready.
+        Realtime safe. Only one thread may read.
+
+        Returns the number of samples read.
+     */
+    int read (float* const* dest, int numChannels, int startSample, int numSamples) noexcept;
+
+    /** Fill the FIFO up to the current read-ahead right now. For tests and
+        offline rendering, message thread.
+     */
+    void prefetch();
+
+private:
+    class Pool;
+    std::shared_ptr<Pool> pool;
+    juce::TimeSliceThread* thread = nullptr;
+
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    const juce::File file;
+    double sampleRate = 44100.0;
+    juce::int64 length = 0;
+    bool mapped = false;
+
+    std::shared_ptr<SampleCache> cache;
+    juce::String cacheKey;
+    SampleCache::Block block; // I/O thread
+    juce::int64 blockIndex = -1;
+
+    juce::AbstractFifo fifo;
+    juce::AudioBuffer<float> ring;
+    std::atomic<int> readAhead { 0 };
+    std::atomic<bool> looping { false }, finished { false }, wantsMore { false };
+    std::atomic<bool> producerDone { false };
+    std::atomic<juce::int64> underruns { 0 };
+
+    // seek hand shake: requested by anyone, acknowledged by the I/O thread
+    // once it stopped writing old samples, flushed by the audio thread.
+    std::atomic<juce::int64> seekTarget { 0 }, seekedPosition { 0 };
+    std::atomic<juce::uint32> seekSerial { 0 }, ackSerial { 0 }, flushSerial { 0 };
+    juce::uint32 producerSerial = 0; // I/O thread
+    juce::uint32 consumerSerial = 0; // audio thread
+
+    juce::int64 readPosition = 0; // I/O thread
+    std::atomic<juce::int64> position { 0 };
+    juce::CriticalSection producerLock;
+
+    DiskStream (std::unique_ptr<juce::AudioFormatReader> reader, const juce::File& file, bool mapped);
+    int useTimeSlice() override;
+    int fill();
+    void readFromCache (int destStart, int numSamples, juce::int64 startPosition);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiskStream)
+};
+
+//==============================================================================
+/** Plays a DiskStream, with resampling and gain, in place of an
+    AudioTransportSource.
+
+    Streams are swapped in at block boundaries, so opening a file never
+    blocks the audio thread. Broadcasts a change when playback starts or
+    stops.
+ */
+class DiskStreamPlayer final : public juce::AudioSource,
+                               public juce::ChangeBroadcaster
+{
+public:
+    DiskStreamPlayer();
+    ~DiskStreamPlayer() override;
+
+    /** Play a new stream from the next block, or nothing if it's null.
+        Message thread.
+     */
+    void setStream (std::unique_ptr<DiskStream> newStream);
+
+    /** Returns the newest stream, or nullptr. */
+    DiskStream* getStream() const noexcept { return latest.load(); }
+
+    void start();
+    void stop();
+    bool isPlaying() const noexcept { return playing.load(); }
+
+    /** Seek to a time in seconds. Any thread. */
+    void setPosition (double seconds);
+    double getCurrentPosition() const;
+    double getLengthInSeconds() const;
+
+    void setLooping (bool shouldLoop);
+    bool isLooping() const noexcept { return looping.load(); }
+
+    /** Follow a timeline for the next block. Audio thread, before
+        getNextAudioBlock().
+
+        Starts or stops with the timeline and keeps the stream at the
+        sample `timeInSamples` lands on, at the output rate. Looping wraps
+        the timeline over the file. Out of step streams are located in the
+        block they're found, so playback stays locked to the timeline.
+     */
+    void follow (bool shouldPlay, juce::int64 timeInSamples) noexcept;
+
+    /** Returns the bytes held by the streams, including ones waiting to
+        be freed.
+     */
+    juce::int64 getMemoryUsage() const;
+
+    void setGain (float newGain) noexcept { gain.store (newGain); }
+    float getGain() const noexcept { return gain.load(); }
+
+    //==========================================================================
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock (const juce::AudioSourceChannelInfo&) override;
+
+private:
+    class Source;
+    std::unique_ptr<Source> source;
+    std::unique_ptr<juce::ResamplingAudioSource> resampler;
+
+    juce::CriticalSection lock;
+    juce::OwnedArray<DiskStream> streams;
+    std::atomic<DiskStream*> latest { nullptr }, pending { nullptr }, current { nullptr };
+    std::atomic<bool> hasPending { false }, playing { false }, looping { false };
+    std::atomic<float> gain { 1.f };
+    float lastGain = 1.f;
+    double outputRate = 44100.0;
+    bool prepared = false; // under the lock
+    bool resampling = false; // audio thread
+    bool following = false; // audio thread
+    juce::int64 followTime = 0; // audio thread
+
+    void reclaim();
+    void updateRatio (DiskStream*) noexcept;
+    bool followTimeline (DiskStream&) noexcept;
+};
+
+} // namespace element
@@ -0,0 +1,446 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <mutex>
+
+#include <element/juce/core.hpp>
+
+#if ! JUCE_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "engine/diskwriter.hpp"
+#include "engine/threadpolicy.hpp"
+
+namespace element {
+using namespace juce;
+
+//==============================================================================
+/** Writer threads shared by all recordings, alive while any recording is. */
+class DiskWriter::Pool final
+{
+public:
+    Pool()
+    {
+        const int numThreads = jlimit (1, 2, SystemStats::getNumCpus() / 4);
+        for (int i = 0; i < numThreads; ++i)
+        {
+            auto* thread = threads.add (new TimeSliceThread ("Disk Writer " + String (i + 1)));
+            ThreadPolicy::prepareBackground (*thread);
+            thread->startThread();
+            loads.add (0);
+        }
+    }
+
+    ~Pool()
+    {
+        for (auto* thread : threads)
+            thread->stopThread (1000);
+    }
+
+    static std::shared_ptr<Pool> getInstance()
+    {
+        static std::mutex mutex;
+        static std::weak_ptr<Pool> instance;
+
+        const std::lock_guard<std::mutex> sl (mutex);
+        auto pool = instance.lock();
+        if (pool == nullptr)
+        {
+            pool = std::make_shared<Pool>();
+            instance = pool;
+        }
+        return pool;
+    }
+
+    /** Returns the thread serving the fewest recordings. */
+    TimeSliceThread* acquire()
+    {
+        const ScopedLock sl (lock);
+        int best = 0;
+        for (int i = 1; i < loads.size(); ++i)
+            if (loads[i] < loads[best])
+                best = i;
+        loads.set (best, loads[best] + 1);
+        return threads.getUnchecked (best);
+    }
+
+    void release (TimeSliceThread* thread)
+    {
+        const ScopedLock sl (lock);
+        const int index = threads.indexOf (thread);
+        if (index >= 0)
+            loads.set (index, jmax (0, loads[index] - 1));
+    }
+
+private:
+    CriticalSection lock;
+    OwnedArray<TimeSliceThread> threads;
+    Array<int> loads;
+};
+
+//==============================================================================
+/** A buffered file stream that reserves disk space ahead of its writes.
+
+    Space is reserved a step at a time without changing the file's size,
+    so the formats' writers see an ordinary file. On close the file is
+    truncated to what was written, which frees the reservation left over.
+    Windows has no reservation and writes through a FileOutputStream.
+ */
+class DiskWriter::Stream final : public OutputStream
+{
+public:
+    Stream (const File& file, int64 bytesPerStep)
+        : reserveStep (jmax ((int64) 0, bytesPerStep))
+    {
+#if JUCE_WINDOWS
+        file.deleteFile();
+        output = std::make_unique<FileOutputStream> (file);
+        if (output->failedToOpen())
+            output.reset();
+#else
+        fd = ::open (file.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        buffer.malloc (bufferSize);
+        if (fd >= 0 && reserveStep > 0)
+            reserveTo (reserveStep);
+#endif
+    }
+
+    ~Stream() override
+    {
+#if ! JUCE_WINDOWS
+        if (fd < 0)
+            return;
+        flushBuffer();
+        if (reserved > length)
+            ignoreUnused (::ftruncate (fd, (off_t) length));
+        ::close (fd);
+#endif
+    }
+
+    bool openedOk() const noexcept
+    {
+#if JUCE_WINDOWS
+        return output != nullptr;
+#else
+        return fd >= 0;
+#endif
+    }
+
+    bool isReserved() const noexcept { return reserved > 0; }
+
+    void flush() override
+    {
+#if JUCE_WINDOWS
+        output->flush();
+#else
+        flushBuffer();
+#endif
+    }
+
+    int64 getPosition() override
+    {
+#if JUCE_WINDOWS
+        return output->getPosition();
+#else
+        return position;
+#endif
+    }
+
+    bool setPosition (int64 newPosition) override
+    {
+#if JUCE_WINDOWS
+        return output->setPosition (newPosition);
+#else
+        if (newPosition == position)
+            return true;
+        if (! flushBuffer() || ::lseek (fd, (off_t) newPosition, SEEK_SET) < 0)
+            return false;
+        position = newPosition;
+        return true;
+#endif
+    }
+
+    bool write (const void* data, size_t numBytes) override
+    {
+#if JUCE_WINDOWS
+        return output->write (data, numBytes);
+#else
+        if (fd < 0)
+            return false;
+
+        if (reserveStep > 0 && position + (int64) numBytes > reserved)
+            reserveTo (position + (int64) numBytes + reserveStep);
+
+        if (numUsed + numBytes > bufferSize && ! flushBuffer())
+            return false;
+
+        if (numBytes >= bufferSize)
+        {
+            if (! writeAll (static_cast<const char*> (data), numBytes))
+                return false;
+        }
+        else
+        {
+            memcpy (buffer + numUsed, data, numBytes);
+            numUsed += numBytes;
+        }
+
+        position += (int64) numBytes;
+        length = jmax (length, position);
+        return true;
+#endif
+    }
+
+private:
+#if JUCE_WINDOWS
+    std::unique_ptr<FileOutputStream> output;
+#else
+    static constexpr size_t bufferSize = 1 << 16;
+    int fd = -1;
+    HeapBlock<char> buffer;
+    size_t numUsed = 0;
+    int64 position = 0, length = 0;
+#endif
+    int64 reserveStep;
+    int64 reserved = 0;
+
+#if ! JUCE_WINDOWS
+    void reserveTo (int64 size)
+    {
+#if JUCE_LINUX || JUCE_BSD
+#ifdef FALLOC_FL_KEEP_SIZE
+        if (::fallocate (fd, FALLOC_FL_KEEP_SIZE, 0, (off_t) size) == 0)
+            reserved = size;
+        else
+            reserveStep = 0; // not supported by this file system
+#else
+        ignoreUnused (size);
+        reserveStep = 0;
+#endif
+#elif JUCE_MAC || JUCE_IOS
+        fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t) (size - reserved), 0 };
+        if (::fcntl (fd, F_PREALLOCATE, &store) < 0)
+        {
+            // no contiguous run that long, take it in pieces.
+            store.fst_flags = F_ALLOCATEALL;
+            if (::fcntl (fd, F_PREALLOCATE, &store) < 0)
+            {
+                reserveStep = 0;
+                return;
+            }
+        }
+        reserved = size;
+#else
+        ignoreUnused (size);
+        reserveStep = 0;
+#endif
+    }
+
+    bool writeAll (const char* data, size_t numBytes)
+    {
+        while (numBytes > 0)
+        {
+            const auto n = ::write (fd, data, numBytes);
+            if (n <= 0)
+                return false;
+            data += n;
+            numBytes -= (size_t) n;
+        }
+        return true;
+    }
+
+    bool flushBuffer()
+    {
+        const bool ok = writeAll (buffer, numUsed);
+        numUsed = 0;
+        return ok;
+    }
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE (Stream)
+};
+
+//==============================================================================
+namespace detail {
+// writes per time slice, so one recording doesn't hold up the others.
+static constexpr int maxChunk = 16384;
+
+static std::unique_ptr<AudioFormat> createFormat (DiskWriter::Format format)
+{
+    switch (format)
+    {
+        case DiskWriter::wav:
+            return std::make_unique<WavAudioFormat>();
+        case DiskWriter::aiff:
+            return std::make_unique<AiffAudioFormat>();
+        case DiskWriter::flac:
+#if JUCE_USE_FLAC
+            return std::make_unique<FlacAudioFormat>();
+#else
+            break;
+#endif
+    }
+    return nullptr;
+}
+} // namespace detail
+
+String DiskWriter::getFileExtension (Format format)
+{
+    switch (format)
+    {
+        case wav:
+            return ".wav";
+        case aiff:
+            return ".aiff";
+        case flac:
+            return ".flac";
+    }
+    return {};
+}
+
+std::unique_ptr<DiskWriter> DiskWriter::create (const File& file, const Options& options)
+{
+    auto format = detail::createFormat (options.format);
+    if (format == nullptr || options.numChannels <= 0 || options.sampleRate <= 0.0)
+        return nullptr;
+
+    const auto bytesPerSecond = options.sampleRate * options.numChannels * (options.bitsPerSample / 8);
+    auto stream = std::make_unique<Stream> (file, (int64) (options.reserveSeconds * bytesPerSecond));
+    if (! stream->openedOk())
+        return nullptr;
+
+    std::unique_ptr<AudioFormatWriter> writer (format->createWriterFor (stream.get(),
+                                                                        options.sampleRate,
+                                                                        (unsigned int) options.numChannels,
+                                                                        options.bitsPerSample,
+                                                                        {},
+                                                                        0));
+    if (writer == nullptr)
+    {
+        stream.reset();
+        file.deleteFile();
+        return nullptr;
+    }
+
+    return std::unique_ptr<DiskWriter> (new DiskWriter (std::move (writer), stream.release(), file, options));
+}
+
+DiskWriter::DiskWriter (std::unique_ptr<AudioFormatWriter> w, Stream* s, const File& f, const Options& options)
+    : pool (Pool::getInstance()),
+      stream (s),
+      writer (std::move (w)),
+      file (f),
+      numChannels (options.numChannels),
+      sampleRate (options.sampleRate),
+      fifo (jmax (detail::maxChunk, roundToInt (options.sampleRate * options.bufferSeconds)) + 1)
+{
+    ring.setSize (numChannels, fifo.getTotalSize());
+    ring.clear();
+    channels.calloc ((size_t) numChannels + 1);
+
+    thread = pool->acquire();
+    thread->addTimeSliceClient (this);
+}
+
+DiskWriter::~DiskWriter()
+{
+    thread->removeTimeSliceClient (this);
+    pool->release (thread);
+
+    const ScopedLock sl (writerLock);
+    while (drain (detail::maxChunk) > 0)
+        continue;
+    writer.reset(); // finishes the header and closes the stream
+}
+
+bool DiskWriter::isReserved() const noexcept
+{
+    return stream != nullptr && stream->isReserved();
+}
+
+size_t DiskWriter::getNumBytes() const noexcept
+{
+    return sizeof (float) * (size_t) ring.getNumChannels() * (size_t) ring.getNumSamples();
+}
+
+bool DiskWriter::write (const float* const* data, int numIns, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return true;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (ch < numIns)
+        {
+            if (size1 > 0)
+                ring.copyFrom (ch, start1, data[ch], size1);
+            if (size2 > 0)
+                ring.copyFrom (ch, start2, data[ch] + size1, size2);
+        }
+        else
+        {
+            if (size1 > 0)
+                ring.clear (ch, start1, size1);
+            if (size2 > 0)
+                ring.clear (ch, start2, size2);
+        }
+    }
+
+    fifo.finishedWrite (size1 + size2);
+
+    if (size1 + size2 < numSamples)
+    {
+        overflows.fetch_add (1, std::memory_order_relaxed);
+        dropped.fetch_add (numSamples - (size1 + size2), std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+int DiskWriter::useTimeSlice()
+{
+    const ScopedLock sl (writerLock);
+    // straight back while there's more than a chunk waiting.
+    return drain (detail::maxChunk) >= detail::maxChunk ? 0 : 20;
+}
+
+void DiskWriter::flush()
+{
+    const ScopedLock sl (writerLock);
+    while (drain (detail::maxChunk) > 0)
+        continue;
+    writer->flush();
+}
+
+int DiskWriter::drain (int maxSamples)
+{
+    if (writer == nullptr)
+        return 0;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (jmin (maxSamples, fifo.getNumReady()), start1, size1, start2, size2);
+
+    auto writeBlock = [this] (int start, int numSamples) {
+        if (numSamples <= 0)
+            return;
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch] = ring.getReadPointer (ch, start);
+        if (! writer->writeFromFloatArrays (channels, numChannels, numSamples))
+            failed.store (true, std::memory_order_relaxed);
+    };
+
+    writeBlock (start1, size1);
+    writeBlock (start2, size2);
+    fifo.finishedRead (size1 + size2);
+    written.fetch_add (size1 + size2, std::memory_order_relaxed);
+    return size1 + size2;
+}
+
+} // namespace element
@@ -0,0 +1,121 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/audio_formats.hpp>
+
+namespace element {
+
+/** Records audio from the audio thread to one file on disk.
+
+    The audio thread copies each block into a large FIFO and never waits,
+    a small pool of writer threads shared by every recording in the
+    process encodes and writes it. When the disk falls so far behind that
+    the FIFO is full, the block's remaining samples are dropped and
+    counted, the recording goes on.
+
+    Where the platform allows, disk space is reserved ahead of the writes
+    so the file's extents are allocated up front, and whatever wasn't used
+    is given back when the file closes.
+ */
+class DiskWriter final : private juce::TimeSliceClient
+{
+public:
+    enum Format
+    {
+        wav = 0,
+        aiff,
+        flac
+    };
+
+    struct Options
+    {
+        Format format = wav;
+        int bitsPerSample = 24;
+        double sampleRate = 44100.0;
+        int numChannels = 2;
+        double bufferSeconds = 4.0; ///< how far the disk may fall behind
+        double reserveSeconds = 300.0; ///< space reserved at a time
+    };
+
+    /** Closes the file once everything written has reached it. */
+    ~DiskWriter() override;
+
+    /** Create a file and start a recording into it. Returns nullptr if the
+        file can't be created or the format can't write these options.
+        Message thread.
+     */
+    static std::unique_ptr<DiskWriter> create (const juce::File& file, const Options& options);
+
+    /** Returns the file extension of a format, with the dot. */
+    static juce::String getFileExtension (Format format);
+
+    /** Returns the file being written. */
+    const juce::File& getFile() const noexcept { return file; }
+
+    int getNumChannels() const noexcept { return numChannels; }
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    /** Queue a block for writing. Audio thread, realtime safe. Channels
+        past numChannels are ignored, missing ones are written as silence.
+
+        Returns false if the FIFO was too full to take all of it.
+     */
+    bool write (const float* const* data, int numChannels, int numSamples) noexcept;
+
+    /** Returns the number of blocks that didn't fit in the FIFO. */
+    juce::int64 getNumOverflows() const noexcept { return overflows.load (std::memory_order_relaxed); }
+
+    /** Returns the number of samples dropped by overflows. */
+    juce::int64 getNumDropped() const noexcept { return dropped.load (std::memory_order_relaxed); }
+
+    /** Returns the number of samples written to the file so far. */
+    juce::int64 getNumWritten() const noexcept { return written.load (std::memory_order_relaxed); }
+
+    /** Returns true if disk space was reserved for the file. */
+    bool isReserved() const noexcept;
+
+    /** Returns true if the file couldn't be written to. */
+    bool hasFailed() const noexcept { return failed.load (std::memory_order_relaxed); }
+
+    /** Returns the bytes of the FIFO. */
+    size_t getNumBytes() const noexcept;
+
+    /** Write everything queued so far to the file now. For tests and
+        offline rendering, message thread.
+     */
+    void flush();
+
+private:
+    class Pool;
+    class Stream;
+    std::shared_ptr<Pool> pool;
+    juce::TimeSliceThread* thread = nullptr;
+
+    Stream* stream = nullptr; // owned by writer
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    const juce::File file;
+    const int numChannels;
+    const double sampleRate;
+
+    juce::AbstractFifo fifo;
+    juce::AudioBuffer<float> ring;
+    juce::HeapBlock<const float*> channels; // writer thread
+    juce::CriticalSection writerLock;
+
+    std::atomic<juce::int64> overflows { 0 }, dropped { 0 }, written { 0 };
+    std::atomic<bool> failed { false };
+
+    DiskWriter (std::unique_ptr<juce::AudioFormatWriter>, Stream*, const juce::File&, const Options&);
+    int useTimeSlice() override;
+    int drain (int maxSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiskWriter)
+};
+
+} // namespace element
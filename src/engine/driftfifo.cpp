@@ -0,0 +1,192 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+
+#include "engine/driftfifo.hpp"
+
+namespace element {
+using namespace juce;
+
+namespace {
+// the measured fill is smoothed over a few dozen blocks before it steers
+// the ratio. The loop follows a change of drift in a few seconds, damped
+// so it doesn't overshoot much, and holds the fill with no offset once
+// the integral has found the drift.
+constexpr double smoothing = 0.02;
+constexpr double bandwidth = 0.5; // radians per second
+constexpr double damping = 0.7;
+constexpr double jitterSeconds = 0.002; // callbacks run this late or early
+
+inline float hermite (float xm1, float x0, float x1, float x2, float t) noexcept
+{
+    const float c1 = 0.5f * (x1 - xm1);
+    const float c2 = xm1 - 2.5f * x0 + 2.f * x1 - 0.5f * x2;
+    const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+    return ((c3 * t + c2) * t + c1) * t + x0;
+}
+} // namespace
+
+void DriftFifo::prepare (int numChannels, int maxBlock, double newWriterRate, double readerRate)
+{
+    writerRate = newWriterRate > 0.0 ? newWriterRate : 44100.0;
+    nominal = readerRate > 0.0 ? writerRate / readerRate : 1.0;
+    maxBlock = jmax (1, maxBlock);
+
+    // a block from either side, what the curve reads ahead, and room for
+    // callbacks that don't run exactly on time.
+    const int perRead = (int) std::ceil (maxBlock * nominal * (1.0 + maxCorrection)) + 4;
+    target = maxBlock + perRead + (int) std::ceil (jitterSeconds * writerRate);
+    capacity = nextPowerOfTwo (4 * target);
+    proportional = 2.0 * damping * bandwidth / writerRate;
+    integralGain = bandwidth * bandwidth / (writerRate * readerRate);
+    maxSince = 2.0 * (double) maxBlock / writerRate + jitterSeconds;
+    buffer.setSize (jmax (1, numChannels), capacity, false, true, false);
+    reset();
+}
+
+void DriftFifo::reset() noexcept
+{
+    buffer.clear();
+    sequence.store (0);
+    written.store (0);
+    writtenAt.store (0.0);
+    consumed.store (0);
+    ratio.store (nominal);
+    underruns.store (0);
+    overruns.store (0);
+    fraction = 0.0;
+    level = (double) target;
+    integral = 0.0;
+    filling = true;
+}
+
+int DriftFifo::getNumReady() const noexcept
+{
+    return (int) (written.load (std::memory_order_acquire) - consumed.load (std::memory_order_acquire));
+}
+
+void DriftFifo::write (const float* const* data, int numChannels, int numSamples, double seconds) noexcept
+{
+    const auto start = written.load (std::memory_order_relaxed);
+    const int space = capacity - (int) (start - consumed.load (std::memory_order_acquire));
+    if (numSamples > space)
+    {
+        overruns.fetch_add (1, std::memory_order_relaxed);
+        numSamples = jmax (0, space);
+    }
+
+    const int mask = capacity - 1;
+    const int index = (int) (start & mask);
+    const int first = jmin (numSamples, capacity - index);
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        auto* const dest = buffer.getWritePointer (ch);
+        if (ch < numChannels && data[ch] != nullptr)
+        {
+            FloatVectorOperations::copy (dest + index, data[ch], first);
+            FloatVectorOperations::copy (dest, data[ch] + first, numSamples - first);
+        }
+        else
+        {
+            FloatVectorOperations::clear (dest + index, first);
+            FloatVectorOperations::clear (dest, numSamples - first);
+        }
+    }
+
+    const auto seq = sequence.load (std::memory_order_relaxed);
+    sequence.store (seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    writtenAt.store (seconds, std::memory_order_relaxed);
+    written.store (start + numSamples, std::memory_order_relaxed);
+    sequence.store (seq + 2, std::memory_order_release);
+}
+
+void DriftFifo::read (float* const* data, int numChannels, int numSamples, double seconds) noexcept
+{
+    auto silence = [&]() {
+        for (int ch = 0; ch < numChannels; ++ch)
+            FloatVectorOperations::clear (data[ch], numSamples);
+    };
+
+    int64 end = 0;
+    double endAt = 0.0;
+    for (;;)
+    {
+        const auto seq = sequence.load (std::memory_order_acquire);
+        end = written.load (std::memory_order_relaxed);
+        endAt = writtenAt.load (std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if ((seq & 1) == 0 && seq == sequence.load (std::memory_order_relaxed))
+            break;
+    }
+
+    auto start = consumed.load (std::memory_order_relaxed);
+    int ready = (int) (end - start);
+
+    // where the writer's clock is now, between its callbacks. Nothing is
+    // extrapolated before the first write.
+    const double since = end > 0 ? jlimit (0.0, maxSince, seconds - endAt) : 0.0;
+    double fill = (double) ready + since * writerRate - fraction;
+
+    if (filling)
+    {
+        if (fill < (double) target)
+            return silence();
+
+        // start exactly at the target, the surplus is never heard.
+        const int skip = jmin (ready, (int) (fill - (double) target));
+        start += skip;
+        ready -= skip;
+        fill -= (double) skip;
+        filling = false;
+        level = fill;
+    }
+
+    // steer the ratio to hold the fill at the target. The integral stops
+    // while the correction is at its limit so it doesn't wind up.
+    level += smoothing * (fill - level);
+    const double error = level - (double) target;
+    const double wanted = proportional * error + integral;
+    if (std::abs (wanted) < maxCorrection || (wanted > 0.0) != (error > 0.0))
+        integral = jlimit (-maxCorrection, maxCorrection, integral + integralGain * error * numSamples);
+    const double correction = jlimit (-maxCorrection, maxCorrection, proportional * error + integral);
+    const double step = nominal * (1.0 + correction);
+    ratio.store (step, std::memory_order_relaxed);
+
+    // frame `start` is the one before the first read, for the curve.
+    if ((int) (fraction + (double) (numSamples - 1) * step) + 4 > ready)
+    {
+        underruns.fetch_add (1, std::memory_order_relaxed);
+        filling = true;
+        consumed.store (start, std::memory_order_release);
+        return silence();
+    }
+
+    const int mask = capacity - 1;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* const out = data[ch];
+        if (ch >= buffer.getNumChannels())
+        {
+            FloatVectorOperations::clear (out, numSamples);
+            continue;
+        }
+
+        const float* const x = buffer.getReadPointer (ch);
+        double t = fraction;
+        for (int i = 0; i < numSamples; ++i, t += step)
+        {
+            const auto whole = (int64) t;
+            const auto frame = start + whole;
+            out[i] = hermite (x[frame & mask], x[(frame + 1) & mask], x[(frame + 2) & mask], x[(frame + 3) & mask], (float) (t - (double) whole));
+        }
+    }
+
+    const double next = fraction + (double) numSamples * step;
+    const auto advance = (int64) next;
+    fraction = next - (double) advance;
+    consumed.store (start + advance, std::memory_order_release);
+}
+
+} // namespace element
@@ -0,0 +1,101 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Moves audio from one device's callback to another's when their clocks
+    don't quite agree.
+
+    One thread writes whole blocks, another reads. The reader resamples by
+    a ratio that is steered to keep the FIFO at a steady fill, so a clock
+    a few hundred ppm fast or slow is followed without ever running dry
+    or over. Each write is timestamped and the fill is measured where the
+    writer's clock would be when the reader runs, so blocks of different
+    sizes don't make it jump. Reading interpolates with a 4-point Hermite
+    curve, plenty for ratios this close to one. Lock free, realtime safe
+    on both sides.
+ */
+class DriftFifo final
+{
+public:
+    /** The most a clock may be corrected, as a fraction of its rate. */
+    static constexpr double maxCorrection = 0.002;
+
+    DriftFifo() = default;
+
+    /** Allocate for blocks of up to maxBlock frames each side, between
+        devices at these nominal rates. Not realtime safe.
+     */
+    void prepare (int numChannels, int maxBlock, double writerRate, double readerRate);
+
+    /** Empty the FIFO and start filling again. Call while neither side
+        is running.
+     */
+    void reset() noexcept;
+
+    /** Add a block. Frames that don't fit are dropped and counted. Writer
+        thread. Pass the time in seconds, or use the overload that reads
+        the clock.
+     */
+    void write (const float* const* data, int numChannels, int numSamples, double seconds) noexcept;
+    void write (const float* const* data, int numChannels, int numSamples) noexcept { write (data, numChannels, numSamples, now()); }
+
+    /** Fill a block, silence until the FIFO first fills or after it runs
+        dry. Reader thread.
+     */
+    void read (float* const* data, int numChannels, int numSamples, double seconds) noexcept;
+    void read (float* const* data, int numChannels, int numSamples) noexcept { read (data, numChannels, numSamples, now()); }
+
+    /** Returns frames written and not read yet. */
+    int getNumReady() const noexcept;
+
+    /** Returns the frames the reader keeps buffered. */
+    int getTarget() const noexcept { return target; }
+
+    /** Returns the reader's current ratio, writer frames per reader frame. */
+    double getRatio() const noexcept { return ratio.load (std::memory_order_relaxed); }
+
+    /** Returns how often the reader ran dry. */
+    int getNumUnderruns() const noexcept { return underruns.load (std::memory_order_relaxed); }
+
+    /** Returns how often the writer found it full. */
+    int getNumOverruns() const noexcept { return overruns.load (std::memory_order_relaxed); }
+
+    int getNumChannels() const noexcept { return buffer.getNumChannels(); }
+
+private:
+    juce::AudioBuffer<float> buffer;
+    int capacity = 0, target = 0;
+    double nominal = 1.0, writerRate = 0.0;
+    double proportional = 0.0, integralGain = 0.0; // per frame of error, and per frame read
+    double maxSince = 0.0; // seconds the writer's clock is followed past a write
+
+    // the writer's count and when it was reached, published as a pair
+    // behind a sequence number that's odd while they change.
+    std::atomic<juce::uint32> sequence { 0 };
+    std::atomic<juce::int64> written { 0 };
+    std::atomic<double> writtenAt { 0.0 };
+
+    std::atomic<juce::int64> consumed { 0 }; // whole frames, reader owned
+    std::atomic<double> ratio { 1.0 };
+    std::atomic<int> underruns { 0 }, overruns { 0 };
+
+    // reader
+    double fraction = 0.0;
+    double level = 0.0; // smoothed fill
+    double integral = 0.0;
+    bool filling = true;
+
+    static double now() noexcept { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+
+    JUCE_DECLARE_NON_COPYABLE (DriftFifo)
+};
+
+} // namespace element
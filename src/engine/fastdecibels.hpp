@@ -0,0 +1,51 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <cmath>
+#include <cstring>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Approximate decibel conversions for per sample gain math.
+
+    log2 and exp2 split off the float exponent and fit the rest with a
+    quartic, which is within 0.001 dB of the real thing and has no calls
+    or branches for the compiler to trip over in a loop.
+ */
+struct FastDecibels
+{
+    static float log2 (float x) noexcept
+    {
+        x = juce::jmax (x, 1.0e-30f);
+        juce::uint32 bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+        const auto exponent = (float) ((int) ((bits >> 23) & 0xff) - 127);
+        bits = (bits & 0x007fffff) | 0x3f800000;
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+        return exponent + (-2.49835315f + (4.02921139f + (-2.07833517f + (0.626032182f - 0.0784406762f * m) * m) * m) * m);
+    }
+
+    static float exp2 (float x) noexcept
+    {
+        x = juce::jlimit (-126.f, 126.f, x);
+        const float whole = std::floor (x);
+        const float f = x - whole;
+        const auto bits = (juce::uint32) ((int) whole + 127) << 23;
+        float scale;
+        std::memcpy (&scale, &bits, sizeof (scale));
+        return scale * (1.00000349f + (0.692972922f + (0.241604357f + (0.0517449978f + 0.0136703095f * f) * f) * f) * f);
+    }
+
+    /** Returns a positive gain in decibels. */
+    static float gainToDecibels (float gain) noexcept { return log2 (gain) * 6.02059991f; }
+
+    /** Returns the gain for a level in decibels. */
+    static float decibelsToGain (float dB) noexcept { return exp2 (dB * 0.166096405f); }
+};
+
+} // namespace element
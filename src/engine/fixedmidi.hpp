@@ -0,0 +1,107 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+
+#include <element/juce/audio_basics.hpp>
+
+namespace element {
+
+/** Adds MIDI to the graph's rendering buffers without growing them.
+
+    Every MIDI buffer a rendering sequence owns is reserved to capacity
+    bytes when the sequence is built. Copies and mixes on the render path
+    go through here and only add an event while it still fits. Anything
+    that doesn't is dropped and counted, so a burst of sysex or dense CCs
+    never allocates on the audio thread. Events that did fit keep their
+    order and timing.
+ */
+class FixedMidi final
+{
+public:
+    /** Bytes reserved per buffer, about 1000 short messages. */
+    static constexpr int capacity = 8192;
+
+    /** Reserve a buffer's storage. Not realtime safe. */
+    static void reserve (juce::MidiBuffer& buffer) { buffer.ensureSize ((size_t) capacity); }
+
+    /** Add one event if it fits. Returns false if it was dropped. */
+    static bool add (juce::MidiBuffer& dst, const void* data, int numBytes, int frame) noexcept
+    {
+        if (numBytes <= 0)
+            return false;
+
+        if (dst.data.size() + eventHeaderSize + numBytes > capacity)
+        {
+            dropped.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+
+        dst.addEvent (data, numBytes, frame);
+        return true;
+    }
+
+    /** Add the events of src from start, for count frames (or all if count is
+        negative), moved by offset. Returns the number that were dropped.
+     */
+    static int add (juce::MidiBuffer& dst, const juce::MidiBuffer& src, int start, int count, int offset) noexcept
+    {
+        int numDropped = 0;
+        for (auto iter = src.findNextSamplePosition (start); iter != src.cend(); ++iter)
+        {
+            const auto ev = *iter;
+            if (count >= 0 && ev.samplePosition >= start + count)
+                break;
+            if (! add (dst, ev.data, ev.numBytes, ev.samplePosition + offset))
+                ++numDropped;
+        }
+        return numDropped;
+    }
+
+    /** Replace dst's events with those in src. */
+    static int copy (juce::MidiBuffer& dst, const juce::MidiBuffer& src) noexcept
+    {
+        dst.clear();
+        return add (dst, src, 0, -1, 0);
+    }
+
+    /** Scale every event's frame by multiply / divide, in place. Used when
+        a buffer moves between sample rates. Nothing is copied or reordered,
+        the mapping never decreases so events stay sorted.
+     */
+    static void remap (juce::MidiBuffer& buffer, int multiply, int divide) noexcept
+    {
+        jassert (multiply > 0 && divide > 0);
+        auto* d = buffer.data.begin();
+        auto* const end = buffer.data.end();
+        while (d < end)
+        {
+            juce::int32 frame;
+            std::memcpy (&frame, d, sizeof (frame));
+            frame = (juce::int32) ((juce::int64) frame * multiply / divide);
+            std::memcpy (d, &frame, sizeof (frame));
+
+            juce::uint16 numBytes;
+            std::memcpy (&numBytes, d + sizeof (juce::int32), sizeof (numBytes));
+            d += eventHeaderSize + numBytes;
+        }
+    }
+
+    /** Returns the number of events dropped since the last reset. */
+    static juce::int64 getNumDropped() noexcept { return dropped.load (std::memory_order_relaxed); }
+
+    /** Reset the dropped event counter. */
+    static void resetNumDropped() noexcept { dropped.store (0, std::memory_order_relaxed); }
+
+private:
+    // timestamp and size stored ahead of each event's bytes.
+    static constexpr int eventHeaderSize = (int) (sizeof (juce::int32) + sizeof (juce::uint16));
+    inline static std::atomic<juce::int64> dropped { 0 };
+
+    FixedMidi() = delete;
+};
+
+} // namespace element
@@ -0,0 +1,54 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+namespace element {
+
+/** Hands whole frames from one thread to another without locks.
+
+    Three frames: the writer fills one, the reader shows another and the
+    third holds the newest published frame. Publishing and taking swap a
+    frame with the middle one, so neither side waits and a slow reader only
+    ever skips to the latest frame.
+ */
+template <typename Frame>
+class FrameMailbox final
+{
+public:
+    /** Returns the frame to fill. Writer thread. */
+    Frame& getWriteFrame() noexcept { return frames[writeIndex]; }
+
+    /** Make the written frame the newest. Writer thread. */
+    void publish() noexcept
+    {
+        writeIndex = middle.exchange (writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Take the newest frame if one was published since the last call.
+        Returns nullptr otherwise. Reader thread.
+     */
+    const Frame* take() noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & freshBit) == 0)
+            return nullptr;
+        readIndex = middle.exchange (readIndex, std::memory_order_acq_rel) & indexMask;
+        return &frames[readIndex];
+    }
+
+    /** Returns the frame last taken. Reader thread. */
+    const Frame& getReadFrame() const noexcept { return frames[readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshBit = 4;
+
+    Frame frames[3];
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> middle { 2 };
+};
+
+} // namespace element
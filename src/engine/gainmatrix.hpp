@@ -0,0 +1,123 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <vector>
+
+#include "matrixstate.hpp"
+
+namespace element {
+
+/** An audio routing matrix with a gain per patch.
+
+    Built on the message thread from a MatrixState and a gain for each cell,
+    rendered on the audio thread. Only patches with a non zero gain are
+    kept, listed per output, so a sparse matrix costs one vector operation
+    per patch and an empty output is a clear. Unity gains use plain copies
+    and adds. Blocks are mixed in chunks short enough for every input of a
+    large matrix to stay in cache while its outputs are summed.
+ */
+class GainMatrix final
+{
+public:
+    /** Samples mixed per pass over the outputs. */
+    static constexpr int chunkSize = 256;
+
+    /** Create a matrix. `gains` holds one gain per cell, indexed like
+        MatrixState::getIndexForCell(). nullptr means unity everywhere.
+     */
+    explicit GainMatrix (const MatrixState& patches, const float* gains = nullptr)
+        : numIns (patches.getNumRows()),
+          numOuts (patches.getNumColumns())
+    {
+        offsets.reserve ((size_t) numOuts + 1);
+        for (int out = 0; out < numOuts; ++out)
+        {
+            offsets.push_back ((int) entries.size());
+            for (int in = 0; in < numIns; ++in)
+            {
+                if (! patches.connected (in, out))
+                    continue;
+                const float gain = gains != nullptr ? gains[patches.getIndexForCell (in, out)] : 1.f;
+                if (gain != 0.f)
+                    entries.push_back ({ in, gain });
+            }
+        }
+        offsets.push_back ((int) entries.size());
+    }
+
+    int getNumInputs() const noexcept { return numIns; }
+    int getNumOutputs() const noexcept { return numOuts; }
+
+    /** Returns the number of patches with a non zero gain. */
+    int getNumPatches() const noexcept { return (int) entries.size(); }
+
+    bool sameSizeAs (const GainMatrix& other) const noexcept
+    {
+        return numIns == other.numIns && numOuts == other.numOuts;
+    }
+
+    /** Returns the gain from an input to an output, zero if not patched. */
+    float getGain (int in, int out) const noexcept
+    {
+        if (! isPositiveAndBelow (out, numOuts))
+            return 0.f;
+        for (int i = offsets[(size_t) out]; i < offsets[(size_t) out + 1]; ++i)
+            if (entries[(size_t) i].input == in)
+                return entries[(size_t) i].gain;
+        return 0.f;
+    }
+
+    /** Mix inputs to outputs, replacing what the outputs held. Outputs must
+        not alias inputs. Realtime safe.
+     */
+    void process (const float* const* inputs, float* const* outputs, int numSamples) const noexcept
+    {
+        const auto* const first = entries.data();
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int num = jmin (chunkSize, numSamples - start);
+            for (int out = 0; out < numOuts; ++out)
+            {
+                float* const dst = outputs[out] + start;
+                const auto* e = first + offsets[(size_t) out];
+                const auto* const end = first + offsets[(size_t) out + 1];
+
+                if (e == end)
+                {
+                    FloatVectorOperations::clear (dst, num);
+                    continue;
+                }
+
+                const float* src = inputs[e->input] + start;
+                if (e->gain == 1.f)
+                    FloatVectorOperations::copy (dst, src, num);
+                else
+                    FloatVectorOperations::copyWithMultiply (dst, src, e->gain, num);
+
+                for (++e; e != end; ++e)
+                {
+                    src = inputs[e->input] + start;
+                    if (e->gain == 1.f)
+                        FloatVectorOperations::add (dst, src, num);
+                    else
+                        FloatVectorOperations::addWithMultiply (dst, src, e->gain, num);
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        int input;
+        float gain;
+    };
+
+    int numIns = 0, numOuts = 0;
+    std::vector<Entry> entries;
+    std::vector<int> offsets;
+};
+
+} // namespace element
@@ -0,0 +1,123 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <cmath>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Gain ramp kernels that measure the signal in the same pass.
+
+    Each returns the sum of squares of the samples it read, so a meter
+    costs nothing beyond the mix itself. Like SignalLevel, four independent
+    accumulators let the compiler keep the loops in vector registers
+    without reassociating float math.
+ */
+struct GainRamp
+{
+    /** Add src to dst, ramping gain from start to end over the block.
+        Returns the sum of squares of src. Realtime safe.
+     */
+    static float add (float* dst, const float* src, int numSamples, float start, float end) noexcept
+    {
+        if (numSamples <= 0)
+            return 0.f;
+
+        const float step = (end - start) / (float) numSamples;
+        float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+
+        int i = 0;
+        if (step == 0.f)
+        {
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const float a = src[i], b = src[i + 1], c = src[i + 2], d = src[i + 3];
+                s0 += a * a;
+                s1 += b * b;
+                s2 += c * c;
+                s3 += d * d;
+                dst[i] += a * start;
+                dst[i + 1] += b * start;
+                dst[i + 2] += c * start;
+                dst[i + 3] += d * start;
+            }
+        }
+        else
+        {
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const float g = start + step * (float) i;
+                const float a = src[i], b = src[i + 1], c = src[i + 2], d = src[i + 3];
+                s0 += a * a;
+                s1 += b * b;
+                s2 += c * c;
+                s3 += d * d;
+                dst[i] += a * g;
+                dst[i + 1] += b * (g + step);
+                dst[i + 2] += c * (g + step * 2.f);
+                dst[i + 3] += d * (g + step * 3.f);
+            }
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            s0 += src[i] * src[i];
+            dst[i] += src[i] * (start + step * (float) i);
+        }
+
+        return s0 + s1 + s2 + s3;
+    }
+
+    /** Copy src to dst, ramping gain from start to end over the block.
+        Returns the sum of squares of dst. Realtime safe.
+     */
+    static float copy (float* dst, const float* src, int numSamples, float start, float end) noexcept
+    {
+        if (numSamples <= 0)
+            return 0.f;
+
+        const float step = (end - start) / (float) numSamples;
+        float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float g = start + step * (float) i;
+            const float a = src[i] * g;
+            const float b = src[i + 1] * (g + step);
+            const float c = src[i + 2] * (g + step * 2.f);
+            const float d = src[i + 3] * (g + step * 3.f);
+            dst[i] = a;
+            dst[i + 1] = b;
+            dst[i + 2] = c;
+            dst[i + 3] = d;
+            s0 += a * a;
+            s1 += b * b;
+            s2 += c * c;
+            s3 += d * d;
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            dst[i] = src[i] * (start + step * (float) i);
+            s0 += dst[i] * dst[i];
+        }
+
+        return s0 + s1 + s2 + s3;
+    }
+
+    /** Constant power pan gains for a stereo pair, unity at the centre.
+        pan runs from -1 (left) to 1 (right).
+     */
+    static void panGains (float pan, float& left, float& right) noexcept
+    {
+        const float angle = (juce::jlimit (-1.f, 1.f, pan) + 1.f) * juce::MathConstants<float>::pi * 0.25f;
+        left = std::cos (angle) * juce::MathConstants<float>::sqrt2;
+        right = std::sin (angle) * juce::MathConstants<float>::sqrt2;
+    }
+};
+
+} // namespace element
@@ -0,0 +1,197 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <vector>
+
+#include "engine/gainramp.hpp"
+
+namespace element {
+
+/** Implemented by processors that only scale and mix their audio inputs.
+
+    The processing is a fixed set of taps, each an input feeding an output
+    through a gain that ramps over the block. GraphBuilder folds a stage
+    like this into the copies and adds that gather its inputs, so a chain
+    of trims and mixes costs one pass over each buffer.
+ */
+class GainStage
+{
+public:
+    struct Tap
+    {
+        int input;
+        int output;
+    };
+
+    virtual ~GainStage() = default;
+
+    /** Returns the taps. Fixed for the life of the processor. */
+    virtual const std::vector<Tap>& getGainTaps() const noexcept = 0;
+
+    /** Advance the stage a block and write each tap's gain at its start and
+        end. Called on the audio thread in place of processBlock().
+     */
+    virtual void nextGains (int numSamples, float* start, float* end) noexcept = 0;
+};
+
+//==============================================================================
+/** Renders a GainStage straight from the buffers that feed it.
+
+    Each input channel lists the shared buffers summed into it, and each
+    output the shared buffer it is written to. Outputs are written in turn.
+    When one would overwrite a buffer a later tap still reads, the outputs
+    are mixed in short chunks through scratch space instead.
+ */
+class FusedGain final
+{
+public:
+    /** Samples mixed per chunk when outputs overlap their sources. */
+    static constexpr int chunkSize = 256;
+
+    /** Prepare for a stage. sources holds the buffers of each input, outputs
+        the buffer of each output. Not realtime safe.
+     */
+    FusedGain (const std::vector<GainStage::Tap>& taps,
+               const std::vector<std::vector<int>>& sources,
+               const std::vector<int>& outputs)
+        : numTaps ((int) taps.size()),
+          outputBuffers (outputs)
+    {
+        offsets.reserve (outputs.size() + 1);
+        for (int out = 0; out < (int) outputs.size(); ++out)
+        {
+            offsets.push_back ((int) paths.size());
+            const auto first = paths.size();
+            for (int t = 0; t < numTaps; ++t)
+            {
+                if (taps[(size_t) t].output != out)
+                    continue;
+                for (auto buffer : sources[(size_t) taps[(size_t) t].input])
+                {
+                    // a path reading the output's own buffer goes first, so
+                    // it's read before the output is written.
+                    if (buffer == outputs[(size_t) out])
+                        paths.insert (paths.begin() + (std::ptrdiff_t) first, { t, buffer });
+                    else
+                        paths.push_back ({ t, buffer });
+                }
+            }
+        }
+        offsets.push_back ((int) paths.size());
+
+        // writing an output is only safe if no path after its first reads
+        // the buffer it's written to.
+        for (int out = 0; out < (int) outputs.size(); ++out)
+            for (int p = offsets[(size_t) out] + 1; p < (int) paths.size(); ++p)
+                if (paths[(size_t) p].buffer == outputs[(size_t) out])
+                    chunked = true;
+
+        if (chunked)
+            scratch.resize (outputs.size() * (size_t) chunkSize);
+    }
+
+    int getNumTaps() const noexcept { return numTaps; }
+
+    /** True if outputs are mixed through scratch space. */
+    bool isChunked() const noexcept { return chunked; }
+
+    /** Mix a block. silence holds a flag per shared buffer, paths from
+        silent buffers are skipped and the outputs' flags are updated.
+        Realtime safe.
+     */
+    void process (float* const* buffers, juce::uint8* silence, const float* start, const float* end, int numSamples) noexcept
+    {
+        if (chunked)
+        {
+            for (int done = 0; done < numSamples; done += chunkSize)
+                processChunk (buffers, silence, start, end, done, juce::jmin (chunkSize, numSamples - done), numSamples);
+        }
+        else
+        {
+            for (int out = 0; out < (int) outputBuffers.size(); ++out)
+            {
+                auto* const dst = buffers[outputBuffers[(size_t) out]];
+                const bool wrote = mix (dst, out, buffers, silence, start, end, 0, numSamples, numSamples);
+                if (! wrote)
+                    juce::FloatVectorOperations::clear (dst, numSamples);
+                setSilent (silence, outputBuffers[(size_t) out], ! wrote);
+            }
+        }
+    }
+
+private:
+    struct Path
+    {
+        int tap;
+        int buffer;
+    };
+
+    const int numTaps;
+    std::vector<int> outputBuffers;
+    std::vector<Path> paths;
+    std::vector<int> offsets;
+    std::vector<float> scratch;
+    bool chunked = false;
+
+    static void setSilent (juce::uint8* silence, int buffer, bool isSilent) noexcept
+    {
+        // buffer 0 is the shared zero buffer, its flag never changes.
+        if (buffer > 0)
+            silence[buffer] = isSilent ? 1 : 0;
+    }
+
+    /** Mix the paths of one output into dst over [offset, offset + count) of
+        a block numSamples long. Returns false if nothing was written.
+     */
+    bool mix (float* dst, int out, const float* const* buffers, const juce::uint8* silence, const float* start, const float* end, int offset, int count, int numSamples) const noexcept
+    {
+        bool wrote = false;
+        for (int p = offsets[(size_t) out]; p < offsets[(size_t) out + 1]; ++p)
+        {
+            const auto& path = paths[(size_t) p];
+            const float g0 = start[path.tap], g1 = end[path.tap];
+            if (silence[path.buffer] || (g0 == 0.f && g1 == 0.f))
+                continue;
+
+            const float step = (g1 - g0) / (float) numSamples;
+            const float from = g0 + step * (float) offset;
+            const float to = g0 + step * (float) (offset + count);
+            const float* src = buffers[path.buffer] + offset;
+            if (wrote)
+                GainRamp::add (dst, src, count, from, to);
+            else
+                GainRamp::copy (dst, src, count, from, to);
+            wrote = true;
+        }
+        return wrote;
+    }
+
+    void processChunk (float* const* buffers, juce::uint8* silence, const float* start, const float* end, int offset, int count, int numSamples) noexcept
+    {
+        const int numOuts = (int) outputBuffers.size();
+        bool wrote[16] {};
+        jassert (numOuts <= 16);
+
+        // every output is mixed before any is written back.
+        for (int out = 0; out < numOuts; ++out)
+            wrote[out] = mix (scratch.data() + out * chunkSize, out, buffers, silence, start, end, offset, count, numSamples);
+
+        for (int out = 0; out < numOuts; ++out)
+        {
+            auto* const dst = buffers[outputBuffers[(size_t) out]] + offset;
+            if (wrote[out])
+                juce::FloatVectorOperations::copy (dst, scratch.data() + out * chunkSize, count);
+            else
+                juce::FloatVectorOperations::clear (dst, count);
+        }
+
+        // flags change only after the last chunk has read them.
+        if (offset + count >= numSamples)
+            for (int out = 0; out < numOuts; ++out)
+                setSilent (silence, outputBuffers[(size_t) out], ! wrote[out]);
+    }
+};
+
+} // namespace element
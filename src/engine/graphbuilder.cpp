@@ -1,14 +1,26 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <algorithm>
+#include <typeinfo>
+
 #include <element/atombuffer.hpp>
 #include <element/symbolmap.hpp>
 #include <element/processor.hpp>
 
-#include "engine/miditranspose.hpp"
+#include "engine/cvramp.hpp"
+#include "engine/fixedmidi.hpp"
+#include "engine/gainstage.hpp"
+#include "engine/midifilterstage.hpp"
+#include "engine/parameterqueue.hpp"
 #include "engine/graphnode.hpp"
 #include "engine/graphbuilder.hpp"
 #include "engine/ionode.hpp"
+#include "engine/rendertrace.hpp"
+#include "engine/signalguard.hpp"
+#include "engine/signallevel.hpp"
+#include "nodes/audioprocessor.hpp"
+#include "nodes/auxbus.hpp"
 
 #ifndef EL_TRACE_GRAPH_OPS
 #define EL_TRACE_GRAPH_OPS 0
@@ -24,22 +36,21 @@ class ApplyParamToCVOp : public GraphOp
 {
 public:
     ApplyParamToCVOp (ParameterPtr src, int _cvIndex)
-        : param (src), cvIndex (std::max (0, _cvIndex))
+        : param (src), ramp (param->getValue()), cvIndex (std::max (0, _cvIndex))
     {
-        value.setCurrentAndTargetValue (param->getValue());
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override { b.audio.add (cvIndex); }
+
     void perform (AudioSampleBuffer& buffer, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int nframes) override
     {
-        value.setTargetValue (param->getValue());
-        auto ptr = buffer.getWritePointer (cvIndex);
-        for (int f = 0; f < nframes; ++f)
-            ptr[f] = value.getNextValue();
+        // the buffer comes from the shared pool, so it's filled every block.
+        ramp.fill (buffer.getWritePointer (cvIndex), nframes, param->getValue());
     }
 
 private:
     ParameterPtr param;
-    LinearSmoothedValue<float> value;
+    CVRamp ramp;
     int cvIndex = 0;
 };
 
@@ -50,7 +61,7 @@ public:
     BindParameterOp (ParameterPtr src, ParameterPtr dst)
         : param1 (src), param2 (dst)
     {
-        param1->addListener (this);
+        param1->addRealtimeListener (this);
     }
 
     ~BindParameterOp()
@@ -92,11 +103,15 @@ public:
         return str.toStdString();
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.atom.add (srcBufferNum);
+        b.atom.add (dstBufferNum);
+    }
+
     void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const SharedAtom& atom, const int)
     {
-        auto dst = atom.getUnchecked (dstBufferNum);
-        dst->clear();
-        dst->add (*atom.getUnchecked (srcBufferNum));
+        atom.getUnchecked (dstBufferNum)->copyFrom (*atom.getUnchecked (srcBufferNum));
     }
 
 private:
@@ -105,23 +120,41 @@ private:
     JUCE_DECLARE_NON_COPYABLE (CopyAtomBufferOp)
 };
 
+/** Merges every atom source of a port into its buffer in one pass. */
 class AddAtomBufferOp : public GraphOp
 {
 public:
-    AddAtomBufferOp (const int srcBufferNum_, const int dstBufferNum_)
-        : srcBufferNum (srcBufferNum_),
+    AddAtomBufferOp (const Array<int>& srcBufferNums_, const int dstBufferNum_)
+        : srcBufferNums (srcBufferNums_),
           dstBufferNum (dstBufferNum_)
     {
+        sources.insertMultiple (0, nullptr, srcBufferNums.size());
+    }
+
+    std::string traceStep() const noexcept override
+    {
+        String str;
+        str << "AddAtomBuffer: " << srcBufferNums.size() << " buffers to " << dstBufferNum;
+        return str.toStdString();
+    }
+
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.atom.addArray (srcBufferNums);
+        b.atom.add (dstBufferNum);
     }
 
-    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const SharedAtom& atom, const int numSamples)
+    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const SharedAtom& atom, const int)
     {
-        atom.getUnchecked (dstBufferNum)
-            ->add (*atom.getUnchecked (srcBufferNum)); // TODO: -> , 0, numSamples, 0);
+        for (int i = 0; i < srcBufferNums.size(); ++i)
+            sources.setUnchecked (i, atom.getUnchecked (srcBufferNums.getUnchecked (i)));
+        atom.getUnchecked (dstBufferNum)->merge (sources.getRawDataPointer(), sources.size());
     }
 
 private:
-    const int srcBufferNum, dstBufferNum;
+    const Array<int> srcBufferNums;
+    const int dstBufferNum;
+    Array<const AtomBuffer*> sources;
 
     JUCE_DECLARE_NON_COPYABLE (AddAtomBufferOp)
 };
@@ -141,6 +174,8 @@ public:
         return str.toStdString();
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override { b.atom.add (bufferIdx); }
+
     void perform (SharedAudio&, const SharedMidi&, const SharedAtom& atom, const int numSamples) override
     {
         atom.getUnchecked (bufferIdx)->clear (0, numSamples);
@@ -160,6 +195,12 @@ public:
         return str.toStdString();
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.midi.add (_midiIdx);
+        b.atom.add (_atomIdx);
+    }
+
     void perform (SharedAudio&, const SharedMidi& midi, const SharedAtom& atom, const int) override
     {
         atom.getUnchecked (_atomIdx)->add (*midi.getUnchecked (_midiIdx));
@@ -184,6 +225,12 @@ public:
         return str.toStdString();
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.atom.add (_atomIdx);
+        b.midi.add (_midiIdx);
+    }
+
     void perform (SharedAudio&, const SharedMidi& midi, const SharedAtom& atom, const int nframes) override
     {
         auto seq = atom.getUnchecked (_atomIdx)->sequence();
@@ -195,9 +242,10 @@ public:
                 break;
             if (ev->body.type != midi_MidiEvent)
                 continue;
-            mb->addEvent (LV2_ATOM_BODY (&ev->body),
-                          ev->body.size,
-                          static_cast<int> (ev->time.frames));
+            FixedMidi::add (*mb,
+                            LV2_ATOM_BODY (&ev->body),
+                            (int) ev->body.size,
+                            static_cast<int> (ev->time.frames));
         }
     }
 
@@ -215,11 +263,22 @@ public:
     {
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override { b.audio.add (channelNum); }
+
     void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
     {
         sharedBufferChans.clear (channelNum, 0, numSamples);
     }
 
+    GraphInstruction decode() noexcept override
+    {
+        GraphInstruction inst;
+        inst.code = GraphInstruction::clearAudio;
+        inst.dst = channelNum;
+        inst.op = this;
+        return inst;
+    }
+
 private:
     const int channelNum;
 
@@ -235,11 +294,30 @@ public:
     {
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.audio.add (srcChannelNum);
+        b.audio.add (dstChannelNum);
+    }
+
     void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
     {
         sharedBufferChans.copyFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    GraphInstruction decode() noexcept override
+    {
+        GraphInstruction inst;
+        inst.code = GraphInstruction::copyAudio;
+        inst.src = srcChannelNum;
+        inst.dst = dstChannelNum;
+        inst.op = this;
+        return inst;
+    }
+
+    int getSource() const noexcept { return srcChannelNum; }
+    int getDestination() const noexcept { return dstChannelNum; }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -255,11 +333,27 @@ public:
     {
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.audio.add (srcChannelNum);
+        b.audio.add (dstChannelNum);
+    }
+
     void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
     {
         sharedBufferChans.addFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    GraphInstruction decode() noexcept override
+    {
+        GraphInstruction inst;
+        inst.code = GraphInstruction::addAudio;
+        inst.src = srcChannelNum;
+        inst.dst = dstChannelNum;
+        inst.op = this;
+        return inst;
+    }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -274,11 +368,22 @@ public:
     {
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override { b.midi.add (bufferNum); }
+
     void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int)
     {
         sharedMidiBuffers.getUnchecked (bufferNum)->clear();
     }
 
+    GraphInstruction decode() noexcept override
+    {
+        GraphInstruction inst;
+        inst.code = GraphInstruction::clearMidi;
+        inst.dst = bufferNum;
+        inst.op = this;
+        return inst;
+    }
+
 private:
     const int bufferNum;
 
@@ -295,9 +400,26 @@ public:
     {
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.midi.add (srcBufferNum);
+        b.midi.add (dstBufferNum);
+    }
+
     void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int)
     {
-        *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
+        FixedMidi::copy (*sharedMidiBuffers.getUnchecked (dstBufferNum),
+                         *sharedMidiBuffers.getUnchecked (srcBufferNum));
+    }
+
+    GraphInstruction decode() noexcept override
+    {
+        GraphInstruction inst;
+        inst.code = GraphInstruction::copyMidi;
+        inst.src = srcBufferNum;
+        inst.dst = dstBufferNum;
+        inst.op = this;
+        return inst;
     }
 
 private:
@@ -315,10 +437,29 @@ public:
     {
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.midi.add (srcBufferNum);
+        b.midi.add (dstBufferNum);
+    }
+
     void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int numSamples)
     {
-        sharedMidiBuffers.getUnchecked (dstBufferNum)
-            ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
+        FixedMidi::add (*sharedMidiBuffers.getUnchecked (dstBufferNum),
+                        *sharedMidiBuffers.getUnchecked (srcBufferNum),
+                        0,
+                        numSamples,
+                        0);
+    }
+
+    GraphInstruction decode() noexcept override
+    {
+        GraphInstruction inst;
+        inst.code = GraphInstruction::addMidi;
+        inst.src = srcBufferNum;
+        inst.dst = dstBufferNum;
+        inst.op = this;
+        return inst;
     }
 
 private:
@@ -327,52 +468,150 @@ private:
     JUCE_DECLARE_NON_COPYABLE (AddMidiBufferOp)
 };
 
+/** Delays one or more channels by the same number of samples.
+
+    Each channel keeps its history in a ring long enough to take a whole
+    block, so a block is written and read back with at most two contiguous
+    copies each way instead of a per sample loop. Channels delayed by the
+    same amount share one op, one history buffer and one write position.
+    A channel can also be delayed from a different source channel, which
+    folds away the copy that would otherwise fill it. The ring has room to
+    spare, so a latency change can retune the delay in place.
+ */
 class DelayChannelOp : public GraphOp
 {
 public:
     DelayChannelOp (const int channel_, const int numSamplesDelay_)
-        : channel (channel_),
-          bufferSize (numSamplesDelay_ + 1),
-          readIndex (0),
-          writeIndex (numSamplesDelay_)
+        : DelayChannelOp (Array<int> (channel_), Array<int> (channel_), numSamplesDelay_) {}
+
+    DelayChannelOp (const Array<int>& sources_, const Array<int>& channels_, const int numSamplesDelay_)
+        : sources (sources_),
+          channels (channels_),
+          delay (numSamplesDelay_),
+          maxDelay (numSamplesDelay_ + jmax (numSamplesDelay_, minHeadroom)),
+          ringSize (maxDelay + maxBlockSize)
     {
-        buffer.calloc ((size_t) bufferSize);
+        jassert (sources.size() == channels.size());
+        jassert (delay > 0);
+        history.setSize (channels.size(), ringSize);
+        history.clear();
+        fade.setSize (1, maxBlockSize);
+        nextDelay.store (delay);
     }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
+    int getDelay() const noexcept { return nextDelay.load (std::memory_order_relaxed); }
+
+    /** Returns true if the ring can hold a delay. */
+    bool canDelay (int newDelay) const noexcept { return newDelay > 0 && newDelay <= maxDelay; }
+
+    /** Change the delay while rendering. The output crossfades to it over
+        the next block. Returns false if the ring can't hold it.
+     */
+    bool setDelay (int newDelay) noexcept
+    {
+        if (! canDelay (newDelay))
+            return false;
+        nextDelay.store (newDelay, std::memory_order_relaxed);
+        return true;
+    }
+    int getNumChannels() const noexcept { return channels.size(); }
+    int getChannel (int index) const noexcept { return channels.getUnchecked (index); }
+    int getSource (int index) const noexcept { return sources.getUnchecked (index); }
+
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.audio.addArray (sources);
+        b.audio.addArray (channels);
+    }
+
+    size_t getNumBytes() const noexcept override
     {
-        float* data = sharedBufferChans.getWritePointer (channel, 0);
+        return sizeof (float) * (size_t) (history.getNumChannels() * history.getNumSamples() + fade.getNumSamples());
+    }
 
-        for (int i = numSamples; --i >= 0;)
+    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
+    {
+        // blocks longer than the ring's spare room are done in chunks.
+        for (int offset = 0; offset < numSamples;)
         {
-            buffer[writeIndex] = *data;
-            *data++ = buffer[readIndex];
+            const int count = std::min (numSamples - offset, maxBlockSize);
+            const int target = nextDelay.load (std::memory_order_relaxed);
+            const int readPos = (writePos + ringSize - delay) % ringSize;
+            const int targetPos = (writePos + ringSize - target) % ringSize;
+
+            for (int ch = channels.size(); --ch >= 0;)
+            {
+                float* const ring = history.getWritePointer (ch);
+                float* const dst = sharedBufferChans.getWritePointer (channels.getUnchecked (ch), offset);
+                write (ring, sharedBufferChans.getReadPointer (sources.getUnchecked (ch), offset), count);
+                if (target == delay)
+                {
+                    read (ring, readPos, dst, count);
+                    continue;
+                }
+
+                // the ring holds both, so the old and new delay fade over.
+                float* const from = fade.getWritePointer (0);
+                read (ring, readPos, from, count);
+                read (ring, targetPos, dst, count);
+                for (int i = 0; i < count; ++i)
+                {
+                    const float g = (float) (i + 1) / (float) count;
+                    dst[i] = from[i] + g * (dst[i] - from[i]);
+                }
+            }
 
-            if (++readIndex >= bufferSize)
-                readIndex = 0;
-            if (++writeIndex >= bufferSize)
-                writeIndex = 0;
+            delay = target;
+            writePos = (writePos + count) % ringSize;
+            offset += count;
         }
     }
 
 private:
-    HeapBlock<float> buffer;
-    const int channel, bufferSize;
-    int readIndex, writeIndex;
+    // matches the frames GraphNode allocates for its rendering buffers.
+    static constexpr int maxBlockSize = 4096;
+    // room to grow without a rebuild when a plugin's latency changes.
+    static constexpr int minHeadroom = 2048;
+
+    const Array<int> sources, channels;
+    int delay;
+    const int maxDelay, ringSize;
+    std::atomic<int> nextDelay { 0 };
+    AudioSampleBuffer history, fade;
+    int writePos = 0;
+
+    void write (float* ring, const float* src, int count) const noexcept
+    {
+        const int first = std::min (count, ringSize - writePos);
+        FloatVectorOperations::copy (ring + writePos, src, first);
+        if (first < count)
+            FloatVectorOperations::copy (ring, src + first, count - first);
+    }
+
+    void read (const float* ring, int pos, float* dst, int count) const noexcept
+    {
+        const int first = std::min (count, ringSize - pos);
+        FloatVectorOperations::copy (dst, ring + pos, first);
+        if (first < count)
+            FloatVectorOperations::copy (dst + first, ring, count - first);
+    }
 
     JUCE_DECLARE_NON_COPYABLE (DelayChannelOp)
 };
 
-class ProcessBufferOp : public GraphOp
+class ProcessBufferOp : public GraphOp,
+                        private Parameter::Listener
 {
 public:
     ProcessBufferOp (const ProcessorPtr& node_,
                      const int totalChans_,
                      const int totalCV_,
                      const int midiBufferToUse_,
-                     const Array<int> chans[PortType::Unknown])
+                     const Array<int> chans[PortType::Unknown],
+                     const Array<int>& borrowedMidi)
         : node (node_),
           processor (node_->getAudioPluginInstance()),
+          pluginNode (dynamic_cast<AudioProcessorNode*> (node_.get())),
           audioChannelsToUse (chans[PortType::Audio]),
           cvChannelsToUse (chans[PortType::CV]),
           midiChannelsToUse (chans[PortType::Midi]),
@@ -381,6 +620,10 @@ public:
           totalCV (std::max (1, totalCV_)),
           numAudioIns (node_->getNumPorts (PortType::Audio, true)),
           numAudioOuts (node_->getNumPorts (PortType::Audio, false)),
+          numCVIns (node_->getNumPorts (PortType::CV, true)),
+          numCVOuts (node_->getNumPorts (PortType::CV, false)),
+          numMidiIns (node_->getNumPorts (PortType::Midi, true)),
+          numAtomIns (node_->getNumPorts (PortType::Atom, true)),
           midiBufferToUse (midiBufferToUse_)
     {
         channels.calloc ((size_t) totalChans);
@@ -392,18 +635,76 @@ public:
             cvChannelsToUse.add (0);
 
         if (midiChannelsToUse.size() > 0)
+        {
             midiBufferToUse = midiChannelsToUse.getFirst();
+            for (int i = 0; i < midiChannelsToUse.size(); ++i)
+            {
+                // Borrowed inputs are still read by later nodes, so this one
+                // works on its own copy of them.
+                const bool borrowed = borrowedMidi.contains (i);
+                midiSlots.add (borrowed ? borrowedSlot : sharedSlot);
+                ownedMidi.add (borrowed ? new MidiBuffer() : nullptr);
+            }
+        }
         else
-            midiChannelsToUse.add (midiBufferToUse);
+        {
+            // Nodes without MIDI ports get a private scratch buffer so they
+            // never touch a shared one. This keeps them independent of other
+            // nodes when the graph is rendered in parallel.
+            midiChannelsToUse.add (0);
+            midiSlots.add (privateSlot);
+            ownedMidi.add (new MidiBuffer());
+        }
+
+        for (auto* mb : ownedMidi)
+            if (mb != nullptr)
+                FixedMidi::reserve (*mb);
+        midiBuffers.calloc ((size_t) midiChannelsToUse.size());
 
         if (atomChannelsToUse.isEmpty())
             atomChannelsToUse.add (0);
+        // the pipes refer to these spans when a node has more event ports
+        // than they hold inline.
+        atomBuffers.calloc ((size_t) atomChannelsToUse.size());
+
+        if (node->wantsContext())
+        {
+            renderFns[0] = &ProcessBufferOp::renderNode<true, false>;
+            renderFns[1] = &ProcessBufferOp::renderNode<true, true>;
+        }
+        else
+        {
+            jassert (processor != nullptr);
+            renderFns[0] = &ProcessBufferOp::renderNode<false, false>;
+            renderFns[1] = &ProcessBufferOp::renderNode<false, true>;
+        }
 
         lastMute = node->isMuted();
+        // IO nodes move data in and out of the graph, they never sleep.
+        canSleep = dynamic_cast<IONode*> (node.get()) == nullptr;
+        // nor are they bypassed for bad input, and a graph's nodes are
+        // guarded on their own.
+        canFaultBypass = canSleep && ! node->isGraph();
 
         osChanSize = totalChans;
         osChans.reset (new float*[osChanSize]);
-        tempMidi.ensureSize (128);
+        // swapped with shared buffers, so it needs the same capacity.
+        FixedMidi::reserve (tempMidi);
+
+        if (node->wantsParameterEvents())
+        {
+            paramQueue = std::make_unique<ParameterQueue>();
+            paramEvents = std::make_unique<ParameterEvents>();
+            params = node->getParameters (true);
+            for (auto* param : params)
+                param->addRealtimeListener (this);
+        }
+    }
+
+    ~ProcessBufferOp()
+    {
+        for (auto* param : params)
+            param->removeListener (this);
     }
 
     void perform (SharedAudio& sharedBufferChans,
@@ -411,25 +712,66 @@ public:
                   const SharedAtom& sharedAtomBuffers,
                   const int numSamples) override
     {
-        for (int i = totalChans; --i >= 0;)
-            channels[i] = sharedBufferChans.getWritePointer (audioChannelsToUse.getUnchecked (i), 0);
-        for (int i = totalCV; --i >= 0;)
-            cv[i] = sharedBufferChans.getWritePointer (cvChannelsToUse.getUnchecked (i), 0);
+        // the shared buffers belong to the sequence and only move when it's
+        // rebuilt, so the tables are resolved once rather than every block.
+        if (sharedBufferChans.getReadPointer (0) != resolvedFor)
+        {
+            for (int i = totalChans; --i >= 0;)
+                channels[i] = sharedBufferChans.getWritePointer (audioChannelsToUse.getUnchecked (i), 0);
+            for (int i = totalCV; --i >= 0;)
+                cv[i] = sharedBufferChans.getWritePointer (cvChannelsToUse.getUnchecked (i), 0);
+            resolvedFor = sharedBufferChans.getReadPointer (0);
+        }
+
+        for (int i = midiChannelsToUse.size(); --i >= 0;)
+        {
+            auto* const shared = sharedMidiBuffers.getUnchecked (midiChannelsToUse.getUnchecked (i));
+            if (auto* const own = ownedMidi.getUnchecked (i))
+            {
+                own->clear();
+                // copy on write: only events are copied, and only when there are some.
+                if (midiSlots.getUnchecked (i) == borrowedSlot && ! shared->isEmpty())
+                    FixedMidi::add (*own, *shared, 0, -1, 0);
+                midiBuffers[i] = own;
+            }
+            else
+            {
+                midiBuffers[i] = shared;
+            }
+        }
+
+        for (int i = atomChannelsToUse.size(); --i >= 0;)
+            atomBuffers[i] = sharedAtomBuffers.getUnchecked (atomChannelsToUse.getUnchecked (i));
 
         // clang-format off
         RenderContext context (channels, totalChans, cv, totalCV, 
-                               sharedMidiBuffers, midiChannelsToUse, 
-                               sharedAtomBuffers, atomChannelsToUse,
+                               midiBuffers, midiChannelsToUse.size(), 
+                               atomBuffers, atomChannelsToUse.size(),
                                numSamples);
         // clang-format on
 
-        if (! node->isEnabled())
+        if (! node->isEnabled() || node->isPreparing())
         {
             for (int ch = numAudioIns; ch < numAudioOuts; ++ch)
+            {
                 context.audio.clear (ch, 0, numSamples);
+                markSilent (audioChannelsToUse.getUnchecked (ch), true);
+            }
+            return;
+        }
+
+        const int tailSamples = canSleep ? node->getTailLengthSamples() : -1;
+        const bool inputsSilent = tailSamples >= 0 && areInputsSilent (sharedMidiBuffers, sharedAtomBuffers);
+        if (inputsSilent && quietSamples > tailSamples)
+        {
+            sleep (context, sharedAtomBuffers, numSamples);
             return;
         }
 
+        RenderTrace::record (RenderTrace::opBegin, node->nodeId, numSamples);
+        const bool profiling = node->isProfilingEnabled();
+        const auto startTicks = profiling ? Time::getHighResolutionTicks() : 0;
+
         const bool muted = node->isMuted();
         const bool muteInput = node->isMutingInputs();
 
@@ -460,207 +802,601 @@ public:
             context.audio.applyGain (0, numSamples, node->getInputGain());
         }
 
-        for (int i = numAudioIns; --i >= 0;)
-            node->setInputRMS (i, context.audio.getRMSLevel (i, 0, numSamples));
+        const bool metering = node->isMetering();
+        if (metering)
+            for (int i = numAudioIns; --i >= 0;)
+                node->setInputRMS (i, SignalLevel::measure (context.audio.getReadPointer (i), numSamples).rms);
 
         // Begin MIDI filters
         {
-            jassert (tempMidi.getNumEvents() == 0);
-            ScopedLock spl (node->getPropertyLock());
-            transpose.setNoteOffset (node->getTransposeOffset());
-            const auto keyRange (node->getKeyRange());
-            const auto midiChans (node->getMidiChannels());
-            const auto useMidiProgram (node->areMidiProgramsEnabled());
-
-            if (keyRange.getLength() > 0 || ! midiChans.isOmni() || useMidiProgram)
+            const auto filter = node->getMidiFilter();
+            if (filter.keyRange != lastFilter.keyRange || filter.transpose != lastFilter.transpose
+                || filter.channels != lastFilter.channels || filter.programsEnabled != lastFilter.programsEnabled)
+            {
+                lastFilter = filter;
+                // an empty range has always meant no key filtering.
+                if (filter.keyRange.getLength() > 0)
+                    midiFilter.setKeyRange (filter.keyRange.getStart(), filter.keyRange.getEnd());
+                else
+                    midiFilter.setKeyRange (0, 127);
+                midiFilter.setChannels (filter.channels);
+                midiFilter.setTranspose (filter.transpose);
+                midiFilter.setConsumePrograms (filter.programsEnabled);
+            }
+
+            if (! midiFilter.isPassthrough())
             {
+                int program = -1;
                 for (int i = 0; i < context.midi.getNumBuffers(); ++i)
                 {
-                    auto& midi = *context.midi.getWriteBuffer (i);
-                    for (auto m : midi)
-                    {
-                        auto msg = m.getMessage();
-                        if (msg.isNoteOnOrOff())
-                        {
-                            // out of range
-                            if (keyRange.getLength() > 0 && (msg.getNoteNumber() < keyRange.getStart() || msg.getNoteNumber() > keyRange.getEnd()))
-                                continue;
-                        }
+                    const int last = midiFilter.process (*context.midi.getWriteBuffer (i));
+                    if (last >= 0)
+                        program = last;
+                }
 
-                        if (msg.getChannel() > 0 && midiChans.isOff (msg.getChannel()))
-                            continue;
+                if (program >= 0)
+                {
+                    node->setMidiProgram (program);
+                    node->reloadMidiProgram();
+                }
+            }
+        }
 
-                        if (useMidiProgram && msg.isProgramChange())
-                        {
-                            node->setMidiProgram (msg.getProgramChangeNumber());
-                            node->reloadMidiProgram();
-                            continue;
-                        }
+        tempMidi.clear();
+        // End MIDI filters
 
-                        transpose.process (msg);
-                        tempMidi.addEvent (msg, m.samplePosition);
-                    }
+        const auto osFactor = node->getOversamplingFactor();
+        auto osProcessor = osFactor > 1 ? node->getOversamplingProcessor() : nullptr;
 
-                    midi.swapWith (tempMidi);
-                    tempMidi.clear();
-                }
+        if (paramQueue != nullptr)
+        {
+            paramEvents->clear();
+            paramQueue->render (*paramEvents, osProcessor != nullptr ? numSamples * osFactor : numSamples, ParameterQueue::now());
+            context.params = paramEvents.get();
+        }
+
+        (this->*renderFns[osProcessor != nullptr ? 1 : 0]) (context, numSamples, osProcessor, osFactor);
+
+        if (SignalGuard::isEnabled())
+            guardOutputs (context, numSamples);
+
+        if (muted && ! muteInput)
+        {
+            if (lastMute != muted)
+            {
+                // just became muted
+                context.audio.applyGainRamp (0, numSamples, node->getLastGain(), 0.0);
             }
             else
             {
-                for (int i = context.midi.getNumBuffers(); --i >= 0;)
-                    transpose.process (*context.midi.getWriteBuffer (i), numSamples);
+                // normal mute processing
+                context.audio.applyGain (0, numSamples, 0.0);
             }
         }
+        else if (! muted && ! muteInput && muted != lastMute)
+        {
+            // just became unmuted
+            context.audio.applyGainRamp (0, numSamples, 0.0, node->getGain());
+        }
+        else if (node->getGain() != node->getLastGain())
+        {
+            context.audio.applyGainRamp (0, numSamples, node->getLastGain(), node->getGain());
+        }
+        else
+        {
+            context.audio.applyGain (0, numSamples, node->getGain());
+        }
 
-        tempMidi.clear();
-        // End MIDI filters
+        node->updateGain();
+        lastMute = muted;
 
-        auto pluginProcessBlock = [this] (RenderContext& context, bool isSuspended) {
-            if (node->wantsContext())
+        bool outputsQuiet = true;
+        for (int i = 0; i < numAudioOuts; ++i)
+        {
+            // silence and sleep only need the peak, RMS is for meters.
+            float peak = 0.f;
+            const auto* data = context.audio.getReadPointer (i);
+            if (metering)
             {
-                if (! isSuspended)
-                    node->render (context);
-                else
-                    node->renderBypassed (context);
+                const auto level = SignalLevel::measure (data, numSamples);
+                node->setOutputRMS (i, level.rms);
+                peak = level.peak;
             }
+            else if (numSamples > 0)
+            {
+                const auto range = FloatVectorOperations::findMinAndMax (data, numSamples);
+                peak = jmax (-range.getStart(), range.getEnd());
+            }
+
+            markSilent (audioChannelsToUse.getUnchecked (i), peak == 0.f);
+            outputsQuiet = outputsQuiet && peak < quietLevel;
+        }
+
+        for (int i = numAudioOuts; i < totalChans; ++i)
+            markSilent (audioChannelsToUse.getUnchecked (i), false);
+        for (int i = 0; i < totalCV; ++i)
+            markSilent (cvChannelsToUse.getUnchecked (i), false);
+
+        if (inputsSilent && outputsQuiet && ! hasOutputEvents (context, sharedAtomBuffers))
+            quietSamples += numSamples;
+        else
+            quietSamples = 0;
+
+        if (profiling)
+            node->recordProcessTime (Time::getHighResolutionTicks() - startTicks, numSamples);
+
+        RenderTrace::record (RenderTrace::opEnd, node->nodeId);
+    }
+
+    bool setSilenceFlags (uint8* flags) noexcept override
+    {
+        silence = flags;
+        return true;
+    }
+
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.audio.addArray (audioChannelsToUse);
+        b.audio.addArray (cvChannelsToUse);
+        for (int i = 0; i < midiChannelsToUse.size(); ++i)
+            if (midiSlots.getUnchecked (i) != privateSlot)
+                b.midi.add (midiChannelsToUse.getUnchecked (i));
+        b.atom.addArray (atomChannelsToUse);
+
+        if (auto ioNode = dynamic_cast<IONode*> (node.get()))
+            b.ioType = ioNode->getType();
+    }
+
+    bool endsStep() const noexcept override { return true; }
+
+    /** Returns the shared buffer of each audio channel. */
+    const Array<int>& getAudioChannels() const noexcept { return audioChannelsToUse; }
+
+    const ProcessorPtr node;
+    AudioProcessor* const processor;
+
+private:
+    // plugins that may render in double precision, see GraphNode::setDoublePrecision()
+    AudioProcessorNode* const pluginNode;
+
+    Array<int> audioChannelsToUse;
+    Array<int> cvChannelsToUse;
+    Array<int> midiChannelsToUse;
+    Array<int> atomChannelsToUse;
+
+    HeapBlock<float*> channels;
+    HeapBlock<float*> cv;
+    const float* resolvedFor = nullptr; // first shared channel the tables point into
+    int totalChans, totalCV, numAudioIns, numAudioOuts;
+    int numCVIns, numCVOuts, numMidiIns, numAtomIns;
+    int midiBufferToUse;
+    bool lastMute = false;
+
+    // sleeping when silent, see Processor::setTailLength()
+    static constexpr float quietLevel = 0.000001f; // -120 dB
+    uint8* silence = nullptr;
+    bool canSleep = true;
+    int quietSamples = 0;
+
+    // see SignalGuard
+    bool canFaultBypass = true;
+    int faultBlocks = 0;
+
+    MidiFilterStage midiFilter;
+    Processor::MidiFilter lastFilter;
+    MidiBuffer tempMidi;
+
+    enum MidiSlot
+    {
+        sharedSlot = 0, ///< renders straight into the graph's buffer
+        borrowedSlot, ///< input shared with later nodes, copied before use
+        privateSlot ///< scratch buffer for nodes without MIDI ports
+    };
+
+    Array<int> midiSlots;
+    OwnedArray<MidiBuffer> ownedMidi;
+    HeapBlock<MidiBuffer*> midiBuffers;
+    HeapBlock<AtomBuffer*> atomBuffers;
+
+    std::unique_ptr<float*> osChans;
+    int osChanSize = 0;
+
+    // parameter events, only for nodes that want them
+    ParameterArray params;
+    std::unique_ptr<ParameterQueue> paramQueue;
+    std::unique_ptr<ParameterEvents> paramEvents;
+
+    void controlValueChanged (int index, float value) override { paramQueue->push (index, value); }
+    void controlTouched (int, bool) override {}
+
+    // How the node renders is fixed when the op is built, so that choice is
+    // made once here. Oversampling can be toggled any time, perform() picks
+    // the variant for it each block.
+    using RenderFn = void (ProcessBufferOp::*) (RenderContext&, int, dsp::Oversampling<float>*, int);
+    RenderFn renderFns[2] {};
+
+    template <bool UsesContext>
+    void processNode (RenderContext& context, bool isSuspended)
+    {
+        if constexpr (UsesContext)
+        {
+            if (! isSuspended)
+                node->render (context);
             else
+                node->renderBypassed (context);
+        }
+        else if (pluginNode != nullptr && processor->isUsingDoublePrecision())
+        {
+            if (! pluginNode->renderDouble (context.audio, *context.midi.getWriteBuffer (0), isSuspended))
+                context.audio.clear();
+        }
+        else
+        {
+            if (! isSuspended)
+                processor->processBlock (context.audio, *context.midi.getWriteBuffer (0));
+            else
+                processor->processBlockBypassed (context.audio, *context.midi.getWriteBuffer (0));
+        }
+    }
+
+    template <bool UsesContext, bool Oversampled>
+    void renderNode (RenderContext& context, int numSamples, dsp::Oversampling<float>* osProcessor, int osFactor)
+    {
+        if constexpr (! Oversampled)
+        {
+            ignoreUnused (numSamples, osProcessor, osFactor);
+            processNode<UsesContext> (context, node->isSuspended());
+        }
+        else
+        {
+            dsp::AudioBlock<float> block (channels, static_cast<size_t> (totalChans), static_cast<size_t> (numSamples));
+            dsp::AudioBlock<float> osBlock = osProcessor->processSamplesUp (block);
+
+            if (totalChans > osChanSize)
             {
-                jassert (processor != nullptr);
-                if (! isSuspended)
-                {
-                    processor->processBlock (context.audio, *context.midi.getWriteBuffer (0));
-                    // processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
-                }
-                else
-                {
-                    processor->processBlockBypassed (context.audio, *context.midi.getWriteBuffer (0));
-                    // processor->processBlockBypassed (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
-                }
+                osChanSize = context.audio.getNumChannels();
+                osChans.reset (new float*[osChanSize]);
             }
-        };
 
-        const auto osFactor = node->getOversamplingFactor();
-        if (osFactor > 1)
+            float** osData = osChans.get();
+            for (int ch = 0; ch < totalChans; ++ch)
+                osData[ch] = osBlock.getChannelPointer (ch);
+            context.audio.setDataToReferTo (osData, totalChans, static_cast<int> (osBlock.getNumSamples()));
+
+            for (int i = 0; i < context.midi.getNumBuffers(); ++i)
+                FixedMidi::remap (*context.midi.getWriteBuffer (i), osFactor, 1);
+
+            processNode<UsesContext> (context, node->isSuspended());
+
+            osProcessor->processSamplesDown (block);
+            for (int ch = 0; ch < totalChans; ++ch)
+                osData[ch] = block.getChannelPointer (ch);
+            context.audio.setDataToReferTo (osData, totalChans, numSamples);
+
+            for (int i = 0; i < context.midi.getNumBuffers(); ++i)
+                FixedMidi::remap (*context.midi.getWriteBuffer (i), 1, osFactor);
+        }
+    }
+
+    /** Zero bad samples the node wrote, and bypass it if it keeps writing them. */
+    void guardOutputs (RenderContext& context, int numSamples) noexcept
+    {
+        bool faulty = false;
+        for (int i = 0; i < numAudioOuts; ++i)
+            faulty = SignalGuard::sanitize (context.audio.getWritePointer (i), numSamples).nonFinite > 0 || faulty;
+        for (int i = 0; i < numCVOuts; ++i)
+            faulty = SignalGuard::sanitize (context.cv.getWritePointer (i), numSamples).nonFinite > 0 || faulty;
+
+        if (! faulty)
+        {
+            faultBlocks = 0;
+            return;
+        }
+
+        SignalGuard::recordFault();
+        node->recordSignalFault (canFaultBypass && ++faultBlocks >= SignalGuard::faultLimit);
+    }
+
+    void markSilent (int buffer, bool isSilent) noexcept
+    {
+        // buffer 0 is the shared zero buffer, its flag never changes.
+        if (silence != nullptr && buffer > 0)
+            silence[buffer] = isSilent ? 1 : 0;
+    }
+
+    static bool hasEvents (const AtomBuffer& buffer) noexcept
+    {
+        return buffer.sequence()->atom.size > sizeof (LV2_Atom_Sequence_Body);
+    }
+
+    bool areInputsSilent (const SharedMidi& midi, const SharedAtom& atom) const noexcept
+    {
+        if (silence == nullptr)
+            return false;
+
+        for (int i = 0; i < numAudioIns; ++i)
+            if (! silence[audioChannelsToUse.getUnchecked (i)])
+                return false;
+        for (int i = 0; i < numCVIns; ++i)
+            if (! silence[cvChannelsToUse.getUnchecked (i)])
+                return false;
+
+        for (int i = 0; i < std::min (numMidiIns, midiChannelsToUse.size()); ++i)
+            if (midiSlots.getUnchecked (i) != privateSlot
+                && midi.getUnchecked (midiChannelsToUse.getUnchecked (i))->getNumEvents() > 0)
+                return false;
+
+        for (int i = 0; i < std::min (numAtomIns, atomChannelsToUse.size()); ++i)
+        {
+            const int idx = atomChannelsToUse.getUnchecked (i);
+            if (idx > 0 && hasEvents (*atom.getUnchecked (idx)))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool hasOutputEvents (const RenderContext& context, const SharedAtom& atom) const noexcept
+    {
+        for (int i = 0; i < context.midi.getNumBuffers(); ++i)
+            if (context.midi.getReadBuffer (i)->getNumEvents() > 0)
+                return true;
+
+        for (auto idx : atomChannelsToUse)
+            if (idx > 0 && hasEvents (*atom.getUnchecked (idx)))
+                return true;
+
+        return false;
+    }
+
+    /** Render a block without processing the node. Everything it would write
+        is cleared, so downstream nodes see silence and may sleep too.
+     */
+    void sleep (RenderContext& context, const SharedAtom& atom, int numSamples) noexcept
+    {
+        for (int i = 0; i < totalChans; ++i)
+        {
+            const int idx = audioChannelsToUse.getUnchecked (i);
+            if (idx > 0)
+                context.audio.clear (i, 0, numSamples);
+            markSilent (idx, true);
+        }
+
+        for (int i = 0; i < totalCV; ++i)
+        {
+            const int idx = cvChannelsToUse.getUnchecked (i);
+            if (idx > 0)
+                context.cv.clear (i, 0, numSamples);
+            markSilent (idx, true);
+        }
+
+        context.midi.clear();
+        for (auto idx : atomChannelsToUse)
+            if (idx > 0)
+                atom.getUnchecked (idx)->clear();
+
+        for (int i = numAudioIns; --i >= 0;)
+            node->setInputRMS (i, 0.f);
+        for (int i = numAudioOuts; --i >= 0;)
+            node->setOutputRMS (i, 0.f);
+
+        node->updateGain();
+        lastMute = node->isMuted();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ProcessBufferOp)
+};
+
+//==============================================================================
+/** A GainStage node and the copies and adds that gather its inputs.
+
+    While the node is plain, meaning enabled, unmuted, not bypassed,
+    metered or oversampled, its gains are mixed straight from the source
+    buffers into its outputs in one pass. Otherwise the gathered ops run
+    as usual and the node processes normally.
+ */
+class FusedGainOp : public GraphOp
+{
+public:
+    struct Move
+    {
+        GraphInstruction::Code code;
+        int src, dst;
+    };
+
+    FusedGainOp (ProcessBufferOp* op_,
+                 GainStage& stage_,
+                 std::vector<Move> moves_,
+                 const std::vector<std::vector<int>>& sources,
+                 const std::vector<int>& outputs)
+        : op (op_),
+          stage (stage_),
+          moves (std::move (moves_)),
+          fused (stage_.getGainTaps(), sources, outputs),
+          lastMute (op_->node->isMuted())
+    {
+        start.resize ((size_t) fused.getNumTaps());
+        end.resize ((size_t) fused.getNumTaps());
+
+        // gathered buffers that aren't outputs are skipped when fused.
+        for (const auto& move : moves)
+            if (std::find (outputs.begin(), outputs.end(), move.dst) == outputs.end())
+                unwritten.push_back (move.dst);
+    }
+
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        for (const auto& move : moves)
         {
-            auto osProcessor = node->getOversamplingProcessor();
+            if (move.code != GraphInstruction::clearAudio)
+                b.audio.add (move.src);
+            b.audio.add (move.dst);
+        }
+        op->collectBuffers (b);
+    }
 
-            dsp::AudioBlock<float> block (channels, static_cast<size_t> (totalChans), static_cast<size_t> (numSamples));
-            dsp::AudioBlock<float> osBlock = osProcessor->processSamplesUp (block);
+    bool endsStep() const noexcept override { return true; }
 
-            if (totalChans > osChanSize)
-            {
-                osChanSize = context.audio.getNumChannels();
-                osChans.reset (new float*[osChanSize]);
-            }
+    bool setSilenceFlags (uint8* flags) noexcept override
+    {
+        silence = flags;
+        return op->setSilenceFlags (flags);
+    }
 
-            float** osData = osChans.get();
-            for (int ch = 0; ch < totalChans; ++ch)
-                osData[ch] = osBlock.getChannelPointer (ch);
-            context.audio.setDataToReferTo (osData, totalChans, static_cast<int> (osBlock.getNumSamples()));
+    void perform (SharedAudio& audio, const SharedMidi& midi, const SharedAtom& atom, const int numSamples) override
+    {
+        auto& node = *op->node;
+        const bool muted = node.isMuted();
+        const bool plain = silence != nullptr && node.isEnabled() && ! node.isPreparing() && ! muted && ! lastMute
+                           && ! node.isSuspended() && ! node.isMetering() && ! node.isProfilingEnabled()
+                           && node.getOversamplingFactor() <= 1;
+        lastMute = muted;
 
-            tempMidi.clear();
-            for (int i = 0; i < context.midi.getNumBuffers(); ++i)
-            {
-                auto& mb = *context.midi.getWriteBuffer (i);
-                for (const MidiMessageMetadata msg : mb)
-                {
-                    tempMidi.addEvent (
-                        msg.data,
-                        msg.numBytes,
-                        msg.samplePosition * osFactor);
-                }
-                mb.swapWith (tempMidi);
-                tempMidi.clear();
-            }
+        if (! plain)
+        {
+            gather (audio, numSamples);
+            op->perform (audio, midi, atom, numSamples);
+            return;
+        }
 
-            pluginProcessBlock (context, node->isSuspended());
+        RenderTrace::record (RenderTrace::opBegin, node.nodeId, numSamples);
 
-            osProcessor->processSamplesDown (block);
-            for (int ch = 0; ch < totalChans; ++ch)
-                osData[ch] = block.getChannelPointer (ch);
-            context.audio.setDataToReferTo (osData, totalChans, numSamples);
+        stage.nextGains (numSamples, start.data(), end.data());
 
-            tempMidi.clear();
-            for (int i = 0; i < context.midi.getNumBuffers(); ++i)
-            {
-                auto& mb = *context.midi.getWriteBuffer (i);
-                for (const MidiMessageMetadata msg : mb)
-                {
-                    tempMidi.addEvent (
-                        msg.data,
-                        msg.numBytes,
-                        msg.samplePosition / osFactor);
-                }
-                mb.swapWith (tempMidi);
-                tempMidi.clear();
-            }
-        }
-        else
+        // the node's own gains ride along with the stage's.
+        const float from = node.getLastInputGain() * node.getLastGain();
+        const float to = node.getInputGain() * node.getGain();
+        if (from != 1.f || to != 1.f)
         {
-            pluginProcessBlock (context, node->isSuspended());
+            for (auto& g : start)
+                g *= from;
+            for (auto& g : end)
+                g *= to;
         }
+        node.updateGain();
 
-        if (muted && ! muteInput)
+        fused.process (audio.getArrayOfWritePointers(), silence, start.data(), end.data(), numSamples);
+        for (auto idx : unwritten)
+            if (idx > 0)
+                silence[idx] = 0;
+
+        RenderTrace::record (RenderTrace::opEnd, node.nodeId);
+    }
+
+private:
+    std::unique_ptr<ProcessBufferOp> op;
+    GainStage& stage;
+    std::vector<Move> moves;
+    std::vector<int> unwritten;
+    FusedGain fused;
+    std::vector<float> start, end;
+    uint8* silence = nullptr;
+    bool lastMute;
+
+    /** Run the gathering ops the way GraphProgram would. */
+    void gather (SharedAudio& audio, int numSamples) noexcept
+    {
+        for (const auto& move : moves)
         {
-            if (lastMute != muted)
-            {
-                // just became muted
-                context.audio.applyGainRamp (0, numSamples, node->getLastGain(), 0.0);
-            }
-            else
+            auto* const dst = audio.getWritePointer (move.dst);
+            switch (move.code)
             {
-                // normal mute processing
-                context.audio.applyGain (0, numSamples, 0.0);
+                case GraphInstruction::clearAudio:
+                    FloatVectorOperations::clear (dst, numSamples);
+                    setSilent (move.dst, 1);
+                    break;
+                case GraphInstruction::copyAudio:
+                    FloatVectorOperations::copy (dst, audio.getReadPointer (move.src), numSamples);
+                    setSilent (move.dst, silence != nullptr ? silence[move.src] : 0);
+                    break;
+                case GraphInstruction::addAudio:
+                    FloatVectorOperations::add (dst, audio.getReadPointer (move.src), numSamples);
+                    if (silence != nullptr && ! silence[move.src])
+                        setSilent (move.dst, 0);
+                    break;
+                default:
+                    break;
             }
         }
-        else if (! muted && ! muteInput && muted != lastMute)
-        {
-            // just became unmuted
-            context.audio.applyGainRamp (0, numSamples, 0.0, node->getGain());
-        }
-        else if (node->getGain() != node->getLastGain())
-        {
-            context.audio.applyGainRamp (0, numSamples, node->getLastGain(), node->getGain());
-        }
-        else
+    }
+
+    void setSilent (int buffer, uint8 flag) noexcept
+    {
+        if (silence != nullptr && buffer > 0)
+            silence[buffer] = flag;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (FusedGainOp)
+};
+
+/** Adds an aux send's inputs into its bus at the send level. */
+class AuxSendOp : public GraphOp
+{
+public:
+    AuxSendOp (const ProcessorPtr& node_, AuxSendProcessor& send_, const Array<int>& sources_, const std::vector<int>& buses_)
+        : node (node_),
+          send (send_),
+          sources (sources_),
+          buses (buses_)
+    {
+        lastGain = getTargetGain();
+    }
+
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        for (int i = 0; i < (int) buses.size(); ++i)
         {
-            context.audio.applyGain (0, numSamples, node->getGain());
+            b.audio.add (sources.getUnchecked (i));
+            b.audio.add (buses[(size_t) i]);
         }
+    }
 
-        node->updateGain();
-        lastMute = muted;
-
-        for (int i = 0; i < numAudioOuts; ++i)
-            node->setOutputRMS (i, context.audio.getRMSLevel (i, 0, numSamples));
+    bool setSilenceFlags (uint8* flags) noexcept override
+    {
+        silence = flags;
+        return true;
     }
 
-    const ProcessorPtr node;
-    AudioProcessor* const processor;
+    void perform (SharedAudio& audio, const SharedMidi&, const SharedAtom&, const int numSamples) override
+    {
+        const float gain = getTargetGain();
+        if (gain != 0.f || lastGain != 0.f)
+        {
+            for (int i = 0; i < (int) buses.size(); ++i)
+            {
+                const int src = sources.getUnchecked (i);
+                if (silence != nullptr && silence[src])
+                    continue;
+                GainRamp::add (audio.getWritePointer (buses[(size_t) i]), audio.getReadPointer (src), numSamples, lastGain, gain);
+                if (silence != nullptr)
+                    silence[buses[(size_t) i]] = 0;
+            }
+        }
+        lastGain = gain;
+    }
 
 private:
-    Array<int> audioChannelsToUse;
-    Array<int> cvChannelsToUse;
-    Array<int> midiChannelsToUse;
-    Array<int> atomChannelsToUse;
+    const ProcessorPtr node;
+    AuxSendProcessor& send;
+    const Array<int> sources;
+    const std::vector<int> buses;
+    uint8* silence = nullptr;
+    float lastGain = 0.f;
 
-    HeapBlock<float*> channels;
-    HeapBlock<float*> cv;
-    int totalChans, totalCV, numAudioIns, numAudioOuts;
-    int midiBufferToUse;
-    bool lastMute = false;
-    MidiTranspose transpose;
-    MidiBuffer tempMidi;
+    float getTargetGain() const noexcept
+    {
+        return node->isEnabled() && ! node->isMuted() ? send.getSendGain() : 0.f;
+    }
 
-    std::unique_ptr<float*> osChans;
-    int osChanSize = 0;
-    JUCE_DECLARE_NON_COPYABLE (ProcessBufferOp)
+    JUCE_DECLARE_NON_COPYABLE (AuxSendOp)
 };
 
 GraphBuilder::GraphBuilder (GraphNode& graph_,
-                            const Array<void*>& orderedNodes_,
+                            const GraphLayout& layout_,
                             Array<void*>& renderingOps)
     : graph (graph_),
-      orderedNodes (orderedNodes_),
+      layout (layout_),
+      orderedNodes (layout_.nodes),
       midi_MidiEvent (graph.symbols().map (LV2_MIDI__MidiEvent)),
       totalLatency (0)
 {
@@ -670,6 +1406,9 @@ GraphBuilder::GraphBuilder (GraphNode& graph_,
         allPorts[i].add (EL_INVALID_PORT);
     }
 
+    buildLookupTables();
+    createAuxBuses (renderingOps);
+
     for (int i = 0; i < orderedNodes.size(); ++i)
     {
         createRenderingOpsForNode ((Processor*) orderedNodes.getUnchecked (i),
@@ -728,37 +1467,140 @@ int GraphBuilder::buffersNeeded (PortType _type)
     return allNodes[type.id()].size();
 }
 
-int GraphBuilder::getNodeDelay (const uint32 nodeID) const { return nodeDelays[nodeDelayIDs.indexOf (nodeID)]; }
-
-void GraphBuilder::setNodeDelay (const uint32 nodeID, const int latency)
+void GraphBuilder::buildLookupTables()
 {
-    const int index = nodeDelayIDs.indexOf (nodeID);
+    std::unordered_map<uint32, int> steps;
+    nodeMap.reserve ((size_t) orderedNodes.size());
+    nodeKeys.reserve ((size_t) orderedNodes.size());
+    steps.reserve ((size_t) orderedNodes.size());
+
+    for (int i = 0; i < orderedNodes.size(); ++i)
+    {
+        auto* node = (Processor*) orderedNodes.getUnchecked (i);
+        const auto key = layout.keys[(size_t) i];
+        nodeMap[key] = node;
+        nodeKeys[node] = key;
+        steps[key] = i;
+    }
+
+    inputArcs.reserve (layout.arcs.size());
+    for (const auto& arc : layout.arcs)
+        inputArcs.push_back (&arc);
+    std::stable_sort (inputArcs.begin(), inputArcs.end(), [] (const Arc* a, const Arc* b) {
+        return a->destNode != b->destNode ? a->destNode < b->destNode : a->destPort < b->destPort;
+    });
+    for (size_t i = 0; i < inputArcs.size();)
+    {
+        const auto node = inputArcs[i]->destNode;
+        const auto first = i;
+        while (i < inputArcs.size() && inputArcs[i]->destNode == node)
+            ++i;
+        inputRanges[node] = { first, i };
+    }
+
+    for (const auto& arc : layout.arcs)
+    {
+        const auto* const c = &arc;
+        auto step = steps.find (c->destNode);
+        if (step == steps.end())
+            continue;
+        // ports past the end don't count, the node can't read them.
+        if (c->destPort >= getNode (c->destNode)->getNumPorts())
+            continue;
+        outputUses[portKey (c->sourceNode, c->sourcePort)].push_back ({ step->second, c->destPort });
+    }
 
-    if (index >= 0)
+    for (auto& iter : outputUses)
     {
-        nodeDelays.set (index, latency);
+        std::stable_sort (iter.second.begin(), iter.second.end(), [] (const PortUse& a, const PortUse& b) {
+            return a.step < b.step;
+        });
     }
-    else
+}
+
+Processor* GraphBuilder::getNode (const uint32 nodeId) const noexcept
+{
+    auto iter = nodeMap.find (nodeId);
+    return iter != nodeMap.end() ? iter->second : nullptr;
+}
+
+uint32 GraphBuilder::getKey (const Processor* node) const noexcept
+{
+    auto iter = nodeKeys.find (node);
+    return iter != nodeKeys.end() ? iter->second : (uint32) anonymousNodeID;
+}
+
+void GraphBuilder::createAuxBuses (Array<void*>& renderingOps)
+{
+    // a bus with a return gets buffers of its own, cleared each block, that
+    // its sends add into and its last return renders from.
+    for (auto* ptr : orderedNodes)
     {
-        nodeDelayIDs.add (nodeID);
-        nodeDelays.add (latency);
+        auto* const node = (Processor*) ptr;
+        auto* const aux = dynamic_cast<AuxBusProcessor*> (node->getAudioProcessor());
+        if (aux == nullptr || ! aux->isReturn())
+            continue;
+
+        auto& bus = auxBuses[{ node->getParentGraph(), aux->getBus() }];
+        ++bus.returnsLeft;
+        if (! bus.buffers.empty())
+            continue;
+
+        for (int i = 0; i < AuxBusProcessor::numChannels; ++i)
+        {
+            const int bufIndex = getFreeBuffer (PortType::Audio);
+            allNodes[PortType::Audio].set (bufIndex, (uint32) busNodeID);
+            bus.buffers.push_back (bufIndex);
+            renderingOps.add (new ClearChannelOp (bufIndex));
+        }
     }
 }
 
+GraphBuilder::AuxBus* GraphBuilder::getAuxBus (Processor* node, bool isReturn) noexcept
+{
+    auto* const aux = dynamic_cast<AuxBusProcessor*> (node->getAudioProcessor());
+    if (aux == nullptr || aux->isReturn() != isReturn)
+        return nullptr;
+    auto iter = auxBuses.find ({ node->getParentGraph(), aux->getBus() });
+    return iter != auxBuses.end() ? &iter->second : nullptr;
+}
+
+int GraphBuilder::getNodeDelay (const uint32 nodeID) const
+{
+    auto iter = nodeDelays.find (nodeID);
+    return iter != nodeDelays.end() ? iter->second : 0;
+}
+
+void GraphBuilder::setNodeDelay (const uint32 nodeID, const int latency)
+{
+    nodeDelays[nodeID] = latency;
+}
+
 int GraphBuilder::getInputLatency (const uint32 nodeID) const
 {
     int maxLatency = 0;
 
-    for (int i = graph.getNumConnections(); --i >= 0;)
-    {
-        const auto* const c = graph.getConnection (i);
-        if (c->destNode == nodeID)
-            maxLatency = jmax (maxLatency, getNodeDelay (c->sourceNode));
-    }
+    auto range = inputRanges.find (nodeID);
+    if (range != inputRanges.end())
+        for (auto i = range->second.first; i < range->second.second; ++i)
+            maxLatency = jmax (maxLatency, getNodeDelay (inputArcs[i]->sourceNode));
 
     return maxLatency;
 }
 
+std::pair<const Arc* const*, const Arc* const*> GraphBuilder::getInputs (const uint32 nodeID, const uint32 port) const noexcept
+{
+    auto range = inputRanges.find (nodeID);
+    if (range == inputRanges.end())
+        return {};
+
+    const auto* const first = inputArcs.data() + range->second.first;
+    const auto* const last = inputArcs.data() + range->second.second;
+    const auto* const lower = std::lower_bound (first, last, port, [] (const Arc* a, uint32 p) { return a->destPort < p; });
+    const auto* const upper = std::upper_bound (lower, last, port, [] (uint32 p, const Arc* a) { return p < a->destPort; });
+    return { lower, upper };
+}
+
 void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                                               Array<void*>& renderingOps,
                                               const int ourRenderingIndex)
@@ -777,7 +1619,13 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
     }
 
     Array<int> channelsToUse[PortType::Unknown];
-    int maxLatency = getInputLatency (node->nodeId);
+    Array<int> borrowedMidi;
+    const int firstOp = renderingOps.size();
+    const uint32 nodeKey = getKey (node);
+    int maxLatency = getInputLatency (nodeKey);
+
+    auto* const returnBus = getAuxBus (node, true);
+    const bool lastReturn = returnBus != nullptr && --returnBus->returnsLeft == 0;
 
     const uint32 numPorts (node->getNumPorts());
     for (uint32 port = 0; port < numPorts; ++port)
@@ -797,7 +1645,7 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
             {
                 case PortType::Control: {
                     const int bufIndex = getFreeBuffer (portType);
-                    markBufferAsContaining (bufIndex, portType, node->nodeId, port);
+                    markBufferAsContaining (bufIndex, portType, nodeKey, port);
                     break;
                 }
 
@@ -805,7 +1653,15 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                     const int outputChan = node->getChannelPort (port);
                     if (outputChan >= (int) numIns && outputChan < (int) numOuts)
                     {
-                        const int bufIndex = getFreeBuffer (portType);
+                        const int busIndex = returnBus != nullptr && portType == PortType::Audio && outputChan < (int) returnBus->buffers.size()
+                                                 ? returnBus->buffers[(size_t) outputChan]
+                                                 : -1;
+
+                        // the last return on a bus renders straight from it,
+                        // any others get a copy.
+                        const int bufIndex = busIndex >= 0 && lastReturn ? busIndex : getFreeBuffer (portType);
+                        if (busIndex >= 0 && ! lastReturn)
+                            renderingOps.add (new CopyChannelOp (busIndex, bufIndex));
                         channelsToUse[portType.id()].add (bufIndex);
                         const uint32 outPort = node->getNthPort (portType, outputChan, false, false);
 
@@ -813,7 +1669,7 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                         jassert (outPort == port);
                         jassert (outPort < node->getNumPorts());
 
-                        markBufferAsContaining (bufIndex, portType, node->nodeId, outPort);
+                        markBufferAsContaining (bufIndex, portType, nodeKey, outPort);
                     }
                     break;
                 }
@@ -830,16 +1686,15 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
         Array<uint32> sourcePorts;
         Array<PortType> sourceTypes;
 
-        for (int i = graph.getNumConnections(); --i >= 0;)
+        // newest connection first, same as the graph's own order.
+        const auto inputs = getInputs (nodeKey, port);
+        for (auto iter = inputs.second; iter != inputs.first;)
         {
-            const auto* const c = graph.getConnection (i);
-            if (c->destNode == node->nodeId && c->destPort == port)
-            {
-                sourceNodes.add (c->sourceNode);
-                sourcePorts.add (c->sourcePort);
-                auto src = graph.getNodeForId (c->sourceNode);
-                sourceTypes.add (src->getPortType (c->sourcePort));
-            }
+            const auto* const c = *--iter;
+            sourceNodes.add (c->sourceNode);
+            sourcePorts.add (c->sourcePort);
+            auto src = getNode (c->sourceNode);
+            sourceTypes.add (src->getPortType (c->sourcePort));
         }
 
         int bufIndex = -1;
@@ -880,7 +1735,7 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
             // port with a straight forward single input..
             const uint32 srcNode = sourceNodes.getUnchecked (0);
             const uint32 srcPort = sourcePorts.getUnchecked (0);
-            auto srcObj = graph.getNodeForId (srcNode);
+            auto srcObj = getNode (srcNode);
             const auto srcType = srcObj->getPortType (srcPort);
 
             bufIndex = getBufferContaining (srcType, srcNode, srcPort);
@@ -897,23 +1752,21 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
 
             if (portType == PortType::Control)
             {
-                auto src = graph.getNodeForId (srcNode);
+                auto src = getNode (srcNode);
                 renderingOps.add (new BindParameterOp (
                     src->getParameter ((int) srcPort),
                     node->getParameter ((int) port)));
             }
             else if (srcType.isControl() && portType.isCv())
             {
-                auto src = graph.getNodeForId (srcNode);
+                auto src = getNode (srcNode);
                 const int newFreeBuffer = getFreeBuffer (portType);
                 renderingOps.add (new ApplyParamToCVOp (src->getParameter ((int) srcPort), newFreeBuffer));
                 bufIndex = newFreeBuffer;
             }
             // clang-format off
-            else if (srcType != portType || 
-                     (bufNeededLater && (inputChan < (int) numOuts || 
-                                         portType == PortType::Midi || 
-                                         portType == PortType::Atom)))
+            else if (srcType != portType ||
+                     (bufNeededLater && (inputChan < (int) numOuts || portType == PortType::Atom)))
             // clang-format on
             {
                 jassert (! portType.isControl());
@@ -947,10 +1800,18 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
 
                 bufIndex = newFreeBuffer;
             }
+            else if (bufNeededLater && portType == PortType::Midi)
+            {
+                // An input only port doesn't write back to this buffer, so
+                // later nodes can keep reading it. MIDI inputs get copied on
+                // write by the op. Atom inputs are copied above, nodes such
+                // as LV2 plugins write into and clear them.
+                borrowedMidi.add (channelsToUse[PortType::Midi].size());
+            }
 
             const int nodeDelay = getNodeDelay (srcNode);
 
-            if (nodeDelay < maxLatency)
+            if (nodeDelay < maxLatency && (portType.isAudio() || portType.isCv()))
                 renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay));
         }
         else
@@ -1047,6 +1908,7 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                 }
             }
 
+            Array<int> atomSources;
             for (int j = 0; j < sourceNodes.size(); ++j)
             {
                 if (j != reusableInputIndex)
@@ -1083,7 +1945,7 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                         }
                         else if (sourceTypes.getUnchecked (j).isAtom() && portType.isAtom())
                         {
-                            renderingOps.add (new AddAtomBufferOp (srcIndex, bufIndex));
+                            atomSources.add (srcIndex);
                         }
                         else if (sourceTypes.getUnchecked (j).isAtom() && portType.isMidi())
                         {
@@ -1096,6 +1958,9 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                     }
                 }
             }
+
+            if (! atomSources.isEmpty())
+                renderingOps.add (new AddAtomBufferOp (atomSources, bufIndex));
         }
 
         jassert (bufIndex >= 0);
@@ -1104,11 +1969,11 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
         if (inputChan < (int) numOuts)
         {
             const int outputPort = node->getNthPort (portType, inputChan, false, false);
-            markBufferAsContaining (bufIndex, portType, node->nodeId, outputPort);
+            markBufferAsContaining (bufIndex, portType, nodeKey, outputPort);
         }
     } /* foreach port */
 
-    setNodeDelay (node->nodeId, maxLatency + node->getLatencySamples());
+    setNodeDelay (nodeKey, maxLatency + node->getLatencySamples());
 
     if (node->isAudioIONode() && node->getNumPorts (PortType::Audio, false) == 0)
         totalLatency = maxLatency;
@@ -1117,7 +1982,191 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                            node->getNumPorts (PortType::Audio, false));
     int totalCV = jmax (node->getNumPorts (PortType::CV, true),
                         node->getNumPorts (PortType::CV, false));
-    renderingOps.add (new ProcessBufferOp (node, totalChans, totalCV, 0, channelsToUse));
+    groupDelayOps (renderingOps, firstOp);
+
+    if (auto* const sendBus = getAuxBus (node, false))
+    {
+        if (sendBus->returnsLeft > 0 && channelsToUse[PortType::Audio].size() >= (int) sendBus->buffers.size())
+            renderingOps.add (new AuxSendOp (node, *dynamic_cast<AuxSendProcessor*> (proc), channelsToUse[PortType::Audio], sendBus->buffers));
+    }
+
+    renderingOps.add (new ProcessBufferOp (node, totalChans, totalCV, 0, channelsToUse, borrowedMidi));
+    fuseGainStage (renderingOps, firstOp);
+}
+
+void GraphBuilder::fuseGainStage (Array<void*>& renderingOps, const int firstOp)
+{
+    // A node that only scales and mixes takes over the ops gathering its
+    // audio inputs, as long as that's all they do.
+    auto* const processOp = dynamic_cast<ProcessBufferOp*> (static_cast<GraphOp*> (renderingOps.getLast()));
+    auto* const stage = processOp != nullptr ? dynamic_cast<GainStage*> (processOp->processor) : nullptr;
+    if (stage == nullptr)
+        return;
+
+    const auto& node = *processOp->node;
+    const int numIns = (int) node.getNumPorts (PortType::Audio, true);
+    const int numOuts = (int) node.getNumPorts (PortType::Audio, false);
+    const auto& chans = processOp->getAudioChannels();
+    if (numOuts <= 0 || numOuts > 16 || chans.size() < jmax (numIns, numOuts))
+        return;
+    for (const auto& tap : stage->getGainTaps())
+        if (tap.input < 0 || tap.input >= numIns || tap.output < 0 || tap.output >= numOuts)
+            return;
+
+    std::vector<std::vector<int>> sources;
+    for (int i = 0; i < numIns; ++i)
+        sources.push_back ({ chans.getUnchecked (i) });
+
+    std::vector<FusedGainOp::Move> moves;
+    const int lastOp = renderingOps.size() - 1;
+    for (int i = firstOp; i < lastOp; ++i)
+    {
+        const auto inst = static_cast<GraphOp*> (renderingOps.getUnchecked (i))->decode();
+        const int chan = chans.indexOf (inst.dst);
+        if (chan < 0 || chan >= numIns)
+            return;
+
+        auto& list = sources[(size_t) chan];
+        switch (inst.code)
+        {
+            case GraphInstruction::clearAudio:
+                list.clear();
+                break;
+            case GraphInstruction::copyAudio:
+                list.assign (1, inst.src);
+                break;
+            case GraphInstruction::addAudio:
+                list.push_back (inst.src);
+                break;
+            default:
+                return;
+        }
+
+        moves.push_back ({ inst.code, inst.src, inst.dst });
+    }
+
+    std::vector<int> outputs;
+    for (int i = 0; i < numOuts; ++i)
+        outputs.push_back (chans.getUnchecked (i));
+
+    for (int i = firstOp; i < lastOp; ++i)
+        delete static_cast<GraphOp*> (renderingOps.getUnchecked (i));
+    renderingOps.removeRange (firstOp, lastOp - firstOp);
+    renderingOps.set (firstOp, new FusedGainOp (processOp, *stage, std::move (moves), sources, outputs));
+}
+
+static bool isBufferTouched (const Array<void*>& ops, int start, int end, int audioBuffer)
+{
+    GraphOpBuffers buffers;
+    for (int i = start; i < end; ++i)
+    {
+        buffers.audio.clearQuick();
+        static_cast<GraphOp*> (ops.getUnchecked (i))->collectBuffers (buffers);
+        if (buffers.audio.contains (audioBuffer))
+            return true;
+    }
+    return false;
+}
+
+void GraphBuilder::groupDelayOps (Array<void*>& renderingOps, const int firstOp)
+{
+    // A delay whose channel isn't touched again before the node processes
+    // can run last. Those with equal delay are merged into one op, and a
+    // copy that only fills a delayed channel is folded into the delay.
+    struct Group
+    {
+        int delay;
+        Array<int> sources, channels;
+    };
+
+    std::vector<Group> groups;
+    Array<void*> kept;
+    const int numOps = renderingOps.size();
+
+    for (int i = firstOp; i < numOps; ++i)
+    {
+        auto* const delayOp = dynamic_cast<DelayChannelOp*> (static_cast<GraphOp*> (renderingOps.getUnchecked (i)));
+        if (delayOp == nullptr || delayOp->getNumChannels() != 1
+            || isBufferTouched (renderingOps, i + 1, numOps, delayOp->getChannel (0)))
+        {
+            kept.add (renderingOps.getUnchecked (i));
+            continue;
+        }
+
+        const int channel = delayOp->getChannel (0);
+        int source = delayOp->getSource (0);
+
+        auto* const copyOp = kept.size() > 0
+                                 ? dynamic_cast<CopyChannelOp*> (static_cast<GraphOp*> (kept.getLast()))
+                                 : nullptr;
+        if (copyOp != nullptr && renderingOps.getUnchecked (i - 1) == copyOp
+            && copyOp->getDestination() == channel
+            && ! isBufferTouched (renderingOps, i + 1, numOps, copyOp->getSource()))
+        {
+            source = copyOp->getSource();
+            kept.removeLast();
+            delete copyOp;
+        }
+
+        // channels in a group are written in turn, so one must not read
+        // from a buffer another one writes.
+        auto group = std::find_if (groups.begin(), groups.end(), [&] (const Group& g) {
+            return g.delay == delayOp->getDelay()
+                   && ! g.sources.contains (channel) && ! g.channels.contains (source)
+                   && ! g.channels.contains (channel);
+        });
+
+        if (group == groups.end())
+            group = groups.insert (groups.end(), Group { delayOp->getDelay(), {}, {} });
+
+        group->sources.add (source);
+        group->channels.add (channel);
+        delete delayOp;
+    }
+
+    renderingOps.removeRange (firstOp, numOps - firstOp);
+    renderingOps.addArray (kept);
+    for (const auto& group : groups)
+        renderingOps.add (new DelayChannelOp (group.sources, group.channels, group.delay));
+}
+
+bool GraphBuilder::retuneDelays (const Array<void*>& liveOps, const Array<void*>& plannedOps)
+{
+    if (liveOps.size() != plannedOps.size())
+        return false;
+
+    // the plan must match op for op, with only the delays different.
+    std::vector<std::pair<DelayChannelOp*, int>> changes;
+    for (int i = 0; i < liveOps.size(); ++i)
+    {
+        auto* const live = static_cast<GraphOp*> (liveOps.getUnchecked (i));
+        auto* const planned = static_cast<GraphOp*> (plannedOps.getUnchecked (i));
+        if (typeid (*live) != typeid (*planned))
+            return false;
+
+        auto* const liveDelay = dynamic_cast<DelayChannelOp*> (live);
+        if (liveDelay == nullptr)
+            continue;
+
+        auto* const plannedDelay = static_cast<DelayChannelOp*> (planned);
+        if (liveDelay->getNumChannels() != plannedDelay->getNumChannels())
+            return false;
+        for (int ch = 0; ch < liveDelay->getNumChannels(); ++ch)
+            if (liveDelay->getChannel (ch) != plannedDelay->getChannel (ch)
+                || liveDelay->getSource (ch) != plannedDelay->getSource (ch))
+                return false;
+
+        if (liveDelay->getDelay() != plannedDelay->getDelay())
+        {
+            if (! liveDelay->canDelay (plannedDelay->getDelay()))
+                return false;
+            changes.push_back ({ liveDelay, plannedDelay->getDelay() });
+        }
+    }
+
+    for (const auto& change : changes)
+        change.first->setDelay (change.second);
+    return true;
 }
 
 int GraphBuilder::getFreeBuffer (PortType _type)
@@ -1139,15 +2188,9 @@ int GraphBuilder::getReadOnlyEmptyBuffer() const noexcept { return 0; }
 int GraphBuilder::getBufferContaining (const PortType _type, const uint32 nodeId, const uint32 outputPort) noexcept
 {
     const PortType type = _type == PortType::CV ? PortType::Audio : _type;
-    Array<uint32>& nodes = allNodes[type.id()];
-    Array<uint32>& ports = allPorts[type.id()];
-
-    for (int i = nodes.size(); --i >= 0;)
-        if (nodes.getUnchecked (i) == nodeId
-            && ports.getUnchecked (i) == outputPort)
-            return i;
-
-    return -1;
+    const auto& lookup = bufferLookup[type.id()];
+    auto iter = lookup.find (portKey (nodeId, outputPort));
+    return iter != lookup.end() ? iter->second : -1;
 }
 
 void GraphBuilder::markUnusedBuffersFree (const int stepIndex)
@@ -1160,8 +2203,13 @@ void GraphBuilder::markUnusedBuffersFree (const int stepIndex)
         for (int i = 0; i < nodes.size(); ++i)
         {
             if (isNodeBusy (nodes.getUnchecked (i))
+                && nodes.getUnchecked (i) != busNodeID
                 && ! isBufferNeededLater (stepIndex, EL_INVALID_PORT, nodes.getUnchecked (i), ports.getUnchecked (i)))
             {
+                auto& lookup = bufferLookup[type];
+                auto iter = lookup.find (portKey (nodes.getUnchecked (i), ports.getUnchecked (i)));
+                if (iter != lookup.end() && iter->second == i)
+                    lookup.erase (iter);
                 nodes.set (i, (uint32) freeNodeID);
             }
         }
@@ -1173,48 +2221,20 @@ bool GraphBuilder::isBufferNeededLater (int stepIndexToSearchFrom,
                                         const uint32 sourceNode,
                                         const uint32 outputPortIndex) const
 {
-    while (stepIndexToSearchFrom < orderedNodes.size())
-    {
-        const Processor* const node = (const Processor*) orderedNodes.getUnchecked (stepIndexToSearchFrom);
-
-        {
-            for (uint32 port = 0; port < node->getNumPorts(); ++port)
-            {
-                if (port != inputChannelOfIndexToIgnore && graph.getConnectionBetween (sourceNode, outputPortIndex, node->nodeId, port) != nullptr)
-                {
-                    return true;
-                }
-            }
-        }
+    auto iter = outputUses.find (portKey (sourceNode, outputPortIndex));
+    if (iter == outputUses.end())
+        return false;
 
-        inputChannelOfIndexToIgnore = EL_INVALID_PORT;
-        ++stepIndexToSearchFrom;
-    }
-
-    return false;
-}
-
-bool GraphBuilder::isBufferNeededLater2 (int stepIndexToSearchFrom,
-                                         uint32 inputChannelOfIndexToIgnore,
-                                         const uint32 sourceNode,
-                                         const uint32 outputPortIndex) const
-{
-    while (stepIndexToSearchFrom < orderedNodes.size())
+    // uses are sorted by step, so walk back from the last one.
+    const auto& uses = iter->second;
+    for (auto use = uses.rbegin(); use != uses.rend(); ++use)
     {
-        const Processor* const node = (const Processor*) orderedNodes.getUnchecked (stepIndexToSearchFrom);
-
-        {
-            for (uint32 port = 0; port < node->getNumPorts(); ++port)
-            {
-                if (port != inputChannelOfIndexToIgnore && graph.getConnectionBetween (sourceNode, outputPortIndex, node->nodeId, port) != nullptr)
-                {
-                    return true;
-                }
-            }
-        }
-
-        inputChannelOfIndexToIgnore = EL_INVALID_PORT;
-        ++stepIndexToSearchFrom;
+        if (use->step > stepIndexToSearchFrom)
+            return true;
+        if (use->step < stepIndexToSearchFrom)
+            return false;
+        if (use->port != inputChannelOfIndexToIgnore)
+            return true;
     }
 
     return false;
@@ -1228,8 +2248,15 @@ void GraphBuilder::markBufferAsContaining (int bufferNum, PortType _type, uint32
     Array<uint32>& ports = allPorts[type.id()];
 
     jassert (bufferNum >= 0 && bufferNum < nodes.size());
+
+    auto& lookup = bufferLookup[type.id()];
+    auto iter = lookup.find (portKey (nodes.getUnchecked (bufferNum), ports.getUnchecked (bufferNum)));
+    if (iter != lookup.end() && iter->second == bufferNum)
+        lookup.erase (iter);
+
     nodes.set (bufferNum, nodeId);
     ports.set (bufferNum, portIndex);
+    lookup[portKey (nodeId, portIndex)] = bufferNum;
 }
 
 } // namespace element
@@ -3,6 +3,12 @@
 
 #pragma once
 
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <element/arc.hpp>
+
 #include "ElementApp.h"
 
 namespace element {
@@ -11,6 +17,46 @@ class AtomBuffer;
 class GraphNode;
 class Processor;
 
+/** Shared buffer indexes an op reads or writes. Used when ordering ops
+    for parallel rendering.
+ */
+struct GraphOpBuffers
+{
+    juce::Array<int> audio, midi, atom;
+
+    /** Set when the op touches the parent graph's IO buffers. Holds the
+        IONode device type, or -1 if not an IO op. Inputs and outputs of
+        the same kind are ordered against each other.
+     */
+    int ioType = -1;
+};
+
+class GraphOp;
+
+/** A decoded rendering op. Trivial buffer ops are run inline by
+    GraphProgram, anything else calls back into its GraphOp.
+ */
+struct GraphInstruction
+{
+    enum Code : uint8
+    {
+        perform = 0,
+        clearAudio,
+        copyAudio,
+        addAudio,
+        clearMidi,
+        copyMidi,
+        addMidi,
+        sumAudio, ///< dst = sum of numSources channels starting at src in the source table
+        nop ///< absorbed into an earlier instruction
+    };
+
+    Code code = perform;
+    int src = 0, dst = 0;
+    int numSources = 0;
+    GraphOp* op = nullptr;
+};
+
 class GraphOp
 {
 public:
@@ -19,6 +65,29 @@ public:
 
     virtual std::string traceStep() const noexcept { return {}; }
 
+    /** Add the shared buffers this op uses. */
+    virtual void collectBuffers (GraphOpBuffers&) const {}
+
+    /** Returns the bytes this op allocated for itself, e.g. delay lines. */
+    virtual size_t getNumBytes() const noexcept { return 0; }
+
+    /** Returns true if this op completes a node's rendering step. */
+    virtual bool endsStep() const noexcept { return false; }
+
+    /** Hand this op the program's per-buffer silence flags, indexed by
+        audio buffer. Return true if the op keeps the flags of the buffers
+        it writes up to date, otherwise they are cleared after perform().
+     */
+    virtual bool setSilenceFlags (uint8*) noexcept { return false; }
+
+    /** Returns this op as an instruction. The default calls perform(). */
+    virtual GraphInstruction decode() noexcept
+    {
+        GraphInstruction inst;
+        inst.op = this;
+        return inst;
+    }
+
     virtual void perform (juce::AudioSampleBuffer& sharedBufferChans,
                           const juce::OwnedArray<MidiBuffer>& sharedMidiBuffers,
                           const juce::OwnedArray<AtomBuffer>& sharedAtomBuffers,
@@ -28,21 +97,43 @@ private:
     JUCE_LEAK_DETECTOR (GraphOp)
 };
 
+/** The nodes and connections a GraphBuilder renders.
+
+    Usually a graph's own nodes keyed by node ID. When subgraphs are
+    flattened, their nodes are inlined in rendering order and their IO
+    nodes are wired through, so each node gets a key of its own and the
+    arcs refer to keys instead of node IDs.
+ */
+struct GraphLayout
+{
+    juce::Array<void*> nodes; ///< Processors in rendering order
+    std::vector<uint32> keys; ///< key of each node, same order as nodes
+    std::vector<Arc> arcs;
+};
+
 /** Used to calculate the correct sequence of rendering ops needed, based on
     the best re-use of shared buffers at each stage. */
 class GraphBuilder
 {
 public:
     GraphBuilder (GraphNode& graph_,
-                  const Array<void*>& orderedNodes_,
+                  const GraphLayout& layout_,
                   Array<void*>& renderingOps);
 
     int buffersNeeded (PortType type);
     int getTotalLatencySamples() const { return totalLatency; }
 
+    /** Moves the delays of live ops to those of a new plan, if the plan
+        differs only in its delays and each fits. Nothing changes when it
+        returns false. The live ops crossfade over to the new delays on
+        their next block.
+     */
+    static bool retuneDelays (const Array<void*>& liveOps, const Array<void*>& plannedOps);
+
 private:
     //==============================================================================
     GraphNode& graph;
+    const GraphLayout& layout;
     const Array<void*>& orderedNodes;
     Array<uint32> allNodes[PortType::Unknown];
     Array<uint32> allPorts[PortType::Unknown];
@@ -52,28 +143,66 @@ private:
     {
         freeNodeID = 0xffffffff,
         zeroNodeID = 0xfffffffe,
-        anonymousNodeID = 0xfffffffd
+        anonymousNodeID = 0xfffffffd,
+        busNodeID = 0xfffffffc ///< held by an aux bus for the whole program
     };
 
     static bool isNodeBusy (uint32 nodeID) noexcept { return nodeID != freeNodeID && nodeID != zeroNodeID; }
 
-    Array<uint32> nodeDelayIDs;
-    Array<int> nodeDelays;
+    std::unordered_map<uint32, int> nodeDelays;
     int totalLatency;
 
+    // lookup tables built once per rebuild so the passes below stay linear.
+    struct PortUse
+    {
+        int step;
+        uint32 port;
+    };
+
+    static uint64 portKey (uint32 nodeId, uint32 port) noexcept { return ((uint64) nodeId << 32) | (uint64) port; }
+
+    std::unordered_map<uint32, Processor*> nodeMap;
+    std::unordered_map<const Processor*, uint32> nodeKeys;
+    // arcs into each node, grouped by node then port in one array, and
+    // where each node's group starts and ends.
+    std::vector<const Arc*> inputArcs;
+    std::unordered_map<uint32, std::pair<size_t, size_t>> inputRanges;
+    std::unordered_map<uint64, std::vector<PortUse>> outputUses;
+    std::unordered_map<uint64, int> bufferLookup[PortType::Unknown];
+
+    // aux buses keyed by the graph they're in and the bus number.
+    struct AuxBus
+    {
+        std::vector<int> buffers;
+        int returnsLeft = 0;
+    };
+
+    std::map<std::pair<const void*, int>, AuxBus> auxBuses;
+
+    void createAuxBuses (Array<void*>& renderingOps);
+    AuxBus* getAuxBus (Processor* node, bool isReturn) noexcept;
+
+    void buildLookupTables();
+    Processor* getNode (uint32 nodeId) const noexcept;
+    uint32 getKey (const Processor* node) const noexcept;
+
     int getNodeDelay (const uint32 nodeID) const;
     void setNodeDelay (const uint32 nodeID, const int latency);
 
     int getInputLatency (const uint32 nodeID) const;
 
+    /** Returns the arcs into a node's port in the order they were made. */
+    std::pair<const Arc* const*, const Arc* const*> getInputs (uint32 nodeID, uint32 port) const noexcept;
+
     void createRenderingOpsForNode (Processor* const node, Array<void*>& renderingOps, const int ourRenderingIndex);
+    void groupDelayOps (Array<void*>& renderingOps, const int firstOp);
+    void fuseGainStage (Array<void*>& renderingOps, const int firstOp);
 
     int getFreeBuffer (PortType type);
     int getReadOnlyEmptyBuffer() const noexcept;
     int getBufferContaining (const PortType type, const uint32 nodeId, const uint32 outputPort) noexcept;
     void markUnusedBuffersFree (const int stepIndex);
     bool isBufferNeededLater (int stepIndexToSearchFrom, uint32 inputChannelOfIndexToIgnore, const uint32 sourceNode, const uint32 outputPortIndex) const;
-    bool isBufferNeededLater2 (int stepIndexToSearchFrom, uint32 inputChannelOfIndexToIgnore, const uint32 sourceNode, const uint32 outputPortIndex) const;
 
     void markBufferAsContaining (int bufferNum, PortType type, uint32 nodeId, uint32 portIndex);
 
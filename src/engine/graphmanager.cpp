@@ -11,6 +11,7 @@
 #include "nodes/midiprogrammap.hpp"
 #include "nodes/placeholder.hpp"
 #include "engine/rootgraph.hpp"
+#include "session/sessionprofile.hpp"
 
 #include "utils.hpp"
 
@@ -154,20 +155,63 @@ public:
     {
         jassert (object != nullptr);
         if (object)
+        {
             portsChangedConnection = object->portsChanged.connect (
-                std::bind (&NodeModelUpdater::onPortsChanged, this));
+                std::bind (&NodeModelUpdater::queue, this, portsPending));
+            signalFaultedConnection = object->signalFaulted.connect (
+                std::bind (&NodeModelUpdater::queue, this, faultPending));
+        }
     }
 
     ~NodeModelUpdater()
     {
         portsChangedConnection.disconnect();
+        signalFaultedConnection.disconnect();
+    }
+
+    /** Brings the model up to date with everything noted since the last
+        call. The manager syncs the arcs afterwards. Message thread.
+     */
+    void applyPending()
+    {
+        const int flags = pending.exchange (0);
+
+        // removed while queued, its model isn't part of the graph any more.
+        if (object.get() != &manager.getGraph() && manager.getNodeForId (object->nodeId) != object)
+            return;
+
+        if ((flags & faultPending) != 0)
+            onSignalFaulted();
+        if ((flags & portsPending) != 0)
+            onPortsChanged();
     }
 
 private:
+    enum
+    {
+        portsPending = 1 << 0,
+        faultPending = 1 << 1
+    };
+
     GraphManager& manager;
     ValueTree data;
     ProcessorPtr object;
     SignalConnection portsChangedConnection;
+    SignalConnection signalFaultedConnection;
+    std::atomic<int> pending { 0 };
+
+    void queue (int flag)
+    {
+        // only the first change since the last batch queues this object.
+        if (pending.fetch_or (flag) == 0)
+            manager.queueModelUpdate (this);
+    }
+
+    void onSignalFaulted()
+    {
+        // the guard bypassed the node, show it.
+        data.setProperty (tags::bypass, object->isSuspended(), nullptr);
+    }
 
     void onPortsChanged()
     {
@@ -181,13 +225,12 @@ private:
                 index = -1;
 
             data.addChild (newPorts, index, nullptr);
-            manager.removeIllegalConnections();
+            manager.removeIllegalConnections (object->nodeId);
         }
         if (object->isGraph())
         {
             IONodeEnforcer enforce (manager);
         }
-        manager.syncArcsModel();
     }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NodeModelUpdater)
@@ -269,6 +312,12 @@ GraphManager::GraphManager (GraphNode& pg, PluginManager& pm)
 
 GraphManager::~GraphManager()
 {
+    cancelPendingUpdate();
+    {
+        ScopedLock sl (pendingLock);
+        pendingUpdates.clear();
+    }
+
     // Make sure to dereference Processor's so we don't leak memory
     // If you get warnings by juce's leak detector about graph related
     // objects, then there's probably "object" properties lingering that
@@ -343,6 +392,60 @@ Processor* GraphManager::createPlaceholder (const Node& node)
     return processor.addNode (new AudioProcessorNode (node.getNodeId(), ph), node.getNodeId());
 }
 
+void GraphManager::loadInBackground (const Node& node, const PluginDescription& desc)
+{
+    const auto nodeId = node.getNodeId();
+    ProcessorPtr placeholder = processor.getNodeForId (nodeId);
+    std::weak_ptr<int> token = loads;
+
+    // counted in the profile of the load that started it, however late.
+    auto profile = SessionProfile::getCurrent();
+    const auto startTicks = Time::getHighResolutionTicks();
+    const auto name = node.getName();
+    const auto pluginName = desc.name;
+    pluginManager.createAudioPluginAsync (desc, [this, token, nodeId, placeholder, profile, startTicks, name, pluginName] (std::unique_ptr<AudioPluginInstance> plugin, const String& error) {
+        if (profile != nullptr)
+            profile->add (SessionProfile::instantiate,
+                          Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks),
+                          name,
+                          pluginName);
+        if (! token.expired())
+        {
+            SessionProfile::Timer timer (profile, SessionProfile::restore, name, pluginName);
+            swapInLoadedPlugin (nodeId, placeholder, std::move (plugin), error);
+        }
+    });
+}
+
+void GraphManager::swapInLoadedPlugin (uint32 nodeId, const ProcessorPtr& placeholder, std::unique_ptr<AudioPluginInstance> plugin, const String& error)
+{
+    // the node may have been removed while the plugin loaded.
+    Node node (getNodeModelForId (nodeId));
+    if (! node.isValid() || processor.getNodeForId (nodeId) != placeholder.get())
+        return;
+
+    if (plugin == nullptr)
+    {
+        std::clog << "[element] error creating audio plugin: " << error.toStdString() << std::endl;
+        node.data().setProperty (tags::missing, true, nullptr);
+        changed();
+        return;
+    }
+
+    plugin->enableAllBuses();
+    ProcessorPtr obj = NodeFactory::wrap (plugin.release());
+
+    // restore buses and state first so connections are checked against
+    // the ports the session saved.
+    setupNode (node.data(), obj);
+    if (! processor.replaceNode (nodeId, obj.get()))
+        return;
+    node.data().removeProperty (tags::missing, nullptr);
+    obj->setEnabled (node.isEnabled());
+    node.setProperty (tags::enabled, obj->isEnabled());
+    processorArcsChanged();
+}
+
 //==============================================================================
 uint32 GraphManager::addNode (const Node& newNode)
 {
@@ -392,7 +495,14 @@ uint32 GraphManager::addNode (const PluginDescription* desc, double rx, double r
         return EL_INVALID_NODE;
     }
 
-    if (auto* object = createFilter (desc, rx, ry, nodeId))
+    // a warm instance makes adding a frequently used plugin instant.
+    Processor* object = nullptr;
+    if (auto plugin = pluginManager.takeWarmPlugin (*desc))
+        object = processor.addNode (NodeFactory::wrap (plugin.release()), nodeId);
+    if (object == nullptr)
+        object = createFilter (desc, rx, ry, nodeId);
+
+    if (object != nullptr)
     {
         nodeId = object->nodeId;
         ValueTree data = ! object->isGraph() ? ValueTree (types::Node)
@@ -500,7 +610,10 @@ void GraphManager::removeNode (const uint32 uid)
             if (obj)
             {
                 obj->willBeRemoved();
-                obj->releaseResources();
+                if (isBatching())
+                    released.add (obj);
+                else
+                    obj->releaseResources();
             }
 
             for (int i = bindings.size(); --i >= 0;)
@@ -555,6 +668,12 @@ void GraphManager::removeIllegalConnections()
         processorArcsChanged();
 }
 
+void GraphManager::removeIllegalConnections (const uint32 nodeId)
+{
+    if (processor.removeIllegalConnections (nodeId))
+        processorArcsChanged();
+}
+
 int GraphManager::getNumConnections() const noexcept
 {
     jassert (arcs.getNumChildren() == processor.getNumConnections());
@@ -599,7 +718,9 @@ void GraphManager::removeConnection (uint32 sourceNode, uint32 sourcePort, uint3
 
 void GraphManager::setNodeModel (const Node& node)
 {
+    const ScopedBatch batch (*this);
     loaded = false;
+    loads = std::make_shared<int> (0);
 
     processor.clear();
     graph = node.data();
@@ -619,9 +740,31 @@ void GraphManager::setNodeModel (const Node& node)
     {
         Node node (nodes.getChild (i), false);
         const PluginDescription desc (pluginManager.findDescriptionFor (node));
-        if (ProcessorPtr obj = createFilter (&desc, 0, 0, node.getNodeId()))
+
+        // plugins start as placeholders and load without holding up the
+        // session. Each takes over from its placeholder once it's ready.
+        if (pluginManager.canCreateAudioPluginAsync (desc))
         {
-            setupNode (node.data(), obj);
+            if (ProcessorPtr ph = createPlaceholder (node))
+            {
+                node.data().setProperty (tags::object, ph.get(), nullptr);
+                loadInBackground (node, desc);
+                continue;
+            }
+        }
+
+        ProcessorPtr obj;
+        {
+            SessionProfile::Timer timer (SessionProfile::instantiate, node.getName(), desc.name);
+            obj = createFilter (&desc, 0, 0, node.getNodeId());
+        }
+
+        if (obj != nullptr)
+        {
+            {
+                SessionProfile::Timer timer (SessionProfile::restore, node.getName(), desc.name);
+                setupNode (node.data(), obj);
+            }
             obj->setEnabled (node.isEnabled());
             node.setProperty (tags::enabled, obj->isEnabled());
         }
@@ -648,10 +791,6 @@ void GraphManager::setNodeModel (const Node& node)
     // If you hit this, then failed nodes didn't get handled properly
     jassert (nodes.getNumChildren() == processor.getNumNodes());
 
-    // Cheap way to refresh engine-side nodes
-    processor.triggerAsyncUpdate();
-    processor.handleUpdateNowIfNeeded();
-
     for (int i = 0; i < arcs.getNumChildren(); ++i)
     {
         ValueTree arc (arcs.getChild (i));
@@ -715,6 +854,7 @@ void GraphManager::savePluginStates()
 void GraphManager::clear()
 {
     loaded = false;
+    loads = std::make_shared<int> (0);
 
     if (graph.isValid())
     {
@@ -728,11 +868,80 @@ void GraphManager::clear()
     }
 
     processor.clear();
+    for (auto* obj : released)
+        obj->releaseResources();
+    released.clear();
     changed();
 }
 
+void GraphManager::beginBatch()
+{
+    ++batchDepth;
+    processor.beginUpdate();
+    for (auto* b : bindings)
+        if (auto* sub = b->getSubGraphManager())
+            sub->beginBatch();
+}
+
+void GraphManager::endBatch()
+{
+    // subgraphs created during the batch were never held.
+    if (batchDepth <= 0)
+        return;
+
+    for (auto* b : bindings)
+        if (auto* sub = b->getSubGraphManager())
+            sub->endBatch();
+
+    if (--batchDepth > 0)
+        return;
+
+    processor.endUpdate();
+    for (auto* obj : released)
+        obj->releaseResources();
+    released.clear();
+
+    if (arcsChanged)
+    {
+        arcsChanged = false;
+        processorArcsChanged();
+    }
+}
+
+void GraphManager::queueModelUpdate (NodeModelUpdater* updater)
+{
+    {
+        ScopedLock sl (pendingLock);
+        pendingUpdates.add (updater);
+    }
+    triggerAsyncUpdate();
+}
+
+void GraphManager::handleAsyncUpdate()
+{
+    ReferenceCountedArray<NodeModelUpdater> updaters;
+    {
+        ScopedLock sl (pendingLock);
+        updaters.swapWith (pendingUpdates);
+    }
+
+    if (updaters.isEmpty())
+        return;
+
+    // every node's model first, then the arcs once for the whole batch.
+    for (auto* updater : updaters)
+        updater->applyPending();
+    syncArcsModel();
+}
+
 void GraphManager::processorArcsChanged()
 {
+    if (isBatching())
+    {
+        arcsChanged = true;
+        return;
+    }
+
     ValueTree newArcs = ValueTree (tags::arcs);
     for (int i = 0; i < processor.getNumConnections(); ++i)
         newArcs.addChild (Node::makeArc (*processor.getConnection (i)), -1, nullptr);
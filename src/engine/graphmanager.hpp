@@ -3,16 +3,20 @@
 
 #pragma once
 
+#include <memory>
+
 #include <element/audioengine.hpp>
 #include "engine/graphnode.hpp"
 #include <element/node.hpp>
 
 namespace element {
 
+class NodeModelUpdater;
 class PluginManager;
 class RootGraph;
 
-class GraphManager : public ChangeBroadcaster
+class GraphManager : public ChangeBroadcaster,
+                     private AsyncUpdater
 {
 public:
     static const uint32 invalidNodeId = EL_INVALID_PORT;
@@ -75,6 +79,7 @@ public:
     void removeConnection (uint32 sourceNode, uint32 sourcePort, uint32 destNode, uint32 destPort);
 
     void removeIllegalConnections();
+    void removeIllegalConnections (uint32 nodeId);
 
     void clear();
 
@@ -92,6 +97,29 @@ public:
 
     inline bool isLoaded() const { return loaded; }
 
+    /** Hold engine updates until the matching endBatch(). Bulk edits like
+        pasting nodes, loading a graph or running a script then rebuild the
+        engine and the arcs model once, when the outermost batch ends.
+        Subgraphs are held too. Calls nest.
+     */
+    void beginBatch();
+    void endBatch();
+
+    /** Returns true while a batch is held. */
+    bool isBatching() const noexcept { return batchDepth > 0; }
+
+    /** Holds a batch for its lifetime. */
+    class ScopedBatch final
+    {
+    public:
+        explicit ScopedBatch (GraphManager& m) : manager (m) { manager.beginBatch(); }
+        ~ScopedBatch() { manager.endBatch(); }
+
+    private:
+        GraphManager& manager;
+        JUCE_DECLARE_NON_COPYABLE (ScopedBatch)
+    };
+
 private:
     PluginManager& pluginManager;
     GraphNode& processor;
@@ -100,15 +128,37 @@ private:
 
     uint32 lastUID;
 
+    // plugins still loading hold a weak reference. A new model or clear()
+    // replaces it, so late loads are dropped.
+    std::shared_ptr<int> loads { std::make_shared<int> (0) };
+
     class Binding;
     friend class Binding;
     OwnedArray<Binding> bindings;
 
+    // while batching, removed nodes wait here to be released and arc
+    // changes are noted instead of synced.
+    int batchDepth = 0;
+    bool arcsChanged = false;
+    ReferenceCountedArray<Processor> released;
+
+    // engine objects note port and fault changes here from any thread.
+    // Each object is queued once, and the batch is applied to the model
+    // on the message thread with a single arcs sync.
+    friend class NodeModelUpdater;
+    CriticalSection pendingLock;
+    ReferenceCountedArray<NodeModelUpdater> pendingUpdates;
+    void queueModelUpdate (NodeModelUpdater* updater);
+    void handleAsyncUpdate() override;
+
     uint32 getNextUID() noexcept;
     inline void changed() { sendChangeMessage(); }
     Processor* createFilter (const PluginDescription* desc, double x = 0.0f, double y = 0.0f, uint32 nodeId = 0);
     Processor* createPlaceholder (const Node& node);
 
+    void loadInBackground (const Node& node, const PluginDescription& desc);
+    void swapInLoadedPlugin (uint32 nodeId, const ProcessorPtr& placeholder, std::unique_ptr<AudioPluginInstance> plugin, const String& error);
+
     void setupNode (const ValueTree& data, ProcessorPtr object);
 
     void processorArcsChanged();
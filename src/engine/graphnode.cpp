@@ -1,6 +1,14 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <element/atombuffer.hpp>
 #include <element/audioengine.hpp>
 #include <element/midipipe.hpp>
 #include <element/node.hpp>
@@ -8,12 +16,20 @@
 #include <element/context.hpp>
 #include <element/symbolmap.hpp>
 
+#include "engine/diskstream.hpp"
+#include "engine/fixedmidi.hpp"
 #include "engine/graphbuilder.hpp"
+#include "engine/graphschedule.hpp"
 #include "engine/ionode.hpp"
+#include "engine/offlinerender.hpp"
+#include "engine/resampler.hpp"
 #include "nodes/audioprocessor.hpp"
-#include "engine/miditranspose.hpp"
+#include "nodes/auxbus.hpp"
 #include "nodes/nodetypes.hpp"
 #include "engine/graphnode.hpp"
+#include "engine/renderthreadpool.hpp"
+#include "engine/rendertrace.hpp"
+#include "session/sessionprofile.hpp"
 
 #ifndef EL_GRAPH_NODE_NAME
 #define EL_GRAPH_NODE_NAME "Graph"
@@ -21,6 +37,112 @@
 
 namespace element {
 
+/** Threads that prepare nodes away from the message and audio threads,
+    shared by every graph.
+ */
+struct GraphNode::PrepareThreads
+{
+    ThreadPool pool { jlimit (1, 8, SystemStats::getNumCpus() - 1) };
+};
+
+/* runs fn for every index in parallel. The caller takes items too, so
+   nested graphs preparing their own nodes can't starve the pool. */
+static void forEachInParallel (ThreadPool& pool, int count, const std::function<void (int)>& fn)
+{
+    if (count < 2)
+    {
+        for (int i = 0; i < count; ++i)
+            fn (i);
+        return;
+    }
+
+    struct Shared
+    {
+        std::atomic<int> next { 0 }, done { 0 };
+        WaitableEvent finished;
+    };
+
+    auto shared = std::make_shared<Shared>();
+    auto work = [shared, count, fn]() {
+        for (int i; (i = shared->next++) < count;)
+        {
+            fn (i);
+            if (++shared->done == count)
+                shared->finished.signal();
+        }
+    };
+
+    for (int i = 1; i < jmin (count, pool.getNumThreads() + 1); ++i)
+        pool.addJob (work);
+    work();
+    shared->finished.wait();
+}
+
+void GraphNode::prepareInParallel (ThreadPool& pool, const ReferenceCountedArray<Processor>& nodes, double sampleRate, int blockSize, GraphNode* graph)
+{
+    auto profile = SessionProfile::getCurrent();
+    auto* const items = nodes.begin();
+    forEachInParallel (pool, nodes.size(), [items, sampleRate, blockSize, graph, profile] (int i) {
+        SessionProfile::Timer timer (profile, SessionProfile::prepare, items[i]->getName());
+        items[i]->prepare (sampleRate, blockSize, graph);
+    });
+}
+
+void GraphNode::prepareGraphs (const Array<GraphNode*>& graphs, double sampleRate, int blockSize)
+{
+    SharedResourcePointer<PrepareThreads> threads;
+    auto* const items = graphs.begin();
+    forEachInParallel (threads->pool, graphs.size(), [items, sampleRate, blockSize] (int i) {
+        items[i]->prepareToRender (sampleRate, blockSize);
+    });
+}
+
+/** Polls node latencies on the message thread, so changes made on the
+    audio thread, or never announced, are seen. Changes within one
+    interval are re-planned together.
+ */
+struct GraphNode::LatencyWatch : public Timer
+{
+    static constexpr int interval = 100;
+
+    explicit LatencyWatch (GraphNode& g) : graph (g) {}
+    void timerCallback() override { graph.checkLatencies(); }
+
+    GraphNode& graph;
+};
+
+/** A frozen render and the player streaming it in place of the graph. */
+struct GraphNode::Freeze
+{
+    File file;
+    DiskStreamPlayer player;
+
+    // the thread rendering the graph offline, for which it isn't frozen.
+    std::atomic<std::thread::id> renderer;
+    std::atomic<bool> ready { false };
+    bool prepared = false; // message thread
+};
+
+/** The converters a graph at its own rate renders between. */
+struct GraphNode::Bridge
+{
+    RateBridge rates;
+    AudioSampleBuffer cv; // no channels, graphs don't route CV
+    AtomBuffer atoms;
+};
+
+Optional<AudioPlayHead::PositionInfo> GraphNode::RatePlayHead::getPosition() const
+{
+    auto* const ph = source.load();
+    if (ph == nullptr)
+        return {};
+    auto pos = ph->getPosition();
+    if (pos)
+        if (auto time = pos->getTimeInSamples())
+            pos->setTimeInSamples ((int64) std::llround ((double) *time * ratio.load()));
+    return pos;
+}
+
 GraphNode::Connection::Connection (const uint32 sourceNode_, const uint32 sourcePort_, const uint32 destNode_, const uint32 destPort_) noexcept
     : Arc (sourceNode_, sourcePort_, destNode_, destPort_) {}
 
@@ -31,11 +153,11 @@ GraphNode::GraphNode (Context& c)
                      .toPortList()),
       _context (c),
       lastNodeId (0),
-      renderingBuffers (1, 1),
       currentAudioInputBuffer (nullptr),
       currentAudioOutputBuffer (1, 1),
       currentMidiInputBuffer (nullptr)
 {
+    latencyWatch = std::make_unique<LatencyWatch> (*this);
     for (int i = 0; i < IONode::numDeviceTypes; ++i)
         ioNodes[i] = EL_INVALID_PORT;
     setName (EL_GRAPH_NODE_NAME);
@@ -43,8 +165,11 @@ GraphNode::GraphNode (Context& c)
 
 GraphNode::~GraphNode()
 {
+    latencyWatch.reset();
     renderingSequenceChanged.disconnect_all_slots();
     clearRenderingSequence();
+    retireBridge();
+    thaw();
     clear();
 }
 
@@ -52,16 +177,45 @@ void GraphNode::clear()
 {
     clearRenderingSequence();
     nodes.clear();
+    nodeSlots.clear();
+    for (auto* n : retired)
+        n->setParentGraph (nullptr);
+    retired.clear();
     connections.clear();
+    arcs.clear();
+    nodeOrder.clearQuick();
 }
 
 Processor* GraphNode::getNodeForId (const uint32 nodeId) const
 {
-    for (int i = nodes.size(); --i >= 0;)
-        if (nodes.getUnchecked (i)->nodeId == nodeId)
-            return nodes.getUnchecked (i);
+    const auto iter = nodeSlots.find (nodeId);
+    return iter != nodeSlots.end() ? nodes.getUnchecked (iter->second) : nullptr;
+}
+
+const GraphNode::Arcs* GraphNode::findArcs (const uint32 nodeId) const
+{
+    const auto iter = arcs.find (nodeId);
+    return iter != arcs.end() ? &iter->second : nullptr;
+}
 
-    return nullptr;
+void GraphNode::addArcs (const Connection* c)
+{
+    arcs[c->sourceNode].outputs.add (c);
+    arcs[c->destNode].inputs.add (c);
+}
+
+void GraphNode::removeArcs (const Connection* c)
+{
+    for (auto id : { c->sourceNode, c->destNode })
+    {
+        auto iter = arcs.find (id);
+        if (iter == arcs.end())
+            continue;
+        iter->second.inputs.removeFirstMatchingValue (c);
+        iter->second.outputs.removeFirstMatchingValue (c);
+        if (iter->second.inputs.isEmpty() && iter->second.outputs.isEmpty())
+            arcs.erase (iter);
+    }
 }
 
 Processor* GraphNode::addNode (Processor* newNode, uint32 nodeId)
@@ -72,13 +226,10 @@ Processor* GraphNode::addNode (Processor* newNode, uint32 nodeId)
         return nullptr;
     }
 
-    for (int i = nodes.size(); --i >= 0;)
+    if (getNodeForId (newNode->nodeId) == newNode)
     {
-        if (nodes.getUnchecked (i).get() == newNode)
-        {
-            jassertfalse; // Cannot add the same object to the graph twice!
-            return nullptr;
-        }
+        jassertfalse; // Cannot add the same object to the graph twice!
+        return nullptr;
     }
 
     if (nodeId == 0 || nodeId == EL_INVALID_NODE)
@@ -101,39 +252,79 @@ Processor* GraphNode::addNode (Processor* newNode, uint32 nodeId)
             lastNodeId = nodeId;
     }
 
-    newNode->setPlayHead (playhead);
+    newNode->setPlayHead (getNodePlayHead());
     newNode->setParentGraph (this);
     newNode->refreshPorts();
     if (prepared())
-        newNode->prepare (getSampleRate(), getBlockSize(), this);
+    {
+        // plugins can take a while, everything else is quick enough here.
+        if (newNode->getAudioPluginInstance() != nullptr)
+            prepareInBackground (newNode);
+        else
+            newNode->prepare (getSampleRate(), getBlockSize(), this);
+    }
     triggerAsyncUpdate();
+    // a node without connections can render anywhere, so appending keeps
+    // the cached order valid.
+    nodeOrder.add (newNode);
+    nodeSlots[newNode->nodeId] = nodes.size();
     return nodes.add (newNode);
 }
 
 bool GraphNode::removeNode (const uint32 nodeId)
 {
     disconnectNode (nodeId);
-    for (int i = nodes.size(); --i >= 0;)
-    {
-        ProcessorPtr n = nodes.getUnchecked (i);
-        if (n->nodeId == nodeId)
-        {
-            nodes.remove (i);
+    const auto iter = nodeSlots.find (nodeId);
+    if (iter == nodeSlots.end())
+        return false;
 
-            handleAsyncUpdate();
-            n->setParentGraph (nullptr);
-            n->setPlayHead (nullptr);
+    const int slot = iter->second;
+    nodeSlots.erase (iter);
+    ProcessorPtr n = nodes.getUnchecked (slot);
+    nodes.remove (slot);
+    for (int i = slot; i < nodes.size(); ++i)
+        nodeSlots[nodes.getUnchecked (i)->nodeId] = i;
 
-            if (n->isSubGraph())
-            {
-                DBG ("[element] sub graph removed");
-            }
+    nodeOrder.removeFirstMatchingValue (n.get());
+    retire (n);
 
-            return true;
-        }
+    if (n->isSubGraph())
+    {
+        DBG ("[element] sub graph removed");
     }
 
-    return false;
+    return true;
+}
+
+bool GraphNode::replaceNode (const uint32 nodeId, Processor* newNode)
+{
+    ProcessorPtr added (newNode);
+    if (added == nullptr || (void*) added->getAudioProcessor() == (void*) this)
+    {
+        jassertfalse;
+        return false;
+    }
+
+    const auto iter = nodeSlots.find (nodeId);
+    if (iter == nodeSlots.end())
+        return false;
+
+    ProcessorPtr n = nodes.getUnchecked (iter->second);
+    const_cast<uint32&> (added->nodeId) = nodeId;
+    added->setPlayHead (getNodePlayHead());
+    added->setParentGraph (this);
+    added->refreshPorts();
+    if (prepared())
+        added->prepare (getSampleRate(), getBlockSize(), this);
+
+    nodes.set (iter->second, added);
+    const int order = nodeOrder.indexOf (n.get());
+    if (order >= 0)
+        nodeOrder.set (order, added.get());
+
+    removeIllegalConnections (nodeId);
+    retire (n);
+    return true;
 }
 
 const GraphNode::Connection*
@@ -150,16 +341,10 @@ const GraphNode::Connection*
 bool GraphNode::isConnected (const uint32 sourceNode,
                              const uint32 destNode) const
 {
-    for (int i = connections.size(); --i >= 0;)
-    {
-        const Connection* const c = connections.getUnchecked (i);
-
-        if (c->sourceNode == sourceNode
-            && c->destNode == destNode)
-        {
-            return true;
-        }
-    }
+    if (const auto* a = findArcs (sourceNode))
+        for (const auto* c : a->outputs)
+            if (c->destNode == destNode)
+                return true;
 
     return false;
 }
@@ -216,10 +401,9 @@ bool GraphNode::canConnect (const uint32 sourceNode, const uint32 sourcePort, co
     if (destType == PortType::Control || 
         (sourceType == PortType::Control && destType == PortType::CV))
     {
-        int numSources = 0;
-        for (const auto* c : connections)
-            if (c->destNode == destNode && c->destPort == destPort)
-                if (++numSources > 0)
+        if (const auto* a = findArcs (destNode))
+            for (const auto* c : a->inputs)
+                if (c->destPort == destPort)
                     return false;
     }
     // clang-format on
@@ -235,6 +419,8 @@ bool GraphNode::addConnection (const uint32 sourceNode, const uint32 sourcePort,
     ArcSorter sorter;
     Connection* c = new Connection (sourceNode, sourcePort, destNode, destPort);
     connections.addSorted (sorter, c);
+    addArcs (c);
+    updateNodeOrder (sourceNode, destNode);
     triggerAsyncUpdate();
     return true;
 }
@@ -250,6 +436,8 @@ bool GraphNode::connectChannels (PortType type, uint32 sourceNode, int32 sourceC
 
 void GraphNode::removeConnection (const int index)
 {
+    if (auto* c = connections[index])
+        removeArcs (c);
     connections.remove (index);
     cancelPendingUpdate();
     triggerAsyncUpdate();
@@ -257,41 +445,31 @@ void GraphNode::removeConnection (const int index)
 
 bool GraphNode::removeConnection (const uint32 sourceNode, const uint32 sourcePort, const uint32 destNode, const uint32 destPort)
 {
-    bool doneAnything = false;
-
-    for (int i = connections.size(); --i >= 0;)
-    {
-        const Connection* const c = connections.getUnchecked (i);
-
-        if (c->sourceNode == sourceNode
-            && c->destNode == destNode
-            && c->sourcePort == sourcePort
-            && c->destPort == destPort)
-        {
-            removeConnection (i);
-            doneAnything = true;
-        }
-    }
+    // canConnect() refuses duplicates, so there's at most one.
+    const Connection c (sourceNode, sourcePort, destNode, destPort);
+    ArcSorter sorter;
+    const int index = connections.indexOfSorted (sorter, &c);
+    if (index < 0)
+        return false;
 
-    return doneAnything;
+    removeConnection (index);
+    return true;
 }
 
 bool GraphNode::disconnectNode (const uint32 nodeId)
 {
-    bool doneAnything = false;
+    const auto* a = findArcs (nodeId);
+    if (a == nullptr)
+        return false;
 
-    for (int i = connections.size(); --i >= 0;)
-    {
-        const Connection* const c = connections.getUnchecked (i);
+    Array<const Connection*> found (a->inputs);
+    found.addArray (a->outputs);
 
-        if (c->sourceNode == nodeId || c->destNode == nodeId)
-        {
-            removeConnection (i);
-            doneAnything = true;
-        }
-    }
+    ArcSorter sorter;
+    for (const auto* c : found)
+        removeConnection (connections.indexOfSorted (sorter, c));
 
-    return doneAnything;
+    return true;
 }
 
 bool GraphNode::isConnectionLegal (const Connection* const c) const
@@ -324,6 +502,25 @@ bool GraphNode::removeIllegalConnections()
     return doneAnything;
 }
 
+bool GraphNode::removeIllegalConnections (const uint32 nodeId)
+{
+    const auto* a = findArcs (nodeId);
+    if (a == nullptr)
+        return false;
+
+    Array<const Connection*> illegal;
+    for (const auto* list : { &a->inputs, &a->outputs })
+        for (const auto* c : *list)
+            if (! isConnectionLegal (c))
+                illegal.add (c);
+
+    ArcSorter sorter;
+    for (const auto* c : illegal)
+        removeConnection (connections.indexOfSorted (sorter, c));
+
+    return ! illegal.isEmpty();
+}
+
 void GraphNode::setMidiChannel (const int channel) noexcept
 {
     jassert (isPositiveAndBelow (channel, 17));
@@ -331,18 +528,21 @@ void GraphNode::setMidiChannel (const int channel) noexcept
         midiChannels.setOmni (true);
     else
         midiChannels.setChannel (channel);
+    midiFilterChanged.store (true);
 }
 
 void GraphNode::setMidiChannels (const BigInteger channels) noexcept
 {
     ScopedLock sl (getPropertyLock());
     midiChannels.setChannels (channels);
+    midiFilterChanged.store (true);
 }
 
 void GraphNode::setMidiChannels (const MidiChannels channels) noexcept
 {
     ScopedLock sl (getPropertyLock());
     midiChannels = channels;
+    midiFilterChanged.store (true);
 }
 
 bool GraphNode::acceptsMidiChannel (const int channel) const noexcept
@@ -355,6 +555,7 @@ void GraphNode::setVelocityCurveMode (const VelocityCurve::Mode mode) noexcept
 {
     ScopedLock sl (getPropertyLock());
     velocityCurve.setMode (mode);
+    midiFilterChanged.store (true);
 }
 
 static void deleteRenderOpArray (Array<void*>& ops)
@@ -364,16 +565,277 @@ static void deleteRenderOpArray (Array<void*>& ops)
     ops.clearQuick();
 }
 
-void GraphNode::clearRenderingSequence()
+struct GraphNode::RenderSequence
 {
-    Array<void*> oldOps;
+    ~RenderSequence()
+    {
+        schedule.reset();
+        deleteRenderOpArray (ops);
+    }
 
+    /** Carve the audio and CV buffers out of one aligned block. */
+    void allocateAudio (int numChannels, int numFrames)
     {
-        const ScopedLock sl (seqLock);
-        renderingOps.swapWith (oldOps);
+        static constexpr size_t alignment = 64;
+        numChannels = jmax (1, numChannels);
+        capacity = jmax (1, numFrames);
+
+        // round each channel up so every one starts on a cache line.
+        const auto stride = ((size_t) capacity * sizeof (float) + alignment - 1) & ~(alignment - 1);
+        audioBytes = stride * (size_t) numChannels;
+        arena.calloc (audioBytes + alignment);
+        channels.calloc ((size_t) numChannels);
+
+        auto base = (reinterpret_cast<uintptr_t> (arena.get()) + alignment - 1) & ~(uintptr_t) (alignment - 1);
+        for (int c = 0; c < numChannels; ++c)
+            channels[c] = reinterpret_cast<float*> (base + stride * (size_t) c);
+
+        audio.setDataToReferTo (channels.get(), numChannels, capacity);
+    }
+
+    /** Decide which outputs can write straight into the parent's buffers.
+        That holds when every input of the same kind runs before the first
+        output, so nothing reads the parent's buffer after it's written.
+     */
+    void findDirectOutputs()
+    {
+        // indexed by kind, 0 for audio and 1 for MIDI.
+        int lastInput[2] = { -1, -1 };
+        int firstOutput[2] = { -1, -1 };
+
+        for (int i = 0; i < ops.size(); ++i)
+        {
+            GraphOpBuffers buffers;
+            static_cast<GraphOp*> (ops.getUnchecked (i))->collectBuffers (buffers);
+            switch (buffers.ioType)
+            {
+                case IONode::audioInputNode:
+                    lastInput[0] = i;
+                    break;
+                case IONode::midiInputNode:
+                    lastInput[1] = i;
+                    break;
+                case IONode::audioOutputNode:
+                    if (firstOutput[0] < 0)
+                        firstOutput[0] = i;
+                    break;
+                case IONode::midiOutputNode:
+                    if (firstOutput[1] < 0)
+                        firstOutput[1] = i;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        directAudioOutput = firstOutput[0] >= 0 && lastInput[0] < firstOutput[0];
+        directMidiOutput = firstOutput[1] >= 0 && lastInput[1] < firstOutput[1];
+        readsMidiInput = lastInput[1] >= 0;
+    }
+
+    Array<void*> ops;
+    std::unique_ptr<GraphSchedule> schedule;
+    HeapBlock<char> arena;
+    HeapBlock<float*> channels;
+    size_t audioBytes = 0;
+    int capacity = 0;
+    AudioSampleBuffer audio;
+    OwnedArray<MidiBuffer> midi;
+    OwnedArray<AtomBuffer> atom;
+
+    // subgraphs that could be inlined, and whether they were.
+    std::vector<std::pair<GraphNode*, bool>> subgraphs;
+    ReferenceCountedArray<Processor> retained;
+
+    // aux nodes and the bus each was built for.
+    std::vector<std::pair<AuxBusProcessor*, int>> auxNodes;
+
+    // every rendered node and the latency it was planned with.
+    std::vector<std::pair<Processor*, int>> latencies;
+
+    bool directAudioOutput = false;
+    bool directMidiOutput = false;
+    bool readsMidiInput = false;
+};
+
+/** Lays out a graph's nodes and arcs for the builder, inlining subgraphs
+    that can be flattened.
+
+    Each port of an inlined subgraph becomes a wire. Arcs into the port and
+    arcs out of the matching IO node both attach to the wire, and once
+    everything is collected the wires are followed through to real nodes.
+ */
+struct GraphNode::Flattener
+{
+    struct End
+    {
+        uint32 key;
+        uint32 port;
+    };
+
+    using PortWires = std::unordered_map<uint32, uint32>;
+
+    struct Scope
+    {
+        std::unordered_map<uint32, uint32> keys; ///< node ID to key
+        std::unordered_map<uint32, PortWires> subgraphs; ///< node ID to port wires
+    };
+
+    Flattener (GraphLayout& l, RenderSequence& s, bool f)
+        : layout (l), sequence (s), flatten (f) {}
+
+    void addGraph (GraphNode& graph, Scope& scope, const PortWires* graphPorts)
+    {
+        if (! graph.isNodeOrderValid())
+            graph.sortNodeOrder();
+
+        for (auto* node : graph.nodeOrder)
+        {
+            if (node->isSubGraph() && flatten)
+            {
+                auto* sub = static_cast<GraphNode*> (node);
+                const bool inlined = sub->isFlattenable();
+                sequence.subgraphs.push_back ({ sub, inlined });
+                sequence.retained.add (sub);
+                sub->flattenedInto = inlined ? &graph : nullptr;
+
+                if (inlined)
+                {
+                    addSubgraph (*sub, scope);
+                    continue;
+                }
+            }
+
+            // a flattened graph's IO nodes are replaced by its port wires.
+            if (graphPorts != nullptr && dynamic_cast<IONode*> (node) != nullptr)
+                continue;
+
+            const uint32 key = graphPorts == nullptr ? node->nodeId : nextKey++;
+            scope.keys[node->nodeId] = key;
+            layout.nodes.add (node);
+            layout.keys.push_back (key);
+        }
+
+        for (const auto* c : graph.connections)
+        {
+            End src, dst;
+            if (resolve (graph, scope, graphPorts, c->sourceNode, c->sourcePort, src)
+                && resolve (graph, scope, graphPorts, c->destNode, c->destPort, dst))
+                arcs.emplace_back (src.key, src.port, dst.key, dst.port);
+        }
+    }
+
+    void addSubgraph (GraphNode& sub, Scope& parent)
+    {
+        auto& ports = parent.subgraphs[sub.nodeId];
+        for (uint32 port = 0; port < (uint32) sub.getNumPorts(); ++port)
+        {
+            ports[port] = nextKey;
+            wires.insert (nextKey++);
+        }
+
+        Scope inner;
+        addGraph (sub, inner, &ports);
+    }
+
+    bool resolve (GraphNode& graph, const Scope& scope, const PortWires* graphPorts, uint32 nodeId, uint32 port, End& end) const
+    {
+        auto key = scope.keys.find (nodeId);
+        if (key != scope.keys.end())
+        {
+            end = { key->second, port };
+            return true;
+        }
+
+        auto sub = scope.subgraphs.find (nodeId);
+        if (sub != scope.subgraphs.end())
+        {
+            auto wire = sub->second.find (port);
+            if (wire == sub->second.end())
+                return false;
+            end = { wire->second, 0 };
+            return true;
+        }
+
+        auto* io = graphPorts != nullptr ? dynamic_cast<IONode*> (graph.getNodeForId (nodeId)) : nullptr;
+        if (io == nullptr)
+            return false;
+
+        // an IO node's channel stands for the same channel of the graph.
+        const bool graphInput = io->getType() == IONode::audioInputNode || io->getType() == IONode::midiInputNode;
+        const auto graphPort = graph.getPortForChannel (io->getPortType(), io->getChannelPort (port), graphInput);
+        auto wire = graphPorts->find (graphPort);
+        if (wire == graphPorts->end())
+            return false;
+        end = { wire->second, 0 };
+        return true;
+    }
+
+    /** Follow every arc through the wires it reaches. */
+    void finish()
+    {
+        std::unordered_map<uint32, std::vector<End>> sinks;
+        for (const auto& arc : arcs)
+            if (wires.count (arc.sourceNode) > 0)
+                sinks[arc.sourceNode].push_back ({ arc.destNode, arc.destPort });
+
+        for (const auto& arc : arcs)
+            if (wires.count (arc.sourceNode) == 0)
+                connect ({ arc.sourceNode, arc.sourcePort }, { arc.destNode, arc.destPort }, sinks, 0);
+    }
+
+    void connect (End src, End dst, const std::unordered_map<uint32, std::vector<End>>& sinks, int depth)
+    {
+        if (wires.count (dst.key) == 0)
+        {
+            layout.arcs.emplace_back (src.key, src.port, dst.key, dst.port);
+            return;
+        }
+
+        auto iter = sinks.find (dst.key);
+        if (iter == sinks.end() || depth > 64)
+            return;
+        for (const auto& next : iter->second)
+            connect (src, next, sinks, depth + 1);
     }
 
-    deleteRenderOpArray (oldOps);
+    GraphLayout& layout;
+    RenderSequence& sequence;
+    const bool flatten;
+    // inlined nodes and wires get keys well clear of node IDs.
+    uint32 nextKey = 0x40000000;
+    std::unordered_set<uint32> wires;
+    std::vector<Arc> arcs;
+};
+
+void GraphNode::publishSequence (RenderSequence* newSequence)
+{
+    std::unique_ptr<RenderSequence> oldSequence (activeSequence.exchange (newSequence));
+    if (oldSequence == nullptr)
+        return;
+
+    // A render that started before the exchange may still be using the old
+    // sequence. Any render starting from now on sees the new one, so wait for
+    // the one in flight to finish. Only this thread waits, never the audio one.
+    const auto epoch = renderEpoch.load();
+    while (rendering.load() && renderEpoch.load() == epoch)
+        std::this_thread::yield();
+}
+
+void GraphNode::clearRenderingSequence()
+{
+    publishSequence (nullptr);
+}
+
+void GraphNode::retireBridge()
+{
+    std::unique_ptr<Bridge> bridge (rateBridge.exchange (nullptr));
+    if (bridge == nullptr)
+        return;
+
+    const auto epoch = renderEpoch.load();
+    while (rendering.load() && renderEpoch.load() == epoch)
+        std::this_thread::yield();
 }
 
 bool GraphNode::isAnInputTo (const uint32 possibleInputId,
@@ -382,23 +844,20 @@ bool GraphNode::isAnInputTo (const uint32 possibleInputId,
 {
     if (recursionCheck > 0)
     {
-        for (int i = connections.size(); --i >= 0;)
-        {
-            const GraphNode::Connection* const c = connections.getUnchecked (i);
-
-            if (c->destNode == possibleDestinationId
-                && (c->sourceNode == possibleInputId
-                    || isAnInputTo (possibleInputId, c->sourceNode, recursionCheck - 1)))
-                return true;
-        }
+        if (const auto* a = findArcs (possibleDestinationId))
+            for (const auto* c : a->inputs)
+                if (c->sourceNode == possibleInputId
+                    || isAnInputTo (possibleInputId, c->sourceNode, recursionCheck - 1))
+                    return true;
     }
 
     return false;
 }
 
-void GraphNode::buildRenderingSequence()
+void GraphNode::buildRenderingSequence (bool onlyLatencyChanged)
 {
-    Array<void*> newRenderingOps;
+    auto sequence = std::make_unique<RenderSequence>();
+    auto& newRenderingOps = sequence->ops;
     int numRenderingBuffersNeeded = 2;
     int numMidiBuffersNeeded = 1;
     int numAtomBuffersNeeded = 1;
@@ -407,75 +866,266 @@ void GraphNode::buildRenderingSequence()
         //XXX:
         //MessageManagerLock mml;
 
-        Array<void*> orderedNodes;
+        GraphLayout layout;
+        Flattener flattener (layout, *sequence, isFlatteningSubgraphs());
+        Flattener::Scope scope;
+        flattener.addGraph (*this, scope, nullptr);
+        flattener.finish();
 
+        for (auto* node : layout.nodes)
         {
-            const LookupTable table (connections);
-
-            for (int i = 0; i < nodes.size(); ++i)
-            {
-                Processor* const node = nodes.getUnchecked (i);
-
-                int j = 0;
-                for (; j < orderedNodes.size(); ++j)
-                    if (table.isAnInputTo (node->nodeId, ((Processor*) orderedNodes.getUnchecked (j))->nodeId))
-                        break;
-
-                orderedNodes.insert (j, node);
-            }
+            auto* const proc = (Processor*) node;
+            if (auto* aux = dynamic_cast<AuxBusProcessor*> (proc->getAudioProcessor()))
+                sequence->auxNodes.push_back ({ aux, aux->getBus() });
+            sequence->latencies.push_back ({ proc, proc->getLatencySamples() });
         }
 
-        GraphBuilder builder (*this, orderedNodes, newRenderingOps);
+        GraphBuilder builder (*this, layout, newRenderingOps);
         numRenderingBuffersNeeded = builder.buffersNeeded (PortType::Audio);
         numMidiBuffersNeeded = builder.buffersNeeded (PortType::Midi);
         numAtomBuffersNeeded = builder.buffersNeeded (PortType::Atom);
-        setLatencySamples (builder.getTotalLatencySamples());
+        auto latency = builder.getTotalLatencySamples();
+        if (auto* const bridge = rateBridge.load())
+        {
+            // the nodes report latency in their own frames.
+            const auto& rates = bridge->rates;
+            latency = roundToInt (latency * rates.getOuterRate() / rates.getInnerRate()) + rates.getLatencySamples();
+        }
+        setLatencySamples (latency);
     }
 
+    // a latency change that only moves delays retunes the live ops, which
+    // keeps their history and avoids swapping in a new sequence.
+    auto* const live = activeSequence.load();
+    if (onlyLatencyChanged && live != nullptr && GraphBuilder::retuneDelays (live->ops, newRenderingOps))
     {
-        // swap over to the new rendering sequence..
-        {
-            const ScopedLock sl (getPropertyLock());
-            renderingBuffers.setSize (numRenderingBuffersNeeded, 4096);
-            renderingBuffers.clear();
-            for (auto ab : atomBuffers)
-                ab->clear();
-            for (int i = midiBuffers.size(); --i >= 0;)
-                midiBuffers.getUnchecked (i)->clear();
-
-            while (midiBuffers.size() < numMidiBuffersNeeded)
-                midiBuffers.add (new MidiBuffer());
-            while (atomBuffers.size() < numAtomBuffersNeeded)
-            {
-                auto ab = atomBuffers.add (new AtomBuffer());
-                ab->setTypes (_context.symbols());
-            }
-        }
+        live->latencies = std::move (sequence->latencies);
+        if (flattenedInto != nullptr && flattenedInto == getParentGraph())
+            flattenedInto->buildRenderingSequence (true);
+        return;
+    }
 
-        ScopedLock sl (seqLock);
-        renderingOps.swapWith (newRenderingOps);
+    sequence->findDirectOutputs();
+    sequence->schedule = std::make_unique<GraphSchedule>();
+    sequence->schedule->build (newRenderingOps);
+
+    // the new sequence owns its buffers, nothing here is shared with the
+    // one being rendered. Longer blocks than this are rendered in pieces.
+    sequence->allocateAudio (numRenderingBuffersNeeded, getBlockSize() > 0 ? getBlockSize() : 512);
+    while (sequence->midi.size() < numMidiBuffersNeeded)
+        FixedMidi::reserve (*sequence->midi.add (new MidiBuffer()));
+    while (sequence->atom.size() < numAtomBuffersNeeded)
+    {
+        auto ab = sequence->atom.add (new AtomBuffer());
+        ab->setTypes (_context.symbols());
     }
 
-    // delete the old ones..
-    deleteRenderOpArray (newRenderingOps);
+    RenderTrace::record (RenderTrace::graphSwap, nodeId, newRenderingOps.size());
+
+    // swap over to the new rendering sequence. The old one is deleted here.
+    publishSequence (sequence.release());
 
     renderingSequenceChanged();
+
+    // the parent renders our nodes, so it needs the change too.
+    if (flattenedInto != nullptr && flattenedInto == getParentGraph())
+        flattenedInto->buildRenderingSequence (onlyLatencyChanged);
+}
+
+void GraphNode::checkLatencies()
+{
+    auto* const sequence = activeSequence.load();
+    if (sequence == nullptr || isUpdatePending())
+        return;
+
+    bool changed = false;
+    for (const auto& [node, latency] : sequence->latencies)
+    {
+        // plugins don't always announce a change, so ask them.
+        if (auto* const proc = node->getAudioProcessor())
+            node->setLatencySamples (proc->getLatencySamples());
+        changed |= node->getLatencySamples() != latency;
+    }
+
+    if (changed)
+        buildRenderingSequence (true);
 }
 
 void GraphNode::getOrderedNodes (ReferenceCountedArray<Processor>& orderedNodes)
 {
-    const LookupTable table (connections);
-    for (int i = 0; i < nodes.size(); ++i)
+    if (! isNodeOrderValid())
+        sortNodeOrder();
+    for (auto* node : nodeOrder)
+        orderedNodes.add (node);
+}
+
+/** Each aux send renders before the returns on its bus, as if connected. */
+static std::vector<std::pair<uint32, uint32>> findAuxArcs (const ReferenceCountedArray<Processor>& nodes)
+{
+    std::vector<std::pair<uint32, uint32>> arcs;
+    for (auto* send : nodes)
     {
-        Processor* const node = nodes.getUnchecked (i);
+        auto* const from = dynamic_cast<AuxBusProcessor*> (send->getAudioProcessor());
+        if (from == nullptr || from->isReturn())
+            continue;
+        for (auto* ret : nodes)
+        {
+            auto* const to = dynamic_cast<AuxBusProcessor*> (ret->getAudioProcessor());
+            if (to != nullptr && to->isReturn() && to->getBus() == from->getBus())
+                arcs.emplace_back (send->nodeId, ret->nodeId);
+        }
+    }
+    return arcs;
+}
 
-        int j = 0;
-        for (; j < orderedNodes.size(); ++j)
-            if (table.isAnInputTo (node->nodeId, ((Processor*) orderedNodes.getUnchecked (j))->nodeId))
-                break;
+bool GraphNode::isNodeOrderValid() const
+{
+    if (nodeOrder.size() != nodes.size())
+        return false;
+
+    std::unordered_map<uint32, int> positions;
+    positions.reserve ((size_t) nodeOrder.size());
+    for (int i = 0; i < nodeOrder.size(); ++i)
+        positions[nodeOrder.getUnchecked (i)->nodeId] = i;
+
+    for (auto* node : nodes)
+        if (positions.find (node->nodeId) == positions.end())
+            return false;
 
-        orderedNodes.insert (j, node);
+    for (auto* c : connections)
+    {
+        auto src = positions.find (c->sourceNode);
+        auto dst = positions.find (c->destNode);
+        if (src == positions.end() || dst == positions.end() || src->second > dst->second)
+            return false;
+    }
+
+    for (const auto& arc : findAuxArcs (nodes))
+        if (positions[arc.first] > positions[arc.second])
+            return false;
+
+    return true;
+}
+
+void GraphNode::sortNodeOrder()
+{
+    // Kahn's algorithm. Ready nodes are taken in the order they were added
+    // to the graph so the result is stable between rebuilds.
+    const int numNodes = nodes.size();
+    std::unordered_map<uint32, int> indexes;
+    indexes.reserve ((size_t) numNodes);
+    for (int i = 0; i < numNodes; ++i)
+        indexes[nodes.getUnchecked (i)->nodeId] = i;
+
+    std::vector<int> numInputs ((size_t) numNodes, 0);
+    std::vector<std::vector<int>> outputs ((size_t) numNodes);
+    for (auto* c : connections)
+    {
+        auto src = indexes.find (c->sourceNode);
+        auto dst = indexes.find (c->destNode);
+        if (src == indexes.end() || dst == indexes.end() || src->second == dst->second)
+            continue;
+        outputs[(size_t) src->second].push_back (dst->second);
+        ++numInputs[(size_t) dst->second];
+    }
+
+    for (const auto& arc : findAuxArcs (nodes))
+    {
+        const int src = indexes[arc.first], dst = indexes[arc.second];
+        outputs[(size_t) src].push_back (dst);
+        ++numInputs[(size_t) dst];
+    }
+
+    std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+    for (int i = 0; i < numNodes; ++i)
+        if (numInputs[(size_t) i] == 0)
+            ready.push (i);
+
+    std::vector<bool> added ((size_t) numNodes, false);
+    nodeOrder.clearQuick();
+    nodeOrder.ensureStorageAllocated (numNodes);
+
+    while (! ready.empty())
+    {
+        const int index = ready.top();
+        ready.pop();
+        added[(size_t) index] = true;
+        nodeOrder.add (nodes.getUnchecked (index));
+        for (auto next : outputs[(size_t) index])
+            if (--numInputs[(size_t) next] == 0)
+                ready.push (next);
     }
+
+    // whatever is left sits in a feedback loop, render it last.
+    for (int i = 0; i < numNodes; ++i)
+        if (! added[(size_t) i])
+            nodeOrder.add (nodes.getUnchecked (i));
+}
+
+void GraphNode::updateNodeOrder (const uint32 sourceId, const uint32 destId)
+{
+    int srcIdx = -1, dstIdx = -1;
+    for (int i = nodeOrder.size(); --i >= 0;)
+    {
+        const auto id = nodeOrder.getUnchecked (i)->nodeId;
+        if (id == sourceId)
+            srcIdx = i;
+        if (id == destId)
+            dstIdx = i;
+    }
+
+    // unknown nodes or already in order.
+    if (srcIdx < 0 || dstIdx < 0 || srcIdx < dstIdx)
+        return;
+
+    // Only nodes between the two ends can be out of order now. Find the
+    // ones downstream of dest and upstream of source within that window.
+    const int first = dstIdx, count = srcIdx - dstIdx + 1;
+    std::unordered_map<uint32, int> window;
+    for (int i = 0; i < count; ++i)
+        window[nodeOrder.getUnchecked (first + i)->nodeId] = i;
+
+    auto collect = [&] (uint32 start, bool forward, std::vector<bool>& marked) {
+        std::vector<uint32> stack { start };
+        marked[(size_t) window[start]] = true;
+        while (! stack.empty())
+        {
+            const auto id = stack.back();
+            stack.pop_back();
+            const auto* a = findArcs (id);
+            if (a == nullptr)
+                continue;
+            for (const auto* c : forward ? a->outputs : a->inputs)
+            {
+                const auto to = forward ? c->destNode : c->sourceNode;
+                auto iter = window.find (to);
+                if (iter == window.end() || marked[(size_t) iter->second])
+                    continue;
+                marked[(size_t) iter->second] = true;
+                stack.push_back (to);
+            }
+        }
+    };
+
+    std::vector<bool> downstream ((size_t) count, false), upstream ((size_t) count, false);
+    collect (destId, true, downstream);
+    if (downstream[(size_t) window[sourceId]])
+        return; // feedback loop, leave it for a full sort.
+    collect (sourceId, false, upstream);
+
+    // upstream nodes move ahead of downstream ones, everything else keeps its slot.
+    Array<Processor*> moved;
+    Array<int> slots;
+    for (int pass = 0; pass < 2; ++pass)
+        for (int i = 0; i < count; ++i)
+            if ((pass == 0 && upstream[(size_t) i]) || (pass == 1 && downstream[(size_t) i]))
+                moved.add (nodeOrder.getUnchecked (first + i));
+    for (int i = 0; i < count; ++i)
+        if (upstream[(size_t) i] || downstream[(size_t) i])
+            slots.add (first + i);
+
+    for (int i = 0; i < slots.size(); ++i)
+        nodeOrder.set (slots.getUnchecked (i), moved.getUnchecked (i));
 }
 
 void GraphNode::handleAsyncUpdate()
@@ -484,38 +1134,116 @@ void GraphNode::handleAsyncUpdate()
 }
 
 void GraphNode::prepareToRender (double sampleRate, int estimatedSamplesPerBlock)
+{
+    outerRate = sampleRate;
+    outerBlock = estimatedSamplesPerBlock;
+
+    if (auto* const fz = getFreeze())
+    {
+        // the nodes stay released until the graph is unfrozen.
+        if (getSampleRate() != sampleRate || getBlockSize() != estimatedSamplesPerBlock)
+            setRenderDetails (sampleRate, estimatedSamplesPerBlock);
+        fz->player.prepareToPlay (estimatedSamplesPerBlock, sampleRate);
+        fz->prepared = true;
+        return;
+    }
+
+    prepareNodes (sampleRate, estimatedSamplesPerBlock);
+}
+
+void GraphNode::prepareNodes (double sampleRate, int estimatedSamplesPerBlock)
 {
     if (prepared())
         return;
 
     currentAudioInputBuffer = nullptr;
-    currentAudioOutputBuffer.setSize (jmax (1, getNumAudioOutputs()), estimatedSamplesPerBlock);
+    currentAudioOutputBuffer.setSize (jmax (1, getNumAudioInputs(), getNumAudioOutputs()), estimatedSamplesPerBlock);
     currentMidiInputBuffer = nullptr;
     currentMidiOutputBuffer.clear();
+    currentMidiOutputBuffer.ensureSize (4096);
     clearRenderingSequence();
 
+    ratePlayHead.ratio.store (1.0);
+    if (internalRate > 0.0 && std::llround (internalRate) != std::llround (sampleRate))
+    {
+        auto bridge = std::make_unique<Bridge>();
+        const int numChannels = jmax (1, getNumAudioInputs(), getNumAudioOutputs());
+        if (bridge->rates.prepare (sampleRate, internalRate, numChannels, estimatedSamplesPerBlock))
+        {
+            // from here on the nodes only see the inner rate.
+            ratePlayHead.ratio.store (internalRate / sampleRate);
+            sampleRate = internalRate;
+            estimatedSamplesPerBlock = bridge->rates.getMaxInnerBlock();
+            currentAudioOutputBuffer.setSize (numChannels, estimatedSamplesPerBlock);
+            rateBridge.store (bridge.release());
+        }
+    }
+
     _prepared = true;
     if (getSampleRate() != sampleRate || getBlockSize() != estimatedSamplesPerBlock)
         setRenderDetails (sampleRate, estimatedSamplesPerBlock);
 
-    for (int i = 0; i < nodes.size(); ++i)
-        nodes.getUnchecked (i)->prepare (sampleRate, estimatedSamplesPerBlock, this);
+    waitForPrepares();
+    prepareInParallel (prepareThreads->pool, nodes, sampleRate, estimatedSamplesPerBlock, this);
 
-    buildRenderingSequence();
+    {
+        SessionProfile::Timer timer (SessionProfile::rebuild, getName());
+        buildRenderingSequence();
+    }
+    latencyWatch->startTimer (LatencyWatch::interval);
+}
+
+void GraphNode::prepareInBackground (Processor* node)
+{
+    // the node renders as if disabled until it's ready.
+    node->preparing.store (true, std::memory_order_release);
+    ++pendingPrepares;
+
+    ProcessorPtr keep (node), self (this);
+    const auto rate = getSampleRate();
+    const auto block = getBlockSize();
+    prepareThreads->pool.addJob ([this, keep, self, rate, block]() {
+        keep->prepare (rate, block, this);
+        keep->preparing.store (false, std::memory_order_release);
+        --pendingPrepares;
+        // latency may have changed.
+        triggerAsyncUpdate();
+    });
+}
+
+void GraphNode::waitForPrepares()
+{
+    while (pendingPrepares.load() > 0)
+        Thread::sleep (1);
 }
 
 void GraphNode::releaseResources()
+{
+    if (auto* const fz = getFreeze())
+    {
+        fz->player.releaseResources();
+        fz->prepared = false;
+        return;
+    }
+
+    releaseNodes();
+}
+
+void GraphNode::releaseNodes()
 {
     if (! prepared())
         return;
 
+    latencyWatch->stopTimer();
+    waitForPrepares();
+
     for (int i = 0; i < nodes.size(); ++i)
         nodes.getUnchecked (i)->unprepare();
 
     _prepared = false;
 
-    renderingBuffers.setSize (1, 1);
-    midiBuffers.clear();
+    clearRenderingSequence();
+    retireBridge();
 
     currentAudioInputBuffer = nullptr;
     currentAudioOutputBuffer.setSize (1, 1);
@@ -534,56 +1262,176 @@ void GraphNode::reset()
 // MARK: Process Graph
 
 void GraphNode::render (RenderContext& rc)
+{
+    rendering.store (true);
+    if (auto* const fz = getFreeze())
+        renderFrozen (*fz, rc);
+    else if (auto* const bridge = rateBridge.load())
+        renderBridged (*bridge, rc);
+    else
+        renderNodes (rc);
+    renderEpoch.fetch_add (1);
+    rendering.store (false);
+}
+
+void GraphNode::renderBridged (Bridge& bridge, RenderContext& rc)
+{
+    const int numSamples = rc.audio.getNumSamples();
+    auto& midi = *rc.midi.getWriteBuffer (0);
+    const int numInner = bridge.rates.toInner (rc.audio, numSamples);
+    if (numInner > 0)
+    {
+        FixedMidi::remap (midi, numInner, numSamples);
+        RenderContext inner (bridge.rates.getInnerBuffer(), bridge.cv, midi, bridge.atoms, numInner);
+        renderNodes (inner);
+        FixedMidi::remap (midi, numSamples, numInner);
+    }
+    else
+    {
+        // only a block of a frame or so going down can convert to nothing.
+        midi.clear();
+    }
+
+    bridge.rates.toOuter (numInner, rc.audio, numSamples);
+}
+
+void GraphNode::renderNodes (RenderContext& rc)
 {
     const int32 numSamples = rc.audio.getNumSamples();
     auto& midiMessages = *rc.midi.getWriteBuffer (0);
+
+    // one sequence for the whole block, so the output mode can't change part way.
+    auto* const seq = activeSequence.load();
+    const bool directAudio = seq != nullptr && seq->directAudioOutput;
+    const bool directMidi = seq != nullptr && seq->directMidiOutput;
+
     currentAudioInputBuffer = &rc.audio;
-    currentAudioOutputBuffer.setSize (jmax (1, rc.audio.getNumChannels()), numSamples);
-    currentAudioOutputBuffer.clear();
+    directAudioOutput = directAudio ? &rc.audio : nullptr;
+    if (! directAudio)
+    {
+        currentAudioOutputBuffer.setSize (jmax (1, rc.audio.getNumChannels()), numSamples, false, false, true);
+        currentAudioOutputBuffer.clear();
+    }
+
+    if (midiFilterChanged.exchange (false))
+    {
+        uint32 mask = 0;
+        if (midiChannels.isOmni())
+            mask = 1u;
+        else
+            for (int ch = 1; ch <= 16; ++ch)
+                if (! midiChannels.isOff (ch))
+                    mask |= (1u << ch);
+        midiFilter.setChannels (mask);
+        midiFilter.setVelocityCurve (velocityCurve);
+    }
 
-    if (midiChannels.isOmni() && velocityCurve.getMode() == VelocityCurve::Linear)
+    midiFilter.process (midiMessages);
+    currentMidiInputBuffer = &midiMessages;
+
+    if (directMidi)
     {
-        currentMidiInputBuffer = &midiMessages;
+        // nothing consumes the input, so it mustn't pass through.
+        if (! seq->readsMidiInput)
+            midiMessages.clear();
+        directMidiOutput = &midiMessages;
     }
     else
     {
-        filteredMidi.clear();
-        int chan = 0;
+        currentMidiOutputBuffer.clear();
+    }
 
-        for (auto m : midiMessages)
+    const int quantum = renderQuantum.load (std::memory_order_relaxed);
+    if (quantum <= 0 || (numSamples <= quantum && currentMidiInputBuffer->isEmpty()))
+    {
+        renderSequence (seq, 0, numSamples);
+    }
+    else
+    {
+        for (int start = 0; start < numSamples;)
         {
-            auto msg = m.getMessage();
-            chan = msg.getChannel();
-            if (chan > 0 && midiChannels.isOff (chan))
-                continue;
+            int length = jmin (quantum, numSamples - start);
 
-            if (msg.isNoteOn())
-            {
-                msg.setVelocity (velocityCurve.process (msg.getFloatVelocity()));
-            }
+            // end early at the next event so it lands on the first frame of a sub-block.
+            const auto next = currentMidiInputBuffer->findNextSamplePosition (start + 1);
+            if (next != currentMidiInputBuffer->cend())
+                length = jmin (length, (*next).samplePosition - start);
 
-            filteredMidi.addEvent (msg, m.samplePosition);
+            renderSequence (seq, start, length);
+            start += length;
         }
+    }
+
+    subBlockOffset = 0;
+    directAudioOutput = nullptr;
+    directMidiOutput = nullptr;
 
-        currentMidiInputBuffer = &filteredMidi;
+    if (! directAudio)
+        for (int i = 0; i < rc.audio.getNumChannels(); ++i)
+            rc.audio.copyFrom (i, 0, currentAudioOutputBuffer, i, 0, numSamples);
+
+    if (! directMidi)
+    {
+        midiMessages.clear();
+        midiMessages.addEvents (currentMidiOutputBuffer, 0, numSamples, 0);
     }
+}
 
-    currentMidiOutputBuffer.clear();
+void GraphNode::renderSequence (RenderSequence* seq, int offset, int numSamples)
+{
+    if (seq == nullptr)
+        return;
 
+    // rebuild if a subgraph was muted, bypassed or otherwise changed
+    // whether it can be inlined.
+    if (offset == 0)
     {
-        ScopedLock sl (seqLock);
-        for (auto ptr : renderingOps)
+        for (const auto& sub : seq->subgraphs)
         {
-            GraphOp* const op = static_cast<GraphOp*> (ptr);
-            op->perform (renderingBuffers, midiBuffers, atomBuffers, numSamples);
+            if (sub.first->isFlattenable() != sub.second)
+            {
+                triggerAsyncUpdate();
+                break;
+            }
+        }
+
+        // sends and returns are wired by bus, so a new bus needs a new program.
+        for (const auto& aux : seq->auxNodes)
+        {
+            if (aux.first->getBus() != aux.second)
+            {
+                triggerAsyncUpdate();
+                break;
+            }
         }
     }
 
-    for (int i = 0; i < rc.audio.getNumChannels(); ++i)
-        rc.audio.copyFrom (i, 0, currentAudioOutputBuffer, i, 0, numSamples);
+    auto& schedule = *seq->schedule;
+    auto pool = renderPool.load();
+    const bool parallel = pool != nullptr && pool->getNumWorkers() > 0 && schedule.isParallel();
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int count = jmin (seq->capacity, numSamples - done);
+        subBlockOffset = offset + done;
+        audioOutputWritten = false;
+        if (parallel)
+        {
+            schedule.prepare (seq->audio, seq->midi, seq->atom, count);
+            pool->perform (schedule);
+        }
+        else
+        {
+            schedule.getProgram().run (seq->audio, seq->midi, seq->atom, count);
+        }
+
+        // the parent's input is still in there if no output ran.
+        if (directAudioOutput != nullptr && ! audioOutputWritten)
+            for (int i = directAudioOutput->getNumChannels(); --i >= 0;)
+                directAudioOutput->clear (i, subBlockOffset, count);
 
-    midiMessages.clear();
-    midiMessages.addEvents (currentMidiOutputBuffer, 0, numSamples, 0);
+        done += count;
+    }
 }
 
 void GraphNode::getPluginDescription (PluginDescription& d) const
@@ -604,8 +1452,48 @@ void GraphNode::setPlayHead (AudioPlayHead* newPlayHead)
 {
     Processor::setPlayHead (newPlayHead);
     playhead = getPlayHead();
+    ratePlayHead.source = playhead.load();
+    auto* const forNodes = getNodePlayHead();
     for (auto* const node : nodes)
-        node->setPlayHead (playhead);
+        node->setPlayHead (forNodes);
+}
+
+AudioPlayHead* GraphNode::getNodePlayHead() const noexcept
+{
+    auto* const ph = playhead.load();
+    return ph != nullptr && internalRate > 0.0 ? const_cast<RatePlayHead*> (&ratePlayHead) : ph;
+}
+
+void GraphNode::setInternalRate (double newRate)
+{
+    newRate = jmax (0.0, newRate);
+    if (newRate == internalRate)
+        return;
+
+    if (auto* const parent = getParentGraph())
+    {
+        // prepared again by the parent, like an oversampling change.
+        const bool wasEnabled = isEnabled();
+        setEnabled (false);
+        internalRate = newRate;
+        setPlayHead (getPlayHead());
+        setEnabled (wasEnabled);
+        parent->triggerAsyncUpdate();
+    }
+    else if (prepared())
+    {
+        // the engine renders root graphs under this lock.
+        const ScopedLock sl (getPropertyLock());
+        releaseNodes();
+        internalRate = newRate;
+        setPlayHead (getPlayHead());
+        prepareNodes (outerRate, outerBlock);
+    }
+    else
+    {
+        internalRate = newRate;
+        setPlayHead (getPlayHead());
+    }
 }
 
 void GraphNode::refreshPorts()
@@ -662,4 +1550,268 @@ void GraphNode::rebuild() noexcept
     handleAsyncUpdate();
 }
 
+void GraphNode::beginUpdate() noexcept
+{
+    ++updateDepth;
+}
+
+void GraphNode::endUpdate()
+{
+    if (updateDepth <= 0 || --updateDepth > 0)
+        return;
+
+    if (retired.isEmpty() && ! isUpdatePending())
+        return;
+
+    rebuild();
+    for (auto* n : retired)
+    {
+        n->setParentGraph (nullptr);
+        n->setPlayHead (nullptr);
+    }
+    retired.clear();
+}
+
+void GraphNode::retire (ProcessorPtr node)
+{
+    // the old node keeps rendering until the new sequence is published.
+    if (updateDepth > 0)
+    {
+        retired.add (node);
+        triggerAsyncUpdate();
+        return;
+    }
+
+    handleAsyncUpdate();
+    node->setParentGraph (nullptr);
+    node->setPlayHead (nullptr);
+}
+
+void GraphNode::setRenderThreadPool (RenderThreadPool* pool) noexcept
+{
+    renderPool.store (pool);
+}
+
+GraphNode::ScratchInfo GraphNode::getScratchInfo() const
+{
+    ScratchInfo info;
+    if (auto* seq = activeSequence.load())
+    {
+        info.maxBlockSize = seq->capacity;
+        info.audioBytes = seq->audioBytes;
+        info.midiBytes = (size_t) seq->midi.size() * (size_t) FixedMidi::capacity;
+        for (auto* ab : seq->atom)
+            info.atomBytes += (size_t) ab->capacity();
+        for (auto* op : seq->ops)
+            info.opBytes += static_cast<GraphOp*> (op)->getNumBytes();
+    }
+    return info;
+}
+
+int64 GraphNode::getMemoryUsage() const
+{
+    auto total = Processor::getMemoryUsage() + (int64) getScratchInfo().getTotalBytes();
+    if (auto* const fz = frozen.load())
+        total += fz->player.getMemoryUsage();
+    if (auto* const bridge = rateBridge.load())
+        total += (int64) bridge->rates.getNumBytes();
+    for (auto* node : nodes)
+        total += node->getMemoryUsage();
+    return total;
+}
+
+int GraphNode::getNumRenderOps() const
+{
+    auto* seq = activeSequence.load();
+    return seq != nullptr ? seq->ops.size() : 0;
+}
+
+void GraphNode::setFlattenSubgraphs (bool shouldFlatten)
+{
+    if (flattenSubgraphs.exchange (shouldFlatten) != shouldFlatten)
+        triggerAsyncUpdate();
+}
+
+void GraphNode::setDoublePrecision (bool shouldUseDouble)
+{
+    if (doublePrecision.exchange (shouldUseDouble) != shouldUseDouble)
+        updateProcessingPrecision();
+}
+
+bool GraphNode::isDoublePrecision() const noexcept
+{
+    for (auto* graph = this; graph != nullptr; graph = graph->getParentGraph())
+        if (graph->doublePrecision.load (std::memory_order_relaxed))
+            return true;
+    return false;
+}
+
+void GraphNode::updateProcessingPrecision()
+{
+    if (! prepared())
+        return;
+
+    waitForPrepares();
+    for (auto* node : nodes)
+    {
+        if (auto* sub = dynamic_cast<GraphNode*> (node))
+        {
+            sub->updateProcessingPrecision();
+            continue;
+        }
+
+        // plugins take the precision when prepared, see AudioProcessorNode.
+        auto* proc = node->getAudioProcessor();
+        if (proc == nullptr || ! proc->supportsDoublePrecisionProcessing() || ! node->isEnabled())
+            continue;
+        node->setEnabled (false);
+        node->setEnabled (true);
+    }
+}
+
+bool GraphNode::isFlattenable() noexcept
+{
+    if (! isSubGraph() || isFrozen() || ! prepared() || ! isEnabled() || isSuspended() || isMuted())
+        return false;
+    if (isProfilingEnabled() || getGain() != 1.f || getInputGain() != 1.f)
+        return false;
+    if (getOversamplingFactor() > 1 || getDelayCompensationSamples() != 0 || isBridged())
+        return false;
+
+    const auto filter = getMidiFilter();
+    if (filter.transpose != 0 || filter.keyRange != Range<int> (0, 127) || ! filter.isOmni() || filter.programsEnabled)
+        return false;
+
+    return midiChannels.isOmni()
+           && velocityCurve.getMode() == VelocityCurve::Linear
+           && getRenderQuantum() <= 0;
+}
+
+GraphNode::Freeze* GraphNode::getFreeze() const noexcept
+{
+    auto* const fz = frozen.load();
+    return fz != nullptr && fz->renderer.load() != std::this_thread::get_id() ? fz : nullptr;
+}
+
+Result GraphNode::freeze (const File& file, int64 numSamples)
+{
+    if (! isSubGraph())
+        return Result::fail ("only subgraphs can be frozen");
+    if (isFrozen())
+        return Result::fail ("the graph is already frozen");
+    if (numSamples <= 0 || outerRate <= 0.0 || outerBlock <= 0)
+        return Result::fail ("nothing to render");
+
+    auto* const fz = new Freeze();
+    fz->file = file;
+    fz->renderer.store (std::this_thread::get_id());
+    fz->prepared = prepared();
+
+    // the parent renders silence in its place from the next block. One
+    // that inlined the nodes has to call render() again first.
+    frozen.store (fz);
+    if (flattenedInto != nullptr)
+        flattenedInto->rebuild();
+    const auto epoch = renderEpoch.load();
+    while (rendering.load() && renderEpoch.load() == epoch)
+        std::this_thread::yield();
+
+    OfflineRender::Options options;
+    options.sampleRate = outerRate;
+    options.blockSize = outerBlock;
+    options.length = numSamples;
+    options.numChannels = jmax (1, getNumAudioOutputs());
+    options.bitsPerSample = 32;
+    options.numThreads = 1;
+
+    auto* const livePlayHead = getPlayHead();
+    if (livePlayHead != nullptr)
+        if (auto pos = livePlayHead->getPosition())
+            options.tempo = pos->getBpm().orFallback (options.tempo);
+
+    OfflineRender::Stem stem;
+    stem.graph = this;
+    stem.file = file;
+
+    // the engine's workers are the audio thread's.
+    auto* const pool = renderPool.exchange (nullptr);
+    const auto result = OfflineRender::render (stem, options);
+    renderPool.store (pool);
+    setPlayHead (livePlayHead);
+    fz->renderer.store (std::thread::id());
+
+    std::unique_ptr<DiskStream> stream;
+    if (result.wasOk())
+    {
+        AudioFormatManager formats;
+        formats.registerFormat (new WavAudioFormat(), true);
+        stream = DiskStream::open (formats, file);
+    }
+
+    if (stream == nullptr)
+    {
+        unfreeze();
+        return Result::fail (result.wasOk() ? "couldn't read " + file.getFullPathName() : result.error);
+    }
+
+    fz->player.setStream (std::move (stream));
+    if (fz->prepared)
+        fz->player.prepareToPlay (outerBlock, outerRate);
+    fz->ready.store (true, std::memory_order_release);
+    return Result::ok();
+}
+
+void GraphNode::unfreeze()
+{
+    auto* const fz = frozen.load();
+    if (fz == nullptr)
+        return;
+
+    // ready the nodes while the file still plays.
+    if (fz->prepared)
+        prepareNodes (outerRate, outerBlock);
+    thaw();
+}
+
+void GraphNode::thaw()
+{
+    std::unique_ptr<Freeze> fz (frozen.exchange (nullptr));
+    if (fz == nullptr)
+        return;
+
+    // a block started before the exchange may still be playing the file.
+    const auto epoch = renderEpoch.load();
+    while (rendering.load() && renderEpoch.load() == epoch)
+        std::this_thread::yield();
+
+    const auto file = fz->file;
+    fz.reset();
+    file.deleteFile();
+}
+
+void GraphNode::renderFrozen (Freeze& fz, RenderContext& rc)
+{
+    auto& audio = rc.audio;
+    rc.midi.getWriteBuffer (0)->clear();
+    if (! fz.ready.load (std::memory_order_acquire))
+    {
+        audio.clear();
+        return;
+    }
+
+    // start, stop and seek with the transport, like a synced file player.
+    if (auto* const ph = getPlayHead())
+        if (auto pos = ph->getPosition())
+            fz.player.follow (pos->getIsPlaying(), pos->getTimeInSamples().orFallback (0));
+
+    fz.player.getNextAudioBlock (AudioSourceChannelInfo (&audio, 0, audio.getNumSamples()));
+    for (int c = getNumAudioOutputs(); c < audio.getNumChannels(); ++c)
+        audio.clear (c, 0, audio.getNumSamples());
+}
+
+void GraphNode::setRenderQuantum (int numSamples) noexcept
+{
+    renderQuantum.store (jmax (0, numSamples), std::memory_order_relaxed);
+}
+
 } // namespace element
@@ -3,8 +3,11 @@
 
 #pragma once
 
+#include <unordered_map>
+
 #include "ElementApp.h"
 #include <element/processor.hpp>
+#include "engine/midifilterstage.hpp"
 #include "engine/velocitycurve.hpp"
 #include <element/arc.hpp>
 #include <element/signals.hpp>
@@ -12,6 +15,8 @@
 namespace element {
 
 class Context;
+class GraphSchedule;
+class RenderThreadPool;
 class SymbolMap;
 
 class GraphNode : public Processor,
@@ -86,6 +91,14 @@ public:
     */
     bool removeNode (uint32 nodeId);
 
+    /** Puts a node in place of an existing one, keeping its ID, position and
+        connections. Connections the new node can't take are dropped. The
+        audio thread picks up the swap with the next rendering sequence.
+
+        Returns false if there's no node with the ID.
+    */
+    bool replaceNode (uint32 nodeId, Processor* newNode);
+
     /** Builds an array of ordered nodes */
     void getOrderedNodes (ReferenceCountedArray<Processor>& res);
 
@@ -143,6 +156,11 @@ public:
     */
     bool removeIllegalConnections();
 
+    /** Like removeIllegalConnections(), but only checks the connections
+        of one node, e.g. after its ports changed.
+    */
+    bool removeIllegalConnections (uint32 nodeId);
+
     /** Set the allowed MIDI channel of this Graph */
     void setMidiChannel (const int channel) noexcept;
 
@@ -179,6 +197,9 @@ public:
     void refreshPorts() override;
     void setPlayHead (AudioPlayHead*) override;
 
+    /** Scratch buffers and delay lines, plus every node in the graph. */
+    int64 getMemoryUsage() const override;
+
     void setNumPorts (PortType type, int count, bool inputs, bool async = true);
 
     /** Returns true if the graph is prepared. */
@@ -189,6 +210,115 @@ public:
     /** Rebuild rendering ops immediately. */
     void rebuild() noexcept;
 
+    /** Hold off rebuilding for removed and replaced nodes until the matching
+        endUpdate(). Nodes taken out meanwhile keep rendering in the current
+        sequence, then one rebuild publishes every change. Calls nest.
+     */
+    void beginUpdate() noexcept;
+    void endUpdate();
+
+    /** Render independent branches of this graph on a thread pool.
+        Pass nullptr to render serially.  The pool must outlive the graph
+        or be unset before it is deleted.
+     */
+    void setRenderThreadPool (RenderThreadPool* pool) noexcept;
+
+    /** Render in sub-blocks of at most this many samples. Blocks are also
+        split at incoming MIDI events, so each event starts a sub-block and
+        parameters are applied at every boundary. Zero renders whole blocks.
+     */
+    void setRenderQuantum (int numSamples) noexcept;
+
+    /** Returns the sub-block size, or zero if whole blocks are rendered. */
+    int getRenderQuantum() const noexcept { return renderQuantum.load (std::memory_order_relaxed); }
+
+    /** Inline eligible subgraphs into this graph's own rendering sequence.
+
+        Their nodes share this graph's buffers and are rendered without a
+        copy in and out of each subgraph. A subgraph is only inlined while
+        it renders like a plain wire around its nodes: not muted, bypassed
+        or profiled, unity gain and no MIDI filtering, oversampling or
+        sub-blocks. Whenever that changes the graph is rebuilt.
+     */
+    void setFlattenSubgraphs (bool shouldFlatten);
+
+    /** Returns true if eligible subgraphs are inlined. */
+    bool isFlatteningSubgraphs() const noexcept { return flattenSubgraphs.load (std::memory_order_relaxed); }
+
+    /** Returns true if this subgraph can be inlined into its parent right now. Realtime safe. */
+    bool isFlattenable() noexcept;
+
+    /** Render plugins that support it in double precision. The buffers
+        between nodes stay 32-bit, each plugin's block is converted on the
+        way in and out. Subgraphs follow the graph they're in. Supporting
+        plugins are prepared again, so call from the message thread.
+     */
+    void setDoublePrecision (bool shouldUseDouble);
+
+    /** Returns true if this graph, or one it's nested in, renders plugins
+        in double precision.
+     */
+    bool isDoublePrecision() const noexcept;
+
+    /** Scratch memory held by the active rendering sequence. */
+    struct ScratchInfo
+    {
+        int maxBlockSize = 0; ///< frames rendered at once, longer blocks are split
+        size_t audioBytes = 0; ///< audio and CV buffers, one aligned block
+        size_t midiBytes = 0;
+        size_t atomBytes = 0;
+        size_t opBytes = 0; ///< delay lines and other state owned by ops
+
+        size_t getTotalBytes() const noexcept { return audioBytes + midiBytes + atomBytes + opBytes; }
+    };
+
+    /** Returns what the active sequence allocated. Call from the message thread. */
+    ScratchInfo getScratchInfo() const;
+
+    /** Returns the number of ops in the active sequence. Call from the message thread. */
+    int getNumRenderOps() const;
+
+    /** Render this subgraph to a file and stream the file in its place.
+
+        The graph is rendered offline from the start of the timeline for
+        numSamples at its current rate, with its inputs silent, then its
+        nodes are released. From then on the file plays in time with the
+        transport, so the graph costs what streaming it does. The file
+        belongs to the graph and is deleted when it's unfrozen.
+
+        Blocks until the render is done. Message thread only.
+     */
+    Result freeze (const File& file, int64 numSamples);
+
+    /** Prepare the nodes again and go back to rendering them live. Message thread. */
+    void unfreeze();
+
+    /** Returns true if the graph plays a frozen render. */
+    bool isFrozen() const noexcept { return frozen.load() != nullptr; }
+
+    /** Prepare several graphs at once, as prepareToRender() would one
+        after another, on the threads nodes are prepared with. Each
+        graph's nodes are prepared in parallel too. Blocks until they're
+        all ready.
+     */
+    static void prepareGraphs (const Array<GraphNode*>& graphs, double sampleRate, int blockSize);
+
+    /** Run the nodes at their own sample rate, whatever the device's.
+
+        Audio is converted at the graph's inputs and outputs, MIDI times
+        are scaled, and the nodes see the transport in their own frames.
+        The conversion adds a little latency, which the graph reports.
+        Zero follows the parent, or the device for a root graph. Message
+        thread only.
+     */
+    void setInternalRate (double sampleRate);
+
+    /** Returns the rate asked for, or zero if the graph follows its parent. */
+    double getInternalRate() const noexcept { return internalRate; }
+
+    /** Returns true if the nodes run at a different rate to the graph. */
+    bool isBridged() const noexcept { return rateBridge.load() != nullptr; }
+
 protected:
     //==========================================================================
     virtual void preRenderNodes() {}
@@ -212,13 +342,78 @@ private:
     typedef ArcTable<Connection> LookupTable;
     ReferenceCountedArray<Processor> nodes;
     OwnedArray<Connection> connections;
+    ReferenceCountedArray<Processor> retired;
+
+    // node ID to index in nodes, kept in sync with it.
+    std::unordered_map<uint32, int> nodeSlots;
+
+    // each node's connections, so edits don't scan the whole graph.
+    struct Arcs
+    {
+        Array<const Connection*> inputs, outputs;
+    };
+    std::unordered_map<uint32, Arcs> arcs;
+    const Arcs* findArcs (uint32 nodeId) const;
+    void addArcs (const Connection*);
+    void removeArcs (const Connection*);
+    int updateDepth = 0;
+
+    struct PrepareThreads;
+    SharedResourcePointer<PrepareThreads> prepareThreads;
+    std::atomic<int> pendingPrepares { 0 };
+    void prepareInBackground (Processor* node);
+    void waitForPrepares();
+    static void prepareInParallel (ThreadPool&, const ReferenceCountedArray<Processor>&, double sampleRate, int blockSize, GraphNode*);
+
+    struct LatencyWatch;
+    std::unique_ptr<LatencyWatch> latencyWatch;
+    void checkLatencies();
     uint32 ioNodes[10];
 
     uint32 lastNodeId;
-    AudioSampleBuffer renderingBuffers;
-    OwnedArray<MidiBuffer> midiBuffers;
-    OwnedArray<AtomBuffer> atomBuffers;
-    Array<void*> renderingOps;
+
+    /** Ops, schedule and buffers of one built sequence. Published to the
+        audio thread through activeSequence and never modified afterwards.
+     */
+    struct RenderSequence;
+    struct Flattener;
+    std::atomic<RenderSequence*> activeSequence { nullptr };
+    std::atomic<bool> rendering { false };
+    std::atomic<uint32> renderEpoch { 0 };
+    std::atomic<RenderThreadPool*> renderPool { nullptr };
+    std::atomic<int> renderQuantum { 0 };
+    std::atomic<bool> flattenSubgraphs { false };
+    std::atomic<bool> doublePrecision { false };
+    void updateProcessingPrecision();
+
+    struct Freeze;
+    std::atomic<Freeze*> frozen { nullptr };
+    Freeze* getFreeze() const noexcept;
+    void renderFrozen (Freeze&, RenderContext&);
+    void prepareNodes (double sampleRate, int blockSize);
+    void releaseNodes();
+    void retireBridge();
+    void thaw();
+
+    /** The transport as the nodes of a bridged graph see it. */
+    struct RatePlayHead : public AudioPlayHead
+    {
+        Optional<PositionInfo> getPosition() const override;
+        std::atomic<AudioPlayHead*> source { nullptr };
+        std::atomic<double> ratio { 1.0 }; // inner frames per outer frame
+    };
+
+    struct Bridge;
+    RatePlayHead ratePlayHead;
+    std::atomic<Bridge*> rateBridge { nullptr };
+    double internalRate = 0.0;
+    double outerRate = 0.0; // the rate and block the parent prepared
+    int outerBlock = 0;
+    AudioPlayHead* getNodePlayHead() const noexcept;
+    void renderNodes (RenderContext&);
+    void renderBridged (Bridge&, RenderContext&);
+    GraphNode* flattenedInto = nullptr;
+    int subBlockOffset = 0;
     bool _prepared = false;
 
     AudioSampleBuffer* currentAudioInputBuffer;
@@ -226,20 +421,35 @@ private:
     MidiBuffer* currentMidiInputBuffer;
     MidiBuffer currentMidiOutputBuffer;
 
+    // set while outputs write straight into the parent's buffers, see
+    // RenderSequence::findDirectOutputs().
+    AudioSampleBuffer* directAudioOutput = nullptr;
+    MidiBuffer* directMidiOutput = nullptr;
+    bool audioOutputWritten = false;
+
     MidiChannels midiChannels;
     VelocityCurve velocityCurve;
-    MidiBuffer filteredMidi;
+    MidiFilterStage midiFilter;
+    std::atomic<bool> midiFilterChanged { true };
 
     std::atomic<AudioPlayHead*> playhead { nullptr };
 
     bool customPortsSet = false;
     PortList userPorts;
 
-    CriticalSection seqLock;
     friend class ScriptNode; // workaround so parameter connections work when params change.
     void handleAsyncUpdate() override;
     void clearRenderingSequence();
-    void buildRenderingSequence();
+    void retire (ProcessorPtr node);
+    void buildRenderingSequence (bool onlyLatencyChanged = false);
+    void publishSequence (RenderSequence* newSequence);
+    void renderSequence (RenderSequence* seq, int offset, int numSamples);
+
+    // cached topological order kept up to date by node and connection edits.
+    Array<Processor*> nodeOrder;
+    bool isNodeOrderValid() const;
+    void sortNodeOrder();
+    void updateNodeOrder (uint32 sourceId, uint32 destId);
     bool isAnInputTo (uint32 possibleInputId, uint32 possibleDestinationId, int recursionCheck) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GraphNode)
@@ -0,0 +1,221 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <vector>
+
+#include "engine/fixedmidi.hpp"
+#include "engine/graphbuilder.hpp"
+
+namespace element {
+
+/** A graph's rendering ops decoded into one contiguous instruction array.
+
+    Clears, copies and sums of shared buffers are run inline by a switch,
+    so the hot loop doesn't make a virtual call or chase an op pointer for
+    each of them. Everything else is dispatched to GraphOp::perform().
+    Instruction indexes match the rendering ops they were built from.
+ */
+class GraphProgram final
+{
+public:
+    GraphProgram() = default;
+
+    /** Decode a rendering sequence. Not realtime safe. */
+    void build (const juce::Array<void*>& renderingOps)
+    {
+        code.clear();
+        sources.clear();
+        code.reserve ((size_t) renderingOps.size());
+
+        int numAudioBuffers = 1;
+        GraphOpBuffers buffers;
+        for (auto* ptr : renderingOps)
+        {
+            buffers.audio.clearQuick();
+            static_cast<GraphOp*> (ptr)->collectBuffers (buffers);
+            for (auto idx : buffers.audio)
+                numAudioBuffers = juce::jmax (numAudioBuffers, idx + 1);
+        }
+
+        // shared buffers start out cleared.
+        silence.assign ((size_t) numAudioBuffers, 1);
+
+        for (auto* ptr : renderingOps)
+        {
+            auto* op = static_cast<GraphOp*> (ptr);
+            auto inst = op->decode();
+
+            // ops that don't keep their own flags are assumed to leave
+            // sound in every audio buffer they touch.
+            if (inst.code == GraphInstruction::perform && ! op->setSilenceFlags (silence.data()))
+            {
+                buffers.audio.clearQuick();
+                op->collectBuffers (buffers);
+                inst.src = (int) sources.size();
+                for (auto idx : buffers.audio)
+                    if (idx > 0)
+                        sources.push_back (idx);
+                inst.numSources = (int) sources.size() - inst.src;
+            }
+
+            code.push_back (inst);
+        }
+
+        optimize();
+    }
+
+    /** Returns the number of instructions. */
+    int size() const noexcept { return (int) code.size(); }
+
+    /** Run every instruction. */
+    void run (juce::AudioSampleBuffer& audio,
+              const juce::OwnedArray<juce::MidiBuffer>& midi,
+              const juce::OwnedArray<AtomBuffer>& atom,
+              int numSamples) noexcept
+    {
+        run (0, size(), audio, midi, atom, numSamples);
+    }
+
+    /** Run a range of instructions. */
+    void run (int first, int count,
+              juce::AudioSampleBuffer& audio,
+              const juce::OwnedArray<juce::MidiBuffer>& midi,
+              const juce::OwnedArray<AtomBuffer>& atom,
+              int numSamples) noexcept
+    {
+        auto* const silent = silence.data();
+        const auto* inst = code.data() + first;
+        const auto* const end = inst + count;
+
+        for (; inst != end; ++inst)
+        {
+            switch (inst->code)
+            {
+                case GraphInstruction::clearAudio:
+                    juce::FloatVectorOperations::clear (audio.getWritePointer (inst->dst), numSamples);
+                    silent[inst->dst] = 1;
+                    break;
+                case GraphInstruction::copyAudio:
+                    juce::FloatVectorOperations::copy (audio.getWritePointer (inst->dst),
+                                                       audio.getReadPointer (inst->src),
+                                                       numSamples);
+                    silent[inst->dst] = silent[inst->src];
+                    break;
+                case GraphInstruction::addAudio:
+                    if (silent[inst->src])
+                        break;
+                    juce::FloatVectorOperations::add (audio.getWritePointer (inst->dst),
+                                                      audio.getReadPointer (inst->src),
+                                                      numSamples);
+                    silent[inst->dst] = 0;
+                    break;
+                case GraphInstruction::clearMidi:
+                    midi.getUnchecked (inst->dst)->clear();
+                    break;
+                case GraphInstruction::copyMidi:
+                    // keeps the destination's storage, assigning would reallocate.
+                    FixedMidi::copy (*midi.getUnchecked (inst->dst), *midi.getUnchecked (inst->src));
+                    break;
+                case GraphInstruction::addMidi:
+                    FixedMidi::add (*midi.getUnchecked (inst->dst), *midi.getUnchecked (inst->src), 0, numSamples, 0);
+                    break;
+                case GraphInstruction::sumAudio: {
+                    const int* chans = sources.data() + inst->src;
+                    auto* dst = audio.getWritePointer (inst->dst);
+                    juce::FloatVectorOperations::add (dst,
+                                                      audio.getReadPointer (chans[0]),
+                                                      audio.getReadPointer (chans[1]),
+                                                      numSamples);
+                    uint8 allSilent = silent[chans[0]] & silent[chans[1]];
+                    for (int i = 2; i < inst->numSources; ++i)
+                    {
+                        if (silent[chans[i]])
+                            continue;
+                        juce::FloatVectorOperations::add (dst, audio.getReadPointer (chans[i]), numSamples);
+                        allSilent = 0;
+                    }
+                    silent[inst->dst] = allSilent;
+                    break;
+                }
+                case GraphInstruction::nop:
+                    break;
+                case GraphInstruction::perform:
+                default: {
+                    inst->op->perform (audio, midi, atom, numSamples);
+                    const int* chans = sources.data() + inst->src;
+                    for (int i = 0; i < inst->numSources; ++i)
+                        silent[chans[i]] = 0;
+                    break;
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<GraphInstruction> code;
+    std::vector<int> sources;
+    std::vector<uint8> silence;
+
+    static bool isa (const GraphInstruction& inst, GraphInstruction::Code c) noexcept
+    {
+        return inst.code == c;
+    }
+
+    /** Peephole pass over the decoded ops. Absorbed instructions become
+        nops so indexes still line up with the rendering ops.
+     */
+    void optimize()
+    {
+        using I = GraphInstruction;
+        const int n = size();
+
+        for (int i = 0; i < n; ++i)
+        {
+            auto& head = code[(size_t) i];
+
+            // clear + add into the same buffer is a copy.
+            if (i + 1 < n && (isa (head, I::clearAudio) || isa (head, I::clearMidi)))
+            {
+                auto& next = code[(size_t) i + 1];
+                const auto add = isa (head, I::clearAudio) ? I::addAudio : I::addMidi;
+                if (isa (next, add) && next.dst == head.dst && next.src != head.dst)
+                {
+                    // the add becomes the copy, so it can still start a sum.
+                    next.code = isa (head, I::clearAudio) ? I::copyAudio : I::copyMidi;
+                    head.code = I::nop;
+                    continue;
+                }
+            }
+
+            // copy followed by adds into the same channel is a single sum.
+            if (isa (head, I::copyAudio) && head.src != head.dst)
+            {
+                int j = i + 1;
+                while (j < n && isa (code[(size_t) j], I::addAudio)
+                       && code[(size_t) j].dst == head.dst
+                       && code[(size_t) j].src != head.dst)
+                    ++j;
+
+                if (j - i < 2)
+                    continue;
+
+                const int offset = (int) sources.size();
+                sources.push_back (head.src);
+                for (int k = i + 1; k < j; ++k)
+                {
+                    sources.push_back (code[(size_t) k].src);
+                    code[(size_t) k].code = I::nop;
+                }
+
+                head.code = I::sumAudio;
+                head.src = offset;
+                head.numSources = j - i;
+                i = j - 1;
+            }
+        }
+    }
+};
+
+} // namespace element
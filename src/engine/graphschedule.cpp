@@ -0,0 +1,172 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+#include <map>
+
+#include "engine/graphbuilder.hpp"
+#include "engine/graphschedule.hpp"
+
+namespace element {
+
+namespace detail {
+enum ResourceKind
+{
+    audioResource = 1,
+    midiResource,
+    atomResource,
+    ioResource
+};
+
+static inline int resourceKey (ResourceKind kind, int index) noexcept
+{
+    return ((int) kind << 24) | (index & 0x00ffffff);
+}
+} // namespace detail
+
+void GraphSchedule::build (const juce::Array<void*>& renderingOps)
+{
+    steps.clear();
+    parallel = false;
+    program.build (renderingOps);
+
+    // last step to touch each resource.
+    std::map<int, int> owners;
+    std::vector<int> keys;
+
+    for (int i = 0; i < renderingOps.size();)
+    {
+        const int stepIndex = (int) steps.size();
+        Step step;
+        step.firstOp = i;
+
+        GraphOpBuffers buffers;
+        while (i < renderingOps.size())
+        {
+            auto* op = static_cast<GraphOp*> (renderingOps.getUnchecked (i++));
+            ++step.numOps;
+            op->collectBuffers (buffers);
+            if (op->endsStep())
+                break;
+        }
+
+        keys.clear();
+        // audio 0 is the read-only zero buffer and atom 0 is only handed
+        // to nodes without atom ports. Neither is shared state.
+        for (auto idx : buffers.audio)
+            if (idx > 0)
+                keys.push_back (detail::resourceKey (detail::audioResource, idx));
+        for (auto idx : buffers.midi)
+            keys.push_back (detail::resourceKey (detail::midiResource, idx));
+        for (auto idx : buffers.atom)
+            if (idx > 0)
+                keys.push_back (detail::resourceKey (detail::atomResource, idx));
+        // inputs and outputs of a kind share a key. An output may write
+        // straight into the buffer its input reads, so they keep their order.
+        if (buffers.ioType >= 0)
+            keys.push_back (detail::resourceKey (detail::ioResource, buffers.ioType / 2));
+
+        for (auto key : keys)
+        {
+            auto iter = owners.find (key);
+            if (iter != owners.end() && iter->second != stepIndex)
+            {
+                auto& succ = steps[(size_t) iter->second].successors;
+                if (std::find (succ.begin(), succ.end(), stepIndex) == succ.end())
+                {
+                    succ.push_back (stepIndex);
+                    ++step.numDependencies;
+                }
+            }
+
+            owners[key] = stepIndex;
+        }
+
+        steps.push_back (std::move (step));
+    }
+
+    int numRoots = 0;
+    for (const auto& step : steps)
+    {
+        if (step.numDependencies == 0)
+            ++numRoots;
+        if (step.successors.size() > 1)
+            parallel = true;
+    }
+
+    parallel = parallel || numRoots > 1;
+
+    pending.reset (new std::atomic<int>[std::max ((size_t) 1, steps.size())]);
+    queue.reset (new std::atomic<int>[std::max ((size_t) 1, steps.size())]);
+}
+
+void GraphSchedule::prepare (juce::AudioSampleBuffer& a,
+                             const juce::OwnedArray<juce::MidiBuffer>& m,
+                             const juce::OwnedArray<AtomBuffer>& at,
+                             int n) noexcept
+{
+    audio = &a;
+    midi = &m;
+    atom = &at;
+    numSamples = n;
+
+    const int numSteps = (int) steps.size();
+    for (int i = 0; i < numSteps; ++i)
+    {
+        pending[(size_t) i].store (steps[(size_t) i].numDependencies, std::memory_order_relaxed);
+        queue[(size_t) i].store (-1, std::memory_order_relaxed);
+    }
+
+    readPos.store (0, std::memory_order_relaxed);
+    writePos.store (0, std::memory_order_relaxed);
+    remaining.store (numSteps, std::memory_order_relaxed);
+
+    for (int i = 0; i < numSteps; ++i)
+        if (steps[(size_t) i].numDependencies == 0)
+            push (i);
+}
+
+void GraphSchedule::push (int step) noexcept
+{
+    const int pos = writePos.fetch_add (1, std::memory_order_acq_rel);
+    queue[(size_t) pos].store (step, std::memory_order_release);
+}
+
+bool GraphSchedule::runNextTask() noexcept
+{
+    int pos = readPos.load (std::memory_order_acquire);
+    while (true)
+    {
+        if (pos >= writePos.load (std::memory_order_acquire))
+            return false;
+        if (readPos.compare_exchange_weak (pos, pos + 1, std::memory_order_acq_rel))
+            break;
+    }
+
+    // the slot is claimed but the pusher might not have published it yet.
+    int step = -1;
+    while ((step = queue[(size_t) pos].load (std::memory_order_acquire)) < 0)
+        ;
+
+    runStep (step);
+    return true;
+}
+
+void GraphSchedule::runStep (int index) noexcept
+{
+    const auto& step = steps[(size_t) index];
+    program.run (step.firstOp, step.numOps, *audio, *midi, *atom, numSamples);
+
+    for (auto succ : step.successors)
+        if (pending[(size_t) succ].fetch_sub (1, std::memory_order_acq_rel) == 1)
+            push (succ);
+
+    remaining.fetch_sub (1, std::memory_order_release);
+}
+
+bool GraphSchedule::isFinished() const noexcept
+{
+    return remaining.load (std::memory_order_acquire) <= 0;
+}
+
+} // namespace element
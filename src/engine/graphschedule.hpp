@@ -0,0 +1,81 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "engine/graphprogram.hpp"
+#include "engine/renderthreadpool.hpp"
+#include "ElementApp.h"
+
+namespace element {
+
+class AtomBuffer;
+class GraphOp;
+
+/** Splits a graph's rendering ops into per-node steps and tracks which
+    steps depend on each other, so independent branches can be rendered
+    on a RenderThreadPool.
+
+    Two steps depend on each other if they share a buffer or both touch
+    the graph's IO. The original op order is kept for dependent steps, so
+    the result is identical to rendering the ops serially.
+ */
+class GraphSchedule final : public RenderThreadPool::Job
+{
+public:
+    GraphSchedule() = default;
+
+    /** Build the schedule from a rendering sequence. Not realtime safe. */
+    void build (const juce::Array<void*>& renderingOps);
+
+    /** Returns true if any two steps could run at the same time. */
+    bool isParallel() const noexcept { return parallel; }
+
+    /** Returns the number of steps in the schedule. */
+    int getNumSteps() const noexcept { return (int) steps.size(); }
+
+    /** Returns the decoded ops in their serial order. */
+    GraphProgram& getProgram() noexcept { return program; }
+
+    /** Reset for a new block.  Call before handing this to the pool. */
+    void prepare (juce::AudioSampleBuffer& audio,
+                  const juce::OwnedArray<juce::MidiBuffer>& midi,
+                  const juce::OwnedArray<AtomBuffer>& atom,
+                  int numSamples) noexcept;
+
+    bool runNextTask() noexcept override;
+    bool isFinished() const noexcept override;
+
+private:
+    struct Step
+    {
+        int firstOp = 0;
+        int numOps = 0;
+        int numDependencies = 0;
+        std::vector<int> successors;
+    };
+
+    GraphProgram program;
+    std::vector<Step> steps;
+    bool parallel = false;
+
+    std::unique_ptr<std::atomic<int>[]> pending;
+    std::unique_ptr<std::atomic<int>[]> queue;
+    std::atomic<int> readPos { 0 }, writePos { 0 }, remaining { 0 };
+
+    juce::AudioSampleBuffer* audio = nullptr;
+    const juce::OwnedArray<juce::MidiBuffer>* midi = nullptr;
+    const juce::OwnedArray<AtomBuffer>* atom = nullptr;
+    int numSamples = 0;
+
+    void push (int step) noexcept;
+    void runStep (int step) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (GraphSchedule)
+};
+
+} // namespace element
@@ -17,8 +17,14 @@
 #include "nodes/channelize.hpp"
 #include "nodes/combfilter.hpp"
 #include "nodes/compressor.hpp"
+#include "nodes/auxbus.hpp"
+#include "nodes/convolver.hpp"
 #include "nodes/eqfilter.hpp"
 #include "nodes/freqsplitter.hpp"
+#include "nodes/diskrecorder.hpp"
+#include "nodes/limiter.hpp"
+#include "nodes/looper.hpp"
+#include "nodes/netbridge.hpp"
 #include "nodes/mediaplayer.hpp"
 #include "nodes/midichannelmap.hpp"
 #include "nodes/mididevice.hpp"
@@ -111,6 +117,50 @@ void ElementAudioPluginFormat::findAllTypesForFile (OwnedArray<PluginDescription
         auto* desc = ds.add (new PluginDescription());
         ReverbProcessor().fillInPluginDescription (*desc);
     }
+    else if (fileOrId == EL_NODE_ID_CONVOLVER)
+    {
+        auto* desc = ds.add (new PluginDescription());
+        ConvolverProcessor().fillInPluginDescription (*desc);
+    }
+    else if (fileOrId == EL_NODE_ID_AUX_SEND)
+    {
+        auto* desc = ds.add (new PluginDescription());
+        AuxSendProcessor().fillInPluginDescription (*desc);
+    }
+    else if (fileOrId == EL_NODE_ID_AUX_RETURN)
+    {
+        auto* desc = ds.add (new PluginDescription());
+        AuxReturnProcessor().fillInPluginDescription (*desc);
+    }
+    else if (fileOrId == EL_NODE_ID_LOOPER)
+    {
+        auto* desc = ds.add (new PluginDescription());
+        LooperProcessor().fillInPluginDescription (*desc);
+    }
+    else if (fileOrId == EL_NODE_ID_NET_SEND)
+    {
+        for (int channels : { 2, 8 })
+        {
+            auto* desc = ds.add (new PluginDescription());
+            NetSendProcessor (channels).fillInPluginDescription (*desc);
+        }
+    }
+    else if (fileOrId == EL_NODE_ID_NET_RECEIVE)
+    {
+        for (int channels : { 2, 8 })
+        {
+            auto* desc = ds.add (new PluginDescription());
+            NetReceiveProcessor (channels).fillInPluginDescription (*desc);
+        }
+    }
+    else if (fileOrId == EL_NODE_ID_DISK_RECORDER)
+    {
+        for (int channels : { 2, 8 })
+        {
+            auto* desc = ds.add (new PluginDescription());
+            DiskRecorderProcessor (channels).fillInPluginDescription (*desc);
+        }
+    }
     else if (fileOrId == EL_NODE_ID_EQ_FILTER)
     {
         auto* desc = ds.add (new PluginDescription());
@@ -118,14 +168,22 @@ void ElementAudioPluginFormat::findAllTypesForFile (OwnedArray<PluginDescription
     }
     else if (fileOrId == EL_NODE_ID_FREQ_SPLITTER)
     {
-        auto* desc = ds.add (new PluginDescription());
-        FreqSplitterProcessor().fillInPluginDescription (*desc);
+        for (int bands = Crossover::minBands; bands <= Crossover::maxBands; ++bands)
+        {
+            auto* desc = ds.add (new PluginDescription());
+            FreqSplitterProcessor (2, bands).fillInPluginDescription (*desc);
+        }
     }
     else if (fileOrId == EL_NODE_ID_COMPRESSOR)
     {
         auto* desc = ds.add (new PluginDescription());
         CompressorProcessor().fillInPluginDescription (*desc);
     }
+    else if (fileOrId == EL_NODE_ID_LIMITER)
+    {
+        auto* desc = ds.add (new PluginDescription());
+        LimiterProcessor().fillInPluginDescription (*desc);
+    }
     else if (fileOrId == EL_NODE_ID_AUDIO_MIXER)
     {
         auto* const desc = ds.add (new PluginDescription());
@@ -173,12 +231,20 @@ StringArray ElementAudioPluginFormat::searchPathsForPlugins (const FileSearchPat
     StringArray results;
     results.add (EL_NODE_ID_COMB_FILTER);
     results.add (EL_NODE_ID_COMPRESSOR);
+    results.add (EL_NODE_ID_LIMITER);
     results.add (EL_NODE_ID_EQ_FILTER);
     results.add (EL_NODE_ID_FREQ_SPLITTER);
     results.add (EL_NODE_ID_ALLPASS_FILTER);
     results.add (EL_NODE_ID_VOLUME);
     results.add (EL_NODE_ID_WET_DRY);
     results.add (EL_NODE_ID_REVERB);
+    results.add (EL_NODE_ID_CONVOLVER);
+    results.add (EL_NODE_ID_NET_SEND);
+    results.add (EL_NODE_ID_NET_RECEIVE);
+    results.add (EL_NODE_ID_AUX_SEND);
+    results.add (EL_NODE_ID_AUX_RETURN);
+    results.add (EL_NODE_ID_DISK_RECORDER);
+    results.add (EL_NODE_ID_LOOPER);
     results.add (EL_NODE_ID_AUDIO_MIXER);
     results.add (EL_NODE_ID_CHANNELIZE);
     results.add (EL_NODE_ID_MEDIA_PLAYER);
@@ -215,12 +281,36 @@ AudioPluginInstance* ElementAudioPluginFormat::instantiatePlugin (const PluginDe
         base = std::make_unique<WetDryProcessor>();
     else if (desc.fileOrIdentifier == EL_NODE_ID_REVERB)
         base = std::make_unique<ReverbProcessor>();
+    else if (desc.fileOrIdentifier == EL_NODE_ID_CONVOLVER)
+        base = std::make_unique<ConvolverProcessor>();
+    else if (desc.fileOrIdentifier == EL_NODE_ID_AUX_SEND)
+        base = std::make_unique<AuxSendProcessor>();
+    else if (desc.fileOrIdentifier == EL_NODE_ID_AUX_RETURN)
+        base = std::make_unique<AuxReturnProcessor>();
+    else if (desc.fileOrIdentifier == EL_NODE_ID_LOOPER)
+        base = std::make_unique<LooperProcessor>();
+    else if (desc.fileOrIdentifier == EL_NODE_ID_NET_SEND)
+        base = std::make_unique<NetSendProcessor>();
+    else if (desc.fileOrIdentifier.startsWith (EL_NODE_ID_NET_SEND "."))
+        base = std::make_unique<NetSendProcessor> (desc.fileOrIdentifier.fromLastOccurrenceOf (".", false, false).getIntValue());
+    else if (desc.fileOrIdentifier == EL_NODE_ID_NET_RECEIVE)
+        base = std::make_unique<NetReceiveProcessor>();
+    else if (desc.fileOrIdentifier.startsWith (EL_NODE_ID_NET_RECEIVE "."))
+        base = std::make_unique<NetReceiveProcessor> (desc.fileOrIdentifier.fromLastOccurrenceOf (".", false, false).getIntValue());
+    else if (desc.fileOrIdentifier == EL_NODE_ID_DISK_RECORDER)
+        base = std::make_unique<DiskRecorderProcessor>();
+    else if (desc.fileOrIdentifier.startsWith (EL_NODE_ID_DISK_RECORDER "."))
+        base = std::make_unique<DiskRecorderProcessor> (desc.fileOrIdentifier.fromLastOccurrenceOf (".", false, false).getIntValue());
     else if (desc.fileOrIdentifier == EL_NODE_ID_EQ_FILTER)
         base = std::make_unique<EQFilterProcessor>();
     else if (desc.fileOrIdentifier == EL_NODE_ID_FREQ_SPLITTER)
         base = std::make_unique<FreqSplitterProcessor>();
+    else if (desc.fileOrIdentifier.startsWith (EL_NODE_ID_FREQ_SPLITTER "."))
+        base = std::make_unique<FreqSplitterProcessor> (2, desc.fileOrIdentifier.fromLastOccurrenceOf (".", false, false).getIntValue());
     else if (desc.fileOrIdentifier == EL_NODE_ID_COMPRESSOR)
         base = std::make_unique<CompressorProcessor>();
+    else if (desc.fileOrIdentifier == EL_NODE_ID_LIMITER)
+        base = std::make_unique<LimiterProcessor>();
     else if (desc.fileOrIdentifier == EL_NODE_ID_AUDIO_MIXER)
         base = std::make_unique<AudioMixerProcessor> (4, sampleRate, blockSize);
     else if (desc.fileOrIdentifier == EL_NODE_ID_CHANNELIZE)
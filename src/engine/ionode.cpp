@@ -98,14 +98,43 @@ void IONode::render (RenderContext& rc) // AudioSampleBuffer& buffer, MidiPipe&
     jassert (graph != nullptr);
     // jassert (midiPipe.getNumBuffers() > 0);
     auto& midiMessages = *rc.midi.getWriteBuffer (0);
+    // where this block starts in the graph's own block, see GraphNode::setRenderQuantum().
+    const int offset = graph->subBlockOffset;
+    const int numSamples = rc.audio.getNumSamples();
     switch (type)
     {
         case audioOutputNode: {
+            if (auto* dest = graph->directAudioOutput)
+            {
+                // the first output this sub-block replaces the parent's input.
+                const bool adding = graph->audioOutputWritten;
+                const int numChans = jmin (dest->getNumChannels(), rc.audio.getNumChannels());
+                for (int i = 0; i < dest->getNumChannels(); ++i)
+                {
+                    if (i >= numChans)
+                    {
+                        if (! adding)
+                            dest->clear (i, offset, numSamples);
+                    }
+                    else if (adding)
+                    {
+                        dest->addFrom (i, offset, rc.audio, i, 0, numSamples);
+                    }
+                    else
+                    {
+                        dest->copyFrom (i, offset, rc.audio, i, 0, numSamples);
+                    }
+                }
+
+                graph->audioOutputWritten = true;
+                break;
+            }
+
             for (int i = jmin (graph->currentAudioOutputBuffer.getNumChannels(),
                                rc.audio.getNumChannels());
                  --i >= 0;)
             {
-                graph->currentAudioOutputBuffer.addFrom (i, 0, rc.audio, i, 0, rc.audio.getNumSamples());
+                graph->currentAudioOutputBuffer.addFrom (i, offset, rc.audio, i, 0, numSamples);
             }
 
             break;
@@ -116,22 +145,30 @@ void IONode::render (RenderContext& rc) // AudioSampleBuffer& buffer, MidiPipe&
                                rc.audio.getNumChannels());
                  --i >= 0;)
             {
-                rc.audio.copyFrom (i, 0, *graph->currentAudioInputBuffer, i, 0, rc.audio.getNumSamples());
+                rc.audio.copyFrom (i, 0, *graph->currentAudioInputBuffer, i, offset, numSamples);
             }
 
             break;
         }
 
         case midiOutputNode:
-            graph->currentMidiOutputBuffer.clear();
-            graph->currentMidiOutputBuffer.addEvents (midiMessages, 0, rc.audio.getNumSamples(), 0);
+            if (auto* dest = graph->directMidiOutput)
+            {
+                // the input node already took this sub-block's events.
+                dest->addEvents (midiMessages, 0, numSamples, offset);
+            }
+            else
+            {
+                graph->currentMidiOutputBuffer.clear (offset, numSamples);
+                graph->currentMidiOutputBuffer.addEvents (midiMessages, 0, numSamples, offset);
+            }
             midiMessages.clear();
             break;
 
         case midiInputNode:
             midiMessages.clear();
-            midiMessages.addEvents (*graph->currentMidiInputBuffer, 0, rc.audio.getNumSamples(), 0);
-            graph->currentMidiInputBuffer->clear();
+            midiMessages.addEvents (*graph->currentMidiInputBuffer, offset, numSamples, -offset);
+            graph->currentMidiInputBuffer->clear (offset, numSamples);
             break;
 
         default:
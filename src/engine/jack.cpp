@@ -22,7 +22,11 @@
 
 #include <jack/weakjack.h>
 #include <jack/jack.h>
+#include <jack/midiport.h>
 
+#include "engine/devicemidi.hpp"
+#include "engine/deviceports.hpp"
+#include "engine/fixedmidi.hpp"
 #include "engine/jack.hpp"
 #include "dynlib.h"
 
@@ -72,6 +76,7 @@ JUCE_DECL_VOID_JACK_FUNCTION (jack_on_info_shutdown, (jack_client_t * client, Ja
 JUCE_DECL_JACK_FUNCTION (void*, jack_port_get_buffer, (jack_port_t * port, jack_nframes_t nframes), (port, nframes))
 JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_port_get_total_latency, (jack_client_t * client, jack_port_t* port), (client, port))
 JUCE_DECL_JACK_FUNCTION (jack_port_t*, jack_port_register, (jack_client_t * client, const char* port_name, const char* port_type, unsigned long flags, unsigned long buffer_size), (client, port_name, port_type, flags, buffer_size))
+JUCE_DECL_JACK_FUNCTION (int, jack_port_unregister, (jack_client_t * client, jack_port_t* port), (client, port))
 JUCE_DECL_VOID_JACK_FUNCTION (jack_set_error_function, (void (*func) (const char*)), (func))
 JUCE_DECL_JACK_FUNCTION (int, jack_set_process_callback, (jack_client_t * client, JackProcessCallback process_callback, void* arg), (client, process_callback, arg))
 JUCE_DECL_JACK_FUNCTION (const char**, jack_get_ports, (jack_client_t * client, const char* port_name_pattern, const char* type_name_pattern, unsigned long flags), (client, port_name_pattern, type_name_pattern, flags))
@@ -91,6 +96,11 @@ JUCE_DECL_JACK_FUNCTION (char*, jack_get_client_name, (jack_client_t * client),
 
 JUCE_DECL_VOID_JACK_FUNCTION (jack_free, (void* ptr), (ptr))
 
+JUCE_DECL_JACK_FUNCTION (uint32_t, jack_midi_get_event_count, (void* port_buffer), (port_buffer))
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_get, (jack_midi_event_t * event, void* port_buffer, uint32_t event_index), (event, port_buffer, event_index))
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_write, (void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, size_t data_size), (port_buffer, time, data, data_size))
+JUCE_DECL_VOID_JACK_FUNCTION (jack_midi_clear_buffer, (void* port_buffer), (port_buffer))
+
 #if JUCE_DEBUG
 #define JACK_LOGGING_ENABLED 1
 #endif
@@ -353,7 +363,8 @@ int JackPort::connect (const JackPort& other) { return jack_connect (client, get
 int JackPort::getFlags() const { return element::jack_port_flags (port); }
 
 //==============================================================================
-class JackAudioIODevice : public AudioIODevice
+class JackAudioIODevice : public AudioIODevice,
+                          public DevicePortHost
 {
 public:
     JackAudioIODevice (JackClient& _client,
@@ -406,6 +417,12 @@ public:
 
             inChans.calloc (totalNumberOfInputChannels + 2);
             outChans.calloc (totalNumberOfOutputChannels + 2);
+
+            // MIDI ports go straight to callbacks that can take them, see DeviceMidiCallback.
+            midiInPort = element::jack_port_register (client, "midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+            midiOutPort = element::jack_port_register (client, "midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+            FixedMidi::reserve (midiIn);
+            FixedMidi::reserve (midiOut);
         }
     }
 
@@ -489,6 +506,10 @@ public:
         element::jack_activate (client);
         deviceIsOpen = true;
 
+        portCallback = dynamic_cast<DevicePortCallback*> (client.getEngineCallback());
+        if (portCallback != nullptr)
+            portCallback->setDevicePortHost (this);
+
         if (! inputChannels.isZero())
         {
             forEachClientChannel (inputName, false, [&] (const char* portName, int index) {
@@ -538,6 +559,15 @@ public:
     {
         stop();
 
+        if (portCallback != nullptr)
+        {
+            portCallback->setDevicePortHost (nullptr);
+            portCallback = nullptr;
+        }
+
+        for (int i = 0; i < maxPortGroups; ++i)
+            removePortGroup (i);
+
         if (client != nullptr)
         {
             const auto result = element::jack_deactivate (client);
@@ -565,6 +595,10 @@ public:
             {
                 const ScopedLock sl (callbackLock);
                 callback = newCallback;
+                // the callback is the device manager's, the engine's is kept by the client.
+                midiCallback = newCallback != nullptr ? dynamic_cast<DeviceMidiCallback*> (client.getEngineCallback())
+                                                      : nullptr;
+                graphPortCallback = newCallback != nullptr ? portCallback : nullptr;
             }
 
             if (oldCallback != nullptr)
@@ -606,6 +640,62 @@ public:
         return latency;
     }
 
+    int addPortGroup (const String& name, int numInputs, int numOutputs) override
+    {
+        if (client == nullptr || ! deviceIsOpen)
+            return -1;
+
+        int groupId = -1;
+        for (int i = 0; i < maxPortGroups && groupId < 0; ++i)
+            if (portGroups[i] == nullptr)
+                groupId = i;
+        if (groupId < 0)
+            return -1;
+
+        auto group = std::make_unique<PortGroup>();
+        group->prefix = name.trim().replaceCharacters (" :", "__");
+        for (const auto& other : portGroups)
+            if (other != nullptr && other->prefix == group->prefix)
+                group->prefix << "_" << (groupId + 1);
+        if (group->prefix.isEmpty())
+            group->prefix << "graph_" << (groupId + 1);
+
+        // registered outside the callback lock, this waits on the server.
+        for (int i = 0; i < numInputs; ++i)
+            if (auto* port = element::jack_port_register (client, (group->prefix + "_in_" + String (i + 1)).toUTF8(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0))
+                group->inputs.add (port);
+        for (int i = 0; i < numOutputs; ++i)
+            if (auto* port = element::jack_port_register (client, (group->prefix + "_out_" + String (i + 1)).toUTF8(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0))
+                group->outputs.add (port);
+
+        group->inBuffers.calloc ((size_t) group->inputs.size() + 1);
+        group->outBuffers.calloc ((size_t) group->outputs.size() + 1);
+
+        const ScopedLock sl (callbackLock);
+        portGroups[groupId] = std::move (group);
+        return groupId;
+    }
+
+    void removePortGroup (int groupId) override
+    {
+        if (! isPositiveAndBelow (groupId, maxPortGroups))
+            return;
+
+        std::unique_ptr<PortGroup> group;
+        {
+            const ScopedLock sl (callbackLock);
+            std::swap (group, portGroups[groupId]);
+        }
+
+        if (group == nullptr || client == nullptr)
+            return;
+
+        for (auto* port : group->inputs)
+            element::jack_port_unregister (client, port);
+        for (auto* port : group->outputs)
+            element::jack_port_unregister (client, port);
+    }
+
     String inputName, outputName;
 
 private:
@@ -653,15 +743,44 @@ private:
 
         const ScopedLock sl (callbackLock);
 
+        auto* const midiInBuffer = midiInPort != nullptr ? element::jack_port_get_buffer (midiInPort, (jack_nframes_t) numSamples) : nullptr;
+        auto* const midiOutBuffer = midiOutPort != nullptr ? element::jack_port_get_buffer (midiOutPort, (jack_nframes_t) numSamples) : nullptr;
+        if (midiOutBuffer != nullptr)
+            element::jack_midi_clear_buffer (midiOutBuffer);
+
+        const int numPortGroups = preparePortGroups (numSamples);
+
         if (callback != nullptr)
         {
-            if ((numActiveInChans + numActiveOutChans) > 0)
+            if (midiCallback != nullptr)
+            {
+                midiIn.clear();
+                midiOut.clear();
+                if (midiInBuffer != nullptr)
+                    readMidi (midiInBuffer);
+                midiCallback->setDeviceMidi (&midiIn, &midiOut);
+            }
+
+            if (graphPortCallback != nullptr && numPortGroups > 0)
+                graphPortCallback->setDevicePorts (portBuffers, maxPortGroups);
+
+            if ((numActiveInChans + numActiveOutChans + numPortGroups) > 0)
                 callback->audioDeviceIOCallbackWithContext (inChans.getData(),
                                                             numActiveInChans,
                                                             outChans,
                                                             numActiveOutChans,
                                                             numSamples,
                                                             {});
+
+            if (graphPortCallback != nullptr && numPortGroups > 0)
+                graphPortCallback->setDevicePorts (nullptr, 0);
+
+            if (midiCallback != nullptr)
+            {
+                midiCallback->setDeviceMidi (nullptr, nullptr);
+                if (midiOutBuffer != nullptr)
+                    writeMidi (midiOutBuffer, numSamples);
+            }
         }
         else
         {
@@ -670,6 +789,63 @@ private:
         }
     }
 
+    /** Fetch the buffers of each port group for this block. Outputs are
+        silenced first, so a graph that isn't rendered stays quiet.
+        Returns the number of groups in use. Called with the callback lock held.
+     */
+    int preparePortGroups (int numSamples) noexcept
+    {
+        int numInUse = 0;
+        for (int i = 0; i < maxPortGroups; ++i)
+        {
+            auto& buffers = portBuffers[i];
+            auto* group = portGroups[i].get();
+            if (group == nullptr)
+            {
+                buffers = {};
+                continue;
+            }
+
+            for (int c = 0; c < group->inputs.size(); ++c)
+                group->inBuffers[c] = (const float*) element::jack_port_get_buffer (group->inputs.getUnchecked (c), (jack_nframes_t) numSamples);
+
+            for (int c = 0; c < group->outputs.size(); ++c)
+            {
+                group->outBuffers[c] = (float*) element::jack_port_get_buffer (group->outputs.getUnchecked (c), (jack_nframes_t) numSamples);
+                juce::zeromem (group->outBuffers[c], sizeof (float) * (size_t) numSamples);
+            }
+
+            buffers.inputs = group->inBuffers.getData();
+            buffers.outputs = group->outBuffers.getData();
+            buffers.numInputs = group->inputs.size();
+            buffers.numOutputs = group->outputs.size();
+            ++numInUse;
+        }
+
+        return numInUse;
+    }
+
+    void readMidi (void* buffer) noexcept
+    {
+        const auto numEvents = element::jack_midi_get_event_count (buffer);
+        for (uint32_t i = 0; i < numEvents; ++i)
+        {
+            jack_midi_event_t ev;
+            if (element::jack_midi_event_get (&ev, buffer, i) == 0)
+                FixedMidi::add (midiIn, ev.buffer, (int) ev.size, (int) ev.time);
+        }
+    }
+
+    void writeMidi (void* buffer, int numSamples) noexcept
+    {
+        for (const auto msg : midiOut)
+        {
+            if (msg.samplePosition >= numSamples)
+                break;
+            element::jack_midi_event_write (buffer, (jack_nframes_t) msg.samplePosition, msg.data, (size_t) msg.numBytes);
+        }
+    }
+
     static int processCallback (jack_nframes_t nframes, void* callbackArgument)
     {
         if (callbackArgument != nullptr)
@@ -756,8 +932,28 @@ private:
     bool deviceIsOpen = false;
     String lastError;
     AudioIODeviceCallback* callback = nullptr;
+    DeviceMidiCallback* midiCallback = nullptr;
+    DevicePortCallback* portCallback = nullptr;
+    DevicePortCallback* graphPortCallback = nullptr;
     CriticalSection callbackLock;
 
+    /** Extra audio ports registered for a graph, see DevicePortHost. */
+    struct PortGroup
+    {
+        String prefix;
+        Array<jack_port_t*> inputs, outputs;
+        HeapBlock<const float*> inBuffers;
+        HeapBlock<float*> outBuffers;
+    };
+
+    static constexpr int maxPortGroups = 32;
+    std::unique_ptr<PortGroup> portGroups[maxPortGroups];
+    DevicePortGroup portBuffers[maxPortGroups];
+
+    jack_port_t* midiInPort = nullptr;
+    jack_port_t* midiOutPort = nullptr;
+    MidiBuffer midiIn, midiOut;
+
     HeapBlock<float*> inChans, outChans;
     int totalNumberOfInputChannels = 0;
     int totalNumberOfOutputChannels = 0;
@@ -118,6 +118,15 @@ public:
     /** Query for ports */
     void getPorts (juce::StringArray& dest, juce::String nameRegex = {}, juce::String typeRegex = {}, uint64_t flags = 0);
 
+    /** Set the engine's audio callback. Devices are started with the
+        device manager's callback, so they look here for the engine's
+        DeviceMidiCallback and DevicePortCallback.
+     */
+    void setEngineCallback (juce::AudioIODeviceCallback* callback) noexcept { engineCallback = callback; }
+
+    /** Returns the engine's audio callback, or nullptr. */
+    juce::AudioIODeviceCallback* getEngineCallback() const noexcept { return engineCallback; }
+
     operator jack_client_t*() const { return client; }
 
 private:
@@ -127,6 +136,7 @@ private:
     juce::String name, mainInPrefix, mainOutPrefix;
     int numMainIns, numMainOuts;
     juce::Array<JackPort::Ptr> ports;
+    juce::AudioIODeviceCallback* engineCallback = nullptr;
 };
 
 } // namespace element
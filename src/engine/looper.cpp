@@ -0,0 +1,244 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+
+#include "engine/looper.hpp"
+
+namespace element {
+using namespace juce;
+
+std::atomic<double> Looper::maxSeconds { 30.0 };
+
+int64 Looper::framesToBoundary (double ppq, double beats, double framesPerBeat) noexcept
+{
+    if (beats <= 0.0 || framesPerBeat <= 0.0)
+        return 0;
+    const auto frames = (std::ceil (ppq / beats) * beats - ppq) * framesPerBeat;
+    // a position a rounding error short of a boundary is on it.
+    return frames < 0.5 ? 0 : (int64) std::llround (frames);
+}
+
+void Looper::prepare (int newNumChannels, double sampleRate)
+{
+    const int newCapacity = jmax (1, roundToInt (getMaxSeconds() * sampleRate));
+    if (newNumChannels == numChannels && newCapacity == capacity)
+        return;
+
+    numChannels = jmax (1, newNumChannels);
+    capacity = newCapacity;
+    layers.setSize (numChannels * maxLayers, capacity, false, true, false);
+    for (auto& d : dirty)
+        d.store (false);
+    reset();
+}
+
+void Looper::release()
+{
+    layers.setSize (0, 0);
+    numChannels = capacity = 0;
+    for (auto& d : dirty)
+        d.store (false);
+    reset();
+}
+
+size_t Looper::getNumBytes() const noexcept
+{
+    return sizeof (float) * (size_t) layers.getNumChannels() * (size_t) layers.getNumSamples();
+}
+
+bool Looper::needsCleaning() const noexcept
+{
+    for (const auto& d : dirty)
+        if (d.load (std::memory_order_relaxed))
+            return true;
+    return false;
+}
+
+void Looper::clean() noexcept
+{
+    for (int l = 0; l < maxLayers; ++l)
+    {
+        if (! dirty[l].load (std::memory_order_acquire))
+            continue;
+        for (int ch = 0; ch < numChannels; ++ch)
+            layers.clear (l * numChannels + ch, 0, capacity);
+        dirty[l].store (false, std::memory_order_release);
+    }
+}
+
+//==============================================================================
+void Looper::process (float* const* io, int numIns, int numSamples, Action action, int actionFrame) noexcept
+{
+    if (capacity <= 0)
+        return;
+
+    actionFrame = jlimit (0, numSamples, actionFrame);
+    render (io, numIns, 0, actionFrame);
+    apply (action);
+    render (io, numIns, actionFrame, numSamples - actionFrame);
+
+    publishedState.store (state, std::memory_order_relaxed);
+    publishedLength.store (length, std::memory_order_relaxed);
+    publishedPosition.store (position, std::memory_order_relaxed);
+    publishedLayers.store (numLayers, std::memory_order_relaxed);
+}
+
+void Looper::render (float* const* io, int numIns, int start, int numSamples) noexcept
+{
+    numIns = jmin (numIns, numChannels);
+
+    while (numSamples > 0)
+    {
+        if (state == recording)
+        {
+            const int n = jmin (numSamples, capacity - length);
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if (ch < numIns)
+                    FloatVectorOperations::copy (getLayer (0, ch) + length, io[ch] + start, n);
+                else
+                    FloatVectorOperations::clear (getLayer (0, ch) + length, n);
+            }
+
+            length += n;
+            start += n;
+            numSamples -= n;
+            if (length >= capacity)
+                closeLoop (playing); // out of memory, play what there is
+        }
+        else if (state == playing || state == overdubbing)
+        {
+            const int n = jmin (numSamples, length - position);
+            for (int ch = 0; ch < numIns; ++ch)
+            {
+                auto* out = io[ch] + start;
+                if (state == overdubbing)
+                {
+                    // the layers with this pass added are the input plus
+                    // the loop as it was.
+                    FloatVectorOperations::add (getLayer (target, ch) + position, out, n);
+                    FloatVectorOperations::clear (out, n);
+                }
+                for (int l = 0; l < numLayers; ++l)
+                    FloatVectorOperations::add (out, getLayer (l, ch) + position, n);
+            }
+
+            position += n;
+            if (position >= length)
+                position = 0;
+            start += n;
+            numSamples -= n;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+void Looper::apply (Action action) noexcept
+{
+    switch (action)
+    {
+        case none:
+            break;
+
+        case record:
+            if (state == recording)
+                closeLoop (playing);
+            else
+                startRecording();
+            break;
+
+        case overdub:
+            if (state == recording)
+                closeLoop (overdubbing);
+            else if (state == overdubbing)
+                state = playing;
+            else if (length > 0)
+                startOverdub();
+            else
+                startRecording();
+            break;
+
+        case play:
+            if (state == stopped && length > 0)
+            {
+                position = 0;
+                state = playing;
+            }
+            break;
+
+        case stop:
+            if (state == recording)
+                closeLoop (stopped);
+            else if (state == playing || state == overdubbing)
+                state = stopped;
+            position = 0;
+            break;
+
+        case undo:
+            if (state == recording || numLayers <= 1)
+            {
+                reset();
+                break;
+            }
+            dirty[--numLayers].store (true, std::memory_order_release);
+            if (state == overdubbing)
+                state = playing;
+            break;
+
+        case clear:
+            reset();
+            break;
+    }
+}
+
+void Looper::startRecording() noexcept
+{
+    discardOverdubs();
+    numLayers = 1;
+    length = position = 0;
+    state = recording;
+}
+
+void Looper::closeLoop (State next) noexcept
+{
+    if (length <= 0)
+    {
+        reset();
+        return;
+    }
+
+    position = 0;
+    state = next;
+    if (next == overdubbing)
+        startOverdub();
+}
+
+void Looper::startOverdub() noexcept
+{
+    if (numLayers < maxLayers && ! dirty[numLayers].load (std::memory_order_acquire))
+        target = numLayers++;
+    else
+        target = numLayers - 1;
+    state = overdubbing;
+}
+
+void Looper::discardOverdubs() noexcept
+{
+    // the first layer is written over by recording, it never needs zeroing.
+    for (int l = 1; l < numLayers; ++l)
+        dirty[l].store (true, std::memory_order_release);
+}
+
+void Looper::reset() noexcept
+{
+    discardOverdubs();
+    numLayers = 0;
+    length = position = 0;
+    state = empty;
+}
+
+} // namespace element
@@ -0,0 +1,124 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/audio_basics.hpp>
+
+namespace element {
+
+/** The loop memory and state machine of the Looper node.
+
+    Every layer of a loop is allocated in prepare(), at the longest loop
+    allowed, so recording never allocates. The first layer holds the
+    recorded loop and each overdub pass goes to a layer of its own while
+    there is one free, so it can be undone. Playback sums the layers onto
+    the input.
+
+    Layers that are undone or cleared have to be zeroed before they're
+    used again. That's left to clean() off the audio thread, until then
+    overdubs go to the top layer in use.
+ */
+class Looper final
+{
+public:
+    static constexpr int maxLayers = 4;
+
+    enum State
+    {
+        empty = 0,
+        recording,
+        playing,
+        overdubbing,
+        stopped
+    };
+
+    enum Action
+    {
+        none = 0,
+        record,
+        overdub,
+        play,
+        stop,
+        undo,
+        clear
+    };
+
+    Looper() = default;
+
+    /** Returns the longest loop in seconds, see setMaxSeconds(). */
+    static double getMaxSeconds() noexcept { return maxSeconds.load (std::memory_order_relaxed); }
+
+    /** Set the longest loop. Any thread, takes effect when a looper is
+        next prepared.
+     */
+    static void setMaxSeconds (double seconds) noexcept { maxSeconds.store (juce::jlimit (1.0, 3600.0, seconds), std::memory_order_relaxed); }
+
+    /** Returns the frames from a position in beats to the next multiple
+        of `beats`, or 0 when it's on one.
+     */
+    static juce::int64 framesToBoundary (double ppq, double beats, double framesPerBeat) noexcept;
+
+    /** Allocate the layers. Keeps the loop if the size didn't change.
+        Not while processing.
+     */
+    void prepare (int numChannels, double sampleRate);
+
+    /** Free the layers. Not while processing. */
+    void release();
+
+    /** Loop a block in place, applying an action at a frame in it.
+        Audio thread.
+     */
+    void process (float* const* io, int numChannels, int numSamples, Action action = none, int actionFrame = 0) noexcept;
+
+    /** Returns true if undone or cleared layers need zeroing. */
+    bool needsCleaning() const noexcept;
+
+    /** Zero undone and cleared layers. Any thread but the audio one. */
+    void clean() noexcept;
+
+    /** These can be read from any thread, they're updated after each block. */
+    State getState() const noexcept { return (State) publishedState.load (std::memory_order_relaxed); }
+    juce::int64 getLength() const noexcept { return publishedLength.load (std::memory_order_relaxed); }
+    juce::int64 getPosition() const noexcept { return publishedPosition.load (std::memory_order_relaxed); }
+    int getNumLayers() const noexcept { return publishedLayers.load (std::memory_order_relaxed); }
+
+    /** Returns the longest loop in samples. */
+    int getCapacity() const noexcept { return capacity; }
+
+    /** Returns the bytes of the layers. */
+    size_t getNumBytes() const noexcept;
+
+private:
+    static std::atomic<double> maxSeconds;
+
+    juce::AudioBuffer<float> layers; // numChannels per layer
+    int numChannels = 0;
+    int capacity = 0;
+    std::atomic<bool> dirty[maxLayers] {};
+
+    // audio thread
+    State state = empty;
+    int length = 0, position = 0;
+    int numLayers = 0, target = 0;
+
+    std::atomic<int> publishedState { empty };
+    std::atomic<juce::int64> publishedLength { 0 }, publishedPosition { 0 };
+    std::atomic<int> publishedLayers { 0 };
+
+    float* getLayer (int layer, int channel) noexcept { return layers.getWritePointer (layer * numChannels + channel); }
+    void render (float* const* io, int numIns, int start, int numSamples) noexcept;
+    void apply (Action action) noexcept;
+    void startRecording() noexcept;
+    void closeLoop (State next) noexcept;
+    void startOverdub() noexcept;
+    void discardOverdubs() noexcept;
+    void reset() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (Looper)
+};
+
+} // namespace element
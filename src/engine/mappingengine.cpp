@@ -1,7 +1,11 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <array>
+#include <unordered_map>
+
 #include <element/processor.hpp>
+#include "engine/controllerdecoder.hpp"
 #include "engine/mappingengine.hpp"
 #include "engine/midiengine.hpp"
 #include <element/controller.hpp>
@@ -9,14 +13,81 @@
 
 namespace element {
 
+/** Brings the model and listeners up to date after a mapping set a node's
+    bypass or mute flag from the MIDI thread. Message thread only.
+ */
+static void syncBypassAndMute (const ProcessorPtr& node, Node& model)
+{
+    node->syncBypassAndMute();
+    if (model.isBypassed() != node->isSuspended())
+        model.setProperty (tags::bypass, node->isSuspended());
+    if (model.isMuted() != node->isMuted())
+        model.setProperty (tags::mute, node->isMuted());
+}
+
 class ControllerMapHandler
 {
 public:
     ControllerMapHandler() {}
     virtual ~ControllerMapHandler() {}
 
+    /** Number of slots in a dispatch index, a CC or a note number each. */
+    static constexpr int numDispatchKeys = 256;
+
+    /** Returns the dispatch slot for a message, or -1 if no handler can want it. */
+    static int dispatchKey (const MidiMessage& message) noexcept
+    {
+        if (message.isController())
+            return message.getControllerNumber();
+        if (message.isNoteOnOrOff())
+            return 128 + message.getNoteNumber();
+        return -1;
+    }
+
+    /** Returns the dispatch slot of the messages this handles. wants() still
+        has the final say, e.g. the channel can change while mapped.
+     */
+    virtual int getDispatchKey() const noexcept = 0;
+
     virtual bool wants (const MidiMessage& message) const = 0;
     virtual void perform (const MidiMessage& message) = 0;
+
+    /** Returns the ControllerEvent key this handles, or -1 for 7-bit handlers. */
+    virtual int getHighResolutionKey() const noexcept { return -1; }
+    virtual bool wantsEvent (const ControllerEvent&) const { return false; }
+    virtual void performEvent (const ControllerEvent&) {}
+
+    /** Apply the last value given to postValue() if it hasn't been yet.
+        Called from the flush thread, see MappingEngine::Flusher.
+     */
+    void flush()
+    {
+        if (coalesced == nullptr || ! hasPendingValue.exchange (false, std::memory_order_acquire))
+            return;
+
+        coalesced->beginChangeGesture();
+        coalesced->setValueNotifyingHost (pendingValue.load (std::memory_order_relaxed));
+        coalesced->endChangeGesture();
+    }
+
+protected:
+    /** Set the parameter postValue() changes. Call from the constructor. */
+    void setCoalescedParameter (Parameter* param) noexcept { coalesced = param; }
+
+    /** Queue a value for the next flush, replacing one that wasn't applied
+        yet. A fast sweep gives one parameter change per flush instead of
+        one per message.
+     */
+    void postValue (float value) noexcept
+    {
+        pendingValue.store (value, std::memory_order_relaxed);
+        hasPendingValue.store (true, std::memory_order_release);
+    }
+
+private:
+    Parameter* coalesced = nullptr;
+    std::atomic<float> pendingValue { 0.f };
+    std::atomic<bool> hasPendingValue { false };
 };
 
 struct MidiNoteControllerMap : public ControllerMapHandler,
@@ -66,6 +137,8 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
         return message.getNoteNumber() == noteNumber && (channel.get() == 0 || (channel.get() > 0 && message.getChannel() == channel.get()));
     }
 
+    int getDispatchKey() const noexcept override { return 128 + noteNumber; }
+
     bool wants (const MidiMessage& message) const override
     {
         bool wants = momentary.get() == 0
@@ -100,7 +173,25 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
 
             parameter->endChangeGesture();
         }
-        else if (parameterIndex == Processor::EnabledParameter || parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
+        else if (parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
+        {
+            // set here so the renderer has it next block, the model catches up later.
+            const bool isBypass = parameterIndex == Processor::BypassParameter;
+            bool state = isBypass ? node->isSuspended() : node->isMuted();
+            if (momentary.get() == 0)
+                state = ! state;
+            else if (isBypass)
+                state = isInverse ? message.isNoteOn() : message.isNoteOff();
+            else
+                state = isInverse ? message.isNoteOff() : message.isNoteOn();
+
+            if (isBypass)
+                node->setBypassFlag (state);
+            else
+                node->setMuteFlag (state);
+            triggerAsyncUpdate();
+        }
+        else if (parameterIndex == Processor::EnabledParameter)
         {
             triggerAsyncUpdate();
         }
@@ -108,6 +199,12 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
 
     void handleAsyncUpdate() override
     {
+        if (parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
+        {
+            syncBypassAndMute (node, model);
+            return;
+        }
+
         MidiMessage event;
 
         {
@@ -122,15 +219,6 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
                 node->setEnabled (! node->isEnabled());
                 model.setProperty (tags::enabled, node->isEnabled());
             }
-            else if (parameterIndex == Processor::BypassParameter)
-            {
-                node->suspendProcessing (! node->isSuspended());
-                model.setProperty (tags::bypass, node->isSuspended());
-            }
-            else if (parameterIndex == Processor::MuteParameter)
-            {
-                model.setMuted (! model.isMuted());
-            }
         }
         else
         {
@@ -143,15 +231,6 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
                 node->setEnabled (isInverse ? event.isNoteOff() : event.isNoteOn());
                 model.setProperty (tags::enabled, node->isEnabled());
             }
-            else if (parameterIndex == Processor::BypassParameter)
-            {
-                node->suspendProcessing (isInverse ? event.isNoteOn() : event.isNoteOff());
-                model.setProperty (tags::bypass, node->isSuspended());
-            }
-            else if (parameterIndex == Processor::MuteParameter)
-            {
-                model.setMuted (isInverse ? event.isNoteOff() : event.isNoteOn());
-            }
         }
     }
 
@@ -226,6 +305,7 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
         {
             parameter = node->getParameters()[parameterIndex];
             jassert (nullptr != parameter);
+            setCoalescedParameter (parameter.get());
         }
         else if (parameterIndex == Processor::EnabledParameter)
         {
@@ -241,6 +321,8 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
         channelObject.removeListener (this);
     }
 
+    int getDispatchKey() const noexcept override { return controllerNumber; }
+
     bool wants (const MidiMessage& message) const override
     {
         return message.isController() && message.getControllerNumber() == controllerNumber && (channel.get() == 0 || (channel.get() > 0 && message.getChannel() == channel.get()));
@@ -252,9 +334,7 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
 
         if (nullptr != parameter)
         {
-            parameter->beginChangeGesture();
-            parameter->setValueNotifyingHost (static_cast<float> (ccValue) / 127.f);
-            parameter->endChangeGesture();
+            postValue (static_cast<float> (ccValue) / 127.f);
         }
         else if (parameterIndex == Processor::EnabledParameter || parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
         {
@@ -311,35 +391,41 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
             }
 
             if (currentToggleState != desiredToggleState.get())
+            {
+                // bypass and mute are set here so the renderer has them next
+                // block, the model catches up later.
+                const bool state = desiredToggleState.get() == getStateToCompare();
+                if (parameterIndex == Processor::BypassParameter)
+                    node->setBypassFlag (! state); // inverted, see handleAsyncUpdate()
+                else if (parameterIndex == Processor::MuteParameter)
+                    node->setMuteFlag (state);
                 triggerAsyncUpdate();
+            }
         }
 
         lastControllerValue = ccValue;
     }
 
-    void handleAsyncUpdate() override
+    int getStateToCompare() const noexcept
     {
-        const auto mode = toggleMode.get();
-        const int stateToCompare = mode != Control::toggleEquals
-                                       ? (inverseToggle.get() == 1 ? 0 : 1) // inverse on, then compare false
-                                       : 1; // equals mode always compare true
+        return toggleMode.get() != Control::toggleEquals
+                   ? (inverseToggle.get() == 1 ? 0 : 1) // inverse on, then compare false
+                   : 1; // equals mode always compare true
+    }
 
+    void handleAsyncUpdate() override
+    {
         if (parameterIndex == Processor::EnabledParameter)
         {
-            node->setEnabled (desiredToggleState.get() == stateToCompare);
+            node->setEnabled (desiredToggleState.get() == getStateToCompare());
             if (model.isEnabled() != node->isEnabled())
                 model.setProperty (tags::enabled, node->isEnabled());
         }
-        else if (parameterIndex == Processor::BypassParameter)
-        {
-            // inverted because UI displays bypass as inactive (or active for not bypassed)
-            node->suspendProcessing (! (desiredToggleState.get() == stateToCompare));
-            if (model.isBypassed() != node->isSuspended())
-                model.setProperty (tags::bypass, node->isSuspended());
-        }
-        else if (parameterIndex == Processor::MuteParameter)
+        else if (parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
         {
-            model.setMuted (desiredToggleState.get() == stateToCompare);
+            // bypass is inverted because UI displays bypass as inactive (or
+            // active for not bypassed). It was already applied in perform().
+            syncBypassAndMute (node, model);
         }
     }
 
@@ -389,6 +475,77 @@ private:
     }
 };
 
+/** Maps a 14-bit CC or NRPN controller to a parameter. */
+struct MidiHighResControllerMap : public ControllerMapHandler,
+                                  private Value::Listener
+{
+    MidiHighResControllerMap (const Control& ctl, const Node& _node, const int _parameter)
+        : control (ctl),
+          model (_node),
+          node (_node.getObject()),
+          parameterIndex (_parameter),
+          key (ControllerEvent::key (ctl.getResolution() == Control::resolutionNRPN ? ControllerEvent::NRPN
+                                                                                    : ControllerEvent::Controller14,
+                                     ctl.getEventId()))
+    {
+        jassert (control.isHighResolution());
+        jassert (node);
+
+        channelObject = control.getPropertyAsValue (tags::midiChannel);
+        channelObject.addListener (this);
+        valueChanged (channelObject);
+
+        if (isPositiveAndBelow (parameterIndex, node->getParameters().size()))
+            parameter = node->getParameters()[parameterIndex];
+        jassert (nullptr != parameter);
+        setCoalescedParameter (parameter.get());
+    }
+
+    ~MidiHighResControllerMap()
+    {
+        channelObject.removeListener (this);
+    }
+
+    int getDispatchKey() const noexcept override { return -1; }
+    bool wants (const MidiMessage&) const override { return false; }
+    void perform (const MidiMessage&) override {}
+
+    int getHighResolutionKey() const noexcept override { return key; }
+
+    bool wantsEvent (const ControllerEvent& event) const override
+    {
+        return event.getKey() == key && (channel.get() == 0 || event.channel == channel.get());
+    }
+
+    void performEvent (const ControllerEvent& event) override
+    {
+        // surfaces resend unchanged values, only pass on real changes.
+        if (parameter == nullptr || event.value == lastValue)
+            return;
+
+        lastValue = event.value;
+        postValue (event.getNormalized());
+    }
+
+private:
+    Control control;
+    Node model;
+    ProcessorPtr node { nullptr };
+    ParameterPtr parameter { nullptr };
+    const int parameterIndex { -1 };
+    const int key;
+    int lastValue = -1;
+
+    Value channelObject;
+    Atomic<int> channel { 0 };
+
+    void valueChanged (Value& value) override
+    {
+        if (channelObject.refersToSameSourceAs (value))
+            channel.set (jlimit (0, 16, (int) channelObject.getValue()));
+    }
+};
+
 class ControllerMapInput : public MidiInputCallback
 {
 public:
@@ -411,12 +568,24 @@ public:
         //     << " : " << message.getControllerValue());
         if (message.isNoteOn())
             mapping.captureNextEvent (*this, notes[message.getNoteNumber()], message);
-        else if (message.isController())
+        else if (message.isController() && controls.contains (message.getControllerNumber()))
             mapping.captureNextEvent (*this, controls[message.getControllerNumber()], message);
 
-        for (auto* handler : handlers)
+        // only handlers mapped to this CC or note are asked.
+        const auto key = ControllerMapHandler::dispatchKey (message);
+        for (auto* handler : dispatch[(size_t) key])
             if (handler->wants (message))
                 handler->perform (message);
+
+        if (! highResDispatch.empty())
+        {
+            ControllerEvent event;
+            if (decoder.decode (message, event))
+                if (auto iter = highResDispatch.find (event.getKey()); iter != highResDispatch.end())
+                    for (auto* handler : iter->second)
+                        if (handler->wantsEvent (event))
+                            handler->performEvent (event);
+        }
     }
 
     bool close()
@@ -433,7 +602,23 @@ public:
         {
             const auto control (controllerDevice.getControl (i));
             const auto midi (control.getMidiMessage());
-            if (midi.isController())
+            if (control.isHighResolution())
+            {
+                // let both halves of the pair through to the decoder.
+                const int number = control.getEventId();
+                if (control.getResolution() == Control::resolution14Bit && isPositiveAndBelow (number, 32))
+                {
+                    controllerNumbers.setBit (number, true);
+                    controllerNumbers.setBit (number + 32, true);
+                    controls.set (number, control);
+                }
+                else if (control.getResolution() == Control::resolutionNRPN)
+                {
+                    for (const int cc : { 6, 38, 98, 99, 100, 101 })
+                        controllerNumbers.setBit (cc, true);
+                }
+            }
+            else if (midi.isController())
             {
                 controllerNumbers.setBit (midi.getControllerNumber(), true);
                 controls.set (midi.getControllerNumber(), control);
@@ -445,6 +630,20 @@ public:
             }
         }
 
+        // the callback is removed while this is rebuilt, so the MIDI thread
+        // never sees it half done.
+        for (auto& slot : dispatch)
+            slot.clearQuick();
+        highResDispatch.clear();
+        decoder.reset();
+        for (auto* handler : handlers)
+        {
+            if (isPositiveAndBelow (handler->getDispatchKey(), ControllerMapHandler::numDispatchKeys))
+                dispatch[(size_t) handler->getDispatchKey()].add (handler);
+            if (handler->getHighResolutionKey() >= 0)
+                highResDispatch[handler->getHighResolutionKey()].add (handler);
+        }
+
         const auto deviceId = controllerDevice.getInputDevice().toString();
         midi.addMidiInputCallback (deviceId, this, true);
 
@@ -478,12 +677,22 @@ public:
         start();
     }
 
+    /** Apply coalesced parameter values, see ControllerMapHandler::flush(). */
+    void flush()
+    {
+        for (auto* handler : handlers)
+            handler->flush();
+    }
+
 private:
     MidiEngine& midi;
     MappingEngine& mapping;
     Controller controllerDevice;
     std::unique_ptr<MidiInput> midiInput;
     OwnedArray<ControllerMapHandler> handlers;
+    std::array<Array<ControllerMapHandler*>, ControllerMapHandler::numDispatchKeys> dispatch;
+    std::unordered_map<int, Array<ControllerMapHandler*>> highResDispatch;
+    ControllerDecoder decoder;
     BigInteger controllerNumbers, noteNumbers;
     HashMap<int, Control> controls, notes;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ControllerMapInput)
@@ -497,6 +706,7 @@ public:
 
     bool add (ControllerMapInput* input)
     {
+        const ScopedLock sl (lock);
         if (inputs.contains (input))
             return true;
         inputs.add (input);
@@ -510,6 +720,7 @@ public:
         if (auto* input = findInput (device))
         {
             input->close();
+            const ScopedLock sl (lock);
             inputs.removeObject (input, true);
         }
 
@@ -521,9 +732,21 @@ public:
         stop();
         for (auto* input : inputs)
             input->close();
+        const ScopedLock sl (lock);
         inputs.clear (true);
     }
 
+    /** Apply coalesced parameter values on every input. */
+    void flush()
+    {
+        const ScopedLock sl (lock);
+        for (auto* input : inputs)
+            input->flush();
+    }
+
+    /** Held while inputs or their handlers are added or removed. */
+    const CriticalSection& getLock() const noexcept { return lock; }
+
     void start()
     {
         if (isRunning())
@@ -567,17 +790,45 @@ public:
 
 private:
     OwnedArray<ControllerMapInput> inputs;
+    CriticalSection lock;
     bool running = false;
 };
 
+/** Applies coalesced controller values at a steady rate, about one audio
+    block apart. Runs on its own thread so the MIDI input threads only ever
+    store a value.
+ */
+class MappingEngine::Flusher : private HighResolutionTimer
+{
+public:
+    static constexpr int periodMs = 5;
+
+    explicit Flusher (Inputs& i) : inputs (i) {}
+    ~Flusher() { stop(); }
+
+    void start() { startTimer (periodMs); }
+
+    void stop()
+    {
+        stopTimer();
+        inputs.flush();
+    }
+
+private:
+    Inputs& inputs;
+    void hiResTimerCallback() override { inputs.flush(); }
+};
+
 MappingEngine::MappingEngine()
 {
     inputs.reset (new Inputs());
+    flusher.reset (new Flusher (*inputs));
     capturedEvent.capture.set (true);
 }
 
 MappingEngine::~MappingEngine()
 {
+    flusher = nullptr;
     inputs->clear();
     inputs = nullptr;
 }
@@ -610,13 +861,18 @@ bool MappingEngine::addHandler (const Control& control,
             const auto message (control.getMidiMessage());
             std::unique_ptr<ControllerMapHandler> handler;
 
-            if (message.isController())
+            if (control.isHighResolution() && isPositiveAndBelow (parameter, object->getParameters().size()))
+                handler.reset (new MidiHighResControllerMap (control, node, parameter));
+            else if (control.isHighResolution() && control.getResolution() == Control::resolutionNRPN)
+                return false; // NRPN can't toggle enable, bypass or mute
+            else if (message.isController())
                 handler.reset (new MidiCCControllerMapHandler (control, message, node, parameter));
             else if (message.isNoteOn())
                 handler.reset (new MidiNoteControllerMap (control, message, node, parameter));
 
             if (nullptr != handler)
             {
+                const ScopedLock sl (inputs->getLock());
                 input->addHandler (handler.release());
                 return true;
             }
@@ -657,10 +913,12 @@ void MappingEngine::startMapping()
 {
     stopMapping();
     inputs->start();
+    flusher->start();
 }
 
 void MappingEngine::stopMapping()
 {
+    flusher->stop();
     inputs->stop();
 }
 
@@ -41,6 +41,8 @@ private:
     friend class ControllerMapInput;
     class Inputs;
     std::unique_ptr<Inputs> inputs;
+    class Flusher;
+    std::unique_ptr<Flusher> flusher;
 
     class CapturedEvent : public AsyncUpdater
     {
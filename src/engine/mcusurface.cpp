@@ -0,0 +1,195 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+
+#include "engine/mcusurface.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace {
+// fader touch notes run from here, one per fader.
+constexpr int firstTouchNote = 0x68;
+
+// F0 00 00 66 14 12 offset ... F7
+constexpr uint8 lcdHeader[] = { 0xf0, 0x00, 0x00, 0x66, 0x14, 0x12 };
+constexpr int lcdOverhead = (int) sizeof (lcdHeader) + 2;
+} // namespace
+
+McuSurface::McuSurface()
+{
+    for (int i = 0; i < numFaders; ++i)
+    {
+        faders[i].store (0);
+        touched[i].store (false);
+    }
+    for (auto& led : leds)
+        led.store (0);
+    for (auto& c : chars)
+        c.store (' ');
+
+    std::fill (std::begin (sentFaders), std::end (sentFaders), -1);
+    std::fill (std::begin (sentLeds), std::end (sentLeds), -1);
+    std::fill (std::begin (sentChars), std::end (sentChars), -1);
+}
+
+void McuSurface::setFader (int index, int value) noexcept
+{
+    if (isPositiveAndBelow (index, numFaders))
+        faders[index].store (jlimit (0, 16383, value), std::memory_order_relaxed);
+}
+
+int McuSurface::getFader (int index) const noexcept
+{
+    return isPositiveAndBelow (index, numFaders) ? faders[index].load (std::memory_order_relaxed) : 0;
+}
+
+void McuSurface::setFaderTouched (int index, bool isTouched) noexcept
+{
+    if (isPositiveAndBelow (index, numFaders))
+        touched[index].store (isTouched, std::memory_order_relaxed);
+}
+
+void McuSurface::setLed (int note, int velocity) noexcept
+{
+    if (isPositiveAndBelow (note, numLeds))
+        leds[note].store ((uint8) jlimit (0, 127, velocity), std::memory_order_relaxed);
+}
+
+void McuSurface::setText (int position, const String& text) noexcept
+{
+    auto p = text.getCharPointer();
+    for (int i = jmax (0, position); i < numChars && ! p.isEmpty(); ++i)
+    {
+        const auto c = p.getAndAdvance();
+        chars[i].store ((uint8) (c >= 0x20 && c < 0x7f ? c : '?'), std::memory_order_relaxed);
+    }
+}
+
+void McuSurface::prepare (double sampleRate, double refreshHz, int bytesPerSecond)
+{
+    tickSamples = jmax (1, roundToInt (sampleRate / jmax (1.0, refreshHz)));
+    untilTick = 0;
+    bytesPerSample = (double) bytesPerSecond / sampleRate;
+
+    // a tick can use what the cable carried since the last, with a
+    // little slack for jitter in block sizes.
+    maxCredit = 2.0 * bytesPerSample * (double) tickSamples;
+    credit = maxCredit;
+    bytesSent.store (0);
+    resendAll.store (true);
+}
+
+void McuSurface::handleInput (const MidiBuffer& input) noexcept
+{
+    for (const auto m : input)
+    {
+        const auto* data = m.data;
+        if (m.numBytes != 3 || (data[0] & 0xf0) != 0x90)
+            continue;
+        const int index = data[1] - firstTouchNote;
+        if (isPositiveAndBelow (index, numFaders))
+            setFaderTouched (index, data[2] != 0);
+    }
+}
+
+void McuSurface::process (MidiBuffer& out, int numSamples) noexcept
+{
+    credit = jmin (maxCredit, credit + bytesPerSample * (double) numSamples);
+
+    untilTick -= numSamples;
+    if (untilTick > 0)
+        return;
+    untilTick += tickSamples;
+    if (untilTick <= 0)
+        untilTick = tickSamples;
+
+    if (resendAll.exchange (false))
+    {
+        std::fill (std::begin (sentFaders), std::end (sentFaders), -1);
+        std::fill (std::begin (sentLeds), std::end (sentLeds), -1);
+        std::fill (std::begin (sentChars), std::end (sentChars), -1);
+    }
+
+    const int used = flush (out, (int) credit);
+    credit -= (double) used;
+    bytesSent.fetch_add (used, std::memory_order_relaxed);
+}
+
+int McuSurface::flush (MidiBuffer& out, int budget) noexcept
+{
+    int used = 0;
+
+    // motors first, they're what the user feels lag on.
+    for (int i = 0; i < numFaders && used + 3 <= budget; ++i)
+    {
+        const int value = faders[i].load (std::memory_order_relaxed);
+        if (value == sentFaders[i] || touched[i].load (std::memory_order_relaxed))
+            continue;
+        const uint8 msg[] = { (uint8) (0xe0 | i), (uint8) (value & 0x7f), (uint8) (value >> 7) };
+        out.addEvent (msg, 3, 0);
+        sentFaders[i] = value;
+        used += 3;
+    }
+
+    for (int i = 0; i < numLeds && used + 3 <= budget; ++i)
+    {
+        const int value = leds[i].load (std::memory_order_relaxed);
+        if (value == sentLeds[i])
+            continue;
+        const uint8 msg[] = { 0x90, (uint8) i, (uint8) value };
+        out.addEvent (msg, 3, 0);
+        sentLeds[i] = value;
+        used += 3;
+    }
+
+    // changed characters go out in runs. A short gap is cheaper to resend
+    // than another message header.
+    uint8 text[numChars];
+    for (int i = 0; i < numChars; ++i)
+        text[i] = chars[i].load (std::memory_order_relaxed);
+
+    int i = 0;
+    while (i < numChars && used + lcdOverhead < budget)
+    {
+        if (text[i] == sentChars[i])
+        {
+            ++i;
+            continue;
+        }
+
+        int end = i + 1, gap = 0;
+        for (int j = end; j < numChars && gap < lcdOverhead; ++j)
+        {
+            if (text[j] != sentChars[j])
+            {
+                end = j + 1;
+                gap = 0;
+            }
+            else
+            {
+                ++gap;
+            }
+        }
+
+        const int count = jmin (end - i, budget - used - lcdOverhead);
+        uint8 msg[lcdOverhead + numChars];
+        std::copy (std::begin (lcdHeader), std::end (lcdHeader), msg);
+        msg[sizeof (lcdHeader)] = (uint8) i;
+        for (int c = 0; c < count; ++c)
+        {
+            msg[sizeof (lcdHeader) + 1 + c] = text[i + c];
+            sentChars[i + c] = text[i + c];
+        }
+        msg[lcdOverhead + count - 1] = 0xf7;
+        out.addEvent (msg, lcdOverhead + count, 0);
+        used += lcdOverhead + count;
+        i += count;
+    }
+
+    return used;
+}
+
+} // namespace element
@@ -0,0 +1,85 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** What a Mackie Control surface should show, and what it was last sent.
+
+    Faders, LEDs and the scribble strip LCD are set from any thread and
+    only the difference from what was sent goes out, coalesced once per
+    refresh tick. Each tick may only spend the bytes a MIDI cable carries
+    in that time. Faders go first, then LEDs, then the display. Anything
+    that doesn't fit waits for the next tick, so a flood of changes ends
+    up as the newest state instead of a backlog.
+ */
+class McuSurface final
+{
+public:
+    static constexpr int numFaders = 9; ///< eight strips and the master
+    static constexpr int numLeds = 128; ///< addressed by note number
+    static constexpr int numChars = 112; ///< two rows of 56
+    static constexpr int midiBytesPerSecond = 3125; ///< 31250 baud, ten bits a byte
+
+    McuSurface();
+
+    /** Position a motor fader, 0 to 16383. Any thread. */
+    void setFader (int index, int value) noexcept;
+    int getFader (int index) const noexcept;
+
+    /** A touched fader belongs to the user and isn't driven. Any thread. */
+    void setFaderTouched (int index, bool touched) noexcept;
+
+    /** Set an LED, 0 is off, 1 blinks and 127 is on. Any thread. */
+    void setLed (int note, int velocity) noexcept;
+
+    /** Write text to the LCD starting at a character. Any thread. */
+    void setText (int position, const juce::String& text) noexcept;
+
+    /** Send everything again on the next tick, e.g. after the surface
+        comes online. Any thread.
+     */
+    void invalidate() noexcept { resendAll.store (true); }
+
+    /** Set the rate and refresh. Not while process() may run. */
+    void prepare (double sampleRate, double refreshHz = 50.0, int bytesPerSecond = midiBytesPerSecond);
+
+    /** Pick up fader touches from the surface. Audio thread. */
+    void handleInput (const juce::MidiBuffer& input) noexcept;
+
+    /** Add the changes due this block to out. Audio thread. */
+    void process (juce::MidiBuffer& out, int numSamples) noexcept;
+
+    /** Returns the number of bytes sent since prepare(). */
+    juce::int64 getNumBytesSent() const noexcept { return bytesSent.load(); }
+
+private:
+    std::atomic<int> faders[numFaders];
+    std::atomic<bool> touched[numFaders];
+    std::atomic<juce::uint8> leds[numLeds];
+    std::atomic<juce::uint8> chars[numChars];
+    std::atomic<bool> resendAll { true };
+
+    // audio thread, -1 for unknown
+    int sentFaders[numFaders];
+    int sentLeds[numLeds];
+    int sentChars[numChars];
+
+    int tickSamples = 882;
+    int untilTick = 0;
+    double bytesPerSample = 0.0;
+    double credit = 0.0, maxCredit = 0.0;
+    std::atomic<juce::int64> bytesSent { 0 };
+
+    int flush (juce::MidiBuffer& out, int budget) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (McuSurface)
+};
+
+} // namespace element
@@ -0,0 +1,167 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+
+#include <element/juce/audio_basics.hpp>
+
+namespace element {
+
+/** Captures MIDI on the audio thread for display elsewhere.
+
+    A fixed size, single producer single consumer ring of timestamped
+    events. The audio thread pushes and never waits or allocates, anything
+    that doesn't fit is counted and dropped. Events are filtered by kind
+    before they're stored, so unwanted traffic like clock costs nothing
+    past the check. Only the first few bytes of long messages are kept.
+ */
+class MidiCapture final
+{
+public:
+    static constexpr int capacity = 4096;
+    static constexpr int maxBytes = 3;
+
+    /** Kinds of message, combine them for a filter. */
+    enum Kind : juce::uint32
+    {
+        notes = 1 << 0,
+        controllers = 1 << 1,
+        programs = 1 << 2,
+        pitchBend = 1 << 3,
+        pressure = 1 << 4,
+        clock = 1 << 5,
+        transport = 1 << 6,
+        sysex = 1 << 7,
+        other = 1 << 8,
+        allKinds = (1 << 9) - 1
+    };
+
+    struct Event
+    {
+        double time = 0.0; // seconds
+        int size = 0;      // of the whole message
+        juce::uint8 data[maxBytes] {};
+
+        /** Returns the stored bytes as a message. Not for sysex, which is cut short. */
+        juce::MidiMessage toMessage() const
+        {
+            return juce::MidiMessage (data, juce::jmin (size, maxBytes), time);
+        }
+    };
+
+    MidiCapture() = default;
+
+    /** Returns the kind of a raw message. */
+    static juce::uint32 getKind (const juce::uint8* data, int size) noexcept
+    {
+        if (size <= 0)
+            return other;
+
+        const auto status = data[0];
+        if (status == 0xf0)
+            return sysex;
+        if (status == 0xf8)
+            return clock;
+        if (status == 0xfa || status == 0xfb || status == 0xfc)
+            return transport;
+        if (status >= 0xf0)
+            return other;
+
+        switch (status & 0xf0)
+        {
+            case 0x80:
+            case 0x90:
+                return notes;
+            case 0xb0:
+                return controllers;
+            case 0xc0:
+                return programs;
+            case 0xe0:
+                return pitchBend;
+            case 0xa0:
+            case 0xd0:
+                return pressure;
+            default:
+                break;
+        }
+
+        return other;
+    }
+
+    /** Set the kinds of message captured. Any thread. */
+    void setFilter (juce::uint32 kinds) noexcept { filter.store (kinds, std::memory_order_relaxed); }
+
+    /** Returns the kinds of message captured. */
+    juce::uint32 getFilter() const noexcept { return filter.load (std::memory_order_relaxed); }
+
+    /** Capture a message. Audio thread. Returns false if it was filtered
+        out or dropped because the ring is full.
+     */
+    bool push (const juce::uint8* data, int size, double time) noexcept
+    {
+        if ((getKind (data, size) & filter.load (std::memory_order_relaxed)) == 0)
+            return false;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+        if (size1 + size2 < 1)
+        {
+            dropped.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+
+        auto& ev = events[size1 > 0 ? start1 : start2];
+        ev.time = time;
+        ev.size = size;
+        std::memcpy (ev.data, data, (size_t) juce::jmin (size, maxBytes));
+        fifo.finishedWrite (1);
+        captured.fetch_add (1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** Move up to maxEvents captured events to dest. Reader thread.
+        Returns the number moved.
+     */
+    int pop (Event* dest, int maxEvents) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (maxEvents, start1, size1, start2, size2);
+        std::copy (events + start1, events + start1 + size1, dest);
+        std::copy (events + start2, events + start2 + size2, dest + size1);
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    /** Throw away everything waiting. Reader thread. */
+    void discard() noexcept { fifo.finishedRead (fifo.getNumReady()); }
+
+    /** Returns the number of events waiting. */
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+    /** Returns the number of events captured since the last reset. */
+    juce::int64 getNumCaptured() const noexcept { return captured.load (std::memory_order_relaxed); }
+
+    /** Returns the number of events dropped since the last reset. */
+    juce::int64 getNumDropped() const noexcept { return dropped.load (std::memory_order_relaxed); }
+
+    /** Reset the counters. */
+    void resetCounters() noexcept
+    {
+        captured.store (0, std::memory_order_relaxed);
+        dropped.store (0, std::memory_order_relaxed);
+    }
+
+private:
+    Event events[capacity];
+    juce::AbstractFifo fifo { capacity };
+    std::atomic<juce::uint32> filter { allKinds & ~(juce::uint32) clock };
+    std::atomic<juce::int64> captured { 0 };
+    std::atomic<juce::int64> dropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (MidiCapture)
+};
+
+} // namespace element
@@ -10,41 +10,120 @@ void MidiClock::process (const MidiMessage& msg)
     jassert (sampleRate > 0.0 && blockSize > 0);
     jassert (msg.isMidiClock() || msg.isSongPositionPointer());
 
+    const double time = msg.getTimeStamp();
+    numTicks.fetch_add (1, std::memory_order_relaxed);
+
+    if (midiClockTicks > 1 && time - timeOfLastTick > dropoutPeriods * period)
+    {
+        if (locked.load (std::memory_order_relaxed))
+        {
+            dropouts.fetch_add (1, std::memory_order_relaxed);
+            for (auto* listener : listeners)
+                listener->midiClockSignalDropped();
+        }
+
+        restart (time);
+        return;
+    }
+
     if (midiClockTicks <= 0)
     {
-        dll.reset (msg.getTimeStamp(), (double) blockSize / sampleRate, 1.0);
-        dll.setParams ((double) blockSize / sampleRate, 1.0);
+        restart (time);
+        return;
+    }
+
+    if (midiClockTicks == 1)
+    {
+        // the first interval seeds the loop, it's refined from here on.
+        period = time - timeOfLastTick;
+        if (period <= 0.0)
+        {
+            restart (time);
+            return;
+        }
+
+        dll.reset (time, period, 1.0);
+        dll.setParams (loopBandwidth, 1.0 / period);
     }
     else
     {
-        dll.update (msg.getTimeStamp());
+        const double error = std::abs (time - dll.nextTime());
+        dll.update (time);
+        period = dll.timeDiff();
+
+        // only the MIDI thread writes these, a plain read-modify-write is enough.
+        if (midiClockTicks >= syncPeriodTicks)
+        {
+            numErrors.fetch_add (1, std::memory_order_relaxed);
+            errorSum.store (errorSum.load (std::memory_order_relaxed) + error * error, std::memory_order_relaxed);
+            if (error > maxError.load (std::memory_order_relaxed))
+                maxError.store (error, std::memory_order_relaxed);
+        }
     }
 
+    timeOfLastTick = time;
+    ++midiClockTicks;
+
     if (midiClockTicks == syncPeriodTicks)
+    {
+        locked.store (true, std::memory_order_relaxed);
         for (auto* listener : listeners)
             listener->midiClockSignalAcquired();
+    }
 
-    if (midiClockTicks >= syncPeriodTicks && msg.getTimeStamp() - timeOfLastUpdate >= 1.0)
+    if (midiClockTicks >= syncPeriodTicks && time - timeOfLastUpdate >= bpmUpdateSeconds && period > 0.0)
     {
-        lastKnownTimeDiff = dll.timeDiff();
-        const double bpm = 60.0 / (lastKnownTimeDiff * 24.0);
-        timeOfLastUpdate = msg.getTimeStamp();
+        const double newBpm = 60.0 / (period * 24.0);
+        timeOfLastUpdate = time;
 
-        if (bpm >= 20.0 && bpm <= 999.0)
+        if (newBpm >= 20.0 && newBpm <= 999.0)
+        {
+            bpm.store (newBpm, std::memory_order_relaxed);
             for (auto* listener : listeners)
-                listener->midiClockTempoChanged (bpm);
+                listener->midiClockTempoChanged ((float) newBpm);
+        }
     }
+}
 
-    ++midiClockTicks;
+void MidiClock::restart (double time) noexcept
+{
+    locked.store (false, std::memory_order_relaxed);
+    bpm.store (0.0, std::memory_order_relaxed);
+    timeOfLastTick = time;
+    timeOfLastUpdate = 0.0;
+    period = 0.0;
+    midiClockTicks = 1;
 }
 
 void MidiClock::reset (const double sr, const int bs)
 {
     sampleRate = sr;
     blockSize = bs;
+    timeOfLastTick = 0.0;
     timeOfLastUpdate = 0.0;
-    lastKnownTimeDiff = 0.0;
+    period = 0.0;
     midiClockTicks = 0;
+
+    numTicks.store (0, std::memory_order_relaxed);
+    numErrors.store (0, std::memory_order_relaxed);
+    dropouts.store (0, std::memory_order_relaxed);
+    locked.store (false, std::memory_order_relaxed);
+    bpm.store (0.0, std::memory_order_relaxed);
+    errorSum.store (0.0, std::memory_order_relaxed);
+    maxError.store (0.0, std::memory_order_relaxed);
+}
+
+MidiClock::Stats MidiClock::getStats() const noexcept
+{
+    Stats s;
+    s.numTicks = numTicks.load (std::memory_order_relaxed);
+    s.dropouts = dropouts.load (std::memory_order_relaxed);
+    s.locked = locked.load (std::memory_order_relaxed);
+    s.bpm = bpm.load (std::memory_order_relaxed);
+    s.maxJitterMs = 1000.0 * maxError.load (std::memory_order_relaxed);
+    if (const auto n = numErrors.load (std::memory_order_relaxed); n > 0)
+        s.jitterMs = 1000.0 * std::sqrt (errorSum.load (std::memory_order_relaxed) / (double) n);
+    return s;
 }
 
 void MidiClock::addListener (Listener* listener)
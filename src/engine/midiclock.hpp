@@ -3,14 +3,30 @@
 
 #pragma once
 
+#include <atomic>
+#include <cmath>
+
+#include <element/audioengine.hpp>
+
 #include "ElementApp.h"
 #include "delaylockedloop.hpp"
+#include "engine/fixedmidi.hpp"
 
 namespace element {
 
+/** Follows an external MIDI clock.
+
+    Tick arrival times go through a delay locked loop tuned to the tick
+    rate, so the reported tempo is the loop's smoothed period and not the
+    last interval. The loop's prediction error for each tick is kept as
+    jitter statistics. A clock that stops for more than a few periods is
+    reported dropped and locking starts over with the next tick.
+ */
 class MidiClock
 {
 public:
+    using Stats = AudioEngine::MidiClockStats;
+
     class Listener
     {
     public:
@@ -25,9 +41,20 @@ public:
     MidiClock() = default;
     ~MidiClock() {}
 
+    /** Ticks needed before the clock counts as locked. */
+    static constexpr int syncPeriodTicks = 48;
+    /** Loop bandwidth in Hz. Lower is smoother but slower to follow changes. */
+    static constexpr double loopBandwidth = 0.5;
+    /** A gap of this many periods means the clock dropped. */
+    static constexpr double dropoutPeriods = 4.0;
+
+    /** Handle a clock message, timestamped in seconds. */
     void process (const MidiMessage& msg);
     void reset (const double sampleRate, const int blockSize);
 
+    /** Returns the statistics so far. Safe to call from any thread. */
+    Stats getStats() const noexcept;
+
     void addListener (Listener*);
     void removeListener (Listener*);
 
@@ -35,32 +62,53 @@ private:
     double sampleRate = 0.0;
     int blockSize = 0;
     DelayLockedLoop dll;
+    double timeOfLastTick = 0.0;
     double timeOfLastUpdate = 0.0;
-    double lastKnownTimeDiff = 0.0;
+    double period = 0.0;
     int midiClockTicks = 0;
-    int syncPeriodTicks = 48;
-    [[maybe_unused]] double bpmUpdateSeconds = 1.0;
+    double bpmUpdateSeconds = 1.0;
+
+    std::atomic<int64> numTicks { 0 }, numErrors { 0 }, dropouts { 0 };
+    std::atomic<bool> locked { false };
+    std::atomic<double> bpm { 0.0 }, errorSum { 0.0 }, maxError { 0.0 };
 
     Array<Listener*> listeners;
+
+    void restart (double time) noexcept;
 };
 
+/** Generates MIDI clock at 24 ticks per quarter note.
+
+    Tick positions are kept as a fractional sample offset, so the clock
+    doesn't drift when a tick period isn't a whole number of samples. Each
+    tick lands on the sample it falls in.
+ */
 class MidiClockMaster
 {
 public:
     MidiClockMaster()
     {
-        clockMessage = MidiMessage::midiClock();
         updateCoefficients();
     }
 
     ~MidiClockMaster() noexcept {}
 
+    /** Put the next tick at the start of the next block. */
     inline void reset()
     {
-        pos = 0;
+        nextClock = 0.0;
         updateCoefficients();
     }
 
+    /** Align ticks with a transport position, e.g. after start or continue. */
+    inline void sync (int64 frame) noexcept
+    {
+        if (samplesPerClock <= 0.0)
+            return;
+        const double phase = std::fmod ((double) frame, samplesPerClock);
+        nextClock = phase > 0.0 ? samplesPerClock - phase : 0.0;
+    }
+
     inline void setTempo (const double newTempo) noexcept
     {
         if (tempo == newTempo)
@@ -77,35 +125,37 @@ public:
         updateCoefficients();
     }
 
+    /** Returns the tick period in samples, not rounded. */
+    inline double getSamplesPerClock() const noexcept { return samplesPerClock; }
+
     inline void render (MidiBuffer& midi, int numSamples) noexcept
     {
-        if (samplesPerClock <= 0)
+        if (samplesPerClock <= 0.0)
             return;
 
-        int frame = static_cast<int> (pos % samplesPerClock);
-        if (frame > 0)
-            frame = samplesPerClock - frame;
-        while (frame < numSamples)
+        static constexpr uint8 clock[] = { 0xf8 };
+        while (nextClock < (double) numSamples)
         {
-            midi.addEvent (clockMessage, frame);
-            frame += samplesPerClock;
+            FixedMidi::add (midi, clock, 1, (int) nextClock);
+            nextClock += samplesPerClock;
         }
 
-        pos += numSamples;
+        nextClock -= (double) numSamples;
     }
 
 private:
-    MidiMessage clockMessage;
-    int64 pos = 0;
     double tempo = 120.0;
     double sampleRate = 44100.0;
-    int samplesPerClock = 0;
-    double clocksPerMinute = 1.0;
+    double samplesPerClock = 0.0;
+    double nextClock = 0.0;
 
     void updateCoefficients()
     {
-        clocksPerMinute = 24.f * tempo;
-        samplesPerClock = roundToIntAccurate ((60.0 * sampleRate) / clocksPerMinute);
+        const auto previous = samplesPerClock;
+        samplesPerClock = tempo > 0.0 ? (60.0 * sampleRate) / (24.0 * tempo) : 0.0;
+        // keep the phase when the tempo changes between ticks.
+        if (previous > 0.0 && samplesPerClock > 0.0)
+            nextClock *= samplesPerClock / previous;
     }
 };
 
@@ -1,6 +1,9 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <algorithm>
+#include <deque>
+
 #include <element/juce/audio_basics.hpp>
 #include <element/juce/audio_devices.hpp>
 #include <element/juce/data_structures.hpp>
@@ -149,12 +152,132 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CallbackHandler)
 };
 
+//==============================================================================
+/** Sends queued messages to the default output when they're due.
+
+    The audio thread writes timestamped messages to a single producer,
+    single consumer byte ring. This thread drains it, keeps the messages
+    in time order and takes midiOutputLock itself, so a device change can
+    only ever hold up this thread.
+ */
+class MidiEngine::OutputThread : public juce::Thread
+{
+public:
+    OutputThread (MidiEngine& me) : juce::Thread ("element: midi out"), owner (me)
+    {
+        ring.calloc (ringSize);
+    }
+
+    ~OutputThread() override
+    {
+        stopThread (1000);
+    }
+
+    bool push (const MidiMessageMetadata& msg, double timeMs) noexcept
+    {
+        const auto size = (uint32) msg.numBytes;
+        const auto needed = (uint32) (sizeof (double) + sizeof (uint16)) + size;
+        const auto w = writePos.load (std::memory_order_relaxed);
+        if (size > 0xffff || ringSize - (w - readPos.load (std::memory_order_acquire)) < needed)
+            return false;
+
+        const uint16 size16 = (uint16) size;
+        auto pos = w;
+        pos = write (pos, &timeMs, sizeof (double));
+        pos = write (pos, &size16, sizeof (uint16));
+        pos = write (pos, msg.data, size);
+        writePos.store (pos, std::memory_order_release);
+        return true;
+    }
+
+    int getNumPending() const noexcept { return numPending.load (std::memory_order_relaxed); }
+
+    void run() override
+    {
+        std::vector<uint8> data;
+        while (! threadShouldExit())
+        {
+            drain (data);
+
+            const auto now = Time::getMillisecondCounterHiRes();
+            {
+                const ScopedLock sl (owner.midiOutputLock);
+                auto* const output = owner.defaultMidiOutput.get();
+                while (! pending.empty() && pending.front().getTimeStamp() <= now)
+                {
+                    if (output != nullptr)
+                    {
+                        output->sendMessageNow (pending.front());
+                        owner.numMessagesOut.fetch_add (1, std::memory_order_relaxed);
+                    }
+                    pending.pop_front();
+                }
+            }
+            numPending.store ((int) pending.size(), std::memory_order_relaxed);
+
+            const int waitMs = pending.empty() ? 2 : jlimit (0, 2, (int) (pending.front().getTimeStamp() - now));
+            if (waitMs > 0)
+                wait (waitMs);
+        }
+    }
+
+private:
+    static constexpr uint32 ringSize = 1 << 16; // must be a power of two
+    MidiEngine& owner;
+    HeapBlock<uint8> ring;
+    std::atomic<uint32> readPos { 0 }, writePos { 0 };
+    std::deque<MidiMessage> pending;
+    std::atomic<int> numPending { 0 };
+
+    uint32 write (uint32 pos, const void* src, uint32 size) noexcept
+    {
+        const auto* bytes = static_cast<const uint8*> (src);
+        for (uint32 i = 0; i < size; ++i)
+            ring[(pos + i) & (ringSize - 1)] = bytes[i];
+        return pos + size;
+    }
+
+    uint32 read (uint32 pos, void* dst, uint32 size) const noexcept
+    {
+        auto* bytes = static_cast<uint8*> (dst);
+        for (uint32 i = 0; i < size; ++i)
+            bytes[i] = ring[(pos + i) & (ringSize - 1)];
+        return pos + size;
+    }
+
+    void drain (std::vector<uint8>& data)
+    {
+        auto r = readPos.load (std::memory_order_relaxed);
+        const auto w = writePos.load (std::memory_order_acquire);
+        while (r != w)
+        {
+            double timeMs = 0.0;
+            uint16 size = 0;
+            r = read (r, &timeMs, sizeof (double));
+            r = read (r, &size, sizeof (uint16));
+            data.resize (size);
+            r = read (r, data.data(), size);
+
+            MidiMessage msg (data.data(), (int) size, timeMs);
+            // blocks arrive in order, so this is nearly always an append.
+            auto iter = std::upper_bound (pending.begin(), pending.end(), timeMs, [] (double t, const MidiMessage& m) {
+                return t < m.getTimeStamp();
+            });
+            pending.insert (iter, std::move (msg));
+        }
+        readPos.store (r, std::memory_order_release);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (OutputThread)
+};
+
 void MidiEngine::MidiInputHolder::handleIncomingMidiMessage (MidiInput* source, const MidiMessage& message)
 {
     if (message.isActiveSense())
         return;
 
     jassert (source == input.get());
+    engine.numMessagesIn.fetch_add (1, std::memory_order_relaxed);
     const ScopedLock sl (engine.midiCallbackLock);
 
     for (auto& mc : engine.midiCallbacks)
@@ -170,6 +293,7 @@ MidiEngine::MidiEngine()
 
 MidiEngine::~MidiEngine()
 {
+    outputThread.reset();
     callbackHandler.reset (nullptr);
 }
 
@@ -308,6 +432,7 @@ void MidiEngine::handleIncomingMidiMessageInt (MidiInput* source, const MidiMess
 {
     if (! message.isActiveSense())
     {
+        numMessagesIn.fetch_add (1, std::memory_order_relaxed);
         const ScopedLock sl (midiCallbackLock);
         for (auto& mc : midiCallbacks)
             if (mc.consumer || mc.device.isEmpty() || mc.device == source->getIdentifier())
@@ -351,19 +476,19 @@ void MidiEngine::setDefaultMidiOutput (const MidiDeviceInfo& device)
         if (device.identifier.isNotEmpty())
             newMidiOut = MidiOutput::openDevice (device.identifier);
 
-        if (newMidiOut)
-            newMidiOut->startBackgroundThread();
+        if (newMidiOut && outputThread == nullptr)
+        {
+            outputThread = std::make_unique<OutputThread> (*this);
+            outputThread->startThread (juce::Thread::Priority::highest);
+        }
 
         {
             ScopedLock sl (midiOutputLock);
             defaultMidiOutput.swap (newMidiOut);
+            hasMidiOutput.store (defaultMidiOutput != nullptr);
         }
 
-        if (newMidiOut) // is now the old output
-        {
-            newMidiOut->stopBackgroundThread();
-            newMidiOut.reset();
-        }
+        newMidiOut.reset(); // is now the old output
 
         defaultMidiOutputName = device.name;
         defaultMidiOutputID = device.identifier;
@@ -372,4 +497,26 @@ void MidiEngine::setDefaultMidiOutput (const MidiDeviceInfo& device)
     }
 }
 
+bool MidiEngine::sendBlockOfMessages (const MidiBuffer& buffer,
+                                      double millisecondCounterToStartAt,
+                                      double sampleRate) noexcept
+{
+    if (! hasMidiOutput.load (std::memory_order_acquire) || outputThread == nullptr)
+        return false;
+
+    const double msPerSample = 1000.0 / sampleRate;
+    bool queued = true;
+    for (const auto msg : buffer)
+        queued = outputThread->push (msg, millisecondCounterToStartAt + msg.samplePosition * msPerSample) && queued;
+    return queued;
+}
+
+int64 MidiEngine::getNumMessagesIn() const noexcept { return numMessagesIn.load (std::memory_order_relaxed); }
+int64 MidiEngine::getNumMessagesOut() const noexcept { return numMessagesOut.load (std::memory_order_relaxed); }
+
+int MidiEngine::getNumOutputsPending() const noexcept
+{
+    return outputThread != nullptr ? outputThread->getNumPending() : 0;
+}
+
 } // namespace element
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <atomic>
+
 namespace element {
 
 class Settings;
@@ -101,6 +103,31 @@ public:
 
     void processMidiBuffer (const MidiBuffer& buffer, int nframes, double sampleRate);
 
+    /** Queue a block of messages for the default output. Realtime safe.
+
+        Messages are handed to a MIDI output thread through a lock free
+        FIFO and sent when they're due, so changing the output device never
+        blocks the caller. Returns false if there is no output, or if the
+        queue was full and messages were dropped.
+
+        @param millisecondCounterToStartAt  when the first frame is due, in
+                                            Time::getMillisecondCounterHiRes() units
+     */
+    bool sendBlockOfMessages (const MidiBuffer& buffer,
+                              double millisecondCounterToStartAt,
+                              double sampleRate) noexcept;
+
+    /** Returns the number of messages received from input devices so far. Any thread. */
+    int64 getNumMessagesIn() const noexcept;
+
+    /** Returns the number of messages sent to the default output so far. Any thread. */
+    int64 getNumMessagesOut() const noexcept;
+
+    /** Returns the number of messages waiting to be sent to the default
+        output. Updated by the output thread every couple of milliseconds.
+     */
+    int getNumOutputsPending() const noexcept;
+
     CriticalSection& getMidiOutputLock() { return midiOutputLock; }
 
 private:
@@ -139,8 +166,13 @@ private:
     std::unique_ptr<MidiOutput> defaultMidiOutput;
     CriticalSection audioCallbackLock, midiCallbackLock, midiOutputLock;
 
+    std::atomic<bool> hasMidiOutput { false };
+    std::atomic<int64> numMessagesIn { 0 }, numMessagesOut { 0 };
+
     class CallbackHandler;
     std::unique_ptr<CallbackHandler> callbackHandler;
+    class OutputThread;
+    std::unique_ptr<OutputThread> outputThread;
 
     MidiInputHolder* getMidiInput (const String& identifier, bool openIfNotAlready);
     void handleIncomingMidiMessageInt (juce::MidiInput*, const juce::MidiMessage&);
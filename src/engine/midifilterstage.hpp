@@ -0,0 +1,188 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce.hpp>
+
+#include "engine/fixedmidi.hpp"
+#include "engine/midichannelmap.hpp"
+#include "engine/velocitycurve.hpp"
+
+namespace element {
+
+/** Filters and rewrites a block of MIDI in place, on the raw bytes.
+
+    Configure it when settings change, then call process() once per block.
+    It can drop messages on channels that are off and notes outside a key
+    range, pull out program changes, map channels, transpose notes and put
+    note on velocities through a curve. Everything is looked up from tables
+    built by the setters, no MidiMessage is created. Sysex and other long
+    messages pass through untouched.
+
+    Events are edited where they are. Only when something is dropped is the
+    rest of the block copied to a reserved scratch buffer, which is swapped
+    in at the end.
+ */
+class MidiFilterStage final
+{
+public:
+    MidiFilterStage()
+    {
+        FixedMidi::reserve (scratch);
+        reset();
+    }
+
+    /** Pass everything through unchanged. */
+    void reset() noexcept
+    {
+        setChannels (1u);
+        setKeyRange (0, 127);
+        setTranspose (0);
+        setConsumePrograms (false);
+        for (int ch = 0; ch <= 16; ++ch)
+            channelMap[ch] = (uint8) ch;
+        mapsChannels = false;
+        for (int v = 0; v < 128; ++v)
+            velocityMap[v] = (uint8) v;
+        curvesVelocity = false;
+    }
+
+    /** Set the channels let through. Bit 0 is omni and bits 1-16 are
+        channels, the same as Processor::MidiFilter.
+     */
+    void setChannels (uint32 mask) noexcept
+    {
+        channels = mask;
+        filtersChannels = (mask & 1u) == 0;
+    }
+
+    /** Set the lowest and highest notes let through, inclusive. */
+    void setKeyRange (int lowest, int highest) noexcept
+    {
+        keyLow = jlimit (0, 127, lowest);
+        keyHigh = jlimit (0, 127, highest);
+        filtersKeys = keyLow > 0 || keyHigh < 127;
+    }
+
+    /** Set the number of semitones notes are moved by. */
+    void setTranspose (int semitones) noexcept { transpose = semitones; }
+
+    /** If true, program changes are removed and returned by process(). */
+    void setConsumePrograms (bool consume) noexcept { consumePrograms = consume; }
+
+    /** Map channels the way a MidiChannelMap does. */
+    void setChannelMap (const MidiChannelMap& map) noexcept
+    {
+        mapsChannels = false;
+        for (int ch = 1; ch <= 16; ++ch)
+        {
+            channelMap[ch] = (uint8) jlimit (1, 16, map.get (ch));
+            mapsChannels |= channelMap[ch] != ch;
+        }
+    }
+
+    /** Build the velocity table from a curve. */
+    void setVelocityCurve (VelocityCurve& curve)
+    {
+        curvesVelocity = curve.getMode() != VelocityCurve::Linear;
+        velocityMap[0] = 0;
+        for (int v = 1; v < 128; ++v)
+            velocityMap[v] = curvesVelocity ? MidiMessage::floatValueToMidiByte (curve.process ((float) v / 127.f))
+                                            : (uint8) v;
+    }
+
+    /** Returns true if process() would leave every block as it is. */
+    bool isPassthrough() const noexcept
+    {
+        return ! filtersChannels && ! filtersKeys && ! consumePrograms && ! mapsChannels
+               && ! curvesVelocity && transpose == 0;
+    }
+
+    /** Filter a block. Realtime safe.
+        Returns the last program change consumed, or -1 if there wasn't one.
+     */
+    int process (MidiBuffer& midi) noexcept
+    {
+        if (isPassthrough() || midi.isEmpty())
+            return -1;
+
+        int program = -1;
+        bool copying = false;
+
+        for (const auto m : midi)
+        {
+            // the buffer is ours to change, the iterator only hands out const.
+            auto* data = const_cast<uint8*> (m.data);
+            bool keep = true;
+
+            if (m.numBytes <= 3 && m.numBytes > 0 && data[0] >= 0x80 && data[0] < 0xf0)
+            {
+                const int status = data[0] & 0xf0;
+                const int channel = (data[0] & 0x0f) + 1;
+                const bool isNote = status == 0x90 || status == 0x80;
+
+                if (filtersChannels && (channels & (1u << channel)) == 0)
+                    keep = false;
+                else if (isNote && filtersKeys && m.numBytes >= 2 && (data[1] < keyLow || data[1] > keyHigh))
+                    keep = false;
+                else if (consumePrograms && status == 0xc0 && m.numBytes >= 2)
+                {
+                    program = data[1];
+                    keep = false;
+                }
+
+                if (keep)
+                {
+                    if (mapsChannels)
+                        data[0] = (uint8) (status | (channelMap[channel] - 1));
+                    if (isNote && m.numBytes >= 3)
+                    {
+                        if (transpose != 0)
+                            data[1] = (uint8) ((data[1] + transpose) & 127);
+                        if (curvesVelocity && status == 0x90)
+                            data[2] = velocityMap[data[2] & 127];
+                    }
+                }
+            }
+
+            if (! keep && ! copying)
+            {
+                // first drop, bring over what was kept so far.
+                copying = true;
+                scratch.clear();
+                for (const auto prev : midi)
+                {
+                    if (prev.data == m.data)
+                        break;
+                    FixedMidi::add (scratch, prev.data, prev.numBytes, prev.samplePosition);
+                }
+            }
+            else if (keep && copying)
+            {
+                FixedMidi::add (scratch, data, m.numBytes, m.samplePosition);
+            }
+        }
+
+        if (copying)
+        {
+            midi.swapWith (scratch);
+            scratch.clear();
+        }
+
+        return program;
+    }
+
+private:
+    uint32 channels = 1u;
+    int keyLow = 0, keyHigh = 127;
+    int transpose = 0;
+    bool consumePrograms = false;
+    bool filtersChannels = false, filtersKeys = false;
+    bool mapsChannels = false, curvesVelocity = false;
+    uint8 channelMap[17];
+    uint8 velocityMap[128];
+    MidiBuffer scratch;
+};
+
+} // namespace element
@@ -0,0 +1,198 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+
+#include <element/juce/audio_basics.hpp>
+
+#include "delaylockedloop.hpp"
+
+namespace element {
+
+/** Timestamped MIDI input for the audio thread.
+
+    Inputs push messages from their own threads with the time they arrived.
+    The audio thread pulls a block at a time and places each message at the
+    sample it arrived at, measured against a delay locked loop that filters
+    the callback times. Messages are rendered a block after they arrive so
+    their spacing is kept exactly instead of bunching at block boundaries.
+
+    Only short messages are queued unless room for SysEx is made with
+    setSysexCapacity(). SysEx bytes then go in a preallocated ring beside
+    the messages, so nothing is allocated on either side.
+ */
+class MidiInputQueue final
+{
+public:
+    static constexpr int capacity = 1024;
+
+    MidiInputQueue() = default;
+
+    /** Returns the time base of the queue in seconds. Matches the timestamps
+        JUCE gives incoming MIDI messages.
+     */
+    static double now() noexcept { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+
+    /** Make room for up to `numBytes` of SysEx waiting at once. Not realtime
+        safe, call before anything is pushed or rendered.
+     */
+    void setSysexCapacity (int numBytes)
+    {
+        numBytes = juce::jmax (0, numBytes);
+        sysexBytes.allocate ((size_t) numBytes + 1, true);
+        sysexScratch.allocate ((size_t) numBytes, true);
+        sysexFifo.setTotalSize (numBytes + 1);
+        sysexFifo.reset();
+    }
+
+    /** Push a message. Any thread. Messages without a timestamp are stamped
+        now. Returns false if the message is too long or the queue is full.
+     */
+    bool push (const juce::MidiMessage& msg) noexcept
+    {
+        const auto size = msg.getRawDataSize();
+        if (size <= 0 || (size > 3 && sysexBytes == nullptr))
+            return false;
+
+        // writers are serialized so the reader never waits.
+        const juce::SpinLock::ScopedLockType sl (writeLock);
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+        if (size1 + size2 < 1)
+            return false;
+
+        auto& ev = events[size1 > 0 ? start1 : start2];
+        if (size > 3)
+        {
+            int bstart1, bsize1, bstart2, bsize2;
+            sysexFifo.prepareToWrite (size, bstart1, bsize1, bstart2, bsize2);
+            if (bsize1 + bsize2 < size)
+                return false;
+            std::memcpy (sysexBytes + bstart1, msg.getRawData(), (size_t) bsize1);
+            if (bsize2 > 0)
+                std::memcpy (sysexBytes + bstart2, msg.getRawData() + bsize1, (size_t) bsize2);
+            sysexFifo.finishedWrite (size);
+        }
+        else
+        {
+            std::memcpy (ev.data, msg.getRawData(), (size_t) size);
+        }
+
+        ev.time = msg.getTimeStamp() > 0.0 ? msg.getTimeStamp() : now();
+        ev.size = size;
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    /** Restart timing at a new sample rate. Takes effect on the next render(). */
+    void reset (double newSampleRate) noexcept
+    {
+        sampleRate.store (newSampleRate, std::memory_order_relaxed);
+        resetPending.store (true, std::memory_order_release);
+    }
+
+    /** Add messages that arrived during the previous block to `out`. Audio
+        thread only.
+
+        @param out         buffer to add to, usually the block's MIDI input
+        @param numSamples  size of the block
+        @param callbackTime when the callback started, see now()
+     */
+    void render (juce::MidiBuffer& out, int numSamples, double callbackTime) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const auto rate = sampleRate.load (std::memory_order_relaxed);
+        const double period = (double) numSamples / rate;
+
+        // restart when asked, when the block size changes and after a
+        // dropout, the loop can't follow any of those.
+        if (resetPending.exchange (false, std::memory_order_acquire) || numSamples != blockSize
+            || std::abs (callbackTime - dll.nextTime()) > period * 4.0)
+        {
+            blockSize = numSamples;
+            dll.reset (callbackTime, (double) numSamples, rate);
+            dll.setParams (1.0, rate / (double) numSamples);
+            lastStart = callbackTime - period;
+        }
+        else
+        {
+            dll.update (callbackTime);
+        }
+
+        const double blockStart = dll.currentTime();
+        const double span = blockStart - lastStart;
+        const double scale = span > 0.0 ? (double) numSamples / span : 0.0;
+        lastStart = blockStart;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        int numRead = 0;
+        for (int i = 0; i < size1 + size2; ++i)
+        {
+            const auto& ev = events[i < size1 ? start1 + i : start2 + (i - size1)];
+            // arrived after this block started, it belongs to the next one.
+            // Stamps further ahead than that are bogus and go in now.
+            if (ev.time >= blockStart && ev.time < blockStart + span * 2.0)
+                break;
+
+            const double position = (ev.time - (blockStart - span)) * scale;
+            const int frame = juce::jlimit (0, numSamples - 1, juce::roundToInt (position));
+            if (ev.size > 3)
+                out.addEvent (readSysex (ev.size), ev.size, frame);
+            else
+                out.addEvent (ev.data, ev.size, frame);
+            ++numRead;
+        }
+
+        fifo.finishedRead (numRead);
+    }
+
+    /** Returns the number of messages waiting. */
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    struct Event
+    {
+        double time = 0.0;
+        int size = 0; ///< over 3 is SysEx, its bytes are next in the ring
+        juce::uint8 data[3] {};
+    };
+
+    Event events[capacity];
+    juce::AbstractFifo fifo { capacity };
+    juce::SpinLock writeLock;
+
+    juce::HeapBlock<juce::uint8> sysexBytes, sysexScratch;
+    juce::AbstractFifo sysexFifo { 1 };
+
+    /** Take the next SysEx from the ring, in one piece. Audio thread only. */
+    const juce::uint8* readSysex (int size) noexcept
+    {
+        int start1, size1, start2, size2;
+        sysexFifo.prepareToRead (size, start1, size1, start2, size2);
+        jassert (size1 + size2 == size);
+        std::memcpy (sysexScratch, sysexBytes + start1, (size_t) size1);
+        if (size2 > 0)
+            std::memcpy (sysexScratch + size1, sysexBytes + start2, (size_t) size2);
+        sysexFifo.finishedRead (size1 + size2);
+        return sysexScratch;
+    }
+
+    std::atomic<double> sampleRate { 44100.0 };
+    std::atomic<bool> resetPending { true };
+
+    // audio thread only
+    DelayLockedLoop dll;
+    int blockSize = 0;
+    double lastStart = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE (MidiInputQueue)
+};
+
+} // namespace element
@@ -74,6 +74,25 @@ public:
         return msgs;
     }
 
+    /** Returns true if the buffer has the given CC on the channel (zero
+        is omni). Doesn't copy anything, cheap enough to call every block.
+     */
+    inline static bool containsCC (const juce::MidiBuffer& buffer, int ccNumber, int channel) noexcept
+    {
+        if (ccNumber < 0 || ccNumber > 127)
+            return false;
+
+        for (const auto r : buffer)
+        {
+            const auto* data = r.data;
+            if (r.numBytes >= 3 && (data[0] & 0xf0) == 0xb0 && data[1] == ccNumber
+                && (channel == 0 || channel == (data[0] & 0x0f) + 1))
+                return true;
+        }
+
+        return false;
+    }
+
     /** Replace the given CC messags with a panic set of messages.
       
         The input buffer is left unmodified. The out buffer will contain
@@ -19,32 +19,37 @@ namespace element {
 MidiPipe::MidiPipe()
 {
     size = 0;
-    memset (referencedBuffers, 0, sizeof (MidiBuffer*) * maxReferencedBuffers);
+    memset (inlineBuffers, 0, sizeof (MidiBuffer*) * inlineCapacity);
 }
 
 MidiPipe::MidiPipe (juce::MidiBuffer& buffer)
 {
-    memset (referencedBuffers, 0, sizeof (MidiBuffer*) * maxReferencedBuffers);
-    referencedBuffers[0] = &buffer;
+    memset (inlineBuffers, 0, sizeof (MidiBuffer*) * inlineCapacity);
+    inlineBuffers[0] = &buffer;
     size = 1;
 }
 
-MidiPipe::MidiPipe (MidiBuffer** buffers, int numBuffers)
+MidiPipe::MidiPipe (MidiBuffer* const* buffers, int numBuffers)
 {
-    jassert (numBuffers < maxReferencedBuffers);
-    memset (referencedBuffers, 0, sizeof (MidiBuffer*) * maxReferencedBuffers);
-    for (int i = 0; i < numBuffers; ++i)
-        referencedBuffers[i] = buffers[i];
     size = numBuffers;
+    if (numBuffers > inlineCapacity)
+    {
+        referencedBuffers = buffers;
+        return;
+    }
+
+    memset (inlineBuffers, 0, sizeof (MidiBuffer*) * inlineCapacity);
+    for (int i = 0; i < numBuffers; ++i)
+        inlineBuffers[i] = buffers[i];
 }
 
 MidiPipe::MidiPipe (const OwnedArray<MidiBuffer>& buffers, const Array<int>& channels)
 {
-    jassert (channels.size() < maxReferencedBuffers);
-    memset (referencedBuffers, 0, sizeof (MidiBuffer*) * maxReferencedBuffers);
-    for (int i = 0; i < channels.size(); ++i)
-        referencedBuffers[i] = buffers.getUnchecked (channels.getUnchecked (i));
-    size = channels.size();
+    jassert (channels.size() <= inlineCapacity);
+    memset (inlineBuffers, 0, sizeof (MidiBuffer*) * inlineCapacity);
+    size = jmin (channels.size(), (int) inlineCapacity);
+    for (int i = 0; i < size; ++i)
+        inlineBuffers[i] = buffers.getUnchecked (channels.getUnchecked (i));
 }
 
 MidiPipe::~MidiPipe() {}
@@ -63,24 +68,14 @@ MidiBuffer* const MidiPipe::getWriteBuffer (const int index) const
 
 void MidiPipe::clear()
 {
-    for (int i = 0; i < maxReferencedBuffers; ++i)
-    {
-        if (auto* rbuffer = referencedBuffers[i])
-            rbuffer->clear();
-        else
-            break;
-    }
+    for (int i = 0; i < size; ++i)
+        referencedBuffers[i]->clear();
 }
 
 void MidiPipe::clear (int startSample, int numSamples)
 {
-    for (int i = 0; i < maxReferencedBuffers; ++i)
-    {
-        if (auto* rbuffer = referencedBuffers[i])
-            rbuffer->clear (startSample, numSamples);
-        else
-            break;
-    }
+    for (int i = 0; i < size; ++i)
+        referencedBuffers[i]->clear (startSample, numSamples);
 }
 
 void MidiPipe::clear (int channel, int startSample, int numSamples)
@@ -0,0 +1,308 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce.hpp>
+
+#include "engine/fixedmidi.hpp"
+
+namespace element {
+
+/** Spreads MPE voices across several instruments.
+
+    Each output is treated as an MPE lower zone: channel 1 is the master
+    channel and 2-16 are member channels. A note is given to the output with
+    the fewest sounding voices and to that output's least recently used free
+    member channel, stealing the oldest voice there if all are taken.
+
+    Pitch bend, channel pressure and controllers on an input member channel
+    follow the notes started on it, and their latest values are sent ahead
+    of each note on so a voice starts with the right expression. Master
+    channel and system messages go to every output. Input that isn't MPE
+    works too, its notes are still spread one per member channel.
+
+    Everything lives in fixed size tables, process() doesn't allocate.
+ */
+class MpeVoiceRouter final
+{
+public:
+    static constexpr int maxOutputs = 8;
+    static constexpr int maxVoices = 64;
+    static constexpr int masterChannel = 1;
+
+    MpeVoiceRouter() { reset(); }
+
+    /** Set how many outputs voices are spread over. Resets the router. */
+    void setNumOutputs (int newNumOutputs) noexcept
+    {
+        numOutputs = jlimit (1, maxOutputs, newNumOutputs);
+        reset();
+    }
+
+    int getNumOutputs() const noexcept { return numOutputs; }
+
+    /** Forget all voices. The next block starts by sending each output an
+        MPE configuration message for a 15 channel lower zone.
+     */
+    void reset() noexcept
+    {
+        for (auto& v : voices)
+            v = {};
+        for (auto& e : expression)
+            e = {};
+        for (auto& out : channels)
+            for (auto& ch : out)
+                ch = {};
+        clock = 0;
+        nextOutput = 0;
+        needsConfiguration = true;
+    }
+
+    /** Returns the number of sounding voices on an output, or on all of
+        them if output is negative.
+     */
+    int getNumActiveVoices (int output = -1) const noexcept
+    {
+        int count = 0;
+        for (const auto& v : voices)
+            if (v.active && (output < 0 || v.output == output))
+                ++count;
+        return count;
+    }
+
+    /** Returns the output and member channel a note was given, or false if
+        it isn't sounding.
+     */
+    bool findVoice (int inChannel, int note, int& output, int& channel) const noexcept
+    {
+        if (const auto* v = find (inChannel, note))
+        {
+            output = v->output;
+            channel = v->outChannel;
+            return true;
+        }
+        return false;
+    }
+
+    /** Route a block. There must be getNumOutputs() output buffers, events
+        are added to what they hold. Realtime safe.
+     */
+    void process (const MidiBuffer& input, MidiBuffer* const* outputs) noexcept
+    {
+        if (needsConfiguration)
+        {
+            needsConfiguration = false;
+            for (int i = 0; i < numOutputs; ++i)
+                sendConfiguration (*outputs[i]);
+        }
+
+        for (const auto m : input)
+        {
+            const auto* data = m.data;
+            const int frame = m.samplePosition;
+            if (m.numBytes <= 0 || m.numBytes > 3 || data[0] < 0x80 || data[0] >= 0xf0)
+            {
+                for (int i = 0; i < numOutputs; ++i)
+                    FixedMidi::add (*outputs[i], data, m.numBytes, frame);
+                continue;
+            }
+
+            const int status = data[0] & 0xf0;
+            const int channel = (data[0] & 0x0f) + 1;
+            const int d1 = m.numBytes > 1 ? data[1] : 0;
+            const int d2 = m.numBytes > 2 ? data[2] : 0;
+
+            if (status == 0x90 && d2 > 0)
+                noteOn (outputs, channel, d1, d2, frame);
+            else if (status == 0x80 || status == 0x90)
+                noteOff (outputs, channel, d1, d2, frame);
+            else if (status == 0xa0)
+            {
+                if (const auto* v = find (channel, d1))
+                    send (*outputs[v->output], 0xa0, v->outChannel, d1, d2, 3, frame);
+            }
+            else if (channel == masterChannel)
+            {
+                for (int i = 0; i < numOutputs; ++i)
+                    FixedMidi::add (*outputs[i], data, m.numBytes, frame);
+            }
+            else
+            {
+                auto& e = expression[channel];
+                if (status == 0xe0)
+                    e.pitchBend = (int16) (d1 | (d2 << 7));
+                else if (status == 0xd0)
+                    e.pressure = (uint8) d1;
+                else if (status == 0xb0 && d1 == timbreController)
+                    e.timbre = (uint8) d2;
+
+                for (const auto& v : voices)
+                    if (v.active && v.inChannel == channel)
+                        send (*outputs[v.output], status, v.outChannel, d1, d2, m.numBytes, frame);
+            }
+        }
+    }
+
+private:
+    static constexpr int timbreController = 74;
+
+    struct Voice
+    {
+        bool active = false;
+        uint8 inChannel = 0;
+        uint8 note = 0;
+        uint8 output = 0;
+        uint8 outChannel = 0;
+        uint32 age = 0;
+    };
+
+    struct Expression
+    {
+        int16 pitchBend = 8192;
+        uint8 pressure = 0;
+        uint8 timbre = 64;
+    };
+
+    struct Channel
+    {
+        uint8 numVoices = 0;
+        uint32 lastUsed = 0;
+    };
+
+    Voice voices[maxVoices];
+    Expression expression[17];
+    Channel channels[maxOutputs][17];
+    int numOutputs = 1;
+    int nextOutput = 0;
+    uint32 clock = 0;
+    bool needsConfiguration = true;
+
+    const Voice* find (int inChannel, int note) const noexcept
+    {
+        for (const auto& v : voices)
+            if (v.active && v.inChannel == inChannel && v.note == note)
+                return &v;
+        return nullptr;
+    }
+
+    static void send (MidiBuffer& out, int status, int channel, int d1, int d2, int numBytes, int frame) noexcept
+    {
+        const uint8 data[3] = { (uint8) (status | (channel - 1)), (uint8) d1, (uint8) d2 };
+        FixedMidi::add (out, data, numBytes, frame);
+    }
+
+    static void sendConfiguration (MidiBuffer& out) noexcept
+    {
+        // RPN 6, MPE configuration: lower zone with 15 member channels.
+        send (out, 0xb0, masterChannel, 101, 0, 3, 0);
+        send (out, 0xb0, masterChannel, 100, 6, 3, 0);
+        send (out, 0xb0, masterChannel, 6, 15, 3, 0);
+        send (out, 0xb0, masterChannel, 101, 127, 3, 0);
+        send (out, 0xb0, masterChannel, 100, 127, 3, 0);
+    }
+
+    void release (MidiBuffer* const* outputs, Voice& v, int velocity, int frame) noexcept
+    {
+        send (*outputs[v.output], 0x80, v.outChannel, v.note, velocity, 3, frame);
+        auto& ch = channels[v.output][v.outChannel];
+        if (ch.numVoices > 0)
+            --ch.numVoices;
+        ch.lastUsed = ++clock;
+        v.active = false;
+    }
+
+    void noteOff (MidiBuffer* const* outputs, int inChannel, int note, int velocity, int frame) noexcept
+    {
+        for (auto& v : voices)
+            if (v.active && v.inChannel == inChannel && v.note == note)
+                release (outputs, v, velocity, frame);
+    }
+
+    Voice* oldest (int output) noexcept
+    {
+        Voice* result = nullptr;
+        for (auto& v : voices)
+            if (v.active && (output < 0 || v.output == output) && (result == nullptr || v.age < result->age))
+                result = &v;
+        return result;
+    }
+
+    int chooseOutput() const noexcept
+    {
+        int counts[maxOutputs] {};
+        for (const auto& v : voices)
+            if (v.active)
+                ++counts[v.output];
+
+        int best = nextOutput;
+        for (int i = 1; i < numOutputs; ++i)
+        {
+            const int candidate = (nextOutput + i) % numOutputs;
+            if (counts[candidate] < counts[best])
+                best = candidate;
+        }
+        return best;
+    }
+
+    void noteOn (MidiBuffer* const* outputs, int inChannel, int note, int velocity, int frame) noexcept
+    {
+        // a retriggered note replaces the one still sounding.
+        noteOff (outputs, inChannel, note, 0, frame);
+
+        const int output = chooseOutput();
+        nextOutput = (output + 1) % numOutputs;
+
+        int outChannel = -1;
+        for (int ch = masterChannel + 1; ch <= 16; ++ch)
+        {
+            const auto& c = channels[output][ch];
+            if (c.numVoices == 0 && (outChannel < 0 || c.lastUsed < channels[output][outChannel].lastUsed))
+                outChannel = ch;
+        }
+
+        if (outChannel < 0)
+        {
+            auto* stolen = oldest (output);
+            jassert (stolen != nullptr);
+            outChannel = stolen->outChannel;
+            release (outputs, *stolen, 0, frame);
+        }
+
+        Voice* voice = nullptr;
+        for (auto& v : voices)
+        {
+            if (! v.active)
+            {
+                voice = &v;
+                break;
+            }
+        }
+
+        if (voice == nullptr)
+        {
+            voice = oldest (-1);
+            release (outputs, *voice, 0, frame);
+        }
+
+        voice->active = true;
+        voice->inChannel = (uint8) inChannel;
+        voice->note = (uint8) note;
+        voice->output = (uint8) output;
+        voice->outChannel = (uint8) outChannel;
+        voice->age = ++clock;
+
+        auto& c = channels[output][outChannel];
+        ++c.numVoices;
+        c.lastUsed = clock;
+
+        auto& out = *outputs[output];
+        const auto& e = expression[inChannel];
+        send (out, 0xe0, outChannel, e.pitchBend & 127, (e.pitchBend >> 7) & 127, 3, frame);
+        send (out, 0xd0, outChannel, e.pressure, 0, 2, frame);
+        send (out, 0xb0, outChannel, timbreController, e.timbre, 3, frame);
+        send (out, 0x90, outChannel, note, velocity, 3, frame);
+    }
+};
+
+} // namespace element
@@ -0,0 +1,461 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "engine/netbridge.hpp"
+#include "engine/threadpolicy.hpp"
+
+namespace element {
+using namespace juce;
+
+namespace {
+
+inline void put16 (uint8* p, uint16 v) noexcept { ByteOrder::littleEndian16BitsToBytes (v, p); }
+inline void put32 (uint8* p, uint32 v) noexcept { ByteOrder::littleEndian32BitsToBytes (v, p); }
+inline uint16 get16 (const uint8* p) noexcept { return ByteOrder::littleEndianShort (p); }
+inline uint32 get32 (const uint8* p) noexcept { return ByteOrder::littleEndianInt (p); }
+
+} // namespace
+
+//==============================================================================
+int NetBridgePacket::write (uint8* dest, const Header& header, const float* const* audio, const uint8* midi) noexcept
+{
+    jassert (header.numChannels > 0 && header.numChannels <= maxChannels);
+    jassert (header.numFrames <= getMaxFrames (header.numChannels, header.compressed));
+    jassert (header.midiBytes <= maxMidiBytes);
+
+    put32 (dest, magic);
+    dest[4] = (uint8) version;
+    dest[5] = header.compressed ? 1 : 0;
+    put16 (dest + 6, (uint16) header.numChannels);
+    put16 (dest + 8, (uint16) header.numFrames);
+    put16 (dest + 10, (uint16) header.midiBytes);
+    put32 (dest + 12, header.sequence);
+    put32 (dest + 16, (uint32) (header.position & 0xffffffff));
+    put32 (dest + 20, (uint32) ((uint64) header.position >> 32));
+    put32 (dest + 24, header.sampleRate);
+
+    auto* p = dest + headerSize;
+    for (int ch = 0; ch < header.numChannels; ++ch)
+    {
+        const auto* src = audio[ch];
+        if (header.compressed)
+        {
+            for (int i = 0; i < header.numFrames; ++i, p += 2)
+                put16 (p, (uint16) (int16) roundToInt (jlimit (-1.f, 1.f, src[i]) * 32767.f));
+        }
+        else
+        {
+            for (int i = 0; i < header.numFrames; ++i, p += 4)
+            {
+                uint32 bits;
+                std::memcpy (&bits, src + i, 4);
+                put32 (p, bits);
+            }
+        }
+    }
+
+    if (header.midiBytes > 0)
+        std::memcpy (p, midi, (size_t) header.midiBytes);
+    return (int) (p - dest) + header.midiBytes;
+}
+
+bool NetBridgePacket::readHeader (const uint8* data, int size, Header& header) noexcept
+{
+    if (size < headerSize || get32 (data) != magic || data[4] != version)
+        return false;
+
+    header.compressed = (data[5] & 1) != 0;
+    header.numChannels = get16 (data + 6);
+    header.numFrames = get16 (data + 8);
+    header.midiBytes = get16 (data + 10);
+    header.sequence = get32 (data + 12);
+    header.position = (int64) ((uint64) get32 (data + 16) | ((uint64) get32 (data + 20) << 32));
+    header.sampleRate = get32 (data + 24);
+
+    const int audioBytes = header.numChannels * header.numFrames * (header.compressed ? 2 : 4);
+    return header.numChannels > 0 && header.numChannels <= maxChannels
+           && header.midiBytes <= maxMidiBytes
+           && header.sampleRate > 0
+           && headerSize + audioBytes + header.midiBytes <= size;
+}
+
+void NetBridgePacket::readAudio (const uint8* data, const Header& header, float* const* dest, int numChannels) noexcept
+{
+    const auto* p = data + headerSize;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* out = dest[ch];
+        if (ch >= header.numChannels)
+        {
+            FloatVectorOperations::clear (out, header.numFrames);
+            continue;
+        }
+
+        const auto* src = p + ch * header.numFrames * (header.compressed ? 2 : 4);
+        if (header.compressed)
+        {
+            for (int i = 0; i < header.numFrames; ++i)
+                out[i] = (float) (int16) get16 (src + i * 2) * (1.f / 32767.f);
+        }
+        else
+        {
+            for (int i = 0; i < header.numFrames; ++i)
+            {
+                const auto bits = get32 (src + i * 4);
+                std::memcpy (out + i, &bits, 4);
+            }
+        }
+    }
+}
+
+//==============================================================================
+NetBridgeSender::NetBridgeSender()
+    : Thread ("net bridge sender"),
+      socket (std::make_unique<DatagramSocket>())
+{
+    slots.allocate ((size_t) (numSlots * NetBridgePacket::maxSize), true);
+    ThreadPolicy::prepareBackground (*this);
+    startThread();
+}
+
+NetBridgeSender::~NetBridgeSender()
+{
+    signalThreadShouldExit();
+    sem.post();
+    stopThread (500);
+}
+
+void NetBridgeSender::setTarget (const String& newHost, int newPort)
+{
+    ScopedLock sl (targetLock);
+    host = newHost;
+    port = newPort;
+}
+
+void NetBridgeSender::prepare (int newNumChannels, double newSampleRate)
+{
+    numChannels = jlimit (1, NetBridgePacket::maxChannels, newNumChannels);
+    sampleRate = (uint32) roundToInt (newSampleRate);
+    maxFrames = NetBridgePacket::getMaxFrames (numChannels, false);
+    frames.setSize (numChannels, maxFrames, false, true, false);
+    numAssembled = midiSize = 0;
+}
+
+void NetBridgeSender::write (const float* const* audio, int numFrames, const MidiBuffer& buffer) noexcept
+{
+    if (maxFrames <= 0)
+        return;
+
+    packing = compressed.load();
+    const int limit = jmin (maxFrames, NetBridgePacket::getMaxFrames (numChannels, packing));
+
+    auto iter = buffer.begin();
+    for (int start = 0; start < numFrames;)
+    {
+        const int n = jmin (numFrames - start, limit - numAssembled);
+        for (int ch = 0; ch < numChannels; ++ch)
+            frames.copyFrom (ch, numAssembled, audio[ch] + start, n);
+
+        for (; iter != buffer.end() && (*iter).samplePosition < start + n; ++iter)
+        {
+            const auto ev = *iter;
+            if (midiSize + 3 + ev.numBytes > NetBridgePacket::maxMidiBytes)
+                continue;
+            put16 (midi + midiSize, (uint16) (numAssembled + jmax (0, ev.samplePosition - start)));
+            midi[midiSize + 2] = (uint8) ev.numBytes;
+            std::memcpy (midi + midiSize + 3, ev.data, (size_t) ev.numBytes);
+            midiSize += 3 + ev.numBytes;
+        }
+
+        numAssembled += n;
+        start += n;
+        if (numAssembled >= limit)
+            flush();
+    }
+
+    // sent every block, so packing never adds latency.
+    flush();
+    sem.post();
+}
+
+void NetBridgeSender::flush() noexcept
+{
+    if (numAssembled <= 0)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (1, start1, size1, start2, size2);
+    if (size1 + size2 > 0)
+    {
+        const int slot = size1 > 0 ? start1 : start2;
+        NetBridgePacket::Header header;
+        header.sequence = sequence;
+        header.position = position;
+        header.numChannels = numChannels;
+        header.numFrames = numAssembled;
+        header.midiBytes = midiSize;
+        header.sampleRate = sampleRate;
+        header.compressed = packing;
+        sizes[slot] = NetBridgePacket::write (slots + slot * NetBridgePacket::maxSize, header, frames.getArrayOfReadPointers(), midi);
+        fifo.finishedWrite (1);
+    }
+    else
+    {
+        dropped.fetch_add (1);
+    }
+
+    ++sequence;
+    position += numAssembled;
+    numAssembled = midiSize = 0;
+}
+
+void NetBridgeSender::run()
+{
+    while (! threadShouldExit())
+    {
+        sem.wait();
+        if (threadShouldExit())
+            break;
+
+        String targetHost;
+        int targetPort;
+        {
+            ScopedLock sl (targetLock);
+            targetHost = host;
+            targetPort = port;
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        auto send = [&] (int start, int count) {
+            for (int i = start; i < start + count; ++i)
+                if (targetHost.isNotEmpty() && targetPort > 0)
+                    socket->write (targetHost, targetPort, slots + i * NetBridgePacket::maxSize, sizes[i]);
+        };
+
+        send (start1, size1);
+        send (start2, size2);
+        fifo.finishedRead (size1 + size2);
+    }
+}
+
+//==============================================================================
+NetBridgeReceiver::NetBridgeReceiver()
+    : Thread ("net bridge receiver")
+{
+    packet.allocate ((size_t) NetBridgePacket::maxSize, true);
+    events.setFilter (MidiCapture::allKinds);
+    ThreadPolicy::prepareBackground (*this);
+}
+
+NetBridgeReceiver::~NetBridgeReceiver()
+{
+    close();
+}
+
+bool NetBridgeReceiver::bind (int port)
+{
+    close();
+    socket = std::make_unique<DatagramSocket>();
+    if (! socket->bindToPort (port))
+    {
+        socket.reset();
+        return false;
+    }
+
+    startThread();
+    return true;
+}
+
+void NetBridgeReceiver::close()
+{
+    signalThreadShouldExit();
+    if (socket != nullptr)
+        socket->shutdown();
+    stopThread (500);
+    socket.reset();
+}
+
+void NetBridgeReceiver::prepare (int newNumChannels, double newSampleRate, int maxBlockSize)
+{
+    numChannels = jlimit (1, NetBridgePacket::maxChannels, newNumChannels);
+    sampleRate = newSampleRate;
+
+    const int maxFrames = NetBridgePacket::getMaxFrames (1, true);
+    ring.setSize (numChannels, capacity, false, true, false);
+    decoded.setSize (numChannels, maxFrames, false, true, false);
+
+    // the fastest drift plus what the interpolator looks ahead.
+    scratch.setSize (numChannels, 2 * jmax (1, maxBlockSize) + 16, false, true, false);
+    scheduled.resize ((size_t) MidiCapture::capacity);
+
+    fifo.reset();
+    events.discard();
+    expected = -1;
+    numWritten = numRead = 0;
+    numScheduled = 0;
+    primed.store (false);
+}
+
+void NetBridgeReceiver::writeSilence (int numFrames) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numFrames, start1, size1, start2, size2);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        ring.clear (ch, start1, size1);
+        ring.clear (ch, start2, size2);
+    }
+    fifo.finishedWrite (size1 + size2);
+    numWritten += size1 + size2;
+}
+
+void NetBridgeReceiver::handlePacket (const void* data, int size) noexcept
+{
+    const auto* bytes = static_cast<const uint8*> (data);
+    NetBridgePacket::Header header;
+    if (numChannels <= 0 || ! NetBridgePacket::readHeader (bytes, size, header)
+        || header.numFrames > decoded.getNumSamples())
+        return;
+
+    remoteRate.store ((double) header.sampleRate);
+
+    if (expected >= 0)
+    {
+        const auto gap = header.position - expected;
+        if (gap < 0 && gap > -(int64) capacity)
+        {
+            // late or duplicated, its frames were already filled in.
+            return;
+        }
+
+        if (gap > 0 && gap < (int64) capacity / 2)
+        {
+            lost.fetch_add (gap);
+            writeSilence ((int) gap);
+        }
+    }
+
+    expected = header.position + header.numFrames;
+    if (fifo.getFreeSpace() < header.numFrames)
+    {
+        lost.fetch_add (header.numFrames);
+        return;
+    }
+
+    NetBridgePacket::readAudio (bytes, header, decoded.getArrayOfWritePointers(), numChannels);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (header.numFrames, start1, size1, start2, size2);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        ring.copyFrom (ch, start1, decoded, ch, 0, size1);
+        ring.copyFrom (ch, start2, decoded, ch, size1, size2);
+    }
+
+    const auto* midi = NetBridgePacket::getMidi (bytes, header);
+    for (int i = 0; i + 3 <= header.midiBytes;)
+    {
+        const int frame = get16 (midi + i);
+        const int len = midi[i + 2];
+        if (i + 3 + len > header.midiBytes)
+            break;
+        events.push (midi + i + 3, len, (double) (numWritten + frame));
+        i += 3 + len;
+    }
+
+    fifo.finishedWrite (size1 + size2);
+    numWritten += size1 + size2;
+}
+
+void NetBridgeReceiver::read (float* const* audio, int numOutputs, int numFrames, MidiBuffer& midi) noexcept
+{
+    for (int ch = 0; ch < numOutputs; ++ch)
+        FloatVectorOperations::clear (audio[ch], numFrames);
+
+    numScheduled += events.pop (scheduled.data() + numScheduled, (int) scheduled.size() - numScheduled);
+
+    const int target = jmax (numFrames, roundToInt (latencyMs.load() * 0.001 * sampleRate));
+    int ready = fifo.getNumReady();
+
+    if (! primed.load())
+    {
+        if (ready < target || numChannels <= 0)
+            return;
+        primed.store (true);
+        fillAverage = ready;
+        for (auto& interpolator : interpolators)
+            interpolator.reset();
+    }
+
+    // after a stall, skip back down to the latency instead of playing late.
+    if (ready > 3 * target + numFrames)
+    {
+        const int skip = ready - target;
+        fifo.finishedRead (skip);
+        numRead += skip;
+        ready -= skip;
+        fillAverage = ready;
+    }
+
+    fillAverage += 0.01 * ((double) ready - fillAverage);
+    const double remote = remoteRate.load();
+    const double base = remote > 0.0 ? remote / sampleRate : 1.0;
+    const double drift = jlimit (-maxDrift, maxDrift, 0.05 * (fillAverage - target) / (double) target);
+    const double ratio = jlimit (0.25, 2.0, base * (1.0 + drift));
+
+    const int needed = (int) std::ceil (numFrames * ratio) + 8;
+    if (ready < needed || needed > scratch.getNumSamples())
+    {
+        primed.store (false);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (needed, start1, size1, start2, size2);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        scratch.copyFrom (ch, 0, ring, ch, start1, size1);
+        scratch.copyFrom (ch, size1, ring, ch, start2, size2);
+    }
+
+    int used = 0;
+    for (int ch = 0; ch < jmin (numChannels, numOutputs); ++ch)
+        used = interpolators[ch].process (ratio, scratch.getReadPointer (ch), audio[ch], numFrames);
+    fifo.finishedRead (used);
+
+    int kept = 0;
+    for (int i = 0; i < numScheduled; ++i)
+    {
+        const auto& ev = scheduled[(size_t) i];
+        if (ev.time >= (double) (numRead + used))
+        {
+            scheduled[(size_t) kept++] = ev;
+            continue;
+        }
+
+        const int frame = jlimit (0, numFrames - 1, (int) ((ev.time - (double) numRead) / ratio));
+        midi.addEvent (ev.data, jmin (ev.size, MidiCapture::maxBytes), frame);
+    }
+
+    numScheduled = kept;
+    numRead += used;
+}
+
+void NetBridgeReceiver::run()
+{
+    while (! threadShouldExit())
+    {
+        if (socket == nullptr || socket->waitUntilReady (true, 100) != 1)
+            continue;
+
+        const int size = socket->read (packet, NetBridgePacket::maxSize, false);
+        if (size < 0)
+            break;
+        if (size > 0)
+            handlePacket (packet, size);
+    }
+}
+
+} // namespace element
@@ -0,0 +1,206 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/core.hpp>
+
+#include "engine/midicapture.hpp"
+#include "semaphore.hpp"
+
+namespace element {
+
+/** Wire format of a network bridge packet.
+
+    A small header followed by planar audio, 32 bit float or 16 bit when
+    compressed, then MIDI as frame, size and bytes for each event. Packets
+    are kept under a typical MTU so they never fragment. Everything is
+    little endian.
+ */
+class NetBridgePacket final
+{
+public:
+    static constexpr juce::uint32 magic = 0x424e4c45; // "ELNB"
+    static constexpr int version = 1;
+    static constexpr int headerSize = 28;
+    static constexpr int maxSize = 1400;
+    static constexpr int maxMidiBytes = 192;
+    static constexpr int maxChannels = 16;
+
+    struct Header
+    {
+        juce::uint32 sequence = 0;
+        juce::int64 position = 0; // of the first frame, in the sender's stream
+        int numChannels = 0;
+        int numFrames = 0;
+        int midiBytes = 0;
+        juce::uint32 sampleRate = 0;
+        bool compressed = false;
+    };
+
+    /** Returns the most frames a packet holds with room for MIDI. */
+    static int getMaxFrames (int numChannels, bool compressed) noexcept
+    {
+        return (maxSize - headerSize - maxMidiBytes) / (juce::jmax (1, numChannels) * (compressed ? 2 : 4));
+    }
+
+    /** Write a packet to dest, which needs maxSize bytes. Returns its size. */
+    static int write (juce::uint8* dest, const Header& header, const float* const* audio, const juce::uint8* midi) noexcept;
+
+    /** Read and check a header. Returns false for anything malformed. */
+    static bool readHeader (const juce::uint8* data, int size, Header& header) noexcept;
+
+    /** Decode the audio of a checked packet. Channels it doesn't have are cleared. */
+    static void readAudio (const juce::uint8* data, const Header& header, float* const* dest, int numChannels) noexcept;
+
+    /** Returns the MIDI of a checked packet, header.midiBytes long. */
+    static const juce::uint8* getMidi (const juce::uint8* data, const Header& header) noexcept
+    {
+        return data + headerSize + header.numChannels * header.numFrames * (header.compressed ? 2 : 4);
+    }
+};
+
+//==============================================================================
+/** Streams audio and MIDI to another Element over UDP.
+
+    The audio thread packs each block into packets and queues them in a
+    fixed ring, a background thread sends them. Nothing on the audio
+    thread blocks or allocates.
+ */
+class NetBridgeSender final : private juce::Thread
+{
+public:
+    NetBridgeSender();
+    ~NetBridgeSender() override;
+
+    /** Where to send. Any thread but the audio thread. */
+    void setTarget (const juce::String& host, int port);
+
+    /** Send 16 bit audio instead of float, half the bandwidth. */
+    void setCompressed (bool shouldCompress) noexcept { compressed.store (shouldCompress); }
+    bool isCompressed() const noexcept { return compressed.load(); }
+
+    /** Allocate for a stream. Not while write() may run. */
+    void prepare (int numChannels, double sampleRate);
+
+    /** Queue a block. Audio thread. */
+    void write (const float* const* audio, int numFrames, const juce::MidiBuffer& midi) noexcept;
+
+    /** Returns the number of packets dropped because the queue was full. */
+    juce::int64 getNumDropped() const noexcept { return dropped.load(); }
+
+private:
+    static constexpr int numSlots = 256;
+
+    juce::CriticalSection targetLock;
+    juce::String host;
+    int port = 0;
+    std::unique_ptr<juce::DatagramSocket> socket;
+    Semaphore sem;
+
+    int numChannels = 0;
+    juce::uint32 sampleRate = 44100;
+    std::atomic<bool> compressed { false };
+    bool packing = false;
+
+    // packet being assembled, audio thread
+    juce::AudioBuffer<float> frames;
+    int maxFrames = 0;
+    int numAssembled = 0;
+    juce::uint8 midi[NetBridgePacket::maxMidiBytes];
+    int midiSize = 0;
+    juce::int64 position = 0;
+    juce::uint32 sequence = 0;
+
+    // finished packets
+    juce::HeapBlock<juce::uint8> slots;
+    int sizes[numSlots] {};
+    juce::AbstractFifo fifo { numSlots };
+    std::atomic<juce::int64> dropped { 0 };
+
+    void flush() noexcept;
+    void run() override;
+
+    JUCE_DECLARE_NON_COPYABLE (NetBridgeSender)
+};
+
+//==============================================================================
+/** Receives a stream from a NetBridgeSender.
+
+    Packets land in a ring that the audio thread reads once it holds the
+    latency asked for. Lost packets become silence so timing holds. The
+    read rate follows how full the ring is, so a sender whose clock runs
+    a little fast or slow doesn't under or overrun, and a different
+    sample rate at the far end is converted.
+ */
+class NetBridgeReceiver final : private juce::Thread
+{
+public:
+    static constexpr int capacity = 1 << 16;
+    static constexpr double maxDrift = 0.005;
+
+    NetBridgeReceiver();
+    ~NetBridgeReceiver() override;
+
+    /** Listen on a port. Returns false if it can't be bound. */
+    bool bind (int port);
+
+    /** Stop listening. */
+    void close();
+
+    /** Allocate for a stream. Not while read() may run. */
+    void prepare (int numChannels, double sampleRate, int maxBlockSize);
+
+    /** Time held in the ring to ride out network jitter. */
+    void setLatencyMilliseconds (double ms) noexcept { latencyMs.store (juce::jmax (1.0, ms)); }
+    double getLatencyMilliseconds() const noexcept { return latencyMs.load(); }
+
+    /** Decode a packet into the ring. Receiving thread, public for testing. */
+    void handlePacket (const void* data, int size) noexcept;
+
+    /** Read a block, silence until the ring holds the latency. Audio thread. */
+    void read (float* const* audio, int numChannels, int numFrames, juce::MidiBuffer& midi) noexcept;
+
+    /** True while the ring is full enough to play. */
+    bool isStreaming() const noexcept { return primed.load(); }
+
+    /** Returns the number of frames lost to missing or late packets. */
+    juce::int64 getNumLost() const noexcept { return lost.load(); }
+
+private:
+    std::unique_ptr<juce::DatagramSocket> socket;
+    juce::HeapBlock<juce::uint8> packet;
+
+    int numChannels = 0;
+    double sampleRate = 44100.0;
+    std::atomic<double> latencyMs { 20.0 };
+    std::atomic<double> remoteRate { 0.0 };
+    std::atomic<bool> primed { false };
+    std::atomic<juce::int64> lost { 0 };
+
+    // ring, written by the receiving thread
+    juce::AudioBuffer<float> ring;
+    juce::AbstractFifo fifo { capacity };
+    juce::AudioBuffer<float> decoded;
+    juce::int64 expected = -1;
+    juce::int64 numWritten = 0;
+    MidiCapture events;
+
+    // audio thread
+    juce::AudioBuffer<float> scratch;
+    juce::LagrangeInterpolator interpolators[NetBridgePacket::maxChannels];
+    std::vector<MidiCapture::Event> scheduled;
+    int numScheduled = 0;
+    double fillAverage = 0.0;
+    juce::int64 numRead = 0;
+
+    void writeSilence (int numFrames) noexcept;
+    void run() override;
+
+    JUCE_DECLARE_NON_COPYABLE (NetBridgeReceiver)
+};
+
+} // namespace element
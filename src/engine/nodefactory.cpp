@@ -11,10 +11,13 @@
 #include "nodes/midimonitor.hpp"
 #include "nodes/midiprogrammap.hpp"
 #include "nodes/midirouter.hpp"
+#include "nodes/mperouter.hpp"
 // #include "nodes/MidiSequencerNode.h"
 #include "nodes/oscreceiver.hpp"
 #include "nodes/oscsender.hpp"
 #include "nodes/scriptnode.hpp"
+#include "nodes/videomonitor.hpp"
+#include "nodes/analyzer.hpp"
 #include "engine/graphnode.hpp"
 
 #include "engine/audioprocessorfactory.hpp"
@@ -99,20 +102,85 @@ private:
     OwnedArray<NodeProvider> providers;
     [[maybe_unused]] NodeFactory& factory;
     StringArray knownIDs;
-    StringArray denyIDs;
+    StringArray visibleIDs;
+    bool visibleChanged = true;
+
+    // lookups by "format:identifier". Descriptions are only cached once a
+    // provider made the node, so misses are retried after add().
+    HashMap<String, NodeProvider*> index;
+    HashMap<String, PluginDescription> descriptions;
+    HashMap<String, bool> hidden;
+
+    static String key (const String& format, const String& identifier)
+    {
+        return format + ":" + identifier;
+    }
+
+    /** Makes a type, asking the provider known to make it before the rest. */
+    Processor* create (const String& format, const String& identifier)
+    {
+        const auto k = key (format, identifier);
+        if (auto* const f = index[k])
+            if (auto* const node = f->create (identifier))
+                return node;
+
+        for (auto* const f : providers)
+        {
+            if (f->format() != format)
+                continue;
+            if (auto* const node = f->create (identifier))
+            {
+                index.set (k, f);
+                return node;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /** Adds the description of a type, making the node once to get it. */
+    void describe (OwnedArray<PluginDescription>& out, const String& format, const String& identifier)
+    {
+        const auto k = key (format, identifier);
+        if (! descriptions.contains (k))
+        {
+            ProcessorPtr ptr = create (format, identifier);
+            if (ptr == nullptr)
+                return;
+            PluginDescription desc;
+            ptr->getPluginDescription (desc);
+            descriptions.set (k, desc);
+        }
+
+        out.add (new PluginDescription (descriptions[k]));
+    }
+
+    void setHidden (const String& tp, bool shouldHide)
+    {
+        if (shouldHide == hidden.contains (tp))
+            return;
+        if (shouldHide)
+            hidden.set (tp, true);
+        else
+            hidden.remove (tp);
+        visibleChanged = true;
+    }
 };
 
 NodeFactory::NodeFactory()
 {
     impl = std::make_unique<Impl> (*this);
+    add (new SingleNodeProvider<AnalyzerNode> (EL_NODE_ID_ANALYZER));
     add (new SingleNodeProvider<AudioRouterNode> (EL_NODE_ID_AUDIO_ROUTER));
     add (new SingleNodeProvider<MidiChannelSplitterNode> (EL_NODE_ID_MIDI_CHANNEL_SPLITTER));
     add (new SingleNodeProvider<MidiMonitorNode> (EL_NODE_ID_MIDI_MONITOR));
     add (new SingleNodeProvider<MidiProgramMapNode> (EL_NODE_ID_MIDI_PROGRAM_MAP));
     add (new SingleNodeProvider<MidiRouterNode> (EL_NODE_ID_MIDI_ROUTER));
+    add (new SingleNodeProvider<MpeRouterNode> (EL_NODE_ID_MPE_ROUTER));
     add (new SingleNodeProvider<OSCSenderNode> (EL_NODE_ID_OSC_SENDER));
     add (new SingleNodeProvider<OSCReceiverNode> (EL_NODE_ID_OSC_RECEIVER));
     add (new SingleNodeProvider<ScriptNode> (EL_NODE_ID_SCRIPT));
+    add (new SingleNodeProvider<VideoMonitorNode> (EL_NODE_ID_VIDEO_MONITOR));
     add (new SingleNodeProvider<MackieControlUniversal> ("el.MCU"));
 #if ! JUCE_DEBUG
     hideType ("el.MCU");
@@ -127,24 +195,12 @@ NodeFactory::~NodeFactory()
 //==============================================================================
 void NodeFactory::getPluginDescriptions (OwnedArray<PluginDescription>& out, const String& ID, bool includeHidden)
 {
-    auto& denyIDs (impl->denyIDs);
-    if (! includeHidden && denyIDs.contains (ID))
+    if (! includeHidden && isTypeHidden (ID))
     {
         return;
     }
 
-    for (auto* f : impl->providers)
-    {
-        if (f->format() != EL_NODE_FORMAT_NAME)
-            continue;
-
-        if (ProcessorPtr ptr = f->create (ID))
-        {
-            auto* desc = out.add (new PluginDescription());
-            ptr->getPluginDescription (*desc);
-            break;
-        }
-    }
+    impl->describe (out, EL_NODE_FORMAT_NAME, ID);
 }
 
 /** Fill a list of plugin descriptions. public */
@@ -159,52 +215,60 @@ void NodeFactory::getPluginDescriptions (OwnedArray<PluginDescription>& out,
         return;
     }
 
-    for (auto* f : impl->providers)
-    {
-        if (f->format() != format)
-            continue;
-
-        if (ProcessorPtr ptr = f->create (identifier))
-        {
-            auto* desc = out.add (new PluginDescription());
-            ptr->getPluginDescription (*desc);
-            break;
-        }
-    }
+    impl->describe (out, format, identifier);
 }
 
 const StringArray& NodeFactory::knownIDs() const noexcept { return impl->knownIDs; }
 
+const StringArray& NodeFactory::visibleIDs() const
+{
+    if (impl->visibleChanged)
+    {
+        impl->visibleIDs.clearQuick();
+        for (const auto& ID : impl->knownIDs)
+            if (! impl->hidden.contains (ID))
+                impl->visibleIDs.add (ID);
+        impl->visibleChanged = false;
+    }
+
+    return impl->visibleIDs;
+}
+
 //==============================================================================
 NodeFactory& NodeFactory::add (NodeProvider* f)
 {
     auto& providers (impl->providers);
     providers.add (f);
 
-    auto& denyIDs (impl->denyIDs);
-    denyIDs.addArray (f->getHiddenTypes());
-    denyIDs.removeDuplicates (true);
-    denyIDs.removeEmptyStrings();
+    for (const auto& tp : f->getHiddenTypes())
+        if (tp.isNotEmpty())
+            impl->setHidden (tp, true);
 
     auto& knownIDs (impl->knownIDs);
-    knownIDs.addArray (f->findTypes());
-    knownIDs.removeDuplicates (true);
-    knownIDs.removeEmptyStrings();
+    for (const auto& tp : f->findTypes())
+    {
+        if (tp.isEmpty())
+            continue;
+        // earlier providers win, like when asking each in turn.
+        const auto k = Impl::key (f->format(), tp);
+        if (! impl->index.contains (k))
+            impl->index.set (k, f);
+        knownIDs.addIfNotAlreadyThere (tp);
+    }
+
+    impl->visibleChanged = true;
     return *this;
 }
 
 //==============================================================================
 void NodeFactory::hideType (const String& tp)
 {
-    auto& denyIDs (impl->denyIDs);
-    denyIDs.addIfNotAlreadyThere (tp);
+    impl->setHidden (tp, true);
 }
 
 void NodeFactory::hideAllTypes()
 {
-    auto& denyIDs (impl->denyIDs);
-    for (const auto& tp : impl->knownIDs)
-        denyIDs.add (tp);
+    StringArray denyIDs (impl->knownIDs);
 
     // TODO: Nodes backed by juce::AudioProcessor
     denyIDs.add (EL_NODE_ID_ALLPASS_FILTER);
@@ -213,6 +277,14 @@ void NodeFactory::hideAllTypes()
     denyIDs.add (EL_NODE_ID_CHANNELIZE);
     denyIDs.add (EL_NODE_ID_COMB_FILTER);
     denyIDs.add (EL_NODE_ID_COMPRESSOR);
+    denyIDs.add (EL_NODE_ID_CONVOLVER);
+    denyIDs.add (EL_NODE_ID_DISK_RECORDER);
+    denyIDs.add (EL_NODE_ID_LIMITER);
+    denyIDs.add (EL_NODE_ID_LOOPER);
+    denyIDs.add (EL_NODE_ID_NET_SEND);
+    denyIDs.add (EL_NODE_ID_NET_RECEIVE);
+    denyIDs.add (EL_NODE_ID_AUX_SEND);
+    denyIDs.add (EL_NODE_ID_AUX_RETURN);
     denyIDs.add (EL_NODE_ID_EQ_FILTER);
     denyIDs.add (EL_NODE_ID_FREQ_SPLITTER);
     denyIDs.add (EL_NODE_ID_MEDIA_PLAYER);
@@ -225,22 +297,18 @@ void NodeFactory::hideAllTypes()
     denyIDs.add (EL_NODE_ID_VOLUME);
     // end audio procesor nodes
 
-    denyIDs.removeDuplicates (false);
-    denyIDs.removeEmptyStrings();
+    for (const auto& tp : denyIDs)
+        impl->setHidden (tp, true);
 }
 
 bool NodeFactory::isTypeHidden (const String& tp) const noexcept
 {
-    auto& denyIDs (impl->denyIDs);
-    return denyIDs.contains (tp);
+    return impl->hidden.contains (tp);
 }
 
 void NodeFactory::removeHiddenType (const String& tp)
 {
-    auto& denyIDs (impl->denyIDs);
-    auto idx = denyIDs.indexOf (tp);
-    if (idx >= 0)
-        denyIDs.remove (idx);
+    impl->setHidden (tp, false);
 }
 
 //==============================================================================
@@ -250,6 +318,10 @@ Processor* NodeFactory::instantiate (const PluginDescription& desc)
     if (desc.pluginFormatName == EL_NODE_FORMAT_NAME)
         return instantiate (ID);
 
+    if (auto* const f = impl->index[Impl::key (desc.pluginFormatName, ID)])
+        if (auto* const node = f->create (ID))
+            return node;
+
     auto& providers (impl->providers);
     Processor* node = nullptr;
     for (const auto& f : providers)
@@ -266,19 +338,7 @@ Processor* NodeFactory::instantiate (const PluginDescription& desc)
 
 Processor* NodeFactory::instantiate (const String& identifier)
 {
-    auto& providers (impl->providers);
-    Processor* node = nullptr;
-    for (const auto& f : providers)
-    {
-        if (f->format() != EL_NODE_FORMAT_NAME)
-            continue;
-
-        if (auto* const n = f->create (identifier))
-        {
-            node = n;
-            break;
-        }
-    }
+    Processor* node = impl->create (EL_NODE_FORMAT_NAME, identifier);
 
     if (node)
     {
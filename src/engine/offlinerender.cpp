@@ -0,0 +1,215 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <element/atombuffer.hpp>
+#include <element/transport.hpp>
+
+#include "engine/graphnode.hpp"
+#include "engine/offlinerender.hpp"
+
+namespace element {
+
+namespace detail {
+static std::unique_ptr<juce::AudioFormatWriter> createWavWriter (const juce::File& file, const OfflineRender::Options& options)
+{
+    if (! file.getParentDirectory().createDirectory())
+        return nullptr;
+    file.deleteFile();
+
+    std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+    if (stream == nullptr)
+        return nullptr;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(),
+                                                                          options.sampleRate,
+                                                                          (unsigned int) options.numChannels,
+                                                                          options.bitsPerSample,
+                                                                          {},
+                                                                          0));
+    if (writer != nullptr)
+        stream.release();
+    return writer;
+}
+
+static void copyBlock (const juce::AudioBuffer<float>& source, juce::int64 position, juce::AudioBuffer<float>& dest, int numSamples)
+{
+    dest.clear (0, numSamples);
+    const auto available = (juce::int64) source.getNumSamples() - position;
+    if (available <= 0)
+        return;
+
+    const int numToCopy = (int) juce::jmin ((juce::int64) numSamples, available);
+    for (int c = juce::jmin (source.getNumChannels(), dest.getNumChannels()); --c >= 0;)
+        dest.copyFrom (c, 0, source, c, (int) position, numToCopy);
+}
+} // namespace detail
+
+OfflineRender::Result OfflineRender::render (const Stem& stem, const Options& options)
+{
+    Result result;
+    auto* const graph = stem.graph;
+    if (graph == nullptr)
+        result.error = "no graph to render";
+    else if (options.sampleRate <= 0.0 || options.blockSize <= 0 || options.numChannels <= 0)
+        result.error = "invalid render options";
+    else if (options.length <= 0)
+        result.error = "nothing to render";
+    if (! result.wasOk())
+        return result;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const auto total = options.length + juce::jmax ((juce::int64) 0, options.tail);
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    if (stem.file != juce::File())
+    {
+        writer = detail::createWavWriter (stem.file, options);
+        if (writer == nullptr)
+        {
+            result.error = "couldn't write " + stem.file.getFullPathName();
+            return result;
+        }
+    }
+
+    if (stem.buffer != nullptr)
+        stem.buffer->setSize (options.numChannels, (int) total, false, true, false);
+
+    Transport transport;
+    transport.setSampleRate (options.sampleRate);
+    transport.requestTempo (options.tempo);
+    transport.requestAudioFrame (0);
+    transport.requestPlayState (true);
+
+    // prepared for other settings it would keep them.
+    if (graph->prepared())
+        graph->releaseResources();
+    graph->setPlayHead (&transport);
+    graph->prepareToRender (options.sampleRate, options.blockSize);
+
+    const int numChannels = juce::jmax (options.numChannels, graph->getNumAudioInputs(), graph->getNumAudioOutputs());
+    juce::AudioBuffer<float> audio (numChannels, options.blockSize), cv;
+    juce::MidiBuffer midi;
+    midi.ensureSize (4096);
+    AtomBuffer atoms;
+
+    for (juce::int64 position = 0; position < total;)
+    {
+        const int numSamples = (int) juce::jmin ((juce::int64) options.blockSize, total - position);
+
+        if (stem.input != nullptr)
+            detail::copyBlock (*stem.input, position, audio, numSamples);
+        else
+            audio.clear (0, numSamples);
+
+        midi.clear();
+        if (stem.midi != nullptr)
+            midi.addEvents (*stem.midi, (int) position, numSamples, -(int) position);
+
+        transport.preProcess (numSamples);
+        {
+            RenderContext rc (audio, cv, midi, atoms, numSamples);
+            const juce::ScopedLock sl (graph->getPropertyLock());
+            graph->render (rc);
+        }
+        transport.postProcess (numSamples);
+
+        for (int c = graph->getNumAudioOutputs(); c < options.numChannels; ++c)
+            audio.clear (c, 0, numSamples);
+
+        if (stem.buffer != nullptr)
+            for (int c = 0; c < options.numChannels; ++c)
+                stem.buffer->copyFrom (c, (int) position, audio, c, 0, numSamples);
+
+        if (writer != nullptr && ! writer->writeFromAudioSampleBuffer (audio, 0, numSamples))
+        {
+            result.error = "couldn't write " + stem.file.getFullPathName();
+            break;
+        }
+
+        position += numSamples;
+        result.numSamples = position;
+    }
+
+    writer.reset();
+    graph->releaseResources();
+    graph->setPlayHead (nullptr);
+
+    result.seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    return result;
+}
+
+juce::Array<OfflineRender::Result> OfflineRender::render (const juce::Array<Stem>& stems, const Options& options)
+{
+    juce::Array<Result> results;
+    results.resize (stems.size());
+
+    const int numThreads = juce::jmin (stems.size(),
+                                       options.numThreads > 0 ? options.numThreads
+                                                              : juce::SystemStats::getNumCpus());
+    std::atomic<int> next { 0 };
+    auto renderNext = [&]() {
+        for (int i = next.fetch_add (1); i < stems.size(); i = next.fetch_add (1))
+            results.getReference (i) = render (stems.getReference (i), options);
+    };
+
+    // the calling thread renders too.
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numThreads; ++i)
+        threads.emplace_back (renderNext);
+    renderNext();
+    for (auto& thread : threads)
+        thread.join();
+
+    return results;
+}
+
+juce::int64 OfflineRender::findFirstDifference (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+{
+    const int numSamples = juce::jmin (a.getNumSamples(), b.getNumSamples());
+    const int numChannels = juce::jmin (a.getNumChannels(), b.getNumChannels());
+
+    juce::int64 first = -1;
+    for (int c = 0; c < numChannels; ++c)
+    {
+        const auto* x = a.getReadPointer (c);
+        const auto* y = b.getReadPointer (c);
+        if (std::memcmp (x, y, sizeof (float) * (size_t) numSamples) == 0)
+            continue;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (std::memcmp (x + i, y + i, sizeof (float)) != 0)
+            {
+                first = first < 0 ? i : juce::jmin (first, (juce::int64) i);
+                break;
+            }
+        }
+    }
+
+    if (first < 0 && (a.getNumSamples() != b.getNumSamples() || a.getNumChannels() != b.getNumChannels()))
+        first = numSamples;
+    return first;
+}
+
+bool OfflineRender::readFile (const juce::File& file, juce::AudioBuffer<float>& buffer, double* sampleRate)
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (file.createInputStream().release(), true));
+    if (reader == nullptr || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return false;
+
+    buffer.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+    if (! reader->read (&buffer, 0, (int) reader->lengthInSamples, 0, true, true))
+        return false;
+    if (sampleRate != nullptr)
+        *sampleRate = reader->sampleRate;
+    return true;
+}
+
+} // namespace element
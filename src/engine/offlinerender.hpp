@@ -0,0 +1,104 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/audio_formats.hpp>
+
+namespace element {
+
+class GraphNode;
+
+/** Renders graphs without an audio device, as fast as the machine allows.
+
+    Each stem is a graph driven block by block from its own playing
+    Transport, starting at zero, with the result written to a WAV file, a
+    buffer or both. Several stems render on separate threads at once.
+    Rendering is deterministic for deterministic graphs, so batch jobs can
+    render a session and compare the output with an earlier run.
+
+    A graph must not be attached to a running AudioEngine while it renders
+    here. It is prepared for the options given, and its play head is
+    replaced, until rendering ends. It is left released.
+ */
+class OfflineRender final
+{
+public:
+    struct Options
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+
+        /** Samples to render, not counting the tail. */
+        juce::int64 length = 0;
+
+        /** Samples rendered past the length, for reverbs and delays. */
+        juce::int64 tail = 0;
+
+        /** Channels written. Graphs with fewer outputs leave the rest silent. */
+        int numChannels = 2;
+
+        double tempo = 120.0;
+
+        /** Bits per sample in written files: 16, 24 or 32 for float. */
+        int bitsPerSample = 24;
+
+        /** Stems rendered at once. Zero for one per CPU. */
+        int numThreads = 0;
+    };
+
+    struct Stem
+    {
+        GraphNode* graph = nullptr;
+
+        /** Written as WAV when not empty, replacing any existing file. */
+        juce::File file;
+
+        /** When set, receives the rendered audio too. */
+        juce::AudioBuffer<float>* buffer = nullptr;
+
+        /** Audio fed to the graph's inputs, silence past its end. Optional. */
+        const juce::AudioBuffer<float>* input = nullptr;
+
+        /** MIDI fed to the graph, at positions from the start. Optional. */
+        const juce::MidiBuffer* midi = nullptr;
+    };
+
+    struct Result
+    {
+        /** Empty unless the stem failed. */
+        juce::String error;
+
+        juce::int64 numSamples = 0;
+
+        /** Wall clock time spent rendering and writing. */
+        double seconds = 0.0;
+
+        bool wasOk() const noexcept { return error.isEmpty(); }
+
+        /** Audio rendered per second taken. Above 1 is faster than real time. */
+        double getSpeed (double sampleRate) const noexcept
+        {
+            return seconds > 0.0 ? numSamples / sampleRate / seconds : 0.0;
+        }
+    };
+
+    /** Renders one stem on the calling thread. */
+    static Result render (const Stem& stem, const Options& options);
+
+    /** Renders stems in parallel, returning when all are done. Results are
+        in the same order as the stems. No two stems may share a graph.
+     */
+    static juce::Array<Result> render (const juce::Array<Stem>& stems, const Options& options);
+
+    /** Returns the first frame where two renders differ by any bit, or -1
+        if they're identical. Different sizes differ at the shorter length.
+     */
+    static juce::int64 findFirstDifference (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b);
+
+    /** Reads a rendered file back, returning false if it can't. */
+    static bool readFile (const juce::File& file, juce::AudioBuffer<float>& buffer, double* sampleRate = nullptr);
+};
+
+} // namespace element
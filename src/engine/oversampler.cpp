@@ -28,30 +28,69 @@ int Oversampler<T>::getFactor (int index) const
     return 1;
 }
 
+template <typename T>
+void Oversampler<T>::setPhase (Phase newPhase)
+{
+    if (phase == newPhase)
+        return;
+    phase = newPhase;
+    processors.clear();
+}
+
 template <typename T>
 void Oversampler<T>::prepare (int numChannels, int blockSize)
+{
+    prepare (numChannels, blockSize, 0);
+}
+
+template <typename T>
+void Oversampler<T>::prepare (int numChannels, int blockSize, int factor)
 {
     numChannels = juce::jmax (1, numChannels);
     const bool procSpecChanged = channels != numChannels || buffer != blockSize;
     channels = numChannels;
     buffer = blockSize;
 
-    if (processors.size() <= 0 || procSpecChanged)
-    {
+    if (procSpecChanged)
         processors.clear();
-        for (int f = 0; f < maxProc; ++f)
-            processors.add (new ProcessorType (channels, f + 1, ProcessorType::FilterType::filterHalfBandPolyphaseIIR));
-    }
+    while (processors.size() < maxProc)
+        processors.add (nullptr);
 
-    for (auto* proc : processors)
-        proc->initProcessing (buffer);
+    const auto filterType = phase == Phase::linear ? ProcessorType::FilterType::filterHalfBandFIREquiripple
+                                                   : ProcessorType::FilterType::filterHalfBandPolyphaseIIR;
+
+    for (int f = 0; f < maxProc; ++f)
+    {
+        if (factor > 0 && factor != (2 << f))
+        {
+            processors.set (f, nullptr, true);
+            continue;
+        }
+
+        if (processors[f] == nullptr)
+            processors.set (f, new ProcessorType ((size_t) channels, (size_t) (f + 1), filterType));
+        processors[f]->initProcessing ((size_t) buffer);
+    }
 }
 
 template <typename T>
 void Oversampler<T>::reset()
 {
     for (auto* const proc : processors)
-        proc->reset();
+        if (proc != nullptr)
+            proc->reset();
+}
+
+template <typename T>
+size_t Oversampler<T>::getNumBytes() const
+{
+    // every stage doubles the rate and buffers its output, so a factor
+    // of F holds 2 + 4 + ... + F = 2F - 2 blocks per channel.
+    size_t total = 0;
+    for (auto* const proc : processors)
+        if (proc != nullptr)
+            total += (size_t) channels * (size_t) buffer * sizeof (T) * (proc->getOversamplingFactor() * 2 - 2);
+    return total;
 }
 
 template class Oversampler<float>;
@@ -1,11 +1,62 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <element/juce/events.hpp>
 #include <element/parameter.hpp>
 
 using namespace juce;
 namespace element {
 
+//==============================================================================
+/** Delivers changes made off the message thread to message thread
+    listeners. Shared by every parameter that has some, it polls their
+    pending flags so changing a parameter only takes two atomic stores.
+ */
+class Parameter::Notifier : private Timer
+{
+public:
+    Notifier() { startTimerHz (30); }
+    ~Notifier() override { stopTimer(); }
+
+    static std::shared_ptr<Notifier> getShared()
+    {
+        static std::weak_ptr<Notifier> shared;
+        auto notifier = shared.lock();
+        if (notifier == nullptr)
+        {
+            notifier = std::make_shared<Notifier>();
+            shared = notifier;
+        }
+        return notifier;
+    }
+
+    void add (Parameter* param)
+    {
+        const ScopedLock sl (lock);
+        params.addIfNotAlreadyThere (param);
+    }
+
+    void remove (Parameter* param)
+    {
+        const ScopedLock sl (lock);
+        params.removeFirstMatchingValue (param);
+    }
+
+private:
+    CriticalSection lock;
+    Array<Parameter*> params;
+
+    void timerCallback() override
+    {
+        const ScopedLock sl (lock);
+        // a listener may remove itself, or its parameter, while being called.
+        const auto toDeliver = params;
+        for (auto* param : toDeliver)
+            if (params.contains (param))
+                param->deliverPending();
+    }
+};
+
 //==============================================================================
 Parameter::Parameter() noexcept {}
 
@@ -16,6 +67,11 @@ Parameter::~Parameter()
     // a corresponding call to endChangeGesture...
     jassert (! isPerformingGesture);
 #endif
+
+    if (notifier != nullptr)
+        notifier->remove (this);
+    jassert (numNotifying.load() == 0);
+    delete realtimeListeners.exchange (nullptr);
 }
 
 void Parameter::setValueNotifyingHost (float newValue)
@@ -58,18 +114,50 @@ void Parameter::endChangeGesture()
 
 void Parameter::sendValueChangedMessageToListeners (float newValue)
 {
-    ScopedLock lock (listenerLock);
-    for (int i = listeners.size(); --i >= 0;)
-        if (auto* l = listeners[i])
-            l->controlValueChanged (getParameterIndex(), newValue);
+    ++numNotifying;
+    if (auto* list = realtimeListeners.load())
+        for (int i = list->size(); --i >= 0;)
+            list->getUnchecked (i)->controlValueChanged (getParameterIndex(), newValue);
+    --numNotifying;
+
+    pendingValue.store (newValue, std::memory_order_relaxed);
+    valuePending.store (true, std::memory_order_release);
+    if (MessageManager::existsAndIsCurrentThread())
+        deliverPending();
 }
 
 void Parameter::sendGestureChangedMessageToListeners (bool touched)
 {
-    ScopedLock lock (listenerLock);
+    ++numNotifying;
+    if (auto* list = realtimeListeners.load())
+        for (int i = list->size(); --i >= 0;)
+            list->getUnchecked (i)->controlTouched (getParameterIndex(), touched);
+    --numNotifying;
+
+    pendingGesture.store (touched ? 1 : 0, std::memory_order_release);
+    if (MessageManager::existsAndIsCurrentThread())
+        deliverPending();
+}
+
+void Parameter::deliverPending()
+{
+    const bool hasValue = valuePending.exchange (false, std::memory_order_acquire);
+    const int gesture = pendingGesture.exchange (-1, std::memory_order_acquire);
+    if (! hasValue && gesture < 0)
+        return;
+
+    const auto value = pendingValue.load (std::memory_order_relaxed);
+    const ScopedLock sl (listenerLock);
     for (int i = listeners.size(); --i >= 0;)
+    {
         if (auto* l = listeners[i])
-            l->controlTouched (getParameterIndex(), touched);
+        {
+            if (gesture >= 0)
+                l->controlTouched (getParameterIndex(), gesture == 1);
+            if (hasValue)
+                l->controlValueChanged (getParameterIndex(), value);
+        }
+    }
 }
 
 bool Parameter::isOrientationInverted() const { return false; }
@@ -105,16 +193,55 @@ StringArray Parameter::getValueStrings() const
 
 void Parameter::addListener (Parameter::Listener* newListener)
 {
-    const ScopedLock sl (listenerLock);
-    listeners.addIfNotAlreadyThere (newListener);
+    {
+        const ScopedLock sl (listenerLock);
+        listeners.addIfNotAlreadyThere (newListener);
+    }
+
+    // outside the listener lock, the notifier takes its own lock first.
+    if (notifier == nullptr)
+    {
+        notifier = Notifier::getShared();
+        notifier->add (this);
+    }
+}
+
+void Parameter::addRealtimeListener (Parameter::Listener* newListener)
+{
+    updateRealtimeListeners (newListener, true);
 }
 
 void Parameter::removeListener (Parameter::Listener* listenerToRemove)
 {
+    updateRealtimeListeners (listenerToRemove, false);
+
     const ScopedLock sl (listenerLock);
     listeners.removeFirstMatchingValue (listenerToRemove);
 }
 
+void Parameter::updateRealtimeListeners (Listener* listener, bool add)
+{
+    const ScopedLock sl (listenerLock);
+    auto* const current = realtimeListeners.load();
+    if (add == (current != nullptr && current->contains (listener)))
+        return;
+
+    auto* const list = current != nullptr ? new ListenerList (*current) : new ListenerList();
+    if (add)
+        list->add (listener);
+    else
+        list->removeFirstMatchingValue (listener);
+
+    realtimeListeners.store (list->isEmpty() ? nullptr : list);
+    if (list->isEmpty())
+        delete list;
+
+    // a reader counted after the swap sees the new list.
+    while (numNotifying.load() > 0)
+        Thread::yield();
+    delete current;
+}
+
 RangedParameter::RangedParameter (const PortDescription& p)
 {
     jassert (p.type == PortType::Control);
@@ -0,0 +1,104 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/core.hpp>
+#include <element/parameterevents.hpp>
+
+namespace element {
+
+/** Timestamped parameter changes for the audio thread.
+
+    Changes are pushed from whatever thread made them with the time they
+    were made. Once a block the audio thread moves them into a node's
+    ParameterEvents, spreading the changes made since the previous block
+    over this one so their spacing is kept. Like MidiInputQueue, that puts
+    them a block late, changes made after the block started land on its
+    last frame.
+ */
+class ParameterQueue final
+{
+public:
+    static constexpr int capacity = 512;
+
+    ParameterQueue() = default;
+
+    /** Returns the time base of the queue in milliseconds. */
+    static double now() noexcept { return juce::Time::getMillisecondCounterHiRes(); }
+
+    /** Push a change. Any thread. Returns false if the queue is full. */
+    bool push (int parameter, float value) noexcept
+    {
+        // writers are serialized so the reader never waits, and stamping
+        // inside the lock keeps the times in order.
+        const juce::SpinLock::ScopedLockType sl (writeLock);
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+        if (size1 + size2 < 1)
+            return false;
+
+        auto& ev = events[size1 > 0 ? start1 : start2];
+        ev.time = now();
+        ev.parameter = parameter;
+        ev.value = value;
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    /** Move waiting changes into `out`. Audio thread only. Changes that
+        don't fit stay queued for the next block.
+
+        @param out        the block's events, usually cleared first
+        @param numSamples size of the block
+        @param blockTime  when the block started, see now()
+     */
+    void render (ParameterEvents& out, int numSamples, double blockTime) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const double span = blockTime - lastTime;
+        // the first block and the one after a stall have nothing to measure
+        // against, so changes go at the start.
+        const bool spread = lastTime > 0.0 && span > 0.0 && span < 1000.0;
+        lastTime = blockTime;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        int numRead = 0;
+        for (int i = 0; i < size1 + size2 && ! out.isFull(); ++i)
+        {
+            const auto& ev = events[i < size1 ? start1 + i : start2 + (i - size1)];
+            const int frame = spread ? juce::jlimit (0, numSamples - 1, juce::roundToInt ((ev.time - (blockTime - span)) / span * numSamples))
+                                     : 0;
+            out.add (frame, ev.parameter, ev.value);
+            ++numRead;
+        }
+
+        fifo.finishedRead (numRead);
+    }
+
+    /** Returns the number of changes waiting. */
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    struct Event
+    {
+        double time = 0.0;
+        int parameter = 0;
+        float value = 0.f;
+    };
+
+    Event events[capacity];
+    juce::AbstractFifo fifo { capacity };
+    juce::SpinLock writeLock;
+
+    // audio thread only
+    double lastTime = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterQueue)
+};
+
+} // namespace element
@@ -0,0 +1,222 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+#include <cstring>
+
+#include "engine/peaklimiter.hpp"
+
+namespace element {
+using namespace juce;
+
+namespace {
+int framesFor (double ms, double sampleRate)
+{
+    return jmax (1, roundToInt (ms * sampleRate / 1000.0));
+}
+} // namespace
+
+void PeakLimiter::prepare (double newSampleRate, int newNumChannels, int newBlockSize)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    numChannels = jmax (1, newNumChannels);
+    blockSize = jmax (1, newBlockSize);
+
+    // the detector stays prepared in sample peak mode too, so switching
+    // modes doesn't allocate.
+    oversampler.setPhase (Oversampler<float>::Phase::linear);
+    oversampler.prepare (numChannels, blockSize, truePeakFactor);
+
+    const int maxWindow = framesFor (maxLookaheadMs, sampleRate);
+    const int maxPeakDelay = (int) std::ceil (oversampler.getLatencySamples (1));
+
+    peaks.assign ((size_t) blockSize, 0.f);
+    samplePeaks.assign ((size_t) blockSize, 0.f);
+    gains.assign ((size_t) blockSize, 1.f);
+    peakHistory.assign ((size_t) (maxPeakDelay + blockSize), 0.f);
+    history.setSize (numChannels, maxWindow - 1 + maxPeakDelay + blockSize, false, true);
+    queue.assign ((size_t) maxWindow + 2, { 0, 1.f });
+    average.assign ((size_t) maxWindow, 1.f);
+
+    setReleaseMs (releaseMs);
+    configure();
+}
+
+void PeakLimiter::configure() noexcept
+{
+    window = jlimit (1, jmax (1, (int) average.size()), framesFor (lookaheadMs, sampleRate));
+    peakDelay = truePeak && blockSize > 0 ? (int) std::ceil (oversampler.getLatencySamples (1)) : 0;
+    delay = window - 1 + peakDelay;
+    reset();
+}
+
+void PeakLimiter::reset() noexcept
+{
+    oversampler.reset();
+    history.clear();
+    std::fill (peakHistory.begin(), peakHistory.end(), 0.f);
+
+    queueHead = queueSize = 0;
+    frame = 0;
+
+    std::fill (average.begin(), average.end(), 1.f);
+    averagePos = 0;
+    averageSum = (double) window;
+    held = lastGain = 1.f;
+}
+
+void PeakLimiter::setCeilingDecibels (float newCeilingDB) noexcept
+{
+    ceiling = Decibels::decibelsToGain (jmin (0.f, newCeilingDB));
+}
+
+void PeakLimiter::setReleaseMs (float newReleaseMs) noexcept
+{
+    releaseMs = jmax (1.f, newReleaseMs);
+    releaseCoeff = 1.f - std::exp (-1.f / ((float) sampleRate * releaseMs / 1000.f));
+}
+
+void PeakLimiter::setLookaheadMs (double newLookaheadMs) noexcept
+{
+    newLookaheadMs = jlimit (0.1, maxLookaheadMs, newLookaheadMs);
+    if (lookaheadMs == newLookaheadMs)
+        return;
+    lookaheadMs = newLookaheadMs;
+    configure();
+}
+
+void PeakLimiter::setTruePeak (bool shouldDetectTruePeaks) noexcept
+{
+    if (truePeak == shouldDetectTruePeaks)
+        return;
+    truePeak = shouldDetectTruePeaks;
+    configure();
+}
+
+size_t PeakLimiter::getNumBytes() const noexcept
+{
+    return oversampler.getNumBytes()
+           + sizeof (float) * (peaks.size() + samplePeaks.size() + gains.size() + peakHistory.size() + average.size())
+           + sizeof (float) * (size_t) (history.getNumChannels() * history.getNumSamples())
+           + sizeof (Entry) * queue.size();
+}
+
+float PeakLimiter::slidingMin (float gain) noexcept
+{
+    // anything at or above the newcomer can never be the minimum again,
+    // so each frame enters and leaves the queue once.
+    const int capacity = (int) queue.size();
+    while (queueSize > 0 && queue[(size_t) ((queueHead + queueSize - 1) % capacity)].gain >= gain)
+        --queueSize;
+    queue[(size_t) ((queueHead + queueSize) % capacity)] = { frame, gain };
+    ++queueSize;
+
+    // one frame more than the window, to cover the detector's fractional
+    // delay.
+    while (queue[(size_t) queueHead].frame <= frame - (window + 1))
+    {
+        queueHead = (queueHead + 1) % capacity;
+        --queueSize;
+    }
+
+    ++frame;
+    return queue[(size_t) queueHead].gain;
+}
+
+void PeakLimiter::detect (const float* const* channels, int numChans, int numSamples) noexcept
+{
+    float* const peak = peaks.data();
+    float* const samplePeak = samplePeaks.data();
+
+    // the loudest channel each frame
+    FloatVectorOperations::abs (samplePeak, channels[0], numSamples);
+    for (int ch = 1; ch < numChans; ++ch)
+    {
+        FloatVectorOperations::abs (peak, channels[ch], numSamples);
+        FloatVectorOperations::max (samplePeak, samplePeak, peak, numSamples);
+    }
+
+    if (peakDelay <= 0)
+    {
+        FloatVectorOperations::copy (peak, samplePeak, numSamples);
+        return;
+    }
+
+    const auto up = oversampler.getProcessor (1)->processSamplesUp (
+        dsp::AudioBlock<const float> (channels, (size_t) numChans, (size_t) numSamples));
+
+    for (int ch = 0; ch < numChans; ++ch)
+    {
+        const float* const x = up.getChannelPointer ((size_t) ch);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float* const f = x + i * truePeakFactor;
+            const float p = jmax (jmax (std::abs (f[0]), std::abs (f[1])),
+                                  jmax (std::abs (f[2]), std::abs (f[3])));
+            peak[i] = ch == 0 ? p : jmax (peak[i], p);
+        }
+    }
+
+    // the upsampled peaks come out late, the sample peaks wait for them.
+    float* const waiting = peakHistory.data();
+    FloatVectorOperations::copy (waiting + peakDelay, samplePeak, numSamples);
+    FloatVectorOperations::max (peak, peak, waiting, numSamples);
+    std::memmove (waiting, waiting + numSamples, (size_t) peakDelay * sizeof (float));
+}
+
+void PeakLimiter::processChunk (float* const* channels, int numChans, int numSamples) noexcept
+{
+    detect (channels, numChans, numSamples);
+
+    // the gain each frame wants, without branches so it vectorizes.
+    float* const gain = gains.data();
+    const float* const peak = peaks.data();
+    const float limit = ceiling;
+    for (int i = 0; i < numSamples; ++i)
+        gain[i] = limit / std::max (peak[i], limit);
+
+    // held at the window's minimum, released, then averaged over the window
+    // so the gain is all the way down by the time the peak comes out.
+    const double scale = 1.0 / (double) window;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float wanted = slidingMin (gain[i]);
+        held = jmin (wanted, held + releaseCoeff * (wanted - held));
+
+        averageSum += (double) (held - average[(size_t) averagePos]);
+        average[(size_t) averagePos] = held;
+        if (++averagePos == window)
+            averagePos = 0;
+        gain[i] = (float) (averageSum * scale);
+    }
+    lastGain = gain[numSamples - 1];
+
+    for (int ch = 0; ch < numChans; ++ch)
+    {
+        float* const line = history.getWritePointer (ch);
+        float* const x = channels[ch];
+        FloatVectorOperations::copy (line + delay, x, numSamples);
+        FloatVectorOperations::multiply (x, line, gain, numSamples);
+        FloatVectorOperations::clip (x, x, -limit, limit, numSamples);
+        std::memmove (line, line + numSamples, (size_t) delay * sizeof (float));
+    }
+}
+
+void PeakLimiter::process (float* const* channels, int numChans, int numSamples) noexcept
+{
+    jassert (numChans <= numChannels);
+    numChans = jmin (numChans, numChannels);
+    if (numChans <= 0 || blockSize <= 0)
+        return;
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        const int count = jmin (blockSize, numSamples - start);
+        float* chunk[32];
+        for (int ch = 0; ch < jmin (numChans, 32); ++ch)
+            chunk[ch] = channels[ch] + start;
+        processChunk (chunk, jmin (numChans, 32), count);
+    }
+}
+
+} // namespace element
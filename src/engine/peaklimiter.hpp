@@ -0,0 +1,114 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <vector>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/oversampler.hpp>
+
+namespace element {
+
+/** A lookahead brickwall limiter.
+
+    Every channel shares one gain. The detector takes the peak of each
+    frame, and in true peak mode also the peaks between samples, found by
+    upsampling four times with linear phase filters. The gain needed to
+    keep each peak under the ceiling is held as the minimum over the
+    lookahead window, released exponentially, then averaged over the
+    window so it ramps down before the peak arrives instead of clipping
+    it. The audio is delayed to line up, by getLatencySamples() frames.
+    A final clip at the ceiling catches rounding.
+ */
+class PeakLimiter final
+{
+public:
+    /** Longest lookahead, sets the size of the delay lines. */
+    static constexpr double maxLookaheadMs = 10.0;
+
+    /** Upsampling factor of the true peak detector. */
+    static constexpr int truePeakFactor = 4;
+
+    PeakLimiter() = default;
+
+    /** Allocate for blocks of up to blockSize frames. Not realtime safe. */
+    void prepare (double sampleRate, int numChannels, int blockSize);
+
+    /** Clear the delay lines and release all gain reduction. */
+    void reset() noexcept;
+
+    /** Set the highest level let out. */
+    void setCeilingDecibels (float newCeilingDB) noexcept;
+
+    /** Set how long the gain takes to come back up. */
+    void setReleaseMs (float newReleaseMs) noexcept;
+
+    /** Set how far ahead peaks are seen, clamped to 0.1 to maxLookaheadMs.
+        Changes the latency and resets the limiter.
+     */
+    void setLookaheadMs (double newLookaheadMs) noexcept;
+
+    /** Detect peaks between samples too. Changes the latency and resets
+        the limiter.
+     */
+    void setTruePeak (bool shouldDetectTruePeaks) noexcept;
+
+    bool isTruePeak() const noexcept { return truePeak; }
+
+    /** Returns the frames the audio is delayed by. */
+    int getLatencySamples() const noexcept { return delay; }
+
+    /** Returns the bytes held by the delay lines, detector and scratch. */
+    size_t getNumBytes() const noexcept;
+
+    /** Returns the gain applied to the last frame processed. */
+    float getGain() const noexcept { return lastGain; }
+
+    /** Limit a block in place. Realtime safe. */
+    void process (float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    double sampleRate = 44100.0;
+    int numChannels = 0, blockSize = 0;
+
+    float ceiling = 1.f;
+    float releaseMs = 100.f, releaseCoeff = 0.f;
+    double lookaheadMs = 2.0;
+    bool truePeak = true;
+
+    int window = 1; // boxcar length, the lookahead in frames
+    int peakDelay = 0; // frames the true peak detector lags the input
+    int delay = 0; // total latency
+
+    Oversampler<float> oversampler;
+    std::vector<float> peaks, samplePeaks, gains;
+    std::vector<float> peakHistory; // sample peaks, delayed to meet the upsampled ones
+    juce::AudioBuffer<float> history; // delayed audio, per channel
+
+    // sliding minimum of the wanted gain over window + 1 frames, a
+    // monotonic queue in a ring.
+    struct Entry
+    {
+        juce::int64 frame;
+        float gain;
+    };
+    std::vector<Entry> queue;
+    int queueHead = 0, queueSize = 0;
+    juce::int64 frame = 0;
+
+    // the held gain after release, and the running average of it
+    std::vector<float> average;
+    int averagePos = 0;
+    double averageSum = 0.0;
+    float held = 1.f, lastGain = 1.f;
+
+    void configure() noexcept;
+    float slidingMin (float gain) noexcept;
+    void detect (const float* const* channels, int numChannels, int numSamples) noexcept;
+    void processChunk (float* const* channels, int numChannels, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PeakLimiter)
+};
+
+} // namespace element
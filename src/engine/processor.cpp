@@ -1,6 +1,7 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <cmath>
 #include <iomanip>
 
 #include <element/audioengine.hpp>
@@ -17,12 +18,35 @@
 
 namespace element {
 
+//==============================================================================
+/** Per block timing written by the render thread. There is only one writer,
+    readers on other threads see each field through its own atomic.
+ */
+struct Processor::Profile
+{
+    // quarter octave bins from one microsecond up to about 65 ms.
+    static constexpr int numBins = 64;
+
+    static int getBin (double micros) noexcept
+    {
+        return micros <= 1.0 ? 0 : jmin (numBins - 1, (int) (4.0 * std::log2 (micros)));
+    }
+
+    static double getBinLimit (int bin) noexcept { return std::exp2 ((bin + 1) / 4.0); }
+
+    std::atomic<bool> resetPending { true };
+    std::atomic<int64> numBlocks { 0 };
+    std::atomic<double> minimum { 0.0 }, maximum { 0.0 }, average { 0.0 }, load { 0.0 };
+    std::atomic<uint32> bins[numBins] {};
+};
+
 Processor::Processor (const PortList& portList)
     : nodeId (0),
       isPrepared (false),
       enablement (*this),
       midiProgramLoader (*this),
-      portResetter (*this)
+      portResetter (*this),
+      faultNotifier (*this)
 {
     parent = nullptr;
     gain.set (1.0f);
@@ -30,6 +54,8 @@ Processor::Processor (const PortList& portList)
     inputGain.set (1.0f);
     lastInputGain.set (1.0f);
     oversampler = std::make_unique<Oversampler<float>>();
+    updateMidiFilter();
+    profile = std::make_unique<Profile>();
     // ports = portList;
     setPorts (portList);
 }
@@ -39,7 +65,8 @@ Processor::Processor (const uint32 nodeId_) noexcept
       isPrepared (false),
       enablement (*this),
       midiProgramLoader (*this),
-      portResetter (*this)
+      portResetter (*this),
+      faultNotifier (*this)
 {
     parent = nullptr;
     gain.set (1.0f);
@@ -47,6 +74,8 @@ Processor::Processor (const uint32 nodeId_) noexcept
     inputGain.set (1.0f);
     lastInputGain.set (1.0f);
     oversampler = std::make_unique<Oversampler<float>>();
+    updateMidiFilter();
+    profile = std::make_unique<Profile>();
 }
 
 Processor::~Processor()
@@ -56,6 +85,41 @@ Processor::~Processor()
     parent = nullptr;
 }
 
+// key range, transpose, program flag and channels packed into one word.
+namespace detail {
+static constexpr int filterHighShift = 7;
+static constexpr int filterTransposeShift = 14;
+static constexpr int filterProgramsShift = 21;
+static constexpr int filterChannelsShift = 22;
+} // namespace detail
+
+void Processor::updateMidiFilter()
+{
+    ScopedLock sl (propertyLock);
+    uint32 channels = 0;
+    for (int ch = 0; ch <= 16; ++ch)
+        if (midiChannels.get()[ch])
+            channels |= (1u << ch);
+
+    const auto packed = (uint64) (keyRangeLow.get() & 0x7f)
+                        | ((uint64) (keyRangeHigh.get() & 0x7f) << detail::filterHighShift)
+                        | ((uint64) ((transposeOffset.get() + 64) & 0x7f) << detail::filterTransposeShift)
+                        | ((uint64) (midiProgramsEnabled.get() == 1 ? 1 : 0) << detail::filterProgramsShift)
+                        | ((uint64) channels << detail::filterChannelsShift);
+    midiFilter.store (packed, std::memory_order_release);
+}
+
+Processor::MidiFilter Processor::getMidiFilter() const noexcept
+{
+    const auto packed = midiFilter.load (std::memory_order_acquire);
+    MidiFilter filter;
+    filter.keyRange = { (int) (packed & 0x7f), (int) ((packed >> detail::filterHighShift) & 0x7f) };
+    filter.transpose = (int) ((packed >> detail::filterTransposeShift) & 0x7f) - 64;
+    filter.programsEnabled = ((packed >> detail::filterProgramsShift) & 1) != 0;
+    filter.channels = (uint32) ((packed >> detail::filterChannelsShift) & 0x1ffff);
+    return filter;
+}
+
 void Processor::setRenderDetails (double newSampleRate, int newBlockSize)
 {
     sampleRate = newSampleRate;
@@ -230,10 +294,22 @@ void Processor::suspendProcessing (const bool shouldBeSuspended)
         bypassed.set (iShouldBeSuspended);
     }
 
+    if (! isSuspended())
+        faultBypassed.store (false, std::memory_order_relaxed);
     if (isSuspended() != wasSuspeneded)
         bypassChanged (this);
 }
 
+void Processor::syncBypassAndMute()
+{
+    if (auto* proc = getAudioProcessor())
+        if (proc->isSuspended() != isSuspended())
+            proc->suspendProcessing (isSuspended());
+
+    bypassChanged (this);
+    muteChanged (this);
+}
+
 bool Processor::isGraph() const noexcept { return isA<GraphNode>(); }
 bool Processor::isRootGraph() const noexcept { return isA<RootGraph>(); }
 bool Processor::isSubGraph() const noexcept { return isGraph() && ! isRootGraph(); }
@@ -278,24 +354,9 @@ int Processor::getChannelPort (const uint32 port) const
 
 int Processor::getNthPort (const PortType type, const int index, bool isInput, bool oneBased) const
 {
-    int count = oneBased ? 0 : -1;
-
-    jassert (getNumPorts() >= 0);
-    uint32 nports = getNumPorts();
-
-    for (uint32 port = 0; port < nports; ++port)
-    {
-        if (type == getPortType (port) && isInput == isPortInput (port))
-        {
-            if (++count == index)
-            {
-                return port;
-            }
-        }
-    }
-
-    jassertfalse;
-    return EL_INVALID_PORT;
+    const int port = ports.getNthPort (type, oneBased ? index - 1 : index, isInput);
+    jassert (port != static_cast<int> (EL_INVALID_PORT));
+    return port;
 }
 
 uint32 Processor::getMidiInputPort() const { return getPortForChannel (PortType::Midi, 0, true); }
@@ -306,9 +367,12 @@ void Processor::prepare (const double newSampleRate,
                          GraphNode* const parentGraph,
                          bool willBeEnabled)
 {
+    // a background prepare may still be running.
+    const ScopedLock sl (prepareLock);
     sampleRate = newSampleRate;
     blockSize = newBlockSize;
     parent = parentGraph;
+    updateTailSamples();
 
     if ((willBeEnabled || enabled.get() == 1) && ! isPrepared)
     {
@@ -317,7 +381,8 @@ void Processor::prepare (const double newSampleRate,
 
         oversampler->prepare (jmax (getNumPorts (PortType::Audio, true),
                                     getNumPorts (PortType::Audio, false)),
-                              blockSize);
+                              blockSize,
+                              getOversamplingFactor());
 
         if (auto* const osProc = getOversamplingProcessor())
             osLatency = osProc->getLatencyInSamples();
@@ -347,6 +412,7 @@ void Processor::prepare (const double newSampleRate,
 
 void Processor::unprepare()
 {
+    const ScopedLock sl (prepareLock);
     if (isPrepared)
     {
         isPrepared = false;
@@ -397,6 +463,97 @@ void Processor::EnablementUpdater::handleAsyncUpdate()
 
 //=============================================================================
 
+/** Decoded global MIDI program states, message thread only. */
+struct Processor::MidiProgramCache final : private Timer
+{
+    explicit MidiProgramCache (Processor& p) : node (p) {}
+    ~MidiProgramCache() override { stopTimer(); }
+
+    /** Queue every program file saved for the node, decoded one per tick. */
+    void prefetch()
+    {
+        PluginDescription desc;
+        node.getPluginDescription (desc);
+        const auto prefix = desc.createIdentifierString() + "_";
+        if (prefix.length() <= 1)
+            return;
+
+        pending.clearQuick();
+        for (const auto& file : DataPath::defaultGlobalMidiProgramsDir().findChildFiles (
+                 File::findFiles, false, "*.eln"))
+        {
+            const auto name = file.getFileNameWithoutExtension();
+            if (name.startsWith (prefix) && name.substring (prefix.length()).containsOnly ("0123456789"))
+                pending.addIfNotAlreadyThere (name.substring (prefix.length()).getIntValue());
+        }
+
+        if (! pending.isEmpty())
+            startTimer (1);
+    }
+
+    /** Returns the saved state of a program, decoding it if it isn't cached
+        or the file changed since. nullptr if there is no state.
+     */
+    const MemoryBlock* get (int program)
+    {
+        if (! isPositiveAndBelow (program, 128))
+            return nullptr;
+
+        auto& entry = entries[program];
+        const auto file = node.getMidiProgramFile (program);
+        if (! file.existsAsFile())
+        {
+            entry = {};
+            return nullptr;
+        }
+
+        const auto modified = file.getLastModificationTime();
+        if (! entry.decoded || entry.modified != modified)
+        {
+            entry.state.reset();
+            const auto data = Node::parse (file).getProperty (tags::state).toString().trim();
+            if (data.isNotEmpty())
+                entry.state.fromBase64Encoding (data);
+            entry.modified = modified;
+            entry.decoded = true;
+        }
+
+        return entry.state.getSize() > 0 ? &entry.state : nullptr;
+    }
+
+private:
+    struct Entry
+    {
+        bool decoded = false;
+        Time modified;
+        MemoryBlock state;
+    };
+
+    Processor& node;
+    Entry entries[128];
+    Array<int> pending;
+
+    void timerCallback() override
+    {
+        if (! pending.isEmpty())
+            get (pending.removeAndReturn (0));
+        if (pending.isEmpty())
+            stopTimer();
+    }
+};
+
+Processor::MidiProgramCache& Processor::getMidiProgramCache()
+{
+    if (programCache == nullptr)
+        programCache = std::make_unique<MidiProgramCache> (*this);
+    return *programCache;
+}
+
+void Processor::prefetchMidiPrograms()
+{
+    getMidiProgramCache().prefetch();
+}
+
 void Processor::reloadMidiProgram()
 {
     midiProgramLoader.triggerAsyncUpdate();
@@ -495,31 +652,23 @@ void Processor::MidiProgramLoader::handleAsyncUpdate()
 
     if (globalPrograms)
     {
-        if (programFile.existsAsFile())
+        // usually prefetched, so this only applies the state.
+        if (const auto* state = node.getMidiProgramCache().get (requestedProgram))
         {
-            const auto programData = Node::parse (programFile);
-            auto data = programData.getProperty (tags::state).toString().trim();
-            if (data.isNotEmpty())
-            {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
-                {
-                    node.lastMidiProgram.set (requestedProgram);
-                    node.setState (state.getData(), (int) state.getSize());
-                    DBG ("[element] loaded program: " << requestedProgram);
-                }
-            }
+            node.lastMidiProgram.set (requestedProgram);
+            node.setState (state->getData(), (int) state->getSize());
+            DBG ("[element] loaded program: " << requestedProgram);
         }
         else
         {
-            DBG ("[element] Program file doesn't exist: " << node.getMidiProgramFile().getFileName());
+            DBG ("[element] Program file doesn't exist: " << programFile.getFileName());
         }
     }
     else
     {
         if (auto* const program = node.getMidiProgram (requestedProgram))
         {
+            node.lastMidiProgram.set (requestedProgram);
             node.setState (program->state.getData(),
                            static_cast<int> (program->state.getSize()));
         }
@@ -717,6 +866,7 @@ dsp::Oversampling<float>* Processor::getOversamplingProcessor()
 
 void Processor::setOversamplingFactor (int osFactor)
 {
+    osFactor = jlimit (1, Oversampler<float>::maxFactor, osFactor);
     const auto newOsPow = (int) log2f ((float) osFactor);
 
     {
@@ -752,13 +902,30 @@ void Processor::setOversamplingFactor (int osFactor)
 
 int Processor::getOversamplingFactor()
 {
-    if (osPow > 0)
-    {
-        if (auto* osProc = getOversamplingProcessor())
-            return static_cast<int> (osProc->getOversamplingFactor());
-    }
+    // processors only exist for the factor in use once prepared.
+    return 1 << osPow;
+}
+
+void Processor::setLinearPhaseOversampling (bool linearPhase)
+{
+    const auto phase = linearPhase ? Oversampler<float>::Phase::linear
+                                   : Oversampler<float>::Phase::minimum;
+    if (phase == oversampler->getPhase())
+        return;
 
-    return 1;
+    const auto wasEnabled = isEnabled();
+    setEnabled (false);
+    oversampler->setPhase (phase);
+    osLatency = 0.0f;
+    setEnabled (wasEnabled);
+
+    if (auto* g = getParentGraph())
+        g->triggerAsyncUpdate();
+}
+
+bool Processor::isLinearPhaseOversampling() const
+{
+    return oversampler->getPhase() == Oversampler<float>::Phase::linear;
 }
 
 //==============================================================================
@@ -774,6 +941,130 @@ void Processor::setDelayCompensation (double delayMs)
 double Processor::getDelayCompensation() const { return delayCompMillis; }
 int Processor::getDelayCompensationSamples() const { return delayCompSamples; }
 
+void Processor::setTailLength (double tailMs)
+{
+    if (tailMillis == tailMs)
+        return;
+    tailMillis = tailMs;
+    updateTailSamples();
+}
+
+double Processor::getTailLength() const { return tailMillis; }
+
+int64 Processor::getMemoryUsage() const
+{
+    return (int64) oversampler->getNumBytes();
+}
+
+void Processor::setProfilingEnabled (bool shouldProfile)
+{
+    if (shouldProfile && ! isProfilingEnabled())
+        resetProcessStats();
+    profiling.store (shouldProfile, std::memory_order_relaxed);
+}
+
+void Processor::resetProcessStats() noexcept
+{
+    profile->resetPending.store (true, std::memory_order_release);
+}
+
+void Processor::recordProcessTime (int64 ticks, int numSamples) noexcept
+{
+    auto& p = *profile;
+    const auto micros = Time::highResolutionTicksToSeconds (ticks) * 1.0e6;
+    const auto budget = sampleRate > 0.0 ? (double) numSamples * 1.0e6 / sampleRate : 0.0;
+    const auto blockLoad = budget > 0.0 ? micros / budget : 0.0;
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    if (p.resetPending.exchange (false, std::memory_order_acq_rel))
+    {
+        for (auto& bin : p.bins)
+            bin.store (0, relaxed);
+        p.numBlocks.store (0, relaxed);
+        p.minimum.store (micros, relaxed);
+        p.maximum.store (micros, relaxed);
+        p.average.store (micros, relaxed);
+        p.load.store (blockLoad, relaxed);
+    }
+
+    const auto count = p.numBlocks.load (relaxed) + 1;
+    // a plain mean to start with, then a moving average over ~100 blocks.
+    const auto weight = jmax (1.0 / (double) count, 0.01);
+
+    p.minimum.store (jmin (p.minimum.load (relaxed), micros), relaxed);
+    p.maximum.store (jmax (p.maximum.load (relaxed), micros), relaxed);
+    p.average.store (p.average.load (relaxed) + (micros - p.average.load (relaxed)) * weight, relaxed);
+    p.load.store (p.load.load (relaxed) + (blockLoad - p.load.load (relaxed)) * weight, relaxed);
+
+    auto& bin = p.bins[Profile::getBin (micros)];
+    bin.store (bin.load (relaxed) + 1, relaxed);
+    p.numBlocks.store (count, std::memory_order_release);
+}
+
+void Processor::recordSignalFault (bool shouldBypass) noexcept
+{
+    signalFaults.fetch_add (1, std::memory_order_relaxed);
+    if (! shouldBypass || isSuspended())
+        return;
+
+    setBypassFlag (true);
+    faultBypassed.store (true, std::memory_order_relaxed);
+    faultNotifier.triggerAsyncUpdate();
+}
+
+void Processor::FaultNotifier::handleAsyncUpdate()
+{
+    Logger::writeToLog ("[element] bypassed " + node.getName() + ", its output had NaN or infinite samples");
+    node.syncBypassAndMute();
+    node.signalFaulted (&node);
+}
+
+Processor::ProcessStats Processor::getProcessStats() const noexcept
+{
+    const auto& p = *profile;
+    constexpr auto relaxed = std::memory_order_relaxed;
+    ProcessStats stats;
+    if (p.resetPending.load (std::memory_order_acquire))
+        return stats;
+
+    stats.numBlocks = p.numBlocks.load (std::memory_order_acquire);
+    stats.minimum = p.minimum.load (relaxed);
+    stats.maximum = p.maximum.load (relaxed);
+    stats.average = p.average.load (relaxed);
+    stats.load = p.load.load (relaxed);
+
+    uint32 bins[Profile::numBins];
+    uint64 total = 0;
+    for (int i = 0; i < Profile::numBins; ++i)
+        total += (bins[i] = p.bins[i].load (relaxed));
+    if (total == 0)
+        return stats;
+
+    uint64 running = 0;
+    for (int i = 0; i < Profile::numBins; ++i)
+    {
+        running += bins[i];
+        const auto limit = jmin (Profile::getBinLimit (i), stats.maximum);
+        if (stats.p50 == 0.0 && running * 100 >= total * 50)
+            stats.p50 = limit;
+        if (stats.p95 == 0.0 && running * 100 >= total * 95)
+            stats.p95 = limit;
+        if (stats.p99 == 0.0 && running * 100 >= total * 99)
+        {
+            stats.p99 = limit;
+            break;
+        }
+    }
+
+    return stats;
+}
+
+void Processor::updateTailSamples()
+{
+    tailSamples.store (tailMillis < 0.0 ? -1 : roundToInt (tailMillis * 0.001 * sampleRate),
+                       std::memory_order_relaxed);
+}
+
 //=========================================================================
 struct ChannelConnectionMap
 {
@@ -0,0 +1,211 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if EL_REALTIME_GUARD && defined(__GLIBC__)
+#include <dlfcn.h>
+#include <pthread.h>
+#endif
+
+#include "engine/realtimeguard.hpp"
+
+namespace element {
+
+#if EL_REALTIME_GUARD
+std::atomic<bool> RealtimeGuard::enabled { true };
+#else
+std::atomic<bool> RealtimeGuard::enabled { false };
+#endif
+
+namespace detail {
+struct GuardThread
+{
+    int depth;
+    int allowDepth;
+    bool reporting;
+};
+
+// plain data in initial-exec TLS, reading it never allocates.
+#if defined(__GNUC__)
+static thread_local GuardThread guardThread __attribute__ ((tls_model ("initial-exec"))) = { 0, 0, false };
+#else
+static thread_local GuardThread guardThread = { 0, 0, false };
+#endif
+
+static std::atomic<juce::int64> numViolations { 0 };
+static std::atomic<int> numReported { 0 };
+static std::atomic<int> maxReports { 20 };
+
+static void reportToStderr (RealtimeGuard::Violation kind, const char* what, const char* stack)
+{
+    std::fprintf (stderr, "[element] realtime violation: %s%s%s\n%s\n",
+                  RealtimeGuard::toString (kind),
+                  what != nullptr ? ": " : "",
+                  what != nullptr ? what : "",
+                  stack);
+}
+
+static std::atomic<RealtimeGuard::Reporter> reporter { &reportToStderr };
+} // namespace detail
+
+RealtimeGuard::Scope::Scope() noexcept { ++detail::guardThread.depth; }
+RealtimeGuard::Scope::~Scope() { --detail::guardThread.depth; }
+
+RealtimeGuard::Allow::Allow() noexcept { ++detail::guardThread.allowDepth; }
+RealtimeGuard::Allow::~Allow() { --detail::guardThread.allowDepth; }
+
+bool RealtimeGuard::isRealtimeThread() noexcept
+{
+    const auto& state = detail::guardThread;
+    return state.depth > 0 && state.allowDepth <= 0;
+}
+
+void RealtimeGuard::check (Violation kind, const char* what) noexcept
+{
+    auto& state = detail::guardThread;
+    if (state.depth <= 0 || state.allowDepth > 0 || state.reporting || ! isEnabled())
+        return;
+
+    // reporting allocates and may lock, none of that counts.
+    state.reporting = true;
+    detail::numViolations.fetch_add (1, std::memory_order_relaxed);
+    if (detail::numReported.fetch_add (1, std::memory_order_relaxed) < detail::maxReports.load (std::memory_order_relaxed))
+    {
+        const auto stack = juce::SystemStats::getStackBacktrace();
+        detail::reporter.load() (kind, what, stack.toRawUTF8());
+    }
+    state.reporting = false;
+}
+
+void RealtimeGuard::setMaxReports (int maxReports) noexcept
+{
+    detail::maxReports.store (juce::jmax (0, maxReports));
+}
+
+void RealtimeGuard::setReporter (Reporter newReporter) noexcept
+{
+    detail::reporter.store (newReporter != nullptr ? newReporter : &detail::reportToStderr);
+}
+
+juce::int64 RealtimeGuard::getNumViolations() noexcept
+{
+    return detail::numViolations.load (std::memory_order_relaxed);
+}
+
+void RealtimeGuard::resetViolations() noexcept
+{
+    detail::numViolations.store (0);
+    detail::numReported.store (0);
+}
+
+const char* RealtimeGuard::toString (Violation kind) noexcept
+{
+    switch (kind)
+    {
+        case allocation:
+            return "allocation";
+        case deallocation:
+            return "deallocation";
+        case lock:
+            return "lock";
+        case other:
+            break;
+    }
+    return "other";
+}
+
+} // namespace element
+
+//==============================================================================
+#if EL_REALTIME_GUARD
+using element::RealtimeGuard;
+
+#if defined(__GLIBC__)
+// glibc lets the program replace these, operator new and delete end up here.
+extern "C" {
+void* __libc_malloc (size_t);
+void* __libc_calloc (size_t, size_t);
+void* __libc_realloc (void*, size_t);
+void __libc_free (void*);
+
+void* malloc (size_t size)
+{
+    RealtimeGuard::check (RealtimeGuard::allocation, "malloc");
+    return __libc_malloc (size);
+}
+
+void* calloc (size_t count, size_t size)
+{
+    RealtimeGuard::check (RealtimeGuard::allocation, "calloc");
+    return __libc_calloc (count, size);
+}
+
+void* realloc (void* ptr, size_t size)
+{
+    RealtimeGuard::check (RealtimeGuard::allocation, "realloc");
+    return __libc_realloc (ptr, size);
+}
+
+void free (void* ptr)
+{
+    if (ptr != nullptr)
+        RealtimeGuard::check (RealtimeGuard::deallocation, "free");
+    __libc_free (ptr);
+}
+
+// CriticalSection and std::mutex lock through here. Try locks are fine.
+// libc's own locks don't, so looking up the real one can't recurse.
+int pthread_mutex_lock (pthread_mutex_t* mutex)
+{
+    using LockFunction = int (*) (pthread_mutex_t*);
+    static std::atomic<LockFunction> next { nullptr };
+    auto lockMutex = next.load (std::memory_order_acquire);
+    if (lockMutex == nullptr)
+    {
+        lockMutex = (LockFunction) dlsym (RTLD_NEXT, "pthread_mutex_lock");
+        next.store (lockMutex, std::memory_order_release);
+    }
+
+    RealtimeGuard::check (RealtimeGuard::lock, "pthread_mutex_lock");
+    return lockMutex (mutex);
+}
+}
+
+#else
+void* operator new (std::size_t size)
+{
+    RealtimeGuard::check (RealtimeGuard::allocation, "operator new");
+    if (auto* ptr = std::malloc (size > 0 ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    RealtimeGuard::check (RealtimeGuard::allocation, "operator new[]");
+    if (auto* ptr = std::malloc (size > 0 ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeGuard::check (RealtimeGuard::deallocation, "operator delete");
+    std::free (ptr);
+}
+
+void operator delete[] (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeGuard::check (RealtimeGuard::deallocation, "operator delete[]");
+    std::free (ptr);
+}
+
+void operator delete (void* ptr, std::size_t) noexcept { operator delete (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { operator delete[] (ptr); }
+#endif
+#endif
@@ -0,0 +1,88 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Reports allocations and locks on threads that render audio.
+
+    The audio callback and render workers run inside a Scope. Built with
+    the realtime-guard option (EL_REALTIME_GUARD), malloc, free and
+    pthread_mutex_lock on Linux, or operator new and delete elsewhere, call
+    check() and every violation inside a Scope is reported with a stack
+    trace. That catches CriticalSection::enter, MidiBuffer growth and
+    plugins doing the same. Reporting allocates and is slow, it is for
+    testing and never for release builds.
+
+    Without the option nothing is intercepted. A Scope costs a thread local
+    increment and only explicit check() calls are counted, and only while
+    enabled.
+ */
+class RealtimeGuard final
+{
+public:
+    enum Violation : uint8
+    {
+        allocation = 0,
+        deallocation,
+        lock,
+        other
+    };
+
+    /** Called on the violating thread with a description and stack trace. */
+    using Reporter = void (*) (Violation kind, const char* what, const char* stack);
+
+    /** Marks the calling thread as rendering audio until destroyed. Nests. */
+    struct Scope
+    {
+        Scope() noexcept;
+        ~Scope();
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+    /** Lets a Scope's thread allocate or lock on purpose until destroyed. */
+    struct Allow
+    {
+        Allow() noexcept;
+        ~Allow();
+        JUCE_DECLARE_NON_COPYABLE (Allow)
+    };
+
+    /** Returns true if the calling thread is in a Scope and not allowed. */
+    static bool isRealtimeThread() noexcept;
+
+    /** Counts a violation if the calling thread is realtime, and reports
+        the first few. Does nothing while disabled.
+     */
+    static void check (Violation kind, const char* what = nullptr) noexcept;
+
+    /** On by default only in builds with EL_REALTIME_GUARD. */
+    static void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+    static bool isEnabled() noexcept { return enabled.load (std::memory_order_relaxed); }
+
+    /** Violations past this many are counted but not reported. */
+    static void setMaxReports (int maxReports) noexcept;
+
+    /** Replace the reporter, which defaults to writing to stderr. Pass
+        nullptr for the default. Set it before rendering starts.
+     */
+    static void setReporter (Reporter reporter) noexcept;
+
+    static juce::int64 getNumViolations() noexcept;
+    static void resetViolations() noexcept;
+
+    /** Returns a name for a kind of violation. */
+    static const char* toString (Violation kind) noexcept;
+
+private:
+    static std::atomic<bool> enabled;
+
+    RealtimeGuard() = delete;
+};
+
+} // namespace element
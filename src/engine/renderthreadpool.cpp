@@ -0,0 +1,187 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <thread>
+
+#include "engine/realtimeguard.hpp"
+#include "engine/renderthreadpool.hpp"
+#include "engine/threadpolicy.hpp"
+
+namespace element {
+
+class RenderThreadPool::Worker : public juce::Thread
+{
+public:
+    Worker (RenderThreadPool& p, int index)
+        : juce::Thread (juce::String ("element: render ") + juce::String (index + 1)),
+          pool (p) {}
+
+    void run() override { pool.runWorker(); }
+
+private:
+    RenderThreadPool& pool;
+};
+
+RenderThreadPool::RenderThreadPool() {}
+
+RenderThreadPool::~RenderThreadPool()
+{
+    stopWorkers();
+}
+
+void RenderThreadPool::setNumWorkers (int newNumWorkers)
+{
+    newNumWorkers = juce::jlimit (0, 64, newNumWorkers);
+    if (newNumWorkers == workers.size())
+        return;
+
+    stopWorkers();
+    for (int i = 0; i < newNumWorkers; ++i)
+    {
+        auto* worker = workers.add (new Worker (*this, i));
+        worker->startThread (juce::Thread::Priority::highest);
+    }
+}
+
+void RenderThreadPool::stopWorkers()
+{
+    jassert (currentJob.load() == nullptr);
+    shouldExit.store (true);
+
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        wakeup.post();
+    }
+
+    for (auto* worker : workers)
+        worker->stopThread (1000);
+
+    workers.clear();
+
+    // drain stale wakeups so new workers start idle.
+    while (wakeup.tryWait())
+        ;
+
+    shouldExit.store (false);
+}
+
+void RenderThreadPool::perform (Job& job) noexcept
+{
+    if (workers.isEmpty())
+    {
+        while (! job.isFinished())
+            job.runNextTask();
+        return;
+    }
+
+    // Nested or overlapping calls, e.g. a plugin in a graph rendered by a
+    // worker, run on the calling thread. One at a time is offered to the
+    // workers too, they take its tasks when theirs run out.
+    if (busy.exchange (true, std::memory_order_acquire))
+    {
+        Job* expected = nullptr;
+        const bool offered = nestedJob.compare_exchange_strong (expected, &job);
+
+        while (! job.isFinished())
+            if (! job.runNextTask())
+                std::this_thread::yield();
+
+        if (offered)
+        {
+            nestedJob.store (nullptr);
+            while (nestedHelpers.load() > 0)
+                std::this_thread::yield();
+        }
+        return;
+    }
+
+    currentJob.store (&job);
+    for (int i = workers.size(); --i >= 0;)
+        wakeup.post();
+
+    while (! job.isFinished())
+        if (! job.runNextTask() && ! runNestedTask())
+            std::this_thread::yield();
+
+    // Workers register as active before loading the job pointer, so once
+    // the count falls to zero nobody can be touching this job anymore.
+    currentJob.store (nullptr);
+    while (activeWorkers.load() > 0)
+        std::this_thread::yield();
+
+    busy.store (false, std::memory_order_release);
+}
+
+void RenderThreadPool::performTasks (int numTasks, void (*task) (void*, uint32_t), void* context) noexcept
+{
+    struct Tasks final : public Job
+    {
+        int total = 0;
+        void (*task) (void*, uint32_t) = nullptr;
+        void* context = nullptr;
+        std::atomic<int> next { 0 }, done { 0 };
+
+        bool runNextTask() noexcept override
+        {
+            const int index = next.fetch_add (1);
+            if (index >= total)
+                return false;
+            task (context, (uint32_t) index);
+            done.fetch_add (1, std::memory_order_release);
+            return true;
+        }
+
+        bool isFinished() const noexcept override { return done.load (std::memory_order_acquire) >= total; }
+    };
+
+    if (numTasks <= 0 || task == nullptr)
+        return;
+
+    Tasks tasks;
+    tasks.total = numTasks;
+    tasks.task = task;
+    tasks.context = context;
+    perform (tasks);
+}
+
+bool RenderThreadPool::runNestedTask() noexcept
+{
+    if (nestedJob.load() == nullptr)
+        return false;
+
+    // same as the workers' count, the owner waits for this to drop.
+    nestedHelpers.fetch_add (1);
+    bool ran = false;
+    if (auto* job = nestedJob.load())
+        ran = job->runNextTask();
+    nestedHelpers.fetch_sub (1);
+    return ran;
+}
+
+void RenderThreadPool::runWorker() noexcept
+{
+    int policy = -1;
+    while (true)
+    {
+        wakeup.wait();
+        if (shouldExit.load())
+            break;
+
+        ThreadPolicy::applyRealtimeIfChanged (policy);
+
+        activeWorkers.fetch_add (1);
+
+        if (auto* job = currentJob.load())
+        {
+            RealtimeGuard::Scope realtime;
+            while (! job->isFinished())
+                if (! job->runNextTask() && ! runNestedTask())
+                    std::this_thread::yield();
+        }
+
+        activeWorkers.fetch_sub (1);
+    }
+}
+
+} // namespace element
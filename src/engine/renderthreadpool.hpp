@@ -0,0 +1,88 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+#include "semaphore.hpp"
+
+namespace element {
+
+/** A pool of realtime worker threads used to render independent parts of
+    a graph concurrently.
+
+    The audio thread hands a Job to perform(). Workers are woken and pull
+    tasks from the job until it reports completion. The calling thread
+    helps with the work too, so a pool with zero workers degrades to plain
+    serial rendering.
+ */
+class RenderThreadPool final
+{
+public:
+    /** A unit of parallel work. Implementations must be safe to call from
+        several threads at once.
+     */
+    class Job
+    {
+    public:
+        virtual ~Job() = default;
+
+        /** Run one pending task if one is ready.
+            Returns true if a task was run.
+         */
+        virtual bool runNextTask() noexcept = 0;
+
+        /** Returns true when every task in the job has finished. */
+        virtual bool isFinished() const noexcept = 0;
+    };
+
+    RenderThreadPool();
+    ~RenderThreadPool();
+
+    /** Change the number of worker threads. Not realtime safe, don't call
+        this while perform() is running on another thread.
+     */
+    void setNumWorkers (int newNumWorkers);
+
+    /** Returns the number of worker threads. */
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    /** Perform a job, returning after every task has completed.
+        Realtime safe: this doesn't allocate or lock. If the pool is already
+        performing a job, e.g. a node rendered by a worker asks for one, the
+        calling thread runs it and workers without a task of their own help.
+     */
+    void perform (Job& job) noexcept;
+
+    /** Calls task (context, index) once for every index below numTasks,
+        spread over the pool, returning when all have run. This serves a
+        hosted plugin's thread pool request (CLAP's request_exec) with the
+        graph's own workers instead of threads the plugin would start.
+        Realtime safe.
+     */
+    void performTasks (int numTasks, void (*task) (void*, uint32_t), void* context) noexcept;
+
+private:
+    class Worker;
+    juce::OwnedArray<Worker> workers;
+    Semaphore wakeup;
+    std::atomic<Job*> currentJob { nullptr };
+    std::atomic<int> activeWorkers { 0 };
+    std::atomic<bool> shouldExit { false };
+    std::atomic<bool> busy { false };
+
+    // a job asked for while busy, which idle workers help with.
+    std::atomic<Job*> nestedJob { nullptr };
+    std::atomic<int> nestedHelpers { 0 };
+
+    void stopWorkers();
+    void runWorker() noexcept;
+    bool runNestedTask() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderThreadPool)
+};
+
+} // namespace element
@@ -0,0 +1,268 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+
+#include "engine/rendertrace.hpp"
+
+namespace element {
+
+std::atomic<bool> RenderTrace::enabled { false };
+
+namespace detail {
+static constexpr uint32 traceRingSize = 4096; // must be a power of two
+static constexpr int maxTraceThreads = 32;
+
+struct TraceRing
+{
+    std::atomic<bool> claimed { false };
+    std::atomic<uint32> readPos { 0 }, writePos { 0 };
+    RenderTrace::Event events[traceRingSize];
+};
+
+struct TraceState
+{
+    class Drainer : public juce::Thread
+    {
+    public:
+        Drainer (TraceState& s) : juce::Thread ("element: trace"), state (s) {}
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                state.drain();
+                wait (10);
+            }
+        }
+
+    private:
+        TraceState& state;
+    };
+
+    TraceRing rings[maxTraceThreads];
+    std::atomic<int64> dropped { 0 };
+
+    juce::CriticalSection lock;
+    std::vector<RenderTrace::Event> captured;
+    size_t maxEvents = 0;
+    std::unique_ptr<Drainer> drainer;
+
+    void drain()
+    {
+        const juce::ScopedLock sl (lock);
+        for (auto& ring : rings)
+        {
+            auto r = ring.readPos.load (std::memory_order_relaxed);
+            const auto w = ring.writePos.load (std::memory_order_acquire);
+            for (; r != w; ++r)
+            {
+                if (captured.size() < maxEvents)
+                    captured.push_back (ring.events[r & (traceRingSize - 1)]);
+                else
+                    dropped.fetch_add (1, std::memory_order_relaxed);
+            }
+            ring.readPos.store (r, std::memory_order_release);
+        }
+    }
+};
+
+static TraceState& traceState()
+{
+    static TraceState state;
+    return state;
+}
+
+/** Gives each recording thread a ring of its own, freed when the thread exits. */
+struct TraceSlot
+{
+    int index = -1;
+
+    ~TraceSlot()
+    {
+        if (index >= 0)
+            traceState().rings[index].claimed.store (false, std::memory_order_release);
+    }
+};
+
+static thread_local TraceSlot traceSlot;
+} // namespace detail
+
+void RenderTrace::push (Kind kind, uint32 id, int32 value) noexcept
+{
+    auto& state = detail::traceState();
+    auto& slot = detail::traceSlot;
+
+    if (slot.index < 0)
+    {
+        for (int i = 0; i < detail::maxTraceThreads && slot.index < 0; ++i)
+        {
+            bool expected = false;
+            if (state.rings[i].claimed.compare_exchange_strong (expected, true, std::memory_order_acq_rel))
+                slot.index = i;
+        }
+
+        if (slot.index < 0)
+        {
+            state.dropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    auto& ring = state.rings[slot.index];
+    const auto w = ring.writePos.load (std::memory_order_relaxed);
+    if (w - ring.readPos.load (std::memory_order_acquire) >= detail::traceRingSize)
+    {
+        state.dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& event = ring.events[w & (detail::traceRingSize - 1)];
+    event.ticks = juce::Time::getHighResolutionTicks();
+    event.id = id;
+    event.value = value;
+    event.kind = kind;
+    event.thread = (uint8) slot.index;
+    ring.writePos.store (w + 1, std::memory_order_release);
+}
+
+void RenderTrace::start (int maxEvents)
+{
+    auto& state = detail::traceState();
+    if (isEnabled())
+        return;
+
+    {
+        const juce::ScopedLock sl (state.lock);
+        state.captured.clear();
+        state.maxEvents = (size_t) juce::jmax (1, maxEvents);
+        state.dropped.store (0);
+
+        // skip whatever was left over from an earlier capture.
+        for (auto& ring : state.rings)
+            ring.readPos.store (ring.writePos.load());
+    }
+
+    enabled.store (true);
+    state.drainer = std::make_unique<detail::TraceState::Drainer> (state);
+    state.drainer->startThread (juce::Thread::Priority::low);
+}
+
+std::vector<RenderTrace::Event> RenderTrace::stop()
+{
+    auto& state = detail::traceState();
+    enabled.store (false);
+
+    if (state.drainer != nullptr)
+    {
+        state.drainer->stopThread (1000);
+        state.drainer.reset();
+    }
+
+    state.drain();
+
+    std::vector<Event> events;
+    {
+        const juce::ScopedLock sl (state.lock);
+        events.swap (state.captured);
+    }
+
+    std::stable_sort (events.begin(), events.end(), [] (const Event& a, const Event& b) {
+        return a.ticks < b.ticks;
+    });
+
+    return events;
+}
+
+int64 RenderTrace::getNumDropped() noexcept
+{
+    return detail::traceState().dropped.load (std::memory_order_relaxed);
+}
+
+void RenderTrace::writeChromeTrace (const std::vector<Event>& events, juce::OutputStream& out)
+{
+    const auto origin = events.empty() ? 0 : events.front().ticks;
+
+    out << "{\"traceEvents\":[";
+    bool first = true;
+
+    for (const auto& ev : events)
+    {
+        juce::String name, phase, scope, args;
+        switch (ev.kind)
+        {
+            case blockBegin:
+                name = "block";
+                phase = "B";
+                args << "\"frames\":" << ev.value;
+                break;
+            case blockEnd:
+                name = "block";
+                phase = "E";
+                break;
+            case opBegin:
+            case opEnd:
+                name << "node " << (int) ev.id;
+                phase = ev.kind == opBegin ? "B" : "E";
+                break;
+            case xrun:
+                name = ev.id == 0 ? "late callback" : "overrun";
+                phase = "i";
+                scope = "g";
+                args << "\"us\":" << ev.value;
+                break;
+            case midiIn:
+            case midiOut:
+                name = ev.kind == midiIn ? "midi in" : "midi out";
+                phase = "i";
+                scope = "t";
+                args << "\"events\":" << ev.value;
+                break;
+            case midiEvent:
+                name = "midi";
+                phase = "i";
+                scope = "t";
+                args << "\"frame\":" << (int) ev.id << ",\"bytes\":\""
+                     << juce::String::toHexString ((int) ev.value) << "\"";
+                break;
+            case graphSwap:
+                name = "graph swap";
+                phase = "i";
+                scope = "p";
+                args << "\"ops\":" << ev.value;
+                break;
+            default:
+                continue;
+        }
+
+        const auto micros = juce::Time::highResolutionTicksToSeconds (ev.ticks - origin) * 1.0e6;
+
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "{\"name\":\"" << name << "\",\"ph\":\"" << phase << "\""
+            << ",\"ts\":" << juce::String (micros, 3)
+            << ",\"pid\":1,\"tid\":" << (int) ev.thread;
+        if (scope.isNotEmpty())
+            out << ",\"s\":\"" << scope << "\"";
+        if (args.isNotEmpty())
+            out << ",\"args\":{" << args << "}";
+        out << "}";
+    }
+
+    out << "\n]}\n";
+}
+
+bool RenderTrace::stopAndSave (const juce::File& file)
+{
+    const auto events = stop();
+    juce::FileOutputStream stream (file);
+    if (stream.failedToOpen())
+        return false;
+
+    stream.setPosition (0);
+    stream.truncate();
+    writeChromeTrace (events, stream);
+    stream.flush();
+    return stream.getStatus().wasOk();
+}
+
+} // namespace element
@@ -0,0 +1,80 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** A binary event trace of the render path.
+
+    Each thread that records gets its own fixed size ring, so recording is
+    a handful of stores with no locks or allocation. A background thread
+    drains the rings while a capture is running. When tracing is off,
+    record() costs one relaxed atomic load.
+
+    Captures can be saved in the Chrome trace event format, which opens in
+    chrome://tracing and Perfetto.
+ */
+class RenderTrace final
+{
+public:
+    enum Kind : uint8
+    {
+        blockBegin = 0, ///< value is the block size
+        blockEnd,
+        opBegin, ///< id is the node ID
+        opEnd, ///< id is the node ID
+        xrun, ///< id is 0 for a late callback, 1 for an overrun. value is microseconds
+        midiIn, ///< value is the number of events
+        midiOut, ///< value is the number of events
+        midiEvent, ///< id is the frame, value the packed message bytes
+        graphSwap ///< value is the number of rendering ops
+    };
+
+    struct Event
+    {
+        int64 ticks;
+        uint32 id;
+        int32 value;
+        uint8 kind;
+        uint8 thread;
+    };
+
+    /** Returns true while a capture is running. */
+    static bool isEnabled() noexcept { return enabled.load (std::memory_order_relaxed); }
+
+    /** Record an event. Realtime safe. */
+    static void record (Kind kind, uint32 id = 0, int32 value = 0) noexcept
+    {
+        if (isEnabled())
+            push (kind, id, value);
+    }
+
+    /** Start a capture, keeping at most maxEvents. Not realtime safe. */
+    static void start (int maxEvents = 1 << 20);
+
+    /** Stop the capture and return everything recorded. Not realtime safe. */
+    static std::vector<Event> stop();
+
+    /** Returns the number of events lost to full rings or the capture limit. */
+    static int64 getNumDropped() noexcept;
+
+    /** Write events in the Chrome trace event (JSON) format. */
+    static void writeChromeTrace (const std::vector<Event>& events, juce::OutputStream& out);
+
+    /** Stop the capture and save it to a file. Returns false if it couldn't be written. */
+    static bool stopAndSave (const juce::File& file);
+
+private:
+    static std::atomic<bool> enabled;
+    static void push (Kind kind, uint32 id, int32 value) noexcept;
+
+    RenderTrace() = delete;
+};
+
+} // namespace element
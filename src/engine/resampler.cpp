@@ -0,0 +1,208 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "engine/resampler.hpp"
+
+namespace element {
+using namespace juce;
+
+namespace {
+constexpr double kaiserBeta = 8.0; // about 80 dB
+constexpr double lowerCutoff = 0.46; // of the lower rate, the middle of the transition
+
+double besselI0 (double x) noexcept
+{
+    double sum = 1.0, term = 1.0;
+    const double q = x * x * 0.25;
+    for (int k = 1; k < 64 && term > sum * 1.0e-12; ++k)
+    {
+        term *= q / ((double) k * (double) k);
+        sum += term;
+    }
+    return sum;
+}
+
+/* eight running sums, one per lane, so the loop vectorizes without
+   reordering any float additions. numTaps is a multiple of eight. */
+inline float dot (const float* h, const float* x, int numTaps) noexcept
+{
+    float acc[8] = {};
+    for (int k = 0; k < numTaps; k += 8)
+        for (int j = 0; j < 8; ++j)
+            acc[j] += h[k + j] * x[k + j];
+    return ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+}
+} // namespace
+
+bool Resampler::prepare (double sourceRate, double targetRate, int newNumChannels, int newMaxInput)
+{
+    const auto source = (int64) std::llround (sourceRate);
+    const auto target = (int64) std::llround (targetRate);
+    if (source <= 0 || target <= 0)
+        return false;
+
+    const auto g = std::gcd (source, target);
+    if (target / g > maxPhases || source / g > maxPhases)
+        return false;
+
+    up = (int) (target / g);
+    down = (int) (source / g);
+    numChannels = jmax (1, newNumChannels);
+    maxInput = jmax (1, newMaxInput);
+
+    // the filter spans the same time at the lower rate whichever way it goes.
+    const int span = (lowerRateTaps * jmax (up, down) + up - 1) / up;
+    numTaps = (span + 7) & ~7;
+
+    const int length = numTaps * up;
+    const double cutoff = lowerCutoff / (double) jmax (up, down); // cycles per upsampled frame
+    const double centre = (length - 1) * 0.5;
+    const double norm = besselI0 (kaiserBeta);
+
+    coefficients.assign ((size_t) length, 0.f);
+    for (int n = 0; n < length; ++n)
+    {
+        const double t = (double) n - centre;
+        const double x = 2.0 * cutoff * t;
+        const double sinc = std::abs (x) < 1.0e-12 ? 1.0 : std::sin (MathConstants<double>::pi * x) / (MathConstants<double>::pi * x);
+        const double r = t / (centre > 0.0 ? centre : 1.0);
+        const double window = besselI0 (kaiserBeta * std::sqrt (jmax (0.0, 1.0 - r * r))) / norm;
+
+        // phase p, tap k is prototype frame p + k * up. Taps are stored
+        // oldest first to line up with the history.
+        const int p = n % up, k = n / up;
+        coefficients[(size_t) (p * numTaps + (numTaps - 1 - k))] = (float) (up * 2.0 * cutoff * sinc * window);
+    }
+
+    history.setSize (numChannels, numTaps - 1 + maxInput, false, true, false);
+    reset();
+    return true;
+}
+
+void Resampler::reset() noexcept
+{
+    history.clear();
+    phase = 0;
+    offset = 0;
+}
+
+int Resampler::process (const float* const* input, int numInput, float* const* output) noexcept
+{
+    numInput = jlimit (0, maxInput, numInput);
+    const int keep = numTaps - 1;
+    int numOutput = 0, nextPhase = phase, nextOffset = offset;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* const x = history.getWritePointer (ch);
+        FloatVectorOperations::copy (x + keep, input[ch], numInput);
+
+        // the newest frame of each window is frame i of this block.
+        int p = phase, i = offset, n = 0;
+        float* const out = output[ch];
+        while (i < numInput)
+        {
+            out[n++] = dot (coefficients.data() + p * numTaps, x + i, numTaps);
+            p += down;
+            i += p / up;
+            p %= up;
+        }
+
+        std::memmove (x, x + numInput, sizeof (float) * (size_t) keep);
+        numOutput = n;
+        nextPhase = p;
+        nextOffset = i - numInput;
+    }
+
+    phase = nextPhase;
+    offset = nextOffset;
+    return numOutput;
+}
+
+//==============================================================================
+bool RateBridge::prepare (double newOuterRate, double newInnerRate, int newNumChannels, int maxBlock)
+{
+    numChannels = jmax (1, newNumChannels);
+    maxBlock = jmax (1, maxBlock);
+    if (! down.prepare (newOuterRate, newInnerRate, numChannels, maxBlock))
+        return false;
+    if (! up.prepare (newInnerRate, newOuterRate, numChannels, down.getMaxOutput()))
+        return false;
+
+    outerRate = newOuterRate;
+    innerRate = newInnerRate;
+    inner.setSize (numChannels, down.getMaxOutput(), false, true, false);
+    inputs.assign ((size_t) numChannels, nullptr);
+    silence.assign ((size_t) maxBlock, 0.f);
+    converted.setSize (numChannels, up.getMaxOutput(), false, true, false);
+
+    // conversions give a frame or two more or less than a block, so the
+    // FIFO starts a little ahead.
+    fifo.setSize (numChannels, preroll + maxBlock + up.getMaxOutput(), false, true, false);
+    latency = roundToInt (down.getDelay() + up.getDelay() * outerRate / innerRate) + preroll;
+    reset();
+    return true;
+}
+
+void RateBridge::reset() noexcept
+{
+    down.reset();
+    up.reset();
+    inner.clear();
+    fifo.clear();
+    fifoSize = preroll;
+    underruns = 0;
+}
+
+size_t RateBridge::getNumBytes() const noexcept
+{
+    auto bytes = [] (const AudioBuffer<float>& b) { return sizeof (float) * (size_t) b.getNumChannels() * (size_t) b.getNumSamples(); };
+    return bytes (inner) + bytes (converted) + bytes (fifo);
+}
+
+int RateBridge::toInner (const AudioBuffer<float>& outer, int numSamples) noexcept
+{
+    numSamples = jmin (numSamples, (int) silence.size());
+    for (int ch = 0; ch < numChannels; ++ch)
+        inputs[(size_t) ch] = ch < outer.getNumChannels() ? outer.getReadPointer (ch) : silence.data();
+    return down.process (inputs.data(), numSamples, inner.getArrayOfWritePointers());
+}
+
+void RateBridge::toOuter (int numInner, AudioBuffer<float>& outer, int numSamples) noexcept
+{
+    const int numConverted = up.process (inner.getArrayOfReadPointers(), numInner, converted.getArrayOfWritePointers());
+    const int numToAdd = jmin (numConverted, fifo.getNumSamples() - fifoSize);
+    for (int ch = 0; ch < numChannels; ++ch)
+        fifo.copyFrom (ch, fifoSize, converted, ch, 0, numToAdd);
+    fifoSize += numToAdd;
+
+    const int numReady = jmin (numSamples, fifoSize);
+    if (numReady < numSamples)
+        ++underruns;
+
+    for (int ch = 0; ch < outer.getNumChannels(); ++ch)
+    {
+        if (ch >= numChannels)
+        {
+            outer.clear (ch, 0, numSamples);
+            continue;
+        }
+
+        outer.copyFrom (ch, 0, fifo, ch, 0, numReady);
+        if (numReady < numSamples)
+            outer.clear (ch, numReady, numSamples - numReady);
+    }
+
+    fifoSize -= numReady;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* const data = fifo.getWritePointer (ch);
+        std::memmove (data, data + numReady, sizeof (float) * (size_t) fifoSize);
+    }
+}
+
+} // namespace element
@@ -0,0 +1,129 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <vector>
+
+#include <element/juce/audio_basics.hpp>
+
+namespace element {
+
+/** Streaming sample rate conversion by a fixed ratio.
+
+    A polyphase FIR, windowed sinc with a Kaiser window, for the exact
+    rational ratio between two whole sample rates, so converting for
+    hours never drifts. The filter spans lowerRateTaps frames of the lower
+    rate and the dot products are laid out to vectorize. It rejects about
+    80 dB from the lower Nyquist up, and is flat to about 84% of it.
+
+    Every block in gives as many frames out as the ratio allows so far,
+    which varies by one from block to block.
+ */
+class Resampler final
+{
+public:
+    static constexpr int lowerRateTaps = 64;
+    static constexpr int maxPhases = 2048;
+
+    Resampler() = default;
+
+    /** Set up a conversion and allocate for blocks of up to maxInput
+        frames. Returns false if the rates have no ratio with at most
+        maxPhases phases.
+     */
+    bool prepare (double sourceRate, double targetRate, int numChannels, int maxInput);
+
+    /** Clear the history, as if nothing was converted yet. */
+    void reset() noexcept;
+
+    /** Returns the most frames one process() can write. */
+    int getMaxOutput() const noexcept { return (int) (((juce::int64) maxInput * up + down - 1) / down) + 1; }
+
+    /** Returns the filter's delay in source frames. */
+    double getDelay() const noexcept { return (double) (numTaps * up - 1) / (2.0 * up); }
+
+    /** Returns the coefficients in each phase. */
+    int getNumTaps() const noexcept { return numTaps; }
+
+    int getNumChannels() const noexcept { return numChannels; }
+
+    /** Convert numInput frames of every channel. Returns the number of
+        frames written to each output channel. Realtime safe.
+     */
+    int process (const float* const* input, int numInput, float* const* output) noexcept;
+
+private:
+    int up = 1, down = 1;
+    int numTaps = 0; // per phase, a multiple of 8
+    int numChannels = 0, maxInput = 0;
+    std::vector<float> coefficients; // phase by phase, reversed
+    juce::AudioBuffer<float> history; // numTaps - 1 frames, then the block
+    int phase = 0, offset = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (Resampler)
+};
+
+//==============================================================================
+/** Runs a graph at its own rate inside a parent at another.
+
+    Each outer block is converted to the inner rate, the graph renders
+    however many frames that came to, and its output is converted back
+    through a short FIFO that always holds enough for the next block.
+    The conversions and the FIFO delay the graph by getLatencySamples().
+ */
+class RateBridge final
+{
+public:
+    RateBridge() = default;
+
+    /** Allocate for the rates and blocks of up to maxBlock outer frames.
+        Returns false if the rates can't be bridged.
+     */
+    bool prepare (double outerRate, double innerRate, int numChannels, int maxBlock);
+
+    /** Clear the converters and refill the FIFO with silence. */
+    void reset() noexcept;
+
+    /** Returns the most frames the graph renders at once. */
+    int getMaxInnerBlock() const noexcept { return down.getMaxOutput(); }
+
+    /** Returns the delay added to the graph, in outer frames. */
+    int getLatencySamples() const noexcept { return latency; }
+
+    double getOuterRate() const noexcept { return outerRate; }
+    double getInnerRate() const noexcept { return innerRate; }
+
+    /** Returns the number of times the FIFO ran short. */
+    int getNumUnderruns() const noexcept { return underruns; }
+
+    /** Returns the buffer the graph renders in. */
+    juce::AudioBuffer<float>& getInnerBuffer() noexcept { return inner; }
+
+    /** Convert a block of input to the inner rate. Returns the frames to
+        render. Realtime safe.
+     */
+    int toInner (const juce::AudioBuffer<float>& outer, int numSamples) noexcept;
+
+    /** Convert rendered frames back and fill a block of output. Realtime safe. */
+    void toOuter (int numInner, juce::AudioBuffer<float>& outer, int numSamples) noexcept;
+
+    /** Returns the bytes held by the buffers and filters. */
+    size_t getNumBytes() const noexcept;
+
+private:
+    static constexpr int preroll = 8;
+    Resampler down, up;
+    juce::AudioBuffer<float> inner, converted, fifo;
+    std::vector<const float*> inputs;
+    std::vector<float> silence; // input for channels the block doesn't have
+    double outerRate = 0.0, innerRate = 0.0;
+    int numChannels = 0;
+    int fifoSize = 0;
+    int latency = 0;
+    int underruns = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (RateBridge)
+};
+
+} // namespace element
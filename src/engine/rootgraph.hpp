@@ -43,6 +43,9 @@ public:
 
     void refreshPorts() override;
 
+    /** The name is used for the graph's own device ports. */
+    using GraphNode::setName;
+
     void setPlayConfigFor (AudioIODevice* device);
     void setPlayConfigFor (const DeviceManager::AudioDeviceSetup& setup);
     void setPlayConfigFor (DeviceManager&);
@@ -73,6 +76,22 @@ public:
      */
     inline constexpr int getEngineIndex() const noexcept { return engineIndex; }
 
+    /** Returns true if the engine released this graph to save resources.
+        Parked graphs are skipped while rendering and prepared again before
+        they can be switched to.
+     */
+    inline bool isParked() const noexcept { return parked.load (std::memory_order_acquire); }
+
+    /** Set whether this graph gets its own device ports, e.g. a group of
+        JACK ports, instead of sharing the main inputs and outputs. Other
+        clients can then patch into it directly. Applied by
+        AudioEngine::updateDevicePorts().
+     */
+    inline void setDevicePortsEnabled (bool enabled) noexcept { devicePortsEnabled = enabled; }
+
+    /** Returns true if this graph asked for its own device ports. */
+    inline bool isDevicePortsEnabled() const noexcept { return devicePortsEnabled; }
+
 private:
     friend class AudioEngine;
     friend struct RootGraphRender;
@@ -82,6 +101,9 @@ private:
     int midiProgram = -1;
     int engineIndex = -1;
     RenderMode renderMode = Parallel;
+    std::atomic<bool> parked { false };
+    bool devicePortsEnabled = false;
+    int devicePortGroup = -1;
 };
 
 } // namespace element
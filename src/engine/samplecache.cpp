@@ -0,0 +1,107 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "engine/samplecache.hpp"
+
+namespace element {
+using namespace juce;
+
+std::shared_ptr<SampleCache> SampleCache::getShared()
+{
+    static auto cache = std::make_shared<SampleCache>();
+    return cache;
+}
+
+String SampleCache::getKey (const File& file)
+{
+    String key (file.getFullPathName());
+    key << "|" << String (file.getLastModificationTime().toMilliseconds());
+    return key;
+}
+
+size_t SampleCache::sizeOf (const Block& block) noexcept
+{
+    return (size_t) block->getNumChannels() * (size_t) block->getNumSamples() * sizeof (float);
+}
+
+void SampleCache::setCapacity (size_t newCapacity)
+{
+    const ScopedLock sl (lock);
+    capacity = newCapacity;
+    trim();
+}
+
+size_t SampleCache::getCapacity() const
+{
+    const ScopedLock sl (lock);
+    return capacity;
+}
+
+size_t SampleCache::getNumBytes() const
+{
+    const ScopedLock sl (lock);
+    return numBytes;
+}
+
+SampleCache::Block SampleCache::findBlock (const String& key, int64 index)
+{
+    const ScopedLock sl (lock);
+    auto iter = lookup.find ({ key, index });
+    if (iter == lookup.end())
+        return nullptr;
+
+    entries.splice (entries.begin(), entries, iter->second);
+    return iter->second->block;
+}
+
+SampleCache::Block SampleCache::getBlock (const String& key, AudioFormatReader& reader, int64 index)
+{
+    const auto start = index * blockSize;
+    if (index < 0 || start >= reader.lengthInSamples)
+        return nullptr;
+
+    if (auto block = findBlock (key, index))
+    {
+        hits.fetch_add (1, std::memory_order_relaxed);
+        return block;
+    }
+
+    misses.fetch_add (1, std::memory_order_relaxed);
+
+    const auto numSamples = (int) jmin ((int64) blockSize, reader.lengthInSamples - start);
+    auto decoded = std::make_shared<AudioBuffer<float>> (2, numSamples);
+    reader.read (decoded.get(), 0, numSamples, start, true, true);
+    Block block = decoded;
+
+    const ScopedLock sl (lock);
+    // another thread may have decoded it meanwhile, keep theirs.
+    if (auto iter = lookup.find ({ key, index }); iter != lookup.end())
+        return iter->second->block;
+
+    entries.push_front ({ key, index, block });
+    lookup[{ key, index }] = entries.begin();
+    numBytes += sizeOf (block);
+    trim();
+    return block;
+}
+
+void SampleCache::clear()
+{
+    const ScopedLock sl (lock);
+    entries.clear();
+    lookup.clear();
+    numBytes = 0;
+}
+
+void SampleCache::trim()
+{
+    while (numBytes > capacity && ! entries.empty())
+    {
+        auto& oldest = entries.back();
+        numBytes -= sizeOf (oldest.block);
+        lookup.erase ({ oldest.key, oldest.index });
+        entries.pop_back();
+    }
+}
+
+} // namespace element
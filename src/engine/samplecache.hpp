@@ -0,0 +1,87 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/audio_formats.hpp>
+
+namespace element {
+
+/** Decoded audio shared by every file player in the process.
+
+    Files are decoded in fixed size blocks of stereo floats, keyed by path
+    and modification time, so players of the same file and each pass of a
+    loop reuse one decode. The least recently used blocks are dropped once
+    the cache is over its capacity. Blocks are reference counted, a block
+    someone still holds stays valid after it's dropped.
+
+    Thread safe. Decoding happens outside the lock on the calling thread.
+ */
+class SampleCache final
+{
+public:
+    static constexpr int blockSize = 65536;
+    static constexpr size_t defaultCapacity = 256 * 1024 * 1024;
+
+    using Block = std::shared_ptr<const juce::AudioBuffer<float>>;
+
+    SampleCache() = default;
+
+    /** Returns the process-wide cache. */
+    static std::shared_ptr<SampleCache> getShared();
+
+    /** Returns the key for a file, changes when the file does. */
+    static juce::String getKey (const juce::File& file);
+
+    /** Set the most bytes to keep, dropping blocks if over. */
+    void setCapacity (size_t numBytes);
+    size_t getCapacity() const;
+
+    /** Bytes held by cached blocks. */
+    size_t getNumBytes() const;
+
+    /** Returns block `index` of a file, decoding it with reader on a miss.
+        The reader isn't thread safe, the caller needs to own it. Returns
+        nullptr if index is past the end.
+     */
+    Block getBlock (const juce::String& key, juce::AudioFormatReader& reader, juce::int64 index);
+
+    /** Returns a cached block without decoding it, or nullptr. */
+    Block findBlock (const juce::String& key, juce::int64 index);
+
+    /** Drop everything. */
+    void clear();
+
+    juce::int64 getNumHits() const noexcept { return hits.load (std::memory_order_relaxed); }
+    juce::int64 getNumMisses() const noexcept { return misses.load (std::memory_order_relaxed); }
+
+private:
+    struct Entry
+    {
+        juce::String key;
+        juce::int64 index;
+        Block block;
+    };
+
+    using EntryList = std::list<Entry>;
+    using Key = std::pair<juce::String, juce::int64>;
+
+    juce::CriticalSection lock;
+    EntryList entries; // most recently used first
+    std::map<Key, EntryList::iterator> lookup;
+    size_t capacity = defaultCapacity, numBytes = 0;
+    std::atomic<juce::int64> hits { 0 }, misses { 0 };
+
+    static size_t sizeOf (const Block&) noexcept;
+    void trim();
+
+    JUCE_DECLARE_NON_COPYABLE (SampleCache)
+};
+
+} // namespace element
@@ -0,0 +1,198 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+
+#include "engine/signalanalyzer.hpp"
+
+namespace element {
+using namespace juce;
+
+static_assert (isPowerOfTwo (SnapshotRing::capacity), "ring positions are masked");
+static_assert (SignalAnalyzer::scopeFrames >= SignalAnalyzer::fftSize, "the FFT reads the newest scope frames");
+static_assert (SignalAnalyzer::scopeFrames <= SnapshotRing::capacity, "the ring holds a whole scope");
+
+SnapshotRing::SnapshotRing (int numChannels)
+    : buffer (jmax (1, numChannels), capacity)
+{
+    buffer.clear();
+}
+
+void SnapshotRing::write (const float* const* data, int numChannels, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    // only the newest frames of an oversized block would survive anyway.
+    const int skip = jmax (0, numSamples - capacity);
+    const int count = numSamples - skip;
+    const auto start = written.load (std::memory_order_relaxed);
+    const int pos = (int) ((start + skip) & (capacity - 1));
+    const int first = jmin (count, capacity - pos);
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        float* const dst = buffer.getWritePointer (ch);
+        if (ch < numChannels)
+        {
+            FloatVectorOperations::copy (dst + pos, data[ch] + skip, first);
+            FloatVectorOperations::copy (dst, data[ch] + skip + first, count - first);
+        }
+        else
+        {
+            FloatVectorOperations::clear (dst + pos, first);
+            FloatVectorOperations::clear (dst, count - first);
+        }
+    }
+
+    written.store (start + numSamples, std::memory_order_release);
+}
+
+bool SnapshotRing::read (float* const* dest, int numFrames) const noexcept
+{
+    jassert (numFrames <= capacity);
+    const auto end = written.load (std::memory_order_acquire);
+    if (numFrames > capacity || end < numFrames)
+        return false;
+
+    const auto start = end - numFrames;
+    const int pos = (int) (start & (capacity - 1));
+    const int first = jmin (numFrames, capacity - pos);
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        const float* const src = buffer.getReadPointer (ch);
+        FloatVectorOperations::copy (dest[ch], src + pos, first);
+        FloatVectorOperations::copy (dest[ch] + first, src, numFrames - first);
+    }
+
+    // the copy is good if the writer hasn't come round to where it started.
+    std::atomic_thread_fence (std::memory_order_acquire);
+    return written.load (std::memory_order_relaxed) - start <= capacity;
+}
+
+//==============================================================================
+SignalAnalyzer::SignalAnalyzer (const SnapshotRing& r)
+    : Thread ("element: analyzer"),
+      ring (r),
+      audio (r.getNumChannels(), scopeFrames),
+      window ((size_t) fftSize),
+      fftData ((size_t) fftSize * 2),
+      peaks ((size_t) numBins, minDecibels)
+{
+    dsp::WindowingFunction<float>::fillWindowingTables (window.data(), (size_t) fftSize, dsp::WindowingFunction<float>::hann, false);
+
+    // a full scale sine reads 0 dB.
+    float sum = 0.f;
+    for (auto w : window)
+        sum += w;
+    windowGain = 2.f / sum;
+}
+
+SignalAnalyzer::~SignalAnalyzer()
+{
+    stopThread (1000);
+}
+
+void SignalAnalyzer::addWatcher()
+{
+    if (numWatchers++ == 0)
+        startThread (Thread::Priority::low);
+}
+
+void SignalAnalyzer::removeWatcher()
+{
+    jassert (numWatchers > 0);
+    if (--numWatchers == 0)
+        stopThread (1000);
+}
+
+float SignalAnalyzer::getBinFrequency (int bin, double sampleRate) noexcept
+{
+    const double ratio = jmax (1.0, sampleRate * 0.5 / lowestFrequency);
+    return (float) (lowestFrequency * std::pow (ratio, (double) bin / (double) (numBins - 1)));
+}
+
+void SignalAnalyzer::updateBins (double newRate)
+{
+    binRate = newRate;
+    binStart.resize ((size_t) numBins);
+    binEnd.resize ((size_t) numBins);
+
+    // each bin covers the FFT bins from halfway to its neighbours, at least
+    // one of them where they're spread thinner than the bins.
+    const double ratio = jmax (1.0, newRate * 0.5 / lowestFrequency);
+    const double perHz = fftSize / newRate;
+    for (int b = 0; b < numBins; ++b)
+    {
+        const double lo = lowestFrequency * std::pow (ratio, (b - 0.5) / (numBins - 1));
+        const double hi = lowestFrequency * std::pow (ratio, (b + 0.5) / (numBins - 1));
+        const int first = jlimit (1, fftSize / 2, roundToInt (lo * perHz));
+        binStart[(size_t) b] = first;
+        binEnd[(size_t) b] = jlimit (first, fftSize / 2, roundToInt (hi * perHz));
+    }
+
+    std::fill (peaks.begin(), peaks.end(), minDecibels);
+}
+
+bool SignalAnalyzer::analyze()
+{
+    const double currentRate = sampleRate.load();
+    if (currentRate != binRate)
+        updateBins (currentRate);
+
+    if (! ring.read (audio.getArrayOfWritePointers(), scopeFrames))
+        return false;
+
+    float* const mono = audio.getWritePointer (0);
+    for (int ch = 1; ch < audio.getNumChannels(); ++ch)
+        FloatVectorOperations::add (mono, audio.getReadPointer (ch), scopeFrames);
+    if (audio.getNumChannels() > 1)
+        FloatVectorOperations::multiply (mono, 1.f / (float) audio.getNumChannels(), scopeFrames);
+
+    auto& frame = mailbox.getWriteFrame();
+    frame.sampleRate = currentRate;
+    frame.spectrum.resize ((size_t) numBins);
+    frame.scopeMin.resize ((size_t) numScopePoints);
+    frame.scopeMax.resize ((size_t) numScopePoints);
+
+    constexpr int framesPerPoint = scopeFrames / numScopePoints;
+    for (int p = 0; p < numScopePoints; ++p)
+    {
+        const auto range = FloatVectorOperations::findMinAndMax (mono + p * framesPerPoint, framesPerPoint);
+        frame.scopeMin[(size_t) p] = range.getStart();
+        frame.scopeMax[(size_t) p] = range.getEnd();
+    }
+
+    float* const data = fftData.data();
+    FloatVectorOperations::multiply (data, mono + scopeFrames - fftSize, window.data(), fftSize);
+    FloatVectorOperations::clear (data + fftSize, fftSize);
+    fft.performFrequencyOnlyForwardTransform (data, true);
+
+    // peaks fall about 90 dB a second at the display rate.
+    constexpr float decay = 1.5f;
+    for (int b = 0; b < numBins; ++b)
+    {
+        float magnitude = 0.f;
+        for (int k = binStart[(size_t) b]; k <= binEnd[(size_t) b]; ++k)
+            magnitude = jmax (magnitude, data[k]);
+
+        const float db = Decibels::gainToDecibels (magnitude * windowGain, minDecibels);
+        auto& peak = peaks[(size_t) b];
+        peak = jmax (db, peak - decay);
+        frame.spectrum[(size_t) b] = peak;
+    }
+
+    mailbox.publish();
+    return true;
+}
+
+void SignalAnalyzer::run()
+{
+    while (! threadShouldExit())
+    {
+        analyze();
+        wait (1000 / passesPerSecond);
+    }
+}
+
+} // namespace element
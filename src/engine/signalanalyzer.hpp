@@ -0,0 +1,132 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <element/juce/audio_basics.hpp>
+#include <element/juce/core.hpp>
+#include <element/juce/dsp.hpp>
+
+#include "engine/framemailbox.hpp"
+
+namespace element {
+
+/** The most recent audio, kept for a reader on another thread.
+
+    The audio thread only copies its block in and advances a counter.
+    A reader copies out the newest frames and checks the counter again
+    afterwards, dropping the copy if the writer got far enough to
+    overwrite it meanwhile. Neither side locks or waits.
+ */
+class SnapshotRing final
+{
+public:
+    /** Frames kept per channel. */
+    static constexpr int capacity = 8192;
+
+    /** Allocates for a fixed number of channels. */
+    explicit SnapshotRing (int numChannels);
+
+    int getNumChannels() const noexcept { return buffer.getNumChannels(); }
+
+    /** Returns the frames written so far. */
+    juce::int64 getNumWritten() const noexcept { return written.load (std::memory_order_acquire); }
+
+    /** Add a block. Channels past the ring's are ignored, missing ones
+        are written silent. Realtime safe.
+     */
+    void write (const float* const* data, int numChannels, int numSamples) noexcept;
+
+    /** Copy out the newest numFrames of every channel. Returns false if
+        fewer were written or the writer overwrote them while copying.
+     */
+    bool read (float* const* dest, int numFrames) const noexcept;
+
+private:
+    juce::AudioBuffer<float> buffer;
+    std::atomic<juce::int64> written { 0 };
+};
+
+//==============================================================================
+/** Turns what a SnapshotRing holds into spectra and scope traces.
+
+    Runs on its own thread at display rate while anyone is watching. Each
+    pass takes the newest audio, mixed to mono, through a windowed FFT and
+    reduces it to a fixed number of log spaced bins, the loudest FFT bin
+    in each, with peaks decaying slowly. The scope is the newest stretch
+    of audio reduced to a min and max per point. Frames are handed to the
+    display through a FrameMailbox, so drawing one never waits on
+    analysis and analysis never touches the audio thread.
+ */
+class SignalAnalyzer final : private juce::Thread
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = 256;
+    static constexpr int numScopePoints = 512;
+    static constexpr int scopeFrames = 4096;
+    static constexpr float minDecibels = -120.f;
+    static constexpr float lowestFrequency = 20.f;
+
+    /** Passes per second while running. */
+    static constexpr int passesPerSecond = 60;
+
+    /** One analysis, ready to draw. */
+    struct Frame
+    {
+        std::vector<float> spectrum; // dB per bin
+        std::vector<float> scopeMin, scopeMax; // per point, oldest first
+        double sampleRate = 44100.0;
+    };
+
+    explicit SignalAnalyzer (const SnapshotRing& ring);
+    ~SignalAnalyzer() override;
+
+    /** Set the rate of the audio in the ring. Realtime safe. */
+    void setSampleRate (double newSampleRate) noexcept { sampleRate.store (newSampleRate); }
+
+    /** Start analysing, for as long as someone watches. Calls are counted
+        and the thread stops when the last watcher leaves. Message thread.
+     */
+    void addWatcher();
+    void removeWatcher();
+
+    /** Returns the newest frame if one was made since the last call.
+        Display thread.
+     */
+    const Frame* takeFrame() noexcept { return mailbox.take(); }
+    const Frame& getFrame() const noexcept { return mailbox.getReadFrame(); }
+
+    /** Returns the centre frequency of a bin at a sample rate. */
+    static float getBinFrequency (int bin, double sampleRate) noexcept;
+
+    /** Make and publish one frame. Returns false if the ring hasn't enough
+        audio yet. Called by the thread, or directly when it isn't running.
+     */
+    bool analyze();
+
+private:
+    const SnapshotRing& ring;
+    std::atomic<double> sampleRate { 44100.0 };
+    int numWatchers = 0;
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::AudioBuffer<float> audio;
+    std::vector<float> window, fftData, peaks;
+    std::vector<int> binStart, binEnd;
+    double binRate = 0.0;
+    float windowGain = 1.f;
+
+    FrameMailbox<Frame> mailbox;
+
+    void run() override;
+    void updateBins (double newRate);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SignalAnalyzer)
+};
+
+} // namespace element
@@ -0,0 +1,53 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cstring>
+
+#include "engine/signalguard.hpp"
+
+namespace element {
+
+std::atomic<bool> SignalGuard::enabled { false };
+std::atomic<int64> SignalGuard::numFaults { 0 };
+
+namespace detail {
+static constexpr uint32 exponentMask = 0x7f800000u;
+static constexpr uint32 mantissaMask = 0x007fffffu;
+
+static inline uint32 floatBits (float value) noexcept
+{
+    uint32 bits;
+    std::memcpy (&bits, &value, sizeof (bits));
+    return bits;
+}
+
+static inline bool isNonFinite (uint32 bits) noexcept { return (bits & exponentMask) == exponentMask; }
+static inline bool isDenormal (uint32 bits) noexcept { return (bits & exponentMask) == 0 && (bits & mantissaMask) != 0; }
+} // namespace detail
+
+SignalGuard::Result SignalGuard::sanitize (float* data, int numSamples) noexcept
+{
+    Result result;
+
+    // branch free counts so the loop vectorizes.
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto bits = detail::floatBits (data[i]);
+        result.nonFinite += detail::isNonFinite (bits) ? 1 : 0;
+        result.denormal += detail::isDenormal (bits) ? 1 : 0;
+    }
+
+    if (result.isClean())
+        return result;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto bits = detail::floatBits (data[i]);
+        if (detail::isNonFinite (bits) || detail::isDenormal (bits))
+            data[i] = 0.f;
+    }
+
+    return result;
+}
+
+} // namespace element
@@ -0,0 +1,67 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Keeps bad samples from spreading through a graph.
+
+    While enabled, each node's outputs are scanned after it renders. NaN
+    and infinite samples are zeroed and counted as a fault of the node,
+    denormals are flushed to zero without counting. A node that faults for
+    faultLimit blocks in a row is bypassed, so one broken plugin silences
+    only itself instead of everything downstream of it.
+
+    The scan tests bits rather than calling std::isnan(), which fast math
+    builds are free to fold away.
+ */
+class SignalGuard final
+{
+public:
+    /** Consecutive faulty blocks before a node is bypassed. */
+    static constexpr int faultLimit = 8;
+
+    /** What sanitize() found. */
+    struct Result
+    {
+        int nonFinite = 0; ///< NaN or infinite samples
+        int denormal = 0;
+
+        bool isClean() const noexcept { return nonFinite == 0 && denormal == 0; }
+    };
+
+    /** Returns true if node outputs are being checked. */
+    static bool isEnabled() noexcept { return enabled.load (std::memory_order_relaxed); }
+
+    /** Turn the checks on or off. Any thread, takes effect on the next block. */
+    static void setEnabled (bool shouldGuard) noexcept { enabled.store (shouldGuard, std::memory_order_relaxed); }
+
+    /** Zero NaN, infinite and denormal samples in place. Realtime safe.
+
+        Clean blocks, the usual case, are only read: the first pass just
+        counts and the second runs when there is something to zero.
+     */
+    static Result sanitize (float* data, int numSamples) noexcept;
+
+    /** Count a faulty block. Called by the graph while rendering. */
+    static void recordFault() noexcept { numFaults.fetch_add (1, std::memory_order_relaxed); }
+
+    /** Returns the faulty blocks of all nodes since the last reset. Any thread. */
+    static int64 getNumFaults() noexcept { return numFaults.load (std::memory_order_relaxed); }
+
+    /** Clear the fault count. Any thread. */
+    static void resetFaults() noexcept { numFaults.store (0, std::memory_order_relaxed); }
+
+private:
+    static std::atomic<bool> enabled;
+    static std::atomic<int64> numFaults;
+
+    SignalGuard() = delete;
+};
+
+} // namespace element
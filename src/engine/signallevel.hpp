@@ -0,0 +1,58 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <cmath>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Peak and RMS of a block of samples, measured in one pass. */
+struct SignalLevel
+{
+    float peak = 0.f;
+    float rms = 0.f;
+
+    /** Measure a channel. Realtime safe.
+
+        Four independent accumulators let the compiler keep the loop in
+        vector registers without reassociating float math.
+     */
+    static SignalLevel measure (const float* data, int numSamples) noexcept
+    {
+        SignalLevel level;
+        if (numSamples <= 0)
+            return level;
+
+        float p0 = 0.f, p1 = 0.f, p2 = 0.f, p3 = 0.f;
+        float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float a = data[i], b = data[i + 1], c = data[i + 2], d = data[i + 3];
+            p0 = juce::jmax (p0, std::abs (a));
+            p1 = juce::jmax (p1, std::abs (b));
+            p2 = juce::jmax (p2, std::abs (c));
+            p3 = juce::jmax (p3, std::abs (d));
+            s0 += a * a;
+            s1 += b * b;
+            s2 += c * c;
+            s3 += d * d;
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            p0 = juce::jmax (p0, std::abs (data[i]));
+            s0 += data[i] * data[i];
+        }
+
+        level.peak = juce::jmax (p0, p1, p2, p3);
+        level.rms = std::sqrt ((s0 + s1 + s2 + s3) / (float) numSamples);
+        return level;
+    }
+};
+
+} // namespace element
@@ -0,0 +1,108 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+
+#include <element/audioengine.hpp>
+
+namespace element {
+
+/** Collects callback timing for AudioEngine::getTelemetry().
+
+    record() is called once per callback on the audio thread and only does
+    relaxed atomic stores, so any thread can take a snapshot at any time.
+ */
+class TelemetryCollector final
+{
+public:
+    using Telemetry = AudioEngine::Telemetry;
+    static constexpr int numBins = Telemetry::numBins;
+
+    TelemetryCollector() { reset(); }
+
+    /** Clear all counters. */
+    void reset() noexcept
+    {
+        numCallbacks.store (0, std::memory_order_relaxed);
+        deadlineMisses.store (0, std::memory_order_relaxed);
+        lateCallbacks.store (0, std::memory_order_relaxed);
+        for (auto& bin : histogram)
+            bin.store (0, std::memory_order_relaxed);
+        load.store (0.f, std::memory_order_relaxed);
+        peakLoad.store (0.f, std::memory_order_relaxed);
+        numPeriods.store (0, std::memory_order_relaxed);
+        periodSum.store (0.0, std::memory_order_relaxed);
+        deviationSum.store (0.0, std::memory_order_relaxed);
+    }
+
+    /** Record one callback. Realtime safe, call from the audio thread only.
+
+        @param blockSeconds    duration of the audio in the block
+        @param elapsedSeconds  time spent in the callback
+        @param periodSeconds   time since the previous callback started, or
+                               zero if there wasn't one
+     */
+    void record (double blockSeconds, double elapsedSeconds, double periodSeconds) noexcept
+    {
+        if (blockSeconds <= 0.0)
+            return;
+
+        numCallbacks.fetch_add (1, std::memory_order_relaxed);
+
+        const auto ratio = elapsedSeconds / blockSeconds;
+        if (ratio > 1.0)
+            deadlineMisses.fetch_add (1, std::memory_order_relaxed);
+        histogram[(size_t) juce::jlimit (0, numBins - 1, (int) (ratio * (numBins - 1)))]
+            .fetch_add (1, std::memory_order_relaxed);
+
+        const auto current = load.load (std::memory_order_relaxed);
+        load.store (current + 0.1f * ((float) ratio - current), std::memory_order_relaxed);
+        if ((float) ratio > peakLoad.load (std::memory_order_relaxed))
+            peakLoad.store ((float) ratio, std::memory_order_relaxed);
+
+        if (periodSeconds > 0.0)
+        {
+            if (periodSeconds > blockSeconds * 1.5)
+                lateCallbacks.fetch_add (1, std::memory_order_relaxed);
+
+            // only this thread writes these, a plain read-modify-write is enough.
+            const auto deviation = periodSeconds - blockSeconds;
+            numPeriods.fetch_add (1, std::memory_order_relaxed);
+            periodSum.store (periodSum.load (std::memory_order_relaxed) + periodSeconds, std::memory_order_relaxed);
+            deviationSum.store (deviationSum.load (std::memory_order_relaxed) + deviation * deviation,
+                                std::memory_order_relaxed);
+        }
+    }
+
+    /** Returns the counters so far. xruns is left for the caller to fill in. */
+    Telemetry snapshot() const noexcept
+    {
+        Telemetry t;
+        t.numCallbacks = numCallbacks.load (std::memory_order_relaxed);
+        t.deadlineMisses = deadlineMisses.load (std::memory_order_relaxed);
+        t.lateCallbacks = lateCallbacks.load (std::memory_order_relaxed);
+        t.load = load.load (std::memory_order_relaxed);
+        t.peakLoad = peakLoad.load (std::memory_order_relaxed);
+        for (int i = 0; i < numBins; ++i)
+            t.histogram[i] = histogram[(size_t) i].load (std::memory_order_relaxed);
+
+        if (const auto n = numPeriods.load (std::memory_order_relaxed); n > 0)
+        {
+            t.periodMs = 1000.0 * periodSum.load (std::memory_order_relaxed) / (double) n;
+            t.jitterMs = 1000.0 * std::sqrt (deviationSum.load (std::memory_order_relaxed) / (double) n);
+        }
+
+        return t;
+    }
+
+private:
+    std::atomic<juce::int64> numCallbacks, deadlineMisses, lateCallbacks, numPeriods;
+    std::atomic<juce::int64> histogram[numBins];
+    std::atomic<float> load, peakLoad;
+    std::atomic<double> periodSum, deviationSum;
+};
+
+} // namespace element
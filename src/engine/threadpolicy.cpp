@@ -0,0 +1,162 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "engine/threadpolicy.hpp"
+
+#if JUCE_LINUX || JUCE_BSD
+#include <pthread.h>
+#include <sched.h>
+#elif JUCE_WINDOWS
+#include <windows.h>
+#endif
+
+namespace element {
+
+std::atomic<int> ThreadPolicy::generation { 0 };
+std::atomic<juce::uint32> ThreadPolicy::realtimeMask { 0 };
+std::atomic<juce::uint32> ThreadPolicy::backgroundMask { 0 };
+std::atomic<int> ThreadPolicy::priority { 0 };
+
+void ThreadPolicy::set (juce::uint32 realtimeCores, juce::uint32 backgroundCores, int realtimePriority) noexcept
+{
+    realtimePriority = juce::jlimit (0, 99, realtimePriority);
+    if (realtimeMask.load() == realtimeCores && backgroundMask.load() == backgroundCores
+        && priority.load() == realtimePriority)
+        return;
+
+    realtimeMask.store (realtimeCores);
+    backgroundMask.store (backgroundCores);
+    priority.store (realtimePriority);
+    generation.fetch_add (1, std::memory_order_release);
+}
+
+namespace {
+/** What applyRealtime() changed on a thread, so it can be undone when the
+    settings are cleared.
+ */
+struct AppliedState
+{
+    bool pinned = false;
+#if JUCE_LINUX || JUCE_BSD
+    bool scheduled = false;
+    int oldPolicy = SCHED_OTHER;
+    sched_param oldParam {};
+#elif JUCE_WINDOWS
+    HANDLE mmcss = nullptr;
+#endif
+};
+
+thread_local AppliedState applied;
+
+void unpinCurrentThread() noexcept
+{
+#if JUCE_LINUX
+    cpu_set_t all;
+    CPU_ZERO (&all);
+    for (int core = 0; core < CPU_SETSIZE; ++core)
+        CPU_SET (core, &all);
+    pthread_setaffinity_np (pthread_self(), sizeof (all), &all);
+#elif JUCE_WINDOWS
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (GetProcessAffinityMask (GetCurrentProcess(), &processMask, &systemMask))
+        SetThreadAffinityMask (GetCurrentThread(), processMask);
+#else
+    juce::Thread::setCurrentThreadAffinityMask (~juce::uint32 (0));
+#endif
+}
+
+#if JUCE_WINDOWS
+using AvSetFn = HANDLE (WINAPI*) (LPCWSTR, LPDWORD);
+using AvRevertFn = BOOL (WINAPI*) (HANDLE);
+
+HMODULE getAvrt() noexcept
+{
+    static HMODULE lib = LoadLibraryW (L"avrt.dll");
+    return lib;
+}
+#endif
+} // namespace
+
+void ThreadPolicy::applyRealtime() noexcept
+{
+    // cleared settings put back what the thread had before, all cores and
+    // the scheduling it started with.
+    if (const auto mask = realtimeMask.load (std::memory_order_relaxed); mask != 0)
+    {
+        juce::Thread::setCurrentThreadAffinityMask (mask);
+        applied.pinned = true;
+    }
+    else if (applied.pinned)
+    {
+        unpinCurrentThread();
+        applied.pinned = false;
+    }
+
+    const auto prio = priority.load (std::memory_order_relaxed);
+
+#if JUCE_LINUX || JUCE_BSD
+    if (prio > 0)
+    {
+        if (! applied.scheduled)
+            pthread_getschedparam (pthread_self(), &applied.oldPolicy, &applied.oldParam);
+
+        sched_param param {};
+        param.sched_priority = juce::jlimit (sched_get_priority_min (SCHED_FIFO),
+                                             sched_get_priority_max (SCHED_FIFO),
+                                             prio);
+        // fails without CAP_SYS_NICE or an rtprio limit, the thread keeps its old policy.
+        if (pthread_setschedparam (pthread_self(), SCHED_FIFO, &param) == 0)
+            applied.scheduled = true;
+    }
+    else if (applied.scheduled)
+    {
+        pthread_setschedparam (pthread_self(), applied.oldPolicy, &applied.oldParam);
+        applied.scheduled = false;
+    }
+#elif JUCE_WINDOWS
+    static const auto avSet = getAvrt() != nullptr ? (AvSetFn) GetProcAddress (getAvrt(), "AvSetMmThreadCharacteristicsW") : nullptr;
+    static const auto avRevert = getAvrt() != nullptr ? (AvRevertFn) GetProcAddress (getAvrt(), "AvRevertMmThreadCharacteristics") : nullptr;
+
+    // each call registers the thread again, so the last one is reverted first.
+    if (applied.mmcss != nullptr && avRevert != nullptr)
+        avRevert (applied.mmcss);
+    applied.mmcss = nullptr;
+
+    if (prio > 0 && avSet != nullptr)
+    {
+        DWORD taskIndex = 0;
+        applied.mmcss = avSet (L"Pro Audio", &taskIndex);
+    }
+#else
+    juce::ignoreUnused (prio);
+#endif
+}
+
+void ThreadPolicy::prepareBackground (juce::Thread& thread) noexcept
+{
+    if (const auto mask = backgroundMask.load (std::memory_order_relaxed); mask != 0)
+        thread.setAffinityMask (mask);
+}
+
+juce::uint32 ThreadPolicy::parseCores (const juce::String& text) noexcept
+{
+    juce::uint32 mask = 0;
+    for (const auto& token : juce::StringArray::fromTokens (text, ",", {}))
+    {
+        const auto item = token.trim();
+        if (item.isEmpty() || ! item.containsOnly ("0123456789-"))
+            continue;
+
+        int first = item.upToFirstOccurrenceOf ("-", false, false).getIntValue();
+        int last = item.contains ("-") ? item.fromFirstOccurrenceOf ("-", false, false).getIntValue() : first;
+        if (last < first)
+            std::swap (first, last);
+
+        for (int core = juce::jmax (0, first); core <= juce::jmin (31, last); ++core)
+            mask |= (1u << core);
+    }
+
+    return mask;
+}
+
+} // namespace element
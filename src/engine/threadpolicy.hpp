@@ -0,0 +1,68 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Core pinning and realtime priority for the engine's threads.
+
+    Realtime threads (the audio callback and render workers) can be pinned
+    to a set of isolated cores and given SCHED_FIFO priority on Linux or
+    MMCSS "Pro Audio" scheduling on Windows. Background threads (LV2
+    workers, file players, scanners...) can be moved to other cores.
+
+    The policy is global. Realtime threads pick up changes the next time
+    they run, by comparing getGeneration() with the one they last applied.
+    Background threads are configured when they start.
+ */
+class ThreadPolicy final
+{
+public:
+    /** Set the policy. Masks have a bit per core, zero leaves threads
+        unpinned. A priority of zero leaves scheduling to the backend,
+        otherwise it's a SCHED_FIFO priority from 1 to 99. Clearing either
+        undoes what was applied to realtime threads: they're unpinned and
+        get back the scheduling they had before.
+     */
+    static void set (juce::uint32 realtimeCores, juce::uint32 backgroundCores, int realtimePriority) noexcept;
+
+    /** Returns a counter that changes each time the policy does. */
+    static int getGeneration() noexcept { return generation.load (std::memory_order_acquire); }
+
+    /** Apply the realtime policy to the calling thread. */
+    static void applyRealtime() noexcept;
+
+    /** Apply the realtime policy to the calling thread if it changed since
+        lastGeneration. Cheap enough to call once per block.
+     */
+    static void applyRealtimeIfChanged (int& lastGeneration) noexcept
+    {
+        const auto current = getGeneration();
+        if (current == lastGeneration)
+            return;
+        lastGeneration = current;
+        applyRealtime();
+    }
+
+    /** Configure a background thread before it's started. */
+    static void prepareBackground (juce::Thread& thread) noexcept;
+
+    /** Parse a core list like "2,3" or "4-7" into a mask. Cores past 31
+        are ignored.
+     */
+    static juce::uint32 parseCores (const juce::String& text) noexcept;
+
+private:
+    static std::atomic<int> generation;
+    static std::atomic<juce::uint32> realtimeMask, backgroundMask;
+    static std::atomic<int> priority;
+
+    ThreadPolicy() = delete;
+};
+
+} // namespace element
@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include "matrixstate.hpp"
 
 namespace element {
@@ -119,4 +122,68 @@ private:
     }
 };
 
+/** Hands immutable grid snapshots to the audio thread without locking.
+
+    The message thread publishes whole grids. The audio thread acquires the
+    newest one, uses it for as long as it likes and then retires the grid it
+    replaced. Retired grids are deleted back on the message thread, so the
+    audio thread never allocates, frees or waits.
+ */
+template <typename GridType>
+class GridExchange final : private AsyncUpdater
+{
+public:
+    GridExchange() = default;
+
+    ~GridExchange()
+    {
+        cancelPendingUpdate();
+        delete pending.exchange (nullptr);
+        delete retired.exchange (nullptr);
+    }
+
+    /** Publish a new grid. Don't call on the audio thread. */
+    void publish (std::unique_ptr<GridType> grid)
+    {
+        collect();
+        delete pending.exchange (grid.release());
+    }
+
+    /** Publish a snapshot of a matrix. Allocates, don't call on the audio thread. */
+    void publish (const MatrixState& matrix) { publish (std::make_unique<GridType> (matrix)); }
+
+    /** Returns the newest published grid, or nullptr if nothing new is ready.
+        The caller owns it and must hand back the grid it replaces with
+        retire(). Realtime safe.
+     */
+    GridType* acquire() noexcept
+    {
+        // one grid in flight at a time, try again once the last was collected.
+        if (retired.load (std::memory_order_acquire) != nullptr)
+            return nullptr;
+        return pending.exchange (nullptr, std::memory_order_acq_rel);
+    }
+
+    /** Give back a grid that is no longer used. Realtime safe. */
+    void retire (GridType* grid) noexcept
+    {
+        if (grid == nullptr)
+            return;
+        jassert (retired.load() == nullptr);
+        retired.store (grid, std::memory_order_release);
+        triggerAsyncUpdate();
+    }
+
+private:
+    std::atomic<GridType*> pending { nullptr };
+    std::atomic<GridType*> retired { nullptr };
+
+    void collect() { delete retired.exchange (nullptr, std::memory_order_acq_rel); }
+    void handleAsyncUpdate() override { collect(); }
+
+    JUCE_DECLARE_NON_COPYABLE (GridExchange)
+};
+
+using ToggleGridExchange = GridExchange<ToggleGrid>;
+
 } // namespace element
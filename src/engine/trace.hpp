@@ -5,43 +5,33 @@
 
 #include <element/juce/audio_basics.hpp>
 
+#include "engine/rendertrace.hpp"
+
 namespace element {
 
-inline static void traceMidi (const juce::MidiMessage& msg, const int frame = -1)
+/** Record raw MIDI bytes in the render trace. Only the first three are kept. */
+inline static void traceMidi (const juce::uint8* data, int size, const int frame = -1) noexcept
+{
+    int32 packed = 0;
+    for (int i = 0; i < juce::jmin (3, size); ++i)
+        packed |= (int32) data[i] << (8 * (2 - i));
+
+    RenderTrace::record (RenderTrace::midiEvent, (uint32) juce::jmax (0, frame), packed);
+}
+
+/** Record a MIDI message in the render trace. Realtime safe. */
+inline static void traceMidi (const juce::MidiMessage& msg, const int frame = -1) noexcept
 {
-    if (msg.isMidiClock())
-    {
-        DBG ("clock:");
-    }
-    if (msg.isNoteOn())
-    {
-        std::clog << "NOTE ON: " << msg.getMidiNoteName (msg.getNoteNumber(), true, false, 4).toStdString() << std::endl;
-    }
-    if (msg.isNoteOff())
-    {
-        std::clog << "NOTE OFF: " << msg.getMidiNoteName (msg.getNoteNumber(), true, false, 4).toStdString() << std::endl;
-    }
-
-    if (msg.isController())
-    {
-        msg.isControllerOfType (0);
-        DBG ("MIDI CC: " << msg.getControllerNumber() << ":" << msg.getControllerValue());
-    }
-
-    if (msg.isProgramChange())
-    {
-        DBG ("program change: " << msg.getProgramChangeNumber() << " ch: " << msg.getChannel());
-    }
-
-    if (frame >= 0 && (msg.isAllNotesOff() || msg.isAllSoundOff()))
-    {
-        DBG ("got it: " << frame);
-    }
+    if (RenderTrace::isEnabled())
+        traceMidi (msg.getRawData(), msg.getRawDataSize(), frame);
 }
 
-inline static void traceMidi (juce::MidiBuffer& buf)
+/** Record every message in a buffer. Realtime safe. */
+inline static void traceMidi (const juce::MidiBuffer& buf) noexcept
 {
+    if (! RenderTrace::isEnabled())
+        return;
     for (const auto i : buf)
-        traceMidi (i.getMessage(), i.samplePosition);
+        traceMidi (i.data, i.numBytes, i.samplePosition);
 }
 } // namespace element
@@ -1,6 +1,8 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <algorithm>
+
 #include <element/transport.hpp>
 #include "tempo.hpp"
 
@@ -59,99 +61,220 @@ void Transport::Monitor::getBarsAndBeats (int& bars, int& beats, int& subBeats,
 }
 
 Transport::Transport()
-    : playState (false),
-      recordState (false)
 {
     monitor = new Monitor();
     monitor->tempo.set (getTempo());
-
-    seekWanted.set (false);
-    seekFrame.set (0);
-
-    nextBeatsPerBar.set (getBeatsPerBar());
-    nextBeatDivisor.set (getBeatType());
-
     setLengthFrames (0);
 }
 
 Transport::~Transport() {}
 
-void Transport::preProcess (int nframes)
+bool Transport::push (const Command& command)
+{
+    // writers are serialized so the audio thread never waits.
+    const SpinLock::ScopedLockType sl (writeLock);
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (1, start1, size1, start2, size2);
+    if (size1 + size2 < 1)
+        return false;
+    queue[(size_t) (size1 > 0 ? start1 : start2)] = command;
+    fifo.finishedWrite (1);
+    return true;
+}
+
+void Transport::drain()
 {
-    if (recording != recordState.get())
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (jmin (fifo.getNumReady(), capacity - numPending), start1, size1, start2, size2);
+    for (int i = 0; i < size1 + size2; ++i)
     {
-        recording = recordState.get();
+        const auto& command = queue[(size_t) (i < size1 ? start1 + i : start2 + (i - size1))];
+        // keep offset order, requests at the same offset stay in the order made.
+        int j = numPending++;
+        while (j > 0 && pending[(size_t) j - 1].offset > command.offset)
+        {
+            pending[(size_t) j] = pending[(size_t) j - 1];
+            --j;
+        }
+        pending[(size_t) j] = command;
     }
+    fifo.finishedRead (size1 + size2);
+}
 
-    if (playing != playState.get())
+void Transport::apply (const Command& command)
+{
+    switch (command.type)
     {
-        playing = playState.get();
+        case Command::play:
+            playing = command.state;
+            break;
+        case Command::record:
+            recording = command.state;
+            break;
+        case Command::tempo:
+            rampLength = 0;
+            if (command.tempo > 0.0)
+                setTempo ((float) command.tempo);
+            break;
+        case Command::ramp:
+            rampLength = 0;
+            if (command.tempo <= 0.0)
+                break;
+            if (command.frame <= 0)
+            {
+                setTempo ((float) command.tempo);
+                break;
+            }
+            rampStart = getTempo();
+            rampTarget = command.tempo;
+            rampLength = command.frame;
+            rampDone = 0;
+            break;
+        case Command::meter: {
+            bool updateTimeScale = false;
+            if (getBeatsPerBar() != command.beatsPerBar)
+            {
+                ts.setBeatsPerBar ((unsigned short) command.beatsPerBar);
+                updateTimeScale = true;
+            }
+
+            if (ts.beatDivisor() != command.beatDivisor)
+            {
+                ts.setBeatType ((unsigned short) command.beatDivisor);
+                ts.setBeatDivisor (1 << ts.beatType());
+                updateTimeScale = true;
+            }
+
+            if (updateTimeScale)
+                ts.updateScale();
+            monitor->beatsPerBar.set (getBeatsPerBar());
+            monitor->beatDivisor.set (command.beatDivisor);
+            break;
+        }
+        case Command::locate:
+            if (getPositionFrames() != command.frame)
+                seekAudioFrame (command.frame);
+            break;
     }
+}
 
-    if (playing)
+void Transport::advanceRamp (int64_t frames)
+{
+    if (rampLength <= 0 || frames <= 0)
+        return;
+
+    rampDone = jmin (rampLength, rampDone + frames);
+    const double progress = (double) rampDone / (double) rampLength;
+    setTempo ((float) (rampStart + (rampTarget - rampStart) * progress));
+    if (rampDone >= rampLength)
+        rampLength = 0;
+}
+
+void Transport::preProcess (int nframes)
+{
+    ignoreUnused (nframes);
+    drain();
+
+    int numDone = 0;
+    while (numDone < numPending && pending[(size_t) numDone].offset <= 0)
+        apply (pending[(size_t) numDone++]);
+
+    if (numDone > 0)
     {
+        std::copy (pending.begin() + numDone, pending.begin() + numPending, pending.begin());
+        numPending -= numDone;
     }
 }
 
 void Transport::postProcess (int nframes)
 {
-    if (getTempo() != nextTempo.get())
+    // the block is rendered, walk through it applying what falls inside.
+    int64_t cursor = 0;
+    int numDone = 0;
+    while (numDone < numPending && pending[(size_t) numDone].offset < nframes)
     {
-        setTempo (nextTempo.get());
-        nextTempo.set (getTempo());
-        monitor->tempo.set (nextTempo.get());
+        const auto& command = pending[(size_t) numDone++];
+        if (playing)
+            advance ((int) (command.offset - cursor));
+        advanceRamp (command.offset - cursor);
+        cursor = command.offset;
+        apply (command);
     }
 
+    if (playing)
+        advance ((int) (nframes - cursor));
+    advanceRamp (nframes - cursor);
+
+    std::copy (pending.begin() + numDone, pending.begin() + numPending, pending.begin());
+    numPending -= numDone;
+    for (int i = 0; i < numPending; ++i)
+        pending[(size_t) i].offset -= nframes;
+
+    monitor->tempo.set (getTempo());
     monitor->playing.set (playing);
     monitor->recording.set (recording);
     monitor->positionFrames.set (getPositionFrames());
+}
 
-    bool updateTimeScale = false;
-    if (getBeatsPerBar() != nextBeatsPerBar.get())
-    {
-        ts.setBeatsPerBar ((unsigned short) nextBeatsPerBar.get());
-        monitor->beatsPerBar.set (getBeatsPerBar());
-        updateTimeScale = true;
-    }
+bool Transport::requestPlayState (bool shouldPlay, int64_t offset)
+{
+    Command command;
+    command.type = Command::play;
+    command.state = shouldPlay;
+    command.offset = offset;
+    if (! push (command))
+        return false;
+    requestedPlaying.store (shouldPlay);
+    return true;
+}
 
-    if (ts.beatDivisor() != nextBeatDivisor.get())
-    {
-        ts.setBeatType ((unsigned short) nextBeatDivisor.get());
-        ts.setBeatDivisor (1 << ts.beatType());
-        monitor->beatDivisor.set (nextBeatDivisor.get());
-        updateTimeScale = true;
-    }
+bool Transport::requestPlayPause() { return requestPlayState (! requestedPlaying.load()); }
 
-    if (updateTimeScale)
-        ts.updateScale();
+bool Transport::requestRecordState (bool shouldRecord, int64_t offset)
+{
+    Command command;
+    command.type = Command::record;
+    command.state = shouldRecord;
+    command.offset = offset;
+    return push (command);
+}
 
-    if (seekWanted.get())
-    {
-        if (getPositionFrames() != seekFrame.get())
-            seekAudioFrame (seekFrame.get());
-        seekWanted.set (false);
-    }
+bool Transport::requestTempo (double bpm, int64_t offset)
+{
+    Command command;
+    command.type = Command::tempo;
+    command.tempo = bpm;
+    command.offset = offset;
+    return push (command);
+}
+
+bool Transport::requestTempoRamp (double bpm, int64_t lengthFrames, int64_t offset)
+{
+    Command command;
+    command.type = Command::ramp;
+    command.tempo = bpm;
+    command.frame = lengthFrames;
+    command.offset = offset;
+    return push (command);
 }
 
-void Transport::requestMeter (int beatsPerBar, int beatDivisor)
+bool Transport::requestMeter (int beatsPerBar, int beatDivisor, int64_t offset)
 {
-    // std::clog << "request meter: " << beatsPerBar << "/" << (1 << beatDivisor) << std::endl;
-    if (beatsPerBar < 1)
-        beatsPerBar = 1;
-    if (beatsPerBar > 99)
-        beatsPerBar = 99;
-    if (beatDivisor < 0)
-        beatDivisor = 0;
-    if (beatDivisor > BeatType::SixteenthNote)
-        beatDivisor = BeatType::SixteenthNote;
-    nextBeatsPerBar.set (beatsPerBar);
-    nextBeatDivisor.set (beatDivisor);
+    Command command;
+    command.type = Command::meter;
+    command.beatsPerBar = jlimit (1, 99, beatsPerBar);
+    command.beatDivisor = jlimit (0, (int) BeatType::SixteenthNote, beatDivisor);
+    command.offset = offset;
+    return push (command);
 }
 
-void Transport::requestAudioFrame (const int64_t frame)
+bool Transport::requestAudioFrame (int64_t frame, int64_t offset)
 {
-    seekFrame.set (frame);
-    seekWanted.set (true);
+    Command command;
+    command.type = Command::locate;
+    command.frame = frame;
+    command.offset = offset;
+    return push (command);
 }
 
 } // namespace element
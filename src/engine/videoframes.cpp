@@ -0,0 +1,159 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "engine/threadpolicy.hpp"
+#include "engine/videoframes.hpp"
+
+using namespace juce;
+
+namespace element {
+
+//==============================================================================
+bool ImageSequence::open (const File& location)
+{
+    folder = location.isDirectory() ? location : location.getParentDirectory();
+    files = folder.findChildFiles (File::findFiles, false, "*.png;*.jpg;*.jpeg");
+    files.sort();
+    return ! files.isEmpty();
+}
+
+int ImageSequence::getFrameAt (double seconds) const noexcept
+{
+    if (files.isEmpty())
+        return -1;
+    return jlimit (0, files.size() - 1, (int) std::floor (seconds * frameRate));
+}
+
+Image ImageSequence::decode (int frame) const
+{
+    if (! isPositiveAndBelow (frame, files.size()))
+        return {};
+    return ImageFileFormat::loadFrom (files.getReference (frame));
+}
+
+//==============================================================================
+VideoFramePipeline::VideoFramePipeline()
+    : Thread ("video frames") {}
+
+VideoFramePipeline::~VideoFramePipeline()
+{
+    stop();
+}
+
+bool VideoFramePipeline::open (const File& location, double rate)
+{
+    stop();
+    const bool opened = sequence.open (location);
+    sequence.setFrameRate (rate);
+    frameRate.store (sequence.getFrameRate());
+    numFrames.store (sequence.getNumFrames());
+    if (opened)
+        start();
+    return opened;
+}
+
+void VideoFramePipeline::close()
+{
+    stop();
+    numFrames.store (0);
+}
+
+void VideoFramePipeline::setDisplaySize (int width, int height)
+{
+    const int size = (jlimit (0, 0xffff, width) << 16) | jlimit (0, 0xffff, height);
+    if (displaySize.exchange (size) != size)
+        sem.post();
+}
+
+void VideoFramePipeline::setPosition (double seconds) noexcept
+{
+    const int count = numFrames.load (std::memory_order_relaxed);
+    if (count <= 0)
+        return;
+
+    // same as ImageSequence::getFrameAt(), without touching its files.
+    const int frame = jlimit (0, count - 1, (int) std::floor (seconds * frameRate.load (std::memory_order_relaxed)));
+    if (wantedFrame.exchange (frame, std::memory_order_relaxed) != frame)
+        sem.post();
+}
+
+void VideoFramePipeline::start()
+{
+    shownFrame = shownSize = nextFrame = -1;
+    next = {};
+    ThreadPolicy::prepareBackground (*this);
+    startThread();
+
+    // show something before the transport moves.
+    if (wantedFrame.load() < 0)
+        wantedFrame.store (0);
+    sem.post();
+}
+
+void VideoFramePipeline::stop()
+{
+    signalThreadShouldExit();
+    sem.post();
+    stopThread (1000);
+    while (sem.tryWait())
+        continue;
+    wantedFrame.store (-1);
+}
+
+void VideoFramePipeline::run()
+{
+    while (! threadShouldExit())
+    {
+        sem.wait();
+        while (sem.tryWait())
+            continue;
+        if (threadShouldExit())
+            break;
+
+        const int frame = wantedFrame.load();
+        const int size = displaySize.load();
+        if (frame < 0 || (frame == shownFrame && size == shownSize))
+            continue;
+
+        Image source;
+        if (frame == nextFrame && next.isValid())
+        {
+            source = next;
+            prefetched.fetch_add (1);
+        }
+        else
+        {
+            source = sequence.decode (frame);
+        }
+
+        // scaled here so the message thread only has to blit it.
+        const int width = size >> 16, height = size & 0xffff;
+        auto& dest = mailbox.getWriteFrame();
+        if (width <= 0 || height <= 0 || ! source.isValid())
+        {
+            dest = source;
+        }
+        else
+        {
+            if (! dest.isValid() || dest.getWidth() != width || dest.getHeight() != height)
+                dest = Image (Image::ARGB, width, height, false, SoftwareImageType());
+            Graphics g (dest);
+            g.fillAll (Colours::black);
+            g.drawImageWithin (source, 0, 0, width, height, RectanglePlacement::centred);
+        }
+        mailbox.publish();
+
+        const bool moved = frame != shownFrame;
+        shownFrame = frame;
+        shownSize = size;
+
+        // playback moves forward, so get the next frame ready while idle.
+        if (moved)
+        {
+            nextFrame = frame + 1 < sequence.getNumFrames() ? frame + 1 : -1;
+            next = nextFrame >= 0 ? sequence.decode (nextFrame) : Image();
+        }
+    }
+}
+
+} // namespace element
@@ -0,0 +1,108 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+#include <element/juce/graphics.hpp>
+
+#include "engine/framemailbox.hpp"
+#include "semaphore.hpp"
+
+namespace element {
+
+/** Hands decoded images from the decoder to the display. */
+using VideoFrameMailbox = FrameMailbox<juce::Image>;
+
+//==============================================================================
+/** A folder of numbered still images played at a fixed frame rate. */
+class ImageSequence final
+{
+public:
+    /** Open a folder, or the folder a file is in. Frames are its PNG and
+        JPEG files sorted by name. Returns false if there are none.
+     */
+    bool open (const juce::File& location);
+
+    const juce::File& getFolder() const noexcept { return folder; }
+    int getNumFrames() const noexcept { return files.size(); }
+
+    double getFrameRate() const noexcept { return frameRate; }
+    void setFrameRate (double newRate) noexcept { frameRate = juce::jlimit (1.0, 120.0, newRate); }
+
+    /** Returns the frame shown at a time in seconds, held on the first and
+        last frames outside the clip.
+     */
+    int getFrameAt (double seconds) const noexcept;
+
+    /** Load a frame. Returns an invalid image if it can't be read. */
+    juce::Image decode (int frame) const;
+
+private:
+    juce::File folder;
+    juce::Array<juce::File> files;
+    double frameRate = 25.0;
+};
+
+//==============================================================================
+/** Decodes video frames for the transport position on a thread of its own.
+
+    The audio thread reports the position and wakes the decoder only when
+    the frame changes. Frames are decoded, scaled to the display and
+    published off the message thread, which just takes the newest one and
+    draws it. The frame after the current one is decoded ahead while the
+    decoder is otherwise idle.
+ */
+class VideoFramePipeline final : private juce::Thread
+{
+public:
+    VideoFramePipeline();
+    ~VideoFramePipeline() override;
+
+    /** Play a folder of images. Message thread. */
+    bool open (const juce::File& location, double frameRate);
+    void close();
+
+    const juce::File& getFolder() const noexcept { return sequence.getFolder(); }
+    double getFrameRate() const noexcept { return sequence.getFrameRate(); }
+    int getNumFrames() const noexcept { return sequence.getNumFrames(); }
+
+    /** Change the size frames are scaled to. Message thread. */
+    void setDisplaySize (int width, int height);
+
+    /** Report the transport position. Realtime safe. */
+    void setPosition (double seconds) noexcept;
+
+    /** Returns the newest frame if it changed since the last call. Message thread. */
+    const juce::Image* takeFrame() noexcept { return mailbox.take(); }
+    const juce::Image& getFrame() const noexcept { return mailbox.getReadFrame(); }
+
+    /** Returns the number of frames that were ready ahead of time. */
+    juce::int64 getNumPrefetched() const noexcept { return prefetched.load(); }
+
+private:
+    ImageSequence sequence;
+    VideoFrameMailbox mailbox;
+    Semaphore sem;
+
+    std::atomic<double> frameRate { 25.0 };
+    std::atomic<int> numFrames { 0 };
+    std::atomic<int> wantedFrame { -1 };
+    std::atomic<int> displaySize { 0 };
+    std::atomic<juce::int64> prefetched { 0 };
+
+    // decoder thread
+    int shownFrame = -1, shownSize = 0;
+    int nextFrame = -1;
+    juce::Image next;
+
+    void start();
+    void stop();
+    void run() override;
+
+    JUCE_DECLARE_NON_COPYABLE (VideoFramePipeline)
+};
+
+} // namespace element
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "appinfo.hpp"
+#include "logstore.hpp"
 #include <element/datapath.hpp>
 
 namespace element {
@@ -52,14 +53,15 @@ public:
     /** Returns a copy of the message history */
     StringArray getHistory() const
     {
-        ScopedLock sl (lock);
-        return history;
+        StringArray lines;
+        for (int i = 0; i < history.size(); ++i)
+            lines.add (history[i]);
+        return lines;
     }
 
     /** Flush message history */
     void flushHistory()
     {
-        ScopedLock sl (lock);
         history.clear();
     }
 
@@ -72,8 +74,6 @@ public:
         ScopedLock sl (lock);
         mainlogger->logMessage (message);
         history.add (message);
-        if (history.size() > maxLines)
-            history.remove (0);
 
         listeners.call ([&message] (Listener& l) {
             l.messageLogged (message);
@@ -83,8 +83,7 @@ public:
 private:
     CriticalSection lock;
     std::unique_ptr<FileLogger> mainlogger;
-    StringArray history;
-    int maxLines = 1024;
+    LogStore history { 1024 };
     ListenerList<Listener> listeners;
 };
 
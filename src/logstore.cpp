@@ -0,0 +1,81 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cstring>
+
+#include "logstore.hpp"
+
+using namespace juce;
+
+namespace element {
+
+// sequence is odd while written, and twice the line number plus two once done.
+struct LogStore::Slot
+{
+    std::atomic<uint64> sequence { 0 };
+    int numBytes = 0;
+    char text[maxLineBytes];
+};
+
+LogStore::LogStore (int cap)
+    : capacity (jmax (1, cap)),
+      slots (new Slot[(size_t) jmax (1, cap)])
+{
+}
+
+LogStore::~LogStore() = default;
+
+void LogStore::add (const String& line) noexcept
+{
+    const auto number = head.fetch_add (1, std::memory_order_acq_rel);
+    auto& slot = slots[(size_t) (number % (uint64) capacity)];
+
+    slot.sequence.store (number * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    const auto utf8 = line.toRawUTF8();
+    const auto length = std::strlen (utf8);
+    auto numBytes = (int) jmin ((size_t) maxLineBytes, length);
+    // don't cut a character in half.
+    while (numBytes > 0 && (size_t) numBytes < length && (utf8[numBytes] & 0xc0) == 0x80)
+        --numBytes;
+    std::memcpy (slot.text, utf8, (size_t) numBytes);
+    slot.numBytes = numBytes;
+
+    slot.sequence.store (number * 2 + 2, std::memory_order_release);
+}
+
+void LogStore::clear() noexcept
+{
+    start.store (head.load (std::memory_order_acquire), std::memory_order_release);
+}
+
+uint64 LogStore::getStart() const noexcept
+{
+    const auto end = getEnd();
+    const auto first = end > (uint64) capacity ? end - (uint64) capacity : 0;
+    return jmax (first, start.load (std::memory_order_acquire));
+}
+
+String LogStore::get (uint64 number) const
+{
+    if (number < getStart() || number >= getEnd())
+        return {};
+
+    const auto& slot = slots[(size_t) (number % (uint64) capacity)];
+    const auto expected = number * 2 + 2;
+    if (slot.sequence.load (std::memory_order_acquire) != expected)
+        return {};
+
+    char text[maxLineBytes];
+    const int numBytes = jlimit (0, maxLineBytes, slot.numBytes);
+    std::memcpy (text, slot.text, (size_t) numBytes);
+
+    std::atomic_thread_fence (std::memory_order_acquire);
+    if (slot.sequence.load (std::memory_order_relaxed) != expected)
+        return {};
+
+    return String::fromUTF8 (text, numBytes);
+}
+
+} // namespace element
@@ -0,0 +1,60 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** The last lines of a log, in a fixed amount of memory.
+
+    Any thread can add lines without locking or allocating, the newest
+    line overwrites the oldest once full. Lines are numbered from the
+    first ever added, so a reader can keep its place and pick up only
+    what's new. A line overwritten while being read reads as empty.
+ */
+class LogStore final
+{
+public:
+    static constexpr int maxLineBytes = 256; ///< longer lines are cut short
+
+    explicit LogStore (int capacity = 1024);
+    ~LogStore();
+
+    /** Adds a line. Any thread. */
+    void add (const juce::String& line) noexcept;
+
+    /** Forgets every line added so far. */
+    void clear() noexcept;
+
+    int getCapacity() const noexcept { return capacity; }
+
+    /** Returns the number of the next line to be added. */
+    juce::uint64 getEnd() const noexcept { return head.load (std::memory_order_acquire); }
+
+    /** Returns the number of the oldest line still stored. */
+    juce::uint64 getStart() const noexcept;
+
+    /** Returns the number of lines stored. */
+    int size() const noexcept { return (int) (getEnd() - getStart()); }
+
+    /** Returns a line by its number. */
+    juce::String get (juce::uint64 number) const;
+
+    /** Returns a stored line by position, 0 being the oldest. */
+    juce::String operator[] (int index) const { return get (getStart() + (juce::uint64) index); }
+
+private:
+    struct Slot;
+    const int capacity;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<juce::uint64> head { 0 }, start { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (LogStore)
+};
+
+} // namespace element
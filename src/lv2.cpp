@@ -681,6 +681,14 @@ public:
             return;
         }
 
+        // the plugin is restoring state and can't run meanwhile.
+        const SpinLock::ScopedTryLockType restoring (module->getRestoreLock());
+        if (! restoring.isLocked())
+        {
+            renderBypassed (rc);
+            return;
+        }
+
         if (auto const atomIn = wantsMidiMessages ? rc.atom.writeBuffer (0) : nullptr)
         {
             writeTimeInfoToPort (*atomIn);
@@ -749,14 +757,14 @@ public:
     //==============================================================================
     void getState (MemoryBlock& mb) override
     {
-        const auto state = module->getStateString();
-        mb.append (state.toRawUTF8(), state.length());
+        MemoryOutputStream stream (mb, true);
+        module->writeState (stream);
     }
 
     void setState (const void* data, int size) override
     {
-        MemoryInputStream stream (data, (size_t) size, false);
-        module->setStateString (stream.readEntireStreamAsString());
+        if (size > 0)
+            module->restoreState (data, (size_t) size);
     }
 
     //==============================================================================
@@ -883,7 +891,6 @@ struct ViewSizeListener : private ComponentMovementWatcher
 extern bool getNativeWindowSize (void* window, int& width, int& height);
 
 class LV2NativeEditor : public Editor,
-                        public juce::Timer,
                         public PhysicalResizeListener
 {
 public:
@@ -915,7 +922,6 @@ public:
         }
 
         setSize (w > 0 ? w : 640, h > 0 ? h : 360);
-        startTimerHz (60);
 
         setResizable (ui->haveClientResize());
 
@@ -928,7 +934,8 @@ public:
     ~LV2NativeEditor()
     {
         nativeViewSetup = false;
-        stopTimer();
+        vblank.reset();
+        plugin.getModule().setExternalRefresh (false);
 
         view->prepareForDestruction();
         view.reset();
@@ -944,16 +951,28 @@ public:
     {
     }
 
-    void timerCallback() override
+    void parentHierarchyChanged() override
+    {
+        // vblanks only come while on screen, the module's timer fills in otherwise.
+        plugin.getModule().setExternalRefresh (getPeer() != nullptr);
+    }
+
+    /** Port events and UI idle go out together, once per display refresh. */
+    void refresh()
     {
         if (! nativeViewSetup || ! ui || ! ui->isNative())
-            return stopTimer();
+            return;
+
+        plugin.getModule().deliverPortEvents();
+
+        if (idleStopped)
+            return;
 
         if (ui->haveIdleInterface())
         {
             if (ui->idle() != 0)
             {
-                stopTimer();
+                idleStopped = true;
             }
             else
             {
@@ -968,7 +987,7 @@ public:
         }
         else
         {
-            stopTimer();
+            idleStopped = true;
         }
     }
 
@@ -984,9 +1003,11 @@ public:
     }
 
 private:
-    [[maybe_unused]] LV2Processor& plugin;
+    LV2Processor& plugin;
     LV2ModuleUI::Ptr ui = nullptr;
     bool nativeViewSetup = false;
+    bool idleStopped = false;
+    std::unique_ptr<VBlankAttachment> vblank { std::make_unique<VBlankAttachment> (this, [this] { refresh(); }) };
 
 #if JUCE_LINUX || JUCE_BSD
     struct InnerHolder
@@ -1143,7 +1164,7 @@ public:
           _symbols (&s),
           provider (p)
     {
-        world = std::make_unique<World> (*_symbols);
+        world = std::make_shared<World> (*_symbols);
     }
 
     LV2 (LV2NodeProvider& p)
@@ -1151,7 +1172,14 @@ public:
           _symbols (new SymbolMap()),
           provider (p)
     {
-        world = std::make_unique<World> (*_symbols);
+        world = std::make_shared<World> (*_symbols);
+    }
+
+    LV2 (LV2NodeProvider& p, std::shared_ptr<World> w)
+        : provider (p),
+          world (std::move (w))
+    {
+        jassert (world != nullptr);
     }
 
     ~LV2()
@@ -1199,7 +1227,7 @@ private:
     bool _symowned = false;
     SymbolMap* _symbols { nullptr };
     [[maybe_unused]] LV2NodeProvider& provider;
-    std::unique_ptr<World> world;
+    std::shared_ptr<World> world;
 };
 
 LV2NodeProvider::LV2NodeProvider (SymbolMap& s)
@@ -1212,6 +1240,11 @@ LV2NodeProvider::LV2NodeProvider()
     lv2 = std::make_unique<LV2> (*this);
 }
 
+LV2NodeProvider::LV2NodeProvider (std::shared_ptr<World> world)
+{
+    lv2 = std::make_unique<LV2> (*this, std::move (world));
+}
+
 LV2NodeProvider::~LV2NodeProvider()
 {
     lv2.reset();
@@ -1229,6 +1262,8 @@ StringArray LV2NodeProvider::findTypes()
     return types;
 }
 
+std::shared_ptr<World> LV2NodeProvider::getWorld() const noexcept { return lv2->world; }
+
 String LV2NodeProvider::nameForURI (const String& uri) const noexcept
 {
     auto plugin = lv2->world->getPlugin (uri);
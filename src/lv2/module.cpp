@@ -14,6 +14,7 @@
 #include <element/processor.hpp>
 
 #include "engine/portbuffer.hpp"
+#include "ringbuffer.hpp"
 
 #include "lv2/messages.hpp"
 #include "lv2/module.hpp"
@@ -21,6 +22,10 @@
 
 #define TRACE_UI 0
 
+#ifndef LV2_STATE__threadSafeRestore
+#define LV2_STATE__threadSafeRestore LV2_STATE_PREFIX "threadSafeRestore"
+#endif
+
 namespace element {
 namespace detail {
 
@@ -194,7 +199,7 @@ public:
 
             auto* const buffer = buffers.getUnchecked (port->index);
 
-            if (ui)
+            if (ui && forwardsToUI ((uint32) port->index))
             {
                 ui->portEvent ((uint32_t) port->index, sizeof (float), 0, buffer->getPortData());
             }
@@ -278,17 +283,110 @@ private:
 
     HeapBlock<float> mins, maxes, defaults, current;
     OwnedArray<PortBuffer> buffers;
+    HeapBlock<void*> connected; ///< what each port was last connected to
 
     std::vector<LV2PatchInfo> patchParams;
     uint32_t atomControlInIndex { EL_INVALID_PORT };
     uint32_t atomControlOutIndex { EL_INVALID_PORT };
 
+    // Port events are framed ring messages of a MessageHeader and the data.
+    static constexpr int eventsSize = EL_LV2_RING_BUFFER_SIZE * 4;
     // UI -> Plugin
-    lvtk::Messages<lvtk::MessageHeader, lvtk::RealtimeReadTrait> eventsIn;
+    RingBuffer eventsIn { eventsSize };
+    SpinLock eventsInLock; ///< held by non-realtime writers
+    HeapBlock<uint8> eventsInScratch { eventsSize };
     // Plugin -> UI
-    lvtk::Messages<lvtk::MessageHeader, lvtk::RealtimeWriteTrait> eventsOut;
+    RingBuffer eventsOut { eventsSize };
+    HeapBlock<uint8> eventsOutScratch { eventsSize };
+
+    // Control outputs are coalesced to the latest value per port between
+    // deliveries. notifyPorts lists the pending ones in arrival order.
+    HeapBlock<float> notifyValues;
+    HeapBlock<bool> notifyPending;
+    Array<uint32> notifyPorts;
+
+    // Ports the UI asked for with ui:portSubscribe. Until it subscribes to
+    // something, everything is forwarded.
+    HeapBlock<bool> subscribed;
+    bool filterSubscribed = false;
+    bool externalRefresh = false;
+
+    void queueNotify (uint32 port, float value) noexcept
+    {
+        notifyValues[port] = value;
+        if (! notifyPending[port])
+        {
+            notifyPending[port] = true;
+            notifyPorts.add (port);
+        }
+    }
+
+    bool forwardsToUI (uint32 port) const noexcept
+    {
+        return ! filterSubscribed || subscribed[port];
+    }
+
+    static bool pushEvent (RingBuffer& ring, uint32 port, uint32 protocol, uint32 size, const void* data) noexcept
+    {
+        const lvtk::MessageHeader header = { port, protocol };
+        RingBuffer::Span span;
+        if (! ring.prepareMessage ((uint32) sizeof (header) + size, span))
+            return false;
+
+        span.copyFrom (&header, 0, sizeof (header));
+        span.copyFrom (data, sizeof (header), size);
+        ring.commitMessage (span.size());
+        return true;
+    }
+
+    /** Call fn for each port event ready in the ring. Event data is passed
+        in place unless it wraps, then it goes through scratch. */
+    template <typename Fn>
+    static void readEvents (RingBuffer& ring, HeapBlock<uint8>& scratch, Fn&& fn)
+    {
+        // only what's there now, a busy writer can't keep the reader here.
+        uint32 remaining = ring.getReadSpace();
+        RingBuffer::Span span;
+
+        while (ring.peekMessage (span) && RingBuffer::getMessageSpace (span.size()) <= remaining)
+        {
+            remaining -= RingBuffer::getMessageSpace (span.size());
+            if (span.size() >= sizeof (lvtk::MessageHeader))
+            {
+                lvtk::MessageHeader header;
+                span.copyTo (&header, 0, sizeof (header));
+
+                const auto body = span.slice (sizeof (header), span.size() - sizeof (header));
+                const void* data = body.data1;
+                if (! body.isContiguous())
+                {
+                    body.copyTo (scratch.getData(), 0, body.size());
+                    data = scratch.getData();
+                }
+
+                fn (header, body.size(), data);
+            }
+
+            ring.finishMessage (span);
+        }
+    }
 
     bool wantsTime = false;
+    bool threadSafeRestore = false;
+    SpinLock restoreLock;
+
+    /** Features for state save and restore, terminated. The worker lets a
+        plugin move heavy restore work off the calling thread. */
+    Array<const LV2_Feature*> getStateFeatures() const
+    {
+        Array<const LV2_Feature*> feats;
+        owner.world.getFeatures (feats);
+        if (owner.worker != nullptr)
+            feats.add (owner.worker->getFeature());
+        feats.add (nullptr);
+        return feats;
+    }
+
     const uint32_t atom_eventTransfer = [&] { return owner.map (LV2_ATOM__eventTransfer); }();
     const uint32_t atom_atomTransfer = [&] { return owner.map (LV2_ATOM__atomTransfer); }();
     const uint32_t ui_floatProtocol = [&] { return owner.map (LV2_UI__floatProtocol); }();
@@ -319,6 +417,11 @@ void LV2Module::init()
     priv->maxes.allocate (numPorts, true);
     priv->defaults.allocate (numPorts, true);
     priv->current.allocate (numPorts, true);
+    priv->connected.allocate (numPorts, true);
+    priv->notifyValues.allocate (numPorts, true);
+    priv->notifyPending.allocate (numPorts, true);
+    priv->notifyPorts.ensureStorageAllocated ((int) numPorts);
+    priv->subscribed.allocate (numPorts, true);
 
     lilv_plugin_get_port_ranges_float (plugin, priv->mins, priv->maxes, priv->defaults);
 
@@ -425,6 +528,11 @@ void LV2Module::init()
 
     priv->patchParams = detail::getPatchWritables (*this, world, plugin);
 
+    {
+        auto threadSafeRestore = world.makeURI (LV2_STATE__threadSafeRestore);
+        priv->threadSafeRestore = lilv_plugin_has_feature (plugin, threadSafeRestore);
+    }
+
     priv->atomControlInIndex = getAtomControlIndex();
     if (priv->atomControlInIndex == EL_INVALID_PORT)
         priv->atomControlInIndex = getMidiPort (true);
@@ -448,8 +556,8 @@ void LV2Module::loadDefaultState()
     {
         if (auto* state = lilv_state_new_from_world (world.getWorld(), map, uriNode))
         {
-            const LV2_Feature* const features[] = { nullptr };
-            lilv_state_restore (state, instance, Private::setPortValue, priv.get(), LV2_STATE_IS_POD, features);
+            const auto features = priv->getStateFeatures();
+            lilv_state_restore (state, instance, Private::setPortValue, priv.get(), LV2_STATE_IS_POD, features.getRawDataPointer());
             lilv_state_free (state);
             priv->sendControlValues();
         }
@@ -460,46 +568,81 @@ void LV2Module::loadDefaultState()
 
 String LV2Module::getStateString() const
 {
-    if (instance == nullptr)
+    MemoryOutputStream stream;
+    if (! writeState (stream))
         return String();
+    return stream.toUTF8();
+}
+
+void LV2Module::setStateString (const String& stateStr)
+{
+    restoreState (stateStr.toRawUTF8(), stateStr.getNumBytesAsUTF8());
+}
+
+bool LV2Module::writeState (OutputStream& stream) const
+{
+    if (instance == nullptr)
+        return false;
 
     auto* const map = (LV2_URID_Map*) world.getFeatures().getFeature (LV2_URID__map)->getFeature()->data;
     auto* const unmap = (LV2_URID_Unmap*) world.getFeatures().getFeature (LV2_URID__unmap)->getFeature()->data;
     const String descURI = "http://kushview.net/kv/state";
+    const auto features = priv->getStateFeatures();
 
-    String result;
-    const LV2_Feature* const features[] = { nullptr };
+    // state:save may run alongside run(), no need for the restore lock.
+    auto* const state = lilv_state_new_from_instance (plugin, instance, map, 0, 0, 0, 0, Private::getPortValue, priv.get(),
+                                                      LV2_STATE_IS_POD, // flags
+                                                      features.getRawDataPointer());
+    if (state == nullptr)
+        return false;
 
-    if (auto* state = lilv_state_new_from_instance (plugin, instance, map, 0, 0, 0, 0, Private::getPortValue, priv.get(),
-                                                    LV2_STATE_IS_POD, // flags
-                                                    features))
+    bool written = false;
+    if (char* strState = lilv_state_to_string (world.getWorld(), map, unmap, state, descURI.toRawUTF8(), 0))
     {
-        char* strState = lilv_state_to_string (world.getWorld(), map, unmap, state, descURI.toRawUTF8(), 0);
-        result = String::fromUTF8 (strState);
+        written = stream.write (strState, std::strlen (strState));
         std::free (strState);
-
-        lilv_state_free (state);
     }
 
-    return result;
+    lilv_state_free (state);
+    return written;
 }
 
-void LV2Module::setStateString (const String& stateStr)
+bool LV2Module::restoreState (const void* data, size_t size)
 {
-    if (instance == nullptr)
-        return;
-    auto* const map = (LV2_URID_Map*) world.getFeatures().getFeature (LV2_URID__map)->getFeature()->data;
-    auto* const unmap = (LV2_URID_Unmap*) world.getFeatures().getFeature (LV2_URID__unmap)->getFeature()->data;
-    lvtk::ignore (unmap);
-    if (auto* state = lilv_state_new_from_string (world.getWorld(), map, stateStr.toRawUTF8()))
+    if (instance == nullptr || data == nullptr || size == 0)
+        return false;
+
+    // lilv wants a terminated string, only copy when it isn't one.
+    const char* text = static_cast<const char*> (data);
+    HeapBlock<char> terminated;
+    if (text[size - 1] != 0)
     {
-        const LV2_Feature* const features[] = { nullptr };
-        lilv_state_restore (state, instance, Private::setPortValue, priv.get(), LV2_STATE_IS_POD, features);
-        lilv_state_free (state);
-        priv->sendControlValues();
+        terminated.malloc (size + 1);
+        std::memcpy (terminated.get(), text, size);
+        terminated[size] = 0;
+        text = terminated.get();
     }
+
+    auto* const map = (LV2_URID_Map*) world.getFeatures().getFeature (LV2_URID__map)->getFeature()->data;
+    auto* const state = lilv_state_new_from_string (world.getWorld(), map, text);
+    terminated.free();
+    if (state == nullptr)
+        return false;
+
+    const auto features = priv->getStateFeatures();
+    if (! priv->threadSafeRestore)
+        priv->restoreLock.enter();
+    lilv_state_restore (state, instance, Private::setPortValue, priv.get(), LV2_STATE_IS_POD, features.getRawDataPointer());
+    if (! priv->threadSafeRestore)
+        priv->restoreLock.exit();
+
+    lilv_state_free (state);
+    priv->sendControlValues();
+    return true;
 }
 
+const SpinLock& LV2Module::getRestoreLock() const noexcept { return priv->restoreLock; }
+
 Result LV2Module::instantiate (double samplerate)
 {
     freeInstance();
@@ -532,6 +675,9 @@ Result LV2Module::instantiate (double samplerate)
         return Result::fail ("Could not instantiate plugin.");
     }
 
+    // a new instance starts with nothing connected.
+    priv->connected.clear (numPorts);
+
     if (const void* data = getExtensionData (LV2_WORKER__interface))
     {
         if (worker == nullptr)
@@ -547,7 +693,8 @@ Result LV2Module::instantiate (double samplerate)
     }
 
     loadDefaultState();
-    startTimerHz (60);
+    if (! priv->externalRefresh)
+        startTimerHz (60);
     return Result::ok();
 }
 
@@ -624,6 +771,8 @@ void LV2Module::connectChannel (const PortType type, const int32 channel, void*
 
 void LV2Module::connectPort (uint32 port, void* data)
 {
+    if (port < numPorts)
+        priv->connected[port] = data;
     lilv_instance_connect_port (instance, port, data);
 }
 
@@ -920,6 +1069,44 @@ void LV2Module::clearEditor()
         priv->ui = nullptr;
         ui = nullptr;
     }
+
+    // the next UI starts with a clean slate.
+    priv->subscribed.clear (numPorts);
+    priv->filterSubscribed = false;
+}
+
+void LV2Module::setPortSubscribed (uint32 port, bool isSubscribed)
+{
+    if (port >= numPorts)
+        return;
+
+    priv->subscribed[port] = isSubscribed;
+    if (isSubscribed)
+    {
+        priv->filterSubscribed = true;
+        return;
+    }
+
+    priv->filterSubscribed = false;
+    for (uint32 p = 0; p < numPorts && ! priv->filterSubscribed; ++p)
+        priv->filterSubscribed = priv->subscribed[p];
+}
+
+bool LV2Module::isPortSubscribed (uint32 port) const noexcept
+{
+    return port < numPorts && priv->forwardsToUI (port);
+}
+
+void LV2Module::setExternalRefresh (bool shouldBeExternal)
+{
+    if (priv->externalRefresh == shouldBeExternal)
+        return;
+
+    priv->externalRefresh = shouldBeExternal;
+    if (shouldBeExternal)
+        stopTimer();
+    else if (instance != nullptr)
+        startTimerHz (60);
 }
 
 PortBuffer* LV2Module::getPortBuffer (uint32 port) const
@@ -978,16 +1165,45 @@ bool LV2Module::isPortOutput (uint32 index) const
 
 void LV2Module::timerCallback()
 {
-    priv->eventsOut.read_all ([this] (lvtk::MessageHeader header, uint32_t size, const void* data) {
-        if (header.protocol == 0 || header.protocol == priv->atom_eventTransfer)
+    deliverPortEvents();
+}
+
+void LV2Module::deliverPortEvents()
+{
+    Private::readEvents (priv->eventsOut, priv->eventsOutScratch, [this] (lvtk::MessageHeader header, uint32_t size, const void* data) {
+        if (header.portIndex >= numPorts)
+            return;
+
+        if (header.protocol == 0)
         {
+            // meters can change every block, only the latest value matters.
+            if (size == sizeof (float))
+                priv->queueNotify (header.portIndex, juce::readUnaligned<float> (data));
+        }
+        else if (header.protocol == priv->atom_eventTransfer)
+        {
+            // messages are discrete, they go out as they come.
             if (auto ui = priv->ui)
-                ui->portEvent (header.portIndex, size, header.protocol, data);
+                if (priv->forwardsToUI (header.portIndex))
+                    ui->portEvent (header.portIndex, size, header.protocol, data);
             if (onPortNotify)
                 onPortNotify (header.portIndex, size, header.protocol, data);
         }
     });
 
+    auto ui = priv->ui;
+    for (const auto port : priv->notifyPorts)
+    {
+        priv->notifyPending[port] = false;
+        const float* value = priv->notifyValues + port;
+        if (ui != nullptr && priv->forwardsToUI (port))
+            ui->portEvent (port, sizeof (float), 0, value);
+        if (onPortNotify)
+            onPortNotify (port, sizeof (float), 0, value);
+    }
+
+    priv->notifyPorts.clearQuick();
+
 #if 0
     PortEvent ev;
 
@@ -1062,13 +1278,19 @@ void LV2Module::referBuffers (RenderContext& rc)
         else if (buffer->isControl())
             priv->current[i] = buffer->getValue();
 
-        lilv_instance_connect_port (instance, static_cast<uint32_t> (i), buffer->getPortData());
+        // bindings only change when the graph's buffers do.
+        auto* const data = buffer->getPortData();
+        if (priv->connected[i] != data)
+        {
+            priv->connected[i] = data;
+            lilv_instance_connect_port (instance, static_cast<uint32_t> (i), data);
+        }
     }
 }
 
 void LV2Module::processEvents()
 {
-    priv->eventsIn.read_all ([this] (lvtk::MessageHeader header, [[maybe_unused]] uint32_t size, const void* data) {
+    Private::readEvents (priv->eventsIn, priv->eventsInScratch, [this] (lvtk::MessageHeader header, [[maybe_unused]] uint32_t size, const void* data) {
         const int index = static_cast<int> (header.portIndex);
 
         if (header.protocol == 0 || header.protocol == priv->ui_floatProtocol)
@@ -1119,8 +1341,7 @@ void LV2Module::run (uint32 nframes)
         if (buffer->isControl() && priv->current[i] != buffer->getValue())
         {
             priv->current[i] = buffer->getValue();
-            lvtk::MessageHeader header = { static_cast<uint32_t> (i), 0 };
-            priv->eventsOut.push_message (header, sizeof (float), &priv->current[i]);
+            Private::pushEvent (priv->eventsOut, static_cast<uint32_t> (i), 0, sizeof (float), &priv->current[i]);
         }
     }
 
@@ -1130,10 +1351,7 @@ void LV2Module::run (uint32 nframes)
         auto seq = static_cast<LV2_Atom_Sequence*> (out->getPortData());
         LV2_ATOM_SEQUENCE_FOREACH (seq, ev)
         {
-            lvtk::MessageHeader header = { priv->atomControlOutIndex, priv->atom_eventTransfer };
-            priv->eventsOut.push_message (header,
-                                          lv2_atom_total_size (&ev->body),
-                                          &ev->body);
+            Private::pushEvent (priv->eventsOut, priv->atomControlOutIndex, priv->atom_eventTransfer, lv2_atom_total_size (&ev->body), &ev->body);
         }
     }
 }
@@ -1146,8 +1364,8 @@ uint32 LV2Module::map (const String& uri) const
 
 void LV2Module::write (uint32 port, uint32 size, uint32 protocol, const void* buffer)
 {
-    lvtk::MessageHeader header = { port, protocol };
-    priv->eventsIn.push_message (header, size, buffer);
+    const SpinLock::ScopedLockType sl (priv->eventsInLock);
+    Private::pushEvent (priv->eventsIn, port, protocol, size, buffer);
 }
 
 bool LV2Module::wantsTime() const noexcept { return priv->wantsTime; }
@@ -314,6 +314,21 @@ public:
      */
     void setStateString (const String&);
 
+    /** Write the state getStateString() would return to a stream, without
+        building a String on the way. Returns false if there was none. */
+    bool writeState (OutputStream& stream) const;
+
+    /** Restore from UTF-8 state data as written by writeState().
+
+        Unless the plugin supports state:threadSafeRestore this holds the
+        restore lock, so the plugin doesn't run while it restores.
+     */
+    bool restoreState (const void* data, size_t size);
+
+    /** Held while restoring state into a plugin that can't do so while
+        running. Try-lock it on the audio thread around run(). */
+    const SpinLock& getRestoreLock() const noexcept;
+
     //=========================================================================
 
     /** Write some data to a port
@@ -324,6 +339,29 @@ public:
     /** Send port values to listeners now */
     void sendPortEvents();
 
+    /** Deliver port events the plugin sent since the last call. Control
+        outputs are coalesced to their latest value and go out in one batch
+        after any atom messages. Message thread only.
+
+        The module calls this from a 60Hz timer unless setExternalRefresh()
+        hands it to an editor that ticks with the display.
+     */
+    void deliverPortEvents();
+
+    /** Stop the module's own timer and let the caller drive
+        deliverPortEvents(), e.g. from a VBlankAttachment.
+     */
+    void setExternalRefresh (bool shouldBeExternal);
+
+    /** Subscribe or unsubscribe the UI from a port. Once any port is
+        subscribed, only subscribed ports are forwarded to the UI. Listeners
+        set with onPortNotify always see every port.
+     */
+    void setPortSubscribed (uint32 port, bool isSubscribed);
+
+    /** Returns true if events on a port are forwarded to the UI. */
+    bool isPortSubscribed (uint32 port) const noexcept;
+
     /** Returns a mapped LV2_URID */
     uint32 map (const String& uri) const;
 
@@ -616,11 +654,21 @@ private:
 
     static uint32_t portSubscribe (void* controller, uint32_t port_index, uint32_t protocol, const LV2_Feature* const* features)
     {
+        juce::ignoreUnused (protocol, features);
+        auto& plugin = (static_cast<LV2ModuleUI*> (controller))->getPlugin();
+        if (port_index >= plugin.getNumPorts())
+            return 1;
+        plugin.setPortSubscribed (port_index, true);
         return 0;
     }
 
     static uint32_t portUnsubscribe (void* controller, uint32_t port_index, uint32_t protocol, const LV2_Feature* const* features)
     {
+        juce::ignoreUnused (protocol, features);
+        auto& plugin = (static_cast<LV2ModuleUI*> (controller))->getPlugin();
+        if (port_index >= plugin.getNumPorts())
+            return 1;
+        plugin.setPortSubscribed (port_index, false);
         return 0;
     }
 
@@ -1,6 +1,7 @@
 // Copyright 2014-2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include "engine/threadpolicy.hpp"
 #include "lv2/workthread.hpp"
 
 using namespace juce;
@@ -20,9 +21,8 @@ namespace element {
 WorkThread::WorkThread (const String& name, uint32_t bufsize, Thread::Priority priority)
     : Thread (name)
 {
-    nextWorkId = 0;
     bufferSize = (uint32_t) nextPowerOfTwo (bufsize);
-    requests = std::make_unique<RingBuffer> (bufferSize);
+    ThreadPolicy::prepareBackground (*this);
     startThread (priority);
 }
 
@@ -32,35 +32,92 @@ WorkThread::~WorkThread()
     signalThreadShouldExit();
     notify();
     waitForThreadToExit (100);
-    requests = nullptr;
 }
 
 WorkerBase* WorkThread::getWorker (uint32_t workerId) const
 {
-    if (workerId == 0)
+    const auto index = (int) (workerId & slotMask) - 1;
+    if (! isPositiveAndBelow (index, maxWorkers))
         return nullptr;
 
-    for (int i = 0; i < workers.size(); ++i)
-        if (workers.getUnchecked (i)->workId == workerId)
-            return workers.getUnchecked (i);
-
-    return nullptr;
+    auto* const worker = slots[index].worker.load (std::memory_order_acquire);
+    return worker != nullptr && worker->workId == workerId ? worker : nullptr;
 }
 
 void WorkThread::addWorker (WorkerBase* worker)
 {
-    worker->workId = ++nextWorkId;
-    WORKER_LOG (getThreadName() + " registering worker: " + String (worker->workId));
-    workers.addIfNotAlreadyThere (worker);
+    jassert (worker->workId == 0);
+    for (int i = 0; i < maxWorkers; ++i)
+    {
+        auto& slot = slots[i];
+        WorkerBase* expected = nullptr;
+        if (! slot.worker.compare_exchange_strong (expected, worker))
+            continue;
+
+        worker->workId = (++slot.generation << slotBits) | (uint32_t) (i + 1);
+
+        int used = numSlots.load();
+        while (used < i + 1 && ! numSlots.compare_exchange_weak (used, i + 1))
+        {
+        }
+
+        numWorkers.fetch_add (1, std::memory_order_relaxed);
+        WORKER_LOG (getThreadName() + " registering worker: " + String (worker->workId));
+        return;
+    }
+
+    WORKER_LOG (getThreadName() + " has no free worker slots");
+    jassertfalse;
 }
 
 void WorkThread::removeWorker (WorkerBase* worker)
 {
     WORKER_LOG (getThreadName() + " removing worker: " + String (worker->workId));
-    workers.removeFirstMatchingValue (worker);
+    if (getWorker (worker->workId) != worker)
+        return;
+
+    auto& slot = slots[(worker->workId & slotMask) - 1];
+    slot.worker.store (nullptr);
+
+    // the thread checks the slot again after claiming it, once it's idle
+    // here it can't be holding this worker.
+    while (slot.busy.load())
+        Thread::sleep (1);
+
+    numWorkers.fetch_sub (1, std::memory_order_relaxed);
     worker->workId = 0;
 }
 
+WorkerBase* WorkThread::claimNextWorker()
+{
+    const int count = numSlots.load (std::memory_order_acquire);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int index = (nextWorker + i) % count;
+        auto& slot = slots[index];
+        if (slot.worker.load (std::memory_order_relaxed) == nullptr)
+            continue;
+
+        // mark the slot busy before loading the worker for real, removeWorker
+        // clears the pointer first and then waits for busy to drop.
+        slot.busy.store (true);
+        auto* const worker = slot.worker.load();
+        RingBuffer::Span request;
+        if (worker == nullptr || ! worker->requests->peekMessage (request))
+        {
+            slot.busy.store (false);
+            continue;
+        }
+
+        worker->flag.setWorking (true);
+        nextWorker = (index + 1) % count;
+        return worker;
+    }
+
+    return nullptr;
+}
+
 void WorkThread::run()
 {
     HeapBlock<uint8> buffer;
@@ -73,52 +130,38 @@ void WorkThread::run()
         if (doExit || threadShouldExit())
             break;
 
-        while (! validateMessage (*requests))
-            Thread::sleep (6);
-
-        if (doExit || threadShouldExit())
-            break;
-
-        uint32_t size = 0;
-        if (requests->read (&size, sizeof (size)) < sizeof (size))
-        {
-            WORKER_LOG ("error reading request: message size");
-            continue;
-        }
-
-        uint32_t workId;
-        if (requests->read (&workId, sizeof (workId)) < sizeof (workId))
-        {
-            WORKER_LOG ("error reading request: worker id");
-            continue;
-        }
-
-        if (workId == 0)
-            continue;
-
-        if (size > static_cast<uint32_t> (readBufferSize))
+        // serve one request per worker per pass until every ring is drained.
+        while (auto* const worker = claimNextWorker())
         {
-            readBufferSize = nextPowerOfTwo (size);
-            buffer.realloc (readBufferSize);
-        }
-
-        if (requests->read (buffer.getData(), size) < size)
-        {
-            WORKER_LOG ("error reading request: message body");
-            continue;
-        }
+            auto& requests = *worker->requests;
+            RingBuffer::Span request;
+            requests.peekMessage (request);
 
-        {
-            if (WorkerBase* const worker = getWorker (workId))
+            // requests are used in place unless they wrap around the ring.
+            const uint32_t size = request.size();
+            if (request.isContiguous())
             {
-                while (! worker->flag.setWorking (true))
+                worker->processRequest (size, request.data1);
+            }
+            else
+            {
+                if (size > static_cast<uint32_t> (readBufferSize))
                 {
+                    readBufferSize = nextPowerOfTwo (size);
+                    buffer.realloc (readBufferSize);
                 }
+
+                request.copyTo (buffer.getData(), 0, size);
                 worker->processRequest (size, buffer.getData());
-                while (! worker->flag.setWorking (false))
-                {
-                }
             }
+
+            requests.finishMessage (request);
+
+            worker->flag.setWorking (false);
+            slots[(worker->workId & slotMask) - 1].busy.store (false);
+
+            if (threadShouldExit() || doExit)
+                break;
         }
 
         if (threadShouldExit() || doExit)
@@ -131,32 +174,20 @@ void WorkThread::run()
 bool WorkThread::scheduleWork (WorkerBase* worker, uint32_t size, const void* data)
 {
     jassert (size > 0 && worker && worker->workId != 0);
-    if (! requests->canWrite (getRequiredSpace (size)))
+    if (worker->workId == 0)
         return false;
 
-    if (requests->write (&size, sizeof (size)) < sizeof (uint32_t))
-        return false;
-
-    if (requests->write (&worker->workId, sizeof (worker->workId)) < sizeof (worker->workId))
-        return false;
-
-    if (requests->write (data, size) < size)
+    if (! worker->requests->writeMessage (data, size))
         return false;
 
     notify();
     return true;
 }
 
-bool WorkThread::validateMessage (RingBuffer& ring)
-{
-    uint32_t size = 0;
-    ring.peak (&size, sizeof (size));
-    return ring.canRead (getRequiredSpace (size));
-}
-
 WorkerBase::WorkerBase (WorkThread& thread, uint32_t bufsize)
     : owner (thread)
 {
+    requests = std::make_unique<RingBuffer> ((int32) thread.bufferSize);
     bufsize = juce::nextPowerOfTwo (bufsize);
     responses = std::make_unique<RingBuffer> (bufsize);
     response.calloc (bufsize);
@@ -165,12 +196,10 @@ WorkerBase::WorkerBase (WorkThread& thread, uint32_t bufsize)
 
 WorkerBase::~WorkerBase()
 {
-    while (flag.isWorking())
-    {
-        Thread::sleep (100);
-    }
-
+    // waits for a request in progress.
     owner.removeWorker (this);
+
+    requests = nullptr;
     responses = nullptr;
     response.free();
 }
@@ -182,42 +211,34 @@ bool WorkerBase::scheduleWork (uint32_t size, const void* data)
 
 bool WorkerBase::respondToWork (uint32_t size, const void* data)
 {
-    if (! responses->canWrite (sizeof (size) + size))
-        return false;
-
-    if (responses->write (&size, sizeof (size)) < sizeof (size))
-        return false;
-
-    if (responses->write (data, size) < size)
-        return false;
-
-    return true;
+    return responses->writeMessage (data, size);
 }
 
 void WorkerBase::processWorkResponses()
 {
+    // only what's ready now, responses written meanwhile go next cycle.
     uint32_t remaining = responses->getReadSpace();
-    uint32_t size = 0;
+    RingBuffer::Span message;
 
-    while (remaining >= sizeof (uint32_t))
+    while (remaining >= RingBuffer::headerSize && responses->peekMessage (message))
     {
-        /* respond next cycle if response isn't ready */
-        if (! validateMessage (*responses))
-            return;
-
-        responses->read (&size, sizeof (size));
-        responses->read (response.getData(), size);
-        processResponse (size, response.getData());
-        remaining -= (sizeof (uint32_t) + size);
-    }
-}
+        const uint32_t size = message.size();
+        if (RingBuffer::getMessageSpace (size) > remaining)
+            break;
 
-bool WorkerBase::validateMessage (RingBuffer& ring)
-{
-    // the worker only validates message size
-    uint32_t size = 0;
-    ring.peak (&size, sizeof (size));
-    return ring.canRead (size + sizeof (size));
+        if (message.isContiguous())
+        {
+            processResponse (size, message.data1);
+        }
+        else
+        {
+            message.copyTo (response.getData(), 0, size);
+            processResponse (size, response.getData());
+        }
+
+        responses->finishMessage (message);
+        remaining -= RingBuffer::getMessageSpace (size);
+    }
 }
 
 void WorkerBase::setSize (uint32_t newSize)
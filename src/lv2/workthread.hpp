@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
 #include <element/juce/core.hpp>
@@ -15,6 +16,11 @@ class WorkerBase;
 
 /** A worker thread
     Capable of scheduling non-realtime work from a realtime context.
+
+    Each worker has its own request ring, written only by the realtime
+    thread and read only by this one. The thread serves its workers in
+    turn, one request each per pass, so a worker with a long queue can't
+    hold back the others assigned to it.
  */
 class WorkThread : public juce::Thread
 {
@@ -23,15 +29,23 @@ public:
     WorkThread (const juce::String& name, uint32_t bufsize, Priority priority = Priority::normal);
     ~WorkThread();
 
-    inline static uint32_t getRequiredSpace (uint32_t msgSize) { return msgSize + (2 * sizeof (uint32_t)); }
+    inline static uint32_t getRequiredSpace (uint32_t msgSize) { return RingBuffer::getMessageSpace (msgSize); }
+
+    /** Most workers a single thread can serve. */
+    static constexpr int maxWorkers = 255;
+
+    /** Returns the number of workers scheduling on this thread. */
+    int getNumWorkers() const { return numWorkers.load (std::memory_order_relaxed); }
 
 protected:
     friend class WorkerBase;
 
-    /** Register a worker for scheduling. Does not take ownership */
+    /** Register a worker for scheduling. Does not take ownership. Leaves
+        the worker's id at zero if every slot is taken */
     void addWorker (WorkerBase* worker);
 
-    /** Deregister a worker from scheduling. Does not delete the worker */
+    /** Deregister a worker from scheduling. Does not delete the worker, but
+        waits for a request it's processing to finish */
     void removeWorker (WorkerBase* worker);
 
     /** Schedule non-realtime work
@@ -41,16 +55,31 @@ protected:
 private:
     uint32_t bufferSize;
 
+    /** A registry entry. Ids pack the slot index in the low byte and the
+        slot's generation above it, so an id from a removed worker never
+        matches the slot's next occupant. */
+    struct Slot
+    {
+        std::atomic<WorkerBase*> worker { nullptr };
+        std::atomic<bool> busy { false }; ///< held by the thread while claimed
+        uint32_t generation = 0;
+    };
+
+    static constexpr uint32_t slotBits = 8;
+    static constexpr uint32_t slotMask = (1u << slotBits) - 1;
+
+    /** Lock-free, O(1). The worker is only safe to use while its slot is
+        busy or its owner otherwise keeps it alive */
     WorkerBase* getWorker (uint32_t workerId) const;
-    juce::Array<WorkerBase*, juce::CriticalSection> workers;
 
-    uint32_t nextWorkId;
+    Slot slots[maxWorkers];
+    std::atomic<int> numSlots { 0 }; ///< one past the highest slot used
+    std::atomic<int> numWorkers { 0 };
+    int nextWorker = 0; ///< where the next pass starts
     bool doExit = false;
 
-    std::unique_ptr<RingBuffer> requests; ///< requests to process
-
-    /** @internal Validate a ringbuffer for message completeness */
-    bool validateMessage (RingBuffer& ring);
+    /** @internal Claim the next worker with a complete request, or nullptr */
+    WorkerBase* claimNextWorker();
 
     /** @internal The work thread function */
     void run();
@@ -108,14 +137,13 @@ protected:
 
 private:
     WorkThread& owner;
-    uint32_t workId; ///< The thread assigned id for this worker
+    uint32_t workId = 0; ///< The thread assigned id for this worker
     WorkFlag flag; ///< A flag for when work is being processed
 
+    std::unique_ptr<RingBuffer> requests; ///< requests to the work thread
     std::unique_ptr<RingBuffer> responses; ///< responses from work
     juce::HeapBlock<uint8_t> response; ///< buffer to write a response
 
-    bool validateMessage (RingBuffer& ring);
-
     friend class WorkThread;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerBase)
 };
@@ -1,6 +1,9 @@
 // Copyright 2014-2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <algorithm>
+#include <map>
+
 #include <lv2/event/event.h>
 #include <lv2/midi/midi.h>
 #include <lv2/ui/ui.h>
@@ -11,6 +14,9 @@
 #include <lvtk/ext/bufsize.hpp>
 #include <lvtk/ext/state.hpp>
 
+#include <element/datapath.hpp>
+
+#include "engine/threadpolicy.hpp"
 #include "lv2/lv2features.hpp"
 #include "lv2/module.hpp"
 #include "lv2/workerfeature.hpp"
@@ -18,7 +24,8 @@
 #include "lv2/logfeature.hpp"
 
 #ifndef EL_LV2_NUM_WORKERS
-#define EL_LV2_NUM_WORKERS 1
+// zero picks a thread count from the number of cores
+#define EL_LV2_NUM_WORKERS 0
 #endif
 
 namespace element {
@@ -108,6 +115,309 @@ private:
     LV2_Feature feat;
 };
 
+//=============================================================================
+/** Plugin metadata by bundle, saved between runs.
+
+    A bundle's entry is trusted while its modification time matches, the
+    newest of the bundle directory and the Turtle files in it.
+ */
+struct World::Cache
+{
+    struct Plugin
+    {
+        String uri, name;
+        bool supported = false;
+    };
+
+    struct Bundle
+    {
+        int64 mtime = 0;
+        std::vector<Plugin> plugins;
+    };
+
+    CriticalSection lock;
+    std::map<String, Bundle> bundles; ///< by full path
+    StringArray dirs; ///< bundle directories found last time
+    bool upToDate = false;
+
+    static File getFile() { return DataPath::applicationDataDir().getChildFile ("lv2cache.bin"); }
+
+    static int64 getBundleTime (const File& bundle)
+    {
+        auto mtime = bundle.getLastModificationTime().toMilliseconds();
+        for (const auto& entry : RangedDirectoryIterator (bundle, false, "*.ttl", File::findFiles))
+            mtime = jmax (mtime, entry.getModificationTime().toMilliseconds());
+        return mtime;
+    }
+
+    /** The directories lilv searches, plus any bundles were found in before. */
+    StringArray getSearchDirs() const
+    {
+        StringArray paths;
+        const auto env = SystemStats::getEnvironmentVariable ("LV2_PATH", {});
+        if (env.isNotEmpty())
+        {
+#if JUCE_WINDOWS
+            paths.addTokens (env, ";", {});
+#else
+            paths.addTokens (env, ":", {});
+#endif
+        }
+        else
+        {
+            const auto home = File::getSpecialLocation (File::userHomeDirectory);
+#if JUCE_WINDOWS
+            paths.add (File::getSpecialLocation (File::userApplicationDataDirectory).getChildFile ("LV2").getFullPathName());
+            paths.add (File::getSpecialLocation (File::globalApplicationsDirectory).getChildFile ("Common Files/LV2").getFullPathName());
+#else
+            paths.add (home.getChildFile (".lv2").getFullPathName());
+#if JUCE_MAC
+            paths.add (home.getChildFile ("Library/Audio/Plug-Ins/LV2").getFullPathName());
+            paths.add ("/Library/Audio/Plug-Ins/LV2");
+#endif
+            paths.add ("/usr/local/lib/lv2");
+            paths.add ("/usr/lib/lv2");
+#endif
+        }
+
+        paths.addArray (dirs);
+        paths.trim();
+        paths.removeEmptyStrings();
+        paths.removeDuplicates (false);
+        return paths;
+    }
+
+    /** Returns true if every bundle on disk has a current entry. */
+    bool checkBundles() const
+    {
+        size_t numFound = 0;
+        for (const auto& path : getSearchDirs())
+        {
+            for (const auto& entry : RangedDirectoryIterator (File (path), false, "*", File::findDirectories))
+            {
+                const auto bundle = entry.getFile();
+                if (! bundle.getChildFile ("manifest.ttl").existsAsFile())
+                    continue;
+
+                const auto it = bundles.find (bundle.getFullPathName());
+                if (it == bundles.end() || it->second.mtime != getBundleTime (bundle))
+                    return false;
+                ++numFound;
+            }
+        }
+
+        return numFound == bundles.size();
+    }
+
+    void load()
+    {
+        const auto file = getFile();
+        if (! file.existsAsFile())
+            return;
+
+        MemoryMappedFile mapped (file, MemoryMappedFile::readOnly);
+        if (mapped.getData() == nullptr)
+            return;
+
+        const auto tree = ValueTree::readFromData (mapped.getData(), mapped.getSize());
+        if (! tree.hasType ("lv2cache"))
+            return;
+
+        const ScopedLock sl (lock);
+        bundles.clear();
+        dirs.clear();
+        for (const auto& b : tree)
+        {
+            auto& bundle = bundles[b["path"].toString()];
+            bundle.mtime = (int64) b["mtime"];
+            if (! dirs.contains (File (b["path"].toString()).getParentDirectory().getFullPathName()))
+                dirs.add (File (b["path"].toString()).getParentDirectory().getFullPathName());
+
+            for (const auto& p : b)
+                bundle.plugins.push_back ({ p["uri"].toString(), p["name"].toString(), (bool) p["supported"] });
+        }
+
+        upToDate = checkBundles();
+    }
+
+    void save() const
+    {
+        ValueTree tree ("lv2cache");
+        {
+            const ScopedLock sl (lock);
+            for (const auto& [path, bundle] : bundles)
+            {
+                ValueTree b ("bundle");
+                b.setProperty ("path", path, nullptr).setProperty ("mtime", bundle.mtime, nullptr);
+                for (const auto& plugin : bundle.plugins)
+                {
+                    ValueTree p ("plugin");
+                    p.setProperty ("uri", plugin.uri, nullptr)
+                        .setProperty ("name", plugin.name, nullptr)
+                        .setProperty ("supported", plugin.supported, nullptr);
+                    b.appendChild (p, nullptr);
+                }
+                tree.appendChild (b, nullptr);
+            }
+        }
+
+        const auto file = getFile();
+        file.getParentDirectory().createDirectory();
+        const TemporaryFile temp (file);
+        if (auto out = temp.getFile().createOutputStream())
+        {
+            tree.writeToStream (*out);
+            out.reset();
+            temp.overwriteTargetFileWithTemporary();
+        }
+    }
+
+    /** Refresh entries from a loaded world. Only plugins in bundles that
+        changed are queried again. */
+    void update (const World& owner)
+    {
+        std::map<String, Bundle> fresh;
+        auto* const plugins = lilv_world_get_all_plugins (owner.world);
+        LILV_FOREACH (plugins, iter, plugins)
+        {
+            const auto* const plugin = lilv_plugins_get (plugins, iter);
+            char* const bundlePath = lilv_file_uri_parse (lilv_node_as_uri (lilv_plugin_get_bundle_uri (plugin)), nullptr);
+            if (bundlePath == nullptr)
+                continue;
+
+            const File bundleFile (String::fromUTF8 (bundlePath));
+            lilv_free (bundlePath);
+
+            const auto path = bundleFile.getFullPathName();
+            auto& bundle = fresh[path];
+            if (bundle.mtime == 0)
+                bundle.mtime = getBundleTime (bundleFile);
+
+            const auto uri = String::fromUTF8 (lilv_node_as_uri (lilv_plugin_get_uri (plugin)));
+            {
+                const ScopedLock sl (lock);
+                const auto old = bundles.find (path);
+                if (old != bundles.end() && old->second.mtime == bundle.mtime)
+                {
+                    const auto& cached = old->second.plugins;
+                    const auto match = std::find_if (cached.begin(), cached.end(), [&] (const Plugin& p) { return p.uri == uri; });
+                    if (match != cached.end())
+                    {
+                        bundle.plugins.push_back (*match);
+                        continue;
+                    }
+                }
+            }
+
+            auto* const nameNode = lilv_plugin_get_name (plugin);
+            bundle.plugins.push_back ({ uri,
+                                        nameNode != nullptr ? String::fromUTF8 (lilv_node_as_string (nameNode)) : String(),
+                                        owner.isPluginSupported (plugin) });
+            if (nameNode != nullptr)
+                lilv_node_free (nameNode);
+        }
+
+        StringArray newDirs;
+        for (const auto& entry : fresh)
+            newDirs.addIfNotAlreadyThere (File (entry.first).getParentDirectory().getFullPathName());
+
+        // bundles without plugins (specs, presets...) are tracked too, or
+        // the next check would count them as new.
+        StringArray searchDirs;
+        {
+            const ScopedLock sl (lock);
+            searchDirs = getSearchDirs();
+        }
+        for (const auto& path : searchDirs)
+        {
+            for (const auto& entry : RangedDirectoryIterator (File (path), false, "*", File::findDirectories))
+            {
+                const auto bundle = entry.getFile();
+                if (! bundle.getChildFile ("manifest.ttl").existsAsFile())
+                    continue;
+                auto& b = fresh[bundle.getFullPathName()];
+                if (b.mtime == 0)
+                    b.mtime = getBundleTime (bundle);
+            }
+        }
+
+        bool changed;
+        {
+            const ScopedLock sl (lock);
+            changed = ! upToDate;
+            bundles.swap (fresh);
+            dirs = newDirs;
+            upToDate = true;
+        }
+
+        if (changed)
+            save();
+    }
+
+    bool getSupportedPlugins (StringArray& list) const
+    {
+        const ScopedLock sl (lock);
+        if (! upToDate)
+            return false;
+        for (const auto& entry : bundles)
+            for (const auto& plugin : entry.second.plugins)
+                if (plugin.supported)
+                    list.add (plugin.uri);
+        return true;
+    }
+
+    bool getPluginName (const String& uri, String& name) const
+    {
+        const ScopedLock sl (lock);
+        if (! upToDate)
+            return false;
+        for (const auto& entry : bundles)
+        {
+            for (const auto& plugin : entry.second.plugins)
+            {
+                if (plugin.uri == uri)
+                {
+                    name = plugin.name;
+                    return true;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+//=============================================================================
+class World::Loader : public Thread
+{
+public:
+    Loader (World& w)
+        : Thread ("lv2_discovery"), owner (w)
+    {
+        ThreadPolicy::prepareBackground (*this);
+    }
+
+    ~Loader() override { waitForThreadToExit (-1); }
+
+    void run() override
+    {
+        lilv_world_load_all (owner.world);
+        owner.cache->update (owner);
+        loaded.store (true);
+        done.signal();
+    }
+
+    void wait() const
+    {
+        if (! loaded.load())
+            done.wait (-1);
+    }
+
+private:
+    World& owner;
+    std::atomic<bool> loaded { false };
+    WaitableEvent done { true };
+};
+
 //=============================================================================
 World::World (SymbolMap& s)
     : symbolMap (s)
@@ -157,7 +467,6 @@ World::World (SymbolMap& s)
 
     lilv_world_set_option (world, LILV_OPTION_DYN_MANIFEST, trueNode);
 
-    lilv_world_load_all (world);
 #if JLV2_SUIL_INIT
     suil_init (nullptr, nullptr, SUIL_ARG_NONE);
 #endif
@@ -168,7 +477,8 @@ World::World (SymbolMap& s)
     suil_host_set_touch_func (suil, LV2ModuleUI::touch);
 
     currentThread = 0;
-    numThreads = EL_LV2_NUM_WORKERS;
+    numThreads = EL_LV2_NUM_WORKERS > 0 ? EL_LV2_NUM_WORKERS
+                                        : jlimit (1, 4, SystemStats::getNumCpus() / 2);
     for (int i = 0; i < numThreads; ++i)
     {
         threads.add (new WorkThread ("lv2_worker_" + String (i + 1), EL_LV2_RING_BUFFER_SIZE));
@@ -179,10 +489,16 @@ World::World (SymbolMap& s)
     addFeature (new LogFeature(), false);
     addFeature (new OptionsFeature (symbolMap), false);
     addFeature (new BoundedBlockLengthFeature(), true);
+
+    cache = std::make_unique<Cache>();
+    cache->load();
+    loader = std::make_unique<Loader> (*this);
+    loader->startThread (Thread::Priority::low);
 }
 
 World::~World()
 {
+    loader.reset();
     features.clear();
 
 #define _node_free(n) lilv_node_free (const_cast<LilvNode*> (n))
@@ -213,13 +529,21 @@ World::~World()
     suil = nullptr;
 }
 
+void World::waitUntilLoaded() const
+{
+    if (loader != nullptr)
+        loader->wait();
+}
+
 lvtk::Node World::get (const LilvNode* subject, const LilvNode* pred) const noexcept
 {
+    waitUntilLoaded();
     return { lilv_world_get (this->world, subject, pred, nullptr) };
 }
 
 lvtk::Node World::makeURI (const std::string& uriStr) const noexcept
 {
+    waitUntilLoaded();
     return { lilv_new_uri (this->world, uriStr.c_str()) };
 }
 
@@ -256,6 +580,7 @@ void World::fillPluginDescription (const String& uri, PluginDescription& desc) c
 
 const LilvPlugin* World::getPlugin (const String& uri) const
 {
+    waitUntilLoaded();
     LilvNode* p (lilv_new_uri (world, uri.toUTF8()));
     const LilvPlugin* plugin = lilv_plugins_get_by_uri (getAllPlugins(), p);
     lilv_node_free (p);
@@ -265,6 +590,10 @@ const LilvPlugin* World::getPlugin (const String& uri) const
 
 String World::getPluginName (const String& uri) const
 {
+    if (String cached; cache->getPluginName (uri, cached))
+        return cached;
+
+    waitUntilLoaded();
     auto* uriNode = lilv_new_uri (world, uri.toRawUTF8());
     const auto* plugin = lilv_plugins_get_by_uri (
         lilv_world_get_all_plugins (world), uriNode);
@@ -285,6 +614,10 @@ String World::getPluginName (const String& uri) const
 
 void World::getSupportedPlugins (StringArray& list) const
 {
+    if (cache->getSupportedPlugins (list))
+        return;
+
+    waitUntilLoaded();
     const LilvPlugins* plugins (lilv_world_get_all_plugins (world));
     LILV_FOREACH (plugins, iter, plugins)
     {
@@ -297,6 +630,7 @@ void World::getSupportedPlugins (StringArray& list) const
 
 const LilvPlugins* World::getAllPlugins() const
 {
+    waitUntilLoaded();
     return lilv_world_get_all_plugins (world);
 }
 
@@ -307,10 +641,16 @@ WorkThread& World::getWorkThread()
         threads.add (new WorkThread ("LV2 Worker " + String (threads.size()), EL_LV2_RING_BUFFER_SIZE));
     }
 
-    const int threadIndex = currentThread;
-    if (++currentThread >= numThreads)
-        currentThread = 0;
+    // the least busy thread, ties go round robin so idle threads fill evenly.
+    int threadIndex = currentThread;
+    for (int i = 1; i < numThreads; ++i)
+    {
+        const int index = (currentThread + i) % numThreads;
+        if (threads.getUnchecked (index)->getNumWorkers() < threads.getUnchecked (threadIndex)->getNumWorkers())
+            threadIndex = index;
+    }
 
+    currentThread = (threadIndex + 1) % numThreads;
     return *threads.getUnchecked (threadIndex);
 }
 
@@ -23,6 +23,11 @@ class WorkThread;
 
 /** Slim wrapper around LilvWorld.  Publishes commonly used LilvNodes and
     manages heavy weight features (like LV2 Worker)
+
+    Bundles are loaded by lilv on a background thread, anything that needs
+    lilv waits for it. Plugin lists and names come from a metadata cache
+    kept in the application data directory, so they're ready at once
+    unless a bundle changed since the cache was written.
  */
 class World
 {
@@ -93,7 +98,14 @@ public:
     bool isPluginSupported (const LilvPlugin* plugin) const;
 
     /** Return the underlying LilvWorld* pointer */
-    inline LilvWorld* getWorld() const { return world; }
+    inline LilvWorld* getWorld() const
+    {
+        waitUntilLoaded();
+        return world;
+    }
+
+    /** Block until lilv has loaded all bundles. */
+    void waitUntilLoaded() const;
 
     /** Add a supported feature */
     inline void addFeature (LV2Feature* feat, bool rebuild = true) { features.add (feat, rebuild); }
@@ -145,9 +157,14 @@ private:
     SymbolMap& symbolMap;
     LV2FeatureArray features;
 
-    // a simple rotating thread pool
+    // worker threads, new workers go to the least busy one
     int currentThread, numThreads;
     OwnedArray<WorkThread> threads;
+
+    struct Cache;
+    std::unique_ptr<Cache> cache;
+    class Loader;
+    std::unique_ptr<Loader> loader;
 };
 
 } // namespace element
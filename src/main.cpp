@@ -18,12 +18,21 @@
 #include <element/ui/commands.hpp>
 #include "datapath.hpp"
 #include "services/sessionservice.hpp"
+#include "session/pluginbridge.hpp"
 #include "log.hpp"
 #include "messages.hpp"
 #include "utils.hpp"
 
 namespace element {
 
+/** Command line flag to run without a UI, e.g. `element --headless show.els` */
+static const char* headlessFlag = "--headless";
+
+static bool isHeadless (const String& commandLine)
+{
+    return StringArray::fromTokens (commandLine, true).contains (headlessFlag);
+}
+
 class Startup : public ActionBroadcaster
 {
 public:
@@ -57,6 +66,7 @@ private:
     {
         auto& settings = world.settings();
         DeviceManager& devices (world.devices());
+        devices.setAggregateMembers (settings.getAggregateDevices());
         for (const auto& tp : devices.getAvailableDeviceTypes())
             tp->scanForDevices();
 
@@ -104,8 +114,12 @@ private:
 
     void setupKeyMappings()
     {
+        auto* const gui = world.services().find<GuiService>();
+        if (gui == nullptr)
+            return;
+
         auto* const props = world.settings().getUserSettings();
-        auto* const keymp = world.services().find<GuiService>()->commands().getKeyMappings();
+        auto* const keymp = gui->commands().getKeyMappings();
         if (props && keymp)
         {
             std::unique_ptr<XmlElement> xml;
@@ -154,7 +168,9 @@ public:
 
     void initialise (const String& commandLine) override
     {
-        world = std::make_unique<Context> (RunMode::Standalone, commandLine);
+        world = std::make_unique<Context> (isHeadless (commandLine) ? RunMode::Headless
+                                                                    : RunMode::Standalone,
+                                           commandLine);
         if (maybeLaunchScannerWorker (commandLine))
             return;
 
@@ -219,6 +235,15 @@ public:
 
         auto* sc = world->services().find<SessionService>();
 
+        if (world->services().getRunMode() == RunMode::Headless)
+        {
+            // nobody to ask, keep what's on disk up to date.
+            if (sc->getSessionFile().existsAsFile())
+                sc->saveSession (false, false, false);
+            Application::quit();
+            return;
+        }
+
         if (world->settings().askToSaveSession())
         {
             // - 0 if the third button was pressed ('cancel')
@@ -250,22 +275,28 @@ public:
         }
     }
 
+    static File getCommandLineFile (const String& commandLine)
+    {
+        auto args = StringArray::fromTokens (commandLine, true);
+        args.removeString (headlessFlag);
+        const auto path = args.joinIntoString (" ").unquoted().trim();
+        if (path.isEmpty())
+            return {};
+        const File file = File::isAbsolutePath (path)
+                              ? File (path)
+                              : File::getCurrentWorkingDirectory().getChildFile (path);
+        return file.existsAsFile() ? file : File();
+    }
+
     void maybeOpenCommandLineFile (const String& commandLine)
     {
         if (auto* sc = world->services().find<SessionService>())
         {
-            const auto path = commandLine.unquoted().trim();
-            const File sessionFile = File::isAbsolutePath (path)
-                                         ? File (path)
-                                         : File::getCurrentWorkingDirectory().getChildFile (path);
-            if (sessionFile.existsAsFile())
-            {
-                const File file (path);
-                if (file.hasFileExtension ("els"))
-                    sc->openFile (file);
-                else if (file.hasFileExtension ("elg"))
-                    sc->importGraph (file);
-            }
+            const File file (getCommandLineFile (commandLine));
+            if (file.hasFileExtension ("els"))
+                sc->openFile (file);
+            else if (file.hasFileExtension ("elg"))
+                sc->importGraph (file);
         }
     }
 
@@ -295,12 +326,32 @@ public:
 
         startup.reset();
 
+        const auto commandLine = getCommandLineParameters();
+        if (world->services().getRunMode() == RunMode::Headless)
+        {
+            // go straight to the session asked for, instead of loading the
+            // last or default one first.
+            if (getCommandLineFile (commandLine).hasFileExtension ("els"))
+            {
+                world->services().activate();
+                maybeOpenCommandLineFile (commandLine);
+            }
+            else
+            {
+                world->services().run();
+                maybeOpenCommandLineFile (commandLine);
+            }
+
+            Logger::writeToLog ("[element] running headless");
+            return;
+        }
+
         world->services().run();
 
         if (world->settings().checkForUpdates())
             startTimer (5000);
 
-        maybeOpenCommandLineFile (getCommandLineParameters());
+        maybeOpenCommandLineFile (commandLine);
     }
 
 private:
@@ -322,19 +373,17 @@ private:
     {
         workers.clearQuick (true);
         workers.add (world->plugins().createAudioPluginScannerWorker());
-        StringArray processIds = { EL_PLUGIN_SCANNER_PROCESS_ID };
-        for (auto* worker : workers)
+        workers.add (createPluginBridgeWorker());
+        const StringArray processIds = { EL_PLUGIN_SCANNER_PROCESS_ID, EL_PLUGIN_BRIDGE_PROCESS_ID };
+        for (int i = 0; i < workers.size(); ++i)
         {
-            for (const auto& pid : processIds)
+            if (workers[i]->initialiseFromCommandLine (commandLine, processIds[i], 20 * 1000))
             {
-                if (worker->initialiseFromCommandLine (commandLine, pid, 20 * 1000))
-                {
 #if JUCE_MAC
-                    Process::setDockIconVisible (false);
-                    juce::shutdownJuce_GUI();
+                Process::setDockIconVisible (false);
+                juce::shutdownJuce_GUI();
 #endif
-                    return true;
-                }
+                return true;
             }
         }
 
@@ -1,15 +1,32 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <limits>
+
 #include <element/context.hpp>
 #include <element/engine.hpp>
 #include <element/plugins.hpp>
 #include <element/signals.hpp>
 
 #include "messages.hpp"
+#include "session/statepool.hpp"
 
 namespace element {
 
+namespace {
+/** Plugin states held by undo actions, shared between them. */
+StatePool& undoStates()
+{
+    static StatePool pool;
+    return pool;
+}
+
+int clampUnits (int64 bytes) noexcept
+{
+    return (int) jlimit<int64> (1, std::numeric_limits<int>::max(), bytes);
+}
+} // namespace
+
 class AddPluginAction : public UndoableAction
 {
 public:
@@ -17,6 +34,8 @@ public:
         : app (_app), graph (msg.graph), description (msg.description), builder (msg.builder), verified (msg.verified) {}
     ~AddPluginAction() noexcept {}
 
+    int getSizeInUnits() override { return (int) sizeof (*this); }
+
     bool perform() override
     {
         addedNode = Node();
@@ -70,8 +89,19 @@ public:
         node.getRelativePosition (x, y);
         nodeData = node.data().createCopy();
         Node::sanitizeRuntimeProperties (nodeData);
+
+        // the copy refers to shared states, so only a state the history
+        // doesn't hold yet counts against its size.
+        auto& states = undoStates();
+        states.purge();
+        const auto sharedBytes = states.share (nodeData);
+        MemoryOutputStream tree;
+        nodeData.writeToStream (tree);
+        sizeInUnits = clampUnits ((int64) tree.getDataSize() + sharedBytes + arcs.size() * (int64) sizeof (Arc));
     }
 
+    int getSizeInUnits() override { return sizeInUnits; }
+
     bool perform() override
     {
         auto& ec = *app.find<EngineService>();
@@ -103,6 +133,7 @@ private:
     OwnedArray<Arc> arcs;
     double x = 0.5;
     double y = 0.5;
+    int sizeInUnits = 1;
     bool isDataValid() const
     {
         return targetGraph.isGraph() && ! nodeUuid.isNull() && nodeData.isValid();
@@ -127,6 +158,8 @@ public:
         return true;
     }
 
+    int getSizeInUnits() override { return (int) sizeof (*this); }
+
     bool undo() override
     {
         auto& ec = *app.find<EngineService>();
@@ -161,6 +194,8 @@ public:
         return true;
     }
 
+    int getSizeInUnits() override { return (int) sizeof (*this); }
+
     bool undo() override
     {
         auto& ec = *app.find<EngineService>();
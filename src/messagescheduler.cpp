@@ -0,0 +1,142 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+
+#include "messagescheduler.hpp"
+
+using namespace juce;
+
+namespace element {
+
+MessageScheduler::MessageScheduler (double budgetMsPerDispatch)
+    : budgetMs (jmax (0.0, budgetMsPerDispatch))
+{
+}
+
+MessageScheduler::~MessageScheduler()
+{
+    cancelPendingUpdate();
+}
+
+void MessageScheduler::post (const void* key, std::function<void()> work, Priority priority)
+{
+    if (! work)
+        return;
+
+    if (key != nullptr)
+    {
+        for (auto& task : pending)
+        {
+            if (task.key != key)
+                continue;
+            // the newer work replaces the old, but keeps its place in line.
+            task.work = std::move (work);
+            task.priority = jmin (task.priority, priority);
+            ++stats.numCoalesced;
+            triggerAsyncUpdate();
+            return;
+        }
+    }
+
+    pending.push_back ({ key, std::move (work), priority, Time::getMillisecondCounterHiRes(), nextOrder++ });
+    triggerAsyncUpdate();
+}
+
+void MessageScheduler::cancel (const void* key)
+{
+    if (key == nullptr)
+        return;
+    pending.erase (std::remove_if (pending.begin(), pending.end(), [key] (const Task& t) { return t.key == key; }),
+                   pending.end());
+
+    // or still waiting in the batch being dispatched.
+    if (running != nullptr)
+        for (auto& task : *running)
+            if (task.key == key)
+                task.work = nullptr;
+}
+
+bool MessageScheduler::dispatch()
+{
+    if (pending.empty())
+        return true;
+
+    // take what's pending now, work may post more while running.
+    std::vector<Task> batch;
+    batch.swap (pending);
+    std::stable_sort (batch.begin(), batch.end(), [] (const Task& a, const Task& b) {
+        return a.priority != b.priority ? a.priority < b.priority : a.order < b.order;
+    });
+
+    running = &batch;
+    const double start = Time::getMillisecondCounterHiRes();
+    bool ranOther = false;
+    size_t index = 0;
+    for (; index < batch.size(); ++index)
+    {
+        auto& task = batch[index];
+        if (! task.work)
+            continue;
+
+        const double now = Time::getMillisecondCounterHiRes();
+        if (task.priority != high)
+        {
+            // something besides urgent work gets through each time.
+            if (ranOther && now - start >= budgetMs)
+                break;
+            ranOther = true;
+        }
+
+        const double latency = now - task.postedMs;
+        ++stats.numRun;
+        totalLatencyMs += latency;
+        stats.averageLatencyMs = totalLatencyMs / (double) stats.numRun;
+        stats.maxLatencyMs = jmax (stats.maxLatencyMs, latency);
+
+        auto work = std::move (task.work);
+        task.work = nullptr;
+        work();
+    }
+    running = nullptr;
+
+    if (index >= batch.size())
+        return pending.empty();
+
+    ++stats.numDeferred;
+
+    // leftovers go back in front of anything posted meanwhile, unless
+    // that replaced them.
+    for (auto& task : pending)
+    {
+        for (size_t i = index; i < batch.size(); ++i)
+        {
+            if (task.key != nullptr && batch[i].key == task.key)
+            {
+                batch[i].work = std::move (task.work);
+                batch[i].priority = jmin (batch[i].priority, task.priority);
+                task.work = nullptr;
+                ++stats.numCoalesced;
+                break;
+            }
+        }
+    }
+
+    std::vector<Task> next;
+    for (size_t i = index; i < batch.size(); ++i)
+        if (batch[i].work)
+            next.push_back (std::move (batch[i]));
+    for (auto& task : pending)
+        if (task.work)
+            next.push_back (std::move (task));
+    pending.swap (next);
+    return false;
+}
+
+void MessageScheduler::handleAsyncUpdate()
+{
+    if (! dispatch())
+        triggerAsyncUpdate();
+}
+
+} // namespace element
@@ -0,0 +1,79 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <element/juce/events.hpp>
+
+namespace element {
+
+/** Runs UI work on the message thread within a time budget.
+
+    Work posted under a key replaces anything still pending under the same
+    key, so a burst of identical refreshes runs once. Each dispatch runs
+    the most urgent work first and stops when the budget is spent; what's
+    left goes out in the next dispatch, after whatever else the message
+    queue holds, so mouse and paint events get their turn in between.
+ */
+class MessageScheduler final : private juce::AsyncUpdater
+{
+public:
+    enum Priority
+    {
+        high = 0, ///< always runs in the next dispatch
+        normal,
+        low
+    };
+
+    /** Message thread latency of the work that ran since resetStats(). */
+    struct Stats
+    {
+        int numRun = 0;
+        int numCoalesced = 0; ///< posts replaced by a later one under the same key
+        int numDeferred = 0; ///< dispatches that ran out of budget
+        double averageLatencyMs = 0.0; ///< from post to run
+        double maxLatencyMs = 0.0;
+    };
+
+    explicit MessageScheduler (double budgetMsPerDispatch = 8.0);
+    ~MessageScheduler() override;
+
+    /** Queue work for the message thread. A null key never coalesces. Message thread. */
+    void post (const void* key, std::function<void()> work, Priority priority = normal);
+
+    /** Drop pending work under a key, e.g. when its owner goes away. */
+    void cancel (const void* key);
+
+    /** Returns the amount of work waiting. */
+    int getNumPending() const noexcept { return (int) pending.size(); }
+
+    /** Runs pending work now, up to the budget. Returns true if all of it ran. */
+    bool dispatch();
+
+    Stats getStats() const noexcept { return stats; }
+    void resetStats() noexcept { stats = {}; }
+
+private:
+    struct Task
+    {
+        const void* key;
+        std::function<void()> work;
+        Priority priority;
+        double postedMs;
+        juce::uint64 order;
+    };
+
+    const double budgetMs;
+    std::vector<Task> pending;
+    std::vector<Task>* running = nullptr;
+    juce::uint64 nextOrder = 0;
+    Stats stats;
+    double totalLatencyMs = 0.0;
+
+    void handleAsyncUpdate() override;
+};
+
+} // namespace element
@@ -7,6 +7,8 @@
 #include <element/script.hpp>
 
 #include "engine/graphmanager.hpp"
+#include "session/sessionfile.hpp"
+#include "session/sessionprofile.hpp"
 #include "scopedflag.hpp"
 
 namespace element {
@@ -282,21 +284,19 @@ ValueTree Node::resetIds (const ValueTree& data)
 ValueTree Node::parse (const File& file)
 {
     ValueTree sessionData = Session::readFromFile (file);
-    if (sessionData.isValid())
+    if (sessionData.hasType (types::Session))
     {
         const auto graphs = sessionData.getChildWithName (tags::graphs);
-        const auto sessionNode = graphs.getChild (graphs.getProperty (tags::active, 0));
-        return sessionNode.createCopy();
+        auto sessionNode = graphs.getChild (graphs.getProperty (tags::active, 0)).createCopy();
+        SessionFile::resolveStates (sessionNode);
+        return sessionNode;
     }
 
-    ValueTree data;
+    // readFromFile() also reads XML, so graphs and presets are parsed once.
+    ValueTree data (sessionData);
     ValueTree nodeData;
 
-    if (auto e = XmlDocument::parse (file))
-    {
-        data = ValueTree::fromXml (*e);
-    }
-    else
+    if (! data.isValid())
     {
         FileInputStream input (file);
         data = ValueTree::readFromStream (input);
@@ -374,6 +374,7 @@ bool Node::writeToFile (const File& targetFile) const
 {
     ValueTree data = objectData.createCopy();
     sanitizeProperties (data, true);
+    SessionFile::resolveStates (data);
 
 #if EL_SAVE_BINARY_FORMAT
     TemporaryFile tempFile (targetFile);
@@ -496,6 +497,7 @@ void Node::setMissingProperties()
     stabilizeProperty (tags::keyEnd, 127);
     stabilizeProperty (tags::transpose, 0);
     stabilizeProperty (tags::delayCompensation, 0);
+    stabilizeProperty (tags::tailLength, -1.0);
     stabilizeProperty (tags::tempo, (double) 120.0);
     objectData.getOrCreateChildWithName (tags::nodes, nullptr);
     objectData.getOrCreateChildWithName (tags::ports, nullptr);
@@ -835,27 +837,17 @@ void Node::restorePluginState()
             if (shouldSetProgram)
                 proc->setCurrentProgram (wantedProgram);
 
-            auto data = getProperty (tags::state).toString().trim();
-            if (data.isNotEmpty())
+            // states from a session file are decoded here, on first use.
+            MemoryBlock state;
+            if (SessionFile::readState (getProperty (tags::state), state))
             {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
-                {
-                    proc->setStateInformation (state.getData(), (int) state.getSize());
-                }
+                proc->setStateInformation (state.getData(), (int) state.getSize());
             }
 
-            data = getProperty (tags::programState).toString().trim();
-            if (shouldSetProgram && data.isNotEmpty())
+            if (shouldSetProgram && SessionFile::readState (getProperty (tags::programState), state))
             {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
-                {
-                    proc->setCurrentProgramStateInformation (state.getData(),
-                                                             (int) state.getSize());
-                }
+                proc->setCurrentProgramStateInformation (state.getData(),
+                                                         (int) state.getSize());
             }
         }
         else
@@ -865,14 +857,9 @@ void Node::restorePluginState()
             if (shouldSetProgram)
                 obj->setCurrentProgram (wantedProgram);
 
-            auto data = getProperty (tags::state).toString().trim();
-            if (data.isNotEmpty())
-            {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
-                    obj->setState (state.getData(), (int) state.getSize());
-            }
+            MemoryBlock state;
+            if (SessionFile::readState (getProperty (tags::state), state))
+                obj->setState (state.getData(), (int) state.getSize());
         }
 
         if (hasProperty (tags::bypass))
@@ -911,6 +898,8 @@ void Node::restorePluginState()
         if (hasProperty (tags::midiProgramsEnabled))
             obj->setMidiProgramsEnabled ((bool) getProperty (tags::midiProgramsEnabled, true));
         obj->setUseGlobalMidiPrograms ((bool) getProperty (tags::globalMidiPrograms, obj->useGlobalMidiPrograms()));
+        if (obj->areMidiProgramsEnabled() && obj->useGlobalMidiPrograms())
+            obj->prefetchMidiPrograms();
         if (hasProperty (tags::midiProgramsState))
             obj->setMidiProgramsState (getProperty (tags::midiProgramsState).toString().trim());
 
@@ -920,8 +909,10 @@ void Node::restorePluginState()
         if (hasProperty (tags::transpose))
             obj->setTransposeOffset (getProperty (tags::transpose));
 
+        obj->setLinearPhaseOversampling ((bool) getProperty (tags::oversamplingLinearPhase, false));
         obj->setOversamplingFactor (jmax (1, (int) getProperty (tags::oversamplingFactor, 1)));
         obj->setDelayCompensation (getProperty (tags::delayCompensation, 0.0));
+        obj->setTailLength (getProperty (tags::tailLength, -1.0));
     }
 
     // this was originally here to help reduce memory usage
@@ -943,6 +934,7 @@ void Node::savePluginState()
     ProcessorPtr obj = getObject();
     if (obj && obj->isPrepared)
     {
+        SessionProfile::Timer timer (SessionProfile::saveStates, getName(), getPluginName());
         MemoryBlock state;
 
         if (auto* proc = obj->getAudioProcessor())
@@ -1011,7 +1003,9 @@ void Node::savePluginState()
         obj->getMidiProgramsState (mps);
         setProperty (tags::midiProgramsState, mps);
         setProperty (tags::oversamplingFactor, obj->getOversamplingFactor());
+        setProperty (tags::oversamplingLinearPhase, obj->isLinearPhaseOversampling());
         setProperty (tags::delayCompensation, obj->getDelayCompensation());
+        setProperty (tags::tailLength, obj->getTailLength());
     }
 
     for (int i = 0; i < getNumNodes(); ++i)
@@ -1272,6 +1266,8 @@ void Node::setUseGlobalMidiPrograms (bool useGlobal)
             return;
         obj->setUseGlobalMidiPrograms (useGlobal);
         setProperty (tags::globalMidiPrograms, obj->useGlobalMidiPrograms());
+        if (obj->areMidiProgramsEnabled() && obj->useGlobalMidiPrograms())
+            obj->prefetchMidiPrograms();
     }
 }
 
@@ -1285,6 +1281,8 @@ void Node::setMidiProgramsEnabled (bool useMidiPrograms)
             return;
         obj->setMidiProgramsEnabled (useMidiPrograms);
         setProperty (tags::midiProgramsEnabled, obj->areMidiProgramsEnabled());
+        if (obj->areMidiProgramsEnabled() && obj->useGlobalMidiPrograms())
+            obj->prefetchMidiPrograms();
     }
 }
 
@@ -1388,6 +1386,10 @@ void NodeObjectSync::valueTreePropertyChanged (ValueTree& tree, const Identifier
             g->triggerAsyncUpdate();
         }
     }
+    else if (property == tags::tailLength)
+    {
+        obj->setTailLength (tree.getProperty (property, obj->getTailLength()));
+    }
 }
 
 void NodeObjectSync::valueTreeChildAdded (ValueTree& parent, ValueTree& child)
@@ -0,0 +1,39 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "nodes/analyzer.hpp"
+
+namespace element {
+
+static PortList analyzerPorts()
+{
+    PortList ports;
+    int index = 0;
+    for (int i = 0; i < AnalyzerNode::numChannels; ++i)
+        ports.add (PortType::Audio, index++, i, String ("audio_in_XX").replace ("XX", String (i)), String ("Input XX").replace ("XX", String (i + 1)), true);
+    for (int i = 0; i < AnalyzerNode::numChannels; ++i)
+        ports.add (PortType::Audio, index++, i, String ("audio_out_XX").replace ("XX", String (i)), String ("Output XX").replace ("XX", String (i + 1)), false);
+    return ports;
+}
+
+AnalyzerNode::AnalyzerNode()
+    : Processor (analyzerPorts())
+{
+    setName ("Analyzer");
+}
+
+AnalyzerNode::~AnalyzerNode() {}
+
+void AnalyzerNode::prepareToRender (double sampleRate, int maxBufferSize)
+{
+    ignoreUnused (maxBufferSize);
+    analyzer.setSampleRate (sampleRate);
+}
+
+void AnalyzerNode::render (RenderContext& rc)
+{
+    // inputs are already the outputs, only a copy is taken.
+    ring.write (rc.audio.getArrayOfReadPointers(), jmin (numChannels, rc.audio.getNumChannels()), rc.audio.getNumSamples());
+}
+
+} // namespace element
@@ -0,0 +1,72 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/processor.hpp>
+
+#include "engine/signalanalyzer.hpp"
+#include "nodes/nodetypes.hpp"
+
+namespace element {
+
+/** Shows the spectrum and waveform of the audio passing through.
+
+    Audio goes through untouched. Each block is copied into a SnapshotRing
+    and that's all the audio thread does, the FFT runs on the analyzer's
+    own thread and only while an editor is watching.
+ */
+class AnalyzerNode : public Processor
+{
+public:
+    static constexpr int numChannels = 2;
+
+    AnalyzerNode();
+    ~AnalyzerNode() override;
+
+    SignalAnalyzer& getAnalyzer() noexcept { return analyzer; }
+
+    //==========================================================================
+    void prepareToRender (double sampleRate, int maxBufferSize) override;
+    void releaseResources() override {}
+
+    inline bool wantsContext() const noexcept override { return true; }
+    void render (RenderContext& rc) override;
+
+    void getState (MemoryBlock&) override {}
+    void setState (const void*, int) override {}
+
+    int getNumPrograms() const override { return 1; }
+    int getCurrentProgram() const override { return 0; }
+    void setCurrentProgram (int index) override { ignoreUnused (index); }
+    const String getProgramName (int index) const override
+    {
+        ignoreUnused (index);
+        return "Default";
+    }
+
+    void getPluginDescription (PluginDescription& desc) const override
+    {
+        desc.fileOrIdentifier = EL_NODE_ID_ANALYZER;
+        desc.uniqueId = EL_NODE_UID_ANALYZER;
+        desc.name = "Analyzer";
+        desc.descriptiveName = "Spectrum and scope of the audio passing through";
+        desc.numInputChannels = numChannels;
+        desc.numOutputChannels = numChannels;
+        desc.hasSharedContainer = false;
+        desc.isInstrument = false;
+        desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+        desc.pluginFormatName = "Element";
+        desc.version = "1.0.0";
+    }
+
+    void refreshPorts() override {}
+
+private:
+    SnapshotRing ring { numChannels };
+    SignalAnalyzer analyzer { ring };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalyzerNode)
+};
+
+} // namespace element
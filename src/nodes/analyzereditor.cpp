@@ -0,0 +1,134 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "nodes/analyzer.hpp"
+#include "nodes/analyzereditor.hpp"
+
+namespace element {
+
+namespace {
+constexpr float topDecibels = 6.f;
+constexpr float bottomDecibels = -96.f;
+} // namespace
+
+AnalyzerNodeEditor::AnalyzerNodeEditor (const Node& node)
+    : NodeEditor (node)
+{
+    setOpaque (true);
+    analyzer = getNodeObjectOfType<AnalyzerNode>();
+    jassert (analyzer != nullptr);
+    if (analyzer != nullptr)
+        analyzer->getAnalyzer().addWatcher();
+
+    setSize (480, 320);
+    setResizable (true);
+    vblank = std::make_unique<VBlankAttachment> (this, [this] { refresh(); });
+}
+
+AnalyzerNodeEditor::~AnalyzerNodeEditor()
+{
+    vblank.reset();
+    if (analyzer != nullptr)
+        analyzer->getAnalyzer().removeWatcher();
+}
+
+void AnalyzerNodeEditor::paint (Graphics& g)
+{
+    g.fillAll (Colours::black);
+
+    g.setColour (Colours::white.withAlpha (0.12f));
+    for (float db = 0.f; db > bottomDecibels; db -= 12.f)
+    {
+        const auto y = jmap (db, bottomDecibels, topDecibels, (float) spectrumArea.getBottom(), (float) spectrumArea.getY());
+        g.drawHorizontalLine (roundToInt (y), (float) spectrumArea.getX(), (float) spectrumArea.getRight());
+    }
+    g.drawHorizontalLine (scopeArea.getCentreY(), (float) scopeArea.getX(), (float) scopeArea.getRight());
+
+    g.setColour (Colours::lightgreen);
+    g.strokePath (spectrum, PathStrokeType (1.f));
+    g.setColour (Colours::skyblue);
+    g.fillPath (scope);
+}
+
+void AnalyzerNodeEditor::resized()
+{
+    auto r = getLocalBounds().reduced (4);
+    spectrumArea = r.removeFromTop (r.getHeight() * 2 / 3);
+    r.removeFromTop (4);
+    scopeArea = r;
+
+    if (analyzer != nullptr)
+        updatePaths (analyzer->getAnalyzer().getFrame());
+}
+
+void AnalyzerNodeEditor::refresh()
+{
+    if (analyzer == nullptr)
+        return;
+    if (auto* const frame = analyzer->getAnalyzer().takeFrame())
+    {
+        updatePaths (*frame);
+        repaint();
+    }
+}
+
+void AnalyzerNodeEditor::updatePaths (const SignalAnalyzer::Frame& frame)
+{
+    spectrum.clear();
+    scope.clear();
+
+    // the loudest bin in each column
+    const int numBins = (int) frame.spectrum.size();
+    const int columns = jmin (numBins, spectrumArea.getWidth());
+    for (int c = 0; c < columns; ++c)
+    {
+        const int first = c * numBins / columns;
+        const int last = jmax (first + 1, (c + 1) * numBins / columns);
+        float db = bottomDecibels;
+        for (int b = first; b < last; ++b)
+            db = jmax (db, frame.spectrum[(size_t) b]);
+
+        const auto x = jmap ((float) c, 0.f, (float) jmax (1, columns - 1), (float) spectrumArea.getX(), (float) spectrumArea.getRight());
+        const auto y = jmap (jlimit (bottomDecibels, topDecibels, db), bottomDecibels, topDecibels, (float) spectrumArea.getBottom(), (float) spectrumArea.getY());
+        if (c == 0)
+            spectrum.startNewSubPath (x, y);
+        else
+            spectrum.lineTo (x, y);
+    }
+
+    // min and max over each column, drawn as one filled outline
+    const int numPoints = (int) frame.scopeMax.size();
+    const int width = jmin (numPoints, scopeArea.getWidth());
+    if (width <= 0)
+        return;
+
+    const float middle = (float) scopeArea.getCentreY();
+    const float half = (float) scopeArea.getHeight() * 0.5f;
+    Array<Point<float>> lower;
+    lower.ensureStorageAllocated (width);
+    for (int c = 0; c < width; ++c)
+    {
+        const int first = c * numPoints / width;
+        const int last = jmax (first + 1, (c + 1) * numPoints / width);
+        float lo = 1.f, hi = -1.f;
+        for (int p = first; p < last; ++p)
+        {
+            lo = jmin (lo, frame.scopeMin[(size_t) p]);
+            hi = jmax (hi, frame.scopeMax[(size_t) p]);
+        }
+
+        const auto x = (float) scopeArea.getX() + (float) c * (float) scopeArea.getWidth() / (float) width;
+        const auto top = middle - jlimit (-1.f, 1.f, hi) * half;
+        if (c == 0)
+            scope.startNewSubPath (x, top);
+        else
+            scope.lineTo (x, top);
+        lower.add ({ x, middle - jlimit (-1.f, 1.f, lo) * half + 1.f });
+    }
+
+    for (int c = lower.size(); --c >= 0;)
+        scope.lineTo (lower.getReference (c));
+    scope.closeSubPath();
+}
+
+} // namespace element
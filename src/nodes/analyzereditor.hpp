@@ -0,0 +1,38 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/ui/nodeeditor.hpp>
+
+#include "engine/signalanalyzer.hpp"
+
+namespace element {
+
+class AnalyzerNode;
+
+/** Draws an Analyzer node's spectrum above its scope.
+
+    Frames are picked up at vsync and reduced again to at most a point per
+    pixel column, so drawing costs the same however much was analysed.
+ */
+class AnalyzerNodeEditor : public NodeEditor
+{
+public:
+    AnalyzerNodeEditor (const Node& node);
+    ~AnalyzerNodeEditor() override;
+
+    void paint (Graphics& g) override;
+    void resized() override;
+
+private:
+    ReferenceCountedObjectPtr<AnalyzerNode> analyzer;
+    std::unique_ptr<VBlankAttachment> vblank;
+    Rectangle<int> spectrumArea, scopeArea;
+    Path spectrum, scope;
+
+    void refresh();
+    void updatePaths (const SignalAnalyzer::Frame& frame);
+};
+
+} // namespace element
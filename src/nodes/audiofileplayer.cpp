@@ -412,6 +412,7 @@ AudioFilePlayerNode::AudioFilePlayerNode()
     addLegacyParameter (slave = new AudioParameterBool ("slave", "Slave", false));
     addLegacyParameter (volume = new AudioParameterFloat ("volume", "Volume", -60.f, 12.f, 0.f));
     addLegacyParameter (looping = new AudioParameterBool ("loop", "Loop", false));
+    formats.registerBasicFormats();
 
     for (auto* const param : getParameters())
         param->addListener (this);
@@ -439,13 +440,11 @@ bool AudioFilePlayerNode::respondsToStartStopContinue() const
 
 void AudioFilePlayerNode::enableHostSync (bool sync)
 {
-    juce::ScopedLock sl (getCallbackLock());
     *slave = sync;
 }
 
 bool AudioFilePlayerNode::hostSyncEnabled() const noexcept
 {
-    juce::ScopedLock sl (getCallbackLock());
     return *slave;
 }
 
@@ -466,9 +465,8 @@ void AudioFilePlayerNode::fillInPluginDescription (PluginDescription& desc) cons
 
 void AudioFilePlayerNode::clearPlayer()
 {
-    player.setSource (nullptr);
-    if (reader)
-        reader = nullptr;
+    player.stop();
+    player.setStream (nullptr);
     *playing = player.isPlaying();
 }
 
@@ -476,54 +474,26 @@ void AudioFilePlayerNode::openFile (const File& file)
 {
     if (file == audioFile)
         return;
-    if (auto* newReader = formats.createReaderFor (file))
+
+    // the stream is read ahead here and swapped in at the next block, the
+    // audio thread keeps playing the old one until then.
+    if (auto stream = DiskStream::open (formats, file))
     {
-        clearPlayer();
-        reader.reset (new AudioFormatReaderSource (newReader, true));
         audioFile = file;
-        player.setSource (reader.get(), 1024 * 8, &thread, newReader->sampleRate, 2);
-
-        ScopedLock sl (getCallbackLock());
-        reader->setLooping (*looping);
         player.setLooping (*looping);
+        player.setStream (std::move (stream));
     }
 }
 
 void AudioFilePlayerNode::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
 {
-    thread.startThread();
-    formats.registerBasicFormats();
+    // the stream, position and play state carry over from before.
     player.prepareToPlay (maximumExpectedSamplesPerBlock, sampleRate);
-
-    if (reader)
-    {
-        double readerSampleRate = sampleRate;
-        if (auto* fmtReader = reader->getAudioFormatReader())
-            readerSampleRate = fmtReader->sampleRate;
-
-        reader->setLooping (*looping);
-        player.setLooping (*looping);
-        player.setSource (reader.get(), 1024 * 8, &thread, readerSampleRate, 2);
-        player.setPosition (jmax (0.0, lastTransportPos));
-        if (wasPlaying)
-            player.start();
-    }
-    else
-    {
-        clearPlayer();
-    }
 }
 
 void AudioFilePlayerNode::releaseResources()
 {
-    lastTransportPos = player.getCurrentPosition();
-    wasPlaying = player.isPlaying();
-
-    player.stop();
     player.releaseResources();
-    player.setSource (nullptr);
-    formats.clearFormats();
-    thread.stopThread (14);
 }
 
 void AudioFilePlayerNode::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
@@ -532,30 +502,14 @@ void AudioFilePlayerNode::processBlock (AudioBuffer<float>& buffer, MidiBuffer&
     for (int c = buffer.getNumChannels(); --c >= 0;)
         buffer.clear (c, 0, nframes);
 
-    ScopedLock sl (getCallbackLock());
     const bool hostSync = *slave;
     if (hostSync)
     {
         if (auto* const playhead = getPlayHead())
         {
-            auto pos = playhead->getPosition();
-            if (pos)
-            {
-                if (pos->getTimeInSamples() == 0 && player.getCurrentPosition() != 0.0)
-                {
-                    player.setPosition (0.0);
-                }
-
-                if (player.isPlaying() != pos->getIsPlaying())
-                {
-                    if (pos->getIsPlaying())
-                        midiPlayState.set (Continue);
-                    else
-                        midiPlayState.set (Stop);
-
-                    triggerAsyncUpdate();
-                }
-            }
+            // start, stop and seek here in the block the transport does.
+            if (auto pos = playhead->getPosition())
+                player.follow (pos->getIsPlaying(), pos->getTimeInSamples().orFallback (0));
         }
     }
 
@@ -709,11 +663,7 @@ void AudioFilePlayerNode::parameterValueChanged (int parameter, float newValue)
         break;
 
         case Looping: {
-            if (reader != nullptr)
-            {
-                player.setLooping (*looping);
-                reader->setLooping (*looping);
-            }
+            player.setLooping (*looping);
         }
         break;
     }
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "engine/diskstream.hpp"
 #include "nodes/baseprocessor.hpp"
 #include <element/signals.hpp>
 
@@ -66,6 +67,7 @@ public:
     void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
     void releaseResources() override;
     void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
+    int64 getMemoryUsage() const override { return player.getMemoryUsage(); }
 
     bool canAddBus (bool isInput) const override
     {
@@ -103,7 +105,7 @@ public:
     void parameterValueChanged (int parameterIndex, float newValue) override;
     void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override;
 
-    AudioTransportSource& getPlayer() { return player; }
+    DiskStreamPlayer& getPlayer() { return player; }
 
     Signal<void()> restoredState;
 
@@ -144,10 +146,8 @@ protected:
 private:
     friend class AudioFilePlayerEditor;
 
-    TimeSliceThread thread { "MediaPlayer" };
-    std::unique_ptr<AudioFormatReaderSource> reader;
     AudioFormatManager formats;
-    AudioTransportSource player;
+    DiskStreamPlayer player;
 
     AudioParameterBool* slave { nullptr };
     AudioParameterBool* playing { nullptr };
@@ -158,9 +158,6 @@ private:
     Atomic<int> midiStartStopContinue;
     Atomic<int> midiPlayState { None };
 
-    bool wasPlaying { false };
-    double lastTransportPos { 0.0 };
-
     File watchDir;
 
     void clearPlayer();
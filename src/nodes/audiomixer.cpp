@@ -1,8 +1,10 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include "engine/gainramp.hpp"
 #include "nodes/audiomixer.hpp"
 #include "ui/horizontallistbox.hpp"
+#include "ui/meterticker.hpp"
 #include <element/ui/style.hpp>
 #include <element/ui/simplemeter.hpp>
 
@@ -14,7 +16,7 @@ namespace element {
 typedef AudioMixerProcessor::MonitorPtr MonitorPtr;
 
 class AudioMixerEditor : public AudioProcessorEditor,
-                         private Timer
+                         private MeterTicker::Client
 {
 public:
     AudioMixerEditor (AudioMixerProcessor& p)
@@ -25,10 +27,13 @@ public:
         setName ("AudioMixerEditor");
         addAndMakeVisible (channels);
         setSize (330, 210);
-        startTimerHz (24);
+        ticker->add (this);
     }
 
-    ~AudioMixerEditor() noexcept {}
+    ~AudioMixerEditor() noexcept
+    {
+        ticker->remove (this);
+    }
 
     void paint (Graphics& g) override
     {
@@ -92,6 +97,17 @@ private:
 
             addAndMakeVisible (meter);
 
+            if (monitor->getTrackId() >= 0 && monitor->getNumChannels() == 2)
+            {
+                addAndMakeVisible (pan);
+                pan.setSliderStyle (Slider::LinearBar);
+                pan.setTextBoxStyle (Slider::NoTextBox, true, 1, 1);
+                pan.setRange (-1.0, 1.0, 0.01);
+                pan.setValue (0.0, dontSendNotification);
+                pan.setDoubleClickReturnValue (true, 0.0);
+                pan.addListener (this);
+            }
+
             addAndMakeVisible (name);
             name.setFont (name.getFont().withHeight (14));
             name.setJustificationType (Justification::centred);
@@ -135,6 +151,8 @@ private:
         {
             auto r = getLocalBounds();
             name.setBounds (r.removeFromTop (18));
+            if (pan.isVisible())
+                pan.setBounds (r.removeFromTop (12).reduced (2, 1));
 
             volume.setBounds (r.removeFromBottom (18));
             auto r2 = r.removeFromBottom (18);
@@ -159,6 +177,10 @@ private:
                 monitor->requestVolume (s->getValue());
                 updateLabels();
             }
+            else if (s == &pan)
+            {
+                monitor->requestPan ((float) s->getValue());
+            }
         }
 
         int getNumChannels() const { return (nullptr != monitor) ? monitor->getNumChannels()
@@ -170,6 +192,7 @@ private:
         AudioMixerEditor& editor;
         AudioMixerProcessor::MonitorPtr monitor;
         Slider fader;
+        Slider pan;
         SimpleMeter meter;
         TextButton mute;
         Label name;
@@ -192,6 +215,8 @@ private:
             }
 
             mute.setToggleState (monitor->isMuted(), dontSendNotification);
+            if (pan.isVisible() && ! pan.isMouseButtonDown())
+                pan.setValue ((double) monitor->getPan(), dontSendNotification);
         }
 
         void processMeter()
@@ -331,9 +356,12 @@ private:
     std::unique_ptr<ChannelStrip> masterStrip;
     MonitorPtr masterMonitor;
 
-    friend class Timer;
-    void timerCallback() override
+    SharedResourcePointer<MeterTicker> ticker;
+
+    void meterTick() override
     {
+        if (! isShowing())
+            return;
         for (auto* const strip : strips)
         {
             strip->processMeter();
@@ -342,11 +370,57 @@ private:
     }
 };
 
+//==============================================================================
+/** The tracks as the audio thread sees them, with its ramp state. */
+struct AudioMixerProcessor::Layout
+{
+    struct Strip
+    {
+        Strip (const Track& track, int first, int numConnected)
+            : busIdx (track.busIdx),
+              numChannels (track.numInputs),
+              firstChannel (first),
+              numInputs (jmin (numConnected, numChannels)),
+              monitor (track.monitor),
+              inputs ((size_t) numChannels, nullptr),
+              lastGains ((size_t) numChannels, track.monitor->isMuted() ? 0.f : track.monitor->getGain()),
+              gains ((size_t) numChannels, 0.f),
+              sums ((size_t) numChannels, 0.f)
+        {
+        }
+
+        int busIdx = -1;
+        int numChannels = 0;
+        int firstChannel = 0; // of the bus in the process buffer
+        int numInputs = 0; // channels the bus has, none when it's gone
+        MonitorPtr monitor;
+        std::vector<const float*> inputs;
+        std::vector<float> lastGains, gains, sums;
+    };
+
+    std::vector<Strip> strips;
+};
+
+AudioMixerProcessor::AudioMixerProcessor (int numTracks, const double sampleRate, const int bufferSize)
+    : BaseProcessor (BusesProperties()
+                         .withOutput ("Master", AudioChannelSet::stereo(), false))
+{
+    tracks.ensureStorageAllocated (16);
+    while (--numTracks >= 0)
+        addStereoTrack();
+
+    setRateAndBufferSizeDetails (sampleRate, bufferSize);
+    addLegacyParameter (masterMute = new AudioParameterBool ("masterMute", "Master Mute", false));
+    addLegacyParameter (masterVolume = new AudioParameterFloat ("masterVolume", "Master Volume", -120.0f, 12.0f, 0.f));
+    masterMonitor = new Monitor (-1, 2);
+    publish();
+}
+
 AudioMixerProcessor::~AudioMixerProcessor()
 {
     Array<Track*> oldTracks;
     {
-        ScopedLock sl (getCallbackLock());
+        ScopedLock sl (lock);
         masterMute = nullptr;
         masterVolume = nullptr;
         tracks.swapWith (oldTracks);
@@ -360,7 +434,7 @@ AudioMixerProcessor::MonitorPtr AudioMixerProcessor::getMonitor (const int track
 {
     if (track < 0)
         return masterMonitor;
-    ScopedLock sl (getCallbackLock());
+    ScopedLock sl (lock);
     if (! isPositiveAndBelow (track, tracks.size()))
         return nullptr;
     return tracks.getUnchecked (track)->monitor;
@@ -402,7 +476,7 @@ void AudioMixerProcessor::addStereoTrack()
         track->mute = false;
         track->monitor = new Monitor (track->index, track->numOutputs);
 
-        ScopedLock sl (getCallbackLock());
+        ScopedLock sl (lock);
         tracks.add (track);
         numTracks = tracks.size();
     }
@@ -412,6 +486,26 @@ void AudioMixerProcessor::addStereoTrack()
     }
 }
 
+void AudioMixerProcessor::publish()
+{
+    auto next = std::make_unique<Layout>();
+    {
+        ScopedLock sl (lock);
+        next->strips.reserve ((size_t) tracks.size());
+        // where each bus sits in the process buffer only changes with the
+        // layout, so it's looked up here rather than every block.
+        const int numBuses = getBusCount (true);
+        for (const auto* const track : tracks)
+        {
+            const bool connected = isPositiveAndBelow (track->busIdx, numBuses);
+            next->strips.emplace_back (*track,
+                                       connected ? getChannelIndexInProcessBlockBuffer (true, track->busIdx, 0) : 0,
+                                       connected ? getChannelCountOfBus (true, track->busIdx) : 0);
+        }
+    }
+    layouts.publish (std::move (next));
+}
+
 AudioProcessorEditor* AudioMixerProcessor::createEditor()
 {
     auto* ed = new AudioMixerEditor (*this);
@@ -422,77 +516,136 @@ AudioProcessorEditor* AudioMixerProcessor::createEditor()
 void AudioMixerProcessor::prepareToPlay (const double sampleRate, const int bufferSize)
 {
     setRateAndBufferSizeDetails (sampleRate, bufferSize);
-    jassert (tracks.size() == getBusCount (true));
+    jassert (getNumTracks() == getBusCount (true));
     jassert (1 == getBusCount (false));
     tempBuffer.setSize (getMainBusNumOutputChannels(), bufferSize, false, true, true);
+    publish();
 }
 
 void AudioMixerProcessor::processBlock (AudioSampleBuffer& audio, MidiBuffer& midi)
 {
     midi.clear();
 
-    ScopedLock sl (getCallbackLock());
+    if (auto* const next = layouts.acquire())
+    {
+        // keep ramping from where tracks that are still there left off.
+        if (layout != nullptr)
+            for (auto& strip : next->strips)
+                for (const auto& old : layout->strips)
+                    if (old.monitor == strip.monitor && old.numChannels == strip.numChannels)
+                        strip.lastGains = old.lastGains;
+
+        layouts.retire (layout.release());
+        layout.reset (next);
+    }
 
-    if (tracks.size() <= 0)
+    if (layout == nullptr || layout->strips.empty())
     {
         audio.clear();
         return;
     }
 
     auto output (getBusBuffer<float> (audio, false, 0));
-    const int numSamples = audio.getNumSamples();
-    tempBuffer.clear (0, numSamples);
+    const int numSamples = jmin (audio.getNumSamples(), tempBuffer.getNumSamples());
+    const int numOutputs = jmin (output.getNumChannels(), tempBuffer.getNumChannels());
+    const int numChannels = audio.getNumChannels();
 
-    for (int i = 0; i < tracks.size(); ++i)
+    for (auto& strip : layout->strips)
     {
-        auto* const track = tracks.getUnchecked (i);
-        auto input (getBusBuffer<float> (audio, true, track->busIdx));
-        auto& rms = track->monitor->rms;
-
-        if (track->mute)
+        auto& monitor = *strip.monitor;
+        const float gain = monitor.nextGain.get();
+        const float pan = monitor.nextPan.get();
+        const bool mute = monitor.nextMute.get() > 0;
+        monitor.gain.set (gain);
+        monitor.pan.set (pan);
+        monitor.muted.set (mute ? 1 : 0);
+
+        float left = 1.f, right = 1.f;
+        if (strip.numChannels == 2)
+            GainRamp::panGains (pan, left, right);
+
+        for (int c = 0; c < strip.numChannels; ++c)
         {
-            for (int c = 0; c < track->numInputs; ++c)
-                rms.getReference (c).set (0.0);
+            const float panGain = c == 0 ? left : (c == 1 ? right : 1.f);
+            strip.gains[(size_t) c] = mute ? 0.f : gain * panGain;
+            const int channel = strip.firstChannel + c;
+            strip.inputs[(size_t) c] = c < strip.numInputs && channel < numChannels ? audio.getReadPointer (channel) : nullptr;
+            strip.sums[(size_t) c] = 0.f;
         }
-        else
+    }
+
+    // master gain and mute ramp like a track's.
+    const float masterGain = Decibels::decibelsToGain ((float) *masterVolume, (float) EL_FADER_MIN_DB);
+    const float masterTarget = *masterMute ? 0.f : masterGain;
+    float masterSums[2] = { 0.f, 0.f };
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int num = jmin (chunkSize, numSamples - start);
+        const float from = (float) start / (float) numSamples;
+        const float to = (float) (start + num) / (float) numSamples;
+
+        for (int c = 0; c < numOutputs; ++c)
+            FloatVectorOperations::clear (tempBuffer.getWritePointer (c, start), num);
+
+        for (auto& strip : layout->strips)
         {
-            for (int c = 0; c < track->numInputs; ++c)
+            for (int c = jmin (strip.numChannels, numOutputs); --c >= 0;)
             {
-                rms.getReference (c).set (track->gain * input.getRMSLevel (c, 0, numSamples));
-                tempBuffer.addFromWithRamp (c, 0, input.getReadPointer (c), numSamples, track->lastGain, track->gain);
+                const auto* const src = strip.inputs[(size_t) c];
+                const float last = strip.lastGains[(size_t) c];
+                const float target = strip.gains[(size_t) c];
+                if (src == nullptr || (last == 0.f && target == 0.f))
+                    continue;
+
+                strip.sums[(size_t) c] += GainRamp::add (tempBuffer.getWritePointer (c, start), src + start, num,
+                                                         last + (target - last) * from,
+                                                         last + (target - last) * to);
             }
         }
 
-        track->lastGain = track->gain;
+        // the master copy reads the chunk while it's still in cache.
+        for (int c = 0; c < numOutputs; ++c)
+        {
+            const float sum = GainRamp::copy (output.getWritePointer (c, start), tempBuffer.getReadPointer (c, start), num,
+                                              lastGain + (masterTarget - lastGain) * from,
+                                              lastGain + (masterTarget - lastGain) * to);
+            if (c < 2)
+                masterSums[c] += sum;
+        }
+    }
 
-        if (track->gain != track->monitor->nextGain.get())
-            track->gain = track->monitor->nextGain.get();
-        track->monitor->gain.set (track->gain);
+    for (int c = numOutputs; c < output.getNumChannels(); ++c)
+        output.clear (c, 0, audio.getNumSamples());
+    if (numSamples < audio.getNumSamples())
+        for (int c = 0; c < numOutputs; ++c)
+            output.clear (c, numSamples, audio.getNumSamples() - numSamples);
 
-        if (static_cast<int> (track->mute) != track->monitor->nextMute.get())
-            track->mute = track->monitor->nextMute.get() > 0;
-        track->monitor->muted.set (track->mute ? 1 : 0);
+    const float divisor = (float) jmax (1, numSamples);
+    for (auto& strip : layout->strips)
+    {
+        auto& rms = strip.monitor->rms;
+        for (int c = 0; c < strip.numChannels; ++c)
+        {
+            const float level = strip.gains[(size_t) c] * std::sqrt (strip.sums[(size_t) c] / divisor);
+            if (isPositiveAndBelow (c, rms.size()))
+                rms.getReference (c).set (level);
+            strip.lastGains[(size_t) c] = strip.gains[(size_t) c];
+        }
     }
 
-    output.clear (0, numSamples);
-    const float gain = Decibels::decibelsToGain ((float) *masterVolume, (float) EL_FADER_MIN_DB);
-    if (! *masterMute)
-        for (int c = 0; c < output.getNumChannels(); ++c)
-            output.copyFromWithRamp (c, 0, tempBuffer.getReadPointer (c), numSamples, lastGain, gain);
-
-    if (gain != masterMonitor->nextGain.get())
+    if (masterGain != masterMonitor->nextGain.get())
         *masterVolume = Decibels::gainToDecibels (masterMonitor->nextGain.get(), (float) EL_FADER_MIN_DB);
     if (static_cast<int> (*masterMute) != masterMonitor->nextMute.get())
         *masterMute = masterMonitor->nextMute.get() <= 0 ? false : true;
 
     masterMonitor->muted.set (*masterMute);
-    masterMonitor->gain.set (gain);
+    masterMonitor->gain.set (masterGain);
 
     for (int i = 0; i < 2; ++i)
-        masterMonitor->rms.getReference (i).set (
-            output.getRMSLevel (i, 0, numSamples));
+        masterMonitor->rms.getReference (i).set (std::sqrt (masterSums[i] / divisor));
 
-    lastGain = gain;
+    lastGain = masterTarget;
 }
 
 void AudioMixerProcessor::releaseResources()
@@ -525,34 +678,47 @@ bool AudioMixerProcessor::canApplyBusCountChange (bool isInput, bool isAdding, A
 
 void AudioMixerProcessor::setTrackGain (const int track, const float gain)
 {
-    if (! isPositiveAndBelow (track, numTracks))
-        return;
-    ScopedLock sl (getCallbackLock());
-    tracks.getUnchecked (track)->gain = gain;
+    ScopedLock sl (lock);
+    if (isPositiveAndBelow (track, tracks.size()))
+        tracks.getUnchecked (track)->monitor->requestGain (gain);
 }
 
 void AudioMixerProcessor::setTrackMuted (const int track, const bool mute)
 {
-    if (! isPositiveAndBelow (track, numTracks))
-        return;
-    ScopedLock sl (getCallbackLock());
-    tracks.getUnchecked (track)->mute = mute;
+    ScopedLock sl (lock);
+    if (isPositiveAndBelow (track, tracks.size()))
+        tracks.getUnchecked (track)->monitor->requestMute (mute);
+}
+
+void AudioMixerProcessor::setTrackPan (const int track, const float pan)
+{
+    ScopedLock sl (lock);
+    if (isPositiveAndBelow (track, tracks.size()))
+        tracks.getUnchecked (track)->monitor->requestPan (pan);
 }
 
 bool AudioMixerProcessor::isTrackMuted (const int track) const
 {
-    if (! isPositiveAndBelow (track, numTracks))
+    ScopedLock sl (lock);
+    if (! isPositiveAndBelow (track, tracks.size()))
         return false;
-    ScopedLock sl (getCallbackLock());
-    return tracks.getUnchecked (track)->mute;
+    return tracks.getUnchecked (track)->monitor->nextMute.get() > 0;
 }
 
 float AudioMixerProcessor::getTrackGain (const int track) const
 {
-    if (! isPositiveAndBelow (track, numTracks))
+    ScopedLock sl (lock);
+    if (! isPositiveAndBelow (track, tracks.size()))
         return 1.f;
-    ScopedLock sl (getCallbackLock());
-    return tracks.getUnchecked (track)->gain;
+    return tracks.getUnchecked (track)->monitor->nextGain.get();
+}
+
+float AudioMixerProcessor::getTrackPan (const int track) const
+{
+    ScopedLock sl (lock);
+    if (! isPositiveAndBelow (track, tracks.size()))
+        return 0.f;
+    return tracks.getUnchecked (track)->monitor->nextPan.get();
 }
 
 void AudioMixerProcessor::getStateInformation (juce::MemoryBlock& block)
@@ -563,9 +729,15 @@ void AudioMixerProcessor::getStateInformation (juce::MemoryBlock& block)
     float volume = 0.0f;
     bool mute = false;
     {
-        ScopedLock sl (getCallbackLock());
+        ScopedLock sl (lock);
         for (int i = 0; i < numTracks; ++i)
-            t.getUnchecked (i)->update (tracks.getUnchecked (i));
+        {
+            auto* const track = t.getUnchecked (i);
+            track->update (tracks.getUnchecked (i));
+            track->gain = track->monitor->nextGain.get();
+            track->pan = track->monitor->nextPan.get();
+            track->mute = track->monitor->nextMute.get() > 0;
+        }
         volume = *masterVolume;
         mute = *masterMute;
     }
@@ -582,6 +754,7 @@ void AudioMixerProcessor::getStateInformation (juce::MemoryBlock& block)
             .setProperty ("numInputs", track->numInputs, 0)
             .setProperty ("numOutputs", track->numOutputs, 0)
             .setProperty ("gain", track->gain, 0)
+            .setProperty ("pan", track->pan, 0)
             .setProperty ("mute", track->mute, 0);
         state.addChild (trk, -1, 0);
     }
@@ -614,6 +787,7 @@ void AudioMixerProcessor::setStateInformation (const void* data, int size)
         track->numOutputs = trk.getProperty ("numOutputs", 2);
         track->gain = trk.getProperty ("gain", 1.f);
         track->lastGain = track->gain;
+        track->pan = trk.getProperty ("pan", 0.f);
         track->mute = (bool) trk.getProperty ("mute", false);
 
         track->monitor = new Monitor (track->index, track->numInputs);
@@ -621,12 +795,14 @@ void AudioMixerProcessor::setStateInformation (const void* data, int size)
         track->monitor->nextGain.set (track->gain);
         track->monitor->muted.set (track->mute ? 1 : 0);
         track->monitor->nextMute.set (track->mute ? 1 : 0);
+        track->monitor->pan.set (track->pan);
+        track->monitor->nextPan.set (track->pan);
 
         newTracks.add (track);
     }
 
     {
-        ScopedLock sl (getCallbackLock());
+        ScopedLock sl (lock);
         *masterVolume = (float) state.getProperty (tags::volume, 0.0);
         *masterMute = (bool) state.getProperty ("mute", false);
         masterMonitor->nextGain.set (Decibels::decibelsToGain ((float) *masterVolume, (float) EL_FADER_MIN_DB));
@@ -637,6 +813,8 @@ void AudioMixerProcessor::setStateInformation (const void* data, int size)
         numTracks = tracks.size();
     }
 
+    publish();
+
     for (auto* dt : newTracks)
         delete dt;
     newTracks.clear();
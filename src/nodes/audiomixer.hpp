@@ -3,10 +3,19 @@
 
 #pragma once
 
+#include "engine/togglegrid.hpp"
 #include "nodes/baseprocessor.hpp"
 
 namespace element {
 
+/** Mixes stereo tracks to a master bus.
+
+    Track gain, pan and mute are requested through each track's Monitor
+    and read by the audio thread without locking. The track list itself is
+    published as an immutable snapshot. Tracks are summed in short chunks
+    so the mix stays in cache however many tracks there are, and meters
+    are measured in the same pass as the mix.
+ */
 class AudioMixerProcessor : public BaseProcessor
 {
     AudioParameterBool* masterMute;
@@ -28,6 +37,7 @@ public:
         }
 
         inline float getGain() const { return gain.get(); }
+        inline float getPan() const { return pan.get(); }
         inline int getNumChannels() const { return numChannels; }
         inline int getTrackId() const { return trackId; }
         inline bool isMuted() const { return muted.get() > 0; }
@@ -54,6 +64,12 @@ public:
             requestGain (Decibels::decibelsToGain (dB, -120.f));
         }
 
+        /** Request a pan from -1 (left) to 1 (right). Stereo tracks only. */
+        inline void requestPan (const float newPan)
+        {
+            nextPan.set (jlimit (-1.f, 1.f, newPan));
+        }
+
     private:
         friend class AudioMixerProcessor;
         const int trackId;
@@ -63,6 +79,8 @@ public:
         Atomic<int> nextMute;
         Atomic<float> gain;
         Atomic<float> nextGain;
+        Atomic<float> pan;
+        Atomic<float> nextPan;
 
         void reset()
         {
@@ -70,6 +88,8 @@ public:
             nextMute = 0;
             gain = 1.f;
             nextGain = 1.f;
+            pan = 0.f;
+            nextPan = 0.f;
             if (rms.size() > 0)
                 rms.clearQuick();
             while (rms.size() < numChannels)
@@ -87,6 +107,7 @@ public:
         int numOutputs = 0;
         float lastGain = 1.0;
         float gain = 1.0;
+        float pan = 0.0;
         bool mute = false;
         MonitorPtr monitor;
 
@@ -98,6 +119,7 @@ public:
             this->numOutputs = track->numOutputs;
             this->gain = track->gain;
             this->lastGain = track->gain;
+            this->pan = track->pan;
             this->mute = track->mute;
             this->monitor = track->monitor;
         }
@@ -105,19 +127,7 @@ public:
 
     explicit AudioMixerProcessor (int numTracks = 4,
                                   const double sampleRate = 44100.0,
-                                  const int bufferSize = 1024)
-        : BaseProcessor (BusesProperties()
-                             .withOutput ("Master", AudioChannelSet::stereo(), false))
-    {
-        tracks.ensureStorageAllocated (16);
-        while (--numTracks >= 0)
-            addStereoTrack();
-
-        setRateAndBufferSizeDetails (sampleRate, bufferSize);
-        addLegacyParameter (masterMute = new AudioParameterBool ("masterMute", "Master Mute", false));
-        addLegacyParameter (masterVolume = new AudioParameterFloat ("masterVolume", "Master Volume", -120.0f, 12.0f, 0.f));
-        masterMonitor = new Monitor (-1, 2);
-    }
+                                  const int bufferSize = 1024);
 
     ~AudioMixerProcessor();
 
@@ -140,7 +150,7 @@ public:
 
     int getNumTracks() const
     {
-        ScopedLock sl (getCallbackLock());
+        ScopedLock sl (lock);
         return tracks.size();
     }
 
@@ -148,8 +158,10 @@ public:
 
     void setTrackGain (const int track, const float gain);
     void setTrackMuted (const int track, const bool mute);
+    void setTrackPan (const int track, const float pan);
     bool isTrackMuted (const int track) const;
     float getTrackGain (const int track) const;
+    float getTrackPan (const int track) const;
 
     inline bool acceptsMidi() const override { return false; }
     inline bool producesMidi() const override { return false; }
@@ -175,6 +187,7 @@ public:
     bool canAddBus (bool) const override { return true; }
     bool canRemoveBus (bool) const override { return true; }
     bool canApplyBusCountChange (bool isInput, bool isAdding, AudioProcessor::BusProperties& outProperties) override;
+    void processorLayoutsChanged() override { publish(); }
 
     double getTailLengthSeconds() const override { return 0.0; }
 
@@ -187,14 +200,23 @@ public:
     void getStateInformation (juce::MemoryBlock&) override;
     void setStateInformation (const void*, int) override;
 
+    /** Samples mixed per pass over the tracks. */
+    static constexpr int chunkSize = 256;
+
 private:
+    struct Layout;
+
     MonitorPtr masterMonitor;
+    CriticalSection lock;
     Array<Track*> tracks;
     int numTracks = 0;
+    GridExchange<Layout> layouts;
+    std::unique_ptr<Layout> layout; // audio thread
     AudioSampleBuffer tempBuffer;
     float lastGain = 0.f;
     void addMonoTrack();
     void addStereoTrack();
+    void publish();
 };
 
 } // namespace element
@@ -37,9 +37,17 @@ public:
 
     void getPluginDescription (PluginDescription& desc) const override;
     bool wantsContext() const noexcept override { return false; }
+    int64 getMemoryUsage() const override;
+
+    /** Process a block through the plugin in double precision, converting
+        to and from the float buffers of the graph. Returns false, doing
+        nothing, if the block is larger than what the node was prepared for.
+        Only call while the plugin is using double precision. Audio thread.
+     */
+    bool renderDouble (AudioSampleBuffer& audio, MidiBuffer& midi, bool bypassed) noexcept;
 
     void audioProcessorChanged (AudioProcessor*, const ChangeDetails&) override;
-    void audioProcessorParameterChanged (juce::AudioProcessor*, int, float) override {}
+    void audioProcessorParameterChanged (juce::AudioProcessor*, int, float) override { markStateChanged(); }
 
 protected:
     ParameterPtr getParameter (const PortDescription& port) override;
@@ -49,6 +57,7 @@ private:
     Atomic<int> enabled { 1 };
     MemoryBlock pluginState;
     ParameterArray params;
+    AudioBuffer<double> doubleBuffer;
 
     struct EnablementUpdater : public AsyncUpdater
     {
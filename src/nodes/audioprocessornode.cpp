@@ -20,7 +20,7 @@ public:
         : param (p)
     {
         param.addListener (this);
-        addListener (this);
+        addRealtimeListener (this);
     }
 
     ~AudioProcessorNodeParameter()
@@ -130,11 +130,54 @@ void AudioProcessorNode::prepareToRender (double sampleRate, int maxBufferSize)
         return;
     }
 
+    // the graph chooses the precision, plugins only take it when prepared.
+    auto* graph = getParentGraph();
+    const bool useDouble = graph != nullptr && graph->isDoublePrecision()
+                           && proc->supportsDoublePrecisionProcessing();
+    proc->setProcessingPrecision (useDouble ? AudioProcessor::doublePrecision
+                                            : AudioProcessor::singlePrecision);
+    if (useDouble)
+        doubleBuffer.setSize (jmax (1, getNumAudioInputs(), getNumAudioOutputs()), maxBufferSize);
+    else
+        doubleBuffer.setSize (0, 0);
+
     proc->setRateAndBufferSizeDetails (sampleRate, maxBufferSize);
     proc->prepareToPlay (sampleRate, maxBufferSize);
     setLatencySamples (proc->getLatencySamples());
 }
 
+bool AudioProcessorNode::renderDouble (AudioSampleBuffer& audio, MidiBuffer& midi, bool bypassed) noexcept
+{
+    const int numChannels = audio.getNumChannels();
+    const int numSamples = audio.getNumSamples();
+    if (numChannels > doubleBuffer.getNumChannels() || numSamples > doubleBuffer.getNumSamples())
+        return false;
+
+    AudioBuffer<double> block (doubleBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* src = audio.getReadPointer (ch);
+        auto* dst = block.getWritePointer (ch);
+        for (int i = 0; i < numSamples; ++i)
+            dst[i] = (double) src[i];
+    }
+
+    if (bypassed)
+        proc->processBlockBypassed (block, midi);
+    else
+        proc->processBlock (block, midi);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* src = block.getReadPointer (ch);
+        auto* dst = audio.getWritePointer (ch);
+        for (int i = 0; i < numSamples; ++i)
+            dst[i] = (float) src[i];
+    }
+
+    return true;
+}
+
 void AudioProcessorNode::releaseResources()
 {
     if (! proc)
@@ -144,16 +187,16 @@ void AudioProcessorNode::releaseResources()
     }
 
     proc->releaseResources();
+    doubleBuffer.setSize (0, 0);
 }
 
 void AudioProcessorNode::audioProcessorChanged (AudioProcessor*, const ChangeDetails& details)
 {
-    if (details.latencyChanged)
-    {
-        setLatencySamples (proc->getLatencySamples());
-        if (auto g = getParentGraph())
-            g->triggerAsyncUpdate();
-    }
+    if (details.programChanged || details.nonParameterStateChanged)
+        markStateChanged();
+
+    // latency changes may come from the audio thread. The parent graph
+    // polls for them and re-plans its delay compensation.
 }
 
 void AudioProcessorNode::getState (MemoryBlock& block)
@@ -263,6 +306,15 @@ void AudioProcessorNode::getPluginDescription (PluginDescription& desc) const
         pi->fillInPluginDescription (desc);
 }
 
+int64 AudioProcessorNode::getMemoryUsage() const
+{
+    auto total = Processor::getMemoryUsage();
+    total += (int64) doubleBuffer.getNumChannels() * doubleBuffer.getNumSamples() * (int64) sizeof (double);
+    if (auto* base = dynamic_cast<BaseProcessor*> (proc.get()))
+        total += base->getMemoryUsage();
+    return total;
+}
+
 ParameterPtr AudioProcessorNode::getParameter (const PortDescription& port)
 {
     jassert (isPositiveAndBelow (port.channel, params.size()));
@@ -13,17 +13,10 @@ AudioRouterNode::AudioRouterNode (int ins, int outs)
     : Processor (0),
       numSources (ins),
       numDestinations (outs),
-      state (ins, outs),
-      toggles (ins, outs),
-      nextToggles (ins, outs)
+      state (ins, outs)
 {
     setName ("Audio Router");
-
-    fadeIn.setFadesIn (true);
-    fadeIn.setLength (fadeLengthSeconds);
-    fadeOut.setFadesIn (false);
-    fadeOut.setLength (fadeLengthSeconds);
-
+    gains.insertMultiple (0, 1.f, ins * outs);
     clearPatches();
 
     auto* program = programs.add (new Program ("Linear Stereo"));
@@ -65,6 +58,14 @@ AudioRouterNode::AudioRouterNode (int ins, int outs)
 
 AudioRouterNode::~AudioRouterNode() {}
 
+void AudioRouterNode::prepareToRender (double newSampleRate, int maxBufferSize)
+{
+    sampleRate = newSampleRate;
+    const int numChannels = jmax (1, numSources, numDestinations);
+    tempAudio.setSize (numChannels, maxBufferSize, false, false, true);
+    fadeAudio.setSize (numChannels, maxBufferSize, false, false, true);
+}
+
 void AudioRouterNode::setCurrentProgram (int index)
 {
     if (auto* program = programs[index])
@@ -77,16 +78,48 @@ void AudioRouterNode::setCurrentProgram (int index)
 void AudioRouterNode::applyMatrix (const MatrixState& matrix)
 {
     jassert (matrix.sameSizeAs (state));
-    ToggleGrid newPatches (matrix);
-    {
-        ScopedLock sl (getLock());
-        nextToggles.swapWith (newPatches);
-        togglesChanged = true; // initiate the crossfade
-    }
+    ignoreUnused (matrix);
+    publish(); // the audio thread crossfades to it
+    sendChangeMessage();
+}
+
+void AudioRouterNode::publish()
+{
+    jassert (gains.size() == state.getNumRows() * state.getNumColumns());
+    grids.publish (std::make_unique<GainMatrix> (state, gains.getRawDataPointer()));
+}
+
+void AudioRouterNode::resizeGains (int oldRows, int oldColumns)
+{
+    const int rows = state.getNumRows(), columns = state.getNumColumns();
+    Array<float> newGains;
+    newGains.insertMultiple (0, 1.f, rows * columns);
+    if (gains.size() == oldRows * oldColumns)
+        for (int r = 0; r < jmin (rows, oldRows); ++r)
+            for (int c = 0; c < jmin (columns, oldColumns); ++c)
+                newGains.set (state.getIndexForCell (r, c), gains.getUnchecked ((r * oldColumns) + c));
+    gains.swapWith (newGains);
+}
 
+void AudioRouterNode::setGain (int src, int dst, float gain)
+{
+    if (! isPositiveAndBelow (src, state.getNumRows()) || ! isPositiveAndBelow (dst, state.getNumColumns()))
+        return;
+    const int index = state.getIndexForCell (src, dst);
+    if (gains[index] == gain)
+        return;
+    gains.set (index, gain);
+    publish();
     sendChangeMessage();
 }
 
+float AudioRouterNode::getGain (int src, int dst) const
+{
+    if (! isPositiveAndBelow (src, state.getNumRows()) || ! isPositiveAndBelow (dst, state.getNumColumns()))
+        return 0.f;
+    return gains[state.getIndexForCell (src, dst)];
+}
+
 String AudioRouterNode::getSizeString() const
 {
     int s = 0, d = 0;
@@ -112,17 +145,15 @@ void AudioRouterNode::setSize (int newIns, int newOuts, bool async)
             return;
     }
 
+    const int oldRows = state.getNumRows(), oldColumns = state.getNumColumns();
     state.resize (newIns, newOuts, true);
-    ToggleGrid newPatches (state);
-    ToggleGrid newNextPatches (state);
+    resizeGains (oldRows, oldColumns);
+    publish(); // a new size switches without a crossfade
 
     {
         ScopedLock sl (getLock());
-        nextToggles.swapWith (newNextPatches);
-        toggles.swapWith (newPatches);
         numSources = newIns;
         numDestinations = newOuts;
-        sizeChanged = true; // initiate the size change
     }
 
     rebuildPorts = true;
@@ -156,149 +187,96 @@ void AudioRouterNode::render (RenderContext& rc)
     const int numFrames = rc.audio.getNumSamples();
     const int numChannels = rc.audio.getNumChannels();
 
-    tempAudio.setSize (numChannels, numFrames, false, false, true);
-    tempAudio.clear (0, numFrames);
-
-    if (sizeChanged)
+    // a new matrix is picked up between crossfades, never during one.
+    if (next == nullptr)
     {
-        fadeIn.reset();
-        fadeOut.reset();
-        sizeChanged = false;
-        TRACE_AUDIO_ROUTER ("size changed");
+        if (auto* published = grids.acquire())
+        {
+            if (current == nullptr || ! current->sameSizeAs (*published))
+            {
+                grids.retire (current.release());
+                current.reset (published);
+                TRACE_AUDIO_ROUTER ("size changed");
+            }
+            else
+            {
+                next.reset (published);
+                fadeGain = 0.f;
+                TRACE_AUDIO_ROUTER ("fade start");
+            }
+        }
     }
 
-    if (togglesChanged)
+    if (current == nullptr)
     {
-        fadeIn.reset();
-        fadeIn.startFading();
-        fadeOut.reset();
-        fadeOut.startFading();
-        togglesChanged = false;
-        TRACE_AUDIO_ROUTER ("fade start");
+        rc.audio.clear();
+        rc.midi.clear();
+        return;
     }
 
-    if (numSources > numChannels || numDestinations > numChannels)
+    const int numOuts = current->getNumOutputs();
+    if (current->getNumInputs() > numChannels || numOuts > numChannels)
     {
         rc.audio.clear();
         rc.midi.clear();
         return;
     }
 
-    if (fadeIn.isActive() || fadeOut.isActive())
-    {
-        auto framesToProcess = numFrames;
-        int frame = 0;
-        ScopedLock sl (lock);
-
-        float fadeInGain = 0.0f;
-        float fadeOutGain = 1.0f;
+    tempAudio.setSize (numChannels, numFrames, false, false, true);
+    current->process (rc.audio.getArrayOfReadPointers(), tempAudio.getArrayOfWritePointers(), numFrames);
 
-        while (--framesToProcess >= 0)
+    if (next != nullptr)
+    {
+        // fade from one mix to the other, patches that didn't change come out the same.
+        fadeAudio.setSize (numChannels, numFrames, false, false, true);
+        next->process (rc.audio.getArrayOfReadPointers(), fadeAudio.getArrayOfWritePointers(), numFrames);
+
+        const float step = 1.f / jmax (1.f, fadeLength.load (std::memory_order_relaxed) * (float) sampleRate);
+        const float startGain = fadeGain;
+        float endGain = startGain + step * (float) numFrames;
+        int numFading = numFrames;
+        if (endGain >= 1.f)
         {
-            fadeInGain = fadeIn.isActive() ? fadeIn.getNextEnvelopeValue() : 1.0f;
-            fadeOutGain = fadeOut.isActive() ? fadeOut.getNextEnvelopeValue() : 0.0f;
-
-            if (! fadeIn.isActive() && ! fadeOut.isActive())
-            {
-                TRACE_AUDIO_ROUTER ("last frame fade in gain  : " << fadeInGain);
-                TRACE_AUDIO_ROUTER ("last frame fade out gain : " << fadeOutGain);
-            }
-
-            for (int i = 0; i < numSources; ++i)
-            {
-                for (int j = 0; j < numDestinations; ++j)
-                {
-                    if (toggles.get (i, j) && nextToggles.get (i, j))
-                    {
-                        // no patch change and on means 1 to 1 mix
-                        tempAudio.getWritePointer (j)[frame] +=
-                            rc.audio.getReadPointer (i)[frame];
-                    }
-                    else if (! toggles.get (i, j) && ! nextToggles.get (i, j))
-                    {
-                        // no patch change and off means no fade and zero'd
-                        tempAudio.getWritePointer (j)[frame] += 0.0f;
-                    }
-                    else if (! toggles.get (i, j) && nextToggles.get (i, j))
-                    {
-                        tempAudio.getWritePointer (j)[frame] +=
-                            (rc.audio.getReadPointer (i)[frame] * fadeInGain);
-                    }
-                    else if (toggles.get (i, j) && ! nextToggles.get (i, j))
-                    {
-                        tempAudio.getWritePointer (j)[frame] +=
-                            (rc.audio.getReadPointer (i)[frame] * fadeOutGain);
-                    }
-                }
-            }
-
-            ++frame;
-
-            if (! fadeIn.isActive() && ! fadeOut.isActive())
-                break;
+            numFading = jlimit (1, numFrames, (int) std::ceil ((1.f - startGain) / step));
+            endGain = 1.f;
         }
 
-        if (! fadeOut.isActive() && ! fadeIn.isActive())
+        for (int c = 0; c < numOuts; ++c)
         {
-            TRACE_AUDIO_ROUTER ("fade stopped @ frame: " << (frame));
-            TRACE_AUDIO_ROUTER ("fade in level  : " << fadeInGain);
-            TRACE_AUDIO_ROUTER ("fade out level : " << fadeOutGain);
-
-            if (framesToProcess > 0)
-            {
-                TRACE_AUDIO_ROUTER ("rendering " << framesToProcess << " remainging frames");
-                for (int i = 0; i < numSources; ++i)
-                {
-                    for (int j = 0; j < numDestinations; ++j)
-                    {
-                        if (toggles.get (i, j) && nextToggles.get (i, j))
-                        {
-                            // no patch change and on means 1 to 1 mix
-                            tempAudio.addFrom (j, frame, rc.audio.getReadPointer (i, frame), framesToProcess);
-                        }
-                        else if (! toggles.get (i, j) && ! nextToggles.get (i, j))
-                        {
-                            // patch not changed and of, so clear the out channel.
-                            // nothing to do
-                        }
-                        else if (! toggles.get (i, j) && nextToggles.get (i, j))
-                        {
-                            tempAudio.addFromWithRamp (j, frame, rc.audio.getReadPointer (i, frame), framesToProcess, fadeInGain, 1.0f);
-                        }
-                        else if (toggles.get (i, j) && ! nextToggles.get (i, j))
-                        {
-                            tempAudio.addFromWithRamp (j, frame, rc.audio.getReadPointer (i, frame), framesToProcess, fadeOutGain, 0.0f);
-                        }
-                        else
-                        {
-                            // this would be an unhandled fading scenario
-                            jassertfalse;
-                        }
-                    }
-                }
-            }
+            tempAudio.applyGainRamp (c, 0, numFading, 1.f - startGain, 1.f - endGain);
+            if (numFading < numFrames)
+                tempAudio.copyFrom (c, numFading, fadeAudio, c, numFading, numFrames - numFading);
+            tempAudio.addFromWithRamp (c, 0, fadeAudio.getReadPointer (c), numFading, startGain, endGain);
+        }
 
-            toggles.swapWith (nextToggles);
+        fadeGain = endGain;
+        if (fadeGain >= 1.f)
+        {
+            TRACE_AUDIO_ROUTER ("fade stopped @ frame: " << numFading);
+            grids.retire (current.release());
+            current = std::move (next);
         }
     }
-    else
-    {
-        ScopedLock sl (lock);
-        for (int i = 0; i < numSources; ++i)
-            for (int j = 0; j < numDestinations; ++j)
-                if (toggles.get (i, j))
-                    tempAudio.addFrom (j, 0, rc.audio, i, 0, numFrames);
-    }
 
-    for (int c = 0; c < numChannels; ++c)
+    for (int c = 0; c < numOuts; ++c)
         rc.audio.copyFrom (c, 0, tempAudio.getReadPointer (c), numFrames);
+    for (int c = numOuts; c < numChannels; ++c)
+        rc.audio.clear (c, 0, numFrames);
     rc.midi.clear();
 }
 
 void AudioRouterNode::getState (MemoryBlock& block)
 {
     MemoryOutputStream stream (block, false);
-    state.createValueTree().writeToStream (stream);
+    auto tree = state.createValueTree();
+    if (std::any_of (gains.begin(), gains.end(), [] (float g) { return g != 1.f; }))
+    {
+        StringArray tokens;
+        for (const auto g : gains)
+            tokens.add (String (g));
+        tree.setProperty ("gains", tokens.joinIntoString (" "), nullptr);
+    }
+    tree.writeToStream (stream);
 }
 
 void AudioRouterNode::setState (const void* data, int sizeInBytes)
@@ -313,16 +291,18 @@ void AudioRouterNode::setState (const void* data, int sizeInBytes)
         if (matrix.getNumRows() > 0 && matrix.getNumColumns() > 0)
         {
             state = matrix;
+            gains.clearQuick();
+            gains.insertMultiple (0, 1.f, state.getNumRows() * state.getNumColumns());
+            const auto tokens = StringArray::fromTokens (tree.getProperty ("gains").toString(), " ", {});
+            if (tokens.size() == gains.size())
+                for (int i = 0; i < tokens.size(); ++i)
+                    gains.set (i, tokens[i].getFloatValue());
+            publish();
 
-            ToggleGrid newPatches (state);
-            ToggleGrid newNextPatches (state);
             {
                 ScopedLock sl (getLock());
                 numSources = matrix.getNumRows();
                 numDestinations = matrix.getNumColumns();
-                nextToggles.swapWith (newNextPatches);
-                toggles.swapWith (newPatches);
-                sizeChanged = true;
             }
 
             rebuildPorts = true;
@@ -335,25 +315,19 @@ void AudioRouterNode::setState (const void* data, int sizeInBytes)
 void AudioRouterNode::setWithoutLocking (int src, int dst, bool set)
 {
     jassert (src >= 0 && src < numSources && dst >= 0 && dst < numDestinations);
-    toggles.set (src, dst, set);
     state.set (src, dst, set);
+    publish();
 }
 
 void AudioRouterNode::set (int src, int dst, bool patched)
 {
     jassert (src >= 0 && src < numSources && dst >= 0 && numDestinations < 4);
-    toggles.set (src, dst, patched);
     state.set (src, dst, patched);
+    publish();
 }
 
 void AudioRouterNode::clearPatches()
 {
-    {
-        ScopedLock sl (getLock());
-        toggles.clear();
-        nextToggles.clear();
-    }
-
     for (int r = 0; r < state.getNumRows(); ++r)
         for (int c = 0; c < state.getNumColumns(); ++c)
             state.set (r, c, false);
@@ -5,7 +5,7 @@
 
 #include <element/node.h>
 #include <element/processor.hpp>
-#include "engine/linearfade.hpp"
+#include "engine/gainmatrix.hpp"
 #include "engine/togglegrid.hpp"
 
 namespace element {
@@ -17,7 +17,7 @@ public:
     explicit AudioRouterNode (int ins = 4, int outs = 4);
     ~AudioRouterNode();
 
-    void prepareToRender (double sampleRate, int maxBufferSize) override { ignoreUnused (sampleRate, maxBufferSize); }
+    void prepareToRender (double sampleRate, int maxBufferSize) override;
     void releaseResources() override {}
 
     inline bool wantsContext() const noexcept override { return true; }
@@ -33,6 +33,14 @@ public:
     void setWithoutLocking (int src, int dst, bool set);
     CriticalSection& getLock() { return lock; }
 
+    /** Set the gain of a patch, linear. Applies while the patch is on and
+        is kept across program changes.
+     */
+    void setGain (int src, int dst, float gain);
+
+    /** Returns the gain of a patch, whether it's on or not. */
+    float getGain (int src, int dst) const;
+
     int getNumPrograms() const override { return jmax (1, programs.size()); }
     int getCurrentProgram() const override { return currentProgram; }
     void setCurrentProgram (int index) override;
@@ -43,13 +51,10 @@ public:
         return "Audio Router " + String (index + 1);
     }
 
+    /** Set the crossfade length, applied from the next matrix change. */
     void setFadeLength (double seconds)
     {
-        seconds = jlimit (0.001, 5.0, seconds);
-        ScopedLock sl (lock);
-        fadeLengthSeconds = seconds;
-        fadeIn.setLength (static_cast<float> (fadeLengthSeconds));
-        fadeOut.setLength (static_cast<float> (fadeLengthSeconds));
+        fadeLength.store (static_cast<float> (jlimit (0.001, 5.0, seconds)));
     }
 
     void getPluginDescription (PluginDescription& desc) const override
@@ -98,6 +103,7 @@ private:
     [[maybe_unused]] int numDestinations;
     [[maybe_unused]] int nextNumDestinations;
     AudioSampleBuffer tempAudio { 1, 1 };
+    AudioSampleBuffer fadeAudio { 1, 1 };
     bool rebuildPorts = true;
 
     struct Program
@@ -117,16 +123,21 @@ private:
 
     // used by the UI, but not the rendering
     MatrixState state;
+    Array<float> gains; ///< one per cell of state, indexed the same way
+
+    std::atomic<float> fadeLength { 0.001f }; // 1 ms
 
-    double fadeLengthSeconds { 0.001 }; // 1 ms
-    LinearFade fadeIn;
-    LinearFade fadeOut;
-    ToggleGrid toggles;
-    ToggleGrid nextToggles;
-    bool togglesChanged { false },
-        sizeChanged { false };
+    // published to the audio thread. The crossfade and the matrices it fades
+    // between are only touched there.
+    GridExchange<GainMatrix> grids;
+    std::unique_ptr<GainMatrix> current;
+    std::unique_ptr<GainMatrix> next;
+    double sampleRate = 44100.0;
+    float fadeGain = 0.f;
 
     void applyMatrix (const MatrixState&);
+    void publish();
+    void resizeGains (int oldRows, int oldColumns);
 };
 
 } // namespace element
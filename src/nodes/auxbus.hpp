@@ -0,0 +1,186 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include "nodes/baseprocessor.hpp"
+
+namespace element {
+
+/** Common to the aux send and return nodes.
+
+    Sends and returns on the same bus in a graph are wired by GraphBuilder.
+    The bus is a pair of shared buffers: every send adds into them and the
+    return reads them as its output. No connections are needed between the
+    two, and no extra buffers or copies for each send.
+ */
+class AuxBusProcessor : public BaseProcessor
+{
+public:
+    static constexpr int numBuses = 16;
+    static constexpr int numChannels = 2;
+
+    /** Returns the bus, starting at 1. */
+    int getBus() const noexcept { return bus != nullptr ? bus->get() : 1; }
+
+    /** True for a return, false for a send. */
+    virtual bool isReturn() const noexcept = 0;
+
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+
+    AudioProcessorEditor* createEditor() override { return new GenericAudioProcessorEditor (*this); }
+    bool hasEditor() const override { return true; }
+
+    void releaseResources() override {}
+
+    int getNumPrograms() override { return 1; };
+    int getCurrentProgram() override { return 1; };
+    void setCurrentProgram (int index) override { ignoreUnused (index); };
+    const String getProgramName (int index) override
+    {
+        ignoreUnused (index);
+        return "Parameter";
+    }
+    void changeProgramName (int index, const String& newName) override { ignoreUnused (index, newName); }
+
+    void getStateInformation (juce::MemoryBlock& destData) override
+    {
+        ValueTree state (tags::state);
+        state.setProperty ("bus", getBus(), nullptr);
+        if (level != nullptr)
+            state.setProperty ("level", (float) *level, nullptr);
+        if (auto e = state.createXml())
+            AudioProcessor::copyXmlToBinary (*e, destData);
+    }
+
+    void setStateInformation (const void* data, int sizeInBytes) override
+    {
+        if (auto e = AudioProcessor::getXmlFromBinary (data, sizeInBytes))
+        {
+            auto state = ValueTree::fromXml (*e);
+            if (state.isValid())
+            {
+                *bus = (int) state.getProperty ("bus", getBus());
+                if (level != nullptr)
+                    *level = (float) state.getProperty ("level", (float) *level);
+            }
+        }
+    }
+
+protected:
+    AudioParameterInt* bus = nullptr;
+    AudioParameterFloat* level = nullptr;
+
+    explicit AuxBusProcessor (const BusesProperties& layout)
+        : BaseProcessor (layout)
+    {
+        addLegacyParameter (bus = new AudioParameterInt ("bus", "Bus", 1, numBuses, 1));
+    }
+
+    bool canApplyBusCountChange (bool, bool, BusProperties&) override { return false; }
+};
+
+//==============================================================================
+/** Passes its input through and sends it to an aux bus at a level. */
+class AuxSendProcessor : public AuxBusProcessor
+{
+public:
+    AuxSendProcessor()
+        : AuxBusProcessor (BusesProperties()
+                               .withInput ("Main", AudioChannelSet::stereo(), true)
+                               .withOutput ("Main", AudioChannelSet::stereo(), true))
+    {
+        addLegacyParameter (level = new AudioParameterFloat ("level", "Level", -70.f, 6.f, 0.f));
+    }
+
+    bool isReturn() const noexcept override { return false; }
+
+    /** Returns the send level as a gain, zero at the bottom of the range. */
+    float getSendGain() const noexcept
+    {
+        const float db = *level;
+        return db <= -70.f ? 0.f : Decibels::decibelsToGain (db);
+    }
+
+    const String getName() const override { return "Aux Send"; }
+
+    void fillInPluginDescription (PluginDescription& desc) const override
+    {
+        desc.name = getName();
+        desc.fileOrIdentifier = EL_NODE_ID_AUX_SEND;
+        desc.descriptiveName = "Sends audio to an aux bus in the same graph";
+        desc.numInputChannels = numChannels;
+        desc.numOutputChannels = numChannels;
+        desc.hasSharedContainer = false;
+        desc.isInstrument = false;
+        desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+        desc.pluginFormatName = "Element";
+        desc.version = "1.0.0";
+        desc.uniqueId = EL_NODE_UID_AUX_SEND;
+    }
+
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override
+    {
+        setPlayConfigDetails (numChannels, numChannels, sampleRate, maximumExpectedSamplesPerBlock);
+    }
+
+    // the graph does the sending, the audio passes through untouched.
+    void processBlock (AudioBuffer<float>&, MidiBuffer&) override {}
+
+protected:
+    bool isBusesLayoutSupported (const BusesLayout& layout) const override
+    {
+        return layout.getMainInputChannels() == numChannels
+               && layout.getMainOutputChannels() == numChannels;
+    }
+};
+
+//==============================================================================
+/** Outputs the sum of every send on its bus. */
+class AuxReturnProcessor : public AuxBusProcessor
+{
+public:
+    AuxReturnProcessor()
+        : AuxBusProcessor (BusesProperties()
+                               .withOutput ("Main", AudioChannelSet::stereo(), true))
+    {
+    }
+
+    bool isReturn() const noexcept override { return true; }
+
+    const String getName() const override { return "Aux Return"; }
+
+    void fillInPluginDescription (PluginDescription& desc) const override
+    {
+        desc.name = getName();
+        desc.fileOrIdentifier = EL_NODE_ID_AUX_RETURN;
+        desc.descriptiveName = "Returns the sum of the aux sends on a bus";
+        desc.numInputChannels = 0;
+        desc.numOutputChannels = numChannels;
+        desc.hasSharedContainer = false;
+        desc.isInstrument = false;
+        desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+        desc.pluginFormatName = "Element";
+        desc.version = "1.0.0";
+        desc.uniqueId = EL_NODE_UID_AUX_RETURN;
+    }
+
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override
+    {
+        setPlayConfigDetails (0, numChannels, sampleRate, maximumExpectedSamplesPerBlock);
+    }
+
+    // the graph renders the bus straight into the output buffers.
+    void processBlock (AudioBuffer<float>&, MidiBuffer&) override {}
+
+protected:
+    bool isBusesLayoutSupported (const BusesLayout& layout) const override
+    {
+        return layout.getMainInputChannels() == 0
+               && layout.getMainOutputChannels() == numChannels;
+    }
+};
+
+} // namespace element
@@ -20,6 +20,11 @@ public:
         : juce::AudioPluginInstance (ioLayouts) {}
     virtual ~BaseProcessor() {}
 
+    /** Returns the bytes this processor allocated for its own use, e.g.
+        buffers and caches. Counted by the node hosting it.
+     */
+    virtual int64 getMemoryUsage() const { return 0; }
+
 protected:
     /** This is for backward compatibility with juce 6. Don't use in new processors */
     inline void addLegacyParameter (HostedParameter* param)
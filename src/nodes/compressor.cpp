@@ -33,6 +33,7 @@ CompressorProcessor::CompressorProcessor (const int _numChannels)
     addLegacyParameter (releaseMs = new AudioParameterFloat ("release", "Release [ms]", releaseRange, 100.0f));
     addLegacyParameter (makeupDB = new AudioParameterFloat ("makeup", "Makeup [dB]", -18.0f, 18.0f, 0.0f));
     addLegacyParameter (sideChain = new AudioParameterFloat ("sidechain", "Side Chain", 0.0f, 1.0f, 0.0f));
+    addLegacyParameter (link = new AudioParameterChoice ("link", "Detector", { "Stereo Link", "Per Channel" }, 0));
 
     makeupGain.reset (numSteps);
 }
@@ -54,24 +55,32 @@ void CompressorProcessor::fillInPluginDescription (PluginDescription& desc) cons
 
 void CompressorProcessor::updateParams()
 {
-    detector.setAttackMs (*attackMs);
-    detector.setReleaseMs (*releaseMs);
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        detector[ch].setAttackMs (*attackMs);
+        detector[ch].setReleaseMs (*releaseMs);
 
-    sideDetector.setAttackMs (*attackMs);
-    sideDetector.setReleaseMs (*releaseMs);
+        sideDetector[ch].setAttackMs (*attackMs);
+        sideDetector[ch].setReleaseMs (*releaseMs);
 
-    gainComputer.setThreshold (*threshDB);
-    gainComputer.setRatio (*ratio);
-    gainComputer.setKnee (*kneeDB);
+        gainComputer[ch].setThreshold (*threshDB);
+        gainComputer[ch].setRatio (*ratio);
+        gainComputer[ch].setKnee (*kneeDB);
+    }
 
     makeupGain.setTargetValue (Decibels::decibelsToGain ((float) *makeupDB));
 }
 
 void CompressorProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
 {
-    detector.reset ((float) sampleRate);
-    sideDetector.reset ((float) sampleRate);
-    gainComputer.reset();
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        detector[ch].reset ((float) sampleRate);
+        sideDetector[ch].reset ((float) sampleRate);
+        gainComputer[ch].reset();
+    }
+
+    scratch.setSize (NumScratch, jmax (1, maximumExpectedSamplesPerBlock), false, true, true);
 
     setBusesLayout (getBusesLayout());
     setRateAndBufferSizeDetails (sampleRate, maximumExpectedSamplesPerBlock);
@@ -79,40 +88,107 @@ void CompressorProcessor::prepareToPlay (double sampleRate, int maximumExpectedS
 
 void CompressorProcessor::releaseResources() {}
 
-void CompressorProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&)
+void CompressorProcessor::sumToMono (const AudioBuffer<float>& buffer, float* dest, int start, int numSamples)
 {
-    auto mainBuffer = getBusBuffer (buffer, true, 0);
-    auto sideBuffer = getBusBuffer (buffer, true, 1);
+    const int numChans = buffer.getNumChannels();
+    if (numChans <= 0)
+    {
+        FloatVectorOperations::clear (dest, numSamples);
+        return;
+    }
 
-    auto numBuffChannels = mainBuffer.getNumChannels();
+    const float scale = 1.0f / (float) numChans;
+    FloatVectorOperations::copyWithMultiply (dest, buffer.getReadPointer (0, start), scale, numSamples);
+    for (int ch = 1; ch < numChans; ++ch)
+        FloatVectorOperations::addWithMultiply (dest, buffer.getReadPointer (ch, start), scale, numSamples);
+}
 
-    updateParams();
+void CompressorProcessor::processChunk (AudioBuffer<float>& mainBus, AudioBuffer<float>& sideBus, int start, int numSamples)
+{
+    const float sideAmount = *sideChain;
+    const bool linked = isStereoLinked();
+    const int numChans = jmin (2, mainBus.getNumChannels());
+
+    float* const level = scratch.getWritePointer (Level);
+    float* const sideLevel = scratch.getWritePointer (SideLevel);
+    float* const makeup = scratch.getWritePointer (Makeup);
+
+    const bool rampMakeup = makeupGain.isSmoothing();
+    if (rampMakeup)
+        for (int n = 0; n < numSamples; ++n)
+            makeup[n] = makeupGain.getNextValue();
+
+    // the side detector only runs while it's heard, and starts over from
+    // silence when it comes back.
+    auto detect = [&] (int index, const float* input, const float* sideInput) {
+        detector[index].processBlock (input, level, numSamples);
+        if (sideAmount > 0.0f)
+        {
+            sideDetector[index].processBlock (sideInput, sideLevel, numSamples);
+            FloatVectorOperations::multiply (level, 1.0f - sideAmount, numSamples);
+            FloatVectorOperations::addWithMultiply (level, sideLevel, sideAmount, numSamples);
+        }
+        else
+        {
+            sideDetector[index].setLevelEstimate (0.0f);
+        }
 
-    float level = 0.0f;
-    for (int n = 0; n < buffer.getNumSamples(); ++n)
-    {
-        // Get Main mono input
-        float mainInput = getSummedMonoSample (mainBuffer, n, numBuffChannels);
+        lastLevel = level[numSamples - 1];
+        gainComputer[index].processBlock (level, numSamples);
 
-        // Get sidechain mono input
-        float sideInput = getSummedMonoSample (sideBuffer, n, numBuffChannels);
+        if (rampMakeup)
+            FloatVectorOperations::multiply (level, makeup, numSamples);
+        else
+            FloatVectorOperations::multiply (level, makeupGain.getCurrentValue(), numSamples);
+    };
+
+    if (linked)
+    {
+        float* const input = scratch.getWritePointer (Input);
+        float* const sideInput = scratch.getWritePointer (SideInput);
+        sumToMono (mainBus, input, start, numSamples);
+        if (sideAmount > 0.0f)
+            sumToMono (sideBus, sideInput, start, numSamples);
+
+        detect (0, input, sideInput);
+        for (int ch = 0; ch < mainBus.getNumChannels(); ++ch)
+            FloatVectorOperations::multiply (mainBus.getWritePointer (ch, start), level, numSamples);
+        return;
+    }
 
-        // Get level estimate, and compute gain
-        level = detector.process (mainInput) * (1.0f - *sideChain)
-                + sideDetector.process (sideInput) * *sideChain;
-        float gain = gainComputer.process (level);
+    for (int ch = 0; ch < numChans; ++ch)
+    {
+        const float* const sideInput = ch < sideBus.getNumChannels() ? sideBus.getReadPointer (ch, start)
+                                                                  : scratch.getReadPointer (SideInput);
+        if (ch >= sideBus.getNumChannels())
+            scratch.clear (SideInput, 0, numSamples);
 
-        // Apply gain
-        mainBuffer.applyGain (n, 1, gain * makeupGain.getNextValue());
+        detect (ch, mainBus.getReadPointer (ch, start), sideInput);
+        FloatVectorOperations::multiply (mainBus.getWritePointer (ch, start), level, numSamples);
     }
+}
+
+void CompressorProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&)
+{
+    auto mainBuffer = getBusBuffer (buffer, true, 0);
+    auto sideBuffer = getBusBuffer (buffer, true, 1);
+
+    updateParams();
+
+    // blocks longer than prepared for run in pieces.
+    const int numSamples = buffer.getNumSamples();
+    const int chunk = scratch.getNumSamples();
+    for (int start = 0; chunk > 0 && start < numSamples; start += chunk)
+        processChunk (mainBuffer, sideBuffer, start, jmin (chunk, numSamples - start));
 
-    listeners.call (&Listener::updateInGainDB, Decibels::gainToDecibels (level));
+    listeners.call (&Listener::updateInGainDB, Decibels::gainToDecibels (lastLevel));
 }
 
 float CompressorProcessor::calcGainDB (float db)
 {
     auto x = Decibels::decibelsToGain (db);
-    auto gain = gainComputer.calcGain (x, gainComputer.thresh.getCurrentValue(), gainComputer.ratio.getCurrentValue());
+    auto& computer = gainComputer[0];
+    auto gain = computer.calcGain (x, computer.thresh.getCurrentValue(), computer.ratio.getCurrentValue());
     return Decibels::gainToDecibels (gain);
 }
 
@@ -128,6 +204,7 @@ void CompressorProcessor::getStateInformation (juce::MemoryBlock& destData)
     state.setProperty ("release", (float) *releaseMs, 0);
     state.setProperty ("makeup", (float) *makeupDB, 0);
     state.setProperty ("sidechain", (float) *sideChain, 0);
+    state.setProperty ("link", link->getIndex(), 0);
     if (auto e = state.createXml())
         AudioProcessor::copyXmlToBinary (*e, destData);
 }
@@ -146,6 +223,7 @@ void CompressorProcessor::setStateInformation (const void* data, int sizeInBytes
             *releaseMs = (float) state.getProperty ("release", (float) *releaseMs);
             *makeupDB = (float) state.getProperty ("makeup", (float) *makeupDB);
             *sideChain = (float) state.getProperty ("sidechain", (float) *sideChain);
+            *link = (int) state.getProperty ("link", 0);
         }
     }
 }
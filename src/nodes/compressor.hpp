@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "engine/fastdecibels.hpp"
 #include "nodes/baseprocessor.hpp"
 #include "ElementApp.h"
 
@@ -59,6 +60,24 @@ public:
         return levelEstimate;
     }
 
+    /* Process a block, writing the level estimate for each sample. input
+       and output may be the same.
+    */
+    void processBlock (const float* input, float* output, int numSamples) noexcept
+    {
+        const float attack = b0_a, release = b0_r;
+        float level = levelEstimate;
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const float x = std::abs (input[n]);
+            level += (x > level ? attack : release) * (x - level);
+            output[n] = level;
+        }
+
+        levelEstimate = level;
+    }
+
     void setLevelEstimate (float levelEst) { levelEstimate = levelEst; }
     float getLevelEstimate() { return levelEstimate; }
 
@@ -144,6 +163,33 @@ public:
         return calcGain (x, thresh.getNextValue(), ratio.getNextValue());
     }
 
+    /** Turn a block of levels into gains, in place.
+
+        Exact while the threshold or ratio is moving. After that the curve
+        is worked out in decibels with FastDecibels, without branches.
+     */
+    void processBlock (float* data, int numSamples) noexcept
+    {
+        int n = 0;
+        for (; n < numSamples && (thresh.isSmoothing() || ratio.isSmoothing()); ++n)
+            data[n] = process (data[n]);
+
+        const float threshold = Decibels::gainToDecibels (thresh.getCurrentValue());
+        const float slope = 1.0f / ratio.getCurrentValue() - 1.0f;
+        const float lowerDB = threshold - 0.5f * kneeDB;
+        const float upperDB = threshold + 0.5f * kneeDB;
+        const float kneeA = aFF;
+
+        for (; n < numSamples; ++n)
+        {
+            const float xDB = FastDecibels::gainToDecibels (std::abs (data[n]));
+            const float corr = xDB - lowerDB;
+            const float gainDB = xDB >= upperDB ? (xDB - threshold) * slope
+                                                : (xDB > lowerDB ? -kneeA * corr * corr : 0.0f);
+            data[n] = FastDecibels::decibelsToGain (gainDB);
+        }
+    }
+
 private:
     // recalculate knee values for a new threshold or knee width
     void recalcKnees()
@@ -190,6 +236,9 @@ public:
     void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override;
     float calcGainDB (float db);
 
+    /** Returns true if every channel shares one detector. */
+    bool isStereoLinked() const { return link->getIndex() == 0; }
+
     AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
 
@@ -249,14 +298,22 @@ protected:
     }
 
 private:
-    inline float getSummedMonoSample (AudioBuffer<float>& buffer, int idx, int numChans)
+    // scratch channels
+    enum
     {
-        float sum = 0.0f;
-        for (int ch = 0; ch < numChans; ++ch)
-            sum += buffer.getSample (ch, idx);
-        return sum / (float) numChans;
+        Input = 0,
+        SideInput,
+        Level,
+        SideLevel,
+        Makeup,
+        NumScratch
     };
 
+    /** Average the channels of a buffer into dest. */
+    static void sumToMono (const AudioBuffer<float>& buffer, float* dest, int start, int numSamples);
+
+    void processChunk (AudioBuffer<float>& mainBus, AudioBuffer<float>& sideBus, int start, int numSamples);
+
     int numChannels = 0;
     AudioParameterFloat* threshDB = nullptr;
     AudioParameterFloat* ratio = nullptr;
@@ -265,13 +322,17 @@ private:
     AudioParameterFloat* releaseMs = nullptr;
     AudioParameterFloat* makeupDB = nullptr;
     AudioParameterFloat* sideChain = nullptr;
+    AudioParameterChoice* link = nullptr;
 
     SmoothedValue<float, ValueSmoothingTypes::Multiplicative> makeupGain = 1.0f;
     const int numSteps = 200;
 
-    LevelDetector detector;
-    LevelDetector sideDetector;
-    GainComputer gainComputer;
+    // one per channel, the first serves all of them when linked.
+    LevelDetector detector[2];
+    LevelDetector sideDetector[2];
+    GainComputer gainComputer[2];
+    AudioBuffer<float> scratch;
+    float lastLevel = 0.0f;
 
     ListenerList<Listener> listeners;
 
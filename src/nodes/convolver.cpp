@@ -0,0 +1,255 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <element/ui/style.hpp>
+
+#include "nodes/convolver.hpp"
+#include "nodes/knobs.hpp"
+
+namespace element {
+
+class ConvolverEditor : public AudioProcessorEditor,
+                        private FilenameComponentListener
+{
+public:
+    ConvolverEditor (ConvolverProcessor& p)
+        : AudioProcessorEditor (p),
+          proc (p),
+          chooser ("Impulse", p.getImpulseFile(), false, false, false, p.getWildcard(), {}, TRANS ("Select Impulse Response")),
+          knobs (p)
+    {
+        setOpaque (true);
+        chooser.addListener (this);
+        addAndMakeVisible (chooser);
+        addAndMakeVisible (knobs);
+        setSize (320, 140);
+    }
+
+    ~ConvolverEditor() override
+    {
+        chooser.removeListener (this);
+    }
+
+    void paint (Graphics& g) override
+    {
+        g.fillAll (Colors::widgetBackgroundColor.darker (0.1f));
+    }
+
+    void resized() override
+    {
+        auto r = getLocalBounds().reduced (4);
+        chooser.setBounds (r.removeFromTop (24));
+        r.removeFromTop (4);
+        knobs.setBounds (r);
+    }
+
+private:
+    ConvolverProcessor& proc;
+    FilenameComponent chooser;
+    KnobsComponent knobs;
+
+    void filenameComponentChanged (FilenameComponent*) override
+    {
+        if (! proc.loadImpulse (chooser.getCurrentFile()))
+            chooser.setCurrentFile (proc.getImpulseFile(), false, dontSendNotification);
+    }
+};
+
+//==============================================================================
+ConvolverProcessor::ConvolverProcessor()
+    : BaseProcessor (BusesProperties()
+                         .withInput ("Main", AudioChannelSet::stereo())
+                         .withOutput ("Main", AudioChannelSet::stereo()))
+{
+    setRateAndBufferSizeDetails (44100.0, 1024);
+    formats.registerBasicFormats();
+
+    addLegacyParameter (wetLevel = new AudioParameterFloat ("wet", "Wet Level", 0.0f, 1.0f, 0.33f));
+    addLegacyParameter (dryLevel = new AudioParameterFloat ("dry", "Dry Level", 0.0f, 1.0f, 0.4f));
+}
+
+ConvolverProcessor::~ConvolverProcessor() {}
+
+void ConvolverProcessor::fillInPluginDescription (PluginDescription& desc) const
+{
+    desc.name = getName();
+    desc.fileOrIdentifier = EL_NODE_ID_CONVOLVER;
+    desc.descriptiveName = "Convolution Reverb";
+    desc.numInputChannels = 2;
+    desc.numOutputChannels = 2;
+    desc.hasSharedContainer = false;
+    desc.isInstrument = false;
+    desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+    desc.pluginFormatName = "Element";
+    desc.version = "1.0.0";
+    desc.uniqueId = EL_NODE_UID_CONVOLVER;
+}
+
+bool ConvolverProcessor::loadImpulse (const File& file)
+{
+    std::unique_ptr<AudioFormatReader> reader;
+
+    if (auto* format = formats.findFormatForFileExtension (file.getFileExtension()))
+    {
+        if (std::unique_ptr<MemoryMappedAudioFormatReader> mapReader { format->createMemoryMappedReader (file) })
+            if (mapReader->mapEntireFile())
+                reader = std::move (mapReader);
+    }
+
+    if (reader == nullptr)
+        reader.reset (formats.createReaderFor (file));
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+        return false;
+
+    const auto maxLength = (int64) (reader->sampleRate * maxLengthSeconds);
+    const int length = (int) jmin (reader->lengthInSamples, maxLength);
+    const int numChannels = jlimit (1, 2, (int) reader->numChannels);
+
+    AudioBuffer<float> data (numChannels, length);
+    reader->read (&data, 0, length, 0, true, numChannels > 1);
+
+    impulseFile = file;
+    impulseRate = reader->sampleRate;
+    impulse = std::move (data);
+    rebuild();
+    return true;
+}
+
+void ConvolverProcessor::rebuild()
+{
+    if (impulse.getNumSamples() <= 0)
+        return;
+
+    const double rate = getSampleRate() > 0.0 ? getSampleRate() : impulseRate;
+    const double ratio = impulseRate / rate;
+    const int length = jmax (1, (int) std::ceil (impulse.getNumSamples() / ratio));
+
+    AudioBuffer<float> resampled (impulse.getNumChannels(), length);
+    for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+    {
+        if (ratio == 1.0)
+        {
+            resampled.copyFrom (ch, 0, impulse, ch, 0, length);
+            continue;
+        }
+
+        LagrangeInterpolator interpolator;
+        interpolator.process (ratio, impulse.getReadPointer (ch), resampled.getWritePointer (ch), length, impulse.getNumSamples(), 0);
+    }
+
+    // unit energy in the loudest channel, so every impulse sits at about
+    // the same level as the dry signal.
+    float energy = 0.0f;
+    for (int ch = 0; ch < resampled.getNumChannels(); ++ch)
+    {
+        const auto* samples = resampled.getReadPointer (ch);
+        float sum = 0.0f;
+        for (int i = 0; i < length; ++i)
+            sum += samples[i] * samples[i];
+        energy = jmax (energy, sum);
+    }
+
+    if (energy > 0.0f)
+        resampled.applyGain (1.0f / std::sqrt (energy));
+
+    builtRate = rate;
+    convolvers.publish (std::make_unique<Convolver> (resampled, 2));
+}
+
+void ConvolverProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    setRateAndBufferSizeDetails (sampleRate, maximumExpectedSamplesPerBlock);
+    wet.setSize (2, jmax (1, maximumExpectedSamplesPerBlock), false, true, true);
+
+    wetGain.reset (sampleRate, 0.05);
+    wetGain.setCurrentAndTargetValue (*wetLevel);
+    dryGain.reset (sampleRate, 0.05);
+    dryGain.setCurrentAndTargetValue (*dryLevel);
+
+    if (sampleRate != builtRate)
+        rebuild();
+}
+
+void ConvolverProcessor::releaseResources() {}
+
+void ConvolverProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&)
+{
+    if (auto* const next = convolvers.acquire())
+    {
+        convolvers.retire (convolver.release());
+        convolver.reset (next);
+    }
+
+    wetGain.setTargetValue (*wetLevel);
+    dryGain.setTargetValue (*dryLevel);
+
+    const int numSamples = buffer.getNumSamples();
+    const int numChans = jmin (2, buffer.getNumChannels());
+    const int chunk = wet.getNumSamples();
+
+    for (int start = 0; chunk > 0 && start < numSamples; start += chunk)
+    {
+        const int n = jmin (chunk, numSamples - start);
+
+        const float dryStart = dryGain.getCurrentValue();
+        dryGain.skip (n);
+        const float wetStart = wetGain.getCurrentValue();
+        wetGain.skip (n);
+
+        if (convolver == nullptr || numChans < 2)
+        {
+            for (int ch = 0; ch < numChans; ++ch)
+                buffer.applyGainRamp (ch, start, n, dryStart, dryGain.getCurrentValue());
+            continue;
+        }
+
+        const float* input[2] = { buffer.getReadPointer (0, start), buffer.getReadPointer (1, start) };
+        float* output[2] = { wet.getWritePointer (0), wet.getWritePointer (1) };
+        convolver->process (input, output, n);
+
+        for (int ch = 0; ch < numChans; ++ch)
+        {
+            buffer.applyGainRamp (ch, start, n, dryStart, dryGain.getCurrentValue());
+            buffer.addFromWithRamp (ch, start, wet.getReadPointer (ch), n, wetStart, wetGain.getCurrentValue());
+        }
+    }
+}
+
+AudioProcessorEditor* ConvolverProcessor::createEditor()
+{
+    return new ConvolverEditor (*this);
+}
+
+double ConvolverProcessor::getTailLengthSeconds() const
+{
+    return impulseRate > 0.0 ? impulse.getNumSamples() / impulseRate : 0.0;
+}
+
+void ConvolverProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    ValueTree state (tags::state);
+    state.setProperty ("wet", (float) *wetLevel, nullptr);
+    state.setProperty ("dry", (float) *dryLevel, nullptr);
+    state.setProperty ("irFile", impulseFile.getFullPathName(), nullptr);
+    if (auto e = state.createXml())
+        AudioProcessor::copyXmlToBinary (*e, destData);
+}
+
+void ConvolverProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    if (auto e = AudioProcessor::getXmlFromBinary (data, sizeInBytes))
+    {
+        auto state = ValueTree::fromXml (*e);
+        if (state.isValid())
+        {
+            *wetLevel = (float) state.getProperty ("wet", (float) *wetLevel);
+            *dryLevel = (float) state.getProperty ("dry", (float) *dryLevel);
+
+            const auto path = state.getProperty ("irFile").toString();
+            if (File::isAbsolutePath (path) && File (path).existsAsFile())
+                loadImpulse (File (path));
+        }
+    }
+}
+
+} // namespace element
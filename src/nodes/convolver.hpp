@@ -0,0 +1,86 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include "engine/convolver.hpp"
+#include "engine/togglegrid.hpp"
+#include "nodes/baseprocessor.hpp"
+
+namespace element {
+
+/** Stereo convolution reverb with zero latency.
+
+    Impulses are memory mapped where the format allows, resampled to the
+    device rate and normalized to unit energy. Each load builds a new
+    Convolver on the message thread and hands it to the audio thread
+    without locking.
+ */
+class ConvolverProcessor : public BaseProcessor
+{
+public:
+    /** Longest impulse used, anything after is dropped. */
+    static constexpr double maxLengthSeconds = 20.0;
+
+    ConvolverProcessor();
+    ~ConvolverProcessor() override;
+
+    const String getName() const override { return "Convolver"; }
+    void fillInPluginDescription (PluginDescription& desc) const override;
+
+    /** Load an impulse response. Returns false if the file can't be read.
+        Call on the message thread.
+     */
+    bool loadImpulse (const File& file);
+
+    /** Returns the loaded impulse file. */
+    const File& getImpulseFile() const noexcept { return impulseFile; }
+
+    /** Returns a wildcard of the formats that can be loaded. */
+    String getWildcard() const { return formats.getWildcardForAllFormats(); }
+
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override;
+
+    AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    double getTailLengthSeconds() const override;
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+
+    int getNumPrograms() override { return 1; };
+    int getCurrentProgram() override { return 1; };
+    void setCurrentProgram (int index) override { ignoreUnused (index); };
+    const String getProgramName (int index) override
+    {
+        ignoreUnused (index);
+        return "Default";
+    }
+    void changeProgramName (int index, const String& newName) override { ignoreUnused (index, newName); }
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+private:
+    AudioParameterFloat* wetLevel = nullptr;
+    AudioParameterFloat* dryLevel = nullptr;
+
+    AudioFormatManager formats;
+    File impulseFile;
+    AudioBuffer<float> impulse;
+    double impulseRate = 0.0;
+    double builtRate = 0.0;
+
+    GridExchange<Convolver> convolvers;
+    std::unique_ptr<Convolver> convolver;
+    AudioBuffer<float> wet;
+    SmoothedValue<float> wetGain, dryGain;
+
+    void rebuild();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolverProcessor)
+};
+
+} // namespace element
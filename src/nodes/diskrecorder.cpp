@@ -0,0 +1,314 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <thread>
+
+#include <element/datapath.hpp>
+#include <element/ui/style.hpp>
+
+#include "nodes/diskrecorder.hpp"
+
+namespace element {
+
+namespace {
+
+constexpr int maxChannels = 32;
+
+String getIdentifier (int numChannels)
+{
+    String id (EL_NODE_ID_DISK_RECORDER);
+    if (numChannels != 2)
+        id << "." << numChannels;
+    return id;
+}
+
+const char* getFormatName (DiskWriter::Format format)
+{
+    switch (format)
+    {
+        case DiskWriter::wav:
+            return "wav";
+        case DiskWriter::aiff:
+            return "aiff";
+        case DiskWriter::flac:
+            return "flac";
+    }
+    return "wav";
+}
+
+DiskWriter::Format getFormatNamed (const String& name)
+{
+    if (name == "aiff")
+        return DiskWriter::aiff;
+    if (name == "flac")
+        return DiskWriter::flac;
+    return DiskWriter::wav;
+}
+
+} // namespace
+
+/** Record button, format and folder, with the take's status. */
+class DiskRecorderEditor : public AudioProcessorEditor,
+                           private Timer
+{
+public:
+    DiskRecorderEditor (DiskRecorderProcessor& p)
+        : AudioProcessorEditor (p),
+          recorder (p)
+    {
+        setOpaque (true);
+
+        recordButton.setButtonText ("Record");
+        recordButton.setClickingTogglesState (true);
+        recordButton.setColour (TextButton::buttonOnColourId, Colours::red.darker (0.2f));
+        recordButton.onClick = [this]() { recorder.setRecording (recordButton.getToggleState()); };
+        addAndMakeVisible (recordButton);
+
+        formatBox.addItem ("WAV", 1 + DiskWriter::wav);
+        formatBox.addItem ("AIFF", 1 + DiskWriter::aiff);
+        formatBox.addItem ("FLAC", 1 + DiskWriter::flac);
+        formatBox.setSelectedId (1 + recorder.getFormat(), dontSendNotification);
+        formatBox.onChange = [this]() {
+            recorder.setFormat ((DiskWriter::Format) (formatBox.getSelectedId() - 1));
+        };
+        addAndMakeVisible (formatBox);
+
+        folderButton.setButtonText ("Folder...");
+        folderButton.onClick = [this]() { chooseFolder(); };
+        addAndMakeVisible (folderButton);
+
+        addAndMakeVisible (fileLabel);
+        addAndMakeVisible (statusLabel);
+
+        setSize (320, 84);
+        timerCallback();
+        startTimerHz (4);
+    }
+
+    void paint (Graphics& g) override
+    {
+        g.fillAll (Colors::widgetBackgroundColor.darker (0.1f));
+    }
+
+    void resized() override
+    {
+        auto r = getLocalBounds().reduced (4);
+        auto row = r.removeFromTop (24);
+        recordButton.setBounds (row.removeFromLeft (72));
+        row.removeFromLeft (4);
+        formatBox.setBounds (row.removeFromLeft (80));
+        row.removeFromLeft (4);
+        folderButton.setBounds (row.removeFromLeft (72));
+        r.removeFromTop (4);
+        fileLabel.setBounds (r.removeFromTop (22));
+        statusLabel.setBounds (r.removeFromTop (22));
+    }
+
+private:
+    DiskRecorderProcessor& recorder;
+    TextButton recordButton, folderButton;
+    ComboBox formatBox;
+    Label fileLabel, statusLabel;
+    std::unique_ptr<FileChooser> chooser;
+
+    void chooseFolder()
+    {
+        chooser = std::make_unique<FileChooser> ("Recordings Folder", recorder.getDirectory());
+        chooser->launchAsync (FileBrowserComponent::openMode | FileBrowserComponent::canSelectDirectories,
+                              [this] (const FileChooser& fc) {
+                                  if (fc.getResult() != File())
+                                      recorder.setDirectory (fc.getResult());
+                                  timerCallback();
+                              });
+    }
+
+    void timerCallback() override
+    {
+        recordButton.setToggleState (recorder.isRecording(), dontSendNotification);
+        formatBox.setEnabled (! recorder.isRecording());
+
+        const auto& file = recorder.getTakeFile();
+        fileLabel.setText (file != File() ? file.getFileName() : recorder.getDirectory().getFullPathName(),
+                           dontSendNotification);
+
+        String status;
+        if (recorder.isRecording())
+        {
+            const auto rate = recorder.getSampleRate() > 0.0 ? recorder.getSampleRate() : 44100.0;
+            const auto seconds = (int) (recorder.getTakeLength() / rate);
+            status << String (seconds / 60) << ":" << String (seconds % 60).paddedLeft ('0', 2);
+        }
+        if (const auto overflows = recorder.getTakeOverflows())
+            status << (status.isEmpty() ? "" : "  ") << "Overflows: " << String (overflows);
+        statusLabel.setText (status, dontSendNotification);
+    }
+};
+
+//==============================================================================
+DiskRecorderProcessor::DiskRecorderProcessor (int nc)
+    : BaseProcessor (BusesProperties()
+                         .withInput ("Main", AudioChannelSet::canonicalChannelSet (jlimit (1, maxChannels, nc)))
+                         .withOutput ("Main", AudioChannelSet::canonicalChannelSet (jlimit (1, maxChannels, nc)))),
+      numChannels (jlimit (1, maxChannels, nc)),
+      directory (DataPath::defaultRecordingsDir())
+{
+    setRateAndBufferSizeDetails (44100.0, 1024);
+    addLegacyParameter (record = new AudioParameterBool ("record", "Record", false));
+}
+
+DiskRecorderProcessor::~DiskRecorderProcessor()
+{
+    cancelPendingUpdate();
+    stopTake();
+}
+
+void DiskRecorderProcessor::fillInPluginDescription (PluginDescription& desc) const
+{
+    desc.name = getName();
+    if (numChannels != 2)
+        desc.name << " (" << numChannels << " ch)";
+    desc.fileOrIdentifier = getIdentifier (numChannels);
+    desc.descriptiveName = "Records its inputs to audio files";
+    desc.numInputChannels = numChannels;
+    desc.numOutputChannels = numChannels;
+    desc.hasSharedContainer = false;
+    desc.isInstrument = false;
+    desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+    desc.pluginFormatName = "Element";
+    desc.version = "1.0.0";
+    desc.uniqueId = EL_NODE_UID_DISK_RECORDER;
+}
+
+void DiskRecorderProcessor::setDirectory (const File& newDirectory)
+{
+    directory = newDirectory;
+}
+
+void DiskRecorderProcessor::setRecording (bool shouldRecord)
+{
+    record->setValueNotifyingHost (shouldRecord ? 1.f : 0.f);
+}
+
+void DiskRecorderProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    setRateAndBufferSizeDetails (sampleRate, maximumExpectedSamplesPerBlock);
+    // a take at the old rate is closed and a new one started.
+    triggerAsyncUpdate();
+}
+
+void DiskRecorderProcessor::releaseResources() {}
+
+void DiskRecorderProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
+{
+    midi.clear();
+
+    const bool wanted = *record;
+    if (wanted != recordWanted.exchange (wanted))
+        triggerAsyncUpdate();
+
+    rendering.store (true);
+    if (auto* const writer = liveTake.load())
+        if (wanted)
+            writer->write (buffer.getArrayOfReadPointers(), jmin (numChannels, buffer.getNumChannels()), buffer.getNumSamples());
+    renderEpoch.fetch_add (1);
+    rendering.store (false);
+}
+
+void DiskRecorderProcessor::handleAsyncUpdate()
+{
+    const bool wanted = recordWanted.load();
+    if (take != nullptr && (! wanted || take->getSampleRate() != getSampleRate()))
+        stopTake();
+    if (wanted && take == nullptr)
+        startTake();
+}
+
+void DiskRecorderProcessor::startTake()
+{
+    if (! directory.createDirectory())
+    {
+        Logger::writeToLog ("[element] disk recorder: can't create " + directory.getFullPathName());
+        return;
+    }
+
+    const auto name = Time::getCurrentTime().formatted ("Take %Y-%m-%d %H-%M-%S");
+    auto file = directory.getChildFile (name + DiskWriter::getFileExtension (format)).getNonexistentSibling();
+
+    DiskWriter::Options options;
+    options.format = format;
+    // FLAC stops at 24 bits.
+    options.bitsPerSample = format == DiskWriter::flac ? jmin (24, bitsPerSample) : bitsPerSample;
+    options.sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    options.numChannels = numChannels;
+
+    take = DiskWriter::create (file, options);
+    if (take == nullptr)
+    {
+        Logger::writeToLog ("[element] disk recorder: can't write " + file.getFullPathName());
+        return;
+    }
+
+    takeFile = file;
+    lastOverflows = 0;
+    liveTake.store (take.get());
+}
+
+void DiskRecorderProcessor::stopTake()
+{
+    if (take == nullptr)
+        return;
+
+    // a block that started before the store may still be writing, wait
+    // for it. Only this thread waits, never the audio one.
+    liveTake.store (nullptr);
+    const auto epoch = renderEpoch.load();
+    while (rendering.load() && renderEpoch.load() == epoch)
+        std::this_thread::yield();
+
+    lastOverflows = take->getNumOverflows();
+    if (lastOverflows > 0)
+        Logger::writeToLog ("[element] disk recorder: " + takeFile.getFileName() + " dropped "
+                            + String (take->getNumDropped()) + " samples in "
+                            + String (lastOverflows) + " overflows");
+    take.reset();
+}
+
+int64 DiskRecorderProcessor::getMemoryUsage() const
+{
+    auto* const writer = liveTake.load();
+    return writer != nullptr ? (int64) writer->getNumBytes() : 0;
+}
+
+AudioProcessorEditor* DiskRecorderProcessor::createEditor()
+{
+    return new DiskRecorderEditor (*this);
+}
+
+void DiskRecorderProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    ValueTree state (tags::state);
+    state.setProperty ("directory", directory.getFullPathName(), nullptr);
+    state.setProperty ("format", getFormatName (format), nullptr);
+    state.setProperty ("bitsPerSample", bitsPerSample, nullptr);
+    if (auto e = state.createXml())
+        AudioProcessor::copyXmlToBinary (*e, destData);
+}
+
+void DiskRecorderProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    ValueTree state;
+    if (auto e = AudioProcessor::getXmlFromBinary (data, sizeInBytes))
+        state = ValueTree::fromXml (*e);
+    if (! state.isValid())
+        return;
+
+    const auto path = state.getProperty ("directory").toString();
+    if (File::isAbsolutePath (path))
+        setDirectory (File (path));
+    format = getFormatNamed (state.getProperty ("format").toString());
+    bitsPerSample = (int) state.getProperty ("bitsPerSample", bitsPerSample);
+    if (bitsPerSample != 16 && bitsPerSample != 24 && bitsPerSample != 32)
+        bitsPerSample = 24;
+}
+
+} // namespace element
@@ -0,0 +1,107 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include "engine/diskwriter.hpp"
+#include "nodes/baseprocessor.hpp"
+
+namespace element {
+
+/** Records its inputs to audio files, passing them through unchanged.
+
+    Each time Record is switched on a new take is started in the
+    recordings folder. The file is opened on the message thread, so a
+    take starts a few milliseconds after the switch, it ends on the block
+    the switch goes off.
+ */
+class DiskRecorderProcessor : public BaseProcessor,
+                              private juce::AsyncUpdater
+{
+public:
+    explicit DiskRecorderProcessor (int numChannels = 2);
+    ~DiskRecorderProcessor() override;
+
+    const String getName() const override { return "Disk Recorder"; }
+    void fillInPluginDescription (PluginDescription& desc) const override;
+
+    /** Where takes are written. Message thread. */
+    void setDirectory (const File& newDirectory);
+    const File& getDirectory() const noexcept { return directory; }
+
+    /** The file format of the next take. Message thread. */
+    void setFormat (DiskWriter::Format newFormat) noexcept { format = newFormat; }
+    DiskWriter::Format getFormat() const noexcept { return format; }
+
+    /** Start or stop recording. Same as changing the Record parameter. */
+    void setRecording (bool shouldRecord);
+
+    /** Returns true while a take is being written. Message thread. */
+    bool isRecording() const noexcept { return take != nullptr; }
+
+    /** Returns the file of the current take, or of the last one. */
+    const File& getTakeFile() const noexcept { return takeFile; }
+
+    /** Returns the samples written to the current take. */
+    int64 getTakeLength() const noexcept { return take != nullptr ? take->getNumWritten() : 0; }
+
+    /** Returns the blocks the current take dropped because the disk fell
+        behind, and those of the last take once it's closed.
+     */
+    int64 getTakeOverflows() const noexcept { return take != nullptr ? take->getNumOverflows() : lastOverflows; }
+
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi) override;
+
+    int64 getMemoryUsage() const override;
+
+    AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+
+    int getNumPrograms() override { return 1; };
+    int getCurrentProgram() override { return 1; };
+    void setCurrentProgram (int index) override { ignoreUnused (index); };
+    const String getProgramName (int index) override
+    {
+        ignoreUnused (index);
+        return "Default";
+    }
+    void changeProgramName (int index, const String& newName) override { ignoreUnused (index, newName); }
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+private:
+    const int numChannels;
+    AudioParameterBool* record = nullptr;
+    File directory;
+    DiskWriter::Format format = DiskWriter::wav;
+    int bitsPerSample = 24;
+
+    // message thread
+    std::unique_ptr<DiskWriter> take;
+    File takeFile;
+    int64 lastOverflows = 0;
+
+    // The audio thread writes to liveTake. It's cleared and any block in
+    // flight waited for before a take is closed, so no lock is needed.
+    std::atomic<DiskWriter*> liveTake { nullptr };
+    std::atomic<bool> recordWanted { false };
+    std::atomic<bool> rendering { false };
+    std::atomic<uint32> renderEpoch { 0 };
+
+    void startTake();
+    void stopTake();
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiskRecorderProcessor)
+};
+
+} // namespace element
@@ -44,21 +44,17 @@ void EQFilterProcessor::fillInPluginDescription (PluginDescription& desc) const
 
 void EQFilterProcessor::updateParams()
 {
-    for (int ch = 0; ch < 2; ++ch)
-    {
-        eqFilter[ch].setFrequency (*freq);
-        eqFilter[ch].setQ (*q);
-        eqFilter[ch].setGain (Decibels::decibelsToGain ((float) *gainDB));
-        eqFilter[ch].setShape ((EQFilter::Shape) eqShape->getIndex());
-    }
+    eqFilter.setFrequency (*freq);
+    eqFilter.setQ (*q);
+    eqFilter.setGain (Decibels::decibelsToGain ((float) *gainDB));
+    eqFilter.setShape ((EQFilter::Shape) eqShape->getIndex());
 }
 
 void EQFilterProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
 {
     updateParams();
 
-    for (int ch = 0; ch < 2; ++ch)
-        eqFilter[ch].reset (sampleRate);
+    eqFilter.reset (sampleRate);
 
     setPlayConfigDetails (numChannels, numChannels, sampleRate, maximumExpectedSamplesPerBlock);
 }
@@ -66,12 +62,9 @@ void EQFilterProcessor::prepareToPlay (double sampleRate, int maximumExpectedSam
 void EQFilterProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&)
 {
     const int numChans = jmin (2, buffer.getNumChannels());
-    auto output = buffer.getArrayOfWritePointers();
 
     updateParams();
-
-    for (int c = 0; c < numChans; ++c)
-        eqFilter[c].processBlock (output[c], buffer.getNumSamples());
+    eqFilter.processBlock (buffer.getArrayOfWritePointers(), numChans, buffer.getNumSamples());
 }
 
 AudioProcessorEditor* EQFilterProcessor::createEditor()
@@ -9,10 +9,18 @@
 
 namespace element {
 
-/* Filter for a single EQ band */
+/* Filter for a single EQ band.
+
+   One filter runs every channel of a signal: coefficients are computed once
+   for all of them, and channels are filtered in pairs so two independent
+   recursions share each loop iteration.
+*/
 class EQFilter
 {
 public:
+    /** Most channels one filter can run. */
+    static constexpr int maxChannels = 8;
+
     enum Shape
     {
         Bell,
@@ -196,32 +204,52 @@ public:
         a[2] = (phi - K + 1.0f) / a0;
     }
 
-    inline float process (float x)
+    inline float process (float x, int channel = 0)
     {
         // process input sample, direct form II transposed
-        float y = z[1] + x * b[0];
+        auto& zc = z[channel];
+        float y = zc[0] + x * b[0];
 
-        z[1] = z[2] + x * b[1] - y * a[1];
-        z[2] = x * b[2] - y * a[2];
+        zc[0] = zc[1] + x * b[1] - y * a[1];
+        zc[1] = x * b[2] - y * a[2];
 
         return y;
     }
 
     void processBlock (float* buffer, int numSamples)
     {
-        for (int n = 0; n < numSamples; n++)
+        processBlock (&buffer, 1, numSamples);
+    }
+
+    /** Filter channels in place, with the same coefficients for each. */
+    void processBlock (float* const* channels, int numChannels, int numSamples)
+    {
+        numChannels = jmin (numChannels, maxChannels);
+
+        // per sample coefficients only while a parameter is moving.
+        int n = 0;
+        for (; n < numSamples && isSmoothing(); ++n)
         {
-            if (freq.isSmoothing() || Q.isSmoothing() || gain.isSmoothing())
-                calcCoefs (freq.getNextValue(), Q.getNextValue(), gain.getNextValue());
-            buffer[n] = process (buffer[n]);
+            calcCoefs (freq.getNextValue(), Q.getNextValue(), gain.getNextValue());
+            for (int ch = 0; ch < numChannels; ++ch)
+                channels[ch][n] = process (channels[ch][n], ch);
         }
+
+        if (n >= numSamples)
+            return;
+
+        int ch = 0;
+        for (; ch + 2 <= numChannels; ch += 2)
+            processPair (channels[ch] + n, channels[ch + 1] + n, ch, numSamples - n);
+        if (ch < numChannels)
+            processSingle (channels[ch] + n, ch, numSamples - n);
     }
 
     void reset (double sampleRate)
     {
         // clear state
-        for (int n = 0; n < 3; ++n)
-            z[n] = 0.0f;
+        for (auto& zc : z)
+            zc[0] = zc[1] = 0.0f;
 
         fs = (float) sampleRate;
         calcCoefs (freq.skip (smoothSteps), Q.skip (smoothSteps), gain.skip (smoothSteps));
@@ -301,6 +329,51 @@ public:
     }
 
 private:
+    bool isSmoothing() const noexcept { return freq.isSmoothing() || Q.isSmoothing() || gain.isSmoothing(); }
+
+    void processSingle (float* x, int channel, int numSamples) noexcept
+    {
+        const float b0 = b[0], b1 = b[1], b2 = b[2], a1 = a[1], a2 = a[2];
+        float z1 = z[channel][0], z2 = z[channel][1];
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const float in = x[n];
+            const float y = z1 + in * b0;
+            z1 = z2 + in * b1 - y * a1;
+            z2 = in * b2 - y * a2;
+            x[n] = y;
+        }
+
+        z[channel][0] = z1;
+        z[channel][1] = z2;
+    }
+
+    void processPair (float* l, float* r, int channel, int numSamples) noexcept
+    {
+        const float b0 = b[0], b1 = b[1], b2 = b[2], a1 = a[1], a2 = a[2];
+        float lz1 = z[channel][0], lz2 = z[channel][1];
+        float rz1 = z[channel + 1][0], rz2 = z[channel + 1][1];
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const float lin = l[n], rin = r[n];
+            const float ly = lz1 + lin * b0;
+            const float ry = rz1 + rin * b0;
+            lz1 = lz2 + lin * b1 - ly * a1;
+            rz1 = rz2 + rin * b1 - ry * a1;
+            lz2 = lin * b2 - ly * a2;
+            rz2 = rin * b2 - ry * a2;
+            l[n] = ly;
+            r[n] = ry;
+        }
+
+        z[channel][0] = lz1;
+        z[channel][1] = lz2;
+        z[channel + 1][0] = rz1;
+        z[channel + 1][1] = rz2;
+    }
+
     SmoothedValue<float, ValueSmoothingTypes::Linear> freq;
     SmoothedValue<float, ValueSmoothingTypes::Linear> Q;
     SmoothedValue<float, ValueSmoothingTypes::Linear> gain;
@@ -312,7 +385,7 @@ private:
 
     float b[3] = { 1.0f, 0.0f, 0.0f };
     float a[3] = { 1.0f, 0.0f, 0.0f };
-    float z[3] = { 0.0f, 0.0f, 0.0f };
+    float z[maxChannels][2] = {};
 
     float fs = 44100.0f;
 
@@ -334,7 +407,7 @@ public:
     void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override;
 
     void updateParams();
-    float getMagnitudeAtFreq (float freq) { return eqFilter[0].getMagnitudeAtFreq (freq); }
+    float getMagnitudeAtFreq (float freq) { return eqFilter.getMagnitudeAtFreq (freq); }
 
     AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -386,7 +459,7 @@ private:
     AudioParameterFloat* q = nullptr;
     AudioParameterFloat* gainDB = nullptr;
     AudioParameterChoice* eqShape = nullptr;
-    EQFilter eqFilter[2];
+    EQFilter eqFilter;
 };
 
 } // namespace element
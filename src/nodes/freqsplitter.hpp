@@ -4,22 +4,19 @@
 
 #pragma once
 
+#include "engine/crossover.hpp"
 #include "nodes/baseprocessor.hpp"
 #include "ElementApp.h"
-#include "nodes/eqfilter.hpp"
 
 namespace element {
 class FreqSplitterProcessor : public BaseProcessor
 {
 public:
-    explicit FreqSplitterProcessor (const int _numChannels = 2)
-        : BaseProcessor (BusesProperties()
-                             .withInput ("Main", AudioChannelSet::canonicalChannelSet (jlimit (1, 2, _numChannels)))
-                             .withOutput ("Low", AudioChannelSet::canonicalChannelSet (jlimit (1, 2, _numChannels)))
-                             .withOutput ("Mid", AudioChannelSet::canonicalChannelSet (jlimit (1, 2, _numChannels)))
-                             .withOutput ("High", AudioChannelSet::canonicalChannelSet (jlimit (1, 2, _numChannels)))),
+    explicit FreqSplitterProcessor (const int _numChannels = 2, const int _numBands = 3)
+        : BaseProcessor (makeBuses (jlimit (1, 2, _numChannels), jlimit (Crossover::minBands, Crossover::maxBands, _numBands))),
+          numBands (jlimit (Crossover::minBands, Crossover::maxBands, _numBands)),
           numChannelsIn (jlimit (1, 2, _numChannels)),
-          numChannelsOut (3 * numChannelsIn)
+          numChannelsOut (numBands * numChannelsIn)
     {
         setBusesLayout (getBusesLayout());
         setRateAndBufferSizeDetails (44100.0, 1024);
@@ -27,16 +24,34 @@ public:
         NormalisableRange<float> freqRange (20.0f, 22000.0f);
         freqRange.setSkewForCentre (1000.0f);
 
-        addLegacyParameter (lowFreq = new AudioParameterFloat ("lowFreq", "Low Frequency [Hz]", freqRange, 500.0f));
-        addLegacyParameter (highFreq = new AudioParameterFloat ("highFreq", "High Frequency [Hz]", freqRange, 2000.0f));
+        // spread around 1 kHz, 500 Hz and 2 kHz for the classic three bands.
+        const int numSplits = numBands - 1;
+        const float ratio = numSplits > 1 ? jmin (4.0f, std::pow (200.0f, 1.0f / (float) (numSplits - 1))) : 1.0f;
+        for (int i = 0; i < numSplits; ++i)
+        {
+            const float freq = 1000.0f * std::pow (ratio, (float) i - (float) (numSplits - 1) * 0.5f);
+            addLegacyParameter (frequencies[i] = new AudioParameterFloat ("freq" + String (i + 1),
+                                                                          "Crossover " + String (i + 1) + " [Hz]",
+                                                                          freqRange,
+                                                                          freq));
+        }
+
+        crossover.setNumBands (numBands);
     }
 
     const String getName() const override { return "Frequency Band Splitter"; }
 
+    int getNumBands() const noexcept { return numBands; }
+
     void fillInPluginDescription (PluginDescription& desc) const override
     {
         desc.name = getName();
         desc.fileOrIdentifier = EL_NODE_ID_FREQ_SPLITTER;
+        if (numBands != 3)
+        {
+            desc.name << " (" << numBands << " bands)";
+            desc.fileOrIdentifier << "." << numBands;
+        }
         desc.descriptiveName = "Frequency Band Splitter";
         desc.numInputChannels = numChannelsIn;
         desc.numOutputChannels = numChannelsOut;
@@ -50,21 +65,12 @@ public:
 
     void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override
     {
-        const float butterQ = 0.7071f; // maximally flat passband
-        auto setupFilter = [butterQ, sampleRate] (EQFilter& filt, float freq, EQFilter::Shape shape) {
-            filt.setFrequency (freq);
-            filt.setQ (butterQ);
-            filt.setGain (1.0f);
-            filt.setShape (shape);
-            filt.reset (sampleRate);
-        };
-
-        for (int ch = 0; ch < 2; ++ch)
+        crossover.prepare (sampleRate);
+        for (int i = 0; i < numBands - 1; ++i)
         {
-            setupFilter (lowLPF[ch], *lowFreq, EQFilter::Shape::LowPass);
-            setupFilter (lowHPF[ch], *lowFreq, EQFilter::Shape::HighPass);
-            setupFilter (highLPF[ch], *highFreq, EQFilter::Shape::LowPass);
-            setupFilter (highHPF[ch], *highFreq, EQFilter::Shape::HighPass);
+            smoothed[i].reset (sampleRate, 0.02);
+            smoothed[i].setCurrentAndTargetValue (*frequencies[i]);
+            crossover.setFrequency (i, *frequencies[i]);
         }
 
         setBusesLayout (getBusesLayout());
@@ -77,42 +83,46 @@ public:
 
     void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
     {
-        auto inBuffer = getBusBuffer (buffer, true, 0);
-        auto lowBuffer = getBusBuffer (buffer, false, 0);
-        auto midBuffer = getBusBuffer (buffer, false, 1);
-        auto highBuffer = getBusBuffer (buffer, false, 2);
-
-        const auto numChannels = inBuffer.getNumChannels();
+        const auto inBuffer = getBusBuffer (buffer, true, 0);
+        const auto numChannels = jmin (inBuffer.getNumChannels(), Crossover::maxChannels);
         const auto numSamples = buffer.getNumSamples();
 
-        // copy input into extra output channels
+        const float* input[Crossover::maxChannels] = {};
+        float* output[Crossover::maxBands * Crossover::maxChannels] = {};
         for (int ch = 0; ch < numChannels; ++ch)
+            input[ch] = inBuffer.getReadPointer (ch);
+        for (int band = 0; band < numBands; ++band)
         {
-            lowBuffer.copyFrom (ch, 0, inBuffer.getReadPointer (ch), numSamples);
-            midBuffer.copyFrom (ch, 0, inBuffer.getReadPointer (ch), numSamples);
-            highBuffer.copyFrom (ch, 0, inBuffer.getReadPointer (ch), numSamples);
+            auto bandBuffer = getBusBuffer (buffer, false, band);
+            if (bandBuffer.getNumChannels() < numChannels)
+                return;
+            for (int ch = 0; ch < numChannels; ++ch)
+                output[band * numChannels + ch] = bandBuffer.getWritePointer (ch);
         }
 
-        // update filter parameters
-        for (int c = 0; c < 2; ++c)
+        bool smoothing = false;
+        for (int i = 0; i < numBands - 1; ++i)
         {
-            lowLPF[c].setFrequency (*lowFreq);
-            lowHPF[c].setFrequency (*lowFreq);
-            highLPF[c].setFrequency (*highFreq);
-            highHPF[c].setFrequency (*highFreq);
+            smoothed[i].setTargetValue (*frequencies[i]);
+            smoothing |= smoothed[i].isSmoothing();
         }
 
-        for (int ch = 0; ch < numChannels; ++ch)
+        // while a frequency moves, redesign every few samples.
+        const int step = smoothing ? smoothStep : numSamples;
+        for (int start = 0; start < numSamples; start += step)
         {
-            // Low freq band
-            lowLPF[ch].processBlock (lowBuffer.getWritePointer (ch), numSamples);
-
-            // Mid freq band
-            lowHPF[ch].processBlock (midBuffer.getWritePointer (ch), numSamples);
-            highLPF[ch].processBlock (midBuffer.getWritePointer (ch), numSamples);
-
-            // High freq band
-            highHPF[ch].processBlock (highBuffer.getWritePointer (ch), numSamples);
+            const int n = jmin (step, numSamples - start);
+            for (int i = 0; i < numBands - 1; ++i)
+                crossover.setFrequency (i, smoothed[i].skip (n));
+
+            const float* in[Crossover::maxChannels];
+            float* out[Crossover::maxBands * Crossover::maxChannels];
+            for (int ch = 0; ch < numChannels; ++ch)
+                in[ch] = input[ch] + start;
+            for (int i = 0; i < numBands * numChannels; ++i)
+                out[i] = output[i] + start;
+
+            crossover.process (in, out, numChannels, n);
         }
     }
 
@@ -136,8 +146,8 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override
     {
         ValueTree state (tags::state);
-        state.setProperty ("lowFreq", (float) *lowFreq, 0);
-        state.setProperty ("highFreq", (float) *highFreq, 0);
+        for (int i = 0; i < numBands - 1; ++i)
+            state.setProperty (frequencies[i]->paramID, (float) *frequencies[i], 0);
         if (auto e = state.createXml())
             AudioProcessor::copyXmlToBinary (*e, destData);
     }
@@ -149,8 +159,15 @@ public:
             auto state = ValueTree::fromXml (*e);
             if (state.isValid())
             {
-                *lowFreq = (float) state.getProperty ("lowFreq", (float) *lowFreq);
-                *highFreq = (float) state.getProperty ("highFreq", (float) *highFreq);
+                // sessions from before the crossover had two fixed splits.
+                if (numBands == 3)
+                {
+                    *frequencies[0] = (float) state.getProperty ("lowFreq", (float) *frequencies[0]);
+                    *frequencies[1] = (float) state.getProperty ("highFreq", (float) *frequencies[1]);
+                }
+
+                for (int i = 0; i < numBands - 1; ++i)
+                    *frequencies[i] = (float) state.getProperty (frequencies[i]->paramID, (float) *frequencies[i]);
             }
         }
     }
@@ -164,12 +181,12 @@ public:
 protected:
     inline bool isBusesLayoutSupported (const BusesLayout& layout) const override
     {
-        // supports single input bus, three output busses
-        if (layout.inputBuses.size() != 1 && layout.outputBuses.size() != 3)
+        // supports single input bus, one output bus per band
+        if (layout.inputBuses.size() != 1 || layout.outputBuses.size() != numBands)
             return false;
 
         // ins must equal outs
-        for (int bus = 0; bus < 3; ++bus)
+        for (int bus = 0; bus < numBands; ++bus)
         {
             if (layout.getMainInputChannels() != layout.outputBuses[bus].size())
                 return false;
@@ -187,14 +204,33 @@ protected:
     }
 
 private:
+    static constexpr int smoothStep = 32;
+
+    const int numBands;
     int numChannelsIn = 0;
     int numChannelsOut = 0;
-    AudioParameterFloat* lowFreq = nullptr;
-    AudioParameterFloat* highFreq = nullptr;
-    EQFilter lowLPF[2];
-    EQFilter lowHPF[2];
-    EQFilter highLPF[2];
-    EQFilter highHPF[2];
+    AudioParameterFloat* frequencies[Crossover::maxSplits] = {};
+    SmoothedValue<float, ValueSmoothingTypes::Multiplicative> smoothed[Crossover::maxSplits];
+    Crossover crossover;
+
+    static BusesProperties makeBuses (int numChannels, int bands)
+    {
+        const auto set = AudioChannelSet::canonicalChannelSet (numChannels);
+        BusesProperties buses;
+        buses = buses.withInput ("Main", set);
+        for (int band = 0; band < bands; ++band)
+        {
+            String name;
+            if (band == 0)
+                name = "Low";
+            else if (band == bands - 1)
+                name = "High";
+            else
+                name = bands == 3 ? String ("Mid") : String ("Band ") + String (band + 1);
+            buses = buses.withOutput (name, set);
+        }
+        return buses;
+    }
 };
 
 } // namespace element
@@ -0,0 +1,129 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "nodes/limiter.hpp"
+
+namespace element {
+
+LimiterProcessor::LimiterProcessor (const int _numChannels)
+    : BaseProcessor (BusesProperties()
+                         .withInput ("Main", AudioChannelSet::canonicalChannelSet (jlimit (1, 2, _numChannels)))
+                         .withOutput ("Main", AudioChannelSet::canonicalChannelSet (jlimit (1, 2, _numChannels)))),
+      numChannels (jlimit (1, 2, _numChannels))
+{
+    setBusesLayout (getBusesLayout());
+    setRateAndBufferSizeDetails (44100.0, 1024);
+
+    NormalisableRange<float> releaseRange (1.0f, 1000.0f);
+    releaseRange.setSkewForCentre (100.0f);
+
+    NormalisableRange<float> lookaheadRange (0.1f, (float) PeakLimiter::maxLookaheadMs);
+    lookaheadRange.setSkewForCentre (2.0f);
+
+    addLegacyParameter (gainDB = new AudioParameterFloat ("gain", "Gain [dB]", 0.0f, 24.0f, 0.0f));
+    addLegacyParameter (ceilingDB = new AudioParameterFloat ("ceiling", "Ceiling [dB]", -24.0f, 0.0f, -1.0f));
+    addLegacyParameter (releaseMs = new AudioParameterFloat ("release", "Release [ms]", releaseRange, 100.0f));
+    addLegacyParameter (lookaheadMs = new AudioParameterFloat ("lookahead", "Lookahead [ms]", lookaheadRange, 2.0f));
+    addLegacyParameter (detection = new AudioParameterChoice ("detection", "Detection", { "True Peak", "Sample Peak" }, 0));
+
+    inputGain.reset (200);
+}
+
+void LimiterProcessor::fillInPluginDescription (PluginDescription& desc) const
+{
+    desc.name = getName();
+    desc.fileOrIdentifier = EL_NODE_ID_LIMITER;
+    desc.descriptiveName = "Lookahead brickwall limiter";
+    desc.numInputChannels = numChannels;
+    desc.numOutputChannels = numChannels;
+    desc.hasSharedContainer = false;
+    desc.isInstrument = false;
+    desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+    desc.pluginFormatName = "Element";
+    desc.version = "1.0.0";
+    desc.uniqueId = EL_NODE_UID_LIMITER;
+}
+
+void LimiterProcessor::updateParams()
+{
+    inputGain.setTargetValue (Decibels::decibelsToGain ((float) *gainDB));
+    limiter.setCeilingDecibels (*ceilingDB);
+    limiter.setReleaseMs (*releaseMs);
+    limiter.setTruePeak (detection->getIndex() == 0);
+    limiter.setLookaheadMs ((double) *lookaheadMs);
+
+    // the graph picks this up and moves its delay compensation.
+    if (getLatencySamples() != limiter.getLatencySamples())
+        setLatencySamples (limiter.getLatencySamples());
+}
+
+void LimiterProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    setBusesLayout (getBusesLayout());
+    setRateAndBufferSizeDetails (sampleRate, maximumExpectedSamplesPerBlock);
+
+    limiter.prepare (sampleRate, numChannels, jmax (1, maximumExpectedSamplesPerBlock));
+    inputGain.setCurrentAndTargetValue (Decibels::decibelsToGain ((float) *gainDB));
+    updateParams();
+}
+
+void LimiterProcessor::releaseResources() {}
+
+void LimiterProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&)
+{
+    updateParams();
+
+    const int numSamples = buffer.getNumSamples();
+    const int numChans = jmin (numChannels, buffer.getNumChannels());
+    if (inputGain.isSmoothing())
+    {
+        const float start = inputGain.getCurrentValue();
+        inputGain.skip (numSamples);
+        for (int ch = 0; ch < numChans; ++ch)
+            buffer.applyGainRamp (ch, 0, numSamples, start, inputGain.getCurrentValue());
+    }
+    else if (inputGain.getCurrentValue() != 1.0f)
+    {
+        for (int ch = 0; ch < numChans; ++ch)
+            buffer.applyGain (ch, 0, numSamples, inputGain.getCurrentValue());
+    }
+
+    limiter.process (buffer.getArrayOfWritePointers(), numChans, numSamples);
+}
+
+AudioProcessorEditor* LimiterProcessor::createEditor()
+{
+    auto* ed = new GenericAudioProcessorEditor (*this);
+    ed->resized();
+    return ed;
+}
+
+void LimiterProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    ValueTree state (tags::state);
+    state.setProperty ("gain", (float) *gainDB, 0);
+    state.setProperty ("ceiling", (float) *ceilingDB, 0);
+    state.setProperty ("release", (float) *releaseMs, 0);
+    state.setProperty ("lookahead", (float) *lookaheadMs, 0);
+    state.setProperty ("detection", detection->getIndex(), 0);
+    if (auto e = state.createXml())
+        AudioProcessor::copyXmlToBinary (*e, destData);
+}
+
+void LimiterProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    if (auto e = AudioProcessor::getXmlFromBinary (data, sizeInBytes))
+    {
+        auto state = ValueTree::fromXml (*e);
+        if (state.isValid())
+        {
+            *gainDB = (float) state.getProperty ("gain", (float) *gainDB);
+            *ceilingDB = (float) state.getProperty ("ceiling", (float) *ceilingDB);
+            *releaseMs = (float) state.getProperty ("release", (float) *releaseMs);
+            *lookaheadMs = (float) state.getProperty ("lookahead", (float) *lookaheadMs);
+            *detection = (int) state.getProperty ("detection", 0);
+        }
+    }
+}
+
+} // namespace element
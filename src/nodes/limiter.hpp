@@ -0,0 +1,85 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include "engine/peaklimiter.hpp"
+#include "nodes/baseprocessor.hpp"
+#include "ElementApp.h"
+
+namespace element {
+
+/** Lookahead brickwall limiter, for protecting outputs. Reports its
+    lookahead as latency so the graph compensates it.
+ */
+class LimiterProcessor : public BaseProcessor
+{
+public:
+    explicit LimiterProcessor (const int _numChannels = 2);
+
+    const String getName() const override { return "Limiter"; }
+
+    void fillInPluginDescription (PluginDescription& desc) const override;
+
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override;
+
+    AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    double getTailLengthSeconds() const override { return 0.0; };
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+
+    int getNumPrograms() override { return 1; };
+    int getCurrentProgram() override { return 1; };
+    void setCurrentProgram (int index) override { ignoreUnused (index); };
+    const String getProgramName (int index) override
+    {
+        ignoreUnused (index);
+        return "Parameter";
+    }
+    void changeProgramName (int index, const String& newName) override { ignoreUnused (index, newName); }
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+    int64 getMemoryUsage() const override { return (int64) limiter.getNumBytes(); }
+
+protected:
+    inline bool isBusesLayoutSupported (const BusesLayout& layout) const override
+    {
+        if (layout.getMainInputChannels() != layout.getMainOutputChannels())
+            return false;
+        const auto nchans = layout.getMainInputChannels();
+        return nchans >= 1 && nchans <= 2;
+    }
+
+    inline bool canApplyBusesLayout (const BusesLayout& layouts) const override { return isBusesLayoutSupported (layouts); }
+    inline bool canApplyBusCountChange (bool isInput, bool isAddingBuses, BusProperties& outNewBusProperties) override
+    {
+        ignoreUnused (isInput, isAddingBuses, outNewBusProperties);
+        return false;
+    }
+
+private:
+    /** Pass the parameters to the limiter, and the latency to the host if
+        they changed it.
+     */
+    void updateParams();
+
+    const int numChannels;
+    AudioParameterFloat* gainDB = nullptr;
+    AudioParameterFloat* ceilingDB = nullptr;
+    AudioParameterFloat* releaseMs = nullptr;
+    AudioParameterFloat* lookaheadMs = nullptr;
+    AudioParameterChoice* detection = nullptr;
+
+    SmoothedValue<float, ValueSmoothingTypes::Multiplicative> inputGain = 1.0f;
+    PeakLimiter limiter;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LimiterProcessor)
+};
+
+} // namespace element
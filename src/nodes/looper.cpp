@@ -0,0 +1,248 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <element/ui/style.hpp>
+
+#include "nodes/looper.hpp"
+
+namespace element {
+
+namespace {
+
+const char* getStateName (Looper::State state)
+{
+    switch (state)
+    {
+        case Looper::empty:
+            return "Empty";
+        case Looper::recording:
+            return "Recording";
+        case Looper::playing:
+            return "Playing";
+        case Looper::overdubbing:
+            return "Overdubbing";
+        case Looper::stopped:
+            return "Stopped";
+    }
+    return "";
+}
+
+} // namespace
+
+/** A button for each action, the quantize choice and the loop's state. */
+class LooperEditor : public AudioProcessorEditor,
+                     private Timer
+{
+public:
+    LooperEditor (LooperProcessor& p, AudioParameterChoice& q)
+        : AudioProcessorEditor (p),
+          looper (p),
+          quantize (q)
+    {
+        setOpaque (true);
+
+        const char* names[] = { "Rec", "Dub", "Play", "Stop", "Undo", "Clear" };
+        for (int i = 0; i < 6; ++i)
+        {
+            auto* button = buttons.add (new TextButton (names[i]));
+            const auto action = (Looper::Action) (i + 1);
+            button->onClick = [this, action]() { looper.trigger (action); };
+            addAndMakeVisible (button);
+        }
+
+        quantizeBox.addItemList (quantize.choices, 1);
+        quantizeBox.setSelectedItemIndex (quantize.getIndex(), dontSendNotification);
+        quantizeBox.onChange = [this]() {
+            quantize.setValueNotifyingHost (quantize.convertTo0to1 ((float) quantizeBox.getSelectedItemIndex()));
+        };
+        addAndMakeVisible (quantizeBox);
+        addAndMakeVisible (statusLabel);
+
+        setSize (360, 64);
+        timerCallback();
+        startTimerHz (10);
+    }
+
+    void paint (Graphics& g) override
+    {
+        g.fillAll (Colors::widgetBackgroundColor.darker (0.1f));
+    }
+
+    void resized() override
+    {
+        auto r = getLocalBounds().reduced (4);
+        auto row = r.removeFromTop (24);
+        const int width = row.getWidth() / buttons.size();
+        for (auto* button : buttons)
+            button->setBounds (row.removeFromLeft (width).reduced (1, 0));
+        r.removeFromTop (4);
+        row = r.removeFromTop (24);
+        quantizeBox.setBounds (row.removeFromLeft (80));
+        row.removeFromLeft (6);
+        statusLabel.setBounds (row);
+    }
+
+private:
+    LooperProcessor& looper;
+    AudioParameterChoice& quantize;
+    OwnedArray<TextButton> buttons;
+    ComboBox quantizeBox;
+    Label statusLabel;
+
+    void timerCallback() override
+    {
+        const auto& lp = looper.getLooper();
+        const auto state = lp.getState();
+        buttons[0]->setColour (TextButton::buttonColourId, state == Looper::recording ? Colours::red.darker (0.2f) : Colours::transparentBlack);
+        buttons[1]->setColour (TextButton::buttonColourId, state == Looper::overdubbing ? Colours::orange.darker (0.2f) : Colours::transparentBlack);
+
+        if (quantizeBox.getSelectedItemIndex() != quantize.getIndex())
+            quantizeBox.setSelectedItemIndex (quantize.getIndex(), dontSendNotification);
+
+        const auto rate = looper.getSampleRate() > 0.0 ? looper.getSampleRate() : 44100.0;
+        String status (getStateName (state));
+        if (lp.getLength() > 0)
+            status << "  " << String (lp.getPosition() / rate, 1) << " / "
+                   << String (lp.getLength() / rate, 1) << " s"
+                   << "  " << String (lp.getNumLayers()) << " layers";
+        statusLabel.setText (status, dontSendNotification);
+    }
+};
+
+//==============================================================================
+LooperProcessor::LooperProcessor()
+    : BaseProcessor (BusesProperties()
+                         .withInput ("Main", AudioChannelSet::stereo())
+                         .withOutput ("Main", AudioChannelSet::stereo()))
+{
+    setRateAndBufferSizeDetails (44100.0, 1024);
+    const char* ids[] = { "record", "overdub", "play", "stop", "undo", "clear" };
+    const char* names[] = { "Record", "Overdub", "Play", "Stop", "Undo", "Clear" };
+    for (int i = 0; i < numActions; ++i)
+        addLegacyParameter (actions[i] = new AudioParameterBool (ids[i], names[i], false));
+    addLegacyParameter (quantize = new AudioParameterChoice ("quantize", "Quantize", StringArray ({ "Off", "Beat", "Bar" }), 2));
+}
+
+LooperProcessor::~LooperProcessor()
+{
+    cancelPendingUpdate();
+}
+
+void LooperProcessor::fillInPluginDescription (PluginDescription& desc) const
+{
+    desc.name = getName();
+    desc.fileOrIdentifier = EL_NODE_ID_LOOPER;
+    desc.descriptiveName = "Loops its input with overdubs, quantized to the transport";
+    desc.numInputChannels = 2;
+    desc.numOutputChannels = 2;
+    desc.hasSharedContainer = false;
+    desc.isInstrument = false;
+    desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+    desc.pluginFormatName = "Element";
+    desc.version = "1.0.0";
+    desc.uniqueId = EL_NODE_UID_LOOPER;
+}
+
+void LooperProcessor::trigger (Looper::Action action)
+{
+    if (action > Looper::none && action <= numActions)
+        actions[action - 1]->setValueNotifyingHost (1.f);
+}
+
+void LooperProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    setRateAndBufferSizeDetails (sampleRate, maximumExpectedSamplesPerBlock);
+    looper.prepare (getTotalNumInputChannels(), sampleRate);
+    pending = Looper::none;
+}
+
+void LooperProcessor::releaseResources() {}
+
+void LooperProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
+{
+    midi.clear();
+    const int nframes = buffer.getNumSamples();
+
+    bool switchedOn = false;
+    for (int i = 0; i < numActions; ++i)
+    {
+        const bool on = *actions[i];
+        if (on && ! wasOn[i])
+        {
+            // the latest action replaces one still waiting for its beat.
+            pending = (Looper::Action) (i + 1);
+            seen[i].store (true);
+            switchedOn = true;
+        }
+        wasOn[i] = on;
+    }
+
+    auto action = Looper::none;
+    int64 frame = 0;
+    if (pending != Looper::none)
+    {
+        if (quantize->getIndex() > 0)
+        {
+            if (auto* const playhead = getPlayHead())
+            {
+                // quantizing needs a clock, with the transport stopped
+                // actions land at once.
+                const auto pos = playhead->getPosition();
+                if (pos.hasValue() && pos->getIsPlaying())
+                {
+                    const auto bpm = pos->getBpm().orFallback (120.0);
+                    const auto sig = pos->getTimeSignature().orFallback (AudioPlayHead::TimeSignature());
+                    const double beats = quantize->getIndex() == 1 ? 1.0 : (double) jmax (1, sig.numerator);
+                    frame = Looper::framesToBoundary (pos->getPpqPosition().orFallback (0.0), beats, getSampleRate() * 60.0 / jmax (1.0, bpm));
+                }
+            }
+        }
+
+        if (frame < nframes)
+        {
+            action = pending;
+            pending = Looper::none;
+        }
+    }
+
+    looper.process (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), nframes, action, (int) frame);
+
+    if (switchedOn || looper.needsCleaning())
+        triggerAsyncUpdate();
+}
+
+void LooperProcessor::handleAsyncUpdate()
+{
+    // switch actions back off so the next press is seen, whatever the
+    // control mapped to them does on release.
+    for (int i = 0; i < numActions; ++i)
+        if (seen[i].exchange (false))
+            actions[i]->setValueNotifyingHost (0.f);
+    looper.clean();
+}
+
+AudioProcessorEditor* LooperProcessor::createEditor()
+{
+    return new LooperEditor (*this, *quantize);
+}
+
+void LooperProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    ValueTree state (tags::state);
+    state.setProperty ("quantize", quantize->getIndex(), nullptr);
+    if (auto e = state.createXml())
+        AudioProcessor::copyXmlToBinary (*e, destData);
+}
+
+void LooperProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    ValueTree state;
+    if (auto e = AudioProcessor::getXmlFromBinary (data, sizeInBytes))
+        state = ValueTree::fromXml (*e);
+    if (! state.isValid())
+        return;
+
+    *quantize = jlimit (0, quantize->choices.size() - 1, (int) state.getProperty ("quantize", quantize->getIndex()));
+}
+
+} // namespace element
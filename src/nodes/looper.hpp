@@ -0,0 +1,78 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include "engine/looper.hpp"
+#include "nodes/baseprocessor.hpp"
+
+namespace element {
+
+/** Loops its input with overdubs, quantized to the transport.
+
+    Record, Overdub, Play, Stop, Undo and Clear are parameters so they
+    can be mapped to MIDI controls. Each acts when it's switched on, and
+    is switched back off after, so a toggling or momentary control both
+    work. While the transport plays, actions wait for the next beat or
+    bar and land on its exact sample.
+ */
+class LooperProcessor : public BaseProcessor,
+                        private juce::AsyncUpdater
+{
+public:
+    LooperProcessor();
+    ~LooperProcessor() override;
+
+    const String getName() const override { return "Looper"; }
+    void fillInPluginDescription (PluginDescription& desc) const override;
+
+    /** Trigger an action as if its parameter was switched on. */
+    void trigger (Looper::Action action);
+
+    const Looper& getLooper() const noexcept { return looper; }
+
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi) override;
+
+    int64 getMemoryUsage() const override { return (int64) looper.getNumBytes(); }
+
+    AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+
+    int getNumPrograms() override { return 1; };
+    int getCurrentProgram() override { return 1; };
+    void setCurrentProgram (int index) override { ignoreUnused (index); };
+    const String getProgramName (int index) override
+    {
+        ignoreUnused (index);
+        return "Default";
+    }
+    void changeProgramName (int index, const String& newName) override { ignoreUnused (index, newName); }
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+private:
+    static constexpr int numActions = 6;
+    Looper looper;
+    AudioParameterBool* actions[numActions] {};
+    AudioParameterChoice* quantize = nullptr;
+    std::atomic<bool> seen[numActions] {}; // switched on, to switch off
+
+    // audio thread
+    bool wasOn[numActions] {};
+    Looper::Action pending = Looper::none;
+
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LooperProcessor)
+};
+
+} // namespace element
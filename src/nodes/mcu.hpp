@@ -7,6 +7,7 @@
 #include <element/processor.hpp>
 #include <element/porttype.hpp>
 
+#include "engine/mcusurface.hpp"
 #include "nodes/nodetypes.hpp"
 #include <element/ui/style.hpp>
 
@@ -25,7 +26,7 @@ class MackieControlUniversal : public Processor,
 {
 public:
     MackieControlUniversal()
-        : Processor (PortCount().with (PortType::Midi, 1, 0).with (PortType::Control, 0, 9).toPortList()) {}
+        : Processor (PortCount().with (PortType::Midi, 1, 1).with (PortType::Control, 0, 9).toPortList()) {}
     ~MackieControlUniversal() {}
 
     /** Open the device. e.g. go online. */
@@ -35,6 +36,7 @@ public:
         data[4] = 0x63;
 
         sendMidi (MidiMessage::createSysExMessage (data, 5));
+        surface.invalidate();
     }
 
     void close()
@@ -46,11 +48,15 @@ public:
         col.addMessageToQueue (msg.withTimeStamp ((double) Time::getMillisecondCounter() / 1000.0));
     }
 
+    /** Surface state. Set it from anywhere, changes are sent in batches. */
+    McuSurface& getSurface() noexcept { return surface; }
+
     //==========================================================================
     void prepareToRender (double sampleRate, int maxBufferSize) override
     {
-        ignoreUnused (sampleRate, maxBufferSize);
+        ignoreUnused (maxBufferSize);
         col.reset (sampleRate);
+        surface.prepare (sampleRate);
     }
 
     void releaseResources() override {}
@@ -59,12 +65,10 @@ public:
     void render (RenderContext& rc) override
     {
         auto buf = rc.midi.getWriteBuffer (0);
-        for (const auto msg : *buf)
-        {
-            juce::ignoreUnused (msg);
-        }
+        surface.handleInput (*buf);
         rc.midi.clear();
         col.removeNextBlockOfMessages (*buf, rc.audio.getNumSamples());
+        surface.process (*buf, rc.audio.getNumSamples());
     }
 
     void getState (MemoryBlock&) override {}
@@ -103,6 +107,7 @@ public:
 private:
     CriticalSection lock;
     juce::MidiMessageCollector col;
+    McuSurface surface;
 };
 
 class MackieControlEditor : public NodeEditor
@@ -138,7 +143,7 @@ public:
         fader.setRange (0.0, 16383.0, 1.0);
         fader.setSliderStyle (Slider::LinearVertical);
         fader.onValueChange = [this]() {
-            proc()->sendMidi (MidiMessage::pitchWheel (1, roundToInt (fader.getValue())));
+            proc()->getSurface().setFader (0, roundToInt (fader.getValue()));
         };
 
         setSize (300, 500);
@@ -165,6 +165,8 @@ MediaPlayerProcessor::MediaPlayerProcessor()
     addLegacyParameter (volume = new AudioParameterFloat ("volume", "Volume", -60.f, 12.f, 0.f));
     for (auto* const param : getParameters())
         param->addListener (this);
+    formats.registerBasicFormats();
+    player.setLooping (true);
 }
 
 MediaPlayerProcessor::~MediaPlayerProcessor()
@@ -193,9 +195,8 @@ void MediaPlayerProcessor::fillInPluginDescription (PluginDescription& desc) con
 
 void MediaPlayerProcessor::clearPlayer()
 {
-    player.setSource (nullptr);
-    if (reader)
-        reader = nullptr;
+    player.stop();
+    player.setStream (nullptr);
     *playing = player.isPlaying();
 }
 
@@ -203,34 +204,23 @@ void MediaPlayerProcessor::openFile (const File& file)
 {
     if (file == audioFile)
         return;
-    if (auto* newReader = formats.createReaderFor (file))
+    if (auto stream = DiskStream::open (formats, file))
     {
         clearPlayer();
-        reader.reset (new AudioFormatReaderSource (newReader, true));
         audioFile = file;
-        player.setSource (reader.get(), 1024 * 8, &thread, getSampleRate(), 2);
-        ScopedLock sl (getCallbackLock());
-        player.setLooping (true);
-        reader->setLooping (true);
+        player.setStream (std::move (stream));
     }
 }
 
 void MediaPlayerProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
 {
-    thread.startThread();
-    formats.registerBasicFormats();
     player.prepareToPlay (maximumExpectedSamplesPerBlock, sampleRate);
-    player.setLooping (true);
-    if (reader)
-        reader->setLooping (true);
 }
 
 void MediaPlayerProcessor::releaseResources()
 {
     player.stop();
     player.releaseResources();
-    formats.clearFormats();
-    thread.stopThread (14);
 }
 
 void MediaPlayerProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "engine/diskstream.hpp"
 #include "nodes/baseprocessor.hpp"
 
 namespace element {
@@ -31,6 +32,7 @@ public:
     void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
     void releaseResources() override;
     void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
+    int64 getMemoryUsage() const override { return player.getMemoryUsage(); }
 
     bool canAddBus (bool isInput) const override
     {
@@ -68,7 +70,7 @@ public:
     void parameterValueChanged (int parameterIndex, float newValue) override;
     void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override;
 
-    AudioTransportSource& getPlayer() { return player; }
+    DiskStreamPlayer& getPlayer() { return player; }
 
 protected:
     bool isBusesLayoutSupported (const BusesLayout&) const override;
@@ -105,10 +107,8 @@ protected:
 #endif
 
 private:
-    TimeSliceThread thread { "MediaPlayer" };
-    std::unique_ptr<AudioFormatReaderSource> reader;
     AudioFormatManager formats;
-    AudioTransportSource player;
+    DiskStreamPlayer player;
 
     AudioParameterBool* slave { nullptr };
     AudioParameterBool* playing { nullptr };
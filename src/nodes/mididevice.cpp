@@ -1,6 +1,8 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <thread>
+
 #include "nodes/mididevice.hpp"
 #include "engine/midiengine.hpp"
 #include <element/ui/style.hpp>
@@ -149,6 +151,8 @@ MidiDeviceProcessor::MidiDeviceProcessor (const bool isInput, MidiEngine& me)
       midi (me)
 {
     setPlayConfigDetails (0, 0, 44100.0, 1024);
+    if (inputDevice)
+        inputMessages.setSysexCapacity (sysexCapacity);
 }
 
 MidiDeviceProcessor::~MidiDeviceProcessor() noexcept
@@ -203,19 +207,14 @@ void MidiDeviceProcessor::setDevice (const MidiDeviceInfo& newDevice)
     }
     else
     {
-        if (output)
-        {
-            output->stopBackgroundThread();
-            output->clearAllPendingMessages();
-            output.reset();
-        }
-
+        closeOutput();
         output = MidiOutput::openDevice (deviceWanted.identifier);
 
         if (output)
         {
             output->clearAllPendingMessages();
             output->startBackgroundThread();
+            liveOutput.store (output.get());
             device = deviceWanted;
         }
         else
@@ -250,16 +249,7 @@ Result MidiDeviceProcessor::closeDevice()
     }
     else
     {
-        if (output)
-        {
-            output->clearAllPendingMessages();
-            std::unique_ptr<MidiOutput> closer;
-            {
-                ScopedLock sl (getCallbackLock());
-                std::swap (output, closer);
-            }
-            closer.reset();
-        }
+        closeOutput();
     }
 
     suspendProcessing (wasSuspended);
@@ -268,6 +258,23 @@ Result MidiDeviceProcessor::closeDevice()
     return Result::ok();
 }
 
+void MidiDeviceProcessor::closeOutput()
+{
+    if (output == nullptr)
+        return;
+
+    // a block that started before the store may still be sending, wait
+    // for it. Only this thread waits, never the audio one.
+    liveOutput.store (nullptr);
+    const auto epoch = renderEpoch.load();
+    while (rendering.load() && renderEpoch.load() == epoch)
+        std::this_thread::yield();
+
+    output->stopBackgroundThread();
+    output->clearAllPendingMessages();
+    output.reset();
+}
+
 bool MidiDeviceProcessor::isDeviceOpen() const
 {
     if (inputDevice)
@@ -275,8 +282,7 @@ bool MidiDeviceProcessor::isDeviceOpen() const
         return device.identifier.isNotEmpty() && deviceWanted.identifier == device.identifier;
     }
 
-    ScopedLock sl (getCallbackLock());
-    return output != nullptr;
+    return liveOutput.load() != nullptr;
 }
 
 void MidiDeviceProcessor::reload()
@@ -312,20 +318,24 @@ void MidiDeviceProcessor::processBlock (AudioBuffer<float>& audio, MidiBuffer& m
     if (inputDevice)
     {
         midi.clear (0, nframes);
-        inputMessages.removeNextBlockOfMessages (midi, nframes);
+        inputMessages.render (midi, nframes, MidiInputQueue::now());
     }
     else
     {
-        if (output && ! midi.isEmpty())
+        rendering.store (true);
+        auto* const out = liveOutput.load();
+        if (out != nullptr && ! midi.isEmpty())
         {
             const auto delayMs = midiOutLatency.get();
 #if JUCE_WINDOWS
-            output->sendBlockOfMessagesNow (midi);
+            out->sendBlockOfMessagesNow (midi);
 #else
-            output->sendBlockOfMessages (
+            out->sendBlockOfMessages (
                 midi, delayMs + Time::getMillisecondCounterHiRes(), getSampleRate());
 #endif
         }
+        renderEpoch.fetch_add (1);
+        rendering.store (false);
 
         midi.clear (0, nframes);
     }
@@ -381,11 +391,14 @@ void MidiDeviceProcessor::handleIncomingMidiMessage (MidiInput* source, const Mi
 {
     if (message.isActiveSense())
         return;
-    inputMessages.addMessageToQueue (message);
+    // full, or SysEx too large for the ring: dropped rather than blocking.
+    inputMessages.push (message);
 }
 
 void MidiDeviceProcessor::handlePartialSysexMessage (MidiInput* source, const uint8* messageData, int numBytesSoFar, double timestamp)
 {
+    // the input assembles SysEx itself and hands over the whole message
+    // once it's complete, so the pieces aren't needed.
     ignoreUnused (source, messageData, numBytesSoFar, timestamp);
 }
 
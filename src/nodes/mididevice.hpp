@@ -4,6 +4,7 @@
 #pragma once
 
 #include <element/signals.hpp>
+#include "engine/midiinputqueue.hpp"
 #include "nodes/baseprocessor.hpp"
 
 namespace element {
@@ -147,16 +148,26 @@ protected:
 #endif
 
 private:
+    /** Bytes of SysEx an input can hold between blocks. */
+    static constexpr int sysexCapacity = 64 * 1024;
+
     const bool inputDevice;
     MidiEngine& midi;
     bool prepared = false;
     MidiDeviceInfo device; // actual device name in use;
     MidiDeviceInfo deviceWanted; // The device as saved in Stage and chosen by users.
-    MidiMessageCollector inputMessages;
+    MidiInputQueue inputMessages;
     std::unique_ptr<MidiInput> input;
     std::unique_ptr<MidiOutput> output;
     Atomic<double> midiOutLatency { 0.0 };
 
+    // The audio thread sends to liveOutput. It's cleared and any block in
+    // flight waited for before output is closed, so no lock is needed.
+    std::atomic<MidiOutput*> liveOutput { nullptr };
+    std::atomic<bool> rendering { false };
+    std::atomic<uint32> renderEpoch { 0 };
+    void closeOutput();
+
     void waitForDevice() {}
     void timerCallback() override;
     bool deviceIsAvailable (const String& name);
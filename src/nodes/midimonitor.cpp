@@ -9,7 +9,9 @@ MidiMonitorNode::MidiMonitorNode()
     : MidiFilterNode (0)
 {
     setName ("MIDI Monitor");
-    midiTemp.ensureSize (3 * 32);
+    log.resize ((size_t) maxLoggedMessages);
+    incoming.resize ((size_t) MidiCapture::capacity);
+    startTime = Time::getMillisecondCounterHiRes() * 0.001;
 }
 
 MidiMonitorNode::~MidiMonitorNode()
@@ -20,9 +22,8 @@ MidiMonitorNode::~MidiMonitorNode()
 
 void MidiMonitorNode::prepareToRender (double sampleRate, int maxBufferSize)
 {
-    inputMessages.reset (sampleRate);
+    ignoreUnused (maxBufferSize);
     currentSampleRate = sampleRate;
-    numSamples = 0;
     startTimerHz (refreshRateHz);
 };
 
@@ -33,99 +34,93 @@ void MidiMonitorNode::releaseResources()
 
 void MidiMonitorNode::render (RenderContext& rc)
 {
-    auto timestamp = Time::getMillisecondCounterHiRes();
     const auto nframes = rc.audio.getNumSamples();
-
     if (nframes == 0)
         return;
 
     auto* const midiIn = rc.midi.getWriteBuffer (0);
+    if (midiIn->isEmpty())
+        return;
 
-    for (auto m : *midiIn)
-    {
-        auto msg = m.getMessage();
-        msg.setTimeStamp (timestamp + (1000.0 * (static_cast<double> (m.samplePosition) / currentSampleRate)));
-        inputMessages.addMessageToQueue (msg);
-    }
+    const auto timestamp = Time::getMillisecondCounterHiRes() * 0.001;
+    for (const auto m : *midiIn)
+        capture.push (m.data, m.numBytes, timestamp + (double) m.samplePosition / currentSampleRate);
+}
 
-    ScopedLock sl (lock);
-    numSamples += nframes;
+void MidiMonitorNode::getState (MemoryBlock& block)
+{
+    ValueTree state (tags::state);
+    state.setProperty ("filter", (int) capture.getFilter(), nullptr);
+    MemoryOutputStream stream (block, false);
+    state.writeToStream (stream);
 }
 
-void MidiMonitorNode::getMessages (MidiBuffer& destBuffer)
+void MidiMonitorNode::setState (const void* data, int size)
 {
-    ScopedLock sl (lock);
-    if (numSamples <= 0)
-        return;
-    inputMessages.removeNextBlockOfMessages (destBuffer, numSamples);
-    numSamples = 0;
+    const auto state = ValueTree::readFromData (data, (size_t) size);
+    if (state.isValid() && state.hasProperty ("filter"))
+        capture.setFilter ((uint32) (int) state.getProperty ("filter"));
 }
 
 void MidiMonitorNode::clearMessages()
 {
-    midiLog.clearQuick();
-    {
-        ScopedLock sl (lock);
-        inputMessages.reset (currentSampleRate);
-        numSamples = 0;
-    }
+    capture.discard();
+    capture.resetCounters();
+    logStart = logSize = 0;
+    startTime = Time::getMillisecondCounterHiRes() * 0.001;
     messagesLogged();
 }
 
+String MidiMonitorNode::describe (const MidiCapture::Event& ev) const
+{
+    String text (String (ev.time - startTime, 3).paddedLeft (' ', 10));
+    text << "  ";
+
+    const auto kind = MidiCapture::getKind (ev.data, ev.size);
+    if (kind == MidiCapture::sysex)
+        return text << "SysEx (" << ev.size << " bytes)";
+
+    const auto msg = ev.toMessage();
+    if (msg.isMidiStart())
+        text << "Start";
+    else if (msg.isMidiStop())
+        text << "Stop";
+    else if (msg.isMidiContinue())
+        text << "Continue";
+    else if (msg.isNoteOnOrOff())
+        text << (msg.isNoteOn() ? "Note On " : "Note Off ")
+             << MidiMessage::getMidiNoteName (msg.getNoteNumber(), true, true, 5)
+             << " (" << msg.getNoteNumber() << ") "
+             << " Velocity " << msg.getVelocity()
+             << " Channel " << msg.getChannel();
+    else
+        text << msg.getDescription();
+
+    return text;
+}
+
 void MidiMonitorNode::timerCallback()
 {
-    midiTemp.clear();
-    getMessages (midiTemp);
-    if (midiTemp.getNumEvents() <= 0)
+    const int numRead = capture.pop (incoming.data(), (int) incoming.size());
+    if (numRead <= 0)
         return;
 
-    int numLogged = 0;
-    String text;
-    for (auto m : midiTemp)
+    // only the newest maxLoggedMessages are kept, older ones are overwritten.
+    for (int i = jmax (0, numRead - maxLoggedMessages); i < numRead; ++i)
     {
-        auto msg = m.getMessage();
-        if (msg.isMidiClock())
+        if (logSize < maxLoggedMessages)
         {
-            text.clear();
-            continue;
+            log[(size_t) ((logStart + logSize) % maxLoggedMessages)] = incoming[(size_t) i];
+            ++logSize;
         }
-
-        if (msg.isMidiStart())
-            text << "Start";
-        else if (msg.isMidiStop())
-            text << "Stop";
-        else if (msg.isMidiContinue())
-            text << "Continue";
-
-        if (text.isNotEmpty()) {
-            midiLog.add(text);
-        } else if (msg.isNoteOn()) {
-            text.clear();
-            text << "Note On "
-                 << msg.getMidiNoteName(msg.getNoteNumber(), true, true, 5)
-                 << " ("  << msg.getNoteNumber() << ") "
-                 << " Velocity " << msg.getVelocity()
-                 << " Channel " << msg.getChannel();
-        } else if (msg.isNoteOff()) {
-            text.clear();
-            text << "Note Off "
-                 << msg.getMidiNoteName(msg.getNoteNumber(), true, true, 5)
-                 << " ("  << msg.getNoteNumber() << ") "
-                 << " Velocity " << msg.getVelocity()
-                 << " Channel " << msg.getChannel();
-        } else {
-            midiLog.add (msg.getDescription());
+        else
+        {
+            log[(size_t) logStart] = incoming[(size_t) i];
+            logStart = (logStart + 1) % maxLoggedMessages;
         }
-
-        text.clear();
-        ++numLogged;
     }
 
-    if (midiLog.size() > maxLoggedMessages)
-        midiLog.removeRange (0, midiLog.size() - maxLoggedMessages);
-
-    if (numLogged > 0)
-        messagesLogged();
+    messagesLogged();
 }
 
 }; // namespace element
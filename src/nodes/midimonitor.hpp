@@ -4,6 +4,7 @@
 #pragma once
 
 #include <element/midipipe.hpp>
+#include "engine/midicapture.hpp"
 #include "nodes/baseprocessor.hpp"
 #include "nodes/midifilter.hpp"
 #include <element/signals.hpp>
@@ -51,29 +52,50 @@ public:
 
     void render (RenderContext& rc) override;
 
-    void setState (const void* data, int size) override {};
-    void getState (MemoryBlock& block) override {};
+    void setState (const void* data, int size) override;
+    void getState (MemoryBlock& block) override;
 
     void clearMessages();
 
-    const StringArray& logger() const { return midiLog; }
+    /** Returns the kinds of message logged, see MidiCapture::Kind. */
+    uint32 getFilter() const noexcept { return capture.getFilter(); }
+
+    /** Change the kinds of message logged. Anything else is skipped on
+        the audio thread before it's captured.
+     */
+    void setFilter (uint32 kinds) { capture.setFilter (kinds); }
+
+    /** Returns the number of messages in the log. */
+    int getNumLogged() const noexcept { return logSize; }
+
+    /** Returns a logged message, 0 is the oldest. */
+    const MidiCapture::Event& getLogged (int index) const noexcept
+    {
+        return log[(size_t) ((logStart + index) % maxLoggedMessages)];
+    }
+
+    /** Returns a line of text for a logged message. */
+    String describe (const MidiCapture::Event& ev) const;
+
+    /** Returns the number of messages lost because the log couldn't keep up. */
+    int64 getNumDropped() const noexcept { return capture.getNumDropped(); }
 
 private:
     friend class MidiMonitorNodeEditor;
     friend class MidiMonitorBlock;
     Signal<void()> messagesLogged;
     double currentSampleRate = 44100.0;
-    int numSamples = 0;
-    MidiMessageCollector inputMessages;
     bool createdPorts = false;
-    CriticalSection lock;
 
-    MidiBuffer midiTemp;
-    StringArray midiLog;
-    int maxLoggedMessages { 100 };
+    MidiCapture capture;
+    static constexpr int maxLoggedMessages = 1000;
+    std::vector<MidiCapture::Event> log;
+    std::vector<MidiCapture::Event> incoming;
+    int logStart = 0;
+    int logSize = 0;
+    double startTime = 0.0;
     float refreshRateHz { 60.0 };
 
-    void getMessages (MidiBuffer& destBuffer);
     void timerCallback() override;
 };
 
@@ -32,24 +32,23 @@ public:
         node = nullptr;
     }
 
-    int getNumRows() override { return node->logger().size(); }
+    int getNumRows() override { return node->getNumLogged(); }
 
+    // only visible rows are painted, so text is only made for those.
     void paintListBoxItem (int row, Graphics& g, int width, int height, bool rowIsSelected) override
     {
-        const auto& logList = node->logger();
         ignoreUnused (rowIsSelected);
         g.setFont (Font (Font::getDefaultMonospacedFontName(),
                          g.getCurrentFont().getHeight(),
                          Font::plain));
-        if (isPositiveAndBelow (row, logList.size()))
-            ViewHelpers::drawBasicTextRow (logList[row], g, width, height, false);
+        if (isPositiveAndBelow (row, node->getNumLogged()))
+            ViewHelpers::drawBasicTextRow (node->describe (node->getLogged (row)), g, width, height, false);
     }
 
     void handleAsyncUpdate() override
     {
-        const auto& logList = node->logger();
         updateContent();
-        scrollToEnsureRowIsOnscreen (logList.size() - 1);
+        scrollToEnsureRowIsOnscreen (node->getNumLogged() - 1);
         repaint();
     }
 
@@ -72,22 +71,79 @@ MidiMonitorNodeEditor::MidiMonitorNodeEditor (const Node& node)
             n->clearMessages();
     };
 
+    addAndMakeVisible (filterButton);
+    filterButton.setButtonText ("Filter");
+    filterButton.onClick = [this]() { showFilterMenu(); };
+
+    addAndMakeVisible (droppedLabel);
+    droppedLabel.setJustificationType (Justification::centredRight);
+    if (auto* n = getNodeObjectOfType<MidiMonitorNode>())
+        loggedConnection = n->messagesLogged.connect ([this]() { updateDropped(); });
+
     setSize (320 * 1.2, 160 * 1.2);
     setResizable (true);
 }
 
 MidiMonitorNodeEditor::~MidiMonitorNodeEditor()
 {
+    loggedConnection.disconnect();
     logger.reset();
 }
 
 void MidiMonitorNodeEditor::resized()
 {
     auto r1 = getLocalBounds().reduced (4);
+    auto top = r1.removeFromTop (24);
     clearButton.changeWidthToFitText (24);
-    clearButton.setBounds (r1.getX(), r1.getY(), clearButton.getWidth(), clearButton.getHeight());
-    r1.removeFromTop (24 + 2);
+    clearButton.setBounds (top.removeFromLeft (clearButton.getWidth()));
+    top.removeFromLeft (4);
+    filterButton.changeWidthToFitText (24);
+    filterButton.setBounds (top.removeFromLeft (filterButton.getWidth()));
+    droppedLabel.setBounds (top);
+    r1.removeFromTop (2);
     logger->setBounds (r1);
 }
 
+void MidiMonitorNodeEditor::updateDropped()
+{
+    if (auto* n = getNodeObjectOfType<MidiMonitorNode>())
+    {
+        const auto dropped = n->getNumDropped();
+        droppedLabel.setText (dropped > 0 ? String ("Dropped: ") + String (dropped) : String(),
+                              dontSendNotification);
+    }
+}
+
+void MidiMonitorNodeEditor::showFilterMenu()
+{
+    auto* n = getNodeObjectOfType<MidiMonitorNode>();
+    if (n == nullptr)
+        return;
+
+    const std::pair<uint32, const char*> kinds[] = {
+        { MidiCapture::notes, "Notes" },
+        { MidiCapture::controllers, "Controllers" },
+        { MidiCapture::programs, "Program Changes" },
+        { MidiCapture::pitchBend, "Pitch Bend" },
+        { MidiCapture::pressure, "Pressure" },
+        { MidiCapture::clock, "Clock" },
+        { MidiCapture::transport, "Start / Stop" },
+        { MidiCapture::sysex, "SysEx" },
+        { MidiCapture::other, "Other" }
+    };
+
+    PopupMenu menu;
+    const auto filter = n->getFilter();
+    for (const auto& kind : kinds)
+    {
+        const auto bit = kind.first;
+        menu.addItem (TRANS (kind.second), true, (filter & bit) != 0, [this, bit]() {
+            if (auto* node = getNodeObjectOfType<MidiMonitorNode>())
+                node->setFilter (node->getFilter() ^ bit);
+        });
+    }
+
+    menu.showMenuAsync (PopupMenu::Options().withTargetComponent (&filterButton));
+}
+
 }; // namespace element
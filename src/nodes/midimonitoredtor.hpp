@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <element/signals.hpp>
 #include <element/ui/nodeeditor.hpp>
 
 namespace element {
@@ -20,6 +21,12 @@ private:
     class Logger;
     std::unique_ptr<Logger> logger;
     TextButton clearButton;
+    TextButton filterButton;
+    Label droppedLabel;
+    SignalConnection loggedConnection;
+
+    void updateDropped();
+    void showFilterMenu();
 };
 
 } // namespace element
@@ -14,9 +14,7 @@ MidiRouterNode::MidiRouterNode (int ins, int outs)
     : Processor (0),
       numSources (ins),
       numDestinations (outs),
-      state (ins, outs),
-      toggles (ins, outs),
-      nextToggles (ins, outs)
+      state (ins, outs)
 {
     setName ("MIDI Router");
     clearPatches();
@@ -67,14 +65,7 @@ void MidiRouterNode::setMatrixState (const MatrixState& matrix)
 {
     jassert (state.sameSizeAs (matrix));
     state = matrix;
-    ToggleGrid newPatches (state);
-
-    {
-        ScopedLock sl (getLock());
-        toggles.swapWith (newPatches);
-        togglesChanged = true; // initiate the crossfade
-    }
-
+    grids.publish (state);
     sendChangeMessage();
 }
 
@@ -91,16 +82,23 @@ void MidiRouterNode::render (RenderContext& rc)
     const auto nbuffers = rc.midi.getNumBuffers();
     rc.audio.clear();
 
-    ScopedLock sl (getLock());
-    for (int src = 0; src < numSources; ++src)
+    if (auto* next = grids.acquire())
     {
-        if (src >= nbuffers)
-            break;
+        grids.retire (toggles.release());
+        toggles.reset (next);
+    }
 
-        const auto& rb = *rc.midi.getReadBuffer (src);
-        for (int dst = 0; dst < numDestinations; ++dst)
-            if (toggles.get (src, dst))
-                midiOuts.getUnchecked (dst)->addEvents (rb, 0, nsamples, 0);
+    if (toggles != nullptr)
+    {
+        const int ins = jmin (numSources, nbuffers, toggles->getNumInputs());
+        const int outs = jmin (numDestinations, toggles->getNumOutputs());
+        for (int src = 0; src < ins; ++src)
+        {
+            const auto& rb = *rc.midi.getReadBuffer (src);
+            for (int dst = 0; dst < outs; ++dst)
+                if (toggles->get (src, dst))
+                    midiOuts.getUnchecked (dst)->addEvents (rb, 0, nsamples, 0);
+        }
     }
 
     for (int i = midiOuts.size(); --i >= 0;)
@@ -133,25 +131,19 @@ void MidiRouterNode::setState (const void* data, int sizeInBytes)
 void MidiRouterNode::setWithoutLocking (int src, int dst, bool set)
 {
     jassert (src >= 0 && src < numSources && dst >= 0 && dst < numDestinations);
-    toggles.set (src, dst, set);
     state.set (src, dst, set);
+    grids.publish (state);
 }
 
 void MidiRouterNode::set (int src, int dst, bool patched)
 {
     jassert (src >= 0 && src < numSources && dst >= 0 && numDestinations < 4);
-    toggles.set (src, dst, patched);
     state.set (src, dst, patched);
+    grids.publish (state);
 }
 
 void MidiRouterNode::clearPatches()
 {
-    {
-        ScopedLock sl (getLock());
-        toggles.clear();
-        nextToggles.clear();
-    }
-
     for (int r = 0; r < state.getNumRows(); ++r)
         for (int c = 0; c < state.getNumColumns(); ++c)
             state.set (r, c, false);
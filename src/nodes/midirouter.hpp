@@ -28,7 +28,6 @@ public:
     void setMatrixState (const MatrixState&);
     MatrixState getMatrixState() const;
     void setWithoutLocking (int src, int dst, bool set);
-    CriticalSection& getLock() { return lock; }
 
     int getNumPrograms() const override { return jmax (1, programs.size()); }
     int getCurrentProgram() const override { return currentProgram; }
@@ -74,7 +73,6 @@ public:
     }
 
 private:
-    CriticalSection lock;
     const int numSources;
     const int numDestinations;
 
@@ -96,9 +94,9 @@ private:
     // used by the UI, but not the rendering
     MatrixState state;
 
-    ToggleGrid toggles;
-    ToggleGrid nextToggles;
-    bool togglesChanged { false };
+    // published to the audio thread, which owns the grid it's routing with.
+    ToggleGridExchange grids;
+    std::unique_ptr<ToggleGrid> toggles;
 
     OwnedArray<MidiBuffer> midiOuts;
     void initMidiOuts (OwnedArray<MidiBuffer>& outs);
@@ -16,7 +16,12 @@ MidiSetListProcessor::MidiSetListProcessor (Context& ctx)
     setName ("MIDI Set List");
 }
 
-MidiSetListProcessor::~MidiSetListProcessor() {}
+MidiSetListProcessor::~MidiSetListProcessor()
+{
+    cancelPendingUpdate();
+    if (auto e = _context.audio())
+        e->setUpcomingProgram (-1);
+}
 
 void MidiSetListProcessor::clear()
 {
@@ -149,8 +154,11 @@ void MidiSetListProcessor::addProgramEntry (const String& name, int programIn, i
     entry->tempo = 0.0;
     sendChangeMessage();
 
-    ScopedLock sl (lock);
-    programMap[entry->in] = entry->out;
+    {
+        ScopedLock sl (lock);
+        programMap[entry->in] = entry->out;
+    }
+    updateUpcomingProgram();
 }
 
 void MidiSetListProcessor::editProgramEntry (int index,
@@ -166,9 +174,12 @@ void MidiSetListProcessor::editProgramEntry (int index,
         entry->in = inProgram;
         entry->out = outProgram;
         entry->tempo = tempo;
-        ScopedLock sl (lock);
-        programMap[entry->in] = entry->out;
+        {
+            ScopedLock sl (lock);
+            programMap[entry->in] = entry->out;
+        }
         sendChangeMessage();
+        updateUpcomingProgram();
     }
 }
 
@@ -179,9 +190,12 @@ void MidiSetListProcessor::removeProgramEntry (int index)
     {
         entries.remove (index, false);
         deleter.reset (entry);
-        ScopedLock sl (lock);
-        programMap[entry->in] = -1;
+        {
+            ScopedLock sl (lock);
+            programMap[entry->in] = -1;
+        }
         sendChangeMessage();
+        updateUpcomingProgram();
     }
 }
 
@@ -197,7 +211,25 @@ void MidiSetListProcessor::handleAsyncUpdate()
     const auto program = getLastProgram();
     if (isPositiveAndBelow (program, getNumProgramEntries()))
         maybeSendTempoAndPosition (program);
+    updateUpcomingProgram();
     lastProgramChanged();
 }
 
+void MidiSetListProcessor::updateUpcomingProgram()
+{
+    auto e = _context.audio();
+    if (e == nullptr)
+        return;
+
+    // the entry after the one playing, or the first before anything has.
+    const int last = getLastProgram();
+    int next = 0;
+    for (int i = 0; i < entries.size(); ++i)
+        if (entries.getUnchecked (i)->in == last)
+            next = i + 1;
+
+    const auto* const entry = entries[next];
+    e->setUpcomingProgram (entry != nullptr ? entry->out : -1);
+}
+
 } // namespace element
@@ -171,6 +171,10 @@ protected:
     }
 
     void maybeSendTempoAndPosition (int program);
+
+    /** Tells the engine which program follows the last one received, so
+        its graph is ready before the change comes in. */
+    void updateUpcomingProgram();
 };
 
 } // namespace element
@@ -0,0 +1,110 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/midipipe.hpp>
+#include "nodes/midifilter.hpp"
+#include "nodes/baseprocessor.hpp"
+#include "engine/mpevoicerouter.hpp"
+
+namespace element {
+
+/** Spreads an MPE performance over several instances of an instrument,
+    see MpeVoiceRouter.
+ */
+class MpeRouterNode : public MidiFilterNode
+{
+public:
+    static constexpr int numOutputs = 4;
+
+    MpeRouterNode()
+        : MidiFilterNode (0)
+    {
+        setName ("MPE Router");
+        router.setNumOutputs (numOutputs);
+    }
+
+    ~MpeRouterNode() {}
+
+    void setState (const void* data, int size) override { ignoreUnused (data, size); }
+    void getState (MemoryBlock& block) override { ignoreUnused (block); }
+
+    void prepareToRender (double sampleRate, int maxBufferSize) override
+    {
+        ignoreUnused (sampleRate, maxBufferSize);
+        FixedMidi::reserve (tempMidi);
+        router.reset();
+    }
+
+    void releaseResources() override {}
+
+    inline void render (RenderContext& rc) override
+    {
+        if (rc.midi.getNumBuffers() < numOutputs)
+        {
+            if (! assertedLowChannels)
+            {
+                assertedLowChannels = true;
+                jassertfalse;
+            }
+
+            rc.midi.clear (0, rc.audio.getNumSamples());
+            return;
+        }
+
+        // the input shares a buffer with the first output.
+        tempMidi.swapWith (*rc.midi.getWriteBuffer (0));
+        for (int i = 0; i < numOutputs; ++i)
+        {
+            buffers[i] = rc.midi.getWriteBuffer (i);
+            buffers[i]->clear();
+        }
+
+        router.process (tempMidi, buffers);
+        tempMidi.clear();
+    }
+
+    void getPluginDescription (PluginDescription& desc) const override
+    {
+        desc.fileOrIdentifier = EL_NODE_ID_MPE_ROUTER;
+        desc.name = "MPE Router";
+        desc.descriptiveName = "Spread MPE voices over several instruments";
+        desc.numInputChannels = 0;
+        desc.numOutputChannels = 0;
+        desc.hasSharedContainer = false;
+        desc.isInstrument = false;
+        desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+        desc.pluginFormatName = EL_NODE_FORMAT_NAME;
+        desc.version = "1.0.0";
+        desc.uniqueId = EL_NODE_UID_MPE_ROUTER;
+    }
+
+protected:
+    bool assertedLowChannels = false;
+    bool createdPorts = false;
+    MpeVoiceRouter router;
+    MidiBuffer* buffers[numOutputs];
+    MidiBuffer tempMidi;
+
+    inline void refreshPorts() override
+    {
+        if (createdPorts)
+            return;
+
+        PortList newPorts;
+        newPorts.add (PortType::Midi, 0, 0, "midi_in", "MIDI In", true);
+        for (int i = 0; i < numOutputs; ++i)
+        {
+            String symbol = "midi_out_";
+            symbol << i;
+            String name = "Voices ";
+            name << (i + 1);
+            newPorts.add (PortType::Midi, i + 1, i, symbol, name, false);
+        }
+        createdPorts = true;
+        setPorts (newPorts);
+    }
+};
+
+} // namespace element
@@ -0,0 +1,292 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <element/ui/style.hpp>
+
+#include "nodes/netbridge.hpp"
+#include "nodes/knobs.hpp"
+
+namespace element {
+
+namespace {
+
+String getIdentifier (const char* baseId, int numChannels)
+{
+    String id (baseId);
+    if (numChannels != 2)
+        id << "." << numChannels;
+    return id;
+}
+
+ValueTree readState (const void* data, int sizeInBytes)
+{
+    if (auto e = AudioProcessor::getXmlFromBinary (data, sizeInBytes))
+        return ValueTree::fromXml (*e);
+    return {};
+}
+
+} // namespace
+
+/** Host and port over the node's parameters. The host row is hidden on
+    the receiving side.
+ */
+class NetBridgeEditor : public AudioProcessorEditor,
+                        private Timer
+{
+public:
+    NetBridgeEditor (AudioProcessor& p, bool showHost, const String& host, int port)
+        : AudioProcessorEditor (p),
+          knobs (p)
+    {
+        setOpaque (true);
+
+        hostLabel.setText ("Host", dontSendNotification);
+        hostField.setText (host, dontSendNotification);
+        hostField.setEditable (true);
+        hostField.onTextChange = [this]() { changed(); };
+        if (showHost)
+        {
+            addAndMakeVisible (hostLabel);
+            addAndMakeVisible (hostField);
+        }
+
+        portLabel.setText ("Port", dontSendNotification);
+        addAndMakeVisible (portLabel);
+        portSlider.setRange (1.0, 65535.0, 1.0);
+        portSlider.setSliderStyle (Slider::IncDecButtons);
+        portSlider.setTextBoxStyle (Slider::TextBoxLeft, false, 60, 22);
+        portSlider.setValue (port, dontSendNotification);
+        portSlider.onValueChange = [this]() { changed(); };
+        addAndMakeVisible (portSlider);
+
+        addAndMakeVisible (statusLabel);
+        addAndMakeVisible (knobs);
+
+        setSize (320, 150);
+        startTimerHz (4);
+    }
+
+    std::function<void (const String&, int)> onTargetChanged;
+    std::function<String()> getStatus;
+
+    void paint (Graphics& g) override
+    {
+        g.fillAll (Colors::widgetBackgroundColor.darker (0.1f));
+    }
+
+    void resized() override
+    {
+        auto r = getLocalBounds().reduced (4);
+        auto row = r.removeFromTop (22);
+        if (hostField.isVisible())
+        {
+            hostLabel.setBounds (row.removeFromLeft (36));
+            hostField.setBounds (row.removeFromLeft (100));
+            row.removeFromLeft (4);
+        }
+        portLabel.setBounds (row.removeFromLeft (36));
+        portSlider.setBounds (row.removeFromLeft (110));
+        statusLabel.setBounds (row);
+        r.removeFromTop (4);
+        knobs.setBounds (r);
+    }
+
+private:
+    KnobsComponent knobs;
+    Label hostLabel, hostField, portLabel, statusLabel;
+    Slider portSlider;
+
+    void changed()
+    {
+        if (onTargetChanged)
+            onTargetChanged (hostField.getText().trim(), roundToInt (portSlider.getValue()));
+        timerCallback();
+    }
+
+    void timerCallback() override
+    {
+        if (getStatus)
+            statusLabel.setText (getStatus(), dontSendNotification);
+    }
+};
+
+//==============================================================================
+NetSendProcessor::NetSendProcessor (int nc)
+    : BaseProcessor (BusesProperties()
+                         .withInput ("Main", AudioChannelSet::canonicalChannelSet (jlimit (1, NetBridgePacket::maxChannels, nc)))),
+      numChannels (jlimit (1, NetBridgePacket::maxChannels, nc))
+{
+    setRateAndBufferSizeDetails (44100.0, 1024);
+    addLegacyParameter (compress = new AudioParameterBool ("compress", "16 Bit", false));
+    sender.setTarget (host, port);
+}
+
+NetSendProcessor::~NetSendProcessor() {}
+
+void NetSendProcessor::fillInPluginDescription (PluginDescription& desc) const
+{
+    desc.name = getName();
+    if (numChannels != 2)
+        desc.name << " (" << numChannels << " ch)";
+    desc.fileOrIdentifier = getIdentifier (EL_NODE_ID_NET_SEND, numChannels);
+    desc.descriptiveName = "Streams audio and MIDI to another Element over the network";
+    desc.numInputChannels = numChannels;
+    desc.numOutputChannels = 0;
+    desc.hasSharedContainer = false;
+    desc.isInstrument = false;
+    desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+    desc.pluginFormatName = "Element";
+    desc.version = "1.0.0";
+    desc.uniqueId = EL_NODE_UID_NET_SEND;
+}
+
+void NetSendProcessor::setTarget (const String& newHost, int newPort)
+{
+    host = newHost;
+    port = jlimit (1, 65535, newPort);
+    sender.setTarget (host, port);
+}
+
+void NetSendProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    setRateAndBufferSizeDetails (sampleRate, maximumExpectedSamplesPerBlock);
+    sender.prepare (numChannels, sampleRate);
+}
+
+void NetSendProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
+{
+    if (buffer.getNumChannels() < numChannels)
+        return;
+
+    sender.setCompressed (*compress);
+    sender.write (buffer.getArrayOfReadPointers(), buffer.getNumSamples(), midi);
+    midi.clear();
+}
+
+AudioProcessorEditor* NetSendProcessor::createEditor()
+{
+    auto* editor = new NetBridgeEditor (*this, true, host, port);
+    editor->onTargetChanged = [this] (const String& h, int p) { setTarget (h, p); };
+    editor->getStatus = [this]() {
+        const auto dropped = sender.getNumDropped();
+        return dropped > 0 ? String ("Dropped: ") + String (dropped) : String();
+    };
+    return editor;
+}
+
+void NetSendProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    ValueTree state (tags::state);
+    state.setProperty ("host", host, nullptr);
+    state.setProperty ("port", port, nullptr);
+    state.setProperty ("compress", (bool) *compress, nullptr);
+    if (auto e = state.createXml())
+        AudioProcessor::copyXmlToBinary (*e, destData);
+}
+
+void NetSendProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    const auto state = readState (data, sizeInBytes);
+    if (! state.isValid())
+        return;
+
+    *compress = (bool) state.getProperty ("compress", (bool) *compress);
+    setTarget (state.getProperty ("host", host).toString(), (int) state.getProperty ("port", port));
+}
+
+//==============================================================================
+NetReceiveProcessor::NetReceiveProcessor (int nc)
+    : BaseProcessor (BusesProperties()
+                         .withOutput ("Main", AudioChannelSet::canonicalChannelSet (jlimit (1, NetBridgePacket::maxChannels, nc)))),
+      numChannels (jlimit (1, NetBridgePacket::maxChannels, nc))
+{
+    setRateAndBufferSizeDetails (44100.0, 1024);
+    addLegacyParameter (latency = new AudioParameterFloat ("latency", "Latency [ms]", NormalisableRange<float> (2.0f, 500.0f, 1.0f, 0.5f), 20.0f));
+}
+
+NetReceiveProcessor::~NetReceiveProcessor()
+{
+    receiver.close();
+}
+
+void NetReceiveProcessor::fillInPluginDescription (PluginDescription& desc) const
+{
+    desc.name = getName();
+    if (numChannels != 2)
+        desc.name << " (" << numChannels << " ch)";
+    desc.fileOrIdentifier = getIdentifier (EL_NODE_ID_NET_RECEIVE, numChannels);
+    desc.descriptiveName = "Plays audio and MIDI streamed from another Element over the network";
+    desc.numInputChannels = 0;
+    desc.numOutputChannels = numChannels;
+    desc.hasSharedContainer = false;
+    desc.isInstrument = false;
+    desc.manufacturerName = EL_NODE_FORMAT_AUTHOR;
+    desc.pluginFormatName = "Element";
+    desc.version = "1.0.0";
+    desc.uniqueId = EL_NODE_UID_NET_RECEIVE;
+}
+
+bool NetReceiveProcessor::setPort (int newPort)
+{
+    port = jlimit (1, 65535, newPort);
+    listening = receiver.bind (port);
+    return listening;
+}
+
+void NetReceiveProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    setRateAndBufferSizeDetails (sampleRate, maximumExpectedSamplesPerBlock);
+
+    // the receiving thread writes into what prepare allocates.
+    receiver.close();
+    receiver.prepare (numChannels, sampleRate, maximumExpectedSamplesPerBlock);
+    listening = receiver.bind (port);
+}
+
+void NetReceiveProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi)
+{
+    midi.clear();
+    receiver.setLatencyMilliseconds (*latency);
+    receiver.read (buffer.getArrayOfWritePointers(), jmin (numChannels, buffer.getNumChannels()), buffer.getNumSamples(), midi);
+}
+
+AudioProcessorEditor* NetReceiveProcessor::createEditor()
+{
+    auto* editor = new NetBridgeEditor (*this, false, {}, port);
+    editor->onTargetChanged = [this] (const String&, int p) {
+        if (p != port || ! listening)
+            setPort (p);
+    };
+    editor->getStatus = [this]() -> String {
+        if (! listening)
+            return TRANS ("Port in use");
+        if (! isStreaming())
+            return TRANS ("Waiting");
+        const auto numLost = receiver.getNumLost();
+        return numLost > 0 ? String ("Lost: ") + String (numLost) : TRANS ("Streaming");
+    };
+    return editor;
+}
+
+void NetReceiveProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    ValueTree state (tags::state);
+    state.setProperty ("port", port, nullptr);
+    state.setProperty ("latency", (float) *latency, nullptr);
+    if (auto e = state.createXml())
+        AudioProcessor::copyXmlToBinary (*e, destData);
+}
+
+void NetReceiveProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    const auto state = readState (data, sizeInBytes);
+    if (! state.isValid())
+        return;
+
+    *latency = (float) state.getProperty ("latency", (float) *latency);
+    const int newPort = (int) state.getProperty ("port", port);
+    if (newPort != port || ! listening)
+        setPort (newPort);
+}
+
+} // namespace element
@@ -0,0 +1,114 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include "engine/netbridge.hpp"
+#include "nodes/baseprocessor.hpp"
+
+namespace element {
+
+/** Sends its audio and MIDI inputs to a Net Receive node on another
+    machine over UDP.
+ */
+class NetSendProcessor : public BaseProcessor
+{
+public:
+    explicit NetSendProcessor (int numChannels = 2);
+    ~NetSendProcessor() override;
+
+    const String getName() const override { return "Net Send"; }
+    void fillInPluginDescription (PluginDescription& desc) const override;
+
+    /** Where to send. */
+    void setTarget (const String& host, int port);
+    const String& getHost() const noexcept { return host; }
+    int getPort() const noexcept { return port; }
+
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override {}
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi) override;
+
+    AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return true; }
+    bool producesMidi() const override { return false; }
+
+    int getNumPrograms() override { return 1; };
+    int getCurrentProgram() override { return 1; };
+    void setCurrentProgram (int index) override { ignoreUnused (index); };
+    const String getProgramName (int index) override
+    {
+        ignoreUnused (index);
+        return "Default";
+    }
+    void changeProgramName (int index, const String& newName) override { ignoreUnused (index, newName); }
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+private:
+    const int numChannels;
+    AudioParameterBool* compress = nullptr;
+    String host { "127.0.0.1" };
+    int port = 9100;
+    NetBridgeSender sender;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NetSendProcessor)
+};
+
+/** Plays audio and MIDI streamed from a Net Send node. */
+class NetReceiveProcessor : public BaseProcessor
+{
+public:
+    explicit NetReceiveProcessor (int numChannels = 2);
+    ~NetReceiveProcessor() override;
+
+    const String getName() const override { return "Net Receive"; }
+    void fillInPluginDescription (PluginDescription& desc) const override;
+
+    /** Listen on a port. Returns false if it's taken. */
+    bool setPort (int port);
+    int getPort() const noexcept { return port; }
+    bool isListening() const noexcept { return listening; }
+
+    /** True while a stream is playing. */
+    bool isStreaming() const noexcept { return receiver.isStreaming(); }
+
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override {}
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midi) override;
+
+    AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return true; }
+
+    int getNumPrograms() override { return 1; };
+    int getCurrentProgram() override { return 1; };
+    void setCurrentProgram (int index) override { ignoreUnused (index); };
+    const String getProgramName (int index) override
+    {
+        ignoreUnused (index);
+        return "Default";
+    }
+    void changeProgramName (int index, const String& newName) override { ignoreUnused (index, newName); }
+
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+private:
+    const int numChannels;
+    AudioParameterFloat* latency = nullptr;
+    int port = 9100;
+    bool listening = false;
+    NetBridgeReceiver receiver;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NetReceiveProcessor)
+};
+
+} // namespace element
@@ -11,6 +11,8 @@ OSCReceiverNode::OSCReceiverNode()
     : MidiFilterNode (0)
 {
     setName ("OSC Receiver");
+    incoming.setFilter (MidiCapture::allKinds);
+    scheduled.resize ((size_t) MidiCapture::capacity);
     oscReceiver.addListener (this);
 }
 
@@ -30,6 +32,7 @@ void OSCReceiverNode::setState (const void* data, int size)
     int newPortNumber = jlimit (1, 65536, (int) tree.getProperty ("portNumber", 9001));
     bool newConnected = (bool) tree.getProperty ("connected", false);
     bool newPaused = (bool) tree.getProperty ("paused", false);
+    setJitterMilliseconds ((double) tree.getProperty ("jitterMs", 0.0));
 
     if (newHostName != currentHostName || newPortNumber != currentPortNumber)
         disconnect();
@@ -51,6 +54,7 @@ void OSCReceiverNode::getState (MemoryBlock& block)
     tree.setProperty ("portNumber", currentPortNumber, nullptr);
     tree.setProperty ("connected", connected, nullptr);
     tree.setProperty ("paused", paused, nullptr);
+    tree.setProperty ("jitterMs", getJitterMilliseconds(), nullptr);
 
     MemoryOutputStream stream (block, false);
 
@@ -76,12 +80,8 @@ inline void OSCReceiverNode::refreshPorts()
 
 void OSCReceiverNode::prepareToRender (double sampleRate, int maxBufferSize)
 {
-    if (! outputMidiMessagesInitDone)
-    {
-        outputMidiMessages.reset (sampleRate);
-        currentSampleRate = sampleRate;
-        outputMidiMessagesInitDone = true;
-    }
+    ignoreUnused (maxBufferSize);
+    currentSampleRate = sampleRate;
 }
 
 void OSCReceiverNode::render (RenderContext& rc)
@@ -91,25 +91,84 @@ void OSCReceiverNode::render (RenderContext& rc)
         return;
 
     rc.midi.clear();
-    outputMidiMessages.removeNextBlockOfMessages (*rc.midi.getWriteBuffer (0), nframes);
+    auto* const midiOut = rc.midi.getWriteBuffer (0);
+
+    numScheduled += incoming.pop (scheduled.data() + numScheduled, (int) scheduled.size() - numScheduled);
+    if (numScheduled <= 0)
+        return;
+
+    // events are due once their time falls before the end of this block,
+    // anything late plays at the start.
+    const double blockStart = Time::getMillisecondCounterHiRes();
+    const double samplesPerMs = currentSampleRate * 0.001;
+    const double blockEnd = blockStart + nframes / samplesPerMs;
+
+    int kept = 0;
+    for (int i = 0; i < numScheduled; ++i)
+    {
+        const auto& ev = scheduled[(size_t) i];
+        const double targetMs = ev.time * 1000.0;
+        if (targetMs >= blockEnd)
+        {
+            scheduled[(size_t) kept++] = ev;
+            continue;
+        }
+
+        const int frame = jlimit (0, nframes - 1, roundToInt ((targetMs - blockStart) * samplesPerMs));
+        midiOut->addEvent (ev.data, jmin (ev.size, MidiCapture::maxBytes), frame);
+    }
+
+    numScheduled = kept;
 }
 
 /** OSCReceiver real-time callbacks */
 
+double OSCReceiverNode::getTargetTime (const OSCTimeTag& timeTag) const
+{
+    const double now = Time::getMillisecondCounterHiRes();
+    double delay = 0.0;
+
+    // timetags are wall clock, play them the same distance from now on
+    // the millisecond counter. Past times play as soon as possible.
+    if (! timeTag.isImmediately())
+        delay = jlimit (0.0, maxDelayMs, (double) (timeTag.toTime().toMilliseconds() - Time::currentTimeMillis()));
+
+    return now + delay + jitterMs.load();
+}
+
+void OSCReceiverNode::schedule (const OSCMessage& message, double targetMs)
+{
+    const auto midiMsg = Util::processOscToMidiMessage (message);
+    incoming.push (midiMsg.getRawData(), midiMsg.getRawDataSize(), targetMs * 0.001);
+}
+
 void OSCReceiverNode::oscMessageReceived (const OSCMessage& message)
 {
     if (paused)
         return;
 
-    auto timestamp = Time::getMillisecondCounterHiRes();
+    schedule (message, getTargetTime (OSCTimeTag::immediately));
+};
 
-    MidiMessage midiMsg = Util::processOscToMidiMessage (message);
-    midiMsg.setTimeStamp (timestamp);
+void OSCReceiverNode::oscBundleReceived (const OSCBundle& bundle)
+{
+    if (paused)
+        return;
 
-    outputMidiMessages.addMessageToQueue (midiMsg);
+    const auto targetMs = getTargetTime (bundle.getTimeTag());
+    for (const auto& element : bundle)
+    {
+        if (element.isMessage())
+            schedule (element.getMessage(), targetMs);
+        else if (element.isBundle())
+            oscBundleReceived (element.getBundle());
+    }
 };
 
-void OSCReceiverNode::oscBundleReceived (const OSCBundle& bundle) {};
+void OSCReceiverNode::setJitterMilliseconds (double ms)
+{
+    jitterMs.store (jlimit (0.0, maxJitterMs, ms));
+}
 
 /** For node editor */
 
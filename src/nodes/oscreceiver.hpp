@@ -5,6 +5,7 @@
 #pragma once
 
 #include <element/midipipe.hpp>
+#include "engine/midicapture.hpp"
 #include "nodes/baseprocessor.hpp"
 #include "nodes/midifilter.hpp"
 
@@ -54,15 +55,32 @@ public:
     void setPortNumber (int port);
     void setHostName (String hostName);
 
+    /** Extra delay applied to every incoming event, in milliseconds.
+        Evens out network jitter at the cost of latency, so events keep
+        their spacing and bundle timetags land where they should.
+     */
+    void setJitterMilliseconds (double ms);
+    double getJitterMilliseconds() const noexcept { return jitterMs.load(); }
+
     void addMessageLoopListener (OSCReceiver::Listener<OSCReceiver::MessageLoopCallback>* callback);
     void removeMessageLoopListener (OSCReceiver::Listener<OSCReceiver::MessageLoopCallback>* callback);
 
 private:
     /** MIDI */
     bool createdPorts = false;
-    double currentSampleRate;
-    bool outputMidiMessagesInitDone = false;
-    MidiMessageCollector outputMidiMessages;
+    double currentSampleRate = 44100.0;
+
+    /** Longest a timetag may hold an event back, anything later is clamped */
+    static constexpr double maxDelayMs = 2000.0;
+    static constexpr double maxJitterMs = 500.0;
+
+    /** Events from the OSC thread, stamped with when they should play
+        on the millisecond counter */
+    MidiCapture incoming;
+    /** Events waiting for their time to come, audio thread only */
+    std::vector<MidiCapture::Event> scheduled;
+    int numScheduled = 0;
+    std::atomic<double> jitterMs { 0.0 };
 
     /** OSC */
     OSCReceiver oscReceiver;
@@ -73,6 +91,8 @@ private:
 
     void oscMessageReceived (const OSCMessage& message) override;
     void oscBundleReceived (const OSCBundle& bundle) override;
+    void schedule (const OSCMessage& message, double targetMs);
+    double getTargetTime (const OSCTimeTag& timeTag) const;
 };
 
 } // namespace element
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL3-or-later
 // Author: Eliot Akira <me@eliotakira.com>
 
+#include "engine/threadpolicy.hpp"
 #include "nodes/oscsender.hpp"
 #include "utils.hpp"
 
@@ -12,6 +13,10 @@ OSCSenderNode::OSCSenderNode()
       Thread ("osc sender midi processing thread")
 {
     setName ("OSC Sender");
+    midiMessageQueue.setFilter (MidiCapture::allKinds);
+    pending.resize ((size_t) MidiCapture::capacity);
+    oscMessagesToLog.resize ((size_t) maxOscMessages);
+    ThreadPolicy::prepareBackground (*this);
     startThread();
 }
 
@@ -70,31 +75,55 @@ void OSCSenderNode::run()
         if (threadShouldExit())
             break;
 
-        /** MIDI queue -> OSC messages */
+        /** MIDI queue -> OSC bundles, one per audio block */
 
-        MidiBuffer messages;
-
-        midiMessageQueue.removeNextBlockOfMessages (messages, numSamples.get());
-        numSamples = 0;
-
-        MidiMessage msg;
-        ScopedLock sl (lock);
-
-        for (auto m : messages)
+        const int numEvents = midiMessageQueue.pop (pending.data(), (int) pending.size());
+        for (int start = 0; start < numEvents;)
         {
-            msg = m.getMessage();
-            OSCMessage oscMsg = Util::processMidiToOscMessage (msg);
-            oscSender.send (oscMsg);
-
-            if (! msg.isMidiClock())
-            {
-                oscMessagesToLog.push_back (oscMsg);
-            }
+            int end = start + 1;
+            while (end < numEvents && end - start < maxBundleSize
+                   && pending[(size_t) end].time == pending[(size_t) start].time)
+                ++end;
+
+            sendBlock (pending.data() + start, end - start);
+            start = end;
         }
+    }
+}
 
-        while (oscMessagesToLog.size() > (size_t) maxOscMessages)
-            oscMessagesToLog.erase (oscMessagesToLog.begin());
+void OSCSenderNode::sendBlock (const MidiCapture::Event* events, int numEvents)
+{
+    if (numEvents == 1)
+    {
+        const auto msg = events[0].toMessage();
+        const auto oscMsg = Util::processMidiToOscMessage (msg);
+        oscSender.send (oscMsg);
+        if (! msg.isMidiClock())
+            logMessage (oscMsg);
+        return;
     }
+
+    OSCBundle bundle (OSCTimeTag (Time ((int64) (events[0].time * 1000.0))));
+    for (int i = 0; i < numEvents; ++i)
+    {
+        const auto msg = events[i].toMessage();
+        const auto oscMsg = Util::processMidiToOscMessage (msg);
+        bundle.addElement (oscMsg);
+        if (! msg.isMidiClock())
+            logMessage (oscMsg);
+    }
+
+    oscSender.send (bundle);
+}
+
+void OSCSenderNode::logMessage (const OSCMessage& msg)
+{
+    ScopedLock sl (lock);
+    oscMessagesToLog[(size_t) ((logStart + logSize) % maxOscMessages)] = msg;
+    if (logSize < maxOscMessages)
+        ++logSize;
+    else
+        logStart = (logStart + 1) % maxOscMessages;
 }
 
 void OSCSenderNode::stop()
@@ -122,12 +151,7 @@ inline void OSCSenderNode::refreshPorts()
 
 void OSCSenderNode::prepareToRender (double sampleRate, int maxBufferSize)
 {
-    if (! midiMessageQueueInitDone)
-    {
-        midiMessageQueue.reset (sampleRate);
-        currentSampleRate = sampleRate;
-        midiMessageQueueInitDone = true;
-    }
+    ignoreUnused (sampleRate, maxBufferSize);
 };
 
 void OSCSenderNode::render (RenderContext& rc)
@@ -141,17 +165,16 @@ void OSCSenderNode::render (RenderContext& rc)
         return;
     }
 
-    MidiMessage msg;
-    auto timestamp = Time::getMillisecondCounterHiRes();
-    for (auto m : *midiIn)
+    // every event in the block shares its time, so the sender thread can
+    // bundle them back together.
+    if (! midiIn->isEmpty())
     {
-        msg = m.getMessage();
-        msg.setTimeStamp (timestamp + (1000.0 * (static_cast<double> (m.samplePosition) / currentSampleRate)));
-        midiMessageQueue.addMessageToQueue (msg);
+        const auto blockTime = 0.001 * (double) Time::currentTimeMillis();
+        for (auto m : *midiIn)
+            midiMessageQueue.push (m.data, m.numBytes, blockTime);
+        sem.post();
     }
 
-    numSamples += nframes;
-    sem.post();
     midiIn->clear();
 }
 
@@ -233,8 +256,10 @@ std::vector<OSCMessage> OSCSenderNode::getOscMessages()
 
     {
         ScopedLock sl (lock);
-        std::copy (oscMessagesToLog.begin(), oscMessagesToLog.end(), std::back_inserter (copied));
-        oscMessagesToLog.clear();
+        copied.reserve ((size_t) logSize);
+        for (int i = 0; i < logSize; ++i)
+            copied.push_back (oscMessagesToLog[(size_t) ((logStart + i) % maxOscMessages)]);
+        logStart = logSize = 0;
     }
 
     return copied;
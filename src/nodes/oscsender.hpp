@@ -5,6 +5,7 @@
 #pragma once
 
 #include <element/midipipe.hpp>
+#include "engine/midicapture.hpp"
 #include "nodes/baseprocessor.hpp"
 #include "nodes/midifilter.hpp"
 #include "nodes/nodetypes.hpp"
@@ -85,18 +86,23 @@ private:
     int currentPortNumber = 9002;
     String currentHostName = "127.0.0.1";
 
-    /** Max messages in queue before they start getting dropped */
-    int maxOscMessages = 100;
+    /** Max messages kept for the GUI, older ones are overwritten */
+    static constexpr int maxOscMessages = 100;
+
+    /** Most messages in one bundle, keeps datagrams well under the MTU */
+    static constexpr int maxBundleSize = 32;
 
     /** GUI */
     std::vector<OSCMessage> oscMessagesToLog;
+    int logStart = 0;
+    int logSize = 0;
 
     /** To be processed and sent as OSC messages */
-    MidiMessageCollector midiMessageQueue;
+    MidiCapture midiMessageQueue;
+    std::vector<MidiCapture::Event> pending;
 
-    Atomic<int> numSamples = 0;
-    double currentSampleRate = 0;
-    bool midiMessageQueueInitDone = false;
+    void sendBlock (const MidiCapture::Event* events, int numEvents);
+    void logMessage (const OSCMessage& msg);
 };
 
 } // namespace element
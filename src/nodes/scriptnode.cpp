@@ -38,48 +38,104 @@ require ('el.MidiPipe')
 namespace element {
 
 //=============================================================================
-ScriptNode::ScriptNode() noexcept
-    : Processor (0)
+/** A compiled DSP script and the Lua state it lives in. Each load gets a new
+    one so compiling never touches the state the audio thread is running.
+ */
+struct ScriptNode::Program
 {
-    setName ("Script");
-    Lua::initializeState (lua);
-
-    lua.set_function ("print", [this] (sol::variadic_args va) {
-        auto& e = lua;
-        String msg;
-        for (auto v : va)
-        {
-            if (sol::type::string == v.get_type())
+    Program()
+        : lua (sol::default_at_panic, &ScriptAllocator::allocate, &allocator)
+    {
+        Lua::initializeState (lua);
+        lua.set_function ("print", [this] (sol::variadic_args va) {
+            String msg;
+            for (auto v : va)
             {
-                msg << v.as<const char*>() << " ";
-                continue;
+                if (sol::type::string == v.get_type())
+                {
+                    msg << v.as<const char*>() << " ";
+                    continue;
+                }
+
+                sol::function ts = lua["tostring"];
+                if (ts.valid())
+                {
+                    sol::object str = ts ((sol::object) v);
+                    if (str.valid())
+                        if (const char* sstr = str.as<const char*>())
+                            msg << sstr << "  ";
+                }
             }
 
-            sol::function ts = e["tostring"];
-            if (ts.valid())
+            if (msg.isNotEmpty())
             {
-                sol::object str = ts ((sol::object) v);
-                if (str.valid())
-                    if (const char* sstr = str.as<const char*>())
-                        msg << sstr << "  ";
+                // scripts render on any worker, never block one on the message thread.
+                if (MessageManager::getInstance()->isThisTheMessageThread())
+                    Logger::writeToLog (msg);
+                else
+                    MessageManager::callAsync ([msg]() { Logger::writeToLog (msg); });
             }
-        }
+        });
+    }
 
-        if (msg.isNotEmpty())
+    ~Program()
+    {
+        if (script != nullptr)
         {
-            if (MessageManager::getInstance()->isThisTheMessageThread())
-            {
-                Logger::writeToLog (msg);
-            }
-            else
-            {
-                MessageManagerLock ml;
-                Logger::writeToLog (msg);
-            }
+            script->release();
+            script->cleanup();
         }
-    });
+        script.reset();
+    }
+
+    Result load (const String& code)
+    {
+        ScriptLoader loader (lua);
+        loader.load (code);
+        if (loader.hasError())
+            return Result::fail (loader.getErrorMessage());
+
+        auto dsp = loader();
+        if (! dsp.valid() || dsp.get_type() != sol::type::table)
+            return Result::fail ("Could not instantiate script");
+
+        script = std::make_unique<DSPScript> (dsp);
+        return Result::ok();
+    }
+
+    void process (AudioSampleBuffer& audio, MidiPipe& midi)
+    {
+        ScriptAllocator::ScopedRealtime realtime (allocator);
+
+        // the collector doesn't run from inside the script's allocations here,
+        // it gets one basic step after each block instead.
+        auto* L = lua.lua_state();
+        lua_gc (L, LUA_GCSTOP);
+        script->process (audio, midi);
+        lua_gc (L, LUA_GCSTEP, 0);
+        lua_gc (L, LUA_GCRESTART);
+    }
+
+    ScriptAllocator allocator;
+    sol::state lua;
+    std::unique_ptr<DSPScript> script;
+
+    /** Held by whichever thread is running the state. The audio side only
+        try-locks it.
+     */
+    SpinLock stateLock;
+};
+
+//=============================================================================
+ScriptNode::ScriptNode() noexcept
+    : Processor (0)
+{
+    setName ("Script");
+
+    auto initial = std::make_unique<Program>();
+    initial->script = std::make_unique<DSPScript> (initial->lua.create_table());
+    install (std::move (initial));
 
-    script.reset (new DSPScript (lua.create_table()));
     dspCode.replaceAllContent (String::fromUTF8 (
         scripts::amp_lua, scripts::amp_luaSize));
     loadScript (dspCode.getAllContent());
@@ -90,11 +146,31 @@ ScriptNode::ScriptNode() noexcept
 
 ScriptNode::~ScriptNode()
 {
-    script.reset();
+    active = fading = pending = nullptr;
+    programs.clear();
+}
+
+DSPScript* ScriptNode::getScript() const noexcept
+{
+    return programs.isEmpty() ? nullptr : programs.getLast()->script.get();
+}
+
+const ScriptAllocator& ScriptNode::getAllocator() const noexcept
+{
+    return programs.getLast()->allocator;
+}
+
+int64 ScriptNode::getMemoryUsage() const
+{
+    auto total = Processor::getMemoryUsage();
+    for (auto* program : programs)
+        total += (int64) jmax (program->allocator.getBudget(), program->allocator.getBytesInUse());
+    return total;
 }
 
 void ScriptNode::refreshPorts()
 {
+    auto* script = getScript();
     if (script == nullptr)
         return;
     PortList newPorts;
@@ -107,52 +183,72 @@ void ScriptNode::refreshPorts()
 void ScriptNode::setPlayHead (juce::AudioPlayHead* playhead)
 {
     Processor::setPlayHead (playhead);
-    if (script)
-        script->setPlayHead (playhead);
+    for (auto* program : programs)
+        program->script->setPlayHead (playhead);
 }
 
 ParameterPtr ScriptNode::getParameter (const PortDescription& port)
 {
     jassert (port.type == PortType::Control);
+    auto* script = getScript();
     return script ? script->getParameterObject (port.channel, port.input) : nullptr;
 }
 
-Result ScriptNode::loadScript (const String& newCode)
+std::unique_ptr<ScriptNode::Program> ScriptNode::compile (const String& newCode, Result& result)
 {
-    auto result = DSPScript::validate (newCode);
+    result = DSPScript::validate (newCode);
     if (result.failed())
-        return result;
+        return nullptr;
+
+    auto program = std::make_unique<Program>();
+    result = program->load (newCode);
+    if (result.failed())
+        return nullptr;
+
+    program->script->setPlayHead (getPlayHead());
+    program->script->setControlSnapshot (&snapshot);
+    if (prepared)
+        program->script->prepare (sampleRate, blockSize);
+    if (auto* current = getScript())
+        program->script->copyParameterValues (*current);
+    return program;
+}
 
-    ScriptLoader loader (lua);
-    loader.load (newCode);
-    if (loader.hasError())
-        return Result::fail (loader.getErrorMessage());
+void ScriptNode::install (std::unique_ptr<Program> program)
+{
+    ScopedLock sl (lock);
 
-    auto dsp = loader();
-    if (! dsp.valid() || dsp.get_type() != sol::type::table)
-        return Result::fail ("Could not instantiate script");
+    // the audio thread takes pending at the next block and fades over to it,
+    // when it isn't running there's nothing to fade.
+    if (prepared && active.load() != nullptr)
+        pending = program.get();
+    else
+        active = program.get();
 
-    auto newScript = std::make_unique<DSPScript> (dsp);
+    programs.add (program.release());
+    reclaim();
+}
 
-    if (true)
+void ScriptNode::reclaim()
+{
+    // newest stays, the rest go once the audio thread is done with them.
+    for (int i = programs.size() - 1; --i >= 0;)
     {
-        newScript->setPlayHead (getPlayHead());
-        if (prepared)
-            newScript->prepare (sampleRate, blockSize);
-        triggerPortReset();
-        ScopedLock sl (lock);
-        if (script != nullptr)
-            newScript->copyParameterValues (*script);
-        script.swap (newScript);
+        auto* program = programs.getUnchecked (i);
+        if (program != active.load() && program != fading.load() && program != pending.load())
+            programs.remove (i);
     }
+}
 
-    if (newScript != nullptr)
-    {
-        newScript->release();
-        newScript->cleanup();
-        newScript.reset();
-    }
+Result ScriptNode::loadScript (const String& newCode)
+{
+    Result result = Result::ok();
+    auto program = compile (newCode, result);
+    if (program == nullptr)
+        return result;
 
+    triggerPortReset();
+    install (std::move (program));
     return Result::ok();
 }
 
@@ -177,7 +273,20 @@ void ScriptNode::prepareToRender (double rate, int block)
         return;
     sampleRate = rate;
     blockSize = block;
-    script->prepare (sampleRate, blockSize);
+
+    const int numChannels = jmax (1, getNumPorts (PortType::Audio, true), getNumPorts (PortType::Audio, false));
+    fadeAudio.setSize (numChannels, blockSize, false, false, false);
+    while (fadeMidi.size() < 4)
+        fadeMidi.add (new MidiBuffer())->ensureSize (1024);
+    fadeLength = jmax (1, roundToInt (sampleRate * 0.02));
+
+    ScopedLock sl (lock);
+    if (auto* next = pending.exchange (nullptr))
+        active = next;
+    fading = nullptr;
+    reclaim();
+
+    getScript()->prepare (sampleRate, blockSize);
     prepared = true;
 }
 
@@ -186,13 +295,89 @@ void ScriptNode::releaseResources()
     if (! prepared)
         return;
     prepared = false;
-    script->release();
+    getScript()->release();
+
+    ScopedLock sl (lock);
+    reclaim();
 }
 
 void ScriptNode::render (RenderContext& rc)
 {
-    ScopedLock sl (lock);
-    script->process (rc.audio, rc.midi);
+    {
+        // swap at the block boundary, carrying on with the old script if
+        // a load holds the lock.
+        const ScopedTryLock sl (lock);
+        if (sl.isLocked())
+        {
+            if (auto* next = pending.exchange (nullptr))
+            {
+                const bool canFade = fading.load() == nullptr
+                                     && rc.audio.getNumChannels() <= fadeAudio.getNumChannels()
+                                     && rc.audio.getNumSamples() <= fadeAudio.getNumSamples();
+                fading = canFade ? active.load() : nullptr;
+                active = next;
+                fadePosition = 0;
+            }
+        }
+    }
+
+    auto* const current = active.load();
+    if (current == nullptr)
+        return;
+
+    // a Lua state only runs on one thread at a time, if the message thread
+    // is in it (e.g. saving) this block passes through.
+    const SpinLock::ScopedTryLockType currentLock (current->stateLock);
+    if (! currentLock.isLocked())
+    {
+        renderBypassed (rc);
+        return;
+    }
+
+    auto* old = fading.load();
+    if (old != nullptr && ! old->stateLock.tryEnter())
+        old = nullptr;
+
+    if (old == nullptr)
+    {
+        current->process (rc.audio, rc.midi);
+        return;
+    }
+
+    // the old script runs on a copy of the input with no MIDI until the
+    // fade is done.
+    const int numChannels = rc.audio.getNumChannels();
+    const int numSamples = rc.audio.getNumSamples();
+    fadeAudio.setSize (numChannels, numSamples, false, false, true);
+    for (int c = 0; c < numChannels; ++c)
+        fadeAudio.copyFrom (c, 0, rc.audio, c, 0, numSamples);
+
+    MidiBuffer* midiRefs[4];
+    const int numMidi = jmin (rc.midi.getNumBuffers(), fadeMidi.size(), 4);
+    for (int i = 0; i < numMidi; ++i)
+    {
+        fadeMidi.getUnchecked (i)->clear();
+        midiRefs[i] = fadeMidi.getUnchecked (i);
+    }
+    MidiPipe oldMidi (midiRefs, numMidi);
+
+    current->process (rc.audio, rc.midi);
+    old->process (fadeAudio, oldMidi);
+
+    const float g1 = (float) fadePosition / (float) fadeLength;
+    fadePosition = jmin (fadeLength, fadePosition + numSamples);
+    const float g2 = (float) fadePosition / (float) fadeLength;
+    for (int c = 0; c < numChannels; ++c)
+    {
+        rc.audio.applyGainRamp (c, 0, numSamples, g1, g2);
+        rc.audio.addFromWithRamp (c, 0, fadeAudio.getReadPointer (c), numSamples, 1.f - g1, 1.f - g2);
+    }
+
+    old->stateLock.exit();
+
+    // reclaimed by the message thread on the next load.
+    if (fadePosition >= fadeLength)
+        fading = nullptr;
 }
 
 void ScriptNode::setState (const void* data, int size)
@@ -203,17 +388,20 @@ void ScriptNode::setState (const void* data, int size)
         dspCode.replaceAllContent (state["dspCode"].toString());
         edCode.replaceAllContent (state["editorCode"].toString());
 
-        auto result = loadScript (dspCode.getAllContent());
-
-        if (result.wasOk())
+        Result result = Result::ok();
+        if (auto program = compile (dspCode.getAllContent(), result))
         {
+            // restored before the audio thread can see it.
             if (state.hasProperty ("data"))
             {
                 const var& data = state.getProperty ("data");
                 if (data.isBinaryData())
                     if (auto* block = data.getBinaryData())
-                        script->restore (block->getData(), block->getSize());
+                        program->script->restore (block->getData(), block->getSize());
             }
+
+            triggerPortReset();
+            install (std::move (program));
         }
 
         sendChangeMessage();
@@ -227,7 +415,11 @@ void ScriptNode::getState (MemoryBlock& out)
         .setProperty ("editorCode", edCode.getAllContent(), nullptr);
 
     MemoryBlock block;
-    script->save (block);
+    {
+        auto* program = programs.getLast();
+        const SpinLock::ScopedLockType sl (program->stateLock);
+        program->script->save (block);
+    }
     if (block.getSize() > 0)
         state.setProperty ("data", block, nullptr);
     block.reset();
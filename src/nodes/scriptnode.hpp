@@ -3,14 +3,25 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "nodes/baseprocessor.hpp"
 #include <element/processor.hpp>
+#include "scripting/controlsnapshot.hpp"
+#include "scripting/scriptallocator.hpp"
 #include "sol/sol.hpp"
 
 namespace element {
 
 class DSPScript;
 
+/** A node running a Lua DSP script.
+
+    Every loaded script gets its own lua_State and allocator. Nothing is
+    shared with the ScriptManager, the console or other script nodes, so
+    script nodes can render on any worker thread in parallel. A state only
+    runs on one thread at a time.
+ */
 class ScriptNode : public Processor,
                    public ChangeBroadcaster
 {
@@ -44,6 +55,20 @@ public:
 
     void setPlayHead (juce::AudioPlayHead*) override;
 
+    /** Returns the allocator serving the newest script's Lua state. */
+    const ScriptAllocator& getAllocator() const noexcept;
+
+    /** Counts each Lua state's arena, or what it has in use if it spilled
+        over to the heap.
+     */
+    int64 getMemoryUsage() const override;
+
+    /** Returns the latest output control values, written by the audio
+        thread after blocks where they change. Read it from the UI instead
+        of polling parameters.
+     */
+    const ControlSnapshot& getControlSnapshot() const noexcept { return snapshot; }
+
     //==========================================================================
     int getNumPrograms() const override { return 2; }
     int getCurrentProgram() const override { return _program; }
@@ -55,11 +80,24 @@ protected:
     ParameterPtr getParameter (const PortDescription& port) override;
 
 private:
+    struct Program;
+
     CriticalSection lock;
-    sol::state lua;
     CodeDocument dspCode, edCode;
-    std::unique_ptr<DSPScript> script;
+
+    // Message thread owns these, the newest is last. Older ones stay until
+    // the audio thread lets go of them.
+    OwnedArray<Program> programs;
+    // Changed by the audio thread at block boundaries and under the lock by
+    // the message thread.
+    std::atomic<Program*> active { nullptr }, fading { nullptr }, pending { nullptr };
+
+    AudioSampleBuffer fadeAudio;
+    OwnedArray<MidiBuffer> fadeMidi;
+    int fadeLength = 1, fadePosition = 0;
+
     ParameterArray inParams, outParams;
+    ControlSnapshot snapshot;
     StringArray printMessages;
 
     int _program = 0;
@@ -67,6 +105,11 @@ private:
     int blockSize = 512;
     double sampleRate = 44100.0;
     bool prepared = false;
+
+    DSPScript* getScript() const noexcept;
+    std::unique_ptr<Program> compile (const String& code, Result& result);
+    void install (std::unique_ptr<Program> program);
+    void reclaim();
 };
 
 } // namespace element
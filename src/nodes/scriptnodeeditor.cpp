@@ -377,6 +377,10 @@ void ScriptNodeEditor::updateSize()
 
 void ScriptNodeEditor::unload()
 {
+    stopTimer();
+    refreshFunction = sol::safe_function();
+    refreshValues = sol::table();
+
     if (_generic != nullptr)
         _generic.reset();
 
@@ -470,6 +474,14 @@ void ScriptNodeEditor::updatePreview()
                     setResizable (canResize);
                     updateSize();
                     ok = true;
+
+                    if (sol::safe_function refresh = editor["refresh"])
+                    {
+                        refreshFunction = refresh;
+                        refreshValues = state.create_table (ControlSnapshot::maxValues, 0);
+                        snapshotSequence = 0;
+                        startTimerHz (jlimit (1, 60, DSPUI.get_or ("fps", 30)));
+                    }
                 }
                 else
                 {
@@ -495,6 +507,28 @@ void ScriptNodeEditor::updatePreview()
     resized();
 }
 
+void ScriptNodeEditor::timerCallback()
+{
+    if (! isShowing())
+        return;
+
+    const int numValues = lua->getControlSnapshot().read (snapshotValues, snapshotSequence);
+    if (numValues < 0)
+        return;
+
+    for (int i = 0; i < numValues; ++i)
+        refreshValues[i + 1] = snapshotValues[i];
+
+    auto result = refreshFunction (widget, refreshValues, numValues);
+    if (! result.valid())
+    {
+        sol::error e = result;
+        for (const auto& line : StringArray::fromLines (e.what()))
+            log (line);
+        stopTimer();
+    }
+}
+
 void ScriptNodeEditor::onPortsChanged()
 {
     updateAll();
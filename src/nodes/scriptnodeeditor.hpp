@@ -14,7 +14,8 @@ class GenericNodeEditor;
 class ScriptingEngine;
 
 class ScriptNodeEditor : public NodeEditor,
-                         public ChangeListener
+                         public ChangeListener,
+                         private Timer
 {
 public:
     explicit ScriptNodeEditor (ScriptingEngine& scripts, const Node& node);
@@ -34,6 +35,13 @@ private:
     sol::table descriptor;
     Component* comp = nullptr;
 
+    // the widget's refresh function, called with the latest output controls
+    // at most `fps` times a second when they change.
+    sol::safe_function refreshFunction;
+    sol::table refreshValues;
+    float snapshotValues[ControlSnapshot::maxValues];
+    uint32 snapshotSequence = 0;
+
     std::unique_ptr<GenericNodeEditor> _generic;
 
     bool showToolbar = false;
@@ -59,6 +67,7 @@ private:
     sol::table createContext();
     void unload();
     void log (const String& txt) { Logger::writeToLog (txt); }
+    void timerCallback() override;
 };
 
 } // namespace element
@@ -0,0 +1,65 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "nodes/videomonitor.hpp"
+
+namespace element {
+
+VideoMonitorNode::VideoMonitorNode()
+    : Processor (PortList())
+{
+    setName ("Video Monitor");
+}
+
+VideoMonitorNode::~VideoMonitorNode()
+{
+    pipeline.close();
+}
+
+bool VideoMonitorNode::open (const File& location, double frameRate)
+{
+    return pipeline.open (location, frameRate);
+}
+
+void VideoMonitorNode::close()
+{
+    pipeline.close();
+}
+
+void VideoMonitorNode::prepareToRender (double newSampleRate, int maxBufferSize)
+{
+    ignoreUnused (maxBufferSize);
+    sampleRate = newSampleRate;
+}
+
+void VideoMonitorNode::render (RenderContext& rc)
+{
+    ignoreUnused (rc);
+    if (auto* const playhead = getPlayHead())
+        if (auto pos = playhead->getPosition())
+            pipeline.setPosition ((double) pos->getTimeInSamples().orFallback (0) / sampleRate - startTime.load());
+}
+
+void VideoMonitorNode::getState (MemoryBlock& block)
+{
+    ValueTree state (tags::state);
+    state.setProperty ("folder", getFolder().getFullPathName(), nullptr)
+        .setProperty ("frameRate", getFrameRate(), nullptr)
+        .setProperty ("startTime", getStartTime(), nullptr);
+    MemoryOutputStream stream (block, false);
+    state.writeToStream (stream);
+}
+
+void VideoMonitorNode::setState (const void* data, int size)
+{
+    const auto state = ValueTree::readFromData (data, (size_t) size);
+    if (! state.isValid())
+        return;
+
+    setStartTime ((double) state.getProperty ("startTime", 0.0));
+    const auto folder = state.getProperty ("folder").toString();
+    if (File::isAbsolutePath (folder))
+        open (File (folder), (double) state.getProperty ("frameRate", 25.0));
+}
+
+} // namespace element
@@ -3,81 +3,63 @@
 
 #pragma once
 
-#include <element/ui/nodeeditor.hpp>
-#include <element/ui/style.hpp>
 #include <element/processor.hpp>
-#include <element/porttype.hpp>
 
+#include "engine/videoframes.hpp"
 #include "nodes/nodetypes.hpp"
 
 namespace element {
 
-class VideoMonitorNode : public Processor,
-                         public ChangeBroadcaster
+/** Shows a video clip in time with the transport.
+
+    The node has no ports. Each block it reports the transport position to
+    a VideoFramePipeline, which decodes on its own thread, so playback
+    never costs the audio or message threads more than a frame's blit.
+ */
+class VideoMonitorNode : public Processor
 {
 public:
-    VideoMonitorNode()
-        : Processor (PortCount().with (PortType::Midi, 1, 0).with (PortType::Control, 0, 9).toPortList()) {}
-    ~VideoMonitorNode() {}
+    VideoMonitorNode();
+    ~VideoMonitorNode() override;
 
-    /** Open the device. e.g. go online. */
-    void open()
-    {
-        uint8_t data[5] = { 0x00, 0x00, 0x66, 0x14, 0x00 };
-        data[4] = 0x63;
+    /** Play a folder of numbered images. Message thread. */
+    bool open (const File& location, double frameRate);
+    void close();
 
-        sendMidi (MidiMessage::createSysExMessage (data, 5));
-    }
+    const File& getFolder() const noexcept { return pipeline.getFolder(); }
+    double getFrameRate() const noexcept { return pipeline.getFrameRate(); }
 
-    void close()
-    {
-    }
+    /** Transport time the clip starts at, in seconds. */
+    double getStartTime() const noexcept { return startTime.load(); }
+    void setStartTime (double seconds) noexcept { startTime.store (seconds); }
 
-    void sendMidi (const MidiMessage& msg)
-    {
-        col.addMessageToQueue (msg.withTimeStamp ((double) Time::getMillisecondCounter() / 1000.0));
-    }
+    VideoFramePipeline& getPipeline() noexcept { return pipeline; }
 
     //==========================================================================
-    void prepareToRender (double sampleRate, int maxBufferSize) override
-    {
-        ignoreUnused (sampleRate, maxBufferSize);
-        col.reset (sampleRate);
-    }
-
+    void prepareToRender (double sampleRate, int maxBufferSize) override;
     void releaseResources() override {}
 
     inline bool wantsContext() const noexcept override { return true; }
-    void render (RenderContext& rc) override
-    {
-        auto buf = rc.midi.getWriteBuffer (0);
-        for (const auto msg : *buf)
-        {
-            juce::ignoreUnused (msg);
-        }
-        rc.midi.clear();
-        col.removeNextBlockOfMessages (*buf, rc.audio.getNumSamples());
-    }
+    void render (RenderContext& rc) override;
 
-    void getState (MemoryBlock&) override {}
-    void setState (const void*, int sizeInBytes) override {}
-
-    CriticalSection& getLock() { return lock; }
+    void getState (MemoryBlock&) override;
+    void setState (const void*, int sizeInBytes) override;
 
     int getNumPrograms() const override { return 1; }
     int getCurrentProgram() const override { return 0; }
-    void setCurrentProgram (int index) override {}
+    void setCurrentProgram (int index) override { ignoreUnused (index); }
     const String getProgramName (int index) const override
     {
-        return "MCU";
+        ignoreUnused (index);
+        return "Default";
     }
 
     void getPluginDescription (PluginDescription& desc) const override
     {
-        desc.fileOrIdentifier = EL_NODE_ID_MCU;
-        desc.uniqueId = EL_NODE_UID_MCU;
-        desc.name = "MCU Brain";
-        desc.descriptiveName = "Support for Mackie Control Universal";
+        desc.fileOrIdentifier = EL_NODE_ID_VIDEO_MONITOR;
+        desc.uniqueId = EL_NODE_UID_VIDEO_MONITOR;
+        desc.name = "Video Monitor";
+        desc.descriptiveName = "Shows a video clip in time with the transport";
         desc.numInputChannels = 0;
         desc.numOutputChannels = 0;
         desc.hasSharedContainer = false;
@@ -87,74 +69,14 @@ public:
         desc.version = "1.0.0";
     }
 
-    void refreshPorts() override
-    {
-        // nothing to do yet
-    }
-
-private:
-    CriticalSection lock;
-    juce::MidiMessageCollector col;
-};
-
-class MackieControlEditor : public NodeEditor
-{
-public:
-    MackieControlEditor (const Node& node)
-        : NodeEditor (node)
-    {
-        setOpaque (true);
-        addAndMakeVisible (testButton);
-        testButton.setButtonText ("Test");
-        testButton.onClick = [this]() {
-            proc()->sendMidi (MidiMessage::noteOn (1, 100, 1.f));
-            proc()->sendMidi (MidiMessage::noteOff (1, 100));
-        };
-
-        addAndMakeVisible (onlineButton);
-        onlineButton.setButtonText ("Reset");
-        onlineButton.setClickingTogglesState (true);
-        onlineButton.setToggleState (false, dontSendNotification);
-        onlineButton.onClick = [this]() {
-            if (onlineButton.getToggleState())
-            {
-                proc()->open();
-            }
-            else
-            {
-                proc()->close();
-            }
-        };
-
-        addAndMakeVisible (fader);
-        fader.setRange (0.0, 16383.0, 1.0);
-        fader.setSliderStyle (Slider::LinearVertical);
-        fader.onValueChange = [this]() {
-            proc()->sendMidi (MidiMessage::pitchWheel (1, roundToInt (fader.getValue())));
-        };
-
-        setSize (300, 500);
-    }
-
-    void resized() override
-    {
-        auto r = getLocalBounds().reduced (20);
-        testButton.setBounds (r.removeFromTop (24));
-        onlineButton.setBounds (r.removeFromTop (24));
-        fader.setBounds (r.removeFromLeft (20));
-    }
-
-    void paint (Graphics& g) override
-    {
-        g.fillAll (element::Colors::widgetBackgroundColor);
-    }
+    void refreshPorts() override {}
 
 private:
-    TextButton testButton;
-    TextButton onlineButton;
-    Slider fader;
+    VideoFramePipeline pipeline;
+    std::atomic<double> startTime { 0.0 };
+    double sampleRate = 44100.0;
 
-    VideoMonitorNode* proc() const noexcept { return getNodeObjectOfType<VideoMonitorNode>(); }
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VideoMonitorNode)
 };
 
 } // namespace element
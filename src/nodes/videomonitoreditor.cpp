@@ -0,0 +1,102 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "nodes/videomonitor.hpp"
+#include "nodes/videomonitoreditor.hpp"
+
+namespace element {
+
+VideoMonitorNodeEditor::VideoMonitorNodeEditor (const Node& node)
+    : NodeEditor (node)
+{
+    setOpaque (true);
+    video = getNodeObjectOfType<VideoMonitorNode>();
+    jassert (video != nullptr);
+
+    addAndMakeVisible (openButton);
+    openButton.setButtonText ("Open");
+    openButton.onClick = [this]() { chooseFolder(); };
+
+    addAndMakeVisible (rateSlider);
+    rateSlider.setRange (1.0, 120.0, 0.001);
+    rateSlider.setSliderStyle (Slider::IncDecButtons);
+    rateSlider.setTextBoxStyle (Slider::TextBoxLeft, false, 60, 22);
+    rateSlider.setTextValueSuffix (" fps");
+    rateSlider.setValue (video != nullptr ? video->getFrameRate() : 25.0, dontSendNotification);
+    rateSlider.onValueChange = [this]() {
+        if (video != nullptr && video->getFolder() != File())
+            video->open (video->getFolder(), rateSlider.getValue());
+        updateInfo();
+    };
+
+    addAndMakeVisible (infoLabel);
+    infoLabel.setJustificationType (Justification::centredRight);
+    updateInfo();
+
+    setSize (480, 300);
+    setResizable (true);
+    startTimerHz (60);
+}
+
+VideoMonitorNodeEditor::~VideoMonitorNodeEditor()
+{
+    stopTimer();
+    chooser.reset();
+}
+
+void VideoMonitorNodeEditor::paint (Graphics& g)
+{
+    g.fillAll (Colours::black);
+    if (video == nullptr)
+        return;
+
+    const auto& frame = video->getPipeline().getFrame();
+    if (frame.isValid())
+        g.drawImageAt (frame, screen.getX(), screen.getY());
+}
+
+void VideoMonitorNodeEditor::resized()
+{
+    auto r = getLocalBounds().reduced (4);
+    auto top = r.removeFromTop (24);
+    openButton.changeWidthToFitText (24);
+    openButton.setBounds (top.removeFromLeft (openButton.getWidth()));
+    top.removeFromLeft (4);
+    rateSlider.setBounds (top.removeFromLeft (120));
+    infoLabel.setBounds (top);
+    r.removeFromTop (4);
+
+    screen = r;
+    if (video != nullptr)
+        video->getPipeline().setDisplaySize (screen.getWidth(), screen.getHeight());
+}
+
+void VideoMonitorNodeEditor::chooseFolder()
+{
+    chooser = std::make_unique<FileChooser> ("Open image sequence", video != nullptr ? video->getFolder() : File(), "*.png;*.jpg;*.jpeg");
+    chooser->launchAsync (FileBrowserComponent::openMode | FileBrowserComponent::canSelectFiles | FileBrowserComponent::canSelectDirectories,
+                          [this] (const FileChooser& fc) {
+                              if (video != nullptr && fc.getResult() != File())
+                                  video->open (fc.getResult(), rateSlider.getValue());
+                              updateInfo();
+                          });
+}
+
+void VideoMonitorNodeEditor::updateInfo()
+{
+    if (video == nullptr)
+        return;
+    const int numFrames = video->getPipeline().getNumFrames();
+    infoLabel.setText (numFrames > 0 ? video->getFolder().getFileName() + " - " + String (numFrames) + " frames"
+                                     : TRANS ("No clip"),
+                       dontSendNotification);
+}
+
+void VideoMonitorNodeEditor::timerCallback()
+{
+    // repaint only when the decoder has something new.
+    if (video != nullptr && video->getPipeline().takeFrame() != nullptr)
+        repaint (screen);
+}
+
+} // namespace element
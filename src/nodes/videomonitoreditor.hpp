@@ -0,0 +1,38 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/ui/nodeeditor.hpp>
+
+namespace element {
+
+class VideoMonitorNode;
+
+/** Presents the newest decoded frame of a Video Monitor node. The frame
+    arrives scaled to fit, so painting it is a single blit.
+ */
+class VideoMonitorNodeEditor : public NodeEditor,
+                               private Timer
+{
+public:
+    VideoMonitorNodeEditor (const Node& node);
+    ~VideoMonitorNodeEditor() override;
+
+    void paint (Graphics& g) override;
+    void resized() override;
+
+private:
+    ReferenceCountedObjectPtr<VideoMonitorNode> video;
+    TextButton openButton;
+    Slider rateSlider;
+    Label infoLabel;
+    std::unique_ptr<FileChooser> chooser;
+    Rectangle<int> screen;
+
+    void chooseFolder();
+    void updateInfo();
+    void timerCallback() override;
+};
+
+} // namespace element
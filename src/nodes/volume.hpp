@@ -3,11 +3,13 @@
 
 #pragma once
 
+#include "engine/gainstage.hpp"
 #include "nodes/baseprocessor.hpp"
 
 namespace element {
 
-class VolumeProcessor : public BaseProcessor
+class VolumeProcessor : public BaseProcessor,
+                        public GainStage
 {
 private:
     const bool stereo;
@@ -15,6 +17,7 @@ private:
     float gain;
     float lastGain;
     AudioParameterFloat* volume = nullptr;
+    std::vector<Tap> taps;
 
 public:
     explicit VolumeProcessor (const double minDb, const double maxDb, const bool _stereo = false)
@@ -31,6 +34,9 @@ public:
         lastVolume = *volume;
         gain = Decibels::decibelsToGain (lastVolume);
         lastGain = gain;
+
+        for (int c = 0; c < (stereo ? 2 : 1); ++c)
+            taps.push_back ({ c, c });
     }
 
     virtual ~VolumeProcessor()
@@ -63,20 +69,33 @@ public:
     {
     }
 
-    void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+    const std::vector<Tap>& getGainTaps() const noexcept override { return taps; }
+
+    void nextGains (int, float* start, float* end) noexcept override
     {
         if (lastVolume != (float) *volume)
         {
             gain = (float) *volume <= -30.f ? 0.f : Decibels::decibelsToGain ((float) *volume);
         }
 
-        for (int c = jmin (2, buffer.getNumChannels()); --c >= 0;)
-            buffer.applyGainRamp (c, 0, buffer.getNumSamples(), lastGain, gain);
+        for (int c = (int) taps.size(); --c >= 0;)
+        {
+            start[c] = lastGain;
+            end[c] = gain;
+        }
 
         lastGain = gain;
         lastVolume = *volume;
     }
 
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+    {
+        float start[2], end[2];
+        nextGains (buffer.getNumSamples(), start, end);
+        for (int c = jmin ((int) taps.size(), buffer.getNumChannels()); --c >= 0;)
+            buffer.applyGainRamp (c, 0, buffer.getNumSamples(), start[c], end[c]);
+    }
+
     AudioProcessorEditor* createEditor() override { return new GenericAudioProcessorEditor (*this); }
     bool hasEditor() const override { return true; }
 
@@ -3,11 +3,13 @@
 
 #pragma once
 
+#include "engine/gainstage.hpp"
 #include "nodes/baseprocessor.hpp"
 
 namespace element {
 
-class WetDryProcessor : public BaseProcessor
+class WetDryProcessor : public BaseProcessor,
+                        public GainStage
 {
 private:
     AudioParameterFloat* wetLevel = nullptr;
@@ -15,6 +17,9 @@ private:
     float lastWetLevel = 0.33f;
     float lastDryLevel = 0.40f;
 
+    // each output is its own wet side, the other wet side, then its dry input.
+    const std::vector<Tap> taps { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 1, 1 }, { 0, 1 }, { 3, 1 } };
+
 public:
     explicit WetDryProcessor()
         : BaseProcessor()
@@ -70,34 +75,58 @@ public:
 
     void releaseResources() override {}
 
-    void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+    const std::vector<Tap>& getGainTaps() const noexcept override { return taps; }
+
+    void nextGains (int numSamples, float* start, float* end) noexcept override
     {
         if (lastWetLevel != (float) *wetLevel || lastDryLevel != (float) *dryLevel)
             setLevels (*wetLevel, *dryLevel);
 
-        if (buffer.getNumChannels() >= 4)
+        start[0] = start[3] = wetGain1.getCurrentValue();
+        start[1] = start[4] = wetGain2.getCurrentValue();
+        start[2] = start[5] = dryGain.getCurrentValue();
+
+        // smoothing is followed a block at a time.
+        wetGain1.skip (numSamples);
+        wetGain2.skip (numSamples);
+        dryGain.skip (numSamples);
+
+        end[0] = end[3] = wetGain1.getCurrentValue();
+        end[1] = end[4] = wetGain2.getCurrentValue();
+        end[2] = end[5] = dryGain.getCurrentValue();
+
+        lastWetLevel = *wetLevel;
+        lastDryLevel = *dryLevel;
+    }
+
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+    {
+        const int numSamples = buffer.getNumSamples();
+        float start[6], end[6];
+        nextGains (numSamples, start, end);
+
+        if (buffer.getNumChannels() >= 4 && numSamples > 0)
         {
-            const int numSamples = buffer.getNumSamples();
             auto input = buffer.getArrayOfReadPointers();
             auto output = buffer.getArrayOfWritePointers();
+            const float scale = 1.f / (float) numSamples;
 
             for (int i = 0; i < numSamples; ++i)
             {
-                const float dry = dryGain.getNextValue();
-                const float wet1 = wetGain1.getNextValue();
-                const float wet2 = wetGain2.getNextValue();
-
-                output[0][i] = input[0][i] * wet1 + input[1][i] * wet2 + input[2][i] * dry;
-                output[1][i] = input[1][i] * wet1 + input[0][i] * wet2 + input[3][i] * dry;
+                const float t = (float) i * scale;
+                const float wet1 = start[0] + (end[0] - start[0]) * t;
+                const float wet2 = start[1] + (end[1] - start[1]) * t;
+                const float dry = start[2] + (end[2] - start[2]) * t;
+
+                const float left = input[0][i], right = input[1][i];
+                output[0][i] = left * wet1 + right * wet2 + input[2][i] * dry;
+                output[1][i] = right * wet1 + left * wet2 + input[3][i] * dry;
             }
         }
         else
         {
             DBG ("CHans: " << buffer.getNumChannels());
         }
-
-        lastWetLevel = *wetLevel;
-        lastDryLevel = *dryLevel;
     }
 
     AudioProcessorEditor* createEditor() override
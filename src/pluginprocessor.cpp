@@ -35,19 +35,6 @@ static void setPluginMissingNodeProperties (const ValueTree& tree)
     }
 }
 
-//=============================================================================
-struct PluginProcessor::Latency : public juce::Timer
-{
-    Latency (PluginProcessor& p) : plugin (p) {}
-
-    void timerCallback() override
-    {
-        plugin.calculateLatencySamples();
-    }
-
-    PluginProcessor& plugin;
-};
-
 //=============================================================================
 #define enginectl context->services().find<EngineService>()
 #define guictl context->services().find<GuiService>()
@@ -74,7 +61,6 @@ PluginProcessor::PluginProcessor (Variant instanceType, int numBuses)
     prepared = controllerActive = false;
     shouldProcess.set (false);
     asyncPrepare.reset (new AsyncPrepare (*this));
-    _latency = std::make_unique<Latency> (*this);
 
     if (MessageManager::getInstance()->isThisTheMessageThread())
         handleAsyncUpdate();
@@ -186,9 +172,10 @@ void PluginProcessor::prepareToPlay (double sr, int bs)
         }
     }
 
+    // rebuilds that change the latency report it through the engine, the
+    // host hears about it on the next message loop turn.
+    calculateLatencySamples();
     updateLatencySamples();
-    _latency->startTimer (1000);
-
     engine->sampleLatencyChanged.connect (
         std::bind (&PluginProcessor::updateLatencySamples, this));
 
@@ -198,7 +185,6 @@ void PluginProcessor::prepareToPlay (double sr, int bs)
 void PluginProcessor::releaseResources()
 {
     PLUGIN_DBG ("[element] release resources: " << (int) prepared);
-    _latency->stopTimer();
 
     if (engine)
         engine->sampleLatencyChanged.disconnect_all_slots();
@@ -592,10 +578,9 @@ void PluginProcessor::setForceZeroLatency (bool force)
     if (force == forceZeroLatency)
         return;
     forceZeroLatency = force;
-    if (forceZeroLatency)
-        updateLatencySamples();
-    else
+    if (! forceZeroLatency)
         calculateLatencySamples();
+    updateLatencySamples();
 }
 
 int PluginProcessor::calculateLatencySamples() const
@@ -91,7 +91,7 @@ public:
                 std::bind (&PerformanceParameter::clearNode, this));
 
         if (parameter != nullptr)
-            parameter->addListener (this);
+            parameter->addRealtimeListener (this);
     }
 
     void setAndNotify (float value)
@@ -462,8 +462,6 @@ private:
 
     std::unique_ptr<AsyncPrepare> asyncPrepare;
 
-    struct Latency;
-    std::unique_ptr<Latency> _latency;
 
     void initialize();
     friend class AsyncUpdater;
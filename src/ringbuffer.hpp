@@ -7,9 +7,73 @@
 
 namespace element {
 
+/** A single reader, single writer byte ring.
+
+    Besides copying reads and writes, the ring hands out views of its
+    storage so data can be used in place, and has a framed mode for
+    messages of a uint32 size followed by the payload. A framed message
+    only becomes visible to the reader once it's complete.
+ */
 class RingBuffer
 {
 public:
+    /** A region of the ring. The second part is empty unless the region
+        wraps around the end of the storage. */
+    struct Span
+    {
+        uint8* data1 = nullptr;
+        uint32 size1 = 0;
+        uint8* data2 = nullptr;
+        uint32 size2 = 0;
+
+        inline uint32 size() const noexcept { return size1 + size2; }
+        inline bool isContiguous() const noexcept { return size2 == 0; }
+
+        /** Returns the part of this span starting at offset. */
+        inline Span slice (uint32 offset, uint32 bytes) const noexcept
+        {
+            Span s;
+            bytes = juce::jmin (bytes, size() - juce::jmin (offset, size()));
+            if (offset < size1)
+            {
+                s.data1 = data1 + offset;
+                s.size1 = juce::jmin (bytes, size1 - offset);
+                s.data2 = data2;
+                s.size2 = bytes - s.size1;
+            }
+            else
+            {
+                s.data1 = data2 + (offset - size1);
+                s.size1 = bytes;
+            }
+            return s;
+        }
+
+        inline void copyTo (void* dest, uint32 offset, uint32 bytes) const noexcept
+        {
+            const auto s = slice (offset, bytes);
+            if (s.size1 > 0)
+                memcpy (dest, s.data1, s.size1);
+            if (s.size2 > 0)
+                memcpy ((uint8*) dest + s.size1, s.data2, s.size2);
+        }
+
+        inline void copyFrom (const void* src, uint32 offset, uint32 bytes) noexcept
+        {
+            const auto s = slice (offset, bytes);
+            if (s.size1 > 0)
+                memcpy (s.data1, src, s.size1);
+            if (s.size2 > 0)
+                memcpy (s.data2, (const uint8*) src + s.size1, s.size2);
+        }
+    };
+
+    /** Size of a framed message's header. */
+    static constexpr uint32 headerSize = sizeof (uint32);
+
+    /** Returns the ring space a framed message of msgSize bytes takes. */
+    inline static constexpr uint32 getMessageSpace (uint32 msgSize) noexcept { return msgSize + headerSize; }
+
     RingBuffer (int32 capacity);
     ~RingBuffer();
 
@@ -40,21 +104,31 @@ public:
             fifo.finishedRead (static_cast<int> (bytes));
     }
 
-    inline uint32 read (void* dest, uint32 size, bool advance = true)
+    /** Returns a view of up to `size` readable bytes. Reader only. */
+    inline Span getReadSpan (uint32 size) const noexcept
     {
-        buffer = block.getData();
-        fifo.prepareToRead (size, vec1.index, vec1.size, vec2.index, vec2.size);
+        int start1, size1, start2, size2;
+        fifo.prepareToRead ((int) size, start1, size1, start2, size2);
+        return { buffer + start1, (uint32) size1, buffer + start2, (uint32) size2 };
+    }
 
-        if (vec1.size > 0)
-            memcpy (dest, buffer + vec1.index, vec1.size);
+    /** Returns a view of up to `size` writable bytes. Writer only. */
+    inline Span getWriteSpan (uint32 size) const noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite ((int) size, start1, size1, start2, size2);
+        return { buffer + start1, (uint32) size1, buffer + start2, (uint32) size2 };
+    }
 
-        if (vec2.size > 0)
-            memcpy ((uint8*) dest + vec1.size, buffer + vec2.index, vec2.size);
+    inline uint32 read (void* dest, uint32 size, bool advance = true)
+    {
+        const auto span = getReadSpan (size);
+        span.copyTo (dest, 0, span.size());
 
         if (advance)
-            fifo.finishedRead (vec1.size + vec2.size);
+            fifo.finishedRead ((int) span.size());
 
-        return vec1.size + vec2.size;
+        return span.size();
     }
 
     template <typename T>
@@ -70,17 +144,10 @@ public:
 
     inline uint32 write (const void* src, uint32 bytes)
     {
-        buffer = block.getData();
-        fifo.prepareToWrite (bytes, vec1.index, vec1.size, vec2.index, vec2.size);
-
-        if (vec1.size > 0)
-            memcpy (buffer + vec1.index, src, vec1.size);
-
-        if (vec2.size > 0)
-            memcpy (buffer + vec2.index, (uint8*) src + vec1.size, vec2.size);
-
-        fifo.finishedWrite (vec1.size + vec2.size);
-        return vec1.size + vec2.size;
+        auto span = getWriteSpan (bytes);
+        span.copyFrom (src, 0, span.size());
+        fifo.finishedWrite ((int) span.size());
+        return span.size();
     }
 
     template <typename T>
@@ -89,20 +156,63 @@ public:
         return write (&src, sizeof (T));
     }
 
-    struct Vector
+    //==========================================================================
+    /** Write a framed message. Nothing is written unless all of it fits.
+        Writer only. */
+    inline bool writeMessage (const void* data, uint32 size) noexcept
     {
-        uint32 size;
-        void* buffer;
-    };
+        Span payload;
+        if (! prepareMessage (size, payload))
+            return false;
+        payload.copyFrom (data, 0, size);
+        commitMessage (size);
+        return true;
+    }
 
-private:
-    struct Vec
+    /** Reserve a framed message to fill in place, then call commitMessage().
+        Returns false if it doesn't fit. Writer only. */
+    inline bool prepareMessage (uint32 size, Span& payload) noexcept
     {
-        int32 size;
-        int32 index;
-    };
+        if (getWriteSpace() < getMessageSpace (size))
+            return false;
+        auto span = getWriteSpan (getMessageSpace (size));
+        span.copyFrom (&size, 0, headerSize);
+        payload = span.slice (headerSize, size);
+        return true;
+    }
+
+    /** Publish a message reserved with prepareMessage(). */
+    inline void commitMessage (uint32 size) noexcept
+    {
+        fifo.finishedWrite ((int) getMessageSpace (size));
+    }
 
-    Vec vec1, vec2;
+    /** Returns true if the next framed message is complete, pointing
+        `payload` at it without copying. Call finishMessage() when done
+        with it. Reader only. */
+    inline bool peekMessage (Span& payload) const noexcept
+    {
+        const auto ready = getReadSpace();
+        if (ready < headerSize)
+            return false;
+
+        const auto span = getReadSpan (ready);
+        uint32 size = 0;
+        span.copyTo (&size, 0, headerSize);
+        if (ready < getMessageSpace (size))
+            return false;
+
+        payload = span.slice (headerSize, size);
+        return true;
+    }
+
+    /** Release a message returned by peekMessage(). */
+    inline void finishMessage (const Span& payload) noexcept
+    {
+        fifo.finishedRead ((int) getMessageSpace (payload.size()));
+    }
+
+private:
     juce::AbstractFifo fifo;
     juce::HeapBlock<uint8> block;
     uint8* buffer;
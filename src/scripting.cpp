@@ -6,6 +6,8 @@
 #include "scripting/scriptmanager.hpp"
 #include "scripting/bindings.hpp"
 #include <element/context.hpp>
+#include <element/engine.hpp>
+#include <element/services.hpp>
 
 #ifndef EL_LUA_SPATH
 #define EL_LUA_SPATH ""
@@ -192,6 +194,32 @@ void ScriptingEngine::initialize (Context& g)
     Lua::initializeState (state->state, g);
 }
 
+Result ScriptingEngine::execute (const String& code)
+{
+    sol::state_view view (getLuaState());
+    auto result = view.safe_script (code.toStdString(), sol::script_pass_on_error);
+    if (result.valid())
+        return Result::ok();
+    sol::error error = result;
+    return Result::fail (error.what());
+}
+
+Result ScriptingEngine::executeBatch (const StringArray& chunks)
+{
+    auto* const engine = world != nullptr ? world->services().find<EngineService>() : nullptr;
+    if (engine != nullptr)
+        engine->beginBatch();
+
+    auto result = Result::ok();
+    for (const auto& chunk : chunks)
+        if ((result = execute (chunk)).failed())
+            break;
+
+    if (engine != nullptr)
+        engine->endBatch();
+    return result;
+}
+
 ScriptManager& ScriptingEngine::getScriptManager()
 {
     return impl->manager;
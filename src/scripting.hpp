@@ -25,8 +25,16 @@ public:
     lua_State* getLuaState() const;
 
     //==========================================================================
+    /** Run code against the main state. Message thread. */
     juce::Result execute (const String& code);
 
+    /** Run chunks in order against the main state, holding engine updates
+        until the last has run so they rebuild graphs once. Scripts running
+        on a ScriptJob hand their changes back this way. Stops at the first
+        error. Message thread.
+     */
+    juce::Result executeBatch (const juce::StringArray& chunks);
+
     std::vector<std::string> getPackageNames() const noexcept;
     void addPackage (const std::string& name, lua::CFunction loader);
 
@@ -53,6 +53,7 @@ extern int luaopen_el_Commands (lua_State*);
 extern int luaopen_el_Context (lua_State*);
 extern int luaopen_el_Node (lua_State*);
 extern int luaopen_el_Session (lua_State*);
+extern int luaopen_el_Stats (lua_State*);
 extern int luaopen_el_View (lua_State*);
 extern int luaopen_el_Graph (lua_State*);
 extern int luaopen_el_GraphEditor (lua_State*);
@@ -294,6 +295,10 @@ static int searchInternalModules (lua_State* L)
     {
         sol::stack::push (L, luaopen_el_Session);
     }
+    else if (mod == "el.Stats")
+    {
+        sol::stack::push (L, luaopen_el_Stats);
+    }
     else if (mod == "el.audio" || mod == "kv.audio")
     {
         sol::stack::push (L, luaopen_el_audio);
@@ -0,0 +1,79 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** The latest output control values of a DSP script, for its UI.
+
+    The audio thread writes and the message thread reads without locking.
+    A sequence counter around each write lets readers retry the rare copy
+    that overlaps one, so all values in a read come from the same block.
+ */
+class ControlSnapshot final
+{
+public:
+    static constexpr int maxValues = 128;
+
+    ControlSnapshot() noexcept
+    {
+        for (auto& value : values)
+            value.store (0.f, std::memory_order_relaxed);
+    }
+
+    /** Publish values. Realtime safe, call from one thread only. */
+    void write (const float* data, int numData) noexcept
+    {
+        numData = juce::jlimit (0, maxValues, numData);
+        const auto seq = sequence.load (std::memory_order_relaxed);
+        sequence.store (seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        for (int i = 0; i < numData; ++i)
+            values[i].store (data[i], std::memory_order_relaxed);
+        size.store (numData, std::memory_order_relaxed);
+
+        sequence.store (seq + 2, std::memory_order_release);
+    }
+
+    /** Copy the latest values into dest, which should hold maxValues.
+
+        Returns the number of values copied, or -1 if nothing was written
+        since lastSequence. lastSequence is updated after a copy, start it
+        at zero.
+     */
+    int read (float* dest, juce::uint32& lastSequence) const noexcept
+    {
+        for (;;)
+        {
+            const auto before = sequence.load (std::memory_order_acquire);
+            if (before == lastSequence)
+                return -1;
+            if ((before & 1u) != 0)
+                continue;
+
+            const int numData = size.load (std::memory_order_relaxed);
+            for (int i = 0; i < numData; ++i)
+                dest[i] = values[i].load (std::memory_order_relaxed);
+
+            std::atomic_thread_fence (std::memory_order_acquire);
+            if (sequence.load (std::memory_order_relaxed) == before)
+            {
+                lastSequence = before;
+                return numData;
+            }
+        }
+    }
+
+private:
+    std::atomic<juce::uint32> sequence { 0 };
+    std::atomic<int> size { 0 };
+    std::atomic<float> values[maxValues];
+};
+
+} // namespace element
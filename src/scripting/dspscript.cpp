@@ -254,7 +254,7 @@ public:
     {
         const auto sp = getPort();
         set (sp.defaultValue);
-        addListener (this);
+        addRealtimeListener (this);
     }
 
     ~Parameter() override
@@ -410,6 +410,11 @@ DSPScript::DSPScript (sol::table tbl)
         ok = positionRef != LUA_REFNIL && positionRef != LUA_NOREF;
     }
 
+    if (ok)
+    {
+        ok = prepareFrame();
+    }
+
     loaded = ok;
     if (! loaded)
     {
@@ -513,51 +518,79 @@ void DSPScript::getPorts (PortList& out)
 
 void DSPScript::process (AudioSampleBuffer& a, MidiPipe& m)
 {
-    if (! loaded)
+    if (! loaded || frame == nullptr)
         return;
 
-    if (lua_rawgeti (L, LUA_REGISTRYINDEX, processRef) == LUA_TFUNCTION)
+    // rebinding can allocate, only do it when the block's channels move.
+    auto* buffer = *audio;
+    bool rebind = buffer->getNumChannels() != a.getNumChannels()
+                  || buffer->getNumSamples() != a.getNumSamples();
+    for (int c = 0; ! rebind && c < a.getNumChannels(); ++c)
+        rebind = buffer->getReadPointer (c) != a.getReadPointer (c);
+
+    if (rebind)
+        buffer->setDataToReferTo (a.getArrayOfWritePointers(), a.getNumChannels(), a.getNumSamples());
+    else
+        buffer->setNotClear(); // new audio in the same memory
+
+    (*midi)->swapWith (m);
+
+    if (playhead != nullptr)
+        (*position)->update (playhead->getPosition());
+
+    for (int i = 1; i <= numFrameValues; ++i)
+        lua_pushvalue (frame, i);
+
+    try
     {
-        if (lua_rawgeti (L, LUA_REGISTRYINDEX, audioRef) == LUA_TUSERDATA)
-        {
-            if (lua_rawgeti (L, LUA_REGISTRYINDEX, midiRef) == LUA_TUSERDATA)
-            {
-                if (lua_rawgeti (L, LUA_REGISTRYINDEX, paramsUserData.registry_index()) == LUA_TUSERDATA)
-                {
-                    if (lua_rawgeti (L, LUA_REGISTRYINDEX, controlsUserData.registry_index()) == LUA_TUSERDATA)
-                    {
-                        if (lua_rawgeti (L, LUA_REGISTRYINDEX, positionRef) == LUA_TUSERDATA)
-                        {
-                            (*audio)->setDataToReferTo (a.getArrayOfWritePointers(),
-                                                        a.getNumChannels(),
-                                                        a.getNumSamples());
-                            (*midi)->swapWith (m);
-
-                            if (playhead != nullptr)
-                                (*position)->update (playhead->getPosition());
-
-                            try
-                            {
-                                lua_call (L, 5, 0);
-                            } catch (const sol::error& e)
-                            {
-                                std::clog << e.what() << std::endl;
-                                loaded = false;
-                            }
-                            (*midi)->swapWith (m);
-
-                            for (int ci = outParams.size(); --ci >= 0;)
-                                outParams.getUnchecked (ci)->update (controlData[ci]);
-                        }
-                    }
-                }
-            }
-        }
+        lua_call (frame, numFrameValues - 1, 0);
+    } catch (const sol::error& e)
+    {
+        std::clog << e.what() << std::endl;
+        loaded = false;
     }
-    else
+
+    (*midi)->swapWith (m);
+
+    bool changed = false;
+    for (int ci = outParams.size(); --ci >= 0;)
+    {
+        if (controlData[ci] == lastControlData[ci])
+            continue;
+        lastControlData[ci] = controlData[ci];
+        outParams.getUnchecked (ci)->update (controlData[ci]);
+        changed = true;
+    }
+
+    if (changed && snapshot != nullptr)
+        snapshot->write (controlData, outParams.size());
+}
+
+bool DSPScript::prepareFrame()
+{
+    // the function and its arguments live at the bottom of a thread's stack,
+    // each block copies them up instead of going through the registry.
+    frame = lua_newthread (L);
+    frameRef = luaL_ref (L, LUA_REGISTRYINDEX);
+
+    const int refs[numFrameValues] = { processRef, audioRef, midiRef, paramsUserData.registry_index(),
+                                       controlsUserData.registry_index(), positionRef };
+    for (int i = 0; i < numFrameValues; ++i)
     {
-        DBG ("didn't get render function in callback");
+        const int expected = i == 0 ? LUA_TFUNCTION : LUA_TUSERDATA;
+        if (lua_rawgeti (L, LUA_REGISTRYINDEX, refs[i]) != expected)
+        {
+            lua_pop (L, 1);
+            return false;
+        }
+
+        lua_xmove (L, frame, 1);
     }
+
+    for (auto& value : lastControlData)
+        value = std::numeric_limits<float>::quiet_NaN();
+
+    return true;
 }
 
 void DSPScript::save (MemoryBlock& out)
@@ -737,6 +770,10 @@ void DSPScript::deref()
     position = nullptr;
     luaL_unref (L, LUA_REGISTRYINDEX, positionRef);
     positionRef = LUA_REFNIL;
+
+    frame = nullptr;
+    luaL_unref (L, LUA_REGISTRYINDEX, frameRef);
+    frameRef = LUA_REFNIL;
 }
 
 void DSPScript::addAudioMidiPorts()
@@ -14,6 +14,7 @@
 namespace element {
 
 struct DSPScriptPosition;
+class ControlSnapshot;
 class LuaMidiPipe;
 class MidiPipe;
 
@@ -33,6 +34,9 @@ public:
 
     void setPlayHead (juce::AudioPlayHead* ph) noexcept { playhead = ph; }
 
+    /** Publish output controls to a snapshot after each block they change. */
+    void setControlSnapshot (ControlSnapshot* s) noexcept { snapshot = s; }
+
     /** Returns true if the script loaded ok */
     bool isValid() const noexcept { return loaded; }
 
@@ -74,6 +78,7 @@ private:
     juce::AudioBuffer<float>** audio = nullptr;
     LuaMidiPipe** midi = nullptr;
     juce::AudioPlayHead* playhead = nullptr;
+    ControlSnapshot* snapshot = nullptr;
     DSPScriptPosition** position = nullptr;
 
     int processRef = LUA_REFNIL;
@@ -81,6 +86,11 @@ private:
     int midiRef = LUA_REFNIL;
     int positionRef = LUA_REFNIL;
 
+    // process, audio, midi, params, controls and position.
+    static constexpr int numFrameValues = 6;
+    lua_State* frame = nullptr;
+    int frameRef = LUA_REFNIL;
+
     lua_State* L = nullptr;
     bool loaded = false;
     int numParams = 0, // input params
@@ -90,7 +100,8 @@ private:
         maxParams = 128
     };
     float paramData[maxParams],
-        controlData[maxParams];
+        controlData[maxParams],
+        lastControlData[maxParams];
     sol::userdata paramsUserData, controlsUserData;
     PortList ports;
 
@@ -102,6 +113,7 @@ private:
     struct Position;
 
     void deref();
+    bool prepareFrame();
     void getParameterData (juce::MemoryBlock&, bool);
     void setParameterData (juce::MemoryBlock&, bool);
     void addAudioMidiPorts();
@@ -0,0 +1,134 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cstdlib>
+#include <cstring>
+
+#include "scripting/scriptallocator.hpp"
+
+namespace element {
+
+ScriptAllocator::ScriptAllocator (size_t budgetBytes)
+    : budget (juce::jmax (maxBlockSize, budgetBytes))
+{
+    arena.malloc (budget);
+}
+
+ScriptAllocator::~ScriptAllocator() {}
+
+int ScriptAllocator::getClass (size_t size) noexcept
+{
+    int index = 0;
+    for (size_t block = minBlockSize; block < size; block <<= 1)
+        ++index;
+    return index;
+}
+
+bool ScriptAllocator::owns (const void* ptr) const noexcept
+{
+    const auto* p = static_cast<const char*> (ptr);
+    return p >= arena.get() && p < arena.get() + budget;
+}
+
+void* ScriptAllocator::alloc (size_t size) noexcept
+{
+    if (size <= maxBlockSize)
+    {
+        const auto index = getClass (size);
+        if (auto* block = freeLists[index])
+        {
+            freeLists[index] = block->next;
+            return block;
+        }
+
+        const auto blockSize = minBlockSize << index;
+        if (top + blockSize <= budget)
+        {
+            auto* block = arena.get() + top;
+            top += blockSize;
+            return block;
+        }
+    }
+
+    if (realtime)
+    {
+        failures.fetch_add (1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    return std::malloc (size);
+}
+
+void ScriptAllocator::release (void* ptr, size_t size) noexcept
+{
+    if (! owns (ptr))
+    {
+        std::free (ptr);
+        return;
+    }
+
+    // a block shrunk in place goes back on the list of its smaller size,
+    // it's at least that big.
+    auto* block = static_cast<FreeBlock*> (ptr);
+    const auto index = getClass (juce::jmax (size, sizeof (FreeBlock)));
+    block->next = freeLists[index];
+    freeLists[index] = block;
+}
+
+void* ScriptAllocator::reallocate (void* ptr, size_t osize, size_t nsize) noexcept
+{
+    // Lua expects shrinking to succeed, blocks keep their memory.
+    if (nsize <= osize)
+        return ptr;
+
+    if (owns (ptr) && nsize <= maxBlockSize && getClass (nsize) == getClass (osize))
+        return ptr;
+
+    auto* newPtr = alloc (nsize);
+    if (newPtr == nullptr)
+        return nullptr;
+
+    std::memcpy (newPtr, ptr, osize);
+    release (ptr, osize);
+    return newPtr;
+}
+
+void ScriptAllocator::track (size_t oldSize, size_t newSize) noexcept
+{
+    const auto current = inUse.load (std::memory_order_relaxed) - oldSize + newSize;
+    inUse.store (current, std::memory_order_relaxed);
+    if (current > peak.load (std::memory_order_relaxed))
+        peak.store (current, std::memory_order_relaxed);
+}
+
+void* ScriptAllocator::allocate (void* ud, void* ptr, size_t osize, size_t nsize) noexcept
+{
+    auto& self = *static_cast<ScriptAllocator*> (ud);
+
+    // osize is a type tag when there's no block yet.
+    if (ptr == nullptr)
+        osize = 0;
+
+    if (nsize == 0)
+    {
+        if (ptr != nullptr)
+        {
+            self.release (ptr, osize);
+            self.track (osize, 0);
+        }
+        return nullptr;
+    }
+
+    auto* result = ptr == nullptr ? self.alloc (nsize)
+                                  : self.reallocate (ptr, osize, nsize);
+    if (result != nullptr)
+    {
+        self.track (osize, nsize);
+        // only the state's thread writes it, no need for a locked add.
+        self.allocations.store (self.allocations.load (std::memory_order_relaxed) + 1,
+                                std::memory_order_relaxed);
+    }
+    return result;
+}
+
+} // namespace element
@@ -0,0 +1,102 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** A Lua allocator that serves a state from one preallocated arena.
+
+    Blocks come from power-of-two size classes with a free list each, so
+    allocating and freeing is a pop or a push. Lua passes the old size of
+    every block it frees, so blocks don't need headers. Arena memory is
+    only given back when the allocator is destroyed.
+
+    While realtime, requests the arena can't serve fail and are counted
+    instead of going to malloc, Lua raises them as memory errors. Outside
+    of that, e.g. while a script loads, they fall back to the system heap.
+
+    Not thread safe, it follows the same rules as the lua_State using it.
+ */
+class ScriptAllocator final
+{
+public:
+    static constexpr size_t defaultBudget = 4 * 1024 * 1024;
+    static constexpr size_t minBlockSize = 16;
+    static constexpr size_t maxBlockSize = 64 * 1024;
+
+    /** Create an allocator with an arena of budgetBytes. */
+    explicit ScriptAllocator (size_t budgetBytes = defaultBudget);
+    ~ScriptAllocator();
+
+    /** The lua_Alloc function, pass this as its user data. */
+    static void* allocate (void* ud, void* ptr, size_t osize, size_t nsize) noexcept;
+
+    /** Set whether allocations must stay in the arena. */
+    void setRealtime (bool shouldBeRealtime) noexcept { realtime = shouldBeRealtime; }
+    bool isRealtime() const noexcept { return realtime; }
+
+    /** Realtime for the lifetime of this object. */
+    struct ScopedRealtime
+    {
+        explicit ScopedRealtime (ScriptAllocator& a) noexcept : allocator (a), was (a.isRealtime())
+        {
+            allocator.setRealtime (true);
+        }
+
+        ~ScopedRealtime() { allocator.setRealtime (was); }
+
+    private:
+        ScriptAllocator& allocator;
+        const bool was;
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtime)
+    };
+
+    /** Size of the arena in bytes. */
+    size_t getBudget() const noexcept { return budget; }
+
+    /** Bytes Lua currently has allocated. Any thread. */
+    size_t getBytesInUse() const noexcept { return inUse.load (std::memory_order_relaxed); }
+
+    /** Most bytes Lua had allocated at once. Any thread. */
+    size_t getPeakBytes() const noexcept { return peak.load (std::memory_order_relaxed); }
+
+    /** Allocations and reallocations served so far. Any thread. */
+    juce::int64 getNumAllocations() const noexcept { return allocations.load (std::memory_order_relaxed); }
+
+    /** Realtime requests that couldn't be served. Any thread. */
+    juce::int64 getNumFailures() const noexcept { return failures.load (std::memory_order_relaxed); }
+
+private:
+    static constexpr int numClasses = 13; // 16 bytes to 64k
+    static_assert ((minBlockSize << (numClasses - 1)) == maxBlockSize);
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    juce::HeapBlock<char> arena;
+    const size_t budget;
+    size_t top = 0;
+    FreeBlock* freeLists[numClasses] = {};
+    bool realtime = false;
+
+    std::atomic<size_t> inUse { 0 }, peak { 0 };
+    std::atomic<juce::int64> failures { 0 }, allocations { 0 };
+
+    static int getClass (size_t size) noexcept;
+    bool owns (const void* ptr) const noexcept;
+    void* alloc (size_t size) noexcept;
+    void release (void* ptr, size_t size) noexcept;
+    void* reallocate (void* ptr, size_t osize, size_t nsize) noexcept;
+    void track (size_t oldSize, size_t newSize) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (ScriptAllocator)
+};
+
+} // namespace element
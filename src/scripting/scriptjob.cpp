@@ -0,0 +1,142 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "sol/sol.hpp"
+#include "scripting.hpp"
+#include "scripting/bindings.hpp"
+#include "scripting/scriptjob.hpp"
+
+namespace element {
+using namespace juce;
+
+namespace {
+// the job whose script runs on this thread, for the cancel hook.
+thread_local Thread* runningJob = nullptr;
+
+void stopIfCancelled (lua_State* L, lua_Debug*)
+{
+    if (runningJob != nullptr && runningJob->threadShouldExit())
+        luaL_error (L, "cancelled");
+}
+} // namespace
+
+ScriptJob::ScriptJob (ScriptingEngine& e, const String& n, const String& c)
+    : Thread ("element: script " + n),
+      engine (e),
+      name (n),
+      code (c)
+{
+}
+
+ScriptJob::~ScriptJob()
+{
+    cancel();
+    stopThread (10 * 1000);
+    cancelPendingUpdate();
+}
+
+void ScriptJob::start()
+{
+    jassert (! isThreadRunning());
+    startThread (Thread::Priority::low);
+}
+
+void ScriptJob::cancel()
+{
+    signalThreadShouldExit();
+}
+
+void ScriptJob::run()
+{
+    sol::state lua;
+    Lua::initializeState (lua);
+
+    lua.set_function ("print", [this, &lua] (sol::variadic_args va) {
+        String line;
+        sol::function tostring = lua["tostring"];
+        for (auto v : va)
+        {
+            sol::object str = tostring ((sol::object) v);
+            if (str.is<std::string>())
+                line << str.as<std::string>() << " ";
+        }
+
+        const ScopedLock sl (lock);
+        printed.add (line.trimEnd());
+        triggerAsyncUpdate();
+    });
+
+    auto job = lua.create_named_table ("job");
+    job.set_function ("post", [this] (const std::string& chunk) {
+        const ScopedLock sl (lock);
+        posted.add (String (chunk));
+        triggerAsyncUpdate();
+    });
+    job.set_function ("progress", [this] (double fraction, sol::optional<std::string> text) {
+        {
+            const ScopedLock sl (lock);
+            progressText = text ? String (*text) : String();
+        }
+        progress.store (jlimit (0.f, 1.f, (float) fraction));
+        progressChanged.store (true);
+        triggerAsyncUpdate();
+    });
+    job.set_function ("cancelled", [this]() { return threadShouldExit(); });
+
+    runningJob = this;
+    lua_sethook (lua, stopIfCancelled, LUA_MASKCOUNT, 4096);
+
+    Result outcome = Result::ok();
+    auto ret = lua.safe_script (code.toStdString(), sol::script_pass_on_error, name.toStdString());
+    if (! ret.valid())
+    {
+        sol::error error = ret;
+        outcome = Result::fail (threadShouldExit() ? String ("cancelled") : String (error.what()));
+    }
+
+    lua_sethook (lua, nullptr, 0, 0);
+    runningJob = nullptr;
+
+    const ScopedLock sl (lock);
+    result = outcome;
+    done = true;
+    triggerAsyncUpdate();
+}
+
+void ScriptJob::handleAsyncUpdate()
+{
+    StringArray chunks, lines;
+    String text;
+    bool wasDone = false;
+    {
+        const ScopedLock sl (lock);
+        chunks.swapWith (posted);
+        lines.swapWith (printed);
+        text = progressText;
+        wasDone = done;
+    }
+
+    for (const auto& line : lines)
+        if (onPrint)
+            onPrint (line);
+
+    // everything posted since the last turn is applied together.
+    if (! chunks.isEmpty() && ! threadShouldExit())
+    {
+        const auto applied = engine.executeBatch (chunks);
+        if (applied.failed() && onPrint)
+            onPrint (applied.getErrorMessage());
+    }
+
+    if (progressChanged.exchange (false) && onProgress)
+        onProgress (progress.load(), text);
+
+    if (wasDone && ! finished)
+    {
+        finished = true;
+        if (onFinished)
+            onFinished (result);
+    }
+}
+
+} // namespace element
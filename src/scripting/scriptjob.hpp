@@ -0,0 +1,82 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <functional>
+
+#include <element/juce/core.hpp>
+#include <element/juce/events.hpp>
+
+namespace element {
+
+class ScriptingEngine;
+
+/** Runs a script on its own thread with its own Lua state, so long work
+    like generating graphs or processing files doesn't hold up the UI.
+
+    The job's state has the standard libraries and Element's packages but
+    none of the application's objects, which belong to the message thread.
+    A script hands changes back with `job.post (code)`. Posted chunks run
+    against the main state on the message thread, everything that arrived
+    together inside one engine batch. `job.progress (fraction, text)`
+    reports how far it got, and `job.cancelled()` says if it should stop.
+    A cancelled script that doesn't check is stopped with an error a few
+    thousand instructions later.
+
+    Callbacks are called on the message thread.
+ */
+class ScriptJob final : private juce::Thread,
+                        private juce::AsyncUpdater
+{
+public:
+    ScriptJob (ScriptingEngine& engine, const juce::String& name, const juce::String& code);
+
+    /** Cancels the job and waits for it to stop. */
+    ~ScriptJob() override;
+
+    /** Returns the name the job was given, used as its chunk name. */
+    const juce::String& getName() const noexcept { return name; }
+
+    /** Start running the script. */
+    void start();
+
+    /** Ask the script to stop. */
+    void cancel();
+
+    /** Returns true until the script and everything it posted has run. */
+    bool isRunning() const noexcept { return ! finished; }
+
+    /** Returns the last progress reported, from 0 to 1. */
+    float getProgress() const noexcept { return progress.load(); }
+
+    /** Called with each line the script prints. */
+    std::function<void (const juce::String&)> onPrint;
+
+    /** Called when the script reports progress. */
+    std::function<void (float, const juce::String&)> onProgress;
+
+    /** Called once when the job is done, with the script's error if any. */
+    std::function<void (const juce::Result&)> onFinished;
+
+private:
+    ScriptingEngine& engine;
+    const juce::String name, code;
+
+    juce::CriticalSection lock;
+    juce::StringArray posted, printed;
+    juce::String progressText;
+    juce::Result result { juce::Result::ok() };
+    bool done = false; // under lock, the script returned
+    bool finished = false; // message thread, onFinished was called
+
+    std::atomic<float> progress { 0.f };
+    std::atomic<bool> progressChanged { false };
+
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScriptJob)
+};
+
+} // namespace element
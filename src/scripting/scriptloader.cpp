@@ -5,10 +5,66 @@
 #include "scripting/bindings.hpp"
 #include <element/script.hpp>
 #include "scripting/scriptloader.hpp"
+#include "datapath.hpp"
 
 namespace element {
 using namespace juce;
 
+namespace detail {
+static CriticalSection cacheLock;
+static File& cacheDirectory()
+{
+    static File dir = DataPath::defaultScriptCacheDir();
+    return dir;
+}
+
+static int writeChunk (lua_State*, const void* data, size_t size, void* stream)
+{
+    return static_cast<MemoryOutputStream*> (stream)->write (data, size) ? 0 : 1;
+}
+
+/** Dump the function at index and write it to file, replacing any older copy. */
+static void storeChunk (lua_State* L, int index, const File& file)
+{
+    MemoryOutputStream code;
+    lua_pushvalue (L, index);
+    const bool dumped = lua_dump (L, writeChunk, &code, 0) == 0;
+    lua_pop (L, 1);
+
+    if (! dumped || code.getDataSize() == 0 || ! file.getParentDirectory().createDirectory())
+        return;
+
+    TemporaryFile temp (file);
+    if (temp.getFile().replaceWithData (code.getData(), code.getDataSize()))
+        temp.overwriteTargetFileWithTemporary();
+}
+} // namespace detail
+
+void ScriptLoader::setCacheDirectory (const File& dir)
+{
+    const ScopedLock sl (detail::cacheLock);
+    detail::cacheDirectory() = dir;
+}
+
+File ScriptLoader::getCacheDirectory()
+{
+    const ScopedLock sl (detail::cacheLock);
+    return detail::cacheDirectory();
+}
+
+File ScriptLoader::getCacheFile (const String& source, const std::string& chunk)
+{
+    const auto dir = getCacheDirectory();
+    if (dir == File())
+        return {};
+
+    String name;
+    name << String::toHexString (source.hashCode64()) << "-"
+         << String::toHexString (String (chunk).hashCode64()) << "-"
+         << String ((int64) source.getNumBytesAsUTF8()) << ".luac";
+    return dir.getChildFile (name);
+}
+
 ScriptLoader::ScriptLoader (lua_State* state)
 {
     ownedstate = state == nullptr;
@@ -77,10 +133,34 @@ bool ScriptLoader::load (const String& buffer)
     info = ScriptInfo::parse (buffer);
     std::string chunk = info.name.isNotEmpty() ? info.name.toStdString() : "script=";
     error = "";
+    fromcache = false;
 
     try
     {
-        loaded = view.load_buffer (buffer.toRawUTF8(), (size_t) buffer.length(), chunk);
+        const auto cacheFile = getCacheFile (buffer, chunk);
+        MemoryBlock code;
+        if (cacheFile.existsAsFile() && cacheFile.loadFileAsData (code))
+        {
+            auto binary = view.load_buffer ((const char*) code.getData(), code.getSize(), chunk, sol::load_mode::binary);
+            if (binary.valid())
+            {
+                loaded = std::move (binary);
+                fromcache = true;
+            }
+            else
+            {
+                // stale or from another Lua build, compile it again below.
+                cacheFile.deleteFile();
+            }
+        }
+
+        if (! fromcache)
+        {
+            loaded = view.load_buffer (buffer.toRawUTF8(), buffer.getNumBytesAsUTF8(), chunk);
+            if (loaded.valid() && cacheFile != File())
+                detail::storeChunk (L, loaded.stack_index(), cacheFile);
+        }
+
         switch (loaded.status())
         {
             case sol::load_status::file:
@@ -73,11 +73,28 @@ public:
     bool hasError() const { return error.isNotEmpty(); }
     juce::String getErrorMessage() const { return error; }
 
+    /** Returns true if the last load() used a cached chunk. */
+    bool isFromCache() const { return fromcache; }
+
+    /** Set the directory compiled chunks are cached in. Chunks are keyed by
+        a hash of their source and chunk name, so edited scripts miss and get
+        compiled again. Pass an invalid File to turn the cache off. Defaults
+        to DataPath::defaultScriptCacheDir().
+     */
+    static void setCacheDirectory (const juce::File& dir);
+
+    /** Returns the directory compiled chunks are cached in. */
+    static juce::File getCacheDirectory();
+
+    /** Returns the cache file for a source and chunk name. */
+    static juce::File getCacheFile (const juce::String& source, const std::string& chunk);
+
 private:
     ScriptInfo info;
     lua_State* L = nullptr;
     bool ownedstate = false;
     bool hasloaded = false;
+    bool fromcache = false;
     sol::load_result loaded;
     juce::String error;
 
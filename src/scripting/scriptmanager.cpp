@@ -7,28 +7,20 @@
 #include "scripting/scriptmanager.hpp"
 #include "scripting/bindings.hpp"
 #include "datapath.hpp"
+#include "filesystemwatcher.hpp"
 #include "sol/sol.hpp"
 
 namespace element {
 
-static void scanForScripts (File dir, Array<ScriptInfo>& results, bool recursive = true)
+static ScriptInfo parseScript (const File& file)
 {
-    for (DirectoryEntry entry : RangedDirectoryIterator (dir, recursive, "*.lua"))
+    try
     {
-        ScriptInfo desc;
-        try
-        {
-            desc = ScriptInfo::parse (entry.getFile());
-        } catch (const std::exception& e)
-        {
-            DBG (e.what());
-            desc = {};
-        }
-
-        if (desc.valid())
-        {
-            results.add (desc);
-        }
+        return ScriptInfo::parse (file);
+    } catch (const std::exception& e)
+    {
+        DBG (e.what());
+        return {};
     }
 }
 
@@ -38,11 +30,13 @@ static File getDefaultScriptsDir()
 }
 
 //==============================================================================
-class ScriptManager::Registry
+class ScriptManager::Registry : private FileSystemWatcher::Listener
 {
 public:
     Registry (ScriptManager& sm)
-        : owner (sm) {}
+        : owner (sm) { watcher.addListener (this); }
+
+    ~Registry() { watcher.removeListener (this); }
 
     void scanDefaults()
     {
@@ -54,34 +48,70 @@ public:
         if (! dir.isDirectory())
             return;
 
-        Array<ScriptInfo> results;
-        scanForScripts (dir, results);
-        Array<ScriptInfo> newDSP;
-        Array<ScriptInfo> newDSPUI;
-
-        for (int i = 0; i < results.size(); ++i)
+        root = dir;
+        files.clear();
+        for (const auto& entry : RangedDirectoryIterator (dir, true, "*.lua"))
         {
-            const auto d = results[i];
-            if (d.type.toLowerCase() == "dsp")
-            {
-                newDSP.add (d);
-            }
-            else if (d.type.toLowerCase() == "dspui")
-            {
-                newDSPUI.add (d);
-            }
+            const auto desc = parseScript (entry.getFile());
+            if (desc.valid())
+                files[entry.getFile().getFullPathName()] = desc;
         }
 
-        scripts.swapWith (results);
-        dsp.swapWith (newDSP);
-        dspui.swapWith (newDSPUI);
+        collect();
+        watch();
     }
 
 private:
     friend class ScriptManager;
     [[maybe_unused]] ScriptManager& owner;
+    File root;
+    std::map<String, ScriptInfo> files; // by full path
     Array<ScriptInfo> scripts;
     Array<ScriptInfo> dsp, dspui;
+    FileSystemWatcher watcher;
+
+    void collect()
+    {
+        Array<ScriptInfo> results, newDSP, newDSPUI;
+        for (const auto& [path, desc] : files)
+        {
+            results.add (desc);
+            if (desc.type.toLowerCase() == "dsp")
+                newDSP.add (desc);
+            else if (desc.type.toLowerCase() == "dspui")
+                newDSPUI.add (desc);
+        }
+
+        scripts.swapWith (results);
+        dsp.swapWith (newDSP);
+        dspui.swapWith (newDSPUI);
+    }
+
+    void watch()
+    {
+        // the watcher isn't recursive everywhere.
+        watcher.removeAllFolders();
+        watcher.addFolder (root);
+        for (const auto& entry : RangedDirectoryIterator (root, true, "*", File::findDirectories))
+            watcher.addFolder (entry.getFile());
+    }
+
+    // only the script that changed is read again.
+    void fileChanged (const File& file, FileSystemWatcher::FileSystemEvent) override
+    {
+        if (file.isDirectory() || watcher.getWatchedFolders().contains (file))
+            return scanDirectory (root);
+        if (! file.hasFileExtension ("lua"))
+            return;
+
+        const auto path = file.getFullPathName();
+        const auto desc = file.existsAsFile() ? parseScript (file) : ScriptInfo();
+        if (desc.valid())
+            files[path] = desc;
+        else if (files.erase (path) == 0)
+            return;
+        collect();
+    }
 };
 
 //==============================================================================
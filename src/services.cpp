@@ -14,6 +14,7 @@
 
 #include "services/deviceservice.hpp"
 #include "services/mappingservice.hpp"
+#include "services/metricsservice.hpp"
 #include "services/oscservice.hpp"
 #include "services/sessionservice.hpp"
 #include "services/presetservice.hpp"
@@ -22,7 +23,7 @@
 namespace element {
 using namespace juce;
 
-class Services::Impl
+class Services::Impl : private AsyncUpdater
 {
 public:
     Impl (Services& sm, Context& g, RunMode m)
@@ -56,18 +57,33 @@ public:
             }
         }
 
+        // the rest wait for the message loop, one a turn, so the window
+        // and engine are usable first.
+        activated = true;
         for (auto* s : services)
-            s->activate();
+            if (! s->isDeferred())
+                activate (*s);
+        triggerAsyncUpdate();
+    }
 
-        activated = true;
+    void activate (Service& service)
+    {
+        if (service.active)
+            return;
+        service.active = true;
+        service.activate();
     }
 
     void deactivate()
     {
-        for (auto* s : services)
-            s->deactivate();
-
+        cancelPendingUpdate();
         activated = false;
+        for (auto* s : services)
+        {
+            if (s->active)
+                s->deactivate();
+            s->active = false;
+        }
     }
 
 private:
@@ -81,6 +97,19 @@ private:
     juce::File lastExportedGraph;
     Context& world;
     RunMode runMode;
+
+    void handleAsyncUpdate() override
+    {
+        for (auto* s : services)
+        {
+            if (! s->active)
+            {
+                activate (*s);
+                triggerAsyncUpdate();
+                return;
+            }
+        }
+    }
 };
 
 Services& Service::services() const
@@ -97,13 +126,16 @@ RunMode Service::getRunMode() const { return services().getRunMode(); }
 Services::Services (Context& g, RunMode m)
 {
     impl = std::make_unique<Impl> (*this, g, m);
-    add (new GuiService (g, *this));
+    // headless runs without windows, so nothing that needs one is made.
+    if (m != RunMode::Headless)
+        add (new GuiService (g, *this));
     add (new DeviceService());
     add (new EngineService());
     add (new MappingService());
     add (new PresetService());
     add (new SessionService());
     add (new OSCService());
+    add (new MetricsService());
 }
 
 Services::~Services()
@@ -115,6 +147,12 @@ void Services::initialize() { impl->initialize(); }
 void Services::activate() { impl->activate(); }
 void Services::deactivate() { impl->deactivate(); }
 
+void Services::require (Service& service) const
+{
+    if (impl != nullptr && impl->activated)
+        impl->activate (service);
+}
+
 RunMode Services::getRunMode() const { return impl->runMode; }
 Context& Services::context() { return impl->world; }
 
@@ -201,7 +239,8 @@ void Services::handleMessage (const Message& msg)
     auto* devs = find<DeviceService>();
     auto* maps = find<MappingService>();
     auto* presets = find<PresetService>();
-    jassert (ec && gui && sess && devs && maps && presets);
+    jassert (ec && sess && devs && maps && presets);
+    jassert (gui != nullptr || getRunMode() == RunMode::Headless);
 
     bool handled = false; // final else condition will set false
     auto& services = impl->services;
@@ -289,8 +328,8 @@ void Services::handleMessage (const Message& msg)
         else
             ec->addNode (anm->node);
 
-        if (anm->sourceFile.existsAsFile() && anm->sourceFile.hasFileExtension (".elg"))
-            find<UI>()->recentFiles().addFile (anm->sourceFile);
+        if (auto* ui = find<UI>(); ui && anm->sourceFile.existsAsFile() && anm->sourceFile.hasFileExtension (".elg"))
+            ui->recentFiles().addFile (anm->sourceFile);
     }
     else if (const auto* cbm = dynamic_cast<const ChangeBusesLayout*> (&msg))
     {
@@ -299,7 +338,8 @@ void Services::handleMessage (const Message& msg)
     else if (const auto* osm = dynamic_cast<const OpenSessionMessage*> (&msg))
     {
         sess->openFile (osm->file);
-        find<UI>()->recentFiles().addFile (osm->file);
+        if (auto* ui = find<UI>())
+            ui->recentFiles().addFile (osm->file);
     }
     else if (const auto* mdm = dynamic_cast<const AddMidiDeviceMessage*> (&msg))
     {
@@ -348,7 +388,8 @@ void Services::handleMessage (const Message& msg)
     {
         const auto controllerMap = removeMapMessage->controllerMap;
         maps->remove (controllerMap);
-        gui->stabilizeViews();
+        if (gui != nullptr)
+            gui->stabilizeViews();
     }
     else if (const auto* replaceNodeMessage = dynamic_cast<const ReplaceNodeMessage*> (&msg))
     {
@@ -42,8 +42,12 @@ struct RootGraphHolder
     /** This will create a root graph processor/controller and load it if not
         done already. Properties are set from the model, so make sure they are
         correct before calling this 
+
+        With loadGraph false the graph is added to the engine empty and its
+        nodes are created later with load(). With cue true it's added as a
+        graph of the session that plays next.
      */
-    bool attach (AudioEnginePtr engine)
+    bool attach (AudioEnginePtr engine, bool loadGraph = true, bool cue = false)
     {
         jassert (engine);
         if (! engine)
@@ -83,13 +87,18 @@ struct RootGraphHolder
             root->setRenderMode (mode);
             root->setMidiChannels (channels);
             root->setMidiProgram (program);
+            root->setName (model.getName());
+            root->setDevicePortsEnabled ((bool) model.getProperty (tags::devicePorts, false));
+            root->setDoublePrecision ((bool) model.getProperty (tags::doublePrecision, false));
+            root->setInternalRate ((double) model.getProperty (tags::internalRate, 0.0));
 
-            if (engine->addGraph (root))
+            if (cue ? engine->addCuedGraph (root) : engine->addGraph (root))
             {
                 controller = std::make_unique<RootGraphManager> (*root, plugins);
                 model.setProperty (tags::object, node.get());
 
-                controller->setNodeModel (model);
+                if (loadGraph)
+                    controller->setNodeModel (model);
             }
             else
             {
@@ -121,6 +130,21 @@ struct RootGraphHolder
         return wasRemoved;
     }
 
+    /** Create the graph's nodes if it was attached without them. */
+    bool load()
+    {
+        if (! attached())
+            return false;
+        if (! controller->isLoaded())
+        {
+            controller->getRootGraph().setPlayConfigFor (devices);
+            controller->setNodeModel (model);
+        }
+        return true;
+    }
+
+    bool isLoaded() const { return attached() && controller->isLoaded(); }
+
     RootGraphManager* getController() const { return controller.get(); }
     RootGraph* getRootGraph() const { return dynamic_cast<RootGraph*> (node ? node.get() : nullptr); }
 
@@ -138,11 +162,11 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RootGraphHolder);
 };
 
-class EngineService::RootGraphs
+class EngineService::RootGraphs : private Timer
 {
 public:
     RootGraphs (EngineService& e) : owner (e) {}
-    ~RootGraphs() {}
+    ~RootGraphs() { stopTimer(); }
 
     RootGraphHolder* add (RootGraphHolder* item)
     {
@@ -152,6 +176,7 @@ public:
 
     void clear()
     {
+        stopTimer();
         detachAll();
         graphs.clear();
     }
@@ -205,8 +230,13 @@ public:
      */
     GraphManager* findGraphManagerFor (const Node& graph)
     {
-        for (const auto* h : graphs)
+        for (auto* h : graphs)
         {
+            // a graph still waiting to load is loaded now if it's asked for.
+            if (h->attached() && ! h->isLoaded()
+                && (h->model.data() == graph.data() || graph.data().isAChildOf (h->model.data())))
+                h->load();
+
             if (auto* m1 = h->controller.get())
                 if (auto* m2 = m1->findGraphManagerForGraph (graph))
                     return m2;
@@ -236,6 +266,14 @@ public:
             g->detach (engine);
     }
 
+    /** Loads graphs that were attached empty, one per timer tick in session
+        order, so the message thread keeps running between them.
+     */
+    void loadPending()
+    {
+        startTimer (1);
+    }
+
     // remove the holder, this will also delete it!
     void remove (RootGraphHolder* g)
     {
@@ -244,9 +282,39 @@ public:
 
     const OwnedArray<RootGraphHolder>& getGraphs() const { return graphs; }
 
+    void beginBatch()
+    {
+        for (auto* h : graphs)
+            if (auto* c = h->getController())
+                c->beginBatch();
+    }
+
+    void endBatch()
+    {
+        for (auto* h : graphs)
+            if (auto* c = h->getController())
+                c->endBatch();
+    }
+
 private:
     EngineService& owner;
     SessionPtr session;
+
+    void timerCallback() override
+    {
+        for (auto* h : graphs)
+        {
+            if (h->attached() && ! h->isLoaded())
+            {
+                h->load();
+                DBG ("[element] graph loaded: " << h->model.getName());
+                return;
+            }
+        }
+
+        stopTimer();
+    }
+
     AudioEnginePtr engine;
     OwnedArray<RootGraphHolder> graphs;
 };
@@ -255,10 +323,12 @@ EngineService::EngineService()
     : Service()
 {
     graphs = std::make_unique<RootGraphs> (*this);
+    cued = std::make_unique<RootGraphs> (*this);
 }
 
 EngineService::~EngineService()
 {
+    cued = nullptr;
     graphs = nullptr;
 }
 
@@ -433,7 +503,8 @@ void EngineService::removeGraph (int index)
     if (toRemove.isValid())
         sigNodeRemoved (toRemove);
     // FIXME: dont notify the UI top-down
-    sibling<UI>()->stabilizeContent();
+    if (auto* gui = sibling<UI>())
+        gui->stabilizeContentLater();
 }
 
 void EngineService::connectChannels (const Node& graph, const Node& src, const int sc, const Node& dst, const int dc)
@@ -469,6 +540,7 @@ void EngineService::connect (PortType type, const Node& src, int sc, const Node&
         nc = 1;
     if (auto manager = graphs->findGraphManagerFor (src.getParentGraph()))
     {
+        const GraphManager::ScopedBatch batch (*manager);
         auto s = src.getObject();
         auto d = dst.getObject();
         while (s && d && --nc >= 0)
@@ -522,6 +594,7 @@ Node EngineService::addNode (const Node& node, const Node& target, const Connect
 
     if (auto* controller = graphs->findGraphManagerFor (target))
     {
+        const GraphManager::ScopedBatch batch (*controller);
         const uint32 nodeId = controller->addNode (ref);
         ref = controller->getNodeModelForId (nodeId);
         if (ref.isValid())
@@ -565,8 +638,8 @@ void EngineService::addNode (const Node& _node)
     if (EL_INVALID_NODE != nodeId)
     {
         const Node actual (root->getNodeModelForId (nodeId));
-        if (context().settings().showPluginWindowsWhenAdded())
-            sibling<GuiService>()->presentPluginWindow (actual);
+        if (auto* gui = sibling<GuiService>(); gui && context().settings().showPluginWindowsWhenAdded())
+            gui->presentPluginWindow (actual);
     }
     else
     {
@@ -609,8 +682,9 @@ Node EngineService::addPlugin (const PluginDescription& desc, const bool verifie
         if (EL_INVALID_NODE != nodeId)
         {
             node = root->getNodeModelForId (nodeId);
-            if (! dontShowUI && context().settings().showPluginWindowsWhenAdded())
-                sibling<GuiService>()->presentPluginWindow (node);
+            auto* gui = sibling<GuiService>();
+            if (gui && ! dontShowUI && context().settings().showPluginWindowsWhenAdded())
+                gui->presentPluginWindow (node);
         }
     }
     else
@@ -630,9 +704,12 @@ void EngineService::removeNode (const Node& node)
     if (auto* manager = graphs->findGraphManagerFor (graph))
     {
         jassert (manager->contains (node.getNodeId()));
-        gui->closePluginWindowsFor (node, true);
-        if (gui->getSelectedNode() == node)
-            gui->selectNode (Node());
+        if (gui != nullptr)
+        {
+            gui->closePluginWindowsFor (node, true);
+            if (gui->getSelectedNode() == node)
+                gui->selectNode (Node());
+        }
         manager->removeNode (node.getNodeId());
         sigNodeRemoved (node);
     }
@@ -702,6 +779,10 @@ void EngineService::activate()
     engine->setSession (session);
     engine->activate();
 
+    // plugins are created, and kept warm, at the device's config.
+    if (auto* device = globals.devices().getCurrentAudioDevice())
+        globals.plugins().setPlayConfig (device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples());
+
     sessionReloaded();
 }
 
@@ -720,6 +801,7 @@ void EngineService::deactivate()
     }
 
     session->saveGraphState();
+    cued->clear();
     graphs->clear();
 
     engine->deactivate();
@@ -814,6 +896,9 @@ void EngineService::syncModels()
 {
     for (auto* holder : graphs->getGraphs())
     {
+        if (! holder->isLoaded())
+            continue;
+
         Node graph (holder->model);
         for (int i = 0; i < graph.getNumNodes(); ++i)
         {
@@ -909,7 +994,9 @@ void EngineService::sessionReloaded()
             Node rootGraph (session->getGraph (i));
             if (auto* holder = graphs->add (new RootGraphHolder (rootGraph, context())))
             {
-                if (! holder->attach (engine))
+                // every graph goes in the engine now so indexes follow the
+                // session, but only the active one is loaded before returning.
+                if (! holder->attach (engine, false))
                 {
                     std::clog << "[element] failed attaching root grapn: " << holder->model.getName() << std::endl;
                 }
@@ -923,6 +1010,7 @@ void EngineService::sessionReloaded()
 
         const auto ag = session->getActiveGraph();
         setRootNode (ag);
+        graphs->loadPending();
     }
 
     if (session->getNumGraphs() != graphs->getGraphs().size())
@@ -935,6 +1023,70 @@ void EngineService::sessionReloaded()
     }
 }
 
+bool EngineService::cueSession (const ValueTree& data)
+{
+    if (! data.hasType (types::Session))
+        return false;
+
+    cued->clear();
+
+    auto engine = context().audio();
+    const auto graphsData = data.getChildWithName (tags::graphs);
+    for (int i = 0; i < graphsData.getNumChildren(); ++i)
+    {
+        Node rootGraph (graphsData.getChild (i), false);
+        if (auto* holder = cued->add (new RootGraphHolder (rootGraph, context())))
+        {
+            // in the engine right away so it's prepared, the nodes come a
+            // graph per tick so the message thread keeps up with the show.
+            if (! holder->attach (engine, false, true))
+                std::clog << "[element] failed cueing root graph: " << holder->model.getName() << std::endl;
+        }
+    }
+
+    cued->loadPending();
+    return true;
+}
+
+bool EngineService::hasCuedSession() const
+{
+    return ! cued->getGraphs().isEmpty();
+}
+
+bool EngineService::isCuedSessionReady() const
+{
+    for (const auto* holder : cued->getGraphs())
+        if (! holder->isLoaded())
+            return false;
+    return hasCuedSession();
+}
+
+void EngineService::clearCuedSession()
+{
+    cued->clear();
+}
+
+void EngineService::switchToCuedSession()
+{
+    if (! hasCuedSession())
+        return;
+
+    // nothing is switched to half built, graphs still waiting load now.
+    for (auto* holder : cued->getGraphs())
+        holder->load();
+
+    auto engine = context().audio();
+    auto session = context().session();
+    engine->switchToCuedGraphs (session->getActiveGraphIndex());
+
+    // the graphs switched from are dropped once they've faded out.
+    std::swap (graphs, cued);
+    cued->clear();
+
+    setRootNode (session->getActiveGraph());
+    DBG ("[element] switched to cued session: " << session->getName());
+}
+
 Node EngineService::addPlugin (GraphManager& c, const PluginDescription& desc)
 {
     auto& plugins (context().plugins());
@@ -945,8 +1097,8 @@ Node EngineService::addPlugin (GraphManager& c, const PluginDescription& desc)
         plugins.addToKnownPlugins (desc);
 
         const Node node (c.getNodeModelForId (nodeId));
-        if (context().settings().showPluginWindowsWhenAdded())
-            sibling<GuiService>()->presentPluginWindow (node);
+        if (auto* gui = sibling<GuiService>(); gui && context().settings().showPluginWindowsWhenAdded())
+            gui->presentPluginWindow (node);
         if (! node.isValid())
         {
             jassertfalse; // fatal, but continue
@@ -1040,12 +1192,23 @@ void EngineService::changeBusesLayout (const Node& n, const AudioProcessor::Buse
                 controller->removeIllegalConnections();
                 controller->syncArcsModel();
 
-                sibling<GuiService>()->stabilizeViews();
+                if (auto* gui = sibling<GuiService>())
+                    gui->stabilizeViewsLater();
             }
         }
     }
 }
 
+void EngineService::beginBatch()
+{
+    graphs->beginBatch();
+}
+
+void EngineService::endBatch()
+{
+    graphs->endBatch();
+}
+
 void EngineService::replace (const Node& node, const PluginDescription& desc)
 {
     const auto graph (node.getParentGraph());
@@ -1054,6 +1217,7 @@ void EngineService::replace (const Node& node, const PluginDescription& desc)
 
     if (auto* ctl = graphs->findGraphManagerFor (graph))
     {
+        const GraphManager::ScopedBatch batch (*ctl);
         double x = 0.0, y = 0.0;
         node.getPosition (x, y);
         const auto oldNodeId = node.getNodeId();
@@ -1098,12 +1262,13 @@ void EngineService::replace (const Node& node, const PluginDescription& desc)
                 .setProperty ("windowY", (int) node.getProperty ("windowY"));
 
             removeNode (node);
-            if (wasWindowOpen)
-                sibling<GuiService>()->presentPluginWindow (newNode);
+            if (auto* gui = sibling<GuiService>(); gui && wasWindowOpen)
+                gui->presentPluginWindow (newNode);
         }
     }
 
-    sibling<GuiService>()->stabilizeViews();
+    if (auto* gui = sibling<GuiService>())
+        gui->stabilizeViewsLater();
 }
 
 } // namespace element
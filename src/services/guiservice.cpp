@@ -19,6 +19,7 @@
 #include "engine/midipanic.hpp"
 
 #include "appinfo.hpp"
+#include "messagescheduler.hpp"
 #include "services/sessionservice.hpp"
 #include "ui/virtualkeyboardview.hpp"
 #include "ui/aboutscreen.hpp"
@@ -159,6 +160,10 @@ private:
 static std::unique_ptr<GlobalLookAndFeel> sGlobalLookAndFeel;
 static Array<GuiService*> sGuiControllerInstances;
 
+// keys for coalescing posted refreshes.
+static const int stabilizeContentKey = 0;
+static const int stabilizeViewsKey = 0;
+
 class GuiService::UpdateManager
 {
 public:
@@ -309,6 +314,7 @@ private:
     juce::UndoManager undo;
     juce::File lastSavedFile;
     juce::File lastExportedGraph;
+    MessageScheduler scheduler;
 };
 
 //=============================================================================
@@ -388,6 +394,9 @@ void GuiService::activate()
 {
     context().devices().addChangeListener (this);
     impl->restoreRecents();
+
+    // actions count their size in bytes, see messages.cpp
+    impl->undo.setMaxNumberOfStoredUnits (settings().getUndoHistorySize() * 1024 * 1024, 10);
 }
 
 void GuiService::deactivate()
@@ -395,6 +404,15 @@ void GuiService::deactivate()
     context().devices().removeChangeListener (this);
     nodeSelected.disconnect_all_slots();
 
+    impl->scheduler.cancel (&stabilizeContentKey);
+    impl->scheduler.cancel (&stabilizeViewsKey);
+    const auto stats = impl->scheduler.getStats();
+    if (stats.numRun > 0)
+        Logger::writeToLog (String ("[element] UI updates: ") + String (stats.numRun) + " run, "
+                            + String (stats.numCoalesced) + " coalesced, " + String (stats.numDeferred)
+                            + " deferred, latency avg " + String (stats.averageLatencyMs, 2)
+                            + " ms, max " + String (stats.maxLatencyMs, 2) + " ms");
+
     saveProperties (settings().getUserSettings());
 
     closeAllPluginWindows (true);
@@ -674,6 +692,7 @@ void GuiService::run()
             mainWindow->setFullScreen (true);
         mainWindow->addToDesktop();
     }
+    mainWindow->updateActivity();
 
     sibling<SessionService>()->resetChanges();
     refreshSystemTray();
@@ -719,6 +738,8 @@ void GuiService::getAllCommands (Array<CommandID>& ids)
                     Commands::sessionDuplicateGraph,
                     Commands::sessionDeleteGraph,
                     Commands::sessionInsertPlugin,
+                    Commands::sessionCue,
+                    Commands::sessionSwitchToCued,
                     //======================================================================
                     Commands::importGraph,
                     Commands::exportGraph,
@@ -813,6 +834,20 @@ void GuiService::getCommandInfo (CommandID commandID, ApplicationCommandInfo& re
             result.setInfo ("Insert plugin", "Add a plugin in the current graph", "Session", Info::isDisabled);
             break;
         //======================================================================
+        case Commands::sessionCue:
+            result.setInfo ("Cue Session", "Load a session behind the current one", "Session", 0);
+            break;
+        case Commands::sessionSwitchToCued: {
+            auto* sc = sibling<SessionService>();
+            const auto cued = sc != nullptr ? sc->getCuedFile() : File();
+            result.setInfo (cued == File() ? String ("Switch to Cued Session")
+                                           : "Switch to " + cued.getFileNameWithoutExtension(),
+                            "Crossfade to the cued session",
+                            "Session",
+                            0);
+            result.setActive (cued != File());
+            break;
+        }
         case Commands::importGraph:
             result.setInfo ("Import graph", "Import a graph into current session", "Session", 0);
             break;
@@ -950,11 +985,13 @@ bool GuiService::perform (const InvocationInfo& info)
                 if (window->isOnDesktop())
                 {
                     window->removeFromDesktop();
+                    window->updateActivity();
                     closeAllPluginWindows (true);
                 }
                 else
                 {
                     window->addToDesktop();
+                    window->updateActivity();
                     window->toFront (true);
                     if (session)
                         showPluginWindowsFor (session->getActiveGraph(), true, false);
@@ -999,8 +1036,21 @@ bool GuiService::perform (const InvocationInfo& info)
             std::clog << "case Commands::sessionInsertPlugin:\n";
             break;
         //======================================================================
+        case Commands::sessionCue: {
+            FileChooser chooser ("Cue Session", impl->lastSavedFile, "*.els", true, false);
+            if (chooser.browseForFileToOpen())
+                sibling<SessionService>()->cueFile (chooser.getResult());
+            break;
+        }
+        case Commands::sessionSwitchToCued: {
+            const auto cued = sibling<SessionService>()->getCuedFile();
+            sibling<SessionService>()->switchToCuedSession();
+            if (cued != File())
+                impl->recents.addFile (cued);
+            break;
+        }
         case Commands::importGraph: {
-            FileChooser chooser ("Import Graph", impl->lastExportedGraph, "*.elg");
+            FileChooser chooser ("Import Graph", impl->lastExportedGraph, "*.elg;*.els");
             if (chooser.browseForFileToOpen())
                 sibling<SessionService>()->importGraph (chooser.getResult());
             break;
@@ -1076,6 +1126,18 @@ void GuiService::stabilizeContent()
     sigRefreshed();
 }
 
+void GuiService::stabilizeContentLater()
+{
+    impl->scheduler.post (&stabilizeContentKey, [this]() { stabilizeContent(); });
+}
+
+void GuiService::stabilizeViewsLater()
+{
+    impl->scheduler.post (&stabilizeViewsKey, [this]() { stabilizeViews(); });
+}
+
+MessageScheduler& GuiService::scheduler() { return impl->scheduler; }
+
 void GuiService::stabilizeViews()
 {
     if (auto* cc = _content.get())
@@ -1160,10 +1222,15 @@ bool GuiService::handleMessage (const AppMessage& msg)
     if (! actions.isEmpty())
     {
         auto& undo = impl->undo;
+        auto* engine = sibling<EngineService>();
+        if (engine != nullptr)
+            engine->beginBatch();
         undo.beginNewTransaction();
         for (auto* action : actions)
             undo.perform (action);
         actions.clearQuick (false);
+        if (engine != nullptr)
+            engine->endBatch();
         stabilizeViews();
         return true;
     }
@@ -330,7 +330,7 @@ void MappingService::onControlCaptured()
                 maps.addChild (newMap, -1, nullptr);
 
                 if (auto* gui = sibling<GuiService>())
-                    gui->stabilizeViews();
+                    gui->stabilizeViewsLater();
             }
         }
     }
@@ -0,0 +1,269 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <element/context.hpp>
+#include <element/node.hpp>
+#include <element/session.hpp>
+#include <element/settings.hpp>
+
+#include "engine/graphnode.hpp"
+#include "engine/midiengine.hpp"
+#include "services/metricsservice.hpp"
+#include "session/memoryreport.hpp"
+#include "session/pluginbridge.hpp"
+
+#if JUCE_LINUX
+#include <unistd.h>
+#elif JUCE_MAC
+#include <mach/mach.h>
+#endif
+
+namespace element {
+
+namespace detail {
+static int64 getResidentBytes()
+{
+#if JUCE_LINUX
+    const auto fields = StringArray::fromTokens (File ("/proc/self/statm").loadFileAsString(), true);
+    if (fields.size() > 1)
+        return fields[1].getLargeIntValue() * (int64) sysconf (_SC_PAGESIZE);
+#elif JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info (mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS)
+        return (int64) info.resident_size;
+#endif
+    return -1;
+}
+
+static String escapeLabel (const String& value)
+{
+    return value.replace ("\\", "\\\\").replace ("\"", "\\\"").replace ("\n", "\\n");
+}
+
+/** Writes one metric with its HELP and TYPE lines. */
+template <typename Value>
+static void addMetric (String& text, const char* name, const char* type, const char* help, Value value, const String& labels = {})
+{
+    text << "# HELP " << name << " " << help << "\n"
+         << "# TYPE " << name << " " << type << "\n"
+         << name;
+    if (labels.isNotEmpty())
+        text << "{" << labels << "}";
+    text << " " << value << "\n";
+}
+} // namespace detail
+
+//==============================================================================
+/** Answers HTTP requests on a thread of its own with the latest text. */
+class MetricsService::Server : public Thread
+{
+public:
+    Server() : Thread ("element: metrics") {}
+    ~Server() override { stop(); }
+
+    bool start (int newPort)
+    {
+        stop();
+        if (! socket.createListener (newPort, "127.0.0.1"))
+            return false;
+        port = newPort;
+        startThread();
+        return true;
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        // closing the listener wakes the waiting accept.
+        socket.close();
+        stopThread (2000);
+        port = 0;
+    }
+
+    int getPort() const noexcept { return port; }
+
+    void setText (const String& newText)
+    {
+        const ScopedLock sl (lock);
+        text = newText;
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            std::unique_ptr<StreamingSocket> client (socket.waitForNextConnection());
+            if (client != nullptr && ! threadShouldExit())
+                respond (*client);
+        }
+    }
+
+private:
+    StreamingSocket socket;
+    std::atomic<int> port { 0 };
+    CriticalSection lock;
+    String text;
+
+    void respond (StreamingSocket& client)
+    {
+        // only the request line matters, the rest of the head is skipped.
+        char buffer[2048];
+        int size = 0;
+        while (size < (int) sizeof (buffer) && client.waitUntilReady (true, 1000) == 1)
+        {
+            const int numRead = client.read (buffer + size, (int) sizeof (buffer) - size, false);
+            if (numRead <= 0)
+                break;
+            size += numRead;
+            if (String (buffer, (size_t) size).contains ("\r\n\r\n"))
+                break;
+        }
+
+        const auto request = StringArray::fromTokens (String (buffer, (size_t) size).upToFirstOccurrenceOf ("\r\n", false, false), true);
+        const auto path = request[1].upToFirstOccurrenceOf ("?", false, false);
+
+        String status = "200 OK", body;
+        if (request[0] != "GET")
+            status = "405 Method Not Allowed";
+        else if (path != "/metrics" && path != "/")
+            status = "404 Not Found";
+        else
+        {
+            const ScopedLock sl (lock);
+            body = text;
+        }
+
+        String head;
+        head << "HTTP/1.0 " << status << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+             << "Content-Length: " << (int) body.getNumBytesAsUTF8() << "\r\n"
+             << "Connection: close\r\n\r\n";
+        const auto response = head + body;
+        client.write (response.toRawUTF8(), (int) response.getNumBytesAsUTF8());
+    }
+};
+
+//==============================================================================
+class MetricsService::Poller : public Timer
+{
+public:
+    Poller (MetricsService& s) : owner (s) {}
+    void timerCallback() override { owner.server->setText (format (capture (owner.context()))); }
+
+private:
+    MetricsService& owner;
+};
+
+//==============================================================================
+MetricsService::MetricsService()
+{
+    server = std::make_unique<Server>();
+    poller = std::make_unique<Poller> (*this);
+}
+
+MetricsService::~MetricsService()
+{
+    poller.reset();
+    server.reset();
+}
+
+MetricsService::Snapshot MetricsService::capture (Context& context)
+{
+    Snapshot s;
+    if (auto engine = context.audio())
+    {
+        s.telemetry = engine->getTelemetry();
+        s.midiInPending = engine->getNumMidiInputsPending();
+    }
+
+    auto& midi = context.midi();
+    s.midiIn = midi.getNumMessagesIn();
+    s.midiOut = midi.getNumMessagesOut();
+    s.midiOutPending = midi.getNumOutputsPending();
+    s.residentBytes = detail::getResidentBytes();
+    s.pluginCrashes = getNumBridgedPluginCrashes();
+
+    if (auto session = context.session())
+    {
+        const auto graph = session->getActiveGraph();
+        s.graph = graph.getName();
+        if (auto* object = dynamic_cast<GraphNode*> (graph.getObject()))
+        {
+            s.graphNodes = object->getNumNodes();
+            s.renderOps = object->getNumRenderOps();
+            s.scratchBytes = (int64) object->getScratchInfo().getTotalBytes();
+        }
+        s.sessionBytes = MemoryReport::capture (*session).getTotalBytes();
+    }
+
+    return s;
+}
+
+String MetricsService::format (const Snapshot& s)
+{
+    using detail::addMetric;
+    const auto& t = s.telemetry;
+
+    String text;
+    addMetric (text, "element_dsp_load", "gauge", "Smoothed share of each audio block spent rendering.", t.load);
+    addMetric (text, "element_dsp_peak_load", "gauge", "Highest DSP load since telemetry was reset.", t.peakLoad);
+    addMetric (text, "element_audio_callbacks_total", "counter", "Audio callbacks rendered.", t.numCallbacks);
+    addMetric (text, "element_deadline_misses_total", "counter", "Callbacks that took longer than their block.", t.deadlineMisses);
+    addMetric (text, "element_late_callbacks_total", "counter", "Callbacks that started well past their period.", t.lateCallbacks);
+    if (t.xruns >= 0)
+        addMetric (text, "element_xruns_total", "counter", "Xruns reported by the audio device.", t.xruns);
+    addMetric (text, "element_callback_jitter_ms", "gauge", "RMS deviation of the callback period from the block duration.", t.jitterMs);
+    addMetric (text, "element_signal_faults_total", "counter", "Node output blocks with NaN or infinite samples.", t.signalFaults);
+
+    addMetric (text, "element_midi_in_messages_total", "counter", "MIDI messages received from input devices.", s.midiIn);
+    addMetric (text, "element_midi_out_messages_total", "counter", "MIDI messages sent to the default output.", s.midiOut);
+    addMetric (text, "element_midi_in_pending", "gauge", "MIDI input messages waiting for the audio thread.", s.midiInPending);
+    addMetric (text, "element_midi_out_pending", "gauge", "MIDI messages waiting to be sent.", s.midiOutPending);
+
+    if (s.residentBytes >= 0)
+        addMetric (text, "element_resident_memory_bytes", "gauge", "Resident memory of the process.", s.residentBytes);
+
+    addMetric (text, "element_active_graph_info", "gauge", "The active graph, always 1.", 1, "name=\"" + detail::escapeLabel (s.graph) + "\"");
+    addMetric (text, "element_graph_nodes", "gauge", "Nodes in the active graph.", s.graphNodes);
+    addMetric (text, "element_graph_render_ops", "gauge", "Rendering ops in the active graph's sequence.", s.renderOps);
+    addMetric (text, "element_graph_scratch_bytes", "gauge", "Scratch buffer and delay line memory of the active graph.", s.scratchBytes);
+    addMetric (text, "element_session_memory_bytes", "gauge", "Memory held by the session's graphs, not counting plugins.", s.sessionBytes);
+
+    addMetric (text, "element_plugin_crashes_total", "counter", "Bridged plugin processes that quit unexpectedly.", s.pluginCrashes);
+    return text;
+}
+
+void MetricsService::refreshWithSettings()
+{
+    const auto port = settings().getMetricsPort();
+    if (port == server->getPort())
+        return;
+
+    poller->stopTimer();
+    server->stop();
+    if (port <= 0)
+        return;
+
+    server->setText (format (capture (context())));
+    if (! server->start (port))
+    {
+        Logger::writeToLog ("[element] couldn't serve metrics on port " + String (port));
+        return;
+    }
+
+    poller->startTimer (1000);
+    Logger::writeToLog ("[element] serving metrics at http://127.0.0.1:" + String (port) + "/metrics");
+}
+
+int MetricsService::getPort() const noexcept { return server->getPort(); }
+
+void MetricsService::activate() { refreshWithSettings(); }
+
+void MetricsService::deactivate()
+{
+    poller->stopTimer();
+    server->stop();
+}
+
+} // namespace element
@@ -0,0 +1,69 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/audioengine.hpp>
+#include <element/services.hpp>
+
+namespace element {
+
+/** Serves engine metrics in the Prometheus text format, so machines
+    running unattended can be watched without a UI.
+
+    Metrics are answered at http://127.0.0.1:<port>/metrics on the port
+    from Settings::getMetricsPort(). Only the local machine can connect,
+    put a proxy or the monitoring agent on the same box. Values are taken
+    on the message thread once a second and served from that snapshot.
+ */
+class MetricsService : public Service
+{
+public:
+    MetricsService();
+    ~MetricsService();
+
+    /** One set of values. */
+    struct Snapshot
+    {
+        AudioEngine::Telemetry telemetry;
+        juce::int64 midiIn = 0, midiOut = 0;
+        int midiInPending = 0, midiOutPending = 0;
+
+        /** Resident memory of the process, -1 where it isn't known. */
+        juce::int64 residentBytes = -1;
+
+        juce::String graph;
+        int graphNodes = 0;
+        int renderOps = 0;
+        juce::int64 scratchBytes = 0;
+
+        /** Memory held by the session's graphs and shared sample cache. */
+        juce::int64 sessionBytes = 0;
+
+        juce::int64 pluginCrashes = 0;
+    };
+
+    /** Takes the current values. Message thread. */
+    static Snapshot capture (Context& context);
+
+    /** Formats a snapshot as Prometheus text. */
+    static juce::String format (const Snapshot& snapshot);
+
+    /** Starts, stops or moves the server to match Settings. */
+    void refreshWithSettings();
+
+    /** Returns the port being served, zero if none. */
+    int getPort() const noexcept;
+
+    void activate() override;
+    void deactivate() override;
+    bool isDeferred() const override { return true; }
+
+private:
+    class Server;
+    std::unique_ptr<Server> server;
+    class Poller;
+    std::unique_ptr<Poller> poller;
+};
+
+} // namespace element
@@ -5,14 +5,19 @@
 
 #include <element/ui/commands.hpp>
 
+#include <element/audioengine.hpp>
 #include <element/context.hpp>
 #include <element/devices.hpp>
+#include <element/node.hpp>
+#include <element/processor.hpp>
+#include <element/session.hpp>
 #include <element/settings.hpp>
 
 #include "services/oscservice.hpp"
 
 #define EL_OSC_ADDRESS_COMMAND "/element/command"
 #define EL_OSC_ADDRESS_ENGINE "/element/engine"
+#define EL_OSC_ADDRESS_PARAMS "/element/params"
 
 namespace element {
 
@@ -54,12 +59,44 @@ struct EngineOSCListener final : OSCReceiver::ListenerWithOSCAddress<>
         if (! slug.isString())
             return;
 
-        if (message.size() >= 2 && slug.getString().toLowerCase().trim() == "samplerate")
+        const auto name = slug.getString().toLowerCase().trim();
+        if (message.size() >= 2 && name == "samplerate")
             handleSampleRate (message[1]);
+        else if (message.size() >= 3 && name == "telemetry")
+            handleTelemetry (message[1], message[2]);
     }
 
 private:
     Context& globals;
+    OSCSender reply;
+
+    /** Sends /element/engine/telemetry to host:port with callbacks,
+        deadline misses, late callbacks, xruns, load, peak load, period
+        and jitter (ms), followed by the histogram bins.
+     */
+    void handleTelemetry (const OSCArgument& host, const OSCArgument& port)
+    {
+        if (! host.isString() || ! port.isInt32())
+            return;
+        auto engine = globals.audio();
+        if (engine == nullptr || ! reply.connect (host.getString(), port.getInt32()))
+            return;
+
+        const auto t = engine->getTelemetry();
+        OSCMessage msg (EL_OSC_ADDRESS_ENGINE "/telemetry");
+        msg.addInt32 ((int32) t.numCallbacks);
+        msg.addInt32 ((int32) t.deadlineMisses);
+        msg.addInt32 ((int32) t.lateCallbacks);
+        msg.addInt32 (t.xruns);
+        msg.addFloat32 ((float) t.load);
+        msg.addFloat32 ((float) t.peakLoad);
+        msg.addFloat32 ((float) t.periodMs);
+        msg.addFloat32 ((float) t.jitterMs);
+        for (auto count : t.histogram)
+            msg.addInt32 ((int32) count);
+        reply.send (msg);
+        reply.disconnect();
+    }
 
     void handleSampleRate (const OSCArgument& arg)
     {
@@ -90,6 +127,101 @@ private:
     }
 };
 
+//=============================================================================
+/** Sets node parameters straight from the OSC receive thread.
+
+    /element/params takes a node UUID followed by any number of parameter
+    index and value pairs, values normalized 0 to 1. Send several in a
+    bundle to reach several nodes in one packet. Nodes are found through
+    a table rebuilt on the message thread when the session changes, so
+    a write never waits on it.
+ */
+struct ParameterOSCListener final : OSCReceiver::ListenerWithOSCAddress<OSCReceiver::RealtimeCallback>,
+                                    private ChangeListener,
+                                    private AsyncUpdater
+{
+    ParameterOSCListener (Context& c)
+        : context (c)
+    {
+        session = context.session();
+        if (session != nullptr)
+            session->addChangeListener (this);
+        rebuild();
+    }
+
+    ~ParameterOSCListener()
+    {
+        cancelPendingUpdate();
+        if (session != nullptr)
+            session->removeChangeListener (this);
+    }
+
+    void oscMessageReceived (const OSCMessage& message) override
+    {
+        if (message.size() < 3 || ! message[0].isString())
+            return;
+
+        ProcessorPtr processor;
+        {
+            const ScopedLock sl (lock);
+            processor = processors[message[0].getString()];
+        }
+
+        if (processor == nullptr)
+        {
+            // new or not built yet, catch it next time round.
+            triggerAsyncUpdate();
+            return;
+        }
+
+        const auto& params = processor->getParameters();
+        for (int i = 1; i + 1 < message.size(); i += 2)
+        {
+            const auto& index = message[i];
+            const auto& value = message[i + 1];
+            if (! index.isInt32() || ! isPositiveAndBelow (index.getInt32(), params.size()))
+                continue;
+
+            float normalized = 0.f;
+            if (value.isFloat32())
+                normalized = value.getFloat32();
+            else if (value.isInt32())
+                normalized = (float) value.getInt32();
+            else
+                continue;
+
+            params.getUnchecked (index.getInt32())->setValueNotifyingHost (jlimit (0.f, 1.f, normalized));
+        }
+    }
+
+private:
+    Context& context;
+    SessionPtr session;
+    CriticalSection lock;
+    HashMap<String, ProcessorPtr> processors;
+
+    void rebuild()
+    {
+        HashMap<String, ProcessorPtr> found;
+        if (session != nullptr)
+        {
+            session->forEach ([&found] (const ValueTree& tree) {
+                if (! tree.hasType (types::Node))
+                    return;
+                const Node node (tree, false);
+                if (auto* object = node.getObject())
+                    found.set (node.getUuidString(), object);
+            });
+        }
+
+        const ScopedLock sl (lock);
+        processors.swapWith (found);
+    }
+
+    void changeListenerCallback (ChangeBroadcaster*) override { rebuild(); }
+    void handleAsyncUpdate() override { rebuild(); }
+};
+
 //=============================================================================
 class OSCService::Impl
 {
@@ -140,6 +272,9 @@ public:
         engine.reset (new EngineOSCListener (owner.context()));
         receiver.addListener (engine.get(), EL_OSC_ADDRESS_ENGINE);
 
+        params.reset (new ParameterOSCListener (owner.context()));
+        receiver.addListener (params.get(), EL_OSC_ADDRESS_PARAMS);
+
         listenersReady = true;
     }
 
@@ -151,9 +286,11 @@ public:
 
         receiver.removeListener (application.get());
         receiver.removeListener (engine.get());
+        receiver.removeListener (params.get());
 
         application.reset();
         engine.reset();
+        params.reset();
     }
 
     int getHostPort() const { return serverPort; }
@@ -169,6 +306,7 @@ private:
 
     std::unique_ptr<CommandOSCListener> application;
     std::unique_ptr<EngineOSCListener> engine;
+    std::unique_ptr<ParameterOSCListener> params;
 };
 
 //=============================================================================
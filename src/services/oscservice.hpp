@@ -21,6 +21,7 @@ public:
 
     void activate() override;
     void deactivate() override;
+    bool isDeferred() const override { return true; }
 
 private:
     class Impl;
@@ -8,25 +8,91 @@
 #include <element/context.hpp>
 
 #include "datapath.hpp"
+#include "filesystemwatcher.hpp"
 #include "services/presetservice.hpp"
 
 using juce::String;
 
 namespace element {
 
-struct PresetService::Impl
+struct PresetService::Impl : private FileSystemWatcher::Listener,
+                             private Timer
 {
-    Impl() {}
-    ~Impl() {}
+    Impl (PresetService& o) : owner (o) { watcher.addListener (this); }
+    ~Impl()
+    {
+        stopTimer();
+        watcher.removeListener (this);
+    }
+
+    void watch()
+    {
+        const auto folder = owner.context().presets().getPresetsFolder();
+        watcher.removeAllFolders();
+        if (! folder.isDirectory())
+            return;
+
+        // the watcher isn't recursive everywhere.
+        watcher.addFolder (folder);
+        for (const auto& entry : RangedDirectoryIterator (folder, true, "*", File::findDirectories))
+            watcher.addFolder (entry.getFile());
+    }
 
-    void refresh()
+    void unwatch()
     {
+        stopTimer();
+        watcher.removeAllFolders();
+    }
+
+    /** Indexes presets off the message thread, for startup. */
+    void refreshInBackground()
+    {
+        auto& presets = owner.context().presets();
+        pool.addJob ([&presets]() { presets.refresh(); });
+    }
+
+private:
+    PresetService& owner;
+    FileSystemWatcher watcher;
+    ThreadPool pool { 1 };
+
+    Array<File> changed;
+
+    // saving a preset can touch a file several times, update once.
+    void fileChanged (const File& file, FileSystemWatcher::FileSystemEvent) override
+    {
+        changed.addIfNotAlreadyThere (file);
+        startTimer (500);
+    }
+
+    void timerCallback() override
+    {
+        stopTimer();
+        Array<File> files;
+        files.swapWith (changed);
+
+        // a folder coming or going can hold any number of presets, and
+        // not every watcher sees into sub folders, so those list again.
+        const auto watched = watcher.getWatchedFolders();
+        const bool folders = std::any_of (files.begin(), files.end(), [&watched] (const File& f) {
+            return f.isDirectory() || watched.contains (f);
+        });
+
+        if (folders)
+        {
+            owner.refresh();
+            watch();
+        }
+        else
+        {
+            owner.context().presets().refreshFiles (files);
+        }
     }
 };
 
 PresetService::PresetService()
 {
-    impl.reset (new Impl());
+    impl.reset (new Impl (*this));
 }
 
 PresetService::~PresetService()
@@ -36,10 +102,13 @@ PresetService::~PresetService()
 
 void PresetService::activate()
 {
+    impl->refreshInBackground();
+    impl->watch();
 }
 
 void PresetService::deactivate()
 {
+    impl->unwatch();
 }
 
 void PresetService::refresh()
@@ -63,7 +132,7 @@ void PresetService::add (const Node& node, const String& presetName)
     }
 
     if (auto* ui = sibling<UI>())
-        ui->stabilizeContent();
+        ui->stabilizeContentLater();
 }
 
 } // namespace element
@@ -16,6 +16,7 @@ public:
     ~PresetService();
     void activate() override;
     void deactivate() override;
+    bool isDeferred() const override { return true; }
 
     void refresh();
     void add (const Node& Node, const juce::String& presetName = juce::String());
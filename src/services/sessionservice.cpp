@@ -1,6 +1,9 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <map>
+#include <string_view>
+
 #include <element/graph.hpp>
 #include <element/node.hpp>
 #include <element/context.hpp>
@@ -14,9 +17,34 @@
 #include "services/mappingservice.hpp"
 #include "services/presetservice.hpp"
 #include "services/sessionservice.hpp"
+#include "session/sessionfile.hpp"
+#include "session/sessionjournal.hpp"
+#include "session/sessionprofile.hpp"
+#include "session/sharedplugin.hpp"
+#include "ui/sessionimportwizard.hpp"
 
 namespace element {
 
+namespace {
+// an imported graph is a new copy, so its nodes get their own identities.
+void renewUuids (Node& graph)
+{
+    graph.forEach ([] (const ValueTree& tree) {
+        if (! tree.hasType (types::Node))
+            return;
+        auto ref = tree;
+        ref.setProperty (tags::uuid, Uuid().toString(), nullptr);
+    });
+}
+
+void logProfile()
+{
+    if (auto profile = SessionProfile::getLast())
+        Logger::writeToLog ("[element] " + profile->getOperation() + " " + profile->getFile().getFileName()
+                            + " took " + String (profile->getSeconds() * 1000.0, 1) + " ms");
+}
+} // namespace
+
 class SessionService::ChangeResetter : public AsyncUpdater
 {
 public:
@@ -33,6 +61,163 @@ private:
     SessionService& owner;
 };
 
+//==============================================================================
+/** Journals the session in the background while it's being played.
+
+    Each tick only captures the nodes whose state changed since the last
+    one and appends them to the journal. A change to the model itself
+    writes a new snapshot instead. Capturing state stays on the message
+    thread since plugin formats expect it there, encoding and writing
+    happen on a worker so the tick costs no more than the capture.
+ */
+class SessionService::Autosave : private Timer,
+                                 private ValueTree::Listener
+{
+public:
+    explicit Autosave (SessionService& s) : owner (s) {}
+
+    ~Autosave() override
+    {
+        stopTimer();
+        model.removeListener (this);
+        pool.removeAllJobs (false, 10000);
+    }
+
+    /** Returns the journal kept for a session file. Untitled sessions
+        share one in the application data.
+     */
+    static File journalFileFor (const File& sessionFile)
+    {
+        if (sessionFile.hasFileExtension ("els"))
+            return sessionFile.getSiblingFile ("." + sessionFile.getFileName() + ".autosave");
+        return DataPath::applicationDataDir().getChildFile ("Untitled.autosave");
+    }
+
+    void setInterval (int minutes)
+    {
+        if (minutes > 0)
+            startTimer (minutes * 60 * 1000);
+        else
+            stopTimer();
+    }
+
+    /** Treat the session as it is now as already saved. Pass true when
+        the session file matches, so the journal isn't needed.
+     */
+    void reset (const File& sessionFile, bool clearJournal)
+    {
+        model.removeListener (this);
+        model = owner.currentSession != nullptr ? owner.currentSession->data() : ValueTree();
+        model.addListener (this);
+
+        // a journal left for another session was saved or discarded by now.
+        auto newJournal = std::make_shared<SessionJournal> (journalFileFor (sessionFile));
+        if (journal != nullptr && journal->getFile() != newJournal->getFile())
+            pool.addJob ([j = journal]() { j->clear(); });
+        if (clearJournal || journal == nullptr || journal->getFile() != newJournal->getFile())
+        {
+            pool.addJob ([j = newJournal]() { j->clear(); });
+            journal = newJournal;
+        }
+
+        stamps.clear();
+        ValueTree unused;
+        capture (unused, true);
+        structureChanged = false;
+        needsSnapshot = true;
+    }
+
+private:
+    SessionService& owner;
+    ThreadPool pool { 1 };
+    std::shared_ptr<SessionJournal> journal;
+    ValueTree model;
+    std::map<String, int64> stamps;
+    bool structureChanged = false;
+    bool needsSnapshot = true;
+    std::atomic<int> pending { 0 };
+
+    /** Adds nodes whose state changed to the delta. */
+    void capture (ValueTree& delta, bool baselineOnly)
+    {
+        if (owner.currentSession == nullptr)
+            return;
+
+        owner.currentSession->forEach ([&] (const ValueTree& data) {
+            if (! data.hasType (types::Node))
+                return;
+
+            const Node node (data, false);
+            ProcessorPtr obj = node.getObject();
+            if (obj == nullptr || node.isGraph())
+                return;
+
+            // plugins say when they change. Internal nodes are cheap to
+            // ask, so their state is compared instead.
+            MemoryBlock state, programState;
+            int64 stamp = 0;
+            if (auto* proc = obj->getAudioProcessor())
+            {
+                stamp = (int64) obj->getStateVersion();
+                if (! baselineOnly && stamps[node.getUuidString()] != stamp)
+                {
+                    proc->getStateInformation (state);
+                    proc->getCurrentProgramStateInformation (programState);
+                }
+            }
+            else
+            {
+                obj->getState (state);
+                stamp = (int64) std::hash<std::string_view>() (std::string_view ((const char*) state.getData(), state.getSize()));
+            }
+
+            auto& last = stamps[node.getUuidString()];
+            if (last == stamp)
+                return;
+            last = stamp;
+            if (! baselineOnly)
+                SessionJournal::addNodeState (delta, node.getUuidString(), std::move (state), std::move (programState));
+        });
+    }
+
+    void timerCallback() override
+    {
+        // a slow disk shouldn't pile up snapshots.
+        if (journal == nullptr || pending.load() > 0 || ! model.isValid())
+            return;
+
+        auto delta = SessionJournal::createDelta();
+        capture (delta, false);
+
+        const bool snapshot = needsSnapshot || structureChanged;
+        if (! snapshot && delta.getNumChildren() == 0)
+            return;
+
+        ValueTree copy;
+        if (snapshot)
+        {
+            copy = model.createCopy();
+            Node::sanitizeProperties (copy, true);
+            needsSnapshot = structureChanged = false;
+        }
+
+        ++pending;
+        pool.addJob ([this, j = journal, delta, copy]() {
+            if (delta.getNumChildren() > 0)
+                j->append (delta);
+            if (copy.isValid())
+                j->rebase (copy);
+            --pending;
+        });
+    }
+
+    void valueTreePropertyChanged (ValueTree&, const Identifier&) override { structureChanged = true; }
+    void valueTreeChildAdded (ValueTree&, ValueTree&) override { structureChanged = true; }
+    void valueTreeChildRemoved (ValueTree&, ValueTree&, int) override { structureChanged = true; }
+    void valueTreeChildOrderChanged (ValueTree&, int, int) override { structureChanged = true; }
+};
+
+//==============================================================================
 SessionService::SessionService() {}
 SessionService::~SessionService() {}
 
@@ -42,6 +227,8 @@ void SessionService::activate()
     document.reset (new SessionDocument (currentSession));
     changeResetter.reset (new ChangeResetter (*this));
     document->setFile (DataPath::defaultSessionDir());
+    autosave.reset (new Autosave (*this));
+    autosave->setInterval (context().settings().getAutosaveInterval());
 }
 
 void SessionService::deactivate()
@@ -59,6 +246,7 @@ void SessionService::deactivate()
 
     changeResetter->cancelPendingUpdate();
     changeResetter.reset (nullptr);
+    autosave.reset (nullptr);
 
     currentSession->clear();
     currentSession = nullptr;
@@ -69,10 +257,13 @@ void SessionService::openDefaultSession()
     if (auto* gc = sibling<GuiService>())
         gc->closeAllPluginWindows();
 
+    recoverAutosave ({});
     loadNewSessionData();
     refreshOtherControllers();
-    sibling<GuiService>()->stabilizeContent();
+    if (auto* gc = sibling<GuiService>())
+        gc->stabilizeContent();
     resetChanges (true);
+    autosave->reset ({}, true);
 }
 
 void SessionService::openFile (const File& file)
@@ -94,12 +285,7 @@ void SessionService::openFile (const File& file)
             if (data.isValid() && error.isEmpty())
             {
                 Node node (data, true);
-                node.forEach ([] (const ValueTree& tree) {
-                    if (! tree.hasType (types::Node))
-                        return;
-                    auto ref = tree;
-                    ref.setProperty (tags::uuid, Uuid().toString(), nullptr);
-                });
+                renewUuids (node);
 
                 if (auto* ec = sibling<EngineService>())
                     ec->addGraph (node, false);
@@ -111,32 +297,39 @@ void SessionService::openFile (const File& file)
         }
 
         if (error.isNotEmpty())
-        {
-            AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, "Invalid graph", error);
-        }
+            reportError ("Invalid graph", error);
     }
     else if (file.hasFileExtension ("els"))
     {
         document->saveIfNeededAndUserAgrees();
-        Session::ScopedFrozenLock freeze (*currentSession);
-        Result result = document->loadFrom (file, true);
-
-        if (result.wasOk())
         {
-            auto& gui = *sibling<GuiService>();
-            gui.closeAllPluginWindows();
-            refreshOtherControllers();
+            SessionProfile::Operation profile ("load", file);
+            Session::ScopedFrozenLock freeze (*currentSession);
+            SharedPlugin::beginRestore();
+            Result result = document->loadFrom (file, true);
 
-            if (auto* cc = gui.content())
+            if (result.wasOk())
             {
-                auto ui = currentSession->data().getOrCreateChildWithName (tags::ui, nullptr);
-                cc->applySessionState (ui.getProperty ("content").toString());
+                auto* gui = sibling<GuiService>();
+                if (gui != nullptr)
+                    gui->closeAllPluginWindows();
+                refreshOtherControllers();
+
+                if (auto* cc = gui != nullptr ? gui->content() : nullptr)
+                {
+                    auto ui = currentSession->data().getOrCreateChildWithName (tags::ui, nullptr);
+                    cc->applySessionState (ui.getProperty ("content").toString());
+                }
+
+                if (gui != nullptr)
+                    gui->stabilizeContent();
+                resetChanges();
+                recoverAutosave (file);
+                autosave->reset (file, true);
             }
-
-            sibling<GuiService>()->stabilizeContent();
-            resetChanges();
         }
 
+        logProfile();
         jassert (! hasSessionChanged());
     }
     else
@@ -152,6 +345,81 @@ void SessionService::openFile (const File& file)
     }
 }
 
+void SessionService::cueFile (const File& file)
+{
+    auto* ec = sibling<EngineService>();
+    if (ec == nullptr)
+        return;
+
+    String error;
+    ValueTree data;
+    {
+        SessionProfile::Operation profile ("cue", file);
+        data = SessionDocument::readSession (file, error);
+        // the cued session's state replaces that of plugins it shares.
+        SharedPlugin::beginRestore();
+        if (error.isEmpty() && ! ec->cueSession (data))
+            error = "Could not cue session data";
+    }
+
+    if (error.isNotEmpty())
+    {
+        reportError ("Invalid session", error);
+        return;
+    }
+
+    logProfile();
+    cuedData = data;
+    cuedFile = file;
+}
+
+void SessionService::switchToCuedSession()
+{
+    auto* ec = sibling<EngineService>();
+    if (ec == nullptr || ! ec->hasCuedSession() || ! cuedData.isValid())
+        return;
+    if (document->saveIfNeededAndUserAgrees() == FileBasedDocument::userCancelledSave)
+        return;
+
+    auto* gui = sibling<GuiService>();
+    if (gui != nullptr)
+        gui->closeAllPluginWindows();
+
+    {
+        // the engine already holds the cued graphs, so only the model moves
+        // over and the services catch up with it.
+        Session::ScopedFrozenLock freeze (*currentSession);
+        currentSession->loadData (cuedData);
+        ec->switchToCuedSession();
+        refreshSessionServices();
+
+        if (auto* cc = gui != nullptr ? gui->content() : nullptr)
+        {
+            auto ui = currentSession->data().getOrCreateChildWithName (tags::ui, nullptr);
+            cc->applySessionState (ui.getProperty ("content").toString());
+        }
+
+        document->setFile (cuedFile);
+        document->setChangedFlag (false);
+        autosave->reset (cuedFile, true);
+    }
+
+    cuedData = {};
+    cuedFile = File();
+
+    if (gui != nullptr)
+        gui->stabilizeContent();
+    changeResetter->triggerAsyncUpdate();
+}
+
+void SessionService::reportError (const String& title, const String& error)
+{
+    if (getRunMode() == RunMode::Headless)
+        Logger::writeToLog ("[element] " + error);
+    else
+        AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, title, error);
+}
+
 void SessionService::exportGraph (const Node& node, const File& targetFile)
 {
     if (! node.hasNodeType (types::Graph))
@@ -167,6 +435,27 @@ void SessionService::exportGraph (const Node& node, const File& targetFile)
 
 void SessionService::importGraph (const File& file)
 {
+    // graphs from a session are picked first. Only the model is read until
+    // then, plugin states stay in the file until the graph's nodes exist.
+    if (file.hasFileExtension ("els") && getRunMode() != RunMode::Headless)
+    {
+        auto* dialog = new SessionImportWizardDialog (importWizard, file);
+        dialog->onGraphChosen = [this] (const Node& chosen) {
+            String error;
+            auto data = chosen.data();
+            if (Model (data).version() != EL_GRAPH_VERSION)
+                data = Node::migrate (data, error);
+            if (! data.isValid() || error.isNotEmpty())
+                return;
+
+            Node graph (data, true);
+            renewUuids (graph);
+            if (auto* ec = sibling<EngineService>())
+                ec->addGraph (graph, false);
+        };
+        return;
+    }
+
     openFile (file);
 }
 
@@ -189,9 +478,9 @@ void SessionService::saveSession (const bool saveAs, const bool askForFile, cons
     jassert (document && currentSession);
     auto result = FileBasedDocument::userCancelledSave;
 
-    auto& gui = *sibling<GuiService>();
+    auto* gui = sibling<GuiService>();
 
-    if (auto* cc = gui.content())
+    if (auto* cc = gui != nullptr ? gui->content() : nullptr)
     {
         String state;
         cc->getSessionState (state);
@@ -200,31 +489,40 @@ void SessionService::saveSession (const bool saveAs, const bool askForFile, cons
     }
 
     sigWillSave();
+    document->setCompressionLevel (context().settings().getSessionCompression());
 
-    if (saveAs)
-    {
-        result = document->saveAsInteractive (true);
-    }
-    else
     {
-        result = document->save (askForFile, showError);
+        SessionProfile::Operation profile ("save", document->getFile());
+        if (saveAs)
+        {
+            result = document->saveAsInteractive (true);
+        }
+        else
+        {
+            result = document->save (askForFile, showError);
+        }
+        profile.getProfile().setFile (document->getFile());
     }
 
     if (result == FileBasedDocument::userCancelledSave)
         return;
 
+    logProfile();
+
     if (result == FileBasedDocument::savedOk)
     {
         // ensure change messages are flushed so the changed flag doesn't reset
         currentSession->dispatchPendingMessages();
         document->setChangedFlag (false);
         jassert (! hasSessionChanged());
+        autosave->reset (document->getFile(), true);
         if (auto* us = context().settings().getUserSettings())
             us->setValue (Settings::lastSessionKey, document->getFile().getFullPathName());
 
         if (saveAs)
         {
-            sibling<UI>()->recentFiles().addFile (document->getFile());
+            if (auto* ui = sibling<UI>())
+                ui->recentFiles().addFile (document->getFile());
             currentSession->data().setProperty (tags::name,
                                                 document->getFile().getFileNameWithoutExtension(),
                                                 nullptr);
@@ -251,25 +549,27 @@ void SessionService::newSession()
 
     if (res == 1 || res == 2)
     {
-        sibling<GuiService>()->closeAllPluginWindows();
+        if (auto* gc = sibling<GuiService>())
+            gc->closeAllPluginWindows();
         loadNewSessionData();
         refreshOtherControllers();
-        sibling<GuiService>()->stabilizeContent();
+        if (auto* gc = sibling<GuiService>())
+            gc->stabilizeContent();
         resetChanges (true);
+        autosave->reset ({}, true);
     }
 }
 
 void SessionService::loadNewSessionData()
 {
     currentSession->clear();
+    SharedPlugin::beginRestore();
     const auto file = context().settings().getDefaultNewSessionFile();
     bool wasLoaded = false;
 
     if (file.existsAsFile())
     {
-        ValueTree data;
-        if (auto xml = XmlDocument::parse (file))
-            data = ValueTree::fromXml (*xml);
+        ValueTree data (Session::readFromFile (file));
         if (data.isValid() && data.hasType (types::Session) && EL_SESSION_VERSION == (int) data.getProperty (tags::version))
             wasLoaded = currentSession->loadData (data);
     }
@@ -287,9 +587,46 @@ void SessionService::loadNewSessionData()
     }
 }
 
+void SessionService::recoverAutosave (const File& sessionFile)
+{
+    // a journal newer than its session holds changes that were never saved.
+    const auto journalFile = Autosave::journalFileFor (sessionFile);
+    if (! journalFile.existsAsFile())
+        return;
+    if (sessionFile.existsAsFile() && journalFile.getLastModificationTime() <= sessionFile.getLastModificationTime())
+        return;
+
+    const auto data = SessionJournal::replay (journalFile);
+    if (! data.isValid())
+        return;
+
+    const bool hasFile = sessionFile.existsAsFile();
+    const auto name = (hasFile ? sessionFile.getFileNameWithoutExtension() : String ("Untitled")) + " (Recovered).els";
+    const auto target = (hasFile ? sessionFile.getParentDirectory() : DataPath::defaultSessionDir())
+                            .getChildFile (name)
+                            .getNonexistentSibling();
+
+    bool wasWritten = false;
+    if (auto out = target.createOutputStream())
+        wasWritten = SessionFile::write (data, *out);
+    if (! wasWritten)
+        return;
+
+    const auto message = "Changes that weren't saved last time were recovered to " + target.getFullPathName();
+    if (getRunMode() == RunMode::Headless)
+        Logger::writeToLog ("[element] " + message);
+    else
+        AlertWindow::showMessageBoxAsync (AlertWindow::InfoIcon, "Session Recovered", message);
+}
+
 void SessionService::refreshOtherControllers()
 {
     sibling<EngineService>()->sessionReloaded();
+    refreshSessionServices();
+}
+
+void SessionService::refreshSessionServices()
+{
     sibling<DeviceService>()->refresh();
     sibling<MappingService>()->learn (false);
     sibling<PresetService>()->refresh();
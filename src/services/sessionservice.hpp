@@ -31,6 +31,19 @@ public:
 
     void resetChanges (const bool clearDocumentFile = false);
 
+    /** Load a session file behind the current one. Its graphs are built and
+        prepared while the current session plays, so switchToCuedSession()
+        changes shows without waiting on plugins. Replaces a file already
+        cued.
+     */
+    void cueFile (const File& file);
+
+    /** Returns the session file cued, or nothing. */
+    const File& getCuedFile() const noexcept { return cuedFile; }
+
+    /** Make the cued session the current one, crossfading to it. */
+    void switchToCuedSession();
+
     void exportGraph (const Node& node, const File& targetFile);
     void importGraph (const File& file);
 
@@ -42,9 +55,17 @@ private:
     std::unique_ptr<SessionDocument> document;
     class ChangeResetter;
     std::unique_ptr<ChangeResetter> changeResetter;
+    class Autosave;
+    std::unique_ptr<Autosave> autosave;
+    std::unique_ptr<Component> importWizard;
+    ValueTree cuedData;
+    File cuedFile;
 
     void loadNewSessionData();
+    void recoverAutosave (const File& sessionFile);
     void refreshOtherControllers();
+    void refreshSessionServices();
+    void reportError (const String& title, const String& error);
 };
 
 } // namespace element
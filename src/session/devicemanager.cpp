@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL3-or-later
 
 #include <element/devices.hpp>
+#include "engine/aggregate.hpp"
 #include "engine/jack.hpp"
 
 namespace element {
@@ -23,6 +24,9 @@ public:
 #endif
 
     juce::ReferenceCountedArray<DeviceManager::LevelMeter> levelsIn, levelsOut;
+
+    AggregateDeviceType* aggregate = nullptr; // owned by the device manager
+    StringArray aggregateMembers;
 };
 
 DeviceManager::DeviceManager()
@@ -58,6 +62,9 @@ void DeviceManager::attach (AudioEnginePtr engine)
     }
 
     impl->engine = engine;
+#if EL_USE_JACK
+    impl->jack.setEngineCallback (engine != nullptr ? &engine->getAudioIODeviceCallback() : nullptr);
+#endif
 }
 
 static void addIfNotNull (OwnedArray<AudioIODeviceType>& list, AudioIODeviceType* const device)
@@ -86,6 +93,36 @@ void DeviceManager::createAudioDeviceTypes (OwnedArray<AudioIODeviceType>& list)
 
     addIfNotNull (list, AudioIODeviceType::createAudioIODeviceType_OpenSLES());
     addIfNotNull (list, AudioIODeviceType::createAudioIODeviceType_Android());
+
+    // interfaces aggregated by their plain driver, there's nothing to do
+    // this for where the OS already can.
+#if JUCE_ALSA
+    auto* members = AudioIODeviceType::createAudioIODeviceType_ALSA();
+#elif JUCE_WINDOWS
+    auto* members = AudioIODeviceType::createAudioIODeviceType_WASAPI (WASAPIDeviceMode::exclusive);
+#else
+    AudioIODeviceType* members = nullptr;
+#endif
+    if (members != nullptr)
+    {
+        impl->aggregate = new AggregateDeviceType (members);
+        impl->aggregate->setMembers (impl->aggregateMembers);
+        list.add (impl->aggregate);
+    }
+}
+
+void DeviceManager::setAggregateMembers (const StringArray& names)
+{
+    impl->aggregateMembers = names;
+    if (impl->aggregate == nullptr)
+        return;
+
+    impl->aggregate->setMembers (names);
+    if (getCurrentAudioDeviceType() == AggregateDeviceType::typeName)
+    {
+        closeAudioDevice();
+        restartLastAudioDevice();
+    }
 }
 
 void DeviceManager::getAudioDrivers (StringArray& drivers)
@@ -0,0 +1,100 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <element/node.hpp>
+#include <element/session.hpp>
+
+#include "engine/graphnode.hpp"
+#include "engine/samplecache.hpp"
+#include "session/memoryreport.hpp"
+
+namespace element {
+
+MemoryReport MemoryReport::capture (const Session& session)
+{
+    MemoryReport report;
+    for (int i = 0; i < session.getNumGraphs(); ++i)
+    {
+        const auto model = session.getGraph (i);
+        if (auto* graph = dynamic_cast<GraphNode*> (model.getObject()))
+            report.addGraph (*graph, model.getName());
+    }
+
+    report.setSharedBytes ((juce::int64) SampleCache::getShared()->getNumBytes());
+    return report;
+}
+
+void MemoryReport::addGraph (const GraphNode& graph, const juce::String& name, int depth)
+{
+    Item item;
+    item.name = name;
+    item.nodeId = graph.nodeId;
+    item.depth = depth;
+    item.graph = true;
+    item.bytes = graph.getMemoryUsage();
+    items.add (item);
+
+    for (int i = 0; i < graph.getNumNodes(); ++i)
+    {
+        auto* node = graph.getNode (i);
+        if (auto* sub = dynamic_cast<GraphNode*> (node))
+        {
+            addGraph (*sub, sub->getName(), depth + 1);
+            continue;
+        }
+
+        Item child;
+        child.name = node->getName();
+        child.nodeId = node->nodeId;
+        child.depth = depth + 1;
+        child.bytes = node->getMemoryUsage();
+        items.add (child);
+    }
+}
+
+juce::int64 MemoryReport::getGraphBytes() const noexcept
+{
+    juce::int64 total = 0;
+    for (const auto& item : items)
+        if (item.depth == 0)
+            total += item.bytes;
+    return total;
+}
+
+juce::String MemoryReport::toText() const
+{
+    auto size = [] (juce::int64 bytes) { return juce::File::descriptionOfSizeInBytes (bytes); };
+
+    juce::String text;
+    text << "Total: " << size (getTotalBytes()) << juce::newLine;
+    for (const auto& item : items)
+        text << juce::String::repeatedString ("  ", item.depth + 1) << item.name << ": " << size (item.bytes) << juce::newLine;
+    text << "  Shared sample cache: " << size (sharedBytes) << juce::newLine
+         << juce::newLine
+         << "Memory inside plugins isn't included.";
+    return text;
+}
+
+juce::var MemoryReport::toJSON() const
+{
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("total", getTotalBytes());
+    root->setProperty ("shared", sharedBytes);
+
+    juce::Array<juce::var> list;
+    for (const auto& item : items)
+    {
+        auto* obj = new juce::DynamicObject();
+        obj->setProperty ("name", item.name);
+        obj->setProperty ("node", (juce::int64) item.nodeId);
+        obj->setProperty ("depth", item.depth);
+        obj->setProperty ("graph", item.graph);
+        obj->setProperty ("bytes", item.bytes);
+        list.add (juce::var (obj));
+    }
+    root->setProperty ("items", list);
+
+    return juce::var (root);
+}
+
+} // namespace element
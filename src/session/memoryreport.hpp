@@ -0,0 +1,61 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+class GraphNode;
+class Session;
+
+/** Memory held by a session's running graphs, attributed to graphs and
+    their nodes, to plan what fits on a machine.
+
+    Counts scratch buffers, delay lines, oversampling buffers, Lua states
+    and file player FIFOs, see Processor::getMemoryUsage(). Decoded audio
+    is shared by every player in the process and reported once. Memory
+    inside hosted plugins can't be seen and isn't counted.
+ */
+class MemoryReport final
+{
+public:
+    struct Item
+    {
+        juce::String name;
+        juce::uint32 nodeId = 0;
+        int depth = 0; ///< zero for a session's graphs, one for their nodes and so on
+        bool graph = false;
+        juce::int64 bytes = 0; ///< a graph's bytes include its nodes
+    };
+
+    /** Walks the running graphs of a session. Message thread. */
+    static MemoryReport capture (const Session& session);
+
+    /** Adds a graph and its nodes, depth first. Message thread. */
+    void addGraph (const GraphNode& graph, const juce::String& name, int depth = 0);
+
+    const juce::Array<Item>& getItems() const noexcept { return items; }
+
+    /** Returns the bytes of the graphs added at depth zero. */
+    juce::int64 getGraphBytes() const noexcept;
+
+    /** Decoded audio shared between players. */
+    juce::int64 getSharedBytes() const noexcept { return sharedBytes; }
+    void setSharedBytes (juce::int64 numBytes) noexcept { sharedBytes = numBytes; }
+
+    juce::int64 getTotalBytes() const noexcept { return getGraphBytes() + sharedBytes; }
+
+    /** Returns the report as indented lines for display. */
+    juce::String toText() const;
+
+    /** Returns the report as an object with `total`, `shared` and `items`. */
+    juce::var toJSON() const;
+
+private:
+    juce::Array<Item> items;
+    juce::int64 sharedBytes = 0;
+};
+
+} // namespace element
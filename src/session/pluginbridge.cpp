@@ -0,0 +1,660 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <element/plugins.hpp>
+
+#include "session/pluginbridge.hpp"
+
+#if JUCE_LINUX
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace juce;
+
+namespace element {
+
+//==============================================================================
+struct PluginBridgeChannel::Header
+{
+    uint32 magic;
+    int32 numChannels;
+    int32 maxBlockSize;
+    int32 numSamples;
+    int32 outSamples;
+    int32 midiInSize;
+    int32 midiOutSize;
+    std::atomic<uint32> submitted;
+    std::atomic<uint32> completed;
+};
+
+namespace {
+constexpr uint32 channelMagic = 0x42424c45; // "ELBB"
+constexpr size_t headerBytes = 128;
+static_assert (std::atomic<uint32>::is_always_lock_free, "block counters are shared between processes");
+
+size_t audioBytes (int numChannels, int maxBlockSize)
+{
+    return sizeof (float) * (size_t) numChannels * (size_t) maxBlockSize;
+}
+
+size_t totalBytes (int numChannels, int maxBlockSize)
+{
+    return headerBytes + 2 * audioBytes (numChannels, maxBlockSize) + 2 * (size_t) PluginBridgeChannel::maxMidiBytes;
+}
+
+/* wake whoever sleeps on a block counter */
+void wake (std::atomic<uint32>& word) noexcept
+{
+#if JUCE_LINUX
+    syscall (SYS_futex, reinterpret_cast<uint32*> (&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    ignoreUnused (word);
+#endif
+}
+
+/* sleep on a block counter until the condition holds or time runs out.
+   Without futexes this yields, then naps once the wait gets long. */
+template <typename Condition>
+bool waitOn (std::atomic<uint32>& word, Condition&& condition, double timeoutMs) noexcept
+{
+    const auto start = Time::getMillisecondCounterHiRes();
+    for (int spin = 0; spin < 64; ++spin)
+        if (condition())
+            return true;
+
+    for (;;)
+    {
+        const auto value = word.load (std::memory_order_acquire);
+        if (condition())
+            return true;
+        const auto remaining = timeoutMs - (Time::getMillisecondCounterHiRes() - start);
+        if (remaining <= 0.0)
+            return false;
+#if JUCE_LINUX
+        const auto ns = (long) (remaining * 1000000.0);
+        timespec ts { ns / 1000000000L, ns % 1000000000L };
+        syscall (SYS_futex, reinterpret_cast<uint32*> (&word), FUTEX_WAIT, value, &ts, nullptr, 0);
+#else
+        ignoreUnused (value);
+        if (timeoutMs - remaining < 2.0)
+            Thread::yield();
+        else
+            Thread::sleep (1);
+#endif
+    }
+}
+
+/* events are packed as sample, size and bytes */
+int writeMidi (const MidiBuffer& midi, char* dest, int numSamples) noexcept
+{
+    int size = 0;
+    for (const auto m : midi)
+    {
+        if (m.samplePosition >= numSamples)
+            break;
+        const int needed = (int) (2 * sizeof (int32)) + m.numBytes;
+        if (size + needed > PluginBridgeChannel::maxMidiBytes)
+            break;
+        const int32 head[] = { (int32) m.samplePosition, (int32) m.numBytes };
+        std::memcpy (dest + size, head, sizeof (head));
+        std::memcpy (dest + size + sizeof (head), m.data, (size_t) m.numBytes);
+        size += needed;
+    }
+    return size;
+}
+
+void readMidi (const char* src, int size, MidiBuffer& midi, int numSamples) noexcept
+{
+    midi.clear();
+    int pos = 0;
+    size = jlimit (0, PluginBridgeChannel::maxMidiBytes, size);
+    while (pos + (int) (2 * sizeof (int32)) <= size)
+    {
+        int32 head[2];
+        std::memcpy (head, src + pos, sizeof (head));
+        pos += (int) sizeof (head);
+        if (head[1] <= 0 || pos + head[1] > size)
+            break;
+        midi.addEvent (src + pos, head[1], jlimit (0, jmax (0, numSamples - 1), (int) head[0]));
+        pos += head[1];
+    }
+}
+
+void copyIn (float* dest, const AudioBuffer<float>& audio, int numChannels, int maxBlockSize, int numSamples) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* d = dest + (size_t) ch * (size_t) maxBlockSize;
+        if (ch < audio.getNumChannels())
+            FloatVectorOperations::copy (d, audio.getReadPointer (ch), numSamples);
+        else
+            FloatVectorOperations::clear (d, numSamples);
+    }
+}
+
+void copyOut (AudioBuffer<float>& audio, const float* src, int numChannels, int maxBlockSize, int available, int numSamples) noexcept
+{
+    available = jlimit (0, numSamples, available);
+    for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+    {
+        auto* d = audio.getWritePointer (ch);
+        if (ch < numChannels && available > 0)
+            FloatVectorOperations::copy (d, src + (size_t) ch * (size_t) maxBlockSize, available);
+        if (available < numSamples)
+            FloatVectorOperations::clear (d + available, numSamples - available);
+    }
+}
+} // namespace
+
+bool PluginBridgeChannel::create (const File& file, int numChannels, int maxBlockSize)
+{
+    close();
+    numChannels = jlimit (1, maxChannels, numChannels);
+    maxBlockSize = jmax (1, maxBlockSize);
+
+    static_assert (sizeof (Header) <= headerBytes, "header outgrew its space");
+    MemoryBlock data (totalBytes (numChannels, maxBlockSize), true);
+    auto* h = new (data.getData()) Header();
+    h->magic = channelMagic;
+    h->numChannels = numChannels;
+    h->maxBlockSize = maxBlockSize;
+
+    return file.replaceWithData (data.getData(), data.getSize()) && map (file);
+}
+
+bool PluginBridgeChannel::open (const File& file)
+{
+    close();
+    if (! map (file) || header->magic != channelMagic)
+    {
+        close();
+        return false;
+    }
+
+    lastSeen = header->submitted.load (std::memory_order_acquire);
+    return true;
+}
+
+bool PluginBridgeChannel::map (const File& file)
+{
+    mapped = std::make_unique<MemoryMappedFile> (file, MemoryMappedFile::readWrite);
+    auto* data = static_cast<char*> (mapped->getData());
+    if (data == nullptr || mapped->getSize() < headerBytes)
+    {
+        close();
+        return false;
+    }
+
+    header = reinterpret_cast<Header*> (data);
+    const int numChannels = header->numChannels, maxBlockSize = header->maxBlockSize;
+    if (numChannels < 0 || numChannels > maxChannels || maxBlockSize < 0
+        || mapped->getSize() < totalBytes (numChannels, maxBlockSize))
+    {
+        close();
+        return false;
+    }
+
+    const auto audioSize = audioBytes (numChannels, maxBlockSize);
+    audioIn = reinterpret_cast<float*> (data + headerBytes);
+    audioOut = reinterpret_cast<float*> (data + headerBytes + audioSize);
+    midiIn = data + headerBytes + 2 * audioSize;
+    midiOut = midiIn + maxMidiBytes;
+    return true;
+}
+
+void PluginBridgeChannel::close()
+{
+    header = nullptr;
+    audioIn = audioOut = nullptr;
+    midiIn = midiOut = nullptr;
+    mapped.reset();
+}
+
+int PluginBridgeChannel::getNumChannels() const noexcept { return header != nullptr ? header->numChannels : 0; }
+int PluginBridgeChannel::getMaxBlockSize() const noexcept { return header != nullptr ? header->maxBlockSize : 0; }
+
+bool PluginBridgeChannel::waitUntilDone (double timeoutMs) const noexcept
+{
+    if (header == nullptr)
+        return false;
+    auto& completed = header->completed;
+    auto& submitted = header->submitted;
+    return waitOn (
+        completed, [&]() { return completed.load (std::memory_order_acquire) == submitted.load (std::memory_order_relaxed); }, timeoutMs);
+}
+
+void PluginBridgeChannel::exchange (AudioBuffer<float>& audio, MidiBuffer& midi) noexcept
+{
+    const int numChannels = header->numChannels, maxBlockSize = header->maxBlockSize;
+    const int numSamples = jmin (audio.getNumSamples(), maxBlockSize);
+
+    copyIn (audioIn, audio, numChannels, maxBlockSize, numSamples);
+    header->numSamples = numSamples;
+    header->midiInSize = writeMidi (midi, midiIn, numSamples);
+
+    copyOut (audio, audioOut, numChannels, maxBlockSize, header->outSamples, audio.getNumSamples());
+    readMidi (midiOut, header->midiOutSize, midi, numSamples);
+
+    header->submitted.fetch_add (1, std::memory_order_release);
+    wake (header->submitted);
+}
+
+bool PluginBridgeChannel::waitForBlock (double timeoutMs) const noexcept
+{
+    if (header == nullptr)
+        return false;
+    auto& submitted = header->submitted;
+    return waitOn (
+        submitted, [&]() { return submitted.load (std::memory_order_acquire) != lastSeen; }, timeoutMs);
+}
+
+int PluginBridgeChannel::read (AudioBuffer<float>& audio, MidiBuffer& midi) noexcept
+{
+    lastSeen = header->submitted.load (std::memory_order_acquire);
+    const int numSamples = jlimit (0, jmin (audio.getNumSamples(), header->maxBlockSize), header->numSamples);
+    copyOut (audio, audioIn, header->numChannels, header->maxBlockSize, numSamples, numSamples);
+    readMidi (midiIn, header->midiInSize, midi, numSamples);
+    return numSamples;
+}
+
+void PluginBridgeChannel::write (const AudioBuffer<float>& audio, int numSamples, const MidiBuffer& midi) noexcept
+{
+    numSamples = jlimit (0, header->maxBlockSize, numSamples);
+    copyIn (audioOut, audio, header->numChannels, header->maxBlockSize, numSamples);
+    header->outSamples = numSamples;
+    header->midiOutSize = writeMidi (midi, midiOut, numSamples);
+    header->completed.store (lastSeen, std::memory_order_release);
+    wake (header->completed);
+}
+
+//==============================================================================
+namespace {
+std::atomic<int64> numCrashes { 0 };
+
+/* requests go out as "type:arguments" and the worker answers each with
+   "ok:..." or "error:..." */
+class BridgeCoordinator final : public ChildProcessCoordinator
+{
+public:
+    ~BridgeCoordinator() override
+    {
+        closing.store (true);
+        killWorkerProcess();
+    }
+
+    String call (const String& message, int timeoutMs = 10000)
+    {
+        if (lost.load())
+            return "error:the plugin process has quit";
+
+        replied.reset();
+        {
+            ScopedLock sl (lock);
+            reply.clear();
+        }
+
+        if (! sendMessageToWorker (MemoryBlock (message.toRawUTF8(), message.getNumBytesAsUTF8())))
+            return "error:the plugin process is not connected";
+        if (! replied.wait (timeoutMs))
+            return "error:the plugin process did not respond";
+
+        ScopedLock sl (lock);
+        return reply.isNotEmpty() ? reply : String ("error:the plugin process has quit");
+    }
+
+    void handleMessageFromWorker (const MemoryBlock& mb) override
+    {
+        {
+            ScopedLock sl (lock);
+            reply = mb.toString();
+        }
+        replied.signal();
+    }
+
+    void handleConnectionLost() override
+    {
+        Logger::writeToLog ("[element] bridged plugin process quit");
+        if (! closing.load())
+            numCrashes.fetch_add (1, std::memory_order_relaxed);
+        lost.store (true);
+        replied.signal();
+    }
+
+    std::atomic<bool> lost { false };
+    std::atomic<bool> closing { false };
+
+private:
+    CriticalSection lock;
+    String reply;
+    WaitableEvent replied;
+};
+
+AudioProcessor::BusesProperties busesFor (const PluginDescription& desc)
+{
+    AudioProcessor::BusesProperties buses;
+    if (desc.numInputChannels > 0)
+        buses = buses.withInput ("Input", AudioChannelSet::canonicalChannelSet (desc.numInputChannels), true);
+    if (desc.numOutputChannels > 0)
+        buses = buses.withOutput ("Output", AudioChannelSet::canonicalChannelSet (desc.numOutputChannels), true);
+    return buses;
+}
+
+String argumentsOf (const String& reply) { return reply.fromFirstOccurrenceOf (":", false, false); }
+
+//==============================================================================
+class BridgedPlugin final : public AudioPluginInstance
+{
+public:
+    explicit BridgedPlugin (const PluginDescription& d)
+        : AudioPluginInstance (busesFor (d)), desc (d) {}
+
+    ~BridgedPlugin() override
+    {
+        ready.store (false);
+        coordinator.call ("quit", 1000);
+        channel.close();
+        shared.deleteFile();
+    }
+
+    bool launch (double sampleRate, int blockSize, String& error)
+    {
+        const auto exe = File::getSpecialLocation (File::currentExecutableFile);
+        if (! coordinator.launchWorkerProcess (exe, EL_PLUGIN_BRIDGE_PROCESS_ID, 20 * 1000, 0))
+        {
+            error = "Could not start a process for the plugin";
+            return false;
+        }
+
+        std::unique_ptr<XmlElement> xml (desc.createXml());
+        String message = "open:";
+        message << sampleRate << ":" << blockSize << ":"
+                << xml->toString (XmlElement::TextFormat().singleLine().withoutHeader());
+
+        // opening a plugin can take a while.
+        const auto reply = coordinator.call (message, 60 * 1000);
+        if (! reply.startsWith ("ok"))
+        {
+            error = argumentsOf (reply);
+            return false;
+        }
+
+        // ok:<accepts midi>:<produces midi>:<latency>
+        const auto args = StringArray::fromTokens (argumentsOf (reply), ":", "");
+        midiIn = args[0].getIntValue() != 0;
+        midiOut = args[1].getIntValue() != 0;
+        pluginLatency = args[2].getIntValue();
+        setLatencySamples (blockSize + pluginLatency);
+        return true;
+    }
+
+    const String getName() const override { return desc.name; }
+    void fillInPluginDescription (PluginDescription& d) const override { d = desc; }
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return midiIn; }
+    bool producesMidi() const override { return midiOut; }
+    bool hasEditor() const override { return false; }
+    AudioProcessorEditor* createEditor() override { return nullptr; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram (int) override {}
+    const String getProgramName (int) override { return {}; }
+    void changeProgramName (int, const String&) override {}
+
+    void prepareToPlay (double sampleRate, int blockSize) override
+    {
+        ready.store (false);
+        if (coordinator.lost.load())
+            return;
+
+        coordinator.call ("release");
+        channel.close();
+        shared.deleteFile();
+
+        shared = File::createTempFile (".elbridge");
+        const int numChannels = jmax (1, getTotalNumInputChannels(), getTotalNumOutputChannels());
+        if (! channel.create (shared, numChannels, blockSize))
+            return;
+
+        String message = "prepare:";
+        message << sampleRate << ":" << blockSize << ":" << shared.getFullPathName();
+        const auto reply = coordinator.call (message);
+        if (! reply.startsWith ("ok"))
+        {
+            Logger::writeToLog ("[element] bridge: " + argumentsOf (reply));
+            return;
+        }
+
+        pluginLatency = argumentsOf (reply).getIntValue();
+        setLatencySamples (blockSize + pluginLatency);
+        blockMs = 1000.0 * (double) blockSize / sampleRate;
+        ready.store (true);
+    }
+
+    void releaseResources() override
+    {
+        ready.store (false);
+        coordinator.call ("release");
+    }
+
+    void processBlock (AudioBuffer<float>& audio, MidiBuffer& midi) override
+    {
+        // the worker had the whole last block to finish, a late one is
+        // dropped rather than holding up the graph.
+        if (! ready.load() || coordinator.lost.load() || ! channel.waitUntilDone (blockMs * 0.25))
+        {
+            audio.clear();
+            midi.clear();
+            return;
+        }
+
+        channel.exchange (audio, midi);
+    }
+
+    void getStateInformation (MemoryBlock& block) override
+    {
+        const auto reply = coordinator.call ("getstate");
+        if (reply.startsWith ("ok"))
+            lastState.fromBase64Encoding (argumentsOf (reply));
+        // if the process went down, keep what the plugin had last.
+        block = lastState;
+    }
+
+    void setStateInformation (const void* data, int size) override
+    {
+        lastState = MemoryBlock (data, (size_t) size);
+        coordinator.call ("setstate:" + lastState.toBase64Encoding());
+    }
+
+private:
+    PluginDescription desc;
+    BridgeCoordinator coordinator;
+    PluginBridgeChannel channel;
+    File shared;
+    MemoryBlock lastState;
+    std::atomic<bool> ready { false };
+    bool midiIn = false, midiOut = false;
+    int pluginLatency = 0;
+    double blockMs = 10.0;
+};
+
+//==============================================================================
+class BridgeWorker final : public ChildProcessWorker,
+                           private Thread
+{
+public:
+    BridgeWorker() : Thread ("element: plugin bridge") {}
+    ~BridgeWorker() override { stop(); }
+
+    void handleMessageFromCoordinator (const MemoryBlock& mb) override
+    {
+        // plugins want the message thread.
+        const auto message = mb.toString();
+        MessageManager::callAsync ([this, message]() { handle (message); });
+    }
+
+    void handleConnectionLost() override
+    {
+        stop();
+        Process::terminate();
+    }
+
+private:
+    std::unique_ptr<PluginManager> plugins;
+    std::unique_ptr<AudioPluginInstance> plugin;
+    PluginBridgeChannel channel;
+    AudioBuffer<float> buffer;
+    MidiBuffer midi;
+
+    void answer (const String& text)
+    {
+        sendMessageToCoordinator (MemoryBlock (text.toRawUTF8(), text.getNumBytesAsUTF8()));
+    }
+
+    void stop()
+    {
+        stopThread (1000);
+        channel.close();
+    }
+
+    void handle (const String& message)
+    {
+        const auto type = message.upToFirstOccurrenceOf (":", false, false);
+        const auto args = message.fromFirstOccurrenceOf (":", false, false);
+
+        if (type == "open")
+            open (args);
+        else if (plugin == nullptr)
+            answer ("error:no plugin");
+        else if (type == "prepare")
+            prepare (args);
+        else if (type == "release")
+            release();
+        else if (type == "getstate")
+            getState();
+        else if (type == "setstate")
+            setState (args);
+        else if (type == "quit")
+            quit();
+        else
+            answer ("error:unknown request " + type);
+    }
+
+    void open (const String& args)
+    {
+        // <rate>:<block>:<description xml>
+        const auto rate = args.upToFirstOccurrenceOf (":", false, false).getDoubleValue();
+        const auto rest = args.fromFirstOccurrenceOf (":", false, false);
+        const auto block = rest.upToFirstOccurrenceOf (":", false, false).getIntValue();
+
+        PluginDescription desc;
+        auto xml = parseXML (rest.fromFirstOccurrenceOf (":", false, false));
+        if (xml == nullptr || ! desc.loadFromXml (*xml))
+            return answer ("error:invalid plugin description");
+
+        plugins = std::make_unique<PluginManager>();
+        plugins->addDefaultFormats();
+        plugins->setPlayConfig (rate, block);
+
+        String error;
+        plugin.reset (plugins->createAudioPlugin (desc, error));
+        if (plugin == nullptr)
+            return answer ("error:" + (error.isNotEmpty() ? error : String ("could not load the plugin")));
+
+        plugin->enableAllBuses();
+        String reply = "ok:";
+        reply << (plugin->acceptsMidi() ? 1 : 0) << ":" << (plugin->producesMidi() ? 1 : 0)
+              << ":" << plugin->getLatencySamples();
+        answer (reply);
+    }
+
+    void prepare (const String& args)
+    {
+        // <rate>:<block>:<shared file>
+        const auto tokens = StringArray::fromTokens (args, ":", "");
+        const auto rate = tokens[0].getDoubleValue();
+        const auto block = tokens[1].getIntValue();
+        const File file (args.fromFirstOccurrenceOf (":", false, false).fromFirstOccurrenceOf (":", false, false));
+
+        stop();
+        if (! channel.open (file))
+            return answer ("error:could not map " + file.getFullPathName());
+
+        plugin->setRateAndBufferSizeDetails (rate, block);
+        plugin->prepareToPlay (rate, block);
+        buffer.setSize (jmax (1, plugin->getTotalNumInputChannels(), plugin->getTotalNumOutputChannels()), block);
+        midi.ensureSize (PluginBridgeChannel::maxMidiBytes);
+
+        startThread (Thread::Priority::highest);
+        answer ("ok:" + String (plugin->getLatencySamples()));
+    }
+
+    void release()
+    {
+        stop();
+        plugin->releaseResources();
+        answer ("ok");
+    }
+
+    void getState()
+    {
+        MemoryBlock block;
+        plugin->getStateInformation (block);
+        answer ("ok:" + block.toBase64Encoding());
+    }
+
+    void setState (const String& args)
+    {
+        MemoryBlock block;
+        block.fromBase64Encoding (args);
+        plugin->setStateInformation (block.getData(), (int) block.getSize());
+        answer ("ok");
+    }
+
+    void quit()
+    {
+        stop();
+        plugin.reset();
+        answer ("ok");
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (! channel.waitForBlock (50.0))
+                continue;
+
+            const int numSamples = channel.read (buffer, midi);
+            AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+            {
+                const ScopedLock sl (plugin->getCallbackLock());
+                if (! plugin->isSuspended())
+                    plugin->processBlock (block, midi);
+                else
+                    block.clear();
+            }
+            channel.write (block, numSamples, midi);
+        }
+    }
+};
+} // namespace
+
+std::unique_ptr<AudioPluginInstance> createBridgedPlugin (const PluginDescription& desc,
+                                                          double sampleRate,
+                                                          int blockSize,
+                                                          String& error)
+{
+    auto plugin = std::make_unique<BridgedPlugin> (desc);
+    if (! plugin->launch (sampleRate, blockSize, error))
+        return nullptr;
+    return plugin;
+}
+
+ChildProcessWorker* createPluginBridgeWorker() { return new BridgeWorker(); }
+
+int64 getNumBridgedPluginCrashes() noexcept { return numCrashes.load (std::memory_order_relaxed); }
+
+} // namespace element
@@ -0,0 +1,97 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/audio_processors.hpp>
+#include <element/juce/core.hpp>
+
+namespace element {
+
+class PluginManager;
+
+/** Audio and MIDI exchanged with a bridged plugin through a shared,
+    memory mapped file.
+
+    The host copies a block in, picks up the output of the block before
+    and hands the new one over. The worker processes it while the host
+    carries on, so bridging costs exactly one block of latency. Waiting
+    sides sleep on the block counters, with futexes where the platform
+    has them.
+ */
+class PluginBridgeChannel final
+{
+public:
+    static constexpr int maxChannels = 64;
+    static constexpr int maxMidiBytes = 16384;
+
+    PluginBridgeChannel() = default;
+    ~PluginBridgeChannel() { close(); }
+
+    /** Creates the shared file and maps it. Host side. */
+    bool create (const juce::File& file, int numChannels, int maxBlockSize);
+
+    /** Maps a file made by create(). Worker side. */
+    bool open (const juce::File& file);
+
+    /** Unmaps the file. */
+    void close();
+
+    bool isOpen() const noexcept { return header != nullptr; }
+    int getNumChannels() const noexcept;
+    int getMaxBlockSize() const noexcept;
+
+    //==========================================================================
+    /** Returns true once the worker finished the last block handed over,
+        waiting at most the given time. Host side.
+     */
+    bool waitUntilDone (double timeoutMs) const noexcept;
+
+    /** Hands a block over and replaces it with the output of the block
+        before. Only call when waitUntilDone() returned true. Host side.
+     */
+    void exchange (juce::AudioBuffer<float>& audio, juce::MidiBuffer& midi) noexcept;
+
+    //==========================================================================
+    /** Waits for a block to be handed over. Worker side. */
+    bool waitForBlock (double timeoutMs) const noexcept;
+
+    /** Reads the block handed over, returning its size. Worker side. */
+    int read (juce::AudioBuffer<float>& audio, juce::MidiBuffer& midi) noexcept;
+
+    /** Publishes the processed block. Worker side. */
+    void write (const juce::AudioBuffer<float>& audio, int numSamples, const juce::MidiBuffer& midi) noexcept;
+
+private:
+    struct Header;
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    Header* header = nullptr;
+    float* audioIn = nullptr;
+    float* audioOut = nullptr;
+    char* midiIn = nullptr;
+    char* midiOut = nullptr;
+    juce::uint32 lastSeen = 0;
+
+    bool map (const juce::File& file);
+
+    JUCE_DECLARE_NON_COPYABLE (PluginBridgeChannel)
+};
+
+/** Creates a plugin hosted in its own process. A crash there silences
+    the plugin instead of taking the engine down. Editors and parameters
+    are not bridged, state is.
+ */
+std::unique_ptr<juce::AudioPluginInstance> createBridgedPlugin (const juce::PluginDescription& desc,
+                                                                double sampleRate,
+                                                                int blockSize,
+                                                                juce::String& error);
+
+/** Creates the worker run by a plugin bridge process. */
+juce::ChildProcessWorker* createPluginBridgeWorker();
+
+/** Returns how many bridged plugin processes quit without being asked to. */
+juce::int64 getNumBridgedPluginCrashes() noexcept;
+
+} // namespace element
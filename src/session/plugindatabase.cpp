@@ -0,0 +1,310 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <map>
+
+#include "session/plugindatabase.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace {
+constexpr uint32 magic = 0x44504c45; // "ELPD"
+constexpr uint32 version = 1;
+
+// magic, version, counts, section offsets
+constexpr size_t headerSize = 4 * (8 + PluginDatabase::numIndexes);
+
+// seven strings, two times, six ints
+constexpr size_t recordSize = 4 * 7 + 8 * 2 + 4 * 5;
+
+enum Flags : uint32
+{
+    isInstrumentFlag = 1 << 0,
+    hasSharedContainerFlag = 1 << 1
+};
+
+/* strings are stored once each, null terminated */
+class StringTable
+{
+public:
+    uint32 add (const String& text)
+    {
+        auto iter = refs.find (text);
+        if (iter != refs.end())
+            return iter->second;
+        const auto ref = (uint32) block.getDataSize();
+        block.append (text.toRawUTF8(), text.getNumBytesAsUTF8() + 1);
+        refs[text] = ref;
+        return ref;
+    }
+
+    const MemoryBlock& getData() const noexcept { return block; }
+
+private:
+    MemoryBlock block;
+    std::map<String, uint32> refs;
+};
+
+String keyFor (PluginDatabase::Index index, const PluginDescription& type)
+{
+    switch (index)
+    {
+        case PluginDatabase::byFormat:
+            return type.pluginFormatName;
+        case PluginDatabase::byManufacturer:
+            return type.manufacturerName;
+        case PluginDatabase::byCategory:
+            return type.category;
+        default:
+            break;
+    }
+    return {};
+}
+
+void writeInt (MemoryOutputStream& out, uint32 value) { out.writeInt ((int) value); }
+} // namespace
+
+bool PluginDatabase::write (const KnownPluginList& list, const File& file)
+{
+    const auto typesToWrite = list.getTypes();
+    const auto blacklisted = list.getBlacklistedFiles();
+    StringTable table;
+
+    MemoryOutputStream records;
+    for (const auto& t : typesToWrite)
+    {
+        for (const auto* s : { &t.name, &t.descriptiveName, &t.pluginFormatName, &t.category, &t.manufacturerName, &t.version, &t.fileOrIdentifier })
+            writeInt (records, table.add (*s));
+        records.writeInt64 (t.lastFileModTime.toMilliseconds());
+        records.writeInt64 (t.lastInfoUpdateTime.toMilliseconds());
+        records.writeInt (t.deprecatedUid);
+        records.writeInt (t.uniqueId);
+        records.writeInt (t.numInputChannels);
+        records.writeInt (t.numOutputChannels);
+        writeInt (records, (t.isInstrument ? isInstrumentFlag : 0u) | (t.hasSharedContainer ? hasSharedContainerFlag : 0u));
+    }
+
+    MemoryOutputStream blacklistOut;
+    for (const auto& f : blacklisted)
+        writeInt (blacklistOut, table.add (f));
+
+    // each index: key count, entry count, keys as (string, first, count),
+    // then the entries.
+    MemoryOutputStream indexOut[numIndexes];
+    for (int i = 0; i < numIndexes; ++i)
+    {
+        std::map<String, Array<int>> groups;
+        for (int t = 0; t < typesToWrite.size(); ++t)
+            groups[keyFor ((Index) i, typesToWrite.getReference (t)).toLowerCase()].add (t);
+
+        auto& out = indexOut[i];
+        writeInt (out, (uint32) groups.size());
+        writeInt (out, (uint32) typesToWrite.size());
+        uint32 first = 0;
+        for (const auto& g : groups)
+        {
+            writeInt (out, table.add (g.first));
+            writeInt (out, first);
+            writeInt (out, (uint32) g.second.size());
+            first += (uint32) g.second.size();
+        }
+        for (const auto& g : groups)
+            for (const auto t : g.second)
+                writeInt (out, (uint32) t);
+    }
+
+    const auto& stringData = table.getData();
+    uint32 offset = (uint32) headerSize;
+    const auto stringsAt = offset;
+    offset += (uint32) stringData.getDataSize();
+    const auto typesAt = offset;
+    offset += (uint32) records.getDataSize();
+    const auto blacklistAt = offset;
+    offset += (uint32) blacklistOut.getDataSize();
+
+    MemoryOutputStream out;
+    writeInt (out, magic);
+    writeInt (out, version);
+    writeInt (out, (uint32) typesToWrite.size());
+    writeInt (out, (uint32) blacklisted.size());
+    writeInt (out, stringsAt);
+    writeInt (out, (uint32) stringData.getDataSize());
+    writeInt (out, typesAt);
+    writeInt (out, blacklistAt);
+    for (auto& index : indexOut)
+    {
+        writeInt (out, offset);
+        offset += (uint32) index.getDataSize();
+    }
+
+    out << stringData;
+    out << records.getMemoryBlock();
+    out << blacklistOut.getMemoryBlock();
+    for (auto& index : indexOut)
+        out << index.getMemoryBlock();
+
+    // write beside and move over, a mapped reader keeps the old file.
+    TemporaryFile tmp (file);
+    return tmp.getFile().replaceWithData (out.getData(), out.getDataSize())
+           && tmp.overwriteTargetFileWithTemporary();
+}
+
+bool PluginDatabase::open (const File& file)
+{
+    close();
+
+    mapped = std::make_unique<MemoryMappedFile> (file, MemoryMappedFile::readOnly);
+    data = static_cast<const char*> (mapped->getData());
+    dataSize = mapped->getSize();
+
+    const auto valid = [this]() {
+        if (data == nullptr || dataSize < headerSize)
+            return false;
+        if (readInt (0) != magic || readInt (4) != version)
+            return false;
+
+        numTypes = readInt (8);
+        numBlacklisted = readInt (12);
+        strings = readInt (16);
+        stringsSize = readInt (20);
+        types = readInt (24);
+        blacklist = readInt (28);
+        for (int i = 0; i < numIndexes; ++i)
+            indexes[i] = readInt ((size_t) (32 + 4 * i));
+
+        if ((size_t) strings + stringsSize > dataSize || (stringsSize > 0 && data[strings + stringsSize - 1] != 0))
+            return false;
+        if ((size_t) types + (size_t) numTypes * recordSize > dataSize)
+            return false;
+        if ((size_t) blacklist + (size_t) numBlacklisted * 4 > dataSize)
+            return false;
+        for (const auto index : indexes)
+        {
+            if ((size_t) index + 8 > dataSize)
+                return false;
+            const size_t numKeys = readInt (index), numEntries = readInt (index + 4);
+            if (numEntries != numTypes || (size_t) index + 8 + numKeys * 12 + numEntries * 4 > dataSize)
+                return false;
+        }
+        return true;
+    }();
+
+    if (! valid)
+        close();
+    return valid;
+}
+
+void PluginDatabase::close()
+{
+    mapped.reset();
+    data = nullptr;
+    dataSize = 0;
+    numTypes = numBlacklisted = 0;
+}
+
+uint32 PluginDatabase::readInt (size_t offset) const noexcept
+{
+    return ByteOrder::littleEndianInt (data + offset);
+}
+
+String PluginDatabase::readString (uint32 ref) const
+{
+    return ref < stringsSize ? String::fromUTF8 (data + strings + ref) : String();
+}
+
+PluginDescription PluginDatabase::getType (int index) const
+{
+    PluginDescription t;
+    if (! isPositiveAndBelow (index, (int) numTypes))
+        return t;
+
+    size_t at = types + (size_t) index * recordSize;
+    const auto next = [this, &at]() { const auto v = readInt (at); at += 4; return v; };
+    const auto next64 = [this, &at]() { const auto v = (int64) ByteOrder::littleEndianInt64 (data + at); at += 8; return v; };
+
+    for (auto* s : { &t.name, &t.descriptiveName, &t.pluginFormatName, &t.category, &t.manufacturerName, &t.version, &t.fileOrIdentifier })
+        *s = readString (next());
+    t.lastFileModTime = Time (next64());
+    t.lastInfoUpdateTime = Time (next64());
+    t.deprecatedUid = (int) next();
+    t.uniqueId = (int) next();
+    t.numInputChannels = (int) next();
+    t.numOutputChannels = (int) next();
+    const auto flags = next();
+    t.isInstrument = (flags & isInstrumentFlag) != 0;
+    t.hasSharedContainer = (flags & hasSharedContainerFlag) != 0;
+    return t;
+}
+
+StringArray PluginDatabase::getBlacklistedFiles() const
+{
+    StringArray files;
+    files.ensureStorageAllocated ((int) numBlacklisted);
+    for (uint32 i = 0; i < numBlacklisted; ++i)
+        files.add (readString (readInt (blacklist + i * 4)));
+    return files;
+}
+
+StringArray PluginDatabase::getKeys (Index index) const
+{
+    StringArray keys;
+    if (! isOpen() || ! isPositiveAndBelow ((int) index, (int) numIndexes))
+        return keys;
+
+    const auto at = indexes[index];
+    for (uint32 k = 0; k < readInt (at); ++k)
+        keys.add (readString (readInt (at + 8 + k * 12)));
+    return keys;
+}
+
+Array<int> PluginDatabase::find (Index index, const String& key) const
+{
+    Array<int> found;
+    if (! isOpen() || ! isPositiveAndBelow ((int) index, (int) numIndexes))
+        return found;
+
+    const auto at = indexes[index];
+    const auto numKeys = readInt (at);
+    const auto entries = at + 8 + numKeys * 12;
+    const auto wanted = key.toLowerCase();
+
+    // keys were sorted as strings when written.
+    uint32 lo = 0, hi = numKeys;
+    while (lo < hi)
+    {
+        const auto mid = lo + (hi - lo) / 2;
+        const auto k = at + 8 + mid * 12;
+        const auto cmp = readString (readInt (k)).compare (wanted);
+        if (cmp < 0)
+        {
+            lo = mid + 1;
+        }
+        else if (cmp > 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            const auto first = readInt (k + 4), count = readInt (k + 8);
+            for (uint32 e = first; e < first + count && e < numTypes; ++e)
+                found.add ((int) readInt (entries + e * 4));
+            break;
+        }
+    }
+
+    return found;
+}
+
+void PluginDatabase::restore (KnownPluginList& list) const
+{
+    list.clear();
+    list.clearBlacklistedFiles();
+    for (int i = 0; i < size(); ++i)
+        list.addType (getType (i));
+    for (const auto& f : getBlacklistedFiles())
+        list.addToBlacklist (f);
+}
+
+} // namespace element
@@ -0,0 +1,77 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/audio_processors.hpp>
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** A read only, memory mapped database of known plugins.
+
+    The file holds fixed size records pointing into one table of strings,
+    followed by the blacklist and indexes by format, manufacturer and
+    category. Opening it maps the file and checks its header, nothing is
+    parsed until a record is read. Index keys are sorted, so a lookup is a
+    binary search over the mapped file.
+ */
+class PluginDatabase final
+{
+public:
+    /** Secondary indexes kept in the file. */
+    enum Index
+    {
+        byFormat = 0,
+        byManufacturer,
+        byCategory,
+        numIndexes
+    };
+
+    PluginDatabase() = default;
+
+    /** Writes a plugin list to a database file. */
+    static bool write (const juce::KnownPluginList& list, const juce::File& file);
+
+    /** Maps a database file. Returns false if it is missing or invalid. */
+    bool open (const juce::File& file);
+
+    /** Unmaps the file. */
+    void close();
+
+    /** Returns true if a database is open. */
+    bool isOpen() const noexcept { return data != nullptr; }
+
+    /** Returns the number of plugins in the database. */
+    int size() const noexcept { return (int) numTypes; }
+
+    /** Reads a plugin. */
+    juce::PluginDescription getType (int index) const;
+
+    /** Returns the blacklisted files and identifiers. */
+    juce::StringArray getBlacklistedFiles() const;
+
+    /** Returns the keys of an index, sorted. */
+    juce::StringArray getKeys (Index index) const;
+
+    /** Returns the plugins an index has under a key, ignoring case. */
+    juce::Array<int> find (Index index, const juce::String& key) const;
+
+    /** Replaces a plugin list's types and blacklist with the database's. */
+    void restore (juce::KnownPluginList& list) const;
+
+private:
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    const char* data = nullptr;
+    size_t dataSize = 0;
+    juce::uint32 numTypes = 0, numBlacklisted = 0;
+    juce::uint32 strings = 0, stringsSize = 0, types = 0, blacklist = 0;
+    juce::uint32 indexes[numIndexes] {};
+
+    juce::uint32 readInt (size_t offset) const noexcept;
+    juce::String readString (juce::uint32 ref) const;
+
+    JUCE_DECLARE_NON_COPYABLE (PluginDatabase)
+};
+
+} // namespace element
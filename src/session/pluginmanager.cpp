@@ -1,6 +1,9 @@
 // Copyright 2014-2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <algorithm>
+#include <map>
+
 #include <boost/dll.hpp>
 
 #include <element/nodefactory.hpp>
@@ -10,12 +13,22 @@
 #include <element/lv2.hpp>
 
 #include "nodes/nodetypes.hpp"
+#include "session/pluginbridge.hpp"
+#include "session/plugindatabase.hpp"
+#include "session/pluginscancache.hpp"
+#include "session/sharedplugin.hpp"
 #include "engine/ionode.hpp"
+#include "engine/threadpolicy.hpp"
 #include "datapath.hpp"
+#include "filesystemwatcher.hpp"
 #include "utils.hpp"
 
 #define EL_DEAD_AUDIO_PLUGINS_FILENAME "scanner/crashed.txt"
 #define EL_PLUGIN_SCANNER_SLAVE_LIST_PATH "scanner/list.xml"
+#define EL_PLUGIN_SCANNER_WORKER_LIST_PATH "scanner/list-%d.xml"
+#define EL_PLUGIN_SCANNER_WORKER_DEAD_PATH "scanner/crashed-%d.txt"
+#define EL_PLUGIN_SCANNER_CACHE_PATH "scanner/cache.xml"
+#define EL_PLUGIN_SCANNER_WORKER_CACHE_PATH "scanner/cache-%d.xml"
 #define EL_PLUGIN_SCANNER_WAITING_STATE "waiting"
 #define EL_PLUGIN_SCANNER_READY_STATE "ready"
 
@@ -24,6 +37,8 @@
 #define EL_PLUGIN_SCANNER_FINISHED_ID "finished"
 
 #define EL_PLUGIN_SCANNER_DEFAULT_TIMEOUT 20000 // 20 Seconds
+#define EL_PLUGIN_SCANNER_PLUGIN_TIMEOUT 120000 // 2 Minutes
+#define EL_PLUGIN_SCANNER_MAX_WORKERS 8
 
 #include <errno.h>
 extern char* program_invocation_name;
@@ -36,6 +51,35 @@ static const char* pluginListKey() { return Settings::pluginListKey; }
 /* noop. prevent OS error dialogs from child process */
 static void pluginScannerCrashHandler (void*) {}
 static File pluginsXmlFile() { return DataPath::applicationDataDir().getChildFile ("plugins.xml"); }
+static File pluginsDatabaseFile() { return DataPath::applicationDataDir().getChildFile ("plugins.db"); }
+
+/* each scanner worker keeps its own list and dead mans pedal */
+static File workerListFile (int worker)
+{
+    return DataPath::applicationDataDir().getChildFile (String (EL_PLUGIN_SCANNER_WORKER_LIST_PATH).replace ("%d", String (worker)));
+}
+
+static File workerDeadPluginsFile (int worker)
+{
+    return DataPath::applicationDataDir().getChildFile (String (EL_PLUGIN_SCANNER_WORKER_DEAD_PATH).replace ("%d", String (worker)));
+}
+
+static File scanCacheFile() { return DataPath::applicationDataDir().getChildFile (EL_PLUGIN_SCANNER_CACHE_PATH); }
+
+/* what a worker probed, merged into the scan cache when all are done */
+static File workerCacheFile (int worker)
+{
+    return DataPath::applicationDataDir().getChildFile (String (EL_PLUGIN_SCANNER_WORKER_CACHE_PATH).replace ("%d", String (worker)));
+}
+
+/* true if a worker scans this file. Files are split by hash, so the
+   workers scan disjoint sets without talking to each other. */
+static bool isInShard (const String& fileOrIdentifier, int worker, int numWorkers)
+{
+    if (numWorkers <= 1)
+        return true;
+    return (int) ((uint64) fileOrIdentifier.hashCode64() % (uint64) numWorkers) == worker;
+}
 
 static File scannerExeFullPath()
 {
@@ -57,6 +101,52 @@ static File scannerExeFullPath()
     return scannerExe;
 }
 
+/* plugins found by a worker go over the pipe as "plugin:" and a record */
+static const char pluginMessagePrefix[] = "plugin:";
+static constexpr size_t pluginMessagePrefixSize = sizeof (pluginMessagePrefix) - 1;
+
+static MemoryBlock createPluginMessage (const PluginDescription& type)
+{
+    MemoryOutputStream out;
+    out.write (pluginMessagePrefix, pluginMessagePrefixSize);
+    for (const auto* text : { &type.name, &type.descriptiveName, &type.pluginFormatName, &type.category, &type.manufacturerName, &type.version, &type.fileOrIdentifier })
+        out.writeString (*text);
+    out.writeInt64 (type.lastFileModTime.toMilliseconds());
+    out.writeInt64 (type.lastInfoUpdateTime.toMilliseconds());
+    out.writeInt (type.deprecatedUid);
+    out.writeInt (type.uniqueId);
+    out.writeInt (type.numInputChannels);
+    out.writeInt (type.numOutputChannels);
+    out.writeByte ((char) ((type.isInstrument ? 1 : 0) | (type.hasSharedContainer ? 2 : 0)));
+    return out.getMemoryBlock();
+}
+
+static bool isPluginMessage (const MemoryBlock& mb)
+{
+    return mb.getSize() > pluginMessagePrefixSize
+           && std::memcmp (mb.getData(), pluginMessagePrefix, pluginMessagePrefixSize) == 0;
+}
+
+static bool readPluginMessage (const MemoryBlock& mb, PluginDescription& type)
+{
+    MemoryInputStream in (mb, false);
+    in.skipNextBytes ((int64) pluginMessagePrefixSize);
+    for (auto* text : { &type.name, &type.descriptiveName, &type.pluginFormatName, &type.category, &type.manufacturerName, &type.version, &type.fileOrIdentifier })
+        *text = in.readString();
+    type.lastFileModTime = Time (in.readInt64());
+    type.lastInfoUpdateTime = Time (in.readInt64());
+    type.deprecatedUid = in.readInt();
+    type.uniqueId = in.readInt();
+    type.numInputChannels = in.readInt();
+    type.numOutputChannels = in.readInt();
+    if (in.getNumBytesRemaining() < 1)
+        return false;
+    const auto flags = in.readByte();
+    type.isInstrument = (flags & 1) != 0;
+    type.hasSharedContainer = (flags & 2) != 0;
+    return type.fileOrIdentifier.isNotEmpty() && type.pluginFormatName.isNotEmpty();
+}
+
 } // namespace detail
 
 //==============================================================================
@@ -64,7 +154,8 @@ class PluginScannerCoordinator : public juce::ChildProcessCoordinator,
                                  public AsyncUpdater
 {
 public:
-    explicit PluginScannerCoordinator (PluginScanner& o) : owner (o) {}
+    PluginScannerCoordinator (PluginScanner& o, int index, int count)
+        : owner (o), worker (index), numWorkers (count) {}
     ~PluginScannerCoordinator() {}
 
     bool startScanning (const StringArray& names = StringArray())
@@ -76,6 +167,7 @@ public:
             ScopedLock sl (lock);
             slaveState = EL_PLUGIN_SCANNER_WAITING_STATE;
             running = false;
+            finished = false;
             formatNames = names;
         }
 
@@ -92,6 +184,18 @@ public:
 
     void handleMessageFromWorker (const MemoryBlock& mb) override
     {
+        if (detail::isPluginMessage (mb))
+        {
+            PluginDescription type;
+            if (detail::readPluginMessage (mb, type))
+            {
+                ScopedLock sl (lock);
+                found.add (type);
+            }
+            triggerAsyncUpdate();
+            return;
+        }
+
         const auto data (mb.toString());
         const auto type (data.upToFirstOccurrenceOf (":", false, false));
         const auto message (data.fromFirstOccurrenceOf (":", false, false));
@@ -112,13 +216,16 @@ public:
             owner.listeners.call (&PluginScanner::Listener::audioPluginScanStarted, message.trim());
             ScopedLock sl (lock);
             pluginBeingScanned = message.trim();
+            scanStarted = Time::getMillisecondCounter();
         }
         else if (type == "progress")
         {
             float newProgress = (float) var (message);
-            owner.listeners.call (&PluginScanner::Listener::audioPluginScanProgress, newProgress);
-            ScopedLock sl (lock);
-            progress = newProgress;
+            {
+                ScopedLock sl (lock);
+                progress = newProgress;
+            }
+            owner.setWorkerProgress (worker, newProgress);
         }
     }
 
@@ -135,11 +242,19 @@ public:
 
     void handleAsyncUpdate() override
     {
+        Array<PluginDescription> newTypes;
+        {
+            ScopedLock sl (lock);
+            newTypes.swapWith (found);
+        }
+        if (! newTypes.isEmpty())
+            owner.pluginsFound (newTypes);
+
         const auto state = getWorkerState();
         if (state == "ready" && isRunning())
         {
             String msg = "scan:";
-            msg << formatNames.joinIntoString (",");
+            msg << worker << "/" << numWorkers << ":" << formatNames.joinIntoString (",");
             MemoryBlock mb (msg.toRawUTF8(), msg.length());
             sendMessageToWorker (mb);
         }
@@ -164,10 +279,12 @@ public:
             {
                 ScopedLock sl (lock);
                 running = false;
+                finished = true;
                 slaveState = "idle";
             }
 
-            owner.listeners.call (&PluginScanner::Listener::audioPluginScanFinished);
+            // this may delete the coordinator, it has to come last.
+            owner.workerFinished();
         }
         else if (state == EL_PLUGIN_SCANNER_WAITING_STATE)
         {
@@ -205,6 +322,12 @@ public:
         return running;
     }
 
+    bool isFinished() const
+    {
+        ScopedLock sl (lock);
+        return finished;
+    }
+
     bool sendQuitMessage()
     {
         if (isRunning())
@@ -212,12 +335,44 @@ public:
         return false;
     }
 
+    /** Returns true if the plugin being scanned has taken too long. */
+    bool isStuck (uint32 now, uint32 timeout) const
+    {
+        ScopedLock sl (lock);
+        return running && slaveState == "scanning" && pluginBeingScanned.isNotEmpty()
+               && now - scanStarted > timeout;
+    }
+
+    /** Kills the worker. Its dead mans pedal still names the plugin, so
+        the relaunched worker blacklists it and moves on.
+     */
+    void abandonPlugin()
+    {
+        Logger::writeToLog ("[element] plugin scan timed out: " + getPluginBeingScanned());
+        killWorkerProcess();
+        {
+            ScopedLock sl (lock);
+            running = false;
+        }
+        triggerAsyncUpdate();
+    }
+
+    String getPluginBeingScanned() const
+    {
+        ScopedLock sl (lock);
+        return pluginBeingScanned;
+    }
+
 private:
     PluginScanner& owner;
+    const int worker, numWorkers;
 
     CriticalSection lock;
     bool running = false;
+    bool finished = false;
     float progress = 0.f;
+    uint32 scanStarted = 0;
+    Array<PluginDescription> found;
     String slaveState;
     StringArray formatNames;
     StringArray faileFiles;
@@ -226,9 +381,8 @@ private:
 
     void updateListAndLaunchWorker()
     {
-        if (auto xml = XmlDocument::parse (PluginScanner::getWorkerPluginListFile()))
-            owner.list.recreateFromXml (*xml);
-
+        // the worker picks up its own list again, results are merged once
+        // every worker has finished.
         const bool res = launchScanner();
         ScopedLock sl (lock);
         running = res;
@@ -238,6 +392,7 @@ private:
     {
         ScopedLock sl (lock);
         pluginBeingScanned = String();
+        scanStarted = 0;
         progress = -1.f;
     }
 
@@ -267,7 +422,6 @@ class PluginScannerWorker : public juce::ChildProcessWorker,
 public:
     PluginScannerWorker()
     {
-        scanFile = PluginScanner::getWorkerPluginListFile();
         SystemStats::setApplicationCrashHandler (detail::pluginScannerCrashHandler);
         auto logfile = DataPath::applicationDataDir().getChildFile ("log/scanner.log");
         logfile.create();
@@ -296,8 +450,12 @@ public:
 
         if (type == "scan")
         {
-            const auto formats (StringArray::fromTokens (message.trim(), ",", "'"));
-            formatsToScan = formats;
+            // scan:<worker>/<number of workers>:<formats>
+            const auto shard = message.upToFirstOccurrenceOf (":", false, false);
+            worker = jmax (0, shard.upToFirstOccurrenceOf ("/", false, false).getIntValue());
+            numWorkers = jmax (1, shard.fromFirstOccurrenceOf ("/", false, false).getIntValue());
+            formatsToScan = StringArray::fromTokens (message.fromFirstOccurrenceOf (":", false, false).trim(), ",", "'");
+            loadShard();
             triggerAsyncUpdate();
         }
     }
@@ -349,18 +507,6 @@ public:
         plugins = std::make_unique<PluginManager>();
         logger->logMessage ("[scanner] created global objects");
 
-        if (! scanFile.existsAsFile())
-            scanFile.create();
-
-        if (auto xml = XmlDocument::parse (scanFile))
-            pluginList.recreateFromXml (*xml);
-
-        logger->logMessage ("[scanner] processing blacklist");
-        // This must happen before user settings, PluginManager will delete the deadman file
-        // when restoring user plugins
-        PluginDirectoryScanner::applyBlacklistingsFromDeadMansPedal (
-            pluginList, plugins->getDeadAudioPluginsFile());
-
         logger->logMessage ("[scanner] setting up formats");
         auto& nf = plugins->getNodeFactory();
         nf.add (new LV2NodeProvider());
@@ -397,12 +543,70 @@ private:
     File scanFile;
     StringArray formatsToScan;
 
+    File deadPlugins;
+    int worker = 0, numWorkers = 1;
+    PluginScanCache cache;
+
     std::unique_ptr<juce::FileLogger> logger;
 
+    /** Loads this worker's list, which holds what it scanned before being
+        relaunched, and blacklists whatever it crashed on.
+     */
+    void loadShard()
+    {
+        scanFile = detail::workerListFile (worker);
+        deadPlugins = detail::workerDeadPluginsFile (worker);
+        logger->logMessage ("[scanner] worker " + String (worker + 1) + " of " + String (numWorkers));
+
+        if (! scanFile.existsAsFile())
+            scanFile.create();
+
+        pluginList.clear();
+        pluginList.clearBlacklistedFiles();
+        if (auto xml = XmlDocument::parse (scanFile))
+            pluginList.recreateFromXml (*xml);
+
+        logger->logMessage ("[scanner] processing blacklist");
+        applyDeadPlugins();
+
+        // what this worker probed before a relaunch overrides the last scan
+        cache = {};
+        cache.load (detail::scanCacheFile());
+        cache.load (detail::workerCacheFile (worker));
+    }
+
+    /** True if a binary is unchanged since it was last probed and the list
+        still reflects what that probe found.
+     */
+    bool isUnchanged (const String& fileOrId)
+    {
+        if (! File::isAbsolutePath (fileOrId))
+            return false;
+        const auto* entry = cache.findUnchanged (File (fileOrId));
+        if (entry == nullptr)
+            return false;
+        if (entry->found)
+            return pluginList.getTypeForFile (fileOrId) != nullptr;
+        if (entry->blacklisted)
+            return pluginList.getBlacklistedFiles().contains (fileOrId);
+        return true;
+    }
+
+    void remember (const String& fileOrId)
+    {
+        if (! File::isAbsolutePath (fileOrId) || ! File (fileOrId).exists())
+            return;
+        cache.record (File (fileOrId),
+                      pluginList.getTypeForFile (fileOrId) != nullptr,
+                      scanner->getFailedFiles().contains (fileOrId));
+        cache.save (detail::workerCacheFile (worker), [this] (const String& path) {
+            return detail::isInShard (path, worker, numWorkers);
+        });
+    }
+
     void applyDeadPlugins()
     {
-        PluginDirectoryScanner::applyBlacklistingsFromDeadMansPedal (
-            pluginList, plugins->getDeadAudioPluginsFile());
+        PluginDirectoryScanner::applyBlacklistingsFromDeadMansPedal (pluginList, deadPlugins);
     }
 
     bool writePluginListNow()
@@ -431,13 +635,28 @@ private:
     bool doNextScan()
     {
         const auto nextFile = scanner->getNextPluginFileThatWillBeScanned();
+        if (! detail::isInShard (nextFile, worker, numWorkers))
+            return scanner->skipNextFile();
+        if (isUnchanged (nextFile))
+        {
+            logger->logMessage (String ("[scanner] unchanged: ") + nextFile);
+            return scanner->skipNextFile();
+        }
+
         sendString ("name", nextFile);
         logger->logMessage (String ("[scanner] scan: ") + nextFile);
 
         for (const auto& file : scanner->getFailedFiles())
             pluginList.addToBlacklist (file);
 
-        if (scanner->scanNextFile (true, fileOrIdentifier))
+        const int numTypes = pluginList.getNumTypes();
+        const bool more = scanner->scanNextFile (true, fileOrIdentifier);
+        remember (nextFile);
+        if (pluginList.getNumTypes() != numTypes)
+            for (const auto& type : pluginList.getTypes())
+                if (type.fileOrIdentifier == nextFile)
+                    sendMessageToCoordinator (detail::createPluginMessage (type));
+        if (more)
         {
             writePluginListNow();
             return true;
@@ -471,7 +690,8 @@ private:
             float step = 1.f;
             for (const auto& tp : types)
             {
-                if (! pluginList.getBlacklistedFiles().contains (tp) && pluginList.getTypeForFile (tp) == nullptr)
+                if (detail::isInShard (tp, worker, numWorkers)
+                    && ! pluginList.getBlacklistedFiles().contains (tp) && pluginList.getTypeForFile (tp) == nullptr)
                 {
                     sendString ("name", tp.trim());
                     logger->logMessage (String ("[scanner] scan: ") + tp);
@@ -486,6 +706,7 @@ private:
                         inst->getPluginDescription (desc);
                         pluginList.addType (desc);
                         writePluginListNow();
+                        sendMessageToCoordinator (detail::createPluginMessage (desc));
                     }
                 }
 
@@ -502,7 +723,7 @@ private:
 
         const auto key = String (settings->lastPluginScanPathPrefix) + format.getName();
         FileSearchPath path (settings->getUserSettings()->getValue (key));
-        scanner = std::make_unique<PluginDirectoryScanner> (pluginList, format, path, true, plugins->getDeadAudioPluginsFile(), false);
+        scanner = std::make_unique<PluginDirectoryScanner> (pluginList, format, path, true, deadPlugins, false);
 
         while (doNextScan())
             sendString ("progress", String (scanner->getProgress()));
@@ -518,21 +739,29 @@ private:
 PluginScanner::PluginScanner (KnownPluginList& listToManage) : list (listToManage) {}
 PluginScanner::~PluginScanner()
 {
+    stopTimer();
     listeners.clear();
-    master.reset();
+    workers.clear();
 }
 
 void PluginScanner::cancel()
 {
-    if (master)
+    stopTimer();
+    for (auto* worker : workers)
     {
-        master->handleUpdateNowIfNeeded();
-        master->sendQuitMessage();
-        master.reset();
+        worker->handleUpdateNowIfNeeded();
+        worker->sendQuitMessage();
     }
+    workers.clear();
 }
 
-bool PluginScanner::isScanning() const { return master && master->isRunning(); }
+bool PluginScanner::isScanning() const
+{
+    for (auto* worker : workers)
+        if (worker->isRunning())
+            return true;
+    return false;
+}
 
 void PluginScanner::scanForAudioPlugins (const juce::String& formatName)
 {
@@ -543,15 +772,96 @@ void PluginScanner::scanForAudioPlugins (const StringArray& formats)
 {
     cancel();
     getWorkerPluginListFile().deleteFile();
-    if (master == nullptr)
-        master.reset (new PluginScannerCoordinator (*this));
-    if (master->isRunning())
-        return;
-    master->startScanning (formats);
+
+    // one worker process per spare core, each scanning its own share of
+    // the files. A crash or hang only restarts the worker it happened in.
+    const int numWorkers = jlimit (1, EL_PLUGIN_SCANNER_MAX_WORKERS, SystemStats::getNumCpus() - 1);
+    {
+        ScopedLock sl (progressLock);
+        progress.clearQuick();
+        progress.insertMultiple (0, 0.f, numWorkers);
+    }
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        detail::workerListFile (i).deleteFile();
+        detail::workerCacheFile (i).deleteFile();
+        workers.add (new PluginScannerCoordinator (*this, i, numWorkers))->startScanning (formats);
+    }
+
+    startTimer (1000);
+}
+
+void PluginScanner::setWorkerProgress (int worker, float workerProgress)
+{
+    float total = 0.f;
+    {
+        ScopedLock sl (progressLock);
+        progress.set (worker, jlimit (0.f, 1.f, workerProgress));
+        for (const auto p : progress)
+            total += p;
+        total /= (float) jmax (1, progress.size());
+    }
+
+    listeners.call (&Listener::audioPluginScanProgress, total);
+}
+
+void PluginScanner::pluginsFound (const Array<PluginDescription>& types)
+{
+    for (const auto& type : types)
+    {
+        list.removeFromBlacklist (type.fileOrIdentifier);
+        list.addType (type);
+        listeners.call (&Listener::audioPluginFound, type);
+    }
+}
+
+void PluginScanner::workerFinished()
+{
+    for (auto* worker : workers)
+        if (! worker->isFinished())
+            return;
+
+    stopTimer();
+
+    // every worker started from the known plugins, so their lists only
+    // differ in what each one scanned.
+    KnownPluginList merged;
+    for (int i = 0; i < workers.size(); ++i)
+    {
+        if (auto xml = XmlDocument::parse (detail::workerListFile (i)))
+        {
+            KnownPluginList part;
+            part.recreateFromXml (*xml);
+            for (const auto& type : part.getTypes())
+                merged.addType (type);
+            for (const auto& file : part.getBlacklistedFiles())
+                merged.addToBlacklist (file);
+        }
+    }
+
+    if (auto xml = merged.createXml())
+        xml->writeTo (getWorkerPluginListFile());
+
+    PluginScanCache cache;
+    cache.load (detail::scanCacheFile());
+    for (int i = 0; i < workers.size(); ++i)
+    {
+        cache.load (detail::workerCacheFile (i));
+        detail::workerCacheFile (i).deleteFile();
+    }
+    cache.removeMissing();
+    cache.save (detail::scanCacheFile());
+
+    listeners.call (&Listener::audioPluginScanFinished);
 }
 
 void PluginScanner::timerCallback()
 {
+    const auto now = Time::getMillisecondCounter();
+    for (auto* worker : workers)
+        if (worker->isStuck (now, EL_PLUGIN_SCANNER_PLUGIN_TIMEOUT))
+            worker->abandonPlugin();
 }
 
 //==============================================================================
@@ -588,6 +898,7 @@ public:
             paths.clear();
         }
 
+        ThreadPolicy::prepareBackground (*this);
         startThread (Thread::Priority::background);
     }
 
@@ -621,6 +932,35 @@ public:
         }
     }
 
+    /** Returns the folders searched for a format's plugins. */
+    FileSearchPath getSearchPath (AudioPluginFormat& format) const
+    {
+        FileSearchPath path = paths[format.getName()];
+        path.addPath (format.getDefaultLocationsToSearch());
+        return path;
+    }
+
+    /** Adds or removes one file after it changed, without searching again.
+        Formats that haven't been searched yet are left alone.
+     */
+    void fileChanged (const File& file, AudioPluginFormatManager& formats)
+    {
+        const auto path = file.getFullPathName();
+        ScopedLock sl (lock);
+        for (int i = 0; i < formats.getNumFormats(); ++i)
+        {
+            auto* const format = formats.getFormat (i);
+            if (! plugins.contains (format->getName()))
+                continue;
+
+            auto& found = plugins.getReference (format->getName());
+            if (file.exists() && format->fileMightContainThisPluginType (path))
+                found.addIfNotAlreadyThere (path);
+            else
+                found.removeString (path);
+        }
+    }
+
 private:
     friend class Thread;
     CriticalSection lock;
@@ -687,16 +1027,18 @@ private:
 };
 
 //==============================================================================
-class PluginManager::Private : public PluginScanner::Listener
+class PluginManager::Private : public PluginScanner::Listener,
+                               private FileSystemWatcher::Listener
 {
 public:
     Private (PluginManager& o)
         : owner (o)
     {
         deadAudioPlugins = DataPath::applicationDataDir().getChildFile (EL_DEAD_AUDIO_PLUGINS_FILENAME);
+        watcher.addListener (this);
     }
 
-    ~Private() {}
+    ~Private() { watcher.removeListener (this); }
 
     /** returns true if anything changed in the plugin list */
     bool updateBlacklistedAudioPlugins()
@@ -717,6 +1059,29 @@ public:
     void searchUnverifiedPlugins (PropertiesFile* props)
     {
         unverified.searchForPlugins (props);
+
+        // after the search, plugins installed or removed are picked up as
+        // they happen. Only the search folders themselves are watched,
+        // plugins are bundles or files at the top of them.
+        watcher.removeAllFolders();
+        for (int i = 0; i < formats.getNumFormats(); ++i)
+        {
+            const auto path = unverified.getSearchPath (*formats.getFormat (i));
+            for (int j = 0; j < path.getNumPaths(); ++j)
+                if (path[j].isDirectory() && ! watcher.getWatchedFolders().contains (path[j]))
+                    watcher.addFolder (path[j]);
+        }
+    }
+
+    // a plugin that's gone is dropped from the list, one that's new or
+    // replaced shows as unverified until it's scanned.
+    void fileChanged (const File& file, FileSystemWatcher::FileSystemEvent) override
+    {
+        if (! file.exists())
+            for (const auto& type : allPlugins.getTypes())
+                if (type.fileOrIdentifier == file.getFullPathName())
+                    allPlugins.removeType (type);
+        unverified.fileChanged (file, formats);
     }
 
     void getUnverifiedPlugins (const String& format, OwnedArray<PluginDescription>& plugs)
@@ -731,12 +1096,109 @@ private:
     KnownPluginList allPlugins;
     File deadAudioPlugins;
     UnverifiedPlugins unverified;
+    FileSystemWatcher watcher;
     NodeFactory nodes;
     double sampleRate = 44100.0;
     int blockSize = 512;
     std::unique_ptr<PluginScanner> scanner;
     bool hasAddedFormats = false;
 
+    struct WarmPlugin
+    {
+        String identifier;
+        double sampleRate;
+        int blockSize;
+        std::unique_ptr<AudioPluginInstance> plugin;
+    };
+
+    std::vector<WarmPlugin> warm;
+    std::map<String, int> usage;
+    bool usageLoaded = false;
+    String warming;
+    StringArray failedToWarm;
+    // replaced to drop instances still being created
+    std::shared_ptr<int> warmGeneration { std::make_shared<int> (0) };
+
+    void loadUsage()
+    {
+        if (usageLoaded || owner.props == nullptr)
+            return;
+        usageLoaded = true;
+        for (const auto& line : StringArray::fromLines (owner.props->getValue (Settings::pluginUsageKey)))
+            if (line.containsChar (' '))
+                usage[line.fromFirstOccurrenceOf (" ", false, false)] = line.upToFirstOccurrenceOf (" ", false, false).getIntValue();
+    }
+
+    StringArray mostUsed (int count) const
+    {
+        std::vector<std::pair<int, String>> sorted;
+        for (const auto& u : usage)
+            sorted.emplace_back (u.second, u.first);
+        std::sort (sorted.begin(), sorted.end(), [] (const auto& a, const auto& b) { return a.first > b.first; });
+
+        StringArray ids;
+        for (size_t i = 0; i < sorted.size() && ids.size() < count; ++i)
+            ids.add (sorted[i].second);
+        return ids;
+    }
+
+    void saveUsage()
+    {
+        if (owner.props == nullptr)
+            return;
+        StringArray lines;
+        for (const auto& id : mostUsed (64))
+            lines.add (String (usage[id]) + " " + id);
+        owner.props->setValue (Settings::pluginUsageKey, lines.joinIntoString ("\n"));
+    }
+
+    /** Instantiates the next most used plugin that isn't warm, one at a
+        time so the message thread only stalls briefly for each.
+     */
+    void warmUp()
+    {
+        if (warming.isNotEmpty() || owner.props == nullptr || ! MessageManager::existsAndIsCurrentThread())
+            return;
+
+        loadUsage();
+        const auto wanted = mostUsed (jlimit (0, 16, owner.props->getIntValue (Settings::warmPluginsKey, 4)));
+        warm.erase (std::remove_if (warm.begin(), warm.end(), [&] (const WarmPlugin& w) {
+                        return ! wanted.contains (w.identifier) || w.sampleRate != sampleRate || w.blockSize != blockSize;
+                    }),
+                    warm.end());
+
+        for (const auto& id : wanted)
+        {
+            if (failedToWarm.contains (id) || std::any_of (warm.begin(), warm.end(), [&] (const WarmPlugin& w) { return w.identifier == id; }))
+                continue;
+            auto type = allPlugins.getTypeForIdentifierString (id);
+            if (type == nullptr || ! owner.canCreateAudioPluginAsync (*type) || owner.isPluginBridged (*type) || owner.isPluginShared (*type))
+                continue;
+
+            warming = id;
+            std::weak_ptr<int> token = warmGeneration;
+            const auto rate = sampleRate;
+            const auto block = blockSize;
+            owner.createAudioPluginAsync (*type, [this, token, id, rate, block] (std::unique_ptr<AudioPluginInstance> plugin, const String&) {
+                if (token.expired())
+                    return;
+                warming.clear();
+                if (plugin == nullptr)
+                {
+                    failedToWarm.add (id);
+                }
+                else if (rate == sampleRate && block == blockSize)
+                {
+                    plugin->enableAllBuses();
+                    plugin->prepareToPlay (rate, block);
+                    warm.push_back ({ id, rate, block, std::move (plugin) });
+                }
+                warmUp();
+            });
+            return;
+        }
+    }
+
     void scanAudioPlugins (const StringArray& names)
     {
         if (scanner)
@@ -900,11 +1362,101 @@ bool PluginManager::isScanningAudioPlugins()
 
 AudioPluginInstance* PluginManager::createAudioPlugin (const PluginDescription& desc, String& errorMsg)
 {
+    if (isPluginShared (desc))
+    {
+        auto shared = SharedPlugin::findOrCreate (desc.createIdentifierString(), [&]() -> std::unique_ptr<AudioPluginInstance> {
+            if (isPluginBridged (desc))
+                return createBridgedPlugin (desc, priv->sampleRate, priv->blockSize, errorMsg);
+            return getAudioPluginFormats().createPluginInstance (desc, priv->sampleRate, priv->blockSize, errorMsg);
+        });
+        return createSharedPluginClient (shared).release();
+    }
+
+    if (isPluginBridged (desc))
+        return createBridgedPlugin (desc, priv->sampleRate, priv->blockSize, errorMsg).release();
     return getAudioPluginFormats().createPluginInstance (
                                       desc, priv->sampleRate, priv->blockSize, errorMsg)
         .release();
 }
 
+bool PluginManager::canCreateAudioPluginAsync (const PluginDescription& desc)
+{
+    if (desc.pluginFormatName == EL_NODE_FORMAT_NAME || desc.pluginFormatName == "Internal" || desc.pluginFormatName == "LV2")
+        return false;
+    return getAudioPluginFormat (desc.pluginFormatName) != nullptr;
+}
+
+void PluginManager::createAudioPluginAsync (const PluginDescription& desc, AudioPluginFormat::PluginCreationCallback callback)
+{
+    if (isPluginShared (desc) || isPluginBridged (desc))
+    {
+        String error;
+        std::unique_ptr<AudioPluginInstance> plugin (createAudioPlugin (desc, error));
+        callback (std::move (plugin), error);
+        return;
+    }
+
+    getAudioPluginFormats().createPluginInstanceAsync (desc, priv->sampleRate, priv->blockSize, std::move (callback));
+}
+
+bool PluginManager::canBridgePlugin (const PluginDescription& desc) const
+{
+    // internal nodes and LV2 aren't juce formats the bridge process can load.
+    if (desc.pluginFormatName == EL_NODE_FORMAT_NAME || desc.pluginFormatName == "Internal" || desc.pluginFormatName == "LV2")
+        return false;
+    return getAudioPluginFormat (desc.pluginFormatName) != nullptr;
+}
+
+bool PluginManager::isPluginBridged (const PluginDescription& desc) const
+{
+    if (props == nullptr || ! canBridgePlugin (desc))
+        return false;
+    return StringArray::fromLines (props->getValue (Settings::bridgedPluginsKey))
+        .contains (desc.createIdentifierString());
+}
+
+void PluginManager::setPluginBridged (const PluginDescription& desc, bool bridged)
+{
+    if (props == nullptr || (bridged && ! canBridgePlugin (desc)))
+        return;
+
+    auto ids = StringArray::fromLines (props->getValue (Settings::bridgedPluginsKey));
+    ids.removeEmptyStrings();
+    if (bridged)
+        ids.addIfNotAlreadyThere (desc.createIdentifierString());
+    else
+        ids.removeString (desc.createIdentifierString());
+    props->setValue (Settings::bridgedPluginsKey, ids.joinIntoString ("\n"));
+}
+
+bool PluginManager::canSharePlugin (const PluginDescription& desc) const
+{
+    // the same plain juce plugins the bridge can host.
+    return canBridgePlugin (desc);
+}
+
+bool PluginManager::isPluginShared (const PluginDescription& desc) const
+{
+    if (props == nullptr || ! canSharePlugin (desc))
+        return false;
+    return StringArray::fromLines (props->getValue (Settings::sharedPluginsKey))
+        .contains (desc.createIdentifierString());
+}
+
+void PluginManager::setPluginShared (const PluginDescription& desc, bool shared)
+{
+    if (props == nullptr || (shared && ! canSharePlugin (desc)))
+        return;
+
+    auto ids = StringArray::fromLines (props->getValue (Settings::sharedPluginsKey));
+    ids.removeEmptyStrings();
+    if (shared)
+        ids.addIfNotAlreadyThere (desc.createIdentifierString());
+    else
+        ids.removeString (desc.createIdentifierString());
+    props->setValue (Settings::sharedPluginsKey, ids.joinIntoString ("\n"));
+}
+
 Processor* PluginManager::createGraphNode (const PluginDescription& desc, String& errorMsg)
 {
     errorMsg.clear();
@@ -995,6 +1547,7 @@ void PluginManager::saveUserPlugins (ApplicationProperties& settings)
     setPropertiesFile (settings.getUserSettings());
     if (auto elm = priv->allPlugins.createXml())
         elm->writeTo (detail::pluginsXmlFile());
+    PluginDatabase::write (priv->allPlugins, detail::pluginsDatabaseFile());
 }
 
 void PluginManager::restoreUserPlugins (ApplicationProperties& settings)
@@ -1010,8 +1563,24 @@ void PluginManager::restoreUserPlugins (ApplicationProperties& settings)
         props->removeValue (detail::pluginListKey());
     }
 
-    if (auto xml = XmlDocument::parse (detail::pluginsXmlFile()))
+    // the database is much quicker to load, the xml stays for older
+    // versions and is only read when it is the newer of the two.
+    const auto dbFile = detail::pluginsDatabaseFile();
+    const auto xmlFile = detail::pluginsXmlFile();
+    PluginDatabase db;
+    if (dbFile.getLastModificationTime() >= xmlFile.getLastModificationTime() && db.open (dbFile))
+    {
+        db.restore (priv->allPlugins);
+        db.close();
+        scanInternalPlugins();
+        priv->updateBlacklistedAudioPlugins();
+    }
+    else if (auto xml = XmlDocument::parse (xmlFile))
+    {
         restoreUserPlugins (*xml);
+        PluginDatabase::write (priv->allPlugins, dbFile);
+    }
+
     settings.saveIfNeeded();
 }
 
@@ -1034,6 +1603,35 @@ void PluginManager::setPlayConfig (double sampleRate, int blockSize)
 {
     priv->sampleRate = sampleRate;
     priv->blockSize = blockSize;
+
+    // instances at an old config are dropped when warming up again.
+    priv->warmUp();
+}
+
+std::unique_ptr<AudioPluginInstance> PluginManager::takeWarmPlugin (const PluginDescription& desc)
+{
+    if (! canCreateAudioPluginAsync (desc) || isPluginBridged (desc) || isPluginShared (desc))
+        return nullptr;
+
+    const auto id = desc.createIdentifierString();
+    priv->loadUsage();
+    ++priv->usage[id];
+    priv->saveUsage();
+
+    std::unique_ptr<AudioPluginInstance> plugin;
+    auto& warm = priv->warm;
+    for (auto iter = warm.begin(); iter != warm.end(); ++iter)
+    {
+        if (iter->identifier == id && iter->sampleRate == priv->sampleRate && iter->blockSize == priv->blockSize)
+        {
+            plugin = std::move (iter->plugin);
+            warm.erase (iter);
+            break;
+        }
+    }
+
+    priv->warmUp();
+    return plugin;
 }
 
 void PluginManager::scanAudioPlugins (const StringArray& names)
@@ -1070,7 +1668,7 @@ void PluginManager::scanInternalPlugins()
     }
 
     OwnedArray<PluginDescription> ds;
-    for (const auto& nodeTypeId : nodes.knownIDs())
+    for (const auto& nodeTypeId : nodes.visibleIDs())
     {
         nodes.getPluginDescriptions (ds, nodeTypeId);
     }
@@ -0,0 +1,130 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "session/pluginscancache.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace {
+/* bundles are directories, stamp them by their contents */
+Array<File> filesOf (const File& file)
+{
+    if (! file.isDirectory())
+        return { file };
+    auto files = file.findChildFiles (File::findFiles, true);
+    files.sort();
+    return files;
+}
+
+void stamp (const File& file, int64& size, int64& modified)
+{
+    size = 0;
+    modified = 0;
+    for (const auto& f : filesOf (file))
+    {
+        size += f.getSize();
+        modified = jmax (modified, f.getLastModificationTime().toMilliseconds());
+    }
+}
+} // namespace
+
+String PluginScanCache::hashFile (const File& file)
+{
+    MemoryBlock block;
+    for (const auto& f : filesOf (file))
+    {
+        const auto md5 = MD5 (f).getRawChecksumData();
+        block.append (md5.getData(), md5.getSize());
+    }
+    return MD5 (block).toHexString();
+}
+
+const PluginScanCache::Entry* PluginScanCache::findUnchanged (const File& file)
+{
+    auto iter = entries.find (file.getFullPathName());
+    if (iter == entries.end() || ! file.exists())
+        return nullptr;
+
+    auto& entry = iter->second;
+    int64 size, modified;
+    stamp (file, size, modified);
+    if (size != entry.size)
+        return nullptr;
+    if (modified == entry.modified)
+        return &entry;
+
+    if (hashFile (file) != entry.hash)
+        return nullptr;
+    entry.modified = modified;
+    return &entry;
+}
+
+void PluginScanCache::record (const File& file, bool found, bool blacklisted)
+{
+    auto& entry = entries[file.getFullPathName()];
+    stamp (file, entry.size, entry.modified);
+    entry.hash = hashFile (file);
+    entry.found = found;
+    entry.blacklisted = blacklisted;
+}
+
+void PluginScanCache::remove (const File& file)
+{
+    entries.erase (file.getFullPathName());
+}
+
+void PluginScanCache::removeMissing()
+{
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        if (File (iter->first).exists())
+            ++iter;
+        else
+            iter = entries.erase (iter);
+    }
+}
+
+bool PluginScanCache::load (const File& file)
+{
+    auto xml = XmlDocument::parse (file);
+    if (xml == nullptr || ! xml->hasTagName ("scancache"))
+        return false;
+
+    for (const auto* e : xml->getChildWithTagNameIterator ("binary"))
+    {
+        const auto path = e->getStringAttribute ("path");
+        if (! File::isAbsolutePath (path))
+            continue;
+        auto& entry = entries[path];
+        entry.size = e->getStringAttribute ("size").getLargeIntValue();
+        entry.modified = e->getStringAttribute ("modified").getLargeIntValue();
+        entry.hash = e->getStringAttribute ("hash");
+        entry.found = e->getBoolAttribute ("found");
+        entry.blacklisted = e->getBoolAttribute ("blacklisted");
+    }
+
+    return true;
+}
+
+bool PluginScanCache::save (const File& file, std::function<bool (const String&)> filter) const
+{
+    XmlElement xml ("scancache");
+    for (const auto& e : entries)
+    {
+        if (filter && ! filter (e.first))
+            continue;
+        auto* b = xml.createNewChildElement ("binary");
+        b->setAttribute ("path", e.first);
+        b->setAttribute ("size", String (e.second.size));
+        b->setAttribute ("modified", String (e.second.modified));
+        b->setAttribute ("hash", e.second.hash);
+        b->setAttribute ("found", e.second.found);
+        b->setAttribute ("blacklisted", e.second.blacklisted);
+    }
+
+    return xml.writeTo (file);
+}
+
+} // namespace element
@@ -0,0 +1,66 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <functional>
+#include <map>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Remembers what scanning each plugin binary turned up, keyed by path
+    and stamped with its size, modification time and content hash.
+
+    A binary whose size and time still match is taken as unchanged without
+    reading it. If only the time moved, the hash decides, so a reinstall of
+    the same build doesn't get probed again. Bundles are stamped by the
+    files inside them.
+ */
+class PluginScanCache final
+{
+public:
+    PluginScanCache() = default;
+
+    /** What the last probe of a binary found. */
+    struct Entry
+    {
+        juce::int64 size = 0;
+        juce::int64 modified = 0;
+        juce::String hash;
+        bool found = false; ///< at least one plugin was listed
+        bool blacklisted = false; ///< the binary failed to load
+    };
+
+    /** Returns the entry for a binary if it hasn't changed since it was
+        recorded, or nullptr if it needs probing.
+     */
+    const Entry* findUnchanged (const juce::File& file);
+
+    /** Stamps a binary that was just probed. */
+    void record (const juce::File& file, bool found, bool blacklisted);
+
+    /** Forgets a binary. */
+    void remove (const juce::File& file);
+
+    /** Drops entries for binaries that no longer exist. */
+    void removeMissing();
+
+    /** Returns the number of binaries known. */
+    int size() const noexcept { return (int) entries.size(); }
+
+    /** Adds the entries stored in a file, replacing any with equal paths. */
+    bool load (const juce::File& file);
+
+    /** Writes the entries, or only those the filter accepts, to a file. */
+    bool save (const juce::File& file, std::function<bool (const juce::String&)> filter = nullptr) const;
+
+    /** Returns the content hash of a binary or bundle. */
+    static juce::String hashFile (const juce::File& file);
+
+private:
+    std::map<juce::String, Entry> entries;
+};
+
+} // namespace element
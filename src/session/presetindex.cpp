@@ -0,0 +1,264 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+
+#include <element/datapath.hpp>
+#include <element/node.hpp>
+
+#include "session/presetindex.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace {
+const Identifier indexType ("presetIndex");
+const Identifier presetType ("preset");
+const Identifier fileProperty ("file");
+const Identifier modifiedProperty ("modified");
+const Identifier sizeProperty ("size");
+const Identifier formatProperty ("format");
+const Identifier identifierProperty ("identifier");
+const Identifier tagsProperty ("tags");
+constexpr int indexVersion = 1;
+
+bool parseEntry (PresetIndex::Entry& entry, const File& folder)
+{
+    const Node node (Node::parse (entry.file), false);
+    if (! node.isValid())
+        return false;
+
+    entry.name = node.getName();
+    if (entry.name.isEmpty())
+        entry.name = entry.file.getFileNameWithoutExtension();
+    entry.format = node.getFormat().toString();
+    entry.identifier = node.getIdentifier().toString();
+
+    entry.tags.clear();
+    for (auto dir = entry.file.getParentDirectory(); dir != folder && dir.isAChildOf (folder); dir = dir.getParentDirectory())
+        entry.tags.insert (0, dir.getFileName());
+
+    return entry.format.isNotEmpty() && entry.identifier.isNotEmpty();
+}
+
+bool isPresetFile (const File& file)
+{
+    const auto name = file.getFileName();
+    for (const auto& pattern : StringArray::fromTokens (EL_PRESET_FILE_EXTENSIONS, ";", {}))
+        if (name.matchesWildcard (pattern, ! File::areFileNamesCaseSensitive()))
+            return true;
+    return false;
+}
+
+bool byName (const PresetIndex::Entry* a, const PresetIndex::Entry* b)
+{
+    return a->name.compareNatural (b->name) < 0;
+}
+} // namespace
+
+PresetIndex::PresetIndex (const File& file)
+    : indexFile (file) {}
+
+String PresetIndex::pluginKey (const String& format, const String& identifier)
+{
+    return format + ":" + identifier;
+}
+
+void PresetIndex::clear()
+{
+    plugins.clear();
+    entries.clear();
+}
+
+bool PresetIndex::load()
+{
+    entries.clear();
+
+    FileInputStream in (indexFile);
+    const auto data = in.openedOk() ? ValueTree::readFromStream (in) : ValueTree();
+    if (! data.hasType (indexType) || (int) data.getProperty (tags::version) != indexVersion)
+    {
+        rebuildLookup();
+        return false;
+    }
+
+    for (const auto& preset : data)
+    {
+        Entry entry;
+        entry.file = File (preset.getProperty (fileProperty).toString());
+        entry.modified = (int64) preset.getProperty (modifiedProperty);
+        entry.size = (int64) preset.getProperty (sizeProperty);
+        entry.name = preset.getProperty (tags::name).toString();
+        entry.format = preset.getProperty (formatProperty).toString();
+        entry.identifier = preset.getProperty (identifierProperty).toString();
+        entry.tags.addTokens (preset.getProperty (tagsProperty).toString(), "/", {});
+        entries[entry.file.getFullPathName()] = entry;
+    }
+
+    rebuildLookup();
+    return true;
+}
+
+bool PresetIndex::save() const
+{
+    ValueTree data (indexType);
+    data.setProperty (tags::version, indexVersion, nullptr);
+    for (const auto& [path, entry] : entries)
+    {
+        ValueTree preset (presetType);
+        preset.setProperty (fileProperty, path, nullptr)
+            .setProperty (modifiedProperty, entry.modified, nullptr)
+            .setProperty (sizeProperty, entry.size, nullptr)
+            .setProperty (tags::name, entry.name, nullptr)
+            .setProperty (formatProperty, entry.format, nullptr)
+            .setProperty (identifierProperty, entry.identifier, nullptr)
+            .setProperty (tagsProperty, entry.tags.joinIntoString ("/"), nullptr);
+        data.appendChild (preset, nullptr);
+    }
+
+    TemporaryFile temp (indexFile);
+    if (auto out = temp.getFile().createOutputStream())
+    {
+        data.writeToStream (*out);
+        out.reset();
+        return temp.overwriteTargetFileWithTemporary();
+    }
+
+    return false;
+}
+
+bool PresetIndex::update (const File& folder)
+{
+    bool changed = false;
+    std::map<String, Entry> current;
+
+    if (folder.isDirectory())
+    {
+        for (const auto& item : RangedDirectoryIterator (folder, true, EL_PRESET_FILE_EXTENSIONS))
+        {
+            const auto path = item.getFile().getFullPathName();
+            const auto modified = item.getModificationTime().toMilliseconds();
+            const auto size = item.getFileSize();
+
+            auto it = entries.find (path);
+            if (it != entries.end() && it->second.modified == modified && it->second.size == size)
+            {
+                current[path] = std::move (it->second);
+                continue;
+            }
+
+            Entry entry;
+            entry.file = item.getFile();
+            entry.modified = modified;
+            entry.size = size;
+            changed = true;
+
+            // unreadable files are remembered too, so they aren't parsed
+            // again until they change.
+            if (! parseEntry (entry, folder))
+                entry.format = entry.identifier = {};
+            current[path] = std::move (entry);
+        }
+    }
+
+    changed |= current.size() != entries.size();
+    entries.swap (current);
+    rebuildLookup();
+    return changed;
+}
+
+bool PresetIndex::updateFile (const File& file, const File& folder)
+{
+    const auto path = file.getFullPathName();
+    auto it = entries.find (path);
+
+    if (! file.existsAsFile() || ! file.isAChildOf (folder) || ! isPresetFile (file))
+    {
+        if (it == entries.end())
+            return false;
+        unlink (it->second);
+        entries.erase (it);
+        return true;
+    }
+
+    const auto modified = file.getLastModificationTime().toMilliseconds();
+    const auto size = file.getSize();
+    if (it != entries.end() && it->second.modified == modified && it->second.size == size)
+        return false;
+
+    Entry entry;
+    entry.file = file;
+    entry.modified = modified;
+    entry.size = size;
+    if (! parseEntry (entry, folder))
+        entry.format = entry.identifier = {};
+
+    if (it != entries.end())
+        unlink (it->second);
+    auto& stored = entries[path];
+    stored = std::move (entry);
+    link (stored);
+    return true;
+}
+
+void PresetIndex::rebuildLookup()
+{
+    plugins.clear();
+    for (const auto& [path, entry] : entries)
+        if (entry.format.isNotEmpty() && entry.identifier.isNotEmpty())
+            plugins[pluginKey (entry.format, entry.identifier)].add (&entry);
+
+    for (auto& [key, presets] : plugins)
+        std::sort (presets.begin(), presets.end(), byName);
+}
+
+void PresetIndex::link (const Entry& entry)
+{
+    if (entry.format.isEmpty() || entry.identifier.isEmpty())
+        return;
+    auto& presets = plugins[pluginKey (entry.format, entry.identifier)];
+    const auto pos = std::upper_bound (presets.begin(), presets.end(), &entry, byName);
+    presets.insert ((int) (pos - presets.begin()), &entry);
+}
+
+void PresetIndex::unlink (const Entry& entry)
+{
+    auto it = plugins.find (pluginKey (entry.format, entry.identifier));
+    if (it == plugins.end())
+        return;
+    it->second.removeFirstMatchingValue (&entry);
+    if (it->second.isEmpty())
+        plugins.erase (it);
+}
+
+void PresetIndex::getPresetsFor (const String& format, const String& identifier, Array<Entry>& results) const
+{
+    auto it = plugins.find (pluginKey (format, identifier));
+    if (it == plugins.end())
+        return;
+    for (const auto* entry : it->second)
+        results.add (*entry);
+}
+
+void PresetIndex::search (const String& text, Array<Entry>& results) const
+{
+    StringArray words;
+    words.addTokens (text, true);
+    words.removeEmptyStrings();
+
+    for (const auto& [path, entry] : entries)
+    {
+        if (entry.format.isEmpty())
+            continue;
+
+        const auto haystack = entry.name + " " + entry.tags.joinIntoString (" ");
+        bool matches = true;
+        for (const auto& word : words)
+            matches = matches && haystack.containsIgnoreCase (word);
+        if (matches)
+            results.add (entry);
+    }
+}
+
+} // namespace element
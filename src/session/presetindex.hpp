@@ -0,0 +1,77 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <map>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** An on-disk index of node presets, keyed by plugin format and identifier.
+
+    Presets are only parsed when they're new or their file changed since
+    the index last saw them, so keeping the index current costs a listing
+    of the folder. Lookups by plugin don't touch the disk at all.
+ */
+class PresetIndex final
+{
+public:
+    struct Entry
+    {
+        juce::File file;
+        juce::int64 modified = 0;
+        juce::int64 size = 0;
+        juce::String name;
+        juce::String format;
+        juce::String identifier;
+        juce::StringArray tags; ///< sub folders the preset is in
+    };
+
+    /** Create an index saved to the given file. */
+    explicit PresetIndex (const juce::File& indexFile);
+
+    /** Reads the saved index. Returns false if there wasn't a usable one. */
+    bool load();
+
+    /** Saves the index. */
+    bool save() const;
+
+    /** Brings the index up to date with the presets in a folder and its
+        sub folders. Returns true if anything changed.
+     */
+    bool update (const juce::File& folder);
+
+    /** Brings one file in a folder up to date after it was added, changed
+        or removed, without listing the folder. Returns true if anything
+        changed.
+     */
+    bool updateFile (const juce::File& file, const juce::File& folder);
+
+    /** Forgets every preset, the saved index is left alone. */
+    void clear();
+
+    /** Returns the number of presets indexed. */
+    int size() const noexcept { return (int) entries.size(); }
+
+    /** Adds the presets for a plugin to results, sorted by name. */
+    void getPresetsFor (const juce::String& format, const juce::String& identifier, juce::Array<Entry>& results) const;
+
+    /** Adds presets whose name or tags contain every word of the text. */
+    void search (const juce::String& text, juce::Array<Entry>& results) const;
+
+private:
+    juce::File indexFile;
+    std::map<juce::String, Entry> entries; ///< by full path
+    std::map<juce::String, juce::Array<const Entry*>> plugins; ///< by format and identifier, sorted by name
+
+    void rebuildLookup();
+    void link (const Entry&);
+    void unlink (const Entry&);
+    static juce::String pluginKey (const juce::String& format, const juce::String& identifier);
+
+    JUCE_DECLARE_NON_COPYABLE (PresetIndex)
+};
+
+} // namespace element
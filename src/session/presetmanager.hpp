@@ -7,40 +7,45 @@
 #include <element/presets.hpp>
 
 #include "datapath.hpp"
+#include "session/presetindex.hpp"
 
 namespace element {
 
 class PresetManager
 {
 public:
-    struct SortByName
-    {
-        int compareElements (PresetInfo* first, PresetInfo* second) const
-        {
-            if (first->name < second->name)
-                return -1;
-            if (first->name == second->name)
-                return 0;
-            if (first->name > second->name)
-                return 1;
-            return 0;
-        }
-    };
-
-    PresetManager() {}
+    PresetManager()
+        : indexFile (DataPath::applicationDataDir().getChildFile ("PresetIndex.dat")),
+          index (std::make_unique<PresetIndex> (indexFile)) {}
     ~PresetManager() {}
 
     inline void clear()
     {
-        presets.clear();
+        const ScopedLock sl (lock);
+        index->clear();
     }
 
     inline void getPresetsFor (const Node& node, OwnedArray<PresetInfo>& results) const
     {
-        SortByName sorter;
-        for (const auto* const preset : presets)
-            if (preset->ID == node.getIdentifier().toString() && preset->format == node.getFormat().toString())
-                results.addSorted (sorter, new PresetInfo (*preset));
+        Array<PresetIndex::Entry> entries;
+        {
+            const ScopedLock sl (lock);
+            index->getPresetsFor (node.getFormat().toString(), node.getIdentifier().toString(), entries);
+        }
+        for (const auto& entry : entries)
+            results.add (createInfo (entry));
+    }
+
+    /** Finds presets whose name or folders contain every word of text. */
+    inline void search (const String& text, OwnedArray<PresetInfo>& results) const
+    {
+        Array<PresetIndex::Entry> entries;
+        {
+            const ScopedLock sl (lock);
+            index->search (text, entries);
+        }
+        for (const auto& entry : entries)
+            results.add (createInfo (entry));
     }
 
     inline void addPresetFor (const Node& node, const String& name)
@@ -48,40 +53,52 @@ public:
         jassertfalse;
     }
 
+    /** Brings the index up to date, only new or changed presets are read.
+        Safe on any thread: the index is rebuilt from the saved one aside
+        and swapped in, so lookups don't wait on the disk.
+     */
     inline void refresh()
     {
-        clear();
-
-        StringArray files;
-        path.findPresetFiles (files);
-
-        for (const auto& filename : files)
-        {
-            const File file (filename);
-            const Node node (Node::parse (file), false);
-            if (node.isValid())
-            {
-                std::unique_ptr<PresetInfo> item;
-                item.reset (new PresetInfo());
-                item->file = file.getFullPathName().toStdString();
-                item->name = node.getName().toStdString();
-                if (item->name.empty())
-                    item->name = file.getFileNameWithoutExtension().toStdString();
-                item->format = node.getFormat().toString().toStdString();
-                item->ID = node.getIdentifier().toString().toStdString();
-                if (item->format.empty() || item->ID.empty())
-                    continue;
-
-                presets.add (item.release());
-            }
-        }
+        const ScopedLock rl (refreshLock);
+        auto fresh = std::make_unique<PresetIndex> (indexFile);
+        fresh->load();
+        if (fresh->update (getPresetsFolder()))
+            fresh->save();
+
+        const ScopedLock sl (lock);
+        std::swap (index, fresh);
+    }
 
-        presets.minimiseStorageOverheads();
+    /** Brings just these files up to date, for changes seen as they happen. */
+    inline void refreshFiles (const Array<File>& files)
+    {
+        const ScopedLock rl (refreshLock);
+        const ScopedLock sl (lock);
+        bool changed = false;
+        for (const auto& file : files)
+            changed |= index->updateFile (file, getPresetsFolder());
+        if (changed)
+            index->save();
     }
 
+    /** Returns the folder presets are kept in. */
+    File getPresetsFolder() const { return path.getRootDir().getChildFile ("Nodes"); }
+
 private:
     DataPath path;
-    OwnedArray<PresetInfo> presets;
+    File indexFile;
+    std::unique_ptr<PresetIndex> index;
+    CriticalSection lock, refreshLock;
+
+    static PresetInfo* createInfo (const PresetIndex::Entry& entry)
+    {
+        auto* info = new PresetInfo();
+        info->file = entry.file.getFullPathName().toStdString();
+        info->name = entry.name.toStdString();
+        info->format = entry.format.toStdString();
+        info->ID = entry.identifier.toStdString();
+        return info;
+    }
 };
 
 } // namespace element
@@ -7,6 +7,9 @@
 #include <element/session.hpp>
 
 #include <element/context.hpp>
+#include "session/sessionfile.hpp"
+#include "session/sessionprofile.hpp"
+#include "session/statepool.hpp"
 #include "tempo.hpp"
 
 namespace element {
@@ -39,6 +42,8 @@ public:
 private:
     friend class Session;
     [[maybe_unused]] Session& owner;
+    // states of saved nodes, equal ones are held once.
+    StatePool states;
 };
 
 Session::Session()
@@ -102,8 +107,16 @@ bool Session::loadData (const ValueTree& data)
 
 std::unique_ptr<XmlElement> Session::createXml() const
 {
-    ValueTree saveData = objectData.createCopy();
-    Node::sanitizeProperties (saveData, true);
+    ValueTree saveData;
+    {
+        SessionProfile::Timer timer (SessionProfile::copy);
+        saveData = objectData.createCopy();
+    }
+    {
+        SessionProfile::Timer timer (SessionProfile::sanitize);
+        Node::sanitizeProperties (saveData, true);
+    }
+    SessionFile::resolveStates (saveData);
     return saveData.createXml();
 }
 
@@ -229,6 +242,15 @@ void Session::saveGraphState()
 {
     for (int i = 0; i < getNumGraphs(); ++i)
         getGraph (i).savePluginState();
+
+    // nodes that were never created still refer to the old file, which
+    // is about to be replaced.
+    SessionProfile::Timer timer (SessionProfile::saveStates);
+    SessionFile::resolveStates (objectData);
+
+    // the same plugin in several graphs then holds one copy of its state.
+    impl->states.purge();
+    impl->states.share (objectData);
 }
 
 void Session::restoreGraphState()
@@ -283,18 +305,23 @@ void Session::setActiveGraph (int index)
         .setProperty (tags::active, index, nullptr);
 }
 
-bool Session::writeToFile (const File& file) const
+bool Session::writeToFile (const File& file, int compressionLevel) const
 {
-    ValueTree saveData = objectData.createCopy();
-    Node::sanitizeProperties (saveData, true);
+    ValueTree saveData;
+    {
+        SessionProfile::Timer timer (SessionProfile::copy);
+        saveData = objectData.createCopy();
+    }
+    {
+        SessionProfile::Timer timer (SessionProfile::sanitize);
+        Node::sanitizeProperties (saveData, true);
+    }
     TemporaryFile tempFile (file);
 
     if (auto fos = tempFile.getFile().createOutputStream())
     {
-        {
-            GZIPCompressorOutputStream gzip (*fos, 9);
-            saveData.writeToStream (gzip);
-        }
+        if (! SessionFile::write (saveData, *fos, compressionLevel))
+            return false;
         fos.reset();
         return tempFile.overwriteTargetFileWithTemporary();
     }
@@ -304,9 +331,18 @@ bool Session::writeToFile (const File& file) const
 
 ValueTree Session::readFromFile (const File& file)
 {
-    ValueTree data;
     FileInputStream fi (file);
+    if (! fi.openedOk())
+        return {};
+    if (SessionFile::canRead (fi))
+        return SessionFile::readLazily (file);
 
+    // sessions saved before the chunked format are XML or a gzipped tree.
+    SessionProfile::Timer timer (SessionProfile::parse);
+    if (auto e = XmlDocument::parse (file))
+        return ValueTree::fromXml (*e);
+
+    ValueTree data;
     {
         GZIPDecompressorInputStream gzip (fi);
         data = ValueTree::readFromStream (gzip);
@@ -0,0 +1,549 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <element/tags.hpp>
+
+#include "session/sessionfile.hpp"
+#include "session/sessionprofile.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace {
+constexpr int fourcc (const char (&id)[5]) noexcept
+{
+    return id[0] | (id[1] << 8) | (id[2] << 16) | (id[3] << 24);
+}
+
+constexpr int fileMagic = fourcc ("ELSF");
+constexpr int fileVersion = 1;
+constexpr int treeChunk = fourcc ("TREE");
+constexpr int blobChunk = fourcc ("BLOB");
+
+enum ChunkFlags
+{
+    chunkCompressed = 1 << 0, ///< a single deflate stream
+    chunkSliced = 1 << 1 ///< deflated in slices, see pack()
+};
+
+// base64 properties of a node that hold opaque state.
+const Identifier blobProperties[] = { tags::state, tags::programState, tags::midiProgramsState };
+
+// chunk indexes by content hash.
+using BlobIndex = std::unordered_multimap<uint64, int>;
+
+/** Moves states into blobs. Equal states, e.g. the same plugin in several
+    graphs, are stored once and share a chunk index.
+ */
+void extractBlobs (ValueTree tree, Array<MemoryBlock>& blobs, BlobIndex& index)
+{
+    if (tree.hasType (types::Node))
+    {
+        for (const auto& id : blobProperties)
+        {
+            MemoryBlock block;
+            if (! SessionFile::readState (tree.getProperty (id), block))
+                continue;
+
+            const auto hash = SessionFile::hashState (block);
+            int chunk = -1;
+            const auto range = index.equal_range (hash);
+            for (auto it = range.first; it != range.second && chunk < 0; ++it)
+                if (blobs.getReference (it->second) == block)
+                    chunk = it->second;
+
+            if (chunk < 0)
+            {
+                chunk = blobs.size();
+                index.emplace (hash, chunk);
+                blobs.add (std::move (block));
+            }
+
+            tree.setProperty (id, chunk, nullptr);
+        }
+    }
+
+    for (auto child : tree)
+        extractBlobs (child, blobs, index);
+}
+
+/** Puts states back in place of chunk indexes, getState (property, index)
+    returns the value for a property.
+ */
+template <typename GetState>
+bool restoreBlobs (ValueTree tree, int numBlobs, GetState&& getState)
+{
+    if (tree.hasType (types::Node))
+    {
+        for (const auto& id : blobProperties)
+        {
+            const auto* value = tree.getPropertyPointer (id);
+            if (value == nullptr || ! value->isInt())
+                continue;
+            const int index = (int) *value;
+            if (! isPositiveAndBelow (index, numBlobs))
+                return false;
+            tree.setProperty (id, getState (id, index), nullptr);
+        }
+    }
+
+    for (auto child : tree)
+        if (! restoreBlobs (child, numBlobs, getState))
+            return false;
+    return true;
+}
+
+constexpr size_t sliceSize = 1 << 20;
+
+/** A chunk as it is in memory and, if compressed, in the file. */
+struct Chunk
+{
+    int id = 0;
+    int flags = 0;
+    MemoryBlock data;
+    MemoryBlock payload;
+
+    // sliced chunks, see pack()
+    Array<int64> rawSizes, packedSizes;
+    Array<MemoryBlock> slices;
+};
+
+/** Calls fn with 0 to count - 1, spread over the cores. */
+template <typename Fn>
+void forEachParallel (int count, Fn&& fn)
+{
+    const int numThreads = jmin (count, SystemStats::getNumCpus());
+    if (numThreads <= 1)
+    {
+        for (int i = 0; i < count; ++i)
+            fn (i);
+        return;
+    }
+
+    std::atomic<int> next { 0 };
+    auto work = [&]() {
+        for (int i = next++; i < count; i = next++)
+            fn (i);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numThreads; ++i)
+        threads.emplace_back (work);
+    work();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+/** Lists every slice of every chunk, so large states spread over the
+    cores as well as many small ones.
+ */
+std::vector<std::pair<int, int>> listSlices (const std::vector<Chunk>& chunks)
+{
+    std::vector<std::pair<int, int>> jobs;
+    for (int c = 0; c < (int) chunks.size(); ++c)
+        for (int s = 0; s < chunks[(size_t) c].slices.size(); ++s)
+            jobs.emplace_back (c, s);
+    return jobs;
+}
+
+/** Compresses the chunks in slices which can be inflated independently.
+    Chunks that don't shrink by at least an eighth are stored raw, most
+    plugin state is already dense.
+ */
+void pack (std::vector<Chunk>& chunks, int compressionLevel)
+{
+    for (auto& chunk : chunks)
+    {
+        const auto size = chunk.data.getSize();
+        if (compressionLevel <= 0 || size <= 64)
+            continue;
+        for (size_t offset = 0; offset < size; offset += sliceSize)
+            chunk.rawSizes.add ((int64) jmin (sliceSize, size - offset));
+        chunk.slices.resize (chunk.rawSizes.size());
+    }
+
+    const auto jobs = listSlices (chunks);
+    forEachParallel ((int) jobs.size(), [&] (int i) {
+        auto& chunk = chunks[(size_t) jobs[(size_t) i].first];
+        const int slice = jobs[(size_t) i].second;
+        MemoryOutputStream mo (chunk.slices.getReference (slice), false);
+        GZIPCompressorOutputStream gzip (mo, compressionLevel);
+        gzip.write (addBytesToPointer (chunk.data.getData(), (size_t) slice * sliceSize),
+                    (size_t) chunk.rawSizes[slice]);
+    });
+
+    for (auto& chunk : chunks)
+    {
+        int64 packedSize = 4;
+        for (const auto& slice : chunk.slices)
+        {
+            chunk.packedSizes.add ((int64) slice.getSize());
+            packedSize += 16 + (int64) slice.getSize();
+        }
+
+        const auto size = (int64) chunk.data.getSize();
+        if (chunk.slices.isEmpty() || packedSize >= size - size / 8)
+            continue;
+
+        MemoryOutputStream mo (chunk.payload, false);
+        mo.writeInt (chunk.slices.size());
+        for (int i = 0; i < chunk.slices.size(); ++i)
+        {
+            mo.writeInt64 (chunk.rawSizes[i]);
+            mo.writeInt64 (chunk.packedSizes[i]);
+        }
+        for (const auto& slice : chunk.slices)
+            mo.write (slice.getData(), slice.getSize());
+        chunk.flags |= chunkSliced;
+    }
+}
+
+/** Inflates the chunks read from a file, slices in parallel. */
+bool unpack (std::vector<Chunk>& chunks)
+{
+    std::vector<Array<int64>> offsets (chunks.size());
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        auto& chunk = chunks[c];
+        if ((chunk.flags & chunkCompressed) != 0)
+        {
+            MemoryInputStream mi (chunk.payload, false);
+            GZIPDecompressorInputStream gzip (mi);
+            gzip.readIntoMemoryBlock (chunk.data);
+            if (chunk.data.isEmpty())
+                return false;
+            continue;
+        }
+
+        if ((chunk.flags & chunkSliced) == 0)
+        {
+            chunk.data.swapWith (chunk.payload);
+            continue;
+        }
+
+        MemoryInputStream mi (chunk.payload, false);
+        const int numSlices = mi.readInt();
+        if (numSlices <= 0 || (int64) numSlices * 16 > mi.getNumBytesRemaining())
+            return false;
+
+        int64 rawTotal = 0, packedOffset = 4 + (int64) numSlices * 16;
+        for (int i = 0; i < numSlices; ++i)
+        {
+            chunk.rawSizes.add (mi.readInt64());
+            chunk.packedSizes.add (mi.readInt64());
+            offsets[c].add (packedOffset);
+            if (chunk.rawSizes[i] < 0 || chunk.packedSizes[i] < 0)
+                return false;
+            rawTotal += chunk.rawSizes[i];
+            packedOffset += chunk.packedSizes[i];
+        }
+
+        if (packedOffset != (int64) chunk.payload.getSize())
+            return false;
+        chunk.data.setSize ((size_t) rawTotal);
+        chunk.slices.resize (numSlices);
+    }
+
+    const auto jobs = listSlices (chunks);
+    std::atomic<bool> failed { false };
+    forEachParallel ((int) jobs.size(), [&] (int i) {
+        auto& chunk = chunks[(size_t) jobs[(size_t) i].first];
+        const int slice = jobs[(size_t) i].second;
+
+        int64 rawOffset = 0;
+        for (int s = 0; s < slice; ++s)
+            rawOffset += chunk.rawSizes[s];
+
+        MemoryInputStream mi (addBytesToPointer (chunk.payload.getData(), offsets[(size_t) jobs[(size_t) i].first][slice]),
+                              (size_t) chunk.packedSizes[slice],
+                              false);
+        GZIPDecompressorInputStream gzip (mi);
+        const auto size = (int) chunk.rawSizes[slice];
+        if (gzip.read (addBytesToPointer (chunk.data.getData(), rawOffset), size) != size)
+            failed = true;
+    });
+
+    return ! failed;
+}
+
+bool readChunkHeader (InputStream& in, Chunk& chunk, int64& size)
+{
+    chunk.id = in.readInt();
+    chunk.flags = in.readInt();
+    size = in.readInt64();
+    const int64 remaining = in.getNumBytesRemaining();
+    return size >= 0 && (remaining < 0 || size <= remaining);
+}
+
+bool readChunk (InputStream& in, Chunk& chunk)
+{
+    int64 size = 0;
+    if (! readChunkHeader (in, chunk, size))
+        return false;
+    return in.readIntoMemoryBlock (chunk.payload, (ssize_t) size) == (size_t) size;
+}
+
+/** A session file kept mapped while its states haven't been read. */
+class MappedSession : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<MappedSession>;
+
+    struct Region
+    {
+        int flags = 0;
+        size_t offset = 0, size = 0;
+    };
+
+    explicit MappedSession (const File& file)
+        : mapped (file, MemoryMappedFile::readOnly)
+    {
+        // some filesystems can't be mapped.
+        if (mapped.getData() == nullptr)
+            file.loadFileAsData (fallback);
+    }
+
+    const void* getData() const noexcept { return mapped.getData() != nullptr ? mapped.getData() : fallback.getData(); }
+    size_t getSize() const noexcept { return mapped.getData() != nullptr ? mapped.getSize() : fallback.getSize(); }
+
+    bool inflate (const Region& region, MemoryBlock& result) const
+    {
+        std::vector<Chunk> chunks (1);
+        chunks[0].flags = region.flags;
+        chunks[0].payload.replaceAll (addBytesToPointer (getData(), region.offset), region.size);
+        if (! unpack (chunks))
+            return false;
+        result.swapWith (chunks[0].data);
+        return true;
+    }
+
+private:
+    MemoryMappedFile mapped;
+    MemoryBlock fallback;
+};
+
+/** A state property of a lazily read session. */
+class LazyState : public SessionFile::State
+{
+public:
+    LazyState (MappedSession::Ptr s, MappedSession::Region r)
+        : session (s), region (r) {}
+
+    bool read (MemoryBlock& state) const override { return session->inflate (region, state); }
+
+private:
+    MappedSession::Ptr session;
+    MappedSession::Region region;
+};
+} // namespace
+
+bool SessionFile::write (const ValueTree& session, OutputStream& out, int compressionLevel)
+{
+    std::vector<Chunk> chunks;
+    {
+        SessionProfile::Timer timer (SessionProfile::compress);
+        Array<MemoryBlock> blobs;
+        BlobIndex index;
+        ValueTree tree = session.createCopy();
+        extractBlobs (tree, blobs, index);
+
+        chunks.resize ((size_t) blobs.size() + 1);
+        chunks[0].id = treeChunk;
+        {
+            MemoryOutputStream mo (chunks[0].data, false);
+            tree.writeToStream (mo);
+        }
+        for (int i = 0; i < blobs.size(); ++i)
+        {
+            chunks[(size_t) i + 1].id = blobChunk;
+            chunks[(size_t) i + 1].data.swapWith (blobs.getReference (i));
+        }
+
+        pack (chunks, jlimit (0, 9, compressionLevel));
+    }
+
+    SessionProfile::Timer timer (SessionProfile::write);
+    out.writeInt (fileMagic);
+    out.writeInt (fileVersion);
+    for (const auto& chunk : chunks)
+    {
+        const auto& payload = (chunk.flags & chunkSliced) != 0 ? chunk.payload : chunk.data;
+        out.writeInt (chunk.id);
+        out.writeInt (chunk.flags);
+        out.writeInt64 ((int64) payload.getSize());
+        out.write (payload.getData(), payload.getSize());
+    }
+
+    out.flush();
+    return out.getStatus().wasOk();
+}
+
+bool SessionFile::canRead (InputStream& in)
+{
+    const auto start = in.getPosition();
+    const bool isSession = in.readInt() == fileMagic;
+    in.setPosition (start);
+    return isSession;
+}
+
+ValueTree SessionFile::read (InputStream& in)
+{
+    if (! canRead (in))
+        return {};
+
+    in.readInt();
+    if (in.readInt() > fileVersion)
+        return {};
+
+    std::vector<Chunk> chunks;
+    {
+        SessionProfile::Timer timer (SessionProfile::read);
+        while (! in.isExhausted())
+        {
+            chunks.emplace_back();
+            if (! readChunk (in, chunks.back()))
+                return {};
+        }
+    }
+
+    {
+        SessionProfile::Timer timer (SessionProfile::decompress);
+        if (chunks.empty() || chunks.front().id != treeChunk || ! unpack (chunks))
+            return {};
+    }
+
+    SessionProfile::Timer timer (SessionProfile::parse);
+    const auto& model = chunks.front().data;
+    auto tree = ValueTree::readFromData (model.getData(), model.getSize());
+    if (! tree.isValid())
+        return {};
+
+    // skip chunk types from newer versions.
+    Array<MemoryBlock> blobs;
+    for (auto& chunk : chunks)
+        if (chunk.id == blobChunk)
+            blobs.add (std::move (chunk.data));
+
+    // a shared chunk becomes one string the nodes share.
+    std::vector<var> states ((size_t) blobs.size());
+    const bool restored = restoreBlobs (tree, blobs.size(), [&] (const Identifier&, int index) {
+        auto& state = states[(size_t) index];
+        if (state.isVoid())
+            state = blobs.getReference (index).toBase64Encoding();
+        return state;
+    });
+    return restored ? tree : ValueTree();
+}
+
+ValueTree SessionFile::readLazily (const File& file)
+{
+    std::optional<SessionProfile::Timer> timer (std::in_place, SessionProfile::read);
+    MappedSession::Ptr session = new MappedSession (file);
+    MemoryInputStream in (session->getData(), session->getSize(), false);
+    if (! canRead (in))
+        return {};
+
+    in.readInt();
+    if (in.readInt() > fileVersion)
+        return {};
+
+    // only the model is inflated now, states are found but left in place.
+    std::vector<Chunk> model (1);
+    if (! readChunk (in, model[0]) || model[0].id != treeChunk)
+        return {};
+
+    Array<MappedSession::Region> blobs;
+    while (! in.isExhausted())
+    {
+        Chunk chunk;
+        int64 size = 0;
+        if (! readChunkHeader (in, chunk, size))
+            return {};
+        if (chunk.id == blobChunk)
+            blobs.add ({ chunk.flags, (size_t) in.getPosition(), (size_t) size });
+        in.skipNextBytes (size);
+    }
+
+    timer.emplace (SessionProfile::decompress);
+    if (! unpack (model))
+        return {};
+
+    timer.emplace (SessionProfile::parse);
+    auto tree = ValueTree::readFromData (model[0].data.getData(), model[0].data.getSize());
+    if (! tree.isValid())
+        return {};
+
+    std::vector<var> states ((size_t) blobs.size());
+    std::vector<var> texts ((size_t) blobs.size());
+    const bool restored = restoreBlobs (tree, blobs.size(), [&] (const Identifier& id, int index) -> var {
+        // MIDI program lists are small and read as text elsewhere.
+        if (id == tags::midiProgramsState)
+        {
+            auto& text = texts[(size_t) index];
+            if (text.isVoid())
+            {
+                MemoryBlock state;
+                session->inflate (blobs.getReference (index), state);
+                text = state.toBase64Encoding();
+            }
+            return text;
+        }
+
+        auto& state = states[(size_t) index];
+        if (state.isVoid())
+            state = new LazyState (session, blobs.getReference (index));
+        return state;
+    });
+    return restored ? tree : ValueTree();
+}
+
+uint64 SessionFile::hashState (const MemoryBlock& state) noexcept
+{
+    // FNV-1a, equal hashes still need their contents compared.
+    uint64 hash = 14695981039346656037ull;
+    auto* bytes = static_cast<const uint8*> (state.getData());
+    for (size_t i = 0; i < state.getSize(); ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+bool SessionFile::readState (const var& value, MemoryBlock& state)
+{
+    state.reset();
+    if (auto* stored = dynamic_cast<State*> (value.getObject()))
+        return stored->read (state) && ! state.isEmpty();
+    if (auto* binary = value.getBinaryData())
+    {
+        state = *binary;
+        return ! state.isEmpty();
+    }
+
+    const auto text = value.toString().trim();
+    return text.isNotEmpty() && state.fromBase64Encoding (text) && ! state.isEmpty();
+}
+
+void SessionFile::resolveStates (ValueTree tree)
+{
+    if (tree.hasType (types::Node))
+    {
+        for (const auto& id : blobProperties)
+        {
+            MemoryBlock state;
+            const auto& value = tree.getProperty (id);
+            if (dynamic_cast<State*> (value.getObject()) != nullptr && readState (value, state))
+                tree.setProperty (id, state.toBase64Encoding(), nullptr);
+        }
+    }
+
+    for (auto child : tree)
+        resolveStates (child);
+}
+
+} // namespace element
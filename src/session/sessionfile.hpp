@@ -0,0 +1,79 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/core.hpp>
+#include <element/juce/data_structures.hpp>
+
+namespace element {
+
+/** Reads and writes sessions as a chunked container.
+
+    The model tree and each plugin state are stored as separate chunks.
+    Plugin states are written as raw bytes instead of base64 text inside
+    the tree, and each chunk is only compressed when it pays off. In the
+    stored tree a state property holds the index of its chunk.
+
+    State properties may be base64 text or binary data when written, and
+    are always base64 text when read back.
+
+    Chunks are deflated in 1 MB slices spread over the cores, and inflated
+    the same way when read, so even one large plugin state doesn't keep
+    a save or load on a single core.
+
+    Equal states are stored in one chunk, so the same plugin used in
+    several graphs costs its state once. Nodes read back share it too.
+ */
+struct SessionFile final
+{
+    /** A state property value that's only decoded when read, see
+        readState(). Lazily read states and shared undo states are these.
+     */
+    class State : public juce::ReferenceCountedObject
+    {
+    public:
+        virtual bool read (juce::MemoryBlock& state) const = 0;
+    };
+
+    /** Deflate levels, 0 stores chunks uncompressed. */
+    enum Compression
+    {
+        noCompression = 0,
+        fastCompression = 1,
+        bestCompression = 9
+    };
+
+    /** Writes a session tree to the stream. Returns false on failure. */
+    static bool write (const juce::ValueTree& session, juce::OutputStream& out, int compressionLevel = fastCompression);
+
+    /** Reads a session tree from the stream. Returns an invalid tree if
+        the stream isn't a chunked session, leaving it where it started.
+     */
+    static juce::ValueTree read (juce::InputStream& in);
+
+    /** Returns true if the stream starts like a chunked session. */
+    static bool canRead (juce::InputStream& in);
+
+    /** Reads a session from a file, inflating only the model. Plugin state
+        properties refer into the mapped file instead and are decoded
+        when read with readState(), i.e. when their node is created.
+        Returns an invalid tree if the file isn't a chunked session.
+     */
+    static juce::ValueTree readLazily (const juce::File& file);
+
+    /** Reads a state property whether it's base64 text, binary data or a
+        State. Returns false if there's no state.
+     */
+    static bool readState (const juce::var& value, juce::MemoryBlock& state);
+
+    /** Returns a hash of a state's contents. */
+    static juce::uint64 hashState (const juce::MemoryBlock& state) noexcept;
+
+    /** Replaces State values with base64 text, e.g. before the tree is
+        written as XML or the file lazy states are read from is replaced.
+     */
+    static void resolveStates (juce::ValueTree tree);
+};
+
+} // namespace element
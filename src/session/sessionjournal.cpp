@@ -0,0 +1,209 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <map>
+
+#include <element/tags.hpp>
+
+#include "session/sessionfile.hpp"
+#include "session/sessionjournal.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace {
+constexpr int fourcc (const char (&id)[5]) noexcept
+{
+    return id[0] | (id[1] << 8) | (id[2] << 16) | (id[3] << 24);
+}
+
+constexpr int snapshotRecord = fourcc ("SNAP");
+constexpr int deltaRecord = fourcc ("DLTA");
+constexpr int recordHeaderSize = 12;
+
+const Identifier deltaType ("delta");
+const Identifier nodeType ("node");
+const Identifier stateProperties[] = { tags::state, tags::programState };
+
+using NodeIndex = std::map<String, ValueTree>;
+
+void indexNodes (const ValueTree& tree, NodeIndex& nodes)
+{
+    if (tree.hasType (types::Node))
+        nodes[tree.getProperty (tags::uuid).toString()] = tree;
+    for (const auto& child : tree)
+        indexNodes (child, nodes);
+}
+
+void applyDelta (const NodeIndex& nodes, const ValueTree& delta)
+{
+    for (const auto& change : delta)
+    {
+        // nodes removed since don't need their state.
+        auto it = nodes.find (change.getProperty (tags::uuid).toString());
+        if (it == nodes.end())
+            continue;
+        auto target = it->second;
+        for (const auto& id : stateProperties)
+            if (change.hasProperty (id))
+                target.setProperty (id, change.getProperty (id), nullptr);
+    }
+}
+
+void writeRecord (OutputStream& out, int type, const MemoryBlock& data)
+{
+    out.writeInt (type);
+    out.writeInt64 ((int64) data.getSize());
+    out.write (data.getData(), data.getSize());
+}
+
+bool readRecord (InputStream& in, int& type, MemoryBlock& data)
+{
+    if (in.getNumBytesRemaining() < recordHeaderSize)
+        return false;
+    type = in.readInt();
+    const int64 size = in.readInt64();
+    if (size < 0 || size > in.getNumBytesRemaining())
+        return false;
+    data.reset();
+    return in.readIntoMemoryBlock (data, (ssize_t) size) == (size_t) size;
+}
+
+/** Reads the deltas in a journal, and the snapshot if one is passed. */
+bool readJournal (const File& file, ValueTree* snapshot, Array<ValueTree>& deltas)
+{
+    FileInputStream in (file);
+    if (! in.openedOk())
+        return false;
+
+    int type = 0;
+    MemoryBlock data;
+    if (! readRecord (in, type, data) || type != snapshotRecord)
+        return false;
+
+    if (snapshot != nullptr)
+    {
+        MemoryInputStream mi (data, false);
+        *snapshot = SessionFile::read (mi);
+        if (! snapshot->isValid())
+            return false;
+    }
+
+    while (readRecord (in, type, data))
+    {
+        if (type != deltaRecord)
+            continue;
+        auto delta = ValueTree::readFromData (data.getData(), data.getSize());
+        if (delta.hasType (deltaType))
+            deltas.add (delta);
+    }
+
+    return true;
+}
+} // namespace
+
+SessionJournal::SessionJournal (const File& f)
+    : file (f) {}
+
+bool SessionJournal::rebase (const ValueTree& session)
+{
+    auto tree = session.createCopy();
+
+    Array<ValueTree> deltas;
+    if (readJournal (file, nullptr, deltas))
+    {
+        NodeIndex nodes;
+        indexNodes (tree, nodes);
+        for (const auto& delta : deltas)
+            applyDelta (nodes, delta);
+    }
+
+    MemoryBlock snapshot;
+    {
+        MemoryOutputStream mo (snapshot, false);
+        if (! SessionFile::write (tree, mo))
+            return false;
+    }
+
+    TemporaryFile temp (file);
+    {
+        auto out = temp.getFile().createOutputStream();
+        if (out == nullptr)
+            return false;
+        writeRecord (*out, snapshotRecord, snapshot);
+        out->flush();
+        if (! out->getStatus().wasOk())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+bool SessionJournal::append (const ValueTree& delta)
+{
+    // deltas mean nothing without a snapshot to apply them to.
+    if (! file.existsAsFile() || ! delta.hasType (deltaType))
+        return false;
+
+    MemoryBlock data;
+    {
+        MemoryOutputStream mo (data, false);
+        delta.writeToStream (mo);
+    }
+
+    FileOutputStream out (file);
+    if (out.failedToOpen())
+        return false;
+    writeRecord (out, deltaRecord, data);
+    out.flush();
+    return out.getStatus().wasOk();
+}
+
+void SessionJournal::clear()
+{
+    file.deleteFile();
+}
+
+ValueTree SessionJournal::createDelta()
+{
+    return ValueTree (deltaType);
+}
+
+void SessionJournal::addNodeState (ValueTree& delta, const String& uuid, MemoryBlock state, MemoryBlock programState)
+{
+    ValueTree change (nodeType);
+    change.setProperty (tags::uuid, uuid, nullptr)
+        .setProperty (tags::state, var (std::move (state)), nullptr);
+    if (! programState.isEmpty())
+        change.setProperty (tags::programState, var (std::move (programState)), nullptr);
+    delta.appendChild (change, nullptr);
+}
+
+ValueTree SessionJournal::replay (const File& file)
+{
+    ValueTree session;
+    Array<ValueTree> deltas;
+    if (! readJournal (file, &session, deltas))
+        return {};
+
+    NodeIndex nodes;
+    indexNodes (session, nodes);
+    for (const auto& delta : deltas)
+        applyDelta (nodes, delta);
+
+    // the model keeps state as base64 text.
+    for (auto& entry : nodes)
+    {
+        auto& node = entry.second;
+        for (const auto& id : stateProperties)
+        {
+            if (auto* binary = node.getProperty (id).getBinaryData())
+                node.setProperty (id, binary->toBase64Encoding(), nullptr);
+        }
+    }
+
+    return session;
+}
+
+} // namespace element
@@ -0,0 +1,56 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/core.hpp>
+#include <element/juce/data_structures.hpp>
+
+namespace element {
+
+/** An append-only autosave file for a session.
+
+    The journal starts with a snapshot of the session, followed by deltas.
+    A delta holds the new state of only the nodes that changed, so saving
+    costs the size of what changed rather than the whole session. A
+    partially written record at the end, e.g. after a crash, is ignored.
+
+    Not thread safe. Autosave uses a journal from a single background thread.
+ */
+class SessionJournal final
+{
+public:
+    explicit SessionJournal (const juce::File& file);
+
+    /** Returns the journal file. */
+    const juce::File& getFile() const noexcept { return file; }
+
+    /** Starts the journal over with a snapshot of the session. States from
+        deltas already in the journal are kept if their node still exists.
+     */
+    bool rebase (const juce::ValueTree& session);
+
+    /** Appends a delta, see createDelta(). */
+    bool append (const juce::ValueTree& delta);
+
+    /** Deletes the journal file. */
+    void clear();
+
+    /** Returns an empty delta. Add changes with addNodeState(). */
+    static juce::ValueTree createDelta();
+
+    /** Adds the state of a node, by UUID, to a delta. */
+    static void addNodeState (juce::ValueTree& delta, const juce::String& uuid, juce::MemoryBlock state, juce::MemoryBlock programState = {});
+
+    /** Returns the session in the journal with every delta applied, or an
+        invalid tree if there is no readable snapshot.
+     */
+    static juce::ValueTree replay (const juce::File& file);
+
+private:
+    juce::File file;
+
+    JUCE_DECLARE_NON_COPYABLE (SessionJournal)
+};
+
+} // namespace element
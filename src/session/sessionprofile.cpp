@@ -0,0 +1,227 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "session/sessionprofile.hpp"
+
+namespace element {
+
+namespace detail {
+static juce::SpinLock profileLock;
+static SessionProfile::Ptr currentProfile, lastProfile;
+
+static double secondsSince (juce::int64 startTicks)
+{
+    return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+}
+} // namespace detail
+
+//==============================================================================
+SessionProfile::SessionProfile (const juce::String& op, const juce::File& f)
+    : operation (op), file (f) {}
+
+SessionProfile::Operation::Operation (const juce::String& op, const juce::File& f)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    const juce::SpinLock::ScopedLockType sl (detail::profileLock);
+    profile = detail::currentProfile;
+    if (profile == nullptr)
+    {
+        profile = new SessionProfile (op, f);
+        detail::currentProfile = profile;
+        owner = true;
+    }
+    startTicks = juce::Time::getHighResolutionTicks();
+}
+
+SessionProfile::Operation::~Operation()
+{
+    if (! owner)
+        return;
+    profile->seconds.store (detail::secondsSince (startTicks));
+    // a cancelled save shouldn't hide the last real one.
+    const bool keep = ! profile->getEntries().isEmpty();
+    const juce::SpinLock::ScopedLockType sl (detail::profileLock);
+    detail::currentProfile = nullptr;
+    if (keep)
+        detail::lastProfile = profile;
+}
+
+//==============================================================================
+SessionProfile::Timer::Timer (Phase p, const juce::String& n, const juce::String& pl)
+    : Timer (getCurrent(), p, n, pl) {}
+
+SessionProfile::Timer::Timer (Ptr pr, Phase p, const juce::String& n, const juce::String& pl)
+    : profile (pr), phase (p)
+{
+    if (profile == nullptr)
+        return;
+    node = n;
+    plugin = pl;
+    startTicks = juce::Time::getHighResolutionTicks();
+}
+
+SessionProfile::Timer::~Timer()
+{
+    if (profile != nullptr)
+        profile->add (phase, detail::secondsSince (startTicks), node, plugin);
+}
+
+//==============================================================================
+SessionProfile::Ptr SessionProfile::getCurrent()
+{
+    const juce::SpinLock::ScopedLockType sl (detail::profileLock);
+    return detail::currentProfile;
+}
+
+SessionProfile::Ptr SessionProfile::getLast()
+{
+    const juce::SpinLock::ScopedLockType sl (detail::profileLock);
+    return detail::lastProfile;
+}
+
+void SessionProfile::add (Phase phase, double secs, const juce::String& node, const juce::String& plugin)
+{
+    jassert (phase >= 0 && phase < numPhases);
+    const juce::ScopedLock sl (lock);
+    entries.add ({ phase, node, plugin, secs });
+}
+
+juce::Array<SessionProfile::Entry> SessionProfile::getEntries() const
+{
+    const juce::ScopedLock sl (lock);
+    return entries;
+}
+
+double SessionProfile::getTotal (Phase phase) const
+{
+    const juce::ScopedLock sl (lock);
+    double total = 0.0;
+    for (const auto& e : entries)
+        if (e.phase == phase)
+            total += e.seconds;
+    return total;
+}
+
+juce::Array<SessionProfile::NodeTotal> SessionProfile::getNodeTotals() const
+{
+    juce::Array<NodeTotal> totals;
+    for (const auto& e : getEntries())
+    {
+        if (e.node.isEmpty())
+            continue;
+
+        NodeTotal* total = nullptr;
+        for (auto& t : totals)
+            if (t.node == e.node)
+                total = &t;
+        if (total == nullptr)
+        {
+            totals.add ({});
+            total = &totals.getReference (totals.size() - 1);
+            total->node = e.node;
+        }
+
+        if (total->plugin.isEmpty())
+            total->plugin = e.plugin;
+        total->seconds += e.seconds;
+        total->phases[e.phase] += e.seconds;
+    }
+
+    std::stable_sort (totals.begin(), totals.end(), [] (const NodeTotal& a, const NodeTotal& b) {
+        return a.seconds > b.seconds;
+    });
+    return totals;
+}
+
+juce::String SessionProfile::toText (int maxNodes) const
+{
+    auto ms = [] (double seconds) { return juce::String (seconds * 1000.0, 1) + " ms"; };
+
+    juce::String text;
+    text << operation << " " << file.getFileName() << ": " << ms (getSeconds()) << juce::newLine;
+    for (int i = 0; i < numPhases; ++i)
+        if (const auto total = getTotal ((Phase) i); total > 0.0)
+            text << "  " << toString ((Phase) i) << ": " << ms (total) << juce::newLine;
+
+    const auto nodes = getNodeTotals();
+    if (! nodes.isEmpty())
+        text << juce::newLine << "Slowest nodes" << juce::newLine;
+    for (int i = 0; i < juce::jmin (maxNodes, nodes.size()); ++i)
+    {
+        const auto& n = nodes.getReference (i);
+        text << "  " << n.node;
+        if (n.plugin.isNotEmpty() && n.plugin != n.node)
+            text << " (" << n.plugin << ")";
+        text << ": " << ms (n.seconds) << juce::newLine;
+    }
+    return text;
+}
+
+juce::var SessionProfile::toJSON() const
+{
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("operation", operation);
+    root->setProperty ("file", file.getFullPathName());
+    root->setProperty ("seconds", getSeconds());
+
+    auto* phases = new juce::DynamicObject();
+    for (int i = 0; i < numPhases; ++i)
+        phases->setProperty (toString ((Phase) i), getTotal ((Phase) i));
+    root->setProperty ("phases", juce::var (phases));
+
+    juce::Array<juce::var> nodes;
+    for (const auto& n : getNodeTotals())
+    {
+        auto* node = new juce::DynamicObject();
+        node->setProperty ("name", n.node);
+        node->setProperty ("plugin", n.plugin);
+        node->setProperty ("seconds", n.seconds);
+        auto* nodePhases = new juce::DynamicObject();
+        for (int i = 0; i < numPhases; ++i)
+            if (n.phases[i] > 0.0)
+                nodePhases->setProperty (toString ((Phase) i), n.phases[i]);
+        node->setProperty ("phases", juce::var (nodePhases));
+        nodes.add (juce::var (node));
+    }
+    root->setProperty ("nodes", nodes);
+
+    return juce::var (root);
+}
+
+const char* SessionProfile::toString (Phase phase) noexcept
+{
+    switch (phase)
+    {
+        case read:
+            return "read";
+        case decompress:
+            return "decompress";
+        case parse:
+            return "parse";
+        case migrate:
+            return "migrate";
+        case instantiate:
+            return "instantiate";
+        case restore:
+            return "restore";
+        case prepare:
+            return "prepare";
+        case rebuild:
+            return "rebuild";
+        case saveStates:
+            return "saveStates";
+        case copy:
+            return "copy";
+        case sanitize:
+            return "sanitize";
+        case compress:
+            return "compress";
+        case write:
+            return "write";
+        case numPhases:
+            break;
+    }
+    return "unknown";
+}
+
+} // namespace element
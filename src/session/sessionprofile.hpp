@@ -0,0 +1,142 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** Times the phases of loading and saving a session, per node, to find
+    what makes a session slow to open or save.
+
+    An Operation collects for the length of a load or save on the message
+    thread. Timers placed along the way record into it from any thread,
+    and record nothing when no operation is collecting. Plugins that load
+    in the background keep the profile they started under, so they're
+    counted even when they finish after the operation.
+
+    The last profile is kept for the UI and can be written as JSON.
+ */
+class SessionProfile final : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SessionProfile>;
+
+    enum Phase
+    {
+        read = 0,
+        decompress,
+        parse,
+        migrate,
+        instantiate,
+        restore,
+        prepare,
+        rebuild,
+        saveStates,
+        copy,
+        sanitize,
+        compress,
+        write,
+        numPhases
+    };
+
+    struct Entry
+    {
+        Phase phase;
+        juce::String node;
+        juce::String plugin;
+        double seconds;
+    };
+
+    /** Seconds spent on one node, in each phase. */
+    struct NodeTotal
+    {
+        juce::String node;
+        juce::String plugin;
+        double seconds = 0.0;
+        double phases[numPhases] {};
+    };
+
+    SessionProfile (const juce::String& operation, const juce::File& file);
+
+    /** Collects until destroyed, then keeps the profile as the last one if
+        anything was timed. Message thread. Nested operations add to the
+        outer one.
+     */
+    class Operation final
+    {
+    public:
+        Operation (const juce::String& operation, const juce::File& file);
+        ~Operation();
+
+        /** The profile being collected. */
+        SessionProfile& getProfile() const noexcept { return *profile; }
+
+    private:
+        Ptr profile;
+        bool owner = false;
+        juce::int64 startTicks = 0;
+        JUCE_DECLARE_NON_COPYABLE (Operation)
+    };
+
+    /** Times a phase until destroyed, for a node if one is named. */
+    class Timer final
+    {
+    public:
+        Timer (Phase phase, const juce::String& node = {}, const juce::String& plugin = {});
+
+        /** Records into a profile captured earlier, e.g. on another thread. */
+        Timer (Ptr profile, Phase phase, const juce::String& node = {}, const juce::String& plugin = {});
+
+        ~Timer();
+
+    private:
+        Ptr profile;
+        Phase phase;
+        juce::String node, plugin;
+        juce::int64 startTicks = 0;
+        JUCE_DECLARE_NON_COPYABLE (Timer)
+    };
+
+    /** Returns the profile being collected, or nullptr. Any thread. */
+    static Ptr getCurrent();
+
+    /** Returns the most recently finished profile, or nullptr. Any thread. */
+    static Ptr getLast();
+
+    /** Adds a timing. Any thread. */
+    void add (Phase phase, double seconds, const juce::String& node = {}, const juce::String& plugin = {});
+
+    const juce::String& getOperation() const noexcept { return operation; }
+    const juce::File& getFile() const noexcept { return file; }
+    void setFile (const juce::File& newFile) { file = newFile; }
+
+    /** Wall clock time of the operation itself, not counting background loads. */
+    double getSeconds() const noexcept { return seconds.load(); }
+
+    juce::Array<Entry> getEntries() const;
+
+    /** Total seconds recorded for a phase, over every node. */
+    double getTotal (Phase phase) const;
+
+    /** Nodes by the time spent on them, slowest first. */
+    juce::Array<NodeTotal> getNodeTotals() const;
+
+    /** Phase totals, then the slowest nodes, as lines of text. */
+    juce::String toText (int maxNodes = 10) const;
+
+    /** The whole profile, for reports. */
+    juce::var toJSON() const;
+
+    static const char* toString (Phase phase) noexcept;
+
+private:
+    juce::String operation;
+    juce::File file;
+    std::atomic<double> seconds { 0.0 };
+    juce::CriticalSection lock;
+    juce::Array<Entry> entries;
+};
+
+} // namespace element
@@ -0,0 +1,286 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <map>
+
+#include "session/sharedplugin.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace {
+// starts ahead of every plugin's last rendered block, so the first renders.
+std::atomic<uint32> blockClock { 1 };
+// same, so a plugin restores once per session loaded.
+std::atomic<uint32> restoreClock { 1 };
+
+struct Registry
+{
+    CriticalSection lock;
+    std::map<String, SharedPlugin*> plugins;
+
+    // an entry whose last reference is going is still here until its
+    // destructor runs, it can't be handed out again.
+    SharedPlugin* get (const String& identifier) const
+    {
+        auto iter = plugins.find (identifier);
+        return iter != plugins.end() && iter->second->getReferenceCount() > 0 ? iter->second : nullptr;
+    }
+};
+
+Registry& getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+} // namespace
+
+//==============================================================================
+SharedPlugin::SharedPlugin (const String& id, std::unique_ptr<AudioPluginInstance> p)
+    : identifier (id), plugin (std::move (p))
+{
+    jassert (plugin != nullptr);
+}
+
+SharedPlugin::~SharedPlugin()
+{
+    auto& registry = getRegistry();
+    const ScopedLock sl (registry.lock);
+    auto iter = registry.plugins.find (identifier);
+    if (iter != registry.plugins.end() && iter->second == this)
+        registry.plugins.erase (iter);
+}
+
+SharedPlugin::Ptr SharedPlugin::find (const String& identifier)
+{
+    auto& registry = getRegistry();
+    const ScopedLock sl (registry.lock);
+    return registry.get (identifier);
+}
+
+SharedPlugin::Ptr SharedPlugin::create (const String& identifier, std::unique_ptr<AudioPluginInstance> plugin)
+{
+    if (plugin == nullptr)
+        return nullptr;
+
+    Ptr shared (new SharedPlugin (identifier, std::move (plugin)));
+    auto& registry = getRegistry();
+    const ScopedLock sl (registry.lock);
+    registry.plugins[identifier] = shared.get();
+    return shared;
+}
+
+SharedPlugin::Ptr SharedPlugin::findOrCreate (const String& identifier,
+                                              const std::function<std::unique_ptr<AudioPluginInstance>()>& factory)
+{
+    auto& registry = getRegistry();
+    const ScopedLock sl (registry.lock);
+    if (auto* existing = registry.get (identifier))
+        return existing;
+    // the lock is reentrant, create() takes it again.
+    return factory != nullptr ? create (identifier, factory()) : nullptr;
+}
+
+void SharedPlugin::beginRestore() noexcept
+{
+    restoreClock.fetch_add (1, std::memory_order_relaxed);
+}
+
+void SharedPlugin::nextBlock() noexcept
+{
+    blockClock.fetch_add (1, std::memory_order_release);
+}
+
+void SharedPlugin::prepare (double sampleRate, int blockSize)
+{
+    ++numPrepared;
+    if (numPrepared > 1 && sampleRate == plugin->getSampleRate() && blockSize <= output.getNumSamples())
+        return;
+
+    // other graphs may be playing it, they wait while it changes.
+    const SpinLock::ScopedLockType sl (renderLock);
+    plugin->prepareToPlay (sampleRate, blockSize);
+    output.setSize (jmax (1, plugin->getTotalNumInputChannels(), plugin->getTotalNumOutputChannels()),
+                    jmax (blockSize, output.getNumSamples()));
+    outputMidi.ensureSize (4096);
+    pendingMidi.ensureSize (4096);
+    renderedBlock = 0;
+}
+
+void SharedPlugin::release()
+{
+    if (numPrepared <= 0 || --numPrepared > 0)
+        return;
+
+    const SpinLock::ScopedLockType sl (renderLock);
+    plugin->releaseResources();
+    outputMidi.clear();
+    pendingMidi.clear();
+}
+
+void SharedPlugin::render (AudioBuffer<float>& audio, MidiBuffer& midi) noexcept
+{
+    const auto block = blockClock.load (std::memory_order_acquire);
+    const SpinLock::ScopedLockType sl (renderLock);
+    const int numSamples = jmin (audio.getNumSamples(), output.getNumSamples());
+    if (numPrepared <= 0 || numSamples <= 0)
+    {
+        audio.clear();
+        midi.clear();
+        return;
+    }
+
+    if (block != renderedBlock)
+    {
+        const int numInputs = jmin (audio.getNumChannels(), output.getNumChannels());
+        for (int i = 0; i < output.getNumChannels(); ++i)
+        {
+            if (i < numInputs)
+                output.copyFrom (i, 0, audio, i, 0, numSamples);
+            else
+                output.clear (i, 0, numSamples);
+        }
+
+        // notes held back from late clients go first.
+        pendingMidi.addEvents (midi, 0, numSamples, 0);
+        outputMidi.swapWith (pendingMidi);
+        pendingMidi.clear();
+
+        AudioBuffer<float> proxy (output.getArrayOfWritePointers(), output.getNumChannels(), numSamples);
+        plugin->processBlock (proxy, outputMidi);
+        renderedBlock = block;
+        renderedSamples = numSamples;
+    }
+    else
+    {
+        // the plugin already rendered this block, play these next block.
+        pendingMidi.addEvents (midi, 0, numSamples, 0);
+    }
+
+    midi.clear();
+    midi.addEvents (outputMidi, 0, numSamples, 0);
+
+    const int numReady = jmin (numSamples, renderedSamples);
+    for (int i = 0; i < audio.getNumChannels(); ++i)
+    {
+        if (i < output.getNumChannels())
+        {
+            audio.copyFrom (i, 0, output, i, 0, numReady);
+            if (numReady < audio.getNumSamples())
+                audio.clear (i, numReady, audio.getNumSamples() - numReady);
+        }
+        else
+        {
+            audio.clear (i, 0, audio.getNumSamples());
+        }
+    }
+}
+
+//==============================================================================
+class SharedPluginClient final : public AudioPluginInstance
+{
+public:
+    explicit SharedPluginClient (SharedPlugin::Ptr s)
+        : AudioPluginInstance (getBuses (s->getPlugin())),
+          shared (s)
+    {
+        ++shared->numClients;
+    }
+
+    ~SharedPluginClient() override
+    {
+        releaseResources();
+        --shared->numClients;
+    }
+
+    void fillInPluginDescription (PluginDescription& desc) const override
+    {
+        shared->getPlugin().fillInPluginDescription (desc);
+    }
+
+    const String getName() const override { return shared->getPlugin().getName(); }
+
+    void prepareToPlay (double sampleRate, int blockSize) override
+    {
+        if (prepared)
+            shared->release();
+        shared->prepare (sampleRate, blockSize);
+        prepared = true;
+        setLatencySamples (shared->getPlugin().getLatencySamples());
+    }
+
+    void releaseResources() override
+    {
+        if (prepared)
+            shared->release();
+        prepared = false;
+    }
+
+    void processBlock (AudioBuffer<float>& audio, MidiBuffer& midi) override
+    {
+        shared->render (audio, midi);
+    }
+
+    double getTailLengthSeconds() const override { return shared->getPlugin().getTailLengthSeconds(); }
+    bool acceptsMidi() const override { return shared->getPlugin().acceptsMidi(); }
+    bool producesMidi() const override { return shared->getPlugin().producesMidi(); }
+    bool isMidiEffect() const override { return shared->getPlugin().isMidiEffect(); }
+
+    bool hasEditor() const override { return shared->getPlugin().hasEditor(); }
+    AudioProcessorEditor* createEditor() override
+    {
+        // a plugin shows one editor, whichever node opened it first.
+        auto& plugin = shared->getPlugin();
+        return plugin.getActiveEditor() == nullptr ? plugin.createEditorIfNeeded() : nullptr;
+    }
+
+    int getNumPrograms() override { return shared->getPlugin().getNumPrograms(); }
+    int getCurrentProgram() override { return shared->getPlugin().getCurrentProgram(); }
+    void setCurrentProgram (int index) override { shared->getPlugin().setCurrentProgram (index); }
+    const String getProgramName (int index) override { return shared->getPlugin().getProgramName (index); }
+    void changeProgramName (int index, const String& name) override { shared->getPlugin().changeProgramName (index, name); }
+
+    void getStateInformation (MemoryBlock& data) override { shared->getPlugin().getStateInformation (data); }
+    void setStateInformation (const void* data, int size) override
+    {
+        // later clients join the plugin as it is, or loading a setlist
+        // would restore it once per song.
+        const auto generation = restoreClock.load (std::memory_order_relaxed);
+        if (shared->restoredGeneration == generation && shared->getNumClients() > 1)
+            return;
+        shared->restoredGeneration = generation;
+        shared->getPlugin().setStateInformation (data, size);
+    }
+
+protected:
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override
+    {
+        return layouts == shared->getPlugin().getBusesLayout();
+    }
+
+private:
+    SharedPlugin::Ptr shared;
+    bool prepared = false;
+
+    static BusesProperties getBuses (AudioProcessor& plugin)
+    {
+        BusesProperties buses;
+        for (const bool isInput : { true, false })
+            for (int i = 0; i < plugin.getBusCount (isInput); ++i)
+                if (auto* bus = plugin.getBus (isInput, i))
+                    buses.addBus (isInput, bus->getName(), bus->getCurrentLayout(), bus->isEnabled());
+        return buses;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (SharedPluginClient)
+};
+
+std::unique_ptr<AudioPluginInstance> createSharedPluginClient (SharedPlugin::Ptr shared)
+{
+    if (shared == nullptr)
+        return nullptr;
+    return std::make_unique<SharedPluginClient> (shared);
+}
+
+} // namespace element
@@ -0,0 +1,95 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+#include <element/juce/audio_processors.hpp>
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** One plugin instance played by nodes in any number of graphs.
+
+    Nodes hold clients made by createSharedPluginClient(). The first client
+    to render in a block renders the plugin with its input, the others get
+    a copy of that output. MIDI reaching a client after the plugin already
+    rendered is played in the next block, so only graphs heard at the same
+    time pay a block on their notes. Graphs that aren't rendered cost
+    nothing, so a setlist using the same instrument in every song loads
+    it once.
+ */
+class SharedPlugin final : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SharedPlugin>;
+
+    ~SharedPlugin() override;
+
+    /** Returns the plugin shared under an identifier, or nullptr. */
+    static Ptr find (const juce::String& identifier);
+
+    /** Shares a plugin under an identifier, usually that of its description. */
+    static Ptr create (const juce::String& identifier, std::unique_ptr<juce::AudioPluginInstance> plugin);
+
+    /** Returns the plugin shared under an identifier, sharing the one made
+        by the factory if there's none. Both happen under the registry lock,
+        so two nodes loading at once get the same plugin.
+     */
+    static Ptr findOrCreate (const juce::String& identifier,
+                             const std::function<std::unique_ptr<juce::AudioPluginInstance>()>& factory);
+
+    /** Starts restoring a session. The first client to restore its state
+        afterwards restores the plugin, clients of other graphs in the same
+        session join it as it is.
+     */
+    static void beginRestore() noexcept;
+
+    /** Starts a new block for every shared plugin. Called by the engine
+        before it renders graphs.
+     */
+    static void nextBlock() noexcept;
+
+    const juce::String& getIdentifier() const noexcept { return identifier; }
+    juce::AudioPluginInstance& getPlugin() const noexcept { return *plugin; }
+
+    /** Returns the number of clients, counted by createSharedPluginClient(). */
+    int getNumClients() const noexcept { return numClients; }
+
+    /** Prepares the plugin for the first prepared client. */
+    void prepare (double sampleRate, int blockSize);
+
+    /** Releases the plugin after the last prepared client. */
+    void release();
+
+    /** Renders a client's block in place. Audio thread. */
+    void render (juce::AudioBuffer<float>& audio, juce::MidiBuffer& midi) noexcept;
+
+private:
+    friend class SharedPluginClient;
+    SharedPlugin (const juce::String& identifier, std::unique_ptr<juce::AudioPluginInstance> plugin);
+
+    const juce::String identifier;
+    std::unique_ptr<juce::AudioPluginInstance> plugin;
+    int numClients = 0, numPrepared = 0;
+    juce::uint32 restoredGeneration = 0;
+
+    juce::SpinLock renderLock;
+    juce::uint32 renderedBlock = 0;
+    int renderedSamples = 0;
+    juce::AudioBuffer<float> output;
+    juce::MidiBuffer outputMidi, pendingMidi;
+
+    JUCE_DECLARE_NON_COPYABLE (SharedPlugin)
+};
+
+/** Creates a node's view of a shared plugin. It has the plugin's buses,
+    programs and editor. The first client to restore state after
+    SharedPlugin::beginRestore() restores the plugin, later ones join it
+    as it is unless they're its only client. Parameters are not mirrored.
+ */
+std::unique_ptr<juce::AudioPluginInstance> createSharedPluginClient (SharedPlugin::Ptr shared);
+
+} // namespace element
@@ -0,0 +1,89 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <element/tags.hpp>
+
+#include "session/sessionfile.hpp"
+#include "session/statepool.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace {
+// midiProgramsState is left alone, it's read back as text.
+const Identifier stateProperties[] = { tags::state, tags::programState };
+} // namespace
+
+class StatePool::Blob : public SessionFile::State
+{
+public:
+    explicit Blob (MemoryBlock& state) { data.swapWith (state); }
+
+    bool read (MemoryBlock& state) const override
+    {
+        state = data;
+        return true;
+    }
+
+    const MemoryBlock& getData() const noexcept { return data; }
+
+private:
+    MemoryBlock data;
+};
+
+ReferenceCountedObjectPtr<StatePool::Blob> StatePool::intern (MemoryBlock& state, int64& added)
+{
+    const auto hash = SessionFile::hashState (state);
+    const auto range = states.equal_range (hash);
+    for (auto it = range.first; it != range.second; ++it)
+        if (it->second->getData() == state)
+            return it->second;
+
+    ReferenceCountedObjectPtr<Blob> blob (new Blob (state));
+    states.emplace (hash, blob);
+    added += (int64) blob->getData().getSize();
+    totalSize += (int64) blob->getData().getSize();
+    return blob;
+}
+
+int64 StatePool::share (ValueTree tree)
+{
+    int64 added = 0;
+    if (tree.hasType (types::Node))
+    {
+        for (const auto& id : stateProperties)
+        {
+            const auto& value = tree.getProperty (id);
+            if (dynamic_cast<Blob*> (value.getObject()) != nullptr)
+                continue;
+
+            MemoryBlock state;
+            if (SessionFile::readState (value, state))
+                tree.setProperty (id, var (intern (state, added).get()), nullptr);
+        }
+    }
+
+    for (auto child : tree)
+        added += share (child);
+    return added;
+}
+
+void StatePool::purge()
+{
+    for (auto it = states.begin(); it != states.end();)
+    {
+        // the pool's own reference is the last one.
+        if (it->second->getReferenceCount() == 1)
+        {
+            totalSize -= (int64) it->second->getData().getSize();
+            it = states.erase (it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+} // namespace element
@@ -0,0 +1,54 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <unordered_map>
+
+#include <element/juce/core.hpp>
+#include <element/juce/data_structures.hpp>
+
+namespace element {
+
+/** Keeps plugin states by content, so copies of nodes held for undo share
+    one immutable block per distinct state instead of each keeping its own
+    base64 text.
+
+    Shared states are SessionFile::State values and read back with
+    SessionFile::readState(). A state leaves the pool once nothing else
+    refers to it.
+
+    Message thread only. Trees holding shared states may be read and
+    released on other threads.
+ */
+class StatePool final
+{
+public:
+    StatePool() = default;
+
+    /** Replaces the plugin states of every node in the tree with shared
+        states. Returns the bytes the pool took on, states it already held
+        cost nothing.
+     */
+    juce::int64 share (juce::ValueTree tree);
+
+    /** Returns the number of distinct states held. */
+    int getNumStates() const noexcept { return (int) states.size(); }
+
+    /** Returns the bytes held by distinct states. */
+    juce::int64 getTotalSize() const noexcept { return totalSize; }
+
+    /** Drops states nothing refers to anymore. */
+    void purge();
+
+private:
+    class Blob;
+    std::unordered_multimap<juce::uint64, juce::ReferenceCountedObjectPtr<Blob>> states;
+    juce::int64 totalSize = 0;
+
+    juce::ReferenceCountedObjectPtr<Blob> intern (juce::MemoryBlock& state, juce::int64& added);
+
+    JUCE_DECLARE_NON_COPYABLE (StatePool)
+};
+
+} // namespace element
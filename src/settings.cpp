@@ -22,6 +22,7 @@ const char* Settings::defaultNewSessionFile = "defaultNewSessionFile";
 const char* Settings::generateMidiClockKey = "generateMidiClockKey";
 const char* Settings::sendMidiClockToInputKey = "sendMidiClockToInputKey";
 const char* Settings::hidePluginWindowsWhenFocusLostKey = "hidePluginWindowsWhenFocusLost";
+const char* Settings::releaseMinimisedEditorsKey = "releaseMinimisedEditors";
 const char* Settings::lastGraphKey = "lastGraph";
 const char* Settings::lastSessionKey = "lastSession";
 const char* Settings::legacyInterfaceKey = "legacyInterface";
@@ -41,6 +42,24 @@ const char* Settings::updateKeyTypeKey = "updateKeyType";
 const char* Settings::updateKeyKey = "updateKey";
 const char* Settings::updateKeyUserKey = "updateKeyUserKey";
 const char* Settings::transportStartStopContinue = "transportStartStopContinueKey";
+const char* Settings::renderThreadsKey = "renderThreads";
+const char* Settings::renderQuantumKey = "renderQuantum";
+const char* Settings::flattenSubgraphsKey = "flattenSubgraphs";
+const char* Settings::guardNodeOutputsKey = "guardNodeOutputs";
+const char* Settings::standbyGraphsKey = "standbyGraphs";
+const char* Settings::looperSecondsKey = "looperSeconds";
+const char* Settings::realtimeCoresKey = "realtimeCores";
+const char* Settings::backgroundCoresKey = "backgroundCores";
+const char* Settings::realtimePriorityKey = "realtimePriority";
+const char* Settings::metricsPortKey = "metricsPort";
+const char* Settings::autosaveIntervalKey = "autosaveInterval";
+const char* Settings::sessionCompressionKey = "sessionCompression";
+const char* Settings::undoHistorySizeKey = "undoHistorySize";
+const char* Settings::bridgedPluginsKey = "bridgedPlugins";
+const char* Settings::sharedPluginsKey = "sharedPlugins";
+const char* Settings::warmPluginsKey = "warmPlugins";
+const char* Settings::pluginUsageKey = "pluginUsage";
+const char* Settings::aggregateDevicesKey = "aggregateDevices";
 
 //=============================================================================
 enum OptionsMenuItemId
@@ -52,6 +71,7 @@ enum OptionsMenuItemId
     PluginWindowsOnTop,
     OpenLastUsedSession,
     AskToSaveSessions,
+    ReleaseMinimisedEditors,
 
     MidiInputDevice = 2000000,
     MidiOutputDevice = 3000000,
@@ -87,6 +107,96 @@ const char* Settings::pluginListKey = "pluginList64";
 #endif
 #endif
 
+//=============================================================================
+/** Writes the user settings off the message thread.
+
+    The properties file never saves itself. Changes start a short timer
+    instead, and when it fires a copy of the values is written by a
+    background thread, replacing the file atomically. Only the newest
+    copy waiting is written.
+ */
+class Settings::Writer : private ChangeListener,
+                         private Timer
+{
+public:
+    explicit Writer (PropertiesFile& p) : props (p) { props.addChangeListener (this); }
+
+    ~Writer() override
+    {
+        props.removeChangeListener (this);
+        flush();
+    }
+
+    /** Hands changed values to the background thread. */
+    void submit()
+    {
+        stopTimer();
+        if (! takeChanges())
+            return;
+        pool.addJob ([this]() { writePending(); });
+    }
+
+    /** Writes changed values now, after any write in progress. */
+    void flush()
+    {
+        stopTimer();
+        takeChanges();
+        writePending();
+    }
+
+private:
+    static constexpr int debounceMs = 500;
+
+    PropertiesFile& props;
+    CriticalSection pendingLock, writeLock;
+    std::unique_ptr<StringPairArray> pending;
+    ThreadPool pool { 1 };
+
+    bool takeChanges()
+    {
+        if (! props.needsToBeSaved())
+            return false;
+        auto values = std::make_unique<StringPairArray> (props.getAllProperties());
+        props.setNeedsToBeSaved (false);
+        const ScopedLock sl (pendingLock);
+        pending = std::move (values);
+        return true;
+    }
+
+    void writePending()
+    {
+        const ScopedLock sl (writeLock);
+        std::unique_ptr<StringPairArray> values;
+        {
+            const ScopedLock pl (pendingLock);
+            values = std::move (pending);
+        }
+        if (values == nullptr)
+            return;
+
+        // the same layout PropertiesFile reads, values holding XML are
+        // stored as elements.
+        XmlElement doc ("PROPERTIES");
+        for (int i = 0; i < values->size(); ++i)
+        {
+            auto* e = doc.createNewChildElement ("VALUE");
+            e->setAttribute ("name", values->getAllKeys()[i]);
+            if (auto child = parseXML (values->getAllValues()[i]))
+                e->addChildElement (child.release());
+            else
+                e->setAttribute ("val", values->getAllValues()[i]);
+        }
+
+        // written to a temporary file that then replaces the original.
+        if (! doc.writeTo (props.getFile()))
+            DBG ("[element] could not write settings: " << props.getFile().getFullPathName());
+    }
+
+    void changeListenerCallback (ChangeBroadcaster*) override { startTimer (debounceMs); }
+    void timerCallback() override { submit(); }
+};
+
+//=============================================================================
 Settings::Settings()
 {
     PropertiesFile::Options opts;
@@ -94,6 +204,7 @@ Settings::Settings()
     opts.filenameSuffix = "conf";
     opts.osxLibrarySubFolder = "Application Support";
     opts.storageFormat = PropertiesFile::storeAsXML;
+    opts.millisecondsBeforeSaving = -1;
 
 #if JUCE_DEBUG
     opts.applicationName << "_Debug";
@@ -106,9 +217,26 @@ Settings::Settings()
 #endif
 
     setStorageParameters (opts);
+    if (auto* p = getUserSettings())
+        writer = std::make_unique<Writer> (*p);
 }
 
-Settings::~Settings() {}
+Settings::~Settings()
+{
+    writer.reset();
+}
+
+void Settings::saveIfNeeded()
+{
+    if (writer != nullptr)
+        writer->submit();
+}
+
+void Settings::flush()
+{
+    if (writer != nullptr)
+        writer->flush();
+}
 
 //=============================================================================
 bool Settings::checkForUpdates() const
@@ -299,6 +427,21 @@ void Settings::setHidePluginWindowsWhenFocusLost (const bool hideThem)
         p->setValue (hidePluginWindowsWhenFocusLostKey, hideThem);
 }
 
+bool Settings::releaseMinimisedEditors() const
+{
+    if (auto* p = getProps())
+        return p->getBoolValue (releaseMinimisedEditorsKey, false);
+    return false;
+}
+
+void Settings::setReleaseMinimisedEditors (const bool release)
+{
+    if (release == releaseMinimisedEditors())
+        return;
+    if (auto* p = getProps())
+        p->setValue (releaseMinimisedEditorsKey, release);
+}
+
 bool Settings::useLegacyInterface() const
 {
     if (auto* p = getProps())
@@ -383,6 +526,245 @@ void Settings::setMidiOutLatency (double latencyMs)
         p->setValue (midiOutLatencyKey, latencyMs);
 }
 
+//=============================================================================
+int Settings::getNumRenderThreads() const
+{
+    if (auto* p = getProps())
+        return jlimit (0, 64, p->getIntValue (renderThreadsKey, 0));
+    return 0;
+}
+
+void Settings::setNumRenderThreads (int numThreads)
+{
+    numThreads = jlimit (0, 64, numThreads);
+    if (numThreads == getNumRenderThreads())
+        return;
+    if (auto* p = getProps())
+        p->setValue (renderThreadsKey, numThreads);
+}
+
+int Settings::getRenderQuantum() const
+{
+    if (auto* p = getProps())
+        return jlimit (0, 4096, p->getIntValue (renderQuantumKey, 0));
+    return 0;
+}
+
+void Settings::setRenderQuantum (int numSamples)
+{
+    numSamples = jlimit (0, 4096, numSamples);
+    if (numSamples == getRenderQuantum())
+        return;
+    if (auto* p = getProps())
+        p->setValue (renderQuantumKey, numSamples);
+}
+
+bool Settings::isFlatteningSubgraphs() const
+{
+    if (auto* p = getProps())
+        return p->getBoolValue (flattenSubgraphsKey, false);
+    return false;
+}
+
+void Settings::setFlattenSubgraphs (bool shouldFlatten)
+{
+    if (isFlatteningSubgraphs() == shouldFlatten)
+        return;
+    if (auto* p = getProps())
+        p->setValue (flattenSubgraphsKey, shouldFlatten);
+}
+
+bool Settings::isGuardingNodeOutputs() const
+{
+    if (auto* p = getProps())
+        return p->getBoolValue (guardNodeOutputsKey, false);
+    return false;
+}
+
+void Settings::setGuardNodeOutputs (bool shouldGuard)
+{
+    if (isGuardingNodeOutputs() == shouldGuard)
+        return;
+    if (auto* p = getProps())
+        p->setValue (guardNodeOutputsKey, shouldGuard);
+}
+
+int Settings::getStandbyGraphs() const
+{
+    if (auto* p = getProps())
+        return jlimit (-1, 127, p->getIntValue (standbyGraphsKey, -1));
+    return -1;
+}
+
+void Settings::setStandbyGraphs (int numGraphs)
+{
+    numGraphs = jlimit (-1, 127, numGraphs);
+    if (numGraphs == getStandbyGraphs())
+        return;
+    if (auto* p = getProps())
+        p->setValue (standbyGraphsKey, numGraphs);
+}
+
+int Settings::getLooperSeconds() const
+{
+    if (auto* p = getProps())
+        return jlimit (1, 600, p->getIntValue (looperSecondsKey, 30));
+    return 30;
+}
+
+void Settings::setLooperSeconds (int seconds)
+{
+    seconds = jlimit (1, 600, seconds);
+    if (seconds == getLooperSeconds())
+        return;
+    if (auto* p = getProps())
+        p->setValue (looperSecondsKey, seconds);
+}
+
+String Settings::getRealtimeCores() const
+{
+    if (auto* p = getProps())
+        return p->getValue (realtimeCoresKey, {}).trim();
+    return {};
+}
+
+void Settings::setRealtimeCores (const String& cores)
+{
+    if (getRealtimeCores() == cores.trim())
+        return;
+    if (auto* p = getProps())
+        p->setValue (realtimeCoresKey, cores.trim());
+}
+
+String Settings::getBackgroundCores() const
+{
+    if (auto* p = getProps())
+        return p->getValue (backgroundCoresKey, {}).trim();
+    return {};
+}
+
+void Settings::setBackgroundCores (const String& cores)
+{
+    if (getBackgroundCores() == cores.trim())
+        return;
+    if (auto* p = getProps())
+        p->setValue (backgroundCoresKey, cores.trim());
+}
+
+int Settings::getRealtimePriority() const
+{
+    if (auto* p = getProps())
+        return jlimit (0, 99, p->getIntValue (realtimePriorityKey, 0));
+    return 0;
+}
+
+void Settings::setRealtimePriority (int priority)
+{
+    priority = jlimit (0, 99, priority);
+    if (priority == getRealtimePriority())
+        return;
+    if (auto* p = getProps())
+        p->setValue (realtimePriorityKey, priority);
+}
+
+int Settings::getMetricsPort() const
+{
+    if (auto* p = getProps())
+        return jlimit (0, 65535, p->getIntValue (metricsPortKey, 0));
+    return 0;
+}
+
+void Settings::setMetricsPort (int port)
+{
+    port = jlimit (0, 65535, port);
+    if (port == getMetricsPort())
+        return;
+    if (auto* p = getProps())
+        p->setValue (metricsPortKey, port);
+}
+
+int Settings::getAutosaveInterval() const
+{
+    if (auto* p = getProps())
+        return jlimit (0, 60, p->getIntValue (autosaveIntervalKey, 1));
+    return 1;
+}
+
+void Settings::setAutosaveInterval (int minutes)
+{
+    minutes = jlimit (0, 60, minutes);
+    if (minutes == getAutosaveInterval())
+        return;
+    if (auto* p = getProps())
+        p->setValue (autosaveIntervalKey, minutes);
+}
+
+int Settings::getSessionCompression() const
+{
+    if (auto* p = getProps())
+        return jlimit (0, 9, p->getIntValue (sessionCompressionKey, 1));
+    return 1;
+}
+
+void Settings::setSessionCompression (int level)
+{
+    level = jlimit (0, 9, level);
+    if (level == getSessionCompression())
+        return;
+    if (auto* p = getProps())
+        p->setValue (sessionCompressionKey, level);
+}
+
+int Settings::getUndoHistorySize() const
+{
+    if (auto* p = getProps())
+        return jlimit (1, 1024, p->getIntValue (undoHistorySizeKey, 64));
+    return 64;
+}
+
+void Settings::setUndoHistorySize (int megabytes)
+{
+    megabytes = jlimit (1, 1024, megabytes);
+    if (megabytes == getUndoHistorySize())
+        return;
+    if (auto* p = getProps())
+        p->setValue (undoHistorySizeKey, megabytes);
+}
+
+int Settings::getWarmPluginCount() const
+{
+    if (auto* p = getProps())
+        return jlimit (0, 16, p->getIntValue (warmPluginsKey, 4));
+    return 4;
+}
+
+void Settings::setWarmPluginCount (int count)
+{
+    count = jlimit (0, 16, count);
+    if (count == getWarmPluginCount())
+        return;
+    if (auto* p = getProps())
+        p->setValue (warmPluginsKey, count);
+}
+
+StringArray Settings::getAggregateDevices() const
+{
+    StringArray names;
+    if (auto* p = getProps())
+        names.addLines (p->getValue (aggregateDevicesKey));
+    names.trim();
+    names.removeEmptyStrings();
+    return names;
+}
+
+void Settings::setAggregateDevices (const StringArray& names)
+{
+    if (names == getAggregateDevices())
+        return;
+    if (auto* p = getProps())
+        p->setValue (aggregateDevicesKey, names.joinIntoString ("\n"));
+}
+
 //=============================================================================
 double Settings::getDesktopScale() const
 {
@@ -539,6 +921,7 @@ void Settings::addItemsToMenu (Context& world, PopupMenu& menu)
     sub.addItem (AutomaticallyShowPluginWindows, "Automatically Show Plugin Windows", true, showPluginWindowsWhenAdded());
     sub.addItem (PluginWindowsOnTop, "Plugins On Top By Default", true, pluginWindowsOnTop());
     sub.addItem (HidePluginWindowsWhenFocusLost, "Hide Plugin Windows When App Inactive", true, hidePluginWindowsWhenFocusLost());
+    sub.addItem (ReleaseMinimisedEditors, "Close Editors of Minimised Plugin Windows", true, releaseMinimisedEditors());
 
     sub.addSeparator(); // session items
 
@@ -636,6 +1019,9 @@ bool Settings::performMenuResult (Context& world, const int result)
         case HidePluginWindowsWhenFocusLost:
             setHidePluginWindowsWhenFocusLost (! hidePluginWindowsWhenFocusLost());
             break;
+        case ReleaseMinimisedEditors:
+            setReleaseMinimisedEditors (! releaseMinimisedEditors());
+            break;
         case OpenLastUsedSession:
             setOpenLastUsedSession (! openLastUsedSession());
             break;
@@ -0,0 +1,208 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <lv2/atom/atom.h>
+#include <lv2/buf-size/buf-size.h>
+#include <lv2/midi/midi.h>
+#include <lv2/options/options.h>
+#include <lv2/parameters/parameters.h>
+#include <lv2/patch/patch.h>
+#include <lv2/time/time.h>
+#include <lv2/ui/ui.h>
+
+#include <element/symbolmap.hpp>
+
+namespace element {
+namespace detail {
+
+/** URIs nearly every plugin maps, they get the first URIDs. */
+static const char* const wellKnownURIs[] = {
+    LV2_ATOM__Atom, LV2_ATOM__AtomPort, LV2_ATOM__Blank, LV2_ATOM__Bool,
+    LV2_ATOM__Chunk, LV2_ATOM__Double, LV2_ATOM__Float, LV2_ATOM__Int,
+    LV2_ATOM__Long, LV2_ATOM__Object, LV2_ATOM__Path, LV2_ATOM__Property,
+    LV2_ATOM__Resource, LV2_ATOM__Sequence, LV2_ATOM__String, LV2_ATOM__Tuple,
+    LV2_ATOM__URI, LV2_ATOM__URID, LV2_ATOM__Vector, LV2_ATOM__atomTransfer,
+    LV2_ATOM__beatTime, LV2_ATOM__eventTransfer, LV2_ATOM__frameTime,
+    LV2_BUF_SIZE__maxBlockLength, LV2_BUF_SIZE__minBlockLength,
+    LV2_BUF_SIZE__nominalBlockLength, LV2_BUF_SIZE__sequenceSize,
+    LV2_MIDI__MidiEvent,
+    LV2_OPTIONS__interface, LV2_OPTIONS__options,
+    LV2_PARAMETERS__sampleRate,
+    LV2_PATCH__Get, LV2_PATCH__Set, LV2_PATCH__property, LV2_PATCH__value,
+    LV2_PATCH__subject, LV2_PATCH__writable, LV2_PATCH__readable,
+    LV2_TIME__Position, LV2_TIME__bar, LV2_TIME__barBeat, LV2_TIME__beat,
+    LV2_TIME__beatUnit, LV2_TIME__beatsPerBar, LV2_TIME__beatsPerMinute,
+    LV2_TIME__frame, LV2_TIME__speed,
+    LV2_UI__floatProtocol
+};
+
+static uint64_t hashURI (const char* str) noexcept
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (; *str != 0; ++str)
+        hash = (hash ^ (uint8_t) *str) * 1099511628211ull;
+    return hash;
+}
+
+} // namespace detail
+
+//==============================================================================
+struct SymbolMap::Tables
+{
+    static constexpr uint32_t numShards = 16;
+    static constexpr uint32_t numBuckets = 256; // per shard
+    static constexpr uint32_t segmentSize = 1024;
+    static constexpr uint32_t numSegments = 4096;
+
+    /** A mapped URI. Never changes or moves once published. */
+    struct Entry
+    {
+        uint64_t hash;
+        uint32_t urid;
+        Entry* next;
+        std::string uri;
+    };
+
+    /** Chains only grow, readers follow them without the lock. */
+    struct Shard
+    {
+        std::mutex lock;
+        std::atomic<Entry*> buckets[numBuckets] {};
+        std::vector<std::unique_ptr<Entry>> entries;
+    };
+
+    Shard shards[numShards];
+    std::atomic<std::atomic<Entry*>*> segments[numSegments] {};
+    std::atomic<uint32_t> count { 0 };
+
+    ~Tables()
+    {
+        for (auto& segment : segments)
+            delete[] segment.load();
+    }
+
+    static const Entry* find (const std::atomic<Entry*>& bucket, uint64_t hash, const char* uri) noexcept
+    {
+        for (auto* e = bucket.load (std::memory_order_acquire); e != nullptr; e = e->next)
+            if (e->hash == hash && std::strcmp (e->uri.c_str(), uri) == 0)
+                return e;
+        return nullptr;
+    }
+
+    uint32_t map (const char* uri)
+    {
+        const auto hash = detail::hashURI (uri);
+        auto& shard = shards[hash % numShards];
+        auto& bucket = shard.buckets[(hash / numShards) % numBuckets];
+
+        if (auto* e = find (bucket, hash, uri))
+            return e->urid;
+
+        std::lock_guard<std::mutex> sl (shard.lock);
+        if (auto* e = find (bucket, hash, uri))
+            return e->urid;
+
+        // other shards take ids at the same time, so they're not in order
+        // of being published. unmap() returns null for one that isn't yet.
+        const auto index = count.fetch_add (1, std::memory_order_acq_rel);
+        auto* const slots = getSegment (index / segmentSize);
+        if (slots == nullptr)
+            return 0;
+
+        shard.entries.push_back (std::make_unique<Entry> (Entry { hash, index + 1, bucket.load(), uri }));
+        auto* const e = shard.entries.back().get();
+        slots[index % segmentSize].store (e, std::memory_order_release);
+        bucket.store (e, std::memory_order_release);
+        return e->urid;
+    }
+
+    std::atomic<Entry*>* getSegment (uint32_t segmentIndex)
+    {
+        if (segmentIndex >= numSegments)
+            return nullptr;
+
+        auto& segment = segments[segmentIndex];
+        auto* slots = segment.load (std::memory_order_acquire);
+        if (slots != nullptr)
+            return slots;
+
+        auto* const fresh = new std::atomic<Entry*>[segmentSize] {};
+        if (segment.compare_exchange_strong (slots, fresh, std::memory_order_acq_rel))
+            return fresh;
+
+        delete[] fresh;
+        return slots;
+    }
+
+    const char* unmap (uint32_t urid) const noexcept
+    {
+        if (urid == 0 || urid > segmentSize * numSegments)
+            return nullptr;
+
+        const auto index = urid - 1;
+        const auto* slots = segments[index / segmentSize].load (std::memory_order_acquire);
+        const auto* e = slots != nullptr ? slots[index % segmentSize].load (std::memory_order_acquire) : nullptr;
+        return e != nullptr ? e->uri.c_str() : nullptr;
+    }
+};
+
+//==============================================================================
+static uint32_t mapURI (LV2_URID_Map_Handle handle, const char* uri)
+{
+    return static_cast<SymbolMap*> (handle)->map (uri);
+}
+
+static const char* unmapURID (LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+    return static_cast<const SymbolMap*> (handle)->unmap (urid);
+}
+
+SymbolMap::SymbolMap()
+    : tables (std::make_unique<Tables>())
+{
+    mapData = { this, mapURI };
+    unmapData = { this, unmapURID };
+    mapFeat = { LV2_URID__map, &mapData };
+    unmapFeat = { LV2_URID__unmap, &unmapData };
+
+    for (const auto* uri : detail::wellKnownURIs)
+        map (uri);
+}
+
+SymbolMap::~SymbolMap() = default;
+
+const uint32_t SymbolMap::map (const char* str) noexcept
+{
+    if (str == nullptr)
+        return 0;
+
+    try
+    {
+        return tables->map (str);
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+const char* SymbolMap::unmap (uint32_t urid) const noexcept
+{
+    return tables->unmap (urid);
+}
+
+uint32_t SymbolMap::size() const noexcept
+{
+    return std::min (tables->count.load (std::memory_order_acquire),
+                     Tables::segmentSize * Tables::numSegments);
+}
+
+} // namespace element
@@ -1,10 +1,38 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <algorithm>
+
 #include <element/timescale.hpp>
 
 namespace element {
 
+namespace detail {
+/** Returns the last item at or before key, the first if none are. Checks
+    the current item and the one after it before searching, so cursors
+    moving forward a little at a time don't search at all.
+ */
+template <typename Item, typename Key, typename KeyOf>
+static Item* seek (const std::vector<Item*>& index, Item*& current, Key key, KeyOf keyOf)
+{
+    if (index.empty())
+        return current = nullptr;
+
+    if (current != nullptr && keyOf (current) <= key)
+    {
+        Item* next = current->next();
+        if (next == nullptr || key < keyOf (next))
+            return current;
+        Item* after = next->next();
+        if (after == nullptr || key < keyOf (after))
+            return current = next;
+    }
+
+    auto it = std::upper_bound (index.begin(), index.end(), key, [&keyOf] (Key k, Item* item) { return k < keyOf (item); });
+    return current = (it == index.begin() ? index.front() : *(it - 1));
+}
+} // namespace detail
+
 void TimeScale::reset()
 {
     mNodes.setScoped (true);
@@ -12,10 +40,12 @@ void TimeScale::reset()
 
     // Clear/reset location-markers...
     mMarkers.clear();
+    updateMarkerIndex();
     mMarkerCursor.reset();
 
     // Clear/reset tempo-map...
     mNodes.clear();
+    updateNodeIndex();
     mCursor.reset();
 
     // There must always be one node, always.
@@ -56,6 +86,7 @@ void TimeScale::sync (const TimeScale& ts)
         mMarkers.append (new Marker (*other_marker));
         other_marker = other_marker->next();
     }
+    updateMarkerIndex();
 
     mMarkerCursor.reset();
 
@@ -67,6 +98,7 @@ void TimeScale::sync (const TimeScale& ts)
         mNodes.append (new Node (this, other->frame, other->tempo, other->beatType, other->beatsPerBar, other->beatDivisor));
         other = other->next();
     }
+    updateNodeIndex();
 
     mCursor.reset();
     updateScale();
@@ -164,137 +196,27 @@ void TimeScale::Cursor::reset (TimeScale::Node* n)
 
 TimeScale::Node* TimeScale::Cursor::seekFrame (uint64_t iFrame) const
 {
-    if (node == 0)
-    {
-        node = ts->nodes().first();
-        if (node == 0)
-            return 0;
-    }
-
-    if (iFrame > node->frame)
-    {
-        // Seek frame forward...
-        while (node && node->next() && iFrame >= (node->next())->frame)
-            node = node->next();
-    }
-    else if (iFrame < node->frame)
-    {
-        // Seek frame backward...
-        while (node && node->frame > iFrame)
-            node = node->prev();
-        if (node == 0)
-            node = ts->nodes().first();
-    }
-
-    return node;
+    return detail::seek (ts->mNodeIndex, node, iFrame, [] (const Node* n) { return n->frame; });
 }
 
 TimeScale::Node* TimeScale::Cursor::seekBar (unsigned short sbar) const
 {
-    if (node == 0)
-    {
-        node = ts->nodes().first();
-        if (node == 0)
-            return 0;
-    }
-
-    if (sbar > node->bar)
-    {
-        // Seek bar forward...
-        while (node && node->next() && sbar >= (node->next())->bar)
-            node = node->next();
-    }
-    else if (sbar < node->bar)
-    {
-        // Seek bar backward...
-        while (node && node->bar > sbar)
-            node = node->prev();
-        if (node == 0)
-            node = ts->nodes().first();
-    }
-
-    return node;
+    return detail::seek (ts->mNodeIndex, node, sbar, [] (const Node* n) { return n->bar; });
 }
 
 TimeScale::Node* TimeScale::Cursor::seekBeat (unsigned int sbeat) const
 {
-    if (node == 0)
-    {
-        node = ts->nodes().first();
-        if (node == 0)
-            return 0;
-    }
-
-    if (sbeat > node->beat)
-    {
-        // Seek beat forward...
-        while (node && node->next() && sbeat >= (node->next())->beat)
-            node = node->next();
-    }
-    else if (sbeat < node->beat)
-    {
-        // Seek beat backward...
-        while (node && node->beat > sbeat)
-            node = node->prev();
-        if (node == 0)
-            node = ts->nodes().first();
-    }
-
-    return node;
+    return detail::seek (ts->mNodeIndex, node, sbeat, [] (const Node* n) { return n->beat; });
 }
 
 TimeScale::Node* TimeScale::Cursor::seekTick (uint64_t stick) const
 {
-    if (node == 0)
-    {
-        node = ts->nodes().first();
-        if (node == 0)
-            return 0;
-    }
-
-    if (stick > node->tick)
-    {
-        // Seek tick forward...
-        while (node && node->next() && stick >= (node->next())->tick)
-            node = node->next();
-    }
-    else if (stick < node->tick)
-    {
-        // Seek tick backward...
-        while (node && node->tick > stick)
-            node = node->prev();
-        if (node == 0)
-            node = ts->nodes().first();
-    }
-
-    return node;
+    return detail::seek (ts->mNodeIndex, node, stick, [] (const Node* n) { return n->tick; });
 }
 
 TimeScale::Node* TimeScale::Cursor::seekPixel (int px) const
 {
-    if (node == 0)
-    {
-        node = ts->nodes().first();
-        if (node == 0)
-            return 0;
-    }
-
-    if (px > node->pixel)
-    {
-        // Seek pixel forward...
-        while (node && node->next() && px >= (node->next())->pixel)
-            node = node->next();
-    }
-    else if (px < node->pixel)
-    {
-        // Seek tick backward...
-        while (node && node->pixel > px)
-            node = node->prev();
-        if (node == 0)
-            node = ts->nodes().first();
-    }
-
-    return node;
+    return detail::seek (ts->mNodeIndex, node, px, [] (const Node* n) { return n->pixel; });
 }
 
 TimeScale::Node* TimeScale::addNode (uint64_t frame_, float tempo_, unsigned short beat_type_, unsigned short beats_per_bar_, unsigned short beat_divisor_)
@@ -347,6 +269,7 @@ TimeScale::Node* TimeScale::addNode (uint64_t frame_, float tempo_, unsigned sho
             mNodes.insertAfter (node, prev);
         else
             mNodes.append (node);
+        updateNodeIndex();
     }
 
     // Update coefficients and positioning thereafter...
@@ -403,6 +326,7 @@ void TimeScale::removeNode (TimeScale::Node* node)
 
     // Actually remove/unlink the node...
     mNodes.remove (node);
+    updateNodeIndex();
 
     // Then update marker/bar positions too...
     updateMarkers (prev);
@@ -504,29 +428,7 @@ void TimeScale::MarkerCursor::reset (TimeScale::Marker* m)
 // Location marker seek methods.
 TimeScale::Marker* TimeScale::MarkerCursor::seekFrame (uint64_t iFrame)
 {
-    if (marker == 0)
-    {
-        marker = ts->markers().first();
-        if (marker == 0)
-            return 0;
-    }
-
-    if (iFrame > marker->frame)
-    {
-        // Seek frame forward...
-        while (marker && marker->next() && iFrame >= (marker->next())->frame)
-            marker = marker->next();
-    }
-    else if (iFrame < marker->frame)
-    {
-        // Seek frame backward...
-        while (marker && marker->frame > iFrame)
-            marker = marker->prev();
-        if (marker == 0)
-            marker = ts->markers().first();
-    }
-
-    return marker;
+    return detail::seek (ts->mMarkerIndex, marker, iFrame, [] (const Marker* m) { return m->frame; });
 }
 
 TimeScale::Marker* TimeScale::MarkerCursor::seekBar (unsigned short iBar)
@@ -587,6 +489,7 @@ TimeScale::Marker* TimeScale::addMarker (uint64_t target_frame, const std::strin
             mMarkers.insertAfter (marker, nearest_marker);
         else
             mMarkers.append (marker);
+        updateMarkerIndex();
     }
 
     // Update positioning...
@@ -607,9 +510,24 @@ void TimeScale::removeMarker (TimeScale::Marker* pMarker)
     // and relocate internal cursor...
     Marker* pMarkerPrev = pMarker->prev();
     mMarkers.remove (pMarker);
+    updateMarkerIndex();
     mMarkerCursor.reset (pMarkerPrev);
 }
 
+void TimeScale::updateNodeIndex()
+{
+    mNodeIndex.clear();
+    for (Node* node = mNodes.first(); node != nullptr; node = node->next())
+        mNodeIndex.push_back (node);
+}
+
+void TimeScale::updateMarkerIndex()
+{
+    mMarkerIndex.clear();
+    for (Marker* marker = mMarkers.first(); marker != nullptr; marker = marker->next())
+        mMarkerIndex.push_back (marker);
+}
+
 // Update markers from given node position.
 void TimeScale::updateMarkers (TimeScale::Node* pNode)
 {
@@ -764,9 +764,30 @@ Rectangle<int> BlockComponent::getCornerResizeBox() const
     return { r.getRight() - 14, r.getBottom() - 14, 12, 12 };
 }
 
+void BlockComponent::updateProfileOverlay()
+{
+    const bool profiling = obj != nullptr && obj->isProfilingEnabled();
+    if (profiling || showingProfile)
+        repaint();
+    showingProfile = profiling;
+}
+
 void BlockComponent::paintOverChildren (Graphics& g)
 {
-    ignoreUnused (g);
+    if (obj == nullptr || ! obj->isProfilingEnabled())
+        return;
+
+    const auto stats = obj->getProcessStats();
+    String text;
+    text << String (stats.average, 1) << " us  p95 " << String (stats.p95, 1)
+         << " us  " << String (stats.load * 100.0, 1) << "%";
+
+    auto r = getBoxRectangle().removeFromBottom (13).reduced (1);
+    g.setColour (Colours::black.withAlpha (0.65f));
+    g.fillRect (r);
+    g.setColour (Colours::white);
+    g.setFont (Font (9.f));
+    g.drawFittedText (text, r, Justification::centred, 1);
 }
 
 void BlockComponent::paint (Graphics& g)
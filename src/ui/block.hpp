@@ -219,6 +219,10 @@ public:
     /** Returns the config button */
     SettingButton& getMuteButton() { return muteButton; }
 
+    //=========================================================================
+    /** Repaint the CPU usage overlay if the node is being profiled. */
+    void updateProfileOverlay();
+
     //=========================================================================
     /** Gets the coordinate of the port index 
         Returns true if the coords were acquired.
@@ -294,6 +298,7 @@ private:
     bool dragging = false;
     bool blockDrag = false;
     bool collapsed = false;
+    bool showingProfile = false;
 
     int lastDragDeltaX = 0;
     int lastDragDeltaY = 0;
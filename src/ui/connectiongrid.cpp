@@ -80,32 +80,23 @@ public:
             grid->repaint();
     }
 
-    void mouseMove (const MouseEvent& ev) override
-    {
-        PatchMatrixComponent::mouseMove (ev);
-
-        if (useHighlighting)
-            repaint();
-    }
-
     void paintMatrixCell (Graphics& g, const int width, const int height, const int row, const int column) override
     {
-        const Node src (getNode (row, true));
-        const Node dst (getNode (column, false));
+        const bool connected = matrix.connected (row, column);
 
-        if (useHighlighting && (mouseIsOverCell (row, column) && ! matrix.connected (row, column)))
+        if (useHighlighting && (mouseIsOverCell (row, column) && ! connected))
         {
             g.setColour (Colors::elemental.withAlpha (0.4f));
             g.fillRect (0, 0, width - gridPadding, height - gridPadding);
         }
-        else if ((mouseIsOverRow (row) || mouseIsOverColumn (column)) && ! matrix.connected (row, column))
+        else if ((mouseIsOverRow (row) || mouseIsOverColumn (column)) && ! connected)
         {
             g.setColour (Colors::elemental.withAlpha (0.3f));
             g.fillRect (0, 0, width - gridPadding, height - gridPadding);
         }
         else
         {
-            g.setColour (matrix.connected (row, column)
+            g.setColour (connected
                              ? Colour (Colors::elemental.brighter())
                              : Colour (LookAndFeel_E1::defaultMatrixCellOffColor));
             g.fillRect (0, 0, width - gridPadding, height - gridPadding);
@@ -129,7 +120,7 @@ public:
         if (! srcNode.canConnectTo (dstNode))
         {
             matrix.disconnect (row, col);
-            repaint();
+            repaintCell (row, col);
             return;
         }
 
@@ -154,7 +145,7 @@ public:
             connectPorts (srcPort, dstPort);
         }
 
-        repaint();
+        repaintCell (row, col);
     }
 
     void matrixBackgroundClicked (const MouseEvent& ev) override
@@ -242,6 +233,12 @@ private:
 
     void matrixHoveredCellChanged (const int prevRow, const int prevCol, const int newRow, const int newCol) override
     {
+        // hover highlights the row and column under the mouse.
+        repaintRow (prevRow);
+        repaintRow (newRow);
+        repaintColumn (prevCol);
+        repaintColumn (newCol);
+
         auto* quads = findParentComponentOfClass<QuadrantLayout>();
         if (auto* sources = dynamic_cast<ListBox*> (quads->getQauadrantComponent (QuadrantLayout::Q2)))
         {
@@ -1,6 +1,8 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <deque>
+
 #include "ui/console.hpp"
 #include <element/ui/style.hpp>
 
@@ -117,6 +119,14 @@ public:
     {
         buffer.clear();
         buffer.moveCaretToEnd();
+        lineLengths.clear();
+        numLines = 0;
+    }
+
+    void setMaxLines (int newMax)
+    {
+        maxLines = jmax (1, newMax);
+        trimBuffer();
     }
 
     void clearHistory()
@@ -132,10 +142,16 @@ public:
             line << " ";
         line << text;
 
+        // as the editor stores it, so lengths match when trimming.
+        line = line.trimEnd().replace ("\r\n", "\n") + "\n";
         buffer.moveCaretToEnd();
-        buffer.insertTextAtCaret (line.trimEnd());
-        buffer.insertTextAtCaret (newLine);
+        buffer.insertTextAtCaret (line);
         buffer.moveCaretToEnd();
+
+        // each call may hold several lines, trim by calls.
+        lineLengths.push_back ({ line.length(), jmax (1, line.retainCharacters ("\n").length()) });
+        numLines += lineLengths.back().second;
+        trimBuffer();
     }
 
     void setPromptVisible (bool visible)
@@ -168,6 +184,27 @@ private:
     StringArray history;
     int historyPos { 0 };
 
+    int maxLines { 2000 }, numLines { 0 };
+    std::deque<std::pair<int, int>> lineLengths; // characters and lines per addText
+
+    void trimBuffer()
+    {
+        int numToRemove = 0;
+        while (numLines > maxLines && lineLengths.size() > 1)
+        {
+            numToRemove += lineLengths.front().first;
+            numLines -= lineLengths.front().second;
+            lineLengths.pop_front();
+        }
+
+        if (numToRemove <= 0)
+            return;
+
+        buffer.setHighlightedRegion ({ 0, numToRemove });
+        buffer.insertTextAtCaret ({});
+        buffer.moveCaretToEnd();
+    }
+
     void addToHistory (const String& text)
     {
         if (history.isEmpty() || (history.size() > 0 && text != history.getReference (history.size() - 1)))
@@ -231,6 +268,11 @@ void Console::setPromptVisible (bool visible)
     content->setPromptVisible (visible);
 }
 
+void Console::setMaxLines (int maxLines)
+{
+    content->setMaxLines (maxLines);
+}
+
 void Console::addText (const String& text, bool prefix)
 {
     content->addText (text, prefix);
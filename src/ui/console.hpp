@@ -28,6 +28,9 @@ public:
     /** Show or hide the text prompt */
     void setPromptVisible (bool visible);
 
+    /** Sets how many lines the display buffer keeps, the oldest go first */
+    void setMaxLines (int maxLines);
+
     /** Override this to handle when text is entered on the prompt. The default
         implementation just adds entered text to the display buffer */
     virtual void textEntered (const String& text);
@@ -18,6 +18,7 @@
 #include "ui/mainmenu.hpp"
 #include "ui/tempoandmeterbar.hpp"
 #include "ui/transportbar.hpp"
+#include "ui/uiactivity.hpp"
 #include "ui/viewhelpers.hpp"
 
 namespace element {
@@ -50,7 +51,8 @@ bool ContentView::keyPressed (const KeyPress& k)
 //=============================================================================
 class Content::Toolbar : public Component,
                          public Button::Listener,
-                         public Timer
+                         public Timer,
+                         private UIActivity::Listener
 {
 public:
     Toolbar (Content& o)
@@ -78,13 +80,13 @@ public:
             addAndMakeVisible (pluginMenu);
 
         addAndMakeVisible (midiBlinker);
+        activity->addListener (this);
     }
 
     ~Toolbar()
     {
-        for (const auto& conn : connections)
-            conn.disconnect();
-        connections.clear();
+        activity->removeListener (this);
+        disconnectMidiMonitor();
     }
 
     void setSession (SessionPtr s)
@@ -98,10 +100,7 @@ public:
         if (midiIOMonitor == nullptr)
         {
             midiIOMonitor = engine->getMidiIOMonitor();
-            connections.add (midiIOMonitor->sigSent.connect (
-                std::bind (&MidiBlinker::triggerSent, &midiBlinker)));
-            connections.add (midiIOMonitor->sigReceived.connect (
-                std::bind (&MidiBlinker::triggerReceived, &midiBlinker)));
+            uiActivityChanged (activity->isActive());
         }
 
         auto* props = settings.getUserSettings();
@@ -215,6 +214,27 @@ private:
     IconButton pluginMenu;
     MidiBlinker midiBlinker;
     Array<SignalConnection> connections;
+    SharedResourcePointer<UIActivity> activity;
+
+    // the blinker listens only while it can be seen, so the monitor can stop.
+    void uiActivityChanged (bool isActive) override
+    {
+        disconnectMidiMonitor();
+        if (isActive && midiIOMonitor != nullptr)
+        {
+            connections.add (midiIOMonitor->onSent (
+                std::bind (&MidiBlinker::triggerSent, &midiBlinker)));
+            connections.add (midiIOMonitor->onReceived (
+                std::bind (&MidiBlinker::triggerReceived, &midiBlinker)));
+        }
+    }
+
+    void disconnectMidiMonitor()
+    {
+        for (const auto& conn : connections)
+            conn.disconnect();
+        connections.clear();
+    }
 
     void runPluginMenu()
     {
@@ -227,7 +247,8 @@ private:
 
 class Content::StatusBar : public Component,
                            public Value::Listener,
-                           private Timer
+                           private Timer,
+                           private UIActivity::Listener
 {
 public:
     StatusBar (Context& g)
@@ -254,12 +275,14 @@ public:
             }
         }
 
-        startTimer (2000);
+        activity->addListener (this);
+        uiActivityChanged (activity->isActive());
         updateLabels();
     }
 
     ~StatusBar()
     {
+        activity->removeListener (this);
         latencySamplesChangedConnection.disconnect();
         sampleRate.removeListener (this);
         streamingStatus.removeListener (this);
@@ -311,6 +334,12 @@ public:
             if (strText.isEmpty())
                 strText = "Running";
             text << "Engine: " << strText << ":  CPU: " << String (devices.getCpuUsage() * 100.f, 1) << "%";
+            if (engine != nullptr)
+            {
+                const auto t = engine->getTelemetry();
+                text << ":  Xruns: " << String (t.xruns >= 0 ? t.xruns : t.lateCallbacks)
+                     << ":  Jitter: " << String (t.jitterMs, 2) << " ms";
+            }
             streamingStatusLabel.setText (text, dontSendNotification);
 
             statusLabel.setText (String ("Device: ") + dev->getName(), dontSendNotification);
@@ -354,12 +383,21 @@ private:
     Value sampleRate, streamingStatus, status;
 
     SignalConnection latencySamplesChangedConnection;
+    SharedResourcePointer<UIActivity> activity;
 
     friend class Timer;
     void timerCallback() override
     {
         updateLabels();
     }
+
+    void uiActivityChanged (bool isActive) override
+    {
+        if (isActive)
+            startTimer (2000);
+        else
+            stopTimer();
+    }
 };
 
 struct Content::Tooltips
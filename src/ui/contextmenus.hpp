@@ -182,6 +182,9 @@ public:
         int index = 30000;
         ProcessorPtr ptr = node.getObject();
         menu.addItem (index++, "Mute input ports", ptr != nullptr, ptr && ptr->isMutingInputs());
+        menu.addItem (index++, "Show CPU usage", ptr != nullptr, ptr && ptr->isProfilingEnabled());
+        if (node.isGraph() && ! node.isRootGraph())
+            addItemInternal (menu, "Freeze", new FreezeGraphOp (node));
         addOversamplingSubmenu (menu);
         addSubMenu (TRANS ("Options"), menu, ptr != nullptr);
 #endif
@@ -213,6 +216,9 @@ public:
         osMenu.addItem (index++, "2x", true, ptr->getOversamplingFactor() == 2);
         osMenu.addItem (index++, "4x", true, ptr->getOversamplingFactor() == 4);
         osMenu.addItem (index++, "8x", true, ptr->getOversamplingFactor() == 8);
+        osMenu.addItem (index++, "16x", true, ptr->getOversamplingFactor() == 16);
+        osMenu.addSeparator();
+        osMenu.addItem (40010, "Linear Phase", true, ptr->isLinearPhaseOversampling());
 
         menuToAddTo.addSubMenu ("Oversample", osMenu);
     }
@@ -355,8 +361,17 @@ public:
                 case 0:
                     node.setMuteInput (! node.isMutingInputs());
                     break;
+                case 1:
+                    if (auto obj = node.getObject())
+                        obj->setProfilingEnabled (! obj->isProfilingEnabled());
+                    break;
             }
         }
+        else if (result == 40010)
+        {
+            if (auto gNode = node.getObject())
+                gNode->setLinearPhaseOversampling (! gNode->isLinearPhaseOversampling());
+        }
         else if (result >= 40000 && result < 50000)
         {
             const int osFactor = (int) powf (2, float (result - 40000));
@@ -427,6 +442,54 @@ private:
         }
     };
 
+    struct FreezeGraphOp : public ResultOp
+    {
+        FreezeGraphOp (const Node& n) : node (n) {}
+        const Node node;
+
+        GraphNode* getGraph() const
+        {
+            auto* const graph = dynamic_cast<GraphNode*> (node.getObject());
+            return graph != nullptr && graph->isSubGraph() ? graph : nullptr;
+        }
+
+        bool isActive() override { return getGraph() != nullptr; }
+        bool isTicked() override
+        {
+            auto* const graph = getGraph();
+            return graph != nullptr && graph->isFrozen();
+        }
+
+        bool perform() override
+        {
+            auto* const graph = getGraph();
+            if (graph == nullptr)
+                return false;
+
+            if (graph->isFrozen())
+            {
+                graph->unfreeze();
+                return true;
+            }
+
+            AlertWindow win ("Freeze Graph", "Seconds to render from the start of the timeline:", AlertWindow::NoIcon, nullptr);
+            win.addTextEditor ("seconds", "60", "", false);
+            win.addButton ("Freeze", 1, KeyPress (KeyPress::returnKey));
+            win.addButton ("Cancel", 0, KeyPress (KeyPress::escapeKey));
+            if (1 != win.runModalLoop())
+                return true;
+
+            const auto seconds = win.getTextEditorContents ("seconds").getDoubleValue();
+            const auto file = DataPath::defaultFreezeCacheDir()
+                                  .getChildFile (Uuid().toString())
+                                  .withFileExtension ("wav");
+            const auto result = graph->freeze (file, (int64) (seconds * graph->getSampleRate()));
+            if (result.failed())
+                AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, "Freeze Graph", result.getErrorMessage());
+            return true;
+        }
+    };
+
     struct SingleConnectOp : public ResultOp
     {
         SingleConnectOp (const Node& sn, const Port& sp, const Node& dn, const Port& dp)
@@ -473,8 +473,10 @@ private:
             }
             else if (control.isControllerEvent())
             {
-                text = "CC ";
+                text = control.getResolution() == Control::resolutionNRPN ? "NRPN " : "CC ";
                 text << control.getEventId();
+                if (control.getResolution() == Control::resolution14Bit)
+                    text << "/" << (control.getEventId() + 32);
             }
 
             status.setText (text, dontSendNotification);
@@ -628,7 +630,7 @@ public:
         {
             controls.updateContent();
         }
-        else if (value.refersToSameSourceAs (eventType))
+        else if (value.refersToSameSourceAs (eventType) || value.refersToSameSourceAs (resolution))
         {
             triggerAsyncUpdate();
         }
@@ -799,6 +801,7 @@ public:
         inputDevice.removeListener (this);
         controlName.removeListener (this);
         eventType.removeListener (this);
+        resolution.removeListener (this);
         eventId.removeListener (this);
         toggleMode.removeListener (this);
         momentary.removeListener (this);
@@ -875,8 +878,22 @@ public:
                                                     { "Omni", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15", "16" },
                                                     { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 }));
 
+            if (control.isControllerEvent())
+            {
+                resolution = control.getPropertyAsValue ("resolution");
+                props.add (new ChoicePropertyComponent (resolution, "Resolution", { "7-bit", "14-bit (MSB + LSB)", "NRPN" }, { var ("7bit"), var ("14bit"), var ("nrpn") }));
+
+                if (control.getResolution() == Control::resolution14Bit)
+                    eventName = "MSB CC Number";
+                else if (control.getResolution() == Control::resolutionNRPN)
+                    eventName = "NRPN Number";
+            }
+
+            const double maxEventId = control.isHighResolution()
+                                          ? (control.getResolution() == Control::resolutionNRPN ? 16383.0 : 31.0)
+                                          : 127.0;
             eventId = control.getPropertyAsValue ("eventId");
-            props.add (new SliderPropertyComponent (eventId, eventName, 0.0, 127.0, 1.0));
+            props.add (new SliderPropertyComponent (eventId, eventName, 0.0, maxEventId, 1.0));
 
             if (control.isControllerEvent())
             {
@@ -909,6 +926,7 @@ public:
         inputDevice.addListener (this);
         deviceName.addListener (this);
         eventType.addListener (this);
+        resolution.addListener (this);
         eventId.addListener (this);
         toggleMode.addListener (this);
         momentary.addListener (this);
@@ -1031,7 +1049,7 @@ private:
     ControllerMapsTable maps;
     SessionPtr session;
     Value deviceName, inputDevice, controlName;
-    Value eventType, eventId, toggleMode;
+    Value eventType, eventId, toggleMode, resolution;
     Value momentary;
 
     int mappingsSize = 150;
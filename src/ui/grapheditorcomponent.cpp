@@ -1,6 +1,11 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <tuple>
+
 #include <element/ui/popups.hpp>
 #include <element/node.hpp>
 #include <element/plugins.hpp>
@@ -217,6 +222,14 @@ public:
 
     void paint (Graphics& g) override
     {
+        // only connectors on screen get painted, so only they pay for the stroke.
+        if (strokeDirty)
+        {
+            PathStrokeType (2.5f).createStrokedPath (linePath, curve);
+            linePath.setUsingNonZeroWinding (true);
+            strokeDirty = false;
+        }
+
         auto c = Colours::black.brighter();
         if (hover || dragging)
             c = c.brighter (0.2f);
@@ -226,7 +239,11 @@ public:
 
     bool hitTest (int x, int y) override
     {
-        if (hitPath.contains ((float) x, (float) y))
+        // within the 8 pixel wide band around the curve.
+        const Point<float> pos ((float) x, (float) y);
+        Point<float> nearest;
+        curve.getNearestPoint (pos, nearest);
+        if (pos.getDistanceFrom (nearest) <= 4.0f)
         {
             double distanceFromStart, distanceFromEnd;
             getDistancesFromEnds (x, y, distanceFromStart, distanceFromEnd);
@@ -307,44 +324,20 @@ public:
         x2 -= getX();
         y2 -= getY();
 
-        linePath.clear();
-        linePath.startNewSubPath (x1, y1);
+        curve.clear();
+        curve.startNewSubPath (x1, y1);
         const bool vertical = getGraphPanel()->isLayoutVertical();
 
         if (vertical)
         {
-            linePath.cubicTo (x1, y1 + (y2 - y1) * 0.33f, x2, y1 + (y2 - y1) * 0.66f, x2, y2);
+            curve.cubicTo (x1, y1 + (y2 - y1) * 0.33f, x2, y1 + (y2 - y1) * 0.66f, x2, y2);
         }
         else
         {
-            linePath.cubicTo (x1 + (x2 - x1) * 0.33f, y1, x1 + (x2 - x1) * 0.66f, y2, x2, y2);
-        }
-
-        PathStrokeType wideStroke (8.0f);
-        wideStroke.createStrokedPath (hitPath, linePath);
-
-        PathStrokeType stroke (2.5f);
-        stroke.createStrokedPath (linePath, linePath);
-
-        const bool showArrow = false;
-
-        if (showArrow)
-        {
-            const float arrowW = 5.0f;
-            const float arrowL = 4.0f;
-
-            Path arrow;
-            arrow.addTriangle (-arrowL, arrowW, -arrowL, -arrowW, arrowL, 0.0f);
-
-            arrow.applyTransform (AffineTransform()
-                                      .rotated (MathConstants<float>::pi * 0.5f - (float) atan2 (x2 - x1, y2 - y1))
-                                      .translated ((x1 + x2) * 0.5f,
-                                                   (y1 + y2) * 0.5f));
-
-            linePath.addPath (arrow);
+            curve.cubicTo (x1 + (x2 - x1) * 0.33f, y1, x1 + (x2 - x1) * 0.66f, y2, x2, y2);
         }
 
-        linePath.setUsingNonZeroWinding (true);
+        strokeDirty = true;
     }
 
     uint32 sourceFilterID { EL_INVALID_PORT },
@@ -354,7 +347,8 @@ public:
 private:
     Node graph;
     float lastInputX, lastInputY, lastOutputX, lastOutputY;
-    Path linePath, hitPath;
+    Path curve, linePath;
+    bool strokeDirty { true };
     bool dragging { false };
     bool hover { false };
 
@@ -375,35 +369,50 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConnectorComponent)
 };
 
+//=============================================================================
+namespace {
+// compares as ints, like Node::connectionExists.
+using ArcKey = std::tuple<int, int, int, int>;
+
+ArcKey arcKey (const ValueTree& arc)
+{
+    return { (int) arc.getProperty (tags::sourceNode), (int) arc.getProperty (tags::sourcePort), (int) arc.getProperty (tags::destNode), (int) arc.getProperty (tags::destPort) };
+}
+
+ArcKey arcKey (const ConnectorComponent& cc)
+{
+    return { (int) cc.sourceFilterID, cc.sourceFilterChannel, (int) cc.destFilterID, cc.destFilterChannel };
+}
+} // namespace
+
 //=============================================================================
 void GraphEditorComponent::SelectedNodes::itemSelected (uint32 nodeId)
 {
-    for (int i = 0; i < editor.getNumChildComponents(); ++i)
-        if (auto* block = dynamic_cast<BlockComponent*> (editor.getChildComponent (i)))
-            if (nodeId == block->node.getNodeId())
-                block->setSelectedInternal (true);
+    if (auto* block = editor.getComponentForFilter (nodeId))
+        block->setSelectedInternal (true);
 }
 
 void GraphEditorComponent::SelectedNodes::itemDeselected (uint32 nodeId)
 {
-    for (int i = 0; i < editor.getNumChildComponents(); ++i)
-        if (auto* block = dynamic_cast<BlockComponent*> (editor.getChildComponent (i)))
-            if (nodeId == block->node.getNodeId())
-                block->setSelectedInternal (false);
+    if (auto* block = editor.getComponentForFilter (nodeId))
+        block->setSelectedInternal (false);
 }
 
 //=============================================================================
 GraphEditorComponent::GraphEditorComponent()
     : ViewHelperMixin (this),
-      selectedNodes (*this)
+      selectedNodes (*this),
+      profileRefresh (*this)
 {
     setOpaque (true);
     data.addListener (this);
     setSize (640, 360);
+    profileRefresh.start();
 }
 
 GraphEditorComponent::~GraphEditorComponent()
 {
+    profileRefresh.stopTimer();
     if (graph.isValid())
         graph.setProperty (tags::vertical, verticalLayout);
     data.removeListener (this);
@@ -697,36 +706,31 @@ BlockComponent* GraphEditorComponent::getComponentForNode (const Node& node) con
 
 BlockComponent* GraphEditorComponent::getComponentForFilter (const uint32 nodeID) const
 {
-    for (int i = getNumChildComponents(); --i >= 0;)
-    {
-        if (BlockComponent* const block = dynamic_cast<BlockComponent*> (getChildComponent (i)))
-            if (block->filterID == nodeID)
-                return block;
-    }
-
-    return nullptr;
-}
-
-ConnectorComponent* GraphEditorComponent::getComponentForConnection (const Arc& arc) const
-{
-    for (int i = getNumChildComponents(); --i >= 0;)
+    if (blockIndexDirty)
     {
-        if (ConnectorComponent* const c = dynamic_cast<ConnectorComponent*> (getChildComponent (i)))
-            if (c->sourceFilterID == arc.sourceNode
-                && c->destFilterID == arc.destNode
-                && (uint32_t) c->sourceFilterChannel == arc.sourcePort
-                && (uint32_t) c->destFilterChannel == arc.destPort)
-                return c;
+        // front to back, so the topmost block wins like a search from the top.
+        blockIndex.clear();
+        for (auto* child : getChildren())
+            if (auto* const block = dynamic_cast<BlockComponent*> (child))
+                blockIndex[block->filterID] = block;
+        blockIndexDirty = false;
     }
 
-    return nullptr;
+    auto iter = blockIndex.find (nodeID);
+    return iter != blockIndex.end() ? iter->second : nullptr;
 }
 
 PortComponent* GraphEditorComponent::findPinAt (const int x, const int y) const
 {
-    for (int i = getNumChildComponents(); --i >= 0;)
+    // topmost first, like the child order.
+    auto candidates = getSpatialIndex().find (Point<int> (x, y));
+    std::sort (candidates.begin(), candidates.end(), [this] (Component* a, Component* b) {
+        return getIndexOfChildComponent (a) > getIndexOfChildComponent (b);
+    });
+
+    for (auto* const child : candidates)
     {
-        if (BlockComponent* block = dynamic_cast<BlockComponent*> (getChildComponent (i)))
+        if (BlockComponent* block = dynamic_cast<BlockComponent*> (child))
         {
             if (PortComponent* pin = dynamic_cast<PortComponent*> (block->getComponentAt (x - block->getX(),
                                                                                           y - block->getY())))
@@ -737,6 +741,27 @@ PortComponent* GraphEditorComponent::findPinAt (const int x, const int y) const
     return nullptr;
 }
 
+const SpatialGrid<Component*>& GraphEditorComponent::getSpatialIndex() const
+{
+    if (spatialIndexDirty)
+    {
+        spatialIndex.clear();
+        for (auto* child : getChildren())
+            if (dynamic_cast<BlockComponent*> (child) != nullptr || dynamic_cast<ConnectorComponent*> (child) != nullptr)
+                spatialIndex.set (child, child->getBounds());
+        spatialIndexDirty = false;
+    }
+
+    return spatialIndex;
+}
+
+void GraphEditorComponent::childBoundsChanged (Component* child)
+{
+    // removed children dirty the index, so anything it holds is alive.
+    if (! spatialIndexDirty && spatialIndex.contains (child))
+        spatialIndex.set (child, child->getBounds());
+}
+
 void GraphEditorComponent::resized()
 {
     updateBlockComponents (false);
@@ -767,13 +792,22 @@ void GraphEditorComponent::updateConnectorComponents (bool async)
         return;
     }
 
+    // this runs on every block drag, look arcs up once instead of per connector.
     const ValueTree arcs = graph.getArcsValueTree();
+    std::set<ArcKey> live;
+    for (int i = arcs.getNumChildren(); --i >= 0;)
+    {
+        const ValueTree arc (arcs.getChild (i));
+        if (! (bool) arc.getProperty (tags::missing, false))
+            live.insert (arcKey (arc));
+    }
+
     for (int i = getNumChildComponents(); --i >= 0;)
     {
         ConnectorComponent* const cc = dynamic_cast<ConnectorComponent*> (getChildComponent (i));
         if (cc != nullptr && cc != draggingConnector.get())
         {
-            if (! Node::connectionExists (arcs, cc->sourceFilterID, (uint32) cc->sourceFilterChannel, cc->destFilterID, (uint32) cc->destFilterChannel, true))
+            if (live.find (arcKey (*cc)) == live.end())
             {
                 delete cc;
             }
@@ -813,11 +847,17 @@ void GraphEditorComponent::stabilizeNodes()
 
 void GraphEditorComponent::updateComponents (const bool doNodePositions)
 {
+    std::map<ArcKey, ConnectorComponent*> connectors;
+    for (auto* child : getChildren())
+        if (auto* const cc = dynamic_cast<ConnectorComponent*> (child))
+            connectors.emplace (arcKey (*cc), cc);
+
     for (int i = graph.getNumConnections(); --i >= 0;)
     {
         const ValueTree c = graph.getConnectionValueTree (i);
         const Arc arc (Node::arcFromValueTree (c));
-        ConnectorComponent* connector = getComponentForConnection (arc);
+        auto iter = connectors.find (arcKey (c));
+        ConnectorComponent* connector = iter != connectors.end() ? iter->second : nullptr;
 
         if (connector == nullptr)
         {
@@ -830,13 +870,17 @@ void GraphEditorComponent::updateComponents (const bool doNodePositions)
         connector->setOutput (arc.destNode, arc.destPort);
     }
 
+    std::set<uint32> existing;
+    for (auto* child : getChildren())
+        if (auto* const block = dynamic_cast<BlockComponent*> (child))
+            existing.insert (block->filterID);
+
     for (int i = graph.getNumNodes(); --i >= 0;)
     {
         const Node node (graph.getNode (i));
-        BlockComponent* comp = getComponentForFilter (node.getNodeId());
-        if (comp == nullptr)
+        if (existing.find (node.getNodeId()) == existing.end())
         {
-            comp = createBlock (node);
+            auto* comp = createBlock (node);
             jassert (comp != nullptr);
             addAndMakeVisible (comp, i + 10000);
         }
@@ -1131,15 +1175,13 @@ void GraphEditorComponent::valueTreeChildRemoved (ValueTree& parent,
 void GraphEditorComponent::findLassoItemsInArea (Array<uint32>& itemsFound,
                                                  const Rectangle<int>& area)
 {
-    for (int i = 0; i < getNumChildComponents(); ++i)
-    {
-        if (auto* block = dynamic_cast<BlockComponent*> (getChildComponent (i)))
-            if (area.intersects (block->getBounds()))
-            {
-                itemsFound.add (block->node.getNodeId());
-                block->repaint();
-            }
-    }
+    getSpatialIndex().visit (area, [&itemsFound] (Component* child) {
+        if (auto* block = dynamic_cast<BlockComponent*> (child))
+        {
+            itemsFound.add (block->node.getNodeId());
+            block->repaint();
+        }
+    });
 }
 
 void GraphEditorComponent::selectNode (const Node& nodeToSelect)
@@ -1301,6 +1343,13 @@ void GraphEditorComponent::ensureSize()
         setSize (width, height);
 }
 
+void GraphEditorComponent::ProfileRefresh::timerCallback()
+{
+    for (int i = editor.getNumChildComponents(); --i >= 0;)
+        if (auto* block = dynamic_cast<BlockComponent*> (editor.getChildComponent (i)))
+            block->updateProfileOverlay();
+}
+
 BlockComponent* GraphEditorComponent::createBlock (const Node& node)
 {
     if (factory == nullptr)
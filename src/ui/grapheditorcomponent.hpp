@@ -3,9 +3,13 @@
 
 #pragma once
 
+#include <unordered_map>
+
 #include "ElementApp.h"
 #include "ui/viewhelpers.hpp"
 #include "ui/block.hpp"
+#include "ui/spatialgrid.hpp"
+#include "ui/uiactivity.hpp"
 #include "scopedcallback.hpp"
 
 namespace element {
@@ -121,8 +125,44 @@ private:
 
     bool ignoreNodeSelected = false;
 
+    // blocks by node id, rebuilt on the first lookup after children change.
+    mutable std::unordered_map<uint32, BlockComponent*> blockIndex;
+    mutable bool blockIndexDirty = true;
+
+    // blocks and connectors by bounds, kept current as they move.
+    mutable SpatialGrid<Component*> spatialIndex;
+    mutable bool spatialIndexDirty = true;
+    const SpatialGrid<Component*>& getSpatialIndex() const;
+
+    void childrenChanged() override { blockIndexDirty = spatialIndexDirty = true; }
+    void childBoundsChanged (Component* child) override;
+
     float zoomScale = 1.0;
 
+    // repaints the CPU usage of profiled blocks, while the window shows.
+    struct ProfileRefresh : public juce::Timer,
+                            private UIActivity::Listener
+    {
+        static constexpr int refreshHz = 4;
+        ProfileRefresh (GraphEditorComponent& e) : editor (e) { activity->addListener (this); }
+        ~ProfileRefresh() override { activity->removeListener (this); }
+        GraphEditorComponent& editor;
+        juce::SharedResourcePointer<UIActivity> activity;
+        void start()
+        {
+            if (activity->isActive())
+                startTimerHz (refreshHz);
+        }
+        void timerCallback() override;
+        void uiActivityChanged (bool isActive) override
+        {
+            if (isActive)
+                startTimerHz (refreshHz);
+            else
+                stopTimer();
+        }
+    } profileRefresh;
+
     void setSelectedNodesCompact (bool selected);
 
     Component* createContainerForNode (ProcessorPtr node, bool useGenericEditor);
@@ -140,7 +180,6 @@ private:
 
     BlockComponent* getComponentForNode (const Node&) const;
     BlockComponent* getComponentForFilter (const uint32 filterID) const;
-    ConnectorComponent* getComponentForConnection (const Arc& conn) const;
     PortComponent* findPinAt (const int x, const int y) const;
 
     void updateSelection();
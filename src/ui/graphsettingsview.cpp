@@ -93,6 +93,106 @@ protected:
     Node graph;
 };
 
+class DevicePortsPropertyComponent : public BooleanPropertyComponent
+{
+public:
+    DevicePortsPropertyComponent (const Node& g)
+        : BooleanPropertyComponent ("Device Ports", "Own ports", "Shared"),
+          graph (g)
+    {
+        jassert (graph.isRootGraph());
+        setTooltip ("Give this graph its own JACK ports instead of the main inputs and outputs");
+    }
+
+    bool getState() const override
+    {
+        return (bool) graph.getProperty (tags::devicePorts, false);
+    }
+
+    void setState (bool newState) override
+    {
+        graph.setProperty (tags::devicePorts, newState);
+        if (auto* root = dynamic_cast<RootGraph*> (graph.getObject()))
+        {
+            root->setDevicePortsEnabled (newState);
+            if (auto* world = ViewHelpers::getGlobals (this))
+                world->audio()->updateDevicePorts();
+        }
+
+        refresh();
+    }
+
+private:
+    Node graph;
+};
+
+class DoublePrecisionPropertyComponent : public BooleanPropertyComponent
+{
+public:
+    DoublePrecisionPropertyComponent (const Node& g)
+        : BooleanPropertyComponent ("Precision", "64-bit", "32-bit"),
+          graph (g)
+    {
+        jassert (graph.isRootGraph());
+        setTooltip ("Run plugins that support it in double precision");
+    }
+
+    bool getState() const override
+    {
+        return (bool) graph.getProperty (tags::doublePrecision, false);
+    }
+
+    void setState (bool newState) override
+    {
+        graph.setProperty (tags::doublePrecision, newState);
+        if (auto* root = dynamic_cast<RootGraph*> (graph.getObject()))
+            root->setDoublePrecision (newState);
+
+        refresh();
+    }
+
+private:
+    Node graph;
+};
+
+class InternalRatePropertyComponent : public ChoicePropertyComponent
+{
+public:
+    InternalRatePropertyComponent (const Node& g)
+        : ChoicePropertyComponent ("Internal Rate"),
+          graph (g)
+    {
+        jassert (graph.isRootGraph());
+        setTooltip ("Run the graph at this rate whatever the device's, converting at its inputs and outputs");
+        choices.add ("Device");
+        for (auto rate : rates)
+            choices.add (String (rate) + " Hz");
+    }
+
+    int getIndex() const override
+    {
+        const auto rate = (int) graph.getProperty (tags::internalRate, 0);
+        for (int i = 0; i < numElementsInArray (rates); ++i)
+            if (rates[i] == rate)
+                return i + 1;
+        return 0;
+    }
+
+    void setIndex (const int i) override
+    {
+        const int rate = isPositiveAndBelow (i - 1, numElementsInArray (rates)) ? rates[i - 1] : 0;
+        graph.setProperty (tags::internalRate, rate);
+        if (auto* root = dynamic_cast<RootGraph*> (graph.getObject()))
+            root->setInternalRate ((double) rate);
+
+        refresh();
+    }
+
+private:
+    static constexpr int rates[] = { 44100, 48000, 88200, 96000 };
+    Node graph;
+};
+
 class VelocityCurvePropertyComponent : public ChoicePropertyComponent
 {
 public:
@@ -482,6 +582,9 @@ private:
                                               false));
 
         props.add (new RenderModePropertyComponent (g));
+        props.add (new DevicePortsPropertyComponent (g));
+        props.add (new DoublePrecisionPropertyComponent (g));
+        props.add (new InternalRatePropertyComponent (g));
         props.add (new VelocityCurvePropertyComponent (g));
 #endif
         props.add (new RootGraphMidiChannels (g, getWidth() - 100));
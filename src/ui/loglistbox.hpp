@@ -5,6 +5,8 @@
 
 #include <element/juce.hpp>
 
+#include "logstore.hpp"
+
 namespace element {
 
 class LogListBox : public ListBox,
@@ -23,7 +25,7 @@ public:
 
     int getNumRows() override
     {
-        return logList.size();
+        return logList->size();
     }
 
     void paintListBoxItem (int row, Graphics& g, int width, int height, bool rowIsSelected) override
@@ -32,16 +34,17 @@ public:
         g.setFont (Font (Font::getDefaultMonospacedFontName(),
                          g.getCurrentFont().getHeight(),
                          Font::plain));
-        if (isPositiveAndBelow (row, logList.size()))
-            ViewHelpers::drawBasicTextRow (logList[row], g, width, height, false);
+        if (isPositiveAndBelow (row, logList->size()))
+            ViewHelpers::drawBasicTextRow ((*logList)[row], g, width, height, false);
     }
 
-    /** Sets the maximum allowed messages in the log history */
+    /** Sets the maximum allowed messages in the log history. This clears
+        the history, don't call it while messages may be added. */
     void setMaxMessages (int newMax)
     {
-        if (newMax <= 0 || newMax == maxMessages)
+        if (newMax <= 0 || newMax == logList->getCapacity())
             return;
-        maxMessages = newMax;
+        logList = std::make_unique<LogStore> (newMax);
         triggerAsyncUpdate();
     }
 
@@ -51,19 +54,17 @@ public:
         addMessage (String (message));
     }
 
-    /** Add a new message to the history */
+    /** Add a new message to the history. Any thread. */
     void addMessage (const String& message)
     {
-        if (logList.size() > maxMessages)
-            logList.remove (0);
-        logList.add (message);
+        logList->add (message);
         triggerAsyncUpdate();
     }
 
     /** Clears the message history */
     void clear()
     {
-        logList.clear();
+        logList->clear();
         triggerAsyncUpdate();
     }
 
@@ -71,13 +72,12 @@ public:
     void handleAsyncUpdate() override
     {
         updateContent();
-        scrollToEnsureRowIsOnscreen (logList.size() - 1);
+        scrollToEnsureRowIsOnscreen (logList->size() - 1);
         repaint();
     }
 
 private:
-    int maxMessages { 100 };
-    StringArray logList;
+    std::unique_ptr<LogStore> logList { std::make_unique<LogStore> (100) };
 };
 
 } // namespace element
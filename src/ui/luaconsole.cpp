@@ -20,7 +20,11 @@ LuaConsole::LuaConsole()
     startTimer (200);
 }
 
-LuaConsole::~LuaConsole() {}
+LuaConsole::~LuaConsole()
+{
+    // jobs stop before their callbacks' target goes away.
+    jobs.clear();
+}
 
 void LuaConsole::textEntered (const String& text)
 {
@@ -72,8 +76,9 @@ void LuaConsole::textEntered (const String& text)
     lastError.clear();
 }
 
-void LuaConsole::setEnvironment (const sol::environment& _env)
+void LuaConsole::setEnvironment (ScriptingEngine& engine, const sol::environment& _env)
 {
+    scripting = &engine;
     env = _env;
     auto& e = env;
     jassert (e.valid());
@@ -101,6 +106,12 @@ void LuaConsole::setEnvironment (const sol::environment& _env)
         }
     };
 
+    // long scripts run off the message thread, e.g. spawn ('/path/to/script.lua')
+    e["spawn"] = [this] (const std::string& codeOrFile) { return spawn (codeOrFile); };
+    e["cancel"] = sol::overload (
+        [this]() { cancel (-1); },
+        [this] (int jobId) { cancel (jobId); });
+
     e.set_function ("print", [this] (sol::variadic_args va) {
         auto& e = env;
         String msg;
@@ -143,6 +154,47 @@ void LuaConsole::setEnvironment (const sol::environment& _env)
     }
 }
 
+int LuaConsole::spawn (const String& codeOrFile)
+{
+    if (scripting == nullptr)
+        return 0;
+
+    // drop jobs that are done, their output is already printed.
+    for (int i = jobs.size(); --i >= 0;)
+    {
+        if (! jobs.getUnchecked (i)->isRunning())
+        {
+            jobs.remove (i);
+            jobIds.remove (i);
+        }
+    }
+
+    const int jobId = nextJobId++;
+    const File file = File::isAbsolutePath (codeOrFile) ? File (codeOrFile) : File();
+    const auto name = file.existsAsFile() ? file.getFileName() : String ("job ") + String (jobId);
+    auto* job = jobs.add (new ScriptJob (*scripting, name, file.existsAsFile() ? file.loadFileAsString() : codeOrFile));
+    jobIds.add (jobId);
+
+    job->onPrint = [this] (const String& line) { printMessages.add (line); };
+    job->onProgress = [this, name] (float fraction, const String& text) {
+        printMessages.add (name + ": " + String (roundToInt (fraction * 100.f)) + "% " + text);
+    };
+    job->onFinished = [this, name] (const Result& result) {
+        printMessages.add (name + (result.wasOk() ? String (": done") : ": " + result.getErrorMessage()));
+    };
+
+    printMessages.add (name + ": started, cancel (" + String (jobId) + ") stops it");
+    job->start();
+    return jobId;
+}
+
+void LuaConsole::cancel (int jobId)
+{
+    for (int i = 0; i < jobs.size(); ++i)
+        if (jobId < 0 || jobIds[i] == jobId)
+            jobs.getUnchecked (i)->cancel();
+}
+
 void LuaConsole::timerCallback()
 {
     if (! printMessages.isEmpty())
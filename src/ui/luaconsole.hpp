@@ -7,6 +7,7 @@
 
 #include "ui/console.hpp"
 #include "scripting.hpp"
+#include "scripting/scriptjob.hpp"
 
 namespace element {
 
@@ -18,15 +19,26 @@ public:
     virtual ~LuaConsole();
 
     void textEntered (const String&) override;
-    void setEnvironment (const sol::environment& e);
+
+    /** Set the environment lines run in. Jobs started with `spawn` run
+        on the engine's behalf, see ScriptJob.
+     */
+    void setEnvironment (ScriptingEngine& engine, const sol::environment& e);
 
 private:
     using LuaResult = sol::protected_function_result;
+    ScriptingEngine* scripting = nullptr;
     sol::environment env;
+    juce::OwnedArray<ScriptJob> jobs;
+    juce::Array<int> jobIds;
+    int nextJobId = 1;
     String lastError;
     StringArray printMessages;
     LuaResult errorHandler (lua_State* L, LuaResult pfr);
 
+    int spawn (const String& codeOrFile);
+    void cancel (int jobId);
+
     friend class juce::Timer;
     void timerCallback() override;
 };
@@ -16,6 +16,7 @@ LuaConsoleView::~LuaConsoleView()
         log->removeListener (this);
         log = nullptr;
     }
+    cancelPendingUpdate();
 }
 
 void LuaConsoleView::initializeView (Services& app)
@@ -23,7 +24,7 @@ void LuaConsoleView::initializeView (Services& app)
     auto& se = app.context().scripting();
     sol::state_view view (se.getLuaState());
     console.setEnvironment (
-        sol::environment (view, sol::create, view.globals()));
+        se, sol::environment (view, sol::create, view.globals()));
 
     log = &app.context().logger();
     log->addListener (this);
@@ -14,7 +14,8 @@ namespace element {
 class Services;
 
 class LuaConsoleView : public ContentView,
-                       public Log::Listener
+                       public Log::Listener,
+                       private AsyncUpdater
 {
 public:
     LuaConsoleView()
@@ -36,14 +37,27 @@ public:
         console.setBounds (getLocalBounds().reduced (2));
     }
 
+    /** Any thread, lines reach the console on the message thread. */
     void messageLogged (const String& msg) override
     {
-        console.addText (msg, false);
+        logged.add (msg);
+        triggerAsyncUpdate();
     }
 
 private:
     LuaConsole console;
     Log* log = nullptr;
+    LogStore logged { 256 };
+    uint64 nextLogged = 0;
+
+    void handleAsyncUpdate() override
+    {
+        // lines overwritten before getting here are skipped.
+        const auto end = logged.getEnd();
+        for (auto i = jmax (nextLogged, logged.getStart()); i < end; ++i)
+            console.addText (logged.get (i), false);
+        nextLogged = end;
+    }
 };
 
 } // namespace element
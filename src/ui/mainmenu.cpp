@@ -18,6 +18,8 @@
 #include "services/deviceservice.hpp"
 #include "services/mappingservice.hpp"
 #include "services/sessionservice.hpp"
+#include "session/memoryreport.hpp"
+#include "session/sessionprofile.hpp"
 #include "ui/mainmenu.hpp"
 #include "ui/viewhelpers.hpp"
 #include "ui/pluginwindow.hpp"
@@ -131,6 +133,27 @@ void MainMenu::menuItemSelected (int index, int menu)
         Logger::writeToLog (String ("opening log folder ") + dir.getFullPathName());
         dir.startAsProcess();
     }
+    else if (index == 7003)
+    {
+        auto profile = SessionProfile::getLast();
+        if (profile == nullptr)
+        {
+            AlertWindow::showMessageBoxAsync (AlertWindow::InfoIcon, "Session Profile", "No session has been loaded or saved yet.");
+        }
+        else
+        {
+            auto report = DataPath::defaultSettingsFile().getParentDirectory().getChildFile ("log").getChildFile ("session-profile.json");
+            report.getParentDirectory().createDirectory();
+            String text = profile->toText();
+            if (report.replaceWithText (JSON::toString (profile->toJSON())))
+                text << newLine << "Report written to " << report.getFullPathName();
+            AlertWindow::showMessageBoxAsync (AlertWindow::InfoIcon, "Session Profile", text);
+        }
+    }
+    else if (index == 7004 && session != nullptr)
+    {
+        AlertWindow::showMessageBoxAsync (AlertWindow::InfoIcon, "Memory Usage", MemoryReport::capture (*session).toText());
+    }
 
     else if (index == 2000 && menu == Window)
     {
@@ -242,6 +265,9 @@ void MainMenu::buildFileMenu (PopupMenu& menu)
     menu.addSeparator();
     menu.addCommandItem (&cmd, Commands::sessionOpen, "Open Session...");
     addRecentFiles (menu);
+    menu.addCommandItem (&cmd, Commands::sessionCue, "Cue Session...");
+    menu.addCommandItem (&cmd, Commands::sessionSwitchToCued);
+    menu.addSeparator();
     menu.addCommandItem (&cmd, Commands::sessionSave, "Save Session");
     menu.addCommandItem (&cmd, Commands::sessionSaveAs, "Save Session As...");
     menu.addSeparator();
@@ -316,6 +342,8 @@ void MainMenu::buildHelpMenu (PopupMenu& menu)
     menu.addItem (6000, TRANS ("User's Manual"));
     menu.addSeparator();
     menu.addItem (7002, TRANS ("Log files..."));
+    menu.addItem (7003, TRANS ("Session profile..."));
+    menu.addItem (7004, TRANS ("Memory usage..."));
     menu.addItem (7000, TRANS ("Issue tracking..."));
 #if ! EL_UPDATER
     menu.addSeparator();
@@ -12,6 +12,7 @@
 
 #include "services/sessionservice.hpp"
 #include "ui/mainmenu.hpp"
+#include "ui/uiactivity.hpp"
 #include "utils.hpp"
 
 namespace element {
@@ -139,6 +140,24 @@ void MainWindow::activeWindowStatusChanged()
     gui.checkForegroundStatus();
 }
 
+void MainWindow::minimisationStateChanged (bool isNowMinimised)
+{
+    DocumentWindow::minimisationStateChanged (isNowMinimised);
+    updateActivity();
+}
+
+void MainWindow::visibilityChanged()
+{
+    DocumentWindow::visibilityChanged();
+    updateActivity();
+}
+
+void MainWindow::updateActivity()
+{
+    SharedResourcePointer<UIActivity> activity;
+    activity->setActive (isOnDesktop() && isVisible() && ! isMinimised());
+}
+
 void MainWindow::refreshMenu()
 {
     if (mainMenu)
@@ -8,20 +8,27 @@
 
 #include <element/ui/style.hpp>
 
+#include "ui/meterticker.hpp"
+
 namespace element {
 
 struct SimpleLevelMeter : public Component,
-                          public Timer
+                          public MeterTicker::Client
 {
     SimpleLevelMeter() = delete;
     SimpleLevelMeter (AudioEnginePtr e, int channel, bool input)
     {
         setOpaque (false);
-        startTimerHz (20);
         meter = e->getLevelMeter (channel, input);
+        ticker->add (this);
+    }
+
+    ~SimpleLevelMeter() override
+    {
+        ticker->remove (this);
     }
 
-    void timerCallback() override
+    void meterTick() override
     {
         if (isShowing())
         {
@@ -104,8 +111,8 @@ struct SimpleLevelMeter : public Component,
         }
     }
 
+    SharedResourcePointer<MeterTicker> ticker;
     AudioEngine::LevelMeterPtr meter;
-    ;
     float level = 0;
     int totalBlocks = 7;
 
@@ -0,0 +1,90 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/events.hpp>
+
+#include "ui/uiactivity.hpp"
+
+namespace element {
+
+/** The one timer every level meter in the UI refreshes on.
+
+    The audio thread already publishes levels as atomics, so meters only
+    differ in how often they're read. Sharing a single tick means one
+    message thread callback per frame however many meters are open, and
+    meters that aren't showing skip their work. The tick stops while the
+    main window is hidden. Hold one in a juce::SharedResourcePointer and
+    add clients while they meter.
+ */
+class MeterTicker final : private juce::Timer,
+                          private UIActivity::Listener
+{
+public:
+    static constexpr int refreshHz = 24;
+
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /** Read levels and repaint. Message thread. */
+        virtual void meterTick() = 0;
+    };
+
+    MeterTicker() { activity->addListener (this); }
+
+    ~MeterTicker() override
+    {
+        activity->removeListener (this);
+        stopTimer();
+    }
+
+    /** Starts ticking a client, the timer runs while there are any. */
+    void add (Client* client)
+    {
+        if (client == nullptr || clients.contains (client))
+            return;
+        clients.add (client);
+        if (activity->isActive() && ! isTimerRunning())
+            startTimerHz (refreshHz);
+    }
+
+    /** Stops ticking a client. Safe to call from meterTick(). */
+    void remove (Client* client)
+    {
+        const int index = clients.indexOf (client);
+        if (index < 0)
+            return;
+        clients.remove (index);
+        if (index <= current)
+            --current;
+        if (clients.isEmpty())
+            stopTimer();
+    }
+
+    int getNumClients() const noexcept { return clients.size(); }
+
+private:
+    juce::SharedResourcePointer<UIActivity> activity;
+    juce::Array<Client*> clients;
+    int current = -1;
+
+    void uiActivityChanged (bool isActive) override
+    {
+        if (! isActive)
+            stopTimer();
+        else if (! clients.isEmpty())
+            startTimerHz (refreshHz);
+    }
+
+    void timerCallback() override
+    {
+        for (current = 0; current < clients.size(); ++current)
+            clients.getUnchecked (current)->meterTick();
+        current = -1;
+    }
+};
+
+} // namespace element
@@ -61,15 +61,22 @@ void MidiBlinker::setInputOutputVisibility (bool in, bool out)
 
 void MidiBlinker::triggerReceived()
 {
-    haveInput = true;
-    repaint();
+    // already lit, only the hold is extended.
+    if (! haveInput)
+    {
+        haveInput = true;
+        repaint();
+    }
     startTimer (holdMillis);
 }
 
 void MidiBlinker::triggerSent()
 {
-    haveOutput = true;
-    repaint();
+    if (! haveOutput)
+    {
+        haveOutput = true;
+        repaint();
+    }
     startTimer (holdMillis);
 }
 
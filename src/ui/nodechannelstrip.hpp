@@ -9,12 +9,13 @@
 
 #include "ElementApp.h"
 #include "ui/channelstrip.hpp"
+#include "ui/meterticker.hpp"
 #include "services/sessionservice.hpp"
 
 namespace element {
 
 class NodeChannelStripComponent : public Component,
-                                  public Timer,
+                                  public MeterTicker::Client,
                                   public ComboBox::Listener,
                                   private Value::Listener
 {
@@ -45,6 +46,8 @@ public:
 
     ~NodeChannelStripComponent()
     {
+        ticker->remove (this);
+        setMeteredObject (nullptr);
         unbindSignals();
     }
 
@@ -110,11 +113,15 @@ public:
         g.drawLine (getWidth() - 1.f, 0.0, getWidth() - 1.f, getHeight());
     }
 
-    inline void timerCallback() override
+    inline void meterTick() override
     {
+        if (! isShowing())
+            return;
+
         auto& meter = channelStrip.getSimpleMeter();
         if (ProcessorPtr ptr = node.getObject())
         {
+            setMeteredObject (ptr);
             const int startChannel = jmax (0, channelBox.getSelectedId() - 1);
             if (ptr->getNumAudioOutputs() == 1)
             {
@@ -146,8 +153,9 @@ public:
         }
         else
         {
+            setMeteredObject (nullptr);
             meter.resetPeaks();
-            stopTimer();
+            ticker->remove (this);
         }
 
         meter.refresh();
@@ -185,8 +193,9 @@ public:
 
     inline void setNode (const Node& newNode)
     {
-        stopTimer();
+        ticker->remove (this);
         node = newNode;
+        setMeteredObject (node.getObject());
         isAudioOutNode = node.isAudioOutputNode();
         isAudioInNode = node.isAudioInputNode();
         audioIns.clearQuick();
@@ -194,7 +203,7 @@ public:
         node.getPorts (audioIns, audioOuts, PortType::Audio);
         displayName.referTo (node.getPropertyAsValue (tags::name));
         stabilizeContent();
-        startTimerHz (meterSpeedHz);
+        ticker->add (this);
 
         if (onNodeChanged)
             onNodeChanged();
@@ -250,12 +259,13 @@ private:
     bool useFlowBox = true;
     bool useChannelBox = true;
 
-    int meterSpeedHz = 15;
+    SharedResourcePointer<MeterTicker> ticker;
     bool isAudioOutNode = false;
     bool isAudioInNode = false;
     [[maybe_unused]] bool monoMeter = false;
 
     Value displayName;
+    ProcessorPtr meteredObject;
 
     SignalConnection nodeSelectedConnection;
     SignalConnection volumeChangedConnection;
@@ -264,6 +274,18 @@ private:
     SignalConnection muteChangedConnection;
     std::vector<boost::signals2::connection> _conns;
 
+    /** Levels are only measured for nodes with a meter open. */
+    void setMeteredObject (ProcessorPtr object)
+    {
+        if (object == meteredObject)
+            return;
+        if (meteredObject != nullptr)
+            meteredObject->stopMetering();
+        meteredObject = object;
+        if (meteredObject != nullptr)
+            meteredObject->startMetering();
+    }
+
     inline bool isMonitoringInputs() const { return flowBox.getSelectedId() == 1; }
     inline bool isMonitoringOutputs() const { return flowBox.getSelectedId() == 2; }
 
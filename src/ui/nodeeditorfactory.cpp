@@ -17,6 +17,8 @@
 #include "nodes/volumeeditor.hpp"
 #include "nodes/scriptnodeeditor.hpp"
 #include "nodes/midisetlisteditor.hpp"
+#include "nodes/videomonitoreditor.hpp"
+#include "nodes/analyzereditor.hpp"
 #include "../nodes/mcu.hpp"
 
 #include "ui/nodeeditorfactory.hpp"
@@ -88,6 +90,14 @@ private:
         {
             return new OSCSenderNodeEditor (node);
         }
+        else if (NID == EL_NODE_ID_VIDEO_MONITOR)
+        {
+            return new VideoMonitorNodeEditor (node);
+        }
+        else if (NID == EL_NODE_ID_ANALYZER)
+        {
+            return new AnalyzerNodeEditor (node);
+        }
         else if (NID.contains (EL_NODE_ID_VOLUME))
         {
             return new VolumeNodeEditor (node, gui);
@@ -27,6 +27,7 @@ inline static bool showNodeDelayComp (const Node& node)
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_AUDIO_ROUTER) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_CHANNEL_MAP) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_CHANNEL_SPLITTER) ||
+        node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MPE_ROUTER) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_CHANNELIZE) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_OUTPUT_DEVICE) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_ROUTER))
@@ -57,6 +58,7 @@ inline static bool showMidiFilters (const Node& node)
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_AUDIO_ROUTER) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_CHANNEL_MAP) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_CHANNEL_SPLITTER) ||
+        node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MPE_ROUTER) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_CHANNELIZE) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_OUTPUT_DEVICE) ||
         node.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_ROUTER))
@@ -277,6 +279,30 @@ public:
     }
 };
 
+class TailLengthPropertyComponent : public SliderPropertyComponent
+{
+public:
+    TailLengthPropertyComponent (const Value& value, const String& name)
+        : SliderPropertyComponent (value, name, -1.0, 30000.0, 1.0, 0.5, false)
+    {
+        slider.textFromValueFunction = [] (double value) {
+            if (value < 0.0)
+                return String ("Never sleep");
+            String str (roundToInt (value));
+            str << " ms";
+            return str;
+        };
+
+        slider.valueFromTextFunction = [] (const String& text) -> double {
+            if (! text.containsAnyOf ("0123456789"))
+                return -1.0;
+            return text.replace ("ms", "", false).trim().getDoubleValue();
+        };
+
+        slider.updateText();
+    }
+};
+
 NodeProperties::NodeProperties (const Node& n, int groups)
     : NodeProperties (n, groups & General, groups & Midi) {}
 
@@ -292,8 +318,12 @@ NodeProperties::NodeProperties (const Node& n, bool nodeProps, bool midiProps)
                                         false,
                                         true));
         if (detail::showNodeDelayComp (node))
+        {
             add (new MillisecondSliderPropertyComponent (
                 node.getPropertyAsValue (tags::delayCompensation), "Delay comp."));
+            add (new TailLengthPropertyComponent (
+                node.getPropertyAsValue (tags::tailLength), "Sleep tail"));
+        }
     }
 
     if (midiProps)
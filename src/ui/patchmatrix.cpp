@@ -170,33 +170,52 @@ void PatchMatrixComponent::mouseExit (const MouseEvent& ev)
 
 void PatchMatrixComponent::paint (Graphics& g)
 {
-    if (getNumColumns() <= 0 || getNumRows() <= 0)
+    const int numRows = getNumRows();
+    const int numColumns = getNumColumns();
+    if (numColumns <= 0 || numRows <= 0)
+        return;
+
+    // only the cells in the area being repainted.
+    const auto clip = g.getClipBounds().getIntersection (getLocalBounds());
+    if (clip.isEmpty())
         return;
 
-    const int xs = (offsetX % horizontalThickness);
-    const int ys = (offsetY % verticalThickness);
-    const int cs = getColumnForPixel (0);
     const int w = horizontalThickness;
     const int h = verticalThickness;
+    const int firstColumn = jmax (0, getColumnForPixel (clip.getX()));
+    const int lastColumn = jmin (numColumns - 1, getColumnForPixel (clip.getRight() - 1));
+    const int firstRow = jmax (0, getRowForPixel (clip.getY()));
+    const int lastRow = jmin (numRows - 1, getRowForPixel (clip.getBottom() - 1));
 
-    int row = getRowForPixel (0);
-    for (int y = ys; y < getHeight(); y += h)
+    for (int row = firstRow; row <= lastRow; ++row)
     {
-        int col = cs;
-        for (int x = xs; x < getWidth(); x += w)
+        for (int col = firstColumn; col <= lastColumn; ++col)
         {
-            g.saveState();
-            g.setOrigin (x, y);
+            Graphics::ScopedSaveState state (g);
+            g.setOrigin (offsetX + col * w, offsetY + row * h);
             paintMatrixCell (g, w, h, row, col);
-            g.restoreState();
-            if (++col == getNumColumns())
-                break;
         }
-        if (++row == getNumRows())
-            break;
     }
 }
 
+void PatchMatrixComponent::repaintCell (const int row, const int column)
+{
+    if (row >= 0 && column >= 0)
+        repaint (offsetX + column * horizontalThickness, offsetY + row * verticalThickness, horizontalThickness, verticalThickness);
+}
+
+void PatchMatrixComponent::repaintRow (const int row)
+{
+    if (row >= 0)
+        repaint (0, offsetY + row * verticalThickness, getWidth(), verticalThickness);
+}
+
+void PatchMatrixComponent::repaintColumn (const int column)
+{
+    if (column >= 0)
+        repaint (offsetX + column * horizontalThickness, 0, horizontalThickness, getHeight());
+}
+
 int PatchMatrixComponent::getColumnForPixel (const int x)
 {
     return (x - offsetX) / horizontalThickness;
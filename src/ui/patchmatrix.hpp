@@ -80,6 +80,12 @@ public:
 
     int getColumnForPixel (const int x);
     int getRowForPixel (const int y);
+
+    /** Repaint just the cells that changed, the rest keep what they drew. */
+    void repaintCell (const int row, const int column);
+    void repaintRow (const int row);
+    void repaintColumn (const int column);
+
     void setOffsetX (const int x) { offsetX = x; }
     void setOffsetY (const int y) { offsetY = y; }
 
@@ -384,6 +384,32 @@ public:
             PopupMenu menu;
             menu.addItem (1, "Clear list", ! owner.isPluginVersion());
             menu.addItem (2, "Remove selected", ! owner.isPluginVersion());
+
+            const auto types = list.getTypes();
+            if (isPositiveAndBelow (row, types.size()))
+            {
+                const auto& type = types.getReference (row);
+                const bool bridged = owner.plugins.isPluginBridged (type);
+                const bool shared = owner.plugins.isPluginShared (type);
+                menu.addSeparator();
+                menu.addItem (3, TRANS ("Run in separate process"), ! owner.isPluginVersion() && owner.plugins.canBridgePlugin (type), bridged);
+                menu.addItem (4, TRANS ("Share one instance between graphs"), ! owner.isPluginVersion() && owner.plugins.canSharePlugin (type), shared);
+
+                const int result = menu.show();
+                if (result == 3)
+                {
+                    owner.plugins.setPluginBridged (type, ! bridged);
+                    return;
+                }
+                if (result == 4)
+                {
+                    owner.plugins.setPluginShared (type, ! shared);
+                    return;
+                }
+                cellPopup (result);
+                return;
+            }
+
             cellPopup (menu.show());
         }
     }
@@ -7,6 +7,7 @@
 #include "ui/guicommon.hpp"
 #include "ui/pluginwindow.hpp"
 #include "ui/contextmenus.hpp"
+#include "ui/nodeeditorfactory.hpp"
 #include <element/ui/grapheditor.hpp>
 #include "nodes/volumeeditor.hpp"
 #include "session/presetmanager.hpp"
@@ -74,28 +75,48 @@ public:
     ~PluginWindowContent() noexcept
     {
         powerButton.removeListener (this);
-
-        if (object && editor)
-        {
-            if (auto* proc = object->getAudioProcessor())
-                if (auto* const e = dynamic_cast<AudioProcessorEditor*> (editor.get()))
-                    proc->editorBeingDeleted (e);
-        }
-
-        editor = nullptr;
+        deleteEditor();
         toolbar = nullptr;
         leftPanel = nullptr;
         rightPanel = nullptr;
     }
 
+    /** Plugin editors can be expensive to keep around and can be made
+        again, others aren't touched. The window keeps its size. */
+    bool releaseEditor()
+    {
+        if (! nativeEditor || editor == nullptr)
+            return false;
+        editor->removeComponentListener (this);
+        deleteEditor();
+        return true;
+    }
+
+    bool isEditorReleased() const noexcept { return nativeEditor && editor == nullptr; }
+
+    void restoreEditor (std::unique_ptr<Component> newEditor)
+    {
+        if (newEditor == nullptr)
+            return;
+        editor = std::move (newEditor);
+        addAndMakeVisible (editor.get());
+        editor->addComponentListener (this);
+        updateSize();
+        resized();
+    }
+
     void updateSize()
     {
+        if (editor == nullptr)
+            return;
         const int height = jmax (editor->getHeight(), 100) + toolbar->getHeight();
         setSize (editor->getWidth(), height + 4);
     }
 
     void resized() override
     {
+        if (editor == nullptr)
+            return;
         editor->removeComponentListener (this);
         auto r (getLocalBounds().reduced (2));
 
@@ -234,6 +255,18 @@ private:
     };
 
     AudioProcessor* getProcessor() { return (object != nullptr) ? object->getAudioProcessor() : nullptr; }
+
+    void deleteEditor()
+    {
+        if (object && editor)
+        {
+            if (auto* proc = object->getAudioProcessor())
+                if (auto* const e = dynamic_cast<AudioProcessorEditor*> (editor.get()))
+                    proc->editorBeingDeleted (e);
+        }
+
+        editor = nullptr;
+    }
 };
 
 void PluginWindow::DelayedNodeFocus::timerCallback()
@@ -372,6 +405,25 @@ void PluginWindow::activeWindowStatusChanged()
     gui.checkForegroundStatus();
 }
 
+void PluginWindow::minimisationStateChanged (bool isNowMinimised)
+{
+    DocumentWindow::minimisationStateChanged (isNowMinimised);
+    auto* const content = dynamic_cast<PluginWindowContent*> (getContentComponent());
+    if (content == nullptr)
+        return;
+
+    // a minimised plugin UI can keep drawing and running its timers.
+    if (isNowMinimised)
+    {
+        if (gui.context().settings().releaseMinimisedEditors())
+            content->releaseEditor();
+    }
+    else if (content->isEditorReleased())
+    {
+        content->restoreEditor (NodeEditorFactory::createAudioProcessorEditor (node));
+    }
+}
+
 void PluginWindow::updateGraphNode (Processor* newNode, Component* newEditor)
 {
     jassert (nullptr != newNode && nullptr != newEditor);
@@ -39,6 +39,7 @@ public:
     void resized() override;
 
     void activeWindowStatusChanged() override;
+    void minimisationStateChanged (bool isNowMinimised) override;
 
     int getDesktopWindowStyleFlags() const override
     {
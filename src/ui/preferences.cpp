@@ -438,6 +438,131 @@ public:
             }
         };
 
+        addAndMakeVisible (renderThreadsLabel);
+        renderThreadsLabel.setText ("Render threads", dontSendNotification);
+        renderThreadsLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (renderThreads);
+        renderThreads.textFromValueFunction = [] (double value) -> String {
+            return value < 1.0 ? String ("Off") : String (roundToInt (value));
+        };
+        renderThreads.setRange (0.0, (double) jmax (1, SystemStats::getNumCpus() - 1), 1.0);
+        renderThreads.setValue ((double) settings.getNumRenderThreads());
+        renderThreads.setSliderStyle (Slider::IncDecButtons);
+        renderThreads.setTextBoxStyle (Slider::TextBoxLeft, false, 82, 22);
+        renderThreads.onValueChange = [this]() {
+            settings.setNumRenderThreads (roundToInt (renderThreads.getValue()));
+            if (engine != nullptr)
+                engine->applySettings (settings);
+        };
+
+        addAndMakeVisible (renderQuantumLabel);
+        renderQuantumLabel.setText ("Sub-block size", dontSendNotification);
+        renderQuantumLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (renderQuantum);
+        renderQuantum.textFromValueFunction = [] (double value) -> String {
+            return value < 1.0 ? String ("Off") : String (roundToInt (std::exp2 (value + 3.0)));
+        };
+        // steps of 16, 32, 64 ... 512 samples.
+        renderQuantum.setRange (0.0, 6.0, 1.0);
+        {
+            const int quantum = settings.getRenderQuantum();
+            renderQuantum.setValue (quantum <= 0 ? 0.0 : jlimit (1.0, 6.0, std::log2 ((double) quantum) - 3.0));
+        }
+        renderQuantum.setSliderStyle (Slider::IncDecButtons);
+        renderQuantum.setTextBoxStyle (Slider::TextBoxLeft, false, 82, 22);
+        renderQuantum.onValueChange = [this]() {
+            const int step = roundToInt (renderQuantum.getValue());
+            settings.setRenderQuantum (step <= 0 ? 0 : 1 << (step + 3));
+            if (engine != nullptr)
+                engine->applySettings (settings);
+        };
+
+        addAndMakeVisible (standbyGraphsLabel);
+        standbyGraphsLabel.setText ("Standby graphs", dontSendNotification);
+        standbyGraphsLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (standbyGraphs);
+        standbyGraphs.textFromValueFunction = [] (double value) -> String {
+            return value < 0.0 ? String ("All") : String (roundToInt (value));
+        };
+        standbyGraphs.setRange (-1.0, 16.0, 1.0);
+        standbyGraphs.setValue (jmin (16, settings.getStandbyGraphs()));
+        standbyGraphs.setSliderStyle (Slider::IncDecButtons);
+        standbyGraphs.setTextBoxStyle (Slider::TextBoxLeft, false, 82, 22);
+        standbyGraphs.onValueChange = [this]() {
+            settings.setStandbyGraphs (roundToInt (standbyGraphs.getValue()));
+            if (engine != nullptr)
+                engine->applySettings (settings);
+        };
+
+        addAndMakeVisible (looperSecondsLabel);
+        looperSecondsLabel.setText ("Looper length", dontSendNotification);
+        looperSecondsLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (looperSeconds);
+        looperSeconds.textFromValueFunction = [] (double value) -> String {
+            return String (roundToInt (value)) + " s";
+        };
+        looperSeconds.setRange (1.0, 600.0, 1.0);
+        looperSeconds.setValue (settings.getLooperSeconds());
+        looperSeconds.setSliderStyle (Slider::IncDecButtons);
+        looperSeconds.setTextBoxStyle (Slider::TextBoxLeft, false, 82, 22);
+        looperSeconds.onValueChange = [this]() {
+            settings.setLooperSeconds (roundToInt (looperSeconds.getValue()));
+            if (engine != nullptr)
+                engine->applySettings (settings);
+        };
+
+        addAndMakeVisible (realtimePriorityLabel);
+        realtimePriorityLabel.setText ("Realtime priority", dontSendNotification);
+        realtimePriorityLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (realtimePriority);
+        realtimePriority.textFromValueFunction = [] (double value) -> String {
+            return value < 1.0 ? String ("Default") : String (roundToInt (value));
+        };
+        realtimePriority.setRange (0.0, 99.0, 1.0);
+        realtimePriority.setValue (settings.getRealtimePriority());
+        realtimePriority.setSliderStyle (Slider::IncDecButtons);
+        realtimePriority.setTextBoxStyle (Slider::TextBoxLeft, false, 82, 22);
+        realtimePriority.onValueChange = [this]() {
+            settings.setRealtimePriority (roundToInt (realtimePriority.getValue()));
+            if (engine != nullptr)
+                engine->applySettings (settings);
+        };
+
+        for (auto* editor : { &realtimeCores, &backgroundCores })
+        {
+            addAndMakeVisible (editor);
+            editor->setTextToShowWhenEmpty ("Any", Colours::grey);
+            editor->setInputRestrictions (64, "0123456789,-");
+            editor->onReturnKey = [this]() { applyCoreSettings(); };
+            editor->onFocusLost = [this]() { applyCoreSettings(); };
+        }
+
+        addAndMakeVisible (realtimeCoresLabel);
+        realtimeCoresLabel.setText ("Realtime cores", dontSendNotification);
+        realtimeCoresLabel.setFont (Font (12.0, Font::bold));
+        realtimeCores.setText (settings.getRealtimeCores(), false);
+
+        addAndMakeVisible (backgroundCoresLabel);
+        backgroundCoresLabel.setText ("Background cores", dontSendNotification);
+        backgroundCoresLabel.setFont (Font (12.0, Font::bold));
+        backgroundCores.setText (settings.getBackgroundCores(), false);
+
+        addAndMakeVisible (flattenSubgraphsLabel);
+        flattenSubgraphsLabel.setText ("Flatten subgraphs", dontSendNotification);
+        flattenSubgraphsLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (flattenSubgraphs);
+        flattenSubgraphs.setClickingTogglesState (true);
+        flattenSubgraphs.setToggleState (settings.isFlatteningSubgraphs(), dontSendNotification);
+        flattenSubgraphs.getToggleStateValue().addListener (this);
+
+        addAndMakeVisible (guardNodeOutputsLabel);
+        guardNodeOutputsLabel.setText ("Guard node outputs", dontSendNotification);
+        guardNodeOutputsLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (guardNodeOutputs);
+        guardNodeOutputs.setClickingTogglesState (true);
+        guardNodeOutputs.setToggleState (settings.isGuardingNodeOutputs(), dontSendNotification);
+        guardNodeOutputs.getToggleStateValue().addListener (this);
+
         addAndMakeVisible (legacyCtlLabel);
         legacyCtlLabel.setText ("Enable legacy controllers?", dontSendNotification);
         addAndMakeVisible (legacyCtl);
@@ -543,6 +668,15 @@ public:
 
         layoutSetting (r, systrayLabel, systray);
         layoutSetting (r, desktopScaleLabel, desktopScale, getWidth() / 4);
+        layoutSetting (r, renderThreadsLabel, renderThreads, getWidth() / 4);
+        layoutSetting (r, renderQuantumLabel, renderQuantum, getWidth() / 4);
+        layoutSetting (r, flattenSubgraphsLabel, flattenSubgraphs);
+        layoutSetting (r, guardNodeOutputsLabel, guardNodeOutputs);
+        layoutSetting (r, standbyGraphsLabel, standbyGraphs, getWidth() / 4);
+        layoutSetting (r, looperSecondsLabel, looperSeconds, getWidth() / 4);
+        layoutSetting (r, realtimePriorityLabel, realtimePriority, getWidth() / 4);
+        layoutSetting (r, realtimeCoresLabel, realtimeCores, getWidth() / 4);
+        layoutSetting (r, backgroundCoresLabel, backgroundCores, getWidth() / 4);
         layoutSetting (r, legacyCtlLabel, legacyCtl);
 
 #if ! ELEMENT_SE
@@ -571,6 +705,18 @@ public:
         {
             settings.set ("legacyControllers", legacyCtl.getToggleState());
         }
+        else if (value.refersToSameSourceAs (flattenSubgraphs.getToggleStateValue()))
+        {
+            settings.setFlattenSubgraphs (flattenSubgraphs.getToggleState());
+            if (engine != nullptr)
+                engine->applySettings (settings);
+        }
+        else if (value.refersToSameSourceAs (guardNodeOutputs.getToggleStateValue()))
+        {
+            settings.setGuardNodeOutputs (guardNodeOutputs.getToggleState());
+            if (engine != nullptr)
+                engine->applySettings (settings);
+        }
         // clock source
         else if (value.refersToSameSourceAs (clockSource))
         {
@@ -674,6 +820,31 @@ private:
     Label desktopScaleLabel;
     Slider desktopScale;
 
+    Label renderThreadsLabel;
+    Slider renderThreads;
+    Label renderQuantumLabel;
+    Slider renderQuantum;
+    Label flattenSubgraphsLabel;
+    SettingButton flattenSubgraphs;
+    Label guardNodeOutputsLabel;
+    SettingButton guardNodeOutputs;
+    Label standbyGraphsLabel;
+    Slider standbyGraphs;
+    Label looperSecondsLabel;
+    Slider looperSeconds;
+    Label realtimePriorityLabel;
+    Slider realtimePriority;
+    Label realtimeCoresLabel, backgroundCoresLabel;
+    TextEditor realtimeCores, backgroundCores;
+
+    void applyCoreSettings()
+    {
+        settings.setRealtimeCores (realtimeCores.getText());
+        settings.setBackgroundCores (backgroundCores.getText());
+        if (engine != nullptr)
+            engine->applySettings (settings);
+    }
+
     Label mainContentLabel;
     ComboBox mainContentBox;
 
@@ -689,12 +860,24 @@ private:
 class AudioSettingsComponent : public SettingsPage
 {
 public:
-    AudioSettingsComponent (DeviceManager& d)
+    AudioSettingsComponent (DeviceManager& d, Settings& s)
         : devs (d, 1, DeviceManager::maxAudioChannels, 1, DeviceManager::maxAudioChannels, false, false, false, false),
-          devices (d)
+          devices (d),
+          settings (s)
     {
         addAndMakeVisible (devs);
         devs.setItemHeight (22);
+
+        addAndMakeVisible (aggregateLabel);
+        aggregateLabel.setText ("Aggregate devices", dontSendNotification);
+        aggregateLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (aggregate);
+        aggregate.setMultiLine (true, false);
+        aggregate.setReturnKeyStartsNewLine (true);
+        aggregate.setTextToShowWhenEmpty ("One device per line, the clock first", Colours::grey);
+        aggregate.setText (settings.getAggregateDevices().joinIntoString ("\n"), false);
+        aggregate.onFocusLost = [this]() { applyAggregate(); };
+
         setSize (300, 400);
     }
 
@@ -702,12 +885,31 @@ public:
     {
     }
 
-    void resized() override { devs.setBounds (getLocalBounds()); }
+    void resized() override
+    {
+        auto r = getLocalBounds();
+        aggregate.setBounds (r.removeFromBottom (66));
+        aggregateLabel.setBounds (r.removeFromBottom (22));
+        devs.setBounds (r);
+    }
 
 private:
     // element::AudioDeviceSelectorComponent devs;
     juce::AudioDeviceSelectorComponent devs;
-    [[maybe_unused]] DeviceManager& devices;
+    DeviceManager& devices;
+    Settings& settings;
+    Label aggregateLabel;
+    TextEditor aggregate;
+
+    void applyAggregate()
+    {
+        StringArray names;
+        names.addLines (aggregate.getText());
+        names.trim();
+        names.removeEmptyStrings();
+        settings.setAggregateDevices (names);
+        devices.setAggregateMembers (names);
+    }
 };
 
 //==============================================================================
@@ -1847,7 +2049,7 @@ Component* Preferences::createPageForName (const String& name)
     }
     else if (name == EL_AUDIO_SETTINGS_NAME)
     {
-        return new AudioSettingsComponent (_context.devices());
+        return new AudioSettingsComponent (_context.devices(), _context.settings());
     }
     else if (name == EL_PLUGINS_PREFERENCE_NAME)
     {
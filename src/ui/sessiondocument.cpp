@@ -2,10 +2,26 @@
 // SPDX-License-Identifier: GPL3-or-later
 
 #include <element/session.hpp>
+#include "session/sessionprofile.hpp"
 #include "ui/sessiondocument.hpp"
 
 namespace element {
 
+namespace {
+// nodes fill in what they're missing when first constructed.
+void setupNodes (const ValueTree& tree)
+{
+    if (tree.hasType (types::Node))
+    {
+        const Node node (tree, true);
+        juce::ignoreUnused (node);
+    }
+
+    for (int i = 0; i < tree.getNumChildren(); ++i)
+        setupNodes (tree.getChild (i));
+}
+} // namespace
+
 SessionDocument::SessionDocument (SessionPtr s)
     : FileBasedDocument (".els", "*.els", "Open Session", "Save Session"),
       session (s)
@@ -25,18 +41,15 @@ String SessionDocument::getDocumentTitle()
     return (session != nullptr) ? session->getName() : "Unknown";
 }
 
-Result SessionDocument::loadDocument (const File& file)
+ValueTree SessionDocument::readSession (const File& file, String& error)
 {
-    if (nullptr == session)
-        return Result::fail ("No session data target");
-
-    String error;
-    if (auto e = XmlDocument::parse (file))
+    ValueTree newData (Session::readFromFile (file));
+    if (newData.isValid())
     {
-        ValueTree newData (ValueTree::fromXml (*e));
         if (newData.isValid() && (int) newData.getProperty (tags::version, -1) != EL_SESSION_VERSION)
         {
             std::clog << "[element] migrate session...\n";
+            SessionProfile::Timer timer (SessionProfile::migrate);
             newData = Session::migrate (newData, error);
         }
 
@@ -46,24 +59,28 @@ Result SessionDocument::loadDocument (const File& file)
             if (newData.isValid())
                 error << ": el." << newData.getType().toString();
         }
-
-        if (error.isEmpty() && ! session->loadData (newData))
-            error = "Could not load session data";
     }
     else
     {
         error = "Not a valid session file";
     }
 
-    if (error.isEmpty())
-    {
-        session->forEach ([&] (const ValueTree& d) {
-            if (! d.hasType (types::Node))
-                return;
-            const Node node (d, true);
-            juce::ignoreUnused (node);
-        });
-    }
+    if (error.isNotEmpty())
+        return {};
+
+    setupNodes (newData);
+    return newData;
+}
+
+Result SessionDocument::loadDocument (const File& file)
+{
+    if (nullptr == session)
+        return Result::fail ("No session data target");
+
+    String error;
+    ValueTree newData (readSession (file, error));
+    if (error.isEmpty() && ! session->loadData (newData))
+        error = "Could not load session data";
 
     return (error.isNotEmpty()) ? Result::fail (error) : Result::ok();
 }
@@ -74,15 +91,8 @@ Result SessionDocument::saveDocument (const File& file)
         return Result::fail ("Nil session");
 
     session->saveGraphState();
-    if (auto e = session->createXml())
-    {
-        Result res (e->writeTo (file)
-                        ? Result::ok()
-                        : Result::fail ("Error writing session file"));
-        return res;
-    }
-
-    return Result::fail ("Could not create session data");
+    return session->writeToFile (file, compressionLevel) ? Result::ok()
+                                       : Result::fail ("Error writing session file");
 }
 
 File SessionDocument::getLastDocumentOpened() { return lastSession; }
@@ -26,9 +26,19 @@ public:
 
     void changeListenerCallback (ChangeBroadcaster*) override;
 
+    /** Read a session file, migrating it if it's older, without loading it
+        into a session. Returns an invalid tree and sets error if it isn't
+        a session.
+     */
+    static ValueTree readSession (const File& file, String& error);
+
+    /** Sets the deflate level sessions are saved with, 0 to 9. */
+    void setCompressionLevel (int level) noexcept { compressionLevel = level; }
+
 private:
     SessionPtr session;
     File lastSession;
+    int compressionLevel = 1;
     friend class Session;
     void onSessionChanged();
 };
@@ -151,16 +151,15 @@ SessionImportWizard::~SessionImportWizard()
 
 void SessionImportWizard::loadSession (const File& file)
 {
+    // chunked sessions are mapped and only their model is read, plugin
+    // states are decoded once an imported graph creates its nodes.
     SessionPtr newSession;
     bool loaded = false;
-    if (auto e = XmlDocument::parse (file))
+    const auto newData = Session::readFromFile (file);
+    if (newData.isValid() && newData.hasType (types::Session))
     {
-        ValueTree newData (ValueTree::fromXml (*e));
-        if (newData.isValid() && newData.hasType (types::Session))
-        {
-            newSession = new Session();
-            loaded = newSession->loadData (newData);
-        }
+        newSession = new Session();
+        loaded = newSession->loadData (newData);
     }
 
     if (newSession != nullptr && loaded)
@@ -164,7 +164,12 @@ public:
         ValueTree child (n.data());
         ValueTree parent (child.getParent());
 
-        if (parent.isValid())
+        // the uuid stays put when siblings are added or removed around it.
+        if (n.getUuidString().isNotEmpty())
+        {
+            setUniqueName (n.getUuidString());
+        }
+        else if (parent.isValid())
         {
             setUniqueName (String (parent.indexOf (child)));
         }
@@ -530,10 +535,16 @@ private:
 class SessionGraphTreeItem : public SessionNodeTreeItem
 {
 public:
+    /** Graphs with more nodes than this start closed, their items are
+        made when opened. */
+    static constexpr int maxNodesOpenByDefault = 64;
+
     SessionGraphTreeItem (const Node& n)
         : SessionNodeTreeItem (n)
     {
         jassert (n.isGraph());
+        if (n.getNumNodes() > maxNodesOpenByDefault)
+            setOpenness (Openness::opennessClosed);
     }
 
     //=========================================================================
@@ -541,22 +552,59 @@ public:
 
     void addSubItems() override
     {
-        const auto n = getNode();
-        const auto nodes (n.getNodesValueTree());
+        const auto nodes (getNode().getNodesValueTree());
         for (int i = 0; i < nodes.getNumChildren(); ++i)
         {
             const Node c (nodes.getChild (i), false);
-            if (c.isIONode())
-                continue;
-
-            if (c.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_SCRIPT))
-                addSubItem (new SessionScriptNodeTreeItem (c));
-            else if (c.isGraph())
-                addSubItem (new SessionGraphTreeItem (c));
-            else
-                addSubItem (new SessionNodeTreeItem (c));
+            if (! c.isIONode())
+                addSubItem (createItem (c));
+        }
+    }
+
+    /** Adds the item for a node just added to the graph. Closed graphs
+        have no sub items and are left alone.
+     */
+    void nodeAdded (const Node& child)
+    {
+        if (! isOpen() || child.isIONode())
+            return;
+
+        // IO nodes aren't listed, and scripts of a root graph come after nodes.
+        const auto nodes (getNode().getNodesValueTree());
+        const int childIndex = nodes.indexOf (child.data());
+        int index = 0;
+        for (int i = 0; i < childIndex; ++i)
+            if (! Node (nodes.getChild (i), false).isIONode())
+                ++index;
+
+        addSubItem (createItem (child), index);
+    }
+
+    /** Removes the item of a node just removed from the graph. */
+    void nodeRemoved (const ValueTree& child)
+    {
+        for (int i = getNumSubItems(); --i >= 0;)
+        {
+            if (auto* const item = dynamic_cast<SessionNodeTreeItem*> (getSubItem (i)))
+            {
+                if (item->getNode().data() == child)
+                {
+                    removeSubItem (i);
+                    break;
+                }
+            }
         }
     }
+
+private:
+    static TreeViewItem* createItem (const Node& c)
+    {
+        if (c.isA (EL_NODE_FORMAT_NAME, EL_NODE_ID_SCRIPT))
+            return new SessionScriptNodeTreeItem (c);
+        if (c.isGraph())
+            return new SessionGraphTreeItem (c);
+        return new SessionNodeTreeItem (c);
+    }
 };
 
 //=============================================================================
@@ -813,6 +861,32 @@ public:
         }
     }
 
+    /** Adds the item for a graph just added to the session. */
+    void graphAdded (const Node& graph)
+    {
+        auto session = panel.session();
+        if (session == nullptr)
+            return;
+        const int index = session->getGraphsValueTree().indexOf (graph.data());
+        addSubItem (new SessionRootGraphTreeItem (graph), index);
+    }
+
+    /** Removes the item of a graph just removed from the session. */
+    void graphRemoved (const ValueTree& graph)
+    {
+        for (int i = getNumSubItems(); --i >= 0;)
+        {
+            if (auto* const item = dynamic_cast<SessionNodeTreeItem*> (getSubItem (i)))
+            {
+                if (item->getNode().data() == graph)
+                {
+                    removeSubItem (i);
+                    break;
+                }
+            }
+        }
+    }
+
     virtual bool mightContainSubItems() override { return true; }
     virtual String getRenamingName() const override { return getDisplayName(); }
     virtual String getDisplayName() const override { return "Session"; }
@@ -916,6 +990,13 @@ void SessionTreePanel::mouseDown (const MouseEvent& ev) {}
 
 void SessionTreePanel::setSession (SessionPtr s)
 {
+    // already listening to this session, the items are up to date.
+    if (s != nullptr && s == _session && ! showingNode() && data == s->data())
+    {
+        selectActiveRootGraph();
+        return;
+    }
+
     _session = s;
 
     if (! showingNode())
@@ -1036,19 +1117,11 @@ void SessionTreePanel::valueTreePropertyChanged (ValueTree& tree, const Identifi
     {
         const Node graph (tree, false);
         if (property == tags::name || (graph.isRootGraph() && property == tags::midiProgram))
-            repaint();
+            if (auto* const item = findItemForNode (graph))
+                item->repaintItem();
     }
 }
 
-static bool couldBeSessionObjects (ValueTree& parent, ValueTree& child)
-{
-    // clang-format off
-    return parent.hasType (types::Session) || 
-        (parent.hasType (tags::graphs) && child.hasType (types::Node)) || 
-        (parent.hasType (tags::nodes) && child.hasType (types::Node));
-    // clang-format on
-}
-
 static void refreshSubItems (TreeItemBase* item)
 {
     if (item == nullptr)
@@ -1064,10 +1137,24 @@ static void refreshSubItems (TreeItemBase* item)
     }
 }
 
+// Nodes and graphs are added and removed one item at a time, a rebuild of
+// the whole tree on every edit gets slow with big sessions.
 void SessionTreePanel::valueTreeChildAdded (ValueTree& parent, ValueTree& child)
 {
-    if (couldBeSessionObjects (parent, child))
+    if (parent.hasType (types::Session))
+    {
         refreshSubItems (panel->rootItem.get());
+    }
+    else if (child.hasType (types::Node) && parent.hasType (tags::graphs))
+    {
+        if (auto* const root = dynamic_cast<SessionRootTreeItem*> (panel->rootItem.get()))
+            root->graphAdded (Node (child, false));
+    }
+    else if (child.hasType (types::Node) && parent.hasType (tags::nodes))
+    {
+        if (auto* const item = dynamic_cast<SessionGraphTreeItem*> (findItemForNode (Node (parent.getParent(), false))))
+            item->nodeAdded (Node (child, false));
+    }
 
     if (child.hasType (types::Node))
     {
@@ -1093,13 +1180,36 @@ void SessionTreePanel::valueTreeChildAdded (ValueTree& parent, ValueTree& child)
 
 void SessionTreePanel::valueTreeChildRemoved (ValueTree& parent, ValueTree& child, int indexRemovedAt)
 {
-    if (couldBeSessionObjects (parent, child))
+    ignoreUnused (indexRemovedAt);
+    if (parent.hasType (types::Session))
+    {
         refreshSubItems (panel->rootItem.get());
+    }
+    else if (child.hasType (types::Node) && parent.hasType (tags::graphs))
+    {
+        if (auto* const root = dynamic_cast<SessionRootTreeItem*> (panel->rootItem.get()))
+            root->graphRemoved (child);
+    }
+    else if (child.hasType (types::Node) && parent.hasType (tags::nodes))
+    {
+        if (auto* const item = dynamic_cast<SessionGraphTreeItem*> (findItemForNode (Node (parent.getParent(), false))))
+            item->nodeRemoved (child);
+    }
 }
 
 void SessionTreePanel::valueTreeChildOrderChanged (ValueTree& parent, int oldIndex, int newIndex)
 {
-    refreshSubItems (panel->rootItem.get());
+    ignoreUnused (oldIndex, newIndex);
+    if (parent.hasType (tags::graphs))
+    {
+        refreshSubItems (panel->rootItem.get());
+    }
+    else if (parent.hasType (tags::nodes))
+    {
+        if (auto* const item = dynamic_cast<SessionGraphTreeItem*> (findItemForNode (Node (parent.getParent(), false))))
+            if (item->isOpen())
+                item->refreshSubItems();
+    }
 }
 
 void SessionTreePanel::valueTreeParentChanged (ValueTree& tree)
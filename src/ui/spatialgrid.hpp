@@ -0,0 +1,148 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <element/juce/graphics.hpp>
+
+namespace element {
+
+/** Items bucketed by their bounds on a uniform grid.
+
+    Finding what is under a point or inside an area only looks at the
+    cells it covers, instead of every item. Moving an item touches the
+    cells it left and entered. A grid suits a graph editor better than a
+    tree: blocks are similar in size and spread over a bounded canvas.
+ */
+template <typename Item>
+class SpatialGrid final
+{
+public:
+    explicit SpatialGrid (int cellSizeToUse = 128)
+        : cellSize (juce::jmax (1, cellSizeToUse)) {}
+
+    void clear()
+    {
+        cells.clear();
+        bounds.clear();
+    }
+
+    int size() const noexcept { return (int) bounds.size(); }
+    bool contains (Item item) const { return bounds.find (item) != bounds.end(); }
+
+    /** Adds an item, or moves it if already added. */
+    void set (Item item, juce::Rectangle<int> area)
+    {
+        auto iter = bounds.find (item);
+        if (iter != bounds.end())
+        {
+            if (iter->second == area)
+                return;
+            unlink (item, iter->second);
+            iter->second = area;
+        }
+        else
+        {
+            bounds.emplace (item, area);
+        }
+
+        forEachCell (area, [this, item] (juce::int64 key) { cells[key].push_back (item); });
+    }
+
+    void remove (Item item)
+    {
+        auto iter = bounds.find (item);
+        if (iter == bounds.end())
+            return;
+        unlink (item, iter->second);
+        bounds.erase (iter);
+    }
+
+    /** Calls fn once with each item intersecting an area, in no particular order. */
+    template <typename Fn>
+    void visit (juce::Rectangle<int> area, Fn&& fn) const
+    {
+        if (area.isEmpty())
+            return;
+
+        forEachCell (area, [&] (juce::int64 key) {
+            auto cell = cells.find (key);
+            if (cell == cells.end())
+                return;
+
+            for (const auto& item : cell->second)
+            {
+                // an item spanning cells is reported by the cell holding
+                // the corner of its overlap with the area.
+                const auto overlap = bounds.at (item).getIntersection (area);
+                if (! overlap.isEmpty() && cellKey (overlap.getX(), overlap.getY()) == key)
+                    fn (item);
+            }
+        });
+    }
+
+    /** Returns the items intersecting an area. */
+    std::vector<Item> find (juce::Rectangle<int> area) const
+    {
+        std::vector<Item> found;
+        visit (area, [&found] (Item item) { found.push_back (item); });
+        return found;
+    }
+
+    /** Returns the items whose bounds contain a point. */
+    std::vector<Item> find (juce::Point<int> point) const
+    {
+        return find (juce::Rectangle<int> (point.x, point.y, 1, 1));
+    }
+
+private:
+    const int cellSize;
+    std::unordered_map<juce::int64, std::vector<Item>> cells;
+    std::unordered_map<Item, juce::Rectangle<int>> bounds;
+
+    int cellOf (int v) const noexcept
+    {
+        return v >= 0 ? v / cellSize : (v - cellSize + 1) / cellSize;
+    }
+
+    juce::int64 cellKey (int x, int y) const noexcept
+    {
+        return ((juce::int64) cellOf (x) << 32) | (juce::uint32) cellOf (y);
+    }
+
+    template <typename Fn>
+    void forEachCell (juce::Rectangle<int> area, Fn&& fn) const
+    {
+        const int x1 = cellOf (area.getX()), x2 = cellOf (area.getRight() - (area.getWidth() > 0 ? 1 : 0));
+        const int y1 = cellOf (area.getY()), y2 = cellOf (area.getBottom() - (area.getHeight() > 0 ? 1 : 0));
+        for (int cx = x1; cx <= x2; ++cx)
+            for (int cy = y1; cy <= y2; ++cy)
+                fn (((juce::int64) cx << 32) | (juce::uint32) cy);
+    }
+
+    void unlink (Item item, juce::Rectangle<int> area)
+    {
+        forEachCell (area, [this, item] (juce::int64 key) {
+            auto cell = cells.find (key);
+            if (cell == cells.end())
+                return;
+            auto& items = cell->second;
+            for (size_t i = 0; i < items.size(); ++i)
+            {
+                if (items[i] == item)
+                {
+                    items[i] = items.back();
+                    items.pop_back();
+                    break;
+                }
+            }
+            if (items.empty())
+                cells.erase (cell);
+        });
+    }
+};
+
+} // namespace element
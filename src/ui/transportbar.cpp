@@ -8,6 +8,8 @@
 
 namespace element {
 
+static constexpr int refreshMillis = 88;
+
 class BarLabel : public DragableIntLabel
 {
 public:
@@ -90,11 +92,14 @@ TransportBar::TransportBar()
     setSize (280, 16);
     updateWidth();
 
-    startTimer (88);
+    activity->addListener (this);
+    if (activity->isActive())
+        startTimer (refreshMillis);
 }
 
 TransportBar::~TransportBar()
 {
+    activity->removeListener (this);
     play = nullptr;
     stop = nullptr;
     record = nullptr;
@@ -118,6 +123,14 @@ bool TransportBar::checkForMonitor()
     return monitor != nullptr;
 }
 
+void TransportBar::uiActivityChanged (bool isActive)
+{
+    if (isActive)
+        startTimer (refreshMillis);
+    else
+        stopTimer();
+}
+
 void TransportBar::timerCallback()
 {
     if (! checkForMonitor())
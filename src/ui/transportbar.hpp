@@ -5,6 +5,7 @@
 
 #include "ElementApp.h"
 #include "ui/buttons.hpp"
+#include "ui/uiactivity.hpp"
 #include <element/audioengine.hpp>
 #include <element/session.hpp>
 
@@ -13,7 +14,8 @@ namespace element {
 class BarLabel;
 class TransportBar : public Component,
                      private Button::Listener,
-                     private Timer
+                     private Timer,
+                     private UIActivity::Listener
 {
 public:
     TransportBar();
@@ -30,6 +32,7 @@ private:
     SessionPtr session;
     AudioEnginePtr engine;
     Transport::MonitorPtr monitor;
+    SharedResourcePointer<UIActivity> activity;
 
     std::unique_ptr<SettingButton> play, stop, record, toZero;
     std::unique_ptr<DragableIntLabel> barLabel, beatLabel, subLabel;
@@ -39,6 +42,7 @@ private:
 
     void buttonClicked (Button* buttonThatWasClicked) override;
     void timerCallback() override;
+    void uiActivityChanged (bool isActive) override;
 
     bool checkForMonitor();
 
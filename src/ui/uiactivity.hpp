@@ -0,0 +1,48 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/events.hpp>
+
+namespace element {
+
+/** Whether the main window can be seen.
+
+    While it is minimised or hidden in the system tray, views that only
+    refresh what is on screen stop their timers, and start them again
+    when it comes back. Audio is not affected. The main window sets it,
+    hold one in a juce::SharedResourcePointer to follow it. Message
+    thread only.
+ */
+class UIActivity final
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        /** Called when the main window is shown or hidden. */
+        virtual void uiActivityChanged (bool isActive) = 0;
+    };
+
+    bool isActive() const noexcept { return active; }
+
+    void setActive (bool nowActive)
+    {
+        if (active == nowActive)
+            return;
+        active = nowActive;
+        listeners.call ([nowActive] (Listener& l) { l.uiActivityChanged (nowActive); });
+    }
+
+    void addListener (Listener* listener) { listeners.add (listener); }
+    void removeListener (Listener* listener) { listeners.remove (listener); }
+
+private:
+    bool active = true;
+    juce::ListenerList<Listener> listeners;
+};
+
+} // namespace element
@@ -0,0 +1,64 @@
+#include <boost/test/unit_test.hpp>
+#include "nodes/eqfilter.hpp"
+
+using namespace element;
+
+namespace {
+
+void setup (EQFilter& filter, float freq)
+{
+    filter.setFrequency (freq);
+    filter.setQ (0.707f);
+    filter.setGain (2.f);
+    filter.setShape (EQFilter::LowShelf);
+    filter.reset (44100.0);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (EQFilterTests)
+
+BOOST_AUTO_TEST_CASE (ChannelsMatchSingle)
+{
+    // three channels so the pair and single paths both run.
+    constexpr int numChannels = 3, numSamples = 700;
+    AudioBuffer<float> multi (numChannels, numSamples);
+    Random rng (1234);
+    for (int c = 0; c < numChannels; ++c)
+        for (int i = 0; i < numSamples; ++i)
+            multi.setSample (c, i, rng.nextFloat() * 2.f - 1.f);
+    AudioBuffer<float> single (multi);
+
+    EQFilter filter;
+    setup (filter, 500.f);
+    EQFilter mono[numChannels];
+    for (auto& f : mono)
+        setup (f, 500.f);
+
+    // a parameter change smooths over part of the second block.
+    for (int block = 0; block < 2; ++block)
+    {
+        const int start = block * (numSamples / 2);
+        const int num = numSamples / 2;
+        if (block == 1)
+        {
+            filter.setFrequency (2000.f);
+            for (auto& f : mono)
+                f.setFrequency (2000.f);
+        }
+
+        float* chans[numChannels];
+        for (int c = 0; c < numChannels; ++c)
+            chans[c] = multi.getWritePointer (c, start);
+        filter.processBlock (chans, numChannels, num);
+
+        for (int c = 0; c < numChannels; ++c)
+            mono[c].processBlock (single.getWritePointer (c, start), num);
+    }
+
+    for (int c = 0; c < numChannels; ++c)
+        for (int i = 0; i < numSamples; ++i)
+            BOOST_REQUIRE_SMALL (multi.getSample (c, i) - single.getSample (c, i), 0.00001f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,10 +1,12 @@
 #include <boost/test/unit_test.hpp>
 
 #include <element/context.hpp>
+#include <element/transport.hpp>
 
 #include "fixture/PreparedGraph.h"
 #include "fixture/TestNode.h"
 #include "engine/graphnode.hpp"
+#include "engine/ionode.hpp"
 #include "utils.hpp"
 
 using namespace element;
@@ -77,4 +79,331 @@ BOOST_AUTO_TEST_CASE (AddRemove)
     BOOST_REQUIRE (graph.removeNode (node->nodeId));
 }
 
+BOOST_AUTO_TEST_CASE (BatchedRemove)
+{
+    PreparedGraph fix;
+    GraphNode& graph = fix.graph;
+    ProcessorPtr a = graph.addNode (new TestNode());
+    ProcessorPtr b = graph.addNode (new TestNode());
+    graph.rebuild();
+
+    graph.beginUpdate();
+    BOOST_REQUIRE (graph.removeNode (a->nodeId));
+    BOOST_REQUIRE (graph.removeNode (b->nodeId));
+    BOOST_REQUIRE_EQUAL (graph.getNumNodes(), 0);
+
+    // still in the published sequence until the batch ends.
+    BOOST_REQUIRE (a->getParentGraph() == &graph);
+    BOOST_REQUIRE (b->getParentGraph() == &graph);
+
+    graph.endUpdate();
+    BOOST_REQUIRE (a->getParentGraph() == nullptr);
+    BOOST_REQUIRE (b->getParentGraph() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE (Lookup)
+{
+    PreparedGraph fix;
+    GraphNode& graph = fix.graph;
+    ReferenceCountedArray<Processor> added;
+    for (int i = 0; i < 8; ++i)
+        added.add (graph.addNode (new TestNode (2, 2, 0, 0)));
+    for (int i = 1; i < added.size(); ++i)
+        BOOST_REQUIRE (graph.connectChannels (PortType::Audio, added[i - 1]->nodeId, 0, added[i]->nodeId, 0));
+
+    // removing from the middle moves the nodes after it.
+    const auto removed = added[3]->nodeId;
+    BOOST_REQUIRE (graph.removeNode (removed));
+    BOOST_REQUIRE (graph.getNodeForId (removed) == nullptr);
+    BOOST_REQUIRE (! graph.removeNode (removed));
+    for (int i = 0; i < added.size(); ++i)
+        if (i != 3)
+            BOOST_REQUIRE (graph.getNodeForId (added[i]->nodeId) == added[i]);
+
+    BOOST_REQUIRE_EQUAL (graph.getNumConnections(), 5);
+    BOOST_REQUIRE (! graph.isConnected (added[2]->nodeId, added[3]->nodeId));
+    BOOST_REQUIRE (graph.isConnected (added[4]->nodeId, added[5]->nodeId));
+
+    BOOST_REQUIRE (graph.connectChannels (PortType::Audio, added[2]->nodeId, 0, added[4]->nodeId, 0));
+    BOOST_REQUIRE (! graph.connectChannels (PortType::Audio, added[2]->nodeId, 0, added[4]->nodeId, 0));
+
+    const auto port = added[5]->getPortForChannel (PortType::Audio, 0, true);
+    BOOST_REQUIRE (graph.removeConnection (added[4]->nodeId, added[4]->getPortForChannel (PortType::Audio, 0, false), added[5]->nodeId, port));
+    BOOST_REQUIRE (! graph.isConnected (added[4]->nodeId, added[5]->nodeId));
+
+    BOOST_REQUIRE (graph.disconnectNode (added[6]->nodeId));
+    BOOST_REQUIRE (! graph.disconnectNode (added[6]->nodeId));
+    BOOST_REQUIRE_EQUAL (graph.getNumConnections(), 3);
+    BOOST_REQUIRE (! graph.removeIllegalConnections (added[1]->nodeId));
+    BOOST_REQUIRE_EQUAL (graph.getNumConnections(), 3);
+
+    BOOST_REQUIRE (graph.replaceNode (added[0]->nodeId, new TestNode (2, 2, 0, 0)));
+    BOOST_REQUIRE (graph.getNodeForId (added[0]->nodeId) != added[0]);
+    BOOST_REQUIRE (graph.isConnected (added[0]->nodeId, added[1]->nodeId));
+}
+
+static void connectThrough (GraphNode& graph)
+{
+    auto* audioIn = graph.addNode (new IONode (IONode::audioInputNode));
+    auto* audioOut = graph.addNode (new IONode (IONode::audioOutputNode));
+    auto* midiIn = graph.addNode (new IONode (IONode::midiInputNode));
+    auto* midiOut = graph.addNode (new IONode (IONode::midiOutputNode));
+    for (int c = 0; c < 2; ++c)
+        BOOST_REQUIRE (graph.connectChannels (PortType::Audio, audioIn->nodeId, c, audioOut->nodeId, c));
+    BOOST_REQUIRE (graph.connectChannels (PortType::Midi, midiIn->nodeId, 0, midiOut->nodeId, 0));
+}
+
+BOOST_AUTO_TEST_CASE (SubBlocks)
+{
+    PreparedGraph fix;
+    GraphNode& graph = fix.graph;
+    connectThrough (graph);
+    graph.setRenderQuantum (32);
+    graph.rebuild();
+
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer audio, cv;
+    audio.setSize (2, 100, false, true, false);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+            audio.setSample (c, i, (float) (i + c * 1000));
+    midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 5);
+    midi.addEvent (MidiMessage::noteOff (1, 60), 70);
+
+    RenderContext rc (audio, cv, midi, atoms, audio.getNumSamples());
+    graph.render (rc);
+
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+            BOOST_REQUIRE_EQUAL (audio.getSample (c, i), (float) (i + c * 1000));
+
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 2);
+    BOOST_REQUIRE_EQUAL (midi.getFirstEventTime(), 5);
+    BOOST_REQUIRE_EQUAL (midi.getLastEventTime(), 70);
+}
+
+BOOST_AUTO_TEST_CASE (Scratch)
+{
+    PreparedGraph fix (44100.0, 256);
+    GraphNode& graph = fix.graph;
+    connectThrough (graph);
+    graph.rebuild();
+
+    const auto info = graph.getScratchInfo();
+    BOOST_REQUIRE_EQUAL (info.maxBlockSize, 256);
+    BOOST_REQUIRE (info.audioBytes >= sizeof (float) * 256);
+    BOOST_REQUIRE_EQUAL (info.audioBytes % 64, (size_t) 0);
+    BOOST_REQUIRE (info.getTotalBytes() >= info.audioBytes);
+
+    // blocks longer than the scratch buffers are rendered in pieces.
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer audio, cv;
+    audio.setSize (2, 600, false, true, false);
+    for (int i = 0; i < audio.getNumSamples(); ++i)
+        audio.setSample (0, i, (float) i);
+    midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 300);
+
+    RenderContext rc (audio, cv, midi, atoms, audio.getNumSamples());
+    graph.render (rc);
+
+    for (int i = 0; i < audio.getNumSamples(); ++i)
+        BOOST_REQUIRE_EQUAL (audio.getSample (0, i), (float) i);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+    BOOST_REQUIRE_EQUAL (midi.getFirstEventTime(), 300);
+}
+
+BOOST_AUTO_TEST_CASE (Flatten)
+{
+    PreparedGraph fix;
+    GraphNode& graph = fix.graph;
+    auto* sub = new GraphNode (*element::test::context());
+    graph.addNode (sub);
+    connectThrough (*sub);
+    sub->rebuild();
+
+    auto* audioIn = graph.addNode (new IONode (IONode::audioInputNode));
+    auto* audioOut = graph.addNode (new IONode (IONode::audioOutputNode));
+    for (int c = 0; c < 2; ++c)
+    {
+        BOOST_REQUIRE (graph.connectChannels (PortType::Audio, audioIn->nodeId, c, sub->nodeId, c));
+        BOOST_REQUIRE (graph.connectChannels (PortType::Audio, sub->nodeId, c, audioOut->nodeId, c));
+    }
+
+    BOOST_REQUIRE (sub->isFlattenable());
+    BOOST_REQUIRE (! graph.isFlattenable());
+    graph.setFlattenSubgraphs (true);
+    graph.rebuild();
+
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer audio, cv;
+    audio.setSize (2, 128, false, true, false);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+            audio.setSample (c, i, (float) (i + c * 1000));
+
+    RenderContext rc (audio, cv, midi, atoms, audio.getNumSamples());
+    graph.render (rc);
+
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+            BOOST_REQUIRE_EQUAL (audio.getSample (c, i), (float) (i + c * 1000));
+
+    sub->setMuted (true);
+    BOOST_REQUIRE (! sub->isFlattenable());
+    sub->setMuted (false);
+}
+
+namespace {
+/** Outputs a ramp that starts over whenever it's prepared. */
+class RampNode : public TestNode
+{
+public:
+    RampNode() : TestNode (0, 2, 0, 0) {}
+
+    void prepareToRender (double newSampleRate, int newBlockSize) override
+    {
+        TestNode::prepareToRender (newSampleRate, newBlockSize);
+        frame = 0;
+    }
+
+    void render (RenderContext& rc) override
+    {
+        for (int i = 0; i < rc.audio.getNumSamples(); ++i, ++frame)
+            for (int c = 0; c < rc.audio.getNumChannels(); ++c)
+                rc.audio.setSample (c, i, (float) frame * 1.0e-4f);
+    }
+
+    int frame = 0;
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE (PrepareGraphs)
+{
+    GraphNode a (*element::test::context()), b (*element::test::context());
+    auto* ramp = a.addNode (new RampNode());
+    b.addNode (new TestNode());
+    b.addNode (new TestNode());
+
+    GraphNode::prepareGraphs ({ &a, &b }, 48000.0, 256);
+    BOOST_REQUIRE (a.prepared());
+    BOOST_REQUIRE (b.prepared());
+    BOOST_REQUIRE_EQUAL (ramp->getSampleRate(), 48000.0);
+    BOOST_REQUIRE_EQUAL (b.getBlockSize(), 256);
+
+    a.releaseResources();
+    b.releaseResources();
+    a.clear();
+    b.clear();
+}
+
+BOOST_AUTO_TEST_CASE (Freeze)
+{
+    PreparedGraph fix (44100.0, 128);
+    GraphNode& graph = fix.graph;
+    auto* sub = new GraphNode (*element::test::context());
+    graph.addNode (sub);
+    auto* ramp = sub->addNode (new RampNode());
+    auto* subOut = sub->addNode (new IONode (IONode::audioOutputNode));
+    auto* audioOut = graph.addNode (new IONode (IONode::audioOutputNode));
+    for (int c = 0; c < 2; ++c)
+    {
+        BOOST_REQUIRE (sub->connectChannels (PortType::Audio, ramp->nodeId, c, subOut->nodeId, c));
+        BOOST_REQUIRE (graph.connectChannels (PortType::Audio, sub->nodeId, c, audioOut->nodeId, c));
+    }
+    sub->rebuild();
+    graph.rebuild();
+
+    Transport transport;
+    transport.setSampleRate (44100.0);
+    transport.requestPlayState (true);
+    graph.setPlayHead (&transport);
+
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer audio (2, 128), cv;
+    auto renderBlock = [&]() {
+        audio.clear();
+        transport.preProcess (128);
+        RenderContext rc (audio, cv, midi, atoms, 128);
+        graph.render (rc);
+        transport.postProcess (128);
+    };
+
+    BOOST_REQUIRE (! graph.freeze (File::createTempFile ("wav"), 1024).wasOk());
+    BOOST_REQUIRE (! sub->freeze (File::createTempFile ("wav"), 0).wasOk());
+
+    const auto file = File::createTempFile ("wav");
+    BOOST_REQUIRE (sub->freeze (file, 1024).wasOk());
+    BOOST_REQUIRE (sub->isFrozen());
+    BOOST_REQUIRE (! sub->isFlattenable());
+    BOOST_REQUIRE (! sub->prepared());
+    BOOST_REQUIRE (file.existsAsFile());
+
+    // the file plays from where the transport is.
+    for (int block = 0; block < 4; ++block)
+    {
+        renderBlock();
+        for (int i = 0; i < 128; i += 31)
+            BOOST_REQUIRE_EQUAL (audio.getSample (1, i), (float) (block * 128 + i) * 1.0e-4f);
+    }
+
+    // and the live graph picks up again.
+    sub->unfreeze();
+    BOOST_REQUIRE (! sub->isFrozen());
+    BOOST_REQUIRE (sub->prepared());
+    BOOST_REQUIRE (! file.existsAsFile());
+    renderBlock();
+    BOOST_REQUIRE (audio.getMagnitude (0, 0, 128) > 0.f);
+
+    graph.setPlayHead (nullptr);
+}
+
+BOOST_AUTO_TEST_CASE (InternalRate)
+{
+    PreparedGraph fix (48000.0, 128);
+    GraphNode& graph = fix.graph;
+    auto* sub = new GraphNode (*element::test::context());
+    graph.addNode (sub);
+    auto* ramp = sub->addNode (new RampNode());
+    auto* subOut = sub->addNode (new IONode (IONode::audioOutputNode));
+    auto* audioOut = graph.addNode (new IONode (IONode::audioOutputNode));
+    for (int c = 0; c < 2; ++c)
+    {
+        BOOST_REQUIRE (sub->connectChannels (PortType::Audio, ramp->nodeId, c, subOut->nodeId, c));
+        BOOST_REQUIRE (graph.connectChannels (PortType::Audio, sub->nodeId, c, audioOut->nodeId, c));
+    }
+    sub->rebuild();
+    graph.rebuild();
+
+    sub->setInternalRate (96000.0);
+    graph.rebuild();
+    BOOST_REQUIRE (sub->isBridged());
+    BOOST_REQUIRE (! sub->isFlattenable());
+    BOOST_REQUIRE_EQUAL (ramp->getSampleRate(), 96000.0);
+    const int latency = sub->getLatencySamples();
+    BOOST_REQUIRE (latency > 0);
+
+    // the ramp climbs twice as fast per frame of the parent.
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer audio (2, 128), cv;
+    for (int block = 0; block < 8; ++block)
+    {
+        audio.clear();
+        RenderContext rc (audio, cv, midi, atoms, 128);
+        graph.render (rc);
+    }
+    const auto slope = (audio.getSample (1, 100) - audio.getSample (1, 20)) / 80.f;
+    BOOST_REQUIRE_CLOSE_FRACTION (slope, 2.0e-4f, 0.01f);
+
+    sub->setInternalRate (48000.0);
+    BOOST_REQUIRE (! sub->isBridged());
+    BOOST_REQUIRE_EQUAL (ramp->getSampleRate(), 48000.0);
+    sub->setInternalRate (0.0);
+    BOOST_REQUIRE (! sub->isBridged());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,44 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "logstore.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (LogStoreTests)
+
+BOOST_AUTO_TEST_CASE (KeepsNewestLines)
+{
+    LogStore store (4);
+    BOOST_REQUIRE_EQUAL (store.size(), 0);
+    for (int i = 0; i < 6; ++i)
+        store.add (String ("line ") + String (i));
+
+    BOOST_REQUIRE_EQUAL (store.size(), 4);
+    BOOST_REQUIRE_EQUAL (store.getStart(), (uint64) 2);
+    BOOST_REQUIRE_EQUAL (store.getEnd(), (uint64) 6);
+    BOOST_REQUIRE_EQUAL (store[0], String ("line 2"));
+    BOOST_REQUIRE_EQUAL (store[3], String ("line 5"));
+    BOOST_REQUIRE (store.get (1).isEmpty());
+
+    store.clear();
+    BOOST_REQUIRE_EQUAL (store.size(), 0);
+    store.add ("again");
+    BOOST_REQUIRE_EQUAL (store.size(), 1);
+    BOOST_REQUIRE_EQUAL (store[0], String ("again"));
+}
+
+BOOST_AUTO_TEST_CASE (CutsLongLines)
+{
+    LogStore store (2);
+    String line;
+    for (int i = 0; i < LogStore::maxLineBytes - 1; ++i)
+        line << "a";
+    store.add (line + String (CharPointer_UTF8 ("\xc3\xa9")));
+    BOOST_REQUIRE_EQUAL (store[0], line);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,59 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "messagescheduler.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (MessageSchedulerTests)
+
+BOOST_AUTO_TEST_CASE (CoalescesByKey)
+{
+    MessageScheduler scheduler;
+    int key = 0, runs = 0, last = 0;
+    for (int i = 1; i <= 5; ++i)
+        scheduler.post (&key, [&, i]() { ++runs; last = i; });
+    scheduler.post (nullptr, [&]() { ++runs; });
+    scheduler.post (nullptr, [&]() { ++runs; });
+    BOOST_REQUIRE_EQUAL (scheduler.getNumPending(), 3);
+
+    BOOST_REQUIRE (scheduler.dispatch());
+    BOOST_REQUIRE_EQUAL (runs, 3);
+    BOOST_REQUIRE_EQUAL (last, 5);
+    BOOST_REQUIRE_EQUAL (scheduler.getStats().numRun, 3);
+    BOOST_REQUIRE_EQUAL (scheduler.getStats().numCoalesced, 4);
+}
+
+BOOST_AUTO_TEST_CASE (RunsByPriority)
+{
+    MessageScheduler scheduler;
+    String order;
+    scheduler.post (nullptr, [&]() { order << "l"; }, MessageScheduler::low);
+    scheduler.post (nullptr, [&]() { order << "n"; });
+    scheduler.post (nullptr, [&]() { order << "h"; }, MessageScheduler::high);
+    scheduler.dispatch();
+    BOOST_REQUIRE_EQUAL (order, String ("hnl"));
+}
+
+BOOST_AUTO_TEST_CASE (DefersPastBudget)
+{
+    MessageScheduler scheduler (0.0);
+    int key = 0, runs = 0, urgent = 0;
+    scheduler.post (nullptr, [&]() { ++runs; });
+    scheduler.post (&key, [&]() { ++runs; });
+    scheduler.post (nullptr, [&]() { ++urgent; }, MessageScheduler::high);
+
+    // urgent work and one more always run, the rest waits.
+    BOOST_REQUIRE (! scheduler.dispatch());
+    BOOST_REQUIRE_EQUAL (urgent, 1);
+    BOOST_REQUIRE_EQUAL (runs, 1);
+    BOOST_REQUIRE_EQUAL (scheduler.getStats().numDeferred, 1);
+
+    scheduler.cancel (&key);
+    BOOST_REQUIRE_EQUAL (scheduler.getNumPending(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
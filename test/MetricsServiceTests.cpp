@@ -0,0 +1,88 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include <element/context.hpp>
+#include <element/services.hpp>
+#include <element/settings.hpp>
+
+#include "services/metricsservice.hpp"
+#include "testutil.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+String fetch (int port, const String& path)
+{
+    StreamingSocket socket;
+    if (! socket.connect ("127.0.0.1", port, 2000))
+        return {};
+
+    const String request ("GET " + path + " HTTP/1.0\r\n\r\n");
+    socket.write (request.toRawUTF8(), (int) request.getNumBytesAsUTF8());
+
+    MemoryBlock response;
+    char buffer[1024];
+    while (socket.waitUntilReady (true, 2000) == 1)
+    {
+        const int numRead = socket.read (buffer, (int) sizeof (buffer), false);
+        if (numRead <= 0)
+            break;
+        response.append (buffer, (size_t) numRead);
+    }
+    return response.toString();
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (MetricsServiceTests)
+
+BOOST_AUTO_TEST_CASE (Format)
+{
+    MetricsService::Snapshot s;
+    s.telemetry.load = 0.25;
+    s.telemetry.numCallbacks = 100;
+    s.midiIn = 7;
+    s.graph = "Main \"A\"";
+    s.residentBytes = 1024;
+    s.sessionBytes = 4096;
+
+    const auto text = MetricsService::format (s);
+    BOOST_REQUIRE (text.contains ("# TYPE element_dsp_load gauge\nelement_dsp_load 0.25\n"));
+    BOOST_REQUIRE (text.contains ("element_audio_callbacks_total 100\n"));
+    BOOST_REQUIRE (text.contains ("element_midi_in_messages_total 7\n"));
+    BOOST_REQUIRE (text.contains ("element_resident_memory_bytes 1024\n"));
+    BOOST_REQUIRE (text.contains ("element_session_memory_bytes 4096\n"));
+    BOOST_REQUIRE (text.contains ("element_active_graph_info{name=\"Main \\\"A\\\"\"} 1\n"));
+
+    // devices that don't count xruns leave the metric out.
+    BOOST_REQUIRE (! text.contains ("element_xruns_total"));
+    s.telemetry.xruns = 3;
+    BOOST_REQUIRE (MetricsService::format (s).contains ("element_xruns_total 3\n"));
+}
+
+BOOST_AUTO_TEST_CASE (Serves)
+{
+    auto* context = element::test::context();
+    auto* metrics = context->services().find<MetricsService>();
+    BOOST_REQUIRE (metrics != nullptr);
+
+    const int port = 19000 + Random::getSystemRandom().nextInt (1000);
+    context->settings().setMetricsPort (port);
+    metrics->refreshWithSettings();
+    BOOST_REQUIRE_EQUAL (metrics->getPort(), port);
+
+    const auto response = fetch (port, "/metrics");
+    BOOST_REQUIRE (response.startsWith ("HTTP/1.0 200 OK"));
+    BOOST_REQUIRE (response.contains ("text/plain; version=0.0.4"));
+    BOOST_REQUIRE (response.contains ("\r\n\r\n# HELP element_dsp_load"));
+    BOOST_REQUIRE (fetch (port, "/other").startsWith ("HTTP/1.0 404"));
+
+    context->settings().setMetricsPort (0);
+    metrics->refreshWithSettings();
+    BOOST_REQUIRE_EQUAL (metrics->getPort(), 0);
+    BOOST_REQUIRE (fetch (port, "/metrics").isEmpty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -46,4 +46,30 @@ BOOST_AUTO_TEST_CASE (Internals)
     BOOST_REQUIRE (! nodes.isTypeHidden (EL_NODE_ID_MCU));
 }
 
+BOOST_AUTO_TEST_CASE (CachedLookups)
+{
+    NodeFactory nodes;
+    OwnedArray<PluginDescription> first, second;
+    nodes.getPluginDescriptions (first, EL_NODE_ID_MIDI_ROUTER);
+    nodes.getPluginDescriptions (second, EL_NODE_FORMAT_NAME, EL_NODE_ID_MIDI_ROUTER);
+    BOOST_REQUIRE_EQUAL (first.size(), 1);
+    BOOST_REQUIRE_EQUAL (second.size(), 1);
+    BOOST_REQUIRE (first[0]->isDuplicateOf (*second[0]));
+
+    nodes.getPluginDescriptions (first, "element.notAType");
+    BOOST_REQUIRE_EQUAL (first.size(), 1);
+
+    BOOST_REQUIRE (nodes.visibleIDs().contains (EL_NODE_ID_MIDI_ROUTER));
+    nodes.hideType (EL_NODE_ID_MIDI_ROUTER);
+    BOOST_REQUIRE (! nodes.visibleIDs().contains (EL_NODE_ID_MIDI_ROUTER));
+    BOOST_REQUIRE_EQUAL (nodes.visibleIDs().size() + 1, nodes.knownIDs().size() - (nodes.isTypeHidden (EL_NODE_ID_MCU) ? 1 : 0));
+    nodes.getPluginDescriptions (first, EL_NODE_ID_MIDI_ROUTER);
+    BOOST_REQUIRE_EQUAL (first.size(), 1);
+    nodes.getPluginDescriptions (first, EL_NODE_ID_MIDI_ROUTER, true);
+    BOOST_REQUIRE_EQUAL (first.size(), 2);
+
+    nodes.removeHiddenType (EL_NODE_ID_MIDI_ROUTER);
+    BOOST_REQUIRE (nodes.visibleIDs().contains (EL_NODE_ID_MIDI_ROUTER));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
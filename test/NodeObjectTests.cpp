@@ -46,6 +46,37 @@ BOOST_AUTO_TEST_CASE (Enablement)
     node = nullptr;
 }
 
+BOOST_AUTO_TEST_CASE (ProcessStats)
+{
+    PreparedGraph fix;
+    ProcessorPtr node = fix.graph.addNode (new TestNode());
+
+    BOOST_REQUIRE (! node->isProfilingEnabled());
+    node->setProfilingEnabled (true);
+    BOOST_REQUIRE (node->isProfilingEnabled());
+    BOOST_REQUIRE (node->getProcessStats().numBlocks == 0);
+
+    const auto oneMillisecond = Time::secondsToHighResolutionTicks (0.001);
+    for (int i = 0; i < 100; ++i)
+        node->recordProcessTime (oneMillisecond, 512);
+
+    auto stats = node->getProcessStats();
+    BOOST_REQUIRE (stats.numBlocks == 100);
+    BOOST_REQUIRE (std::abs (stats.average - 1000.0) < 1.0);
+    BOOST_REQUIRE (std::abs (stats.minimum - stats.maximum) < 1.0);
+    BOOST_REQUIRE (stats.p50 > 800.0 && stats.p50 <= stats.maximum);
+    BOOST_REQUIRE (stats.p99 >= stats.p50 && stats.p99 <= stats.maximum);
+
+    node->resetProcessStats();
+    BOOST_REQUIRE (node->getProcessStats().numBlocks == 0);
+    node->recordProcessTime (oneMillisecond * 2, 512);
+    stats = node->getProcessStats();
+    BOOST_REQUIRE (stats.numBlocks == 1);
+    BOOST_REQUIRE (std::abs (stats.average - 2000.0) < 1.0);
+
+    node = nullptr;
+}
+
 BOOST_AUTO_TEST_CASE (PortChannelMapping)
 {
     PreparedGraph fix;
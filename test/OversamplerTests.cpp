@@ -13,7 +13,7 @@ BOOST_AUTO_TEST_CASE (Basics)
     BOOST_REQUIRE (os.getLatencySamples (0) == 0);
     BOOST_REQUIRE (os.getFactor (0) == 1);
     os.prepare (2, 1024);
-    BOOST_REQUIRE (os.getNumProcessors() == 3);
+    BOOST_REQUIRE (os.getNumProcessors() == 4);
     BOOST_REQUIRE_EQUAL (os.getFactor (0), 2);
     for (int i = 0; i < os.getNumProcessors(); ++i) {
         BOOST_REQUIRE (nullptr != os.getProcessor (i));
@@ -30,4 +30,49 @@ BOOST_AUTO_TEST_CASE (Basics)
     os.reset();
 }
 
+BOOST_AUTO_TEST_CASE (SingleFactor)
+{
+    Oversampler<float> os;
+    os.prepare (2, 512, 16);
+    BOOST_REQUIRE (os.getProcessor (0) == nullptr);
+    BOOST_REQUIRE (os.getProcessor (2) == nullptr);
+    BOOST_REQUIRE (os.getProcessor (3) != nullptr);
+    BOOST_REQUIRE_EQUAL (os.getFactor (3), 16);
+
+    // anything else is freed.
+    os.prepare (2, 512, 4);
+    BOOST_REQUIRE (os.getProcessor (1) != nullptr);
+    BOOST_REQUIRE (os.getProcessor (3) == nullptr);
+
+    os.prepare (2, 512, 1);
+    for (int i = 0; i < os.getNumProcessors(); ++i)
+        BOOST_REQUIRE (os.getProcessor (i) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE (NumBytes)
+{
+    Oversampler<float> os;
+    BOOST_REQUIRE_EQUAL (os.getNumBytes(), (size_t) 0);
+
+    // 4x buffers 2x and 4x the block in two stages.
+    os.prepare (2, 512, 4);
+    BOOST_REQUIRE_EQUAL (os.getNumBytes(), (size_t) 2 * 512 * (2 + 4) * sizeof (float));
+
+    os.prepare (2, 512, 1);
+    BOOST_REQUIRE_EQUAL (os.getNumBytes(), (size_t) 0);
+}
+
+BOOST_AUTO_TEST_CASE (Phase)
+{
+    Oversampler<float> os;
+    BOOST_REQUIRE (os.getPhase() == Oversampler<float>::Phase::minimum);
+    os.prepare (2, 512, 2);
+    const auto minimum = os.getLatencySamples (0);
+
+    os.setPhase (Oversampler<float>::Phase::linear);
+    BOOST_REQUIRE (os.getProcessor (0) == nullptr);
+    os.prepare (2, 512, 2);
+    BOOST_REQUIRE (os.getLatencySamples (0) > minimum);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/parameter.hpp>
+
+using namespace element;
+using namespace juce;
+
+namespace {
+struct Counter : public Parameter::Listener
+{
+    std::atomic<int> values { 0 }, gestures { 0 };
+    std::atomic<float> last { -1.f };
+    std::atomic<bool> onMessageThread { true };
+
+    void controlValueChanged (int, float value) override
+    {
+        if (! MessageManager::existsAndIsCurrentThread())
+            onMessageThread = false;
+        last = value;
+        ++values;
+    }
+
+    void controlTouched (int, bool) override { ++gestures; }
+};
+
+RangedParameter* createParameter()
+{
+    PortDescription port (PortType::Control, 0, 0, "gain", "Gain", true);
+    port.maxValue = 1.f;
+    return new RangedParameter (port);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (ParameterTests)
+
+BOOST_AUTO_TEST_CASE (MessageThread)
+{
+    RangedParameterPtr param (createParameter());
+    Counter ui, rt;
+    param->addListener (&ui);
+    param->addRealtimeListener (&rt);
+
+    // both hear about changes made on the message thread right away.
+    param->setValueNotifyingHost (0.25f);
+    BOOST_REQUIRE_EQUAL (ui.values.load(), 1);
+    BOOST_REQUIRE_EQUAL (rt.values.load(), 1);
+
+    param->removeListener (&ui);
+    param->removeListener (&rt);
+    param->setValueNotifyingHost (0.5f);
+    BOOST_REQUIRE_EQUAL (ui.values.load(), 1);
+    BOOST_REQUIRE_EQUAL (rt.values.load(), 1);
+}
+
+BOOST_AUTO_TEST_CASE (Coalesced)
+{
+    RangedParameterPtr param (createParameter());
+    Counter ui, rt;
+    param->addListener (&ui);
+    param->addRealtimeListener (&rt);
+
+    Thread::launch ([&] {
+        for (int i = 1; i <= 100; ++i)
+            param->setValueNotifyingHost ((float) i / 100.f);
+    });
+
+    // realtime listeners run on the changing thread, every time.
+    for (int i = 0; i < 200 && rt.values.load() < 100; ++i)
+        Thread::sleep (5);
+    BOOST_REQUIRE_EQUAL (rt.values.load(), 100);
+    BOOST_REQUIRE_EQUAL (ui.values.load(), 0);
+
+    // the rest are picked up on the message thread with the latest value.
+    for (int i = 0; i < 50 && ui.last.load() != 1.f; ++i)
+        MessageManager::getInstance()->runDispatchLoopUntil (10);
+    BOOST_REQUIRE (ui.values.load() >= 1 && ui.values.load() < 100);
+    BOOST_REQUIRE_EQUAL (ui.last.load(), 1.f);
+    BOOST_REQUIRE (ui.onMessageThread.load());
+
+    param->removeListener (&ui);
+    param->removeListener (&rt);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,59 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "session/pluginbridge.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (PluginBridgeTests)
+
+BOOST_AUTO_TEST_CASE (ChannelDelaysOneBlock)
+{
+    TemporaryFile tmp (".elbridge");
+    PluginBridgeChannel host, worker;
+    BOOST_REQUIRE (host.create (tmp.getFile(), 2, 64));
+    BOOST_REQUIRE (worker.open (tmp.getFile()));
+    BOOST_REQUIRE_EQUAL (worker.getNumChannels(), 2);
+    BOOST_REQUIRE_EQUAL (worker.getMaxBlockSize(), 64);
+
+    AudioBuffer<float> audio (2, 64), scratch (2, 64);
+    MidiBuffer midi, workerMidi;
+    BOOST_REQUIRE (host.waitUntilDone (0.0));
+
+    for (int block = 1; block <= 3; ++block)
+    {
+        audio.clear();
+        audio.setSample (0, 0, (float) block);
+        midi.clear();
+        midi.addEvent (MidiMessage::noteOn (1, 60 + block, (uint8) 100), 5);
+
+        host.exchange (audio, midi);
+        // the previous block's output comes back, doubled by the "plugin"
+        BOOST_REQUIRE_EQUAL (audio.getSample (0, 0), block == 1 ? 0.f : 2.f * (float) (block - 1));
+        BOOST_REQUIRE_EQUAL (midi.getNumEvents(), block == 1 ? 0 : 1);
+        BOOST_REQUIRE (! host.waitUntilDone (0.0));
+
+        BOOST_REQUIRE (worker.waitForBlock (100.0));
+        const int numSamples = worker.read (scratch, workerMidi);
+        BOOST_REQUIRE_EQUAL (numSamples, 64);
+        BOOST_REQUIRE_EQUAL (workerMidi.getNumEvents(), 1);
+        BOOST_REQUIRE_EQUAL ((*workerMidi.begin()).samplePosition, 5);
+        scratch.applyGain (2.f);
+        worker.write (scratch, numSamples, workerMidi);
+        BOOST_REQUIRE (host.waitUntilDone (100.0));
+    }
+}
+
+BOOST_AUTO_TEST_CASE (RejectsForeignFiles)
+{
+    TemporaryFile tmp (".elbridge");
+    BOOST_REQUIRE (tmp.getFile().replaceWithText (String::repeatedString ("x", 512)));
+    PluginBridgeChannel worker;
+    BOOST_REQUIRE (! worker.open (tmp.getFile()));
+    BOOST_REQUIRE (! worker.isOpen());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "session/plugindatabase.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+PluginDescription makeType (const String& name, const String& format, const String& maker, const String& category)
+{
+    PluginDescription t;
+    t.name = t.descriptiveName = name;
+    t.pluginFormatName = format;
+    t.manufacturerName = maker;
+    t.category = category;
+    t.version = "1.0.0";
+    t.fileOrIdentifier = "/plugins/" + name;
+    t.uniqueId = name.hashCode();
+    t.numInputChannels = 2;
+    t.numOutputChannels = 2;
+    t.isInstrument = category == "Synth";
+    t.lastFileModTime = Time (1234567);
+    return t;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (PluginDatabaseTests)
+
+BOOST_AUTO_TEST_CASE (RoundTrip)
+{
+    KnownPluginList list;
+    list.addType (makeType ("Alpha", "VST3", "Kushview", "Synth"));
+    list.addType (makeType ("Beta", "VST3", "Other", "Fx"));
+    list.addType (makeType ("Gamma", "LV2", "kushview", "Fx"));
+    list.addToBlacklist ("/plugins/Broken");
+
+    TemporaryFile tmp (".db");
+    BOOST_REQUIRE (PluginDatabase::write (list, tmp.getFile()));
+
+    PluginDatabase db;
+    BOOST_REQUIRE (db.open (tmp.getFile()));
+    BOOST_REQUIRE_EQUAL (db.size(), 3);
+    BOOST_REQUIRE (db.getBlacklistedFiles() == StringArray ("/plugins/Broken"));
+
+    KnownPluginList restored;
+    db.restore (restored);
+    BOOST_REQUIRE_EQUAL (restored.getNumTypes(), 3);
+    for (const auto& t : list.getTypes())
+    {
+        auto r = restored.getTypeForIdentifierString (t.createIdentifierString());
+        BOOST_REQUIRE (r != nullptr);
+        BOOST_REQUIRE (r->isDuplicateOf (t));
+        BOOST_REQUIRE (r->manufacturerName == t.manufacturerName);
+        BOOST_REQUIRE (r->isInstrument == t.isInstrument);
+        BOOST_REQUIRE (r->lastFileModTime == t.lastFileModTime);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (Indexes)
+{
+    KnownPluginList list;
+    list.addType (makeType ("Alpha", "VST3", "Kushview", "Synth"));
+    list.addType (makeType ("Beta", "VST3", "Other", "Fx"));
+    list.addType (makeType ("Gamma", "LV2", "kushview", "Fx"));
+
+    TemporaryFile tmp (".db");
+    BOOST_REQUIRE (PluginDatabase::write (list, tmp.getFile()));
+    PluginDatabase db;
+    BOOST_REQUIRE (db.open (tmp.getFile()));
+
+    BOOST_REQUIRE_EQUAL (db.find (PluginDatabase::byFormat, "VST3").size(), 2);
+    BOOST_REQUIRE_EQUAL (db.find (PluginDatabase::byManufacturer, "KUSHVIEW").size(), 2);
+    BOOST_REQUIRE_EQUAL (db.find (PluginDatabase::byCategory, "Synth").size(), 1);
+    BOOST_REQUIRE_EQUAL (db.find (PluginDatabase::byCategory, "Missing").size(), 0);
+    BOOST_REQUIRE_EQUAL (db.getKeys (PluginDatabase::byFormat).size(), 2);
+
+    const auto synths = db.find (PluginDatabase::byCategory, "synth");
+    BOOST_REQUIRE (db.getType (synths[0]).name == "Alpha");
+}
+
+BOOST_AUTO_TEST_CASE (RejectsGarbage)
+{
+    TemporaryFile tmp (".db");
+    BOOST_REQUIRE (tmp.getFile().replaceWithText ("not a plugin database at all"));
+    PluginDatabase db;
+    BOOST_REQUIRE (! db.open (tmp.getFile()));
+    BOOST_REQUIRE (! db.isOpen());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
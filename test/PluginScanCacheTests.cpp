@@ -0,0 +1,63 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "session/pluginscancache.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (PluginScanCacheTests)
+
+BOOST_AUTO_TEST_CASE (UnchangedAndChanged)
+{
+    TemporaryFile tmp (".so");
+    const auto& file = tmp.getFile();
+    BOOST_REQUIRE (file.replaceWithText ("plugin"));
+
+    PluginScanCache cache;
+    BOOST_REQUIRE (cache.findUnchanged (file) == nullptr);
+    cache.record (file, true, false);
+    BOOST_REQUIRE (cache.findUnchanged (file) != nullptr);
+    BOOST_REQUIRE (cache.findUnchanged (file)->found);
+
+    // touched but equal content is still unchanged
+    file.setLastModificationTime (Time::getCurrentTime() + RelativeTime::hours (1));
+    BOOST_REQUIRE (cache.findUnchanged (file) != nullptr);
+
+    // same size, new content
+    BOOST_REQUIRE (file.replaceWithText ("plugon"));
+    file.setLastModificationTime (Time::getCurrentTime() + RelativeTime::hours (2));
+    BOOST_REQUIRE (cache.findUnchanged (file) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE (SaveLoadAndFilter)
+{
+    TemporaryFile a (".so"), b (".so"), saved (".xml");
+    BOOST_REQUIRE (a.getFile().replaceWithText ("a"));
+    BOOST_REQUIRE (b.getFile().replaceWithText ("b"));
+
+    PluginScanCache cache;
+    cache.record (a.getFile(), true, false);
+    cache.record (b.getFile(), false, true);
+    const auto pathA = a.getFile().getFullPathName();
+    BOOST_REQUIRE (cache.save (saved.getFile(), [&] (const String& path) { return path == pathA; }));
+
+    PluginScanCache loaded;
+    BOOST_REQUIRE (loaded.load (saved.getFile()));
+    BOOST_REQUIRE_EQUAL (loaded.size(), 1);
+    BOOST_REQUIRE (loaded.findUnchanged (a.getFile()) != nullptr);
+    BOOST_REQUIRE (loaded.findUnchanged (b.getFile()) == nullptr);
+
+    BOOST_REQUIRE (cache.save (saved.getFile()));
+    BOOST_REQUIRE (loaded.load (saved.getFile()));
+    BOOST_REQUIRE_EQUAL (loaded.size(), 2);
+    BOOST_REQUIRE (loaded.findUnchanged (b.getFile())->blacklisted);
+
+    b.getFile().deleteFile();
+    loaded.removeMissing();
+    BOOST_REQUIRE_EQUAL (loaded.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -50,4 +50,39 @@ BOOST_AUTO_TEST_CASE (Types)
     BOOST_REQUIRE (ports.getType (17) == (int) midiType);
 }
 
+BOOST_AUTO_TEST_CASE (Lookups)
+{
+    element::PortList ports;
+    ports.add (PortType::Audio, 0, 0, "in_1", "In 1", true);
+    ports.add (PortType::Audio, 2, 0, "out_1", "Out 1", false);
+    ports.add (PortType::Audio, 1, 1, "in_2", "In 2", true);
+    ports.add (PortType::Midi, 3, 0, "midi_in", "MIDI", true);
+    // far past the others, found without a table entry.
+    ports.add (PortType::Control, 5000, 7, "gain", "Gain", true);
+
+    BOOST_REQUIRE_EQUAL (ports.size (PortType::Audio, true), 2);
+    BOOST_REQUIRE_EQUAL (ports.size (PortType::Audio, false), 1);
+    BOOST_REQUIRE_EQUAL (ports.size (PortType::CV, true), 0);
+    BOOST_REQUIRE_EQUAL (ports.getPortForChannel (PortType::Audio, 1, true), 1);
+    BOOST_REQUIRE_EQUAL (ports.getPortForChannel (PortType::Audio, 1, false), (int) EL_INVALID_PORT);
+    BOOST_REQUIRE_EQUAL (ports.getPortForChannel (PortType::Control, 7, true), 5000);
+    BOOST_REQUIRE_EQUAL (ports.getNthPort (PortType::Audio, 1, true), 1);
+    BOOST_REQUIRE_EQUAL (ports.getNthPort (PortType::Audio, 2, true), (int) EL_INVALID_PORT);
+    BOOST_REQUIRE_EQUAL (ports.getChannelForPort (5000), 7);
+    BOOST_REQUIRE_EQUAL (ports.getType (4), (int) PortType::Unknown);
+    BOOST_REQUIRE_EQUAL (ports.getType (-1), (int) PortType::Unknown);
+
+    // copies and swaps bring their tables along.
+    element::PortList copy (ports), other;
+    BOOST_REQUIRE_EQUAL (copy.getPortForChannel (PortType::Midi, 0, true), 3);
+    other.swapWith (copy);
+    BOOST_REQUIRE_EQUAL (other.size (PortType::Audio, true), 2);
+    BOOST_REQUIRE_EQUAL (copy.size (PortType::Audio, true), 0);
+
+    ports.sanitizeIndexes();
+    BOOST_REQUIRE_EQUAL (ports.getChannelForPort (4), 7);
+    ports.clear();
+    BOOST_REQUIRE_EQUAL (ports.getPortForChannel (PortType::Midi, 0, true), (int) EL_INVALID_PORT);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,127 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/node.hpp>
+
+#include "session/presetindex.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+void writePreset (const File& file, const String& name, const String& identifier)
+{
+    Node node (types::Node);
+    node.setProperty (tags::name, name)
+        .setProperty (tags::format, "VST3")
+        .setProperty (tags::identifier, identifier);
+    file.getParentDirectory().createDirectory();
+    node.writeToFile (file);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (PresetIndexTests)
+
+BOOST_AUTO_TEST_CASE (IndexesByPlugin)
+{
+    TemporaryFile temp;
+    const auto folder = temp.getFile();
+    writePreset (folder.getChildFile ("Keys/Grand.elp"), "Grand", "piano");
+    writePreset (folder.getChildFile ("Keys/Bright.elp"), "Bright", "piano");
+    writePreset (folder.getChildFile ("Pads/Warm.elp"), "Warm", "synth");
+
+    PresetIndex index (folder.getSiblingFile (folder.getFileName() + ".index"));
+    BOOST_REQUIRE (index.update (folder));
+    BOOST_REQUIRE_EQUAL (index.size(), 3);
+    BOOST_REQUIRE (! index.update (folder));
+
+    Array<PresetIndex::Entry> results;
+    index.getPresetsFor ("VST3", "piano", results);
+    BOOST_REQUIRE_EQUAL (results.size(), 2);
+    BOOST_REQUIRE_EQUAL (results[0].name.toStdString(), "Bright");
+    BOOST_REQUIRE_EQUAL (results[1].tags[0].toStdString(), "Keys");
+
+    results.clearQuick();
+    index.search ("pads warm", results);
+    BOOST_REQUIRE_EQUAL (results.size(), 1);
+    BOOST_REQUIRE_EQUAL (results[0].identifier.toStdString(), "synth");
+
+    folder.deleteRecursively();
+}
+
+BOOST_AUTO_TEST_CASE (SavesAndUpdates)
+{
+    TemporaryFile temp;
+    const auto folder = temp.getFile();
+    const auto indexFile = folder.getSiblingFile (folder.getFileName() + ".index");
+    writePreset (folder.getChildFile ("One.elp"), "One", "synth");
+
+    {
+        PresetIndex index (indexFile);
+        index.update (folder);
+        BOOST_REQUIRE (index.save());
+    }
+
+    PresetIndex index (indexFile);
+    BOOST_REQUIRE (index.load());
+    BOOST_REQUIRE_EQUAL (index.size(), 1);
+    BOOST_REQUIRE (! index.update (folder));
+
+    writePreset (folder.getChildFile ("Two.elp"), "Two", "synth");
+    folder.getChildFile ("One.elp").deleteFile();
+    BOOST_REQUIRE (index.update (folder));
+
+    Array<PresetIndex::Entry> results;
+    index.getPresetsFor ("VST3", "synth", results);
+    BOOST_REQUIRE_EQUAL (results.size(), 1);
+    BOOST_REQUIRE_EQUAL (results[0].name.toStdString(), "Two");
+
+    folder.deleteRecursively();
+    indexFile.deleteFile();
+}
+
+BOOST_AUTO_TEST_CASE (UpdatesOneFile)
+{
+    TemporaryFile temp;
+    const auto folder = temp.getFile();
+    writePreset (folder.getChildFile ("Keys/Grand.elp"), "Grand", "piano");
+
+    PresetIndex index (folder.getSiblingFile (folder.getFileName() + ".index"));
+    index.update (folder);
+
+    // added, sorted in with the rest.
+    const auto bright = folder.getChildFile ("Keys/Bright.elp");
+    writePreset (bright, "Bright", "piano");
+    BOOST_REQUIRE (index.updateFile (bright, folder));
+    BOOST_REQUIRE (! index.updateFile (bright, folder));
+    Array<PresetIndex::Entry> results;
+    index.getPresetsFor ("VST3", "piano", results);
+    BOOST_REQUIRE_EQUAL (results.size(), 2);
+    BOOST_REQUIRE_EQUAL (results[0].name.toStdString(), "Bright");
+    BOOST_REQUIRE_EQUAL (results[0].tags[0].toStdString(), "Keys");
+
+    // changed to another plugin.
+    writePreset (bright, "Bright", "synth");
+    bright.setLastModificationTime (Time::getCurrentTime() + RelativeTime::seconds (2.0));
+    BOOST_REQUIRE (index.updateFile (bright, folder));
+    results.clearQuick();
+    index.getPresetsFor ("VST3", "piano", results);
+    BOOST_REQUIRE_EQUAL (results.size(), 1);
+    results.clearQuick();
+    index.getPresetsFor ("VST3", "synth", results);
+    BOOST_REQUIRE_EQUAL (results.size(), 1);
+
+    // removed, and files that aren't presets are ignored.
+    bright.deleteFile();
+    BOOST_REQUIRE (index.updateFile (bright, folder));
+    BOOST_REQUIRE_EQUAL (index.size(), 1);
+    const auto notes = folder.getChildFile ("notes.txt");
+    notes.replaceWithText ("hello");
+    BOOST_REQUIRE (! index.updateFile (notes, folder));
+    BOOST_REQUIRE_EQUAL (index.size(), 1);
+
+    folder.deleteRecursively();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
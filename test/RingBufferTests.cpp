@@ -0,0 +1,121 @@
+#include <boost/test/unit_test.hpp>
+#include "ringbuffer.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (RingBufferTests)
+
+BOOST_AUTO_TEST_CASE (CopyRoundTrip)
+{
+    RingBuffer ring (16);
+    const uint8 in[5] = { 1, 2, 3, 4, 5 };
+    uint8 out[5] = { 0 };
+    BOOST_REQUIRE_EQUAL (ring.write (in, 5), 5u);
+    BOOST_REQUIRE_EQUAL (ring.peak (out, 5), 5u);
+    BOOST_REQUIRE_EQUAL (ring.getReadSpace(), 5u);
+    BOOST_REQUIRE_EQUAL (ring.read (out, 5), 5u);
+    BOOST_REQUIRE_EQUAL (ring.getReadSpace(), 0u);
+    for (int i = 0; i < 5; ++i)
+        BOOST_REQUIRE_EQUAL (out[i], in[i]);
+}
+
+BOOST_AUTO_TEST_CASE (SpansWrap)
+{
+    RingBuffer ring (16);
+    uint8 scratch[12] = { 0 };
+    ring.write (scratch, 12);
+    ring.read (scratch, 12);
+
+    uint8 in[8];
+    for (int i = 0; i < 8; ++i)
+        in[i] = (uint8) (i + 1);
+    ring.write (in, 8);
+
+    const auto span = ring.getReadSpan (8);
+    BOOST_REQUIRE_EQUAL (span.size(), 8u);
+    BOOST_REQUIRE (! span.isContiguous());
+    BOOST_REQUIRE_EQUAL (span.size1, 4u);
+    BOOST_REQUIRE_EQUAL (span.data1[0], 1);
+    BOOST_REQUIRE_EQUAL (span.data2[0], 5);
+
+    const auto tail = span.slice (5, 10);
+    BOOST_REQUIRE_EQUAL (tail.size(), 3u);
+    BOOST_REQUIRE (tail.isContiguous());
+    BOOST_REQUIRE_EQUAL (tail.data1[0], 6);
+
+    uint8 out[8] = { 0 };
+    span.copyTo (out, 0, 8);
+    for (int i = 0; i < 8; ++i)
+        BOOST_REQUIRE_EQUAL (out[i], in[i]);
+}
+
+BOOST_AUTO_TEST_CASE (Messages)
+{
+    RingBuffer ring (32);
+    RingBuffer::Span payload;
+    BOOST_REQUIRE (! ring.peekMessage (payload));
+
+    const uint8 a[3] = { 7, 8, 9 };
+    BOOST_REQUIRE (ring.writeMessage (a, 3));
+    BOOST_REQUIRE (ring.writeMessage (nullptr, 0));
+    BOOST_REQUIRE_EQUAL (ring.getReadSpace(), RingBuffer::getMessageSpace (3) + RingBuffer::headerSize);
+
+    BOOST_REQUIRE (ring.peekMessage (payload));
+    BOOST_REQUIRE_EQUAL (payload.size(), 3u);
+    BOOST_REQUIRE_EQUAL (payload.data1[2], 9);
+    ring.finishMessage (payload);
+
+    BOOST_REQUIRE (ring.peekMessage (payload));
+    BOOST_REQUIRE_EQUAL (payload.size(), 0u);
+    ring.finishMessage (payload);
+    BOOST_REQUIRE (! ring.peekMessage (payload));
+
+    // doesn't fit, nothing is written.
+    uint8 big[40] = { 0 };
+    BOOST_REQUIRE (! ring.writeMessage (big, 40));
+    BOOST_REQUIRE_EQUAL (ring.getReadSpace(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE (PreparedMessagesAreHiddenUntilCommitted)
+{
+    RingBuffer ring (16);
+    RingBuffer::Span payload;
+    BOOST_REQUIRE (ring.prepareMessage (4, payload));
+    BOOST_REQUIRE_EQUAL (payload.size(), 4u);
+    const uint8 data[4] = { 1, 2, 3, 4 };
+    payload.copyFrom (data, 0, 4);
+
+    RingBuffer::Span read;
+    BOOST_REQUIRE (! ring.peekMessage (read));
+    ring.commitMessage (4);
+    BOOST_REQUIRE (ring.peekMessage (read));
+
+    uint8 out[4] = { 0 };
+    read.copyTo (out, 0, 4);
+    BOOST_REQUIRE_EQUAL (out[3], 4);
+}
+
+BOOST_AUTO_TEST_CASE (WrappedMessages)
+{
+    RingBuffer ring (16);
+    uint8 scratch[10] = { 0 };
+    ring.write (scratch, 10);
+    ring.read (scratch, 10);
+
+    // header and payload straddle the end of the storage.
+    const uint8 in[6] = { 10, 11, 12, 13, 14, 15 };
+    BOOST_REQUIRE (ring.writeMessage (in, 6));
+
+    RingBuffer::Span payload;
+    BOOST_REQUIRE (ring.peekMessage (payload));
+    BOOST_REQUIRE_EQUAL (payload.size(), 6u);
+
+    uint8 out[6] = { 0 };
+    payload.copyTo (out, 0, 6);
+    for (int i = 0; i < 6; ++i)
+        BOOST_REQUIRE_EQUAL (out[i], in[i]);
+    ring.finishMessage (payload);
+    BOOST_REQUIRE_EQUAL (ring.getReadSpace(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
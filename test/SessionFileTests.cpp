@@ -0,0 +1,169 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/node.hpp>
+#include <element/session.hpp>
+
+#include "session/sessionfile.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+MemoryBlock makeState (int size, bool noisy)
+{
+    MemoryBlock block ((size_t) size, true);
+    Random random (size);
+    for (int i = 0; i < size; ++i)
+        block[i] = noisy ? (char) random.nextInt (256) : (char) (i % 7);
+    return block;
+}
+
+ValueTree makeSession()
+{
+    ValueTree session (types::Session);
+    auto graphs = session.getOrCreateChildWithName (tags::graphs, nullptr);
+    auto graph = Node::createDefaultGraph ("Graph").data();
+    graphs.appendChild (graph, nullptr);
+
+    auto nodes = graph.getOrCreateChildWithName (tags::nodes, nullptr);
+    ValueTree plugin (types::Node);
+    plugin.setProperty (tags::name, "Sampler", nullptr)
+        .setProperty (tags::state, makeState (4096, true).toBase64Encoding(), nullptr)
+        .setProperty (tags::programState, makeState (1000, false).toBase64Encoding(), nullptr);
+    nodes.appendChild (plugin, nullptr);
+    return session;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SessionFileTests)
+
+BOOST_AUTO_TEST_CASE (RoundTrip)
+{
+    const auto session = makeSession();
+    MemoryOutputStream out;
+    BOOST_REQUIRE (SessionFile::write (session, out));
+
+    MemoryInputStream in (out.getData(), out.getDataSize(), false);
+    BOOST_REQUIRE (SessionFile::canRead (in));
+    const auto loaded = SessionFile::read (in);
+    BOOST_REQUIRE (loaded.isValid());
+    BOOST_REQUIRE (loaded.isEquivalentTo (session));
+}
+
+BOOST_AUTO_TEST_CASE (StoresRawState)
+{
+    auto session = makeSession();
+    MemoryOutputStream with;
+    SessionFile::write (session, with);
+
+    auto nodes = session.getChildWithName (tags::graphs).getChild (0).getChildWithName (tags::nodes);
+    auto plugin = nodes.getChild (nodes.getNumChildren() - 1);
+    plugin.removeProperty (tags::state, nullptr);
+    MemoryOutputStream without;
+    SessionFile::write (session, without);
+
+    // noise doesn't compress, so the state should cost its own size plus
+    // a chunk header and not the third more that base64 would.
+    BOOST_REQUIRE_LE (with.getDataSize() - without.getDataSize(), (size_t) 4096 + 16 + 8);
+}
+
+BOOST_AUTO_TEST_CASE (SlicesLargeState)
+{
+    // bigger than a slice and compressible, so it's deflated in pieces.
+    auto session = makeSession();
+    auto nodes = session.getChildWithName (tags::graphs).getChild (0).getChildWithName (tags::nodes);
+    const auto state = makeState (3 * 1024 * 1024 + 17, false);
+    nodes.getChild (nodes.getNumChildren() - 1).setProperty (tags::state, state.toBase64Encoding(), nullptr);
+
+    for (const int level : { 0, 1, 9 })
+    {
+        MemoryOutputStream out;
+        BOOST_REQUIRE (SessionFile::write (session, out, level));
+        if (level > 0)
+            BOOST_REQUIRE_LT (out.getDataSize(), state.getSize() / 4);
+        else
+            BOOST_REQUIRE_GT (out.getDataSize(), state.getSize());
+
+        MemoryInputStream in (out.getData(), out.getDataSize(), false);
+        BOOST_REQUIRE (SessionFile::read (in).isEquivalentTo (session));
+    }
+}
+
+BOOST_AUTO_TEST_CASE (ReadsLazily)
+{
+    const auto session = makeSession();
+    TemporaryFile temp;
+    {
+        FileOutputStream out (temp.getFile());
+        BOOST_REQUIRE (SessionFile::write (session, out));
+    }
+
+    auto loaded = SessionFile::readLazily (temp.getFile());
+    BOOST_REQUIRE (loaded.isValid());
+
+    // states stay in the file until they're read.
+    auto nodes = loaded.getChildWithName (tags::graphs).getChild (0).getChildWithName (tags::nodes);
+    const auto value = nodes.getChild (nodes.getNumChildren() - 1).getProperty (tags::state);
+    BOOST_REQUIRE (value.isObject());
+
+    MemoryBlock state;
+    BOOST_REQUIRE (SessionFile::readState (value, state));
+    BOOST_REQUIRE (state == makeState (4096, true));
+
+    SessionFile::resolveStates (loaded);
+    BOOST_REQUIRE (loaded.isEquivalentTo (session));
+}
+
+BOOST_AUTO_TEST_CASE (SharesEqualStates)
+{
+    // the same plugin in a second graph.
+    auto session = makeSession();
+    auto graphs = session.getChildWithName (tags::graphs);
+    graphs.appendChild (graphs.getChild (0).createCopy(), nullptr);
+
+    MemoryOutputStream one, two;
+    SessionFile::write (makeSession(), one, SessionFile::noCompression);
+    SessionFile::write (session, two, SessionFile::noCompression);
+    BOOST_REQUIRE (two.getDataSize() < one.getDataSize() + 4096);
+
+    TemporaryFile temp;
+    {
+        FileOutputStream out (temp.getFile());
+        BOOST_REQUIRE (SessionFile::write (session, out));
+    }
+
+    const auto loaded = SessionFile::readLazily (temp.getFile());
+    auto stateIn = [&loaded] (int graph) {
+        const auto nodes = loaded.getChildWithName (tags::graphs).getChild (graph).getChildWithName (tags::nodes);
+        return nodes.getChild (nodes.getNumChildren() - 1).getProperty (tags::state);
+    };
+    BOOST_REQUIRE (stateIn (0).getObject() != nullptr);
+    BOOST_REQUIRE (stateIn (0).getObject() == stateIn (1).getObject());
+}
+
+BOOST_AUTO_TEST_CASE (RejectsOtherData)
+{
+    MemoryOutputStream out;
+    {
+        GZIPCompressorOutputStream gzip (out, 9);
+        makeSession().writeToStream (gzip);
+    }
+
+    MemoryInputStream in (out.getData(), out.getDataSize(), false);
+    BOOST_REQUIRE (! SessionFile::canRead (in));
+    BOOST_REQUIRE (! SessionFile::read (in).isValid());
+    BOOST_REQUIRE_EQUAL (in.getPosition(), (int64) 0);
+}
+
+BOOST_AUTO_TEST_CASE (RejectsTruncated)
+{
+    MemoryOutputStream out;
+    SessionFile::write (makeSession(), out);
+
+    MemoryInputStream in (out.getData(), out.getDataSize() - 100, false);
+    BOOST_REQUIRE (! SessionFile::read (in).isValid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/node.hpp>
+
+#include "session/sessionjournal.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+MemoryBlock makeState (const String& text)
+{
+    return MemoryBlock (text.toRawUTF8(), text.getNumBytesAsUTF8());
+}
+
+ValueTree makeSession (String& uuid)
+{
+    ValueTree session (types::Session);
+    auto graphs = session.getOrCreateChildWithName (tags::graphs, nullptr);
+    auto graph = Node::createDefaultGraph ("Graph");
+    graphs.appendChild (graph.data(), nullptr);
+    uuid = graph.getNode (0).getUuidString();
+    return session;
+}
+
+String stateOf (const ValueTree& tree, const String& uuid)
+{
+    if (tree.getProperty (tags::uuid).toString() == uuid)
+    {
+        MemoryBlock block;
+        block.fromBase64Encoding (tree.getProperty (tags::state).toString());
+        return block.toString();
+    }
+
+    for (const auto& child : tree)
+    {
+        const auto state = stateOf (child, uuid);
+        if (state.isNotEmpty())
+            return state;
+    }
+
+    return {};
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SessionJournalTests)
+
+BOOST_AUTO_TEST_CASE (ReplaysDeltas)
+{
+    TemporaryFile temp;
+    SessionJournal journal (temp.getFile());
+    String uuid;
+    const auto session = makeSession (uuid);
+
+    auto first = SessionJournal::createDelta();
+    BOOST_REQUIRE (! journal.append (first));
+    BOOST_REQUIRE (journal.rebase (session));
+
+    SessionJournal::addNodeState (first, uuid, makeState ("one"));
+    BOOST_REQUIRE (journal.append (first));
+    auto second = SessionJournal::createDelta();
+    SessionJournal::addNodeState (second, uuid, makeState ("two"));
+    SessionJournal::addNodeState (second, Uuid().toString(), makeState ("gone"));
+    BOOST_REQUIRE (journal.append (second));
+
+    const auto replayed = SessionJournal::replay (temp.getFile());
+    BOOST_REQUIRE (replayed.hasType (types::Session));
+    BOOST_REQUIRE_EQUAL (stateOf (replayed, uuid).toStdString(), "two");
+}
+
+BOOST_AUTO_TEST_CASE (RebaseKeepsDeltas)
+{
+    TemporaryFile temp;
+    SessionJournal journal (temp.getFile());
+    String uuid;
+    const auto session = makeSession (uuid);
+    journal.rebase (session);
+
+    auto delta = SessionJournal::createDelta();
+    SessionJournal::addNodeState (delta, uuid, makeState ("kept"));
+    journal.append (delta);
+
+    // the model changed, but still holds the old state.
+    auto changed = session.createCopy();
+    changed.setProperty (tags::name, "Changed", nullptr);
+    BOOST_REQUIRE (journal.rebase (changed));
+
+    const auto replayed = SessionJournal::replay (temp.getFile());
+    BOOST_REQUIRE_EQUAL (replayed.getProperty (tags::name).toString().toStdString(), "Changed");
+    BOOST_REQUIRE_EQUAL (stateOf (replayed, uuid).toStdString(), "kept");
+}
+
+BOOST_AUTO_TEST_CASE (IgnoresTornRecord)
+{
+    TemporaryFile temp;
+    SessionJournal journal (temp.getFile());
+    String uuid;
+    journal.rebase (makeSession (uuid));
+
+    auto delta = SessionJournal::createDelta();
+    SessionJournal::addNodeState (delta, uuid, makeState ("whole"));
+    journal.append (delta);
+    const auto size = temp.getFile().getSize();
+
+    delta = SessionJournal::createDelta();
+    SessionJournal::addNodeState (delta, uuid, makeState ("torn"));
+    journal.append (delta);
+    {
+        FileOutputStream out (temp.getFile());
+        out.setPosition (size + 10);
+        out.truncate();
+    }
+
+    const auto replayed = SessionJournal::replay (temp.getFile());
+    BOOST_REQUIRE (replayed.isValid());
+    BOOST_REQUIRE_EQUAL (stateOf (replayed, uuid).toStdString(), "whole");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
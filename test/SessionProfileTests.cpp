@@ -0,0 +1,109 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/node.hpp>
+
+#include "session/sessionfile.hpp"
+#include "session/sessionprofile.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (SessionProfileTests)
+
+BOOST_AUTO_TEST_CASE (NothingOutsideOperation)
+{
+    BOOST_REQUIRE (SessionProfile::getCurrent() == nullptr);
+    auto last = SessionProfile::getLast();
+    {
+        SessionProfile::Timer timer (SessionProfile::parse, "Node");
+    }
+    BOOST_REQUIRE (SessionProfile::getLast() == last);
+}
+
+BOOST_AUTO_TEST_CASE (RecordsPhases)
+{
+    {
+        SessionProfile::Operation op ("load", File ("/tmp/test.els"));
+        BOOST_REQUIRE (SessionProfile::getCurrent() == &op.getProfile());
+
+        // nested operations add to the outer one.
+        SessionProfile::Operation nested ("import", {});
+        BOOST_REQUIRE (&nested.getProfile() == &op.getProfile());
+
+        op.getProfile().add (SessionProfile::instantiate, 0.5, "Synth", "Big Synth");
+        op.getProfile().add (SessionProfile::restore, 0.25, "Synth", "Big Synth");
+        op.getProfile().add (SessionProfile::instantiate, 0.1, "EQ", "EQ");
+        op.getProfile().add (SessionProfile::decompress, 0.2);
+        SessionProfile::Timer timer (SessionProfile::parse);
+    }
+
+    BOOST_REQUIRE (SessionProfile::getCurrent() == nullptr);
+    auto profile = SessionProfile::getLast();
+    BOOST_REQUIRE (profile != nullptr);
+    BOOST_REQUIRE (profile->getOperation() == "load");
+    BOOST_REQUIRE (profile->getEntries().size() == 5);
+    BOOST_REQUIRE (profile->getSeconds() > 0.0);
+    BOOST_REQUIRE_CLOSE (profile->getTotal (SessionProfile::instantiate), 0.6, 0.001);
+    BOOST_REQUIRE_EQUAL (profile->getTotal (SessionProfile::write), 0.0);
+
+    const auto nodes = profile->getNodeTotals();
+    BOOST_REQUIRE_EQUAL (nodes.size(), 2);
+    BOOST_REQUIRE (nodes[0].node == "Synth");
+    BOOST_REQUIRE (nodes[0].plugin == "Big Synth");
+    BOOST_REQUIRE_CLOSE (nodes[0].seconds, 0.75, 0.001);
+    BOOST_REQUIRE_CLOSE (nodes[0].phases[SessionProfile::restore], 0.25, 0.001);
+
+    const auto json = profile->toJSON();
+    BOOST_REQUIRE (json["operation"].toString() == "load");
+    BOOST_REQUIRE_CLOSE ((double) json["phases"]["decompress"], 0.2, 0.001);
+    BOOST_REQUIRE_EQUAL (json["nodes"].size(), 2);
+    BOOST_REQUIRE (json["nodes"][0]["name"].toString() == "Synth");
+    BOOST_REQUIRE (JSON::parse (JSON::toString (json))["nodes"][1]["name"].toString() == "EQ");
+    BOOST_REQUIRE (profile->toText().contains ("Big Synth"));
+}
+
+BOOST_AUTO_TEST_CASE (KeepsLastWithEntries)
+{
+    {
+        SessionProfile::Operation op ("save", {});
+        SessionProfile::Timer timer (SessionProfile::write);
+    }
+    auto saved = SessionProfile::getLast();
+    BOOST_REQUIRE (saved != nullptr && saved->getOperation() == "save");
+
+    // a cancelled operation times nothing and is dropped.
+    {
+        SessionProfile::Operation op ("save", {});
+    }
+    BOOST_REQUIRE (SessionProfile::getLast() == saved);
+}
+
+BOOST_AUTO_TEST_CASE (SessionFilePhases)
+{
+    auto session = ValueTree (types::Session);
+    session.appendChild (Node::createDefaultGraph ("Graph").data(), nullptr);
+
+    MemoryBlock block;
+    {
+        SessionProfile::Operation op ("save", {});
+        MemoryOutputStream out (block, false);
+        BOOST_REQUIRE (SessionFile::write (session, out));
+    }
+    auto profile = SessionProfile::getLast();
+    BOOST_REQUIRE (profile->getTotal (SessionProfile::compress) > 0.0);
+    BOOST_REQUIRE (profile->getTotal (SessionProfile::write) > 0.0);
+
+    {
+        SessionProfile::Operation op ("load", {});
+        MemoryInputStream in (block, false);
+        BOOST_REQUIRE (SessionFile::read (in).isValid());
+    }
+    profile = SessionProfile::getLast();
+    BOOST_REQUIRE (profile->getTotal (SessionProfile::read) > 0.0);
+    BOOST_REQUIRE (profile->getTotal (SessionProfile::decompress) > 0.0);
+    BOOST_REQUIRE (profile->getTotal (SessionProfile::parse) > 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
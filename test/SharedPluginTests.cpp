@@ -0,0 +1,116 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "session/sharedplugin.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+/** Outputs how many blocks it rendered, and counts notes and restores. */
+class CountingPlugin : public AudioPluginInstance
+{
+public:
+    CountingPlugin()
+        : AudioPluginInstance (BusesProperties().withOutput ("Main", AudioChannelSet::stereo(), true)) {}
+
+    int numBlocks = 0, numNotes = 0, numRestores = 0;
+
+    void fillInPluginDescription (PluginDescription& desc) const override { desc.name = getName(); }
+    const String getName() const override { return "Counting"; }
+    void prepareToPlay (double, int) override {}
+    void releaseResources() override {}
+    void processBlock (AudioBuffer<float>& audio, MidiBuffer& midi) override
+    {
+        ++numBlocks;
+        numNotes += midi.getNumEvents();
+        for (int i = 0; i < audio.getNumChannels(); ++i)
+            FloatVectorOperations::fill (audio.getWritePointer (i), (float) numBlocks, audio.getNumSamples());
+    }
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return true; }
+    bool producesMidi() const override { return false; }
+    AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram (int) override {}
+    const String getProgramName (int) override { return {}; }
+    void changeProgramName (int, const String&) override {}
+    void getStateInformation (MemoryBlock&) override {}
+    void setStateInformation (const void*, int) override { ++numRestores; }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SharedPluginTests)
+
+BOOST_AUTO_TEST_CASE (RendersOncePerBlock)
+{
+    auto* counter = new CountingPlugin();
+    auto shared = SharedPlugin::create ("counting", std::unique_ptr<AudioPluginInstance> (counter));
+    BOOST_REQUIRE (SharedPlugin::find ("counting") == shared);
+
+    auto first = createSharedPluginClient (shared);
+    auto second = createSharedPluginClient (shared);
+    BOOST_REQUIRE_EQUAL (shared->getNumClients(), 2);
+    BOOST_REQUIRE_EQUAL (second->getTotalNumOutputChannels(), 2);
+    first->prepareToPlay (44100.0, 64);
+    second->prepareToPlay (44100.0, 64);
+
+    AudioBuffer<float> audio (2, 64);
+    MidiBuffer midi;
+    for (int block = 1; block <= 2; ++block)
+    {
+        SharedPlugin::nextBlock();
+        for (auto* client : { first.get(), second.get() })
+        {
+            audio.clear();
+            midi.clear();
+            midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 0);
+            client->processBlock (audio, midi);
+            BOOST_REQUIRE_EQUAL (audio.getSample (1, 63), (float) block);
+        }
+        BOOST_REQUIRE_EQUAL (counter->numBlocks, block);
+    }
+
+    // the second client was late both times, its first note played in block two.
+    BOOST_REQUIRE_EQUAL (counter->numNotes, 3);
+
+    first.reset();
+    second.reset();
+    BOOST_REQUIRE_EQUAL (shared->getNumClients(), 0);
+    shared = nullptr;
+    BOOST_REQUIRE (SharedPlugin::find ("counting") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE (RestoresOncePerSession)
+{
+    auto* counter = new CountingPlugin();
+    auto shared = SharedPlugin::findOrCreate ("restoring", [counter]() { return std::unique_ptr<AudioPluginInstance> (counter); });
+    BOOST_REQUIRE (shared != nullptr);
+    BOOST_REQUIRE (SharedPlugin::findOrCreate ("restoring", nullptr) == shared);
+
+    auto first = createSharedPluginClient (shared);
+    auto second = createSharedPluginClient (shared);
+    const char state[] = "state";
+
+    SharedPlugin::beginRestore();
+    first->setStateInformation (state, sizeof (state));
+    second->setStateInformation (state, sizeof (state));
+    BOOST_REQUIRE_EQUAL (counter->numRestores, 1);
+
+    // loading or cueing another session applies its state again.
+    SharedPlugin::beginRestore();
+    second->setStateInformation (state, sizeof (state));
+    first->setStateInformation (state, sizeof (state));
+    BOOST_REQUIRE_EQUAL (counter->numRestores, 2);
+
+    // a lone client owns the plugin.
+    second.reset();
+    first->setStateInformation (state, sizeof (state));
+    BOOST_REQUIRE_EQUAL (counter->numRestores, 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
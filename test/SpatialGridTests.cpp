@@ -0,0 +1,52 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ui/spatialgrid.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+std::vector<int> sorted (std::vector<int> items)
+{
+    std::sort (items.begin(), items.end());
+    return items;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SpatialGridTests)
+
+BOOST_AUTO_TEST_CASE (FindsOncePerItem)
+{
+    SpatialGrid<int> grid (16);
+    grid.set (1, { 0, 0, 10, 10 });
+    grid.set (2, { 8, 8, 40, 40 }); // spans nine cells
+    grid.set (3, { -30, -30, 10, 10 });
+    BOOST_REQUIRE_EQUAL (grid.size(), 3);
+
+    BOOST_REQUIRE (sorted (grid.find (Point<int> (9, 9))) == std::vector<int> ({ 1, 2 }));
+    BOOST_REQUIRE (sorted (grid.find (Point<int> (40, 40))) == std::vector<int> ({ 2 }));
+    BOOST_REQUIRE (sorted (grid.find (Point<int> (-25, -25))) == std::vector<int> ({ 3 }));
+    BOOST_REQUIRE (grid.find (Point<int> (10, 0)).empty());
+    BOOST_REQUIRE (sorted (grid.find (Rectangle<int> (-100, -100, 200, 200))) == std::vector<int> ({ 1, 2, 3 }));
+}
+
+BOOST_AUTO_TEST_CASE (MovesAndRemoves)
+{
+    SpatialGrid<int> grid (16);
+    grid.set (1, { 0, 0, 10, 10 });
+    grid.set (1, { 100, 100, 10, 10 });
+    BOOST_REQUIRE_EQUAL (grid.size(), 1);
+    BOOST_REQUIRE (grid.find (Point<int> (5, 5)).empty());
+    BOOST_REQUIRE (grid.find (Point<int> (105, 105)) == std::vector<int> ({ 1 }));
+
+    grid.remove (1);
+    BOOST_REQUIRE (! grid.contains (1));
+    BOOST_REQUIRE (grid.find (Rectangle<int> (0, 0, 200, 200)).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
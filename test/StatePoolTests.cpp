@@ -0,0 +1,74 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/node.hpp>
+
+#include "session/sessionfile.hpp"
+#include "session/statepool.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+ValueTree makeNode (const String& state)
+{
+    ValueTree node (types::Node);
+    MemoryBlock block (state.toRawUTF8(), state.getNumBytesAsUTF8());
+    node.setProperty (tags::state, block.toBase64Encoding(), nullptr);
+    return node;
+}
+
+String stateOf (const ValueTree& node)
+{
+    MemoryBlock block;
+    return SessionFile::readState (node.getProperty (tags::state), block) ? block.toString() : String();
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (StatePoolTests)
+
+BOOST_AUTO_TEST_CASE (SharesEqualStates)
+{
+    StatePool pool;
+    auto a = makeNode ("plugin state");
+    auto b = makeNode ("plugin state");
+    BOOST_REQUIRE_EQUAL (pool.share (a), (int64) 12);
+    BOOST_REQUIRE_EQUAL (pool.share (b), (int64) 0);
+    BOOST_REQUIRE_EQUAL (pool.getNumStates(), 1);
+    BOOST_REQUIRE (a.getProperty (tags::state).getObject() == b.getProperty (tags::state).getObject());
+    BOOST_REQUIRE_EQUAL (stateOf (b), String ("plugin state"));
+}
+
+BOOST_AUTO_TEST_CASE (SharesNestedStates)
+{
+    StatePool pool;
+    ValueTree graph (types::Node);
+    auto nodes = graph.getOrCreateChildWithName (tags::nodes, nullptr);
+    nodes.appendChild (makeNode ("one"), nullptr);
+    nodes.appendChild (makeNode ("two"), nullptr);
+    BOOST_REQUIRE_EQUAL (pool.share (graph), (int64) 6);
+    BOOST_REQUIRE_EQUAL (pool.getNumStates(), 2);
+    BOOST_REQUIRE_EQUAL (stateOf (nodes.getChild (1)), String ("two"));
+
+    // shared states are written out like any other.
+    auto copy = graph.createCopy();
+    SessionFile::resolveStates (copy);
+    BOOST_REQUIRE (copy.getChild (0).getChild (0).getProperty (tags::state).isString());
+}
+
+BOOST_AUTO_TEST_CASE (PurgesUnused)
+{
+    StatePool pool;
+    {
+        auto a = makeNode ("dropped");
+        pool.share (a);
+    }
+    auto b = makeNode ("kept");
+    pool.share (b);
+    pool.purge();
+    BOOST_REQUIRE_EQUAL (pool.getNumStates(), 1);
+    BOOST_REQUIRE_EQUAL (pool.getTotalSize(), (int64) 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
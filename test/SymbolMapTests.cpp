@@ -0,0 +1,83 @@
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <lv2/atom/atom.h>
+#include <lv2/midi/midi.h>
+
+#include <element/symbolmap.hpp>
+
+using element::SymbolMap;
+
+BOOST_AUTO_TEST_SUITE (SymbolMapTests)
+
+BOOST_AUTO_TEST_CASE (MapAndUnmap)
+{
+    SymbolMap sym;
+    const auto before = sym.size();
+    BOOST_REQUIRE (before > 0);
+
+    const auto urid = sym.map ("urn:element:test#one");
+    BOOST_REQUIRE (urid != 0);
+    BOOST_REQUIRE_EQUAL (sym.map ("urn:element:test#one"), urid);
+    BOOST_REQUIRE_EQUAL (std::string (sym.unmap (urid)), "urn:element:test#one");
+    BOOST_REQUIRE_EQUAL (sym.size(), before + 1);
+
+    BOOST_REQUIRE (sym.map ("urn:element:test#two") != urid);
+    BOOST_REQUIRE_EQUAL (sym.map (nullptr), 0u);
+    BOOST_REQUIRE (sym.unmap (0) == nullptr);
+    BOOST_REQUIRE (sym.unmap (sym.size() + 1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE (WellKnownAreMappedUpFront)
+{
+    SymbolMap sym;
+    const auto count = sym.size();
+    const auto midi = sym.map (LV2_MIDI__MidiEvent);
+    const auto seq = sym.map (LV2_ATOM__Sequence);
+    BOOST_REQUIRE (midi != 0 && midi <= count);
+    BOOST_REQUIRE (seq != 0 && seq <= count);
+    BOOST_REQUIRE_EQUAL (sym.size(), count);
+}
+
+BOOST_AUTO_TEST_CASE (Features)
+{
+    SymbolMap sym;
+    auto* map = sym.mapPtr();
+    auto* unmap = sym.unmapPtr();
+    const auto urid = map->map (map->handle, "urn:element:test#feature");
+    BOOST_REQUIRE_EQUAL (urid, sym.map ("urn:element:test#feature"));
+    BOOST_REQUIRE_EQUAL (std::string (unmap->unmap (unmap->handle, urid)), "urn:element:test#feature");
+    BOOST_REQUIRE_EQUAL (std::string (sym.mapFeature()->URI), LV2_URID__map);
+    BOOST_REQUIRE_EQUAL (std::string (sym.unmapFeature()->URI), LV2_URID__unmap);
+}
+
+BOOST_AUTO_TEST_CASE (Concurrent)
+{
+    SymbolMap sym;
+    const auto before = sym.size();
+    constexpr int numThreads = 4, numURIs = 2000;
+    std::vector<std::vector<uint32_t>> results (numThreads);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back ([&, t] {
+            for (int i = 0; i < numURIs; ++i)
+                results[t].push_back (sym.map (("urn:element:test#" + std::to_string (i)).c_str()));
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    BOOST_REQUIRE_EQUAL (sym.size(), before + numURIs);
+    for (int i = 0; i < numURIs; ++i)
+    {
+        for (int t = 1; t < numThreads; ++t)
+            BOOST_REQUIRE_EQUAL (results[t][i], results[0][i]);
+        BOOST_REQUIRE_EQUAL (std::string (sym.unmap (results[0][i])), "urn:element:test#" + std::to_string (i));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/timescale.hpp>
+
+using namespace element;
+
+namespace {
+/** A tempo change every 8 bars, alternating 100 and 140 BPM. */
+void addChanges (TimeScale& ts, int numChanges)
+{
+    for (int i = 1; i <= numChanges; ++i)
+        ts.addNode (ts.frameFromBar ((unsigned short) (i * 8)), i % 2 ? 140.0f : 100.0f);
+}
+
+/** The old cursor, walking the list from the start. */
+const TimeScale::Node* walkToFrame (const TimeScale& ts, uint64_t frame)
+{
+    const auto* node = ts.nodes().first();
+    while (node->next() != nullptr && frame >= node->next()->frame)
+        node = node->next();
+    return node;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (TimeScaleTests)
+
+BOOST_AUTO_TEST_CASE (Seeks)
+{
+    TimeScale ts;
+    addChanges (ts, 200);
+    BOOST_REQUIRE_EQUAL (ts.nodes().count(), 201);
+
+    const auto* last = ts.nodes().last();
+    const uint64_t end = last->frame + 44100;
+
+    // random access, forward and backward, matches walking the list.
+    auto& cursor = ts.cursor();
+    for (uint64_t frame = end; frame > 0; frame = frame > 33333 ? frame - 33333 : 0)
+        BOOST_REQUIRE_EQUAL (cursor.seekFrame (frame), walkToFrame (ts, frame));
+    for (uint64_t frame = 0; frame < end; frame += 1021)
+        BOOST_REQUIRE_EQUAL (cursor.seekFrame (frame), walkToFrame (ts, frame));
+
+    for (const auto* node = ts.nodes().first(); node != nullptr; node = node->next())
+    {
+        BOOST_REQUIRE_EQUAL (cursor.seekFrame (node->frame), node);
+        BOOST_REQUIRE_EQUAL (cursor.seekTick (node->tick), node);
+        BOOST_REQUIRE_EQUAL (cursor.seekBar (node->bar), node);
+        BOOST_REQUIRE_EQUAL (cursor.seekBeat (node->beat), node);
+        if (node->next() != nullptr)
+            BOOST_REQUIRE_EQUAL (cursor.seekTick (node->next()->tick - 1), node);
+    }
+
+    // ticks round trip through the map, frames are finer.
+    const uint64_t tick = last->tick + 1000;
+    BOOST_REQUIRE_EQUAL (ts.tickFromFrame (ts.frameFromTick (tick)), tick);
+}
+
+BOOST_AUTO_TEST_CASE (Edits)
+{
+    TimeScale ts;
+    addChanges (ts, 10);
+    auto* removed = ts.cursor().seekBar (40);
+    BOOST_REQUIRE_EQUAL (removed->bar, 40);
+    ts.removeNode (removed);
+    BOOST_REQUIRE_EQUAL (ts.nodes().count(), 10);
+    BOOST_REQUIRE_EQUAL (ts.cursor().seekBar (44)->bar, 32);
+
+    // copies get an index of their own.
+    TimeScale copy (ts);
+    BOOST_REQUIRE_EQUAL (copy.cursor().seekBar (44)->bar, 32);
+    BOOST_REQUIRE (copy.cursor().seekBar (44) != ts.cursor().seekBar (44));
+
+    ts.addMarker (ts.frameFromBar (4), "A");
+    ts.addMarker (ts.frameFromBar (20), "B");
+    ts.addMarker (ts.frameFromBar (12), "C");
+    BOOST_REQUIRE_EQUAL (ts.markers().seekBar (14)->text, "C");
+    BOOST_REQUIRE_EQUAL (ts.markers().seekBar (2)->text, "A");
+    BOOST_REQUIRE_EQUAL (ts.markers().seekBar (50)->text, "B");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/transport.hpp>
+
+using element::Transport;
+
+namespace {
+void process (Transport& t, int nframes)
+{
+    t.preProcess (nframes);
+    t.postProcess (nframes);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (TransportTests)
+
+BOOST_AUTO_TEST_CASE (Ordered)
+{
+    Transport t;
+    // several requests in one block all land, in order.
+    t.requestAudioFrame (1000);
+    t.requestAudioFrame (2000);
+    t.requestPlayState (true);
+    t.requestTempo (100.0);
+    t.requestTempo (90.0);
+    process (t, 512);
+    BOOST_REQUIRE (t.isPlaying());
+    BOOST_REQUIRE_EQUAL (t.getTempo(), 90.f);
+    // tempo changes keep the beat position, so compare in beats.
+    BOOST_REQUIRE_CLOSE (t.getPositionBeats(), 2000.0 / (44100.0 * 60.0 / 120.0) + 512.0 / (44100.0 * 60.0 / 90.0), 0.1);
+
+    t.requestPlayPause();
+    process (t, 512);
+    BOOST_REQUIRE (! t.isPlaying());
+    BOOST_REQUIRE_EQUAL (t.getMonitor()->tempo.get(), 90.f);
+}
+
+BOOST_AUTO_TEST_CASE (Offsets)
+{
+    Transport t;
+    t.requestPlayState (true);
+    process (t, 512);
+    BOOST_REQUIRE_EQUAL (t.getPositionFrames(), (int64_t) 512);
+
+    // locate 100 frames into the block, the rest of the block plays on.
+    t.requestAudioFrame (10000, 100);
+    process (t, 512);
+    BOOST_REQUIRE_EQUAL (t.getPositionFrames(), (int64_t) 10000 + 412);
+
+    // stop lands in the block after next.
+    t.requestPlayState (false, 600);
+    process (t, 512);
+    BOOST_REQUIRE (t.isPlaying());
+    process (t, 512);
+    BOOST_REQUIRE (! t.isPlaying());
+    BOOST_REQUIRE_EQUAL (t.getPositionFrames(), (int64_t) 10000 + 412 + 600);
+}
+
+BOOST_AUTO_TEST_CASE (TempoRamp)
+{
+    Transport t;
+    t.requestTempoRamp (140.0, 1024);
+    process (t, 512);
+    BOOST_REQUIRE_CLOSE (t.getTempo(), 130.f, 0.01);
+    process (t, 512);
+    BOOST_REQUIRE_EQUAL (t.getTempo(), 140.f);
+    process (t, 512);
+    BOOST_REQUIRE_EQUAL (t.getTempo(), 140.f);
+
+    // a plain tempo request cancels a ramp in progress.
+    t.requestTempoRamp (60.0, 44100);
+    process (t, 512);
+    t.requestTempo (120.0);
+    process (t, 512);
+    process (t, 512);
+    BOOST_REQUIRE_EQUAL (t.getTempo(), 120.f);
+}
+
+BOOST_AUTO_TEST_CASE (Meter)
+{
+    Transport t;
+    t.requestMeter (3, 2);
+    process (t, 0);
+    BOOST_REQUIRE_EQUAL (t.getBeatsPerBar(), 3);
+    BOOST_REQUIRE_EQUAL (t.getMonitor()->beatsPerBar.get(), 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
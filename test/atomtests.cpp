@@ -241,4 +241,85 @@ BOOST_AUTO_TEST_CASE (pipe)
     array.clear (true);
 }
 
+BOOST_AUTO_TEST_CASE (pipe_span)
+{
+    constexpr int count = element::AtomPipe::inlineCapacity * 2;
+    juce::OwnedArray<AtomBuffer> array;
+    juce::HeapBlock<AtomBuffer*> span (count);
+    for (int i = 0; i < count; ++i)
+        span[i] = array.add (new AtomBuffer());
+
+    // past the inline count the pipe refers to the span itself.
+    element::AtomPipe pipe (span, count);
+    BOOST_REQUIRE_EQUAL (pipe.size(), count);
+    BOOST_REQUIRE_EQUAL (pipe.writeBuffer (0), array[0]);
+    BOOST_REQUIRE_EQUAL (pipe.writeBuffer (count - 1), array[count - 1]);
+
+    span[count - 1] = array[0];
+    BOOST_REQUIRE_EQUAL (pipe.writeBuffer (count - 1), array[0]);
+    array.clear (true);
+}
+
+BOOST_AUTO_TEST_CASE (merge)
+{
+    AtomBuffer a, b, c, dst;
+    uint8_t tag = 1;
+    for (const int frame : { 0, 40, 80 })
+        a.insert (frame, 1, urids::midi_MidiEvent, &tag);
+    tag = 2;
+    for (const int frame : { 10, 40 })
+        b.insert (frame, 1, urids::midi_MidiEvent, &tag);
+    tag = 3;
+    c.insert (40, 1, urids::midi_MidiEvent, &tag);
+    tag = 0;
+    dst.insert (40, 1, urids::midi_MidiEvent, &tag);
+
+    const AtomBuffer* sources[] = { &a, &b, &c };
+    dst.merge (sources, 3);
+
+    const int64_t frames[] = { 0, 10, 40, 40, 40, 40, 80 };
+    const uint8_t tags[] = { 1, 2, 0, 1, 2, 3, 1 };
+    int index = 0;
+    LV2_ATOM_SEQUENCE_FOREACH (dst.sequence(), ev)
+    {
+        BOOST_REQUIRE (index < 7);
+        BOOST_REQUIRE_EQUAL (ev->time.frames, frames[index]);
+        BOOST_REQUIRE_EQUAL (*(const uint8_t*) LV2_ATOM_BODY (&ev->body), tags[index]);
+        ++index;
+    }
+    BOOST_REQUIRE_EQUAL (index, 7);
+    BOOST_REQUIRE_EQUAL (dst.numDropped(), 0u);
+
+    AtomBuffer copy;
+    copy.insert (5, 1, urids::midi_MidiEvent, &tag);
+    copy.copyFrom (dst);
+    BOOST_REQUIRE_EQUAL (0, std::memcmp (copy.data(), dst.data(), lv2_atom_total_size (dst.atom())));
+}
+
+BOOST_AUTO_TEST_CASE (overflow)
+{
+    AtomBuffer a, dst;
+    uint8_t data[1000] = { 0 };
+    for (int i = 0; i < 6; ++i)
+        a.insert (i, sizeof (data), 0, data);
+    for (int i = 0; i < 6; ++i)
+        dst.insert (i, sizeof (data), 0, data);
+    BOOST_REQUIRE_EQUAL (a.numDropped(), 0u);
+
+    const AtomBuffer* source = &a;
+    dst.merge (&source, 1);
+    BOOST_REQUIRE (dst.numDropped() > 0);
+    BOOST_REQUIRE (lv2_atom_total_size (dst.atom()) <= dst.capacity());
+
+    int count = 0;
+    int64_t last = -1;
+    LV2_ATOM_SEQUENCE_FOREACH (dst.sequence(), ev)
+    {
+        BOOST_REQUIRE (ev->time.frames >= last);
+        last = ev->time.frames;
+        ++count;
+    }
+    BOOST_REQUIRE_EQUAL ((uint32_t) count + dst.numDropped(), 12u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
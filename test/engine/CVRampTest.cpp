@@ -0,0 +1,41 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/cvramp.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (CVRampTest)
+
+BOOST_AUTO_TEST_CASE (StaticValue)
+{
+    CVRamp ramp (0.25f);
+    float data[13];
+    ramp.fill (data, 13, 0.25f);
+    for (auto s : data)
+        BOOST_REQUIRE_EQUAL (s, 0.25f);
+    BOOST_REQUIRE_EQUAL (ramp.getCurrentValue(), 0.25f);
+}
+
+BOOST_AUTO_TEST_CASE (LinearSegment)
+{
+    CVRamp ramp (0.f);
+    float data[8];
+    ramp.fill (data, 8, 1.f);
+    for (int i = 0; i < 8; ++i)
+        BOOST_REQUIRE_CLOSE (data[i], (float) (i + 1) / 8.f, 0.001f);
+    BOOST_REQUIRE_EQUAL (data[7], 1.f);
+    BOOST_REQUIRE_EQUAL (ramp.getCurrentValue(), 1.f);
+
+    // holds the target once it's reached.
+    ramp.fill (data, 8, 1.f);
+    for (auto s : data)
+        BOOST_REQUIRE_EQUAL (s, 1.f);
+}
+
+BOOST_AUTO_TEST_CASE (EmptyBlock)
+{
+    CVRamp ramp (0.5f);
+    ramp.fill (nullptr, 0, 1.f);
+    BOOST_REQUIRE_EQUAL (ramp.getCurrentValue(), 0.5f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,61 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/controllerdecoder.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (ControllerDecoderTest)
+
+BOOST_AUTO_TEST_CASE (Controller14)
+{
+    ControllerDecoder decoder;
+    ControllerEvent event;
+
+    // an LSB without its MSB is ignored
+    BOOST_REQUIRE (! decoder.decode (MidiMessage::controllerEvent (1, 39, 10), event));
+    BOOST_REQUIRE (! decoder.decode (MidiMessage::controllerEvent (1, 7, 100), event));
+    BOOST_REQUIRE (decoder.decode (MidiMessage::controllerEvent (1, 39, 10), event));
+    BOOST_REQUIRE_EQUAL ((int) event.type, (int) ControllerEvent::Controller14);
+    BOOST_REQUIRE_EQUAL (event.number, 7);
+    BOOST_REQUIRE_EQUAL (event.channel, 1);
+    BOOST_REQUIRE_EQUAL (event.value, (100 << 7) | 10);
+
+    // channels keep their own MSBs
+    BOOST_REQUIRE (! decoder.decode (MidiMessage::controllerEvent (2, 39, 10), event));
+}
+
+BOOST_AUTO_TEST_CASE (NRPN)
+{
+    ControllerDecoder decoder;
+    ControllerEvent event;
+
+    BOOST_REQUIRE (! decoder.decode (MidiMessage::controllerEvent (3, 99, 1), event));
+    BOOST_REQUIRE (! decoder.decode (MidiMessage::controllerEvent (3, 98, 2), event));
+    BOOST_REQUIRE (! decoder.decode (MidiMessage::controllerEvent (3, 6, 64), event));
+    BOOST_REQUIRE (decoder.decode (MidiMessage::controllerEvent (3, 38, 0), event));
+    BOOST_REQUIRE_EQUAL ((int) event.type, (int) ControllerEvent::NRPN);
+    BOOST_REQUIRE_EQUAL (event.number, (1 << 7) | 2);
+    BOOST_REQUIRE_EQUAL (event.value, 64 << 7);
+    BOOST_REQUIRE_EQUAL (event.getKey(), ControllerEvent::key (ControllerEvent::NRPN, 130));
+
+    // the null parameter deselects
+    decoder.decode (MidiMessage::controllerEvent (3, 99, 127), event);
+    decoder.decode (MidiMessage::controllerEvent (3, 98, 127), event);
+    decoder.decode (MidiMessage::controllerEvent (3, 6, 64), event);
+    BOOST_REQUIRE (! decoder.decode (MidiMessage::controllerEvent (3, 38, 0), event));
+}
+
+BOOST_AUTO_TEST_CASE (RPN)
+{
+    ControllerDecoder decoder;
+    ControllerEvent event;
+
+    decoder.decode (MidiMessage::controllerEvent (1, 101, 0), event);
+    decoder.decode (MidiMessage::controllerEvent (1, 100, 0), event);
+    decoder.decode (MidiMessage::controllerEvent (1, 6, 2), event);
+    BOOST_REQUIRE (decoder.decode (MidiMessage::controllerEvent (1, 38, 0), event));
+    BOOST_REQUIRE_EQUAL ((int) event.type, (int) ControllerEvent::RPN);
+    BOOST_REQUIRE_EQUAL (event.number, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
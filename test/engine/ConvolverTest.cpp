@@ -0,0 +1,99 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/convolver.hpp"
+
+using namespace element;
+
+namespace {
+
+AudioBuffer<float> makeNoise (int numChannels, int numSamples, int seed)
+{
+    Random random (seed);
+    AudioBuffer<float> buffer (numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            buffer.setSample (ch, i, random.nextFloat() * 2.f - 1.f);
+    return buffer;
+}
+
+/** Direct convolution of one channel. */
+std::vector<float> convolve (const float* input, int numSamples, const float* impulse, int length)
+{
+    std::vector<float> result ((size_t) numSamples, 0.f);
+    for (int n = 0; n < numSamples; ++n)
+    {
+        double sum = 0.0;
+        for (int k = 0; k < length && k <= n; ++k)
+            sum += (double) impulse[k] * input[n - k];
+        result[(size_t) n] = (float) sum;
+    }
+    return result;
+}
+
+/** Runs the convolver in place over uneven blocks and returns the worst error. */
+float runAgainstDirect (const AudioBuffer<float>& impulse, int headSize, int tailSize, bool background)
+{
+    const int numSamples = 3000;
+    auto input = makeNoise (2, numSamples, 7);
+    auto output = input;
+
+    Convolver convolver (impulse, 2, headSize, tailSize, background);
+    const int sizes[] = { 1, 7, 33, 100, 5, 64, 250 };
+    for (int start = 0, i = 0; start < numSamples; ++i)
+    {
+        const int n = jmin (numSamples - start, sizes[i % 7]);
+        const float* ins[2] = { output.getReadPointer (0, start), output.getReadPointer (1, start) };
+        float* outs[2] = { output.getWritePointer (0, start), output.getWritePointer (1, start) };
+        convolver.process (ins, outs, n);
+        start += n;
+    }
+
+    float error = 0.f;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const int irChannel = jmin (ch, impulse.getNumChannels() - 1);
+        const auto expected = convolve (input.getReadPointer (ch), numSamples, impulse.getReadPointer (irChannel), impulse.getNumSamples());
+        for (int i = 0; i < numSamples; ++i)
+            error = jmax (error, std::abs (output.getSample (ch, i) - expected[(size_t) i]));
+    }
+    return error;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (ConvolverTest)
+
+BOOST_AUTO_TEST_CASE (ImpulseIsIdentity)
+{
+    AudioBuffer<float> impulse (1, 1);
+    impulse.setSample (0, 0, 1.f);
+    BOOST_REQUIRE_SMALL (runAgainstDirect (impulse, 16, 64, false), 0.0001f);
+}
+
+BOOST_AUTO_TEST_CASE (HeadOnly)
+{
+    const auto impulse = makeNoise (1, 50, 1);
+    Convolver convolver (impulse, 2, 16, 64, false);
+    BOOST_REQUIRE_EQUAL (convolver.getLength(), 50);
+    BOOST_REQUIRE_SMALL (runAgainstDirect (impulse, 16, 64, false), 0.0001f);
+}
+
+BOOST_AUTO_TEST_CASE (EarlyAndLate)
+{
+    // covers the head, the early block and several late partitions.
+    const auto impulse = makeNoise (2, 700, 2);
+    BOOST_REQUIRE_SMALL (runAgainstDirect (impulse, 16, 64, false), 0.0001f);
+}
+
+BOOST_AUTO_TEST_CASE (BackgroundTail)
+{
+    const auto impulse = makeNoise (2, 700, 3);
+    BOOST_REQUIRE_SMALL (runAgainstDirect (impulse, 16, 64, true), 0.0001f);
+}
+
+BOOST_AUTO_TEST_CASE (MonoImpulseOnStereo)
+{
+    const auto impulse = makeNoise (1, 300, 4);
+    BOOST_REQUIRE_SMALL (runAgainstDirect (impulse, 32, 64, true), 0.0001f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
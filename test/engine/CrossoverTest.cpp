@@ -0,0 +1,116 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/crossover.hpp"
+
+using namespace element;
+
+namespace {
+
+constexpr int numChannels = 3; // the pair and single paths both run
+constexpr int numSamples = 4000;
+
+AudioBuffer<float> makeNoise()
+{
+    Random random (99);
+    AudioBuffer<float> buffer (numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            buffer.setSample (ch, i, random.nextFloat() * 2.f - 1.f);
+    return buffer;
+}
+
+float getSplitFrequency (int split) { return 100.f * std::pow (2.f, (float) split * 1.5f); }
+
+/** Split buffer into bands with blocks of blockSize, band 0 in place. */
+AudioBuffer<float> split (Crossover& crossover, const AudioBuffer<float>& input, int blockSize)
+{
+    const int numBands = crossover.getNumBands();
+    AudioBuffer<float> bands (numBands * numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        bands.copyFrom (ch, 0, input, ch, 0, numSamples);
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        const int n = jmin (blockSize, numSamples - start);
+        const float* in[numChannels];
+        float* out[Crossover::maxBands * numChannels];
+        for (int ch = 0; ch < numChannels; ++ch)
+            in[ch] = bands.getReadPointer (ch, start);
+        for (int i = 0; i < numBands * numChannels; ++i)
+            out[i] = bands.getWritePointer (i, start);
+        crossover.process (in, out, numChannels, n);
+    }
+
+    return bands;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (CrossoverTest)
+
+BOOST_AUTO_TEST_CASE (BandsSumToAllpass)
+{
+    const auto input = makeNoise();
+
+    for (int numBands = Crossover::minBands; numBands <= Crossover::maxBands; ++numBands)
+    {
+        Crossover crossover;
+        crossover.setNumBands (numBands);
+        crossover.prepare (48000.0);
+        for (int i = 0; i < numBands - 1; ++i)
+            crossover.setFrequency (i, getSplitFrequency (i));
+        const auto bands = split (crossover, input, 500);
+
+        // the sum of two bands is a split's allpass, chain one per split.
+        auto expected = input;
+        for (int i = 0; i < numBands - 1; ++i)
+        {
+            Crossover two;
+            two.setNumBands (2);
+            two.prepare (48000.0);
+            two.setFrequency (0, getSplitFrequency (i));
+            const auto pair = split (two, expected, numSamples);
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                expected.copyFrom (ch, 0, pair, ch, 0, numSamples);
+                expected.addFrom (ch, 0, pair, numChannels + ch, 0, numSamples);
+            }
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                float sum = 0.f;
+                for (int band = 0; band < numBands; ++band)
+                    sum += bands.getSample (band * numChannels + ch, i);
+                BOOST_REQUIRE_SMALL (sum - expected.getSample (ch, i), 0.0005f);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (BandsSeparate)
+{
+    // a tone well inside the middle band barely reaches the others.
+    Crossover crossover;
+    crossover.setNumBands (3);
+    crossover.prepare (48000.0);
+    crossover.setFrequency (0, 200.f);
+    crossover.setFrequency (1, 5000.f);
+
+    AudioBuffer<float> tone (numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            tone.setSample (ch, i, std::sin (MathConstants<float>::twoPi * 1000.f * (float) i / 48000.f));
+
+    const auto bands = split (crossover, tone, 256);
+    const int settled = numSamples / 2;
+    const float low = bands.getRMSLevel (0, settled, numSamples - settled);
+    const float mid = bands.getRMSLevel (numChannels, settled, numSamples - settled);
+    const float high = bands.getRMSLevel (numChannels * 2, settled, numSamples - settled);
+    BOOST_REQUIRE (mid > 0.6f);
+    BOOST_REQUIRE (low < 0.05f);
+    BOOST_REQUIRE (high < 0.05f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,179 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/diskstream.hpp"
+
+using namespace element;
+
+namespace {
+
+constexpr int testLength = 4000;
+
+/** A stereo WAV where each sample is its position over the length, negated on the right. */
+File writeTestFile()
+{
+    auto file = File::createTempFile (".wav");
+    WavAudioFormat wav;
+    std::unique_ptr<AudioFormatWriter> writer (wav.createWriterFor (new FileOutputStream (file), 44100.0, 2, 24, {}, 0));
+    BOOST_REQUIRE (writer != nullptr);
+
+    AudioBuffer<float> data (2, testLength);
+    for (int i = 0; i < testLength; ++i)
+    {
+        data.setSample (0, i, (float) i / testLength);
+        data.setSample (1, i, -(float) i / testLength);
+    }
+    writer->writeFromAudioSampleBuffer (data, 0, testLength);
+    return file;
+}
+
+void requireSamples (const AudioBuffer<float>& buffer, int numSamples, juce::int64 firstPosition)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto expected = (float) ((firstPosition + i) % testLength) / testLength;
+        BOOST_REQUIRE_SMALL (buffer.getSample (0, i) - expected, 0.0001f);
+        BOOST_REQUIRE_SMALL (buffer.getSample (1, i) + expected, 0.0001f);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (DiskStreamTest)
+
+BOOST_AUTO_TEST_CASE (ReadSeekLoop)
+{
+    const auto file = writeTestFile();
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    {
+        auto stream = DiskStream::open (formats, file);
+        BOOST_REQUIRE (stream != nullptr);
+        BOOST_REQUIRE (stream->isMemoryMapped());
+        BOOST_REQUIRE_EQUAL (stream->getLengthInSamples(), (juce::int64) testLength);
+
+        AudioBuffer<float> buffer (2, 512);
+        stream->prefetch();
+        BOOST_REQUIRE (! stream->update());
+        BOOST_REQUIRE_EQUAL (stream->read (buffer.getArrayOfWritePointers(), 2, 0, 512), 512);
+        requireSamples (buffer, 512, 0);
+        BOOST_REQUIRE_EQUAL (stream->getPosition(), (juce::int64) 512);
+
+        // nothing from before a seek plays after it.
+        stream->seek (1000);
+        BOOST_REQUIRE_EQUAL (stream->read (buffer.getArrayOfWritePointers(), 2, 0, 512), 0);
+        BOOST_REQUIRE_EQUAL (buffer.getMagnitude (0, 512), 0.f);
+        stream->prefetch();
+        BOOST_REQUIRE (stream->update());
+        BOOST_REQUIRE_EQUAL (stream->getPosition(), (juce::int64) 1000);
+        stream->prefetch();
+        BOOST_REQUIRE_EQUAL (stream->read (buffer.getArrayOfWritePointers(), 2, 0, 512), 512);
+        requireSamples (buffer, 512, 1000);
+
+        // ends without looping.
+        stream->seek (testLength - 100);
+        stream->prefetch();
+        stream->update();
+        stream->prefetch();
+        BOOST_REQUIRE_EQUAL (stream->read (buffer.getArrayOfWritePointers(), 2, 0, 512), 100);
+        BOOST_REQUIRE (stream->isFinished());
+        BOOST_REQUIRE_EQUAL (stream->getNumUnderruns(), (juce::int64) 0);
+
+        // wraps when looping.
+        stream->setLooping (true);
+        stream->seek (testLength - 100);
+        stream->prefetch();
+        stream->update();
+        stream->prefetch();
+        BOOST_REQUIRE (! stream->isFinished());
+        BOOST_REQUIRE_EQUAL (stream->read (buffer.getArrayOfWritePointers(), 2, 0, 512), 512);
+        requireSamples (buffer, 512, testLength - 100);
+        BOOST_REQUIRE_EQUAL (stream->getPosition(), (juce::int64) 412);
+    }
+
+    file.deleteFile();
+}
+
+BOOST_AUTO_TEST_CASE (Locate)
+{
+    const auto file = writeTestFile();
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    {
+        auto stream = DiskStream::open (formats, file);
+        BOOST_REQUIRE (stream != nullptr);
+        AudioBuffer<float> buffer (2, 256);
+
+        // ahead within what's read, no I/O needed.
+        stream->prefetch();
+        stream->update();
+        BOOST_REQUIRE (stream->locate (300));
+        BOOST_REQUIRE_EQUAL (stream->read (buffer.getArrayOfWritePointers(), 2, 0, 256), 256);
+        requireSamples (buffer, 256, 300);
+
+        // behind goes through a seek.
+        BOOST_REQUIRE (! stream->locate (100));
+        BOOST_REQUIRE (stream->isSeeking());
+        stream->prefetch();
+        BOOST_REQUIRE (stream->update());
+        stream->prefetch();
+        BOOST_REQUIRE (stream->locate (100));
+        BOOST_REQUIRE_EQUAL (stream->read (buffer.getArrayOfWritePointers(), 2, 0, 256), 256);
+        requireSamples (buffer, 256, 100);
+    }
+
+    file.deleteFile();
+}
+
+BOOST_AUTO_TEST_CASE (FollowTimeline)
+{
+    const auto file = writeTestFile();
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    {
+        DiskStreamPlayer player;
+        player.prepareToPlay (256, 44100.0);
+        player.setStream (DiskStream::open (formats, file));
+        BOOST_REQUIRE (player.getStream() != nullptr);
+
+        AudioBuffer<float> buffer (2, 256);
+        const AudioSourceChannelInfo info (buffer);
+
+        // starts in the block the timeline does, at its position.
+        player.follow (true, 1000);
+        BOOST_REQUIRE (player.isPlaying());
+        player.getNextAudioBlock (info);
+        requireSamples (buffer, 256, 1000);
+
+        player.follow (true, 1256);
+        player.getNextAudioBlock (info);
+        requireSamples (buffer, 256, 1256);
+
+        // jumps forward with it.
+        player.follow (true, 2000);
+        player.getNextAudioBlock (info);
+        requireSamples (buffer, 256, 2000);
+
+        player.follow (false, 2256);
+        BOOST_REQUIRE (! player.isPlaying());
+        player.getNextAudioBlock (info);
+        BOOST_REQUIRE_EQUAL (buffer.getMagnitude (0, 256), 0.f);
+
+        // past the end without looping doesn't play.
+        player.follow (true, testLength + 10);
+        BOOST_REQUIRE (! player.isPlaying());
+        player.releaseResources();
+    }
+
+    file.deleteFile();
+}
+
+BOOST_AUTO_TEST_CASE (MissingFile)
+{
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+    BOOST_REQUIRE (DiskStream::open (formats, File::createTempFile (".wav")) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include "engine/diskwriter.hpp"
+
+using namespace element;
+
+namespace {
+/** Reads a file back, or nullptr. */
+std::unique_ptr<AudioFormatReader> readBack (const File& file)
+{
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+    return std::unique_ptr<AudioFormatReader> (formats.createReaderFor (file));
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (DiskWriterTest)
+
+BOOST_AUTO_TEST_CASE (Write)
+{
+    const auto file = File::createTempFile (".wav");
+    DiskWriter::Options options;
+    options.numChannels = 2;
+    options.reserveSeconds = 10.0;
+
+    {
+        auto writer = DiskWriter::create (file, options);
+        BOOST_REQUIRE (writer != nullptr);
+
+        AudioBuffer<float> block (2, 512);
+        for (int i = 0; i < 100; ++i)
+        {
+            for (int s = 0; s < 512; ++s)
+            {
+                block.setSample (0, s, (float) (i * 512 + s) / 51200.f);
+                block.setSample (1, s, -(float) (i * 512 + s) / 51200.f);
+            }
+            // a mono source leaves the second channel silent.
+            BOOST_REQUIRE (writer->write (block.getArrayOfReadPointers(), i < 50 ? 2 : 1, 512));
+        }
+
+        writer->flush();
+        BOOST_REQUIRE_EQUAL (writer->getNumWritten(), (juce::int64) 51200);
+        BOOST_REQUIRE_EQUAL (writer->getNumOverflows(), (juce::int64) 0);
+        BOOST_REQUIRE (! writer->hasFailed());
+    }
+
+    auto reader = readBack (file);
+    BOOST_REQUIRE (reader != nullptr);
+    BOOST_REQUIRE_EQUAL (reader->lengthInSamples, (juce::int64) 51200);
+    BOOST_REQUIRE_EQUAL (reader->numChannels, 2u);
+
+    AudioBuffer<float> data (2, 51200);
+    reader->read (&data, 0, 51200, 0, true, true);
+    BOOST_REQUIRE_SMALL (data.getSample (0, 1000) - 1000.f / 51200.f, 0.0001f);
+    BOOST_REQUIRE_SMALL (data.getSample (1, 1000) + 1000.f / 51200.f, 0.0001f);
+    BOOST_REQUIRE_EQUAL (data.getSample (1, 40000), 0.f);
+    reader.reset();
+
+    // what was reserved and not used is given back.
+    BOOST_REQUIRE (file.getSize() < 51200 * 2 * 3 + 1024);
+    file.deleteFile();
+}
+
+BOOST_AUTO_TEST_CASE (Overflow)
+{
+    const auto file = File::createTempFile (".wav");
+    DiskWriter::Options options;
+    options.numChannels = 1;
+    options.bufferSeconds = 0.0;
+
+    {
+        auto writer = DiskWriter::create (file, options);
+        BOOST_REQUIRE (writer != nullptr);
+
+        // more than the FIFO holds in one block.
+        AudioBuffer<float> block (1, 1 << 16);
+        block.clear();
+        BOOST_REQUIRE (! writer->write (block.getArrayOfReadPointers(), 1, block.getNumSamples()));
+        BOOST_REQUIRE_EQUAL (writer->getNumOverflows(), (juce::int64) 1);
+        BOOST_REQUIRE (writer->getNumDropped() > 0);
+
+        writer->flush();
+        BOOST_REQUIRE_EQUAL (writer->getNumWritten() + writer->getNumDropped(), (juce::int64) block.getNumSamples());
+    }
+
+    file.deleteFile();
+}
+
+BOOST_AUTO_TEST_CASE (Formats)
+{
+    DiskWriter::Options options;
+    options.format = DiskWriter::flac;
+    options.bitsPerSample = 24;
+
+    const auto file = File::createTempFile (DiskWriter::getFileExtension (options.format));
+    {
+        auto writer = DiskWriter::create (file, options);
+        BOOST_REQUIRE (writer != nullptr);
+        AudioBuffer<float> block (2, 4096);
+        block.clear();
+        writer->write (block.getArrayOfReadPointers(), 2, 4096);
+    }
+
+    auto reader = readBack (file);
+    BOOST_REQUIRE (reader != nullptr);
+    BOOST_REQUIRE_EQUAL (reader->lengthInSamples, (juce::int64) 4096);
+    reader.reset();
+    file.deleteFile();
+
+    // FLAC has no 32 bit samples.
+    options.bitsPerSample = 32;
+    BOOST_REQUIRE (DiskWriter::create (file, options) == nullptr);
+    BOOST_REQUIRE (! file.existsAsFile());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
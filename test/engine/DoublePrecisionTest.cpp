@@ -0,0 +1,103 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture/PreparedGraph.h"
+#include "nodes/audioprocessor.hpp"
+#include "nodes/baseprocessor.hpp"
+
+using namespace element;
+
+namespace {
+/** Halves its input and counts the blocks of each precision. */
+class HalfGain : public BaseProcessor {
+public:
+    HalfGain()
+        : BaseProcessor (BusesProperties()
+                             .withInput ("Main", AudioChannelSet::stereo())
+                             .withOutput ("Main", AudioChannelSet::stereo())) {}
+
+    const String getName() const override { return "Half Gain"; }
+    void prepareToPlay (double, int) override {}
+    void releaseResources() override {}
+
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+    void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+    {
+        ++numFloat;
+        buffer.applyGain (0.5f);
+    }
+    void processBlock (AudioBuffer<double>& buffer, MidiBuffer&) override
+    {
+        ++numDouble;
+        buffer.applyGain (0.5);
+    }
+
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+    AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram (int) override {}
+    const String getProgramName (int) override { return {}; }
+    void changeProgramName (int, const String&) override {}
+    void getStateInformation (MemoryBlock&) override {}
+    void setStateInformation (const void*, int) override {}
+    void fillInPluginDescription (PluginDescription& desc) const override { desc.name = getName(); }
+
+    int numFloat = 0, numDouble = 0;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (DoublePrecisionTest)
+
+BOOST_AUTO_TEST_CASE (Graph)
+{
+    PreparedGraph pg;
+    auto* plugin = new HalfGain();
+    auto* node = new AudioProcessorNode (plugin);
+    ProcessorPtr ptr = pg.graph.addNode (node);
+    while (node->isPreparing())
+        Thread::sleep (1);
+    pg.graph.rebuild();
+
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer audio (2, 512), cv;
+    auto renderBlock = [&]() {
+        RenderContext rc (audio, cv, midi, atoms, 512);
+        pg.graph.render (rc);
+    };
+
+    renderBlock();
+    BOOST_REQUIRE (! plugin->isUsingDoublePrecision());
+    BOOST_REQUIRE_EQUAL (plugin->numFloat, 1);
+
+    pg.graph.setDoublePrecision (true);
+    BOOST_REQUIRE (pg.graph.isDoublePrecision());
+    BOOST_REQUIRE (plugin->isUsingDoublePrecision());
+    renderBlock();
+    BOOST_REQUIRE_EQUAL (plugin->numFloat, 1);
+    BOOST_REQUIRE_EQUAL (plugin->numDouble, 1);
+
+    // converted in and out.
+    AudioSampleBuffer block (2, 64);
+    for (int i = 0; i < 64; ++i)
+        block.setSample (1, i, (float) i);
+    BOOST_REQUIRE (node->renderDouble (block, midi, false));
+    BOOST_REQUIRE_EQUAL (block.getSample (1, 63), 31.5f);
+
+    // larger than prepared for.
+    AudioSampleBuffer large (2, 1024);
+    BOOST_REQUIRE (! node->renderDouble (large, midi, false));
+
+    pg.graph.setDoublePrecision (false);
+    BOOST_REQUIRE (! plugin->isUsingDoublePrecision());
+    renderBlock();
+    BOOST_REQUIRE_EQUAL (plugin->numFloat, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,148 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+#include "engine/driftfifo.hpp"
+
+using namespace element;
+
+namespace {
+struct Result
+{
+    int underruns = 0, overruns = 0;
+    double ratio = 0.0; // average over the last minute, less one, in ppm
+    float maxStep = 0.f; // largest change between frames read
+};
+
+/** Runs two simulated devices for a few minutes, the writer's clock off
+    by ppm, each callback up to jitter seconds late, and reads a sine. */
+Result run (double ppm, int writerBlock, int readerBlock, double jitter)
+{
+    constexpr double rate = 48000.0, seconds = 180.0, frequency = 200.0;
+    const double writerRate = rate * (1.0 + ppm * 1.0e-6);
+
+    DriftFifo fifo;
+    fifo.prepare (1, std::max (writerBlock, readerBlock), rate, rate);
+
+    std::vector<float> in ((size_t) writerBlock), out ((size_t) readerBlock);
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<double> late (0.0, jitter);
+    double writerTime = 0.0003, readerTime = 0.0, sum = 0.0;
+    juce::int64 frame = 0;
+    int count = 0;
+    float last = 0.f;
+    Result result;
+
+    while (readerTime < seconds)
+    {
+        // whichever block would finish first runs next.
+        const double writerEnd = writerTime + writerBlock / writerRate;
+        const double readerEnd = readerTime + readerBlock / rate;
+        if (writerEnd <= readerEnd)
+        {
+            for (int i = 0; i < writerBlock; ++i, ++frame)
+                in[(size_t) i] = (float) std::sin (juce::MathConstants<double>::twoPi * frequency * (double) frame / writerRate);
+            const float* data[] = { in.data() };
+            fifo.write (data, 1, writerBlock, writerEnd + late (rng));
+            writerTime = writerEnd;
+            continue;
+        }
+
+        float* data[] = { out.data() };
+        fifo.read (data, 1, readerBlock, readerEnd + late (rng));
+        readerTime = readerEnd;
+
+        // a minute to settle, then nothing may go wrong.
+        if (readerTime < 60.0)
+        {
+            result.underruns = -fifo.getNumUnderruns();
+            result.overruns = -fifo.getNumOverruns();
+            last = out.back();
+            continue;
+        }
+
+        for (auto x : out)
+        {
+            result.maxStep = std::max (result.maxStep, std::abs (x - last));
+            last = x;
+        }
+
+        if (readerTime >= seconds - 60.0)
+        {
+            sum += fifo.getRatio();
+            ++count;
+        }
+    }
+
+    result.underruns += fifo.getNumUnderruns();
+    result.overruns += fifo.getNumOverruns();
+    result.ratio = (sum / count - 1.0) * 1.0e6;
+    return result;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (DriftFifoTest)
+
+BOOST_AUTO_TEST_CASE (FollowsDrift)
+{
+    struct Case
+    {
+        double ppm;
+        int writerBlock, readerBlock;
+        double jitter;
+    };
+
+    const Case cases[] = {
+        { 100.0, 256, 128, 0.0 },
+        { -300.0, 128, 512, 0.002 },
+        { 50.0, 64, 64, 0.0005 },
+        { -300.0, 512, 512, 0.0 },
+        { -500.0, 480, 512, 0.001 },
+        { 1000.0, 256, 256, 0.001 },
+        { -1500.0, 1024, 1024, 0.002 },
+    };
+
+    // a 200 Hz sine at 48 kHz moves at most this much from frame to frame.
+    const float slope = (float) (juce::MathConstants<double>::twoPi * 200.0 / 48000.0);
+
+    for (const auto& c : cases)
+    {
+        BOOST_TEST_CONTEXT (c.ppm << " ppm, " << c.writerBlock << " to " << c.readerBlock)
+        {
+            const auto result = run (c.ppm, c.writerBlock, c.readerBlock, c.jitter);
+            BOOST_REQUIRE_EQUAL (result.underruns, 0);
+            BOOST_REQUIRE_EQUAL (result.overruns, 0);
+            BOOST_REQUIRE_LT (std::abs (result.ratio - c.ppm), 15.0);
+            BOOST_REQUIRE_LT (result.maxStep, slope * 1.01f);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (StartsSilent)
+{
+    DriftFifo fifo;
+    fifo.prepare (2, 256, 48000.0, 48000.0);
+
+    std::vector<float> ones (256, 1.f), left (256, 1.f), right (256, 1.f);
+    const float* in[] = { ones.data(), ones.data() };
+    float* out[] = { left.data(), right.data() };
+
+    // nothing comes out until the target is buffered.
+    fifo.write (in, 2, 256, 0.0);
+    fifo.read (out, 2, 256, 0.001);
+    BOOST_REQUIRE_EQUAL (left[0], 0.f);
+    BOOST_REQUIRE_EQUAL (right[255], 0.f);
+    BOOST_REQUIRE_EQUAL (fifo.getNumUnderruns(), 0);
+
+    for (int i = 0; i < 4; ++i)
+        fifo.write (in, 2, 256, 0.002);
+    fifo.read (out, 2, 256, 0.002);
+    BOOST_REQUIRE_CLOSE (left[128], 1.f, 0.001);
+    BOOST_REQUIRE_CLOSE (right[255], 1.f, 0.001);
+    BOOST_REQUIRE_LE (fifo.getNumReady(), fifo.getTarget());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,28 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/fastdecibels.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (FastDecibelsTest)
+
+BOOST_AUTO_TEST_CASE (MatchesExact)
+{
+    for (float dB = -120.f; dB <= 24.f; dB += 0.37f)
+    {
+        const float gain = std::pow (10.f, dB / 20.f);
+        BOOST_REQUIRE_SMALL (FastDecibels::gainToDecibels (gain) - dB, 0.001f);
+        BOOST_REQUIRE_CLOSE (FastDecibels::decibelsToGain (dB), gain, 0.001f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (Limits)
+{
+    // silence and overflow stay finite.
+    BOOST_REQUIRE (std::isfinite (FastDecibels::gainToDecibels (0.f)));
+    BOOST_REQUIRE (std::isfinite (FastDecibels::decibelsToGain (2000.f)));
+    BOOST_REQUIRE_SMALL (FastDecibels::decibelsToGain (-2000.f), 1.0e-30f);
+    BOOST_REQUIRE_SMALL (FastDecibels::log2 (1.f), 0.0002f);
+    BOOST_REQUIRE_CLOSE (FastDecibels::exp2 (3.f), 8.f, 0.001f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
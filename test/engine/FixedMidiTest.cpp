@@ -0,0 +1,74 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/fixedmidi.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (FixedMidiTest)
+
+BOOST_AUTO_TEST_CASE (AddAndCopy)
+{
+    MidiBuffer src, dst;
+    FixedMidi::reserve (src);
+    FixedMidi::reserve (dst);
+    src.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 10);
+    src.addEvent (MidiMessage::noteOff (1, 60), 90);
+
+    BOOST_REQUIRE_EQUAL (FixedMidi::add (dst, src, 0, 64, 0), 0);
+    BOOST_REQUIRE_EQUAL (dst.getNumEvents(), 1);
+    BOOST_REQUIRE_EQUAL (dst.getFirstEventTime(), 10);
+
+    BOOST_REQUIRE_EQUAL (FixedMidi::copy (dst, src), 0);
+    BOOST_REQUIRE_EQUAL (dst.getNumEvents(), 2);
+    BOOST_REQUIRE_EQUAL (dst.getLastEventTime(), 90);
+
+    dst.clear();
+    FixedMidi::add (dst, src, 64, 64, -64);
+    BOOST_REQUIRE_EQUAL (dst.getNumEvents(), 1);
+    BOOST_REQUIRE_EQUAL (dst.getFirstEventTime(), 26);
+}
+
+BOOST_AUTO_TEST_CASE (Overflow)
+{
+    FixedMidi::resetNumDropped();
+    MidiBuffer dst;
+    FixedMidi::reserve (dst);
+
+    const auto msg = MidiMessage::controllerEvent (1, 7, 64);
+    int added = 0;
+    for (int i = 0; i < FixedMidi::capacity; ++i)
+        if (FixedMidi::add (dst, msg.getRawData(), msg.getRawDataSize(), i % 512))
+            ++added;
+
+    BOOST_REQUIRE (added > 0);
+    BOOST_REQUIRE_EQUAL (dst.getNumEvents(), added);
+    BOOST_REQUIRE (dst.data.size() <= FixedMidi::capacity);
+    BOOST_REQUIRE_EQUAL (FixedMidi::getNumDropped(), (int64) (FixedMidi::capacity - added));
+
+    FixedMidi::resetNumDropped();
+    BOOST_REQUIRE_EQUAL (FixedMidi::getNumDropped(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (Remap)
+{
+    MidiBuffer buffer;
+    buffer.addEvent (MidiMessage::noteOn (1, 60, 0.5f), 3);
+    buffer.addEvent (MidiMessage::createSysExMessage ("abc", 3), 10);
+    buffer.addEvent (MidiMessage::noteOff (1, 60), 11);
+    const auto size = buffer.data.size();
+
+    FixedMidi::remap (buffer, 4, 1);
+    BOOST_REQUIRE_EQUAL (buffer.data.size(), size);
+    int expected[] = { 12, 40, 44 };
+    int i = 0;
+    for (const auto ev : buffer)
+        BOOST_REQUIRE_EQUAL (ev.samplePosition, expected[i++]);
+    BOOST_REQUIRE_EQUAL (i, 3);
+    BOOST_REQUIRE ((*buffer.begin()).getMessage().isNoteOn());
+
+    FixedMidi::remap (buffer, 1, 4);
+    BOOST_REQUIRE_EQUAL (buffer.getFirstEventTime(), 3);
+    BOOST_REQUIRE_EQUAL (buffer.getLastEventTime(), 11);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
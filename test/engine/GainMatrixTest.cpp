@@ -0,0 +1,52 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/gainmatrix.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (GainMatrixTest)
+
+BOOST_AUTO_TEST_CASE (SparsePatches)
+{
+    MatrixState patches (3, 2);
+    patches.set (0, 0, true);
+    patches.set (2, 0, true);
+    patches.set (1, 1, true);
+
+    float gains[] = { 1.f, 1.f, 1.f, 0.f, 0.5f, 1.f };
+    GainMatrix matrix (patches, gains);
+    BOOST_REQUIRE_EQUAL (matrix.getNumPatches(), 2); // 1 -> 1 has a gain of zero
+    BOOST_REQUIRE_EQUAL (matrix.getGain (2, 0), 0.5f);
+    BOOST_REQUIRE_EQUAL (matrix.getGain (1, 1), 0.f);
+
+    AudioSampleBuffer in (3, 4), out (2, 4);
+    for (int c = 0; c < 3; ++c)
+        FloatVectorOperations::fill (in.getWritePointer (c), (float) (c + 1), 4);
+    out.clear();
+    FloatVectorOperations::fill (out.getWritePointer (1), 9.f, 4);
+
+    matrix.process (in.getArrayOfReadPointers(), out.getArrayOfWritePointers(), 4);
+    BOOST_REQUIRE_EQUAL (out.getSample (0, 3), 1.f + 3.f * 0.5f);
+    BOOST_REQUIRE_EQUAL (out.getSample (1, 0), 0.f); // unpatched outputs are cleared
+}
+
+BOOST_AUTO_TEST_CASE (LongBlocks)
+{
+    const int size = 16, numSamples = GainMatrix::chunkSize * 3 + 17;
+    MatrixState patches (size, size);
+    for (int i = 0; i < size; ++i)
+        patches.set (i, size - 1 - i, true);
+    GainMatrix matrix (patches);
+
+    AudioSampleBuffer in (size, numSamples), out (size, numSamples);
+    for (int c = 0; c < size; ++c)
+        for (int i = 0; i < numSamples; ++i)
+            in.setSample (c, i, (float) (c * numSamples + i));
+
+    matrix.process (in.getArrayOfReadPointers(), out.getArrayOfWritePointers(), numSamples);
+    for (int c = 0; c < size; ++c)
+        for (int i = 0; i < numSamples; i += 97)
+            BOOST_REQUIRE_EQUAL (out.getSample (size - 1 - c, i), in.getSample (c, i));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
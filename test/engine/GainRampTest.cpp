@@ -0,0 +1,66 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/gainramp.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (GainRampTest)
+
+BOOST_AUTO_TEST_CASE (AddMeasuresInput)
+{
+    // odd length so the tail loop runs too.
+    float src[11], dst[11];
+    for (int i = 0; i < 11; ++i)
+    {
+        src[i] = (i % 2 == 0) ? 0.5f : -0.25f;
+        dst[i] = 1.f;
+    }
+
+    const auto sum = GainRamp::add (dst, src, 11, 0.f, 1.f);
+
+    float expected = 0.f;
+    for (int i = 0; i < 11; ++i)
+    {
+        expected += src[i] * src[i];
+        BOOST_REQUIRE_CLOSE (dst[i], 1.f + src[i] * ((float) i / 11.f), 0.001f);
+    }
+    BOOST_REQUIRE_CLOSE (sum, expected, 0.001f);
+
+    // a flat gain takes the constant path.
+    for (auto& s : dst)
+        s = 0.f;
+    GainRamp::add (dst, src, 11, 0.5f, 0.5f);
+    for (int i = 0; i < 11; ++i)
+        BOOST_REQUIRE_EQUAL (dst[i], src[i] * 0.5f);
+}
+
+BOOST_AUTO_TEST_CASE (CopyMeasuresOutput)
+{
+    float src[9], dst[9];
+    for (int i = 0; i < 9; ++i)
+        src[i] = 1.f;
+
+    const auto sum = GainRamp::copy (dst, src, 9, 1.f, 0.f);
+
+    float expected = 0.f;
+    for (int i = 0; i < 9; ++i)
+    {
+        BOOST_REQUIRE_CLOSE (dst[i] + 1.f, 2.f - (float) i / 9.f, 0.001f);
+        expected += dst[i] * dst[i];
+    }
+    BOOST_REQUIRE_CLOSE (sum, expected, 0.001f);
+    BOOST_REQUIRE_EQUAL (GainRamp::copy (dst, src, 0, 1.f, 1.f), 0.f);
+}
+
+BOOST_AUTO_TEST_CASE (PanLaw)
+{
+    float left = 0.f, right = 0.f;
+    GainRamp::panGains (0.f, left, right);
+    BOOST_REQUIRE_CLOSE (left, 1.f, 0.001f);
+    BOOST_REQUIRE_CLOSE (right, 1.f, 0.001f);
+
+    GainRamp::panGains (-1.f, left, right);
+    BOOST_REQUIRE_CLOSE (left * left + right * right, 2.f, 0.001f);
+    BOOST_REQUIRE_SMALL (right, 0.0001f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/gainstage.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (GainStageTest)
+
+BOOST_AUTO_TEST_CASE (InPlaceTrim)
+{
+    // buffer 0 is the zero buffer, 1 and 2 are a stereo pair.
+    float zero[8] {}, left[8], right[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        left[i] = 1.f;
+        right[i] = -1.f;
+    }
+    float* buffers[] = { zero, left, right };
+    juce::uint8 silence[] = { 1, 0, 0 };
+
+    FusedGain fused ({ { 0, 0 }, { 1, 1 } }, { { 1 }, { 2 } }, { 1, 2 });
+    BOOST_REQUIRE (! fused.isChunked());
+
+    const float start[] = { 0.5f, 0.f }, end[] = { 0.5f, 0.f };
+    fused.process (buffers, silence, start, end, 8);
+    for (int i = 0; i < 8; ++i)
+    {
+        BOOST_REQUIRE_EQUAL (left[i], 0.5f);
+        BOOST_REQUIRE_EQUAL (right[i], 0.f);
+    }
+    BOOST_REQUIRE_EQUAL (silence[1], 0);
+    BOOST_REQUIRE_EQUAL (silence[2], 1);
+}
+
+BOOST_AUTO_TEST_CASE (GathersSources)
+{
+    // one input summed from two buffers, written to a third.
+    float zero[4] {}, a[4] { 1, 1, 1, 1 }, b[4] { 2, 2, 2, 2 }, out[4] {};
+    float* buffers[] = { zero, a, b, out };
+    juce::uint8 silence[] = { 1, 0, 0, 1 };
+
+    FusedGain fused ({ { 0, 0 } }, { { 1, 2 } }, { 3 });
+    const float start[] = { 2.f }, end[] = { 2.f };
+    fused.process (buffers, silence, start, end, 4);
+    for (int i = 0; i < 4; ++i)
+        BOOST_REQUIRE_EQUAL (out[i], 6.f);
+    BOOST_REQUIRE_EQUAL (silence[3], 0);
+
+    // silent sources are skipped.
+    silence[2] = 1;
+    fused.process (buffers, silence, start, end, 4);
+    for (int i = 0; i < 4; ++i)
+        BOOST_REQUIRE_EQUAL (out[i], 2.f);
+}
+
+BOOST_AUTO_TEST_CASE (CrossMixIsChunked)
+{
+    // outputs swap their inputs in place, like a wet/dry mix.
+    const int n = FusedGain::chunkSize + 7;
+    std::vector<float> zero ((size_t) n), left ((size_t) n, 1.f), right ((size_t) n, 3.f);
+    float* buffers[] = { zero.data(), left.data(), right.data() };
+    juce::uint8 silence[] = { 1, 0, 0 };
+
+    FusedGain fused ({ { 1, 0 }, { 0, 1 } }, { { 1 }, { 2 } }, { 1, 2 });
+    BOOST_REQUIRE (fused.isChunked());
+
+    const float start[] = { 1.f, 1.f }, end[] = { 1.f, 1.f };
+    fused.process (buffers, silence, start, end, n);
+    for (int i = 0; i < n; ++i)
+    {
+        BOOST_REQUIRE_EQUAL (left[(size_t) i], 3.f);
+        BOOST_REQUIRE_EQUAL (right[(size_t) i], 1.f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (RampSpansChunks)
+{
+    const int n = FusedGain::chunkSize * 2;
+    std::vector<float> zero ((size_t) n), a ((size_t) n, 1.f), b ((size_t) n, 0.f);
+    float* buffers[] = { zero.data(), a.data(), b.data() };
+    juce::uint8 silence[] = { 1, 0, 1 };
+
+    // b reads a and a reads b, so it's chunked.
+    FusedGain fused ({ { 1, 0 }, { 0, 1 } }, { { 1 }, { 2 } }, { 1, 2 });
+    const float start[] = { 1.f, 0.f }, end[] = { 1.f, 1.f };
+    fused.process (buffers, silence, start, end, n);
+    for (int i = 0; i < n; ++i)
+        BOOST_REQUIRE_CLOSE (b[(size_t) i] + 1.f, 1.f + (float) i / (float) n, 0.001f);
+    BOOST_REQUIRE_EQUAL (silence[1], 1);
+    BOOST_REQUIRE_EQUAL (silence[2], 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+/*  Measures how long a graph takes to rebuild its rendering sequence.
+    Disabled unless asked for, run it with `meson test --benchmark` or:
+
+        EL_BENCH_NODES=100,1000 test_element -t GraphBuildBench/Run
+
+    EL_BENCH_NODES    Node counts to run, 10,100,500,1000,2500,5000
+    EL_BENCH_CSV      File to write results to, as well as stdout
+
+    Each line of results is CSV: topology, nodes, connections, then the
+    best of three GraphNode::rebuild() and GraphBuilder runs in
+    microseconds. The topologies are described in fixture/SyntheticGraph.h.
+ */
+
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture/PreparedGraph.h"
+#include "fixture/SyntheticGraph.h"
+
+using namespace element;
+
+namespace {
+
+String getSetting (const char* name, const String& fallback)
+{
+    const auto value = SystemStats::getEnvironmentVariable (name, {});
+    return value.isNotEmpty() ? value : fallback;
+}
+
+void runBench (const String& topology, int numNodes, OutputStream* csv)
+{
+    PreparedGraph fix;
+    GraphNode& graph = fix.graph;
+    BOOST_REQUIRE (SyntheticGraph::build (graph, topology, numNodes));
+
+    const auto rebuild = SyntheticGraph::timeRebuild (graph);
+    const auto builder = SyntheticGraph::timeBuilder (graph);
+
+    String line;
+    line << topology << "," << graph.getNumNodes() << "," << graph.getNumConnections() << ","
+         << (rebuild * 1.0e6) << "," << (builder * 1.0e6);
+
+    std::cout << line << std::endl;
+    if (csv != nullptr)
+        csv->writeText (line + "\n", false, false, nullptr);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (GraphBuildBench)
+
+BOOST_AUTO_TEST_CASE (Run, *boost::unit_test::disabled())
+{
+    std::unique_ptr<FileOutputStream> csv;
+    const auto csvPath = getSetting ("EL_BENCH_CSV", {});
+    if (csvPath.isNotEmpty())
+    {
+        const File file (File::getCurrentWorkingDirectory().getChildFile (csvPath));
+        file.deleteFile();
+        csv = file.createOutputStream();
+        BOOST_REQUIRE_MESSAGE (csv != nullptr, file.getFullPathName().toStdString());
+    }
+
+    const String header ("topology,nodes,connections,rebuild_us,builder_us");
+    std::cout << header << std::endl;
+    if (csv != nullptr)
+        csv->writeText (header + "\n", false, false, nullptr);
+
+    for (const auto& topology : SyntheticGraph::getTopologies())
+        for (const auto& token : StringArray::fromTokens (getSetting ("EL_BENCH_NODES", "10,100,500,1000,2500,5000"), ",", {}))
+            if (const int numNodes = token.trim().getIntValue(); numNodes > 0)
+                runBench (topology, numNodes, csv.get());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,57 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture/PreparedGraph.h"
+#include "fixture/SyntheticGraph.h"
+
+using namespace element;
+
+namespace {
+constexpr int smallGraph = 250, largeGraph = 4000;
+
+// 16 times the nodes should cost about 16 times as much to build. A
+// quadratic pass would make it 256, this leaves room for noise and caches.
+constexpr double maxGrowth = 64.0;
+
+// below this, timer resolution and noise dominate the small graph.
+constexpr double minSeconds = 50.0e-6;
+
+void checkScaling (const String& topology)
+{
+    PreparedGraph small, large;
+    BOOST_REQUIRE (SyntheticGraph::build (small.graph, topology, smallGraph));
+    BOOST_REQUIRE (SyntheticGraph::build (large.graph, topology, largeGraph));
+
+    const auto smallRebuild = jmax (minSeconds, SyntheticGraph::timeRebuild (small.graph));
+    const auto largeRebuild = SyntheticGraph::timeRebuild (large.graph);
+    BOOST_CHECK_MESSAGE (largeRebuild < smallRebuild * maxGrowth,
+                         topology << " rebuild: " << smallRebuild << "s to " << largeRebuild << "s");
+
+    const auto smallBuilder = jmax (minSeconds, SyntheticGraph::timeBuilder (small.graph));
+    const auto largeBuilder = SyntheticGraph::timeBuilder (large.graph);
+    BOOST_CHECK_MESSAGE (largeBuilder < smallBuilder * maxGrowth,
+                         topology << " builder: " << smallBuilder << "s to " << largeBuilder << "s");
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (GraphBuildTest)
+
+BOOST_AUTO_TEST_CASE (Topologies)
+{
+    for (const auto& topology : SyntheticGraph::getTopologies())
+    {
+        PreparedGraph fix;
+        BOOST_REQUIRE (SyntheticGraph::build (fix.graph, topology, 40));
+        fix.graph.rebuild();
+        BOOST_REQUIRE (fix.graph.getNumNodes() > 2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (ChainScales) { checkScaling ("chain"); }
+BOOST_AUTO_TEST_CASE (FanoutScales) { checkScaling ("fanout"); }
+BOOST_AUTO_TEST_CASE (RandomScales) { checkScaling ("random"); }
+BOOST_AUTO_TEST_CASE (LayeredScales) { checkScaling ("layered"); }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+/*  Measures what GraphNode::render costs per block on synthetic graphs.
+    Disabled unless asked for, run it with `meson test --benchmark` or:
+
+        EL_BENCH_NODES=16,64 EL_BENCH_BLOCKS=64,256 test_element -t GraphRenderBench/Run
+
+    EL_BENCH_RATE     Sample rate, 48000
+    EL_BENCH_BLOCKS   Block sizes to run, 64,256,1024
+    EL_BENCH_NODES    Node counts to run, 8,32,128
+    EL_BENCH_SECONDS  Audio to render for each run, 2
+    EL_BENCH_CSV      File to write results to, as well as stdout
+
+    Each line of results is CSV: topology, nodes, rate, block, blocks,
+    deadline, p50, p90, p99, max, in microseconds. The topologies are
+    described in fixture/SyntheticGraph.h.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture/PreparedGraph.h"
+#include "fixture/SyntheticGraph.h"
+
+using namespace element;
+
+namespace {
+
+String getSetting (const char* name, const String& fallback)
+{
+    const auto value = SystemStats::getEnvironmentVariable (name, {});
+    return value.isNotEmpty() ? value : fallback;
+}
+
+Array<int> getSizes (const char* name, const String& fallback)
+{
+    Array<int> sizes;
+    for (const auto& token : StringArray::fromTokens (getSetting (name, fallback), ",", {}))
+        if (const int size = token.trim().getIntValue(); size > 0)
+            sizes.add (size);
+    return sizes;
+}
+
+/** Value below which fraction of the sorted samples fall, in microseconds. */
+double percentile (const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    const auto index = jlimit (0, (int) sorted.size() - 1, (int) std::ceil (fraction * sorted.size()) - 1);
+    return sorted[(size_t) index] * 1.0e6;
+}
+
+void runBench (const String& topology, int numNodes, double rate, int blockSize, double seconds, OutputStream* csv)
+{
+    PreparedGraph fix (rate, blockSize);
+    GraphNode& graph = fix.graph;
+
+    BOOST_REQUIRE (SyntheticGraph::build (graph, topology, numNodes));
+    graph.rebuild();
+
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer input (2, blockSize), audio (2, blockSize), cv;
+    Random random (1234);
+    for (int c = 0; c < 2; ++c)
+        for (int f = 0; f < blockSize; ++f)
+            input.setSample (c, f, random.nextFloat() * 2.f - 1.f);
+
+    const int numBlocks = jmax (1, roundToInt (seconds * rate / blockSize));
+    std::vector<double> blockTimes;
+    blockTimes.reserve ((size_t) numBlocks);
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        audio.makeCopyOf (input, true);
+        midi.clear();
+        RenderContext rc (audio, cv, midi, atoms, blockSize);
+        const auto t0 = Time::getHighResolutionTicks();
+        graph.render (rc);
+        const auto t1 = Time::getHighResolutionTicks();
+        blockTimes.push_back (Time::highResolutionTicksToSeconds (t1 - t0));
+    }
+
+    std::sort (blockTimes.begin(), blockTimes.end());
+    String line;
+    line << topology << "," << numNodes << "," << rate << "," << blockSize << "," << numBlocks << ","
+         << (1.0e6 * blockSize / rate) << ","
+         << percentile (blockTimes, 0.5) << "," << percentile (blockTimes, 0.9) << ","
+         << percentile (blockTimes, 0.99) << "," << percentile (blockTimes, 1.0);
+
+    std::cout << line << std::endl;
+    if (csv != nullptr)
+        csv->writeText (line + "\n", false, false, nullptr);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (GraphRenderBench)
+
+BOOST_AUTO_TEST_CASE (Run, *boost::unit_test::disabled())
+{
+    const auto rate = getSetting ("EL_BENCH_RATE", "48000").getDoubleValue();
+    const auto seconds = getSetting ("EL_BENCH_SECONDS", "2").getDoubleValue();
+    BOOST_REQUIRE (rate > 0.0 && seconds > 0.0);
+
+    std::unique_ptr<FileOutputStream> csv;
+    const auto csvPath = getSetting ("EL_BENCH_CSV", {});
+    if (csvPath.isNotEmpty())
+    {
+        const File file (File::getCurrentWorkingDirectory().getChildFile (csvPath));
+        file.deleteFile();
+        csv = file.createOutputStream();
+        BOOST_REQUIRE_MESSAGE (csv != nullptr, file.getFullPathName().toStdString());
+    }
+
+    const String header ("topology,nodes,rate,block,blocks,deadline_us,p50_us,p90_us,p99_us,max_us");
+    std::cout << header << std::endl;
+    if (csv != nullptr)
+        csv->writeText (header + "\n", false, false, nullptr);
+
+    for (const auto& topology : SyntheticGraph::getTopologies())
+        for (const int numNodes : getSizes ("EL_BENCH_NODES", "8,32,128"))
+            for (const int blockSize : getSizes ("EL_BENCH_BLOCKS", "64,256,1024"))
+                runBench (topology, numNodes, rate, blockSize, seconds, csv.get());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
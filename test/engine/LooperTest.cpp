@@ -0,0 +1,112 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include "engine/looper.hpp"
+
+using namespace element;
+
+namespace {
+/** A mono looper holding one second at 1 kHz. */
+struct MonoLooper
+{
+    MonoLooper()
+    {
+        Looper::setMaxSeconds (1.0);
+        looper.prepare (1, 1000.0);
+        Looper::setMaxSeconds (30.0);
+    }
+
+    /** Process a block of `value`, returns the block. */
+    const float* process (float value, int numSamples, Looper::Action action = Looper::none, int frame = 0)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            block[i] = value;
+        float* io[] = { block };
+        looper.process (io, 1, numSamples, action, frame);
+        return block;
+    }
+
+    Looper looper;
+    float block[1024];
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (LooperTest)
+
+BOOST_AUTO_TEST_CASE (RecordAndPlay)
+{
+    MonoLooper m;
+    auto& looper = m.looper;
+    BOOST_REQUIRE_EQUAL (looper.getCapacity(), 1000);
+
+    // recording starts and stops on the frames asked for.
+    m.process (1.f, 100, Looper::record, 50);
+    BOOST_REQUIRE_EQUAL (looper.getState(), Looper::recording);
+    BOOST_REQUIRE_EQUAL (looper.getLength(), (juce::int64) 50);
+
+    auto* out = m.process (1.f, 100, Looper::record, 30);
+    BOOST_REQUIRE_EQUAL (looper.getState(), Looper::playing);
+    BOOST_REQUIRE_EQUAL (looper.getLength(), (juce::int64) 80);
+    BOOST_REQUIRE_EQUAL (looper.getPosition(), (juce::int64) 70);
+    BOOST_REQUIRE_EQUAL (out[29], 1.f);
+    BOOST_REQUIRE_EQUAL (out[30], 2.f); // input plus the loop
+
+    m.process (0.f, 10, Looper::stop);
+    BOOST_REQUIRE_EQUAL (looper.getState(), Looper::stopped);
+    out = m.process (0.f, 10, Looper::play, 5);
+    BOOST_REQUIRE_EQUAL (out[4], 0.f);
+    BOOST_REQUIRE_EQUAL (out[5], 1.f);
+
+    // out of memory, the loop closes and plays.
+    m.process (0.f, 10, Looper::record);
+    for (int i = 0; i < 12; ++i)
+        m.process (0.f, 100);
+    BOOST_REQUIRE_EQUAL (looper.getState(), Looper::playing);
+    BOOST_REQUIRE_EQUAL (looper.getLength(), (juce::int64) 1000);
+}
+
+BOOST_AUTO_TEST_CASE (OverdubAndUndo)
+{
+    MonoLooper m;
+    auto& looper = m.looper;
+    m.process (1.f, 80, Looper::record);
+    m.process (0.f, 80, Looper::record);
+    BOOST_REQUIRE_EQUAL (looper.getLength(), (juce::int64) 80);
+
+    m.process (0.5f, 80, Looper::overdub);
+    BOOST_REQUIRE_EQUAL (looper.getState(), Looper::overdubbing);
+    BOOST_REQUIRE_EQUAL (looper.getNumLayers(), 2);
+
+    auto* out = m.process (0.f, 80, Looper::overdub);
+    BOOST_REQUIRE_EQUAL (looper.getState(), Looper::playing);
+    BOOST_REQUIRE_CLOSE (out[10], 1.5f, 0.001f);
+
+    // undo drops the pass, its layer is zeroed off the audio thread.
+    out = m.process (0.f, 80, Looper::undo);
+    BOOST_REQUIRE_EQUAL (looper.getNumLayers(), 1);
+    BOOST_REQUIRE_EQUAL (out[10], 1.f);
+    BOOST_REQUIRE (looper.needsCleaning());
+    looper.clean();
+    BOOST_REQUIRE (! looper.needsCleaning());
+
+    // the cleaned layer is used again.
+    m.process (0.25f, 80, Looper::overdub);
+    BOOST_REQUIRE_EQUAL (looper.getNumLayers(), 2);
+    out = m.process (0.f, 80, Looper::overdub);
+    BOOST_REQUIRE_CLOSE (out[10], 1.25f, 0.001f);
+
+    m.process (0.f, 10, Looper::clear);
+    BOOST_REQUIRE_EQUAL (looper.getState(), Looper::empty);
+    BOOST_REQUIRE_EQUAL (looper.getLength(), (juce::int64) 0);
+}
+
+BOOST_AUTO_TEST_CASE (Quantize)
+{
+    BOOST_REQUIRE_EQUAL (Looper::framesToBoundary (3.0, 4.0, 100.0), (juce::int64) 100);
+    BOOST_REQUIRE_EQUAL (Looper::framesToBoundary (4.0, 4.0, 100.0), (juce::int64) 0);
+    BOOST_REQUIRE_EQUAL (Looper::framesToBoundary (3.9999999, 4.0, 100.0), (juce::int64) 0);
+    BOOST_REQUIRE_EQUAL (Looper::framesToBoundary (0.25, 1.0, 22050.0), (juce::int64) 16538);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/mcusurface.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (McuSurfaceTest)
+
+static int countBytes (const juce::MidiBuffer& buffer)
+{
+    int total = 0;
+    for (const auto m : buffer)
+        total += m.numBytes;
+    return total;
+}
+
+BOOST_AUTO_TEST_CASE (SendsOnlyChanges)
+{
+    McuSurface surface;
+    surface.prepare (1000.0, 10.0, 100000);
+
+    // the first tick brings the whole surface up to date.
+    juce::MidiBuffer out;
+    surface.process (out, 100);
+    BOOST_REQUIRE_EQUAL (out.getNumEvents(), McuSurface::numFaders + McuSurface::numLeds + 1);
+
+    // between ticks nothing goes out, and many moves make one message.
+    out.clear();
+    for (int v = 0; v < 100; v += 10)
+    {
+        surface.setFader (2, v);
+        surface.process (out, 10);
+    }
+    BOOST_REQUIRE_EQUAL (out.getNumEvents(), 1);
+    for (const auto m : out)
+    {
+        BOOST_REQUIRE_EQUAL (m.data[0], 0xe2);
+        BOOST_REQUIRE_EQUAL (m.data[1] | (m.data[2] << 7), 90);
+    }
+
+    // a touched fader isn't driven.
+    out.clear();
+    const juce::uint8 touch[] = { 0x90, 0x68 + 2, 127 };
+    juce::MidiBuffer input;
+    input.addEvent (touch, 3, 0);
+    surface.handleInput (input);
+    surface.setFader (2, 0);
+    surface.process (out, 100);
+    BOOST_REQUIRE_EQUAL (out.getNumEvents(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (TextRuns)
+{
+    McuSurface surface;
+    surface.prepare (1000.0, 10.0, 100000);
+    juce::MidiBuffer out;
+    surface.process (out, 100);
+
+    // changes close together share a message.
+    out.clear();
+    surface.setText (10, "ab");
+    surface.setText (14, "cd");
+    surface.setText (80, "x");
+    surface.process (out, 100);
+    BOOST_REQUIRE_EQUAL (out.getNumEvents(), 2);
+    BOOST_REQUIRE_EQUAL (countBytes (out), 8 + 6 + 8 + 1);
+}
+
+BOOST_AUTO_TEST_CASE (KeepsToBandwidth)
+{
+    McuSurface surface;
+    surface.prepare (1000.0, 10.0, 1000);
+
+    // 100 bytes a tick plus what went unused, the rest waits.
+    int total = 0;
+    for (int tick = 1; tick <= 20; ++tick)
+    {
+        juce::MidiBuffer out;
+        surface.process (out, 100);
+        total += countBytes (out);
+        BOOST_REQUIRE_LE (total, 200 + 100 * tick);
+    }
+
+    // all sent by now, the display split where a tick ran out.
+    juce::MidiBuffer out;
+    surface.process (out, 100);
+    BOOST_REQUIRE_EQUAL (out.getNumEvents(), 0);
+    BOOST_REQUIRE_GE (total, McuSurface::numFaders * 3 + McuSurface::numLeds * 3 + 8 + McuSurface::numChars);
+    BOOST_REQUIRE_EQUAL (surface.getNumBytesSent(), (juce::int64) total);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
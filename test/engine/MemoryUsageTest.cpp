@@ -0,0 +1,56 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture/PreparedGraph.h"
+#include "fixture/SyntheticGraph.h"
+#include "session/memoryreport.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (MemoryUsageTest)
+
+BOOST_AUTO_TEST_CASE (DelayLines)
+{
+    PreparedGraph plain, delayed;
+    BOOST_REQUIRE (SyntheticGraph::build (plain.graph, "fanout", 4));
+    BOOST_REQUIRE (SyntheticGraph::build (delayed.graph, "latency", 4));
+    plain.graph.rebuild();
+    delayed.graph.rebuild();
+
+    BOOST_REQUIRE_EQUAL (plain.graph.getScratchInfo().opBytes, (size_t) 0);
+    const auto info = delayed.graph.getScratchInfo();
+    BOOST_REQUIRE (info.opBytes > 0);
+
+    // test nodes don't oversample or allocate, the graph holds everything.
+    BOOST_REQUIRE_EQUAL (delayed.graph.getMemoryUsage(), (int64) info.getTotalBytes());
+}
+
+BOOST_AUTO_TEST_CASE (Report)
+{
+    PreparedGraph pg;
+    BOOST_REQUIRE (SyntheticGraph::build (pg.graph, "nested", 3));
+    pg.graph.rebuild();
+
+    MemoryReport report;
+    report.addGraph (pg.graph, "Main");
+    const auto& items = report.getItems();
+    BOOST_REQUIRE (items.size() > pg.graph.getNumNodes());
+    BOOST_REQUIRE (items.getFirst().graph);
+    BOOST_REQUIRE_EQUAL (items.getFirst().bytes, pg.graph.getMemoryUsage());
+    BOOST_REQUIRE_EQUAL (report.getGraphBytes(), pg.graph.getMemoryUsage());
+
+    // nested graphs are indented under their parent.
+    int maxDepth = 0;
+    for (const auto& item : items)
+        maxDepth = jmax (maxDepth, item.depth);
+    BOOST_REQUIRE (maxDepth >= 2);
+
+    report.setSharedBytes (100);
+    BOOST_REQUIRE_EQUAL (report.getTotalBytes(), pg.graph.getMemoryUsage() + 100);
+    BOOST_REQUIRE (report.toText().startsWith ("Total: "));
+    BOOST_REQUIRE_EQUAL ((int) report.toJSON()["items"].size(), items.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/midicapture.hpp"
+
+using namespace element;
+
+namespace {
+
+bool pushMessage (MidiCapture& capture, const MidiMessage& msg, double time = 0.0)
+{
+    return capture.push (msg.getRawData(), msg.getRawDataSize(), time);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (MidiCaptureTest)
+
+BOOST_AUTO_TEST_CASE (PushPop)
+{
+    MidiCapture capture;
+    BOOST_REQUIRE (pushMessage (capture, MidiMessage::noteOn (1, 60, (uint8) 100), 0.5));
+    BOOST_REQUIRE (pushMessage (capture, MidiMessage::controllerEvent (2, 7, 64), 1.0));
+    BOOST_REQUIRE_EQUAL (capture.getNumReady(), 2);
+
+    MidiCapture::Event events[4];
+    BOOST_REQUIRE_EQUAL (capture.pop (events, 4), 2);
+    BOOST_REQUIRE_EQUAL (capture.getNumReady(), 0);
+
+    const auto first = events[0].toMessage();
+    BOOST_REQUIRE (first.isNoteOn());
+    BOOST_REQUIRE_EQUAL (first.getNoteNumber(), 60);
+    BOOST_REQUIRE_EQUAL (events[0].time, 0.5);
+
+    const auto second = events[1].toMessage();
+    BOOST_REQUIRE (second.isController());
+    BOOST_REQUIRE_EQUAL (second.getControllerValue(), 64);
+    BOOST_REQUIRE_EQUAL (capture.getNumCaptured(), 2);
+}
+
+BOOST_AUTO_TEST_CASE (Filter)
+{
+    MidiCapture capture;
+    BOOST_REQUIRE (! pushMessage (capture, MidiMessage::midiClock()));
+    BOOST_REQUIRE (pushMessage (capture, MidiMessage::midiStart()));
+
+    capture.setFilter (MidiCapture::notes);
+    BOOST_REQUIRE (! pushMessage (capture, MidiMessage::pitchWheel (1, 100)));
+    BOOST_REQUIRE (pushMessage (capture, MidiMessage::noteOff (1, 60)));
+    BOOST_REQUIRE_EQUAL (capture.getNumReady(), 2);
+    BOOST_REQUIRE_EQUAL (capture.getNumDropped(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (DropsWhenFull)
+{
+    MidiCapture capture;
+    const auto msg = MidiMessage::noteOn (1, 60, (uint8) 100);
+    int pushed = 0;
+    for (int i = 0; i < MidiCapture::capacity + 10; ++i)
+        pushed += pushMessage (capture, msg) ? 1 : 0;
+
+    BOOST_REQUIRE_EQUAL (pushed, capture.getNumReady());
+    BOOST_REQUIRE_EQUAL (capture.getNumDropped(), MidiCapture::capacity + 10 - pushed);
+    BOOST_REQUIRE_GT (capture.getNumDropped(), 0);
+
+    capture.discard();
+    capture.resetCounters();
+    BOOST_REQUIRE_EQUAL (capture.getNumReady(), 0);
+    BOOST_REQUIRE_EQUAL (capture.getNumDropped(), 0);
+    BOOST_REQUIRE (pushMessage (capture, msg));
+}
+
+BOOST_AUTO_TEST_CASE (SysexKeepsSize)
+{
+    MidiCapture capture;
+    const uint8 data[] = { 0x7e, 0x7f, 0x06, 0x01 };
+    const auto msg = MidiMessage::createSysExMessage (data, (int) sizeof (data));
+    BOOST_REQUIRE (pushMessage (capture, msg));
+
+    MidiCapture::Event ev;
+    BOOST_REQUIRE_EQUAL (capture.pop (&ev, 1), 1);
+    BOOST_REQUIRE_EQUAL (ev.size, msg.getRawDataSize());
+    BOOST_REQUIRE_EQUAL ((int) ev.data[0], 0xf0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/midiclock.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (MidiClockTest)
+
+BOOST_AUTO_TEST_CASE (MasterDoesNotDrift)
+{
+    // 918.75 samples per tick, rounding it would drift a tick every ~4 bars.
+    MidiClockMaster master;
+    master.setSampleRate (44100.0);
+    master.setTempo (120.0);
+    master.reset();
+    BOOST_REQUIRE_CLOSE (master.getSamplesPerClock(), 918.75, 0.0001);
+
+    MidiBuffer midi;
+    FixedMidi::reserve (midi);
+    const int blockSize = 512;
+    int64 frame = 0, numTicks = 0, lastTick = 0;
+    for (int block = 0; block < 4000; ++block)
+    {
+        midi.clear();
+        master.render (midi, blockSize);
+        for (const auto m : midi)
+        {
+            BOOST_REQUIRE (m.getMessage().isMidiClock());
+            lastTick = frame + m.samplePosition;
+            ++numTicks;
+        }
+        frame += blockSize;
+    }
+
+    BOOST_REQUIRE_EQUAL (numTicks, (int64) std::ceil ((double) frame / 918.75));
+    BOOST_REQUIRE_EQUAL (lastTick, (int64) ((double) (numTicks - 1) * 918.75));
+}
+
+BOOST_AUTO_TEST_CASE (MasterSync)
+{
+    MidiClockMaster master;
+    master.setSampleRate (48000.0);
+    master.setTempo (120.0);
+    master.reset();
+    master.sync (500);
+
+    MidiBuffer midi;
+    master.render (midi, 1024);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+    BOOST_REQUIRE_EQUAL (midi.getFirstEventTime(), 500);
+}
+
+BOOST_AUTO_TEST_CASE (FollowerLocksAndMeasuresJitter)
+{
+    MidiClock clock;
+    clock.reset (48000.0, 512);
+
+    const double period = 60.0 / (128.0 * 24.0);
+    Random random (1234);
+    double time = 10.0;
+    for (int i = 0; i < 400; ++i)
+    {
+        auto msg = MidiMessage::midiClock();
+        msg.setTimeStamp (time + (random.nextDouble() - 0.5) * 0.001);
+        clock.process (msg);
+        time += period;
+    }
+
+    auto stats = clock.getStats();
+    BOOST_REQUIRE (stats.locked);
+    BOOST_REQUIRE_EQUAL (stats.numTicks, 400);
+    BOOST_REQUIRE_CLOSE (stats.bpm, 128.0, 0.5);
+    BOOST_REQUIRE (stats.jitterMs > 0.0 && stats.jitterMs < 1.0);
+    BOOST_REQUIRE (stats.maxJitterMs >= stats.jitterMs);
+    BOOST_REQUIRE_EQUAL (stats.dropouts, 0);
+
+    // a long gap drops the lock.
+    auto msg = MidiMessage::midiClock();
+    msg.setTimeStamp (time + 1.0);
+    clock.process (msg);
+    stats = clock.getStats();
+    BOOST_REQUIRE (! stats.locked);
+    BOOST_REQUIRE_EQUAL (stats.dropouts, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/midifilterstage.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+MidiMessage messageAt (const MidiBuffer& midi, int index)
+{
+    int i = 0;
+    for (const auto m : midi)
+        if (i++ == index)
+            return m.getMessage();
+    return {};
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (MidiFilterStageTest)
+
+BOOST_AUTO_TEST_CASE (Passthrough)
+{
+    MidiFilterStage stage;
+    BOOST_REQUIRE (stage.isPassthrough());
+
+    MidiBuffer midi;
+    midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 0);
+    BOOST_REQUIRE_EQUAL (stage.process (midi), -1);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+    BOOST_REQUIRE_EQUAL (messageAt (midi, 0).getNoteNumber(), 60);
+}
+
+BOOST_AUTO_TEST_CASE (ChannelsAndKeys)
+{
+    MidiFilterStage stage;
+    stage.setChannels (1u << 2);
+    stage.setKeyRange (48, 72);
+
+    MidiBuffer midi;
+    midi.addEvent (MidiMessage::noteOn (2, 60, (uint8) 100), 0);
+    midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 1);
+    midi.addEvent (MidiMessage::noteOn (2, 30, (uint8) 100), 2);
+    midi.addEvent (MidiMessage::controllerEvent (2, 7, 100), 3);
+    midi.addEvent (MidiMessage::noteOff (2, 72), 4);
+    stage.process (midi);
+
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 3);
+    BOOST_REQUIRE_EQUAL (messageAt (midi, 0).getNoteNumber(), 60);
+    BOOST_REQUIRE (messageAt (midi, 1).isController());
+    BOOST_REQUIRE (messageAt (midi, 2).isNoteOff());
+    BOOST_REQUIRE_EQUAL (midi.getLastEventTime(), 4);
+}
+
+BOOST_AUTO_TEST_CASE (TransposeAndPrograms)
+{
+    MidiFilterStage stage;
+    stage.setTranspose (-12);
+    stage.setConsumePrograms (true);
+
+    MidiBuffer midi;
+    midi.addEvent (MidiMessage::programChange (1, 4), 0);
+    midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 1);
+    midi.addEvent (MidiMessage::programChange (1, 9), 2);
+    BOOST_REQUIRE_EQUAL (stage.process (midi), 9);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+    BOOST_REQUIRE_EQUAL (messageAt (midi, 0).getNoteNumber(), 48);
+    BOOST_REQUIRE_EQUAL (messageAt (midi, 0).getVelocity(), 100);
+}
+
+BOOST_AUTO_TEST_CASE (ChannelMapAndVelocity)
+{
+    MidiFilterStage stage;
+    MidiChannelMap map;
+    map.set (1, 5);
+    stage.setChannelMap (map);
+
+    VelocityCurve curve;
+    curve.setMode (VelocityCurve::Hard_2);
+    stage.setVelocityCurve (curve);
+
+    MidiBuffer midi;
+    midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 64), 0);
+    midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 0), 1);
+    stage.process (midi);
+
+    const auto on = messageAt (midi, 0);
+    BOOST_REQUIRE_EQUAL (on.getChannel(), 5);
+    BOOST_REQUIRE_EQUAL ((int) on.getVelocity(), (int) MidiMessage::floatValueToMidiByte (curve.process (64.f / 127.f)));
+    BOOST_REQUIRE_EQUAL ((int) messageAt (midi, 1).getVelocity(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/midiinputqueue.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (MidiInputQueueTest)
+
+static MidiMessage noteAt (double time)
+{
+    auto msg = MidiMessage::noteOn (1, 60, (uint8) 100);
+    msg.setTimeStamp (time);
+    return msg;
+}
+
+BOOST_AUTO_TEST_CASE (SampleAccurate)
+{
+    MidiInputQueue queue;
+    MidiBuffer midi;
+    queue.reset (48000.0);
+
+    // 480 samples is 10ms, the first block only starts the clock.
+    queue.render (midi, 480, 1.0);
+    BOOST_REQUIRE (midi.isEmpty());
+
+    BOOST_REQUIRE (queue.push (noteAt (1.005)));
+    queue.render (midi, 480, 1.01);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+    BOOST_REQUIRE_EQUAL (midi.getFirstEventTime(), 240);
+}
+
+BOOST_AUTO_TEST_CASE (LateArrivalsWait)
+{
+    MidiInputQueue queue;
+    MidiBuffer midi;
+    queue.reset (48000.0);
+    queue.render (midi, 480, 1.0);
+
+    // stamped after the next block starts, so it's held for the one after.
+    BOOST_REQUIRE (queue.push (noteAt (1.0125)));
+    queue.render (midi, 480, 1.01);
+    BOOST_REQUIRE (midi.isEmpty());
+    BOOST_REQUIRE_EQUAL (queue.getNumReady(), 1);
+
+    queue.render (midi, 480, 1.02);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+    BOOST_REQUIRE_EQUAL (midi.getFirstEventTime(), 120);
+    BOOST_REQUIRE_EQUAL (queue.getNumReady(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (OnlyShortMessages)
+{
+    MidiInputQueue queue;
+    const uint8 sysex[] = { 0x01, 0x02, 0x03, 0x04 };
+    BOOST_REQUIRE (! queue.push (MidiMessage::createSysExMessage (sysex, 4)));
+    BOOST_REQUIRE (queue.push (MidiMessage::controllerEvent (1, 7, 100)));
+    BOOST_REQUIRE_EQUAL (queue.getNumReady(), 1);
+}
+
+BOOST_AUTO_TEST_CASE (Sysex)
+{
+    MidiInputQueue queue;
+    MidiBuffer midi;
+    queue.setSysexCapacity (64);
+    queue.reset (48000.0);
+    queue.render (midi, 480, 1.0);
+
+    uint8 sysex[40];
+    for (int i = 0; i < 40; ++i)
+        sysex[i] = (uint8) i;
+    auto big = MidiMessage::createSysExMessage (sysex, 40);
+    big.setTimeStamp (1.0025);
+    BOOST_REQUIRE (queue.push (noteAt (1.001)));
+    BOOST_REQUIRE (queue.push (big));
+    // no room for another until the first is rendered.
+    BOOST_REQUIRE (! queue.push (big));
+    BOOST_REQUIRE (queue.push (noteAt (1.005)));
+
+    queue.render (midi, 480, 1.01);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 3);
+    int index = 0;
+    for (const auto meta : midi)
+    {
+        const auto msg = meta.getMessage();
+        if (index == 1)
+        {
+            BOOST_REQUIRE (msg.isSysEx());
+            BOOST_REQUIRE_EQUAL (meta.samplePosition, 120);
+            BOOST_REQUIRE_EQUAL (msg.getSysExDataSize(), 40);
+            BOOST_REQUIRE_EQUAL (msg.getSysExData()[39], (uint8) 39);
+        }
+        else
+        {
+            BOOST_REQUIRE (msg.isNoteOn());
+        }
+        ++index;
+    }
+
+    // the ring wraps.
+    for (int i = 0; i < 3; ++i)
+    {
+        midi.clear();
+        big.setTimeStamp (1.0125 + i * 0.01);
+        BOOST_REQUIRE (queue.push (big));
+        queue.render (midi, 480, 1.02 + i * 0.01);
+        BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+        BOOST_REQUIRE_EQUAL ((*midi.begin()).getMessage().getSysExData()[20], (uint8) 20);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,32 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/midipanic.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (MidiPanicTest)
+
+BOOST_AUTO_TEST_CASE (ContainsCC)
+{
+    MidiBuffer midi;
+    BOOST_REQUIRE (! MidiPanic::containsCC (midi, 64, 0));
+
+    midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 0);
+    midi.addEvent (MidiMessage::controllerEvent (3, 64, 127), 10);
+    BOOST_REQUIRE (MidiPanic::containsCC (midi, 64, 0));
+    BOOST_REQUIRE (MidiPanic::containsCC (midi, 64, 3));
+    BOOST_REQUIRE (! MidiPanic::containsCC (midi, 64, 2));
+    BOOST_REQUIRE (! MidiPanic::containsCC (midi, 65, 0));
+    BOOST_REQUIRE (! MidiPanic::containsCC (midi, -1, 0));
+}
+
+BOOST_AUTO_TEST_CASE (ProcessAgrees)
+{
+    MidiBuffer midi, out;
+    midi.addEvent (MidiMessage::controllerEvent (1, 7, 100), 0);
+    BOOST_REQUIRE_EQUAL (MidiPanic::containsCC (midi, 7, 0), MidiPanic::processCC (midi, out, 7, 0));
+    out.clear();
+    BOOST_REQUIRE_EQUAL (MidiPanic::containsCC (midi, 8, 0), MidiPanic::processCC (midi, out, 8, 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
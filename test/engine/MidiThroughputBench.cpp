@@ -0,0 +1,335 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+/*  Measures MIDI throughput and cost on the audio thread. Disabled unless
+    asked for, run it with `meson test --benchmark` or:
+
+        EL_BENCH_EVENTS=64,512 EL_BENCH_MAPS=256 test_element -t MidiThroughputBench/Run
+
+    Three stages run at each load:
+
+        mapping   MidiEngine::processMidiBuffer into a MappingEngine with
+                  controller maps on every CC, as the engine does with
+                  device MIDI each block
+        graph     a graph with a chain of MIDI nodes between its MIDI input
+                  and output
+        loopback  input to output latency through the MIDI output thread
+                  and back in, with EL_BENCH_LOOPBACK set
+
+    EL_BENCH_RATE      Sample rate, 48000
+    EL_BENCH_BLOCK     Block size, 256
+    EL_BENCH_EVENTS    Events per block to run, 16,128,1024
+    EL_BENCH_MAPS      Mapped controls to run, 16,128
+    EL_BENCH_NODES     MIDI nodes in the graph chain, 8,64
+    EL_BENCH_SECONDS   Audio to process for each run, 2
+    EL_BENCH_LOOPBACK  Part of the name of a device whose output is wired
+                       to its input, e.g. "Midi Through". Skipped if unset.
+    EL_BENCH_CSV       File to write results to, as well as stdout
+
+    Each line of results is CSV: stage, events per block, size (maps or
+    nodes), events per second, block p50 and p99 in microseconds, and the
+    mean cost of one event in nanoseconds. Loopback lines give messages
+    sent and the p50, p99 and max latency in microseconds instead.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <element/atombuffer.hpp>
+#include <element/controller.hpp>
+#include <element/node.hpp>
+
+#include "engine/ionode.hpp"
+#include "engine/mappingengine.hpp"
+#include "engine/midiengine.hpp"
+#include "fixture/PreparedGraph.h"
+#include "fixture/TestNode.h"
+
+using namespace element;
+
+namespace {
+
+String getSetting (const char* name, const String& fallback)
+{
+    const auto value = SystemStats::getEnvironmentVariable (name, {});
+    return value.isNotEmpty() ? value : fallback;
+}
+
+Array<int> getSizes (const char* name, const String& fallback)
+{
+    Array<int> sizes;
+    for (const auto& token : StringArray::fromTokens (getSetting (name, fallback), ",", {}))
+        if (const int size = token.trim().getIntValue(); size > 0)
+            sizes.add (size);
+    return sizes;
+}
+
+/** Value below which fraction of the sorted samples fall, in microseconds. */
+double percentile (const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    const auto index = jlimit (0, (int) sorted.size() - 1, (int) std::ceil (fraction * sorted.size()) - 1);
+    return sorted[(size_t) index] * 1.0e6;
+}
+
+struct Load
+{
+    double rate = 48000.0;
+    int blockSize = 256;
+    int numBlocks = 0;
+    int eventsPerBlock = 0;
+};
+
+/** Spreads CCs, notes and pitch bend over a block, the way a busy
+    controller and keyboard would.
+ */
+void fillBlock (MidiBuffer& midi, const Load& load, Random& random)
+{
+    midi.clear();
+    for (int i = 0; i < load.eventsPerBlock; ++i)
+    {
+        const int frame = (int) ((int64) i * load.blockSize / load.eventsPerBlock);
+        const int channel = 1 + random.nextInt (16);
+        switch (random.nextInt (4))
+        {
+            case 0:
+                midi.addEvent (MidiMessage::noteOn (channel, random.nextInt (128), (uint8) (1 + random.nextInt (127))), frame);
+                break;
+            case 1:
+                midi.addEvent (MidiMessage::pitchWheel (channel, random.nextInt (16384)), frame);
+                break;
+            default:
+                midi.addEvent (MidiMessage::controllerEvent (channel, random.nextInt (120), random.nextInt (128)), frame);
+                break;
+        }
+    }
+}
+
+void writeLine (const String& line, OutputStream* csv)
+{
+    std::cout << line << std::endl;
+    if (csv != nullptr)
+        csv->writeText (line + "\n", false, false, nullptr);
+}
+
+void report (const String& stage, const Load& load, int size, std::vector<double>& blockTimes, OutputStream* csv)
+{
+    std::sort (blockTimes.begin(), blockTimes.end());
+    double total = 0.0;
+    for (const auto t : blockTimes)
+        total += t;
+
+    const auto numEvents = (double) load.eventsPerBlock * load.numBlocks;
+    String line;
+    line << stage << "," << load.eventsPerBlock << "," << size << ","
+         << roundToInt (total > 0.0 ? numEvents / total : 0.0) << ","
+         << percentile (blockTimes, 0.5) << "," << percentile (blockTimes, 0.99) << ","
+         << (numEvents > 0.0 ? total * 1.0e9 / numEvents : 0.0);
+    writeLine (line, csv);
+}
+
+template <class Callback>
+std::vector<double> timeBlocks (const Load& load, Callback&& process)
+{
+    MidiBuffer midi;
+    midi.ensureSize ((size_t) load.eventsPerBlock * 4);
+    Random random (1234);
+    std::vector<double> blockTimes;
+    blockTimes.reserve ((size_t) load.numBlocks);
+
+    for (int i = 0; i < load.numBlocks; ++i)
+    {
+        fillBlock (midi, load, random);
+        const auto t0 = Time::getHighResolutionTicks();
+        process (midi);
+        const auto t1 = Time::getHighResolutionTicks();
+        blockTimes.push_back (Time::highResolutionTicksToSeconds (t1 - t0));
+    }
+    return blockTimes;
+}
+
+void runMapping (const Load& load, int numMaps, OutputStream* csv)
+{
+    MidiEngine midi;
+    MappingEngine mapping;
+
+    // every control toggles the node, so handlers do their full work.
+    Controller controller ("Bench");
+    for (int i = 0; i < numMaps; ++i)
+    {
+        Control control ("CC " + String (i % 120));
+        control.setProperty ("eventType", "controller");
+        control.setProperty ("eventId", i % 120);
+        controller.data().appendChild (control.data(), nullptr);
+    }
+
+    ProcessorPtr object (new TestNode (0, 0, 1, 1));
+    Node node (types::Node);
+    node.setProperty (tags::object, object.get());
+
+    BOOST_REQUIRE (mapping.addInput (controller, midi));
+    for (int i = 0; i < controller.getNumControls(); ++i)
+        BOOST_REQUIRE (mapping.addHandler (controller.getControl (i), node, Processor::EnabledParameter));
+    mapping.startMapping();
+
+    auto times = timeBlocks (load, [&] (MidiBuffer& block) {
+        midi.processMidiBuffer (block, load.blockSize, load.rate);
+    });
+    report ("mapping", load, numMaps, times, csv);
+
+    mapping.stopMapping();
+    mapping.clear();
+    node.data().removeProperty (tags::object, nullptr);
+}
+
+void runGraph (const Load& load, int numNodes, OutputStream* csv)
+{
+    PreparedGraph fix (load.rate, load.blockSize);
+    GraphNode& graph = fix.graph;
+
+    ProcessorPtr last = graph.addNode (new IONode (IONode::midiInputNode));
+    for (int i = 0; i < numNodes; ++i)
+    {
+        ProcessorPtr node = graph.addNode (new TestNode (0, 0, 1, 1));
+        BOOST_REQUIRE (graph.connectChannels (PortType::Midi, last->nodeId, 0, node->nodeId, 0));
+        last = node;
+    }
+    ProcessorPtr output = graph.addNode (new IONode (IONode::midiOutputNode));
+    BOOST_REQUIRE (graph.connectChannels (PortType::Midi, last->nodeId, 0, output->nodeId, 0));
+    graph.rebuild();
+
+    AudioSampleBuffer audio (2, load.blockSize), cv;
+    AtomBuffer atoms;
+    auto times = timeBlocks (load, [&] (MidiBuffer& block) {
+        audio.clear();
+        RenderContext rc (audio, cv, block, atoms, load.blockSize);
+        graph.render (rc);
+    });
+    report ("graph", load, numNodes, times, csv);
+}
+
+/** Sends notes out through MidiEngine and times them coming back in. */
+class Loopback final : public MidiInputCallback
+{
+public:
+    void handleIncomingMidiMessage (MidiInput*, const MidiMessage& message) override
+    {
+        if (! message.isNoteOn())
+            return;
+        const auto index = (message.getNoteNumber() << 7) | message.getVelocity();
+        if (isPositiveAndBelow (index, (int) sentAt.size()) && sentAt[(size_t) index] > 0.0)
+            latencies[(size_t) index] = Time::getMillisecondCounterHiRes() - sentAt[(size_t) index];
+        ++received;
+    }
+
+    void run (const String& name, int numMessages, double rate, OutputStream* csv)
+    {
+        MidiDeviceInfo in, out;
+        for (const auto& device : MidiInput::getAvailableDevices())
+            if (device.name.containsIgnoreCase (name))
+                in = device;
+        for (const auto& device : MidiOutput::getAvailableDevices())
+            if (device.name.containsIgnoreCase (name))
+                out = device;
+        if (in.identifier.isEmpty() || out.identifier.isEmpty())
+        {
+            BOOST_TEST_MESSAGE ("no MIDI loopback device matching " << name);
+            return;
+        }
+
+        numMessages = jlimit (1, 128 * 127, numMessages);
+        sentAt.assign ((size_t) (128 << 7), 0.0);
+        latencies.assign (sentAt.size(), -1.0);
+
+        MidiEngine midi;
+        midi.setMidiInputEnabled (in, true);
+        midi.addMidiInputCallback (in, this, true);
+        midi.setDefaultMidiOutput (out);
+        BOOST_REQUIRE (midi.getDefaultMidiOutput() != nullptr);
+
+        // one message per millisecond, well under what a cable carries.
+        for (int i = 0; i < numMessages; ++i)
+        {
+            const int note = i / 127, velocity = 1 + i % 127;
+            MidiBuffer block;
+            block.addEvent (MidiMessage::noteOn (1, note, (uint8) velocity), 0);
+            const auto now = Time::getMillisecondCounterHiRes();
+            sentAt[(size_t) ((note << 7) | velocity)] = now;
+            midi.sendBlockOfMessages (block, now, rate);
+            Thread::sleep (1);
+        }
+
+        const auto deadline = Time::getMillisecondCounter() + 2000;
+        while (received.load() < numMessages && Time::getMillisecondCounter() < deadline)
+            Thread::sleep (5);
+
+        midi.removeMidiInputCallback (this);
+        midi.setMidiInputEnabled (in, false);
+        midi.setDefaultMidiOutput ({});
+
+        std::vector<double> seconds;
+        for (const auto ms : latencies)
+            if (ms >= 0.0)
+                seconds.push_back (ms / 1000.0);
+        std::sort (seconds.begin(), seconds.end());
+
+        String line;
+        line << "loopback," << numMessages << "," << (int) seconds.size() << ","
+             << percentile (seconds, 0.5) << "," << percentile (seconds, 0.99) << ","
+             << percentile (seconds, 1.0);
+        writeLine (line, csv);
+    }
+
+private:
+    std::vector<double> sentAt, latencies;
+    std::atomic<int> received { 0 };
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (MidiThroughputBench)
+
+BOOST_AUTO_TEST_CASE (Run, *boost::unit_test::disabled())
+{
+    Load load;
+    load.rate = getSetting ("EL_BENCH_RATE", "48000").getDoubleValue();
+    load.blockSize = getSetting ("EL_BENCH_BLOCK", "256").getIntValue();
+    const auto seconds = getSetting ("EL_BENCH_SECONDS", "2").getDoubleValue();
+    BOOST_REQUIRE (load.rate > 0.0 && load.blockSize > 0 && seconds > 0.0);
+    load.numBlocks = jmax (1, roundToInt (seconds * load.rate / load.blockSize));
+
+    std::unique_ptr<FileOutputStream> csv;
+    const auto csvPath = getSetting ("EL_BENCH_CSV", {});
+    if (csvPath.isNotEmpty())
+    {
+        const File file (File::getCurrentWorkingDirectory().getChildFile (csvPath));
+        file.deleteFile();
+        csv = file.createOutputStream();
+        BOOST_REQUIRE_MESSAGE (csv != nullptr, file.getFullPathName().toStdString());
+    }
+
+    writeLine ("stage,events_per_block,size,events_per_sec,p50_us,p99_us,ns_per_event", csv.get());
+    for (const int events : getSizes ("EL_BENCH_EVENTS", "16,128,1024"))
+    {
+        load.eventsPerBlock = events;
+        for (const int numMaps : getSizes ("EL_BENCH_MAPS", "16,128"))
+            runMapping (load, numMaps, csv.get());
+        for (const int numNodes : getSizes ("EL_BENCH_NODES", "8,64"))
+            runGraph (load, numNodes, csv.get());
+    }
+
+    const auto loopback = getSetting ("EL_BENCH_LOOPBACK", {});
+    if (loopback.isNotEmpty())
+    {
+        writeLine ("stage,sent,received,p50_us,p99_us,max_us", csv.get());
+        Loopback().run (loopback, 1000, load.rate, csv.get());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/mpevoicerouter.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+struct Outputs
+{
+    MidiBuffer buffers[2];
+    MidiBuffer* ptrs[2] { &buffers[0], &buffers[1] };
+
+    void clear()
+    {
+        for (auto& b : buffers)
+            b.clear();
+    }
+
+    int count (int output, bool (MidiMessage::*test)() const) const
+    {
+        int n = 0;
+        for (const auto m : buffers[output])
+            if ((m.getMessage().*test)())
+                ++n;
+        return n;
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (MpeVoiceRouterTest)
+
+BOOST_AUTO_TEST_CASE (SpreadsVoices)
+{
+    MpeVoiceRouter router;
+    router.setNumOutputs (2);
+    Outputs out;
+
+    MidiBuffer in;
+    in.addEvent (MidiMessage::noteOn (2, 60, (uint8) 100), 0);
+    in.addEvent (MidiMessage::noteOn (3, 64, (uint8) 100), 0);
+    in.addEvent (MidiMessage::noteOn (4, 67, (uint8) 100), 0);
+    router.process (in, out.ptrs);
+
+    BOOST_REQUIRE_EQUAL (router.getNumActiveVoices(), 3);
+    BOOST_REQUIRE_EQUAL (router.getNumActiveVoices (0), 2);
+    BOOST_REQUIRE_EQUAL (router.getNumActiveVoices (1), 1);
+    BOOST_REQUIRE_EQUAL (out.count (0, &MidiMessage::isNoteOn), 2);
+    BOOST_REQUIRE_EQUAL (out.count (1, &MidiMessage::isNoteOn), 1);
+
+    // both outputs get a zone configuration first.
+    BOOST_REQUIRE (out.count (1, &MidiMessage::isController) >= 5);
+
+    int output = -1, channel = -1;
+    BOOST_REQUIRE (router.findVoice (3, 64, output, channel));
+    BOOST_REQUIRE_EQUAL (output, 1);
+    BOOST_REQUIRE (channel >= 2 && channel <= 16);
+
+    out.clear();
+    in.clear();
+    in.addEvent (MidiMessage::pitchWheel (3, 12000), 0);
+    in.addEvent (MidiMessage::noteOff (3, 64), 1);
+    router.process (in, out.ptrs);
+
+    BOOST_REQUIRE_EQUAL (out.count (0, &MidiMessage::isPitchWheel), 0);
+    BOOST_REQUIRE_EQUAL (out.count (1, &MidiMessage::isPitchWheel), 1);
+    BOOST_REQUIRE_EQUAL (out.count (1, &MidiMessage::isNoteOff), 1);
+    for (const auto m : out.buffers[1])
+        BOOST_REQUIRE_EQUAL (m.getMessage().getChannel(), channel);
+    BOOST_REQUIRE_EQUAL (router.getNumActiveVoices(), 2);
+}
+
+BOOST_AUTO_TEST_CASE (StealsOldest)
+{
+    MpeVoiceRouter router;
+    router.setNumOutputs (1);
+    Outputs out;
+
+    MidiBuffer in;
+    for (int i = 0; i < 16; ++i)
+        in.addEvent (MidiMessage::noteOn (1, 40 + i, (uint8) 100), i);
+    router.process (in, out.ptrs);
+
+    // 15 member channels, the 16th note takes the first one's.
+    BOOST_REQUIRE_EQUAL (router.getNumActiveVoices(), 15);
+    int output = -1, channel = -1;
+    BOOST_REQUIRE (! router.findVoice (1, 40, output, channel));
+    BOOST_REQUIRE (router.findVoice (1, 55, output, channel));
+    BOOST_REQUIRE_EQUAL (out.count (0, &MidiMessage::isNoteOff), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,95 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/netbridge.hpp"
+
+using namespace element;
+
+namespace {
+
+/** Encodes one packet of a constant signal, with a note on at frame 10 if asked. */
+int makePacket (uint8* dest, int64 position, int numFrames, float value, bool withNote, bool compressed = false)
+{
+    AudioBuffer<float> audio (2, numFrames);
+    for (int ch = 0; ch < 2; ++ch)
+        FloatVectorOperations::fill (audio.getWritePointer (ch), value, numFrames);
+
+    const uint8 midi[] = { 10, 0, 3, 0x90, 60, 100 };
+    NetBridgePacket::Header header;
+    header.position = position;
+    header.numChannels = 2;
+    header.numFrames = numFrames;
+    header.midiBytes = withNote ? (int) sizeof (midi) : 0;
+    header.sampleRate = 48000;
+    header.compressed = compressed;
+    return NetBridgePacket::write (dest, header, audio.getArrayOfReadPointers(), midi);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (NetBridgeTest)
+
+BOOST_AUTO_TEST_CASE (PacketRoundTrip)
+{
+    for (bool compressed : { false, true })
+    {
+        uint8 data[NetBridgePacket::maxSize];
+        const int size = makePacket (data, 123456789012LL, 100, 0.25f, true, compressed);
+
+        NetBridgePacket::Header header;
+        BOOST_REQUIRE (NetBridgePacket::readHeader (data, size, header));
+        BOOST_REQUIRE (! NetBridgePacket::readHeader (data, size - 1, header));
+        BOOST_REQUIRE (NetBridgePacket::readHeader (data, size, header));
+        BOOST_REQUIRE_EQUAL (header.position, 123456789012LL);
+        BOOST_REQUIRE_EQUAL (header.numFrames, 100);
+        BOOST_REQUIRE_EQUAL (header.compressed, compressed);
+
+        AudioBuffer<float> audio (2, 100);
+        NetBridgePacket::readAudio (data, header, audio.getArrayOfWritePointers(), 2);
+        BOOST_REQUIRE_CLOSE (audio.getSample (1, 99), 0.25f, 0.01f);
+        BOOST_REQUIRE_EQUAL ((int) NetBridgePacket::getMidi (data, header)[4], 60);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (PacketFitsMTU)
+{
+    for (int channels : { 1, 2, 8, 16 })
+    {
+        const int frames = NetBridgePacket::getMaxFrames (channels, false);
+        BOOST_REQUIRE_GT (frames, 0);
+        BOOST_REQUIRE_LE (NetBridgePacket::headerSize + frames * channels * 4 + NetBridgePacket::maxMidiBytes,
+                          NetBridgePacket::maxSize);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (ReceiverStreams)
+{
+    NetBridgeReceiver receiver;
+    receiver.prepare (2, 48000.0, 64);
+    receiver.setLatencyMilliseconds (5.0);
+
+    uint8 data[NetBridgePacket::maxSize];
+    AudioBuffer<float> out (2, 64);
+    int numNotes = 0;
+
+    for (int block = 0; block < 200; ++block)
+    {
+        // packet 50 goes missing.
+        const int size = makePacket (data, block * 64, 64, 0.5f, block % 50 == 0);
+        if (block != 50)
+            receiver.handlePacket (data, size);
+
+        MidiBuffer midi;
+        receiver.read (out.getArrayOfWritePointers(), 2, 64, midi);
+        numNotes += midi.getNumEvents();
+
+        if (block < 3)
+            BOOST_REQUIRE (! receiver.isStreaming());
+        else
+            BOOST_REQUIRE (receiver.isStreaming());
+    }
+
+    BOOST_REQUIRE_EQUAL (receiver.getNumLost(), 64);
+    BOOST_REQUIRE_EQUAL (numNotes, 3);
+    BOOST_REQUIRE_CLOSE (out.getSample (0, 63), 0.5f, 0.01f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+#include <boost/test/unit_test.hpp>
+
+#include "engine/offlinerender.hpp"
+#include "fixture/SyntheticGraph.h"
+
+using namespace element;
+
+namespace {
+AudioBuffer<float> makeNoise (int numSamples, int seed)
+{
+    AudioBuffer<float> noise (2, numSamples);
+    Random random (seed);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < numSamples; ++i)
+            noise.setSample (c, i, random.nextFloat() * 2.f - 1.f);
+    return noise;
+}
+
+OfflineRender::Options makeOptions()
+{
+    OfflineRender::Options options;
+    options.sampleRate = 44100.0;
+    options.blockSize = 256;
+    options.length = 10000;
+    options.tail = 100;
+    return options;
+}
+
+/** A synthetic graph that clears itself when done with. */
+struct TestGraph
+{
+    explicit TestGraph (const String& topology, int numNodes = 8)
+        : graph (*element::test::context())
+    {
+        BOOST_REQUIRE (SyntheticGraph::build (graph, topology, numNodes));
+    }
+
+    ~TestGraph() { graph.clear(); }
+
+    GraphNode graph;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (OfflineRenderTest)
+
+BOOST_AUTO_TEST_CASE (Errors)
+{
+    auto options = makeOptions();
+    BOOST_REQUIRE (! OfflineRender::render (OfflineRender::Stem(), options).wasOk());
+
+    TestGraph fix ("chain");
+    OfflineRender::Stem stem;
+    stem.graph = &fix.graph;
+    options.length = 0;
+    BOOST_REQUIRE (! OfflineRender::render (stem, options).wasOk());
+    options = makeOptions();
+    options.blockSize = 0;
+    BOOST_REQUIRE (! OfflineRender::render (stem, options).wasOk());
+}
+
+BOOST_AUTO_TEST_CASE (Deterministic)
+{
+    const auto options = makeOptions();
+    const auto input = makeNoise (4000, 1234);
+    TestGraph fix ("random", 32);
+
+    AudioBuffer<float> first, second;
+    OfflineRender::Stem stem;
+    stem.graph = &fix.graph;
+    stem.input = &input;
+    stem.buffer = &first;
+
+    const auto result = OfflineRender::render (stem, options);
+    BOOST_REQUIRE (result.wasOk());
+    BOOST_REQUIRE_EQUAL (result.numSamples, options.length + options.tail);
+    BOOST_REQUIRE_EQUAL (first.getNumChannels(), options.numChannels);
+    BOOST_REQUIRE_EQUAL ((int64) first.getNumSamples(), options.length + options.tail);
+    BOOST_REQUIRE (! fix.graph.prepared());
+
+    stem.buffer = &second;
+    BOOST_REQUIRE (OfflineRender::render (stem, options).wasOk());
+    BOOST_REQUIRE_EQUAL (OfflineRender::findFirstDifference (first, second), -1);
+
+    // something came through, and silence after the input ran out.
+    BOOST_REQUIRE (first.getMagnitude (0, 0, input.getNumSamples()) > 0.f);
+    BOOST_REQUIRE_EQUAL (first.getMagnitude (0, 5000, 5100), 0.f);
+
+    second.setSample (1, 77, second.getSample (1, 77) + 1.f);
+    BOOST_REQUIRE_EQUAL (OfflineRender::findFirstDifference (first, second), 77);
+}
+
+BOOST_AUTO_TEST_CASE (ParallelMatchesSerial)
+{
+    auto options = makeOptions();
+    const auto input = makeNoise (options.blockSize * 8, 99);
+
+    OwnedArray<TestGraph> graphs;
+    OwnedArray<AudioBuffer<float>> serial, parallel;
+    Array<OfflineRender::Stem> stems;
+    for (const auto& topology : SyntheticGraph::getTopologies())
+    {
+        auto* fix = graphs.add (new TestGraph (topology));
+        OfflineRender::Stem stem;
+        stem.graph = &fix->graph;
+        stem.input = &input;
+        stem.buffer = serial.add (new AudioBuffer<float>());
+        BOOST_REQUIRE (OfflineRender::render (stem, options).wasOk());
+
+        stem.buffer = parallel.add (new AudioBuffer<float>());
+        stems.add (stem);
+    }
+
+    options.numThreads = 3;
+    const auto results = OfflineRender::render (stems, options);
+    BOOST_REQUIRE_EQUAL (results.size(), stems.size());
+    for (int i = 0; i < stems.size(); ++i)
+    {
+        BOOST_REQUIRE (results[i].wasOk());
+        BOOST_REQUIRE_EQUAL (OfflineRender::findFirstDifference (*serial[i], *parallel[i]), -1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (WritesFiles)
+{
+    auto options = makeOptions();
+    options.bitsPerSample = 32;
+    const auto input = makeNoise (options.blockSize * 4, 7);
+    TestGraph fix ("chain");
+
+    const auto file = File::createTempFile ("wav");
+    AudioBuffer<float> rendered, read;
+    OfflineRender::Stem stem;
+    stem.graph = &fix.graph;
+    stem.input = &input;
+    stem.buffer = &rendered;
+    stem.file = file;
+    BOOST_REQUIRE (OfflineRender::render (stem, options).wasOk());
+
+    double rate = 0.0;
+    BOOST_REQUIRE (OfflineRender::readFile (file, read, &rate));
+    BOOST_REQUIRE_EQUAL (rate, options.sampleRate);
+    BOOST_REQUIRE_EQUAL (OfflineRender::findFirstDifference (rendered, read), -1);
+    file.deleteFile();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
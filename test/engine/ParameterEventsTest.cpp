@@ -0,0 +1,131 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "engine/parameterqueue.hpp"
+#include "fixture/PreparedGraph.h"
+#include "fixture/TestNode.h"
+
+using namespace element;
+
+namespace {
+/** Has one control input and keeps the events it's given. */
+class AutomatedNode : public TestNode {
+public:
+    AutomatedNode() : TestNode (2, 2, 0, 0) { AutomatedNode::refreshPorts(); }
+
+    void refreshPorts() override
+    {
+        PortList newPorts;
+        newPorts.add (PortType::Audio, 0, 0, "in_1", "In 1", true);
+        newPorts.add (PortType::Audio, 1, 1, "in_2", "In 2", true);
+        newPorts.add (PortType::Audio, 2, 0, "out_1", "Out 1", false);
+        newPorts.add (PortType::Audio, 3, 1, "out_2", "Out 2", false);
+        newPorts.add (PortType::Control, 4, 0, "gain", "Gain", true);
+        setPorts (newPorts);
+    }
+
+    bool wantsParameterEvents() const noexcept override { return true; }
+
+    void render (RenderContext& rc) override
+    {
+        hadLane = rc.params != nullptr;
+        if (rc.params != nullptr)
+            for (const auto& ev : *rc.params)
+                received.push_back (ev);
+    }
+
+    bool hadLane = false;
+    std::vector<ParameterEvents::Event> received;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (ParameterEventsTest)
+
+BOOST_AUTO_TEST_CASE (Lane)
+{
+    ParameterEvents lane;
+    BOOST_REQUIRE (lane.add (10, 0, 0.1f));
+    BOOST_REQUIRE (lane.add (5, 1, 0.2f));
+    BOOST_REQUIRE (lane.add (10, 2, 0.3f));
+    BOOST_REQUIRE_EQUAL (lane.size(), 3);
+    BOOST_REQUIRE_EQUAL (lane[0].frame, 5);
+    // same frame keeps the order added.
+    BOOST_REQUIRE_EQUAL (lane[1].parameter, 0);
+    BOOST_REQUIRE_EQUAL (lane[2].parameter, 2);
+
+    lane.clear();
+    for (int i = 0; i < ParameterEvents::capacity; ++i)
+        BOOST_REQUIRE (lane.add (i, 0, 0.f));
+    BOOST_REQUIRE (lane.isFull());
+    BOOST_REQUIRE (! lane.add (0, 0, 0.f));
+}
+
+BOOST_AUTO_TEST_CASE (Queue)
+{
+    ParameterQueue queue;
+    ParameterEvents lane;
+
+    // nothing to measure against yet, so everything goes at the start.
+    BOOST_REQUIRE (queue.push (0, 0.5f));
+    queue.render (lane, 512, ParameterQueue::now());
+    BOOST_REQUIRE_EQUAL (lane.size(), 1);
+    BOOST_REQUIRE_EQUAL (lane[0].frame, 0);
+    BOOST_REQUIRE_EQUAL (lane[0].value, 0.5f);
+
+    // changes that don't fit wait for the next block.
+    lane.clear();
+    for (int i = 0; i < ParameterEvents::capacity + 10; ++i)
+        BOOST_REQUIRE (queue.push (1, (float) i));
+    Thread::sleep (5);
+    queue.render (lane, 512, ParameterQueue::now());
+    BOOST_REQUIRE (lane.isFull());
+    BOOST_REQUIRE_EQUAL (queue.getNumReady(), 10);
+    for (int i = 1; i < lane.size(); ++i)
+        BOOST_REQUIRE (lane[i].frame >= lane[i - 1].frame);
+
+    lane.clear();
+    queue.render (lane, 512, ParameterQueue::now());
+    BOOST_REQUIRE_EQUAL (lane.size(), 10);
+    // pushed before this block started, so none are past its end.
+    BOOST_REQUIRE (lane[9].frame < 512);
+    BOOST_REQUIRE_EQUAL (lane[9].value, (float) (ParameterEvents::capacity + 9));
+}
+
+BOOST_AUTO_TEST_CASE (Graph)
+{
+    PreparedGraph pg;
+    auto* node = new AutomatedNode();
+    ProcessorPtr ptr = pg.graph.addNode (node);
+    pg.graph.rebuild();
+
+    auto param = node->getParameter (0, true);
+    BOOST_REQUIRE (param != nullptr);
+
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer audio (2, 512), cv;
+    auto renderBlock = [&]() {
+        RenderContext rc (audio, cv, midi, atoms, 512);
+        pg.graph.render (rc);
+    };
+
+    renderBlock();
+    BOOST_REQUIRE (node->hadLane);
+    BOOST_REQUIRE (node->received.empty());
+
+    param->setValueNotifyingHost (0.25f);
+    param->setValueNotifyingHost (0.75f);
+    renderBlock();
+    BOOST_REQUIRE_EQUAL (node->received.size(), (size_t) 2);
+    BOOST_REQUIRE_EQUAL (node->received[0].parameter, param->getParameterIndex());
+    BOOST_REQUIRE_EQUAL (node->received[1].value, 0.75f);
+
+    // consumed once.
+    node->received.clear();
+    renderBlock();
+    BOOST_REQUIRE (node->received.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include "engine/peaklimiter.hpp"
+
+using namespace element;
+
+namespace {
+/** A sine at a quarter of the rate, sampled 45 degrees off its peaks. Every
+    sample is 0.707 of the amplitude, the true peak is the amplitude.
+ */
+std::vector<float> quarterSine (int numSamples, float amplitude)
+{
+    std::vector<float> x ((size_t) numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        x[(size_t) i] = amplitude * (float) std::sin (juce::MathConstants<double>::halfPi * i + juce::MathConstants<double>::pi / 4.0);
+    return x;
+}
+
+float maxAbs (const std::vector<float>& x, int start = 0)
+{
+    float peak = 0.f;
+    for (size_t i = (size_t) start; i < x.size(); ++i)
+        peak = std::max (peak, std::abs (x[i]));
+    return peak;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (PeakLimiterTest)
+
+BOOST_AUTO_TEST_CASE (Latency)
+{
+    for (bool truePeak : { false, true })
+    {
+        PeakLimiter limiter;
+        limiter.setTruePeak (truePeak);
+        limiter.prepare (48000.0, 2, 256);
+        limiter.setCeilingDecibels (-1.f);
+        limiter.setLookaheadMs (2.0);
+
+        // quiet audio comes out as it went in, later by the latency.
+        std::vector<float> left (1000, 0.f), right (1000, 0.f);
+        left[10] = 0.5f;
+        right[10] = -0.25f;
+        float* channels[] = { left.data(), right.data() };
+        limiter.process (channels, 2, 1000);
+
+        const int latency = limiter.getLatencySamples();
+        BOOST_REQUIRE_GE (latency, 95);
+        BOOST_REQUIRE_EQUAL (left[(size_t) (10 + latency)], 0.5f);
+        BOOST_REQUIRE_EQUAL (right[(size_t) (10 + latency)], -0.25f);
+        BOOST_REQUIRE_EQUAL (maxAbs (left), 0.5f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (HoldsCeiling)
+{
+    const float ceiling = juce::Decibels::decibelsToGain (-1.f);
+
+    PeakLimiter limiter;
+    limiter.setTruePeak (false);
+    limiter.prepare (48000.0, 1, 512);
+    limiter.setCeilingDecibels (-1.f);
+
+    // a quiet stretch, then a jump well past the ceiling.
+    auto x = quarterSine (48000, 2.f);
+    for (size_t i = 0; i < 20000; ++i)
+        x[i] *= 0.3f;
+    float* channels[] = { x.data() };
+    limiter.process (channels, 1, (int) x.size());
+
+    BOOST_REQUIRE_LE (maxAbs (x), ceiling);
+    BOOST_REQUIRE_CLOSE (std::abs (x.back()), ceiling, 0.1);
+    BOOST_REQUIRE_CLOSE (std::abs (x[10000]), 0.6f * std::sqrt (0.5f), 0.01);
+}
+
+BOOST_AUTO_TEST_CASE (HoldsTruePeak)
+{
+    const float ceiling = juce::Decibels::decibelsToGain (-1.f);
+
+    PeakLimiter limiter;
+    limiter.setTruePeak (true);
+    limiter.prepare (48000.0, 1, 512);
+    limiter.setCeilingDecibels (-1.f);
+
+    auto x = quarterSine (48000, 2.f);
+    float* channels[] = { x.data() };
+    limiter.process (channels, 1, (int) x.size());
+
+    // the samples are held to 0.707 of the ceiling, so the peaks between
+    // them are too.
+    const float truePeak = maxAbs (x) * std::sqrt (2.f);
+    BOOST_REQUIRE_LE (truePeak, ceiling * 1.005f);
+    BOOST_REQUIRE_GT (truePeak, ceiling * 0.95f);
+}
+
+BOOST_AUTO_TEST_CASE (Releases)
+{
+    PeakLimiter limiter;
+    limiter.setTruePeak (false);
+    limiter.prepare (48000.0, 1, 256);
+    limiter.setCeilingDecibels (-6.f);
+    limiter.setReleaseMs (20.f);
+
+    std::vector<float> x (48000, 0.1f);
+    x[1000] = 1.f;
+    float* channels[] = { x.data() };
+    limiter.process (channels, 1, (int) x.size());
+
+    BOOST_REQUIRE_LT (x[(size_t) (1000 + limiter.getLatencySamples())], 0.51f);
+    BOOST_REQUIRE_CLOSE (x.back(), 0.1f, 0.1);
+    BOOST_REQUIRE_CLOSE (limiter.getGain(), 1.f, 0.1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include "engine/realtimeguard.hpp"
+
+using namespace element;
+
+namespace {
+int numReports = 0;
+RealtimeGuard::Violation lastKind = RealtimeGuard::other;
+
+void countReport (RealtimeGuard::Violation kind, const char*, const char*)
+{
+    ++numReports;
+    lastKind = kind;
+}
+
+/** Enables the guard with a counting reporter, restoring it after. */
+struct GuardFixture
+{
+    GuardFixture() : wasEnabled (RealtimeGuard::isEnabled())
+    {
+        numReports = 0;
+        RealtimeGuard::setReporter (&countReport);
+        RealtimeGuard::resetViolations();
+        RealtimeGuard::setEnabled (true);
+    }
+
+    ~GuardFixture()
+    {
+        RealtimeGuard::setEnabled (wasEnabled);
+        RealtimeGuard::setReporter (nullptr);
+        RealtimeGuard::setMaxReports (20);
+        RealtimeGuard::resetViolations();
+    }
+
+    const bool wasEnabled;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (RealtimeGuardTest)
+
+BOOST_FIXTURE_TEST_CASE (OutsideScope, GuardFixture)
+{
+    BOOST_REQUIRE (! RealtimeGuard::isRealtimeThread());
+    RealtimeGuard::check (RealtimeGuard::lock, "test");
+    BOOST_REQUIRE_EQUAL (RealtimeGuard::getNumViolations(), 0);
+    BOOST_REQUIRE_EQUAL (numReports, 0);
+}
+
+// Assertions stay outside each Scope, in guard builds they'd allocate.
+BOOST_FIXTURE_TEST_CASE (InsideScope, GuardFixture)
+{
+    bool wasRealtime = false, nestedRealtime = false;
+    {
+        RealtimeGuard::Scope realtime;
+        wasRealtime = RealtimeGuard::isRealtimeThread();
+        {
+            RealtimeGuard::Scope nested;
+        }
+        nestedRealtime = RealtimeGuard::isRealtimeThread();
+        RealtimeGuard::check (RealtimeGuard::lock, "test");
+    }
+
+    BOOST_REQUIRE (wasRealtime && nestedRealtime);
+    BOOST_REQUIRE (! RealtimeGuard::isRealtimeThread());
+    BOOST_REQUIRE_EQUAL (RealtimeGuard::getNumViolations(), 1);
+    BOOST_REQUIRE_EQUAL (numReports, 1);
+    BOOST_REQUIRE_EQUAL ((int) lastKind, (int) RealtimeGuard::lock);
+}
+
+BOOST_FIXTURE_TEST_CASE (Allow, GuardFixture)
+{
+    bool allowedRealtime = true;
+    {
+        RealtimeGuard::Scope realtime;
+        RealtimeGuard::Allow allow;
+        allowedRealtime = RealtimeGuard::isRealtimeThread();
+        RealtimeGuard::check (RealtimeGuard::allocation, "test");
+    }
+    BOOST_REQUIRE (! allowedRealtime);
+    BOOST_REQUIRE_EQUAL (RealtimeGuard::getNumViolations(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE (Disabled, GuardFixture)
+{
+    RealtimeGuard::setEnabled (false);
+    {
+        RealtimeGuard::Scope realtime;
+        RealtimeGuard::check (RealtimeGuard::other);
+    }
+    BOOST_REQUIRE_EQUAL (RealtimeGuard::getNumViolations(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE (PerThread, GuardFixture)
+{
+    {
+        RealtimeGuard::Scope realtime;
+        RealtimeGuard::Allow startingThreadsAllocates;
+        std::thread other ([]() {
+            RealtimeGuard::check (RealtimeGuard::lock, "test");
+        });
+        other.join();
+    }
+    BOOST_REQUIRE_EQUAL (RealtimeGuard::getNumViolations(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE (MaxReports, GuardFixture)
+{
+    RealtimeGuard::setMaxReports (2);
+    {
+        RealtimeGuard::Scope realtime;
+        for (int i = 0; i < 5; ++i)
+            RealtimeGuard::check (RealtimeGuard::other);
+    }
+    BOOST_REQUIRE_EQUAL (RealtimeGuard::getNumViolations(), 5);
+    BOOST_REQUIRE_EQUAL (numReports, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,149 @@
+/*  Golden render checks. Every directory under test/golden, or EL_GOLDEN_DIR,
+    holding a graph.elg or graph.els is a case: its active graph is rendered
+    and compared with the WAV files beside it. Record new goldens with:
+
+        EL_GOLDEN_UPDATE=1 test_element -t RenderRegressionTest
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture/RenderRegression.h"
+#include "fixture/SyntheticGraph.h"
+
+using namespace element;
+
+namespace {
+/** Renders at half the gain of the nodes around it. */
+class QuieterNode : public SyntheticGraph::Node {
+public:
+    void render (RenderContext& rc) override
+    {
+        for (int c = 0; c < rc.audio.getNumChannels(); ++c)
+            rc.audio.applyGain (c, 0, rc.audio.getNumSamples(), 0.5f);
+    }
+};
+
+RenderRegression::Options makeOptions()
+{
+    RenderRegression::Options options;
+    options.numBlocks = 16;
+    return options;
+}
+
+struct SyntheticFixture {
+    SyntheticFixture() : graph (*element::test::context())
+    {
+        BOOST_REQUIRE (SyntheticGraph::build (graph, "chain", 6));
+    }
+
+    ~SyntheticFixture() { graph.clear(); }
+
+    GraphNode graph;
+};
+
+File getGoldenRoot()
+{
+    const auto dir = SystemStats::getEnvironmentVariable ("EL_GOLDEN_DIR", {});
+    return dir.isNotEmpty() ? File::getCurrentWorkingDirectory().getChildFile (dir)
+                            : element::test::sourceRoot().getChildFile ("test/golden");
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (RenderRegressionTest)
+
+BOOST_FIXTURE_TEST_CASE (Repeatable, SyntheticFixture)
+{
+    RenderRegression::Capture first, second;
+    String error;
+    BOOST_REQUIRE (RenderRegression::capture (graph, makeOptions(), first, error));
+    BOOST_REQUIRE (RenderRegression::capture (graph, makeOptions(), second, error));
+    BOOST_REQUIRE_EQUAL (first.nodes.size(), (size_t) 6);
+    BOOST_REQUIRE (first.output.getMagnitude (0, first.output.getNumSamples()) > 0.f);
+
+    const auto report = RenderRegression::compare (graph, first, second, 0.f);
+    BOOST_REQUIRE_MESSAGE (report.passed(), report.toString().toStdString());
+}
+
+BOOST_FIXTURE_TEST_CASE (FindsChangedNode, SyntheticFixture)
+{
+    const auto numConnections = graph.getNumConnections();
+    RenderRegression::Capture golden, changed;
+    String error;
+    BOOST_REQUIRE (RenderRegression::capture (graph, makeOptions(), golden, error));
+    BOOST_REQUIRE_EQUAL (graph.getNumConnections(), numConnections);
+
+    ReferenceCountedArray<Processor> ordered;
+    graph.getOrderedNodes (ordered);
+    Array<uint32> chain;
+    for (auto* node : ordered)
+        if (dynamic_cast<IONode*> (node) == nullptr)
+            chain.add (node->nodeId);
+    BOOST_REQUIRE_EQUAL (chain.size(), 6);
+
+    BOOST_REQUIRE (graph.replaceNode (chain[3], new QuieterNode()));
+    BOOST_REQUIRE (RenderRegression::capture (graph, makeOptions(), changed, error));
+
+    const auto report = RenderRegression::compare (graph, golden, changed, 1.0e-6f);
+    BOOST_REQUIRE (! report.passed());
+    BOOST_REQUIRE_EQUAL (report.divergent.getFirst().nodeId, chain[3]);
+    BOOST_REQUIRE_EQUAL (report.divergent.getLast().nodeId, EL_INVALID_PORT);
+    BOOST_REQUIRE_EQUAL (report.divergent.size(), 4);
+}
+
+BOOST_FIXTURE_TEST_CASE (WriteAndRead, SyntheticFixture)
+{
+    RenderRegression::Capture written, read;
+    String error;
+    BOOST_REQUIRE (RenderRegression::capture (graph, makeOptions(), written, error));
+
+    const auto dir = File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("golden", {});
+    BOOST_REQUIRE (RenderRegression::write (written, dir));
+    BOOST_REQUIRE (RenderRegression::read (dir, read));
+    dir.deleteRecursively();
+
+    const auto report = RenderRegression::compare (graph, written, read, 0.f);
+    BOOST_REQUIRE_MESSAGE (report.passed(), report.toString().toStdString());
+}
+
+BOOST_AUTO_TEST_CASE (Goldens)
+{
+    const bool update = SystemStats::getEnvironmentVariable ("EL_GOLDEN_UPDATE", {}).getIntValue() != 0;
+    const auto root = getGoldenRoot();
+    int numCases = 0;
+
+    for (const auto& dir : root.findChildFiles (File::findDirectories, false))
+    {
+        auto file = dir.getChildFile ("graph.elg");
+        if (! file.existsAsFile())
+            file = dir.getChildFile ("graph.els");
+        if (! file.existsAsFile())
+            continue;
+
+        ++numCases;
+        GraphNode graph (*element::test::context());
+        auto manager = RenderRegression::load (graph, file);
+        BOOST_REQUIRE_MESSAGE (manager != nullptr, file.getFullPathName().toStdString());
+
+        RenderRegression::Capture actual, golden;
+        String error;
+        BOOST_REQUIRE_MESSAGE (RenderRegression::capture (graph, makeOptions(), actual, error), error.toStdString());
+
+        if (update)
+        {
+            BOOST_REQUIRE (RenderRegression::write (actual, dir));
+        }
+        else
+        {
+            BOOST_REQUIRE_MESSAGE (RenderRegression::read (dir, golden), "no golden output in " << dir.getFullPathName());
+            const auto report = RenderRegression::compare (graph, golden, actual, makeOptions().tolerance);
+            BOOST_CHECK_MESSAGE (report.passed(), dir.getFileName() << ": " << report.toString());
+        }
+
+        manager.reset();
+        graph.clear();
+    }
+
+    BOOST_TEST_MESSAGE (numCases << " golden render cases in " << root.getFullPathName());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
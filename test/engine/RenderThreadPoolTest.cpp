@@ -0,0 +1,119 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/renderthreadpool.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+class CountingJob : public RenderThreadPool::Job
+{
+public:
+    explicit CountingJob (int n) : numTasks (n) {}
+
+    bool runNextTask() noexcept override
+    {
+        const int task = next.fetch_add (1);
+        if (task >= numTasks)
+            return false;
+        sum.fetch_add (task + 1);
+        done.fetch_add (1);
+        return true;
+    }
+
+    bool isFinished() const noexcept override { return done.load() >= numTasks; }
+
+    const int numTasks;
+    std::atomic<int> next { 0 }, done { 0 }, sum { 0 };
+};
+
+void addIndex (void* context, uint32_t index)
+{
+    static_cast<std::atomic<int>*> (context)->fetch_add ((int) index + 1);
+}
+
+/** Each task asks the pool for more work, like a plugin rendered by the
+    graph using the host's thread pool. */
+class NestingJob : public CountingJob
+{
+public:
+    NestingJob (RenderThreadPool& p, int n) : CountingJob (n), pool (p) {}
+
+    bool runNextTask() noexcept override
+    {
+        const int task = next.fetch_add (1);
+        if (task >= numTasks)
+            return false;
+        std::atomic<int> inner { 0 };
+        pool.performTasks (64, addIndex, &inner);
+        sum.fetch_add (inner.load());
+        done.fetch_add (1);
+        return true;
+    }
+
+    RenderThreadPool& pool;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (RenderThreadPoolTest)
+
+BOOST_AUTO_TEST_CASE (Serial)
+{
+    RenderThreadPool pool;
+    BOOST_REQUIRE_EQUAL (pool.getNumWorkers(), 0);
+    CountingJob job (100);
+    pool.perform (job);
+    BOOST_REQUIRE (job.isFinished());
+    BOOST_REQUIRE_EQUAL (job.sum.load(), 5050);
+}
+
+BOOST_AUTO_TEST_CASE (Workers)
+{
+    RenderThreadPool pool;
+    pool.setNumWorkers (3);
+    BOOST_REQUIRE_EQUAL (pool.getNumWorkers(), 3);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        CountingJob job (1000);
+        pool.perform (job);
+        BOOST_REQUIRE (job.isFinished());
+        BOOST_REQUIRE_EQUAL (job.sum.load(), 500500);
+    }
+
+    pool.setNumWorkers (0);
+    BOOST_REQUIRE_EQUAL (pool.getNumWorkers(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (Tasks)
+{
+    RenderThreadPool pool;
+    std::atomic<int> sum { 0 };
+    pool.performTasks (100, addIndex, &sum);
+    BOOST_REQUIRE_EQUAL (sum.load(), 5050);
+
+    pool.setNumWorkers (3);
+    for (int i = 0; i < 50; ++i)
+    {
+        sum = 0;
+        pool.performTasks (1000, addIndex, &sum);
+        BOOST_REQUIRE_EQUAL (sum.load(), 500500);
+    }
+    pool.setNumWorkers (0);
+}
+
+BOOST_AUTO_TEST_CASE (Nested)
+{
+    RenderThreadPool pool;
+    pool.setNumWorkers (3);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        NestingJob job (pool, 8);
+        pool.perform (job);
+        BOOST_REQUIRE (job.isFinished());
+        BOOST_REQUIRE_EQUAL (job.sum.load(), 8 * 2080);
+    }
+    pool.setNumWorkers (0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
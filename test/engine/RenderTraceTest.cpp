@@ -0,0 +1,64 @@
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include "engine/rendertrace.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (RenderTraceTest)
+
+BOOST_AUTO_TEST_CASE (Disabled)
+{
+    BOOST_REQUIRE (! RenderTrace::isEnabled());
+    RenderTrace::record (RenderTrace::blockBegin, 0, 512);
+    RenderTrace::start();
+    BOOST_REQUIRE (RenderTrace::isEnabled());
+    const auto events = RenderTrace::stop();
+    BOOST_REQUIRE (! RenderTrace::isEnabled());
+    BOOST_REQUIRE (events.empty());
+}
+
+BOOST_AUTO_TEST_CASE (Capture)
+{
+    RenderTrace::start();
+    RenderTrace::record (RenderTrace::blockBegin, 0, 512);
+    RenderTrace::record (RenderTrace::opBegin, 7);
+    RenderTrace::record (RenderTrace::opEnd, 7);
+    RenderTrace::record (RenderTrace::blockEnd);
+
+    std::thread other ([]() {
+        RenderTrace::record (RenderTrace::opBegin, 8);
+        RenderTrace::record (RenderTrace::opEnd, 8);
+    });
+    other.join();
+
+    const auto events = RenderTrace::stop();
+    BOOST_REQUIRE_EQUAL (events.size(), (size_t) 6);
+    BOOST_REQUIRE_EQUAL (RenderTrace::getNumDropped(), 0);
+    for (size_t i = 1; i < events.size(); ++i)
+        BOOST_REQUIRE (events[i - 1].ticks <= events[i].ticks);
+
+    BOOST_REQUIRE_EQUAL ((int) events.front().kind, (int) RenderTrace::blockBegin);
+    BOOST_REQUIRE_EQUAL (events.front().value, 512);
+
+    MemoryOutputStream json;
+    RenderTrace::writeChromeTrace (events, json);
+    const auto parsed = JSON::parse (json.toString());
+    BOOST_REQUIRE (parsed.isObject());
+    auto* list = parsed["traceEvents"].getArray();
+    BOOST_REQUIRE (list != nullptr);
+    BOOST_REQUIRE_EQUAL (list->size(), 6);
+    BOOST_REQUIRE (list->getReference (0)["name"].toString() == "block");
+}
+
+BOOST_AUTO_TEST_CASE (Limit)
+{
+    RenderTrace::start (4);
+    for (int i = 0; i < 10; ++i)
+        RenderTrace::record (RenderTrace::opBegin, (uint32) i);
+    const auto events = RenderTrace::stop();
+    BOOST_REQUIRE_EQUAL (events.size(), (size_t) 4);
+    BOOST_REQUIRE_EQUAL (RenderTrace::getNumDropped(), 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,102 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+#include "engine/resampler.hpp"
+
+using namespace element;
+
+namespace {
+/** Converts a sine for a while and returns its level once settled, in dB.
+    Also checks the frame count tracks the ratio exactly. */
+double toneLevel (double sourceRate, double targetRate, double frequency)
+{
+    constexpr int block = 512, numBlocks = 400;
+    Resampler r;
+    BOOST_REQUIRE (r.prepare (sourceRate, targetRate, 1, block));
+
+    std::vector<float> in (block), out ((size_t) r.getMaxOutput());
+    double peak = 0.0;
+    juce::int64 frame = 0, total = 0;
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        for (int i = 0; i < block; ++i, ++frame)
+            in[(size_t) i] = (float) std::sin (juce::MathConstants<double>::twoPi * frequency * (double) frame / sourceRate);
+
+        const float* input[] = { in.data() };
+        float* output[] = { out.data() };
+        const int n = r.process (input, block, output);
+        BOOST_REQUIRE (n <= r.getMaxOutput());
+        total += n;
+
+        if (b > 100)
+            for (int i = 0; i < n; ++i)
+                peak = std::max (peak, (double) std::abs (out[(size_t) i]));
+    }
+
+    BOOST_REQUIRE_LE (std::abs ((double) total - numBlocks * block * targetRate / sourceRate), 2.0);
+    return 20.0 * std::log10 (peak + 1.0e-12);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (ResamplerTest)
+
+BOOST_AUTO_TEST_CASE (Response)
+{
+    BOOST_REQUIRE_LT (std::abs (toneLevel (96000.0, 48000.0, 1000.0)), 0.05);
+    BOOST_REQUIRE_LT (std::abs (toneLevel (96000.0, 48000.0, 20000.0)), 0.1);
+    BOOST_REQUIRE_LT (toneLevel (96000.0, 48000.0, 30000.0), -70.0);
+    BOOST_REQUIRE_LT (std::abs (toneLevel (48000.0, 44100.0, 1000.0)), 0.05);
+    BOOST_REQUIRE_LT (toneLevel (48000.0, 44100.0, 23000.0), -70.0);
+    BOOST_REQUIRE_LT (std::abs (toneLevel (44100.0, 96000.0, 1000.0)), 0.05);
+
+    Resampler r;
+    BOOST_REQUIRE (! r.prepare (48000.0, 0.0, 1, 64));
+    BOOST_REQUIRE (! r.prepare (48000.0, 44099.0, 1, 64)); // too many phases
+}
+
+BOOST_AUTO_TEST_CASE (RoundTrip)
+{
+    const std::pair<double, double> rates[] = { { 96000.0, 48000.0 }, { 48000.0, 44100.0 }, { 44100.0, 96000.0 } };
+    for (const auto& [outer, inner] : rates)
+    {
+        RateBridge bridge;
+        BOOST_REQUIRE (bridge.prepare (outer, inner, 2, 512));
+
+        // blocks of any size come back whole, delayed by the latency.
+        std::mt19937 rng (1);
+        juce::AudioBuffer<float> io (2, 512);
+        std::vector<float> sent, received;
+        juce::int64 frame = 0;
+        for (int b = 0; b < 500; ++b)
+        {
+            const int numSamples = 1 + (int) (rng() % 512);
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto x = (float) std::sin (juce::MathConstants<double>::twoPi * 997.0 * (double) (frame + i) / outer);
+                io.setSample (0, i, x);
+                io.setSample (1, i, x);
+                sent.push_back (x);
+            }
+            frame += numSamples;
+
+            const int numInner = bridge.toInner (io, numSamples);
+            BOOST_REQUIRE (numInner <= bridge.getMaxInnerBlock());
+            bridge.toOuter (numInner, io, numSamples);
+            for (int i = 0; i < numSamples; ++i)
+                received.push_back (io.getSample (1, i));
+        }
+
+        BOOST_REQUIRE_EQUAL (bridge.getNumUnderruns(), 0);
+        const auto latency = (size_t) bridge.getLatencySamples();
+        float error = 0.f;
+        for (size_t i = 20000; i < received.size(); ++i)
+            error = std::max (error, std::abs (received[i] - sent[i - latency]));
+        BOOST_REQUIRE_LT (error, 0.05f); // the delay isn't a whole frame
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/samplecache.hpp"
+
+using namespace element;
+
+namespace {
+
+constexpr int testLength = SampleCache::blockSize * 2 + 100;
+
+/** A mono WAV where each sample is its position over the length. */
+File writeTestFile()
+{
+    auto file = File::createTempFile (".wav");
+    WavAudioFormat wav;
+    std::unique_ptr<AudioFormatWriter> writer (wav.createWriterFor (new FileOutputStream (file), 44100.0, 1, 24, {}, 0));
+    BOOST_REQUIRE (writer != nullptr);
+
+    AudioBuffer<float> data (1, testLength);
+    for (int i = 0; i < testLength; ++i)
+        data.setSample (0, i, (float) i / testLength);
+    writer->writeFromAudioSampleBuffer (data, 0, testLength);
+    return file;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SampleCacheTest)
+
+BOOST_AUTO_TEST_CASE (BlocksAndEviction)
+{
+    const auto file = writeTestFile();
+    {
+        AudioFormatManager formats;
+        formats.registerBasicFormats();
+        std::unique_ptr<AudioFormatReader> reader (formats.createReaderFor (file));
+        BOOST_REQUIRE (reader != nullptr);
+
+        SampleCache cache;
+        const auto key = SampleCache::getKey (file);
+
+        auto first = cache.getBlock (key, *reader, 1);
+        BOOST_REQUIRE (first != nullptr);
+        BOOST_REQUIRE_EQUAL (first->getNumChannels(), 2);
+        BOOST_REQUIRE_EQUAL (first->getNumSamples(), SampleCache::blockSize);
+        BOOST_REQUIRE_SMALL (first->getSample (0, 10) - (float) (SampleCache::blockSize + 10) / testLength, 0.0001f);
+        BOOST_REQUIRE_SMALL (first->getSample (1, 10) - first->getSample (0, 10), 0.0001f);
+
+        // the same block again is a hit.
+        BOOST_REQUIRE (cache.getBlock (key, *reader, 1) == first);
+        BOOST_REQUIRE_EQUAL (cache.getNumHits(), (juce::int64) 1);
+        BOOST_REQUIRE_EQUAL (cache.getNumMisses(), (juce::int64) 1);
+
+        // the last block is short, past the end there's nothing.
+        auto last = cache.getBlock (key, *reader, 2);
+        BOOST_REQUIRE (last != nullptr);
+        BOOST_REQUIRE_EQUAL (last->getNumSamples(), 100);
+        BOOST_REQUIRE (cache.getBlock (key, *reader, 3) == nullptr);
+
+        // room for one full block: the least recently used one goes.
+        const size_t blockBytes = 2 * SampleCache::blockSize * sizeof (float);
+        cache.getBlock (key, *reader, 0);
+        cache.findBlock (key, 1);
+        cache.setCapacity (blockBytes);
+        BOOST_REQUIRE (cache.getNumBytes() <= blockBytes);
+        BOOST_REQUIRE (cache.findBlock (key, 1) != nullptr);
+        BOOST_REQUIRE (cache.findBlock (key, 0) == nullptr);
+        BOOST_REQUIRE (cache.findBlock (key, 2) == nullptr);
+
+        // dropped blocks stay valid while held.
+        BOOST_REQUIRE_EQUAL (last->getNumSamples(), 100);
+
+        cache.clear();
+        BOOST_REQUIRE_EQUAL (cache.getNumBytes(), (size_t) 0);
+        BOOST_REQUIRE (cache.findBlock (key, 1) == nullptr);
+    }
+    file.deleteFile();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include "engine/signalanalyzer.hpp"
+
+using namespace element;
+
+namespace {
+void writeSine (SnapshotRing& ring, int numSamples, double frequency, double sampleRate, float amplitude)
+{
+    std::vector<float> block ((size_t) numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        block[(size_t) i] = amplitude * (float) std::sin (juce::MathConstants<double>::twoPi * frequency * i / sampleRate);
+    const float* data[] = { block.data(), block.data() };
+    ring.write (data, 2, numSamples);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SignalAnalyzerTest)
+
+BOOST_AUTO_TEST_CASE (RingKeepsNewest)
+{
+    SnapshotRing ring (2);
+    std::vector<float> left (1000), right (1000, -1.f);
+    const float* data[] = { left.data(), right.data() };
+
+    // blocks that straddle the end of the ring come back in order.
+    for (int block = 0; block < 20; ++block)
+    {
+        for (int i = 0; i < 1000; ++i)
+            left[(size_t) i] = (float) (block * 1000 + i);
+        ring.write (data, 2, 1000);
+    }
+    BOOST_REQUIRE_EQUAL (ring.getNumWritten(), (juce::int64) 20000);
+
+    std::vector<float> outL (3000), outR (3000);
+    float* dest[] = { outL.data(), outR.data() };
+    BOOST_REQUIRE (ring.read (dest, 3000));
+    BOOST_REQUIRE_EQUAL (outL.front(), 17000.f);
+    BOOST_REQUIRE_EQUAL (outL.back(), 19999.f);
+    BOOST_REQUIRE_EQUAL (outR[1500], -1.f);
+
+    // a missing channel is written silent.
+    ring.write (data, 1, 1000);
+    BOOST_REQUIRE (ring.read (dest, 1000));
+    BOOST_REQUIRE_EQUAL (outR[500], 0.f);
+
+    // nothing is read until enough was written.
+    SnapshotRing empty (2);
+    BOOST_REQUIRE (! empty.read (dest, 100));
+}
+
+BOOST_AUTO_TEST_CASE (FindsTone)
+{
+    const double rate = 48000.0;
+    SnapshotRing ring (2);
+    SignalAnalyzer analyzer (ring);
+    analyzer.setSampleRate (rate);
+
+    BOOST_REQUIRE (! analyzer.analyze());
+    BOOST_REQUIRE (analyzer.takeFrame() == nullptr);
+
+    writeSine (ring, SignalAnalyzer::scopeFrames, 1000.0, rate, 0.5f);
+    BOOST_REQUIRE (analyzer.analyze());
+    const auto* frame = analyzer.takeFrame();
+    BOOST_REQUIRE (frame != nullptr);
+    BOOST_REQUIRE (analyzer.takeFrame() == nullptr);
+    BOOST_REQUIRE_EQUAL ((int) frame->spectrum.size(), SignalAnalyzer::numBins);
+    BOOST_REQUIRE_EQUAL ((int) frame->scopeMax.size(), SignalAnalyzer::numScopePoints);
+
+    // the loudest bin is the one nearest 1 kHz and reads about -6 dB.
+    int loudest = 0;
+    for (int b = 1; b < SignalAnalyzer::numBins; ++b)
+        if (frame->spectrum[(size_t) b] > frame->spectrum[(size_t) loudest])
+            loudest = b;
+    const float frequency = SignalAnalyzer::getBinFrequency (loudest, rate);
+    BOOST_REQUIRE_GT (frequency, 950.f);
+    BOOST_REQUIRE_LT (frequency, 1050.f);
+    BOOST_REQUIRE_CLOSE (frame->spectrum[(size_t) loudest], -6.02f, 25.0);
+    BOOST_REQUIRE_LT (frame->spectrum.back(), -60.f);
+
+    // the scope spans the sine.
+    float lo = 0.f, hi = 0.f;
+    for (int p = 0; p < SignalAnalyzer::numScopePoints; ++p)
+    {
+        lo = std::min (lo, frame->scopeMin[(size_t) p]);
+        hi = std::max (hi, frame->scopeMax[(size_t) p]);
+    }
+    BOOST_REQUIRE_CLOSE (hi, 0.5f, 1.0);
+    BOOST_REQUIRE_CLOSE (lo, -0.5f, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE (PeaksDecay)
+{
+    SnapshotRing ring (2);
+    SignalAnalyzer analyzer (ring);
+    analyzer.setSampleRate (48000.0);
+
+    writeSine (ring, SignalAnalyzer::scopeFrames, 1000.0, 48000.0, 0.5f);
+    BOOST_REQUIRE (analyzer.analyze());
+    const auto* first = analyzer.takeFrame();
+    BOOST_REQUIRE (first != nullptr);
+    const float before = *std::max_element (first->spectrum.begin(), first->spectrum.end());
+
+    // silence follows, the peak falls a step per pass.
+    std::vector<float> silence ((size_t) SignalAnalyzer::scopeFrames, 0.f);
+    const float* data[] = { silence.data(), silence.data() };
+    ring.write (data, 2, SignalAnalyzer::scopeFrames);
+    BOOST_REQUIRE (analyzer.analyze());
+    const auto* after = analyzer.takeFrame();
+    BOOST_REQUIRE (after != nullptr);
+    const float peak = *std::max_element (after->spectrum.begin(), after->spectrum.end());
+    BOOST_REQUIRE_LT (peak, before);
+    BOOST_REQUIRE_GT (peak, before - 2.f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,99 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+#include "engine/signalguard.hpp"
+#include "fixture/PreparedGraph.h"
+#include "fixture/TestNode.h"
+
+using namespace element;
+
+namespace {
+/** Writes NaN to its outputs until it's bypassed. */
+class FaultyNode : public TestNode {
+public:
+    FaultyNode() : TestNode (2, 2, 0, 0) {}
+
+    void render (RenderContext& rc) override
+    {
+        for (int ch = 0; ch < rc.audio.getNumChannels(); ++ch)
+            rc.audio.setSample (ch, rc.audio.getNumSamples() / 2, std::numeric_limits<float>::quiet_NaN());
+    }
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SignalGuardTest)
+
+BOOST_AUTO_TEST_CASE (Sanitize)
+{
+    float data[67];
+    for (int i = 0; i < 67; ++i)
+        data[i] = (float) i * 0.01f;
+
+    auto result = SignalGuard::sanitize (data, 67);
+    BOOST_REQUIRE (result.isClean());
+
+    data[3] = std::numeric_limits<float>::quiet_NaN();
+    data[20] = std::numeric_limits<float>::infinity();
+    data[40] = -std::numeric_limits<float>::infinity();
+    data[66] = std::numeric_limits<float>::denorm_min();
+    data[50] = -std::numeric_limits<float>::min(); // smallest normal, kept
+    result = SignalGuard::sanitize (data, 67);
+    BOOST_REQUIRE_EQUAL (result.nonFinite, 3);
+    BOOST_REQUIRE_EQUAL (result.denormal, 1);
+    BOOST_REQUIRE_EQUAL (data[3], 0.f);
+    BOOST_REQUIRE_EQUAL (data[20], 0.f);
+    BOOST_REQUIRE_EQUAL (data[40], 0.f);
+    BOOST_REQUIRE_EQUAL (data[66], 0.f);
+    BOOST_REQUIRE_EQUAL (data[50], -std::numeric_limits<float>::min());
+    BOOST_REQUIRE_EQUAL (data[65], 0.65f);
+
+    BOOST_REQUIRE (SignalGuard::sanitize (data, 67).isClean());
+}
+
+BOOST_AUTO_TEST_CASE (FaultBypass)
+{
+    PreparedGraph pg;
+    auto* node = new FaultyNode();
+    ProcessorPtr ptr = pg.graph.addNode (node);
+    pg.graph.rebuild();
+
+    AtomBuffer atoms;
+    MidiBuffer midi;
+    AudioSampleBuffer audio (2, 512), cv;
+    auto renderBlock = [&]() {
+        RenderContext rc (audio, cv, midi, atoms, 512);
+        pg.graph.render (rc);
+    };
+
+    // off by default, nothing is counted.
+    renderBlock();
+    BOOST_REQUIRE_EQUAL (node->getNumSignalFaults(), (int64) 0);
+
+    SignalGuard::setEnabled (true);
+    SignalGuard::resetFaults();
+    for (int i = 1; i < SignalGuard::faultLimit; ++i)
+        renderBlock();
+    BOOST_REQUIRE_EQUAL (node->getNumSignalFaults(), (int64) SignalGuard::faultLimit - 1);
+    BOOST_REQUIRE (! node->isSuspended());
+
+    renderBlock();
+    BOOST_REQUIRE (node->isSuspended());
+    BOOST_REQUIRE (node->isFaultBypassed());
+    BOOST_REQUIRE_EQUAL (SignalGuard::getNumFaults(), (int64) SignalGuard::faultLimit);
+
+    // bypassed, it stays quiet.
+    renderBlock();
+    BOOST_REQUIRE_EQUAL (node->getNumSignalFaults(), (int64) SignalGuard::faultLimit);
+
+    node->suspendProcessing (false);
+    BOOST_REQUIRE (! node->isFaultBypassed());
+
+    SignalGuard::setEnabled (false);
+    SignalGuard::resetFaults();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
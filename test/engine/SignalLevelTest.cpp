@@ -0,0 +1,34 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/signallevel.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (SignalLevelTest)
+
+BOOST_AUTO_TEST_CASE (Silence)
+{
+    float data[13] = { 0.f };
+    const auto level = SignalLevel::measure (data, 13);
+    BOOST_REQUIRE_EQUAL (level.peak, 0.f);
+    BOOST_REQUIRE_EQUAL (level.rms, 0.f);
+    BOOST_REQUIRE_EQUAL (SignalLevel::measure (data, 0).peak, 0.f);
+}
+
+BOOST_AUTO_TEST_CASE (PeakAndRMS)
+{
+    // odd length so the tail loop runs too.
+    float data[11];
+    for (int i = 0; i < 11; ++i)
+        data[i] = (i % 2 == 0) ? 0.5f : -0.5f;
+    data[10] = -0.75f;
+
+    const auto level = SignalLevel::measure (data, 11);
+    BOOST_REQUIRE_EQUAL (level.peak, 0.75f);
+
+    float sum = 0.f;
+    for (auto s : data)
+        sum += s * s;
+    BOOST_REQUIRE_CLOSE (level.rms, std::sqrt (sum / 11.f), 0.001f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
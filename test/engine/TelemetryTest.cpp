@@ -0,0 +1,36 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/telemetry.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (TelemetryTest)
+
+BOOST_AUTO_TEST_CASE (CountsAndHistogram)
+{
+    TelemetryCollector tc;
+    const double block = 0.01;
+
+    tc.record (block, block * 0.25, 0.0);
+    tc.record (block, block * 0.55, block);
+    tc.record (block, block * 1.5, block * 2.0);
+
+    const auto t = tc.snapshot();
+    BOOST_REQUIRE_EQUAL (t.numCallbacks, 3);
+    BOOST_REQUIRE_EQUAL (t.deadlineMisses, 1);
+    BOOST_REQUIRE_EQUAL (t.lateCallbacks, 1);
+    BOOST_REQUIRE_EQUAL (t.xruns, -1);
+    BOOST_REQUIRE_EQUAL (t.histogram[2], 1);
+    BOOST_REQUIRE_EQUAL (t.histogram[5], 1);
+    BOOST_REQUIRE_EQUAL (t.histogram[TelemetryCollector::numBins - 1], 1);
+    BOOST_REQUIRE_CLOSE (t.peakLoad, 1.5, 0.001);
+
+    // periods of 10 and 20 ms against a 10 ms block.
+    BOOST_REQUIRE_CLOSE (t.periodMs, 15.0, 0.001);
+    BOOST_REQUIRE_CLOSE (t.jitterMs, std::sqrt (50.0), 0.001);
+
+    tc.reset();
+    BOOST_REQUIRE_EQUAL (tc.snapshot().numCallbacks, 0);
+    BOOST_REQUIRE_EQUAL (tc.snapshot().periodMs, 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,32 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/threadpolicy.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (ThreadPolicyTest)
+
+BOOST_AUTO_TEST_CASE (ParseCores)
+{
+    BOOST_REQUIRE_EQUAL (ThreadPolicy::parseCores (""), 0u);
+    BOOST_REQUIRE_EQUAL (ThreadPolicy::parseCores ("0"), 1u);
+    BOOST_REQUIRE_EQUAL (ThreadPolicy::parseCores ("2,3"), 0x0cu);
+    BOOST_REQUIRE_EQUAL (ThreadPolicy::parseCores ("4-7"), 0xf0u);
+    BOOST_REQUIRE_EQUAL (ThreadPolicy::parseCores ("7-4, 0"), 0xf1u);
+    BOOST_REQUIRE_EQUAL (ThreadPolicy::parseCores ("1, x, 40"), 0x02u);
+}
+
+BOOST_AUTO_TEST_CASE (Generation)
+{
+    const auto start = ThreadPolicy::getGeneration();
+    ThreadPolicy::set (0x3, 0, 0);
+    BOOST_REQUIRE_NE (ThreadPolicy::getGeneration(), start);
+
+    // setting the same policy again doesn't count as a change.
+    const auto changed = ThreadPolicy::getGeneration();
+    ThreadPolicy::set (0x3, 0, 0);
+    BOOST_REQUIRE_EQUAL (ThreadPolicy::getGeneration(), changed);
+
+    ThreadPolicy::set (0, 0, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,50 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/videoframes.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (VideoFramesTest)
+
+BOOST_AUTO_TEST_CASE (MailboxTakesNewest)
+{
+    VideoFrameMailbox mailbox;
+    BOOST_REQUIRE (mailbox.take() == nullptr);
+
+    for (int width = 1; width <= 3; ++width)
+    {
+        mailbox.getWriteFrame() = juce::Image (juce::Image::ARGB, width, 1, true, juce::SoftwareImageType());
+        mailbox.publish();
+    }
+
+    // the reader skips straight to the last frame published.
+    auto* frame = mailbox.take();
+    BOOST_REQUIRE (frame != nullptr);
+    BOOST_REQUIRE_EQUAL (frame->getWidth(), 3);
+    BOOST_REQUIRE_EQUAL (mailbox.getReadFrame().getWidth(), 3);
+    BOOST_REQUIRE (mailbox.take() == nullptr);
+
+    // and the writer never gets the frame being read.
+    BOOST_REQUIRE (mailbox.getWriteFrame().getWidth() != 3);
+}
+
+BOOST_AUTO_TEST_CASE (SequenceFrameAt)
+{
+    auto dir = juce::File::createTempFile ("frames");
+    BOOST_REQUIRE (dir.createDirectory());
+    for (int i = 0; i < 4; ++i)
+        dir.getChildFile (juce::String ("frame") + juce::String (i) + ".png").create();
+
+    ImageSequence sequence;
+    BOOST_REQUIRE (sequence.open (dir));
+    BOOST_REQUIRE_EQUAL (sequence.getNumFrames(), 4);
+    sequence.setFrameRate (10.0);
+    BOOST_REQUIRE_EQUAL (sequence.getFrameAt (-1.0), 0);
+    BOOST_REQUIRE_EQUAL (sequence.getFrameAt (0.25), 2);
+    BOOST_REQUIRE_EQUAL (sequence.getFrameAt (5.0), 3);
+
+    // empty files aren't images.
+    BOOST_REQUIRE (! sequence.decode (0).isValid());
+    dir.deleteRecursively();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -50,4 +50,31 @@ BOOST_AUTO_TEST_CASE (Basics)
     ToggleGridUnit().runTest();
 }
 
+BOOST_AUTO_TEST_CASE (Exchange)
+{
+    ToggleGridExchange grids;
+    BOOST_REQUIRE (grids.acquire() == nullptr);
+
+    MatrixState matrix (2, 2);
+    matrix.set (0, 1, true);
+    grids.publish (matrix);
+    matrix.set (1, 0, true);
+    grids.publish (matrix); // replaces the one not yet acquired
+
+    std::unique_ptr<ToggleGrid> current (grids.acquire());
+    BOOST_REQUIRE (current != nullptr);
+    BOOST_REQUIRE (current->get (0, 1) && current->get (1, 0));
+    BOOST_REQUIRE (grids.acquire() == nullptr);
+
+    grids.publish (MatrixState (3, 3));
+    grids.retire (new ToggleGrid (2, 2));
+    // nothing new is handed out until the retired grid is collected.
+    BOOST_REQUIRE (grids.acquire() == nullptr);
+
+    grids.publish (MatrixState (4, 4));
+    std::unique_ptr<ToggleGrid> next (grids.acquire());
+    BOOST_REQUIRE (next != nullptr);
+    BOOST_REQUIRE_EQUAL (next->getNumInputs(), 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
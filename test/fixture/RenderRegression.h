@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cmath>
+#include <map>
+#include <memory>
+
+#include <element/context.hpp>
+#include <element/node.hpp>
+
+#include "engine/graphmanager.hpp"
+#include "engine/graphnode.hpp"
+#include "engine/ionode.hpp"
+#include "engine/offlinerender.hpp"
+#include "nodes/placeholder.hpp"
+#include "testutil.hpp"
+
+namespace element {
+
+/** Renders graphs through OfflineRender and compares them with golden
+    outputs, to show a change to the engine didn't change what it renders.
+
+    A capture is the graph's output plus each node's own output, all from
+    the same seeded noise and MIDI. Node outputs are taken by routing one
+    node at a time to the graph's audio output in place of its usual
+    connections, so a mismatch can be traced to the first node, in render
+    order, whose audio changed.
+
+    Goldens are 32 bit float WAV files in a directory per case: output.wav
+    and node-<id>.wav for every node.
+ */
+struct RenderRegression {
+    struct Options {
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        int numBlocks = 64;
+        int seed = 1234;
+
+        /** Largest difference in any sample that still counts as a match. */
+        float tolerance = 1.0e-6f;
+
+        juce::int64 getLength() const noexcept { return (juce::int64) blockSize * numBlocks; }
+    };
+
+    struct Capture {
+        juce::AudioBuffer<float> output;
+        std::map<uint32, juce::AudioBuffer<float>> nodes;
+    };
+
+    struct Divergence {
+        /** EL_INVALID_PORT for the graph's output. */
+        uint32 nodeId = EL_INVALID_PORT;
+        juce::String name;
+        float maxError = 0.f;
+        juce::int64 firstFrame = -1;
+    };
+
+    struct Report {
+        juce::String error;
+
+        /** Nodes that differ in render order, then the output if it did. */
+        juce::Array<Divergence> divergent;
+
+        bool passed() const noexcept { return error.isEmpty() && divergent.isEmpty(); }
+
+        juce::String toString() const
+        {
+            if (error.isNotEmpty())
+                return error;
+            juce::String text;
+            for (const auto& d : divergent)
+                text << (d.nodeId == EL_INVALID_PORT ? juce::String ("output") : "node " + juce::String (d.nodeId))
+                     << " " << d.name.quoted() << ": max error " << d.maxError
+                     << " from frame " << d.firstFrame << juce::newLine;
+            return text.isEmpty() ? juce::String ("matched") : text;
+        }
+    };
+
+    /** Stereo noise with a few silent gaps, the same for a given seed. */
+    static juce::AudioBuffer<float> makeInput (const Options& options)
+    {
+        juce::AudioBuffer<float> input (2, (int) options.getLength());
+        juce::Random random (options.seed);
+        for (int c = 0; c < 2; ++c)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                input.setSample (c, i, (i / options.blockSize) % 8 == 7 ? 0.f : random.nextFloat() * 2.f - 1.f);
+        return input;
+    }
+
+    /** A note on and off every few blocks, so instruments make sound. */
+    static juce::MidiBuffer makeMidi (const Options& options)
+    {
+        juce::MidiBuffer midi;
+        juce::Random random (options.seed);
+        for (int block = 0; block + 2 < options.numBlocks; block += 4)
+        {
+            const int note = 36 + random.nextInt (48);
+            const int frame = block * options.blockSize + random.nextInt (options.blockSize);
+            midi.addEvent (juce::MidiMessage::noteOn (1, note, (juce::uint8) 100), frame);
+            midi.addEvent (juce::MidiMessage::noteOff (1, note), frame + options.blockSize);
+        }
+        return midi;
+    }
+
+    /** Renders the graph and then each node on its own. The graph's
+        connections are put back afterwards.
+     */
+    static bool capture (GraphNode& graph, const Options& options, Capture& result, juce::String& error)
+    {
+        const auto input = makeInput (options);
+        const auto midi = makeMidi (options);
+
+        OfflineRender::Options render;
+        render.sampleRate = options.sampleRate;
+        render.blockSize = options.blockSize;
+        render.length = options.getLength();
+
+        OfflineRender::Stem stem;
+        stem.graph = &graph;
+        stem.input = &input;
+        stem.midi = &midi;
+        stem.buffer = &result.output;
+        if (auto r = OfflineRender::render (stem, render); ! r.wasOk())
+        {
+            error = r.error;
+            return false;
+        }
+
+        Processor* output = nullptr;
+        for (int i = 0; i < graph.getNumNodes(); ++i)
+            if (auto* io = dynamic_cast<IONode*> (graph.getNode (i)))
+                if (io->getType() == IONode::audioOutputNode)
+                    output = io;
+        if (output == nullptr)
+            return true;
+
+        const auto outputId = output->nodeId;
+        juce::Array<GraphNode::Connection> saved;
+        for (int i = 0; i < graph.getNumConnections(); ++i)
+            if (const auto* c = graph.getConnection (i); c->destNode == outputId)
+                saved.add (*c);
+        for (const auto& c : saved)
+            graph.removeConnection (c.sourceNode, c.sourcePort, c.destNode, c.destPort);
+
+        juce::ReferenceCountedArray<Processor> ordered;
+        graph.getOrderedNodes (ordered);
+        bool ok = true;
+        for (auto* node : ordered)
+        {
+            if (dynamic_cast<IONode*> (node) != nullptr || node->getNumAudioOutputs() <= 0)
+                continue;
+
+            const auto id = node->nodeId;
+            const int numChannels = juce::jmin (node->getNumAudioOutputs(), output->getNumAudioInputs());
+            for (int c = 0; c < numChannels; ++c)
+                graph.connectChannels (PortType::Audio, id, c, outputId, c);
+
+            stem.buffer = &result.nodes[id];
+            if (auto r = OfflineRender::render (stem, render); ! r.wasOk())
+            {
+                error = r.error;
+                ok = false;
+            }
+
+            for (int c = 0; c < numChannels; ++c)
+                graph.removeConnection (id, node->getPortForChannel (PortType::Audio, c, false), outputId, output->getPortForChannel (PortType::Audio, c, true));
+            if (! ok)
+                break;
+        }
+
+        for (const auto& c : saved)
+            graph.addConnection (c.sourceNode, c.sourcePort, c.destNode, c.destPort);
+        return ok;
+    }
+
+    static Report compare (GraphNode& graph, const Capture& golden, const Capture& actual, float tolerance)
+    {
+        Report report;
+        juce::ReferenceCountedArray<Processor> ordered;
+        graph.getOrderedNodes (ordered);
+        for (auto* node : ordered)
+        {
+            const auto a = golden.nodes.find (node->nodeId);
+            const auto b = actual.nodes.find (node->nodeId);
+            if (a == golden.nodes.end() && b == actual.nodes.end())
+                continue;
+            if (a == golden.nodes.end() || b == actual.nodes.end())
+            {
+                report.error << "node " << (int) node->nodeId << " is missing from one capture";
+                return report;
+            }
+            if (auto d = diverge (a->second, b->second, tolerance); d.firstFrame >= 0)
+            {
+                d.nodeId = node->nodeId;
+                d.name = node->getName();
+                report.divergent.add (d);
+            }
+        }
+
+        if (auto d = diverge (golden.output, actual.output, tolerance); d.firstFrame >= 0)
+        {
+            d.name = graph.getName();
+            report.divergent.add (d);
+        }
+        return report;
+    }
+
+    static bool write (const Capture& capture, const juce::File& directory)
+    {
+        if (! directory.createDirectory())
+            return false;
+        bool ok = writeFile (capture.output, directory.getChildFile ("output.wav"));
+        for (const auto& [id, buffer] : capture.nodes)
+            ok &= writeFile (buffer, directory.getChildFile ("node-" + juce::String (id) + ".wav"));
+        return ok;
+    }
+
+    static bool read (const juce::File& directory, Capture& capture)
+    {
+        if (! OfflineRender::readFile (directory.getChildFile ("output.wav"), capture.output))
+            return false;
+        for (const auto& file : directory.findChildFiles (juce::File::findFiles, false, "node-*.wav"))
+        {
+            const auto id = (uint32) file.getFileNameWithoutExtension().fromFirstOccurrenceOf ("node-", false, false).getLargeIntValue();
+            if (! OfflineRender::readFile (file, capture.nodes[id]))
+                return false;
+        }
+        return true;
+    }
+
+    /** Loads a graph or session's active graph. Plugins that load in the
+        background are waited for, up to a few seconds.
+     */
+    static std::unique_ptr<GraphManager> load (GraphNode& graph, const juce::File& file)
+    {
+        const Node model (Node::parse (file), false);
+        if (! model.isGraph())
+            return nullptr;
+
+        auto manager = std::make_unique<GraphManager> (graph, element::test::context()->plugins());
+        manager->setNodeModel (model);
+
+        const auto deadline = juce::Time::getMillisecondCounter() + 5000;
+        while (hasPlaceholders (graph) && juce::Time::getMillisecondCounter() < deadline)
+            juce::MessageManager::getInstance()->runDispatchLoopUntil (10);
+        return manager;
+    }
+
+private:
+    static Divergence diverge (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b, float tolerance)
+    {
+        Divergence d;
+        const int numSamples = juce::jmin (a.getNumSamples(), b.getNumSamples());
+        if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+            d.firstFrame = numSamples;
+
+        for (int c = 0; c < juce::jmin (a.getNumChannels(), b.getNumChannels()); ++c)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto error = std::abs (a.getSample (c, i) - b.getSample (c, i));
+                if (! (error <= tolerance))
+                {
+                    d.maxError = juce::jmax (d.maxError, error);
+                    d.firstFrame = d.firstFrame < 0 ? i : juce::jmin (d.firstFrame, (juce::int64) i);
+                }
+            }
+        }
+        return d;
+    }
+
+    static bool writeFile (const juce::AudioBuffer<float>& buffer, const juce::File& file)
+    {
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+        if (stream == nullptr)
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), 48000.0, (unsigned int) buffer.getNumChannels(), 32, {}, 0));
+        if (writer == nullptr)
+            return false;
+        stream.release();
+        return writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+
+    static bool hasPlaceholders (const GraphNode& graph)
+    {
+        for (int i = 0; i < graph.getNumNodes(); ++i)
+            if (graph.getNode (i)->processor<PlaceholderProcessor>() != nullptr)
+                return true;
+        return false;
+    }
+};
+
+} // namespace element
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <element/juce/core.hpp>
+
+#include "fixture/TestNode.h"
+#include "engine/graphbuilder.hpp"
+#include "engine/graphnode.hpp"
+#include "engine/ionode.hpp"
+#include "testutil.hpp"
+
+namespace element {
+
+/** Builds generated graphs of TestNodes for benchmarks and scaling tests.
+    Every topology feeds from the graph's audio input and ends at its output.
+
+    chain     nodes in series
+    fanout    nodes in parallel, all summed into the output
+    nested    subgraphs inside subgraphs, one node and the next at each
+              level, at most maxDepth deep
+    latency   fanout with a different latency on each branch, so the graph
+              adds delays to line them up
+    random    each node fed by one or two earlier nodes picked at random
+    layered   rows of up to 16 nodes, each fed by two of the row before
+ */
+struct SyntheticGraph {
+    static constexpr int maxDepth = 64;
+
+    /** A two channel node that does a little work, and can report latency. */
+    class Node : public TestNode {
+    public:
+        explicit Node (int latency = 0) : TestNode (2, 2, 1, 1)
+        {
+            if (latency > 0)
+                setLatencySamples (latency);
+        }
+
+        void render (RenderContext& rc) override
+        {
+            for (int c = 0; c < rc.audio.getNumChannels(); ++c)
+                rc.audio.applyGain (c, 0, rc.audio.getNumSamples(), 0.999f);
+        }
+    };
+
+    static juce::StringArray getTopologies()
+    {
+        return { "chain", "fanout", "nested", "latency", "random", "layered" };
+    }
+
+    /** Adds numNodes of a topology to an empty graph. Returns false if a
+        connection was refused or the topology is unknown.
+     */
+    static bool build (GraphNode& graph, const juce::String& topology, int numNodes, int seed = 1234)
+    {
+        SyntheticGraph builder (graph);
+        if (topology == "chain")
+            return builder.chain (numNodes);
+        if (topology == "fanout")
+            return builder.fanout (numNodes, 0);
+        if (topology == "latency")
+            return builder.fanout (numNodes, 16);
+        if (topology == "nested")
+            return builder.nested (juce::jmin (numNodes, (int) maxDepth));
+        if (topology == "random")
+            return builder.random (numNodes, seed);
+        if (topology == "layered")
+            return builder.layered (numNodes, 16);
+        return false;
+    }
+
+    /** Seconds taken by the fastest of a few rebuilds of the rendering sequence. */
+    static double timeRebuild (GraphNode& graph, int numRuns = 3)
+    {
+        double best = 0.0;
+        for (int i = 0; i < numRuns; ++i)
+        {
+            const auto t0 = juce::Time::getHighResolutionTicks();
+            graph.rebuild();
+            const auto t1 = juce::Time::getHighResolutionTicks();
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (t1 - t0);
+            best = i == 0 ? seconds : juce::jmin (best, seconds);
+        }
+        return best;
+    }
+
+    /** Seconds taken by the fastest of a few GraphBuilder constructions,
+        leaving out the rest of a rebuild. Subgraphs aren't flattened.
+     */
+    static double timeBuilder (GraphNode& graph, int numRuns = 3)
+    {
+        GraphLayout layout;
+        juce::ReferenceCountedArray<Processor> ordered;
+        graph.getOrderedNodes (ordered);
+        for (auto* node : ordered)
+        {
+            layout.nodes.add (node);
+            layout.keys.push_back (node->nodeId);
+        }
+        for (int i = 0; i < graph.getNumConnections(); ++i)
+        {
+            const auto* c = graph.getConnection (i);
+            layout.arcs.emplace_back (c->sourceNode, c->sourcePort, c->destNode, c->destPort);
+        }
+
+        double best = 0.0;
+        for (int i = 0; i < numRuns; ++i)
+        {
+            juce::Array<void*> ops;
+            const auto t0 = juce::Time::getHighResolutionTicks();
+            {
+                GraphBuilder builder (graph, layout, ops);
+            }
+            const auto t1 = juce::Time::getHighResolutionTicks();
+            for (auto* op : ops)
+                delete static_cast<GraphOp*> (op);
+
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (t1 - t0);
+            best = i == 0 ? seconds : juce::jmin (best, seconds);
+        }
+        return best;
+    }
+
+private:
+    explicit SyntheticGraph (GraphNode& g) : graph (g)
+    {
+        input = graph.addNode (new IONode (IONode::audioInputNode));
+        output = graph.addNode (new IONode (IONode::audioOutputNode));
+    }
+
+    GraphNode& graph;
+    ProcessorPtr input, output;
+
+    bool connect (const ProcessorPtr& source, const ProcessorPtr& dest)
+    {
+        bool ok = true;
+        for (int c = 0; c < 2; ++c)
+            ok &= graph.connectChannels (PortType::Audio, source->nodeId, c, dest->nodeId, c);
+        return ok;
+    }
+
+    ProcessorPtr add (int latency = 0) { return graph.addNode (new Node (latency)); }
+
+    bool chain (int numNodes)
+    {
+        bool ok = true;
+        auto last = input;
+        for (int i = 0; i < numNodes; ++i)
+        {
+            auto node = add();
+            ok &= connect (last, node);
+            last = node;
+        }
+        return ok && connect (last, output);
+    }
+
+    bool fanout (int numNodes, int latencyStep)
+    {
+        bool ok = true;
+        for (int i = 0; i < numNodes; ++i)
+        {
+            auto node = add (i * latencyStep);
+            ok &= connect (input, node) && connect (node, output);
+        }
+        return ok;
+    }
+
+    bool nested (int depth)
+    {
+        auto node = add();
+        bool ok = connect (input, node);
+        if (depth <= 1)
+            return ok && connect (node, output);
+
+        auto* sub = new GraphNode (*element::test::context());
+        ProcessorPtr subPtr = graph.addNode (sub);
+        SyntheticGraph inner (*sub);
+        ok &= inner.nested (depth - 1);
+        sub->rebuild();
+        return ok && connect (node, subPtr) && connect (subPtr, output);
+    }
+
+    bool random (int numNodes, int seed)
+    {
+        juce::Random rng (seed);
+        juce::ReferenceCountedArray<Processor> added;
+        bool ok = true;
+        for (int i = 0; i < numNodes; ++i)
+        {
+            auto pick = [&]() { return added.isEmpty() ? input : added[rng.nextInt (added.size())]; };
+            auto node = add();
+            auto first = pick();
+            ok &= connect (first, node);
+            if (rng.nextBool())
+                if (auto second = pick(); second != first)
+                    ok &= connect (second, node);
+            added.add (node);
+        }
+
+        for (int i = juce::jmax (0, added.size() - 8); i < added.size(); ++i)
+            ok &= connect (added[i], output);
+        return ok;
+    }
+
+    bool layered (int numNodes, int width)
+    {
+        juce::ReferenceCountedArray<Processor> previous, current;
+        previous.add (input.get());
+        bool ok = true;
+        for (int i = 0; i < numNodes; ++i)
+        {
+            auto node = add();
+            const int index = current.size();
+            ok &= connect (previous[index % previous.size()], node);
+            if (previous.size() > 1)
+                ok &= connect (previous[(index + 1) % previous.size()], node);
+            current.add (node);
+            if (current.size() == width || i == numNodes - 1)
+            {
+                previous.swapWith (current);
+                current.clear();
+            }
+        }
+
+        for (auto* node : previous)
+            ok &= connect (node, output);
+        return ok;
+    }
+};
+
+} // namespace element
@@ -0,0 +1,178 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+/*  Measures what a DSP script costs on the audio thread. Disabled unless
+    asked for, run it with `meson test --benchmark` or:
+
+        EL_BENCH_SCRIPT=amp.lua EL_BENCH_BLOCKS=64,256 test_element -t DSPScriptBench/Run
+
+    EL_BENCH_SCRIPT   Script file. Relative names are looked for in
+                      test/snippets, then the user scripts dir.
+                      Defaults to scripts/amp.lua.
+    EL_BENCH_RATE     Sample rate, 48000
+    EL_BENCH_BLOCKS   Block sizes to run, 64,256,1024
+    EL_BENCH_SECONDS  Audio to render at each block size, 10
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <element/datapath.hpp>
+#include <element/midipipe.hpp>
+
+#include "scripting/bindings.hpp"
+#include "scripting/dspscript.hpp"
+#include "scripting/scriptallocator.hpp"
+#include "scripting/scriptloader.hpp"
+#include "testutil.hpp"
+
+using namespace element;
+
+namespace {
+
+String getSetting (const char* name, const String& fallback)
+{
+    const auto value = SystemStats::getEnvironmentVariable (name, {});
+    return value.isNotEmpty() ? value : fallback;
+}
+
+File getBenchScript()
+{
+    const auto path = getSetting ("EL_BENCH_SCRIPT", {});
+    const File root (EL_TEST_SOURCE_ROOT);
+    if (path.isEmpty())
+        return root.getChildFile ("scripts/amp.lua");
+    if (File::isAbsolutePath (path))
+        return File (path);
+
+    const auto snippet = root.getChildFile ("test/snippets").getChildFile (path);
+    return snippet.existsAsFile() ? snippet : DataPath::defaultScriptsDir().getChildFile (path);
+}
+
+/** Value below which fraction of the sorted samples fall, in microseconds. */
+double percentile (const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    const auto index = jlimit (0, (int) sorted.size() - 1, (int) std::ceil (fraction * sorted.size()) - 1);
+    return sorted[(size_t) index] * 1.0e6;
+}
+
+void report (const char* label, std::vector<double>& seconds)
+{
+    std::sort (seconds.begin(), seconds.end());
+    std::cout << "  " << label
+              << "  p50 " << percentile (seconds, 0.5)
+              << "  p90 " << percentile (seconds, 0.9)
+              << "  p99 " << percentile (seconds, 0.99)
+              << "  p99.9 " << percentile (seconds, 0.999)
+              << "  max " << percentile (seconds, 1.0) << " us" << std::endl;
+}
+
+void runBench (const File& file, double rate, int blockSize, double seconds)
+{
+    // set up the way ScriptNode runs a script, see ScriptNode::Program.
+    ScriptAllocator allocator;
+    sol::state lua (sol::default_at_panic, &ScriptAllocator::allocate, &allocator);
+    Lua::initializeState (lua);
+
+    ScriptLoader loader (lua);
+    BOOST_REQUIRE_MESSAGE (loader.load (file), loader.getErrorMessage().toStdString());
+    auto table = loader();
+    BOOST_REQUIRE_MESSAGE (table.get_type() == sol::type::table, "script didn't return a DSP table");
+
+    DSPScript script (table);
+    BOOST_REQUIRE_MESSAGE (script.isValid(), "could not instantiate the DSP script");
+    script.init();
+    script.prepare (rate, blockSize);
+
+    const auto& ports = script.getPorts();
+    const int numChannels = jmax (1, ports.size (PortType::Audio, true), ports.size (PortType::Audio, false));
+    const int numMidi = jlimit (1, 4, jmax (ports.size (PortType::Midi, true), ports.size (PortType::Midi, false)));
+
+    AudioSampleBuffer input (numChannels, blockSize), audio (numChannels, blockSize);
+    Random random (1234);
+    for (int c = 0; c < numChannels; ++c)
+        for (int f = 0; f < blockSize; ++f)
+            input.setSample (c, f, random.nextFloat() * 2.f - 1.f);
+
+    OwnedArray<MidiBuffer> midiBuffers;
+    MidiBuffer* midiRefs[4];
+    for (int i = 0; i < numMidi; ++i)
+    {
+        midiRefs[i] = midiBuffers.add (new MidiBuffer());
+        midiRefs[i]->ensureSize (4096);
+    }
+    MidiPipe midi (midiRefs, numMidi);
+
+    const int numBlocks = jmax (1, roundToInt (seconds * rate / blockSize));
+    const int noteInterval = jmax (1, roundToInt (0.1 * rate / blockSize));
+    std::vector<double> blockTimes, gcTimes;
+    blockTimes.reserve ((size_t) numBlocks);
+    gcTimes.reserve ((size_t) numBlocks);
+
+    auto* L = lua.lua_state();
+    const auto allocationsBefore = allocator.getNumAllocations();
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        audio.makeCopyOf (input, true);
+        for (auto* buffer : midiBuffers)
+            buffer->clear();
+        if (i % noteInterval == 0)
+            midiRefs[0]->addEvent (MidiMessage::noteOn (1, 60 + (i / noteInterval) % 12, 0.8f), 0);
+        else if (i % noteInterval == noteInterval / 2)
+            midiRefs[0]->addEvent (MidiMessage::noteOff (1, 60 + (i / noteInterval) % 12), 0);
+
+        ScriptAllocator::ScopedRealtime realtime (allocator);
+        lua_gc (L, LUA_GCSTOP);
+        const auto t0 = Time::getHighResolutionTicks();
+        script.process (audio, midi);
+        const auto t1 = Time::getHighResolutionTicks();
+        lua_gc (L, LUA_GCSTEP, 0);
+        const auto t2 = Time::getHighResolutionTicks();
+        lua_gc (L, LUA_GCRESTART);
+
+        blockTimes.push_back (Time::highResolutionTicksToSeconds (t1 - t0));
+        gcTimes.push_back (Time::highResolutionTicksToSeconds (t2 - t1));
+    }
+
+    const auto allocations = allocator.getNumAllocations() - allocationsBefore;
+
+    std::cout << file.getFileName() << " at " << rate << " Hz, " << blockSize << " frames, "
+              << numBlocks << " blocks, deadline " << (1.0e6 * blockSize / rate) << " us" << std::endl;
+    report ("process", blockTimes);
+    report ("gc step", gcTimes);
+    std::cout << "  allocations " << allocations << " (" << ((double) allocations / numBlocks) << " per block)"
+              << ", peak " << allocator.getPeakBytes() << " bytes"
+              << ", failed " << allocator.getNumFailures() << std::endl;
+
+    BOOST_CHECK_MESSAGE (script.isValid(), "script raised an error while processing");
+    BOOST_CHECK_MESSAGE (allocator.getNumFailures() == 0, "script ran out of arena memory");
+
+    script.release();
+    script.cleanup();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (DSPScriptBench)
+
+BOOST_AUTO_TEST_CASE (Run, *boost::unit_test::disabled())
+{
+    const auto file = getBenchScript();
+    BOOST_REQUIRE_MESSAGE (file.existsAsFile(), file.getFullPathName().toStdString());
+
+    const auto rate = getSetting ("EL_BENCH_RATE", "48000").getDoubleValue();
+    const auto seconds = getSetting ("EL_BENCH_SECONDS", "10").getDoubleValue();
+    BOOST_REQUIRE (rate > 0.0 && seconds > 0.0);
+
+    for (const auto& token : StringArray::fromTokens (getSetting ("EL_BENCH_BLOCKS", "64,256,1024"), ",", {}))
+        if (const int blockSize = token.trim().getIntValue(); blockSize > 0)
+            runBench (file, rate, blockSize, seconds);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,69 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cstring>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "scripting/scriptallocator.hpp"
+#include "sol/sol.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (ScriptAllocatorTest)
+
+BOOST_AUTO_TEST_CASE (ReusesFreedBlocks)
+{
+    ScriptAllocator allocator (64 * 1024);
+    auto* a = ScriptAllocator::allocate (&allocator, nullptr, 0, 24);
+    BOOST_REQUIRE (a != nullptr);
+    BOOST_REQUIRE_EQUAL (allocator.getBytesInUse(), (size_t) 24);
+
+    ScriptAllocator::allocate (&allocator, a, 24, 0);
+    BOOST_REQUIRE_EQUAL (allocator.getBytesInUse(), (size_t) 0);
+
+    auto* b = ScriptAllocator::allocate (&allocator, nullptr, 0, 32);
+    BOOST_REQUIRE (a == b);
+    BOOST_REQUIRE_EQUAL (allocator.getPeakBytes(), (size_t) 32);
+    ScriptAllocator::allocate (&allocator, b, 32, 0);
+}
+
+BOOST_AUTO_TEST_CASE (RealtimeBudget)
+{
+    ScriptAllocator allocator (64 * 1024);
+
+    {
+        ScriptAllocator::ScopedRealtime rt (allocator);
+        BOOST_REQUIRE (ScriptAllocator::allocate (&allocator, nullptr, 0, 128 * 1024) == nullptr);
+        BOOST_REQUIRE_EQUAL (allocator.getNumFailures(), (juce::int64) 1);
+    }
+
+    BOOST_REQUIRE (! allocator.isRealtime());
+    auto* big = ScriptAllocator::allocate (&allocator, nullptr, 0, 128 * 1024);
+    BOOST_REQUIRE (big != nullptr);
+    ScriptAllocator::allocate (&allocator, big, 128 * 1024, 0);
+    BOOST_REQUIRE_EQUAL (allocator.getNumFailures(), (juce::int64) 1);
+}
+
+BOOST_AUTO_TEST_CASE (GrowKeepsData)
+{
+    ScriptAllocator allocator;
+    auto* p = static_cast<char*> (ScriptAllocator::allocate (&allocator, nullptr, 0, 8));
+    std::memcpy (p, "element", 8);
+    p = static_cast<char*> (ScriptAllocator::allocate (&allocator, p, 8, 100));
+    BOOST_REQUIRE_EQUAL (std::string (p), std::string ("element"));
+    ScriptAllocator::allocate (&allocator, p, 100, 0);
+}
+
+BOOST_AUTO_TEST_CASE (RunsLua)
+{
+    ScriptAllocator allocator;
+    sol::state lua (sol::default_at_panic, &ScriptAllocator::allocate, &allocator);
+    lua.open_libraries (sol::lib::base);
+    lua.script ("t = {} for i = 1, 1000 do t[i] = tostring (i) end");
+    BOOST_REQUIRE_EQUAL (lua["t"][1000].get<std::string>(), std::string ("1000"));
+    BOOST_REQUIRE (allocator.getBytesInUse() > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,71 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "scripting.hpp"
+#include "scripting/scriptjob.hpp"
+#include "sol/sol.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+void waitFor (ScriptJob& job)
+{
+    for (int i = 0; i < 500 && job.isRunning(); ++i)
+        MessageManager::getInstance()->runDispatchLoopUntil (10);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (ScriptJobTest)
+
+BOOST_AUTO_TEST_CASE (PostsToMainState)
+{
+    ScriptingEngine scripting;
+    ScriptJob job (scripting, "posts", R"(
+        local sum = 0
+        for i = 1, 100000 do sum = sum + i end
+        job.progress (0.5, "halfway")
+        job.post ("posted = (posted or 0) + " .. tostring (sum))
+        job.post ("posted = posted + 1")
+        print ("sum", sum)
+    )");
+
+    StringArray lines;
+    float progress = 0.f;
+    bool ok = false;
+    job.onPrint = [&] (const String& line) { lines.add (line); };
+    job.onProgress = [&] (float fraction, const String&) { progress = fraction; };
+    job.onFinished = [&] (const Result& result) { ok = result.wasOk(); };
+
+    job.start();
+    waitFor (job);
+
+    BOOST_REQUIRE (! job.isRunning());
+    BOOST_REQUIRE (ok);
+    BOOST_REQUIRE_EQUAL (progress, 0.5f);
+    BOOST_REQUIRE_EQUAL (lines.joinIntoString ("|"), String ("sum 5000050000"));
+
+    sol::state_view lua (scripting.getLuaState());
+    BOOST_REQUIRE_EQUAL (lua["posted"].get<double>(), 5000050001.0);
+}
+
+BOOST_AUTO_TEST_CASE (Cancels)
+{
+    ScriptingEngine scripting;
+    ScriptJob job (scripting, "spins", "while true do end");
+
+    String error;
+    job.onFinished = [&] (const Result& result) { error = result.getErrorMessage(); };
+    job.start();
+    Thread::sleep (20);
+    BOOST_REQUIRE (job.isRunning());
+
+    job.cancel();
+    waitFor (job);
+    BOOST_REQUIRE (! job.isRunning());
+    BOOST_REQUIRE_EQUAL (error, String ("cancelled"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -131,6 +131,49 @@ BOOST_AUTO_TEST_CASE (ReturnValue)
     BOOST_REQUIRE (obj.as<std::string>() == "anon");
 }
 
+BOOST_AUTO_TEST_CASE (BytecodeCache)
+{
+    const auto previous = ScriptLoader::getCacheDirectory();
+    const auto dir = File::createTempFile ("luacache");
+    ScriptLoader::setCacheDirectory (dir);
+
+    LuaFixture fix;
+    sol::state_view lua (fix.luaState());
+
+    {
+        ScriptLoader loader (lua, sAnonymous);
+        BOOST_REQUIRE (loader.isReady());
+        BOOST_REQUIRE (! loader.isFromCache());
+    }
+
+    const auto cacheFile = ScriptLoader::getCacheFile (sAnonymous, "script=");
+    BOOST_REQUIRE (cacheFile.existsAsFile());
+
+    {
+        ScriptLoader loader (lua, sAnonymous);
+        BOOST_REQUIRE (loader.isReady());
+        BOOST_REQUIRE (loader.isFromCache());
+        sol::object obj = loader.call();
+        BOOST_REQUIRE (obj.is<std::string>() && obj.as<std::string>() == "anon");
+    }
+
+    // a bad cache entry is replaced by compiling the source.
+    cacheFile.replaceWithText ("not bytecode");
+    {
+        ScriptLoader loader (lua, sAnonymous);
+        BOOST_REQUIRE (loader.isReady());
+        BOOST_REQUIRE (! loader.isFromCache());
+    }
+
+    {
+        ScriptLoader loader (lua, sAnonymous);
+        BOOST_REQUIRE (loader.isFromCache());
+    }
+
+    dir.deleteRecursively();
+    ScriptLoader::setCacheDirectory (previous);
+}
+
 BOOST_AUTO_TEST_CASE (Base64Encode)
 {
     String urlStr = "base64://";
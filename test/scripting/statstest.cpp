@@ -0,0 +1,98 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+#include <element/node.hpp>
+
+#include "fixture/TestNode.h"
+#include "engine/graphnode.hpp"
+#include "luatest.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (StatsTest)
+
+BOOST_AUTO_TEST_CASE (Graph)
+{
+    // the model holds a reference, so the graph lives on the heap.
+    juce::ReferenceCountedObjectPtr<GraphNode> graph (new GraphNode (*element::test::context()));
+    graph->prepareToRender (44100.0, 512);
+    ProcessorPtr a = graph->addNode (new TestNode (2, 2, 0, 0));
+    ProcessorPtr b = graph->addNode (new TestNode (2, 2, 0, 0));
+    graph->connectChannels (PortType::Audio, a->nodeId, 0, b->nodeId, 0);
+    graph->rebuild();
+
+    Node model (types::Graph);
+    model.setProperty (tags::object, graph.get());
+
+    LuaFixture lua;
+    sol::state_view view (lua.luaState());
+    view.script ("require ('el.Node')");
+    view["graph"] = model;
+    view["stopped"] = Node (types::Graph);
+
+    try
+    {
+        view.safe_script (R"(
+            local Stats = require ('el.Stats')
+            expect (Stats.graph (stopped) == nil)
+            expect (Stats.nodes (stopped) == nil)
+            expect (not Stats.profile (stopped, true))
+
+            local g = Stats.graph (graph)
+            expect (g.nodes == 2)
+            expect (g.ops > 0)
+            expect (g.blocksize > 0)
+            expect (g.memory == g.audiomemory + g.midimemory + g.atommemory + g.opmemory)
+            expect (g.total >= g.memory)
+
+            local nodes = Stats.nodes (graph)
+            expect (#nodes == 2)
+            expect (nodes[1].memory >= 0)
+            expect (not nodes[1].profiling and nodes[1].load == nil)
+
+            expect (Stats.profile (graph, true))
+            nodes = Stats.nodes (graph)
+            expect (nodes[2].profiling and nodes[2].blocks == 0)
+            Stats.profile (graph, false)
+
+            -- no context is set in this state.
+            expect (Stats.engine() == nil)
+        )",
+                          "[test:stats]");
+    }
+    catch (const std::exception& e)
+    {
+        BOOST_REQUIRE_MESSAGE (false, e.what());
+    }
+
+    BOOST_REQUIRE (! a->isProfilingEnabled());
+    model.data().removeProperty (tags::object, nullptr);
+    graph->releaseResources();
+    graph->clear();
+}
+
+BOOST_AUTO_TEST_CASE (Engine)
+{
+    LuaFixture lua;
+    sol::state_view view (lua.luaState());
+    Lua::setGlobals (view, *element::test::context());
+    try
+    {
+        view.safe_script (R"(
+            local e = require ('el.Stats').engine()
+            if e then
+                expect (e.midiin >= 0 and e.midiout >= 0)
+                expect (e.load >= 0)
+            end
+        )",
+                          "[test:stats]");
+    }
+    catch (const std::exception& e)
+    {
+        BOOST_REQUIRE_MESSAGE (false, e.what());
+    }
+    Lua::clearGlobals (view);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,45 @@
+local AudioBuffer = require ('el.AudioBuffer')
+
+local a = AudioBuffer.new (2, 64)
+local b = AudioBuffer.new (2, 64)
+a:clear()
+b:clear()
+
+a:fill (1, 1, 64, 0.5)
+BOOST_REQUIRE (a:get (1, 64) == 0.5)
+BOOST_REQUIRE (a:magnitude (1, 1, 64) == 0.5)
+
+b:copy (1, 1, a, 1, 1, 64, 2.0)
+BOOST_REQUIRE (b:get (1, 1) == 1.0)
+b:add (1, 1, a, 1, 1, 64)
+BOOST_REQUIRE (b:get (1, 32) == 1.5)
+b:multiply (1, 1, a, 1, 1, 64)
+BOOST_REQUIRE (b:get (1, 64) == 0.75)
+
+-- counts past the end are clipped.
+b:fill (2, 60, 100, 1.0)
+BOOST_REQUIRE (b:get (2, 59) == 0.0)
+BOOST_REQUIRE (b:get (2, 64) == 1.0)
+
+a:ramp (2, 1, 5, 0.0, 1.0)
+BOOST_REQUIRE (a:get (2, 1) == 0.0)
+BOOST_REQUIRE (a:get (2, 3) == 0.5)
+BOOST_REQUIRE (a:get (2, 5) == 1.0)
+
+a:set (2, 10, -2.0)
+local lo, hi = a:range (2, 1, 64)
+BOOST_REQUIRE (lo == -2.0 and hi == 1.0)
+BOOST_REQUIRE (a:rms (1, 1, 64) == 0.5)
+
+-- a pass-through biquad leaves the signal alone.
+local state = { 0.0, 0.0 }
+a:biquad (1, 1, 64, { 1.0, 0.0, 0.0, 0.0, 0.0 }, state)
+BOOST_REQUIRE (a:get (1, 17) == 0.5)
+
+-- one-pole smoothing keeps its state between calls.
+a:fill (1, 1, 64, 1.0)
+a:biquad (1, 1, 32, { 0.5, 0.0, 0.0, -0.5, 0.0 }, state)
+BOOST_REQUIRE (a:get (1, 1) == 0.5)
+BOOST_REQUIRE (state[1] > 0.0)
+a:biquad (1, 33, 32, { 0.5, 0.0, 0.0, -0.5, 0.0 }, state)
+BOOST_REQUIRE (a:get (1, 64) > 0.999)
@@ -0,0 +1,36 @@
+local MidiBuffer = require ('el.MidiBuffer')
+
+local buf = MidiBuffer.new (256)
+buf:write (1, 0x90, 60, 100)
+buf:write (33, 0x80, 60, 0)
+buf:write (17, 0xb0, 7, 64)
+BOOST_REQUIRE (buf:size() == 3)
+
+-- events come back in time order with 1-indexed frames.
+local frames = {}
+for frame, size, status, d1, d2 in buf:raw() do
+    BOOST_REQUIRE (size == 3)
+    frames[#frames + 1] = frame
+    if frame == 17 then
+        BOOST_REQUIRE (status == 0xb0 and d1 == 7 and d2 == 64)
+    end
+end
+BOOST_REQUIRE (#frames == 3)
+BOOST_REQUIRE (frames[1] == 1 and frames[2] == 17 and frames[3] == 33)
+
+-- transpose notes in place.
+for frame, size, status, note in buf:raw() do
+    if status & 0xe0 == 0x80 then
+        buf:rewrite (status, note + 12)
+    end
+end
+
+for frame, size, status, note in buf:raw() do
+    if status & 0xe0 == 0x80 then
+        BOOST_REQUIRE (note == 72)
+    end
+end
+
+-- rewriting past the end of iteration does nothing.
+buf:rewrite (0xff, 0xff, 0xff)
+BOOST_REQUIRE (buf:size() == 3)